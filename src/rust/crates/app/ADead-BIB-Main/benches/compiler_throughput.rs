@@ -0,0 +1,430 @@
+// ============================================================
+// adB bench — throughput del compilador por fase
+// ============================================================
+//   cargo bench -p ADead-BIB-Main --bench compiler_throughput
+//   cargo bench ... -- [filtro] [--quick] [--iters N]
+//                      [--save base.json] [--baseline base.json]
+//                      [--threshold 10]
+//
+// Corre el pipeline C completo, fase por fase, sobre el corpus de
+// tests/c/fixtures y sobre entradas sintéticas grandes:
+//
+//   big_function    una función de 100k líneas
+//   many_functions  10k funciones pequeñas
+//   macro_heavy     header con miles de macros anidadas
+//
+// Por fase: mediana de wall time, líneas/s y asignaciones (número y
+// bytes, contadas por `CountingAlloc`). `--save` guarda el resultado
+// en JSON; `--baseline` compara contra uno guardado y sale con código
+// 1 si alguna fase es más lenta que `--threshold` %. Las entradas son
+// deterministas y el codegen corre en un solo hilo (salvo ADEB_JOBS),
+// así que dos commits en la misma máquina son comparables.
+//
+// ELF no está implementado en este backend (elf.rs es un stub): la
+// fase de escritura mide la imagen PE, en memoria.
+// ============================================================
+
+use adeb_backend_x64::iat_registry::ImportOptions;
+use adeb_backend_x64::isa::c_isa::CIsaCompiler;
+use adeb_backend_x64::isa::isa_compiler::Target;
+use adeb_core::time_report::{self, Span};
+use adeb_frontend_c::header_cache;
+use adeb_frontend_c::lower::to_ir::CToIR;
+use adeb_frontend_c::parse::lexer::CToken;
+use adeb_frontend_c::parse::parser::CParser;
+use adeb_frontend_c::preprocessor::CPreprocessor;
+use adeb_frontend_c::CLexer;
+use serde::{Deserialize, Serialize};
+use std::collections::{BTreeMap, HashSet};
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::process::ExitCode;
+
+#[global_allocator]
+static GLOBAL: time_report::CountingAlloc = time_report::CountingAlloc;
+
+/// Fases en el orden del pipeline. Las tres del medio son sub-fases
+/// que el backend registra dentro de `isa-compile`.
+const PHASES: &[&str] = &[
+    "preprocess",
+    "lex",
+    "parse",
+    "c-to-ir",
+    "isa-compile",
+    "isa-optimize",
+    "isa-schedule",
+    "encode",
+    "pe-write",
+];
+
+/// Formato del JSON de `--save`: cambiarlo rompe las baselines viejas
+const RESULTS_VERSION: u32 = 1;
+
+#[derive(Debug, Clone, Serialize, Deserialize)]
+struct PhaseResult {
+    input: String,
+    phase: String,
+    lines: usize,
+    median_us: u64,
+    allocs: u64,
+    alloc_bytes: u64,
+}
+
+#[derive(Debug, Serialize, Deserialize)]
+struct Results {
+    version: u32,
+    iterations: usize,
+    results: Vec<PhaseResult>,
+}
+
+struct Options {
+    filter: Option<String>,
+    quick: bool,
+    iters: usize,
+    save: Option<String>,
+    baseline: Option<String>,
+    threshold: f64,
+}
+
+fn parse_args() -> Options {
+    let mut opts = Options { filter: None, quick: false, iters: 5, save: None, baseline: None, threshold: 10.0 };
+    let mut args = std::env::args().skip(1);
+    while let Some(arg) = args.next() {
+        match arg.as_str() {
+            "--quick" => opts.quick = true,
+            "--iters" => opts.iters = args.next().and_then(|v| v.parse().ok()).unwrap_or(opts.iters).max(1),
+            "--save" => opts.save = args.next(),
+            "--baseline" => opts.baseline = args.next(),
+            "--threshold" => opts.threshold = args.next().and_then(|v| v.parse().ok()).unwrap_or(opts.threshold),
+            // cargo bench pasa `--bench`; el resto de flags de libtest se ignoran
+            a if a.starts_with("--") => {}
+            a => opts.filter = Some(a.to_string()),
+        }
+    }
+    if opts.quick && opts.iters == 5 {
+        opts.iters = 1;
+    }
+    opts
+}
+
+// ── Entradas ────────────────────────────────────────────────
+
+struct Input {
+    name: String,
+    source: String,
+    dir: PathBuf,
+}
+
+fn fixtures_dir() -> PathBuf {
+    Path::new(env!("CARGO_MANIFEST_DIR")).join("../../../../../tests/c/fixtures")
+}
+
+fn fixture_inputs() -> Vec<Input> {
+    let dir = fixtures_dir();
+    let mut paths: Vec<PathBuf> = fs::read_dir(&dir)
+        .map(|rd| rd.filter_map(|e| e.ok().map(|e| e.path())).collect())
+        .unwrap_or_default();
+    paths.retain(|p| p.extension().map_or(false, |e| e == "c"));
+    paths.sort();
+    paths
+        .into_iter()
+        .filter_map(|p| {
+            let source = fs::read_to_string(&p).ok()?;
+            let name = format!("fixture/{}", p.file_stem()?.to_string_lossy());
+            Some(Input { name, source, dir: dir.clone() })
+        })
+        .collect()
+}
+
+/// `main` con `lines` sentencias aritméticas encadenadas
+fn big_function(lines: usize) -> String {
+    let mut s = String::with_capacity(lines * 32);
+    s.push_str("int main() {\n    int a = 1;\n    int b = 2;\n    int c = 3;\n");
+    for i in 0..lines {
+        match i % 4 {
+            0 => s.push_str(&format!("    a = a + b * {};\n", i % 97 + 1)),
+            1 => s.push_str(&format!("    b = (b ^ a) + {};\n", i % 89)),
+            2 => s.push_str("    if (a > b) { c = c + 1; } else { c = c - 1; }\n"),
+            _ => s.push_str(&format!("    c = c * 3 + (a & {});\n", i % 255)),
+        }
+    }
+    s.push_str("    return a + b + c;\n}\n");
+    s
+}
+
+/// `count` funciones hoja pequeñas y un `main` que llama a cada una
+fn many_functions(count: usize) -> String {
+    let mut s = String::with_capacity(count * 96);
+    for i in 0..count {
+        s.push_str(&format!(
+            "int f{i}(int x, int y) {{\n    int t = x * {k} + y;\n    if (t > {k}) return t - y;\n    return t + {i};\n}}\n",
+            i = i,
+            k = i % 31 + 1
+        ));
+    }
+    s.push_str("int main() {\n    int acc = 0;\n");
+    for i in 0..count {
+        s.push_str(&format!("    acc = acc + f{}(acc, {});\n", i, i % 7));
+    }
+    s.push_str("    return acc;\n}\n");
+    s
+}
+
+/// Header con `macros` macros objeto y función, cada una usando la
+/// anterior, y una TU que las expande en cada línea
+fn macro_heavy(dir: &Path, macros: usize) -> std::io::Result<String> {
+    let mut header = String::from("#ifndef BENCH_MACROS_H\n#define BENCH_MACROS_H\n#define M0(x) ((x) + 1)\n#define K0 1\n");
+    for i in 1..macros {
+        header.push_str(&format!("#define M{i}(x) (M{p}(x) * 2 - K{p})\n#define K{i} (K{p} + {i})\n", i = i, p = i - 1));
+        if i % 100 == 0 {
+            header.push_str(&format!("#ifdef K{}\n#define HAS_{} 1\n#else\n#define HAS_{} 0\n#endif\n", i, i, i));
+        }
+    }
+    header.push_str("#endif\n");
+    fs::write(dir.join("bench_macros.h"), header)?;
+
+    let mut s = String::from("#include \"bench_macros.h\"\nint main() {\n    int v = 0;\n");
+    for i in 0..macros {
+        // Profundidad acotada: el coste crece lineal con las líneas
+        s.push_str(&format!("    v = M{}(v) + K{};\n", i % 8, i % 64));
+    }
+    s.push_str("    return v;\n}\n");
+    Ok(s)
+}
+
+fn synthetic_inputs(quick: bool) -> Vec<Input> {
+    let scale = if quick { 10 } else { 1 };
+    let dir = std::env::temp_dir().join(format!("adeb_bench_{}", std::process::id()));
+    let _ = fs::create_dir_all(&dir);
+    let mut inputs = vec![
+        Input { name: "synthetic/big_function".into(), source: big_function(100_000 / scale), dir: dir.clone() },
+        Input { name: "synthetic/many_functions".into(), source: many_functions(10_000 / scale), dir: dir.clone() },
+    ];
+    match macro_heavy(&dir, 5_000 / scale) {
+        Ok(source) => inputs.push(Input { name: "synthetic/macro_heavy".into(), source, dir }),
+        Err(e) => eprintln!("   macro_heavy: cannot write header: {}", e),
+    }
+    inputs
+}
+
+// ── Pipeline instrumentado ──────────────────────────────────
+
+/// Líneas que ve cada fase: el preprocesador la fuente, el resto el
+/// texto preprocesado
+struct LineCounts {
+    source: usize,
+    preprocessed: usize,
+}
+
+/// Una pasada completa; las spans quedan en el colector de time_report
+fn run_once(input: &Input) -> Result<LineCounts, String> {
+    let t = time_report::phase("preprocess");
+    let mut preprocessor = CPreprocessor::new();
+    preprocessor.set_inject_headers(false);
+    preprocessor.set_use_precompiled(false);
+    preprocessor.set_source_dir(&input.dir);
+    let preprocessed = preprocessor.process(&input.source);
+    drop(t);
+    // Los headers built-in se parsean una vez por proceso (como en batch):
+    // fuera de las fases medidas
+    let headers = header_cache::load_headers(preprocessor.include_order())?;
+    let lines = LineCounts { source: input.source.lines().count(), preprocessed: preprocessed.lines().count() };
+
+    let t = time_report::phase("lex");
+    let (tokens, token_lines) = CLexer::new(&preprocessed).tokenize();
+    drop(t);
+    let mut roots: Vec<String> = tokens
+        .iter()
+        .filter_map(|t| match t {
+            CToken::Identifier(name) => Some(name.as_str().to_string()),
+            _ => None,
+        })
+        .collect::<HashSet<_>>()
+        .into_iter()
+        .collect();
+    roots.sort();
+
+    let t = time_report::phase("parse");
+    let mut parser = CParser::new(tokens, token_lines);
+    parser.seed_typedef_names(headers.typedef_names.iter().cloned());
+    let mut unit = parser.parse_translation_unit()?;
+    drop(t);
+    unit.declarations.splice(0..0, headers.materialize(roots.iter().map(String::as_str)));
+
+    let t = time_report::phase("c-to-ir");
+    let program = CToIR::new().convert(&unit)?;
+    drop(t);
+
+    let mut compiler = CIsaCompiler::new(Target::Windows);
+    compiler.set_codegen_jobs(codegen_jobs());
+    let t = time_report::phase("isa-compile");
+    let (code, data, iat_offsets, string_offsets) = compiler.compile(&program);
+    drop(t);
+
+    let t = time_report::phase("pe-write");
+    let image = adeb_backend_x64::pe::build_pe_image_with_debug(
+        &code,
+        &data,
+        &iat_offsets,
+        &string_offsets,
+        compiler.used_iat_slots(),
+        &ImportOptions::default(),
+        None,
+    )
+    .map_err(|e| e.to_string())?;
+    drop(t);
+    std::hint::black_box(image);
+    Ok(lines)
+}
+
+fn codegen_jobs() -> usize {
+    std::env::var("ADEB_JOBS").ok().and_then(|v| v.trim().parse().ok()).unwrap_or(1).max(1)
+}
+
+/// Tiempo y asignaciones de una fase en una iteración. Las sub-fases
+/// pueden repetirse (una por función o por hilo): se suman.
+fn phase_totals(spans: &[Span]) -> BTreeMap<&str, (u64, u64, u64)> {
+    let mut totals: BTreeMap<&str, (u64, u64, u64)> = BTreeMap::new();
+    for s in spans.iter().filter(|s| s.cat == time_report::PHASE || s.cat == time_report::SUBPHASE) {
+        let e = totals.entry(s.name.as_str()).or_default();
+        e.0 += s.dur_us;
+        e.1 += s.allocs;
+        e.2 += s.alloc_bytes;
+    }
+    totals
+}
+
+fn bench_input(input: &Input, iters: usize) -> Result<Vec<PhaseResult>, String> {
+    let mut samples: BTreeMap<&str, Vec<u64>> = BTreeMap::new();
+    let mut allocs: BTreeMap<&str, (u64, u64)> = BTreeMap::new();
+    let mut lines = LineCounts { source: 0, preprocessed: 0 };
+
+    // Una pasada de calentamiento (caches de headers, page faults)
+    time_report::take();
+    run_once(input)?;
+    time_report::take();
+
+    for _ in 0..iters {
+        lines = run_once(input)?;
+        let spans = time_report::take();
+        for (phase, (us, n, bytes)) in phase_totals(&spans) {
+            let Some(&phase) = PHASES.iter().find(|p| **p == phase) else { continue };
+            samples.entry(phase).or_default().push(us);
+            // Las asignaciones son deterministas: vale la última iteración
+            allocs.insert(phase, (n, bytes));
+        }
+    }
+
+    Ok(PHASES
+        .iter()
+        .filter_map(|phase| {
+            let times = samples.get_mut(phase)?;
+            times.sort_unstable();
+            let (n, bytes) = allocs.get(phase).copied().unwrap_or_default();
+            Some(PhaseResult {
+                input: input.name.clone(),
+                phase: phase.to_string(),
+                lines: if *phase == "preprocess" { lines.source } else { lines.preprocessed },
+                median_us: times[times.len() / 2],
+                allocs: n,
+                alloc_bytes: bytes,
+            })
+        })
+        .collect())
+}
+
+// ── Salida ──────────────────────────────────────────────────
+
+fn lines_per_sec(r: &PhaseResult) -> f64 {
+    r.lines as f64 * 1_000_000.0 / r.median_us.max(1) as f64
+}
+
+fn print_input(name: &str, results: &[PhaseResult]) {
+    println!("   {}", name);
+    for r in results {
+        println!(
+            "     {:<14} {:>10.3} ms {:>12.0} lines/s {:>10} allocs {:>12} bytes",
+            r.phase,
+            r.median_us as f64 / 1000.0,
+            lines_per_sec(r),
+            r.allocs,
+            r.alloc_bytes
+        );
+    }
+}
+
+/// Compara contra la baseline; devuelve cuántas fases empeoraron más
+/// de `threshold` %. Fases de menos de 1 ms se ignoran (ruido).
+fn compare(baseline: &Results, current: &[PhaseResult], threshold: f64) -> usize {
+    let old: BTreeMap<(&str, &str), &PhaseResult> =
+        baseline.results.iter().map(|r| ((r.input.as_str(), r.phase.as_str()), r)).collect();
+    let mut regressions = 0;
+    println!();
+    println!("   ===-- vs baseline (threshold {:.1}%) --===", threshold);
+    for r in current {
+        let Some(prev) = old.get(&(r.input.as_str(), r.phase.as_str())) else { continue };
+        let delta = (r.median_us as f64 - prev.median_us as f64) * 100.0 / prev.median_us.max(1) as f64;
+        let alloc_delta = r.allocs as i64 - prev.allocs as i64;
+        let slow = delta > threshold && prev.median_us.max(r.median_us) >= 1000;
+        if slow {
+            regressions += 1;
+        }
+        if slow || alloc_delta != 0 {
+            println!(
+                "   {} {:<32} {:<14} {:>+7.1}% time {:>+10} allocs",
+                if slow { "REGRESSION" } else { "          " },
+                r.input,
+                r.phase,
+                delta,
+                alloc_delta
+            );
+        }
+    }
+    println!("   {} regression(s)", regressions);
+    regressions
+}
+
+fn main() -> ExitCode {
+    let opts = parse_args();
+    let mut inputs = fixture_inputs();
+    inputs.extend(synthetic_inputs(opts.quick));
+    if let Some(f) = &opts.filter {
+        inputs.retain(|i| i.name.contains(f.as_str()));
+    }
+
+    time_report::enable();
+    println!("   ===-- adB compiler throughput ({} iterations, median) --===", opts.iters);
+    let mut all = Vec::new();
+    for input in &inputs {
+        match bench_input(input, opts.iters) {
+            Ok(results) => {
+                print_input(&input.name, &results);
+                all.extend(results);
+            }
+            Err(e) => println!("   {}: skipped ({})", input.name, e),
+        }
+    }
+
+    let results = Results { version: RESULTS_VERSION, iterations: opts.iters, results: all };
+    if let Some(path) = &opts.save {
+        match serde_json::to_string_pretty(&results).map_err(|e| e.to_string()).and_then(|j| fs::write(path, j).map_err(|e| e.to_string())) {
+            Ok(()) => println!("   Saved: {}", path),
+            Err(e) => eprintln!("   Cannot save '{}': {}", path, e),
+        }
+    }
+    if let Some(path) = &opts.baseline {
+        let baseline = fs::read_to_string(path)
+            .map_err(|e| e.to_string())
+            .and_then(|s| serde_json::from_str::<Results>(&s).map_err(|e| e.to_string()));
+        match baseline {
+            Ok(b) if b.version == RESULTS_VERSION => {
+                if compare(&b, &results.results, opts.threshold) > 0 {
+                    return ExitCode::FAILURE;
+                }
+            }
+            Ok(b) => eprintln!("   Baseline '{}' has format v{}, expected v{}", path, b.version, RESULTS_VERSION),
+            Err(e) => eprintln!("   Cannot read baseline '{}': {}", path, e),
+        }
+    }
+    ExitCode::SUCCESS
+}
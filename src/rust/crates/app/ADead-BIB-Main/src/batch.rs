@@ -0,0 +1,284 @@
+// ============================================================
+// adB cc --batch — many independent programs in one process
+// ============================================================
+//   adB cc --batch list.txt  [--jobs N] [--out-dir D] [--summary s.json]
+//   adB cc --batch 'tests/c/fixtures/*.c' -Wstrict
+//
+// Cada entrada se compila a su propio ejecutable en un pool de `--jobs`
+// hilos (ADEB_JOBS / núcleos por defecto). Los headers built-in se
+// parsean una vez por combinación de includes y los comparten todas.
+// El resto de flags se aplica a cada entrada como si se hubiera lanzado
+// `adB cc <entrada> <flags>`.
+//
+// La lista tiene una fuente por línea (rutas relativas al cwd), `#`
+// comenta. Sin --out-dir cada ejecutable queda al lado de su fuente.
+// ============================================================
+
+use crate::{compile_with_driver, default_output_filename, parse_request, Language};
+use adeb_core::time_report;
+use serde::Serialize;
+use std::path::{Path, PathBuf};
+use std::time::Instant;
+
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct BatchOptions {
+    /// Lista de fuentes o patrón con `*` / `?` en el nombre de archivo
+    pub spec: String,
+    pub jobs: Option<usize>,
+    pub out_dir: Option<String>,
+    pub summary: Option<String>,
+}
+
+/// Resultado de una entrada, tal como va al resumen JSON
+#[derive(Debug, Clone, Serialize)]
+pub struct BatchResult {
+    pub input: String,
+    pub output: String,
+    pub ok: bool,
+    pub error: Option<String>,
+    pub millis: u64,
+}
+
+#[derive(Debug, Serialize)]
+struct BatchSummary<'a> {
+    jobs: usize,
+    total_millis: u64,
+    succeeded: usize,
+    failed: usize,
+    results: &'a [BatchResult],
+}
+
+/// Saca `--batch <spec>`, `--jobs N`, `--out-dir D` y `--summary f` de
+/// argv; `None` si no hay `--batch`
+pub fn take_batch_args(args: &[String]) -> Result<Option<(BatchOptions, Vec<String>)>, String> {
+    if !args.iter().any(|a| a == "--batch") {
+        return Ok(None);
+    }
+    let mut options = BatchOptions::default();
+    let mut rest = Vec::with_capacity(args.len());
+    let mut i = 0;
+    while i < args.len() {
+        let flag = args[i].as_str();
+        if !matches!(flag, "--batch" | "--jobs" | "--out-dir" | "--summary") {
+            rest.push(args[i].clone());
+            i += 1;
+            continue;
+        }
+        let value = args.get(i + 1).ok_or_else(|| format!("Missing value after {}", flag))?.clone();
+        match flag {
+            "--batch" => options.spec = value,
+            "--jobs" => {
+                let jobs = value.parse::<usize>().ok().filter(|&n| n > 0);
+                options.jobs = Some(jobs.ok_or_else(|| format!("Invalid job count '{}'", value))?);
+            }
+            "--out-dir" => options.out_dir = Some(value),
+            _ => options.summary = Some(value),
+        }
+        i += 2;
+    }
+    Ok(Some((options, rest)))
+}
+
+/// Entradas de `spec`: un patrón o una lista, en orden estable
+pub fn batch_inputs(spec: &str) -> Result<Vec<String>, String> {
+    let path = Path::new(spec);
+    let name = path.file_name().and_then(|n| n.to_str()).unwrap_or_default();
+    if !name.contains(['*', '?']) {
+        let text = std::fs::read_to_string(path).map_err(|e| format!("Cannot read batch list '{}': {}", spec, e))?;
+        return Ok(text
+            .lines()
+            .map(str::trim)
+            .filter(|l| !l.is_empty() && !l.starts_with('#'))
+            .map(str::to_string)
+            .collect());
+    }
+
+    let dir = path.parent().filter(|d| !d.as_os_str().is_empty()).unwrap_or(Path::new("."));
+    if dir.to_string_lossy().contains(['*', '?']) {
+        return Err(format!("Only the file name may contain wildcards in '{}'", spec));
+    }
+    let entries = std::fs::read_dir(dir).map_err(|e| format!("Cannot read '{}': {}", dir.display(), e))?;
+    let mut inputs: Vec<String> = entries
+        .filter_map(|e| e.ok())
+        .filter(|e| e.file_type().map_or(false, |t| t.is_file()))
+        .filter(|e| e.file_name().to_str().map_or(false, |n| wildcard_match(name, n)))
+        .map(|e| dir.join(e.file_name()).to_string_lossy().into_owned())
+        .collect();
+    inputs.sort();
+    Ok(inputs)
+}
+
+/// `*` = cualquier tramo, `?` = un carácter
+fn wildcard_match(pattern: &str, name: &str) -> bool {
+    let (p, n): (Vec<char>, Vec<char>) = (pattern.chars().collect(), name.chars().collect());
+    let (mut pi, mut ni) = (0, 0);
+    let mut star: Option<(usize, usize)> = None;
+    while ni < n.len() {
+        if pi < p.len() && (p[pi] == '?' || p[pi] == n[ni]) {
+            pi += 1;
+            ni += 1;
+        } else if pi < p.len() && p[pi] == '*' {
+            star = Some((pi, ni));
+            pi += 1;
+        } else if let Some((sp, sn)) = star {
+            pi = sp + 1;
+            ni = sn + 1;
+            star = Some((sp, sn + 1));
+        } else {
+            return false;
+        }
+    }
+    p[pi..].iter().all(|&c| c == '*')
+}
+
+/// Ejecutable de `input`: en `out_dir`, o al lado de la fuente
+fn batch_output(input: &str, out_dir: Option<&str>) -> String {
+    let name = default_output_filename(input);
+    let dir = match out_dir {
+        Some(dir) => PathBuf::from(dir),
+        None => Path::new(input).parent().map(Path::to_path_buf).unwrap_or_default(),
+    };
+    dir.join(name).to_string_lossy().into_owned()
+}
+
+/// Compila cada entrada de `options.spec` con los flags de `args`
+pub fn run_batch(
+    options: &BatchOptions,
+    args: &[String],
+    lang: Language,
+) -> Result<Vec<BatchResult>, Box<dyn std::error::Error>> {
+    let inputs = batch_inputs(&options.spec)?;
+    if inputs.is_empty() {
+        return Err(format!("No sources in batch '{}'", options.spec).into());
+    }
+    if let Some(dir) = &options.out_dir {
+        std::fs::create_dir_all(dir).map_err(|e| format!("Cannot create '{}': {}", dir, e))?;
+    }
+    // Los flags se validan una vez, antes de lanzar nada
+    let argv = |input: &str, output: &str| {
+        let mut argv = args.to_vec();
+        argv.extend([input.to_string(), "-o".to_string(), output.to_string()]);
+        argv
+    };
+    let first = parse_request(&argv(&inputs[0], "a.exe"), lang)?;
+    if first.input_files.len() > 1 || first.pch {
+        return Err("--batch takes its sources from the list, not from the command line".into());
+    }
+    // -ftime-report / --trace-json suman todas las entradas
+    let timed = first.time_report || first.trace_json.is_some();
+    if timed {
+        time_report::enable();
+    }
+
+    let jobs = options.jobs.unwrap_or_else(adeb_core::parallel::default_jobs);
+    println!("   Batch: {} sources, {} jobs", inputs.len(), jobs);
+    let start = Instant::now();
+    let results = adeb_core::parallel::par_map(&inputs, jobs, |input| {
+        let output = batch_output(input, options.out_dir.as_deref());
+        let t = Instant::now();
+        let result = parse_request(&argv(input, &output), lang).map_err(|e| e.to_string()).and_then(|request| {
+            // Un panic en una entrada no tumba al resto del batch
+            std::panic::catch_unwind(|| compile_with_driver(&request, lang).map_err(|e| e.to_string()))
+                .unwrap_or_else(|_| Err("internal compiler error (panic)".to_string()))
+        });
+        BatchResult {
+            input: input.clone(),
+            output,
+            ok: result.is_ok(),
+            error: result.err(),
+            millis: t.elapsed().as_millis() as u64,
+        }
+    });
+    let total_millis = start.elapsed().as_millis() as u64;
+
+    if timed {
+        let spans = time_report::take();
+        if first.time_report {
+            print!("{}", time_report::render_report(&spans));
+        }
+        if let Some(path) = &first.trace_json {
+            time_report::write_chrome_trace(path, &spans)
+                .map_err(|e| format!("Cannot write trace '{}': {}", path, e))?;
+        }
+    }
+
+    let failed = results.iter().filter(|r| !r.ok).count();
+    println!("   Batch results:");
+    for r in &results {
+        match &r.error {
+            None => println!("     ok    {:>6} ms  {}", r.millis, r.input),
+            Some(e) => println!("     FAIL  {:>6} ms  {}: {}", r.millis, r.input, e),
+        }
+    }
+    println!(
+        "   Batch: {} ok, {} failed, {} ms total",
+        results.len() - failed,
+        failed,
+        total_millis
+    );
+    if let Some(path) = &options.summary {
+        let summary = BatchSummary { jobs, total_millis, succeeded: results.len() - failed, failed, results: &results };
+        let json = serde_json::to_string_pretty(&summary)?;
+        std::fs::write(path, json).map_err(|e| format!("Cannot write summary '{}': {}", path, e))?;
+        println!("   Summary written: {}", path);
+    }
+    Ok(results)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn str_args(values: &[&str]) -> Vec<String> {
+        values.iter().map(|value| value.to_string()).collect()
+    }
+
+    #[test]
+    fn batch_flags_are_taken_out() {
+        let args = str_args(&["adB", "cc", "--batch", "l.txt", "-Wstrict", "--jobs", "4", "--summary", "s.json"]);
+        let (options, rest) = take_batch_args(&args).unwrap().unwrap();
+        assert_eq!(options.spec, "l.txt");
+        assert_eq!(options.jobs, Some(4));
+        assert_eq!(options.summary.as_deref(), Some("s.json"));
+        assert_eq!(rest, str_args(&["adB", "cc", "-Wstrict"]));
+        assert!(take_batch_args(&str_args(&["adB", "cc", "a.c"])).unwrap().is_none());
+        assert!(take_batch_args(&str_args(&["adB", "cc", "--batch", "l.txt", "--jobs", "0"])).is_err());
+    }
+
+    #[test]
+    fn wildcards() {
+        assert!(wildcard_match("*.c", "01_basic.c"));
+        assert!(wildcard_match("0?_*.c", "01_basic.c"));
+        assert!(!wildcard_match("*.c", "01_basic.cpp"));
+        assert!(wildcard_match("*", ""));
+        assert!(!wildcard_match("a*b", "ac"));
+    }
+
+    #[test]
+    fn batch_compiles_each_input() {
+        let dir = std::env::temp_dir().join(format!("adeb_batch_{}", std::process::id()));
+        std::fs::create_dir_all(&dir).unwrap();
+        std::fs::write(dir.join("a.c"), "int main() { return 0; }\n").unwrap();
+        std::fs::write(dir.join("b.c"), "#include <stdio.h>\nint main() { printf(\"b\\n\"); return 0; }\n").unwrap();
+        let file = |name: &str| dir.join(name).to_string_lossy().into_owned();
+        assert_eq!(batch_inputs(&file("*.c")).unwrap(), [file("a.c"), file("b.c")]);
+        let list = format!("# fixtures\n{}\n\n{}\n{}\n", file("a.c"), file("b.c"), file("missing.c"));
+        std::fs::write(dir.join("list.txt"), list).unwrap();
+
+        let out = dir.join("out");
+        let options = BatchOptions {
+            spec: file("list.txt"),
+            jobs: Some(2),
+            out_dir: Some(out.to_string_lossy().into_owned()),
+            summary: Some(dir.join("summary.json").to_string_lossy().into_owned()),
+        };
+        let results = run_batch(&options, &str_args(&["adB", "cc"]), Language::C).unwrap();
+        let ok: Vec<bool> = results.iter().map(|r| r.ok).collect();
+        assert_eq!(ok, [true, true, false]);
+        assert!(Path::new(&results[0].output).exists());
+        assert!(results[0].output.starts_with(out.to_string_lossy().as_ref()));
+        let summary = std::fs::read_to_string(dir.join("summary.json")).unwrap();
+        assert!(summary.contains("\"failed\": 1"), "{}", summary);
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
@@ -0,0 +1,109 @@
+// ============================================================
+// ADead-BIB — Post-link Driver (adB bolt)
+// ============================================================
+//   adB bolt <app.exe> --profile <file> [-o out]
+//
+// Re-lays out the .text of an already linked PE from a sampled
+// branch profile (`perf script -F brstack` or pre-aggregated
+// B/F records): hot paths become fall-through and cold blocks
+// move to the end of the section. Imports and data are untouched.
+// ============================================================
+
+use crate::cli::term;
+use adeb_backend_x64::isa::post_link::BranchProfile;
+
+pub struct BoltRequest {
+    pub input_file: String,
+    pub profile_file: String,
+    pub output_file: String,
+}
+
+pub fn parse_bolt_args(args: &[String]) -> Result<BoltRequest, Box<dyn std::error::Error>> {
+    let mut input_file = None;
+    let mut profile_file = None;
+    let mut output_file = None;
+    let mut i = 2;
+
+    while i < args.len() {
+        match args[i].as_str() {
+            "-o" | "--profile" | "-p" => {
+                let value = args
+                    .get(i + 1)
+                    .ok_or_else(|| format!("Missing value after {} in 'bolt'", args[i]))?
+                    .clone();
+                if args[i] == "-o" {
+                    output_file = Some(value);
+                } else {
+                    profile_file = Some(value);
+                }
+                i += 2;
+            }
+            flag if flag.starts_with('-') => {
+                return Err(format!("Unknown option '{}' in 'bolt'", flag).into());
+            }
+            value => {
+                if input_file.is_some() {
+                    return Err(format!("Unexpected extra argument '{}' in 'bolt'", value).into());
+                }
+                input_file = Some(value.to_string());
+                i += 1;
+            }
+        }
+    }
+
+    let input_file: String =
+        input_file.ok_or("Missing image for 'bolt'. Usage: adB bolt <app.exe> --profile <file>")?;
+    let profile_file = profile_file.ok_or("Missing --profile <file> for 'bolt'")?;
+    let output_file = output_file.unwrap_or_else(|| default_bolt_output(&input_file));
+    Ok(BoltRequest { input_file, profile_file, output_file })
+}
+
+/// app.exe → app.bolt.exe
+fn default_bolt_output(input_file: &str) -> String {
+    match input_file.rsplit_once('.') {
+        Some((stem, ext)) if !stem.is_empty() && !ext.contains(['/', '\\']) => {
+            format!("{}.bolt.{}", stem, ext)
+        }
+        _ => format!("{}.bolt", input_file),
+    }
+}
+
+pub fn run_bolt(request: &BoltRequest) -> Result<(), Box<dyn std::error::Error>> {
+    println!("  ADead-BIB post-link optimizer");
+    println!("   Image:   {}", request.input_file);
+    println!("   Profile: {}", request.profile_file);
+
+    let image = std::fs::read(&request.input_file)
+        .map_err(|e| format!("Cannot read '{}': {}", request.input_file, e))?;
+    let profile = BranchProfile::load(&request.profile_file)?;
+    let (out, stats) = adeb_backend_x64::pe::relayout_pe_image(&image, &profile)?;
+    std::fs::write(&request.output_file, out)
+        .map_err(|e| format!("Cannot write '{}': {}", request.output_file, e))?;
+
+    println!("   {} {}", term::dim("Layout:"), stats);
+    println!("  {} {}", term::ok("Done:"), request.output_file);
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn str_args(values: &[&str]) -> Vec<String> {
+        values.iter().map(|value| value.to_string()).collect()
+    }
+
+    #[test]
+    fn parse_bolt_defaults_output_next_to_input() {
+        let args = str_args(&["adB", "bolt", "app.exe", "--profile", "perf.txt"]);
+        let request = parse_bolt_args(&args).unwrap();
+        assert_eq!(request.input_file, "app.exe");
+        assert_eq!(request.profile_file, "perf.txt");
+        assert_eq!(request.output_file, "app.bolt.exe");
+
+        let args = str_args(&["adB", "bolt", "app.exe", "-o", "fast.exe"]);
+        assert!(parse_bolt_args(&args).is_err());
+        let args = str_args(&["adB", "bolt", "app.exe", "-p", "perf.txt", "-o", "fast.exe"]);
+        assert_eq!(parse_bolt_args(&args).unwrap().output_file, "fast.exe");
+    }
+}
@@ -13,17 +13,36 @@
 // ============================================================
 
 use crate::cli::term;
+use adeb_backend_x64::iat_registry::{self, ImportOptions};
 use adeb_backend_x64::isa::c_isa::CIsaCompiler;
-use adeb_backend_x64::isa::isa_compiler::Target;
-use adeb_core::ast::Program;
-use adeb_frontend_c::ast::{CDeclarator, CDerivedType, CTopLevel, CTranslationUnit, CType};
+use adeb_backend_x64::isa::isa_compiler::{FunctionCodeStats, Target};
+use adeb_backend_x64::isa::scheduler::Uarch;
+use adeb_core::ast::{Program, Stmt};
+use adeb_core::cache::hasher::hash_closure;
+use adeb_core::cache::objects::{object_key, ObjectCache};
+use adeb_core::cache::{build_id, CachedUBReport};
+use adeb_core::time_report;
+use adeb_core::{FxHashSet, Ident};
+use adeb_frontend_c::ast::{
+    CBinOp, CDeclarator, CDerivedType, CExpr, CInitializer, CStmt, CTopLevel, CTranslationUnit, CType,
+};
+use adeb_frontend_c::header_cache;
 use adeb_frontend_c::lower::to_ir::CToIR;
 use adeb_frontend_c::parse::lexer::CToken;
 use adeb_frontend_c::parse::parser::CParser;
+use adeb_frontend_c::pch::{self, PrecompiledHeader};
 use adeb_frontend_c::preprocessor::CPreprocessor;
 use adeb_frontend_c::CLexer;
-use std::collections::BTreeMap;
+use adeb_middle::lto::{self, LtoOptions};
+use adeb_middle::optimizer::inline_exp::InlineExpander;
+use adeb_middle::profile::{self, Profile};
+use adeb_middle::strict_type_checker::TypeCompatResult;
+use adeb_middle::{StrictCheckCache, StrictTypeChecker};
+use serde::{Deserialize, Serialize};
+use std::collections::{BTreeMap, HashMap, HashSet};
 use std::fs;
+use std::ops::Range;
+use std::path::Path;
 
 // ── Public types ────────────────────────────────────────────
 
@@ -31,6 +50,8 @@ use std::fs;
 pub struct CPipelineArtifacts {
     pub preprocessed: String,
     pub included_headers: Vec<String>,
+    /// User headers the TU depends on (pasted or precompiled)
+    pub user_headers: Vec<String>,
     pub tokens: Vec<CToken>,
     pub token_lines: Vec<usize>,
     pub unit: CTranslationUnit,
@@ -79,6 +100,37 @@ pub enum UBKind {
     DeadCode,
 }
 
+impl UBKind {
+    const ALL: [UBKind; 21] = [
+        UBKind::NullPointerDereference,
+        UBKind::DivisionByZero,
+        UBKind::ArrayOutOfBounds,
+        UBKind::UninitializedVariable,
+        UBKind::ShiftOverflow,
+        UBKind::SignedIntegerOverflow,
+        UBKind::FormatStringMismatch,
+        UBKind::UseAfterFree,
+        UBKind::DoubleFree,
+        UBKind::BufferOverflow,
+        UBKind::DanglingPointer,
+        UBKind::InvalidCast,
+        UBKind::UnsequencedModification,
+        UBKind::StrictAliasingViolation,
+        UBKind::AlignmentViolation,
+        UBKind::DataRace,
+        UBKind::StackOverflow,
+        UBKind::MemoryLeak,
+        UBKind::IntegerTruncation,
+        UBKind::InfiniteLoop,
+        UBKind::DeadCode,
+    ];
+
+    /// Inverse of `{:?}` (how fastos.bib stores the kind)
+    fn from_name(name: &str) -> Option<UBKind> {
+        Self::ALL.iter().find(|k| format!("{:?}", k) == name).cloned()
+    }
+}
+
 #[derive(Debug, Clone)]
 pub struct UBWarning {
     pub kind: UBKind,
@@ -104,29 +156,123 @@ impl UBReport {
 
 // ── Pipeline ────────────────────────────────────────────────
 
-/// Full C compilation pipeline: source → preprocessor → lexer → parser → semantic → UB → IR
+/// Full C compilation pipeline: source → preprocessor → lexer → parser → semantic → UB → IR.
+/// Builds go through `lower_c_source_in` (`compile_c_pipeline_in` in
+/// step mode, which keeps every phase); this runs one in the cwd for tests.
+#[cfg(test)]
 pub fn compile_c_pipeline(source: &str, strict: bool) -> Result<CPipelineArtifacts, String> {
-    // Phase 0: Preprocess
+    compile_c_pipeline_in(source, Path::new("."), strict)
+}
+
+/// `compile_c_pipeline` for a TU in `source_dir`, where its
+/// `#include "..."` headers (and their precompiled images) are found
+pub fn compile_c_pipeline_in(source: &str, source_dir: &Path, strict: bool) -> Result<CPipelineArtifacts, String> {
+    run_c_pipeline(source, source_dir, strict, true)
+}
+
+/// The pipeline as a build runs it: preprocessed text, tokens and AST
+/// are freed as soon as the next phase has consumed them (function
+/// bodies one by one while lowering), so peak memory stays near the IR
+/// instead of text + tokens + AST + IR. Only `included_headers`,
+/// `user_headers`, `ub_report` and `program` are filled in.
+pub fn lower_c_source_in(source: &str, source_dir: &Path, strict: bool) -> Result<CPipelineArtifacts, String> {
+    run_c_pipeline(source, source_dir, strict, false)
+}
+
+fn run_c_pipeline(source: &str, source_dir: &Path, strict: bool, keep: bool) -> Result<CPipelineArtifacts, String> {
+    // Phase 0: Preprocess (built-in headers come pre-parsed from fastos.bib,
+    // user headers from their `--pch` image when it is up to date)
+    let t = time_report::phase("preprocess");
     let mut preprocessor = CPreprocessor::new();
+    preprocessor.set_inject_headers(false);
+    preprocessor.set_source_dir(source_dir);
     let preprocessed = preprocessor.process(source);
     let mut included_headers: Vec<String> = preprocessor.included_headers().iter().cloned().collect();
     included_headers.sort();
+    let precompiled = preprocessor.precompiled().to_vec();
+    let mut user_headers = preprocessor.user_headers().to_vec();
+    user_headers.extend(precompiled.iter().flat_map(|p| p.files.iter().cloned()));
+    drop(t);
+    let t = time_report::phase("headers");
+    let headers = header_cache::load_headers(preprocessor.include_order())?;
+    drop(t);
 
     // Phase 1: Lex
+    let t = time_report::phase("lex");
     let (tokens, token_lines) = CLexer::new(&preprocessed).tokenize();
-
-    // Phase 2: Parse
-    let unit = CParser::new(tokens.clone(), token_lines.clone()).parse_translation_unit()?;
-
-    // Phase 3: Semantic snapshot
-    let semantic = collect_semantic_snapshot(&unit);
-
-    // Phase 4: UB Detection (on AST, before lowering)
-    let mut ub_report = detect_ub_in_ast(&unit);
+    let preprocessed = if keep { preprocessed } else { String::new() };
+    // Roots of the built-in declarations to materialize, one per name
+    let mut seen = FxHashSet::default();
+    let identifiers: Vec<Ident> = tokens
+        .iter()
+        .filter_map(|t| match t {
+            CToken::Identifier(name) if seen.insert(name.id()) => Some(name.clone()),
+            _ => None,
+        })
+        .collect();
+    drop(t);
+
+    // Phase 2: Parse — header typedefs seeded, header declarations prepended
+    // (built-in first, then precompiled user headers). Only the built-in
+    // declarations the TU (or a precompiled header) reaches are materialized.
+    let t = time_report::phase("parse");
+    let (tokens, token_lines, mut parser) = if keep {
+        let parser = CParser::new(tokens.clone(), token_lines.clone());
+        (tokens, token_lines, parser)
+    } else {
+        (Vec::new(), Vec::new(), CParser::new(tokens, token_lines))
+    };
+    parser.seed_typedef_names(headers.typedef_names.iter().cloned());
+    for pch in &precompiled {
+        parser.seed_typedef_names(pch.typedef_names.iter().cloned());
+    }
+    let mut unit = parser.parse_translation_unit()?;
+    drop(parser);
+    let mut pch_names = Vec::new();
+    for decl in precompiled.iter().flat_map(|p| &p.declarations) {
+        header_cache::referenced_names(decl, &mut pch_names);
+    }
+    let roots = identifiers
+        .iter()
+        .map(Ident::as_str)
+        .chain(pch_names.iter().map(String::as_str));
+    let builtin_decls = headers.materialize(roots);
+    let builtin_len = builtin_decls.len();
+    let precompiled_decls = precompiled.iter().flat_map(|p| p.declarations.iter().cloned());
+    unit.declarations.splice(0..0, builtin_decls.into_iter().chain(precompiled_decls));
+    let precompiled_len: usize = precompiled.iter().map(|p| p.declarations.len()).sum();
+    let precompiled_range = builtin_len..builtin_len + precompiled_len;
+    // Header definitions are repeated in every TU that includes them
+    let mut header_defs: HashSet<String> = HashSet::new();
+    for decl in &unit.declarations[..precompiled_range.end] {
+        match decl {
+            CTopLevel::FunctionDef { name, .. } => {
+                header_defs.insert(name.clone());
+            }
+            CTopLevel::GlobalVar { declarators, .. } => {
+                header_defs.extend(declarators.iter().map(|d| d.name.clone()));
+            }
+            _ => {}
+        }
+    }
+    drop(t);
+
+    // Phase 3 + 4: Semantic snapshot, UB detection and (strict) bit-width
+    // checks in one pass over the AST, before lowering. Precompiled
+    // functions were UB-checked when their header was built: replay that.
+    let t = time_report::phase("ub-detect");
+    let analysis = analyze_unit(&unit.declarations, precompiled_range, strict, keep);
+    let semantic = analysis
+        .semantic
+        .unwrap_or_else(|| SemanticSnapshot { entries: Vec::new(), duplicate_symbols: Vec::new() });
+    let mut ub_report = UBReport { warnings: analysis.ub };
+    for pch in &precompiled {
+        replay_ub_reports(&pch.ub_reports, &mut ub_report);
+    }
 
     // Phase 4b: Strict mode — additional bit-width & type safety checks
     if strict {
-        detect_strict_violations(&unit, &mut ub_report);
+        ub_report.warnings.extend(analysis.strict);
         // In strict mode, promote all warnings to errors
         for w in &mut ub_report.warnings {
             if w.severity == "warning" {
@@ -134,14 +280,34 @@ pub fn compile_c_pipeline(source: &str, strict: bool) -> Result<CPipelineArtifac
             }
         }
     }
+    drop(t);
 
     // Phase 5: Lower to IR
+    let t = time_report::phase("c-to-ir");
     let mut lower = CToIR::new();
-    let program = lower.convert(&unit)?;
+    let (mut program, unit) = if keep {
+        (lower.convert(&unit)?, unit)
+    } else {
+        (lower.convert_owned(unit)?, CTranslationUnit::new())
+    };
+    let attrs = &mut program.attributes;
+    attrs.internal_symbols.retain(|name| !header_defs.contains(name));
+    attrs.external_definitions.retain(|name| !header_defs.contains(name));
+    drop(t);
+
+    // Phase 5b: Strict mode — whole-program type check on the IR; bodies
+    // unchanged since an earlier build (serve, batch) come from the cache.
+    // Reported as warnings: they do not stop the build like the checks above
+    if strict {
+        let t = time_report::phase("strict-types");
+        ub_report.warnings.extend(strict_type_warnings(&program, StrictCheckCache::global()));
+        drop(t);
+    }
 
     Ok(CPipelineArtifacts {
         preprocessed,
         included_headers,
+        user_headers,
         tokens,
         token_lines,
         unit,
@@ -151,14 +317,43 @@ pub fn compile_c_pipeline(source: &str, strict: bool) -> Result<CPipelineArtifac
     })
 }
 
+/// Profile-guided optimization: `-fprofile-generate[=file]` builds an
+/// instrumented binary that writes `file` at exit; `-fprofile-use=file`
+/// feeds those counts back into code generation.
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub enum PgoMode {
+    #[default]
+    Off,
+    Generate(String),
+    Use(String),
+}
+
+/// Code-generation flags for the C driver (everything but the file names)
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct CCompileOptions {
+    pub step_mode: bool,
+    pub strict: bool,
+    pub pgo: PgoMode,
+    /// -mtune=<cpu>
+    pub tune: Option<Uarch>,
+    /// -flto: optimize the linked Program of all TUs
+    pub lto: bool,
+    /// -fdelay-load: d3dcompiler/dxgi are loaded on first call
+    pub delay_load: bool,
+    /// -g: function symbols and line table in the PE
+    pub debug_info: bool,
+    /// -fbuiltin-malloc: size-class heap instead of msvcrt
+    pub builtin_malloc: bool,
+}
+
 /// Compile a .c file to a PE executable
 pub fn compile_c_file(
     input_file: &str,
     output_file: &str,
-    step_mode: bool,
-    strict: bool,
+    options: &CCompileOptions,
 ) -> Result<(), Box<dyn std::error::Error>> {
     use crate::cli::term;
+    let CCompileOptions { step_mode, strict, debug_info, .. } = *options;
     let extras = if strict { "STRICT" } else { "" };
     println!("{}", term::compiler_header("C", "9.0", extras));
     println!("   {} {}", term::dim("Source:"), input_file);
@@ -167,7 +362,16 @@ pub fn compile_c_file(
     let source = fs::read_to_string(input_file)
         .map_err(|e| format!("Cannot read '{}': {}", input_file, e))?;
 
-    let pipeline = compile_c_pipeline(&source, strict).map_err(|e| format!("C pipeline error: {}", e))?;
+    let pipeline = if step_mode {
+        compile_c_pipeline_in(&source, source_dir(input_file), strict)
+    } else {
+        lower_c_source_in(&source, source_dir(input_file), strict)
+    };
+    let mut pipeline = pipeline.map_err(|e| format!("C pipeline error: {}", e))?;
+    if debug_info {
+        let names = pipeline.program.functions.iter().map(|f| f.name.clone()).collect();
+        stamp_source_files(&mut pipeline.program, names, input_file);
+    }
 
     if step_mode {
         print_step_mode(input_file, &source, &pipeline);
@@ -179,37 +383,177 @@ pub fn compile_c_file(
     if pipeline.ub_report.has_warnings() {
         println!();
         for w in &pipeline.ub_report.warnings {
-            let loc = match &w.function {
-                Some(f) => format!(" in {}()", f),
-                None => String::new(),
-            };
-            match w.severity {
-                "error" => eprintln!("   {} UB{}: {}", term::error_text("ERROR"), loc, w.message),
-                "warning" => println!("   {} UB{}: {}", term::warn("WARN"), loc, w.message),
-                _ => println!("   {} UB{}: {}", term::info("NOTE"), loc, w.message),
-            }
+            print_ub_warning(w.severity, w.function.as_deref(), &w.message);
         }
         println!();
     }
 
-    println!("   Phase 6: Compiling to native code...");
+    emit_pe(&pipeline.program, output_file, options)?;
+
+    if strict && pipeline.ub_report.has_errors() {
+        eprintln!("   STRICT MODE: compilation aborted — {} UB error(s) found", 
+            pipeline.ub_report.warnings.iter().filter(|w| w.severity == "error").count());
+        return Err("Strict mode: UB detected, refusing to emit binary".into());
+    }
+
+    if pipeline.ub_report.has_errors() {
+        eprintln!("   UB errors detected — binary may exhibit undefined behavior");
+    }
+
+    Ok(())
+}
+
+/// Directory `#include "..."` resolves against for `input_file`
+fn source_dir(input_file: &str) -> &Path {
+    match Path::new(input_file).parent() {
+        Some(dir) if !dir.as_os_str().is_empty() => dir,
+        _ => Path::new("."),
+    }
+}
+
+fn print_ub_warning(severity: &str, function: Option<&str>, message: &str) {
+    let loc = match function {
+        Some(f) => format!(" in {}()", f),
+        None => String::new(),
+    };
+    match severity {
+        "error" => eprintln!("   {} UB{}: {}", term::error_text("ERROR"), loc, message),
+        "warning" => println!("   {} UB{}: {}", term::warn("WARN"), loc, message),
+        _ => println!("   {} UB{}: {}", term::info("NOTE"), loc, message),
+    }
+}
+
+/// -g: records `source` (absolute when it resolves) as the file of each
+/// function in `functions`; the first TU that defines a name wins, as in
+/// `link_c_objects`
+fn stamp_source_files(program: &mut Program, functions: Vec<String>, source: &str) {
+    let path = fs::canonicalize(source)
+        .map(|p| p.to_string_lossy().into_owned())
+        .unwrap_or_else(|_| source.to_string());
+    for name in functions {
+        program.attributes.source_files.entry(name).or_insert_with(|| path.clone());
+    }
+}
+
+/// Inlines small leaf functions into their callers (`InlineExpander`'s
+/// call graph and cost model) and drops the ones left without calls.
+/// Runs without the profile so `-fprofile-generate` and `-fprofile-use`
+/// builds keep the same set of functions.
+fn inline_calls(program: &Program) -> Program {
+    let mut copy = program.clone();
+    let stats = InlineExpander::new().run_typed(&mut copy, &HashSet::new());
+    if stats.inlined_calls > 0 {
+        println!(
+            "   {} {} calls inlined, {} functions removed",
+            term::dim("Inline:"),
+            stats.inlined_calls,
+            stats.removed_functions.len()
+        );
+    }
+    copy
+}
+
+/// Phases 6-7: IR → x86-64 → PE, plus post-build validation
+fn emit_pe(
+    program: &Program,
+    output_file: &str,
+    options: &CCompileOptions,
+) -> Result<(), Box<dyn std::error::Error>> {
+    let CCompileOptions { step_mode, ref pgo, tune, lto, delay_load, debug_info, builtin_malloc, .. } = *options;
     let mut compiler = CIsaCompiler::new(Target::Windows);
-    let (code, data, iat_offsets, string_offsets) = compiler.compile(&pipeline.program);
+    compiler.set_debug_info(debug_info);
+    compiler.set_builtin_heap(builtin_malloc);
+    if let Some(tune) = tune {
+        println!("   {} {}", term::dim("Tune:"), tune.name());
+        compiler.set_tune(tune);
+    }
+    let t = time_report::phase("inline");
+    let inlined = inline_calls(program);
+    drop(t);
+    let program = &inlined;
+    // LTO antes que PGO: el build instrumentado y el de profile-use
+    // tienen que ver las mismas funciones
+    let linked;
+    let program = if lto {
+        let t = time_report::phase("lto");
+        let mut copy = program.clone();
+        let stats = lto::optimize(&mut copy, &LtoOptions::default());
+        drop(t);
+        println!(
+            "   {} {} globals propagated, {} calls inlined, {} functions and {} globals stripped",
+            term::dim("LTO:"),
+            stats.globals_propagated,
+            stats.calls_inlined,
+            stats.functions_stripped,
+            stats.globals_stripped
+        );
+        linked = copy;
+        &linked
+    } else {
+        program
+    };
+    let instrumented;
+    let program = match pgo {
+        PgoMode::Off => program,
+        PgoMode::Generate(path) => {
+            let mut copy = program.clone();
+            profile::instrument(&mut copy, path);
+            println!("   {} instrumented, counts go to {}", term::dim("PGO:"), path);
+            instrumented = copy;
+            &instrumented
+        }
+        PgoMode::Use(path) => {
+            let counts = Profile::load(path)?;
+            println!("   {} {} ({} functions)", term::dim("PGO:"), path, counts.functions.len());
+            compiler.set_profile(counts);
+            program
+        }
+    };
+
+    println!("   Phase 6: Compiling to native code...");
+    let t = time_report::phase("codegen");
+    let (code, data, iat_offsets, string_offsets) = compiler.compile(program);
+    drop(t);
+
+    if let Some(debug) = compiler.debug_info() {
+        println!(
+            "   {} {} functions, {} line rows",
+            term::dim("Debug info:"),
+            debug.functions.len(),
+            debug.lines.len()
+        );
+    }
 
     if step_mode {
-        print_backend_step(&code, &data, &iat_offsets, &string_offsets);
+        print_backend_step(&compiler, &code, &data, &iat_offsets, &string_offsets);
+        for report in compiler.loop_reports() {
+            println!("   [vec] {}", report);
+        }
+        let clones = compiler.cloned_functions();
+        if !clones.is_empty() {
+            println!("   [clones] CPUID-dispatched: {}", clones.join(", "));
+        }
     }
 
     println!("   Phase 7: Generating PE binary...");
     let used_slots = compiler.used_iat_slots().clone();
-    adeb_backend_x64::pe::generate_pe_filtered(
+    let t = time_report::phase("pe-write");
+    let imports = ImportOptions::from_env(&used_slots, delay_load);
+    let delayed = iat_registry::delay_load_slots(&used_slots, &imports).len();
+    if delayed > 0 {
+        println!("   {} {} imports resolved on first call", term::dim("Delay-load:"), delayed);
+    }
+    adeb_backend_x64::pe::generate_pe_with_imports(
         &code,
         &data,
         output_file,
         &iat_offsets,
         &string_offsets,
         &used_slots,
+        &imports,
+        compiler.debug_info(),
     )?;
+    drop(t);
 
     let meta = fs::metadata(output_file)
         .map_err(|e| format!("Post-build: cannot stat output '{}': {}", output_file, e))?;
@@ -227,201 +571,654 @@ pub fn compile_c_file(
     }
 
     println!("   Build complete: {} ({} bytes)", output_file, meta.len());
-    println!("   Post-build validation OK");
-
-    if strict && pipeline.ub_report.has_errors() {
-        eprintln!("   STRICT MODE: compilation aborted — {} UB error(s) found", 
-            pipeline.ub_report.warnings.iter().filter(|w| w.severity == "error").count());
-        return Err("Strict mode: UB detected, refusing to emit binary".into());
+    if step_mode {
+        print_phase_cost(&time_report::snapshot(), &["pe-write"]);
     }
+    println!("   Post-build validation OK");
+    Ok(())
+}
 
-    if pipeline.ub_report.has_errors() {
-        eprintln!("   UB errors detected — binary may exhibit undefined behavior");
-    }
+// ── Multi-file builds ───────────────────────────────────────
+
+/// Intermediate object for one translation unit: the lowered Program plus
+/// the UB diagnostics it produced, so cache hits replay the same warnings.
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct CObject {
+    pub source: String,
+    pub key: u64,
+    /// User headers of the TU and the hash of their contents: `key` only
+    /// covers the .c file
+    pub headers: Vec<String>,
+    pub headers_hash: u64,
+    pub diagnostics: Vec<CObjectDiagnostic>,
+    pub program: Program,
+}
 
-    Ok(())
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct CObjectDiagnostic {
+    pub severity: String,
+    pub function: Option<String>,
+    pub message: String,
 }
 
-// ── Strict Mode: Bit-Width & Type Safety ─────────────────────
+impl CObject {
+    pub fn has_ub_errors(&self) -> bool {
+        self.diagnostics.iter().any(|d| d.severity == "error")
+    }
+}
 
-fn detect_strict_violations(unit: &CTranslationUnit, report: &mut UBReport) {
-    use adeb_frontend_c::ast::{CExpr, CBinOp, CAssignOp, CStmt};
+/// Compile one TU to a CObject, reusing the on-disk object when the
+/// content hash (and compiler build/flags) are unchanged. The salt
+/// carries `build_id()`, so bump `cache::FORMAT_VERSION` whenever the
+/// serialized shape of CObject or Program changes.
+/// Returns the object and whether it came from the cache.
+pub fn compile_c_object(
+    input_file: &str,
+    strict: bool,
+    cache: &ObjectCache,
+) -> Result<(CObject, bool), String> {
+    let salt = format!("adB-c-{}-strict={}", build_id(), strict);
+    let key = object_key(input_file, &salt)
+        .map_err(|e| format!("Cannot read '{}': {}", input_file, e))?;
 
-    for decl in &unit.declarations {
-        if let CTopLevel::FunctionDef { name, body, .. } = decl {
-            for stmt in body {
-                check_stmt_strict(report, name, stmt);
+    if let Some(bytes) = cache.load(key) {
+        if let Ok(object) = serde_json::from_slice::<CObject>(&bytes) {
+            let headers: Vec<&str> = object.headers.iter().map(String::as_str).collect();
+            if object.key == key && hash_closure(&headers, &salt).ok() == Some(object.headers_hash) {
+                return Ok((object, true));
             }
         }
     }
+
+    let source = fs::read_to_string(input_file)
+        .map_err(|e| format!("Cannot read '{}': {}", input_file, e))?;
+    let pipeline = lower_c_source_in(&source, source_dir(input_file), strict)
+        .map_err(|e| format!("{}: C pipeline error: {}", input_file, e))?;
+    drop(source);
+    let headers: Vec<&str> = pipeline.user_headers.iter().map(String::as_str).collect();
+    let headers_hash = hash_closure(&headers, &salt)
+        .map_err(|e| format!("{}: cannot hash headers: {}", input_file, e))?;
+    let object = CObject {
+        source: input_file.to_string(),
+        key,
+        headers: pipeline.user_headers.clone(),
+        headers_hash,
+        diagnostics: pipeline
+            .ub_report
+            .warnings
+            .iter()
+            .map(|w| CObjectDiagnostic {
+                severity: w.severity.to_string(),
+                function: w.function.clone(),
+                message: w.message.clone(),
+            })
+            .collect(),
+        program: pipeline.program,
+    };
+
+    // A failed cache write only costs a recompile next time
+    if let Ok(bytes) = serde_json::to_vec(&object) {
+        let _ = cache.store(key, &bytes);
+    }
+    Ok((object, false))
 }
 
-fn check_stmt_strict(report: &mut UBReport, func: &str, stmt: &adeb_frontend_c::ast::CStmt) {
-    use adeb_frontend_c::ast::{CStmt, CExpr, CType};
+/// Link the per-TU Programs into one. `static` functions and globals are
+/// renamed per TU first, so equal names in two TUs stay apart. Two TUs
+/// giving the same external definition is an error; anything else that
+/// repeats (built-in header inlines, C++ inline functions) keeps the
+/// first definition, and a global defined with an initializer replaces
+/// an earlier tentative (`int x;`) definition.
+pub fn link_c_objects(objects: &[CObject]) -> Result<Program, String> {
+    link_programs(objects.iter().map(|o| (o.source.as_str(), &o.program)))
+}
 
-    match stmt {
-        CStmt::VarDecl { type_spec, declarators, .. } => {
-            for d in declarators {
-                // Check: assigning a large literal to a small type
-                if let Some(adeb_frontend_c::ast::CInitializer::Expr(expr)) = &d.initializer {
-                    check_bit_width_init(report, func, type_spec, &d.derived_type, expr);
-                    check_expr_strict(report, func, expr);
-                }
+/// `link_c_objects` over bare Programs, each with the name of its TU;
+/// the C++ driver links with it too
+pub fn link_programs<'a>(units: impl IntoIterator<Item = (&'a str, &'a Program)>) -> Result<Program, String> {
+    let mut linked = Program::new();
+    let mut functions: HashSet<String> = HashSet::new();
+    let mut structs: HashSet<String> = HashSet::new();
+    let mut globals: HashMap<String, usize> = HashMap::new();
+    let mut defined_in: HashMap<String, &str> = HashMap::new();
+
+    for (tu, (source, program)) in units.into_iter().enumerate() {
+        let renamed;
+        let program = if program.attributes.internal_symbols.is_empty() {
+            program
+        } else {
+            let renames: HashMap<String, String> = program
+                .attributes
+                .internal_symbols
+                .iter()
+                .map(|name| (name.clone(), format!("__tu{}_{}", tu, name)))
+                .collect();
+            let mut copy = program.clone();
+            lto::rename_symbols(&mut copy, &renames);
+            renamed = copy;
+            &renamed
+        };
+        for name in &program.attributes.external_definitions {
+            if let Some(first) = defined_in.insert(name.clone(), source) {
+                return Err(format!("multiple definition of '{}' in {} and {}", name, first, source));
             }
         }
-        CStmt::Expr(expr) | CStmt::Return(Some(expr)) => {
-            check_expr_strict(report, func, expr);
+
+        if linked.functions.is_empty() && linked.statements.is_empty() {
+            linked.attributes = program.attributes.clone();
         }
-        CStmt::If { condition, then_body, else_body } => {
-            check_expr_strict(report, func, condition);
-            check_stmt_strict(report, func, then_body);
-            if let Some(eb) = else_body { check_stmt_strict(report, func, eb); }
+        for (name, &align) in &program.attributes.global_align {
+            let entry = linked.attributes.global_align.entry(name.clone()).or_insert(align);
+            *entry = (*entry).max(align);
         }
-        CStmt::While { condition, body } | CStmt::DoWhile { body, condition } => {
-            check_expr_strict(report, func, condition);
-            check_stmt_strict(report, func, body);
+        for (name, file) in &program.attributes.source_files {
+            linked.attributes.source_files.entry(name.clone()).or_insert_with(|| file.clone());
         }
-        CStmt::For { init, condition, update, body } => {
-            if let Some(i) = init { check_stmt_strict(report, func, i); }
-            if let Some(c) = condition { check_expr_strict(report, func, c); }
-            if let Some(u) = update { check_expr_strict(report, func, u); }
-            check_stmt_strict(report, func, body);
+        let attrs = &program.attributes;
+        linked.attributes.internal_symbols.extend(attrs.internal_symbols.iter().cloned());
+        linked.attributes.external_definitions.extend(attrs.external_definitions.iter().cloned());
+        for st in &program.structs {
+            if structs.insert(st.name.clone()) {
+                linked.structs.push(st.clone());
+            }
         }
-        CStmt::Switch { expr, cases } => {
-            check_expr_strict(report, func, expr);
-            for case in cases {
-                for s in &case.body { check_stmt_strict(report, func, s); }
+        for func in &program.functions {
+            if functions.insert(func.name.clone()) {
+                linked.functions.push(func.clone());
             }
         }
-        CStmt::Block(stmts) => {
-            for s in stmts { check_stmt_strict(report, func, s); }
+        for stmt in &program.statements {
+            if let Stmt::VarDecl { name, value, .. } = stmt {
+                if let Some(&idx) = globals.get(name) {
+                    let tentative = matches!(&linked.statements[idx], Stmt::VarDecl { value: None, .. });
+                    if tentative && value.is_some() {
+                        linked.statements[idx] = stmt.clone();
+                    }
+                    continue;
+                }
+                globals.insert(name.clone(), linked.statements.len());
+            }
+            linked.statements.push(stmt.clone());
         }
-        _ => {}
     }
+    Ok(linked)
 }
 
-fn check_expr_strict(report: &mut UBReport, func: &str, expr: &adeb_frontend_c::ast::CExpr) {
-    use adeb_frontend_c::ast::{CExpr, CBinOp};
+/// Compile several .c files into one PE. Each TU becomes a cached object;
+/// only TUs whose content changed are recompiled before the final link.
+pub fn compile_c_files(
+    input_files: &[String],
+    output_file: &str,
+    options: &CCompileOptions,
+) -> Result<(), Box<dyn std::error::Error>> {
+    if input_files.len() == 1 {
+        return compile_c_file(&input_files[0], output_file, options);
+    }
+    let strict = options.strict;
 
-    match expr {
-        // Signed integer overflow from literal arithmetic
-        CExpr::BinaryOp { op: CBinOp::Add, left, right, .. } => {
-            if let (CExpr::IntLiteral(a), CExpr::IntLiteral(b)) = (left.as_ref(), right.as_ref()) {
-                if a.checked_add(*b).is_none() {
-                    report.warnings.push(UBWarning {
-                        kind: UBKind::SignedIntegerOverflow,
-                        severity: "warning",
-                        message: format!("Signed overflow: {} + {} overflows i64 (C99 §6.5/5)", a, b),
-                        function: Some(func.to_string()),
-                    });
+    let extras = if strict { "STRICT" } else { "" };
+    println!("{}", term::compiler_header("C", "9.0", extras));
+    println!("   {} {}", term::dim("Sources:"), input_files.join(" "));
+    println!("   {} {}", term::dim("Target:"), output_file);
+
+    let cache = ObjectCache::from_env();
+    println!("   Phase 1: Compiling {} translation units...", input_files.len());
+    let results = adeb_core::parallel::par_map(
+        input_files,
+        adeb_core::parallel::default_jobs(),
+        |input| compile_c_object(input, strict, &cache),
+    );
+
+    let mut objects = Vec::with_capacity(results.len());
+    let mut any_ub_error = false;
+    for result in results {
+        let (object, cached) = result?;
+        let status = if cached { term::dim("(cached)") } else { term::ok("(compiled)") };
+        println!("     {} {}", object.source, status);
+        for d in &object.diagnostics {
+            print_ub_warning(&d.severity, d.function.as_deref(), &d.message);
+        }
+        any_ub_error |= object.has_ub_errors();
+        objects.push(object);
+    }
+    // Before the link, so the `static` functions it renames keep their file
+    if options.debug_info {
+        for object in &mut objects {
+            let names = object.program.functions.iter().map(|f| f.name.clone()).collect();
+            stamp_source_files(&mut object.program, names, &object.source);
+        }
+    }
+
+    println!("   Phase 5: Linking {} objects...", objects.len());
+    let t = time_report::phase("link");
+    let program = link_c_objects(&objects)?;
+    drop(t);
+    emit_pe(&program, output_file, options)?;
+
+    if strict && any_ub_error {
+        eprintln!("   STRICT MODE: compilation aborted — UB errors found");
+        return Err("Strict mode: UB detected, refusing to emit binary".into());
+    }
+    if any_ub_error {
+        eprintln!("   UB errors detected — binary may exhibit undefined behavior");
+    }
+    Ok(())
+}
+
+// ── Precompiled headers ─────────────────────────────────────
+
+/// `adB cc --pch common.h`: preprocess and parse a user header once and
+/// write its fastos.bib image next to it (`common.h.bib`). A TU that
+/// includes the header before any #define loads the image instead.
+pub fn precompile_c_header(header: &str) -> Result<(), Box<dyn std::error::Error>> {
+    println!("{}", term::compiler_header("C", "9.0", "PCH"));
+    println!("   {} {}", term::dim("Header:"), header);
+    let path = fs::canonicalize(header).map_err(|e| format!("Cannot read '{}': {}", header, e))?;
+    let text = fs::read_to_string(&path).map_err(|e| format!("Cannot read '{}': {}", header, e))?;
+
+    // Nested user headers are pasted: the image must hold all their text
+    let t = time_report::phase("preprocess");
+    let mut preprocessor = CPreprocessor::new();
+    preprocessor.set_inject_headers(false);
+    preprocessor.set_use_precompiled(false);
+    preprocessor.set_source_dir(path.parent().unwrap_or(Path::new(".")));
+    let preprocessed = preprocessor.process(&text);
+    drop(t);
+    let t = time_report::phase("headers");
+    let headers = header_cache::load_headers(preprocessor.include_order())?;
+    drop(t);
+
+    let t = time_report::phase("parse");
+    let (tokens, token_lines) = CLexer::new(&preprocessed).tokenize();
+    let mut parser = CParser::new(tokens, token_lines);
+    parser.seed_typedef_names(headers.typedef_names.iter().cloned());
+    let unit = parser.parse_translation_unit().map_err(|e| format!("{}: {}", header, e))?;
+    let builtin: HashSet<&String> = headers.typedef_names.iter().collect();
+    let mut typedef_names: Vec<String> =
+        parser.typedef_names().iter().filter(|n| !builtin.contains(n)).cloned().collect();
+    typedef_names.sort();
+    drop(t);
+
+    let t = time_report::phase("ub-detect");
+    let ub_report = UBReport { warnings: analyze_unit(&unit.declarations, 0..0, false, false).ub };
+    drop(t);
+    for w in &ub_report.warnings {
+        print_ub_warning(w.severity, w.function.as_deref(), &w.message);
+    }
+
+    let mut files = vec![path.to_string_lossy().into_owned()];
+    files.extend(preprocessor.user_headers().iter().map(|h| {
+        fs::canonicalize(h).map(|p| p.to_string_lossy().into_owned()).unwrap_or_else(|_| h.clone())
+    }));
+    let mut included: Vec<String> = preprocessor.included_headers().iter().cloned().collect();
+    included.sort();
+    let image = PrecompiledHeader {
+        declarations: unit.declarations,
+        typedef_names,
+        macros: preprocessor.macro_definitions(),
+        builtin_headers: preprocessor.include_order().to_vec(),
+        included,
+        files,
+        ub_reports: ub_report.warnings.iter().map(cached_ub_report).collect(),
+    };
+    let image_path = pch::image_path(&path);
+    let size = pch::write_image(&image, &image_path)?;
+    println!(
+        "   Precompiled: {} ({} declarations, {} macros, {} files, {} bytes)",
+        image_path.display(),
+        image.declarations.len(),
+        image.macros.len(),
+        image.files.len(),
+        size
+    );
+    Ok(())
+}
+
+// ── AST Checks: one traversal per function ──────────────────
+//
+// UB detection, format-string checks and strict-mode bit-width checks are
+// all `AstCheck`s. `AstWalker` visits every statement and expression of a
+// function once and hands each node to every check registered for it;
+// functions are independent, so `analyze_unit` fans them out over threads
+// and concatenates the findings back in declaration order.
+
+/// Report a check's findings belong to
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum CheckLane {
+    /// Undefined behavior — always reported
+    Ub,
+    /// Strict mode only — reported after the UB findings
+    Strict,
+}
+
+/// Findings of one function for one lane
+struct Findings<'a> {
+    func: &'a str,
+    warnings: Vec<UBWarning>,
+}
+
+impl<'a> Findings<'a> {
+    fn new(func: &'a str) -> Self {
+        Self { func, warnings: Vec::new() }
+    }
+
+    fn push(&mut self, kind: UBKind, severity: &'static str, message: String) {
+        self.warnings.push(UBWarning { kind, severity, message, function: Some(self.func.to_string()) });
+    }
+}
+
+/// One analysis over C function bodies. Hooks run pre-order, before the
+/// node's children are visited; checks hold no per-function state.
+trait AstCheck: Sync {
+    fn lane(&self) -> CheckLane;
+    fn stmt(&self, _out: &mut Findings, _stmt: &CStmt) {}
+    fn expr(&self, _out: &mut Findings, _expr: &CExpr) {}
+}
+
+/// Shared traversal: visits every node once, dispatching to `checks`
+struct AstWalker<'a> {
+    checks: &'a [&'a dyn AstCheck],
+    ub: Findings<'a>,
+    strict: Findings<'a>,
+}
+
+impl<'a> AstWalker<'a> {
+    fn new(func: &'a str, checks: &'a [&'a dyn AstCheck]) -> Self {
+        Self { checks, ub: Findings::new(func), strict: Findings::new(func) }
+    }
+
+    fn lane(&mut self, lane: CheckLane) -> &mut Findings<'a> {
+        match lane {
+            CheckLane::Ub => &mut self.ub,
+            CheckLane::Strict => &mut self.strict,
+        }
+    }
+
+    fn visit_stmts(&mut self, stmts: &[CStmt]) {
+        for stmt in stmts {
+            self.visit_stmt(stmt);
+        }
+    }
+
+    fn visit_stmt(&mut self, stmt: &CStmt) {
+        let checks = self.checks;
+        for check in checks {
+            check.stmt(self.lane(check.lane()), stmt);
+        }
+
+        match stmt {
+            CStmt::Expr(expr) | CStmt::Return(Some(expr)) => self.visit_expr(expr),
+            CStmt::VarDecl { declarators, .. } => {
+                for d in declarators {
+                    if let Some(init) = &d.initializer {
+                        self.visit_initializer(init);
+                    }
                 }
             }
-            check_expr_strict(report, func, left);
-            check_expr_strict(report, func, right);
-        }
-        CExpr::BinaryOp { op: CBinOp::Mul, left, right, .. } => {
-            if let (CExpr::IntLiteral(a), CExpr::IntLiteral(b)) = (left.as_ref(), right.as_ref()) {
-                if a.checked_mul(*b).is_none() {
-                    report.warnings.push(UBWarning {
-                        kind: UBKind::SignedIntegerOverflow,
-                        severity: "warning",
-                        message: format!("Signed overflow: {} * {} overflows i64 (C99 §6.5/5)", a, b),
-                        function: Some(func.to_string()),
-                    });
+            CStmt::Block(stmts) => self.visit_stmts(stmts),
+            CStmt::If { condition, then_body, else_body } => {
+                self.visit_expr(condition);
+                self.visit_stmt(then_body);
+                if let Some(eb) = else_body {
+                    self.visit_stmt(eb);
                 }
             }
-            check_expr_strict(report, func, left);
-            check_expr_strict(report, func, right);
-        }
-        // Shift into sign bit
-        CExpr::BinaryOp { op: CBinOp::Shl, left, right, .. } => {
-            if let (CExpr::IntLiteral(val), CExpr::IntLiteral(shift)) = (left.as_ref(), right.as_ref()) {
-                if *shift >= 0 && *shift < 64 {
-                    if val.checked_shl(*shift as u32).is_none() || (*val > 0 && (*val << *shift) < 0) {
-                        report.warnings.push(UBWarning {
-                            kind: UBKind::ShiftOverflow,
-                            severity: "warning",
-                            message: format!("Shift {} << {} overflows or shifts into sign bit (C99 §6.5.7/4)", val, shift),
-                            function: Some(func.to_string()),
-                        });
-                    }
+            CStmt::While { condition, body } | CStmt::DoWhile { body, condition } => {
+                self.visit_expr(condition);
+                self.visit_stmt(body);
+            }
+            CStmt::For { init, condition, update, body } => {
+                if let Some(i) = init {
+                    self.visit_stmt(i);
+                }
+                if let Some(c) = condition {
+                    self.visit_expr(c);
+                }
+                if let Some(u) = update {
+                    self.visit_expr(u);
+                }
+                self.visit_stmt(body);
+            }
+            CStmt::Switch { expr, cases } => {
+                self.visit_expr(expr);
+                for case in cases {
+                    self.visit_stmts(&case.body);
                 }
             }
-            check_expr_strict(report, func, left);
-            check_expr_strict(report, func, right);
+            CStmt::Label(_, inner) => self.visit_stmt(inner),
+            _ => {}
         }
-        // Narrowing cast: (char)256, (short)70000, etc.
-        CExpr::Cast { target_type, expr: inner } => {
-            if let CExpr::IntLiteral(val) = inner.as_ref() {
-                let (lo, hi) = type_range(target_type);
-                if *val < lo || *val > hi {
-                    report.warnings.push(UBWarning {
-                        kind: UBKind::IntegerTruncation,
-                        severity: "warning",
-                        message: format!(
-                            "Implicit truncation: value {} does not fit in {} (range {}..{})",
-                            val, render_ctype(target_type), lo, hi
-                        ),
-                        function: Some(func.to_string()),
-                    });
+    }
+
+    fn visit_initializer(&mut self, init: &CInitializer) {
+        match init {
+            CInitializer::Expr(expr) => self.visit_expr(expr),
+            CInitializer::List(entries) => {
+                for entry in entries {
+                    self.visit_initializer(&entry.value);
                 }
             }
-            check_expr_strict(report, func, inner);
         }
-        // Recurse
-        CExpr::BinaryOp { left, right, .. } => {
-            check_expr_strict(report, func, left);
-            check_expr_strict(report, func, right);
+    }
+
+    fn visit_expr(&mut self, expr: &CExpr) {
+        let checks = self.checks;
+        for check in checks {
+            check.expr(self.lane(check.lane()), expr);
         }
-        CExpr::UnaryOp { expr: inner, .. } | CExpr::Deref(inner) | CExpr::AddressOf(inner) => {
-            check_expr_strict(report, func, inner);
+
+        match expr {
+            CExpr::BinaryOp { left, right, .. } => {
+                self.visit_expr(left);
+                self.visit_expr(right);
+            }
+            CExpr::UnaryOp { expr: inner, .. }
+            | CExpr::Cast { expr: inner, .. }
+            | CExpr::SizeofExpr(inner)
+            | CExpr::AddressOf(inner)
+            | CExpr::Deref(inner)
+            | CExpr::Member { object: inner, .. }
+            | CExpr::ArrowMember { pointer: inner, .. } => self.visit_expr(inner),
+            CExpr::Call { args, .. } => {
+                for a in args {
+                    self.visit_expr(a);
+                }
+            }
+            CExpr::Index { array, index } => {
+                self.visit_expr(array);
+                self.visit_expr(index);
+            }
+            CExpr::Ternary { condition, then_expr, else_expr } => {
+                self.visit_expr(condition);
+                self.visit_expr(then_expr);
+                self.visit_expr(else_expr);
+            }
+            CExpr::Assign { target, value, .. } => {
+                self.visit_expr(target);
+                self.visit_expr(value);
+            }
+            CExpr::Comma(exprs) | CExpr::InitList(exprs) => {
+                for e in exprs {
+                    self.visit_expr(e);
+                }
+            }
+            _ => {}
         }
-        CExpr::Assign { target, value, .. } => {
-            check_expr_strict(report, func, target);
-            check_expr_strict(report, func, value);
+    }
+}
+
+/// Division by zero, shift range, NULL dereference, negative index and
+/// `while(1)` without an exit.
+struct UbCheck;
+
+impl AstCheck for UbCheck {
+    fn lane(&self) -> CheckLane {
+        CheckLane::Ub
+    }
+
+    fn stmt(&self, out: &mut Findings, stmt: &CStmt) {
+        // Detect infinite loops: while(1) with no break
+        if let CStmt::While { condition, body } = stmt {
+            if is_always_true(condition) && !stmt_has_break_or_return(body) {
+                out.push(
+                    UBKind::InfiniteLoop,
+                    "warning",
+                    "Potential infinite loop: condition is always true with no break/return".to_string(),
+                );
+            }
         }
-        CExpr::Call { args, .. } => {
-            for a in args { check_expr_strict(report, func, a); }
+    }
+
+    fn expr(&self, out: &mut Findings, expr: &CExpr) {
+        match expr {
+            // Division by zero: x / 0, x % 0
+            CExpr::BinaryOp { op: CBinOp::Div | CBinOp::Mod, right, .. } if is_zero_expr(right) => {
+                out.push(
+                    UBKind::DivisionByZero,
+                    "error",
+                    "Division by zero is undefined behavior (C99 §6.5.5)".to_string(),
+                );
+            }
+            // Shift overflow: x << 64 (or negative shift)
+            CExpr::BinaryOp { op: CBinOp::Shl | CBinOp::Shr, right, .. } => {
+                if let CExpr::IntLiteral(n) = right.as_ref() {
+                    if *n < 0 || *n >= 64 {
+                        out.push(
+                            UBKind::ShiftOverflow,
+                            "warning",
+                            format!("Shift amount {} is out of range (C99 §6.5.7)", n),
+                        );
+                    }
+                }
+            }
+            // Null pointer dereference: *((void*)0) or *NULL
+            CExpr::Deref(inner) if is_null_expr(inner) => {
+                out.push(
+                    UBKind::NullPointerDereference,
+                    "error",
+                    "Dereference of NULL pointer is undefined behavior (C99 §6.5.3.2)".to_string(),
+                );
+            }
+            // Array index with negative index
+            CExpr::Index { index, .. } => {
+                if let CExpr::IntLiteral(n) = index.as_ref() {
+                    if *n < 0 {
+                        out.push(
+                            UBKind::ArrayOutOfBounds,
+                            "warning",
+                            format!("Negative array index {} is undefined behavior", n),
+                        );
+                    }
+                }
+            }
+            _ => {}
         }
-        CExpr::Ternary { condition, then_expr, else_expr } => {
-            check_expr_strict(report, func, condition);
-            check_expr_strict(report, func, then_expr);
-            check_expr_strict(report, func, else_expr);
+    }
+}
+
+/// Argument count of printf/scanf-family calls against their literal format
+struct FormatStringCheck;
+
+impl AstCheck for FormatStringCheck {
+    fn lane(&self) -> CheckLane {
+        CheckLane::Ub
+    }
+
+    fn expr(&self, out: &mut Findings, expr: &CExpr) {
+        if let CExpr::Call { func, args } = expr {
+            if let CExpr::Identifier(name) = func.as_ref() {
+                check_format_string_ub(out, name, args);
+            }
         }
-        CExpr::Comma(exprs) => {
-            for e in exprs { check_expr_strict(report, func, e); }
+    }
+}
+
+/// Strict mode: literal overflow, sign-bit shifts and narrowing
+struct StrictCheck;
+
+impl AstCheck for StrictCheck {
+    fn lane(&self) -> CheckLane {
+        CheckLane::Strict
+    }
+
+    fn stmt(&self, out: &mut Findings, stmt: &CStmt) {
+        // Check: assigning a large literal to a small type
+        if let CStmt::VarDecl { type_spec, declarators, .. } = stmt {
+            for d in declarators {
+                if let Some(CInitializer::Expr(expr)) = &d.initializer {
+                    check_bit_width_init(out, type_spec, expr);
+                }
+            }
         }
-        CExpr::Index { array, index } => {
-            check_expr_strict(report, func, array);
-            check_expr_strict(report, func, index);
+    }
+
+    fn expr(&self, out: &mut Findings, expr: &CExpr) {
+        match expr {
+            // Signed integer overflow from literal arithmetic
+            CExpr::BinaryOp { op: op @ (CBinOp::Add | CBinOp::Mul), left, right } => {
+                if let (CExpr::IntLiteral(a), CExpr::IntLiteral(b)) = (left.as_ref(), right.as_ref()) {
+                    let (result, sign) = match op {
+                        CBinOp::Add => (a.checked_add(*b), '+'),
+                        _ => (a.checked_mul(*b), '*'),
+                    };
+                    if result.is_none() {
+                        out.push(
+                            UBKind::SignedIntegerOverflow,
+                            "warning",
+                            format!("Signed overflow: {} {} {} overflows i64 (C99 §6.5/5)", a, sign, b),
+                        );
+                    }
+                }
+            }
+            // Shift into sign bit
+            CExpr::BinaryOp { op: CBinOp::Shl, left, right } => {
+                if let (CExpr::IntLiteral(val), CExpr::IntLiteral(shift)) = (left.as_ref(), right.as_ref()) {
+                    if *shift >= 0 && *shift < 64 {
+                        if val.checked_shl(*shift as u32).is_none() || (*val > 0 && (*val << *shift) < 0) {
+                            out.push(
+                                UBKind::ShiftOverflow,
+                                "warning",
+                                format!("Shift {} << {} overflows or shifts into sign bit (C99 §6.5.7/4)", val, shift),
+                            );
+                        }
+                    }
+                }
+            }
+            // Narrowing cast: (char)256, (short)70000, etc.
+            CExpr::Cast { target_type, expr: inner } => {
+                if let CExpr::IntLiteral(val) = inner.as_ref() {
+                    let (lo, hi) = type_range(target_type);
+                    if *val < lo || *val > hi {
+                        out.push(
+                            UBKind::IntegerTruncation,
+                            "warning",
+                            format!(
+                                "Implicit truncation: value {} does not fit in {} (range {}..{})",
+                                val, render_ctype(target_type), lo, hi
+                            ),
+                        );
+                    }
+                }
+            }
+            _ => {}
         }
-        _ => {}
     }
 }
 
 /// Check if a literal value fits the declared type's bit-width
-fn check_bit_width_init(
-    report: &mut UBReport,
-    func: &str,
-    base_type: &CType,
-    _derived: &Option<CDerivedType>,
-    expr: &adeb_frontend_c::ast::CExpr,
-) {
-    use adeb_frontend_c::ast::CExpr;
-
+fn check_bit_width_init(out: &mut Findings, base_type: &CType, expr: &CExpr) {
     if let CExpr::IntLiteral(val) = expr {
         let (lo, hi) = type_range(base_type);
         if lo != 0 || hi != 0 { // only check if we know the range
             if *val < lo || *val > hi {
-                report.warnings.push(UBWarning {
-                    kind: UBKind::IntegerTruncation,
-                    severity: "warning",
-                    message: format!(
+                out.push(
+                    UBKind::IntegerTruncation,
+                    "warning",
+                    format!(
                         "Value {} does not fit in {} (valid range: {}..{}). Bits will be truncated.",
                         val, render_ctype(base_type), lo, hi
                     ),
-                    function: Some(func.to_string()),
-                });
+                );
             }
         }
     }
@@ -448,206 +1245,130 @@ fn type_range(ty: &CType) -> (i64, i64) {
     }
 }
 
-// ── UB Detector Implementation ──────────────────────────────
-
-fn detect_ub_in_ast(unit: &CTranslationUnit) -> UBReport {
-    let mut report = UBReport::default();
+/// Units with fewer function bodies are checked on the calling thread:
+/// spawning costs more than the walk.
+const PARALLEL_CHECK_MIN_FUNCTIONS: usize = 64;
+
+/// Everything the analysis pass learns about a translation unit
+struct UnitAnalysis {
+    semantic: Option<SemanticSnapshot>,
+    /// UB findings, function by function in source order
+    ub: Vec<UBWarning>,
+    /// Strict-mode findings (empty unless requested), same order
+    strict: Vec<UBWarning>,
+}
 
-    for decl in &unit.declarations {
-        if let CTopLevel::FunctionDef {
-            name, body, ..
-        } = decl
-        {
-            check_stmts_for_ub(&mut report, name, body);
+/// One pass over `decls`: the symbol snapshot (if `semantic`) on the way,
+/// then every function body walked once with all active checks.
+/// Functions whose index is in `skip_ub` (precompiled, already analyzed)
+/// only get the strict checks.
+fn analyze_unit(decls: &[CTopLevel], skip_ub: Range<usize>, strict: bool, semantic: bool) -> UnitAnalysis {
+    const UB_CHECKS: &[&dyn AstCheck] = &[&UbCheck, &FormatStringCheck];
+    const UB_STRICT_CHECKS: &[&dyn AstCheck] = &[&UbCheck, &FormatStringCheck, &StrictCheck];
+    const STRICT_CHECKS: &[&dyn AstCheck] = &[&StrictCheck];
+
+    let mut snapshot = semantic.then(SnapshotBuilder::default);
+    let mut functions = Vec::new();
+    for (i, decl) in decls.iter().enumerate() {
+        if let Some(s) = &mut snapshot {
+            s.add(decl);
         }
+        let CTopLevel::FunctionDef { name, body, .. } = decl else { continue };
+        let checks = match (!skip_ub.contains(&i), strict) {
+            (true, false) => UB_CHECKS,
+            (true, true) => UB_STRICT_CHECKS,
+            (false, true) => STRICT_CHECKS,
+            (false, false) => continue,
+        };
+        functions.push((name.as_str(), body.as_slice(), checks));
     }
 
-    report
+    let jobs = if functions.len() < PARALLEL_CHECK_MIN_FUNCTIONS {
+        1
+    } else {
+        adeb_core::parallel::default_jobs()
+    };
+    let results = adeb_core::parallel::par_map(&functions, jobs, |&(name, body, checks)| {
+        let mut walker = AstWalker::new(name, checks);
+        walker.visit_stmts(body);
+        (walker.ub.warnings, walker.strict.warnings)
+    });
+
+    let mut analysis = UnitAnalysis {
+        semantic: snapshot.map(SnapshotBuilder::finish),
+        ub: Vec::new(),
+        strict: Vec::new(),
+    };
+    for (ub, strict) in results {
+        analysis.ub.extend(ub);
+        analysis.strict.extend(strict);
+    }
+    analysis
 }
 
-fn check_stmt_for_ub(report: &mut UBReport, func_name: &str, stmt: &adeb_frontend_c::ast::CStmt) {
-    use adeb_frontend_c::ast::CStmt;
-
-    match stmt {
-        CStmt::Expr(expr) => {
-            check_expr_for_ub(report, func_name, expr);
-        }
-        CStmt::Return(Some(expr)) => {
-            check_expr_for_ub(report, func_name, expr);
-        }
-        CStmt::Return(None) => {}
-        CStmt::VarDecl { declarators, .. } => {
-            for decl in declarators {
-                if let Some(adeb_frontend_c::ast::CInitializer::Expr(expr)) = &decl.initializer {
-                    check_expr_for_ub(report, func_name, expr);
+/// Strict type findings of `program` as UB warnings, reusing `cache`
+fn strict_type_warnings(program: &Program, cache: &StrictCheckCache) -> Vec<UBWarning> {
+    let report = StrictTypeChecker::new().with_cache(cache).check_program(program);
+    report
+        .diagnostics
+        .into_iter()
+        .map(|d| {
+            let (kind, mut message) = match d.result {
+                TypeCompatResult::IntegerOverflow { typ, operation, suggestion } => (
+                    UBKind::SignedIntegerOverflow,
+                    format!("Integer overflow in {} on {}. {}", operation, typ, suggestion),
+                ),
+                TypeCompatResult::NarrowingConversion { from, to, suggestion } => {
+                    (UBKind::InvalidCast, format!("Narrowing conversion {} -> {}. {}", from, to, suggestion))
                 }
+                TypeCompatResult::ImplicitCast { from, to, suggestion } => {
+                    (UBKind::InvalidCast, format!("Implicit cast {} -> {}. {}", from, to, suggestion))
+                }
+                TypeCompatResult::SignedUnsignedMix { signed, unsigned, .. } => {
+                    (UBKind::InvalidCast, format!("Signed/unsigned mix: {} with {}", signed, unsigned))
+                }
+                TypeCompatResult::Mismatch { left, right, op, .. } => {
+                    (UBKind::InvalidCast, format!("Type mismatch: {} {} {}", left, op, right))
+                }
+                TypeCompatResult::Ok(_) => unreachable!("only errors are reported"),
+            };
+            if d.line > 0 {
+                message.push_str(&format!(" (line {})", d.line));
             }
-        }
-        CStmt::If { condition, then_body, else_body } => {
-            check_expr_for_ub(report, func_name, condition);
-            check_stmt_for_ub(report, func_name, then_body);
-            if let Some(else_stmt) = else_body {
-                check_stmt_for_ub(report, func_name, else_stmt);
-            }
-        }
-        CStmt::While { condition, body } => {
-            check_expr_for_ub(report, func_name, condition);
-            // Detect infinite loops: while(1) with no break
-            if is_always_true(condition) && !stmt_has_break_or_return(body) {
-                report.warnings.push(UBWarning {
-                    kind: UBKind::InfiniteLoop,
-                    severity: "warning",
-                    message: "Potential infinite loop: condition is always true with no break/return".to_string(),
-                    function: Some(func_name.to_string()),
-                });
-            }
-            check_stmt_for_ub(report, func_name, body);
-        }
-        CStmt::DoWhile { body, condition } => {
-            check_expr_for_ub(report, func_name, condition);
-            check_stmt_for_ub(report, func_name, body);
-        }
-        CStmt::For { init, condition, update, body } => {
-            if let Some(init_stmt) = init {
-                check_stmt_for_ub(report, func_name, init_stmt);
-            }
-            if let Some(cond) = condition {
-                check_expr_for_ub(report, func_name, cond);
-            }
-            if let Some(upd) = update {
-                check_expr_for_ub(report, func_name, upd);
-            }
-            check_stmt_for_ub(report, func_name, body);
-        }
-        CStmt::Switch { expr, cases } => {
-            check_expr_for_ub(report, func_name, expr);
-            for case in cases {
-                check_stmts_for_ub(report, func_name, &case.body);
-            }
-        }
-        CStmt::Block(stmts) => {
-            check_stmts_for_ub(report, func_name, stmts);
-        }
-        _ => {}
-    }
+            UBWarning { kind, severity: "warning", message, function: Some(d.function) }
+        })
+        .collect()
 }
 
-fn check_stmts_for_ub(report: &mut UBReport, func_name: &str, stmts: &[adeb_frontend_c::ast::CStmt]) {
-    for stmt in stmts {
-        check_stmt_for_ub(report, func_name, stmt);
+/// UB warning as a precompiled header stores it
+fn cached_ub_report(w: &UBWarning) -> CachedUBReport {
+    CachedUBReport {
+        kind: format!("{:?}", w.kind),
+        severity: w.severity.to_string(),
+        message: w.message.clone(),
+        location: w.function.clone().unwrap_or_default(),
     }
 }
 
-fn check_expr_for_ub(report: &mut UBReport, func_name: &str, expr: &adeb_frontend_c::ast::CExpr) {
-    use adeb_frontend_c::ast::{CBinOp, CExpr};
-
-    match expr {
-        // Division by zero: x / 0, x % 0
-        CExpr::BinaryOp { op: CBinOp::Div | CBinOp::Mod, right, .. } => {
-            if is_zero_expr(right) {
-                report.warnings.push(UBWarning {
-                    kind: UBKind::DivisionByZero,
-                    severity: "error",
-                    message: "Division by zero is undefined behavior (C99 §6.5.5)".to_string(),
-                    function: Some(func_name.to_string()),
-                });
-            }
-            // Still recurse into left
-            if let CExpr::BinaryOp { left, .. } = expr {
-                check_expr_for_ub(report, func_name, left);
-            }
-        }
-        // Shift overflow: x << 32 (or negative shift)
-        CExpr::BinaryOp { op: CBinOp::Shl | CBinOp::Shr, left, right } => {
-            if let CExpr::IntLiteral(n) = right.as_ref() {
-                if *n < 0 || *n >= 64 {
-                    report.warnings.push(UBWarning {
-                        kind: UBKind::ShiftOverflow,
-                        severity: "warning",
-                        message: format!("Shift amount {} is out of range (C99 §6.5.7)", n),
-                        function: Some(func_name.to_string()),
-                    });
-                }
-            }
-            check_expr_for_ub(report, func_name, left);
-            check_expr_for_ub(report, func_name, right);
-        }
-        // Null pointer dereference: *((void*)0) or *NULL
-        CExpr::Deref(inner) => {
-            if is_null_expr(inner) {
-                report.warnings.push(UBWarning {
-                    kind: UBKind::NullPointerDereference,
-                    severity: "error",
-                    message: "Dereference of NULL pointer is undefined behavior (C99 §6.5.3.2)".to_string(),
-                    function: Some(func_name.to_string()),
-                });
-            }
-            check_expr_for_ub(report, func_name, inner);
-        }
-        // Array index with negative index
-        CExpr::Index { array, index } => {
-            if let CExpr::IntLiteral(n) = index.as_ref() {
-                if *n < 0 {
-                    report.warnings.push(UBWarning {
-                        kind: UBKind::ArrayOutOfBounds,
-                        severity: "warning",
-                        message: format!("Negative array index {} is undefined behavior", n),
-                        function: Some(func_name.to_string()),
-                    });
-                }
-            }
-            check_expr_for_ub(report, func_name, array);
-            check_expr_for_ub(report, func_name, index);
-        }
-        // Format string checks for printf/scanf
-        CExpr::Call { func, args } => {
-            if let CExpr::Identifier(name) = func.as_ref() {
-                check_format_string_ub(report, func_name, name, args);
-            }
-            for arg in args {
-                check_expr_for_ub(report, func_name, arg);
-            }
-        }
-        // Recurse into other binary ops
-        CExpr::BinaryOp { left, right, .. } => {
-            check_expr_for_ub(report, func_name, left);
-            check_expr_for_ub(report, func_name, right);
-        }
-        CExpr::UnaryOp { expr: inner, .. } => {
-            check_expr_for_ub(report, func_name, inner);
-        }
-        CExpr::Cast { expr: inner, .. } => {
-            check_expr_for_ub(report, func_name, inner);
-        }
-        CExpr::Ternary { condition, then_expr, else_expr } => {
-            check_expr_for_ub(report, func_name, condition);
-            check_expr_for_ub(report, func_name, then_expr);
-            check_expr_for_ub(report, func_name, else_expr);
-        }
-        CExpr::Assign { target, value, .. } => {
-            check_expr_for_ub(report, func_name, target);
-            check_expr_for_ub(report, func_name, value);
-        }
-        CExpr::Comma(exprs) => {
-            for e in exprs {
-                check_expr_for_ub(report, func_name, e);
-            }
-        }
-        CExpr::AddressOf(inner) | CExpr::SizeofExpr(inner) => {
-            check_expr_for_ub(report, func_name, inner);
-        }
-        _ => {}
+/// Warnings a precompiled header found when it was built
+fn replay_ub_reports(reports: &[CachedUBReport], report: &mut UBReport) {
+    for r in reports {
+        let Some(kind) = UBKind::from_name(&r.kind) else { continue };
+        let severity = match r.severity.as_str() {
+            "error" => "error",
+            "warning" => "warning",
+            _ => "note",
+        };
+        report.warnings.push(UBWarning {
+            kind,
+            severity,
+            message: r.message.clone(),
+            function: (!r.location.is_empty()).then(|| r.location.clone()),
+        });
     }
 }
 
-fn check_format_string_ub(
-    report: &mut UBReport,
-    func_name: &str,
-    call_name: &str,
-    args: &[adeb_frontend_c::ast::CExpr],
-) {
-    use adeb_frontend_c::ast::CExpr;
-
+fn check_format_string_ub(out: &mut Findings, call_name: &str, args: &[CExpr]) {
     // Only check printf-family and scanf-family
     let is_printf = matches!(call_name, "printf" | "fprintf" | "sprintf" | "snprintf");
     let is_scanf = matches!(call_name, "scanf" | "fscanf" | "sscanf");
@@ -667,15 +1388,14 @@ fn check_format_string_ub(
         let expected_args = count_format_specifiers(fmt);
         let actual_args = args.len() - fmt_idx - 1;
         if expected_args != actual_args {
-            report.warnings.push(UBWarning {
-                kind: UBKind::FormatStringMismatch,
-                severity: "warning",
-                message: format!(
+            out.push(
+                UBKind::FormatStringMismatch,
+                "warning",
+                format!(
                     "{}(): format expects {} argument(s) but {} provided (C99 §7.19.6)",
                     call_name, expected_args, actual_args
                 ),
-                function: Some(func_name.to_string()),
-            });
+            );
         }
     }
 }
@@ -758,86 +1478,95 @@ fn stmt_has_break_or_return(stmt: &adeb_frontend_c::ast::CStmt) -> bool {
 
 // ── Semantic Snapshot ───────────────────────────────────────
 
-pub fn collect_semantic_snapshot(unit: &CTranslationUnit) -> SemanticSnapshot {
-    let mut entries = Vec::new();
-    let mut counts = BTreeMap::<String, usize>::new();
+/// Symbol table built one top-level declaration at a time
+#[derive(Default)]
+struct SnapshotBuilder {
+    entries: Vec<SymbolEntry>,
+    counts: BTreeMap<String, usize>,
+}
 
-    for declaration in &unit.declarations {
+impl SnapshotBuilder {
+    fn add(&mut self, declaration: &CTopLevel) {
         match declaration {
             CTopLevel::FunctionDef { return_type, name, params, .. } => {
-                entries.push(SymbolEntry {
+                self.entries.push(SymbolEntry {
                     kind: "function",
                     name: name.clone(),
                     detail: format!("{} ({}) [definition]", render_ctype(return_type), render_params(params)),
                 });
-                *counts.entry(name.clone()).or_default() += 1;
+                *self.counts.entry(name.clone()).or_default() += 1;
             }
             CTopLevel::FunctionDecl { return_type, name, params } => {
-                entries.push(SymbolEntry {
+                self.entries.push(SymbolEntry {
                     kind: "prototype",
                     name: name.clone(),
                     detail: format!("{} ({})", render_ctype(return_type), render_params(params)),
                 });
-                *counts.entry(name.clone()).or_default() += 1;
+                *self.counts.entry(name.clone()).or_default() += 1;
             }
             CTopLevel::GlobalVar { type_spec, declarators } => {
                 for declarator in declarators {
-                    entries.push(SymbolEntry {
+                    self.entries.push(SymbolEntry {
                         kind: "global",
                         name: declarator.name.clone(),
                         detail: render_declarator(type_spec, declarator),
                     });
-                    *counts.entry(declarator.name.clone()).or_default() += 1;
+                    *self.counts.entry(declarator.name.clone()).or_default() += 1;
                 }
             }
             CTopLevel::StructDef { name, fields } => {
-                entries.push(SymbolEntry {
+                self.entries.push(SymbolEntry {
                     kind: "struct",
                     name: name.clone(),
                     detail: format!("{} field(s)", fields.len()),
                 });
-                *counts.entry(name.clone()).or_default() += 1;
+                *self.counts.entry(name.clone()).or_default() += 1;
             }
             CTopLevel::EnumDef { name, values } => {
-                entries.push(SymbolEntry {
+                self.entries.push(SymbolEntry {
                     kind: "enum",
                     name: name.clone(),
                     detail: format!("{} value(s)", values.len()),
                 });
-                *counts.entry(name.clone()).or_default() += 1;
+                *self.counts.entry(name.clone()).or_default() += 1;
             }
             CTopLevel::TypedefDecl { original, new_name } => {
-                entries.push(SymbolEntry {
+                self.entries.push(SymbolEntry {
                     kind: "typedef",
                     name: new_name.clone(),
                     detail: render_ctype(original),
                 });
-                *counts.entry(new_name.clone()).or_default() += 1;
+                *self.counts.entry(new_name.clone()).or_default() += 1;
             }
             CTopLevel::UnionDef { name, fields } => {
-                entries.push(SymbolEntry {
+                self.entries.push(SymbolEntry {
                     kind: "union",
                     name: name.clone(),
                     detail: format!("{} field(s)", fields.len()),
                 });
-                *counts.entry(name.clone()).or_default() += 1;
+                *self.counts.entry(name.clone()).or_default() += 1;
             }
         }
     }
 
-    let duplicate_symbols = counts
-        .into_iter()
-        .filter_map(|(name, count)| (count > 1).then_some(name))
-        .collect();
+    fn finish(self) -> SemanticSnapshot {
+        let duplicate_symbols = self
+            .counts
+            .into_iter()
+            .filter_map(|(name, count)| (count > 1).then_some(name))
+            .collect();
 
-    SemanticSnapshot { entries, duplicate_symbols }
+        SemanticSnapshot { entries: self.entries, duplicate_symbols }
+    }
 }
 
 // ── Step Mode Printing ──────────────────────────────────────
 
 fn print_step_mode(input_file: &str, source: &str, pipeline: &CPipelineArtifacts) {
+    let spans = time_report::snapshot();
     println!();
     println!("{}", term::phase_bar(0, "Preprocessor", "C"));
+    print_phase_cost(&spans, &["preprocess", "headers"]);
     println!(
         "{}",
         term::info(&format!(
@@ -863,6 +1592,7 @@ fn print_step_mode(input_file: &str, source: &str, pipeline: &CPipelineArtifacts
 
     println!();
     println!("{}", term::phase_bar(1, "Lexical Analysis", "C"));
+    print_phase_cost(&spans, &["lex"]);
     println!(
         "{}",
         term::info(&format!("Tokens generados: {}", pipeline.tokens.len()))
@@ -876,6 +1606,7 @@ fn print_step_mode(input_file: &str, source: &str, pipeline: &CPipelineArtifacts
 
     println!();
     println!("{}", term::phase_bar(2, "Syntactic Analysis (Parser)", "C"));
+    print_phase_cost(&spans, &["parse"]);
     println!(
         "{}",
         term::info(&format!(
@@ -914,6 +1645,8 @@ fn print_step_mode(input_file: &str, source: &str, pipeline: &CPipelineArtifacts
 
     println!();
     println!("{}", term::phase_bar(4, "UB Detection", "C"));
+    // Includes semantic analysis: both come out of the same traversal
+    print_phase_cost(&spans, &["ub-detect"]);
     if pipeline.ub_report.warnings.is_empty() {
         println!("{}", term::ok("No undefined behavior detected"));
     } else {
@@ -946,6 +1679,7 @@ fn print_step_mode(input_file: &str, source: &str, pipeline: &CPipelineArtifacts
 
     println!();
     println!("{}", term::phase_bar(5, "IR Generation", "C"));
+    print_phase_cost(&spans, &["c-to-ir"]);
     println!(
         "{}",
         term::info(&format!(
@@ -958,9 +1692,16 @@ fn print_step_mode(input_file: &str, source: &str, pipeline: &CPipelineArtifacts
     println!("{:#?}", pipeline.program);
 }
 
-fn print_backend_step(code: &[u8], data: &[u8], iat_offsets: &[usize], string_offsets: &[usize]) {
+fn print_backend_step(
+    compiler: &CIsaCompiler,
+    code: &[u8],
+    data: &[u8],
+    iat_offsets: &[usize],
+    string_offsets: &[usize],
+) {
     println!();
     println!("{}", term::phase_bar(6, "Code Generation", "x64"));
+    print_phase_cost(&time_report::snapshot(), &["lto", "codegen", "isa-schedule", "encode"]);
     println!(
         "{}",
         term::info(&format!(
@@ -975,6 +1716,121 @@ fn print_backend_step(code: &[u8], data: &[u8], iat_offsets: &[usize], string_of
     println!("DATA HEX  {}", bytes_to_hex(data, 64));
     println!("IAT       {:?}", iat_offsets);
     println!("STRINGS   {:?}", string_offsets);
+
+    match compiler.schedule_stats() {
+        Some(stats) => {
+            println!(
+                "{}",
+                term::info(&format!(
+                    "ISA scheduler: ops {} -> {} | movidos {} | pares fusionados {} | deps falsas rotas {}",
+                    stats.original_ops,
+                    stats.optimized_ops,
+                    stats.instructions_scheduled,
+                    stats.fused_pairs,
+                    stats.false_deps_broken
+                ))
+            );
+            println!("   {:<12} {:>6} {:>8} {:>10} {:>10}", "pass", "runs", "changed", "ops -", "ms");
+            for pass in &stats.passes {
+                println!(
+                    "   {:<12} {:>6} {:>8} {:>10} {:>10.3}",
+                    pass.name,
+                    pass.runs,
+                    pass.changed_runs,
+                    pass.ops_removed,
+                    pass.time.as_secs_f64() * 1000.0
+                );
+            }
+        }
+        None => println!("{}", term::dim("ISA scheduler: off (-mtune=<cpu>)")),
+    }
+
+    let reports = compiler.loop_reports();
+    if !reports.is_empty() {
+        let mut skipped: BTreeMap<String, usize> = BTreeMap::new();
+        for reason in reports.iter().filter_map(|r| r.skipped) {
+            *skipped.entry(reason.to_string()).or_default() += 1;
+        }
+        let vectorized = reports.len() - skipped.values().sum::<usize>();
+        let reasons = skipped
+            .iter()
+            .map(|(reason, n)| format!("{} x{}", reason, n))
+            .collect::<Vec<_>>()
+            .join(", ");
+        println!(
+            "{}",
+            term::info(&format!(
+                "SoA/vectorizer: {} bucle(s) vectorizados, {} descartados{}",
+                vectorized,
+                reports.len() - vectorized,
+                if reasons.is_empty() { String::new() } else { format!(" ({})", reasons) }
+            ))
+        );
+    }
+
+    let mut functions = compiler.function_stats().to_vec();
+    if !functions.is_empty() {
+        let key = std::env::var("ADEB_STEP_SORT").unwrap_or_default();
+        sort_function_stats(&mut functions, &key);
+        println!(
+            "{}",
+            term::info(&format!(
+                "Codigo por funcion ({}, orden: {}; ADEB_STEP_SORT=bytes|ops|name)",
+                functions.len(),
+                if key.is_empty() { "bytes" } else { key.as_str() }
+            ))
+        );
+        println!("   {:<32} {:>8} {:>10} {:>7}", "function", "ops", "bytes", "% text");
+        let total = code.len().max(1);
+        for f in &functions {
+            println!(
+                "   {:<32} {:>8} {:>10} {:>6.1}%",
+                f.name,
+                f.ops,
+                f.bytes,
+                f.bytes as f64 * 100.0 / total as f64
+            );
+        }
+    }
+}
+
+/// One line per phase in `names`: wall time and the allocations made by the
+/// thread that ran it. Repeated spans with the same name are summed.
+fn print_phase_cost(spans: &[time_report::Span], names: &[&str]) {
+    for &name in names {
+        let mut found = false;
+        let (mut dur_us, mut allocs, mut bytes) = (0u64, 0u64, 0u64);
+        for s in spans
+            .iter()
+            .filter(|s| s.name == name && (s.cat == time_report::PHASE || s.cat == time_report::SUBPHASE))
+        {
+            found = true;
+            dur_us += s.dur_us;
+            allocs += s.allocs;
+            bytes += s.alloc_bytes;
+        }
+        if found {
+            println!(
+                "{}",
+                term::dim(&format!(
+                    "   coste {:<14} {:>10.3} ms {:>10} allocs {:>11}",
+                    name,
+                    dur_us as f64 / 1000.0,
+                    allocs,
+                    time_report::fmt_bytes(bytes)
+                ))
+            );
+        }
+    }
+}
+
+/// `bytes` and `ops` sort largest first, `name` alphabetically; ties by name.
+fn sort_function_stats(functions: &mut [FunctionCodeStats], key: &str) {
+    match key {
+        "name" => functions.sort_by(|a, b| a.name.cmp(&b.name)),
+        "ops" => functions.sort_by(|a, b| b.ops.cmp(&a.ops).then_with(|| a.name.cmp(&b.name))),
+        _ => functions.sort_by(|a, b| b.bytes.cmp(&a.bytes).then_with(|| a.name.cmp(&b.name))),
+    }
 }
 
 // ── Rendering helpers ───────────────────────────────────────
@@ -1081,6 +1937,18 @@ fn bytes_to_hex(bytes: &[u8], limit: usize) -> String {
 mod tests {
     use super::*;
 
+    #[test]
+    fn test_function_stats_sort_keys() {
+        let stat = |name: &str, ops, bytes| FunctionCodeStats { name: name.to_string(), ops, bytes };
+        let mut functions = vec![stat("b", 10, 40), stat("a", 30, 40), stat("c", 20, 90)];
+        sort_function_stats(&mut functions, "");
+        assert_eq!(functions.iter().map(|f| f.name.as_str()).collect::<Vec<_>>(), ["c", "a", "b"]);
+        sort_function_stats(&mut functions, "ops");
+        assert_eq!(functions.iter().map(|f| f.name.as_str()).collect::<Vec<_>>(), ["a", "c", "b"]);
+        sort_function_stats(&mut functions, "name");
+        assert_eq!(functions.iter().map(|f| f.name.as_str()).collect::<Vec<_>>(), ["a", "b", "c"]);
+    }
+
     #[test]
     fn test_c_pipeline_basic() {
         let result = compile_c_pipeline("int main() { return 0; }", false);
@@ -1109,6 +1977,117 @@ mod tests {
         assert!(result.is_ok());
     }
 
+    #[test]
+    fn test_lowering_frees_intermediates() {
+        let source = r#"
+            #include <ctype.h>
+            static int counter;
+            int bump(int c) { static int calls; calls++; return isdigit(c) + counter; }
+            int main() { return bump('7'); }
+        "#;
+        let full = compile_c_pipeline_in(source, Path::new("."), false).unwrap();
+        let lean = lower_c_source_in(source, Path::new("."), false).unwrap();
+        assert!(lean.preprocessed.is_empty() && lean.tokens.is_empty() && lean.unit.declarations.is_empty());
+        assert!(!full.tokens.is_empty() && !full.unit.declarations.is_empty());
+        assert_eq!(format!("{:?}", lean.program.statements), format!("{:?}", full.program.statements));
+        let names = |p: &Program| p.functions.iter().map(|f| f.name.clone()).collect::<Vec<_>>();
+        assert_eq!(names(&lean.program), names(&full.program));
+    }
+
+    #[test]
+    fn test_small_functions_inlined_before_codegen() {
+        let source = r#"
+            int add(int a, int b) { return a + b; }
+            int fact(int n) { return n <= 1 ? 1 : n * fact(n - 1); }
+            int main() { int x = 3; return add(x, 4) + fact(add(1, 2)); }
+        "#;
+        let program = lower_c_source_in(source, Path::new("."), false).unwrap().program;
+        let inlined = inline_calls(&program);
+        let names: Vec<&str> = inlined.functions.iter().map(|f| f.name.as_str()).collect();
+        assert_eq!(names, ["fact", "main"]);
+        let main = format!("{:?}", inlined.functions[1].body);
+        assert!(!main.contains("\"add\"") && main.contains("\"fact\""), "{}", main);
+        assert!(main.contains("args: [Number(3)]"), "add(1, 2) folds to 3: {}", main);
+    }
+
+    /// Build the adeb-stdlib C reference containers with a `main` that
+    /// drives them, through the whole pipeline down to a PE
+    fn compile_stdlib_impl(name: &str, implementation: &str, main: &str) -> Program {
+        let source = format!("#include <stdlib.h>\n#include <string.h>\n{}\n{}", implementation, main);
+        let pipeline = compile_c_pipeline(&source, false).unwrap();
+        let errors: Vec<_> = pipeline.ub_report.warnings.iter().filter(|w| w.severity == "error").collect();
+        assert!(errors.is_empty(), "{}: {:?}", name, errors.iter().map(|w| &w.message).collect::<Vec<_>>());
+
+        let dir = std::env::temp_dir().join(format!("adeb_{}_{}", name, std::process::id()));
+        fs::create_dir_all(&dir).unwrap();
+        let input = dir.join(format!("{}.c", name));
+        let output = dir.join(format!("{}.exe", name));
+        fs::write(&input, &source).unwrap();
+        compile_c_file(input.to_str().unwrap(), output.to_str().unwrap(), &CCompileOptions::default()).unwrap();
+        assert!(fs::metadata(&output).unwrap().len() > 0);
+        let _ = fs::remove_dir_all(&dir);
+        pipeline.program
+    }
+
+    #[test]
+    fn test_stdlib_string_impl_compiles() {
+        // 23 chars is the largest inline string; one more goes to the
+        // heap, and shrink_to_fit brings it back once it fits again
+        let main = r#"
+            int main() {
+                __adb_string s = __str_new("abcdefghijklmnopqrstuvw");
+                if (__str_is_long(&s) || __str_size(&s) != 23 || __str_cstr(&s)[23] != 0) return 1;
+                __str_push_back(&s, 'x');
+                if (!__str_is_long(&s) || __str_size(&s) != 24 || __str_capacity(&s) < 24) return 2;
+                __str_append(&s, "0123456789");
+                __str_shrink_to_fit(&s);
+                if (!__str_is_long(&s) || __str_capacity(&s) != 34) return 3;
+                __str_set_size(&s, 23);
+                __str_shrink_to_fit(&s);
+                if (__str_is_long(&s) || __str_size(&s) != 23) return 4;
+                if (strcmp(__str_cstr(&s), "abcdefghijklmnopqrstuvw") != 0) return 5;
+                __adb_string t = __str_move(&s);
+                if (!__str_empty(&s) || __str_back(&t) != 'w') return 6;
+                __str_reserve(&t, 100);
+                __str_clear(&t);
+                __str_shrink_to_fit(&t);
+                if (__str_is_long(&t) || !__str_empty(&t)) return 7;
+                __str_free(&t);
+                return 0;
+            }
+        "#;
+        let program = compile_stdlib_impl("string_impl", adeb_stdlib::cpp::fastos_string_cpp::STRING_IMPL, main);
+        for f in ["__str_new_n", "__str_realloc", "__str_shrink_to_fit", "__str_append_n", "main"] {
+            assert!(program.functions.iter().any(|g| g.name == f), "{} not lowered", f);
+        }
+    }
+
+    #[test]
+    fn test_stdlib_vector_impl_compiles() {
+        let main = r#"
+            int main() {
+                __adb_vector v;
+                __vec_init(&v, 8);
+                for (int i = 0; i < 100; i++) __vec_push_back_int(&v, i);
+                if (__vec_size(&v) != 100 || __vec_capacity(&v) < 100) return 1;
+                if (__vec_get_int(&v, 99) != 99) return 2;
+                __vec_shrink_to_fit(&v);
+                if (__vec_capacity(&v) != 100) return 3;
+                __vec_resize(&v, 150);
+                if (__vec_get_int(&v, 149) != 0) return 4;
+                __vec_clear(&v);
+                __vec_shrink_to_fit(&v);
+                if (__vec_capacity(&v) != 0 || __vec_data(&v) != 0) return 5;
+                __vec_free(&v);
+                return 0;
+            }
+        "#;
+        let program = compile_stdlib_impl("vector_impl", adeb_stdlib::cpp::fastos_vector::VECTOR_IMPL, main);
+        for f in ["__vec_grow_cap", "__vec_realloc", "__vec_shrink_to_fit", "__vec_resize", "main"] {
+            assert!(program.functions.iter().any(|g| g.name == f), "{} not lowered", f);
+        }
+    }
+
     #[test]
     fn test_ub_format_string() {
         let result = compile_c_pipeline(r#"
@@ -1124,6 +2103,27 @@ mod tests {
         assert!(!result.ub_report.has_warnings());
     }
 
+    #[test]
+    fn test_ub_reports_merged_in_source_order() {
+        // Enough functions to take the parallel path; strict findings
+        // follow all UB findings, each group in declaration order.
+        let n = PARALLEL_CHECK_MIN_FUNCTIONS + 8;
+        let mut source = String::new();
+        for i in 0..n {
+            source.push_str(&format!("int f{i}(int x) {{ char c = 300; return x / 0; }}\n"));
+        }
+        source.push_str("int main() { return 0; }");
+        let result = compile_c_pipeline(&source, true).unwrap();
+        let funcs = |kind: fn(&UBKind) -> bool| -> Vec<String> {
+            result.ub_report.warnings.iter().filter(|w| kind(&w.kind)).filter_map(|w| w.function.clone()).collect()
+        };
+        let expected: Vec<String> = (0..n).map(|i| format!("f{i}")).collect();
+        assert_eq!(funcs(|k| matches!(k, UBKind::DivisionByZero)), expected);
+        assert_eq!(funcs(|k| matches!(k, UBKind::IntegerTruncation)), expected);
+        let first_strict = result.ub_report.warnings.iter().position(|w| matches!(w.kind, UBKind::IntegerTruncation));
+        assert_eq!(first_strict, Some(n));
+    }
+
     #[test]
     fn test_strict_truncation() {
         // char can hold -128..127, 300 does not fit
@@ -1132,6 +2132,179 @@ mod tests {
         assert!(result.ub_report.warnings.iter().any(|w| matches!(w.kind, UBKind::IntegerTruncation)));
     }
 
+    #[test]
+    fn test_strict_types_cached_across_compiles() {
+        let source = "long widen(int x) { return x; } int main() { return (int)widen(1); }";
+        let program = compile_c_pipeline(source, true).unwrap().program;
+        let cache = StrictCheckCache::new();
+        assert!(strict_type_warnings(&program, &cache).is_empty());
+        assert_eq!((cache.hits(), cache.misses()), (0, program.functions.len()));
+
+        // Second strict compile of the same TU: every body comes from the cache
+        let global_hits = StrictCheckCache::global().hits();
+        let again = compile_c_pipeline(source, true).unwrap().program;
+        assert!(StrictCheckCache::global().hits() >= global_hits + again.functions.len());
+        assert!(strict_type_warnings(&again, &cache).is_empty());
+        assert_eq!(cache.hits(), again.functions.len());
+    }
+
+    #[test]
+    fn test_fixtures_strict_clean() {
+        // 03 and 18 store 0xDEADBEEF in an int: a truncation strict mode rejects
+        let dir = Path::new(env!("CARGO_MANIFEST_DIR")).join("../../../../../tests/c/fixtures");
+        let mut checked = 0;
+        for entry in fs::read_dir(&dir).unwrap() {
+            let path = entry.unwrap().path();
+            let name = path.file_name().unwrap().to_string_lossy().into_owned();
+            if !name.ends_with(".c") || name.starts_with("03_") || name.starts_with("18_") {
+                continue;
+            }
+            let source = fs::read_to_string(&path).unwrap();
+            let result = lower_c_source_in(&source, &dir, true).unwrap_or_else(|e| panic!("{}: {}", name, e));
+            let errors: Vec<_> = result.ub_report.warnings.iter().filter(|w| w.severity == "error").collect();
+            assert!(errors.is_empty(), "{} is not strict-clean: {:?}", name, errors);
+            checked += 1;
+        }
+        assert!(checked >= 30, "only {} fixtures found in {}", checked, dir.display());
+    }
+
+    #[test]
+    fn test_c_objects_cached_and_linked() {
+        let dir = std::env::temp_dir().join(format!("adeb_multi_tu_{}", std::process::id()));
+        fs::create_dir_all(&dir).unwrap();
+        let a = dir.join("a.c");
+        let b = dir.join("b.c");
+        fs::write(&a, "int add(int x, int y); int g; int main() { return add(g, 2); }").unwrap();
+        fs::write(&b, "int g = 40; int add(int x, int y) { return x + y; }").unwrap();
+        let cache = ObjectCache::new(dir.join("cache"));
+
+        let (oa, cached_a) = compile_c_object(a.to_str().unwrap(), false, &cache).unwrap();
+        let (ob, _) = compile_c_object(b.to_str().unwrap(), false, &cache).unwrap();
+        assert!(!cached_a);
+        let (_, cached_again) = compile_c_object(a.to_str().unwrap(), false, &cache).unwrap();
+        assert!(cached_again, "unchanged TU should come from the object cache");
+
+        let linked = link_c_objects(&[oa, ob]).unwrap();
+        assert!(linked.functions.iter().any(|f| f.name == "main"));
+        assert!(linked.functions.iter().any(|f| f.name == "add"));
+        let g: Vec<_> = linked
+            .statements
+            .iter()
+            .filter(|s| matches!(s, Stmt::VarDecl { name, .. } if name == "g"))
+            .collect();
+        assert_eq!(g.len(), 1);
+        assert!(matches!(g[0], Stmt::VarDecl { value: Some(_), .. }));
+
+        fs::write(&b, "int g = 1; int add(int x, int y) { return x - y; }").unwrap();
+        let (_, cached_b) = compile_c_object(b.to_str().unwrap(), false, &cache).unwrap();
+        assert!(!cached_b, "edited TU must be recompiled");
+        let _ = fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_link_keeps_static_symbols_per_tu() {
+        let dir = std::env::temp_dir().join(format!("adeb_static_tu_{}", std::process::id()));
+        fs::create_dir_all(&dir).unwrap();
+        let a = dir.join("a.c");
+        let b = dir.join("b.c");
+        fs::write(&a, "static int n = 1; static int get(void) { return n; } int b_get(void); int main() { return get() + b_get(); }").unwrap();
+        fs::write(&b, "static int n = 2; static int get(void) { return n; } int b_get(void) { return get(); }").unwrap();
+        let cache = ObjectCache::new(dir.join("cache"));
+        let (oa, _) = compile_c_object(a.to_str().unwrap(), false, &cache).unwrap();
+        let (ob, _) = compile_c_object(b.to_str().unwrap(), false, &cache).unwrap();
+
+        let linked = link_c_objects(&[oa, ob]).unwrap();
+        let names: Vec<&str> = linked.functions.iter().map(|f| f.name.as_str()).collect();
+        assert!(names.contains(&"__tu0_get") && names.contains(&"__tu1_get"), "{:?}", names);
+        let b_get = linked.functions.iter().find(|f| f.name == "b_get").unwrap();
+        assert!(matches!(&b_get.body[..], [.., Stmt::Return(Some(adeb_core::ast::Expr::Call { name, .. }))] if name == "__tu1_get"));
+        let globals: Vec<&str> = linked
+            .statements
+            .iter()
+            .filter_map(|s| match s {
+                Stmt::VarDecl { name, .. } => Some(name.as_str()),
+                _ => None,
+            })
+            .collect();
+        assert!(globals.contains(&"__tu0_n") && globals.contains(&"__tu1_n"), "{:?}", globals);
+        let _ = fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_link_rejects_duplicate_external_definitions() {
+        let dir = std::env::temp_dir().join(format!("adeb_dup_tu_{}", std::process::id()));
+        fs::create_dir_all(&dir).unwrap();
+        let a = dir.join("a.c");
+        let b = dir.join("b.c");
+        fs::write(&a, "int g; int twice(int x) { return x * 2; } int main() { return twice(g); }").unwrap();
+        fs::write(&b, "int g = 3; int twice(int x) { return x + x; }").unwrap();
+        let cache = ObjectCache::new(dir.join("cache"));
+        let (oa, _) = compile_c_object(a.to_str().unwrap(), false, &cache).unwrap();
+        let (ob, _) = compile_c_object(b.to_str().unwrap(), false, &cache).unwrap();
+
+        let err = link_c_objects(&[oa.clone(), ob]).unwrap_err();
+        assert!(err.contains("multiple definition of 'twice'"), "{}", err);
+        // Tentative `int g;` next to `int g = 3;` is not a conflict, two initializers are
+        fs::write(&b, "int g = 3;").unwrap();
+        let (ob, _) = compile_c_object(b.to_str().unwrap(), false, &cache).unwrap();
+        assert!(link_c_objects(&[oa.clone(), ob]).is_ok());
+        fs::write(&a, "int g = 4; int main() { return g; }").unwrap();
+        let (oa, _) = compile_c_object(a.to_str().unwrap(), false, &cache).unwrap();
+        let (ob, _) = compile_c_object(b.to_str().unwrap(), false, &cache).unwrap();
+        assert!(link_c_objects(&[oa, ob]).unwrap_err().contains("'g'"));
+        let _ = fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_precompiled_header_replaces_text() {
+        let dir = std::env::temp_dir().join(format!("adeb_pch_driver_{}", std::process::id()));
+        fs::create_dir_all(&dir).unwrap();
+        let header = dir.join("common.h");
+        fs::write(&header, concat!(
+            "#ifndef COMMON_H\n#define COMMON_H\n#include <stdio.h>\n",
+            "typedef int score_t;\n#define BONUS 2\n",
+            "static int risky(int x) { return x / 0; }\n",
+            "score_t boost(score_t s) { return s + BONUS; }\n#endif\n",
+        ))
+        .unwrap();
+        let source = "#include \"common.h\"\n#include \"common.h\"\nint main() { score_t s = boost(BONUS); return s; }\n";
+
+        // Without an image the header is pasted
+        let pasted = compile_c_pipeline_in(source, &dir, false).unwrap();
+        assert!(pasted.preprocessed.contains("score_t boost"));
+
+        precompile_c_header(header.to_str().unwrap()).unwrap();
+        let loaded = compile_c_pipeline_in(source, &dir, false).unwrap();
+        assert!(!loaded.preprocessed.contains("score_t boost"), "image must replace the text");
+        assert!(loaded.preprocessed.contains("boost(2)"));
+        assert!(loaded.program.functions.iter().any(|f| f.name == "boost"));
+        assert!(loaded.ub_report.warnings.iter().any(|w| matches!(w.kind, UBKind::DivisionByZero)));
+        assert_eq!(loaded.included_headers, pasted.included_headers);
+        assert_eq!(loaded.user_headers, vec![fs::canonicalize(&header).unwrap().to_string_lossy().into_owned()]);
+
+        // A #define before the include: the image no longer applies
+        let defined = compile_c_pipeline_in(&format!("#define BONUS_SEEN 1\n{}", source), &dir, false).unwrap();
+        assert!(defined.preprocessed.contains("score_t boost"));
+        let _ = fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_c_object_recompiled_when_header_changes() {
+        let dir = std::env::temp_dir().join(format!("adeb_obj_header_{}", std::process::id()));
+        fs::create_dir_all(&dir).unwrap();
+        let main = dir.join("main.c");
+        fs::write(dir.join("config.h"), "#define LEVEL 1\n").unwrap();
+        fs::write(&main, "#include \"config.h\"\nint main() { return LEVEL; }\n").unwrap();
+        let cache = ObjectCache::new(dir.join("cache"));
+        let main = main.to_str().unwrap();
+
+        assert!(!compile_c_object(main, false, &cache).unwrap().1);
+        assert!(compile_c_object(main, false, &cache).unwrap().1);
+        fs::write(dir.join("config.h"), "#define LEVEL 2\n").unwrap();
+        assert!(!compile_c_object(main, false, &cache).unwrap().1, "edited header must recompile the TU");
+        let _ = fs::remove_dir_all(&dir);
+    }
+
     #[test]
     fn test_strict_clean_code_no_errors() {
         // Clean code should pass strict mode with no errors
@@ -17,11 +17,17 @@
 use crate::cli::term;
 use adeb_backend_x64::isa::isa_compiler::{IsaCompiler, Target};
 use adeb_core::ast::Program;
+use adeb_core::cache::build_id;
+use adeb_core::cache::hasher::hash_bytes;
+use adeb_core::cache::objects::{object_key, ObjectCache};
+use adeb_core::time_report;
 use adeb_frontend_cpp::ast::*;
 use adeb_frontend_cpp::lower::cpp_to_ir::CppToIR;
+use adeb_frontend_cpp::lower::templates::{LoweredInstance, SharedInstances};
 use adeb_frontend_cpp::parse::lexer::CppLexer;
 use adeb_frontend_cpp::parse::parser::CppParser;
 use adeb_frontend_cpp::preprocessor::CppPreprocessor;
+use serde::{Deserialize, Serialize};
 use std::fs;
 
 // ── Public types ────────────────────────────────────────────
@@ -86,20 +92,39 @@ impl CppUBReport {
 // ── Pipeline ────────────────────────────────────────────────
 
 pub fn compile_cpp_pipeline(source: &str, strict: bool) -> Result<CppPipelineArtifacts, String> {
+    compile_cpp_pipeline_shared(source, strict, None)
+}
+
+/// Same pipeline; template instantiations are looked up in (and added to)
+/// `shared`, so TUs of one build lower each instantiation once. With
+/// `shared` the class hierarchy is open (no single-implementation
+/// devirtualization).
+pub fn compile_cpp_pipeline_shared(
+    source: &str,
+    strict: bool,
+    shared: Option<&SharedInstances>,
+) -> Result<CppPipelineArtifacts, String> {
     // C++ is IMPLICITLY STRICT — bits are respected, UB = error
     let effective_strict = true; // C++ is always strict in ADead-BIB
 
     // Phase 0: Preprocess
+    let t = time_report::phase("preprocess");
     let mut pp = CppPreprocessor::new();
     let preprocessed = pp.process(source);
+    drop(t);
 
     // Phase 1: Lex
+    let t = time_report::phase("lex");
     let (tokens, token_lines) = CppLexer::new(&preprocessed).tokenize();
+    drop(t);
 
     // Phase 2: Parse
+    let t = time_report::phase("parse");
     let unit = CppParser::new(tokens.clone(), token_lines.clone()).parse_translation_unit()?;
+    drop(t);
 
     // Phase 3+4: UB Detection (always strict)
+    let t = time_report::phase("ub-detect");
     let mut ub_report = detect_cpp_ub(&unit);
     detect_cpp_strict_violations(&unit, &mut ub_report);
 
@@ -112,9 +137,17 @@ pub fn compile_cpp_pipeline(source: &str, strict: bool) -> Result<CppPipelineArt
         }
     }
 
+    drop(t);
+
     // Phase 5: Lower to IR
+    let t = time_report::phase("cpp-to-ir");
     let mut lower = CppToIR::new();
+    if let Some(shared) = shared {
+        // A TU of a multi-file build: other TUs may add subclasses
+        lower = lower.with_shared_instances(shared.clone()).with_closed_hierarchy(false);
+    }
     let program = lower.convert(&unit)?;
+    drop(t);
 
     Ok(CppPipelineArtifacts {
         preprocessed,
@@ -132,6 +165,7 @@ pub fn compile_cpp_file(
     output_file: &str,
     step_mode: bool,
     strict: bool,
+    builtin_malloc: bool,
 ) -> Result<(), Box<dyn std::error::Error>> {
     use crate::cli::term;
     println!("{}", term::compiler_header("C++", "9.0", "STRICT \u{2014} bits respected"));
@@ -172,14 +206,24 @@ pub fn compile_cpp_file(
         return Err("Strict mode: UB detected — refusing to emit binary".into());
     }
 
+    emit_cpp_pe(&pipeline.program, output_file, builtin_malloc)
+}
+
+/// Phases 6-7 plus post-build validation
+fn emit_cpp_pe(program: &Program, output_file: &str, builtin_malloc: bool) -> Result<(), Box<dyn std::error::Error>> {
     println!("   Phase 6: Compiling to native code...");
+    let t = time_report::phase("codegen");
     let mut compiler = IsaCompiler::new(Target::Windows);
-    let (code, data, iat_offsets, string_offsets) = compiler.compile(&pipeline.program);
+    compiler.set_builtin_heap(builtin_malloc);
+    let (code, data, iat_offsets, string_offsets) = compiler.compile(program);
+    drop(t);
 
     println!("   Phase 7: Generating PE binary...");
+    let t = time_report::phase("pe-write");
     adeb_backend_x64::pe::generate_pe_with_offsets(
         &code, &data, output_file, &iat_offsets, &string_offsets,
     )?;
+    drop(t);
 
     let meta = fs::metadata(output_file)
         .map_err(|e| format!("Post-build: cannot stat '{}': {}", output_file, e))?;
@@ -199,6 +243,141 @@ pub fn compile_cpp_file(
     Ok(())
 }
 
+// ── Multi-file builds ───────────────────────────────────────
+
+/// Intermediate object for one C++ translation unit, cached like `CObject`
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct CppObject {
+    pub source: String,
+    pub key: u64,
+    /// (severity, location, message) of each UB diagnostic
+    pub diagnostics: Vec<(String, Option<String>, String)>,
+    pub program: Program,
+}
+
+impl CppObject {
+    pub fn has_ub_errors(&self) -> bool {
+        self.diagnostics.iter().any(|(severity, _, _)| severity == "error")
+    }
+}
+
+fn cpp_salt(strict: bool) -> String {
+    format!("adB-cpp-{}-strict={}", build_id(), strict)
+}
+
+/// Cache key of the build's template instantiation store
+fn instances_key(strict: bool) -> u64 {
+    hash_bytes(format!("{}-instances", cpp_salt(strict)).as_bytes())
+}
+
+/// Compile one TU to a CppObject, reusing the on-disk object when the
+/// content hash (and compiler version/flags) are unchanged.
+/// Returns the object and whether it came from the cache.
+pub fn compile_cpp_object(
+    input_file: &str,
+    strict: bool,
+    cache: &ObjectCache,
+    shared: &SharedInstances,
+) -> Result<(CppObject, bool), String> {
+    let key = object_key(input_file, &cpp_salt(strict))
+        .map_err(|e| format!("Cannot read '{}': {}", input_file, e))?;
+
+    if let Some(bytes) = cache.load(key) {
+        if let Ok(object) = serde_json::from_slice::<CppObject>(&bytes) {
+            if object.key == key {
+                return Ok((object, true));
+            }
+        }
+    }
+
+    let source = fs::read_to_string(input_file)
+        .map_err(|e| format!("Cannot read '{}': {}", input_file, e))?;
+    let pipeline = compile_cpp_pipeline_shared(&source, strict, Some(shared))
+        .map_err(|e| format!("{}: C++ pipeline error: {}", input_file, e))?;
+    let object = CppObject {
+        source: input_file.to_string(),
+        key,
+        diagnostics: pipeline
+            .ub_report
+            .warnings
+            .iter()
+            .map(|w| (w.severity.to_string(), w.location.clone(), w.message.clone()))
+            .collect(),
+        program: pipeline.program,
+    };
+
+    // A failed cache write only costs a recompile next time
+    if let Ok(bytes) = serde_json::to_vec(&object) {
+        let _ = cache.store(key, &bytes);
+    }
+    Ok((object, false))
+}
+
+/// Compile several .cpp files into one PE. Template instantiations are
+/// lowered once per build and kept in the object cache between builds;
+/// an instantiation several TUs emit (`max<int>`) links once.
+pub fn compile_cpp_files(
+    input_files: &[String],
+    output_file: &str,
+    step_mode: bool,
+    strict: bool,
+    builtin_malloc: bool,
+) -> Result<(), Box<dyn std::error::Error>> {
+    if input_files.len() == 1 {
+        return compile_cpp_file(&input_files[0], output_file, step_mode, strict, builtin_malloc);
+    }
+
+    println!("{}", term::compiler_header("C++", "9.0", "STRICT \u{2014} bits respected"));
+    println!("   {} {}", term::dim("Sources:"), input_files.join(" "));
+    println!("   {} {}", term::dim("Target:"), output_file);
+
+    let cache = ObjectCache::from_env();
+    let shared = cache
+        .load(instances_key(strict))
+        .and_then(|bytes| serde_json::from_slice::<Vec<(u64, LoweredInstance)>>(&bytes).ok())
+        .map(SharedInstances::from_entries)
+        .unwrap_or_default();
+
+    println!("   Phase 1: Compiling {} translation units...", input_files.len());
+    let results = adeb_core::parallel::par_map(
+        input_files,
+        adeb_core::parallel::default_jobs(),
+        |input| compile_cpp_object(input, strict, &cache, &shared),
+    );
+
+    let mut objects = Vec::with_capacity(results.len());
+    let mut any_ub_error = false;
+    for result in results {
+        let (object, cached) = result?;
+        let status = if cached { term::dim("(cached)") } else { term::ok("(compiled)") };
+        println!("     {} {}", object.source, status);
+        for (severity, location, message) in &object.diagnostics {
+            let loc = location.as_ref().map(|l| format!(" in {}", l)).unwrap_or_default();
+            match severity.as_str() {
+                "error" => eprintln!("   {} UB{}: {}", term::error_text("ERROR"), loc, message),
+                "warning" => println!("   {} UB{}: {}", term::warn("WARN"), loc, message),
+                _ => println!("   {} UB{}: {}", term::info("NOTE"), loc, message),
+            }
+        }
+        any_ub_error |= object.has_ub_errors();
+        objects.push(object);
+    }
+    if strict && any_ub_error {
+        return Err("Strict mode: UB detected — refusing to emit binary".into());
+    }
+
+    // Only instantiations this build touched are kept for the next one
+    if let Ok(bytes) = serde_json::to_vec(&shared.used_entries()) {
+        let _ = cache.store(instances_key(strict), &bytes);
+    }
+
+    println!("   Phase 5: Linking {} objects...", objects.len());
+    let t = time_report::phase("link");
+    let program = super::c_driver::link_programs(objects.iter().map(|o| (o.source.as_str(), &o.program)))?;
+    drop(t);
+    emit_cpp_pe(&program, output_file, builtin_malloc)
+}
+
 // ── Step mode output ────────────────────────────────────────
 
 fn print_cpp_step_mode(file: &str, source: &str, arts: &CppPipelineArtifacts) {
@@ -996,3 +1175,54 @@ mod tests {
         assert!(init.body.len() >= 2);
     }
 }
+
+// ── Runtime tests ───────────────────────────────────────────
+// Run the lowered program: copies and by-value classes must agree with
+// the backend's layout, which the IR shape alone does not show.
+
+#[cfg(all(test, target_os = "linux", target_arch = "x86_64"))]
+mod run_tests {
+    use super::*;
+    use adeb_backend_x64::isa::test_jit::JitCode;
+
+    /// Compiles `source` and calls its `main` through the backend's JIT
+    /// fixture. The data section is not mapped: no strings, globals or I/O.
+    fn run_main(source: &str) -> i64 {
+        let arts = compile_cpp_pipeline(source, false).unwrap();
+        let mut compiler = IsaCompiler::new(Target::Linux);
+        let (code, _, _, _) = compiler.compile(&arts.program);
+        let jit = JitCode::from_code(&code);
+        let main: extern "sysv64" fn() -> i64 = unsafe { jit.entry() };
+        main() as i32 as i64
+    }
+
+    #[test]
+    fn test_returned_copies_keep_every_field() {
+        let source = r#"
+            struct P { int x; int y; };
+            P pick(bool c) { P a; a.x = 1; a.y = 2; P b; b.x = 3; b.y = 4; if (c) return a; return b; }
+            int main() { P a = pick(true); P b = pick(false); return a.x * 1000 + a.y * 100 + b.x * 10 + b.y; }
+        "#;
+        assert_eq!(run_main(source), 1234);
+    }
+
+    #[test]
+    fn test_by_value_parameter_copies() {
+        // P travels in registers, Q (five slots) by address
+        let source = r#"
+            struct P { int x; int y; };
+            struct Q { int a; int b; int c; int d; int e; };
+            P id(P p) { return p; }
+            Q idq(Q q) { return q; }
+            int main() {
+                P a; a.x = 5; a.y = 6;
+                Q x; x.a = 1; x.b = 2; x.c = 3; x.d = 4; x.e = 5;
+                P b = id(a);
+                Q y = idq(x);
+                Q z = y;
+                return (b.x * 10 + b.y) * 100000 + z.a * 10000 + z.b * 1000 + z.c * 100 + z.d * 10 + z.e;
+            }
+        "#;
+        assert_eq!(run_main(source), 5612345);
+    }
+}
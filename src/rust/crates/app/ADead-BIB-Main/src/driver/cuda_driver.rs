@@ -1,24 +1,108 @@
 // ============================================================
-// ADead-BIB — CUDA Language Driver (Stub)
+// ADead-BIB — CUDA Language Driver
 // ============================================================
-// Future: CUDA/PTX compilation pipeline
-//   Phase 0: Preprocessor (C-based)
-//   Phase 1: Lexer (C + CUDA extensions)
-//   Phase 2: Parser (CUDA AST: __global__, __device__, <<<>>>)
-//   Phase 3: Kernel Analysis (shared memory, thread divergence)
-//   Phase 4: UB Detection (race conditions, out-of-bounds)
-//   Phase 5: IR Generation (GPU IR)
-//   Phase 6: PTX/SPIR-V Code Gen
-//   Phase 7: Output (PTX or fat binary)
+// With the `gpu` feature a .cu file is parsed once and split:
+//   Device: CudeadIR → UB detector → GpuOptimizer → PTX
+//   Host:   C++ pipeline (CppToIR) → IsaCompiler → PE
+// Both halves only share the kernel signatures, so they run on
+// two threads and join at link time, where the PTX is embedded
+// at the end of the data section. `-o x.ptx` emits the PTX
+// alone. Step mode (and ADEB_JOBS=1) keeps them sequential.
+//
+// Without `gpu` the driver is still a stub.
 // ============================================================
 
-use crate::cli::term;
+#[cfg(feature = "gpu")]
+pub fn compile_cuda_file(
+    input_file: &str,
+    output_file: &str,
+    step_mode: bool,
+) -> Result<(), Box<dyn std::error::Error>> {
+    use adeb_backend_gpu::cudead::{host_source, CudeadCompiler, CudeadConfig};
+    use adeb_core::{parallel, time_report};
+    use std::fs;
+
+    println!("  ADead-BIB CUDA Compiler v1.0");
+    println!("   Source: {}", input_file);
+    println!("   Target: {}", output_file);
+
+    let source = fs::read_to_string(input_file)
+        .map_err(|e| format!("Cannot read '{}': {}", input_file, e))?;
+
+    let compiler = CudeadCompiler::with_config(CudeadConfig {
+        step_mode,
+        emit_ptx: true,
+        ..CudeadConfig::default()
+    });
+    let t = time_report::phase("cuda-parse");
+    let ast = compiler.parse(&source).map_err(|e| format!("CUDA {}", e))?;
+    drop(t);
+    println!("   Kernels: {}", ast.kernels.len());
+
+    let device = || {
+        let _t = time_report::phase("device");
+        compiler.compile_ast(&ast).map_err(|e| format!("CUDA {}", e))
+    };
+
+    if output_file.ends_with(".ptx") {
+        let ptx = device()?.ptx;
+        fs::write(output_file, &ptx).map_err(|e| format!("Cannot write '{}': {}", output_file, e))?;
+        println!("   Build complete: {} ({} bytes of PTX)", output_file, ptx.len());
+        return Ok(());
+    }
+
+    let host_src = host_source(&source);
+    let host = || {
+        let _t = time_report::phase("host");
+        compile_cuda_host(&host_src)
+    };
+    let (device, host) = if step_mode || parallel::default_jobs() <= 1 {
+        (device(), host())
+    } else {
+        std::thread::scope(|scope| {
+            let device = scope.spawn(device);
+            let host = host();
+            (device.join().expect("device pipeline panicked"), host)
+        })
+    };
+    let ptx = device?.ptx;
+    let (code, mut data, iat_offsets, string_offsets) = host?;
 
+    // Link: el PTX va tras los datos del host, terminado en NUL
+    let t = time_report::phase("pe-write");
+    data.extend_from_slice(ptx.as_bytes());
+    data.push(0);
+    adeb_backend_x64::pe::generate_pe_with_offsets(
+        &code, &data, output_file, &iat_offsets, &string_offsets,
+    )?;
+    drop(t);
+
+    let size = fs::metadata(output_file)
+        .map_err(|e| format!("Post-build: cannot stat '{}': {}", output_file, e))?
+        .len();
+    println!("   Build complete: {} ({} bytes, {} bytes of PTX embedded)", output_file, size, ptx.len());
+    Ok(())
+}
+
+/// Host half: the split source as C++, compiled to x86-64
+#[cfg(feature = "gpu")]
+fn compile_cuda_host(host_src: &str) -> Result<(Vec<u8>, Vec<u8>, Vec<usize>, Vec<usize>), String> {
+    use adeb_backend_x64::isa::isa_compiler::{IsaCompiler, Target};
+
+    let pipeline = super::cpp_driver::compile_cpp_pipeline(host_src, false)
+        .map_err(|e| format!("CUDA host pipeline error: {}", e))?;
+    let mut compiler = IsaCompiler::new(Target::Windows);
+    Ok(compiler.compile(&pipeline.program))
+}
+
+#[cfg(not(feature = "gpu"))]
 pub fn compile_cuda_file(
     input_file: &str,
     output_file: &str,
     step_mode: bool,
 ) -> Result<(), Box<dyn std::error::Error>> {
+    use crate::cli::term;
+
     println!("  ADead-BIB CUDA Compiler v1.0 (preview)");
     println!("   Source: {}", input_file);
     println!("   Target: {}", output_file);
@@ -35,7 +119,7 @@ pub fn compile_cuda_file(
         println!("{}", term::info("CUDA parser: not yet implemented"));
     }
 
-    Err("CUDA compilation not yet implemented — use 'cc' for C".into())
+    Err("CUDA compilation not yet implemented — build with --features gpu".into())
 }
 
 #[cfg(test)]
@@ -47,4 +131,35 @@ mod tests {
         let result = compile_cuda_file("test.cu", "test.ptx", false);
         assert!(result.is_err());
     }
+
+    #[cfg(feature = "gpu")]
+    #[test]
+    fn test_cuda_mixed_source_embeds_ptx() {
+        let dir = std::env::temp_dir().join(format!("adeb_cuda_{}", std::process::id()));
+        std::fs::create_dir_all(&dir).unwrap();
+        let input = dir.join("mixed.cu");
+        std::fs::write(&input, r#"
+__global__ void vectorAdd(float *A, float *B, float *C, int n) {
+    int i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i < n) {
+        C[i] = A[i] + B[i];
+    }
+}
+int main() {
+    vectorAdd<<<1, 32>>>(0, 0, 0, 32);
+    return 0;
+}
+"#).unwrap();
+        let exe = dir.join("mixed.exe");
+        compile_cuda_file(input.to_str().unwrap(), exe.to_str().unwrap(), false).unwrap();
+        let image = std::fs::read(&exe).unwrap();
+        assert_eq!(&image[..2], b"MZ");
+        let ptx = b".entry vectorAdd";
+        assert!(image.windows(ptx.len()).any(|w| w == ptx));
+
+        let ptx_out = dir.join("mixed.ptx");
+        compile_cuda_file(input.to_str().unwrap(), ptx_out.to_str().unwrap(), false).unwrap();
+        assert!(std::fs::read_to_string(&ptx_out).unwrap().contains(".entry vectorAdd"));
+        std::fs::remove_dir_all(&dir).ok();
+    }
 }
@@ -1,3 +1,4 @@
+pub mod bolt_driver;
 pub mod c_driver;
 pub mod cpp_driver;
 pub mod cuda_driver;
@@ -1,11 +1,17 @@
+mod batch;
 mod cli;
 mod driver;
+mod profiler;
+mod server;
 
 use crate::cli::term;
+use crate::driver::bolt_driver;
 use crate::driver::c_driver;
 use crate::driver::cpp_driver;
 use crate::driver::cuda_driver;
 use crate::driver::js_driver;
+use adeb_backend_x64::isa::scheduler::Uarch;
+use adeb_core::time_report;
 use std::env;
 use std::path::Path;
 use std::process::Command;
@@ -15,15 +21,25 @@ use std::process::ExitCode;
 // ADead-BIB — Unified Multi-Language Compiler CLI
 // ============================================================
 //   adB cc   <file.c>   [-o out] [-step]   C99/C11
+//   adB cc   a.c b.c    [-o out]           Multi-TU (cached objects)
+//   adB cc   --pch common.h                Precompiled header (common.h.bib)
+//   adB cc   --batch list.txt [--jobs N]   Independent programs, one process
 //   adB cxx  <file.cpp> [-o out] [-step]   C++17/20
 //   adB cuda <file.cu>  [-o out] [-step]   CUDA/PTX
 //   adB js   <file.js>  [-o out] [-step]   JavaScript
 //   adB run  <file.c>   [-o out] [-step]   Compile + Run
+//   adB run  <file.c>   --profile[=f]      Compile -g + run sampled
 //   adB step <file.c>   [-o out]           Step mode (all phases)
+//   adB bolt <app.exe>  --profile <f>      Post-link block relayout
+//   adB serve [--listen addr] [-j N]       Compile server (cc --server)
 // ============================================================
 
 const VERSION: &str = "9.0";
 
+// Cuenta asignaciones por hilo para -ftime-report (coste: dos TLS increments)
+#[global_allocator]
+static GLOBAL: time_report::CountingAlloc = time_report::CountingAlloc;
+
 fn main() -> ExitCode {
     term::enable_ansi();
     let args: Vec<String> = env::args().collect();
@@ -49,6 +65,19 @@ fn real_main(args: &[String]) -> Result<ExitCode, Box<dyn std::error::Error>> {
         return Ok(ExitCode::from(2));
     }
 
+    if let Some((addr, forwarded)) = server::take_server_flag(args) {
+        return server::forward(&addr, &forwarded);
+    }
+    if let Some((options, rest)) = batch::take_batch_args(args)? {
+        let lang = command_language(&args[1]).ok_or("--batch needs a compile command (cc, cxx, cuda, js)")?;
+        let results = batch::run_batch(&options, &rest, lang)?;
+        let failed = results.iter().filter(|r| !r.ok).count();
+        if failed > 0 {
+            return Err(format!("{} of {} batch sources failed", failed, results.len()).into());
+        }
+        return Ok(ExitCode::SUCCESS);
+    }
+
     match args[1].as_str() {
         "help" | "--help" | "-h" => {
             print_usage(&args[0]);
@@ -58,36 +87,39 @@ fn real_main(args: &[String]) -> Result<ExitCode, Box<dyn std::error::Error>> {
         // ── C Compiler ──────────────────────────────────
         "cc" | "c" => {
             let request = parse_request(args, Language::C)?;
-            c_driver::compile_c_file(&request.input_file, &request.output_file, request.step_mode, request.strict)?;
+            compile_request(&request, Language::C)?;
             Ok(ExitCode::SUCCESS)
         }
 
         // ── C++ Compiler ────────────────────────────────
         "cxx" | "c++" | "cpp" => {
             let request = parse_request(args, Language::Cpp)?;
-            cpp_driver::compile_cpp_file(&request.input_file, &request.output_file, request.step_mode, request.strict)?;
+            compile_request(&request, Language::Cpp)?;
             Ok(ExitCode::SUCCESS)
         }
 
         // ── CUDA Compiler ───────────────────────────────
         "cuda" | "cu" => {
             let request = parse_request(args, Language::Cuda)?;
-            cuda_driver::compile_cuda_file(&request.input_file, &request.output_file, request.step_mode)?;
+            compile_request(&request, Language::Cuda)?;
             Ok(ExitCode::SUCCESS)
         }
 
         // ── JavaScript Compiler ─────────────────────────
         "js" | "javascript" => {
             let request = parse_request(args, Language::Js)?;
-            js_driver::compile_js_file(&request.input_file, &request.output_file, request.step_mode)?;
+            compile_request(&request, Language::Js)?;
             Ok(ExitCode::SUCCESS)
         }
 
         // ── Compile + Run (auto-detect language) ────────
         "run" => {
-            let request = parse_request(args, Language::Auto)?;
+            let (profile, args) = profiler::take_profile_args(args)?;
+            let mut request = parse_request(&args, Language::Auto)?;
+            // Las muestras se simbolizan con las tablas de -g
+            request.debug_info |= profile.is_some();
             compile_by_language(&request)?;
-            run_executable(&request.output_file)
+            run_executable(&request.output_file, profile.as_ref())
         }
 
         // ── Step Mode (auto-detect language) ────────────
@@ -98,6 +130,20 @@ fn real_main(args: &[String]) -> Result<ExitCode, Box<dyn std::error::Error>> {
             Ok(ExitCode::SUCCESS)
         }
 
+        // ── Post-link relayout ──────────────────────────
+        "bolt" => {
+            let request = bolt_driver::parse_bolt_args(args)?;
+            bolt_driver::run_bolt(&request)?;
+            Ok(ExitCode::SUCCESS)
+        }
+
+        // ── Compile server ──────────────────────────────
+        "serve" => {
+            let (addr, jobs) = server::parse_serve_args(args)?;
+            server::serve(&addr, jobs)?;
+            Ok(ExitCode::SUCCESS)
+        }
+
         // ── Version ─────────────────────────────────────
         "version" | "--version" | "-v" => {
             println!("{}", term::banner("Multi-Language", VERSION));
@@ -112,11 +158,46 @@ fn real_main(args: &[String]) -> Result<ExitCode, Box<dyn std::error::Error>> {
             let first = &args[1];
             let lang = detect_language(first);
             if lang != Language::Auto || first.ends_with(".c") || first.ends_with(".h") {
+                let output_file = default_output_filename(first);
+                let mut pgo = PgoFlags::default();
+                let mut tune = None;
+                let mut lto = false;
+                let mut delay_load = false;
+                let mut debug_info = false;
+                let mut builtin_malloc = false;
+                for arg in &args[2..] {
+                    if arg == "-flto" {
+                        lto = true;
+                    } else if arg == "-fdelay-load" {
+                        delay_load = true;
+                    } else if arg == "-g" {
+                        debug_info = true;
+                    } else if arg == "-fbuiltin-malloc" {
+                        builtin_malloc = true;
+                    } else if let Some(name) = arg.strip_prefix("-mtune=") {
+                        tune = Some(parse_tune(name)?);
+                    } else {
+                        pgo.accept(arg);
+                    }
+                }
                 let request = CompileRequest {
                     input_file: first.clone(),
-                    output_file: default_output_filename(first),
+                    input_files: vec![first.clone()],
+                    pgo: pgo.resolve(&output_file)?,
+                    tune,
+                    lto,
+                    delay_load,
+                    debug_info,
+                    builtin_malloc,
+                    pch: false,
+                    output_file,
                     step_mode: args.iter().any(|a| a == "-step" || a == "--step"),
                     strict: args.iter().any(|a| a == "-Wstrict" || a == "--strict"),
+                    time_report: args.iter().any(|a| a == "-ftime-report"),
+                    trace_json: args
+                        .iter()
+                        .position(|a| a == "--trace-json")
+                        .and_then(|i| args.get(i + 1).cloned()),
                 };
                 compile_by_language(&request)?;
                 Ok(ExitCode::SUCCESS)
@@ -142,9 +223,77 @@ enum Language {
 #[derive(Debug, Clone, PartialEq, Eq)]
 struct CompileRequest {
     input_file: String,
+    /// All translation units (input_file first). Only C accepts more than one.
+    input_files: Vec<String>,
     output_file: String,
     step_mode: bool,
     strict: bool,
+    /// -ftime-report: tabla de fases (wall, allocs, peak RSS) al terminar
+    time_report: bool,
+    /// --trace-json <file>: Chrome trace con una span por fase y función
+    trace_json: Option<String>,
+    /// -fprofile-generate[=file] / -fprofile-use=file (solo C)
+    pgo: c_driver::PgoMode,
+    /// -mtune=<cpu>: tablas de latencias/puertos para el scheduler (solo C)
+    tune: Option<Uarch>,
+    /// -flto: optimización sobre el Program enlazado de todas las TUs (solo C)
+    lto: bool,
+    /// -fdelay-load: d3dcompiler/dxgi se cargan en la primera llamada (solo C)
+    delay_load: bool,
+    /// -g: símbolos de función y tabla de líneas en el PE (solo C)
+    debug_info: bool,
+    /// -fbuiltin-malloc: heap por clases de tamaño propio en vez de msvcrt
+    /// (en Linux siempre está activo)
+    builtin_malloc: bool,
+    /// --pch: las entradas son headers a precompilar en <header>.bib (solo C)
+    pch: bool,
+}
+
+/// `-mtune=` acepta los nombres de GCC/Clang que conoce el scheduler
+fn parse_tune(name: &str) -> Result<Uarch, String> {
+    Uarch::from_name(name).ok_or_else(|| {
+        format!("Unknown -mtune '{}' (generic, skylake, golden-cove, znver3, znver4)", name)
+    })
+}
+
+/// Flags de PGO tal como llegan; `resolve` necesita el -o ya conocido
+#[derive(Default)]
+struct PgoFlags {
+    generate: Option<String>,
+    use_file: Option<String>,
+}
+
+impl PgoFlags {
+    fn accept(&mut self, arg: &str) -> bool {
+        if arg == "-fprofile-generate" {
+            self.generate = Some(String::new());
+        } else if let Some(path) = arg.strip_prefix("-fprofile-generate=") {
+            self.generate = Some(path.to_string());
+        } else if let Some(path) = arg.strip_prefix("-fprofile-use=") {
+            self.use_file = Some(path.to_string());
+        } else {
+            return false;
+        }
+        true
+    }
+
+    /// Sin fichero, el perfil va junto al ejecutable: app.exe → app.prof
+    fn resolve(self, output_file: &str) -> Result<c_driver::PgoMode, String> {
+        match (self.generate, self.use_file) {
+            (Some(_), Some(_)) => {
+                Err("-fprofile-generate and -fprofile-use cannot be combined".to_string())
+            }
+            (Some(path), None) if path.is_empty() => Ok(c_driver::PgoMode::Generate(
+                Path::new(output_file).with_extension("prof").to_string_lossy().into_owned(),
+            )),
+            (Some(path), None) => Ok(c_driver::PgoMode::Generate(path)),
+            (None, Some(path)) if path.is_empty() => {
+                Err("-fprofile-use needs a file: -fprofile-use=app.prof".to_string())
+            }
+            (None, Some(path)) => Ok(c_driver::PgoMode::Use(path)),
+            (None, None) => Ok(c_driver::PgoMode::Off),
+        }
+    }
 }
 
 // ── Argument parsing ────────────────────────────────────────
@@ -154,10 +303,19 @@ fn parse_request(
     lang: Language,
 ) -> Result<CompileRequest, Box<dyn std::error::Error>> {
     let command_name = args.get(1).map(String::as_str).unwrap_or("cc");
-    let mut input_file: Option<String> = None;
+    let mut input_files: Vec<String> = Vec::new();
     let mut output_file: Option<String> = None;
     let mut step_mode = false;
     let mut strict = false;
+    let mut time_report = false;
+    let mut trace_json: Option<String> = None;
+    let mut pgo = PgoFlags::default();
+    let mut tune = None;
+    let mut lto = false;
+    let mut delay_load = false;
+    let mut debug_info = false;
+    let mut builtin_malloc = false;
+    let mut pch = false;
     let mut i = 2;
 
     while i < args.len() {
@@ -177,31 +335,95 @@ fn parse_request(
                 strict = true;
                 i += 1;
             }
+            "-ftime-report" => {
+                time_report = true;
+                i += 1;
+            }
+            "-flto" => {
+                lto = true;
+                i += 1;
+            }
+            "-fdelay-load" => {
+                delay_load = true;
+                i += 1;
+            }
+            "-g" => {
+                debug_info = true;
+                i += 1;
+            }
+            "-fbuiltin-malloc" => {
+                builtin_malloc = true;
+                i += 1;
+            }
+            "--pch" if lang == Language::C => {
+                pch = true;
+                i += 1;
+            }
+            "--trace-json" => {
+                let out = args
+                    .get(i + 1)
+                    .ok_or_else(|| format!("Missing value after --trace-json in '{}'", command_name))?;
+                trace_json = Some(out.clone());
+                i += 2;
+            }
+            flag if pgo.accept(flag) => {
+                i += 1;
+            }
+            flag if flag.starts_with("-mtune=") => {
+                tune = Some(parse_tune(&flag["-mtune=".len()..])?);
+                i += 1;
+            }
             flag if flag.starts_with('-') => {
                 return Err(format!("Unknown option '{}' in '{}'", flag, command_name).into());
             }
             value => {
-                if input_file.is_some() {
+                let multi_ok = match lang {
+                    Language::C => true,
+                    Language::Auto => detect_language(value) == Language::C,
+                    _ => false,
+                };
+                if !input_files.is_empty() && !multi_ok {
                     return Err(
                         format!("Unexpected extra argument '{}' in '{}'", value, command_name).into(),
                     );
                 }
-                input_file = Some(value.to_string());
+                input_files.push(value.to_string());
                 i += 1;
             }
         }
     }
 
-    let input_file = input_file.ok_or_else(|| {
+    let input_file = input_files.first().cloned().ok_or_else(|| {
         format!("Missing source file for '{}'. Usage: adB {} <file>", command_name, command_name)
     })?;
+    if lang == Language::Auto
+        && input_files.len() > 1
+        && detect_language(&input_file) != Language::C
+    {
+        return Err(format!(
+            "Unexpected extra argument '{}' in '{}'",
+            input_files[1], command_name
+        )
+        .into());
+    }
     let output_file = output_file.unwrap_or_else(|| default_output_filename(&input_file));
+    let pgo = pgo.resolve(&output_file)?;
 
     Ok(CompileRequest {
         input_file,
+        input_files,
         output_file,
         step_mode,
         strict,
+        time_report,
+        trace_json,
+        pgo,
+        tune,
+        lto,
+        delay_load,
+        debug_info,
+        builtin_malloc,
+        pch,
     })
 }
 
@@ -233,14 +455,72 @@ fn detect_language(input_file: &str) -> Language {
     }
 }
 
+/// Lenguaje de un subcomando de compilación (`cc`, `cxx`, `cuda`, `js`)
+fn command_language(command: &str) -> Option<Language> {
+    match command {
+        "cc" | "c" => Some(Language::C),
+        "cxx" | "c++" | "cpp" => Some(Language::Cpp),
+        "cuda" | "cu" => Some(Language::Cuda),
+        "js" | "javascript" => Some(Language::Js),
+        _ => None,
+    }
+}
+
 fn compile_by_language(request: &CompileRequest) -> Result<(), Box<dyn std::error::Error>> {
-    let lang = detect_language(&request.input_file);
+    compile_request(request, detect_language(&request.input_file))
+}
+
+/// Compila con el driver de `lang`; con -ftime-report / --trace-json
+/// registra las fases y las vuelca al terminar (también si falló).
+/// El step mode también registra: muestra el coste de cada fase.
+fn compile_request(request: &CompileRequest, lang: Language) -> Result<(), Box<dyn std::error::Error>> {
+    let timed = request.time_report || request.trace_json.is_some();
+    if timed || request.step_mode {
+        time_report::enable();
+    }
+    let result = compile_with_driver(request, lang);
+    if timed {
+        let spans = time_report::take();
+        if request.time_report {
+            print!("{}", time_report::render_report(&spans));
+        }
+        if let Some(path) = &request.trace_json {
+            time_report::write_chrome_trace(path, &spans)
+                .map_err(|e| format!("Cannot write trace '{}': {}", path, e))?;
+            println!("   Trace written: {} ({} spans)", path, spans.len());
+        }
+    }
+    result
+}
+
+fn compile_with_driver(request: &CompileRequest, lang: Language) -> Result<(), Box<dyn std::error::Error>> {
     match lang {
+        Language::C if request.pch => {
+            for header in &request.input_files {
+                c_driver::precompile_c_header(header)?;
+            }
+        }
         Language::C | Language::Auto => {
-            c_driver::compile_c_file(&request.input_file, &request.output_file, request.step_mode, request.strict)?;
+            let options = c_driver::CCompileOptions {
+                step_mode: request.step_mode,
+                strict: request.strict,
+                pgo: request.pgo.clone(),
+                tune: request.tune,
+                lto: request.lto,
+                delay_load: request.delay_load,
+                debug_info: request.debug_info,
+                builtin_malloc: request.builtin_malloc,
+            };
+            c_driver::compile_c_files(&request.input_files, &request.output_file, &options)?;
         }
         Language::Cpp => {
-            cpp_driver::compile_cpp_file(&request.input_file, &request.output_file, request.step_mode, request.strict)?;
+            cpp_driver::compile_cpp_files(
+                &request.input_files,
+                &request.output_file,
+                request.step_mode,
+                request.strict,
+                request.builtin_malloc,
+            )?;
         }
         Language::Cuda => {
             cuda_driver::compile_cuda_file(&request.input_file, &request.output_file, request.step_mode)?;
@@ -252,13 +532,19 @@ fn compile_by_language(request: &CompileRequest) -> Result<(), Box<dyn std::erro
     Ok(())
 }
 
-fn run_executable(output_file: &str) -> Result<ExitCode, Box<dyn std::error::Error>> {
+fn run_executable(
+    output_file: &str,
+    profile: Option<&profiler::ProfileOptions>,
+) -> Result<ExitCode, Box<dyn std::error::Error>> {
     let exe_path = if cfg!(target_os = "windows") {
         format!(".\\{}", output_file)
     } else {
         format!("./{}", output_file)
     };
-    let status = Command::new(&exe_path).status()?;
+    let status = match profile {
+        Some(options) => profiler::profile_executable(&exe_path, output_file, options)?,
+        None => Command::new(&exe_path).status()?,
+    };
     if status.success() {
         Ok(ExitCode::SUCCESS)
     } else {
@@ -276,7 +562,7 @@ fn print_usage(bin: &str) {
     println!("  {}  {} <file.c|file.cpp>          {}", term::phase_header("SHORT:"), bin, term::dim("(auto-detect)"));
     println!();
     println!("  {}", term::phase_header("COMMANDS (Languages):"));
-    println!("    {}   <file.c>     Compile C source (C99/C11)", term::ok("cc  "));
+    println!("    {}   <file.c>...  Compile C source (C99/C11), multi-file with cached objects", term::ok("cc  "));
     println!("    {}   <file.cpp>   Compile C++ source (C++17/20)", term::ok("cxx "));
     println!("    {}   <file.cu>    Compile CUDA source (preview)", term::info("cuda"));
     println!("    {}   <file.js>    Compile JavaScript (preview)", term::info("js  "));
@@ -284,6 +570,9 @@ fn print_usage(bin: &str) {
     println!("  {}", term::phase_header("COMMANDS (Actions):"));
     println!("    {}   <file>       Compile + run (auto-detect language)", term::ok("run "));
     println!("    {}   <file>       Step mode: show every compiler phase", term::ok("step"));
+    println!("    {}   <file> --profile[=f]  Compile with -g, run sampled: flat profile, hot ops, folded stacks", term::ok("run "));
+    println!("    {}   <exe>        Re-lay out an image from a branch profile (--profile <f>)", term::ok("bolt"));
+    println!("    {}  [-j n]       Compile server keeping headers, PCHs and objects warm", term::ok("serve"));
     println!("    {}               Show compiler version", term::info("version"));
     println!("    {}               Show this help", term::info("help"));
     println!();
@@ -291,12 +580,27 @@ fn print_usage(bin: &str) {
     println!("    {}       Output file (default: <basename>.exe)", term::dim("-o <output>"));
     println!("    {}     Enable step mode (show all phases)", term::dim("-step, --step"));
     println!("    {}          Strict C mode: bit-widths enforced, all UB = error", term::dim("-Wstrict"));
+    println!("    {}     Per-phase wall time, allocations and peak RSS", term::dim("-ftime-report"));
+    println!("    {} Chrome trace of phases and functions", term::dim("--trace-json <f>"));
+    println!("    {} Instrumented build, writes counts at exit (default <basename>.prof)", term::dim("-fprofile-generate[=f]"));
+    println!("    {}  Optimize with counts from an instrumented run", term::dim("-fprofile-use=<f>"));
+    println!("    {}     Schedule for a CPU: skylake, golden-cove, znver3, znver4", term::dim("-mtune=<cpu>"));
+    println!("    {}            Whole-program inlining, constant globals and dead-code stripping", term::dim("-flto"));
+    println!("    {}     Load d3dcompiler/dxgi on first call instead of at startup", term::dim("-fdelay-load"));
+    println!("    {}               Function symbols and line tables (COFF + DWARF) for profilers", term::dim("-g"));
+    println!("    {} Size-class heap for malloc/free and new/delete instead of msvcrt", term::dim("-fbuiltin-malloc"));
+    println!("    {}   Precompile the given C headers to <header>.bib, loaded by later builds", term::dim("--pch <header>"));
+    println!("    {} Compile every source of a list or pattern to its own exe", term::dim("--batch <list|glob>"));
+    println!("    {}  Batch workers, output directory, JSON summary", term::dim("--jobs/--out-dir/--summary"));
+    println!("    {}  Send the build to `adB serve` (ADEB_SERVER, default {})", term::dim("--server[=addr]"), server::DEFAULT_ADDR);
     println!("    {}           C++ is always strict (implicit)", term::dim("(C++ note)"));
     println!();
     println!("  {}", term::phase_header("EXAMPLES:"));
     println!("    {} run hello.c                  {}", bin, term::dim("Compile + run C"));
     println!("    {} run app.cpp                  {}", bin, term::dim("Compile + run C++"));
+    println!("    {} run app.c --profile          {}", bin, term::dim("Where does the time go"));
     println!("    {} cc hello.c -o out.exe        {}", bin, term::dim("Custom output"));
+    println!("    {} cc a.c b.c -o app.exe        {}", bin, term::dim("Multi-file, incremental"));
     println!("    {} cxx app.cpp -step            {}", bin, term::dim("C++ step mode"));
     println!("    {} hello.c                      {}", bin, term::dim("Auto-detect C"));
     println!("    {} app.cpp                      {}", bin, term::dim("Auto-detect C++"));
@@ -397,10 +701,111 @@ mod tests {
         assert!(result.ub_report.has_warnings());
     }
 
+    #[test]
+    fn parse_request_cc_multiple_files() {
+        let args = str_args(&["adB", "cc", "a.c", "b.c", "c.c", "-o", "app.exe"]);
+        let request = parse_request(&args, Language::C).unwrap();
+        assert_eq!(request.input_file, "a.c");
+        assert_eq!(request.input_files, vec!["a.c", "b.c", "c.c"]);
+        assert_eq!(request.output_file, "app.exe");
+    }
+
+    #[test]
+    fn parse_request_cxx_rejects_extra_file() {
+        let args = str_args(&["adB", "cxx", "a.cpp", "b.cpp"]);
+        assert!(parse_request(&args, Language::Cpp).is_err());
+    }
+
     #[test]
     fn parse_request_strict() {
         let args = str_args(&["adB", "cc", "demo.c", "-Wstrict"]);
         let request = parse_request(&args, Language::C).unwrap();
         assert!(request.strict);
     }
+
+    #[test]
+    fn parse_request_time_report_and_trace() {
+        let args = str_args(&["adB", "cc", "demo.c", "-ftime-report", "--trace-json", "t.json"]);
+        let request = parse_request(&args, Language::C).unwrap();
+        assert!(request.time_report);
+        assert_eq!(request.trace_json.as_deref(), Some("t.json"));
+        assert_eq!(request.input_files, vec!["demo.c".to_string()]);
+
+        let args = str_args(&["adB", "cc", "demo.c", "--trace-json"]);
+        assert!(parse_request(&args, Language::C).is_err());
+    }
+
+    #[test]
+    fn parse_request_profile_flags() {
+        let args = str_args(&["adB", "cc", "demo.c", "-o", "app.exe", "-fprofile-generate"]);
+        let request = parse_request(&args, Language::C).unwrap();
+        assert_eq!(request.pgo, c_driver::PgoMode::Generate("app.prof".to_string()));
+
+        let args = str_args(&["adB", "cc", "demo.c", "-fprofile-generate=run.prof"]);
+        let request = parse_request(&args, Language::C).unwrap();
+        assert_eq!(request.pgo, c_driver::PgoMode::Generate("run.prof".to_string()));
+
+        let args = str_args(&["adB", "cc", "demo.c", "-fprofile-use=app.prof"]);
+        let request = parse_request(&args, Language::C).unwrap();
+        assert_eq!(request.pgo, c_driver::PgoMode::Use("app.prof".to_string()));
+
+        let args = str_args(&["adB", "cc", "demo.c", "-fprofile-use=a.prof", "-fprofile-generate"]);
+        assert!(parse_request(&args, Language::C).is_err());
+        let args = str_args(&["adB", "cc", "demo.c", "-fprofile-use="]);
+        assert!(parse_request(&args, Language::C).is_err());
+    }
+
+    #[test]
+    fn parse_request_mtune() {
+        let args = str_args(&["adB", "cc", "demo.c", "-mtune=znver4"]);
+        let request = parse_request(&args, Language::C).unwrap();
+        assert_eq!(request.tune, Some(Uarch::Zen4));
+
+        let args = str_args(&["adB", "cc", "demo.c", "-mtune=skylake-avx512", "-o", "x.exe"]);
+        assert_eq!(parse_request(&args, Language::C).unwrap().tune, Some(Uarch::Skylake));
+
+        let args = str_args(&["adB", "cc", "demo.c"]);
+        assert_eq!(parse_request(&args, Language::C).unwrap().tune, None);
+        let args = str_args(&["adB", "cc", "demo.c", "-mtune=pentium4"]);
+        assert!(parse_request(&args, Language::C).is_err());
+    }
+
+    #[test]
+    fn parse_request_lto() {
+        let args = str_args(&["adB", "cc", "a.c", "b.c", "-flto", "-o", "app.exe"]);
+        let request = parse_request(&args, Language::C).unwrap();
+        assert!(request.lto);
+        assert_eq!(request.input_files, vec!["a.c".to_string(), "b.c".to_string()]);
+        assert!(!parse_request(&str_args(&["adB", "cc", "a.c"]), Language::C).unwrap().lto);
+    }
+
+    #[test]
+    fn parse_request_delay_load() {
+        let args = str_args(&["adB", "cc", "gfx.c", "-fdelay-load"]);
+        assert!(parse_request(&args, Language::C).unwrap().delay_load);
+        assert!(!parse_request(&str_args(&["adB", "cc", "gfx.c"]), Language::C).unwrap().delay_load);
+    }
+
+    #[test]
+    fn parse_request_builtin_malloc() {
+        let args = str_args(&["adB", "cc", "list.c", "-fbuiltin-malloc"]);
+        assert!(parse_request(&args, Language::C).unwrap().builtin_malloc);
+        assert!(!parse_request(&str_args(&["adB", "cc", "list.c"]), Language::C).unwrap().builtin_malloc);
+    }
+
+    #[test]
+    fn parse_request_pch() {
+        let args = str_args(&["adB", "cc", "--pch", "common.h"]);
+        let request = parse_request(&args, Language::C).unwrap();
+        assert!(request.pch);
+        assert_eq!(request.input_files, vec!["common.h".to_string()]);
+        assert!(parse_request(&str_args(&["adB", "cxx", "--pch", "common.hpp"]), Language::Cpp).is_err());
+    }
+
+    #[test]
+    fn parse_request_debug_info() {
+        let args = str_args(&["adB", "cc", "app.c", "-g", "-o", "app.exe"]);
+        assert!(parse_request(&args, Language::C).unwrap().debug_info);
+        assert!(!parse_request(&str_args(&["adB", "cc", "app.c"]), Language::C).unwrap().debug_info);
+    }
 }
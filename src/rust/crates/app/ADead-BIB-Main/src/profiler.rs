@@ -0,0 +1,680 @@
+// ============================================================
+// adB run --profile — sampling profiler
+// ============================================================
+//   adB run app.c --profile[=app.folded] [--profile-hz 1000]
+//
+// Compila con -g, lanza el ejecutable y muestrea el RIP del hijo:
+//
+//   Linux    perf_event_open (cpu-clock, sólo user, hereda hilos),
+//            un evento por CPU como `perf record`: el kernel no deja
+//            mapear un evento heredable con cpu = -1. El PE corre bajo
+//            Wine en su base fija 0x140000000
+//   Windows  SuspendThread + GetThreadContext sobre cada hilo del
+//            proceso a la frecuencia pedida (sin ETW: no necesita
+//            una sesión de kernel ni privilegios de administrador)
+//
+// Las muestras se simbolizan contra la tabla de funciones y líneas
+// que el propio compilador escribió en el PE (pe::read_image_text) y
+// salen en tres formas: perfil plano por función, las instrucciones
+// más calientes decodificadas a ADeadOp y un fichero de pilas
+// plegadas para flamegraph.pl / speedscope. No hay call graph: cada
+// pila es imagen;función;línea.
+// ============================================================
+
+use crate::cli::term;
+use adeb_backend_x64::isa::decoder::Decoder;
+use adeb_backend_x64::pe::{self, ImageText};
+use std::collections::HashMap;
+use std::fmt::Write as _;
+use std::process::ExitStatus;
+
+/// Frecuencia por defecto: la de `perf record`
+pub const DEFAULT_HZ: u32 = 1000;
+
+/// Instrucciones que lista el informe
+const HOT_LIMIT: usize = 20;
+
+#[derive(Debug, Clone, PartialEq)]
+pub struct ProfileOptions {
+    /// Salida de pilas plegadas (por defecto <exe sin extensión>.folded)
+    pub folded: Option<String>,
+    pub hz: u32,
+}
+
+/// Saca `--profile[=file]` y `--profile-hz N` de argv; `None` si no
+/// hay `--profile`
+pub fn take_profile_args(args: &[String]) -> Result<(Option<ProfileOptions>, Vec<String>), String> {
+    let mut options: Option<ProfileOptions> = None;
+    let mut hz = DEFAULT_HZ;
+    let mut rest = Vec::with_capacity(args.len());
+    let mut i = 0;
+    while i < args.len() {
+        let arg = args[i].as_str();
+        if arg == "--profile" {
+            options = Some(ProfileOptions { folded: None, hz: 0 });
+        } else if let Some(path) = arg.strip_prefix("--profile=") {
+            if path.is_empty() {
+                return Err("--profile= needs a file: --profile=app.folded".to_string());
+            }
+            options = Some(ProfileOptions { folded: Some(path.to_string()), hz: 0 });
+        } else if arg == "--profile-hz" {
+            let value = args.get(i + 1).ok_or("Missing value after --profile-hz")?;
+            hz = value
+                .parse::<u32>()
+                .ok()
+                .filter(|&n| (1..=100_000).contains(&n))
+                .ok_or_else(|| format!("Invalid sampling frequency '{}'", value))?;
+            i += 1;
+        } else {
+            rest.push(args[i].clone());
+        }
+        i += 1;
+    }
+    Ok((options.map(|o| ProfileOptions { hz, ..o }), rest))
+}
+
+/// app.exe → app.folded
+pub fn default_folded_path(output_file: &str) -> String {
+    match output_file.rsplit_once('.') {
+        Some((stem, ext)) if !stem.is_empty() && !ext.contains(['/', '\\']) => format!("{}.folded", stem),
+        _ => format!("{}.folded", output_file),
+    }
+}
+
+/// Lanza `exe_path`, lo muestrea hasta que termina e imprime el informe
+pub fn profile_executable(
+    exe_path: &str,
+    output_file: &str,
+    options: &ProfileOptions,
+) -> Result<ExitStatus, Box<dyn std::error::Error>> {
+    let bytes = std::fs::read(output_file).map_err(|e| format!("Cannot read '{}': {}", output_file, e))?;
+    let image = pe::read_image_text(&bytes)?;
+    if image.debug.is_none() {
+        println!("  {} no -g tables in {}: samples are reported by offset", term::warn("Profile:"), output_file);
+    }
+
+    let (status, ips) = sampler::sample(exe_path, options.hz)?;
+    let report = Report::build(&ips, &image);
+    print!("{}", report.render(options.hz));
+
+    let folded = options.folded.clone().unwrap_or_else(|| default_folded_path(output_file));
+    let image_name = std::path::Path::new(output_file)
+        .file_name()
+        .map(|n| n.to_string_lossy().into_owned())
+        .unwrap_or_else(|| output_file.to_string());
+    std::fs::write(&folded, report.folded(&image_name)).map_err(|e| format!("Cannot write '{}': {}", folded, e))?;
+    println!("   {} {}", term::dim("Folded stacks:"), folded);
+    Ok(status)
+}
+
+// ── Informe ─────────────────────────────────────────────────
+
+#[derive(Debug, Clone, PartialEq)]
+struct FunctionRow {
+    name: String,
+    samples: usize,
+    /// file:line con más muestras dentro de la función
+    hottest_line: Option<String>,
+}
+
+#[derive(Debug, Clone, PartialEq)]
+struct HotInsn {
+    offset: u32,
+    samples: usize,
+    function: String,
+    line: Option<String>,
+    op: String,
+}
+
+#[derive(Debug, Clone, Default, PartialEq)]
+struct Report {
+    total: usize,
+    /// Muestras fuera de .text: DLLs, stubs del sistema, el loader
+    external: usize,
+    functions: Vec<FunctionRow>,
+    hot: Vec<HotInsn>,
+    /// (función, línea) → muestras, para las pilas plegadas
+    stacks: Vec<(String, Option<String>, usize)>,
+}
+
+impl Report {
+    fn build(ips: &[u64], image: &ImageText) -> Self {
+        let mut report = Report { total: ips.len(), ..Default::default() };
+        let end = image.text_va + image.code.len() as u64;
+        let mut by_offset: HashMap<u32, usize> = HashMap::new();
+        for &ip in ips {
+            if (image.text_va..end).contains(&ip) {
+                *by_offset.entry((ip - image.text_va) as u32).or_default() += 1;
+            } else {
+                report.external += 1;
+            }
+        }
+
+        let function_of = |offset: u32| match image.debug.as_ref().and_then(|d| d.function_at(offset)) {
+            Some(func) => func.name.clone(),
+            None => "[.text]".to_string(),
+        };
+        let line_of = |offset: u32| {
+            let (file, line) = image.debug.as_ref()?.line_at(offset)?;
+            Some(format!("{}:{}", file, line))
+        };
+
+        let mut functions: HashMap<String, (usize, HashMap<Option<String>, usize>)> = HashMap::new();
+        for (&offset, &count) in &by_offset {
+            let entry = functions.entry(function_of(offset)).or_default();
+            entry.0 += count;
+            *entry.1.entry(line_of(offset)).or_default() += count;
+        }
+        for (name, (samples, lines)) in functions {
+            let hottest_line = lines
+                .iter()
+                .filter(|(line, _)| line.is_some())
+                .max_by(|a, b| a.1.cmp(b.1).then_with(|| b.0.cmp(a.0)))
+                .and_then(|(line, _)| line.clone());
+            for (line, count) in lines {
+                report.stacks.push((name.clone(), line, count));
+            }
+            report.functions.push(FunctionRow { name, samples, hottest_line });
+        }
+        report.functions.sort_by(|a, b| b.samples.cmp(&a.samples).then_with(|| a.name.cmp(&b.name)));
+        report.stacks.sort();
+
+        let mut hot: Vec<(u32, usize)> = by_offset.into_iter().collect();
+        hot.sort_by(|a, b| b.1.cmp(&a.1).then(a.0.cmp(&b.0)));
+        let mut decoder = Decoder::new();
+        for (offset, samples) in hot.into_iter().take(HOT_LIMIT) {
+            let (op, _) = decoder.decode_next(&image.code, offset as usize);
+            report.hot.push(HotInsn {
+                offset,
+                samples,
+                function: function_of(offset),
+                line: line_of(offset),
+                op: op.to_string(),
+            });
+        }
+        report
+    }
+
+    fn render(&self, hz: u32) -> String {
+        let mut out = String::new();
+        let pct = |n: usize| if self.total == 0 { 0.0 } else { n as f64 * 100.0 / self.total as f64 };
+        let _ = writeln!(
+            out,
+            "  {} {} samples at {} Hz ({} outside .text)",
+            term::phase_header("Profile:"),
+            self.total,
+            hz,
+            self.external
+        );
+        if self.total == self.external {
+            let _ = writeln!(out, "   {}", term::dim("no samples in the program's code"));
+            return out;
+        }
+        let _ = writeln!(out, "   {:>8} {:>7}  {:<28} {}", "samples", "%", "function", "hottest line");
+        for row in &self.functions {
+            let _ = writeln!(
+                out,
+                "   {:>8} {:>6.1}%  {:<28} {}",
+                row.samples,
+                pct(row.samples),
+                row.name,
+                row.hottest_line.as_deref().unwrap_or("-")
+            );
+        }
+        let _ = writeln!(out, "  {}", term::phase_header("Hot instructions:"));
+        let _ = writeln!(out, "   {:>8} {:>7}  {:<8} {:<20} {:<16} {}", "samples", "%", "offset", "function", "line", "op");
+        for insn in &self.hot {
+            let _ = writeln!(
+                out,
+                "   {:>8} {:>6.1}%  {:<8} {:<20} {:<16} {}",
+                insn.samples,
+                pct(insn.samples),
+                format!("{:#06x}", insn.offset),
+                insn.function,
+                insn.line.as_deref().unwrap_or("-"),
+                insn.op
+            );
+        }
+        out
+    }
+
+    /// Una línea `imagen;función;línea muestras` por pila
+    fn folded(&self, image_name: &str) -> String {
+        let mut out = String::new();
+        for (function, line, count) in &self.stacks {
+            match line {
+                Some(line) => {
+                    let _ = writeln!(out, "{};{};{} {}", image_name, function, line, count);
+                }
+                None => {
+                    let _ = writeln!(out, "{};{} {}", image_name, function, count);
+                }
+            }
+        }
+        if self.external > 0 {
+            let _ = writeln!(out, "{};[external] {}", image_name, self.external);
+        }
+        out
+    }
+}
+
+// ── Muestreo ────────────────────────────────────────────────
+
+#[cfg(all(target_os = "linux", target_arch = "x86_64"))]
+mod sampler {
+    use std::process::{Command, ExitStatus};
+    use std::sync::atomic::{fence, Ordering};
+    use std::time::Duration;
+
+    const SYS_PERF_EVENT_OPEN: i64 = 298;
+    const PERF_TYPE_SOFTWARE: u32 = 1;
+    const PERF_COUNT_SW_CPU_CLOCK: u64 = 0;
+    const PERF_SAMPLE_IP: u64 = 1;
+    const PERF_RECORD_SAMPLE: u32 = 9;
+    const PERF_FLAG_FD_CLOEXEC: u64 = 8;
+    // Bits de perf_event_attr.flags
+    const INHERIT: u64 = 1 << 1;
+    const EXCLUDE_KERNEL: u64 = 1 << 5;
+    const EXCLUDE_HV: u64 = 1 << 6;
+    const FREQ: u64 = 1 << 10;
+
+    /// Páginas de datos del ring buffer (potencia de dos)
+    const RING_PAGES: usize = 64;
+
+    /// perf_event_attr hasta PERF_ATTR_SIZE_VER5 (112 bytes)
+    #[repr(C)]
+    #[derive(Default)]
+    struct PerfEventAttr {
+        kind: u32,
+        size: u32,
+        config: u64,
+        sample_freq: u64,
+        sample_type: u64,
+        read_format: u64,
+        flags: u64,
+        wakeup_events: u32,
+        bp_type: u32,
+        config1: u64,
+        config2: u64,
+        branch_sample_type: u64,
+        sample_regs_user: u64,
+        sample_stack_user: u32,
+        clockid: i32,
+        sample_regs_intr: u64,
+        aux_watermark: u32,
+        sample_max_stack: u16,
+        reserved: u16,
+    }
+
+    extern "C" {
+        fn syscall(num: i64, ...) -> i64;
+        fn mmap(addr: *mut u8, len: usize, prot: i32, flags: i32, fd: i32, offset: i64) -> *mut u8;
+        fn munmap(addr: *mut u8, len: usize) -> i32;
+        fn close(fd: i32) -> i32;
+        fn sysconf(name: i32) -> i64;
+    }
+
+    const PROT_READ_WRITE: i32 = 0x3;
+    const MAP_SHARED: i32 = 0x1;
+    const SC_PAGESIZE: i32 = 30;
+    const SC_NPROCESSORS_CONF: i32 = 83;
+
+    struct Ring {
+        fd: i32,
+        base: *mut u8,
+        page: usize,
+        len: usize,
+    }
+
+    impl Ring {
+        fn open(pid: u32, cpu: i32, hz: u32) -> std::io::Result<Self> {
+            let attr = PerfEventAttr {
+                kind: PERF_TYPE_SOFTWARE,
+                size: std::mem::size_of::<PerfEventAttr>() as u32,
+                config: PERF_COUNT_SW_CPU_CLOCK,
+                sample_freq: hz as u64,
+                sample_type: PERF_SAMPLE_IP,
+                flags: INHERIT | EXCLUDE_KERNEL | EXCLUDE_HV | FREQ,
+                ..Default::default()
+            };
+            // SAFETY: attr vive durante la llamada; el resto son enteros
+            let fd = unsafe {
+                syscall(SYS_PERF_EVENT_OPEN, &attr as *const PerfEventAttr, pid as i64, cpu as i64, -1i64, PERF_FLAG_FD_CLOEXEC)
+            };
+            if fd < 0 {
+                return Err(std::io::Error::last_os_error());
+            }
+            let fd = fd as i32;
+            // SAFETY: sysconf no tiene precondiciones
+            let page = unsafe { sysconf(SC_PAGESIZE) }.max(4096) as usize;
+            let len = page * (1 + RING_PAGES);
+            // El ring que el kernel llena con las muestras (no memoria
+            // ejecutable): página de metadatos + páginas de datos
+            // SAFETY: fd es un perf_event recién abierto; len = 1 + 2^n páginas
+            let base = unsafe { mmap(std::ptr::null_mut(), len, PROT_READ_WRITE, MAP_SHARED, fd, 0) };
+            if base as isize == -1 {
+                let err = std::io::Error::last_os_error();
+                // SAFETY: fd es nuestro y no se usa después
+                unsafe { close(fd) };
+                return Err(err);
+            }
+            Ok(Ring { fd, base, page, len })
+        }
+
+        /// Consume los registros pendientes (data_head/data_tail en la
+        /// página de metadatos, offsets 1024 y 1032)
+        fn drain(&mut self, ips: &mut Vec<u64>) {
+            // SAFETY: base apunta a un mapping de `len` bytes vivo hasta Drop
+            unsafe {
+                let head_ptr = self.base.add(1024) as *const u64;
+                let tail_ptr = self.base.add(1032) as *mut u64;
+                let head = std::ptr::read_volatile(head_ptr);
+                fence(Ordering::Acquire);
+                let tail = std::ptr::read_volatile(tail_ptr);
+                // El kernel no escribe en [tail, head) hasta que avance data_tail
+                let data = std::slice::from_raw_parts(self.base.add(self.page), self.len - self.page);
+                read_samples(data, tail, head, ips);
+                fence(Ordering::Release);
+                std::ptr::write_volatile(tail_ptr, head);
+            }
+        }
+    }
+
+    /// IPs de los PERF_RECORD_SAMPLE entre `tail` y `head` (posiciones
+    /// absolutas; un registro puede dar la vuelta al final de `data`)
+    pub(super) fn read_samples(data: &[u8], mut tail: u64, head: u64, ips: &mut Vec<u64>) {
+        let size = data.len() as u64;
+        let byte = |at: u64| data[(at % size) as usize];
+        let read = |at: u64, n: u64| (0..n).rev().fold(0u64, |v, i| v << 8 | byte(at + i) as u64);
+        while tail < head {
+            let kind = read(tail, 4) as u32;
+            let len = read(tail + 6, 2);
+            if len == 0 {
+                break;
+            }
+            if kind == PERF_RECORD_SAMPLE {
+                ips.push(read(tail + 8, 8));
+            }
+            tail += len;
+        }
+    }
+
+    impl Drop for Ring {
+        fn drop(&mut self) {
+            // SAFETY: mapping y fd abiertos en `open`, liberados una vez
+            unsafe {
+                munmap(self.base, self.len);
+                close(self.fd);
+            }
+        }
+    }
+
+    pub fn sample(exe_path: &str, hz: u32) -> Result<(ExitStatus, Vec<u64>), Box<dyn std::error::Error>> {
+        let mut child = Command::new(exe_path).spawn()?;
+        // SAFETY: sysconf no tiene precondiciones
+        let cpus = unsafe { sysconf(SC_NPROCESSORS_CONF) }.max(1) as i32;
+        let mut rings = Vec::new();
+        let mut last_error = None;
+        // CPUs offline o fuera del cgroup fallan sueltas; basta con una
+        for cpu in 0..cpus {
+            match Ring::open(child.id(), cpu, hz) {
+                Ok(ring) => rings.push(ring),
+                Err(e) => last_error = Some(e),
+            }
+        }
+        if rings.is_empty() {
+            let _ = child.kill();
+            let _ = child.wait();
+            let e = last_error.map(|e| e.to_string()).unwrap_or_default();
+            return Err(format!("perf_event_open failed: {} (check kernel.perf_event_paranoid)", e).into());
+        }
+        let mut ips = Vec::new();
+        loop {
+            rings.iter_mut().for_each(|ring| ring.drain(&mut ips));
+            if let Some(status) = child.try_wait()? {
+                rings.iter_mut().for_each(|ring| ring.drain(&mut ips));
+                return Ok((status, ips));
+            }
+            std::thread::sleep(Duration::from_millis(10));
+        }
+    }
+}
+
+#[cfg(windows)]
+mod sampler {
+    use std::collections::HashMap;
+    use std::process::{Command, ExitStatus};
+    use std::time::{Duration, Instant};
+
+    const TH32CS_SNAPTHREAD: u32 = 0x4;
+    const THREAD_SUSPEND_RESUME: u32 = 0x2;
+    const THREAD_GET_CONTEXT: u32 = 0x8;
+    const CONTEXT_CONTROL: u32 = 0x0010_0001;
+    /// Offsets de ContextFlags y Rip en CONTEXT (x64)
+    const CONTEXT_FLAGS_AT: usize = 0x30;
+    const RIP_AT: usize = 0xF8;
+    /// La lista de hilos se refresca cada tantos ticks
+    const THREAD_REFRESH: u32 = 64;
+
+    #[repr(C)]
+    struct ThreadEntry32 {
+        size: u32,
+        usage: u32,
+        thread_id: u32,
+        owner_process_id: u32,
+        base_priority: i32,
+        delta_priority: i32,
+        flags: u32,
+    }
+
+    #[repr(C, align(16))]
+    struct Context([u8; 1232]);
+
+    #[link(name = "kernel32")]
+    extern "system" {
+        fn CreateToolhelp32Snapshot(flags: u32, pid: u32) -> isize;
+        fn Thread32First(snapshot: isize, entry: *mut ThreadEntry32) -> i32;
+        fn Thread32Next(snapshot: isize, entry: *mut ThreadEntry32) -> i32;
+        fn OpenThread(access: u32, inherit: i32, thread_id: u32) -> isize;
+        fn SuspendThread(thread: isize) -> u32;
+        fn ResumeThread(thread: isize) -> u32;
+        fn GetThreadContext(thread: isize, context: *mut Context) -> i32;
+        fn CloseHandle(handle: isize) -> i32;
+    }
+
+    #[link(name = "winmm")]
+    extern "system" {
+        fn timeBeginPeriod(period: u32) -> u32;
+        fn timeEndPeriod(period: u32) -> u32;
+    }
+
+    /// Abre los hilos de `pid` que aún no están en `threads`
+    fn refresh_threads(pid: u32, threads: &mut HashMap<u32, isize>) {
+        // SAFETY: snapshot y entry son locales; los handles se guardan
+        // en `threads` y se cierran al terminar
+        unsafe {
+            let snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+            if snapshot == -1 {
+                return;
+            }
+            let mut entry: ThreadEntry32 = std::mem::zeroed();
+            entry.size = std::mem::size_of::<ThreadEntry32>() as u32;
+            let mut ok = Thread32First(snapshot, &mut entry);
+            while ok != 0 {
+                if entry.owner_process_id == pid && !threads.contains_key(&entry.thread_id) {
+                    let handle = OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT, 0, entry.thread_id);
+                    if handle != 0 {
+                        threads.insert(entry.thread_id, handle);
+                    }
+                }
+                ok = Thread32Next(snapshot, &mut entry);
+            }
+            CloseHandle(snapshot);
+        }
+    }
+
+    fn thread_rip(thread: isize) -> Option<u64> {
+        let mut context = Context([0; 1232]);
+        context.0[CONTEXT_FLAGS_AT..CONTEXT_FLAGS_AT + 4].copy_from_slice(&CONTEXT_CONTROL.to_le_bytes());
+        // SAFETY: thread tiene THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT;
+        // context está alineado a 16 como exige GetThreadContext
+        unsafe {
+            if SuspendThread(thread) == u32::MAX {
+                return None;
+            }
+            let ok = GetThreadContext(thread, &mut context);
+            ResumeThread(thread);
+            if ok == 0 {
+                return None;
+            }
+        }
+        Some(u64::from_le_bytes(context.0[RIP_AT..RIP_AT + 8].try_into().unwrap()))
+    }
+
+    pub fn sample(exe_path: &str, hz: u32) -> Result<(ExitStatus, Vec<u64>), Box<dyn std::error::Error>> {
+        let period = Duration::from_secs(1) / hz;
+        // SAFETY: sólo cambia la resolución del timer del sistema
+        unsafe { timeBeginPeriod(1) };
+        let mut child = Command::new(exe_path).spawn()?;
+        let pid = child.id();
+        let mut threads = HashMap::new();
+        let mut ips = Vec::new();
+        let mut tick = 0u32;
+        let mut next = Instant::now();
+        let status = loop {
+            if tick % THREAD_REFRESH == 0 {
+                refresh_threads(pid, &mut threads);
+            }
+            tick = tick.wrapping_add(1);
+            ips.extend(threads.values().filter_map(|&thread| thread_rip(thread)));
+            if let Some(status) = child.try_wait()? {
+                break status;
+            }
+            next += period;
+            let now = Instant::now();
+            if next > now {
+                std::thread::sleep(next - now);
+            } else {
+                next = now;
+            }
+        };
+        // SAFETY: handles abiertos en refresh_threads, cerrados una vez
+        unsafe {
+            for handle in threads.into_values() {
+                CloseHandle(handle);
+            }
+            timeEndPeriod(1);
+        }
+        Ok((status, ips))
+    }
+}
+
+#[cfg(not(any(windows, all(target_os = "linux", target_arch = "x86_64"))))]
+mod sampler {
+    use std::process::ExitStatus;
+
+    pub fn sample(_exe_path: &str, _hz: u32) -> Result<(ExitStatus, Vec<u64>), Box<dyn std::error::Error>> {
+        Err("--profile needs Windows or x86-64 Linux".into())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use adeb_backend_x64::isa::debug_info::DebugInfo;
+
+    fn str_args(values: &[&str]) -> Vec<String> {
+        values.iter().map(|value| value.to_string()).collect()
+    }
+
+    const TEXT_VA: u64 = 0x1_4000_1000;
+
+    fn image() -> ImageText {
+        // hot:  0x00 mov rax, rcx / 0x03 ret   main: 0x10 xor eax, eax / 0x12 ret
+        let mut code = vec![0x48, 0x89, 0xC8, 0xC3];
+        code.resize(0x10, 0xCC);
+        code.extend_from_slice(&[0x31, 0xC0, 0xC3]);
+        let debug = DebugInfo::build(
+            vec![("hot".into(), "app.c".into(), 0), ("main".into(), "app.c".into(), 0x10)],
+            &[(0, 4), (0x03, 5), (0x10, 9)],
+            code.len(),
+        );
+        ImageText { text_va: TEXT_VA, code, debug: Some(debug) }
+    }
+
+    #[test]
+    fn profile_flags_are_taken_out() {
+        let args = str_args(&["adB", "run", "app.c", "--profile", "--profile-hz", "250", "-o", "a.exe"]);
+        let (options, rest) = take_profile_args(&args).unwrap();
+        assert_eq!(options, Some(ProfileOptions { folded: None, hz: 250 }));
+        assert_eq!(rest, str_args(&["adB", "run", "app.c", "-o", "a.exe"]));
+
+        let (options, _) = take_profile_args(&str_args(&["adB", "run", "app.c", "--profile=hot.folded"])).unwrap();
+        assert_eq!(options, Some(ProfileOptions { folded: Some("hot.folded".into()), hz: DEFAULT_HZ }));
+        assert_eq!(take_profile_args(&str_args(&["adB", "run", "app.c"])).unwrap().0, None);
+        assert!(take_profile_args(&str_args(&["adB", "run", "app.c", "--profile-hz", "0"])).is_err());
+        assert!(take_profile_args(&str_args(&["adB", "run", "app.c", "--profile="])).is_err());
+        assert_eq!(default_folded_path("build/app.exe"), "build/app.folded");
+    }
+
+    #[test]
+    fn report_symbolizes_samples() {
+        let ips = [TEXT_VA, TEXT_VA, TEXT_VA, TEXT_VA + 3, TEXT_VA + 0x10, 0x7FF8_0000_0000];
+        let report = Report::build(&ips, &image());
+        assert_eq!((report.total, report.external), (6, 1));
+        assert_eq!(
+            report.functions[0],
+            FunctionRow { name: "hot".into(), samples: 4, hottest_line: Some("app.c:4".into()) }
+        );
+        assert_eq!(report.functions[1].name, "main");
+        assert_eq!(report.hot[0].offset, 0);
+        assert_eq!(report.hot[0].samples, 3);
+        assert_eq!(report.hot[0].op, "mov rax, rcx");
+        assert_eq!(report.hot[1].line.as_deref(), Some("app.c:5"));
+        assert!(report.render(DEFAULT_HZ).contains("mov rax, rcx"));
+    }
+
+    #[test]
+    fn folded_stacks_have_one_line_per_source_line() {
+        let ips = [TEXT_VA, TEXT_VA + 1, TEXT_VA + 3, TEXT_VA + 0x11, 0x10];
+        let folded = Report::build(&ips, &image()).folded("app.exe");
+        assert_eq!(
+            folded,
+            "app.exe;hot;app.c:4 2\napp.exe;hot;app.c:5 1\napp.exe;main;app.c:9 1\napp.exe;[external] 1\n"
+        );
+    }
+
+    #[test]
+    fn samples_without_tables_fall_back_to_offsets() {
+        let mut image = image();
+        image.debug = None;
+        let report = Report::build(&[TEXT_VA + 0x10], &image);
+        assert_eq!(report.functions[0].name, "[.text]");
+        assert_eq!(report.hot[0].op, "xor eax, eax");
+        assert_eq!(report.folded("a.exe"), "a.exe;[.text] 1\n");
+    }
+
+    #[cfg(all(target_os = "linux", target_arch = "x86_64"))]
+    #[test]
+    fn ring_records_are_read_across_the_wrap() {
+        fn record(data: &mut [u8], at: usize, kind: u32, size: u16, ip: u64) {
+            let bytes = [&kind.to_le_bytes()[..], &0u16.to_le_bytes(), &size.to_le_bytes(), &ip.to_le_bytes()].concat();
+            for (i, b) in bytes.iter().enumerate() {
+                let n = data.len();
+                data[(at + i) % n] = *b;
+            }
+        }
+        // Consumido hasta 16: un PERF_RECORD_LOST de 24 bytes, una muestra
+        // y otra muestra partida entre el final y el principio del ring
+        let mut data = [0u8; 64];
+        record(&mut data, 16, 2, 24, 7);
+        record(&mut data, 40, 9, 16, 0x2222);
+        record(&mut data, 56, 9, 16, 0x3333);
+        let mut ips = Vec::new();
+        sampler::read_samples(&data, 16, 72, &mut ips);
+        assert_eq!(ips, [0x2222, 0x3333]);
+        // Un registro de tamaño 0 corta la lectura
+        sampler::read_samples(&[0u8; 64], 0, 64, &mut ips);
+        assert_eq!(ips.len(), 2);
+    }
+}
@@ -0,0 +1,293 @@
+// ============================================================
+// adB serve — compile server
+// ============================================================
+//   adB serve [--listen 127.0.0.1:7807] [-j N]
+//   adB cc --server[=addr] a.c -o a.exe      (reenvía al servidor)
+//
+// Un proceso largo que conserva calientes, entre builds, los headers
+// built-in ya parseados (fastos.bib en memoria), las imágenes --pch y
+// los objetos por TU. Cada cliente abre una conexión TCP local y manda
+// una línea JSON {cwd, cache_dir, args}; el servidor responde otra
+// {ok, error, millis}. Un pool fijo de `-j` workers compila en paralelo
+// y la cola de conexiones pendientes está acotada al mismo número.
+//
+// Las rutas relativas del request se resuelven contra el cwd del
+// cliente. Lo que imprimen los drivers sale en la consola del servidor;
+// el cliente recibe el resultado y el error, si lo hubo.
+// ============================================================
+
+use crate::driver::c_driver::PgoMode;
+use crate::{command_language, compile_request, compile_with_driver, parse_request, CompileRequest};
+use adeb_core::cache::objects::{self, ObjectCache};
+use serde::{Deserialize, Serialize};
+use std::io::{BufRead, BufReader, Write};
+use std::net::{TcpListener, TcpStream};
+use std::path::Path;
+use std::process::ExitCode;
+use std::sync::mpsc;
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
+
+/// Dirección por defecto (sólo loopback); `ADEB_SERVER` la cambia
+pub const DEFAULT_ADDR: &str = "127.0.0.1:7807";
+
+/// Un cliente que no manda su request en este tiempo libera al worker
+const READ_TIMEOUT: Duration = Duration::from_secs(30);
+
+#[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
+struct ServeRequest {
+    /// cwd del cliente: base de las rutas relativas
+    cwd: String,
+    /// Cache de objetos del cliente (`ADEB_CACHE_DIR` o `<cwd>/.adB-cache`)
+    cache_dir: String,
+    /// argv completo del cliente, sin `--server`
+    args: Vec<String>,
+}
+
+#[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
+struct ServeReply {
+    ok: bool,
+    error: Option<String>,
+    millis: u64,
+}
+
+fn default_addr() -> String {
+    match std::env::var("ADEB_SERVER") {
+        Ok(addr) if !addr.is_empty() => addr,
+        _ => DEFAULT_ADDR.to_string(),
+    }
+}
+
+// ── Servidor ────────────────────────────────────────────────
+
+/// `adB serve [--listen <addr>] [-j <n>]`
+pub fn parse_serve_args(args: &[String]) -> Result<(String, usize), String> {
+    let mut addr = default_addr();
+    let mut jobs = adeb_core::parallel::default_jobs();
+    let mut i = 2;
+    while i < args.len() {
+        let value = args.get(i + 1);
+        match (args[i].as_str(), value) {
+            ("--listen", Some(v)) => addr = v.clone(),
+            ("-j", Some(v)) => {
+                jobs = v
+                    .parse::<usize>()
+                    .ok()
+                    .filter(|&n| n > 0)
+                    .ok_or_else(|| format!("Invalid worker count '{}' in 'serve'", v))?
+            }
+            ("--listen" | "-j", None) => return Err(format!("Missing value after {} in 'serve'", args[i])),
+            (other, _) => return Err(format!("Unknown option '{}' in 'serve'", other)),
+        }
+        i += 2;
+    }
+    Ok((addr, jobs))
+}
+
+/// Atiende requests hasta que el proceso termina
+pub fn serve(addr: &str, jobs: usize) -> Result<(), Box<dyn std::error::Error>> {
+    let listener = TcpListener::bind(addr).map_err(|e| format!("Cannot listen on {}: {}", addr, e))?;
+    println!("   adB server listening on {} ({} workers)", listener.local_addr()?, jobs);
+    run(listener, jobs)
+}
+
+fn run(listener: TcpListener, jobs: usize) -> Result<(), Box<dyn std::error::Error>> {
+    objects::keep_resident();
+    let (queue, pending) = mpsc::sync_channel::<TcpStream>(jobs);
+    let pending = Arc::new(Mutex::new(pending));
+    for n in 0..jobs {
+        let pending = pending.clone();
+        std::thread::Builder::new().name(format!("adB-worker-{}", n)).spawn(move || loop {
+            let stream = match pending.lock().unwrap().recv() {
+                Ok(stream) => stream,
+                Err(_) => break,
+            };
+            if let Err(e) = handle(stream) {
+                eprintln!("   adB server: {}", e);
+            }
+        })?;
+    }
+    for stream in listener.incoming() {
+        match stream {
+            Ok(stream) => queue.send(stream)?,
+            Err(e) => eprintln!("   adB server: accept failed: {}", e),
+        }
+    }
+    Ok(())
+}
+
+fn handle(stream: TcpStream) -> std::io::Result<()> {
+    stream.set_read_timeout(Some(READ_TIMEOUT))?;
+    let mut line = String::new();
+    BufReader::new(&stream).read_line(&mut line)?;
+    let start = Instant::now();
+    let result = match serde_json::from_str::<ServeRequest>(&line) {
+        Ok(request) => {
+            // Un panic del compilador falla este request, no al worker
+            std::panic::catch_unwind(|| execute(&request).map_err(|e| e.to_string()))
+                .unwrap_or_else(|_| Err("internal compiler error (panic)".to_string()))
+        }
+        Err(e) => Err(format!("Malformed request: {}", e)),
+    };
+    let reply = ServeReply {
+        ok: result.is_ok(),
+        error: result.err(),
+        millis: start.elapsed().as_millis() as u64,
+    };
+    let mut stream = stream;
+    writeln!(stream, "{}", serde_json::to_string(&reply)?)?;
+    stream.flush()
+}
+
+fn execute(request: &ServeRequest) -> Result<(), Box<dyn std::error::Error>> {
+    let command = request.args.get(1).map(String::as_str).unwrap_or_default();
+    let lang = command_language(command)
+        .ok_or_else(|| format!("'{}' cannot be compiled through the server", command))?;
+    let mut compile = parse_request(&request.args, lang)?;
+    if compile.time_report || compile.trace_json.is_some() {
+        // Las spans son globales al proceso: se mezclarían entre requests
+        return Err("-ftime-report and --trace-json are not available through --server".into());
+    }
+    rebase(&mut compile, Path::new(&request.cwd));
+    println!("   [{}] {}", request.cwd, request.args[1..].join(" "));
+    objects::with_dir(&request.cache_dir, || compile_with_driver(&compile, lang))
+}
+
+/// Rutas del request relativas al cwd del cliente
+fn rebase(request: &mut CompileRequest, cwd: &Path) {
+    let at = |path: &mut String| {
+        if Path::new(path.as_str()).is_relative() {
+            *path = cwd.join(path.as_str()).to_string_lossy().into_owned();
+        }
+    };
+    at(&mut request.input_file);
+    for input in &mut request.input_files {
+        at(input);
+    }
+    at(&mut request.output_file);
+    match &mut request.pgo {
+        PgoMode::Generate(path) | PgoMode::Use(path) => at(path),
+        PgoMode::Off => {}
+    }
+}
+
+// ── Cliente ─────────────────────────────────────────────────
+
+/// argv sin `--server[=addr]` y la dirección, si el flag estaba
+pub fn take_server_flag(args: &[String]) -> Option<(String, Vec<String>)> {
+    let pos = args.iter().position(|a| a == "--server" || a.starts_with("--server="))?;
+    let addr = match args[pos].strip_prefix("--server=") {
+        Some(addr) if !addr.is_empty() => addr.to_string(),
+        _ => default_addr(),
+    };
+    let mut rest = args.to_vec();
+    rest.remove(pos);
+    Some((addr, rest))
+}
+
+/// Manda el build al servidor de `addr`. Sin servidor escuchando compila
+/// en este proceso, para que un `--server` en los scripts nunca rompa.
+pub fn forward(addr: &str, args: &[String]) -> Result<ExitCode, Box<dyn std::error::Error>> {
+    let command = args.get(1).map(String::as_str).unwrap_or_default();
+    let lang = command_language(command)
+        .ok_or_else(|| format!("--server only forwards compile commands, not '{}'", command))?;
+    let cwd = std::env::current_dir()?;
+    let request = ServeRequest {
+        cwd: cwd.to_string_lossy().into_owned(),
+        cache_dir: cwd.join(ObjectCache::from_env().dir()).to_string_lossy().into_owned(),
+        args: args.to_vec(),
+    };
+    let reply = match send(addr, &request) {
+        Ok(reply) => reply,
+        Err(e) => {
+            println!("   No adB server at {} ({}), compiling locally", addr, e);
+            compile_request(&parse_request(args, lang)?, lang)?;
+            return Ok(ExitCode::SUCCESS);
+        }
+    };
+    match reply.error {
+        None if reply.ok => {
+            println!("   Compiled by server {} in {} ms", addr, reply.millis);
+            Ok(ExitCode::SUCCESS)
+        }
+        error => Err(error.unwrap_or_else(|| "server build failed".to_string()).into()),
+    }
+}
+
+fn send(addr: &str, request: &ServeRequest) -> std::io::Result<ServeReply> {
+    let mut stream = TcpStream::connect(addr)?;
+    writeln!(stream, "{}", serde_json::to_string(request)?)?;
+    stream.flush()?;
+    let mut line = String::new();
+    BufReader::new(&stream).read_line(&mut line)?;
+    serde_json::from_str(&line).map_err(|e| std::io::Error::new(std::io::ErrorKind::InvalidData, e))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn str_args(values: &[&str]) -> Vec<String> {
+        values.iter().map(|value| value.to_string()).collect()
+    }
+
+    #[test]
+    fn server_flag_is_stripped() {
+        let (addr, rest) = take_server_flag(&str_args(&["adB", "cc", "--server=127.0.0.1:9000", "a.c"])).unwrap();
+        assert_eq!(addr, "127.0.0.1:9000");
+        assert_eq!(rest, str_args(&["adB", "cc", "a.c"]));
+        assert!(take_server_flag(&str_args(&["adB", "cc", "a.c"])).is_none());
+    }
+
+    #[test]
+    fn serve_args() {
+        let (addr, jobs) = parse_serve_args(&str_args(&["adB", "serve", "--listen", "127.0.0.1:0", "-j", "3"])).unwrap();
+        assert_eq!((addr.as_str(), jobs), ("127.0.0.1:0", 3));
+        assert!(parse_serve_args(&str_args(&["adB", "serve", "-j", "0"])).is_err());
+        assert!(parse_serve_args(&str_args(&["adB", "serve", "--listen"])).is_err());
+    }
+
+    #[test]
+    fn relative_paths_follow_the_client() {
+        let args = str_args(&["adB", "cc", "src/a.c", "/abs/b.c", "-o", "out/app.exe", "-fprofile-use=app.prof"]);
+        let mut request = parse_request(&args, crate::Language::C).unwrap();
+        rebase(&mut request, Path::new("/work"));
+        assert_eq!(request.input_file, Path::new("/work").join("src/a.c").to_string_lossy());
+        assert_eq!(request.input_files[1], "/abs/b.c");
+        assert_eq!(request.output_file, Path::new("/work").join("out/app.exe").to_string_lossy());
+        assert_eq!(request.pgo, PgoMode::Use(Path::new("/work").join("app.prof").to_string_lossy().into_owned()));
+    }
+
+    #[test]
+    fn concurrent_requests_compile() {
+        let dir = std::env::temp_dir().join(format!("adeb_serve_{}", std::process::id()));
+        std::fs::create_dir_all(&dir).unwrap();
+        std::fs::write(dir.join("ok.c"), "int main() { return 0; }\n").unwrap();
+        let listener = TcpListener::bind("127.0.0.1:0").unwrap();
+        let addr = listener.local_addr().unwrap().to_string();
+        std::thread::spawn(move || run(listener, 2).map_err(|e| e.to_string()));
+
+        let request = |args: &[&str]| ServeRequest {
+            cwd: dir.to_string_lossy().into_owned(),
+            cache_dir: dir.join("cache").to_string_lossy().into_owned(),
+            args: str_args(args),
+        };
+        let clients: Vec<_> = (0..4)
+            .map(|n| {
+                let (addr, request) = (addr.clone(), request(&["adB", "cc", "ok.c", "-o", &format!("ok{}.exe", n)]));
+                std::thread::spawn(move || send(&addr, &request).unwrap())
+            })
+            .collect();
+        for (n, client) in clients.into_iter().enumerate() {
+            let reply = client.join().unwrap();
+            assert!(reply.ok, "{:?}", reply.error);
+            assert!(dir.join(format!("ok{}.exe", n)).exists());
+        }
+
+        let reply = send(&addr, &request(&["adB", "cc", "missing.c"])).unwrap();
+        assert!(!reply.ok && reply.error.is_some());
+        let reply = send(&addr, &request(&["adB", "cc", "ok.c", "-ftime-report"])).unwrap();
+        assert!(!reply.ok);
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
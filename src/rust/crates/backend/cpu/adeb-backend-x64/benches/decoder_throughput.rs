@@ -0,0 +1,116 @@
+// ============================================================
+// adB bench — throughput del decoder x86-64
+// ============================================================
+//   cargo bench -p adeb-backend-x64 --bench decoder_throughput
+//   cargo bench ... -- [--mb N] [--iters N]
+//
+// Compara, sobre el mismo buffer, los tres caminos de decodificación:
+//
+//   decode_all   Decoder por patrones + fallback de tablas (BinaryRebuilder)
+//   length       decode_table::sweep, solo longitudes (barrido de BG)
+//   fields       decode_table::decode, prefijos/ModRM/SIB/disp/imm
+//
+// El buffer mezcla código emitido por el Encoder (lo que el rebuilder
+// ve en binarios propios) con SSE/VEX/EVEX crudos que los patrones no
+// cubren. Reporta la mediana en MB/s e instrucciones/s.
+// ============================================================
+
+use adeb_backend_x64::isa::decode_table;
+use adeb_backend_x64::isa::decoder::Decoder;
+use adeb_backend_x64::isa::encoder::Encoder;
+use adeb_backend_x64::isa::{ADeadOp, CallTarget, Operand, Reg};
+use std::hint::black_box;
+use std::time::Instant;
+
+fn encoded_block() -> Vec<u8> {
+    let ops = vec![
+        ADeadOp::Push { src: Operand::Reg(Reg::RBP) },
+        ADeadOp::Mov { dst: Operand::Reg(Reg::RBP), src: Operand::Reg(Reg::RSP) },
+        ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm32(0x40) },
+        ADeadOp::Mov { dst: Operand::Reg(Reg::RAX), src: Operand::Imm64(0x1122_3344_5566_7788) },
+        ADeadOp::Xor { dst: Reg::EAX, src: Reg::EAX },
+        ADeadOp::Call { target: CallTarget::RipRelative(0x100) },
+        ADeadOp::Mov { dst: Operand::Reg(Reg::RSP), src: Operand::Reg(Reg::RBP) },
+        ADeadOp::Pop { dst: Reg::RBP },
+        ADeadOp::Ret,
+    ];
+    Encoder::new().encode_all(&ops).code
+}
+
+// Instrucciones fuera de los patrones del Decoder
+const RAW: &[u8] = &[
+    0xF2, 0x0F, 0x10, 0x45, 0xF8, // movsd xmm0, [rbp-8]
+    0x66, 0x0F, 0xEF, 0xC0, // pxor xmm0, xmm0
+    0x0F, 0x28, 0x4C, 0x24, 0x10, // movaps xmm1, [rsp+16]
+    0xC5, 0xFD, 0x58, 0xC1, // vaddpd ymm0, ymm0, ymm1
+    0xC4, 0xE2, 0x7D, 0x18, 0x05, 0, 0, 0, 0, // vbroadcastss ymm0, [rip]
+    0x66, 0x0F, 0x3A, 0x0F, 0xC1, 0x08, // palignr xmm0, xmm1, 8
+    0x62, 0xF1, 0x7C, 0x48, 0x58, 0xC1, // vaddps zmm0, zmm0, zmm1
+    0x0F, 0x1F, 0x44, 0x00, 0x00, // nop dword [rax+rax]
+    0x48, 0x8D, 0x84, 0x24, 0x80, 0, 0, 0, // lea rax, [rsp+0x80]
+];
+
+fn build_buffer(bytes: usize) -> Vec<u8> {
+    let block = encoded_block();
+    let mut buf = Vec::with_capacity(bytes + block.len() + RAW.len());
+    while buf.len() < bytes {
+        buf.extend_from_slice(&block);
+        buf.extend_from_slice(RAW);
+    }
+    buf
+}
+
+fn arg(args: &[String], name: &str, default: usize) -> usize {
+    args.iter()
+        .position(|a| a == name)
+        .and_then(|i| args.get(i + 1))
+        .and_then(|v| v.parse().ok())
+        .unwrap_or(default)
+}
+
+fn measure(iters: usize, mut run: impl FnMut() -> usize) -> (f64, usize) {
+    let mut times = Vec::with_capacity(iters);
+    let mut count = 0;
+    for _ in 0..iters {
+        let t = Instant::now();
+        count = black_box(run());
+        times.push(t.elapsed().as_secs_f64());
+    }
+    times.sort_by(|a, b| a.partial_cmp(b).unwrap());
+    (times[times.len() / 2], count)
+}
+
+fn main() {
+    let args: Vec<String> = std::env::args().collect();
+    let mb = arg(&args, "--mb", 4);
+    let iters = arg(&args, "--iters", 5).max(1);
+    let code = build_buffer(mb << 20);
+
+    println!("decoder_throughput: {} bytes, mediana de {} iteraciones", code.len(), iters);
+    println!("{:<12} {:>10} {:>12} {:>14}", "camino", "ms", "MB/s", "insn/s");
+
+    let cases: [(&str, &dyn Fn() -> usize); 3] = [
+        ("decode_all", &|| Decoder::new().decode_all(&code).len()),
+        ("length", &|| decode_table::sweep(&code).count()),
+        ("fields", &|| {
+            let mut offset = 0;
+            let mut n = 0;
+            while offset < code.len() {
+                offset += decode_table::decode(&code, offset)
+                    .map_or(1, |insn| black_box(insn).len as usize);
+                n += 1;
+            }
+            n
+        }),
+    ];
+    for (name, run) in cases {
+        let (secs, insns) = measure(iters, run);
+        println!(
+            "{:<12} {:>10.2} {:>12.1} {:>14.0}",
+            name,
+            secs * 1e3,
+            code.len() as f64 / secs / (1 << 20) as f64,
+            insns as f64 / secs
+        );
+    }
+}
@@ -0,0 +1,299 @@
+// ============================================================
+// Export tables — PE .edata and ELF .gnu.hash
+// ============================================================
+//
+// Single responsibility:
+//   - Pick the symbols a shared library exports (visibility)
+//   - PE: export directory whose name pointer table is sorted by
+//     byte-wise name, the order GetProcAddress binary-searches
+//   - ELF: DT_GNU_HASH (bloom filter + buckets + chains) and the
+//     .dynsym order it requires
+//
+// Only `Visibility::Default` symbols reach either table, so static
+// helpers and hidden symbols stay out of the dynamic symbol table.
+// The .dll/.so writers are not in this tree yet (elf.rs is a stub);
+// both build their export side from the same `ExportSymbol` list.
+//
+// ============================================================
+
+/// ELF-style symbol visibility; PE has no hidden exports, so `Hidden`
+/// symbols are simply left out of the export directory there
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum Visibility {
+    /// Exported: dynamic symbol table / export directory
+    #[default]
+    Default,
+    /// Local to the library
+    Hidden,
+}
+
+/// A function or object the library defines
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct ExportSymbol {
+    pub name: String,
+    /// RVA (PE) or virtual address offset (ELF) of the definition
+    pub address: u32,
+    pub visibility: Visibility,
+}
+
+impl ExportSymbol {
+    pub fn new(name: &str, address: u32) -> Self {
+        Self { name: name.to_string(), address, visibility: Visibility::Default }
+    }
+
+    pub fn hidden(name: &str, address: u32) -> Self {
+        Self { name: name.to_string(), address, visibility: Visibility::Hidden }
+    }
+}
+
+/// Exported symbols sorted by byte-wise name, duplicates dropped
+/// (the first definition wins)
+pub fn exported(symbols: &[ExportSymbol]) -> Vec<&ExportSymbol> {
+    let mut out: Vec<&ExportSymbol> =
+        symbols.iter().filter(|s| s.visibility == Visibility::Default).collect();
+    // Stable: equal names keep definition order, so dedup keeps the first
+    out.sort_by(|a, b| a.name.as_bytes().cmp(b.name.as_bytes()));
+    out.dedup_by(|b, a| a.name == b.name);
+    out
+}
+
+// ── PE ──────────────────────────────────────────────────────
+
+const EXPORT_DIRECTORY_SIZE: usize = 40;
+
+/// .edata contents for a section at `edata_rva`: IMAGE_EXPORT_DIRECTORY,
+/// export address table, name pointer table, ordinal table, then the
+/// DLL name and the export names. Ordinals follow the sorted name
+/// order (base 1), so the ordinal table is the identity.
+pub fn build_edata(dll_name: &str, symbols: &[ExportSymbol], edata_rva: u32) -> Vec<u8> {
+    let exports = exported(symbols);
+    let count = exports.len();
+    let eat = EXPORT_DIRECTORY_SIZE;
+    let name_ptrs = eat + count * 4;
+    let ordinals = name_ptrs + count * 4;
+    let dll_name_at = ordinals + count * 2;
+    let rva = |offset: usize| edata_rva + offset as u32;
+
+    let mut b = Vec::with_capacity(dll_name_at + dll_name.len() + 1 + exports.iter().map(|s| s.name.len() + 1).sum::<usize>());
+    b.extend_from_slice(&[0u8; 12]); // Characteristics, TimeDateStamp, Version
+    b.extend_from_slice(&rva(dll_name_at).to_le_bytes());
+    b.extend_from_slice(&1u32.to_le_bytes()); // Base
+    b.extend_from_slice(&(count as u32).to_le_bytes()); // NumberOfFunctions
+    b.extend_from_slice(&(count as u32).to_le_bytes()); // NumberOfNames
+    b.extend_from_slice(&rva(eat).to_le_bytes());
+    b.extend_from_slice(&rva(name_ptrs).to_le_bytes());
+    b.extend_from_slice(&rva(ordinals).to_le_bytes());
+
+    for symbol in &exports {
+        b.extend_from_slice(&symbol.address.to_le_bytes());
+    }
+    let mut string_at = dll_name_at + dll_name.len() + 1;
+    for symbol in &exports {
+        b.extend_from_slice(&rva(string_at).to_le_bytes());
+        string_at += symbol.name.len() + 1;
+    }
+    for i in 0..count {
+        b.extend_from_slice(&(i as u16).to_le_bytes());
+    }
+    for name in std::iter::once(dll_name).chain(exports.iter().map(|s| s.name.as_str())) {
+        b.extend_from_slice(name.as_bytes());
+        b.push(0);
+    }
+    b
+}
+
+// ── ELF ─────────────────────────────────────────────────────
+
+/// Second bloom hash: bits (h >> BLOOM_SHIFT) % 64, as GNU ld and lld
+const BLOOM_SHIFT: u32 = 26;
+
+/// dl_new_hash: h = h * 33 + c, from 5381
+pub fn gnu_hash(name: &[u8]) -> u32 {
+    name.iter().fold(5381u32, |h, &c| h.wrapping_mul(33).wrapping_add(c as u32))
+}
+
+/// DT_GNU_HASH section plus the order the hashed symbols must take in
+/// .dynsym, starting at index `symoffset`
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct GnuHashTable {
+    pub section: Vec<u8>,
+    /// Indices into the exported list, in .dynsym order
+    pub order: Vec<usize>,
+    pub nbuckets: u32,
+    pub bloom_words: u32,
+}
+
+/// Builds the table for `names` (the exported symbols; the undefined
+/// ones and the null symbol go first in .dynsym, before `symoffset`).
+/// Sizing follows lld: one bucket per four symbols and a bloom filter
+/// of 12 bits per symbol, rounded up to a power of two of 64-bit words.
+pub fn build_gnu_hash(names: &[&str], symoffset: u32) -> GnuHashTable {
+    let count = names.len();
+    let nbuckets = (count / 4).max(1) as u32;
+    let bloom_words = (count * 12 / 64).max(1).next_power_of_two() as u32;
+    let hashes: Vec<u32> = names.iter().map(|n| gnu_hash(n.as_bytes())).collect();
+
+    let mut order: Vec<usize> = (0..count).collect();
+    order.sort_by_key(|&i| hashes[i] % nbuckets);
+
+    let mut bloom = vec![0u64; bloom_words as usize];
+    for &h in &hashes {
+        let word = &mut bloom[(h / 64 % bloom_words) as usize];
+        *word |= 1 << (h % 64);
+        *word |= 1 << ((h >> BLOOM_SHIFT) % 64);
+    }
+
+    let mut buckets = vec![0u32; nbuckets as usize];
+    let mut chains = Vec::with_capacity(count);
+    for (pos, &i) in order.iter().enumerate() {
+        let bucket = hashes[i] % nbuckets;
+        if pos == 0 || hashes[order[pos - 1]] % nbuckets != bucket {
+            buckets[bucket as usize] = symoffset + pos as u32;
+        }
+        let last = order.get(pos + 1).map_or(true, |&next| hashes[next] % nbuckets != bucket);
+        chains.push(hashes[i] & !1 | last as u32);
+    }
+
+    let mut section = Vec::with_capacity(16 + bloom.len() * 8 + (buckets.len() + chains.len()) * 4);
+    for v in [nbuckets, symoffset, bloom_words, BLOOM_SHIFT] {
+        section.extend_from_slice(&v.to_le_bytes());
+    }
+    for word in &bloom {
+        section.extend_from_slice(&word.to_le_bytes());
+    }
+    for v in buckets.iter().chain(&chains) {
+        section.extend_from_slice(&v.to_le_bytes());
+    }
+    GnuHashTable { section, order, nbuckets, bloom_words }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn u32_at(b: &[u8], at: usize) -> u32 {
+        u32::from_le_bytes(b[at..at + 4].try_into().unwrap())
+    }
+
+    fn c_str(b: &[u8], at: usize) -> &str {
+        let len = b[at..].iter().position(|&c| c == 0).unwrap();
+        std::str::from_utf8(&b[at..at + len]).unwrap()
+    }
+
+    /// What GetProcAddress does with a name: binary search of the name
+    /// pointer table, then ordinal table → export address table
+    fn get_proc_address(edata: &[u8], base_rva: u32, name: &str) -> Option<u32> {
+        let at = |rva: u32| (rva - base_rva) as usize;
+        let count = u32_at(edata, 24) as usize;
+        let (eat, names, ordinals) = (at(u32_at(edata, 28)), at(u32_at(edata, 32)), at(u32_at(edata, 36)));
+        let (mut lo, mut hi) = (0, count);
+        while lo < hi {
+            let mid = (lo + hi) / 2;
+            let candidate = c_str(edata, at(u32_at(edata, names + mid * 4)));
+            match candidate.as_bytes().cmp(name.as_bytes()) {
+                std::cmp::Ordering::Equal => {
+                    let ordinal = u16::from_le_bytes([edata[ordinals + mid * 2], edata[ordinals + mid * 2 + 1]]);
+                    return Some(u32_at(edata, eat + ordinal as usize * 4));
+                }
+                std::cmp::Ordering::Less => lo = mid + 1,
+                std::cmp::Ordering::Greater => hi = mid,
+            }
+        }
+        None
+    }
+
+    /// glibc's lookup: bloom filter, bucket, then walk the chain
+    fn gnu_lookup(table: &GnuHashTable, dynsym: &[&str], name: &str) -> Option<usize> {
+        let s = &table.section;
+        let (nbuckets, symoffset, bloom_words, shift) = (u32_at(s, 0), u32_at(s, 4), u32_at(s, 8), u32_at(s, 12));
+        let h = gnu_hash(name.as_bytes());
+        let word_at = 16 + (h / 64 % bloom_words) as usize * 8;
+        let word = u64::from_le_bytes(s[word_at..word_at + 8].try_into().unwrap());
+        if word & (1 << (h % 64)) == 0 || word & (1 << ((h >> shift) % 64)) == 0 {
+            return None;
+        }
+        let buckets = 16 + bloom_words as usize * 8;
+        let chains = buckets + nbuckets as usize * 4;
+        let mut index = u32_at(s, buckets + (h % nbuckets) as usize * 4);
+        if index == 0 {
+            return None;
+        }
+        loop {
+            let chain = u32_at(s, chains + (index - symoffset) as usize * 4);
+            if chain | 1 == h | 1 && dynsym[index as usize] == name {
+                return Some(index as usize);
+            }
+            if chain & 1 != 0 {
+                return None;
+            }
+            index += 1;
+        }
+    }
+
+    fn plugin_symbols(count: usize) -> Vec<ExportSymbol> {
+        let mut symbols: Vec<ExportSymbol> =
+            (0..count).rev().map(|i| ExportSymbol::new(&format!("plugin_fn_{}", i), 0x1000 + i as u32 * 16)).collect();
+        symbols.push(ExportSymbol::hidden("internal_helper", 0x9000));
+        symbols
+    }
+
+    #[test]
+    fn test_gnu_hash_matches_dl_new_hash() {
+        assert_eq!(gnu_hash(b""), 0x1505);
+        assert_eq!(gnu_hash(b"printf"), 0x156b_2bb8);
+        assert_eq!(gnu_hash(b"exit"), 0x7c96_7e3f);
+        assert_eq!(gnu_hash(b"syscall"), 0xbac2_12a0);
+    }
+
+    #[test]
+    fn test_exported_drops_hidden_and_duplicates() {
+        let symbols = vec![
+            ExportSymbol::new("b", 2),
+            ExportSymbol::hidden("a_hidden", 1),
+            ExportSymbol::new("B", 3),
+            ExportSymbol::new("b", 4),
+        ];
+        let names: Vec<(&str, u32)> = exported(&symbols).iter().map(|s| (s.name.as_str(), s.address)).collect();
+        assert_eq!(names, vec![("B", 3), ("b", 2)]);
+    }
+
+    #[test]
+    fn test_edata_names_are_sorted_for_binary_search() {
+        let symbols = plugin_symbols(300);
+        let edata = build_edata("plugin.dll", &symbols, 0x5000);
+        assert_eq!(u32_at(&edata, 24), 300);
+        assert_eq!(c_str(&edata, (u32_at(&edata, 12) - 0x5000) as usize), "plugin.dll");
+        let names = (u32_at(&edata, 32) - 0x5000) as usize;
+        let listed: Vec<&str> = (0..300).map(|i| c_str(&edata, (u32_at(&edata, names + i * 4) - 0x5000) as usize)).collect();
+        assert!(listed.windows(2).all(|w| w[0].as_bytes() < w[1].as_bytes()));
+        for i in [0, 7, 150, 299] {
+            assert_eq!(get_proc_address(&edata, 0x5000, &format!("plugin_fn_{}", i)), Some(0x1000 + i * 16));
+        }
+        assert_eq!(get_proc_address(&edata, 0x5000, "internal_helper"), None);
+        assert_eq!(get_proc_address(&edata, 0x5000, "plugin_fn_300"), None);
+    }
+
+    #[test]
+    fn test_gnu_hash_lookup_finds_every_export() {
+        let symbols = plugin_symbols(300);
+        let exports = exported(&symbols);
+        let names: Vec<&str> = exports.iter().map(|s| s.name.as_str()).collect();
+        // .dynsym: null symbol + one undefined import, then the hashed ones
+        let table = build_gnu_hash(&names, 2);
+        assert_eq!((table.nbuckets, table.bloom_words), (75, 64));
+        let mut dynsym = vec!["", "memcpy"];
+        dynsym.extend(table.order.iter().map(|&i| names[i]));
+
+        for (i, name) in names.iter().enumerate() {
+            let index = gnu_lookup(&table, &dynsym, name).unwrap();
+            assert_eq!(dynsym[index], names[i]);
+        }
+        assert_eq!(gnu_lookup(&table, &dynsym, "internal_helper"), None);
+        assert_eq!(gnu_lookup(&table, &dynsym, "memcpy"), None);
+
+        let single = build_gnu_hash(&["only"], 1);
+        assert_eq!(gnu_lookup(&single, &["", "only"], "only"), Some(1));
+        let empty = build_gnu_hash(&[], 1);
+        assert_eq!(gnu_lookup(&empty, &[""], "only"), None);
+    }
+}
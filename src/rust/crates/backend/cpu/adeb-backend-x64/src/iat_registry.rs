@@ -6,11 +6,14 @@
 //   - Define DLL import tables (18 DLLs, 340+ functions)
 //   - Build .idata section bytes for PE generation
 //   - Slot lookup for ISA compiler
+//   - Loader hints and delay-loaded DLLs (resolved on first call)
 //
 // ============================================================
 
+use crate::import_hints::ExportHints;
 use std::collections::HashMap;
 use std::collections::HashSet;
+use std::sync::OnceLock;
 
 // ── Multi-DLL IAT Registry v5 ─────────────────────────
 // 18 DLLs, 300+ slots: msvcrt, kernel32, user32, gdi32,
@@ -191,6 +194,14 @@ pub static DLL_IMPORTS: &[DllImport] = &[
         "InitializeCriticalSection", "EnterCriticalSection",
         "LeaveCriticalSection", "DeleteCriticalSection",
         "TryEnterCriticalSection",
+        // Slim reader/writer locks & condition variables
+        "AcquireSRWLockExclusive", "ReleaseSRWLockExclusive",
+        "TryAcquireSRWLockExclusive",
+        "SleepConditionVariableSRW", "WakeConditionVariable",
+        "WakeAllConditionVariable",
+        // I/O completion ports
+        "CreateIoCompletionPort", "GetQueuedCompletionStatusEx",
+        "PostQueuedCompletionStatus",
         // Atomics / Interlocked
         "InterlockedIncrement", "InterlockedDecrement",
         "InterlockedExchange", "InterlockedCompareExchange",
@@ -422,6 +433,50 @@ pub fn total_function_count() -> usize {
     DLL_IMPORTS.iter().map(|d| d.functions.len()).sum()
 }
 
+/// Rarely used DLLs that `-fdelay-load` keeps out of the import directory
+pub const DELAY_LOAD_CANDIDATES: &[&str] = &["d3dcompiler_47.dll", "dxgi.dll"];
+
+/// How the import table is emitted
+#[derive(Debug, Clone, Default)]
+pub struct ImportOptions {
+    /// Hints from the target DLLs' export tables (0 when unknown)
+    pub hints: ExportHints,
+    /// DLLs loaded on the first call to one of their functions
+    pub delay_load: Vec<String>,
+}
+
+impl ImportOptions {
+    /// Hints for the DLLs behind `used_slots` (see `ExportHints::from_env`),
+    /// plus the DELAY_LOAD_CANDIDATES when `delay_load` is set
+    pub fn from_env(used_slots: &HashSet<usize>, delay_load: bool) -> Self {
+        let dlls = used_dlls(used_slots);
+        Self {
+            hints: ExportHints::from_env(dlls.iter().copied()),
+            delay_load: if delay_load {
+                DELAY_LOAD_CANDIDATES.iter().map(|d| d.to_string()).collect()
+            } else {
+                Vec::new()
+            },
+        }
+    }
+
+    fn is_delayed(&self, dll: &str) -> bool {
+        self.delay_load.iter().any(|d| d.eq_ignore_ascii_case(dll))
+    }
+}
+
+/// A function of a delay-loaded DLL. Its IAT slot starts out pointing at a
+/// resolver stub (written by the PE builder) that loads the DLL, looks the
+/// function up, overwrites the slot and jumps there.
+#[derive(Debug, Clone, PartialEq)]
+pub struct DelayImport {
+    pub slot: usize,
+    pub iat_rva: u32,
+    pub dll_name_rva: u32,
+    /// RVA of the function name (the Hint/Name entry + 2)
+    pub name_rva: u32,
+}
+
 #[derive(Debug, Clone)]
 pub struct IdataBuildResult {
     pub bytes: Vec<u8>,
@@ -431,6 +486,8 @@ pub struct IdataBuildResult {
     pub iat_rva: u32,
     pub iat_size: u32,
     pub program_strings_offset: u32,
+    /// Used functions of delay-loaded DLLs, in slot order
+    pub delay_imports: Vec<DelayImport>,
 }
 
 pub fn slot_for_function(name: &str) -> Option<usize> {
@@ -444,6 +501,49 @@ pub fn slot_for_function(name: &str) -> Option<usize> {
     None
 }
 
+/// DLLs with at least one used slot
+pub fn used_dlls(used_slots: &HashSet<usize>) -> Vec<&'static str> {
+    let mut slot = 0usize;
+    let mut dlls = Vec::new();
+    for dll in DLL_IMPORTS {
+        if (slot..slot + dll.functions.len()).any(|s| used_slots.contains(&s)) {
+            dlls.push(dll.dll);
+        }
+        slot += dll.functions.len();
+    }
+    dlls
+}
+
+/// Used slots that belong to delay-loaded DLLs, in slot order
+pub fn delay_load_slots(used_slots: &HashSet<usize>, opts: &ImportOptions) -> Vec<usize> {
+    let mut slots = Vec::new();
+    let mut slot = 0usize;
+    for dll in DLL_IMPORTS {
+        if opts.is_delayed(dll.dll) {
+            slots.extend((slot..slot + dll.functions.len()).filter(|s| used_slots.contains(s)));
+        }
+        slot += dll.functions.len();
+    }
+    slots
+}
+
+/// Layout with every slot imported at ASSUMED_IDATA_RVA — the one the ISA
+/// compiler encodes `call [rip+iat]` against. Built once per process.
+fn assumed_layout() -> &'static IdataBuildResult {
+    static LAYOUT: OnceLock<IdataBuildResult> = OnceLock::new();
+    LAYOUT.get_or_init(|| build_idata(crate::pe::ASSUMED_IDATA_RVA, &[]))
+}
+
+/// IAT RVA of `slot` in the assumed layout
+pub fn assumed_iat_rva(slot: usize) -> u32 {
+    assumed_layout().slot_to_iat_rva[slot]
+}
+
+/// Inverse of `assumed_iat_rva`
+pub fn slot_for_assumed_iat_rva(rva: u32) -> Option<usize> {
+    assumed_layout().slot_to_iat_rva.binary_search(&rva).ok()
+}
+
 fn align_up(value: usize, align: usize) -> usize {
     if align == 0 { return value; }
     (value + (align - 1)) & !(align - 1)
@@ -469,9 +569,26 @@ pub fn build_idata(idata_rva: u32, _extra_imports: &[&str]) -> IdataBuildResult
 /// Build idata section, only importing DLLs that have at least one used slot.
 /// If used_slots is empty, NO DLLs are imported (produces a minimal valid idata).
 pub fn build_idata_filtered(idata_rva: u32, used_slots: &HashSet<usize>) -> IdataBuildResult {
+    build_idata_with(idata_rva, used_slots, &ImportOptions::default())
+}
+
+/// `build_idata_filtered` with loader hints and delay-loaded DLLs.
+/// The layout (and so program_strings_offset) does not depend on `opts`.
+pub fn build_idata_with(idata_rva: u32, used_slots: &HashSet<usize>, opts: &ImportOptions) -> IdataBuildResult {
     let num_dlls = DLL_IMPORTS.len();
     let total_funcs = total_function_count();
 
+    // Delay-load resolver stubs call LoadLibraryA + GetProcAddress
+    let delayed_slots = delay_load_slots(used_slots, opts);
+    let mut with_loader;
+    let used_slots = if delayed_slots.is_empty() {
+        used_slots
+    } else {
+        with_loader = used_slots.clone();
+        with_loader.extend(["LoadLibraryA", "GetProcAddress"].iter().filter_map(|f| slot_for_function(f)));
+        &with_loader
+    };
+
     // Determine which DLLs are actually needed
     let mut dll_is_used = vec![false; num_dlls];
     if !used_slots.is_empty() {
@@ -568,7 +685,25 @@ pub fn build_idata_filtered(idata_rva: u32, used_slots: &HashSet<usize>) -> Idat
     // (zeroed entries in the middle would be treated as null terminator by the PE loader)
     let mut global_func_idx = 0usize;
     let mut desc_idx = 0usize;
+    let mut delay_imports = Vec::with_capacity(delayed_slots.len());
     for (di, dll) in DLL_IMPORTS.iter().enumerate() {
+        if dll_is_used[di] && opts.is_delayed(dll.dll) {
+            // No descriptor: the loader never sees this DLL. The IAT slots are
+            // filled with resolver stub addresses by the PE builder.
+            for fi in 0..dll.functions.len() {
+                let slot = global_func_idx + fi;
+                if used_slots.contains(&slot) {
+                    delay_imports.push(DelayImport {
+                        slot,
+                        iat_rva: slot_to_iat_rva[slot],
+                        dll_name_rva: idata_rva + dll_name_offsets[di] as u32,
+                        name_rva: idata_rva + hint_name_offsets[slot] + 2,
+                    });
+                }
+            }
+            global_func_idx += dll.functions.len();
+            continue;
+        }
         if dll_is_used[di] {
             let desc_off = import_desc_offset + desc_idx * 20;
             let oft_rva = idata_rva + dll_oft_offsets[di] as u32;
@@ -621,8 +756,9 @@ pub fn build_idata_filtered(idata_rva: u32, used_slots: &HashSet<usize>) -> Idat
     for dll in DLL_IMPORTS {
         for f in dll.functions {
             let off = hint_name_offsets[global_func_idx] as usize;
-            // hint = 0
-            bytes[off] = 0; bytes[off+1] = 0;
+            // hint = index into the DLL's export name table (0 if unknown)
+            let hint = opts.hints.hint(dll.dll, f).unwrap_or(0);
+            bytes[off..off+2].copy_from_slice(&hint.to_le_bytes());
             let name_bytes = f.as_bytes();
             bytes[off+2..off+2+name_bytes.len()].copy_from_slice(name_bytes);
             bytes[off+2+name_bytes.len()] = 0;
@@ -654,6 +790,7 @@ pub fn build_idata_filtered(idata_rva: u32, used_slots: &HashSet<usize>) -> Idat
         iat_rva,
         iat_size: iat_total_size,
         program_strings_offset,
+        delay_imports,
     }
 }
 
@@ -669,3 +806,28 @@ pub fn build_iat_name_to_rva_map(idata_rva: u32) -> HashMap<String, u32> {
     }
     map
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_hints_are_written_into_hint_name_entries() {
+        let printf = slot_for_function("printf").unwrap();
+        let used: HashSet<usize> = [printf].into();
+        let mut opts = ImportOptions::default();
+        opts.hints.insert("MSVCRT.dll", &["_exit".to_string(), "printf".to_string()]);
+
+        let idata = build_idata_with(0x2000, &used, &opts);
+        // First descriptor = msvcrt; its OFT[0] points at printf's Hint/Name
+        let oft = u32::from_le_bytes(idata.bytes[0..4].try_into().unwrap()) - 0x2000;
+        let oft = oft as usize;
+        let hint_name = u64::from_le_bytes(idata.bytes[oft..oft + 8].try_into().unwrap()) as usize - 0x2000;
+        assert_eq!(&idata.bytes[hint_name..hint_name + 2], &1u16.to_le_bytes());
+        assert_eq!(&idata.bytes[hint_name + 2..hint_name + 9], b"printf\0");
+        // Same layout with or without options
+        let plain = build_idata_filtered(0x2000, &used);
+        assert_eq!(plain.program_strings_offset, idata.program_strings_offset);
+        assert_eq!(&plain.bytes[hint_name..hint_name + 2], &[0, 0]);
+    }
+}
@@ -0,0 +1,195 @@
+// ============================================================
+// Import Hints — Export name tables of the target DLLs
+// ============================================================
+//
+// Single responsibility:
+//   - Read the export name pointer table of a PE DLL
+//   - Map (dll, function) → hint for the .idata Hint/Name entries
+//
+// The loader first tries the hint as an index into the DLL's
+// sorted export names and only falls back to a binary search of
+// the names when it misses. A hint is therefore only worth
+// emitting when it comes from the real DLL the binary will load:
+// the tables are read from `ADEB_IMPORT_HINTS` (a directory with
+// the target DLLs) or, on Windows, from %SystemRoot%\System32.
+// Without a table the hint stays 0, exactly as before.
+//
+// ============================================================
+
+use std::collections::HashMap;
+use std::path::{Path, PathBuf};
+
+/// Hints per DLL (lower-case DLL name → function → hint)
+#[derive(Debug, Clone, Default)]
+pub struct ExportHints {
+    tables: HashMap<String, HashMap<String, u16>>,
+}
+
+impl ExportHints {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Registers the export names of `dll` in export-table order
+    pub fn insert(&mut self, dll: &str, names: &[String]) {
+        let table = names
+            .iter()
+            .enumerate()
+            .filter(|(i, _)| *i <= u16::MAX as usize)
+            .map(|(i, n)| (n.clone(), i as u16))
+            .collect();
+        self.tables.insert(dll.to_ascii_lowercase(), table);
+    }
+
+    pub fn hint(&self, dll: &str, function: &str) -> Option<u16> {
+        self.tables.get(&dll.to_ascii_lowercase())?.get(function).copied()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.tables.is_empty()
+    }
+
+    /// Reads the export tables of `dlls` from `dir`; missing or
+    /// unreadable DLLs are skipped (their hints stay 0)
+    pub fn load_dir<'a>(dir: &Path, dlls: impl IntoIterator<Item = &'a str>) -> Self {
+        let mut hints = Self::new();
+        for dll in dlls {
+            let path = dir.join(dll);
+            let Ok(bytes) = std::fs::read(&path) else {
+                continue;
+            };
+            if let Some(names) = export_names(&bytes) {
+                hints.insert(dll, &names);
+            }
+        }
+        hints
+    }
+
+    /// `ADEB_IMPORT_HINTS` if set, else System32 on Windows hosts
+    pub fn from_env<'a>(dlls: impl IntoIterator<Item = &'a str>) -> Self {
+        match hints_dir() {
+            Some(dir) => Self::load_dir(&dir, dlls),
+            None => Self::new(),
+        }
+    }
+}
+
+fn hints_dir() -> Option<PathBuf> {
+    if let Ok(dir) = std::env::var("ADEB_IMPORT_HINTS") {
+        return (!dir.is_empty()).then(|| PathBuf::from(dir));
+    }
+    if cfg!(target_os = "windows") {
+        let root = std::env::var("SystemRoot").ok()?;
+        return Some(Path::new(&root).join("System32"));
+    }
+    None
+}
+
+fn read_u16(b: &[u8], off: usize) -> Option<u16> {
+    Some(u16::from_le_bytes(b.get(off..off + 2)?.try_into().ok()?))
+}
+
+fn read_u32(b: &[u8], off: usize) -> Option<u32> {
+    Some(u32::from_le_bytes(b.get(off..off + 4)?.try_into().ok()?))
+}
+
+/// Export names of a PE32/PE32+ image, in name-pointer-table order
+/// (the order hints index into). None if `bytes` is not a PE with exports.
+pub fn export_names(bytes: &[u8]) -> Option<Vec<String>> {
+    if bytes.get(0..2)? != b"MZ" {
+        return None;
+    }
+    let pe = read_u32(bytes, 0x3C)? as usize;
+    if bytes.get(pe..pe + 4)? != b"PE\0\0" {
+        return None;
+    }
+    let coff = pe + 4;
+    let num_sections = read_u16(bytes, coff + 2)? as usize;
+    let opt_size = read_u16(bytes, coff + 16)? as usize;
+    let opt = coff + 20;
+    let dirs = match read_u16(bytes, opt)? {
+        0x10B => opt + 96,
+        0x20B => opt + 112,
+        _ => return None,
+    };
+    let export_rva = read_u32(bytes, dirs)?;
+    if export_rva == 0 {
+        return None;
+    }
+
+    let sections = opt + opt_size;
+    let rva_to_offset = |rva: u32| -> Option<usize> {
+        (0..num_sections).find_map(|i| {
+            let sh = sections + i * 40;
+            let vsize = read_u32(bytes, sh + 8)?;
+            let va = read_u32(bytes, sh + 12)?;
+            let raw_size = read_u32(bytes, sh + 16)?;
+            let raw_ptr = read_u32(bytes, sh + 20)?;
+            let span = vsize.max(raw_size);
+            (va <= rva && rva < va + span).then(|| (rva - va + raw_ptr) as usize)
+        })
+    };
+
+    let dir = rva_to_offset(export_rva)?;
+    let count = read_u32(bytes, dir + 24)? as usize;
+    let names = rva_to_offset(read_u32(bytes, dir + 32)?)?;
+    let mut out = Vec::with_capacity(count);
+    for i in 0..count {
+        let start = rva_to_offset(read_u32(bytes, names + i * 4)?)?;
+        let len = bytes.get(start..)?.iter().position(|&c| c == 0)?;
+        out.push(String::from_utf8_lossy(&bytes[start..start + len]).into_owned());
+    }
+    Some(out)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Minimal PE32+ DLL: one section at RVA 0x1000 holding an export
+    /// directory with the names `names`
+    fn fake_dll(names: &[&str]) -> Vec<u8> {
+        let mut b = vec![0u8; 0x400];
+        b[0..2].copy_from_slice(b"MZ");
+        b[0x3C..0x40].copy_from_slice(&0x80u32.to_le_bytes());
+        b[0x80..0x84].copy_from_slice(b"PE\0\0");
+        let coff = 0x84;
+        b[coff + 2..coff + 4].copy_from_slice(&1u16.to_le_bytes());
+        b[coff + 16..coff + 18].copy_from_slice(&0xF0u16.to_le_bytes());
+        let opt = coff + 20;
+        b[opt..opt + 2].copy_from_slice(&0x20Bu16.to_le_bytes());
+        b[opt + 112..opt + 116].copy_from_slice(&0x1000u32.to_le_bytes());
+        let sh = opt + 0xF0;
+        b[sh + 8..sh + 12].copy_from_slice(&0x200u32.to_le_bytes());
+        b[sh + 12..sh + 16].copy_from_slice(&0x1000u32.to_le_bytes());
+        b[sh + 16..sh + 20].copy_from_slice(&0x200u32.to_le_bytes());
+        b[sh + 20..sh + 24].copy_from_slice(&0x200u32.to_le_bytes());
+
+        // Export directory at file 0x200 (RVA 0x1000); name pointers at +0x40
+        let dir = 0x200;
+        b[dir + 24..dir + 28].copy_from_slice(&(names.len() as u32).to_le_bytes());
+        b[dir + 32..dir + 36].copy_from_slice(&0x1040u32.to_le_bytes());
+        let mut str_rva = 0x1080u32;
+        for (i, name) in names.iter().enumerate() {
+            let ptr = dir + 0x40 + i * 4;
+            b[ptr..ptr + 4].copy_from_slice(&str_rva.to_le_bytes());
+            let at = (str_rva - 0x1000 + 0x200) as usize;
+            b[at..at + name.len()].copy_from_slice(name.as_bytes());
+            str_rva += name.len() as u32 + 1;
+        }
+        b
+    }
+
+    #[test]
+    fn test_export_names_are_read_in_table_order() {
+        let dll = fake_dll(&["D3DCompile", "D3DCreateBlob", "D3DReflect"]);
+        let names = export_names(&dll).unwrap();
+        assert_eq!(names, vec!["D3DCompile", "D3DCreateBlob", "D3DReflect"]);
+        assert_eq!(export_names(b"not a pe"), None);
+
+        let mut hints = ExportHints::new();
+        hints.insert("D3DCompiler_47.dll", &names);
+        assert_eq!(hints.hint("d3dcompiler_47.dll", "D3DReflect"), Some(2));
+        assert_eq!(hints.hint("d3dcompiler_47.dll", "D3DCompile2"), None);
+    }
+}
@@ -0,0 +1,1040 @@
+// ============================================================
+// ADead-BIB — E/S asíncrona de ficheros y sockets (adb_ring_*)
+// ============================================================
+// Un anillo de envío y otro de terminación, con la misma API en los
+// dos sistemas:
+//
+//   - Linux: io_uring por syscall directa (setup/enter/register). Los
+//     tres mapeos compartidos (anillo SQ, anillo CQ y SQEs) se hacen al
+//     crear; encolar solo escribe la SQE y mueve la cola local, y un
+//     único io_uring_enter envía todo el lote y, si se pide, espera
+//     terminaciones. Los búferes registrados van a IORING_REGISTER_BUFFERS
+//     y las operaciones *_FIXED se saltan el pin de páginas por petición
+//   - Windows: un puerto IOCP. Cada petición ocupa una ranura de 128
+//     bytes con su OVERLAPPED al principio; enviar llama a ReadFile o
+//     WriteFile (los sockets son HANDLE) y recoger usa
+//     GetQueuedCompletionStatusEx, hasta 64 terminaciones por llamada.
+//     Un fallo inmediato se publica en el puerto con clave 1 para que
+//     llegue por el mismo camino. Registrar búferes no hace nada: IOCP
+//     no tiene equivalente y las *_FIXED se tratan como READ/WRITE
+//
+// Los códigos de operación son los de io_uring (ADB_IO_READ = 22...).
+// El resultado de una terminación es el de io_uring: bytes o -errno; en
+// Windows, bytes o -error Win32 / el NTSTATUS (negativo), con fin de
+// fichero como 0 bytes.
+//
+//   adb_io_req  { op, fd, buf, len, offset, user_data, buf_index }  8 bytes c/u
+//   adb_cqe     { user_data, result }
+// ============================================================
+
+use super::slab_heap::{self, PageSource};
+use super::{ADeadIR, ADeadOp, CallTarget, Condition, Label, Operand, Reg};
+
+const SYS_CLOSE: i32 = 3;
+const SYS_MMAP: i32 = 9;
+const SYS_IO_URING_SETUP: i32 = 425;
+const SYS_IO_URING_ENTER: i32 = 426;
+const SYS_IO_URING_REGISTER: i32 = 427;
+const IORING_ENTER_GETEVENTS: i32 = 1;
+const IORING_REGISTER_BUFFERS: i32 = 0;
+const IORING_OFF_CQ_RING: i32 = 0x800_0000;
+const IORING_OFF_SQES: i32 = 0x1000_0000;
+const PROT_READ_WRITE: i32 = 3;
+const MAP_SHARED_POPULATE: i32 = 0x8001;
+/// -errno está en [-4095, -1]
+const MAX_ERRNO: i32 = -4096;
+
+// ---- Códigos de operación (los de io_uring) ----
+const OP_READ_FIXED: i32 = 4;
+const OP_WRITE_FIXED: i32 = 5;
+const OP_READ: i32 = 22;
+const OP_WRITE: i32 = 23;
+const OP_SEND: i32 = 26;
+const OP_RECV: i32 = 27;
+
+const ERROR_INVALID_FUNCTION: i32 = 1;
+const ERROR_IO_PENDING: i32 = 997;
+const STATUS_END_OF_FILE: i32 = 0xC000_0011_u32 as i32;
+const INFINITE: i32 = -1;
+
+// ---- Petición y terminación desde C ----
+const REQ_OP: i32 = 0;
+const REQ_FD: i32 = 8;
+const REQ_BUF: i32 = 16;
+const REQ_LEN: i32 = 24;
+const REQ_OFFSET: i32 = 32;
+const REQ_USER_DATA: i32 = 40;
+const REQ_BUF_INDEX: i32 = 48;
+const REQ_BYTES: i32 = 56;
+const CQE_RESULT: i32 = 8;
+
+// ---- Anillo: cabecera común ----
+const ENTRIES: i32 = 0;
+/// Peticiones encoladas que aún no se han enviado
+const QUEUED: i32 = 8;
+/// Bytes mapeados (en Windows incluye las ranuras)
+const BYTES: i32 = 16;
+const HEADER_BYTES: i32 = 4096;
+const DEFAULT_ENTRIES: i32 = 64;
+const MAX_ENTRIES: i32 = 4096;
+
+// ---- Linux ----
+const FD: i32 = 24;
+const SQ_RING: i32 = 32;
+const SQ_RING_BYTES: i32 = 40;
+const CQ_RING: i32 = 48;
+const CQ_RING_BYTES: i32 = 56;
+const SQES: i32 = 64;
+const SQES_BYTES: i32 = 72;
+const SQ_HEAD: i32 = 80;
+const SQ_TAIL: i32 = 88;
+const SQ_MASK: i32 = 96;
+const SQ_ARRAY: i32 = 104;
+const CQ_HEAD: i32 = 112;
+const CQ_TAIL: i32 = 120;
+const CQ_MASK: i32 = 128;
+const CQES: i32 = 136;
+/// Cola local: se publica en el anillo al enviar
+const TAIL: i32 = 144;
+/// struct io_uring_params (120 bytes): sq_off en +40, cq_off en +80
+const PARAMS: i32 = 256;
+const SQ_OFF: i32 = PARAMS + 40;
+const CQ_OFF: i32 = PARAMS + 80;
+
+// ---- Windows ----
+const PORT: i32 = 24;
+const FREE: i32 = 32;
+const FIRST: i32 = 40;
+const LAST: i32 = 48;
+/// Último HANDLE asociado al puerto
+const ASSOCIATED: i32 = 56;
+/// ULONG que rellena GetQueuedCompletionStatusEx
+const REMOVED: i32 = 64;
+/// OVERLAPPED_ENTRY[MAX_EVENTS] de 32 bytes
+const EVENTS: i32 = 1024;
+const MAX_EVENTS: i32 = 64;
+
+/// Ranura: OVERLAPPED (Offset/OffsetHigh en +16) y la petición copiada
+const SLOT_BYTES: i32 = 128;
+const SLOT_SHIFT: u8 = 7;
+const SLOT_OFFSET: i32 = 16;
+const SLOT_USER_DATA: i32 = 32;
+const SLOT_NEXT: i32 = 40;
+const SLOT_HANDLE: i32 = 48;
+const SLOT_BUF: i32 = 56;
+const SLOT_LEN: i32 = 64;
+const SLOT_OP: i32 = 72;
+const SLOT_ERROR: i32 = 80;
+
+/// Cómo llega la E/S al sistema
+#[derive(Debug, Clone, Copy)]
+pub enum AioApi {
+    /// Linux: io_uring por syscall
+    IoUring,
+    /// Windows: puerto de terminación de kernel32
+    Iocp {
+        create_port: u32,
+        get_queued: u32,
+        post_queued: u32,
+        read_file: u32,
+        write_file: u32,
+        close_handle: u32,
+        get_last_error: u32,
+    },
+}
+
+#[derive(Debug, Clone, Copy)]
+pub struct AsyncIo {
+    api: AioApi,
+    pages: PageSource,
+    args: [Reg; 4],
+    /// adb_ring_create(entries) → anillo, o 0
+    pub create: Label,
+    /// adb_ring_register_buffers(r, iov, n) → 0 o -errno
+    pub register: Label,
+    /// adb_ring_queue(r, req) → 0, o -1 si el anillo está lleno
+    pub queue: Label,
+    /// adb_ring_queue_batch(r, reqs, n) → peticiones encoladas
+    pub queue_batch: Label,
+    /// adb_ring_submit(r) → peticiones enviadas, o -errno
+    pub submit: Label,
+    /// adb_ring_wait(r, out, max, min) → terminaciones copiadas, o -errno
+    pub wait: Label,
+    /// adb_ring_destroy(r)
+    pub destroy: Label,
+    map: Label,
+    unmap: Label,
+}
+
+fn mov(ir: &mut ADeadIR, dst: Reg, src: Operand) {
+    ir.emit(ADeadOp::Mov { dst: Operand::Reg(dst), src });
+}
+
+fn mem(base: Reg, disp: i32) -> Operand {
+    Operand::Mem { base, disp }
+}
+
+fn store(ir: &mut ADeadIR, base: Reg, disp: i32, src: Reg) {
+    ir.emit(ADeadOp::Mov { dst: mem(base, disp), src: Operand::Reg(src) });
+}
+
+fn jcc(ir: &mut ADeadIR, cond: Condition, target: Label) {
+    ir.emit(ADeadOp::Jcc { cond, target });
+}
+
+fn call(ir: &mut ADeadIR, target: Label) {
+    ir.emit(ADeadOp::Call { target: CallTarget::Relative(target) });
+}
+
+fn push(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Push { src: Operand::Reg(reg) });
+}
+
+fn pop(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Pop { dst: reg });
+}
+
+fn zero(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Xor { dst: reg, src: reg });
+}
+
+/// Deja solo los 32 bits bajos (unsigned de C, contadores del anillo)
+fn low32(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Shl { dst: reg, amount: 32 });
+    ir.emit(ADeadOp::Shr { dst: reg, amount: 32 });
+}
+
+/// reg = min(reg, limit) sin signo
+fn clamp(ir: &mut ADeadIR, reg: Reg, limit: Reg) {
+    let ok = ir.new_label();
+    ir.emit(ADeadOp::Cmp { left: Operand::Reg(reg), right: Operand::Reg(limit) });
+    jcc(ir, Condition::BelowEq, ok);
+    mov(ir, reg, Operand::Reg(limit));
+    ir.emit(ADeadOp::Label(ok));
+}
+
+fn call_iat(ir: &mut ADeadIR, iat_rva: u32) {
+    ir.emit(ADeadOp::Cld);
+    ir.emit(ADeadOp::CallIAT { iat_rva });
+}
+
+impl AsyncIo {
+    pub fn new(ir: &mut ADeadIR, api: AioApi, pages: PageSource) -> Self {
+        Self {
+            api,
+            pages,
+            args: match api {
+                AioApi::Iocp { .. } => [Reg::RCX, Reg::RDX, Reg::R8, Reg::R9],
+                AioApi::IoUring => [Reg::RDI, Reg::RSI, Reg::RDX, Reg::RCX],
+            },
+            create: ir.new_label(),
+            register: ir.new_label(),
+            queue: ir.new_label(),
+            queue_batch: ir.new_label(),
+            submit: ir.new_label(),
+            wait: ir.new_label(),
+            destroy: ir.new_label(),
+            map: ir.new_label(),
+            unmap: ir.new_label(),
+        }
+    }
+
+    /// Rutina que resuelve una llamada de C/C++
+    pub fn routine(&self, name: &str) -> Option<Label> {
+        match name {
+            "adb_ring_create" => Some(self.create),
+            "adb_ring_register_buffers" => Some(self.register),
+            "adb_ring_queue" => Some(self.queue),
+            "adb_ring_queue_batch" => Some(self.queue_batch),
+            "adb_ring_submit" => Some(self.submit),
+            "adb_ring_wait" => Some(self.wait),
+            "adb_ring_destroy" => Some(self.destroy),
+            _ => None,
+        }
+    }
+
+    pub fn emit_routines(&self, ir: &mut ADeadIR) {
+        slab_heap::emit_page_map(ir, self.map, self.pages);
+        slab_heap::emit_page_unmap(ir, self.unmap, self.pages);
+        self.emit_create(ir);
+        self.emit_register(ir);
+        self.emit_queue(ir);
+        self.emit_queue_batch(ir);
+        self.emit_submit(ir);
+        self.emit_wait(ir);
+        self.emit_destroy(ir);
+    }
+
+    // ---- Entradas desde C: la pila puede venir sin alinear ----
+
+    /// Guarda RBX, R12-R15, RSI, RDI y deja la pila alineada con sombra
+    /// y dos argumentos de pila. RBX = anillo, R12-R14 = resto de argumentos
+    fn enter(&self, ir: &mut ADeadIR) {
+        push(ir, Reg::RBP);
+        mov(ir, Reg::RBP, Operand::Reg(Reg::RSP));
+        for reg in [Reg::RBX, Reg::R12, Reg::R13, Reg::R14, Reg::R15, Reg::RSI, Reg::RDI] {
+            push(ir, reg);
+        }
+        mov(ir, Reg::RAX, Operand::Imm32(-16));
+        ir.emit(ADeadOp::And { dst: Reg::RSP, src: Reg::RAX });
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(48) });
+        mov(ir, Reg::R12, Operand::Reg(self.args[1]));
+        mov(ir, Reg::R13, Operand::Reg(self.args[2]));
+        mov(ir, Reg::R14, Operand::Reg(self.args[3]));
+        mov(ir, Reg::RBX, Operand::Reg(self.args[0]));
+    }
+
+    fn leave(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Lea { dst: Reg::RSP, src: mem(Reg::RBP, -56) });
+        for reg in [Reg::RDI, Reg::RSI, Reg::R15, Reg::R14, Reg::R13, Reg::R12, Reg::RBX] {
+            pop(ir, reg);
+        }
+        pop(ir, Reg::RBP);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    fn emit_create(&self, ir: &mut ADeadIR) {
+        let fail = ir.new_label();
+        let out = ir.new_label();
+        let sized = ir.new_label();
+        ir.emit(ADeadOp::Label(self.create));
+        self.enter(ir);
+        // R12 = entradas: 0 → por defecto, y como mucho MAX_ENTRIES
+        mov(ir, Reg::R12, Operand::Reg(Reg::RBX));
+        low32(ir, Reg::R12);
+        ir.emit(ADeadOp::Test { left: Reg::R12, right: Reg::R12 });
+        jcc(ir, Condition::NotEqual, sized);
+        mov(ir, Reg::R12, Operand::Imm32(DEFAULT_ENTRIES));
+        ir.emit(ADeadOp::Label(sized));
+        mov(ir, Reg::RAX, Operand::Imm32(MAX_ENTRIES));
+        clamp(ir, Reg::R12, Reg::RAX);
+        // R13 = bytes de la cabecera (más las ranuras en Windows)
+        mov(ir, Reg::R13, Operand::Imm32(HEADER_BYTES));
+        if let AioApi::Iocp { .. } = self.api {
+            mov(ir, Reg::RAX, Operand::Reg(Reg::R12));
+            ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: SLOT_SHIFT });
+            ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::R13), src: Operand::Reg(Reg::RAX) });
+        }
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R13));
+        call(ir, self.map);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        mov(ir, Reg::RBX, Operand::Reg(Reg::RAX));
+        store(ir, Reg::RBX, ENTRIES, Reg::R12);
+        store(ir, Reg::RBX, BYTES, Reg::R13);
+        match self.api {
+            AioApi::IoUring => self.create_uring(ir, fail),
+            AioApi::Iocp { create_port, .. } => Self::create_port(ir, create_port, fail),
+        }
+        mov(ir, Reg::RAX, Operand::Reg(Reg::RBX));
+        self.leave(ir);
+        // Sin anillo del sistema: se devuelve la cabecera
+        ir.emit(ADeadOp::Label(fail));
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RBX));
+        mov(ir, Reg::RDX, mem(Reg::RBX, BYTES));
+        call(ir, self.unmap);
+        zero(ir, Reg::RAX);
+        ir.emit(ADeadOp::Label(out));
+        self.leave(ir);
+    }
+
+    /// io_uring_setup y los tres mapeos; RBX = cabecera, R12 = entradas
+    fn create_uring(&self, ir: &mut ADeadIR, fail: Label) {
+        mov(ir, Reg::RDI, Operand::Reg(Reg::R12));
+        ir.emit(ADeadOp::Lea { dst: Reg::RSI, src: mem(Reg::RBX, PARAMS) });
+        mov(ir, Reg::RAX, Operand::Imm32(SYS_IO_URING_SETUP));
+        ir.emit(ADeadOp::Syscall);
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(MAX_ERRNO) });
+        jcc(ir, Condition::Above, fail);
+        store(ir, Reg::RBX, FD, Reg::RAX);
+
+        // El kernel redondea a potencia de dos
+        ir.emit(ADeadOp::Load32 { dst: Reg::RCX, base: Reg::RBX, disp: PARAMS });
+        store(ir, Reg::RBX, ENTRIES, Reg::RCX);
+        // SQ: sq_off.array + entradas·4; CQ: cq_off.cqes + cq_entries·16;
+        // SQEs: entradas·64
+        ir.emit(ADeadOp::Load32 { dst: Reg::RAX, base: Reg::RBX, disp: SQ_OFF + 24 });
+        ir.emit(ADeadOp::Shl { dst: Reg::RCX, amount: 2 });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RCX) });
+        store(ir, Reg::RBX, SQ_RING_BYTES, Reg::RAX);
+        ir.emit(ADeadOp::Load32 { dst: Reg::RAX, base: Reg::RBX, disp: CQ_OFF + 20 });
+        ir.emit(ADeadOp::Load32 { dst: Reg::RCX, base: Reg::RBX, disp: PARAMS + 4 });
+        ir.emit(ADeadOp::Shl { dst: Reg::RCX, amount: 4 });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RCX) });
+        store(ir, Reg::RBX, CQ_RING_BYTES, Reg::RAX);
+        mov(ir, Reg::RAX, mem(Reg::RBX, ENTRIES));
+        ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: 6 });
+        store(ir, Reg::RBX, SQES_BYTES, Reg::RAX);
+
+        for (field, bytes, offset) in
+            [(SQ_RING, SQ_RING_BYTES, 0), (CQ_RING, CQ_RING_BYTES, IORING_OFF_CQ_RING), (SQES, SQES_BYTES, IORING_OFF_SQES)]
+        {
+            let mapped = ir.new_label();
+            zero(ir, Reg::RDI);
+            mov(ir, Reg::RSI, mem(Reg::RBX, bytes));
+            mov(ir, Reg::RDX, Operand::Imm32(PROT_READ_WRITE));
+            mov(ir, Reg::R10, Operand::Imm32(MAP_SHARED_POPULATE));
+            mov(ir, Reg::R8, mem(Reg::RBX, FD));
+            mov(ir, Reg::R9, Operand::Imm32(offset));
+            mov(ir, Reg::RAX, Operand::Imm32(SYS_MMAP));
+            ir.emit(ADeadOp::Syscall);
+            ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(MAX_ERRNO) });
+            jcc(ir, Condition::BelowEq, mapped);
+            // Deshace lo ya mapeado y cierra el fd
+            self.release_uring(ir);
+            ir.emit(ADeadOp::Jmp { target: fail });
+            ir.emit(ADeadOp::Label(mapped));
+            store(ir, Reg::RBX, field, Reg::RAX);
+        }
+
+        let rings = [
+            (SQ_HEAD, SQ_RING, SQ_OFF),
+            (SQ_TAIL, SQ_RING, SQ_OFF + 4),
+            (SQ_ARRAY, SQ_RING, SQ_OFF + 24),
+            (CQ_HEAD, CQ_RING, CQ_OFF),
+            (CQ_TAIL, CQ_RING, CQ_OFF + 4),
+            (CQES, CQ_RING, CQ_OFF + 20),
+        ];
+        for (field, ring, offset) in rings {
+            ir.emit(ADeadOp::Load32 { dst: Reg::RAX, base: Reg::RBX, disp: offset });
+            ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: mem(Reg::RBX, ring) });
+            store(ir, Reg::RBX, field, Reg::RAX);
+        }
+        for (field, ring, offset) in [(SQ_MASK, SQ_RING, SQ_OFF + 8), (CQ_MASK, CQ_RING, CQ_OFF + 8)] {
+            ir.emit(ADeadOp::Load32 { dst: Reg::RCX, base: Reg::RBX, disp: offset });
+            ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RCX), src: mem(Reg::RBX, ring) });
+            ir.emit(ADeadOp::Load32 { dst: Reg::RAX, base: Reg::RCX, disp: 0 });
+            store(ir, Reg::RBX, field, Reg::RAX);
+        }
+    }
+
+    /// Puerto IOCP y pila de ranuras libres; RBX = cabecera, R12 = entradas
+    fn create_port(ir: &mut ADeadIR, create_port: u32, fail: Label) {
+        let top = ir.new_label();
+        mov(ir, Reg::RCX, Operand::Imm32(-1));
+        zero(ir, Reg::RDX);
+        zero(ir, Reg::R8);
+        zero(ir, Reg::R9);
+        call_iat(ir, create_port);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, fail);
+        store(ir, Reg::RBX, PORT, Reg::RAX);
+        ir.emit(ADeadOp::Lea { dst: Reg::RAX, src: mem(Reg::RBX, HEADER_BYTES) });
+        ir.emit(ADeadOp::Label(top));
+        mov(ir, Reg::RCX, mem(Reg::RBX, FREE));
+        store(ir, Reg::RAX, SLOT_NEXT, Reg::RCX);
+        store(ir, Reg::RBX, FREE, Reg::RAX);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Imm32(SLOT_BYTES) });
+        ir.emit(ADeadOp::Dec { dst: Operand::Reg(Reg::R12) });
+        jcc(ir, Condition::NotEqual, top);
+    }
+
+    /// RBX = anillo: desmapea los anillos ya mapeados y cierra el fd
+    fn release_uring(&self, ir: &mut ADeadIR) {
+        for (field, bytes) in [(SQES, SQES_BYTES), (CQ_RING, CQ_RING_BYTES), (SQ_RING, SQ_RING_BYTES)] {
+            let skip = ir.new_label();
+            mov(ir, Reg::RCX, mem(Reg::RBX, field));
+            ir.emit(ADeadOp::Test { left: Reg::RCX, right: Reg::RCX });
+            jcc(ir, Condition::Equal, skip);
+            mov(ir, Reg::RDX, mem(Reg::RBX, bytes));
+            call(ir, self.unmap);
+            ir.emit(ADeadOp::Label(skip));
+        }
+        mov(ir, Reg::RDI, mem(Reg::RBX, FD));
+        mov(ir, Reg::RAX, Operand::Imm32(SYS_CLOSE));
+        ir.emit(ADeadOp::Syscall);
+    }
+
+    fn emit_register(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.register));
+        match self.api {
+            AioApi::IoUring => {
+                self.enter(ir);
+                mov(ir, Reg::RDI, mem(Reg::RBX, FD));
+                mov(ir, Reg::RSI, Operand::Imm32(IORING_REGISTER_BUFFERS));
+                mov(ir, Reg::RDX, Operand::Reg(Reg::R12));
+                mov(ir, Reg::R10, Operand::Reg(Reg::R13));
+                low32(ir, Reg::R10);
+                mov(ir, Reg::RAX, Operand::Imm32(SYS_IO_URING_REGISTER));
+                ir.emit(ADeadOp::Syscall);
+                self.leave(ir);
+            }
+            AioApi::Iocp { .. } => {
+                zero(ir, Reg::RAX);
+                ir.emit(ADeadOp::Ret);
+            }
+        }
+    }
+
+    fn emit_queue(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.queue));
+        self.enter(ir);
+        mov(ir, Reg::RSI, Operand::Reg(Reg::R12));
+        self.queue_one(ir);
+        self.leave(ir);
+    }
+
+    fn emit_queue_batch(&self, ir: &mut ADeadIR) {
+        let top = ir.new_label();
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(self.queue_batch));
+        self.enter(ir);
+        low32(ir, Reg::R13);
+        zero(ir, Reg::R15);
+        ir.emit(ADeadOp::Label(top));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R15), right: Operand::Reg(Reg::R13) });
+        jcc(ir, Condition::AboveEq, done);
+        mov(ir, Reg::RSI, Operand::Imm32(REQ_BYTES));
+        ir.emit(ADeadOp::Mul { dst: Reg::RSI, src: Reg::R15 });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSI), src: Operand::Reg(Reg::R12) });
+        self.queue_one(ir);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::NotEqual, done);
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R15) });
+        ir.emit(ADeadOp::Jmp { target: top });
+        ir.emit(ADeadOp::Label(done));
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R15));
+        self.leave(ir);
+    }
+
+    /// RBX = anillo, RSI = petición → RAX = 0, o -1 si está lleno
+    fn queue_one(&self, ir: &mut ADeadIR) {
+        let full = ir.new_label();
+        let done = ir.new_label();
+        match self.api {
+            AioApi::IoUring => {
+                // Lleno cuando la cola local va `entradas` por delante de
+                // la cabeza que consume el kernel
+                mov(ir, Reg::RAX, mem(Reg::RBX, TAIL));
+                mov(ir, Reg::RCX, mem(Reg::RBX, SQ_HEAD));
+                ir.emit(ADeadOp::Load32 { dst: Reg::RCX, base: Reg::RCX, disp: 0 });
+                mov(ir, Reg::RDX, Operand::Reg(Reg::RAX));
+                ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RDX), src: Operand::Reg(Reg::RCX) });
+                low32(ir, Reg::RDX);
+                ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RDX), right: mem(Reg::RBX, ENTRIES) });
+                jcc(ir, Condition::AboveEq, full);
+                mov(ir, Reg::RCX, mem(Reg::RBX, SQ_MASK));
+                ir.emit(ADeadOp::And { dst: Reg::RAX, src: Reg::RCX });
+                // array[i] = i y RDX = &sqes[i]
+                mov(ir, Reg::RCX, mem(Reg::RBX, SQ_ARRAY));
+                ir.emit(ADeadOp::Lea {
+                    dst: Reg::RCX,
+                    src: Operand::MemSIB { base: Reg::RCX, index: Reg::RAX, scale: 4, disp: 0 },
+                });
+                ir.emit(ADeadOp::Store32 { base: Reg::RCX, disp: 0, src: Reg::RAX });
+                mov(ir, Reg::RDX, Operand::Reg(Reg::RAX));
+                ir.emit(ADeadOp::Shl { dst: Reg::RDX, amount: 6 });
+                ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RDX), src: mem(Reg::RBX, SQES) });
+                zero(ir, Reg::RCX);
+                for disp in (0..64).step_by(8) {
+                    store(ir, Reg::RDX, disp, Reg::RCX);
+                }
+                // opcode@0, fd@4, off@8, addr@16, len@24, user_data@32, buf_index@40
+                mov(ir, Reg::RCX, mem(Reg::RSI, REQ_OP));
+                ir.emit(ADeadOp::Store8 { base: Reg::RDX, disp: 0, src: Reg::RCX });
+                mov(ir, Reg::RCX, mem(Reg::RSI, REQ_FD));
+                ir.emit(ADeadOp::Store32 { base: Reg::RDX, disp: 4, src: Reg::RCX });
+                mov(ir, Reg::RCX, mem(Reg::RSI, REQ_OFFSET));
+                store(ir, Reg::RDX, 8, Reg::RCX);
+                mov(ir, Reg::RCX, mem(Reg::RSI, REQ_BUF));
+                store(ir, Reg::RDX, 16, Reg::RCX);
+                mov(ir, Reg::RCX, mem(Reg::RSI, REQ_LEN));
+                ir.emit(ADeadOp::Store32 { base: Reg::RDX, disp: 24, src: Reg::RCX });
+                mov(ir, Reg::RCX, mem(Reg::RSI, REQ_USER_DATA));
+                store(ir, Reg::RDX, 32, Reg::RCX);
+                mov(ir, Reg::RCX, mem(Reg::RSI, REQ_BUF_INDEX));
+                ir.emit(ADeadOp::Store16 { base: Reg::RDX, disp: 40, src: Reg::RCX });
+                ir.emit(ADeadOp::Inc { dst: mem(Reg::RBX, TAIL) });
+            }
+            AioApi::Iocp { .. } => {
+                let empty = ir.new_label();
+                let linked = ir.new_label();
+                mov(ir, Reg::RAX, mem(Reg::RBX, FREE));
+                ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+                jcc(ir, Condition::Equal, full);
+                mov(ir, Reg::RCX, mem(Reg::RAX, SLOT_NEXT));
+                store(ir, Reg::RBX, FREE, Reg::RCX);
+                zero(ir, Reg::RCX);
+                for disp in [0, 8, 24, SLOT_NEXT, SLOT_ERROR] {
+                    store(ir, Reg::RAX, disp, Reg::RCX);
+                }
+                for (from, to) in [
+                    (REQ_OFFSET, SLOT_OFFSET),
+                    (REQ_USER_DATA, SLOT_USER_DATA),
+                    (REQ_FD, SLOT_HANDLE),
+                    (REQ_BUF, SLOT_BUF),
+                    (REQ_LEN, SLOT_LEN),
+                    (REQ_OP, SLOT_OP),
+                ] {
+                    mov(ir, Reg::RCX, mem(Reg::RSI, from));
+                    store(ir, Reg::RAX, to, Reg::RCX);
+                }
+                // Al final de la lista de pendientes, en orden
+                mov(ir, Reg::RCX, mem(Reg::RBX, LAST));
+                ir.emit(ADeadOp::Test { left: Reg::RCX, right: Reg::RCX });
+                jcc(ir, Condition::Equal, empty);
+                store(ir, Reg::RCX, SLOT_NEXT, Reg::RAX);
+                ir.emit(ADeadOp::Jmp { target: linked });
+                ir.emit(ADeadOp::Label(empty));
+                store(ir, Reg::RBX, FIRST, Reg::RAX);
+                ir.emit(ADeadOp::Label(linked));
+                store(ir, Reg::RBX, LAST, Reg::RAX);
+            }
+        }
+        ir.emit(ADeadOp::Inc { dst: mem(Reg::RBX, QUEUED) });
+        zero(ir, Reg::RAX);
+        ir.emit(ADeadOp::Jmp { target: done });
+        ir.emit(ADeadOp::Label(full));
+        mov(ir, Reg::RAX, Operand::Imm32(-1));
+        ir.emit(ADeadOp::Label(done));
+    }
+
+    fn emit_submit(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.submit));
+        self.enter(ir);
+        zero(ir, Reg::R15);
+        self.send(ir);
+        self.leave(ir);
+    }
+
+    /// RBX = anillo: envía lo encolado → RAX = enviadas, o -errno.
+    /// Linux: R15 = terminaciones mínimas a esperar en el mismo enter
+    fn send(&self, ir: &mut ADeadIR) {
+        let done = ir.new_label();
+        match self.api {
+            AioApi::IoUring => {
+                let flags = ir.new_label();
+                // Publicar la cola: las SQEs ya están escritas (TSO)
+                mov(ir, Reg::RAX, mem(Reg::RBX, TAIL));
+                mov(ir, Reg::RCX, mem(Reg::RBX, SQ_TAIL));
+                ir.emit(ADeadOp::Store32 { base: Reg::RCX, disp: 0, src: Reg::RAX });
+                mov(ir, Reg::RSI, mem(Reg::RBX, QUEUED));
+                mov(ir, Reg::RDX, Operand::Reg(Reg::R15));
+                zero(ir, Reg::R10);
+                ir.emit(ADeadOp::Test { left: Reg::RDX, right: Reg::RDX });
+                jcc(ir, Condition::Equal, flags);
+                mov(ir, Reg::R10, Operand::Imm32(IORING_ENTER_GETEVENTS));
+                ir.emit(ADeadOp::Label(flags));
+                // Nada que enviar ni esperar: sin syscall
+                mov(ir, Reg::RAX, Operand::Reg(Reg::RSI));
+                ir.emit(ADeadOp::Or { dst: Reg::RAX, src: Reg::RDX });
+                jcc(ir, Condition::Equal, done);
+                mov(ir, Reg::RDI, mem(Reg::RBX, FD));
+                zero(ir, Reg::R8);
+                zero(ir, Reg::R9);
+                mov(ir, Reg::RAX, Operand::Imm32(SYS_IO_URING_ENTER));
+                ir.emit(ADeadOp::Syscall);
+                ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(MAX_ERRNO) });
+                jcc(ir, Condition::Above, done);
+                mov(ir, Reg::RCX, mem(Reg::RBX, QUEUED));
+                ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RCX), src: Operand::Reg(Reg::RAX) });
+                store(ir, Reg::RBX, QUEUED, Reg::RCX);
+                ir.emit(ADeadOp::Label(done));
+            }
+            AioApi::Iocp { create_port, post_queued, read_file, write_file, get_last_error, .. } => {
+                let top = ir.new_label();
+                let associated = ir.new_label();
+                let read = ir.new_label();
+                let write = ir.new_label();
+                let issued = ir.new_label();
+                let failed = ir.new_label();
+                let next = ir.new_label();
+                // RDI = ranura, RSI = enviadas; la lista queda vacía
+                zero(ir, Reg::RSI);
+                mov(ir, Reg::RDI, mem(Reg::RBX, FIRST));
+                for field in [FIRST, LAST, QUEUED] {
+                    store(ir, Reg::RBX, field, Reg::RSI);
+                }
+                ir.emit(ADeadOp::Label(top));
+                ir.emit(ADeadOp::Test { left: Reg::RDI, right: Reg::RDI });
+                jcc(ir, Condition::Equal, done);
+                // Asociar el HANDLE al puerto una vez (se recuerda el último;
+                // repetir la asociación falla sin efecto)
+                mov(ir, Reg::RCX, mem(Reg::RDI, SLOT_HANDLE));
+                ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: mem(Reg::RBX, ASSOCIATED) });
+                jcc(ir, Condition::Equal, associated);
+                store(ir, Reg::RBX, ASSOCIATED, Reg::RCX);
+                mov(ir, Reg::RDX, mem(Reg::RBX, PORT));
+                zero(ir, Reg::R8);
+                zero(ir, Reg::R9);
+                call_iat(ir, create_port);
+                ir.emit(ADeadOp::Label(associated));
+                mov(ir, Reg::RAX, mem(Reg::RDI, SLOT_OP));
+                for (op, target) in [
+                    (OP_READ, read),
+                    (OP_READ_FIXED, read),
+                    (OP_RECV, read),
+                    (OP_WRITE, write),
+                    (OP_WRITE_FIXED, write),
+                    (OP_SEND, write),
+                ] {
+                    ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(op) });
+                    jcc(ir, Condition::Equal, target);
+                }
+                mov(ir, Reg::RCX, Operand::Imm32(ERROR_INVALID_FUNCTION));
+                ir.emit(ADeadOp::Jmp { target: failed });
+                // ReadFile/WriteFile(h, buf, len, NULL, &ov)
+                for (label, rva) in [(read, read_file), (write, write_file)] {
+                    ir.emit(ADeadOp::Label(label));
+                    mov(ir, Reg::RCX, mem(Reg::RDI, SLOT_HANDLE));
+                    mov(ir, Reg::RDX, mem(Reg::RDI, SLOT_BUF));
+                    mov(ir, Reg::R8, mem(Reg::RDI, SLOT_LEN));
+                    zero(ir, Reg::R9);
+                    store(ir, Reg::RSP, 32, Reg::RDI);
+                    call_iat(ir, rva);
+                    ir.emit(ADeadOp::Jmp { target: issued });
+                }
+                // Terminado ya o en curso: el paquete llega al puerto
+                ir.emit(ADeadOp::Label(issued));
+                ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+                jcc(ir, Condition::NotEqual, next);
+                call_iat(ir, get_last_error);
+                ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(ERROR_IO_PENDING) });
+                jcc(ir, Condition::Equal, next);
+                mov(ir, Reg::RCX, Operand::Reg(Reg::RAX));
+                // Fallo inmediato: PostQueuedCompletionStatus(port, 0, 1, &ov)
+                ir.emit(ADeadOp::Label(failed));
+                store(ir, Reg::RDI, SLOT_ERROR, Reg::RCX);
+                mov(ir, Reg::RCX, mem(Reg::RBX, PORT));
+                zero(ir, Reg::RDX);
+                mov(ir, Reg::R8, Operand::Imm32(1));
+                mov(ir, Reg::R9, Operand::Reg(Reg::RDI));
+                call_iat(ir, post_queued);
+                ir.emit(ADeadOp::Label(next));
+                ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::RSI) });
+                mov(ir, Reg::RDI, mem(Reg::RDI, SLOT_NEXT));
+                ir.emit(ADeadOp::Jmp { target: top });
+                ir.emit(ADeadOp::Label(done));
+                mov(ir, Reg::RAX, Operand::Reg(Reg::RSI));
+            }
+        }
+    }
+
+    fn emit_wait(&self, ir: &mut ADeadIR) {
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.wait));
+        self.enter(ir);
+        // R12 = salida, R13 = máximo, R14 = mínimo (nunca más que el máximo)
+        low32(ir, Reg::R13);
+        low32(ir, Reg::R14);
+        clamp(ir, Reg::R14, Reg::R13);
+        match self.api {
+            AioApi::IoUring => {
+                let top = ir.new_label();
+                let done = ir.new_label();
+                mov(ir, Reg::R15, Operand::Reg(Reg::R14));
+                self.send(ir);
+                ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(MAX_ERRNO) });
+                jcc(ir, Condition::Above, out);
+                // R8 = cabeza, R10 = listas (hasta el máximo), R11 = i
+                mov(ir, Reg::RCX, mem(Reg::RBX, CQ_HEAD));
+                ir.emit(ADeadOp::Load32 { dst: Reg::R8, base: Reg::RCX, disp: 0 });
+                mov(ir, Reg::RCX, mem(Reg::RBX, CQ_TAIL));
+                ir.emit(ADeadOp::Load32 { dst: Reg::R10, base: Reg::RCX, disp: 0 });
+                ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::R10), src: Operand::Reg(Reg::R8) });
+                low32(ir, Reg::R10);
+                clamp(ir, Reg::R10, Reg::R13);
+                zero(ir, Reg::R11);
+                ir.emit(ADeadOp::Label(top));
+                ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R11), right: Operand::Reg(Reg::R10) });
+                jcc(ir, Condition::AboveEq, done);
+                mov(ir, Reg::RDX, Operand::Reg(Reg::R8));
+                ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RDX), src: Operand::Reg(Reg::R11) });
+                mov(ir, Reg::RCX, mem(Reg::RBX, CQ_MASK));
+                ir.emit(ADeadOp::And { dst: Reg::RDX, src: Reg::RCX });
+                ir.emit(ADeadOp::Shl { dst: Reg::RDX, amount: 4 });
+                ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RDX), src: mem(Reg::RBX, CQES) });
+                mov(ir, Reg::RSI, Operand::Reg(Reg::R11));
+                ir.emit(ADeadOp::Shl { dst: Reg::RSI, amount: 4 });
+                ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSI), src: Operand::Reg(Reg::R12) });
+                // CQE: user_data@0, res@8 (i32)
+                mov(ir, Reg::RCX, mem(Reg::RDX, 0));
+                store(ir, Reg::RSI, 0, Reg::RCX);
+                ir.emit(ADeadOp::Load32 { dst: Reg::RCX, base: Reg::RDX, disp: 8 });
+                ir.emit(ADeadOp::Shl { dst: Reg::RCX, amount: 32 });
+                ir.emit(ADeadOp::Sar { dst: Reg::RCX, amount: 32 });
+                store(ir, Reg::RSI, CQE_RESULT, Reg::RCX);
+                ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R11) });
+                ir.emit(ADeadOp::Jmp { target: top });
+                // Devolver las CQEs al kernel
+                ir.emit(ADeadOp::Label(done));
+                ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::R8), src: Operand::Reg(Reg::R10) });
+                mov(ir, Reg::RCX, mem(Reg::RBX, CQ_HEAD));
+                ir.emit(ADeadOp::Store32 { base: Reg::RCX, disp: 0, src: Reg::R8 });
+                mov(ir, Reg::RAX, Operand::Reg(Reg::R10));
+            }
+            AioApi::Iocp { get_queued, .. } => {
+                let top = ir.new_label();
+                let forever = ir.new_label();
+                let entry = ir.new_label();
+                let io = ir.new_label();
+                let bytes = ir.new_label();
+                let result = ir.new_label();
+                let done = ir.new_label();
+                self.send(ir);
+                // R15 = copiadas
+                zero(ir, Reg::R15);
+                ir.emit(ADeadOp::Label(top));
+                ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R15), right: Operand::Reg(Reg::R13) });
+                jcc(ir, Condition::AboveEq, done);
+                // Bloquea mientras falten para el mínimo; si no, solo recoge
+                mov(ir, Reg::RAX, Operand::Imm32(INFINITE));
+                ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R15), right: Operand::Reg(Reg::R14) });
+                jcc(ir, Condition::Below, forever);
+                zero(ir, Reg::RAX);
+                ir.emit(ADeadOp::Label(forever));
+                store(ir, Reg::RSP, 32, Reg::RAX);
+                zero(ir, Reg::RAX);
+                store(ir, Reg::RSP, 40, Reg::RAX);
+                mov(ir, Reg::R8, Operand::Reg(Reg::R13));
+                ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::R8), src: Operand::Reg(Reg::R15) });
+                mov(ir, Reg::RAX, Operand::Imm32(MAX_EVENTS));
+                clamp(ir, Reg::R8, Reg::RAX);
+                // GetQueuedCompletionStatusEx(port, entries, n, &removed, timeout, FALSE)
+                mov(ir, Reg::RCX, mem(Reg::RBX, PORT));
+                ir.emit(ADeadOp::Lea { dst: Reg::RDX, src: mem(Reg::RBX, EVENTS) });
+                ir.emit(ADeadOp::Lea { dst: Reg::R9, src: mem(Reg::RBX, REMOVED) });
+                call_iat(ir, get_queued);
+                ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+                jcc(ir, Condition::Equal, done);
+                // RDI = quedan, RSI = OVERLAPPED_ENTRY {clave, ov, Internal, bytes}
+                ir.emit(ADeadOp::Load32 { dst: Reg::RDI, base: Reg::RBX, disp: REMOVED });
+                ir.emit(ADeadOp::Lea { dst: Reg::RSI, src: mem(Reg::RBX, EVENTS) });
+                ir.emit(ADeadOp::Label(entry));
+                ir.emit(ADeadOp::Test { left: Reg::RDI, right: Reg::RDI });
+                jcc(ir, Condition::Equal, top);
+                mov(ir, Reg::RCX, mem(Reg::RSI, 8));
+                mov(ir, Reg::RDX, Operand::Reg(Reg::R15));
+                ir.emit(ADeadOp::Shl { dst: Reg::RDX, amount: 4 });
+                ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RDX), src: Operand::Reg(Reg::R12) });
+                mov(ir, Reg::RAX, mem(Reg::RCX, SLOT_USER_DATA));
+                store(ir, Reg::RDX, 0, Reg::RAX);
+                // Clave 1: fallo inmediato con el error Win32 en la ranura
+                mov(ir, Reg::RAX, mem(Reg::RSI, 0));
+                ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+                jcc(ir, Condition::Equal, io);
+                mov(ir, Reg::RAX, mem(Reg::RCX, SLOT_ERROR));
+                ir.emit(ADeadOp::Neg { dst: Reg::RAX });
+                ir.emit(ADeadOp::Jmp { target: result });
+                // NTSTATUS: 0 → bytes, fin de fichero → 0, si no el estado
+                ir.emit(ADeadOp::Label(io));
+                ir.emit(ADeadOp::Load32 { dst: Reg::RAX, base: Reg::RSI, disp: 16 });
+                ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+                jcc(ir, Condition::Equal, bytes);
+                ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: 32 });
+                ir.emit(ADeadOp::Sar { dst: Reg::RAX, amount: 32 });
+                ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(STATUS_END_OF_FILE) });
+                jcc(ir, Condition::NotEqual, result);
+                ir.emit(ADeadOp::Label(bytes));
+                ir.emit(ADeadOp::Load32 { dst: Reg::RAX, base: Reg::RSI, disp: 24 });
+                ir.emit(ADeadOp::Label(result));
+                store(ir, Reg::RDX, CQE_RESULT, Reg::RAX);
+                // La ranura vuelve a la pila libre
+                mov(ir, Reg::RAX, mem(Reg::RBX, FREE));
+                store(ir, Reg::RCX, SLOT_NEXT, Reg::RAX);
+                store(ir, Reg::RBX, FREE, Reg::RCX);
+                ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R15) });
+                ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSI), src: Operand::Imm32(32) });
+                ir.emit(ADeadOp::Dec { dst: Operand::Reg(Reg::RDI) });
+                ir.emit(ADeadOp::Jmp { target: entry });
+                ir.emit(ADeadOp::Label(done));
+                mov(ir, Reg::RAX, Operand::Reg(Reg::R15));
+            }
+        }
+        ir.emit(ADeadOp::Label(out));
+        self.leave(ir);
+    }
+
+    fn emit_destroy(&self, ir: &mut ADeadIR) {
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.destroy));
+        self.enter(ir);
+        ir.emit(ADeadOp::Test { left: Reg::RBX, right: Reg::RBX });
+        jcc(ir, Condition::Equal, out);
+        match self.api {
+            AioApi::IoUring => self.release_uring(ir),
+            AioApi::Iocp { close_handle, .. } => {
+                mov(ir, Reg::RCX, mem(Reg::RBX, PORT));
+                call_iat(ir, close_handle);
+            }
+        }
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RBX));
+        mov(ir, Reg::RDX, mem(Reg::RBX, BYTES));
+        call(ir, self.unmap);
+        ir.emit(ADeadOp::Label(out));
+        zero(ir, Reg::RAX);
+        self.leave(ir);
+    }
+}
+
+#[cfg(all(test, target_os = "linux", target_arch = "x86_64"))]
+mod tests {
+    use super::*;
+    use crate::isa::encoder::Encoder;
+    use crate::isa::test_jit::JitCode;
+    use std::io::Write;
+    use std::os::unix::io::AsRawFd;
+
+    #[repr(C)]
+    #[derive(Clone, Copy, Default)]
+    struct Req {
+        op: i64,
+        fd: i64,
+        buf: u64,
+        len: u64,
+        offset: i64,
+        user_data: u64,
+        buf_index: i64,
+    }
+
+    #[repr(C)]
+    #[derive(Clone, Copy, Default)]
+    struct Cqe {
+        user_data: u64,
+        result: i64,
+    }
+
+    #[test]
+    fn test_iocp_encodes() {
+        let mut ir = ADeadIR::new();
+        let api = AioApi::Iocp {
+            create_port: 0x1000,
+            get_queued: 0x1008,
+            post_queued: 0x1010,
+            read_file: 0x1018,
+            write_file: 0x1020,
+            close_handle: 0x1028,
+            get_last_error: 0x1030,
+        };
+        let pages = PageSource::Iat { alloc_rva: 0x1038, free_rva: 0x1040 };
+        let aio = AsyncIo::new(&mut ir, api, pages);
+        aio.emit_routines(&mut ir);
+        let result = Encoder::new().encode_all(ir.ops());
+        for name in ["adb_ring_create", "adb_ring_submit", "adb_ring_wait", "adb_ring_destroy"] {
+            assert!(result.label_offsets.contains_key(&aio.routine(name).unwrap().0));
+        }
+    }
+
+    #[test]
+    fn test_io_uring_routines() {
+        let mut ir = ADeadIR::new();
+        let aio = AsyncIo::new(&mut ir, AioApi::IoUring, PageSource::Syscall);
+        aio.emit_routines(&mut ir);
+        let code = JitCode::new(ir.ops());
+
+        let dir = std::env::temp_dir();
+        let src_path = dir.join(format!("adb_aio_src_{}", std::process::id()));
+        let dst_path = dir.join(format!("adb_aio_dst_{}", std::process::id()));
+        let data: Vec<u8> = (0..16384u32).map(|i| (i * 7 + 3) as u8).collect();
+        std::fs::File::create(&src_path).unwrap().write_all(&data).unwrap();
+        let src = std::fs::File::open(&src_path).unwrap();
+        let dst = std::fs::File::create(&dst_path).unwrap();
+
+        unsafe {
+            let create: extern "C" fn(u64) -> i64 = code.func(aio.create);
+            let register: extern "C" fn(i64, *const [u64; 2], u64) -> i64 = code.func(aio.register);
+            let queue: extern "C" fn(i64, *const Req) -> i64 = code.func(aio.queue);
+            let queue_batch: extern "C" fn(i64, *const Req, u64) -> i64 = code.func(aio.queue_batch);
+            let submit: extern "C" fn(i64) -> i64 = code.func(aio.submit);
+            let wait: extern "C" fn(i64, *mut Cqe, u64, u64) -> i64 = code.func(aio.wait);
+            let destroy: extern "C" fn(i64) -> i64 = code.func(aio.destroy);
+
+            let ring = create(8);
+            // Kernels sin io_uring (o con él deshabilitado por sysctl)
+            if ring == 0 {
+                eprintln!("io_uring no disponible: se omite la prueba");
+                return;
+            }
+            assert_eq!(submit(ring), 0);
+
+            // Un lote de lecturas a distintos desplazamientos
+            let mut bufs = vec![[0u8; 1024]; 4];
+            let reqs: Vec<Req> = (0..4)
+                .map(|i| Req {
+                    op: OP_READ as i64,
+                    fd: src.as_raw_fd() as i64,
+                    buf: bufs[i].as_mut_ptr() as u64,
+                    len: 1024,
+                    offset: (i * 4096) as i64,
+                    user_data: 100 + i as u64,
+                    buf_index: 0,
+                })
+                .collect();
+            assert_eq!(queue_batch(ring, reqs.as_ptr(), 4), 4);
+            let mut cqes = [Cqe::default(); 8];
+            let mut seen = 0;
+            while seen < 4 {
+                let n = wait(ring, cqes.as_mut_ptr(), 8, 1);
+                assert!(n > 0, "wait = {}", n);
+                for cqe in &cqes[..n as usize] {
+                    assert!((100..104).contains(&cqe.user_data));
+                    assert_eq!(cqe.result, 1024);
+                }
+                seen += n;
+            }
+            for (i, buf) in bufs.iter().enumerate() {
+                assert_eq!(&buf[..], &data[i * 4096..i * 4096 + 1024]);
+            }
+
+            // El anillo se llena (8 entradas) y luego se vacía esperando
+            let one = Req { user_data: 7, ..reqs[0] };
+            for _ in 0..8 {
+                assert_eq!(queue(ring, &one), 0);
+            }
+            assert_eq!(queue(ring, &one), -1);
+            assert_eq!(submit(ring), 8);
+            let mut seen = 0;
+            while seen < 8 {
+                seen += wait(ring, cqes.as_mut_ptr(), 8, 8 - seen as u64);
+            }
+
+            // Búfer registrado: WRITE_FIXED a otro fichero y READ_FIXED
+            let mut fixed = vec![0u8; 8192];
+            fixed[..4096].copy_from_slice(&data[..4096]);
+            let iov = [[fixed.as_mut_ptr() as u64, fixed.len() as u64]];
+            let registered = register(ring, iov.as_ptr(), 1);
+            if registered == 0 {
+                let write = Req {
+                    op: OP_WRITE_FIXED as i64,
+                    fd: dst.as_raw_fd() as i64,
+                    buf: fixed.as_ptr() as u64,
+                    len: 4096,
+                    offset: 0,
+                    user_data: 1,
+                    buf_index: 0,
+                };
+                assert_eq!(queue(ring, &write), 0);
+                assert_eq!(wait(ring, cqes.as_mut_ptr(), 1, 1), 1);
+                assert_eq!((cqes[0].user_data, cqes[0].result), (1, 4096));
+                assert_eq!(std::fs::read(&dst_path).unwrap(), &data[..4096]);
+
+                let read = Req {
+                    op: OP_READ_FIXED as i64,
+                    fd: src.as_raw_fd() as i64,
+                    buf: fixed.as_ptr().add(4096) as u64,
+                    len: 4096,
+                    offset: 8192,
+                    user_data: 2,
+                    buf_index: 0,
+                };
+                assert_eq!(queue(ring, &read), 0);
+                assert_eq!(wait(ring, cqes.as_mut_ptr(), 1, 1), 1);
+                assert_eq!((cqes[0].user_data, cqes[0].result), (2, 4096));
+                assert_eq!(&fixed[4096..], &data[8192..12288]);
+            } else {
+                // RLIMIT_MEMLOCK bajo: -ENOMEM
+                assert!(registered < 0);
+            }
+
+            // Errores llegan como -errno en la terminación
+            let bad = Req { fd: -1, user_data: 9, ..reqs[0] };
+            assert_eq!(queue(ring, &bad), 0);
+            assert_eq!(wait(ring, cqes.as_mut_ptr(), 1, 1), 1);
+            assert_eq!((cqes[0].user_data, cqes[0].result), (9, -9));
+
+            destroy(ring);
+        }
+        std::fs::remove_file(&src_path).ok();
+        std::fs::remove_file(&dst_path).ok();
+    }
+}
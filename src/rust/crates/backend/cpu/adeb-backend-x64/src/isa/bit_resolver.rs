@@ -62,6 +62,8 @@ impl BitTarget {
             "fastos256" => Some(BitTarget::Bits256),
             "auto" => Some(BitTarget::BitsAuto),
             "all" => Some(BitTarget::Bits64), // default for multi-target
+            "sse" | "sse2" => Some(BitTarget::Bits128),
+            "avx2" => Some(BitTarget::Bits256),
             _ => None,
         }
     }
@@ -0,0 +1,739 @@
+// ============================================================
+// ADead-BIB — Kernels densos float (AVX2 + FMA)
+// ============================================================
+// VectorAdd, SAXPY, reducción y MatMul en x86-64, pensados como
+// fallback CPU del pipeline unificado. Por ahora es una biblioteca
+// suelta: ningún camino compilado los genera (UnifiedPipeline no se
+// compila y el backend GPU no depende de este crate).
+// Cada kernel se genera para un tamaño fijo (el que se conoce al
+// compilar): los contadores de bucle, strides y colas son
+// inmediatos, sin aritmética de índices en runtime.
+//
+// ABI System V, la entrada es el offset 0 del código:
+//
+//   vector_add(a, b, c)        rdi, rsi, rdx        c = a + b
+//   saxpy(x, y, alpha)         rdi, rsi, xmm0       y = alpha·x + y
+//   sum(x) -> float            rdi → xmm0
+//   sgemm(a, b, c, work)       rdi, rsi, rdx, rcx   C = A·B row-major
+//                              (A m×k, B k×n, `work` de
+//                               `sgemm_workspace_bytes` bytes)
+//
+// Los kernels BLAS-1 van en bloques de 8 lanes desenrollados (4 en
+// add/saxpy, 8 acumuladores independientes en sum, que luego se
+// combinan en árbol); la cola de n % 8 usa VMASKMOVPS, así que nunca
+// se lee ni se escribe fuera de los arrays.
+//
+// SGEMM sigue el esquema de GotoBLAS/BLIS: B se empaqueta en bloques
+// KC×NC (L3) y A en bloques MC×KC (L2), en paneles de NR columnas y MR
+// filas contiguos en el orden en que los lee el micro-kernel 6×16
+// (12 acumuladores ymm, 2 cargas de B y un broadcast de A por paso de
+// k). Los bordes de m y n se rellenan con ceros al empaquetar y se
+// guardan con máscara; el primer bloque de k escribe C y los demás
+// acumulan, así que C no necesita inicializarse.
+// ============================================================
+
+use std::collections::HashMap;
+
+use super::encoder::Encoder;
+use super::vex_emitter::{AvxInst, FpOp, VexEmitter, VexMem};
+use super::ymm_allocator::YmmReg;
+use super::{ADeadIR, ADeadOp, CallTarget, Condition, Label, Operand, Reg};
+
+/// Filas × columnas del micro-kernel de SGEMM
+pub const SGEMM_MR: usize = 6;
+pub const SGEMM_NR: usize = 16;
+/// Bloques de caché de SGEMM: A empaquetado MC×KC, B empaquetado KC×NC
+pub const SGEMM_MC: usize = 72;
+pub const SGEMM_KC: usize = 256;
+pub const SGEMM_NC: usize = 1024;
+
+// Encodings GP para VexMem
+const RAX: u8 = 0;
+const RDX: u8 = 2;
+const RSI: u8 = 6;
+const RDI: u8 = 7;
+const R8: u8 = 8;
+const R9: u8 = 9;
+const R10: u8 = 10;
+const R11: u8 = 11;
+
+/// Mayor array (en floats) cuyos offsets en bytes caben en un disp32
+const MAX_ELEMENTS: usize = (i32::MAX / 4) as usize;
+
+/// Kernel denso con sus dimensiones
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum DenseKernel {
+    VectorAdd { n: usize },
+    Saxpy { n: usize },
+    Sum { n: usize },
+    Sgemm { m: usize, n: usize, k: usize },
+}
+
+impl DenseKernel {
+    /// Emite la rutina en `ir`; la entrada es el primer op emitido.
+    /// Panics si algún array pasa de 2 GiB (los offsets son disp32).
+    pub fn emit(&self, ir: &mut ADeadIR) {
+        let masks = ir.new_label();
+        match *self {
+            DenseKernel::VectorAdd { n } => emit_vector_add(ir, n, masks),
+            DenseKernel::Saxpy { n } => emit_saxpy(ir, n, masks),
+            DenseKernel::Sum { n } => emit_sum(ir, n, masks),
+            DenseKernel::Sgemm { m, n, k } => Sgemm::new(ir, m, n, k, masks).emit(),
+        }
+        emit_mask_table(ir, masks);
+    }
+
+    /// Código máquina de la rutina (entrada en el offset 0)
+    pub fn encode(&self) -> Vec<u8> {
+        let mut ir = ADeadIR::new();
+        self.emit(&mut ir);
+        Encoder::new().encode_all(ir.ops()).code
+    }
+}
+
+/// Bytes de `work` que necesita `sgemm` para m×k · k×n
+pub fn sgemm_workspace_bytes(m: usize, n: usize, k: usize) -> usize {
+    let (a, b) = sgemm_panel_bytes(m, n, k);
+    a + b
+}
+
+/// (A empaquetado, B empaquetado) en bytes: un bloque de cada
+fn sgemm_panel_bytes(m: usize, n: usize, k: usize) -> (usize, usize) {
+    let kc = k.min(SGEMM_KC);
+    let mc = round_up(m.min(SGEMM_MC), SGEMM_MR);
+    let nc = round_up(n.min(SGEMM_NC), SGEMM_NR);
+    (mc * kc * 4, kc * nc * 4)
+}
+
+fn round_up(v: usize, to: usize) -> usize {
+    (v + to - 1) / to * to
+}
+
+fn ymm(i: usize) -> YmmReg {
+    YmmReg(i as u8)
+}
+
+fn avx(ir: &mut ADeadIR, insts: &[AvxInst]) {
+    let mut vex = VexEmitter::new();
+    vex.emit_all(insts);
+    ir.emit(ADeadOp::RawBytes(vex.into_bytes()));
+}
+
+fn imm(v: usize) -> Operand {
+    Operand::Imm32(v as i32)
+}
+
+fn add_imm(ir: &mut ADeadIR, reg: Reg, v: usize) {
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(reg), src: imm(v) });
+}
+
+fn mov(ir: &mut ADeadIR, dst: Reg, src: Reg) {
+    ir.emit(ADeadOp::Mov { dst: Operand::Reg(dst), src: Operand::Reg(src) });
+}
+
+fn lea(ir: &mut ADeadIR, dst: Reg, base: Reg, disp: usize) {
+    ir.emit(ADeadOp::Lea { dst, src: Operand::Mem { base, disp: disp as i32 } });
+}
+
+/// `dec counter; jnz top`
+fn loop_back(ir: &mut ADeadIR, counter: Reg, top: Label) {
+    ir.emit(ADeadOp::Dec { dst: Operand::Reg(counter) });
+    ir.emit(ADeadOp::Jcc { cond: Condition::NotEqual, target: top });
+}
+
+fn ret(ir: &mut ADeadIR) {
+    avx(ir, &[AvxInst::Vzeroupper]);
+    ir.emit(ADeadOp::Ret);
+}
+
+/// 8 dwords a -1 seguidos de 8 a 0: la máscara de los `w` primeros
+/// lanes es la ventana de 32 bytes que empieza en (8 - w)·4
+fn emit_mask_table(ir: &mut ADeadIR, masks: Label) {
+    ir.emit(ADeadOp::Label(masks));
+    let mut table = vec![0xFF; 32];
+    table.resize(64, 0);
+    ir.emit(ADeadOp::RawBytes(table));
+}
+
+/// ymm15 = máscara de los `lanes` primeros floats (toca R11)
+fn load_mask(ir: &mut ADeadIR, masks: Label, lanes: usize) {
+    debug_assert!(lanes > 0 && lanes < 8);
+    ir.emit(ADeadOp::LeaLabel { dst: Reg::R11, label: masks });
+    avx(ir, &[AvxInst::VmovdquLoad { dst: ymm(15), mem: VexMem::base(R11, ((8 - lanes) * 4) as i32) }]);
+}
+
+const MASK: YmmReg = YmmReg(15);
+
+// ============================================================
+// BLAS-1: recorrido en bloques de 8 lanes
+// ============================================================
+
+/// Recorre n floats con RAX como offset en bytes: `unroll` bloques por
+/// vuelta, los bloques completos sobrantes en línea y la cola con
+/// máscara en ymm15. `block(insts, slot, disp, masked)` emite un bloque
+/// en `[base + rax + disp]`; `slot` < `unroll` elige sus registros.
+fn emit_blocks(
+    ir: &mut ADeadIR,
+    n: usize,
+    unroll: usize,
+    masks: Label,
+    block: impl Fn(&mut Vec<AvxInst>, usize, i32, bool),
+) {
+    assert!(n <= MAX_ELEMENTS, "dense kernel of {} floats exceeds 2 GiB", n);
+    let (blocks, tail) = (n / 8, n % 8);
+    let (iters, rest) = (blocks / unroll, blocks % unroll);
+    ir.emit(ADeadOp::Xor { dst: Reg::EAX, src: Reg::EAX });
+    if iters > 0 {
+        let top = ir.new_label();
+        ir.emit(ADeadOp::Label(top));
+        let mut insts = Vec::new();
+        for slot in 0..unroll {
+            block(&mut insts, slot, (slot * 32) as i32, false);
+        }
+        avx(ir, &insts);
+        add_imm(ir, Reg::RAX, unroll * 32);
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: imm(iters * unroll * 32) });
+        ir.emit(ADeadOp::Jcc { cond: Condition::NotEqual, target: top });
+    }
+    let mut insts = Vec::new();
+    for slot in 0..rest {
+        block(&mut insts, slot, (slot * 32) as i32, false);
+    }
+    avx(ir, &insts);
+    if tail > 0 {
+        load_mask(ir, masks, tail);
+        let mut insts = Vec::new();
+        block(&mut insts, rest, (rest * 32) as i32, true);
+        avx(ir, &insts);
+    }
+}
+
+fn at(base: u8, disp: i32) -> VexMem {
+    VexMem::indexed(base, RAX, 1, disp)
+}
+
+/// c[i] = a[i] + b[i]
+fn emit_vector_add(ir: &mut ADeadIR, n: usize, masks: Label) {
+    emit_blocks(ir, n, 4, masks, |insts, slot, disp, masked| {
+        let (v, t) = (ymm(slot), ymm(slot + 4));
+        if masked {
+            insts.extend([
+                AvxInst::VmaskmovpsLoad { dst: v, mask: MASK, mem: at(RDI, disp) },
+                AvxInst::VmaskmovpsLoad { dst: t, mask: MASK, mem: at(RSI, disp) },
+                AvxInst::Vaddps { dst: v, src1: v, src2: t },
+                AvxInst::VmaskmovpsStore { src: v, mask: MASK, mem: at(RDX, disp) },
+            ]);
+        } else {
+            insts.extend([
+                AvxInst::VmovdquLoad { dst: v, mem: at(RDI, disp) },
+                AvxInst::VfpMem { op: FpOp::Add, double: false, dst: v, src1: v, mem: at(RSI, disp) },
+                AvxInst::VmovdquStore { src: v, mem: at(RDX, disp) },
+            ]);
+        }
+    });
+    ret(ir);
+}
+
+/// y[i] = alpha·x[i] + y[i] (alpha en xmm0)
+fn emit_saxpy(ir: &mut ADeadIR, n: usize, masks: Label) {
+    let alpha = ymm(14);
+    avx(ir, &[AvxInst::Vpbroadcast { lane: 4, dst: alpha, src: ymm(0) }]);
+    emit_blocks(ir, n, 4, masks, |insts, slot, disp, masked| {
+        let (v, t) = (ymm(slot), ymm(slot + 4));
+        if masked {
+            insts.extend([
+                AvxInst::VmaskmovpsLoad { dst: v, mask: MASK, mem: at(RSI, disp) },
+                AvxInst::VmaskmovpsLoad { dst: t, mask: MASK, mem: at(RDI, disp) },
+                AvxInst::Vfmadd231ps { dst: v, src1: alpha, src2: t },
+                AvxInst::VmaskmovpsStore { src: v, mask: MASK, mem: at(RSI, disp) },
+            ]);
+        } else {
+            insts.extend([
+                AvxInst::VmovdquLoad { dst: v, mem: at(RSI, disp) },
+                AvxInst::Vfmadd231psMem { dst: v, src1: alpha, mem: at(RDI, disp) },
+                AvxInst::VmovdquStore { src: v, mem: at(RSI, disp) },
+            ]);
+        }
+    });
+    ret(ir);
+}
+
+/// Σ x[i] → xmm0: 8 acumuladores independientes (la latencia del add
+/// queda oculta) combinados en árbol, y luego el árbol horizontal
+fn emit_sum(ir: &mut ADeadIR, n: usize, masks: Label) {
+    let zero: Vec<AvxInst> = (0..8).map(|i| AvxInst::Vxorps { dst: ymm(i), src1: ymm(i), src2: ymm(i) }).collect();
+    avx(ir, &zero);
+    emit_blocks(ir, n, 8, masks, |insts, slot, disp, masked| {
+        let acc = ymm(slot % 8);
+        if masked {
+            insts.extend([
+                AvxInst::VmaskmovpsLoad { dst: ymm(8), mask: MASK, mem: at(RDI, disp) },
+                AvxInst::Vaddps { dst: acc, src1: acc, src2: ymm(8) },
+            ]);
+        } else {
+            insts.push(AvxInst::VfpMem { op: FpOp::Add, double: false, dst: acc, src1: acc, mem: at(RDI, disp) });
+        }
+    });
+    let mut tree = Vec::new();
+    for width in [4, 2, 1] {
+        for i in 0..width {
+            tree.push(AvxInst::Vaddps { dst: ymm(i), src1: ymm(i), src2: ymm(i + width) });
+        }
+    }
+    let (v, t) = (ymm(0), ymm(1));
+    tree.extend([
+        AvxInst::Vextractf128 { dst: t, src: v },
+        AvxInst::Vaddps { dst: v, src1: v, src2: t },
+        // [2 3 0 1] y [1 0 3 2]: el lane 0 termina con la suma de los 4
+        AvxInst::Vpermilps { dst: t, src: v, imm: 0x4E },
+        AvxInst::Vaddps { dst: v, src1: v, src2: t },
+        AvxInst::Vpermilps { dst: t, src: v, imm: 0xB1 },
+        AvxInst::Vaddps { dst: v, src1: v, src2: t },
+    ]);
+    avx(ir, &tree);
+    ret(ir);
+}
+
+// ============================================================
+// SGEMM
+// ============================================================
+//
+// Registros del driver (callee-saved, se preservan):
+//   r12 = A, r13 = B, r14 = C, r15 = work
+//   rbx = cursor de A por bloques de MC filas, rbp = cursor de C
+// A empaquetado en work+0, B empaquetado en work+bp_offset.
+//
+// Subrutinas internas (una por forma que aparece, ver `Sgemm::routine`):
+//   pack_b(kc, nc)   r8 = &B[pc][jc]  r9 = destino
+//   pack_a(mc, kc)   r8 = &A[ic][pc]  r9 = destino
+//   macro(mc, nc, kc, acc)   rdx = &C[ic][jc]
+//   micro(rows, cols, kc, acc)   r8 = panel A, r9 = panel B, r10 = &C
+// ============================================================
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+enum Routine {
+    PackB { kc: usize, nc: usize },
+    PackA { mc: usize, kc: usize },
+    Macro { mc: usize, nc: usize, kc: usize, acc: bool },
+    Micro { rows: usize, cols: usize, kc: usize, acc: bool },
+}
+
+struct Sgemm<'a> {
+    ir: &'a mut ADeadIR,
+    m: usize,
+    n: usize,
+    k: usize,
+    masks: Label,
+    bp_offset: usize,
+    labels: HashMap<Routine, Label>,
+    /// Rutinas referenciadas que faltan por emitir
+    pending: Vec<Routine>,
+}
+
+impl<'a> Sgemm<'a> {
+    fn new(ir: &'a mut ADeadIR, m: usize, n: usize, k: usize, masks: Label) -> Self {
+        for elements in [m * k, k * n, m * n] {
+            assert!(elements <= MAX_ELEMENTS, "sgemm {}x{}x{} exceeds 2 GiB per matrix", m, n, k);
+        }
+        let bp_offset = sgemm_panel_bytes(m, n, k).0;
+        Self { ir, m, n, k, masks, bp_offset, labels: HashMap::new(), pending: Vec::new() }
+    }
+
+    fn lda(&self) -> usize {
+        self.k * 4
+    }
+
+    fn ldb(&self) -> usize {
+        self.n * 4
+    }
+
+    fn ldc(&self) -> usize {
+        self.n * 4
+    }
+
+    /// Label de la subrutina (se emite tras el driver)
+    fn routine(&mut self, r: Routine) -> Label {
+        if let Some(&label) = self.labels.get(&r) {
+            return label;
+        }
+        let label = self.ir.new_label();
+        self.labels.insert(r, label);
+        self.pending.push(r);
+        label
+    }
+
+    fn call(&mut self, r: Routine) {
+        let label = self.routine(r);
+        self.ir.emit(ADeadOp::Call { target: CallTarget::Relative(label) });
+    }
+
+    fn emit(mut self) {
+        const SAVED: [Reg; 6] = [Reg::RBX, Reg::RBP, Reg::R12, Reg::R13, Reg::R14, Reg::R15];
+        for reg in SAVED {
+            self.ir.emit(ADeadOp::Push { src: Operand::Reg(reg) });
+        }
+        for (dst, src) in [(Reg::R12, Reg::RDI), (Reg::R13, Reg::RSI), (Reg::R14, Reg::RDX), (Reg::R15, Reg::RCX)] {
+            mov(self.ir, dst, src);
+        }
+        if self.m > 0 && self.n > 0 {
+            for jc in (0..self.n).step_by(SGEMM_NC) {
+                let nc = SGEMM_NC.min(self.n - jc);
+                if self.k == 0 {
+                    self.emit_zero_block(jc, nc);
+                }
+                for pc in (0..self.k).step_by(SGEMM_KC) {
+                    self.emit_block(jc, nc, pc, SGEMM_KC.min(self.k - pc));
+                }
+            }
+        }
+        for reg in SAVED.iter().rev() {
+            self.ir.emit(ADeadOp::Pop { dst: *reg });
+        }
+        ret(self.ir);
+
+        while let Some(r) = self.pending.pop() {
+            let label = self.labels[&r];
+            self.ir.emit(ADeadOp::Label(label));
+            match r {
+                Routine::PackB { kc, nc } => self.emit_pack_b(kc, nc),
+                Routine::PackA { mc, kc } => self.emit_pack_a(mc, kc),
+                Routine::Macro { mc, nc, kc, acc } => self.emit_macro(mc, nc, kc, acc),
+                Routine::Micro { rows, cols, kc, acc } => self.emit_micro(rows, cols, kc, acc),
+            }
+        }
+    }
+
+    /// Bloque (jc, pc): empaqueta B una vez y recorre m en bloques de MC
+    fn emit_block(&mut self, jc: usize, nc: usize, pc: usize, kc: usize) {
+        let (lda, ldb, ldc) = (self.lda(), self.ldb(), self.ldc());
+        let acc = pc > 0;
+        lea(self.ir, Reg::R8, Reg::R13, pc * ldb + jc * 4);
+        lea(self.ir, Reg::R9, Reg::R15, self.bp_offset);
+        self.call(Routine::PackB { kc, nc });
+
+        lea(self.ir, Reg::RBX, Reg::R12, pc * 4);
+        lea(self.ir, Reg::RBP, Reg::R14, jc * 4);
+        let (full, edge) = (self.m / SGEMM_MC, self.m % SGEMM_MC);
+        let step = |this: &mut Self, mc: usize| {
+            mov(this.ir, Reg::R8, Reg::RBX);
+            mov(this.ir, Reg::R9, Reg::R15);
+            this.call(Routine::PackA { mc, kc });
+            mov(this.ir, Reg::RDX, Reg::RBP);
+            this.call(Routine::Macro { mc, nc, kc, acc });
+        };
+        if full > 0 {
+            let top = self.ir.new_label();
+            self.ir.emit(ADeadOp::Label(top));
+            step(self, SGEMM_MC);
+            add_imm(self.ir, Reg::RBX, SGEMM_MC * lda);
+            add_imm(self.ir, Reg::RBP, SGEMM_MC * ldc);
+            lea(self.ir, Reg::RAX, Reg::R12, pc * 4 + full * SGEMM_MC * lda);
+            self.ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RBX), right: Operand::Reg(Reg::RAX) });
+            self.ir.emit(ADeadOp::Jcc { cond: Condition::NotEqual, target: top });
+        }
+        if edge > 0 {
+            step(self, edge);
+        }
+    }
+
+    /// k = 0: C = 0 (no hay bloque de k que la escriba)
+    fn emit_zero_block(&mut self, jc: usize, nc: usize) {
+        let ldc = self.ldc();
+        avx(self.ir, &[AvxInst::Vxorps { dst: ymm(0), src1: ymm(0), src2: ymm(0) }]);
+        if nc % 8 != 0 {
+            load_mask(self.ir, self.masks, nc % 8);
+        }
+        for row in 0..self.m {
+            let mut insts = Vec::new();
+            for col in (0..nc).step_by(8) {
+                let mem = VexMem::base(14, (row * ldc + (jc + col) * 4) as i32);
+                insts.push(if nc - col >= 8 {
+                    AvxInst::VmovdquStore { src: ymm(0), mem }
+                } else {
+                    AvxInst::VmaskmovpsStore { src: ymm(0), mask: MASK, mem }
+                });
+            }
+            avx(self.ir, &insts);
+        }
+    }
+
+    /// B[pc.., jc..] (kc×nc) → paneles de NR columnas: panel j en
+    /// r9 + j·kc·64, fila p en +p·64. El último panel se completa con ceros.
+    fn emit_pack_b(&mut self, kc: usize, nc: usize) {
+        let (full, edge) = (nc / SGEMM_NR, nc % SGEMM_NR);
+        let panel = kc * SGEMM_NR * 4;
+        if edge % 8 != 0 {
+            load_mask(self.ir, self.masks, edge % 8);
+        }
+        let zero = ymm(14);
+        avx(self.ir, &[AvxInst::Vxorps { dst: zero, src1: zero, src2: zero }]);
+        self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::R10), src: imm(kc) });
+        let top = self.ir.new_label();
+        self.ir.emit(ADeadOp::Label(top));
+        let mut insts = Vec::new();
+        for j in 0..full {
+            let (src, dst) = ((j * 64) as i32, (j * panel) as i32);
+            insts.extend([
+                AvxInst::VmovdquLoad { dst: ymm(0), mem: VexMem::base(R8, src) },
+                AvxInst::VmovdquLoad { dst: ymm(1), mem: VexMem::base(R8, src + 32) },
+                AvxInst::VmovdquStore { src: ymm(0), mem: VexMem::base(R9, dst) },
+                AvxInst::VmovdquStore { src: ymm(1), mem: VexMem::base(R9, dst + 32) },
+            ]);
+        }
+        if edge > 0 {
+            let (src, dst) = ((full * 64) as i32, (full * panel) as i32);
+            let load = |reg: YmmReg, lanes: usize, disp: i32| match lanes {
+                0 => AvxInst::VmovapsReg { dst: reg, src: zero },
+                8 => AvxInst::VmovdquLoad { dst: reg, mem: VexMem::base(R8, disp) },
+                _ => AvxInst::VmaskmovpsLoad { dst: reg, mask: MASK, mem: VexMem::base(R8, disp) },
+            };
+            insts.extend([
+                load(ymm(0), edge.min(8), src),
+                load(ymm(1), edge.saturating_sub(8), src + 32),
+                AvxInst::VmovdquStore { src: ymm(0), mem: VexMem::base(R9, dst) },
+                AvxInst::VmovdquStore { src: ymm(1), mem: VexMem::base(R9, dst + 32) },
+            ]);
+        }
+        avx(self.ir, &insts);
+        add_imm(self.ir, Reg::R8, self.ldb());
+        add_imm(self.ir, Reg::R9, SGEMM_NR * 4);
+        loop_back(self.ir, Reg::R10, top);
+        ret(self.ir);
+    }
+
+    /// A[ic.., pc..] (mc×kc) → paneles de MR filas: panel i en
+    /// r9 + i·kc·24, columna p en +p·24. Las filas de relleno van a cero.
+    fn emit_pack_a(&mut self, mc: usize, kc: usize) {
+        let (lda, panel) = (self.lda(), kc * SGEMM_MR * 4);
+        self.ir.emit(ADeadOp::Xor { dst: Reg::EAX, src: Reg::EAX });
+        self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::R10), src: imm(kc) });
+        let top = self.ir.new_label();
+        self.ir.emit(ADeadOp::Label(top));
+        for row in 0..round_up(mc, SGEMM_MR) {
+            let disp = ((row / SGEMM_MR) * panel + (row % SGEMM_MR) * 4) as i32;
+            let src = if row < mc {
+                self.ir.emit(ADeadOp::Load32 { dst: Reg::RCX, base: Reg::R8, disp: (row * lda) as i32 });
+                Reg::RCX
+            } else {
+                Reg::RAX
+            };
+            self.ir.emit(ADeadOp::Store32 { base: Reg::R9, disp, src });
+        }
+        add_imm(self.ir, Reg::R8, 4);
+        add_imm(self.ir, Reg::R9, SGEMM_MR * 4);
+        loop_back(self.ir, Reg::R10, top);
+        ret(self.ir);
+    }
+
+    /// Recorre el bloque mc×nc de C en tiles MR×NR: paneles de B por
+    /// fuera (rdi, contador rcx), paneles de A por dentro (rsi, rax)
+    fn emit_macro(&mut self, mc: usize, nc: usize, kc: usize, acc: bool) {
+        let (full_j, edge_j) = (nc / SGEMM_NR, nc % SGEMM_NR);
+        lea(self.ir, Reg::RDI, Reg::R15, self.bp_offset);
+        if full_j > 0 {
+            self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RCX), src: imm(full_j) });
+            let top = self.ir.new_label();
+            self.ir.emit(ADeadOp::Label(top));
+            self.emit_column_sweep(mc, SGEMM_NR, kc, acc);
+            add_imm(self.ir, Reg::RDI, kc * SGEMM_NR * 4);
+            add_imm(self.ir, Reg::RDX, SGEMM_NR * 4);
+            loop_back(self.ir, Reg::RCX, top);
+        }
+        if edge_j > 0 {
+            self.emit_column_sweep(mc, edge_j, kc, acc);
+        }
+        ret(self.ir);
+    }
+
+    /// Una columna de tiles: micro-kernel sobre cada panel de A
+    fn emit_column_sweep(&mut self, mc: usize, cols: usize, kc: usize, acc: bool) {
+        let (full_i, edge_i) = (mc / SGEMM_MR, mc % SGEMM_MR);
+        mov(self.ir, Reg::RSI, Reg::R15);
+        mov(self.ir, Reg::R10, Reg::RDX);
+        let tile = |this: &mut Self, rows: usize| {
+            mov(this.ir, Reg::R8, Reg::RSI);
+            mov(this.ir, Reg::R9, Reg::RDI);
+            this.call(Routine::Micro { rows, cols, kc, acc });
+        };
+        if full_i > 0 {
+            self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RAX), src: imm(full_i) });
+            let top = self.ir.new_label();
+            self.ir.emit(ADeadOp::Label(top));
+            tile(self, SGEMM_MR);
+            add_imm(self.ir, Reg::RSI, kc * SGEMM_MR * 4);
+            add_imm(self.ir, Reg::R10, SGEMM_MR * self.ldc());
+            loop_back(self.ir, Reg::RAX, top);
+        }
+        if edge_i > 0 {
+            tile(self, edge_i);
+        }
+    }
+
+    /// Tile rows×cols de C: acumuladores ymm0..11 (fila i → ymm 2i, 2i+1),
+    /// B en ymm12/13, broadcast de A en ymm14, máscara en ymm15
+    fn emit_micro(&mut self, rows: usize, cols: usize, kc: usize, acc: bool) {
+        let halves = if cols > 8 { 2 } else { 1 };
+        let acc_reg = |i: usize, h: usize| ymm(2 * i + h);
+        let mut insts = Vec::new();
+        for i in 0..rows {
+            for h in 0..halves {
+                let r = acc_reg(i, h);
+                insts.push(AvxInst::Vxorps { dst: r, src1: r, src2: r });
+            }
+        }
+        avx(self.ir, &insts);
+        self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::R11), src: imm(kc) });
+
+        let top = self.ir.new_label();
+        self.ir.emit(ADeadOp::Label(top));
+        let mut insts = Vec::new();
+        for h in 0..halves {
+            insts.push(AvxInst::VmovdquLoad { dst: ymm(12 + h), mem: VexMem::base(R9, (h * 32) as i32) });
+        }
+        for i in 0..rows {
+            insts.push(AvxInst::Vbroadcastss { dst: ymm(14), mem: VexMem::base(R8, (i * 4) as i32) });
+            for h in 0..halves {
+                insts.push(AvxInst::Vfmadd231ps { dst: acc_reg(i, h), src1: ymm(14), src2: ymm(12 + h) });
+            }
+        }
+        avx(self.ir, &insts);
+        add_imm(self.ir, Reg::R8, SGEMM_MR * 4);
+        add_imm(self.ir, Reg::R9, SGEMM_NR * 4);
+        loop_back(self.ir, Reg::R11, top);
+
+        // Una sola mitad puede ser parcial: la máscara se carga una vez
+        if cols % 8 != 0 {
+            load_mask(self.ir, self.masks, cols % 8);
+        }
+        let ldc = self.ldc();
+        let mut insts = Vec::new();
+        for i in 0..rows {
+            for h in 0..halves {
+                let (r, mem) = (acc_reg(i, h), VexMem::base(R10, (i * ldc + h * 32) as i32));
+                let partial = cols - h * 8 < 8;
+                match (partial, acc) {
+                    (false, false) => insts.push(AvxInst::VmovdquStore { src: r, mem }),
+                    (false, true) => insts.extend([
+                        AvxInst::VfpMem { op: FpOp::Add, double: false, dst: r, src1: r, mem },
+                        AvxInst::VmovdquStore { src: r, mem },
+                    ]),
+                    (true, false) => insts.push(AvxInst::VmaskmovpsStore { src: r, mask: MASK, mem }),
+                    (true, true) => insts.extend([
+                        AvxInst::VmaskmovpsLoad { dst: ymm(14), mask: MASK, mem },
+                        AvxInst::Vaddps { dst: r, src1: r, src2: ymm(14) },
+                        AvxInst::VmaskmovpsStore { src: r, mask: MASK, mem },
+                    ]),
+                }
+            }
+        }
+        avx(self.ir, &insts);
+        ret(self.ir);
+    }
+}
+
+#[cfg(all(test, target_os = "linux", target_arch = "x86_64"))]
+mod tests {
+    use super::*;
+    use crate::isa::test_jit::JitCode;
+
+    /// Kernel ensamblado y mapeado mientras viva
+    struct Jit(JitCode);
+
+    impl Jit {
+        fn new(kernel: DenseKernel) -> Self {
+            Self(JitCode::from_code(&kernel.encode()))
+        }
+
+        fn entry<F: Copy>(&self) -> F {
+            unsafe { self.0.entry() }
+        }
+    }
+
+    fn has_avx2_fma() -> bool {
+        is_x86_feature_detected!("avx2") && is_x86_feature_detected!("fma")
+    }
+
+    fn data(n: usize, seed: u32) -> Vec<f32> {
+        (0..n).map(|i| ((i as u32).wrapping_mul(2654435761).wrapping_add(seed) % 97) as f32 / 16.0 - 3.0).collect()
+    }
+
+    #[test]
+    fn test_vector_add_and_saxpy_tails() {
+        if !has_avx2_fma() {
+            return;
+        }
+        for n in [0, 3, 8, 31, 32, 77, 1000] {
+            let (a, b) = (data(n, 1), data(n, 2));
+            // Un float centinela tras cada array: la cola no se sale
+            let mut c = vec![7.0f32; n + 1];
+            let add = Jit::new(DenseKernel::VectorAdd { n });
+            add.entry::<extern "C" fn(*const f32, *const f32, *mut f32)>()(a.as_ptr(), b.as_ptr(), c.as_mut_ptr());
+            for i in 0..n {
+                assert_eq!(c[i], a[i] + b[i], "vector_add n={} i={}", n, i);
+            }
+            assert_eq!(c[n], 7.0);
+
+            let mut y = b.clone();
+            y.push(7.0);
+            let saxpy = Jit::new(DenseKernel::Saxpy { n });
+            saxpy.entry::<extern "C" fn(*const f32, *mut f32, f32)>()(a.as_ptr(), y.as_mut_ptr(), 1.5);
+            for i in 0..n {
+                assert_eq!(y[i], 1.5f32.mul_add(a[i], b[i]), "saxpy n={} i={}", n, i);
+            }
+            assert_eq!(y[n], 7.0);
+        }
+    }
+
+    #[test]
+    fn test_sum() {
+        if !has_avx2_fma() {
+            return;
+        }
+        for n in [0, 1, 7, 64, 65, 1023, 4096] {
+            let x = data(n, 3);
+            let sum = Jit::new(DenseKernel::Sum { n });
+            let got = sum.entry::<extern "C" fn(*const f32) -> f32>()(x.as_ptr());
+            let want: f64 = x.iter().map(|&v| v as f64).sum();
+            assert!((got as f64 - want).abs() <= 1e-3 * (1.0 + want.abs()), "n={} {} vs {}", n, got, want);
+        }
+    }
+
+    #[test]
+    fn test_sgemm_matches_reference() {
+        if !has_avx2_fma() {
+            return;
+        }
+        // Bordes de MR/NR, más de un bloque de MC y de KC, y k = 0
+        for (m, n, k) in [(1, 1, 1), (6, 16, 8), (7, 17, 5), (73, 40, 300), (13, 1030, 3), (5, 9, 0)] {
+            let (a, b) = (data(m * k, 4), data(k * n, 5));
+            let mut c = vec![f32::NAN; m * n + 1];
+            c[m * n] = 7.0;
+            let mut work = vec![0u8; sgemm_workspace_bytes(m, n, k)];
+            let sgemm = Jit::new(DenseKernel::Sgemm { m, n, k });
+            sgemm.entry::<extern "C" fn(*const f32, *const f32, *mut f32, *mut u8)>()(
+                a.as_ptr(),
+                b.as_ptr(),
+                c.as_mut_ptr(),
+                work.as_mut_ptr(),
+            );
+            for i in 0..m {
+                for j in 0..n {
+                    let want: f64 = (0..k).map(|p| a[i * k + p] as f64 * b[p * n + j] as f64).sum();
+                    let got = c[i * n + j] as f64;
+                    assert!((got - want).abs() <= 1e-4 * (1.0 + want.abs()), "{}x{}x{} C[{}][{}] = {} vs {}", m, n, k, i, j, got, want);
+                }
+            }
+            assert_eq!(c[m * n], 7.0);
+        }
+    }
+
+    #[test]
+    fn test_sgemm_shares_routines_per_shape() {
+        // Bloques repetidos reutilizan pack/macro/micro: el código crece con
+        // el número de bloques (jc, pc), no con m
+        let small = DenseKernel::Sgemm { m: 144, n: 64, k: 64 }.encode().len();
+        let tall = DenseKernel::Sgemm { m: 1440, n: 64, k: 64 }.encode().len();
+        assert_eq!(small, tall);
+        assert_eq!(sgemm_workspace_bytes(1, 1, 1), 6 * 4 + 16 * 4);
+    }
+}
@@ -0,0 +1,811 @@
+// ============================================================
+// ADead-BIB — Árbol B ordenado (std::map / std::set)
+// ============================================================
+// Claves con signo de 8 bytes en nodos de 192 bytes alineados a 64:
+// las 7 claves de un nodo llenan una línea de caché, así que buscar
+// en un nodo es un barrido lineal sin fallos, y un millón de claves
+// caben en ~8 niveles en lugar de los ~20 de un árbol rojo-negro.
+//
+//   [0]        número de claves
+//   [1..8)     marcas de borrado, una por clave
+//   [8..64)    claves[7]
+//   [64..120)  valores[7]
+//   [128..192) hijos[8]   (hoja = hijo 0 nulo)
+//
+// La inserción es descendente con división preventiva (t = 4: un nodo
+// lleno se parte en 3 + mediana + 3 antes de bajar por él), así que
+// nunca hay que volver hacia arriba. Borrar deja una lápida; cuando
+// las lápidas superan a las vivas el árbol se reconstruye entero.
+//
+// Los nodos salen de arenas mapeadas que solo se liberan juntas.
+// ============================================================
+
+use super::slab_heap::{self, PageSource};
+use super::{ADeadIR, ADeadOp, CallTarget, Condition, Label, Operand, Reg};
+
+const NODE_BYTES: i32 = 192;
+const MAX_KEYS: i32 = 7;
+const DEAD: i32 = 1;
+const KEYS: i32 = 8;
+const VALS: i32 = 64;
+const CHILD: i32 = 128;
+/// Desde la dirección de una clave hasta su valor
+const KEY_TO_VAL: i32 = VALS - KEYS;
+
+// ---- Cabecera ----
+const ROOT: i32 = 0;
+const SIZE: i32 = 8;
+const TOMBS: i32 = 16;
+const ARENAS: i32 = 24;
+const CUR: i32 = 32;
+const END: i32 = 40;
+const NEXT_BYTES: i32 = 48;
+const HEADER_BYTES: i32 = 4096;
+
+/// Arena: [siguiente, bytes] y los nodos desde +64
+const ARENA_NODES: i32 = 64;
+const FIRST_ARENA: i32 = 64 << 10;
+const MAX_ARENA: i32 = 16 << 20;
+/// Nodos que puede pedir una inserción (una división por nivel y la
+/// raíz): se reservan antes de tocar el árbol, así no falla a medias
+const RESERVE: i32 = 48 * NODE_BYTES;
+/// Lápidas mínimas antes de reconstruir
+const MIN_COMPACT: i32 = 32;
+
+#[derive(Debug, Clone, Copy)]
+pub struct BTree {
+    pages: PageSource,
+    args: [Reg; 3],
+    /// adb_tree_new() → árbol, o 0
+    pub new: Label,
+    /// adb_tree_slot(t, k) → &valor, insertando 0 si no estaba (operator[])
+    pub slot: Label,
+    /// adb_tree_insert(t, k, v) → 1 si insertó, 0 si ya estaba
+    pub insert: Label,
+    /// adb_tree_find(t, k) → &valor, o 0
+    pub find: Label,
+    /// adb_tree_erase(t, k) → 1 si estaba
+    pub erase: Label,
+    /// adb_tree_size(t)
+    pub size: Label,
+    /// adb_tree_clear(t)
+    pub clear: Label,
+    /// adb_tree_free(t)
+    pub free: Label,
+    scan: Label,
+    open: Label,
+    split: Label,
+    alloc: Label,
+    reserve: Label,
+    locate: Label,
+    find_node: Label,
+    compact: Label,
+    walk: Label,
+    drop_arenas: Label,
+    map: Label,
+    unmap: Label,
+}
+
+fn mov(ir: &mut ADeadIR, dst: Reg, src: Operand) {
+    ir.emit(ADeadOp::Mov { dst: Operand::Reg(dst), src });
+}
+
+fn mem(base: Reg, disp: i32) -> Operand {
+    Operand::Mem { base, disp }
+}
+
+fn store(ir: &mut ADeadIR, base: Reg, disp: i32, src: Reg) {
+    ir.emit(ADeadOp::Mov { dst: mem(base, disp), src: Operand::Reg(src) });
+}
+
+fn jcc(ir: &mut ADeadIR, cond: Condition, target: Label) {
+    ir.emit(ADeadOp::Jcc { cond, target });
+}
+
+fn call(ir: &mut ADeadIR, target: Label) {
+    ir.emit(ADeadOp::Call { target: CallTarget::Relative(target) });
+}
+
+fn push(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Push { src: Operand::Reg(reg) });
+}
+
+fn pop(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Pop { dst: reg });
+}
+
+fn zero(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Xor { dst: reg, src: reg });
+}
+
+/// dst = base + index*scale
+fn lea_index(ir: &mut ADeadIR, dst: Reg, base: Reg, index: Reg, scale: u8) {
+    ir.emit(ADeadOp::Lea { dst, src: Operand::MemSIB { base, index, scale, disp: 0 } });
+}
+
+impl BTree {
+    /// `windows`: argumentos en RCX/RDX/R8, si no RDI/RSI/RDX
+    pub fn new(ir: &mut ADeadIR, pages: PageSource, windows: bool) -> Self {
+        Self {
+            pages,
+            args: if windows { [Reg::RCX, Reg::RDX, Reg::R8] } else { [Reg::RDI, Reg::RSI, Reg::RDX] },
+            new: ir.new_label(),
+            slot: ir.new_label(),
+            insert: ir.new_label(),
+            find: ir.new_label(),
+            erase: ir.new_label(),
+            size: ir.new_label(),
+            clear: ir.new_label(),
+            free: ir.new_label(),
+            scan: ir.new_label(),
+            open: ir.new_label(),
+            split: ir.new_label(),
+            alloc: ir.new_label(),
+            reserve: ir.new_label(),
+            locate: ir.new_label(),
+            find_node: ir.new_label(),
+            compact: ir.new_label(),
+            walk: ir.new_label(),
+            drop_arenas: ir.new_label(),
+            map: ir.new_label(),
+            unmap: ir.new_label(),
+        }
+    }
+
+    /// Rutina que resuelve una llamada de C/C++
+    pub fn routine(&self, name: &str) -> Option<Label> {
+        match name {
+            "adb_tree_new" => Some(self.new),
+            "adb_tree_slot" => Some(self.slot),
+            "adb_tree_insert" => Some(self.insert),
+            "adb_tree_find" => Some(self.find),
+            "adb_tree_erase" => Some(self.erase),
+            "adb_tree_size" => Some(self.size),
+            "adb_tree_clear" => Some(self.clear),
+            "adb_tree_free" => Some(self.free),
+            _ => None,
+        }
+    }
+
+    pub fn emit_routines(&self, ir: &mut ADeadIR) {
+        slab_heap::emit_page_map(ir, self.map, self.pages);
+        slab_heap::emit_page_unmap(ir, self.unmap, self.pages);
+        self.emit_new(ir);
+        self.emit_slot(ir);
+        self.emit_insert(ir);
+        self.emit_find(ir);
+        self.emit_erase(ir);
+        self.emit_size(ir);
+        self.emit_clear(ir);
+        self.emit_free(ir);
+        self.emit_scan(ir);
+        self.emit_open(ir);
+        self.emit_split(ir);
+        self.emit_alloc(ir);
+        self.emit_reserve(ir);
+        self.emit_locate(ir);
+        self.emit_find_node(ir);
+        self.emit_compact(ir);
+        self.emit_walk(ir);
+        self.emit_drop_arenas(ir);
+    }
+
+    // ---- Entradas desde C ----
+
+    /// Guarda RBX, R12-R15, RSI, RDI; RBX = árbol, R12 = clave
+    fn enter(&self, ir: &mut ADeadIR) {
+        push(ir, Reg::RBP);
+        mov(ir, Reg::RBP, Operand::Reg(Reg::RSP));
+        for reg in [Reg::RBX, Reg::R12, Reg::R13, Reg::R14, Reg::R15, Reg::RSI, Reg::RDI] {
+            push(ir, reg);
+        }
+        mov(ir, Reg::R12, Operand::Reg(self.args[1]));
+        mov(ir, Reg::RBX, Operand::Reg(self.args[0]));
+    }
+
+    fn leave(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Lea { dst: Reg::RSP, src: mem(Reg::RBP, -56) });
+        for reg in [Reg::RDI, Reg::RSI, Reg::R15, Reg::R14, Reg::R13, Reg::R12, Reg::RBX] {
+            pop(ir, reg);
+        }
+        pop(ir, Reg::RBP);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    fn emit_new(&self, ir: &mut ADeadIR) {
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.new));
+        self.enter(ir);
+        mov(ir, Reg::RCX, Operand::Imm32(HEADER_BYTES));
+        call(ir, self.map);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        mov(ir, Reg::RCX, Operand::Imm32(FIRST_ARENA));
+        store(ir, Reg::RAX, NEXT_BYTES, Reg::RCX);
+        ir.emit(ADeadOp::Label(out));
+        self.leave(ir);
+    }
+
+    fn emit_slot(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.slot));
+        self.enter(ir);
+        call(ir, self.locate);
+        self.leave(ir);
+    }
+
+    fn emit_insert(&self, ir: &mut ADeadIR) {
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.insert));
+        self.enter(ir);
+        // El valor va a [rbp - 64]
+        push(ir, self.args[2]);
+        call(ir, self.locate);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        // RAX = 1 si es nueva (RDX), 0 si ya estaba
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RAX));
+        mov(ir, Reg::RAX, Operand::Reg(Reg::RDX));
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        mov(ir, Reg::RDX, mem(Reg::RBP, -64));
+        store(ir, Reg::RCX, 0, Reg::RDX);
+        ir.emit(ADeadOp::Label(out));
+        self.leave(ir);
+    }
+
+    fn emit_find(&self, ir: &mut ADeadIR) {
+        let out = ir.new_label();
+        let erased = ir.new_label();
+        ir.emit(ADeadOp::Label(self.find));
+        self.enter(ir);
+        call(ir, self.find_node);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        Self::load_dead(ir);
+        jcc(ir, Condition::NotEqual, erased);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Imm32(KEY_TO_VAL) });
+        self.leave(ir);
+        ir.emit(ADeadOp::Label(erased));
+        zero(ir, Reg::RAX);
+        ir.emit(ADeadOp::Label(out));
+        self.leave(ir);
+    }
+
+    fn emit_erase(&self, ir: &mut ADeadIR) {
+        let out = ir.new_label();
+        let erased = ir.new_label();
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(self.erase));
+        self.enter(ir);
+        call(ir, self.find_node);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        Self::load_dead(ir);
+        jcc(ir, Condition::NotEqual, erased);
+        mov(ir, Reg::RDX, Operand::Imm32(1));
+        ir.emit(ADeadOp::Store8 { base: Reg::R8, disp: DEAD, src: Reg::RDX });
+        ir.emit(ADeadOp::Dec { dst: mem(Reg::RBX, SIZE) });
+        ir.emit(ADeadOp::Inc { dst: mem(Reg::RBX, TOMBS) });
+        // Reconstruir cuando las lápidas ya dominan el árbol
+        mov(ir, Reg::RAX, mem(Reg::RBX, TOMBS));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(MIN_COMPACT) });
+        jcc(ir, Condition::Below, done);
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: mem(Reg::RBX, SIZE) });
+        jcc(ir, Condition::BelowEq, done);
+        call(ir, self.compact);
+        ir.emit(ADeadOp::Label(done));
+        mov(ir, Reg::RAX, Operand::Imm32(1));
+        self.leave(ir);
+        ir.emit(ADeadOp::Label(erased));
+        zero(ir, Reg::RAX);
+        ir.emit(ADeadOp::Label(out));
+        self.leave(ir);
+    }
+
+    fn emit_size(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.size));
+        mov(ir, Reg::RAX, mem(self.args[0], SIZE));
+        ir.emit(ADeadOp::Ret);
+    }
+
+    fn emit_clear(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.clear));
+        self.enter(ir);
+        call(ir, self.drop_arenas);
+        zero(ir, Reg::RAX);
+        self.leave(ir);
+    }
+
+    fn emit_free(&self, ir: &mut ADeadIR) {
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.free));
+        self.enter(ir);
+        ir.emit(ADeadOp::Test { left: Reg::RBX, right: Reg::RBX });
+        jcc(ir, Condition::Equal, out);
+        call(ir, self.drop_arenas);
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RBX));
+        mov(ir, Reg::RDX, Operand::Imm32(HEADER_BYTES));
+        call(ir, self.unmap);
+        ir.emit(ADeadOp::Label(out));
+        zero(ir, Reg::RAX);
+        self.leave(ir);
+    }
+
+    // ---- Nodos ----
+
+    /// RDI = nodo, RCX = índice → R8 = nodo + índice, RDX = su marca de
+    /// borrado (ZF si está viva)
+    fn load_dead(ir: &mut ADeadIR) {
+        lea_index(ir, Reg::R8, Reg::RDI, Reg::RCX, 1);
+        ir.emit(ADeadOp::Load8 { dst: Reg::RDX, base: Reg::R8, disp: DEAD });
+        ir.emit(ADeadOp::Test { left: Reg::RDX, right: Reg::RDX });
+    }
+
+    /// RDI = nodo, R12 = clave → RCX = primera clave ≥ R12, RDX = número
+    /// de claves, RAX = &claves[RCX]
+    fn emit_scan(&self, ir: &mut ADeadIR) {
+        let top = ir.new_label();
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(self.scan));
+        ir.emit(ADeadOp::Load8 { dst: Reg::RDX, base: Reg::RDI, disp: 0 });
+        zero(ir, Reg::RCX);
+        ir.emit(ADeadOp::Lea { dst: Reg::RAX, src: mem(Reg::RDI, KEYS) });
+        ir.emit(ADeadOp::Label(top));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: Operand::Reg(Reg::RDX) });
+        jcc(ir, Condition::AboveEq, done);
+        ir.emit(ADeadOp::Cmp { left: mem(Reg::RAX, 0), right: Operand::Reg(Reg::R12) });
+        jcc(ir, Condition::GreaterEq, done);
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::RCX) });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Imm32(8) });
+        ir.emit(ADeadOp::Jmp { target: top });
+        ir.emit(ADeadOp::Label(done));
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// RDI = nodo (no lleno), RCX = i: corre una posición las claves
+    /// i.. y los hijos i+1.. (no toca el número de claves). Usa RAX, RDX, R8
+    fn emit_open(&self, ir: &mut ADeadIR) {
+        let top = ir.new_label();
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(self.open));
+        ir.emit(ADeadOp::Load8 { dst: Reg::RDX, base: Reg::RDI, disp: 0 });
+        ir.emit(ADeadOp::Label(top));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RDX), right: Operand::Reg(Reg::RCX) });
+        jcc(ir, Condition::BelowEq, done);
+        // j = RDX: clave/valor j-1 → j, hijo j → j+1
+        lea_index(ir, Reg::R8, Reg::RDI, Reg::RDX, 8);
+        for (from, to) in [(KEYS - 8, KEYS), (VALS - 8, VALS), (CHILD, CHILD + 8)] {
+            mov(ir, Reg::RAX, mem(Reg::R8, from));
+            store(ir, Reg::R8, to, Reg::RAX);
+        }
+        lea_index(ir, Reg::R8, Reg::RDI, Reg::RDX, 1);
+        ir.emit(ADeadOp::Load8 { dst: Reg::RAX, base: Reg::R8, disp: DEAD - 1 });
+        ir.emit(ADeadOp::Store8 { base: Reg::R8, disp: DEAD, src: Reg::RAX });
+        ir.emit(ADeadOp::Dec { dst: Operand::Reg(Reg::RDX) });
+        ir.emit(ADeadOp::Jmp { target: top });
+        ir.emit(ADeadOp::Label(done));
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// RDI = padre (no lleno), RCX = i con hijos[i] lleno: lo parte en
+    /// 3 + mediana + 3 y sube la mediana a claves[i]. Conserva RDI y RCX
+    fn emit_split(&self, ir: &mut ADeadIR) {
+        const HALF: i32 = MAX_KEYS / 2;
+        ir.emit(ADeadOp::Label(self.split));
+        push(ir, Reg::RDI);
+        push(ir, Reg::RCX);
+        // RSI = hijo lleno, R9 = hermano nuevo
+        lea_index(ir, Reg::RAX, Reg::RDI, Reg::RCX, 8);
+        mov(ir, Reg::RSI, mem(Reg::RAX, CHILD));
+        call(ir, self.alloc);
+        mov(ir, Reg::R9, Operand::Reg(Reg::RAX));
+        for j in 0..HALF {
+            let from = HALF + 1 + j;
+            for base in [KEYS, VALS] {
+                mov(ir, Reg::RAX, mem(Reg::RSI, base + 8 * from));
+                store(ir, Reg::R9, base + 8 * j, Reg::RAX);
+            }
+            ir.emit(ADeadOp::Load8 { dst: Reg::RAX, base: Reg::RSI, disp: DEAD + from });
+            ir.emit(ADeadOp::Store8 { base: Reg::R9, disp: DEAD + j, src: Reg::RAX });
+        }
+        for j in 0..=HALF {
+            mov(ir, Reg::RAX, mem(Reg::RSI, CHILD + 8 * (HALF + 1 + j)));
+            store(ir, Reg::R9, CHILD + 8 * j, Reg::RAX);
+        }
+        mov(ir, Reg::RAX, Operand::Imm32(HALF));
+        ir.emit(ADeadOp::Store8 { base: Reg::R9, disp: 0, src: Reg::RAX });
+        ir.emit(ADeadOp::Store8 { base: Reg::RSI, disp: 0, src: Reg::RAX });
+
+        mov(ir, Reg::RCX, mem(Reg::RSP, 0));
+        mov(ir, Reg::RDI, mem(Reg::RSP, 8));
+        call(ir, self.open);
+        lea_index(ir, Reg::R8, Reg::RDI, Reg::RCX, 8);
+        for base in [KEYS, VALS] {
+            mov(ir, Reg::RAX, mem(Reg::RSI, base + 8 * HALF));
+            store(ir, Reg::R8, base, Reg::RAX);
+        }
+        store(ir, Reg::R8, CHILD + 8, Reg::R9);
+        ir.emit(ADeadOp::Load8 { dst: Reg::RAX, base: Reg::RSI, disp: DEAD + HALF });
+        lea_index(ir, Reg::R8, Reg::RDI, Reg::RCX, 1);
+        ir.emit(ADeadOp::Store8 { base: Reg::R8, disp: DEAD, src: Reg::RAX });
+        ir.emit(ADeadOp::Load8 { dst: Reg::RAX, base: Reg::RDI, disp: 0 });
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::RAX) });
+        ir.emit(ADeadOp::Store8 { base: Reg::RDI, disp: 0, src: Reg::RAX });
+        pop(ir, Reg::RCX);
+        pop(ir, Reg::RDI);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// → RAX = nodo a cero de la arena reservada
+    fn emit_alloc(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.alloc));
+        mov(ir, Reg::RAX, mem(Reg::RBX, CUR));
+        ir.emit(ADeadOp::Lea { dst: Reg::RDX, src: mem(Reg::RAX, NODE_BYTES) });
+        store(ir, Reg::RBX, CUR, Reg::RDX);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// Garantiza RESERVE bytes en la arena actual, abriendo otra (cada
+    /// vez el doble, hasta MAX_ARENA) si no → RAX = 1, o 0 sin páginas
+    fn emit_reserve(&self, ir: &mut ADeadIR) {
+        let room = ir.new_label();
+        let capped = ir.new_label();
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.reserve));
+        mov(ir, Reg::RAX, mem(Reg::RBX, END));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RAX), src: mem(Reg::RBX, CUR) });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(RESERVE) });
+        jcc(ir, Condition::AboveEq, room);
+        mov(ir, Reg::RCX, mem(Reg::RBX, NEXT_BYTES));
+        call(ir, self.map);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        mov(ir, Reg::RCX, mem(Reg::RBX, ARENAS));
+        store(ir, Reg::RAX, 0, Reg::RCX);
+        mov(ir, Reg::RCX, mem(Reg::RBX, NEXT_BYTES));
+        store(ir, Reg::RAX, 8, Reg::RCX);
+        store(ir, Reg::RBX, ARENAS, Reg::RAX);
+        ir.emit(ADeadOp::Lea { dst: Reg::RDX, src: mem(Reg::RAX, ARENA_NODES) });
+        store(ir, Reg::RBX, CUR, Reg::RDX);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RCX) });
+        store(ir, Reg::RBX, END, Reg::RAX);
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: Operand::Imm32(MAX_ARENA) });
+        jcc(ir, Condition::AboveEq, capped);
+        ir.emit(ADeadOp::Shl { dst: Reg::RCX, amount: 1 });
+        store(ir, Reg::RBX, NEXT_BYTES, Reg::RCX);
+        ir.emit(ADeadOp::Label(capped));
+        ir.emit(ADeadOp::Label(room));
+        mov(ir, Reg::RAX, Operand::Imm32(1));
+        ir.emit(ADeadOp::Label(out));
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// RBX = árbol, R12 = clave → RAX = &valor (0 sin páginas) y RDX = 1
+    /// si la clave es nueva o revive una lápida (con valor 0).
+    /// Conserva R13-R15
+    fn emit_locate(&self, ir: &mut ADeadIR) {
+        let fail = ir.new_label();
+        let have_root = ir.new_label();
+        let descend = ir.new_label();
+        let not_here = ir.new_label();
+        let go_down = ir.new_label();
+        let left = ir.new_label();
+        let hit = ir.new_label();
+        let revive = ir.new_label();
+        let leaf = ir.new_label();
+        ir.emit(ADeadOp::Label(self.locate));
+        call(ir, self.reserve);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, fail);
+        mov(ir, Reg::RDI, mem(Reg::RBX, ROOT));
+        ir.emit(ADeadOp::Test { left: Reg::RDI, right: Reg::RDI });
+        jcc(ir, Condition::NotEqual, have_root);
+        call(ir, self.alloc);
+        store(ir, Reg::RBX, ROOT, Reg::RAX);
+        mov(ir, Reg::RDI, Operand::Reg(Reg::RAX));
+        ir.emit(ADeadOp::Label(have_root));
+        // Raíz llena: nueva raíz por encima y división
+        ir.emit(ADeadOp::Load8 { dst: Reg::RAX, base: Reg::RDI, disp: 0 });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(MAX_KEYS) });
+        jcc(ir, Condition::NotEqual, descend);
+        call(ir, self.alloc);
+        store(ir, Reg::RAX, CHILD, Reg::RDI);
+        store(ir, Reg::RBX, ROOT, Reg::RAX);
+        mov(ir, Reg::RDI, Operand::Reg(Reg::RAX));
+        zero(ir, Reg::RCX);
+        call(ir, self.split);
+
+        ir.emit(ADeadOp::Label(descend));
+        call(ir, self.scan);
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: Operand::Reg(Reg::RDX) });
+        jcc(ir, Condition::AboveEq, not_here);
+        ir.emit(ADeadOp::Cmp { left: mem(Reg::RAX, 0), right: Operand::Reg(Reg::R12) });
+        jcc(ir, Condition::Equal, hit);
+        ir.emit(ADeadOp::Label(not_here));
+        mov(ir, Reg::RAX, mem(Reg::RDI, CHILD));
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, leaf);
+        lea_index(ir, Reg::RAX, Reg::RDI, Reg::RCX, 8);
+        mov(ir, Reg::RAX, mem(Reg::RAX, CHILD));
+        ir.emit(ADeadOp::Load8 { dst: Reg::RDX, base: Reg::RAX, disp: 0 });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RDX), right: Operand::Imm32(MAX_KEYS) });
+        jcc(ir, Condition::NotEqual, go_down);
+        // Hijo lleno: partirlo y elegir mitad según la mediana subida
+        call(ir, self.split);
+        lea_index(ir, Reg::RAX, Reg::RDI, Reg::RCX, 8);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Imm32(KEYS) });
+        ir.emit(ADeadOp::Cmp { left: mem(Reg::RAX, 0), right: Operand::Reg(Reg::R12) });
+        jcc(ir, Condition::Equal, hit);
+        jcc(ir, Condition::Greater, left);
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::RCX) });
+        ir.emit(ADeadOp::Label(left));
+        lea_index(ir, Reg::RAX, Reg::RDI, Reg::RCX, 8);
+        mov(ir, Reg::RAX, mem(Reg::RAX, CHILD));
+        ir.emit(ADeadOp::Label(go_down));
+        mov(ir, Reg::RDI, Operand::Reg(Reg::RAX));
+        ir.emit(ADeadOp::Jmp { target: descend });
+
+        // RAX = &claves[RCX] en RDI
+        ir.emit(ADeadOp::Label(hit));
+        Self::load_dead(ir);
+        jcc(ir, Condition::NotEqual, revive);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Imm32(KEY_TO_VAL) });
+        ir.emit(ADeadOp::Ret);
+        ir.emit(ADeadOp::Label(revive));
+        zero(ir, Reg::RDX);
+        ir.emit(ADeadOp::Store8 { base: Reg::R8, disp: DEAD, src: Reg::RDX });
+        ir.emit(ADeadOp::Inc { dst: mem(Reg::RBX, SIZE) });
+        ir.emit(ADeadOp::Dec { dst: mem(Reg::RBX, TOMBS) });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Imm32(KEY_TO_VAL) });
+        store(ir, Reg::RAX, 0, Reg::RDX);
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::RDX) });
+        ir.emit(ADeadOp::Ret);
+
+        // Hoja: hueco en RCX
+        ir.emit(ADeadOp::Label(leaf));
+        call(ir, self.open);
+        lea_index(ir, Reg::R8, Reg::RDI, Reg::RCX, 8);
+        store(ir, Reg::R8, KEYS, Reg::R12);
+        zero(ir, Reg::RAX);
+        store(ir, Reg::R8, VALS, Reg::RAX);
+        lea_index(ir, Reg::R9, Reg::RDI, Reg::RCX, 1);
+        ir.emit(ADeadOp::Store8 { base: Reg::R9, disp: DEAD, src: Reg::RAX });
+        ir.emit(ADeadOp::Load8 { dst: Reg::RAX, base: Reg::RDI, disp: 0 });
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::RAX) });
+        ir.emit(ADeadOp::Store8 { base: Reg::RDI, disp: 0, src: Reg::RAX });
+        ir.emit(ADeadOp::Inc { dst: mem(Reg::RBX, SIZE) });
+        ir.emit(ADeadOp::Lea { dst: Reg::RAX, src: mem(Reg::R8, VALS) });
+        mov(ir, Reg::RDX, Operand::Imm32(1));
+        ir.emit(ADeadOp::Label(fail));
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// RBX = árbol, R12 = clave → RAX = &claves[RCX] en el nodo RDI
+    /// (viva o lápida), o 0
+    fn emit_find_node(&self, ir: &mut ADeadIR) {
+        let top = ir.new_label();
+        let miss = ir.new_label();
+        let none = ir.new_label();
+        let got = ir.new_label();
+        ir.emit(ADeadOp::Label(self.find_node));
+        mov(ir, Reg::RDI, mem(Reg::RBX, ROOT));
+        ir.emit(ADeadOp::Test { left: Reg::RDI, right: Reg::RDI });
+        jcc(ir, Condition::Equal, none);
+        ir.emit(ADeadOp::Label(top));
+        call(ir, self.scan);
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: Operand::Reg(Reg::RDX) });
+        jcc(ir, Condition::AboveEq, miss);
+        ir.emit(ADeadOp::Cmp { left: mem(Reg::RAX, 0), right: Operand::Reg(Reg::R12) });
+        jcc(ir, Condition::Equal, got);
+        ir.emit(ADeadOp::Label(miss));
+        lea_index(ir, Reg::RAX, Reg::RDI, Reg::RCX, 8);
+        mov(ir, Reg::RDI, mem(Reg::RAX, CHILD));
+        ir.emit(ADeadOp::Test { left: Reg::RDI, right: Reg::RDI });
+        jcc(ir, Condition::NotEqual, top);
+        ir.emit(ADeadOp::Label(none));
+        zero(ir, Reg::RAX);
+        ir.emit(ADeadOp::Label(got));
+        ir.emit(ADeadOp::Ret);
+    }
+
+    // ---- Reconstrucción ----
+
+    /// Vuelca las vivas en orden a un buffer, suelta las arenas y las
+    /// reinserta en arenas nuevas. Sin páginas para el buffer no hace nada
+    fn emit_compact(&self, ir: &mut ADeadIR) {
+        let emptied = ir.new_label();
+        let top = ir.new_label();
+        let lost = ir.new_label();
+        let done = ir.new_label();
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.compact));
+        mov(ir, Reg::R13, mem(Reg::RBX, SIZE));
+        ir.emit(ADeadOp::Test { left: Reg::R13, right: Reg::R13 });
+        jcc(ir, Condition::Equal, emptied);
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R13));
+        ir.emit(ADeadOp::Shl { dst: Reg::RCX, amount: 4 });
+        push(ir, Reg::RCX);
+        call(ir, self.map);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        mov(ir, Reg::R14, Operand::Reg(Reg::RAX));
+        mov(ir, Reg::R15, Operand::Reg(Reg::RAX));
+        mov(ir, Reg::RDI, mem(Reg::RBX, ROOT));
+        call(ir, self.walk);
+        // Soltar antes de reinsertar: las arenas nuevas reusan esas páginas
+        call(ir, self.drop_arenas);
+        mov(ir, Reg::R15, Operand::Reg(Reg::R14));
+        ir.emit(ADeadOp::Label(top));
+        mov(ir, Reg::R12, mem(Reg::R15, 0));
+        call(ir, self.locate);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, lost);
+        mov(ir, Reg::RCX, mem(Reg::R15, 8));
+        store(ir, Reg::RAX, 0, Reg::RCX);
+        ir.emit(ADeadOp::Label(lost));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::R15), src: Operand::Imm32(16) });
+        ir.emit(ADeadOp::Dec { dst: Operand::Reg(Reg::R13) });
+        jcc(ir, Condition::NotEqual, top);
+        ir.emit(ADeadOp::Label(done));
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R14));
+        mov(ir, Reg::RDX, mem(Reg::RSP, 0));
+        call(ir, self.unmap);
+        ir.emit(ADeadOp::Label(out));
+        pop(ir, Reg::RCX);
+        ir.emit(ADeadOp::Ret);
+        ir.emit(ADeadOp::Label(emptied));
+        call(ir, self.drop_arenas);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// RDI = nodo, R15 = cursor: escribe {clave, valor} de las vivas en
+    /// orden. Recursiva; conserva RBX y RBP
+    fn emit_walk(&self, ir: &mut ADeadIR) {
+        let top = ir.new_label();
+        let leaf = ir.new_label();
+        let next = ir.new_label();
+        let tail = ir.new_label();
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(self.walk));
+        push(ir, Reg::RBX);
+        push(ir, Reg::RBP);
+        mov(ir, Reg::RBX, Operand::Reg(Reg::RDI));
+        zero(ir, Reg::RBP);
+        ir.emit(ADeadOp::Label(top));
+        ir.emit(ADeadOp::Load8 { dst: Reg::RAX, base: Reg::RBX, disp: 0 });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RBP), right: Operand::Reg(Reg::RAX) });
+        jcc(ir, Condition::AboveEq, tail);
+        lea_index(ir, Reg::RAX, Reg::RBX, Reg::RBP, 8);
+        mov(ir, Reg::RDI, mem(Reg::RAX, CHILD));
+        ir.emit(ADeadOp::Test { left: Reg::RDI, right: Reg::RDI });
+        jcc(ir, Condition::Equal, leaf);
+        call(ir, self.walk);
+        ir.emit(ADeadOp::Label(leaf));
+        lea_index(ir, Reg::RAX, Reg::RBX, Reg::RBP, 1);
+        ir.emit(ADeadOp::Load8 { dst: Reg::RAX, base: Reg::RAX, disp: DEAD });
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::NotEqual, next);
+        lea_index(ir, Reg::RAX, Reg::RBX, Reg::RBP, 8);
+        for (from, to) in [(KEYS, 0), (VALS, 8)] {
+            mov(ir, Reg::RCX, mem(Reg::RAX, from));
+            store(ir, Reg::R15, to, Reg::RCX);
+        }
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::R15), src: Operand::Imm32(16) });
+        ir.emit(ADeadOp::Label(next));
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::RBP) });
+        ir.emit(ADeadOp::Jmp { target: top });
+        ir.emit(ADeadOp::Label(tail));
+        lea_index(ir, Reg::RAX, Reg::RBX, Reg::RBP, 8);
+        mov(ir, Reg::RDI, mem(Reg::RAX, CHILD));
+        ir.emit(ADeadOp::Test { left: Reg::RDI, right: Reg::RDI });
+        jcc(ir, Condition::Equal, done);
+        call(ir, self.walk);
+        ir.emit(ADeadOp::Label(done));
+        pop(ir, Reg::RBP);
+        pop(ir, Reg::RBX);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// RBX = árbol: suelta todas las arenas y lo deja vacío. Conserva R12-R15
+    fn emit_drop_arenas(&self, ir: &mut ADeadIR) {
+        let top = ir.new_label();
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(self.drop_arenas));
+        mov(ir, Reg::RSI, mem(Reg::RBX, ARENAS));
+        ir.emit(ADeadOp::Label(top));
+        ir.emit(ADeadOp::Test { left: Reg::RSI, right: Reg::RSI });
+        jcc(ir, Condition::Equal, done);
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RSI));
+        mov(ir, Reg::RDX, mem(Reg::RSI, 8));
+        mov(ir, Reg::RSI, mem(Reg::RSI, 0));
+        call(ir, self.unmap);
+        ir.emit(ADeadOp::Jmp { target: top });
+        ir.emit(ADeadOp::Label(done));
+        zero(ir, Reg::RAX);
+        for field in [ROOT, SIZE, TOMBS, ARENAS, CUR, END] {
+            store(ir, Reg::RBX, field, Reg::RAX);
+        }
+        mov(ir, Reg::RAX, Operand::Imm32(FIRST_ARENA));
+        store(ir, Reg::RBX, NEXT_BYTES, Reg::RAX);
+        ir.emit(ADeadOp::Ret);
+    }
+}
+
+#[cfg(all(test, target_os = "linux", target_arch = "x86_64"))]
+mod tests {
+    use super::*;
+    use crate::isa::test_jit::JitCode;
+    use std::collections::BTreeMap;
+
+    #[test]
+    fn test_btree_routines() {
+        let mut ir = ADeadIR::new();
+        let tree = BTree::new(&mut ir, PageSource::Syscall, false);
+        tree.emit_routines(&mut ir);
+        let code = JitCode::new(ir.ops());
+
+        unsafe {
+            let new: extern "C" fn() -> i64 = code.func(tree.new);
+            let slot: extern "C" fn(i64, i64) -> *mut i64 = code.func(tree.slot);
+            let insert: extern "C" fn(i64, i64, i64) -> i64 = code.func(tree.insert);
+            let find: extern "C" fn(i64, i64) -> *mut i64 = code.func(tree.find);
+            let erase: extern "C" fn(i64, i64) -> i64 = code.func(tree.erase);
+            let len: extern "C" fn(i64) -> i64 = code.func(tree.size);
+            let clear: extern "C" fn(i64) -> i64 = code.func(tree.clear);
+            let free: extern "C" fn(i64) -> i64 = code.func(tree.free);
+
+            let t = new();
+            assert_ne!(t, 0);
+            let mut want: BTreeMap<i64, i64> = BTreeMap::new();
+            // Ascendentes (divisiones por la derecha), aleatorias con
+            // negativos, y borrados que fuerzan reconstrucciones
+            for k in 0..5000i64 {
+                assert_eq!(insert(t, k * 3, k), 1);
+                want.insert(k * 3, k);
+            }
+            let mut seed = 5u64;
+            for round in 0..60_000i64 {
+                seed = seed.wrapping_mul(6364136223846793005).wrapping_add(1442695040888963407);
+                let k = (seed >> 33) as i64 % 40_000 - 20_000;
+                match round % 4 {
+                    0 => {
+                        let fresh = !want.contains_key(&k);
+                        assert_eq!(insert(t, k, round), fresh as i64);
+                        want.entry(k).or_insert(round);
+                    }
+                    1 => {
+                        *slot(t, k) += 7;
+                        *want.entry(k).or_insert(0) += 7;
+                    }
+                    2 => assert_eq!(erase(t, k), want.remove(&k).is_some() as i64),
+                    _ => {
+                        let p = find(t, k);
+                        match want.get(&k) {
+                            Some(&v) => assert_eq!(*p, v),
+                            None => assert!(p.is_null()),
+                        }
+                    }
+                }
+            }
+            assert_eq!(len(t), want.len() as i64);
+            for (&k, &v) in &want {
+                assert_eq!(*find(t, k), v);
+            }
+            let keys: Vec<i64> = want.keys().copied().collect();
+            for &k in &keys[..keys.len() - 10] {
+                assert_eq!(erase(t, k), 1);
+            }
+            assert_eq!(len(t), 10);
+            for &k in &keys[keys.len() - 10..] {
+                assert_eq!(*find(t, k), want[&k]);
+            }
+
+            clear(t);
+            assert_eq!(len(t), 0);
+            assert!(find(t, keys[0]).is_null());
+            assert_eq!(insert(t, i64::MIN, 9), 1);
+            assert_eq!(*find(t, i64::MIN), 9);
+            free(t);
+        }
+    }
+}
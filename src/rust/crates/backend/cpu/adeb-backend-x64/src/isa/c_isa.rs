@@ -273,6 +273,68 @@ impl CIsaCompiler {
     pub fn used_iat_slots(&self) -> &std::collections::HashSet<usize> {
         self.inner.used_iat_slots()
     }
+
+    /// Number of threads used for per-function codegen (1 = serial).
+    pub fn set_codegen_jobs(&mut self, jobs: usize) {
+        self.inner.set_codegen_jobs(jobs);
+    }
+
+    /// SIMD width the loop vectorizer may use (Bits256 enables AVX2).
+    pub fn set_bit_target(&mut self, target: super::bit_resolver::BitTarget) {
+        self.inner.set_bit_target(target);
+    }
+
+    /// Loop vectorizer decisions, in emission order.
+    pub fn loop_reports(&self) -> &[super::loop_vectorizer::LoopReport] {
+        self.inner.loop_reports()
+    }
+
+    /// Scheduler pass statistics from the last compile (only with `set_tune`).
+    pub fn schedule_stats(&self) -> Option<&super::optimizer::OptStats> {
+        self.inner.schedule_stats()
+    }
+
+    /// IR ops and `.text` bytes per function from the last compile.
+    pub fn function_stats(&self) -> &[super::isa_compiler::FunctionCodeStats] {
+        self.inner.function_stats()
+    }
+
+    /// Extra per-function versions selected at load time by CPUID.
+    pub fn set_target_clones(&mut self, targets: &[super::bit_resolver::BitTarget]) {
+        self.inner.set_target_clones(targets);
+    }
+
+    /// Functions emitted in more than one version.
+    pub fn cloned_functions(&self) -> Vec<&str> {
+        self.inner.cloned_functions()
+    }
+
+    /// Counts from `-fprofile-use`: cold if-arms move out of line and
+    /// hot locals win the register allocator.
+    pub fn set_profile(&mut self, profile: adeb_middle::profile::Profile) {
+        self.inner.set_profile(profile);
+    }
+
+    /// `-mtune`: list-schedule the IR for one core before encoding.
+    pub fn set_tune(&mut self, tune: super::scheduler::Uarch) {
+        self.inner.set_tune(tune);
+    }
+
+    /// `-fbuiltin-malloc`: malloc/free/calloc/realloc go to the built-in
+    /// size-class heap instead of msvcrt (always on for `Target::Linux`).
+    pub fn set_builtin_heap(&mut self, enabled: bool) {
+        self.inner.set_builtin_heap(enabled);
+    }
+
+    /// `-g`: line markers in the IR, symbols and line table after `compile`.
+    pub fn set_debug_info(&mut self, enabled: bool) {
+        self.inner.set_debug_info(enabled);
+    }
+
+    /// Function symbols and line table of the last `compile` (-g).
+    pub fn debug_info(&self) -> Option<&super::debug_info::DebugInfo> {
+        self.inner.debug_info()
+    }
 }
 
 // ============================================================
@@ -312,6 +374,7 @@ pub fn c99_sizeof_for_expr(ty: &Type) -> i64 {
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::frontend::ast::*;
 
     #[test]
     fn test_c99_sizeof_basic() {
@@ -355,4 +418,632 @@ mod tests {
         assert_eq!(align_to(4, 4), 4);
         assert_eq!(align_to(5, 8), 8);
     }
+
+    fn num(n: i64) -> Expr {
+        Expr::Number(n)
+    }
+
+    fn var(n: &str) -> Expr {
+        Expr::Variable(n.to_string())
+    }
+
+    /// f_i(a, b) { while (a < b) { if (a > i) a = a * 2; a = a + 1; } return a - b; }
+    fn loop_function(i: i64) -> Function {
+        let body = vec![
+            Stmt::While {
+                condition: Expr::Comparison {
+                    op: CmpOp::Lt,
+                    left: Box::new(var("a")),
+                    right: Box::new(var("b")),
+                },
+                body: vec![
+                    Stmt::If {
+                        condition: Expr::Comparison {
+                            op: CmpOp::Gt,
+                            left: Box::new(var("a")),
+                            right: Box::new(num(i)),
+                        },
+                        then_body: vec![Stmt::Assign {
+                            name: "a".to_string(),
+                            value: Expr::BinaryOp {
+                                op: BinOp::Mul,
+                                left: Box::new(var("a")),
+                                right: Box::new(num(2)),
+                            },
+                        }],
+                        else_body: None,
+                    },
+                    Stmt::Assign {
+                        name: "a".to_string(),
+                        value: Expr::BinaryOp {
+                            op: BinOp::Add,
+                            left: Box::new(var("a")),
+                            right: Box::new(num(1)),
+                        },
+                    },
+                ],
+            },
+            Stmt::Return(Some(Expr::BinaryOp {
+                op: BinOp::Sub,
+                left: Box::new(var("a")),
+                right: Box::new(var("b")),
+            })),
+        ];
+        Function {
+            name: format!("f{}", i),
+            params: vec![
+                Param::typed("a".to_string(), Type::I64),
+                Param::typed("b".to_string(), Type::I64),
+            ],
+            return_type: None,
+            resolved_return_type: Type::I64,
+            body,
+            attributes: FunctionAttributes::default(),
+        }
+    }
+
+    #[test]
+    fn test_parallel_codegen_matches_serial() {
+        let mut program = Program::new();
+        let mut main_body = Vec::new();
+        for i in 0..16 {
+            program.functions.push(loop_function(i));
+            main_body.push(Stmt::Expr(Expr::Call {
+                name: format!("f{}", i),
+                args: vec![num(i), num(100)],
+            }));
+        }
+        main_body.push(Stmt::Return(Some(num(0))));
+        program.functions.push(Function {
+            name: "main".to_string(),
+            params: vec![],
+            return_type: None,
+            resolved_return_type: Type::I32,
+            body: main_body,
+            attributes: FunctionAttributes::default(),
+        });
+
+        let mut serial = CIsaCompiler::new(Target::Windows);
+        serial.set_codegen_jobs(1);
+        let serial_out = serial.compile(&program);
+
+        let mut parallel = CIsaCompiler::new(Target::Windows);
+        parallel.set_codegen_jobs(4);
+        let parallel_out = parallel.compile(&program);
+
+        assert_eq!(serial_out, parallel_out);
+        assert_eq!(serial.used_iat_slots(), parallel.used_iat_slots());
+    }
+
+    #[test]
+    fn test_function_stats_cover_each_function() {
+        let mut program = Program::new();
+        let mut main_body = Vec::new();
+        for i in 0..4 {
+            program.functions.push(loop_function(i));
+            main_body.push(Stmt::Expr(Expr::Call {
+                name: format!("f{}", i),
+                args: vec![num(i), num(100)],
+            }));
+        }
+        main_body.push(Stmt::Return(Some(num(0))));
+        program.functions.push(Function {
+            name: "main".to_string(),
+            params: vec![],
+            return_type: None,
+            resolved_return_type: Type::I32,
+            body: main_body,
+            attributes: FunctionAttributes::default(),
+        });
+        let mut compiler = CIsaCompiler::new(Target::Windows);
+        compiler.set_codegen_jobs(2);
+        let (code, ..) = compiler.compile(&program);
+
+        let stats = compiler.function_stats();
+        let mut names: Vec<&str> = stats.iter().map(|f| f.name.as_str()).collect();
+        names.sort_unstable();
+        assert_eq!(names, ["f0", "f1", "f2", "f3", "main"]);
+        assert!(stats.iter().all(|f| f.ops > 0 && f.bytes > 0));
+        assert!(stats.iter().map(|f| f.bytes).sum::<usize>() <= code.len());
+        assert!(compiler.schedule_stats().is_none());
+    }
+
+    fn bin(op: BinOp, left: Expr, right: Expr) -> Expr {
+        Expr::BinaryOp {
+            op,
+            left: Box::new(left),
+            right: Box::new(right),
+        }
+    }
+
+    /// IR of `main() { <body> }`
+    fn main_ops(body: Vec<Stmt>) -> Vec<crate::isa::ADeadOp> {
+        main_ops_profiled(body, None)
+    }
+
+    fn main_ops_profiled(body: Vec<Stmt>, profile: Option<&str>) -> Vec<crate::isa::ADeadOp> {
+        let mut program = Program::new();
+        program.functions.push(Function {
+            name: "main".to_string(),
+            params: vec![],
+            return_type: None,
+            resolved_return_type: Type::I64,
+            body,
+            attributes: FunctionAttributes::default(),
+        });
+        let mut compiler = CIsaCompiler::new(Target::Windows);
+        compiler.set_codegen_jobs(1);
+        if let Some(text) = profile {
+            compiler.set_profile(adeb_middle::profile::Profile::parse(text).unwrap());
+        }
+        compiler.compile(&program);
+        compiler.inner.ir().ops().to_vec()
+    }
+
+    /// Spills (push rax) of `main() { a = 3; b = 4; c = 5; return <expr>; }`
+    fn pushes_for(result: Expr) -> usize {
+        let mut body: Vec<Stmt> = ["a", "b", "c"]
+            .iter()
+            .zip([3, 4, 5])
+            .map(|(name, value)| Stmt::VarDecl {
+                var_type: Type::I64,
+                name: name.to_string(),
+                value: Some(num(value)),
+            })
+            .collect();
+        body.push(Stmt::Return(Some(result)));
+        main_ops(body)
+            .iter()
+            .filter(|op| {
+                use crate::isa::{ADeadOp, Operand, Reg};
+                matches!(op, ADeadOp::Push { src: Operand::Reg(Reg::RAX) })
+            })
+            .count()
+    }
+
+    #[test]
+    fn test_integer_expressions_avoid_stack() {
+        let prologue = pushes_for(var("a"));
+        // a + b * c - (a ^ b)
+        let tree = bin(
+            BinOp::Sub,
+            bin(BinOp::Add, var("a"), bin(BinOp::Mul, var("b"), var("c"))),
+            Expr::BitwiseOp {
+                op: BitwiseOp::Xor,
+                left: Box::new(var("a")),
+                right: Box::new(var("b")),
+            },
+        );
+        assert_eq!(pushes_for(tree), prologue);
+        // (a + 1) * (b - c) / (c + 2): division keeps RDX:RAX, still no spill
+        let div = bin(
+            BinOp::Div,
+            bin(BinOp::Mul, bin(BinOp::Add, var("a"), num(1)), bin(BinOp::Sub, var("b"), var("c"))),
+            bin(BinOp::Add, var("c"), num(2)),
+        );
+        assert_eq!(pushes_for(div), prologue);
+        // A call on the right of a non-trivial left still spills through the stack
+        let call = bin(
+            BinOp::Add,
+            bin(BinOp::Div, var("a"), var("b")),
+            Expr::Call { name: "main".to_string(), args: vec![] },
+        );
+        assert!(pushes_for(call) > prologue);
+    }
+
+    #[test]
+    fn test_loop_locals_live_in_registers() {
+        use crate::isa::{ADeadOp, Operand, Reg};
+        // long i = 0; long sum = 0; while (i < 10) { sum += i; i++; } return sum;
+        let decl = |name: &str| Stmt::VarDecl {
+            var_type: Type::I64,
+            name: name.to_string(),
+            value: Some(num(0)),
+        };
+        let ops = main_ops(vec![
+            decl("i"),
+            decl("sum"),
+            Stmt::While {
+                condition: Expr::Comparison {
+                    op: CmpOp::Lt,
+                    left: Box::new(var("i")),
+                    right: Box::new(num(10)),
+                },
+                body: vec![
+                    Stmt::CompoundAssign {
+                        name: "sum".to_string(),
+                        op: CompoundOp::AddAssign,
+                        value: var("i"),
+                    },
+                    Stmt::Increment {
+                        name: "i".to_string(),
+                        is_pre: false,
+                        is_increment: true,
+                    },
+                ],
+            },
+            Stmt::Return(Some(var("sum"))),
+        ]);
+        // i++ es inc r12; sum vive en r13. main es hoja: sin frame, r13
+        // se guarda con push/pop
+        assert!(ops.contains(&ADeadOp::Inc { dst: Operand::Reg(Reg::R12) }));
+        assert!(ops.contains(&ADeadOp::Push { src: Operand::Reg(Reg::R13) }));
+        assert!(ops.contains(&ADeadOp::Pop { dst: Reg::R13 }));
+        assert!(!ops.iter().any(|op| matches!(op, ADeadOp::Inc { dst: Operand::Mem { .. } })));
+        assert!(!ops.contains(&ADeadOp::Push { src: Operand::Reg(Reg::RBP) }));
+    }
+
+    #[test]
+    fn test_target_clones_dispatch_hot_loops() {
+        use crate::isa::bit_resolver::BitTarget;
+        // scale(int *a, long n) { long i = 0; while (i < n) { a[i] = a[i] * 3; i++; } return 0; }
+        let scale = Function {
+            name: "scale".to_string(),
+            params: vec![
+                Param::typed("a".to_string(), Type::Pointer(Box::new(Type::I32))),
+                Param::typed("n".to_string(), Type::I64),
+            ],
+            return_type: None,
+            resolved_return_type: Type::I64,
+            body: vec![
+                Stmt::VarDecl { var_type: Type::I64, name: "i".to_string(), value: Some(num(0)) },
+                Stmt::While {
+                    condition: Expr::Comparison {
+                        op: CmpOp::Lt,
+                        left: Box::new(var("i")),
+                        right: Box::new(var("n")),
+                    },
+                    body: vec![
+                        Stmt::IndexAssign {
+                            object: var("a"),
+                            index: var("i"),
+                            value: bin(
+                                BinOp::Mul,
+                                Expr::Index { object: Box::new(var("a")), index: Box::new(var("i")) },
+                                num(3),
+                            ),
+                        },
+                        Stmt::Increment { name: "i".to_string(), is_pre: false, is_increment: true },
+                    ],
+                },
+                Stmt::Return(Some(num(0))),
+            ],
+            attributes: FunctionAttributes::default(),
+        };
+        let mut program = Program::new();
+        program.functions.push(scale);
+        program.functions.push(loop_function(0));
+        program.functions.push(Function {
+            name: "main".to_string(),
+            params: vec![],
+            return_type: None,
+            resolved_return_type: Type::I64,
+            body: vec![
+                Stmt::Expr(Expr::Call { name: "scale".to_string(), args: vec![num(0), num(0)] }),
+                Stmt::Return(Some(Expr::Call { name: "f0".to_string(), args: vec![num(1), num(2)] })),
+            ],
+            attributes: FunctionAttributes::default(),
+        });
+
+        let xgetbv = |code: &[u8]| code.windows(3).any(|w| w == [0x0F, 0x01, 0xD0]);
+        let mut plain = CIsaCompiler::new(Target::Windows);
+        plain.set_target_clones(&[]);
+        let (plain_code, ..) = plain.compile(&program);
+        assert!(plain.cloned_functions().is_empty());
+        assert!(!xgetbv(&plain_code));
+
+        let mut serial = CIsaCompiler::new(Target::Windows);
+        serial.set_codegen_jobs(1);
+        serial.set_target_clones(&[BitTarget::Bits256]);
+        let serial_out = serial.compile(&program);
+        // f0 no tiene bucle vectorizable: una sola versión
+        assert_eq!(serial.cloned_functions(), vec!["scale"]);
+        assert!(xgetbv(&serial_out.0));
+        assert!(serial.loop_reports().iter().any(|r| r.function == "scale@256" && r.skipped.is_none()));
+    }
+
+    #[test]
+    fn test_dense_switch_uses_jump_table() {
+        // switch (x) { case 0..=9: return k * 7; case 1000: return 1; default: return -1; }
+        let mut cases: Vec<SwitchCase> = (0..10)
+            .map(|k| SwitchCase { value: num(k), body: vec![Stmt::Return(Some(num(k * 7)))], has_break: false })
+            .collect();
+        cases.push(SwitchCase { value: num(1000), body: vec![Stmt::Return(Some(num(1)))], has_break: false });
+        let classify = Function {
+            name: "main".to_string(),
+            params: vec![Param::typed("x".to_string(), Type::I64)],
+            return_type: None,
+            resolved_return_type: Type::I64,
+            body: vec![Stmt::Switch {
+                expr: var("x"),
+                cases,
+                default: Some(vec![Stmt::Return(Some(num(-1)))]),
+            }],
+            attributes: FunctionAttributes::default(),
+        };
+        let mut program = Program::new();
+        program.functions.push(classify);
+
+        let mut compiler = CIsaCompiler::new(Target::Windows);
+        let (code, ..) = compiler.compile(&program);
+        // movsxd rax, [rcx+rax*4]; add rax, rcx; jmp rax
+        let dispatch = code.windows(9).position(|w| w == [0x48, 0x63, 0x04, 0x81, 0x48, 0x01, 0xC8, 0xFF, 0xE0]);
+        let table = dispatch.expect("jump table dispatch") + 9;
+        // Entradas relativas a la tabla, todas hacia adelante y distintas
+        let entries: Vec<i32> = (0..10)
+            .map(|k| i32::from_le_bytes(code[table + 4 * k..table + 4 * k + 4].try_into().unwrap()))
+            .collect();
+        assert!(entries.iter().all(|&e| e >= 40));
+        assert!(entries.windows(2).all(|w| w[0] < w[1]));
+    }
+
+    #[test]
+    fn test_constant_div_mod_avoid_idiv() {
+        let bin = |op, left, right| Expr::BinaryOp { op, left: Box::new(left), right: Box::new(right) };
+        // return x / 10 + x % 16 + x * 40;
+        let sum = bin(
+            BinOp::Add,
+            bin(BinOp::Add, bin(BinOp::Div, var("x"), num(10)), bin(BinOp::Mod, var("x"), num(16))),
+            bin(BinOp::Mul, var("x"), num(40)),
+        );
+        let main = Function {
+            name: "main".to_string(),
+            params: vec![Param::typed("x".to_string(), Type::I64)],
+            return_type: None,
+            resolved_return_type: Type::I64,
+            body: vec![Stmt::Return(Some(sum))],
+            attributes: FunctionAttributes::default(),
+        };
+        let mut program = Program::new();
+        program.functions.push(main);
+
+        let mut compiler = CIsaCompiler::new(Target::Windows);
+        let (code, ..) = compiler.compile(&program);
+        // Sin cqo: ni IDIV ni su extensión de signo
+        assert!(!code.windows(2).any(|w| w == [0x48, 0x99]));
+        // mov rdx, 0x6666666666666667 (mágico de /10)
+        let magic = 0x6666_6666_6666_6667u64.to_le_bytes();
+        assert!(code.windows(8).any(|w| w == magic));
+    }
+
+    #[test]
+    fn test_mem_builtins_expand_inline() {
+        let call = |name: &str, args: Vec<Expr>| Expr::Call { name: name.to_string(), args };
+        // memcpy(p, q, 24); memset(p, 0, n); return memcmp(p, q, n);
+        let main = Function {
+            name: "main".to_string(),
+            params: ["p", "q", "n"].iter().map(|p| Param::typed(p.to_string(), Type::I64)).collect(),
+            return_type: None,
+            resolved_return_type: Type::I64,
+            body: vec![
+                Stmt::Expr(call("memcpy", vec![var("p"), var("q"), num(24)])),
+                Stmt::Expr(call("memset", vec![var("p"), num(0), var("n")])),
+                Stmt::Return(Some(call("memcmp", vec![var("p"), var("q"), var("n")]))),
+            ],
+            attributes: FunctionAttributes::default(),
+        };
+        let mut program = Program::new();
+        program.functions.push(main);
+
+        let mut compiler = CIsaCompiler::new(Target::Windows);
+        compiler.set_bit_target(crate::isa::bit_resolver::BitTarget::Bits64);
+        let (code, ..) = compiler.compile(&program);
+        // Sin llamadas por la IAT (call [rip+disp32])
+        assert!(!code.windows(2).any(|w| w == [0xFF, 0x15]));
+        // mov rax, [rsi+16]; mov [rdi+16], rax — tercer qword de la copia
+        assert!(code.windows(8).any(|w| w == [0x48, 0x8B, 0x46, 0x10, 0x48, 0x89, 0x47, 0x10]));
+        // Tamaño desconocido sin YMM: rep stosb y repe cmpsb
+        assert!(code.windows(2).any(|w| w == [0xF3, 0xAA]));
+        assert!(code.windows(2).any(|w| w == [0xF3, 0xA6]));
+    }
+
+    #[test]
+    fn test_tail_calls_and_frameless_leaves() {
+        use crate::isa::{ADeadOp, Operand, Reg};
+        let call = |name: &str, args: Vec<Expr>| Expr::Call { name: name.to_string(), args };
+        let func = |name: &str, params: &[&str], body: Vec<Stmt>| Function {
+            name: name.to_string(),
+            params: params.iter().map(|p| Param::typed(p.to_string(), Type::I64)).collect(),
+            return_type: None,
+            resolved_return_type: Type::I64,
+            body,
+            attributes: FunctionAttributes::default(),
+        };
+        // leaf(a, b) { return a * 3 + b; }
+        // sum(n, acc) { if (n == 0) return leaf(acc, n); return sum(n - 1, acc + n); }
+        // main() { return sum(100, 0); }
+        let mut program = Program::new();
+        program.functions.push(func("leaf", &["a", "b"], vec![Stmt::Return(Some(bin(
+            BinOp::Add,
+            bin(BinOp::Mul, var("a"), num(3)),
+            var("b"),
+        )))]));
+        program.functions.push(func("sum", &["n", "acc"], vec![
+            Stmt::If {
+                condition: Expr::Comparison {
+                    op: CmpOp::Eq,
+                    left: Box::new(var("n")),
+                    right: Box::new(num(0)),
+                },
+                then_body: vec![Stmt::Return(Some(call("leaf", vec![var("acc"), var("n")])))],
+                else_body: None,
+            },
+            Stmt::Return(Some(call("sum", vec![
+                bin(BinOp::Sub, var("n"), num(1)),
+                bin(BinOp::Add, var("acc"), var("n")),
+            ]))),
+        ]));
+        program.functions.push(func("main", &[], vec![Stmt::Return(Some(call("sum", vec![num(100), num(0)])))]));
+
+        let mut compiler = CIsaCompiler::new(Target::Windows);
+        compiler.set_codegen_jobs(1);
+        compiler.compile(&program);
+        let ops = compiler.inner.ir().ops();
+        // Todas las llamadas están en posición de cola: ningún call
+        assert!(!ops.iter().any(|op| matches!(op, ADeadOp::Call { .. })));
+        // sum y main montan frame; leaf no (sus parámetros viven en r12/r13)
+        let frames = ops.iter().filter(|op| **op == ADeadOp::Push { src: Operand::Reg(Reg::RBP) }).count();
+        assert_eq!(frames, 2);
+        assert!(ops.contains(&ADeadOp::Mov { dst: Operand::Reg(Reg::R12), src: Operand::Reg(Reg::RCX) }));
+    }
+
+    #[test]
+    fn test_profile_moves_cold_arm_out_of_line() {
+        use crate::isa::{ADeadOp, Condition};
+        // long i = 0; long x = 0;
+        // while (i < 100) { if (i == 77) { x = x + 5; } i++; } return x;
+        let decl = |name: &str| Stmt::VarDecl {
+            var_type: Type::I64,
+            name: name.to_string(),
+            value: Some(num(0)),
+        };
+        let body = vec![
+            decl("i"),
+            decl("x"),
+            Stmt::While {
+                condition: Expr::Comparison {
+                    op: CmpOp::Lt,
+                    left: Box::new(var("i")),
+                    right: Box::new(num(100)),
+                },
+                body: vec![
+                    Stmt::If {
+                        condition: Expr::Comparison {
+                            op: CmpOp::Eq,
+                            left: Box::new(var("i")),
+                            right: Box::new(num(77)),
+                        },
+                        then_body: vec![Stmt::Assign {
+                            name: "x".to_string(),
+                            value: bin(BinOp::Add, var("x"), num(5)),
+                        }],
+                        else_body: None,
+                    },
+                    Stmt::Increment {
+                        name: "i".to_string(),
+                        is_pre: false,
+                        is_increment: true,
+                    },
+                ],
+            },
+            Stmt::Return(Some(var("x"))),
+        ];
+        let to_cold = |ops: &[ADeadOp]| {
+            ops.iter().find_map(|op| match op {
+                ADeadOp::Jcc { cond: Condition::NotEqual, target } => Some(*target),
+                _ => None,
+            })
+        };
+
+        assert_eq!(to_cold(&main_ops(body.clone())), None);
+
+        let profile = "# adeb-profile 1\nfn main 1\nsite 0 loop 1 100\nsite 1 if 100 1\n";
+        let ops = main_ops_profiled(body, Some(profile));
+        let cold = to_cold(&ops).expect("cold then-arm jumps out of line");
+        let cold_at = ops.iter().position(|op| *op == ADeadOp::Label(cold)).unwrap();
+        let ret_at = ops.iter().position(|op| *op == ADeadOp::Ret).unwrap();
+        // El then va detrás del ret y vuelve con un jmp
+        assert!(cold_at > ret_at);
+        assert!(matches!(ops.last(), Some(ADeadOp::Jmp { .. })));
+    }
+
+    #[test]
+    fn test_text_layout_splits_cold_code_and_orders_by_affinity() {
+        use crate::isa::{ADeadOp, CallTarget, Condition};
+        let func = |name: &str, params: Vec<&str>, body: Vec<Stmt>| Function {
+            name: name.to_string(),
+            params: params
+                .into_iter()
+                .map(|p| Param {
+                    name: p.to_string(),
+                    param_type: Type::I64,
+                    default_value: None,
+                })
+                .collect(),
+            return_type: None,
+            resolved_return_type: Type::I64,
+            body,
+            attributes: FunctionAttributes::default(),
+        };
+        let call = |name: &str, args: Vec<Expr>| Expr::Call {
+            name: name.to_string(),
+            args,
+        };
+        let decl = |name: &str| Stmt::VarDecl {
+            var_type: Type::I64,
+            name: name.to_string(),
+            value: Some(num(0)),
+        };
+        // long die() { return 7; }   long hot(long n) { return n + 1; }
+        // main: if (x == 5) { die(); exit(1); }
+        //       while (i < 10) { x = hot(x); i++; } return x;
+        let main_body = vec![
+            decl("i"),
+            decl("x"),
+            Stmt::If {
+                condition: Expr::Comparison {
+                    op: CmpOp::Eq,
+                    left: Box::new(var("x")),
+                    right: Box::new(num(5)),
+                },
+                then_body: vec![
+                    Stmt::Expr(call("die", vec![])),
+                    Stmt::Expr(call("exit", vec![num(1)])),
+                ],
+                else_body: None,
+            },
+            Stmt::While {
+                condition: Expr::Comparison {
+                    op: CmpOp::Lt,
+                    left: Box::new(var("i")),
+                    right: Box::new(num(10)),
+                },
+                body: vec![
+                    Stmt::Assign {
+                        name: "x".to_string(),
+                        value: call("hot", vec![var("x")]),
+                    },
+                    Stmt::Increment {
+                        name: "i".to_string(),
+                        is_pre: false,
+                        is_increment: true,
+                    },
+                ],
+            },
+            Stmt::Return(Some(var("x"))),
+        ];
+        let mut program = Program::new();
+        program.functions.push(func("die", vec![], vec![Stmt::Return(Some(num(7)))]));
+        program.functions.push(func("hot", vec!["n"], vec![Stmt::Return(Some(bin(BinOp::Add, var("n"), num(1))))]));
+        program.functions.push(func("main", vec![], main_body));
+        let mut compiler = CIsaCompiler::new(Target::Windows);
+        compiler.set_codegen_jobs(1);
+        compiler.compile(&program);
+        let ops = compiler.inner.ir().ops().to_vec();
+
+        let at = |label| ops.iter().position(|op| *op == ADeadOp::Label(label)).unwrap();
+        let Some(ADeadOp::Jmp { target: main }) = ops.first() else {
+            panic!("entry jmp");
+        };
+        let cold = ops
+            .iter()
+            .find_map(|op| match op {
+                ADeadOp::Jcc { cond: Condition::NotEqual, target } => Some(*target),
+                _ => None,
+            })
+            .expect("exit arm jumps out of line");
+        let callee = |from: usize| {
+            ops[from..].iter().find_map(|op| match op {
+                ADeadOp::Call { target: CallTarget::Relative(l) } => Some(*l),
+                _ => None,
+            })
+        };
+        let hot = callee(at(*main)).unwrap();
+        let die = callee(at(cold)).unwrap();
+        assert_ne!(hot, die);
+        // [jmp main] main hot | brazo frío de main, die
+        assert!(at(*main) < at(hot));
+        assert!(at(hot) < at(cold));
+        assert!(at(cold) < at(die));
+    }
 }
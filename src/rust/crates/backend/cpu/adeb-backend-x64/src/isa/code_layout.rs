@@ -0,0 +1,239 @@
+// ============================================================
+// ADead-BIB — Layout de .text (hot/cold splitting + afinidad)
+// ============================================================
+// Antes de `Encoder::encode_all` el código es una lista de ADeadOp
+// con labels simbólicos: mover tramos enteros no rompe nada, los
+// rel8/rel32 se resuelven después. El orden final es
+//
+//   [jmp entry] [calientes por afinidad] [resolver/thunks] [región fría]
+//
+// Región fría = brazos fríos de cada función (perfil, o heurística:
+// el brazo acaba en exit/abort/__assert_fail) + funciones que el
+// perfil nunca vio ejecutarse o que solo se llaman desde brazos fríos.
+//
+// Las calientes se ordenan al estilo Pettis-Hansen: se unen cadenas
+// por la arista de llamadas más pesada, así caller y callee comparten
+// líneas de I-cache y páginas del iTLB.
+// ============================================================
+
+use super::ADeadOp;
+use crate::frontend::ast::{Expr, Stmt};
+use std::collections::HashMap;
+use std::ops::Range;
+
+/// Llamadas que no vuelven: el brazo que acaba en una de ellas es frío
+pub const NORETURN_FUNCTIONS: &[&str] = &[
+    "exit",
+    "_exit",
+    "_Exit",
+    "quick_exit",
+    "abort",
+    "__assert_fail",
+    "__builtin_trap",
+    "__builtin_unreachable",
+];
+
+/// Sin perfil, cada nivel de loop multiplica el peso de una llamada
+pub const LOOP_WEIGHT: u64 = 8;
+
+pub fn is_noreturn(name: &str) -> bool {
+    NORETURN_FUNCTIONS.contains(&name)
+}
+
+/// `stmt` es una llamada suelta a algo que no vuelve
+pub fn is_noreturn_call(stmt: &Stmt) -> bool {
+    matches!(stmt, Stmt::Expr(Expr::Call { name, .. }) if is_noreturn(name))
+}
+
+/// Heurística sin perfil, mismo formato que `SiteCount::cold_arm`:
+/// Some(true) = el then acaba en exit/abort, Some(false) = el else
+pub fn noreturn_arm(then_body: &[Stmt], else_body: Option<&[Stmt]>) -> Option<bool> {
+    let ends_cold = |body: &[Stmt]| body.last().is_some_and(is_noreturn_call);
+    if ends_cold(then_body) {
+        Some(true)
+    } else if else_body.is_some_and(ends_cold) {
+        Some(false)
+    } else {
+        None
+    }
+}
+
+/// Código de una función dentro del IR: `ops` entero y, dentro, los
+/// tramos de brazos fríos que `emit_cold_blocks` puso tras el epílogo
+#[derive(Debug, Clone, PartialEq)]
+pub struct FunctionSegment {
+    pub name: String,
+    pub ops: Range<usize>,
+    pub cold: Vec<Range<usize>>,
+}
+
+impl FunctionSegment {
+    /// El mismo segmento en un IR donde empieza `offset` ops más allá
+    pub fn shifted(mut self, offset: usize) -> Self {
+        let shift = |r: &Range<usize>| r.start + offset..r.end + offset;
+        self.ops = shift(&self.ops);
+        self.cold = self.cold.iter().map(shift).collect();
+        self
+    }
+}
+
+/// Arista del grafo de llamadas con las ejecuciones estimadas
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct CallEdge {
+    pub caller: usize,
+    pub callee: usize,
+    pub weight: u64,
+}
+
+/// Orden de las funciones no frías. Pettis-Hansen: de la arista más
+/// pesada a la más ligera, se concatenan las cadenas de sus extremos.
+/// La cadena de `first` (el entry) va delante; el resto por peso.
+pub fn affinity_order(count: usize, edges: &[CallEdge], first: Option<usize>, cold: &[bool]) -> Vec<usize> {
+    let is_cold = |f: usize| cold.get(f).copied().unwrap_or(false);
+    let mut merged: HashMap<(usize, usize), u64> = HashMap::new();
+    for e in edges {
+        if e.caller == e.callee || is_cold(e.caller) || is_cold(e.callee) {
+            continue;
+        }
+        let key = (e.caller.min(e.callee), e.caller.max(e.callee));
+        let w = merged.entry(key).or_insert(0);
+        *w = w.saturating_add(e.weight);
+    }
+    let mut sorted: Vec<((usize, usize), u64)> = merged.into_iter().collect();
+    sorted.sort_by(|a, b| b.1.cmp(&a.1).then(a.0.cmp(&b.0)));
+
+    let mut chains: Vec<Vec<usize>> = (0..count).map(|f| vec![f]).collect();
+    let mut weights = vec![0u64; count];
+    let mut chain_of: Vec<usize> = (0..count).collect();
+    for ((a, b), w) in sorted {
+        let (mut ca, mut cb) = (chain_of[a], chain_of[b]);
+        if ca == cb {
+            continue;
+        }
+        if first.is_some_and(|f| chain_of[f] == cb) {
+            std::mem::swap(&mut ca, &mut cb);
+        }
+        let tail = std::mem::take(&mut chains[cb]);
+        for &f in &tail {
+            chain_of[f] = ca;
+        }
+        chains[ca].extend(tail);
+        weights[ca] = weights[ca].saturating_add(weights[cb]).saturating_add(w);
+    }
+
+    let mut order: Vec<usize> = (0..count).filter(|&c| !chains[c].is_empty()).collect();
+    let entry_chain = first.map(|f| chain_of[f]);
+    order.sort_by_key(|&c| (Some(c) != entry_chain, std::cmp::Reverse(weights[c]), chains[c][0]));
+    order
+        .into_iter()
+        .flat_map(|c| std::mem::take(&mut chains[c]))
+        .filter(|&f| !is_cold(f))
+        .collect()
+}
+
+/// Reordena `ops`: lo previo al primer segmento, las calientes en
+/// `order`, lo posterior al último segmento y la región fría (brazos
+/// fríos en orden de fuente, luego las funciones frías). false (y `ops`
+/// intacto) si los segmentos no forman un tramo contiguo o `order` no cuadra.
+pub fn apply(ops: &mut Vec<ADeadOp>, segments: &[FunctionSegment], order: &[usize], cold: &[bool]) -> bool {
+    let (Some(first), Some(last)) = (segments.first(), segments.last()) else {
+        return false;
+    };
+    let contiguous = segments.windows(2).all(|w| w[0].ops.end == w[1].ops.start);
+    let nested = segments.iter().all(|s| {
+        s.cold.windows(2).all(|w| w[0].end <= w[1].start)
+            && s.cold.iter().all(|r| s.ops.start <= r.start && r.end <= s.ops.end)
+    });
+    let mut seen = vec![false; segments.len()];
+    for &f in order {
+        if f >= segments.len() || seen[f] || cold.get(f).copied().unwrap_or(false) {
+            return false;
+        }
+        seen[f] = true;
+    }
+    let placed = seen.iter().zip(0..).all(|(&s, f)| s || cold.get(f).copied().unwrap_or(false));
+    if !contiguous || !nested || !placed || last.ops.end > ops.len() {
+        return false;
+    }
+
+    let len = ops.len();
+    let mut slots: Vec<Option<ADeadOp>> = std::mem::take(ops).into_iter().map(Some).collect();
+    let mut out = Vec::with_capacity(len);
+    let mut take = |range: Range<usize>, out: &mut Vec<ADeadOp>| {
+        out.extend(slots[range].iter_mut().filter_map(Option::take));
+    };
+    take(0..first.ops.start, &mut out);
+    // Los brazos fríos se sacan antes para que el cuerpo quede sin ellos
+    let mut cold_arms = Vec::new();
+    for seg in segments {
+        for r in &seg.cold {
+            take(r.clone(), &mut cold_arms);
+        }
+    }
+    for &f in order {
+        take(segments[f].ops.clone(), &mut out);
+    }
+    take(last.ops.end..len, &mut out);
+    out.extend(cold_arms);
+    for (f, seg) in segments.iter().enumerate() {
+        if cold.get(f).copied().unwrap_or(false) {
+            take(seg.ops.clone(), &mut out);
+        }
+    }
+    *ops = out;
+    true
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::isa::Label;
+
+    fn edge(caller: usize, callee: usize, weight: u64) -> CallEdge {
+        CallEdge { caller, callee, weight }
+    }
+
+    #[test]
+    fn test_affinity_order_follows_heaviest_edges() {
+        // main(0) llama a rara(1) una vez y a caliente(2) dentro de un loop;
+        // caliente llama a hoja(3); fria(4) solo desde un brazo frío
+        let edges = [edge(0, 1, 1), edge(0, 2, 64), edge(2, 3, 512), edge(0, 4, 1)];
+        let cold = [false, false, false, false, true];
+        assert_eq!(affinity_order(5, &edges, Some(0), &cold), vec![0, 2, 3, 1]);
+        // Sin aristas: orden de fuente con el entry delante
+        assert_eq!(affinity_order(3, &[], Some(2), &[]), vec![2, 0, 1]);
+    }
+
+    #[test]
+    fn test_apply_moves_cold_code_to_the_end() {
+        let mut ops: Vec<ADeadOp> = (0..8).map(|i| ADeadOp::Label(Label(i))).collect();
+        let segments = vec![
+            FunctionSegment { name: "a".into(), ops: 1..4, cold: vec![3..4] },
+            FunctionSegment { name: "b".into(), ops: 4..6, cold: vec![] },
+            FunctionSegment { name: "c".into(), ops: 6..7, cold: vec![] },
+        ];
+        let labels = |ops: &[ADeadOp]| -> Vec<u32> {
+            ops.iter()
+                .map(|op| match op {
+                    ADeadOp::Label(l) => l.0,
+                    _ => unreachable!(),
+                })
+                .collect()
+        };
+        // Huecos entre segmentos: se deja el IR como estaba
+        let gap = vec![segments[0].clone(), segments[2].clone()];
+        assert!(!apply(&mut ops, &gap, &[0, 1], &[]));
+        assert_eq!(labels(&ops), (0..8).collect::<Vec<u32>>());
+
+        assert!(apply(&mut ops, &segments, &[1, 0], &[false, false, true]));
+        assert_eq!(labels(&ops), vec![0, 4, 5, 1, 2, 7, 3, 6]);
+    }
+
+    #[test]
+    fn test_noreturn_arm_heuristic() {
+        let call = |name: &str| Stmt::Expr(Expr::Call { name: name.to_string(), args: vec![] });
+        assert_eq!(noreturn_arm(&[call("puts"), call("exit")], None), Some(true));
+        assert_eq!(noreturn_arm(&[call("puts")], Some(&[call("abort")])), Some(false));
+        assert_eq!(noreturn_arm(&[call("puts")], None), None);
+    }
+}
@@ -243,7 +243,7 @@ impl IsaCompiler {
                 self.collect_strings_from_expr(then_expr);
                 self.collect_strings_from_expr(else_expr);
             }
-            Expr::MethodCall { object, args, .. } => {
+            Expr::MethodCall { object, args, .. } | Expr::VirtualCall { object, args, .. } => {
                 self.collect_strings_from_expr(object);
                 for arg in args {
                     self.collect_strings_from_expr(arg);
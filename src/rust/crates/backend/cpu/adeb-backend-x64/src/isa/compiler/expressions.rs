@@ -321,7 +321,8 @@ impl IsaCompiler {
                 object,
                 method: _,
                 args,
-            } => {
+            }
+            | Expr::VirtualCall { object, args, .. } => {
                 // Primary resolution is in cpp_to_ir (converts to Expr::Call).
                 // This fallback handles any remaining unresolved MethodCalls.
                 self.emit_expression(object);
@@ -0,0 +1,616 @@
+// ============================================================
+// ADead-BIB — Debug info (-g): símbolos y tabla de líneas
+// ============================================================
+// Con -g el compilador deja un `ADeadOp::SourceLine` al inicio de
+// cada sentencia y el encoder anota su offset. Con eso y la
+// posición del label de cada función se construye:
+//
+//   - Símbolos de función (nombre, offset, tamaño) → tabla de
+//     símbolos COFF del PE
+//   - DWARF 4 mínimo: .debug_abbrev + .debug_info (una unidad con un
+//     DW_TAG_subprogram por función) y el programa de .debug_line
+//     que mapea direcciones a fichero:línea
+//
+// Es lo que leen perf, VTune, gdb y llvm-symbolizer para atribuir
+// muestras a función y línea. Sin -g no se emite nada: ni
+// SourceLine en el IR ni secciones en el binario.
+//
+// `from_dwarf` hace el camino inverso sobre las secciones de un PE
+// ya escrito (adB run --profile): sólo entiende lo que emite `dwarf`.
+// ============================================================
+
+/// Función emitida en .text
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct FunctionSymbol {
+    pub name: String,
+    /// Offset dentro de .text
+    pub offset: u32,
+    pub size: u32,
+    /// Índice en `DebugInfo::files`
+    pub file: u32,
+}
+
+/// Fila de la tabla de líneas: desde `offset` el código es de file:line
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct LineRow {
+    pub offset: u32,
+    pub file: u32,
+    pub line: u32,
+}
+
+#[derive(Debug, Clone, Default)]
+pub struct DebugInfo {
+    pub files: Vec<String>,
+    /// Ordenadas por offset
+    pub functions: Vec<FunctionSymbol>,
+    /// Ordenadas por offset, una fila por dirección
+    pub lines: Vec<LineRow>,
+    pub code_size: u32,
+}
+
+/// Secciones DWARF listas para el PE (o un ELF)
+#[derive(Debug, Clone, Default)]
+pub struct DwarfSections {
+    pub abbrev: Vec<u8>,
+    pub info: Vec<u8>,
+    pub line: Vec<u8>,
+}
+
+// Parámetros del programa de líneas (los de GCC)
+const LINE_BASE: i64 = -5;
+const LINE_RANGE: u64 = 14;
+const OPCODE_BASE: u8 = 13;
+
+const DW_LNS_COPY: u8 = 0x01;
+const DW_LNS_ADVANCE_PC: u8 = 0x02;
+const DW_LNS_ADVANCE_LINE: u8 = 0x03;
+const DW_LNS_SET_FILE: u8 = 0x04;
+const DW_LNE_END_SEQUENCE: u8 = 0x01;
+const DW_LNE_SET_ADDRESS: u8 = 0x02;
+
+const DW_LANG_C99: u16 = 0x0C;
+
+impl DebugInfo {
+    /// `functions`: (nombre, fichero fuente, offset de su label);
+    /// `source_lines`: los (offset, línea) que anotó el encoder
+    pub fn build(functions: Vec<(String, String, usize)>, source_lines: &[(usize, u32)], code_size: usize) -> Self {
+        let mut info = DebugInfo {
+            code_size: code_size as u32,
+            ..Default::default()
+        };
+        let mut functions = functions;
+        functions.sort_by_key(|(_, _, offset)| *offset);
+        for (i, (name, file, offset)) in functions.iter().enumerate() {
+            let end = functions.get(i + 1).map(|f| f.2).unwrap_or(code_size);
+            let file = match info.files.iter().position(|f| f == file) {
+                Some(index) => index as u32,
+                None => {
+                    info.files.push(file.clone());
+                    (info.files.len() - 1) as u32
+                }
+            };
+            info.functions.push(FunctionSymbol {
+                name: name.clone(),
+                offset: *offset as u32,
+                size: (end - offset) as u32,
+                file,
+            });
+        }
+
+        for &(offset, line) in source_lines {
+            let offset = offset as u32;
+            let Some(func) = info.function_at(offset) else {
+                continue;
+            };
+            let row = LineRow { offset, file: func.file, line };
+            match info.lines.last_mut() {
+                // Sentencias que no emitieron código: vale la última
+                Some(last) if last.offset == offset => *last = row,
+                Some(last) if last.file == row.file && last.line == row.line => {}
+                _ => info.lines.push(row),
+            }
+        }
+        info
+    }
+
+    pub fn function_at(&self, offset: u32) -> Option<&FunctionSymbol> {
+        let i = self.functions.partition_point(|f| f.offset <= offset);
+        self.functions[..i].last().filter(|f| offset < f.offset + f.size)
+    }
+
+    /// Fichero y línea del código en `offset`
+    pub fn line_at(&self, offset: u32) -> Option<(&str, u32)> {
+        let func = self.function_at(offset)?;
+        let i = self.lines.partition_point(|r| r.offset <= offset);
+        let row = self.lines[..i].last().filter(|r| r.offset >= func.offset)?;
+        Some((self.files[row.file as usize].as_str(), row.line))
+    }
+
+    /// DWARF 4 con direcciones absolutas: `text_va` es la VA de .text
+    pub fn dwarf(&self, text_va: u64) -> DwarfSections {
+        DwarfSections {
+            abbrev: self.debug_abbrev(),
+            info: self.debug_info(text_va),
+            line: self.debug_line(text_va),
+        }
+    }
+
+    fn debug_abbrev(&self) -> Vec<u8> {
+        vec![
+            // 1: DW_TAG_compile_unit, con hijos
+            1, 0x11, 1,
+            0x25, 0x08, // DW_AT_producer, string
+            0x13, 0x05, // DW_AT_language, data2
+            0x03, 0x08, // DW_AT_name, string
+            0x11, 0x01, // DW_AT_low_pc, addr
+            0x12, 0x06, // DW_AT_high_pc, data4 (longitud)
+            0x10, 0x17, // DW_AT_stmt_list, sec_offset
+            0, 0,
+            // 2: DW_TAG_subprogram, sin hijos
+            2, 0x2E, 0,
+            0x03, 0x08, // DW_AT_name
+            0x11, 0x01, // DW_AT_low_pc
+            0x12, 0x06, // DW_AT_high_pc
+            0x3F, 0x19, // DW_AT_external, flag_present
+            0, 0,
+            0,
+        ]
+    }
+
+    fn debug_info(&self, text_va: u64) -> Vec<u8> {
+        let mut b = Vec::new();
+        b.extend_from_slice(&0u32.to_le_bytes()); // unit_length, al final
+        b.extend_from_slice(&4u16.to_le_bytes());
+        b.extend_from_slice(&0u32.to_le_bytes()); // offset en .debug_abbrev
+        b.push(8);
+
+        b.push(1);
+        put_str(&mut b, "ADead-BIB");
+        b.extend_from_slice(&DW_LANG_C99.to_le_bytes());
+        put_str(&mut b, self.files.first().map(String::as_str).unwrap_or(""));
+        b.extend_from_slice(&text_va.to_le_bytes());
+        b.extend_from_slice(&self.code_size.to_le_bytes());
+        b.extend_from_slice(&0u32.to_le_bytes()); // offset en .debug_line
+
+        for func in &self.functions {
+            b.push(2);
+            put_str(&mut b, &func.name);
+            b.extend_from_slice(&(text_va + func.offset as u64).to_le_bytes());
+            b.extend_from_slice(&func.size.to_le_bytes());
+        }
+        b.push(0);
+
+        let len = (b.len() - 4) as u32;
+        b[0..4].copy_from_slice(&len.to_le_bytes());
+        b
+    }
+
+    fn debug_line(&self, text_va: u64) -> Vec<u8> {
+        let mut b = Vec::new();
+        b.extend_from_slice(&0u32.to_le_bytes()); // unit_length
+        b.extend_from_slice(&4u16.to_le_bytes());
+        b.extend_from_slice(&0u32.to_le_bytes()); // header_length
+        let header_start = b.len();
+        b.extend_from_slice(&[1, 1, 1, LINE_BASE as i8 as u8, LINE_RANGE as u8, OPCODE_BASE]);
+        b.extend_from_slice(&[0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1]);
+        b.push(0); // sin include_directories
+        for file in &self.files {
+            put_str(&mut b, file);
+            b.extend_from_slice(&[0, 0, 0]); // dir, mtime, longitud
+        }
+        b.push(0);
+        let header_len = (b.len() - header_start) as u32;
+        b[6..10].copy_from_slice(&header_len.to_le_bytes());
+
+        b.extend_from_slice(&[0, 9, DW_LNE_SET_ADDRESS]);
+        b.extend_from_slice(&text_va.to_le_bytes());
+        let (mut offset, mut file, mut line) = (0u32, 0u32, 1i64);
+        for row in &self.lines {
+            if row.file != file {
+                b.push(DW_LNS_SET_FILE);
+                put_uleb(&mut b, row.file as u64 + 1);
+                file = row.file;
+            }
+            let line_delta = row.line as i64 - line;
+            let addr_delta = (row.offset - offset) as u64;
+            let special = (LINE_BASE..LINE_BASE + LINE_RANGE as i64)
+                .contains(&line_delta)
+                .then(|| (line_delta - LINE_BASE) as u64 + LINE_RANGE * addr_delta + OPCODE_BASE as u64)
+                .filter(|&op| op <= 255);
+            if let Some(op) = special {
+                b.push(op as u8);
+            } else {
+                if addr_delta > 0 {
+                    b.push(DW_LNS_ADVANCE_PC);
+                    put_uleb(&mut b, addr_delta);
+                }
+                if line_delta != 0 {
+                    b.push(DW_LNS_ADVANCE_LINE);
+                    put_sleb(&mut b, line_delta);
+                }
+                b.push(DW_LNS_COPY);
+            }
+            offset = row.offset;
+            line = row.line as i64;
+        }
+        if self.code_size > offset {
+            b.push(DW_LNS_ADVANCE_PC);
+            put_uleb(&mut b, (self.code_size - offset) as u64);
+        }
+        b.extend_from_slice(&[0, 1, DW_LNE_END_SEQUENCE]);
+
+        let len = (b.len() - 4) as u32;
+        b[0..4].copy_from_slice(&len.to_le_bytes());
+        b
+    }
+
+    /// Reconstruye la tabla desde .debug_info/.debug_line de un PE
+    /// escrito por `dwarf`. Devuelve la VA de .text (low_pc de la unidad)
+    pub fn from_dwarf(info: &[u8], line: &[u8]) -> Result<(Self, u64), String> {
+        let malformed = |what: &str| format!("malformed {}", what);
+
+        // .debug_info: cabecera (11) + compile_unit + un subprogram por función
+        let mut at = 11;
+        if info.get(at) != Some(&1) {
+            return Err(malformed(".debug_info"));
+        }
+        at += 1;
+        read_str(info, &mut at).ok_or_else(|| malformed(".debug_info"))?;
+        at += 2;
+        read_str(info, &mut at).ok_or_else(|| malformed(".debug_info"))?;
+        let text_va = read_le(info, &mut at, 8).ok_or_else(|| malformed(".debug_info"))?;
+        let code_size = read_le(info, &mut at, 4).ok_or_else(|| malformed(".debug_info"))? as u32;
+        at += 4;
+        let mut result = DebugInfo { code_size, ..Default::default() };
+        while info.get(at) == Some(&2) {
+            at += 1;
+            let name = read_str(info, &mut at).ok_or_else(|| malformed(".debug_info"))?;
+            let low = read_le(info, &mut at, 8).ok_or_else(|| malformed(".debug_info"))?;
+            let size = read_le(info, &mut at, 4).ok_or_else(|| malformed(".debug_info"))? as u32;
+            result.functions.push(FunctionSymbol {
+                name: name.to_string(),
+                offset: low.wrapping_sub(text_va) as u32,
+                size,
+                file: 0,
+            });
+        }
+        result.functions.sort_by_key(|f| f.offset);
+
+        // .debug_line: ficheros de la cabecera y filas del programa
+        let header_len = line.get(6..10).ok_or_else(|| malformed(".debug_line"))?;
+        let program = 10 + u32::from_le_bytes(header_len.try_into().unwrap()) as usize;
+        let opcode_base = *line.get(15).ok_or_else(|| malformed(".debug_line"))?;
+        let mut at = 15 + opcode_base as usize;
+        while line.get(at).is_some_and(|&b| b != 0) {
+            read_str(line, &mut at).ok_or_else(|| malformed(".debug_line"))?;
+        }
+        at += 1;
+        while line.get(at).is_some_and(|&b| b != 0) {
+            let file = read_str(line, &mut at).ok_or_else(|| malformed(".debug_line"))?;
+            result.files.push(file.to_string());
+            for _ in 0..3 {
+                read_uleb(line, &mut at).ok_or_else(|| malformed(".debug_line"))?;
+            }
+        }
+
+        let mut at = program;
+        let (mut addr, mut file, mut row_line) = (0u64, 1u64, 1i64);
+        while at < line.len() {
+            let op = line[at];
+            at += 1;
+            let emit = match op {
+                0 => {
+                    let len = read_uleb(line, &mut at).ok_or_else(|| malformed(".debug_line"))? as usize;
+                    if line.get(at) == Some(&DW_LNE_SET_ADDRESS) {
+                        let mut value = at + 1;
+                        addr = read_le(line, &mut value, 8).ok_or_else(|| malformed(".debug_line"))?;
+                    }
+                    at += len;
+                    false
+                }
+                DW_LNS_COPY => true,
+                DW_LNS_ADVANCE_PC => {
+                    addr += read_uleb(line, &mut at).ok_or_else(|| malformed(".debug_line"))?;
+                    false
+                }
+                DW_LNS_ADVANCE_LINE => {
+                    row_line += read_sleb(line, &mut at).ok_or_else(|| malformed(".debug_line"))?;
+                    false
+                }
+                DW_LNS_SET_FILE => {
+                    file = read_uleb(line, &mut at).ok_or_else(|| malformed(".debug_line"))?;
+                    false
+                }
+                op if op >= OPCODE_BASE => {
+                    let adjusted = (op - OPCODE_BASE) as u64;
+                    addr += adjusted / LINE_RANGE;
+                    row_line += LINE_BASE + (adjusted % LINE_RANGE) as i64;
+                    true
+                }
+                _ => return Err(format!("unsupported .debug_line opcode {}", op)),
+            };
+            if emit {
+                result.lines.push(LineRow {
+                    offset: addr.wrapping_sub(text_va) as u32,
+                    file: file.saturating_sub(1) as u32,
+                    line: row_line as u32,
+                });
+            }
+        }
+
+        // El fichero de cada función es el de su primera fila
+        for func in &mut result.functions {
+            let i = result.lines.partition_point(|r| r.offset < func.offset);
+            if let Some(row) = result.lines.get(i).filter(|r| r.offset < func.offset + func.size) {
+                func.file = row.file;
+            }
+        }
+        Ok((result, text_va))
+    }
+
+    /// Registros de la tabla de símbolos COFF (18 bytes cada uno), uno
+    /// por función de la sección `section` (1 = primera). Los nombres
+    /// de más de 8 bytes van a `strings`.
+    pub fn coff_symbols(&self, section: u16, strings: &mut CoffStrings) -> Vec<u8> {
+        let mut b = Vec::with_capacity(self.functions.len() * 18);
+        for func in &self.functions {
+            b.extend_from_slice(&strings.name_field(&func.name));
+            b.extend_from_slice(&func.offset.to_le_bytes());
+            b.extend_from_slice(&section.to_le_bytes());
+            b.extend_from_slice(&0x20u16.to_le_bytes()); // función
+            b.push(2); // IMAGE_SYM_CLASS_EXTERNAL
+            b.push(0);
+        }
+        b
+    }
+}
+
+/// String table COFF: va detrás de la tabla de símbolos y empieza
+/// con su propio tamaño (u32), así que el primer offset es 4
+#[derive(Debug, Clone)]
+pub struct CoffStrings {
+    bytes: Vec<u8>,
+}
+
+impl Default for CoffStrings {
+    fn default() -> Self {
+        Self { bytes: vec![0; 4] }
+    }
+}
+
+impl CoffStrings {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn add(&mut self, s: &str) -> u32 {
+        let offset = self.bytes.len() as u32;
+        self.bytes.extend_from_slice(s.as_bytes());
+        self.bytes.push(0);
+        offset
+    }
+
+    /// Campo Name[8] de un símbolo: el nombre si cabe, si no
+    /// cuatro ceros + offset en la string table
+    pub fn name_field(&mut self, name: &str) -> [u8; 8] {
+        let mut field = [0u8; 8];
+        if name.len() <= 8 {
+            field[..name.len()].copy_from_slice(name.as_bytes());
+        } else {
+            field[4..].copy_from_slice(&self.add(name).to_le_bytes());
+        }
+        field
+    }
+
+    /// Nombre de sección: "/N" con N en decimal si no cabe en 8 bytes
+    pub fn section_name(&mut self, name: &str) -> [u8; 8] {
+        let mut field = [0u8; 8];
+        if name.len() <= 8 {
+            field[..name.len()].copy_from_slice(name.as_bytes());
+        } else {
+            let short = format!("/{}", self.add(name));
+            field[..short.len()].copy_from_slice(short.as_bytes());
+        }
+        field
+    }
+
+    pub fn finish(mut self) -> Vec<u8> {
+        let len = self.bytes.len() as u32;
+        self.bytes[0..4].copy_from_slice(&len.to_le_bytes());
+        self.bytes
+    }
+}
+
+fn read_str<'a>(b: &'a [u8], at: &mut usize) -> Option<&'a str> {
+    let len = b.get(*at..)?.iter().position(|&c| c == 0)?;
+    let s = std::str::from_utf8(&b[*at..*at + len]).ok()?;
+    *at += len + 1;
+    Some(s)
+}
+
+fn read_le(b: &[u8], at: &mut usize, n: usize) -> Option<u64> {
+    let bytes = b.get(*at..*at + n)?;
+    *at += n;
+    Some(bytes.iter().rev().fold(0, |v, &byte| v << 8 | byte as u64))
+}
+
+fn read_uleb(b: &[u8], at: &mut usize) -> Option<u64> {
+    let (mut v, mut shift) = (0u64, 0);
+    loop {
+        let byte = *b.get(*at)?;
+        *at += 1;
+        if shift < 64 {
+            v |= ((byte & 0x7F) as u64) << shift;
+        }
+        shift += 7;
+        if byte & 0x80 == 0 {
+            return Some(v);
+        }
+    }
+}
+
+fn read_sleb(b: &[u8], at: &mut usize) -> Option<i64> {
+    let (mut v, mut shift) = (0i64, 0);
+    loop {
+        let byte = *b.get(*at)?;
+        *at += 1;
+        if shift < 64 {
+            v |= ((byte & 0x7F) as i64) << shift;
+        }
+        shift += 7;
+        if byte & 0x80 == 0 {
+            if byte & 0x40 != 0 && shift < 64 {
+                v |= -1 << shift;
+            }
+            return Some(v);
+        }
+    }
+}
+
+fn put_str(b: &mut Vec<u8>, s: &str) {
+    b.extend_from_slice(s.as_bytes());
+    b.push(0);
+}
+
+fn put_uleb(b: &mut Vec<u8>, mut v: u64) {
+    loop {
+        let byte = (v & 0x7F) as u8;
+        v >>= 7;
+        if v == 0 {
+            b.push(byte);
+            return;
+        }
+        b.push(byte | 0x80);
+    }
+}
+
+fn put_sleb(b: &mut Vec<u8>, mut v: i64) {
+    loop {
+        let byte = (v & 0x7F) as u8;
+        v >>= 7;
+        let done = (v == 0 && byte & 0x40 == 0) || (v == -1 && byte & 0x40 != 0);
+        if done {
+            b.push(byte);
+            return;
+        }
+        b.push(byte | 0x80);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn sample() -> DebugInfo {
+        DebugInfo::build(
+            vec![
+                ("main".to_string(), "app.c".to_string(), 0x40),
+                ("accumulate_samples".to_string(), "math.c".to_string(), 0x10),
+            ],
+            &[(0x10, 3), (0x14, 4), (0x14, 5), (0x40, 20), (0x48, 21), (0x300, 90), (0x300, 90), (0x310, 2)],
+            0x400,
+        )
+    }
+
+    /// Ejecuta el programa de .debug_line: (dirección, fichero, línea)
+    fn run_line_program(b: &[u8]) -> Vec<(u64, u64, i64)> {
+        let header_len = u32::from_le_bytes(b[6..10].try_into().unwrap()) as usize;
+        let mut at = 10 + header_len;
+        let (mut addr, mut file, mut line) = (0u64, 1u64, 1i64);
+        let mut rows = Vec::new();
+        while at < b.len() {
+            let op = b[at];
+            at += 1;
+            match op {
+                0 => {
+                    let len = read_uleb(b, &mut at).unwrap() as usize;
+                    match b[at] {
+                        DW_LNE_SET_ADDRESS => addr = u64::from_le_bytes(b[at + 1..at + 9].try_into().unwrap()),
+                        DW_LNE_END_SEQUENCE => rows.push((addr, 0, 0)),
+                        other => panic!("extended opcode {}", other),
+                    }
+                    at += len;
+                }
+                DW_LNS_COPY => rows.push((addr, file, line)),
+                DW_LNS_ADVANCE_PC => addr += read_uleb(b, &mut at).unwrap(),
+                DW_LNS_ADVANCE_LINE => line += read_sleb(b, &mut at).unwrap(),
+                DW_LNS_SET_FILE => file = read_uleb(b, &mut at).unwrap(),
+                op if op >= OPCODE_BASE => {
+                    let adjusted = (op - OPCODE_BASE) as u64;
+                    addr += adjusted / LINE_RANGE;
+                    line += LINE_BASE + (adjusted % LINE_RANGE) as i64;
+                    rows.push((addr, file, line));
+                }
+                other => panic!("opcode {}", other),
+            }
+        }
+        rows
+    }
+
+    #[test]
+    fn test_symbols_and_rows_follow_code_order() {
+        let info = sample();
+        assert_eq!(info.files, vec!["math.c", "app.c"]);
+        assert_eq!(info.functions[0].name, "accumulate_samples");
+        assert_eq!((info.functions[0].offset, info.functions[0].size), (0x10, 0x30));
+        assert_eq!((info.functions[1].offset, info.functions[1].size), (0x40, 0x3C0));
+        assert_eq!(info.lines.len(), 6);
+        assert_eq!(info.line_at(0x15), Some(("math.c", 5)));
+        assert_eq!(info.line_at(0x47), Some(("app.c", 20)));
+        assert_eq!(info.line_at(0x30F), Some(("app.c", 90)));
+        assert_eq!(info.line_at(0x3FF), Some(("app.c", 2)));
+        assert_eq!(info.line_at(0x08), None);
+    }
+
+    #[test]
+    fn test_line_program_decodes_to_rows() {
+        let text_va = 0x1_4000_1000;
+        let line = sample().dwarf(text_va).line;
+        assert_eq!(u32::from_le_bytes(line[0..4].try_into().unwrap()) as usize, line.len() - 4);
+        assert_eq!(
+            run_line_program(&line),
+            vec![
+                (text_va + 0x10, 1, 3),
+                (text_va + 0x14, 1, 5),
+                (text_va + 0x40, 2, 20),
+                (text_va + 0x48, 2, 21),
+                (text_va + 0x300, 2, 90),
+                (text_va + 0x310, 2, 2),
+                (text_va + 0x400, 0, 0),
+            ]
+        );
+    }
+
+    #[test]
+    fn test_from_dwarf_round_trips() {
+        let text_va = 0x1_4000_1000;
+        let info = sample();
+        let dwarf = info.dwarf(text_va);
+        let (read, va) = DebugInfo::from_dwarf(&dwarf.info, &dwarf.line).unwrap();
+        assert_eq!(va, text_va);
+        assert_eq!(read.files, info.files);
+        assert_eq!(read.functions, info.functions);
+        assert_eq!(read.lines, info.lines);
+        assert_eq!(read.code_size, info.code_size);
+        assert_eq!(read.line_at(0x30F), Some(("app.c", 90)));
+        assert!(DebugInfo::from_dwarf(&dwarf.info[..20], &dwarf.line).is_err());
+    }
+
+    #[test]
+    fn test_coff_symbols_use_string_table_for_long_names() {
+        let info = sample();
+        let mut strings = CoffStrings::new();
+        let debug_line = strings.section_name(".debug_line");
+        let symbols = info.coff_symbols(1, &mut strings);
+        let strings = strings.finish();
+        assert_eq!(&debug_line, b"/4\0\0\0\0\0\0");
+        assert_eq!(symbols.len(), 2 * 18);
+        // accumulate_samples: 0 + offset en la string table
+        assert_eq!(&symbols[0..4], &[0, 0, 0, 0]);
+        let name_at = u32::from_le_bytes(symbols[4..8].try_into().unwrap()) as usize;
+        assert!(strings[name_at..].starts_with(b"accumulate_samples\0"));
+        assert_eq!(&symbols[18..26], b"main\0\0\0\0");
+        assert_eq!(u32::from_le_bytes(symbols[26..30].try_into().unwrap()), 0x40);
+        assert_eq!(u32::from_le_bytes(strings[0..4].try_into().unwrap()) as usize, strings.len());
+    }
+}
@@ -0,0 +1,614 @@
+// ============================================================
+// ADead-BIB Decode Tables — longitud y prefijos x86-64 por tabla
+// ============================================================
+// Mapas de opcodes (legacy, 0F, 0F38, 0F3A; VEX/EVEX reusan los
+// tres últimos) generados en tiempo de compilación: cada entrada
+// dice si hay ModRM y qué inmediato sigue. Con eso una sola pasada
+// resuelve prefijos, REX/VEX, ModRM/SIB, desplazamiento e
+// inmediato de cualquier instrucción de 64 bits, la entienda o no
+// el Decoder semántico.
+//
+//   length(code, off)  → solo la longitud (barridos lineales)
+//   decode(code, off)  → Insn con todos los campos
+//   sweep(code)        → iterador (offset, len) sobre un buffer
+//
+// Decoder::decode_next cae aquí cuando no reconoce una instrucción,
+// así BinaryRebuilder y BG no se desincronizan byte a byte.
+// ============================================================
+
+// ── Atributos por opcode ──
+const MODRM: u16 = 1 << 0;
+const IMM8: u16 = 1 << 1;
+/// Iw: siempre 16 bits (ret imm16, enter)
+const IMM16: u16 = 1 << 2;
+/// Iz: 16 con 66, si no 32
+const IMMZ: u16 = 1 << 3;
+/// Iv: 64 con REX.W (mov r64, imm64), 16 con 66, si no 32
+const IMMV: u16 = 1 << 4;
+const REL8: u16 = 1 << 5;
+/// rel32 (Jz en 64 bits: el 66 no lo acorta en Intel)
+const REL32: u16 = 1 << 6;
+/// moffs de A0-A3: 8 bytes, 4 con 67
+const MOFFS: u16 = 1 << 7;
+/// Grupo 3 (F6/F7): el inmediato solo existe con /0 y /1 (test)
+const GRP3: u16 = 1 << 8;
+const PREFIX: u16 = 1 << 9;
+const REX: u16 = 1 << 10;
+/// 0F en el mapa legacy; 38/3A en el mapa 0F
+const ESCAPE: u16 = 1 << 11;
+const VEX2: u16 = 1 << 12;
+const VEX3: u16 = 1 << 13;
+const EVEX: u16 = 1 << 14;
+const INVALID: u16 = 1 << 15;
+
+/// Longitud máxima de una instrucción x86
+pub const MAX_INSN_LEN: usize = 15;
+
+// ── Prefijos legacy (Insn::prefixes) ──
+pub const PREFIX_LOCK: u8 = 1 << 0;
+pub const PREFIX_REP: u8 = 1 << 1;
+pub const PREFIX_REPNE: u8 = 1 << 2;
+pub const PREFIX_OPSIZE: u8 = 1 << 3;
+pub const PREFIX_ADDRSIZE: u8 = 1 << 4;
+pub const PREFIX_SEGMENT: u8 = 1 << 5;
+
+const fn fill(mut t: [u16; 256], lo: usize, hi: usize, attrs: u16) -> [u16; 256] {
+    let mut i = lo;
+    while i <= hi {
+        t[i] = attrs;
+        i += 1;
+    }
+    t
+}
+
+const fn set(mut t: [u16; 256], op: usize, attrs: u16) -> [u16; 256] {
+    t[op] = attrs;
+    t
+}
+
+const fn legacy_map() -> [u16; 256] {
+    let mut t = [0u16; 256];
+    // 00-3F: ocho filas ALU (add/or/adc/sbb/and/sub/xor/cmp), r/m + AL/eAX imm
+    let mut row = 0;
+    while row < 8 {
+        let b = row * 8;
+        t = fill(t, b, b + 3, MODRM);
+        t = set(t, b + 4, IMM8);
+        t = set(t, b + 5, IMMZ);
+        t = fill(t, b + 6, b + 7, INVALID);
+        row += 1;
+    }
+    t = set(t, 0x0F, ESCAPE);
+    t = set(t, 0x26, PREFIX);
+    t = set(t, 0x2E, PREFIX);
+    t = set(t, 0x36, PREFIX);
+    t = set(t, 0x3E, PREFIX);
+    t = fill(t, 0x40, 0x4F, REX);
+    // 50-5F push/pop: sin operandos extra
+    t = fill(t, 0x60, 0x61, INVALID);
+    t = set(t, 0x62, EVEX);
+    t = set(t, 0x63, MODRM);
+    t = fill(t, 0x64, 0x67, PREFIX);
+    t = set(t, 0x68, IMMZ);
+    t = set(t, 0x69, MODRM | IMMZ);
+    t = set(t, 0x6A, IMM8);
+    t = set(t, 0x6B, MODRM | IMM8);
+    t = fill(t, 0x70, 0x7F, REL8);
+    t = set(t, 0x80, MODRM | IMM8);
+    t = set(t, 0x81, MODRM | IMMZ);
+    t = set(t, 0x82, INVALID);
+    t = set(t, 0x83, MODRM | IMM8);
+    t = fill(t, 0x84, 0x8F, MODRM);
+    t = set(t, 0x9A, INVALID);
+    t = fill(t, 0xA0, 0xA3, MOFFS);
+    t = set(t, 0xA8, IMM8);
+    t = set(t, 0xA9, IMMZ);
+    t = fill(t, 0xB0, 0xB7, IMM8);
+    t = fill(t, 0xB8, 0xBF, IMMV);
+    t = fill(t, 0xC0, 0xC1, MODRM | IMM8);
+    t = set(t, 0xC2, IMM16);
+    t = set(t, 0xC4, VEX3);
+    t = set(t, 0xC5, VEX2);
+    t = set(t, 0xC6, MODRM | IMM8);
+    t = set(t, 0xC7, MODRM | IMMZ);
+    t = set(t, 0xC8, IMM16 | IMM8);
+    t = set(t, 0xCA, IMM16);
+    t = set(t, 0xCD, IMM8);
+    t = set(t, 0xCE, INVALID);
+    t = fill(t, 0xD0, 0xD3, MODRM);
+    t = fill(t, 0xD4, 0xD6, INVALID);
+    t = fill(t, 0xD8, 0xDF, MODRM);
+    t = fill(t, 0xE0, 0xE3, REL8);
+    t = fill(t, 0xE4, 0xE7, IMM8);
+    t = fill(t, 0xE8, 0xE9, REL32);
+    t = set(t, 0xEA, INVALID);
+    t = set(t, 0xEB, REL8);
+    t = set(t, 0xF0, PREFIX);
+    t = fill(t, 0xF2, 0xF3, PREFIX);
+    t = set(t, 0xF6, MODRM | GRP3 | IMM8);
+    t = set(t, 0xF7, MODRM | GRP3 | IMMZ);
+    t = fill(t, 0xFE, 0xFF, MODRM);
+    t
+}
+
+const fn map_0f() -> [u16; 256] {
+    let mut t = fill([0u16; 256], 0x00, 0xFF, MODRM);
+    t = set(t, 0x04, INVALID);
+    // syscall, clts, sysret, invd, wbinvd
+    t = fill(t, 0x05, 0x09, 0);
+    t = set(t, 0x0A, INVALID);
+    t = set(t, 0x0B, 0);
+    t = set(t, 0x0C, INVALID);
+    t = set(t, 0x0E, 0);
+    // 3DNow!: el sufijo de opcode va como imm8
+    t = set(t, 0x0F, MODRM | IMM8);
+    t = fill(t, 0x24, 0x27, INVALID);
+    // wrmsr, rdtsc, rdmsr, rdpmc, sysenter, sysexit, -, getsec
+    t = fill(t, 0x30, 0x37, 0);
+    t = set(t, 0x36, INVALID);
+    t = set(t, 0x38, ESCAPE);
+    t = set(t, 0x39, INVALID);
+    t = set(t, 0x3A, ESCAPE);
+    t = fill(t, 0x3B, 0x3F, INVALID);
+    t = fill(t, 0x70, 0x73, MODRM | IMM8);
+    // emms / vzeroupper
+    t = set(t, 0x77, 0);
+    t = fill(t, 0x80, 0x8F, REL32);
+    // push/pop fs, cpuid
+    t = fill(t, 0xA0, 0xA2, 0);
+    t = set(t, 0xA4, MODRM | IMM8);
+    t = fill(t, 0xA6, 0xA7, INVALID);
+    // push/pop gs, rsm
+    t = fill(t, 0xA8, 0xAA, 0);
+    t = set(t, 0xAC, MODRM | IMM8);
+    t = set(t, 0xBA, MODRM | IMM8);
+    t = set(t, 0xC2, MODRM | IMM8);
+    t = fill(t, 0xC4, 0xC6, MODRM | IMM8);
+    // bswap r32/r64
+    t = fill(t, 0xC8, 0xCF, 0);
+    t
+}
+
+static LEGACY: [u16; 256] = legacy_map();
+static MAP_0F: [u16; 256] = map_0f();
+static MAP_0F38: [u16; 256] = fill([0u16; 256], 0x00, 0xFF, MODRM);
+static MAP_0F3A: [u16; 256] = fill([0u16; 256], 0x00, 0xFF, MODRM | IMM8);
+
+/// Mapa de opcodes de la instrucción
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum OpcodeMap {
+    #[default]
+    Legacy,
+    Map0F,
+    Map0F38,
+    Map0F3A,
+}
+
+impl OpcodeMap {
+    fn table(self) -> &'static [u16; 256] {
+        match self {
+            OpcodeMap::Legacy => &LEGACY,
+            OpcodeMap::Map0F => &MAP_0F,
+            OpcodeMap::Map0F38 => &MAP_0F38,
+            OpcodeMap::Map0F3A => &MAP_0F3A,
+        }
+    }
+
+    /// `mmmmm` de VEX/EVEX. Los mapas 5 y 6 de EVEX (FP16) tienen la
+    /// misma forma que 0F38 (ModRM sin inmediato).
+    fn from_vex(mmmmm: u8, evex: bool) -> Option<(Self, &'static [u16; 256])> {
+        match mmmmm {
+            1 => Some((OpcodeMap::Map0F, &MAP_0F)),
+            2 => Some((OpcodeMap::Map0F38, &MAP_0F38)),
+            3 => Some((OpcodeMap::Map0F3A, &MAP_0F3A)),
+            5 | 6 if evex => Some((OpcodeMap::Map0F38, &MAP_0F38)),
+            _ => None,
+        }
+    }
+}
+
+/// Codificación de la instrucción
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum Encoding {
+    #[default]
+    Legacy,
+    Vex,
+    Evex,
+}
+
+/// Instrucción decodificada a nivel de formato (sin semántica)
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub struct Insn {
+    pub len: u8,
+    /// Bits PREFIX_* de los prefijos legacy presentes
+    pub prefixes: u8,
+    /// Byte REX (0 si no hay)
+    pub rex: u8,
+    pub encoding: Encoding,
+    pub map: OpcodeMap,
+    pub opcode: u8,
+    /// VEX/EVEX: W, L (0=128, 1=256, 2=512) y vvvv ya invertido
+    pub vex_w: bool,
+    pub vex_l: u8,
+    pub vex_vvvv: u8,
+    pub modrm: Option<u8>,
+    pub sib: Option<u8>,
+    pub disp: i32,
+    pub disp_len: u8,
+    /// Inmediato (o rel8/rel32 si `relative`), little-endian sin signo
+    pub imm: u64,
+    pub imm_len: u8,
+    /// El inmediato es un desplazamiento relativo al final de la instrucción
+    pub relative: bool,
+}
+
+impl Insn {
+    pub fn rex_w(&self) -> bool {
+        self.rex & 0x08 != 0 || (self.encoding != Encoding::Legacy && self.vex_w)
+    }
+
+    /// Campo reg del ModRM (/digit en los grupos)
+    pub fn reg_field(&self) -> Option<u8> {
+        self.modrm.map(|m| (m >> 3) & 7)
+    }
+
+    /// Destino de un salto/llamada relativa que empieza en `offset`
+    pub fn branch_target(&self, offset: usize) -> Option<usize> {
+        if !self.relative {
+            return None;
+        }
+        let rel = match self.imm_len {
+            1 => self.imm as u8 as i8 as i64,
+            _ => self.imm as u32 as i32 as i64,
+        };
+        let end = (offset + self.len as usize) as i64;
+        usize::try_from(end + rel).ok()
+    }
+}
+
+/// Lee `n` bytes little-endian desde `p`
+#[inline(always)]
+fn read_le(code: &[u8], p: usize, n: usize) -> Option<u64> {
+    let bytes = code.get(p..p + n)?;
+    let mut v = 0u64;
+    for (i, b) in bytes.iter().enumerate() {
+        v |= (*b as u64) << (8 * i);
+    }
+    Some(v)
+}
+
+/// Una pasada: prefijos → opcode (o VEX/EVEX) → ModRM/SIB/disp → imm.
+/// Con `FIELDS = false` solo cuenta bytes y no rellena `out`.
+#[inline(always)]
+fn scan<const FIELDS: bool>(code: &[u8], offset: usize, out: &mut Insn) -> Option<usize> {
+    let mut p = offset;
+    let mut prefixes = 0u8;
+    let mut rex = 0u8;
+    let mut b;
+    let mut attrs;
+    loop {
+        b = *code.get(p)?;
+        attrs = LEGACY[b as usize];
+        if attrs & PREFIX != 0 {
+            prefixes |= match b {
+                0xF0 => PREFIX_LOCK,
+                0xF3 => PREFIX_REP,
+                0xF2 => PREFIX_REPNE,
+                0x66 => PREFIX_OPSIZE,
+                0x67 => PREFIX_ADDRSIZE,
+                _ => PREFIX_SEGMENT,
+            };
+            // Un REX seguido de otro prefijo se ignora
+            rex = 0;
+        } else if attrs & REX != 0 {
+            rex = b;
+        } else {
+            break;
+        }
+        p += 1;
+        if p - offset >= MAX_INSN_LEN {
+            return None;
+        }
+    }
+    if attrs & INVALID != 0 {
+        return None;
+    }
+
+    let mut encoding = Encoding::Legacy;
+    let mut map = OpcodeMap::Legacy;
+    let (mut vex_w, mut vex_l, mut vex_vvvv) = (false, 0u8, 0u8);
+    if attrs & (VEX2 | VEX3 | EVEX) != 0 {
+        // VEX/EVEX no admiten REX ni 66/F2/F3/F0 delante
+        if rex != 0 || prefixes & (PREFIX_LOCK | PREFIX_REP | PREFIX_REPNE | PREFIX_OPSIZE) != 0 {
+            return None;
+        }
+        let table;
+        if attrs & VEX2 != 0 {
+            let p1 = *code.get(p + 1)?;
+            encoding = Encoding::Vex;
+            (map, table) = (OpcodeMap::Map0F, &MAP_0F);
+            vex_l = (p1 >> 2) & 1;
+            vex_vvvv = (!p1 >> 3) & 0xF;
+            p += 2;
+        } else if attrs & VEX3 != 0 {
+            let p1 = *code.get(p + 1)?;
+            let p2 = *code.get(p + 2)?;
+            encoding = Encoding::Vex;
+            (map, table) = OpcodeMap::from_vex(p1 & 0x1F, false)?;
+            vex_w = p2 & 0x80 != 0;
+            vex_l = (p2 >> 2) & 1;
+            vex_vvvv = (!p2 >> 3) & 0xF;
+            p += 3;
+        } else {
+            let p0 = *code.get(p + 1)?;
+            let p1 = *code.get(p + 2)?;
+            let p2 = *code.get(p + 3)?;
+            encoding = Encoding::Evex;
+            (map, table) = OpcodeMap::from_vex(p0 & 0x07, true)?;
+            vex_w = p1 & 0x80 != 0;
+            vex_l = (p2 >> 5) & 3;
+            vex_vvvv = (!p1 >> 3) & 0xF;
+            p += 4;
+        }
+        b = *code.get(p)?;
+        attrs = table[b as usize];
+        // Los saltos rel32 del mapa 0F no existen en VEX
+        if attrs & (INVALID | ESCAPE | REL32) != 0 {
+            return None;
+        }
+    } else if attrs & ESCAPE != 0 {
+        p += 1;
+        b = *code.get(p)?;
+        map = OpcodeMap::Map0F;
+        attrs = MAP_0F[b as usize];
+        if attrs & ESCAPE != 0 {
+            p += 1;
+            map = if b == 0x38 { OpcodeMap::Map0F38 } else { OpcodeMap::Map0F3A };
+            b = *code.get(p)?;
+            attrs = map.table()[b as usize];
+        }
+        if attrs & INVALID != 0 {
+            return None;
+        }
+    }
+    let opcode = b;
+    p += 1;
+
+    let mut modrm = None;
+    let mut sib = None;
+    let mut disp_len = 0usize;
+    if attrs & MODRM != 0 {
+        let m = *code.get(p)?;
+        p += 1;
+        let md = m >> 6;
+        let rm = m & 7;
+        if md != 3 {
+            if rm == 4 {
+                let s = *code.get(p)?;
+                p += 1;
+                if md == 0 && s & 7 == 5 {
+                    disp_len = 4;
+                }
+                if FIELDS {
+                    sib = Some(s);
+                }
+            } else if md == 0 && rm == 5 {
+                // [rip + disp32]
+                disp_len = 4;
+            }
+            match md {
+                1 => disp_len = 1,
+                2 => disp_len = 4,
+                _ => {}
+            }
+        }
+        modrm = Some(m);
+    }
+    let disp_at = p;
+    p += disp_len;
+
+    let opsize16 = prefixes & PREFIX_OPSIZE != 0 && rex & 0x08 == 0;
+    let mut imm_len = 0usize;
+    if attrs & (IMM8 | REL8) != 0 {
+        imm_len += 1;
+    }
+    if attrs & IMM16 != 0 {
+        imm_len += 2;
+    }
+    if attrs & IMMZ != 0 {
+        imm_len += if opsize16 { 2 } else { 4 };
+    }
+    if attrs & IMMV != 0 {
+        imm_len += if rex & 0x08 != 0 {
+            8
+        } else if opsize16 {
+            2
+        } else {
+            4
+        };
+    }
+    if attrs & REL32 != 0 {
+        imm_len += 4;
+    }
+    if attrs & MOFFS != 0 {
+        imm_len += if prefixes & PREFIX_ADDRSIZE != 0 { 4 } else { 8 };
+    }
+    if attrs & GRP3 != 0 && modrm.map_or(0, |m| (m >> 3) & 7) > 1 {
+        imm_len = 0;
+    }
+    let imm_at = p;
+    p += imm_len;
+
+    let len = p - offset;
+    if len > MAX_INSN_LEN || p > code.len() {
+        return None;
+    }
+    if FIELDS {
+        *out = Insn {
+            len: len as u8,
+            prefixes,
+            rex,
+            encoding,
+            map,
+            opcode,
+            vex_w,
+            vex_l,
+            vex_vvvv,
+            modrm,
+            sib,
+            disp: match disp_len {
+                1 => code[disp_at] as i8 as i32,
+                4 => read_le(code, disp_at, 4)? as u32 as i32,
+                _ => 0,
+            },
+            disp_len: disp_len as u8,
+            imm: if imm_len > 0 { read_le(code, imm_at, imm_len.min(8))? } else { 0 },
+            imm_len: imm_len as u8,
+            relative: attrs & (REL8 | REL32) != 0,
+        };
+    }
+    Some(len)
+}
+
+/// Longitud de la instrucción en `offset`, o None si es inválida o está
+/// truncada. No rellena campos: es el modo de los barridos lineales.
+#[inline]
+pub fn length(code: &[u8], offset: usize) -> Option<usize> {
+    let mut unused = Insn::default();
+    scan::<false>(code, offset, &mut unused)
+}
+
+/// Decodifica formato completo (prefijos, ModRM, disp, imm) en una pasada
+#[inline]
+pub fn decode(code: &[u8], offset: usize) -> Option<Insn> {
+    let mut insn = Insn::default();
+    scan::<true>(code, offset, &mut insn)?;
+    Some(insn)
+}
+
+/// Barrido lineal: (offset, len) de cada instrucción. Un byte inválido
+/// avanza 1, igual que el RawBytes de `Decoder::decode_all`.
+pub fn sweep(code: &[u8]) -> Sweep<'_> {
+    Sweep { code, offset: 0 }
+}
+
+pub struct Sweep<'a> {
+    code: &'a [u8],
+    offset: usize,
+}
+
+impl Iterator for Sweep<'_> {
+    type Item = (usize, usize);
+
+    #[inline]
+    fn next(&mut self) -> Option<(usize, usize)> {
+        if self.offset >= self.code.len() {
+            return None;
+        }
+        let at = self.offset;
+        let len = length(self.code, at).unwrap_or(1);
+        self.offset += len;
+        Some((at, len))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn len(bytes: &[u8]) -> Option<usize> {
+        length(bytes, 0)
+    }
+
+    #[test]
+    fn test_lengths_legacy() {
+        assert_eq!(len(&[0x55]), Some(1)); // push rbp
+        assert_eq!(len(&[0x48, 0x89, 0xE5]), Some(3)); // mov rbp, rsp
+        assert_eq!(len(&[0x48, 0x83, 0xEC, 0x20]), Some(4)); // sub rsp, 0x20
+        assert_eq!(len(&[0x48, 0x81, 0xEC, 0, 1, 0, 0]), Some(7)); // sub rsp, 0x100
+        assert_eq!(len(&[0x48, 0xB8, 1, 2, 3, 4, 5, 6, 7, 8]), Some(10)); // movabs
+        assert_eq!(len(&[0x66, 0xB8, 1, 2]), Some(4)); // mov ax, imm16
+        assert_eq!(len(&[0x48, 0x8B, 0x44, 0x24, 0x08]), Some(5)); // mov rax, [rsp+8]
+        assert_eq!(len(&[0x8B, 0x05, 0, 0, 0, 0]), Some(6)); // mov eax, [rip+d32]
+        assert_eq!(len(&[0x8B, 0x04, 0x25, 0, 0, 0, 0]), Some(7)); // mov eax, [d32]
+        assert_eq!(len(&[0xFF, 0x15, 0, 0, 0, 0]), Some(6)); // call [rip+d32]
+        assert_eq!(len(&[0xF6, 0xC0, 0x01]), Some(3)); // test al, 1
+        assert_eq!(len(&[0xF7, 0xD8]), Some(2)); // neg eax: sin imm
+        assert_eq!(len(&[0xC8, 0x10, 0x00, 0x00]), Some(4)); // enter 16, 0
+        assert_eq!(len(&[0xA1, 0, 0, 0, 0, 0, 0, 0, 0]), Some(9)); // mov eax, moffs64
+        assert_eq!(len(&[0xF3, 0x48, 0xAB]), Some(3)); // rep stosq
+    }
+
+    #[test]
+    fn test_lengths_escape_maps() {
+        assert_eq!(len(&[0x0F, 0x05]), Some(2)); // syscall
+        assert_eq!(len(&[0x0F, 0x84, 0, 0, 0, 0]), Some(6)); // je rel32
+        assert_eq!(len(&[0x0F, 0xAF, 0xC1]), Some(3)); // imul eax, ecx
+        assert_eq!(len(&[0xF2, 0x0F, 0x10, 0x45, 0xF8]), Some(5)); // movsd xmm0, [rbp-8]
+        assert_eq!(len(&[0x66, 0x0F, 0x38, 0x00, 0xC1]), Some(5)); // pshufb
+        assert_eq!(len(&[0x66, 0x0F, 0x3A, 0x0E, 0xC1, 0x0F]), Some(6)); // pblendw
+        assert_eq!(len(&[0x0F, 0xBA, 0xE0, 0x03]), Some(4)); // bt eax, 3
+    }
+
+    #[test]
+    fn test_lengths_vex_evex() {
+        assert_eq!(len(&[0xC5, 0xFC, 0x58, 0xC1]), Some(4)); // vaddps ymm0, ymm0, ymm1
+        assert_eq!(len(&[0xC5, 0xF8, 0x77]), Some(3)); // vzeroupper
+        assert_eq!(len(&[0xC4, 0xE2, 0x7D, 0x18, 0x00]), Some(5)); // vbroadcastss ymm0, [rax]
+        assert_eq!(len(&[0xC4, 0xE3, 0x7D, 0x18, 0xC1, 0x01]), Some(6)); // vinsertf128
+        assert_eq!(len(&[0x62, 0xF1, 0x7C, 0x48, 0x58, 0xC1]), Some(6)); // vaddps zmm0, zmm0, zmm1
+        // VEX con REX delante no existe
+        assert_eq!(len(&[0x48, 0xC5, 0xFC, 0x58, 0xC1]), None);
+    }
+
+    #[test]
+    fn test_invalid_and_truncated() {
+        assert_eq!(len(&[0x06]), None); // push es: inválido en 64 bits
+        assert_eq!(len(&[0x48, 0x8B]), None); // falta el ModRM
+        assert_eq!(len(&[0xE8, 0, 0]), None); // call rel32 truncado
+        assert_eq!(len(&[0x66; 16]), None); // más de 15 bytes
+    }
+
+    #[test]
+    fn test_decode_fields() {
+        // lock add qword [rax+rcx*8+0x10], 5
+        let insn = decode(&[0xF0, 0x48, 0x83, 0x44, 0xC8, 0x10, 0x05], 0).unwrap();
+        assert_eq!(insn.len, 7);
+        assert_eq!(insn.prefixes, PREFIX_LOCK);
+        assert!(insn.rex_w());
+        assert_eq!(insn.opcode, 0x83);
+        assert_eq!(insn.reg_field(), Some(0));
+        assert_eq!(insn.sib, Some(0xC8));
+        assert_eq!((insn.disp, insn.disp_len), (0x10, 1));
+        assert_eq!((insn.imm, insn.imm_len), (5, 1));
+
+        // jmp -2 (a sí mismo) en el offset 0x10
+        let mut code = vec![0x90; 0x10];
+        code.extend_from_slice(&[0xEB, 0xFE]);
+        let jmp = decode(&code, 0x10).unwrap();
+        assert_eq!(jmp.branch_target(0x10), Some(0x10));
+
+        let vex = decode(&[0xC4, 0xE2, 0x7D, 0x18, 0x00], 0).unwrap();
+        assert_eq!((vex.encoding, vex.map, vex.vex_l), (Encoding::Vex, OpcodeMap::Map0F38, 1));
+    }
+
+    #[test]
+    fn test_sweep_matches_encoder_output() {
+        use super::super::encoder::Encoder;
+        use super::super::{ADeadOp, Operand, Reg};
+        let ops = vec![
+            ADeadOp::Push { src: Operand::Reg(Reg::RBP) },
+            ADeadOp::Mov { dst: Operand::Reg(Reg::RBP), src: Operand::Reg(Reg::RSP) },
+            ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm32(0x40) },
+            ADeadOp::Mov { dst: Operand::Reg(Reg::RAX), src: Operand::Imm64(0x1122334455667788) },
+            ADeadOp::Xor { dst: Reg::EAX, src: Reg::EAX },
+            ADeadOp::Mov { dst: Operand::Reg(Reg::RSP), src: Operand::Reg(Reg::RBP) },
+            ADeadOp::Pop { dst: Reg::RBP },
+            ADeadOp::Ret,
+        ];
+        let code = Encoder::new().encode_all(&ops).code;
+        let lengths: Vec<usize> = sweep(&code).map(|(_, n)| n).collect();
+        assert_eq!(lengths.len(), ops.len());
+        assert_eq!(lengths.iter().sum::<usize>(), code.len());
+    }
+}
@@ -9,6 +9,7 @@
 // Email: eddi.salazar.dev@gmail.com
 // ============================================================
 
+use super::decode_table::{self, Encoding, Insn, OpcodeMap};
 use super::*;
 use std::collections::HashMap;
 
@@ -33,13 +34,9 @@ impl Decoder {
         let mut offset = 0;
 
         while offset < code.len() {
-            if let Some((op, consumed)) = self.decode_one(code, offset) {
-                ops.push((offset, op));
-                offset += consumed;
-            } else {
-                ops.push((offset, ADeadOp::RawBytes(vec![code[offset]])));
-                offset += 1;
-            }
+            let (op, consumed) = self.decode_next(code, offset);
+            ops.push((offset, op));
+            offset += consumed;
         }
 
         // Insertar Label pseudo-ops en las posiciones referenciadas por saltos
@@ -68,6 +65,75 @@ impl Decoder {
         result
     }
 
+    /// Como `decode_one`, pero nunca falla: lo que los patrones no cubren
+    /// pasa por `decode_table`. Saltos relativos e instrucciones de sistema
+    /// se levantan a su ADeadOp; el resto queda como RawBytes de la
+    /// instrucción completa, así el barrido no se desincroniza.
+    pub fn decode_next(&mut self, code: &[u8], offset: usize) -> (ADeadOp, usize) {
+        if let Some(hit) = self.decode_one(code, offset) {
+            return hit;
+        }
+        let Some(insn) = decode_table::decode(code, offset) else {
+            return (ADeadOp::RawBytes(vec![code[offset]]), 1);
+        };
+        let len = insn.len as usize;
+        let op = self
+            .lift(&insn, offset)
+            .unwrap_or_else(|| ADeadOp::RawBytes(code[offset..offset + len].to_vec()));
+        (op, len)
+    }
+
+    /// ADeadOp de una instrucción ya medida por las tablas, si tiene forma
+    /// propia en la IR (sin prefijos que cambien el tamaño de operando)
+    fn lift(&mut self, insn: &Insn, offset: usize) -> Option<ADeadOp> {
+        if insn.encoding != Encoding::Legacy || insn.prefixes != 0 {
+            return None;
+        }
+        let imm8 = || Operand::Imm8(insn.imm as u8 as i8);
+        let op = match (insn.map, insn.opcode) {
+            (OpcodeMap::Legacy, 0x70..=0x7F) | (OpcodeMap::Map0F, 0x80..=0x8F) => ADeadOp::Jcc {
+                cond: condition_code(insn.opcode & 0x0F)?,
+                target: self.get_or_create_label(insn.branch_target(offset)?),
+            },
+            (OpcodeMap::Legacy, 0xEB | 0xE9) => ADeadOp::Jmp {
+                target: self.get_or_create_label(insn.branch_target(offset)?),
+            },
+            (OpcodeMap::Legacy, 0xE8) => ADeadOp::Call {
+                target: CallTarget::Name(format!("func_{:04X}", insn.branch_target(offset)?)),
+            },
+            (OpcodeMap::Legacy, 0xF4) => ADeadOp::Hlt,
+            (OpcodeMap::Legacy, 0xFA) => ADeadOp::Cli,
+            (OpcodeMap::Legacy, 0xFB) => ADeadOp::Sti,
+            (OpcodeMap::Legacy, 0xCF) if insn.rex_w() => ADeadOp::Iret,
+            (OpcodeMap::Legacy, 0xCD) => ADeadOp::Int { vector: insn.imm as u8 },
+            (OpcodeMap::Legacy, 0xE4) => ADeadOp::InByte { port: imm8() },
+            (OpcodeMap::Legacy, 0xEC) => ADeadOp::InByte { port: Operand::Reg(Reg::DX) },
+            (OpcodeMap::Legacy, 0xE5) => ADeadOp::InDword { port: imm8() },
+            (OpcodeMap::Legacy, 0xED) => ADeadOp::InDword { port: Operand::Reg(Reg::DX) },
+            (OpcodeMap::Legacy, 0xE6) => ADeadOp::OutByte {
+                port: imm8(),
+                src: Operand::Reg(Reg::AL),
+            },
+            (OpcodeMap::Legacy, 0xEE) => ADeadOp::OutByte {
+                port: Operand::Reg(Reg::DX),
+                src: Operand::Reg(Reg::AL),
+            },
+            (OpcodeMap::Legacy, 0xE7) => ADeadOp::OutDword {
+                port: imm8(),
+                src: Operand::Reg(Reg::EAX),
+            },
+            (OpcodeMap::Legacy, 0xEF) => ADeadOp::OutDword {
+                port: Operand::Reg(Reg::DX),
+                src: Operand::Reg(Reg::EAX),
+            },
+            (OpcodeMap::Map0F, 0x30) => ADeadOp::Wrmsr,
+            (OpcodeMap::Map0F, 0x32) => ADeadOp::Rdmsr,
+            (OpcodeMap::Map0F, 0xA2) => ADeadOp::Cpuid,
+            _ => return None,
+        };
+        Some(op)
+    }
+
     /// Decodifica una instrucción en el offset dado.
     /// Retorna (instrucción, bytes_consumidos) o None si no se reconoce.
     pub fn decode_one(&mut self, code: &[u8], offset: usize) -> Option<(ADeadOp, usize)> {
@@ -1153,6 +1219,23 @@ impl Default for Decoder {
 }
 
 #[inline]
+/// Condición del nibble bajo de Jcc/SETcc (sin o/no/s/ns/p/np en la IR)
+fn condition_code(cc: u8) -> Option<Condition> {
+    Some(match cc {
+        0x2 => Condition::Below,
+        0x3 => Condition::AboveEq,
+        0x4 => Condition::Equal,
+        0x5 => Condition::NotEqual,
+        0x6 => Condition::BelowEq,
+        0x7 => Condition::Above,
+        0xC => Condition::Less,
+        0xD => Condition::GreaterEq,
+        0xE => Condition::LessEq,
+        0xF => Condition::Greater,
+        _ => return None,
+    })
+}
+
 fn read_i32(code: &[u8], offset: usize) -> i32 {
     i32::from_le_bytes([
         code[offset],
@@ -1232,6 +1315,36 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_unknown_instructions_stay_in_sync() {
+        // movsd xmm0, [rbp-8] (sin patrón) seguido de jne y hlt
+        let code = vec![0xF2, 0x0F, 0x10, 0x45, 0xF8, 0x75, 0xF9, 0xF4];
+        let ops = Decoder::new().decode_all(&code);
+        assert!(matches!(ops[0], ADeadOp::Label(_)));
+        assert_eq!(ops[1], ADeadOp::RawBytes(vec![0xF2, 0x0F, 0x10, 0x45, 0xF8]));
+        assert!(matches!(ops[2], ADeadOp::Jcc { cond: Condition::NotEqual, .. }));
+        assert_eq!(ops[3], ADeadOp::Hlt);
+    }
+
+    #[test]
+    fn test_decode_system_instructions() {
+        let code = vec![0xFA, 0xE4, 0x60, 0xEE, 0x0F, 0x30, 0xCD, 0x80];
+        let ops = Decoder::new().decode_all(&code);
+        assert_eq!(
+            ops,
+            vec![
+                ADeadOp::Cli,
+                ADeadOp::InByte { port: Operand::Imm8(0x60) },
+                ADeadOp::OutByte {
+                    port: Operand::Reg(Reg::DX),
+                    src: Operand::Reg(Reg::AL),
+                },
+                ADeadOp::Wrmsr,
+                ADeadOp::Int { vector: 0x80 },
+            ]
+        );
+    }
+
     #[test]
     fn test_roundtrip_prologue() {
         // Encode → bytes → Decode → verify same ops
@@ -26,6 +26,10 @@ pub struct EncodeResult {
     /// FASM-inspired: exact offsets of 64-bit string address immediates (48 B8+ [imm64])
     /// Each entry is the code offset of the 8-byte imm64 field
     pub string_imm64_offsets: Vec<usize>,
+    /// Posición final de cada label (id → offset en `code`)
+    pub label_offsets: HashMap<u32, usize>,
+    /// (offset en `code`, línea) de cada `ADeadOp::SourceLine`, en orden
+    pub source_lines: Vec<(usize, u32)>,
 }
 
 /// Tipo de patch pendiente para resolución de saltos.
@@ -46,6 +50,8 @@ struct PendingPatch {
 enum PatchKind {
     Rel32,
     Rel8,
+    /// dword `target - base` (entradas de ADeadOp::JumpTable)
+    TableRel32 { base: Label },
 }
 
 /// Encoder de instrucciones ISA a bytes x86-64.
@@ -56,6 +62,7 @@ pub struct Encoder {
     unresolved_calls: Vec<(usize, String)>,
     iat_call_offsets: Vec<usize>,
     string_imm64_offsets: Vec<usize>,
+    source_lines: Vec<(usize, u32)>,
     current_op_idx: usize,
 }
 
@@ -68,155 +75,133 @@ impl Encoder {
             unresolved_calls: Vec::new(),
             iat_call_offsets: Vec::new(),
             string_imm64_offsets: Vec::new(),
+            source_lines: Vec::new(),
             current_op_idx: 0,
         }
     }
 
-    /// FASM-inspired multi-pass encoder (from assembler_loop in ASSEMBLE.INC).
+    /// FASM-inspired encoder con relajación de saltos sobre una tabla de tamaños.
     ///
-    /// Pass 1: Encode all ops with rel32 jumps, record label positions.
-    /// Pass 2: Patch all jump displacement fields.
-    /// Pass 3: Verify short-jump candidates — only backward jumps whose
-    ///         target label was already seen (no forward-reference risk).
-    ///         Re-encode if any can be shortened; repeat until stable.
+    /// Pass 1: Encode all ops with rel32 jumps and record each op's size.
+    /// Pass 2: Relax Jmp/Jcc (forward and backward) to rel8 on the size
+    ///         table: a worklist checks every jump once, and afterwards only
+    ///         re-checks jumps whose span contains a jump that just shrank.
+    /// Pass 3: Encode once more with the chosen forms and patch.
     ///
-    /// Conservative approach: only shorten backward jumps where the label
-    /// position is definitively known before the jump instruction.
+    /// Everything starts near and only shrinks. Shrinking an op can only
+    /// bring a jump's endpoints closer together, so a jump that fits in
+    /// rel8 keeps fitting and the worklist always terminates.
     pub fn encode_all(&mut self, ops: &[ADeadOp]) -> EncodeResult {
-        // Track which (jump_index, target_label) can use short encoding.
-        // Key = index into ops[] of the Jmp/Jcc, value = true if short-safe.
-        let mut short_jump_indices: std::collections::HashSet<usize> =
-            std::collections::HashSet::new();
-        let max_passes = 3;
-
-        for _pass in 0..max_passes {
-            self.code.clear();
-            self.label_positions.clear();
-            self.pending_patches.clear();
-            self.unresolved_calls.clear();
-            self.iat_call_offsets.clear();
-            self.string_imm64_offsets.clear();
-
-            for (op_idx, op) in ops.iter().enumerate() {
-                if short_jump_indices.contains(&op_idx) {
-                    // Emit short form for this jump
-                    match op {
-                        ADeadOp::Jmp { target } => {
-                            self.emit(&[0xEB]);
-                            let patch_offset = self.code.len();
-                            self.emit(&[0x00]);
-                            self.pending_patches.push(PendingPatch {
-                                code_offset: patch_offset,
-                                target: *target,
-                                kind: PatchKind::Rel8,
-                                op_idx,
-                            });
-                            continue;
-                        }
-                        ADeadOp::Jcc { cond, target } => {
-                            let cc = match cond {
-                                Condition::Equal => 0x04u8,
-                                Condition::NotEqual => 0x05,
-                                Condition::Less => 0x0C,
-                                Condition::LessEq => 0x0E,
-                                Condition::Greater => 0x0F,
-                                Condition::GreaterEq => 0x0D,
-                                Condition::Below => 0x02,
-                                Condition::BelowEq => 0x06,
-                                Condition::Above => 0x07,
-                                Condition::AboveEq => 0x03,
-                                Condition::Always => {
-                                    self.emit(&[0xEB]);
-                                    let patch_offset = self.code.len();
-                                    self.emit(&[0x00]);
-                                    self.pending_patches.push(PendingPatch {
-                                        code_offset: patch_offset,
-                                        target: *target,
-                                        kind: PatchKind::Rel8,
-                                        op_idx,
-                                    });
-                                    continue;
-                                }
-                            };
-                            self.emit(&[0x70 | cc]);
-                            let patch_offset = self.code.len();
-                            self.emit(&[0x00]);
-                            self.pending_patches.push(PendingPatch {
-                                code_offset: patch_offset,
-                                target: *target,
-                                kind: PatchKind::Rel8,
-                                op_idx,
-                            });
-                            continue;
-                        }
-                        _ => {}
-                    }
-                }
-                self.current_op_idx = op_idx;
-                self.encode_op(op);
-            }
+        let chunk = self.encode_chunk(ops);
+        link_chunks(vec![chunk])
+    }
 
-            // Resolve all patches
-            let mut unresolved_patch_count = 0usize;
-            for patch in &self.pending_patches {
-                if let Some(&target_pos) = self.label_positions.get(&patch.target.0) {
-                    match patch.kind {
-                        PatchKind::Rel32 => {
-                            let rel = (target_pos as i64 - (patch.code_offset as i64 + 4)) as i32;
-                            self.code[patch.code_offset..patch.code_offset + 4]
-                                .copy_from_slice(&rel.to_le_bytes());
-                        }
-                        PatchKind::Rel8 => {
-                            let rel = target_pos as i64 - (patch.code_offset as i64 + 1);
-                            // Safety: verify it still fits; if not, we have a bug
-                            self.code[patch.code_offset] = (rel as i8) as u8;
-                        }
-                    }
-                } else {
-                    unresolved_patch_count += 1;
-                }
+    /// Encoding por funciones en paralelo. `starts` = índice del primer
+    /// op de cada función; se agrupan en tramos de al menos
+    /// `PARALLEL_CHUNK_OPS` ops que se codifican (y relajan) cada uno en
+    /// su propio buffer. Los saltos, calls y LEAs entre tramos quedan
+    /// rel32 y se parchean al concatenar, igual que los disp32 de la IAT.
+    ///
+    /// Los tramos solo dependen de `ops` y `starts`, no de `jobs`: el
+    /// binario es el mismo con cualquier número de hilos.
+    pub fn encode_functions(ops: &[ADeadOp], starts: &[usize], jobs: usize) -> EncodeResult {
+        let chunks = function_chunks(ops.len(), starts);
+        // LabelAddrRef escribe direcciones absolutas sin patch pendiente
+        if chunks.len() <= 1 || ops.iter().any(|op| matches!(op, ADeadOp::LabelAddrRef { .. })) {
+            return Encoder::new().encode_all(ops);
+        }
+        let parts = adeb_core::parallel::par_map(&chunks, jobs, |range| {
+            let mut chunk = Encoder::new().encode_chunk(&ops[range.clone()]);
+            for patch in &mut chunk.deferred {
+                patch.op_idx += range.start;
             }
-            if unresolved_patch_count > 0 {
-                eprintln!(
-                    "   ⚠️  Encoder: {} unresolved label patches ({} labels known, {} patches total)",
-                    unresolved_patch_count,
-                    self.label_positions.len(),
-                    self.pending_patches.len()
-                );
-            }
-
-            // Convergence: find backward rel32 jumps that fit in rel8
-            let mut changed = false;
-            for patch in self.pending_patches.iter() {
-                if let PatchKind::Rel32 = patch.kind {
-                    if let Some(&target_pos) = self.label_positions.get(&patch.target.0) {
-                        // Only shorten BACKWARD jumps (target before jump)
-                        if target_pos < patch.code_offset {
-                            let rel = target_pos as i64 - (patch.code_offset as i64 + 4);
-                            // Conservative: only if well within range after shrink
-                            if rel >= -120 && rel <= 120 {
-                                if short_jump_indices.insert(patch.op_idx) {
-                                    changed = true;
-                                }
-                            }
-                        }
-                    }
-                }
+            chunk
+        });
+        link_chunks(parts)
+    }
+
+    /// Codifica un tramo con offsets relativos a su inicio. Lo que apunta
+    /// a labels de fuera del tramo queda en `deferred`.
+    fn encode_chunk(&mut self, ops: &[ADeadOp]) -> ChunkCode {
+        self.reset();
+        let mut sizes = Vec::with_capacity(ops.len());
+        for (op_idx, op) in ops.iter().enumerate() {
+            let start = self.code.len();
+            self.current_op_idx = op_idx;
+            self.encode_op(op);
+            sizes.push(self.code.len() - start);
+        }
+        let (short, positions) = relax_branches(ops, &mut sizes);
+
+        self.reset();
+        // Con las posiciones finales conocidas, LabelAddrRef también
+        // resuelve labels que vienen después
+        for (op_idx, op) in ops.iter().enumerate() {
+            if let ADeadOp::Label(label) = op {
+                self.label_positions.insert(label.0, positions[op_idx]);
             }
-
-            if !changed {
-                break;
+        }
+        for (op_idx, op) in ops.iter().enumerate() {
+            self.current_op_idx = op_idx;
+            if short[op_idx] {
+                self.encode_short_jump(op);
+            } else {
+                self.encode_op(op);
             }
         }
-
-        EncodeResult {
-            code: self.code.clone(),
-            unresolved_calls: self.unresolved_calls.clone(),
-            iat_call_offsets: self.iat_call_offsets.clone(),
-            string_imm64_offsets: self.string_imm64_offsets.clone(),
+        debug_assert_eq!(self.code.len(), positions.last().copied().unwrap_or(0) + sizes.last().copied().unwrap_or(0));
+
+        let patches = std::mem::take(&mut self.pending_patches);
+        let patch_count = patches.len();
+        let deferred = apply_patches(&mut self.code, patches, &self.label_positions);
+        ChunkCode {
+            code: std::mem::take(&mut self.code),
+            labels: std::mem::take(&mut self.label_positions),
+            deferred,
+            patch_count,
+            unresolved_calls: std::mem::take(&mut self.unresolved_calls),
+            iat_call_offsets: std::mem::take(&mut self.iat_call_offsets),
+            string_imm64_offsets: std::mem::take(&mut self.string_imm64_offsets),
+            source_lines: std::mem::take(&mut self.source_lines),
         }
     }
 
+    fn reset(&mut self) {
+        self.code.clear();
+        self.label_positions.clear();
+        self.pending_patches.clear();
+        self.unresolved_calls.clear();
+        self.iat_call_offsets.clear();
+        self.string_imm64_offsets.clear();
+        self.source_lines.clear();
+    }
+
+    /// EB rel8 / 7x rel8 para un Jmp/Jcc que `relax_branches` marcó corto
+    fn encode_short_jump(&mut self, op: &ADeadOp) {
+        let target = match op {
+            ADeadOp::Jmp { target } => {
+                self.emit(&[0xEB]);
+                target
+            }
+            ADeadOp::Jcc { cond, target } => {
+                match condition_code(cond) {
+                    Some(cc) => self.emit(&[0x70 | cc]),
+                    None => self.emit(&[0xEB]),
+                }
+                target
+            }
+            _ => unreachable!("only Jmp/Jcc are relaxed"),
+        };
+        let patch_offset = self.code.len();
+        self.emit(&[0x00]);
+        self.pending_patches.push(PendingPatch {
+            code_offset: patch_offset,
+            target: *target,
+            kind: PatchKind::Rel8,
+            op_idx: self.current_op_idx,
+        });
+    }
+
     /// Codifica una instrucción individual.
     pub fn encode_op(&mut self, op: &ADeadOp) {
         match op {
@@ -233,6 +218,7 @@ impl Encoder {
             ADeadOp::Sub { dst, src } => self.encode_sub(dst, src),
             ADeadOp::Mul { dst, src } => self.encode_mul(dst, src),
             ADeadOp::Div { src } => self.encode_div(src),
+            ADeadOp::MulHigh { src } => self.encode_mul_high(src),
             ADeadOp::And { dst, src } => self.encode_and(dst, src),
             ADeadOp::Or { dst, src } => self.encode_or(dst, src),
             ADeadOp::Xor { dst, src } => self.encode_xor(dst, src),
@@ -241,6 +227,7 @@ impl Encoder {
             ADeadOp::Neg { dst } => self.encode_neg(dst),
             ADeadOp::Not { dst } => self.encode_not(dst),
             ADeadOp::Shl { dst, amount } => self.encode_shl(dst, *amount),
+            ADeadOp::Sar { dst, amount } => self.encode_sar(dst, *amount),
             ADeadOp::Cmp { left, right } => self.encode_cmp(left, right),
             ADeadOp::Test { left, right } => self.encode_test(left, right),
             ADeadOp::SetCC { cond, dst: _ } => self.encode_setcc(cond),
@@ -276,6 +263,9 @@ impl Encoder {
             ADeadOp::Label(label) => {
                 self.label_positions.insert(label.0, self.code.len());
             }
+            ADeadOp::SourceLine(line) => {
+                self.source_lines.push((self.code.len(), *line));
+            }
             ADeadOp::Nop => self.emit(&[0x90]),
             ADeadOp::RawBytes(bytes) => self.emit(bytes),
             ADeadOp::CallIAT { iat_rva } => self.encode_call_iat(*iat_rva),
@@ -323,6 +313,18 @@ impl Encoder {
                 });
             }
             ADeadOp::FarJmp { selector, offset } => self.encode_far_jmp(*selector, *offset),
+            ADeadOp::JumpTable { table, targets } => {
+                for target in targets {
+                    let patch_offset = self.code.len();
+                    self.emit_i32(0);
+                    self.pending_patches.push(PendingPatch {
+                        code_offset: patch_offset,
+                        target: *target,
+                        kind: PatchKind::TableRel32 { base: *table },
+                        op_idx: self.current_op_idx,
+                    });
+                }
+            }
             ADeadOp::LabelAddrRef {
                 label,
                 size,
@@ -354,6 +356,13 @@ impl Encoder {
             ADeadOp::Cdq => self.emit(&[0x48, 0x99]),   // CQO (REX.W + 99)
             ADeadOp::Movsb => self.emit(&[0xA4]),
             ADeadOp::Stosb => self.emit(&[0xAA]),
+            ADeadOp::Cmpsb => self.emit(&[0xA6]),
+            ADeadOp::Bswap { dst } => {
+                // REX.W 0F C8+r
+                let (idx, ext) = reg_index(dst);
+                let rex = self.rex_wrxb(true, false, ext);
+                self.emit(&[rex, 0x0F, 0xC8 + idx]);
+            }
             ADeadOp::Rep { op } => {
                 self.emit(&[0xF3]);
                 self.encode_op(op);
@@ -423,8 +432,38 @@ impl Encoder {
 
     /// FASM-inspired: generic LEA r64, [base+disp] — supports ALL registers
     fn encode_lea(&mut self, dst: &Reg, src: &Operand) {
-        if let Operand::Mem { base, disp } = src {
-            self.encode_rm_disp(0x8D, dst, base, *disp);
+        match src {
+            Operand::Mem { base, disp } => self.encode_rm_disp(0x8D, dst, base, *disp),
+            // lea r64, [base + index*scale + disp] — ModR/M rm=100 + SIB
+            Operand::MemSIB { base, index, scale, disp } => {
+                let (reg_idx, reg_ext) = reg_index(dst);
+                let (base_idx, base_ext) = reg_index(base);
+                let (index_idx, index_ext) = reg_index(index);
+                let scale_bits = match scale {
+                    1 => 0,
+                    2 => 1,
+                    4 => 2,
+                    _ => 3,
+                };
+                let mut rex = self.rex_wrxb(true, reg_ext, base_ext);
+                if index_ext {
+                    rex |= 0x02; // REX.X
+                }
+                let sib = (scale_bits << 6) | ((index_idx & 7) << 3) | (base_idx & 7);
+                // RBP/R13 como base no tienen forma sin desplazamiento
+                if *disp == 0 && base_idx != 5 {
+                    let modrm = self.modrm(0, reg_idx, 4);
+                    self.emit(&[rex, 0x8D, modrm, sib]);
+                } else if *disp >= -128 && *disp <= 127 {
+                    let modrm = self.modrm(1, reg_idx, 4);
+                    self.emit(&[rex, 0x8D, modrm, sib, *disp as u8]);
+                } else {
+                    let modrm = self.modrm(2, reg_idx, 4);
+                    self.emit(&[rex, 0x8D, modrm, sib]);
+                    self.emit_i32(*disp);
+                }
+            }
+            _ => {}
         }
     }
 
@@ -440,6 +479,8 @@ impl Encoder {
             // add r64, imm — FASM: basic_reg_imm with auto imm8/imm32 (/0)
             (Operand::Reg(r), Operand::Imm8(v)) => self.encode_alu_ri(0, r, *v as i32),
             (Operand::Reg(r), Operand::Imm32(v)) => self.encode_alu_ri(0, r, *v),
+            // add r64, [base+disp] — (03 /r)
+            (Operand::Reg(r), Operand::Mem { base, disp }) => self.encode_rm_disp(0x03, r, base, *disp),
             _ => {}
         }
     }
@@ -452,6 +493,8 @@ impl Encoder {
             // sub r64, imm — FASM: basic_reg_imm with auto imm8/imm32 (/5)
             (Operand::Reg(r), Operand::Imm8(v)) => self.encode_alu_ri(5, r, *v as i32),
             (Operand::Reg(r), Operand::Imm32(v)) => self.encode_alu_ri(5, r, *v),
+            // sub r64, [base+disp] — (2B /r)
+            (Operand::Reg(r), Operand::Mem { base, disp }) => self.encode_rm_disp(0x2B, r, base, *disp),
             _ => {}
         }
     }
@@ -475,6 +518,14 @@ impl Encoder {
         self.emit(&[rex, 0xF7, modrm]);
     }
 
+    /// IMUL r64 (un operando): RDX:RAX = RAX * src — F7 /5
+    fn encode_mul_high(&mut self, src: &Reg) {
+        let (idx, ext) = reg_index(src);
+        let rex = self.rex_wrxb(true, false, ext);
+        let modrm = self.modrm(3, 5, idx);
+        self.emit(&[rex, 0xF7, modrm]);
+    }
+
     // ========================================
     // Bitwise: AND, OR, XOR
     // ========================================
@@ -573,6 +624,13 @@ impl Encoder {
         self.emit(&[rex, 0xC1, modrm, amount]);
     }
 
+    fn encode_sar(&mut self, dst: &Reg, amount: u8) {
+        let (idx, ext) = reg_index(dst);
+        let rex = self.rex_wrxb(true, false, ext);
+        let modrm = self.modrm(3, 7, idx); // SAR = /7
+        self.emit(&[rex, 0xC1, modrm, amount]);
+    }
+
     // ========================================
     // CMP, TEST, SETCC
     // ========================================
@@ -592,6 +650,11 @@ impl Encoder {
             }
             // cmp r64, imm32 — (81 /7 or 83 /7)
             (Operand::Reg(r), Operand::Imm32(v)) => self.encode_alu_ri(7, r, *v),
+            // cmp qword [base+disp], imm32 — (81 /7)
+            (Operand::Mem { base, disp }, Operand::Imm32(v)) => {
+                self.encode_ext_rm_disp(0x81, 7, base, *disp);
+                self.emit_i32(*v);
+            }
             _ => self.encode_rr(0x39, &Reg::RBX, &Reg::RAX),
         }
     }
@@ -668,6 +731,24 @@ impl Encoder {
                 }
                 self.emit(&[0xFF, 0xD0 | idx]);
             }
+            CallTarget::Mem { base, disp } => {
+                // call [base+disp] — FF /2; sin REX.W (el operando ya es de 64 bits)
+                let (idx, ext) = reg_index(base);
+                if ext {
+                    self.emit(&[0x41]); // REX.B
+                }
+                let mode = if *disp == 0 && idx != 5 { 0 } else if *disp >= -128 && *disp <= 127 { 1 } else { 2 };
+                let modrm = self.modrm(mode, 2, idx);
+                self.emit(&[0xFF, modrm]);
+                if idx == 4 {
+                    self.emit(&[0x24]); // SIB para RSP o R12
+                }
+                match mode {
+                    1 => self.emit(&[*disp as u8]),
+                    2 => self.emit_i32(*disp),
+                    _ => {}
+                }
+            }
         }
     }
 
@@ -687,22 +768,9 @@ impl Encoder {
 
     /// FASM-inspired: Jcc with condition code table
     fn encode_jcc(&mut self, cond: &Condition, target: &Label) {
-        // FASM pattern: condition code table instead of per-condition match
-        let cc = match cond {
-            Condition::Equal => 0x04u8,   // JE/JZ
-            Condition::NotEqual => 0x05,  // JNE/JNZ
-            Condition::Less => 0x0C,      // JL
-            Condition::LessEq => 0x0E,    // JLE
-            Condition::Greater => 0x0F,   // JG
-            Condition::GreaterEq => 0x0D, // JGE
-            Condition::Below => 0x02,     // JB (CF=1)
-            Condition::BelowEq => 0x06,   // JBE (CF=1 OR ZF=1)
-            Condition::Above => 0x07,     // JA (CF=0 AND ZF=0)
-            Condition::AboveEq => 0x03,   // JAE (CF=0)
-            Condition::Always => {
-                self.encode_jmp(target);
-                return;
-            }
+        let Some(cc) = condition_code(cond) else {
+            self.encode_jmp(target);
+            return;
         };
         // Near Jcc: 0F 8x rel32
         self.emit(&[0x0F, 0x80 | cc]);
@@ -1486,6 +1554,248 @@ fn reg_index(reg: &Reg) -> (u8, bool) {
     }
 }
 
+/// FASM pattern: condition code table instead of per-condition match.
+/// None = Always (se codifica como jmp)
+fn condition_code(cond: &Condition) -> Option<u8> {
+    Some(match cond {
+        Condition::Equal => 0x04,     // JE/JZ
+        Condition::NotEqual => 0x05,  // JNE/JNZ
+        Condition::Less => 0x0C,      // JL
+        Condition::LessEq => 0x0E,    // JLE
+        Condition::Greater => 0x0F,   // JG
+        Condition::GreaterEq => 0x0D, // JGE
+        Condition::Below => 0x02,     // JB (CF=1)
+        Condition::BelowEq => 0x06,   // JBE (CF=1 OR ZF=1)
+        Condition::Above => 0x07,     // JA (CF=0 AND ZF=0)
+        Condition::AboveEq => 0x03,   // JAE (CF=0)
+        Condition::Always => return None,
+    })
+}
+
+// ========================================
+// Branch relaxation
+// ========================================
+
+/// Los saltos cortos (EB/7x rel8) ocupan 2 bytes
+const SHORT_JUMP_SIZE: usize = 2;
+
+/// Suma de prefijos de los tamaños de op (Fenwick): posición de un op
+/// en O(log n) mientras los saltos se van encogiendo
+struct SizeTable {
+    tree: Vec<i64>,
+}
+
+impl SizeTable {
+    fn new(sizes: &[usize]) -> Self {
+        let mut tree = vec![0i64; sizes.len() + 1];
+        // Construcción O(n): cada nodo ya tiene sus hijos cuando se suma al padre
+        for (i, &size) in sizes.iter().enumerate() {
+            let k = i + 1;
+            tree[k] += size as i64;
+            let parent = k + (k & k.wrapping_neg());
+            if parent < tree.len() {
+                tree[parent] += tree[k];
+            }
+        }
+        Self { tree }
+    }
+
+    /// Offset del op `i` (suma de los tamaños de 0..i)
+    fn position(&self, i: usize) -> i64 {
+        let (mut k, mut sum) = (i, 0);
+        while k > 0 {
+            sum += self.tree[k];
+            k &= k - 1;
+        }
+        sum
+    }
+
+    fn add(&mut self, i: usize, delta: i64) {
+        let mut k = i + 1;
+        while k < self.tree.len() {
+            self.tree[k] += delta;
+            k += k & k.wrapping_neg();
+        }
+    }
+}
+
+/// Elige qué Jmp/Jcc van en rel8. Devuelve la marca por op y el offset
+/// final de cada op; `sizes` queda con los tamaños finales.
+fn relax_branches(ops: &[ADeadOp], sizes: &mut [usize]) -> (Vec<bool>, Vec<usize>) {
+    let mut labels: HashMap<u32, usize> = HashMap::new();
+    for (i, op) in ops.iter().enumerate() {
+        if let ADeadOp::Label(label) = op {
+            labels.insert(label.0, i);
+        }
+    }
+    // (op del salto, op del label destino)
+    let mut worklist: Vec<(usize, usize)> = ops
+        .iter()
+        .enumerate()
+        .filter_map(|(i, op)| match op {
+            ADeadOp::Jmp { target } | ADeadOp::Jcc { target, .. } => labels.get(&target.0).map(|&t| (i, t)),
+            _ => None,
+        })
+        .collect();
+
+    let mut table = SizeTable::new(sizes);
+    let mut short = vec![false; ops.len()];
+    let mut waiting: Vec<(usize, usize)> = Vec::new();
+    while !worklist.is_empty() {
+        let mut shrunk: Vec<usize> = Vec::new();
+        for (i, t) in worklist.drain(..) {
+            let saved = (sizes[i] - SHORT_JUMP_SIZE) as i64;
+            let end = table.position(i) + SHORT_JUMP_SIZE as i64;
+            let target = table.position(t) - if t > i { saved } else { 0 };
+            if (-128..=127).contains(&(target - end)) {
+                short[i] = true;
+                sizes[i] = SHORT_JUMP_SIZE;
+                table.add(i, -saved);
+                shrunk.push(i);
+            } else {
+                waiting.push((i, t));
+            }
+        }
+        // Solo vuelven los saltos que cruzan un op que cambió de tamaño
+        shrunk.sort_unstable();
+        let spans_change = |&(i, t): &(usize, usize)| {
+            let (lo, hi) = if t > i { (i + 1, t) } else { (t, i) };
+            let k = shrunk.partition_point(|&s| s < lo);
+            k < shrunk.len() && shrunk[k] < hi
+        };
+        let (again, rest): (Vec<_>, Vec<_>) = waiting.drain(..).partition(spans_change);
+        worklist = again;
+        waiting = rest;
+    }
+
+    let positions = (0..ops.len()).map(|i| table.position(i) as usize).collect();
+    (short, positions)
+}
+
+// ========================================
+// Encoding por tramos
+// ========================================
+
+/// Ops mínimos por tramo de encoding paralelo: por debajo el hilo no compensa
+pub const PARALLEL_CHUNK_OPS: usize = 4096;
+
+/// Un tramo de ops ya codificado, con todo relativo a su inicio
+struct ChunkCode {
+    code: Vec<u8>,
+    labels: HashMap<u32, usize>,
+    /// Patches a labels de otros tramos
+    deferred: Vec<PendingPatch>,
+    patch_count: usize,
+    unresolved_calls: Vec<(usize, String)>,
+    iat_call_offsets: Vec<usize>,
+    string_imm64_offsets: Vec<usize>,
+    source_lines: Vec<(usize, u32)>,
+}
+
+/// Agrupa funciones consecutivas en tramos de al menos `PARALLEL_CHUNK_OPS`
+fn function_chunks(len: usize, starts: &[usize]) -> Vec<std::ops::Range<usize>> {
+    let mut starts: Vec<usize> = starts.iter().copied().filter(|&s| s > 0 && s < len).collect();
+    starts.sort_unstable();
+    starts.dedup();
+    let mut chunks = Vec::new();
+    let mut begin = 0;
+    for s in starts {
+        if s - begin >= PARALLEL_CHUNK_OPS {
+            chunks.push(begin..s);
+            begin = s;
+        }
+    }
+    chunks.push(begin..len);
+    chunks
+}
+
+/// Escribe los desplazamientos que `labels` resuelve; devuelve el resto
+fn apply_patches(code: &mut [u8], patches: Vec<PendingPatch>, labels: &HashMap<u32, usize>) -> Vec<PendingPatch> {
+    let mut unresolved = Vec::new();
+    for patch in patches {
+        let Some(&target_pos) = labels.get(&patch.target.0) else {
+            unresolved.push(patch);
+            continue;
+        };
+        match patch.kind {
+            PatchKind::Rel32 => {
+                let rel = (target_pos as i64 - (patch.code_offset as i64 + 4)) as i32;
+                code[patch.code_offset..patch.code_offset + 4].copy_from_slice(&rel.to_le_bytes());
+            }
+            PatchKind::Rel8 => {
+                let rel = target_pos as i64 - (patch.code_offset as i64 + 1);
+                debug_assert!((-128..=127).contains(&rel), "rel8 out of range in op {}", patch.op_idx);
+                code[patch.code_offset] = (rel as i8) as u8;
+            }
+            PatchKind::TableRel32 { base } => match labels.get(&base.0) {
+                Some(&base_pos) => {
+                    let rel = (target_pos as i64 - base_pos as i64) as i32;
+                    code[patch.code_offset..patch.code_offset + 4].copy_from_slice(&rel.to_le_bytes());
+                }
+                None => unresolved.push(patch),
+            },
+        }
+    }
+    unresolved
+}
+
+/// Concatena los tramos en orden: rebasa labels y offsets, corrige los
+/// disp32 de la IAT (se calcularon con la posición local) y aplica los
+/// patches entre tramos
+fn link_chunks(chunks: Vec<ChunkCode>) -> EncodeResult {
+    let mut labels: HashMap<u32, usize> = HashMap::new();
+    let mut base = 0;
+    for chunk in &chunks {
+        labels.extend(chunk.labels.iter().map(|(&l, &pos)| (l, pos + base)));
+        base += chunk.code.len();
+    }
+
+    let mut code = Vec::with_capacity(base);
+    let mut deferred = Vec::new();
+    let mut patch_count = 0;
+    let mut unresolved_calls = Vec::new();
+    let mut iat_call_offsets = Vec::new();
+    let mut string_imm64_offsets = Vec::new();
+    let mut source_lines = Vec::new();
+    for chunk in chunks {
+        let base = code.len();
+        code.extend_from_slice(&chunk.code);
+        for offset in chunk.iat_call_offsets {
+            let at = base + offset;
+            let disp = i32::from_le_bytes(code[at..at + 4].try_into().unwrap()) - base as i32;
+            code[at..at + 4].copy_from_slice(&disp.to_le_bytes());
+            iat_call_offsets.push(at);
+        }
+        unresolved_calls.extend(chunk.unresolved_calls.into_iter().map(|(offset, name)| (offset + base, name)));
+        string_imm64_offsets.extend(chunk.string_imm64_offsets.into_iter().map(|offset| offset + base));
+        source_lines.extend(chunk.source_lines.into_iter().map(|(offset, line)| (offset + base, line)));
+        deferred.extend(chunk.deferred.into_iter().map(|mut patch| {
+            patch.code_offset += base;
+            patch
+        }));
+        patch_count += chunk.patch_count;
+    }
+
+    let unresolved = apply_patches(&mut code, deferred, &labels);
+    if !unresolved.is_empty() {
+        eprintln!(
+            "   ⚠️  Encoder: {} unresolved label patches ({} labels known, {} patches total)",
+            unresolved.len(),
+            labels.len(),
+            patch_count
+        );
+    }
+
+    EncodeResult {
+        code,
+        unresolved_calls,
+        iat_call_offsets,
+        string_imm64_offsets,
+        label_offsets: labels,
+        source_lines,
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -1521,6 +1831,45 @@ mod tests {
         assert_eq!(result.code, expected);
     }
 
+    #[test]
+    fn test_alu_memory_operands() {
+        let mut enc = Encoder::new();
+        let ops = vec![
+            ADeadOp::Add {
+                dst: Operand::Reg(Reg::R9),
+                src: Operand::Mem { base: Reg::RBX, disp: 72 },
+            },
+            ADeadOp::Sub {
+                dst: Operand::Reg(Reg::RAX),
+                src: Operand::Mem { base: Reg::R11, disp: 24 },
+            },
+            ADeadOp::Cmp {
+                left: Operand::Mem { base: Reg::R11, disp: 32 },
+                right: Operand::Imm32(0),
+            },
+        ];
+        let result = enc.encode_all(&ops);
+        assert_eq!(
+            result.code,
+            vec![0x4C, 0x03, 0x4B, 0x48, 0x49, 0x2B, 0x43, 0x18, 0x49, 0x81, 0x7B, 0x20, 0, 0, 0, 0]
+        );
+    }
+
+    #[test]
+    fn test_call_mem() {
+        let mut enc = Encoder::new();
+        let ops = vec![
+            ADeadOp::Call { target: CallTarget::Mem { base: Reg::RAX, disp: 0 } },
+            ADeadOp::Call { target: CallTarget::Mem { base: Reg::RAX, disp: 16 } },
+            ADeadOp::Call { target: CallTarget::Mem { base: Reg::R11, disp: 1024 } },
+        ];
+        let result = enc.encode_all(&ops);
+        assert_eq!(
+            result.code,
+            vec![0xFF, 0x10, 0xFF, 0x50, 0x10, 0x41, 0xFF, 0x93, 0x00, 0x04, 0x00, 0x00]
+        );
+    }
+
     #[test]
     fn test_xor_eax() {
         let mut enc = Encoder::new();
@@ -1577,6 +1926,81 @@ mod tests {
         assert_eq!(result.code.len(), 3); // nop(1) + jmp_short(2)
     }
 
+    #[test]
+    fn test_forward_jumps_are_relaxed() {
+        let mut ir = ADeadIR::new();
+        let (l1, l2, far) = (ir.new_label(), ir.new_label(), ir.new_label());
+        let ops = vec![
+            // j1 solo cabe en rel8 cuando j2, que cruza, ya es corto
+            ADeadOp::Jcc { cond: Condition::Equal, target: l1 },
+            ADeadOp::Jmp { target: l2 },
+            ADeadOp::Label(l2),
+            ADeadOp::RawBytes(vec![0x90; 124]),
+            ADeadOp::Label(l1),
+            ADeadOp::Jmp { target: far },
+            ADeadOp::RawBytes(vec![0x90; 200]),
+            ADeadOp::Label(far),
+        ];
+        let result = Encoder::new().encode_all(&ops);
+        assert_eq!(&result.code[..4], &[0x74, 126, 0xEB, 0x00]);
+        assert_eq!(&result.code[128..133], &[0xE9, 200, 0, 0, 0]);
+        assert_eq!(result.code.len(), 128 + 5 + 200);
+    }
+
+    #[test]
+    fn test_offsets_follow_relaxed_jumps() {
+        let mut ir = ADeadIR::new();
+        let lbl = ir.new_label();
+        let ops = vec![
+            ADeadOp::Jmp { target: lbl },
+            ADeadOp::Nop,
+            ADeadOp::Label(lbl),
+            ADeadOp::CallIAT { iat_rva: 0x3000 },
+        ];
+        let result = Encoder::new().encode_all(&ops);
+        assert_eq!(&result.code[..3], &[0xEB, 0x01, 0x90]);
+        assert_eq!(result.iat_call_offsets, vec![5]);
+        let disp = 0x3000 - (0x1000 + 3 + 6);
+        assert_eq!(&result.code[5..9], &(disp as i32).to_le_bytes());
+    }
+
+    #[test]
+    fn test_parallel_encoding_matches_serial() {
+        let mut ir = ADeadIR::new();
+        let funcs: Vec<Label> = (0..3).map(|_| ir.new_label()).collect();
+        let (top, table) = (ir.new_label(), ir.new_label());
+        let mut ops = vec![ADeadOp::Jmp { target: funcs[2] }];
+        let mut starts = Vec::new();
+        for (f, &label) in funcs.iter().enumerate() {
+            starts.push(ops.len());
+            ops.push(ADeadOp::Label(label));
+            match f {
+                0 => {
+                    ops.push(ADeadOp::Label(top));
+                    ops.push(ADeadOp::Nop);
+                    ops.push(ADeadOp::Jcc { cond: Condition::NotEqual, target: top });
+                }
+                1 => ops.push(ADeadOp::CallIAT { iat_rva: 0x3000 }),
+                _ => {
+                    ops.push(ADeadOp::Call { target: CallTarget::Relative(funcs[0]) });
+                    ops.push(ADeadOp::LeaLabel { dst: Reg::RAX, label: funcs[1] });
+                    ops.push(ADeadOp::Label(table));
+                    ops.push(ADeadOp::JumpTable { table, targets: vec![funcs[0], funcs[2]] });
+                }
+            }
+            ops.extend((0..PARALLEL_CHUNK_OPS).map(|_| ADeadOp::Nop));
+            ops.push(ADeadOp::Ret);
+        }
+        assert_eq!(function_chunks(ops.len(), &starts).len(), 3);
+
+        let serial = Encoder::new().encode_all(&ops);
+        for jobs in [1, 4] {
+            let parallel = Encoder::encode_functions(&ops, &starts, jobs);
+            assert_eq!(parallel.code, serial.code, "jobs = {}", jobs);
+            assert_eq!(parallel.iat_call_offsets, serial.iat_call_offsets);
+        }
+    }
+
     // ========================================
     // OS-Level instruction tests
     // ========================================
@@ -0,0 +1,809 @@
+// ============================================================
+// ADead-BIB — Tabla hash plana (std::unordered_map / unordered_set)
+// ============================================================
+// Direccionamiento abierto al estilo SwissTable: un byte de control
+// por slot (EMPTY, DELETED o los 7 bits altos del hash, H2) y los
+// slots {clave, valor} en un array aparte. Se sondea por grupos
+// alineados de bytes de control, con salto triangular entre grupos:
+//
+//   - con AVX2 (BitTarget con ymm) un grupo son 32 bytes: vpcmpeqb
+//     contra H2 difundido + vpmovmskb da los candidatos de una vez
+//   - sin AVX2, grupos de 8 bytes con SWAR sobre un registro de 64 bits
+//
+// Solo se comparan claves en los candidatos con el mismo H2, así que
+// una búsqueda típica toca una línea de control y una de slots.
+// Carga máxima 7/8; al agotarse se rehace la tabla (el doble si hay
+// muchas vivas, igual si sobraban lápidas).
+//
+// La cabecera vive en una página propia con una tabla inicial de
+// INLINE_CAP slots dentro; las tablas mayores son mapeos aparte.
+// Claves y valores de 8 bytes (enteros o punteros).
+// ============================================================
+
+use super::slab_heap::{self, PageSource};
+use super::vex_emitter::{AvxInst, VexEmitter, VexMem};
+use super::ymm_allocator::YmmReg;
+use super::{ADeadIR, ADeadOp, CallTarget, Condition, Label, Operand, Reg};
+
+/// Multiplicador de Fibonacci: los bits altos de k·HASH_MUL mezclan toda la clave
+const HASH_MUL: u64 = 0x9E37_79B9_7F4A_7C15;
+/// H2 = bits 57..63; el grupo sale de los bits desde GROUP_SHIFT
+const H2_SHIFT: u8 = 57;
+const GROUP_SHIFT: u8 = 25;
+
+const EMPTY: i32 = 0x80;
+const DELETED: i32 = 0xFE;
+const LOW_BYTES: u64 = 0x0101_0101_0101_0101;
+const HIGH_BITS: u64 = 0x8080_8080_8080_8080;
+
+// ---- Cabecera ----
+const CTRL: i32 = 0;
+const SLOTS: i32 = 8;
+const CAP: i32 = 16;
+const SIZE: i32 = 24;
+/// Slots EMPTY que aún pueden ocuparse sin pasar de 7/8
+const GROWTH: i32 = 32;
+/// Bytes del mapeo de la tabla; 0 = tabla inicial dentro de la cabecera
+const MAPPED: i32 = 40;
+const HEADER_BYTES: i32 = 4096;
+
+/// Tabla inicial: control en +64 (alineado para vmovdqa), slots detrás
+const INLINE_CTRL: i32 = 64;
+const INLINE_CAP: i32 = 128;
+const INLINE_SLOTS: i32 = INLINE_CTRL + INLINE_CAP;
+const _: () = assert!(INLINE_SLOTS + INLINE_CAP * SLOT_BYTES <= HEADER_BYTES);
+
+const SLOT_BYTES: i32 = 16;
+const SLOT_BITS: u8 = 4;
+
+#[derive(Debug, Clone, Copy)]
+pub struct FlatHash {
+    pages: PageSource,
+    args: [Reg; 3],
+    /// log2 del grupo: 5 (32 bytes, AVX2) o 3 (8 bytes, SWAR)
+    group_bits: u8,
+    /// adb_hash_new() → tabla, o 0
+    pub new: Label,
+    /// adb_hash_slot(t, k) → &valor, insertando 0 si no estaba (operator[])
+    pub slot: Label,
+    /// adb_hash_insert(t, k, v) → 1 si insertó, 0 si ya estaba
+    pub insert: Label,
+    /// adb_hash_find(t, k) → &valor, o 0
+    pub find: Label,
+    /// adb_hash_erase(t, k) → 1 si estaba
+    pub erase: Label,
+    /// adb_hash_size(t)
+    pub size: Label,
+    /// adb_hash_clear(t): vacía y vuelve a la tabla inicial
+    pub clear: Label,
+    /// adb_hash_free(t)
+    pub free: Label,
+    lookup: Label,
+    free_slot: Label,
+    place: Label,
+    add: Label,
+    rehash: Label,
+    reset: Label,
+    map: Label,
+    unmap: Label,
+}
+
+fn mov(ir: &mut ADeadIR, dst: Reg, src: Operand) {
+    ir.emit(ADeadOp::Mov { dst: Operand::Reg(dst), src });
+}
+
+fn mem(base: Reg, disp: i32) -> Operand {
+    Operand::Mem { base, disp }
+}
+
+fn store(ir: &mut ADeadIR, base: Reg, disp: i32, src: Reg) {
+    ir.emit(ADeadOp::Mov { dst: mem(base, disp), src: Operand::Reg(src) });
+}
+
+fn jcc(ir: &mut ADeadIR, cond: Condition, target: Label) {
+    ir.emit(ADeadOp::Jcc { cond, target });
+}
+
+fn call(ir: &mut ADeadIR, target: Label) {
+    ir.emit(ADeadOp::Call { target: CallTarget::Relative(target) });
+}
+
+fn push(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Push { src: Operand::Reg(reg) });
+}
+
+fn pop(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Pop { dst: reg });
+}
+
+fn zero(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Xor { dst: reg, src: reg });
+}
+
+fn gpr(reg: Reg) -> u8 {
+    match reg {
+        Reg::RAX => 0,
+        Reg::RCX => 1,
+        Reg::RDX => 2,
+        Reg::RBX => 3,
+        Reg::RSP => 4,
+        Reg::RBP => 5,
+        Reg::RSI => 6,
+        Reg::RDI => 7,
+        Reg::R8 => 8,
+        Reg::R9 => 9,
+        Reg::R10 => 10,
+        Reg::R11 => 11,
+        Reg::R12 => 12,
+        Reg::R13 => 13,
+        Reg::R14 => 14,
+        Reg::R15 => 15,
+        _ => unreachable!("flat_hash solo usa registros de propósito general"),
+    }
+}
+
+/// bsf dst, src (src ≠ 0)
+fn bsf(ir: &mut ADeadIR, dst: Reg, src: Reg) {
+    let (d, s) = (gpr(dst), gpr(src));
+    let rex = 0x48 | ((d >> 3) << 2) | (s >> 3);
+    ir.emit(ADeadOp::RawBytes(vec![rex, 0x0F, 0xBC, 0xC0 | ((d & 7) << 3) | (s & 7)]));
+}
+
+fn emit_avx(ir: &mut ADeadIR, insts: &[AvxInst]) {
+    let mut vex = VexEmitter::new();
+    vex.emit_all(insts);
+    ir.emit(ADeadOp::RawBytes(vex.into_bytes()));
+}
+
+impl FlatHash {
+    /// `windows`: argumentos en RCX/RDX/R8, si no RDI/RSI/RDX;
+    /// `avx2`: grupos de 32 bytes con ymm
+    pub fn new(ir: &mut ADeadIR, pages: PageSource, windows: bool, avx2: bool) -> Self {
+        Self {
+            pages,
+            args: if windows { [Reg::RCX, Reg::RDX, Reg::R8] } else { [Reg::RDI, Reg::RSI, Reg::RDX] },
+            group_bits: if avx2 { 5 } else { 3 },
+            new: ir.new_label(),
+            slot: ir.new_label(),
+            insert: ir.new_label(),
+            find: ir.new_label(),
+            erase: ir.new_label(),
+            size: ir.new_label(),
+            clear: ir.new_label(),
+            free: ir.new_label(),
+            lookup: ir.new_label(),
+            free_slot: ir.new_label(),
+            place: ir.new_label(),
+            add: ir.new_label(),
+            rehash: ir.new_label(),
+            reset: ir.new_label(),
+            map: ir.new_label(),
+            unmap: ir.new_label(),
+        }
+    }
+
+    /// Rutina que resuelve una llamada de C/C++
+    pub fn routine(&self, name: &str) -> Option<Label> {
+        match name {
+            "adb_hash_new" => Some(self.new),
+            "adb_hash_slot" => Some(self.slot),
+            "adb_hash_insert" => Some(self.insert),
+            "adb_hash_find" => Some(self.find),
+            "adb_hash_erase" => Some(self.erase),
+            "adb_hash_size" => Some(self.size),
+            "adb_hash_clear" => Some(self.clear),
+            "adb_hash_free" => Some(self.free),
+            _ => None,
+        }
+    }
+
+    fn avx2(&self) -> bool {
+        self.group_bits == 5
+    }
+
+    pub fn emit_routines(&self, ir: &mut ADeadIR) {
+        slab_heap::emit_page_map(ir, self.map, self.pages);
+        slab_heap::emit_page_unmap(ir, self.unmap, self.pages);
+        self.emit_new(ir);
+        self.emit_slot(ir);
+        self.emit_insert(ir);
+        self.emit_find(ir);
+        self.emit_erase(ir);
+        self.emit_size(ir);
+        self.emit_clear(ir);
+        self.emit_free(ir);
+        self.emit_lookup(ir);
+        self.emit_free_slot(ir);
+        self.emit_place(ir);
+        self.emit_add(ir);
+        self.emit_rehash(ir);
+        self.emit_reset(ir);
+    }
+
+    // ---- Entradas desde C ----
+
+    /// Guarda RBX, R12-R15, RSI, RDI; RBX = tabla, R12 = clave
+    fn enter(&self, ir: &mut ADeadIR) {
+        push(ir, Reg::RBP);
+        mov(ir, Reg::RBP, Operand::Reg(Reg::RSP));
+        for reg in [Reg::RBX, Reg::R12, Reg::R13, Reg::R14, Reg::R15, Reg::RSI, Reg::RDI] {
+            push(ir, reg);
+        }
+        mov(ir, Reg::R12, Operand::Reg(self.args[1]));
+        mov(ir, Reg::RBX, Operand::Reg(self.args[0]));
+    }
+
+    fn leave(&self, ir: &mut ADeadIR) {
+        if self.avx2() {
+            emit_avx(ir, &[AvxInst::Vzeroupper]);
+        }
+        ir.emit(ADeadOp::Lea { dst: Reg::RSP, src: mem(Reg::RBP, -56) });
+        for reg in [Reg::RDI, Reg::RSI, Reg::R15, Reg::R14, Reg::R13, Reg::R12, Reg::RBX] {
+            pop(ir, reg);
+        }
+        pop(ir, Reg::RBP);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    fn emit_new(&self, ir: &mut ADeadIR) {
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.new));
+        self.enter(ir);
+        mov(ir, Reg::RCX, Operand::Imm32(HEADER_BYTES));
+        call(ir, self.map);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        mov(ir, Reg::RBX, Operand::Reg(Reg::RAX));
+        call(ir, self.reset);
+        mov(ir, Reg::RAX, Operand::Reg(Reg::RBX));
+        ir.emit(ADeadOp::Label(out));
+        self.leave(ir);
+    }
+
+    fn emit_slot(&self, ir: &mut ADeadIR) {
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.slot));
+        self.enter(ir);
+        call(ir, self.lookup);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Imm32(8) });
+        self.leave(ir);
+        ir.emit(ADeadOp::Label(out));
+        call(ir, self.add);
+        self.leave(ir);
+    }
+
+    fn emit_insert(&self, ir: &mut ADeadIR) {
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.insert));
+        self.enter(ir);
+        // El valor va a [rbp - 64]: lookup pisa todos los registros libres
+        push(ir, self.args[2]);
+        call(ir, self.lookup);
+        zero(ir, Reg::RCX);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        mov(ir, Reg::RAX, Operand::Reg(Reg::RCX));
+        jcc(ir, Condition::NotEqual, out);
+        call(ir, self.add);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        mov(ir, Reg::RCX, mem(Reg::RBP, -64));
+        store(ir, Reg::RAX, 0, Reg::RCX);
+        mov(ir, Reg::RAX, Operand::Imm32(1));
+        ir.emit(ADeadOp::Label(out));
+        self.leave(ir);
+    }
+
+    fn emit_find(&self, ir: &mut ADeadIR) {
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.find));
+        self.enter(ir);
+        call(ir, self.lookup);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Imm32(8) });
+        ir.emit(ADeadOp::Label(out));
+        self.leave(ir);
+    }
+
+    /// Si el grupo del slot aún tiene un EMPTY, ningún sondeo pasó
+    /// nunca de él: el slot vuelve a EMPTY. Si no, queda una lápida
+    fn emit_erase(&self, ir: &mut ADeadIR) {
+        let out = ir.new_label();
+        let mark = ir.new_label();
+        ir.emit(ADeadOp::Label(self.erase));
+        self.enter(ir);
+        call(ir, self.lookup);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        // RAX = índice del slot, RDI = su grupo (lookup lo deja ahí)
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RAX), src: mem(Reg::RBX, SLOTS) });
+        ir.emit(ADeadOp::Shr { dst: Reg::RAX, amount: SLOT_BITS });
+        self.empty_mask(ir);
+        mov(ir, Reg::RCX, Operand::Imm32(DELETED));
+        ir.emit(ADeadOp::Test { left: Reg::RDX, right: Reg::RDX });
+        jcc(ir, Condition::Equal, mark);
+        mov(ir, Reg::RCX, Operand::Imm32(EMPTY));
+        ir.emit(ADeadOp::Inc { dst: mem(Reg::RBX, GROWTH) });
+        ir.emit(ADeadOp::Label(mark));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: mem(Reg::RBX, CTRL) });
+        ir.emit(ADeadOp::Store8 { base: Reg::RAX, disp: 0, src: Reg::RCX });
+        ir.emit(ADeadOp::Dec { dst: mem(Reg::RBX, SIZE) });
+        mov(ir, Reg::RAX, Operand::Imm32(1));
+        ir.emit(ADeadOp::Label(out));
+        self.leave(ir);
+    }
+
+    fn emit_size(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.size));
+        mov(ir, Reg::RAX, mem(self.args[0], SIZE));
+        ir.emit(ADeadOp::Ret);
+    }
+
+    fn emit_clear(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.clear));
+        self.enter(ir);
+        call(ir, self.reset);
+        zero(ir, Reg::RAX);
+        self.leave(ir);
+    }
+
+    fn emit_free(&self, ir: &mut ADeadIR) {
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.free));
+        self.enter(ir);
+        ir.emit(ADeadOp::Test { left: Reg::RBX, right: Reg::RBX });
+        jcc(ir, Condition::Equal, out);
+        call(ir, self.reset);
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RBX));
+        mov(ir, Reg::RDX, Operand::Imm32(HEADER_BYTES));
+        call(ir, self.unmap);
+        ir.emit(ADeadOp::Label(out));
+        zero(ir, Reg::RAX);
+        self.leave(ir);
+    }
+
+    // ---- Sondeo ----
+
+    /// R13 = hash de R12
+    fn hash(ir: &mut ADeadIR) {
+        mov(ir, Reg::R13, Operand::Imm64(HASH_MUL));
+        ir.emit(ADeadOp::Mul { dst: Reg::R13, src: Reg::R12 });
+    }
+
+    /// RSI = máscara de grupos, R14 = primer grupo, R15 = paso
+    fn group_start(&self, ir: &mut ADeadIR) {
+        mov(ir, Reg::RSI, mem(Reg::RBX, CAP));
+        ir.emit(ADeadOp::Shr { dst: Reg::RSI, amount: self.group_bits });
+        ir.emit(ADeadOp::Dec { dst: Operand::Reg(Reg::RSI) });
+        mov(ir, Reg::R14, Operand::Reg(Reg::R13));
+        ir.emit(ADeadOp::Shr { dst: Reg::R14, amount: GROUP_SHIFT });
+        ir.emit(ADeadOp::And { dst: Reg::R14, src: Reg::RSI });
+        zero(ir, Reg::R15);
+    }
+
+    /// Salto triangular: visita todos los grupos (su número es potencia de 2)
+    fn next_group(ir: &mut ADeadIR, top: Label) {
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R15) });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::R14), src: Operand::Reg(Reg::R15) });
+        ir.emit(ADeadOp::And { dst: Reg::R14, src: Reg::RSI });
+        ir.emit(ADeadOp::Jmp { target: top });
+    }
+
+    /// RDI = control del grupo R14; con SWAR, R11 = sus 8 bytes y con
+    /// AVX2, ymm1 = sus 32
+    fn load_group(&self, ir: &mut ADeadIR) {
+        mov(ir, Reg::RDI, Operand::Reg(Reg::R14));
+        ir.emit(ADeadOp::Shl { dst: Reg::RDI, amount: self.group_bits });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RDI), src: mem(Reg::RBX, CTRL) });
+        if self.avx2() {
+            emit_avx(ir, &[AvxInst::VmovdqaLoad { dst: YmmReg(1), mem: VexMem::base(gpr(Reg::RDI), 0) }]);
+        } else {
+            mov(ir, Reg::R11, mem(Reg::RDI, 0));
+        }
+    }
+
+    /// RDX = bit por byte de control con el MSB de `ctrl & !(ctrl << shift)`:
+    /// shift 6 marca EMPTY, shift 7 EMPTY o DELETED. Usa RAX
+    fn swar_special(ir: &mut ADeadIR, shift: u8) {
+        mov(ir, Reg::RDX, Operand::Reg(Reg::R11));
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R11));
+        ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: shift });
+        ir.emit(ADeadOp::BitwiseNot { dst: Reg::RAX });
+        ir.emit(ADeadOp::And { dst: Reg::RDX, src: Reg::RAX });
+        mov(ir, Reg::RAX, Operand::Imm64(HIGH_BITS));
+        ir.emit(ADeadOp::And { dst: Reg::RDX, src: Reg::RAX });
+    }
+
+    /// RDX = slots EMPTY del grupo en RDI (cargándolo de nuevo). Usa RAX y R11
+    fn empty_mask(&self, ir: &mut ADeadIR) {
+        if self.avx2() {
+            emit_avx(ir, &[AvxInst::VmovdqaLoad { dst: YmmReg(1), mem: VexMem::base(gpr(Reg::RDI), 0) }]);
+            Self::avx_empty(ir);
+        } else {
+            push(ir, Reg::RAX);
+            mov(ir, Reg::R11, mem(Reg::RDI, 0));
+            Self::swar_special(ir, 6);
+            pop(ir, Reg::RAX);
+        }
+    }
+
+    /// ymm3 = EMPTY en cada byte; RDX = bytes de ymm1 iguales
+    fn avx_empty(ir: &mut ADeadIR) {
+        mov(ir, Reg::RCX, Operand::Imm32(EMPTY));
+        emit_avx(ir, &[
+            AvxInst::VmovqFromGp { dst: YmmReg(3), src: gpr(Reg::RCX) },
+            AvxInst::Vpbroadcast { lane: 1, dst: YmmReg(3), src: YmmReg(3) },
+            AvxInst::Vpcmpeqb { dst: YmmReg(2), src1: YmmReg(1), src2: YmmReg(3) },
+            AvxInst::Vpmovmskb { dst: gpr(Reg::RDX), src: YmmReg(2) },
+        ]);
+    }
+
+    /// RCX = byte del grupo del bit más bajo de RDX
+    fn lowest_byte(&self, ir: &mut ADeadIR, dst: Reg) {
+        bsf(ir, dst, Reg::RDX);
+        if !self.avx2() {
+            ir.emit(ADeadOp::Shr { dst, amount: 3 });
+        }
+        mov(ir, Reg::R9, Operand::Reg(Reg::R14));
+        ir.emit(ADeadOp::Shl { dst: Reg::R9, amount: self.group_bits });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(dst), src: Operand::Reg(Reg::R9) });
+    }
+
+    /// RBX = tabla, R12 = clave → RAX = slot o 0, R13 = hash,
+    /// RDI = control de su grupo
+    fn emit_lookup(&self, ir: &mut ADeadIR) {
+        let top = ir.new_label();
+        let candidates = ir.new_label();
+        let no_match = ir.new_label();
+        let next = ir.new_label();
+        let found = ir.new_label();
+        ir.emit(ADeadOp::Label(self.lookup));
+        Self::hash(ir);
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R13));
+        ir.emit(ADeadOp::Shr { dst: Reg::RCX, amount: H2_SHIFT });
+        if self.avx2() {
+            emit_avx(ir, &[
+                AvxInst::VmovqFromGp { dst: YmmReg(0), src: gpr(Reg::RCX) },
+                AvxInst::Vpbroadcast { lane: 1, dst: YmmReg(0), src: YmmReg(0) },
+            ]);
+        } else {
+            // R8 = H2 en cada byte, R10 = 0x01 en cada byte
+            mov(ir, Reg::R10, Operand::Imm64(LOW_BYTES));
+            mov(ir, Reg::R8, Operand::Reg(Reg::RCX));
+            ir.emit(ADeadOp::Mul { dst: Reg::R8, src: Reg::R10 });
+        }
+        self.group_start(ir);
+        ir.emit(ADeadOp::Label(top));
+        self.load_group(ir);
+        if self.avx2() {
+            emit_avx(ir, &[
+                AvxInst::Vpcmpeqb { dst: YmmReg(2), src1: YmmReg(1), src2: YmmReg(0) },
+                AvxInst::Vpmovmskb { dst: gpr(Reg::RDX), src: YmmReg(2) },
+            ]);
+        } else {
+            // Bytes a cero de ctrl ^ H2: (x - 0x01..) & !x & 0x80.. (solo
+            // falsos positivos sobre slots llenos; se comparan las claves)
+            mov(ir, Reg::RDX, Operand::Reg(Reg::R11));
+            ir.emit(ADeadOp::Xor { dst: Reg::RDX, src: Reg::R8 });
+            mov(ir, Reg::RAX, Operand::Reg(Reg::RDX));
+            ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::R10) });
+            ir.emit(ADeadOp::BitwiseNot { dst: Reg::RDX });
+            ir.emit(ADeadOp::And { dst: Reg::RDX, src: Reg::RAX });
+            mov(ir, Reg::RAX, Operand::Imm64(HIGH_BITS));
+            ir.emit(ADeadOp::And { dst: Reg::RDX, src: Reg::RAX });
+        }
+        ir.emit(ADeadOp::Label(candidates));
+        ir.emit(ADeadOp::Test { left: Reg::RDX, right: Reg::RDX });
+        jcc(ir, Condition::Equal, no_match);
+        self.lowest_byte(ir, Reg::RAX);
+        ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: SLOT_BITS });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: mem(Reg::RBX, SLOTS) });
+        ir.emit(ADeadOp::Cmp { left: mem(Reg::RAX, 0), right: Operand::Reg(Reg::R12) });
+        jcc(ir, Condition::Equal, found);
+        ir.emit(ADeadOp::Lea { dst: Reg::RCX, src: mem(Reg::RDX, -1) });
+        ir.emit(ADeadOp::And { dst: Reg::RDX, src: Reg::RCX });
+        ir.emit(ADeadOp::Jmp { target: candidates });
+        // Un EMPTY en el grupo corta el sondeo
+        ir.emit(ADeadOp::Label(no_match));
+        if self.avx2() {
+            Self::avx_empty(ir);
+        } else {
+            Self::swar_special(ir, 6);
+        }
+        ir.emit(ADeadOp::Test { left: Reg::RDX, right: Reg::RDX });
+        jcc(ir, Condition::Equal, next);
+        zero(ir, Reg::RAX);
+        ir.emit(ADeadOp::Label(found));
+        ir.emit(ADeadOp::Ret);
+        ir.emit(ADeadOp::Label(next));
+        Self::next_group(ir, top);
+    }
+
+    /// RBX = tabla, R13 = hash → RAX = índice del primer slot EMPTY o
+    /// DELETED de su sondeo
+    fn emit_free_slot(&self, ir: &mut ADeadIR) {
+        let top = ir.new_label();
+        let next = ir.new_label();
+        ir.emit(ADeadOp::Label(self.free_slot));
+        self.group_start(ir);
+        ir.emit(ADeadOp::Label(top));
+        self.load_group(ir);
+        if self.avx2() {
+            emit_avx(ir, &[AvxInst::Vpmovmskb { dst: gpr(Reg::RDX), src: YmmReg(1) }]);
+        } else {
+            Self::swar_special(ir, 7);
+        }
+        ir.emit(ADeadOp::Test { left: Reg::RDX, right: Reg::RDX });
+        jcc(ir, Condition::Equal, next);
+        self.lowest_byte(ir, Reg::RAX);
+        ir.emit(ADeadOp::Ret);
+        ir.emit(ADeadOp::Label(next));
+        Self::next_group(ir, top);
+    }
+
+    /// RAX = índice libre, R12 = clave, R13 = hash: ocupa el slot con
+    /// valor 0 → RAX = &valor
+    fn emit_place(&self, ir: &mut ADeadIR) {
+        let was_deleted = ir.new_label();
+        ir.emit(ADeadOp::Label(self.place));
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RAX));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RCX), src: mem(Reg::RBX, CTRL) });
+        ir.emit(ADeadOp::Load8 { dst: Reg::RDX, base: Reg::RCX, disp: 0 });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RDX), right: Operand::Imm32(EMPTY) });
+        jcc(ir, Condition::NotEqual, was_deleted);
+        ir.emit(ADeadOp::Dec { dst: mem(Reg::RBX, GROWTH) });
+        ir.emit(ADeadOp::Label(was_deleted));
+        mov(ir, Reg::RDX, Operand::Reg(Reg::R13));
+        ir.emit(ADeadOp::Shr { dst: Reg::RDX, amount: H2_SHIFT });
+        ir.emit(ADeadOp::Store8 { base: Reg::RCX, disp: 0, src: Reg::RDX });
+        ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: SLOT_BITS });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: mem(Reg::RBX, SLOTS) });
+        store(ir, Reg::RAX, 0, Reg::R12);
+        zero(ir, Reg::RDX);
+        store(ir, Reg::RAX, 8, Reg::RDX);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Imm32(8) });
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// Inserta R12 (ausente, hash en R13) con valor 0 → RAX = &valor, o 0
+    /// si no hubo páginas para crecer
+    fn emit_add(&self, ir: &mut ADeadIR) {
+        let room = ir.new_label();
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.add));
+        ir.emit(ADeadOp::Cmp { left: mem(Reg::RBX, GROWTH), right: Operand::Imm32(0) });
+        jcc(ir, Condition::NotEqual, room);
+        call(ir, self.rehash);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        ir.emit(ADeadOp::Label(room));
+        call(ir, self.free_slot);
+        call(ir, self.place);
+        ir.emit(ADeadOp::Inc { dst: mem(Reg::RBX, SIZE) });
+        ir.emit(ADeadOp::Label(out));
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// Tabla nueva (doble si las vivas pasan de 7/16, si no igual, para
+    /// limpiar lápidas) y reinserción → RAX = 1, o 0 sin páginas.
+    /// Conserva RBX, R12 y R13
+    fn emit_rehash(&self, ir: &mut ADeadIR) {
+        let same = ir.new_label();
+        let top = ir.new_label();
+        let skip = ir.new_label();
+        let moved = ir.new_label();
+        let inline = ir.new_label();
+        let out = ir.new_label();
+        // Frame: tabla vieja + índice + R12/R13 del que llama
+        const OLD_CTRL: i32 = 0;
+        const OLD_SLOTS: i32 = 8;
+        const OLD_CAP: i32 = 16;
+        const OLD_MAPPED: i32 = 24;
+        const INDEX: i32 = 32;
+        const SAVED_KEY: i32 = 40;
+        const SAVED_HASH: i32 = 48;
+        ir.emit(ADeadOp::Label(self.rehash));
+        push(ir, Reg::RBP);
+        mov(ir, Reg::RBP, Operand::Reg(Reg::RSP));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm32(64) });
+        mov(ir, Reg::RAX, Operand::Imm32(-16));
+        ir.emit(ADeadOp::And { dst: Reg::RSP, src: Reg::RAX });
+        store(ir, Reg::RSP, SAVED_KEY, Reg::R12);
+        store(ir, Reg::RSP, SAVED_HASH, Reg::R13);
+        for (disp, field) in [(OLD_CTRL, CTRL), (OLD_SLOTS, SLOTS), (OLD_CAP, CAP), (OLD_MAPPED, MAPPED)] {
+            mov(ir, Reg::RAX, mem(Reg::RBX, field));
+            store(ir, Reg::RSP, disp, Reg::RAX);
+        }
+
+        // R12 = capacidad nueva
+        mov(ir, Reg::R12, mem(Reg::RBX, CAP));
+        mov(ir, Reg::RAX, mem(Reg::RBX, SIZE));
+        ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: 4 });
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R12));
+        mov(ir, Reg::RDX, Operand::Imm32(7));
+        ir.emit(ADeadOp::Mul { dst: Reg::RCX, src: Reg::RDX });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Reg(Reg::RCX) });
+        jcc(ir, Condition::Below, same);
+        ir.emit(ADeadOp::Shl { dst: Reg::R12, amount: 1 });
+        ir.emit(ADeadOp::Label(same));
+        // cap bytes de control + cap slots
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R12));
+        mov(ir, Reg::RDX, Operand::Imm32(SLOT_BYTES + 1));
+        ir.emit(ADeadOp::Mul { dst: Reg::RCX, src: Reg::RDX });
+        mov(ir, Reg::R13, Operand::Reg(Reg::RCX));
+        call(ir, self.map);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        store(ir, Reg::RBX, CTRL, Reg::RAX);
+        store(ir, Reg::RBX, MAPPED, Reg::R13);
+        store(ir, Reg::RBX, CAP, Reg::R12);
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RAX));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RCX), src: Operand::Reg(Reg::R12) });
+        store(ir, Reg::RBX, SLOTS, Reg::RCX);
+        Self::set_growth(ir);
+        mov(ir, Reg::RDI, Operand::Reg(Reg::RAX));
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R12));
+        mov(ir, Reg::RAX, Operand::Imm32(EMPTY));
+        ir.emit(ADeadOp::Cld);
+        ir.emit(ADeadOp::Rep { op: Box::new(ADeadOp::Stosb) });
+
+        // Reinsertar las vivas (sin lápidas ni comparar claves)
+        zero(ir, Reg::RAX);
+        store(ir, Reg::RSP, INDEX, Reg::RAX);
+        ir.emit(ADeadOp::Label(top));
+        mov(ir, Reg::RAX, mem(Reg::RSP, INDEX));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: mem(Reg::RSP, OLD_CAP) });
+        jcc(ir, Condition::AboveEq, moved);
+        mov(ir, Reg::RCX, mem(Reg::RSP, OLD_CTRL));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RCX), src: Operand::Reg(Reg::RAX) });
+        ir.emit(ADeadOp::Load8 { dst: Reg::RCX, base: Reg::RCX, disp: 0 });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: Operand::Imm32(EMPTY) });
+        jcc(ir, Condition::AboveEq, skip);
+        ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: SLOT_BITS });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: mem(Reg::RSP, OLD_SLOTS) });
+        mov(ir, Reg::R12, mem(Reg::RAX, 0));
+        push(ir, Reg::RAX);
+        push(ir, Reg::RAX);
+        Self::hash(ir);
+        call(ir, self.free_slot);
+        call(ir, self.place);
+        pop(ir, Reg::RCX);
+        pop(ir, Reg::RCX);
+        mov(ir, Reg::RCX, mem(Reg::RCX, 8));
+        store(ir, Reg::RAX, 0, Reg::RCX);
+        ir.emit(ADeadOp::Label(skip));
+        ir.emit(ADeadOp::Inc { dst: mem(Reg::RSP, INDEX) });
+        ir.emit(ADeadOp::Jmp { target: top });
+
+        ir.emit(ADeadOp::Label(moved));
+        mov(ir, Reg::RDX, mem(Reg::RSP, OLD_MAPPED));
+        ir.emit(ADeadOp::Test { left: Reg::RDX, right: Reg::RDX });
+        jcc(ir, Condition::Equal, inline);
+        mov(ir, Reg::RCX, mem(Reg::RSP, OLD_CTRL));
+        call(ir, self.unmap);
+        ir.emit(ADeadOp::Label(inline));
+        mov(ir, Reg::RAX, Operand::Imm32(1));
+        ir.emit(ADeadOp::Label(out));
+        mov(ir, Reg::R12, mem(Reg::RSP, SAVED_KEY));
+        mov(ir, Reg::R13, mem(Reg::RSP, SAVED_HASH));
+        mov(ir, Reg::RSP, Operand::Reg(Reg::RBP));
+        pop(ir, Reg::RBP);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// GROWTH = 7/8 de R12 (capacidad)
+    fn set_growth(ir: &mut ADeadIR) {
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R12));
+        ir.emit(ADeadOp::Shr { dst: Reg::RCX, amount: 3 });
+        mov(ir, Reg::RDX, Operand::Reg(Reg::R12));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RDX), src: Operand::Reg(Reg::RCX) });
+        store(ir, Reg::RBX, GROWTH, Reg::RDX);
+    }
+
+    /// RBX = cabecera: suelta la tabla mapeada y vuelve a la inicial vacía.
+    /// Conserva RBX; pisa R12
+    fn emit_reset(&self, ir: &mut ADeadIR) {
+        let inline = ir.new_label();
+        ir.emit(ADeadOp::Label(self.reset));
+        mov(ir, Reg::RDX, mem(Reg::RBX, MAPPED));
+        ir.emit(ADeadOp::Test { left: Reg::RDX, right: Reg::RDX });
+        jcc(ir, Condition::Equal, inline);
+        mov(ir, Reg::RCX, mem(Reg::RBX, CTRL));
+        call(ir, self.unmap);
+        ir.emit(ADeadOp::Label(inline));
+        ir.emit(ADeadOp::Lea { dst: Reg::RDI, src: mem(Reg::RBX, INLINE_CTRL) });
+        store(ir, Reg::RBX, CTRL, Reg::RDI);
+        ir.emit(ADeadOp::Lea { dst: Reg::RAX, src: mem(Reg::RBX, INLINE_SLOTS) });
+        store(ir, Reg::RBX, SLOTS, Reg::RAX);
+        mov(ir, Reg::R12, Operand::Imm32(INLINE_CAP));
+        store(ir, Reg::RBX, CAP, Reg::R12);
+        zero(ir, Reg::RAX);
+        store(ir, Reg::RBX, SIZE, Reg::RAX);
+        store(ir, Reg::RBX, MAPPED, Reg::RAX);
+        Self::set_growth(ir);
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R12));
+        mov(ir, Reg::RAX, Operand::Imm32(EMPTY));
+        ir.emit(ADeadOp::Cld);
+        ir.emit(ADeadOp::Rep { op: Box::new(ADeadOp::Stosb) });
+        ir.emit(ADeadOp::Ret);
+    }
+}
+
+#[cfg(all(test, target_os = "linux", target_arch = "x86_64"))]
+mod tests {
+    use super::*;
+    use crate::isa::test_jit::JitCode;
+    use std::collections::HashMap;
+
+    fn check(avx2: bool) {
+        let mut ir = ADeadIR::new();
+        let hash = FlatHash::new(&mut ir, PageSource::Syscall, false, avx2);
+        hash.emit_routines(&mut ir);
+        let code = JitCode::new(ir.ops());
+
+        unsafe {
+            let new: extern "C" fn() -> i64 = code.func(hash.new);
+            let slot: extern "C" fn(i64, i64) -> *mut i64 = code.func(hash.slot);
+            let insert: extern "C" fn(i64, i64, i64) -> i64 = code.func(hash.insert);
+            let find: extern "C" fn(i64, i64) -> *mut i64 = code.func(hash.find);
+            let erase: extern "C" fn(i64, i64) -> i64 = code.func(hash.erase);
+            let len: extern "C" fn(i64) -> i64 = code.func(hash.size);
+            let clear: extern "C" fn(i64) -> i64 = code.func(hash.clear);
+            let free: extern "C" fn(i64) -> i64 = code.func(hash.free);
+
+            let t = new();
+            assert_ne!(t, 0);
+            let mut want: HashMap<i64, i64> = HashMap::new();
+            // Varias duplicaciones, borrados con lápidas y reinserciones
+            let mut seed = 11u64;
+            for round in 0..40_000i64 {
+                seed = seed.wrapping_mul(6364136223846793005).wrapping_add(1442695040888963407);
+                let k = (seed >> 33) as i64 % 30_000 - 10_000;
+                match round % 5 {
+                    0 | 1 => {
+                        let fresh = !want.contains_key(&k);
+                        assert_eq!(insert(t, k, round), fresh as i64);
+                        want.entry(k).or_insert(round);
+                    }
+                    2 => {
+                        *slot(t, k) += 3;
+                        *want.entry(k).or_insert(0) += 3;
+                    }
+                    3 => assert_eq!(erase(t, k), want.remove(&k).is_some() as i64),
+                    _ => {
+                        let p = find(t, k);
+                        match want.get(&k) {
+                            Some(&v) => assert_eq!(*p, v),
+                            None => assert!(p.is_null()),
+                        }
+                    }
+                }
+            }
+            assert_eq!(len(t), want.len() as i64);
+            for (&k, &v) in &want {
+                assert_eq!(*find(t, k), v);
+            }
+
+            clear(t);
+            assert_eq!(len(t), 0);
+            assert!(find(t, *want.keys().next().unwrap()).is_null());
+            assert_eq!(insert(t, i64::MIN, 5), 1);
+            assert_eq!(*find(t, i64::MIN), 5);
+            free(t);
+        }
+    }
+
+    #[test]
+    fn test_flat_hash_swar() {
+        check(false);
+    }
+
+    #[test]
+    fn test_flat_hash_avx2() {
+        if std::is_x86_feature_detected!("avx2") {
+            check(true);
+        }
+    }
+}
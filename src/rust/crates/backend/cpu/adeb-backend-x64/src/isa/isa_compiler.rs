@@ -12,11 +12,40 @@
 // Email: eddi.salazar.dev@gmail.com
 // ============================================================
 
-use super::encoder::Encoder;
-use super::reg_alloc::TempAllocator;
+use super::bit_resolver::BitTarget;
+use super::code_layout::{self, CallEdge, FunctionSegment};
+use super::debug_info::DebugInfo;
+use super::encoder::{EncodeResult, Encoder};
+use super::linux_stdio::{self, StdoutBuffer};
+use super::linux_vdso;
+use super::slab_heap::{self, PageSource, SlabHeap};
+use super::task_pool::{self, TaskPool, ThreadApi};
+use super::par_algorithms::ParAlgorithms;
+use super::flat_hash::FlatHash;
+use super::async_io::{AioApi, AsyncIo};
+use super::btree::BTree;
+use super::sync::{SyncApi, SyncRuntime};
+use super::vec_math::{self, MathFn, VecMathRuntime};
+use super::liveness;
+use super::loop_opt;
+use super::sroa;
+use super::struct_abi::{self, StructPass};
+use super::loop_vectorizer::{self, ArrayInfo, LoopContext, LoopReport, VecLoop, VecStep};
+use super::mem_builtins::{self, BlockStrategy, MemBuiltin};
+use super::optimizer::{IsaOptLevel, IsaOptimizer, OptStats};
+use super::reg_alloc::{LinearScanAllocator, TempAllocator, EXPR_REGS, LOCAL_REGS};
+use super::scheduler::Uarch;
+use super::soa_optimizer::SoaSkipReason;
+use super::strength_reduce::{self, DivPlan, MagicFixup, MulStep};
+use super::string_pool::StringPool;
+use super::switch_lowering::{self, CaseCluster};
+use super::vex_emitter::{AvxInst, VexEmitter, VexMem};
+use super::ymm_allocator::YmmReg;
 use super::{ADeadIR, ADeadOp, CallTarget, Condition, Label, Operand, Reg};
 use crate::backend::cpu::iat_registry;
 use crate::frontend::ast::*;
+use adeb_middle::profile::{self, FunctionProfile, Profile, SiteCount};
+use adeb_core::{FxHashMap, FxHashSet};
 use std::collections::HashMap;
 
 /// Target de compilación
@@ -73,6 +102,41 @@ impl CpuMode {
     }
 }
 
+/// Integer ops that register-resident expression trees apply reg-to-reg
+#[derive(Clone, Copy, PartialEq, Debug)]
+enum RegOp {
+    Add,
+    Sub,
+    Mul,
+    And,
+    Or,
+    Xor,
+}
+
+impl RegOp {
+    fn from_bin(op: &BinOp) -> Option<Self> {
+        match op {
+            BinOp::Add => Some(RegOp::Add),
+            BinOp::Sub => Some(RegOp::Sub),
+            BinOp::Mul => Some(RegOp::Mul),
+            BinOp::And => Some(RegOp::And),
+            BinOp::Or => Some(RegOp::Or),
+            // IDIV fija RDX:RAX — se queda en el camino general
+            BinOp::Div | BinOp::Mod => None,
+        }
+    }
+
+    fn from_bitwise(op: &BitwiseOp) -> Option<Self> {
+        match op {
+            BitwiseOp::And => Some(RegOp::And),
+            BitwiseOp::Or => Some(RegOp::Or),
+            BitwiseOp::Xor => Some(RegOp::Xor),
+            // Los shifts necesitan CL
+            BitwiseOp::LeftShift | BitwiseOp::RightShift => None,
+        }
+    }
+}
+
 impl Default for CpuMode {
     fn default() -> Self {
         CpuMode::Long64 // ADead-BIB defaults to 64-bit
@@ -85,6 +149,160 @@ pub struct CompiledFunction {
     pub name: String,
     pub label: Label,
     pub params: Vec<String>,
+    pub param_types: Vec<Type>,
+    pub return_type: Type,
+}
+
+/// Código emitido para una función en el último `compile`: ops del IR
+/// final y bytes de su tramo en `.text` (hasta la siguiente función, así
+/// que incluye los brazos fríos que el layout dejó detrás de ella)
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct FunctionCodeStats {
+    pub name: String,
+    pub ops: usize,
+    pub bytes: usize,
+}
+
+/// Resultado de compilar una función en un worker aislado (codegen paralelo).
+/// Los labels `>= label_base` son locales al worker y se renumeran al fusionar.
+struct FunctionCode {
+    ops: Vec<ADeadOp>,
+    label_base: u32,
+    label_end: u32,
+    new_named_labels: Vec<(String, Label)>,
+    iat_slots: Vec<usize>,
+    loop_reports: Vec<LoopReport>,
+    clones: Vec<FunctionClone>,
+    /// Segmento de la función en `ops` (offsets desde 0)
+    segment: Option<FunctionSegment>,
+    /// false si la función mutó estado global compartido (strings tardíos,
+    /// `org`, cambio de modo CPU) — en ese caso se recompila en serie.
+    isolated: bool,
+}
+
+/// Mínimo de funciones para que compensa lanzar hilos de codegen.
+const PARALLEL_CODEGEN_MIN_FUNCTIONS: usize = 8;
+
+/// Globals de 64+ bytes (tablas constantes) empiezan en línea de caché propia
+const CACHE_LINE: u64 = 64;
+
+/// Funciones que resuelve el heap propio (slab_heap.rs) cuando está activo
+const HEAP_FUNCTIONS: [&str; 5] = ["malloc", "free", "calloc", "realloc", "adb_heap_stats"];
+
+/// Funciones del pool de tareas (task_pool.rs)
+const POOL_FUNCTIONS: [&str; 5] = ["adb_parallel_for", "adb_async", "adb_future_get", "adb_future_wait", "adb_pool_size"];
+
+/// Algoritmos con std::execution::par / par_unseq (par_algorithms.rs)
+const PAR_FUNCTIONS: [&str; 5] =
+    ["adb_par_sort", "adb_par_reduce", "adb_par_unseq_reduce", "adb_par_transform", "adb_par_for_each"];
+
+/// std::unordered_map/unordered_set de claves enteras (flat_hash.rs)
+const HASH_FUNCTIONS: [&str; 8] = [
+    "adb_hash_new",
+    "adb_hash_slot",
+    "adb_hash_insert",
+    "adb_hash_find",
+    "adb_hash_erase",
+    "adb_hash_size",
+    "adb_hash_clear",
+    "adb_hash_free",
+];
+
+/// std::map/std::set de claves enteras (btree.rs)
+const TREE_FUNCTIONS: [&str; 8] = [
+    "adb_tree_new",
+    "adb_tree_slot",
+    "adb_tree_insert",
+    "adb_tree_find",
+    "adb_tree_erase",
+    "adb_tree_size",
+    "adb_tree_clear",
+    "adb_tree_free",
+];
+
+/// std::mutex, std::condition_variable y std::atomic (sync.rs)
+const SYNC_FUNCTIONS: [&str; 15] = [
+    "adb_mutex_lock",
+    "adb_mutex_unlock",
+    "adb_mutex_try_lock",
+    "adb_cond_wait",
+    "adb_cond_notify_one",
+    "adb_cond_notify_all",
+    "adb_atomic_load",
+    "adb_atomic_store",
+    "adb_atomic_exchange",
+    "adb_atomic_fetch_add",
+    "adb_atomic_fetch_sub",
+    "adb_atomic_fetch_and",
+    "adb_atomic_fetch_or",
+    "adb_atomic_fetch_xor",
+    "adb_atomic_cas",
+];
+
+/// Anillo de E/S asíncrona: io_uring o IOCP (async_io.rs)
+const AIO_FUNCTIONS: [&str; 7] = [
+    "adb_ring_create",
+    "adb_ring_register_buffers",
+    "adb_ring_queue",
+    "adb_ring_queue_batch",
+    "adb_ring_submit",
+    "adb_ring_wait",
+    "adb_ring_destroy",
+];
+
+/// Una función compilada en varias versiones (`target_clones`). Su label
+/// público es un thunk `jmp [slot]`; el resolver del stub de arranque
+/// escribe en el slot la mejor versión que soporte la CPU.
+#[derive(Debug, Clone)]
+struct FunctionClone {
+    name: String,
+    default: Label,
+    variants: Vec<(BitTarget, Label)>,
+}
+
+/// Brazo de un if que el perfil marca como frío: se emite fuera de línea,
+/// detrás del epílogo, y vuelve a `resume` con un jmp. Guarda el scope
+/// del punto del if para que el cuerpo vea los mismos locales.
+struct ColdBlock {
+    label: Label,
+    resume: Label,
+    body: Vec<Stmt>,
+    variables: FxHashMap<String, i32>,
+    variable_types: FxHashMap<String, Type>,
+    array_vars: FxHashSet<String>,
+    array_elem_sizes: FxHashMap<String, u8>,
+    loop_stack: Vec<(Label, Label)>,
+}
+
+/// Array global de escalares (`int t[N]`): ocupa N elementos en la
+/// sección de datos y su nombre decae a la dirección del primero
+#[derive(Debug, Clone)]
+struct GlobalArray {
+    stride: u8,
+    elem: Type,
+    /// Alineación garantizada de la base (dirección absoluta)
+    align: u64,
+}
+
+/// Global de 8 bytes con la dirección de la versión elegida
+fn clone_slot_name(func: &str) -> String {
+    format!("__mv.{}", func)
+}
+
+/// Ancho SIMD por defecto del vectorizador: `ADEB_SIMD` (avx2, sse, auto,
+/// fastos256...) o escalar. Para elegir en runtime: `ADEB_TARGET_CLONES`.
+fn default_bit_target() -> BitTarget {
+    std::env::var("ADEB_SIMD")
+        .ok()
+        .and_then(|v| BitTarget::from_target_str(v.trim()))
+        .unwrap_or(BitTarget::Bits64)
+}
+
+/// Versiones extra por función: `ADEB_TARGET_CLONES=avx2,default`.
+fn default_target_clones() -> Vec<BitTarget> {
+    std::env::var("ADEB_TARGET_CLONES")
+        .map(|v| v.split(',').filter_map(|t| BitTarget::from_target_str(t.trim())).collect())
+        .unwrap_or_default()
 }
 
 /// Class/Struct layout info - inspired by GCC/LLVM Itanium ABI
@@ -100,29 +318,43 @@ pub struct ClassLayout {
     pub is_union: bool,                     // Union semantics (all fields at offset 0)
 }
 
+/// Cómo viaja un parámetro o un retorno entre funciones libres propias
+/// (reglas en struct_abi.rs)
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum ArgPass {
+    /// Escalar, o struct por referencia (métodos, imports, punteros a función)
+    Value,
+    /// Struct en N registros: un eightbyte por slot de argumento
+    Regs(u8),
+    /// Struct en memoria: puntero a una copia de N bytes (sret al volver)
+    Copy(i32),
+}
+
 /// ISA Compiler — Compilador que genera ADeadIR en vez de bytes directos.
 pub struct IsaCompiler {
     ir: ADeadIR,
 
-    // Strings
-    strings: Vec<String>,
-    string_offsets: HashMap<String, u64>,
+    // Strings (dedup + tail merging, ver string_pool.rs)
+    strings: StringPool,
 
     // Funciones
-    functions: HashMap<String, CompiledFunction>,
+    functions: FxHashMap<String, CompiledFunction>,
+    // Funciones cuya dirección se toma: se pueden llamar por puntero, así
+    // que conservan la convención de siempre (structs por referencia)
+    address_taken: FxHashSet<String>,
 
     // Class layouts - GCC/LLVM style field offset tracking
-    class_layouts: HashMap<String, ClassLayout>,
+    class_layouts: FxHashMap<String, ClassLayout>,
 
     // Estado actual
     current_function: Option<String>,
-    variables: HashMap<String, i32>,
-    variable_types: HashMap<String, Type>,
-    array_vars: std::collections::HashSet<String>,
-    array_elem_sizes: HashMap<String, u8>,          // Per-array element byte size (1=char,2=short,4=int,8=qword)
-    param_vars: std::collections::HashSet<String>, // Function parameters (use 8-byte stride)
-    struct_params: std::collections::HashSet<String>, // Struct parameters (passed by pointer)
-    ref_vars: std::collections::HashSet<String>,   // Reference parameters (auto-deref)
+    variables: FxHashMap<String, i32>,
+    variable_types: FxHashMap<String, Type>,
+    array_vars: FxHashSet<String>,
+    array_elem_sizes: FxHashMap<String, u8>,        // Per-array element byte size (1=char,2=short,4=int,8=qword)
+    param_vars: FxHashSet<String>, // Function parameters (use 8-byte stride)
+    struct_params: FxHashSet<String>, // Struct parameters (passed by pointer)
+    ref_vars: FxHashSet<String>,   // Reference parameters (auto-deref)
     stack_offset: i32,
 
     // Configuración
@@ -134,11 +366,24 @@ pub struct IsaCompiler {
     cpu_mode: CpuMode,
 
     // Named labels (v3.3-Boot) — maps label names to Label IDs
-    named_labels: HashMap<String, Label>,
+    named_labels: FxHashMap<String, Label>,
 
     // Register allocator for temporaries — eliminates push/pop in expressions
     temp_alloc: TempAllocator,
 
+    // Locales escalares que viven en un registro callee-saved (LinearScanAllocator)
+    reg_vars: FxHashMap<String, Reg>,
+    // Callee-saved guardados en el frame por esas promociones: (reg, disp desde RBP)
+    saved_callee_regs: Vec<(Reg, i32)>,
+    // Función hoja sin frame: callee-saved que empuja su prólogo (None = frame RBP)
+    frameless_saves: Option<Vec<Reg>>,
+    // Destino de `return f(...)` recursivo: el cuerpo, ya pasado el prólogo
+    tail_loop: Option<Label>,
+    // `return g(...)` puede salir con jmp (solo dentro de un frame normal)
+    tail_calls: bool,
+    // Alguna dirección del frame sale a un puntero: no se libera antes de g
+    frame_escapes: bool,
+
     // Track prologue sub rsp index for patching dynamic stack frame
     prologue_sub_index: Option<usize>,
 
@@ -146,16 +391,24 @@ pub struct IsaCompiler {
     loop_stack: Vec<(Label, Label)>,
 
     // Goto labels: maps C label names (e.g. "cleanup") to IR Label IDs
-    goto_labels: HashMap<String, Label>,
+    goto_labels: FxHashMap<String, Label>,
 
     // Global/static variables — stored at absolute addresses in data section
     // Maps variable name → byte offset within global data area
-    global_vars: HashMap<String, u32>,
+    global_vars: FxHashMap<String, u32>,
     global_data: Vec<u8>, // raw bytes for global variable initial values
     global_offset: u32,   // next free offset in global data area
-
-    // Field IR types — maps (class_name, field_name) → Type for float field detection
-    field_ir_types: HashMap<(String, String), Type>,
+    // Arrays globales con almacenamiento propio (ver GlobalArray)
+    global_arrays: FxHashMap<String, GlobalArray>,
+    // Punteros a función en datos globales (vtables): (global, offset,
+    // función). Se rellenan en el stub de arranque, ver emit_code_pointers
+    code_pointers: Vec<(String, u32, String)>,
+    // alignas/__declspec(align) pedidos por el frontend (nombre → bytes)
+    global_align: FxHashMap<String, u64>,
+
+    // Field IR types — class_name → field_name → Type for float field detection
+    // (anidado para consultar con &str sin armar una clave por lookup)
+    field_ir_types: FxHashMap<String, FxHashMap<String, Type>>,
 
     // Current class being compiled (for method field type resolution)
     current_class: Option<String>,
@@ -163,6 +416,73 @@ pub struct IsaCompiler {
     // Track which IAT slots are actually used during compilation
     // Used by PE builder to only import DLLs with referenced functions
     used_iat_slots: std::collections::HashSet<usize>,
+
+    // Hilos para codegen por función (1 = serie). La salida es idéntica
+    // byte a byte sin importar el valor.
+    codegen_jobs: usize,
+
+    // Ancho SIMD permitido al vectorizador de bucles (Bits256 = AVX2)
+    bit_target: BitTarget,
+    // Decisiones del vectorizador, en orden de emisión
+    loop_reports: Vec<LoopReport>,
+
+    // Multiversioning: targets con versión propia además de `bit_target`,
+    // y las funciones que acabaron clonadas
+    target_clones: Vec<BitTarget>,
+    clones: Vec<FunctionClone>,
+
+    // -fprofile-use: conteos de una ejecución instrumentada
+    profile: Option<Profile>,
+    // Perfil de la función actual y número de site de cada if/loop de su
+    // cuerpo (clave: dirección del Stmt)
+    function_profile: Option<FunctionProfile>,
+    site_ids: FxHashMap<usize, usize>,
+    // Brazos fríos pendientes de la función actual
+    cold_blocks: Vec<ColdBlock>,
+    // La función actual emite brazos fríos tras su epílogo (perfil o
+    // heurística noreturn); no en @interrupt/@naked ni en top-level
+    split_cold: bool,
+    // Tramos de brazos fríos ya emitidos y segmento de cada función del
+    // IR, para el layout de .text previo al encode
+    cold_ranges: Vec<std::ops::Range<usize>>,
+    segments: Vec<FunctionSegment>,
+    // -mtune: list scheduling del IR completo antes del encode
+    tune: Option<Uarch>,
+    // Estadísticas del scheduler (-mtune) y tamaño por función del último
+    // `compile`, para `adB step`
+    schedule_stats: Option<OptStats>,
+    function_stats: Vec<FunctionCodeStats>,
+    // Linux: el stub de arranque es entry de proceso (lee el auxv y
+    // resuelve el vDSO antes de main, sale con exit_group)
+    process_entry: bool,
+    // Linux con entry de proceso: stdout con buffer (ver linux_stdio.rs)
+    stdout_buffer: Option<StdoutBuffer>,
+    // malloc/free propios (slab_heap.rs): siempre en Linux, opcional en Windows
+    builtin_heap: bool,
+    heap: Option<SlabHeap>,
+    // Pool con work stealing (task_pool.rs), si el programa lo usa
+    pool: Option<TaskPool>,
+    // sort/reduce/transform/for_each paralelos sobre el pool (par_algorithms.rs)
+    par: Option<ParAlgorithms>,
+    // Tabla hash plana y árbol B (flat_hash.rs, btree.rs), si se usan
+    hash: Option<FlatHash>,
+    tree: Option<BTree>,
+    // Mutex/condition_variable/atomic en línea y sus caminos lentos (sync.rs)
+    sync: Option<SyncRuntime>,
+    // Anillo de E/S asíncrona (async_io.rs)
+    aio: Option<AsyncIo>,
+    // sin/cos/exp/log/pow/sqrt/tanh AVX2 propios (vec_math.rs)
+    vec_math: Option<VecMathRuntime>,
+    // -g: un SourceLine por sentencia; símbolos y líneas tras el encode
+    debug_lines: bool,
+    debug_info: Option<DebugInfo>,
+    // Unroll e inducción a punteros antes del codegen (loop_opt.rs)
+    loop_opt: bool,
+    // Structs locales → escalares antes del codegen (sroa.rs)
+    scalar_replace: bool,
+    // Retorno de la función actual por valor y slot del puntero sret
+    return_pass: ArgPass,
+    sret_slot: Option<i32>,
 }
 
 impl IsaCompiler {
@@ -181,7 +501,7 @@ impl IsaCompiler {
         };
 
         // Initialize default class layouts based on GCC/LLVM ABI research
-        let mut class_layouts = HashMap::new();
+        let mut class_layouts = FxHashMap::default();
 
         // Counter class layout
         class_layouts.insert(
@@ -347,37 +667,176 @@ impl IsaCompiler {
 
         Self {
             ir: ADeadIR::new(),
-            strings: Vec::new(),
-            string_offsets: HashMap::new(),
-            functions: HashMap::new(),
+            strings: StringPool::new(),
+            functions: FxHashMap::default(),
+            address_taken: FxHashSet::default(),
             class_layouts,
             current_function: None,
-            variables: HashMap::new(),
-            variable_types: HashMap::new(),
-            array_vars: std::collections::HashSet::new(),
-            array_elem_sizes: HashMap::new(),
-            param_vars: std::collections::HashSet::new(),
-            struct_params: std::collections::HashSet::new(),
-            ref_vars: std::collections::HashSet::new(),
+            variables: FxHashMap::default(),
+            variable_types: FxHashMap::default(),
+            array_vars: FxHashSet::default(),
+            array_elem_sizes: FxHashMap::default(),
+            param_vars: FxHashSet::default(),
+            struct_params: FxHashSet::default(),
+            ref_vars: FxHashSet::default(),
             stack_offset: 0,
             target,
             base_address: base,
             data_rva,
             cpu_mode: CpuMode::Long64, // Default: 64-bit
-            named_labels: HashMap::new(),
-            temp_alloc: TempAllocator::new(),
+            named_labels: FxHashMap::default(),
+            temp_alloc: TempAllocator::with_regs(&EXPR_REGS),
+            reg_vars: FxHashMap::default(),
+            saved_callee_regs: Vec::new(),
+            frameless_saves: None,
+            tail_loop: None,
+            tail_calls: false,
+            frame_escapes: false,
             prologue_sub_index: None,
             loop_stack: Vec::new(),
-            goto_labels: HashMap::new(),
-            global_vars: HashMap::new(),
+            goto_labels: FxHashMap::default(),
+            global_vars: FxHashMap::default(),
             global_data: Vec::new(),
             global_offset: 0,
-            field_ir_types: HashMap::new(),
+            global_arrays: FxHashMap::default(),
+            code_pointers: Vec::new(),
+            global_align: FxHashMap::default(),
+            field_ir_types: FxHashMap::default(),
             current_class: None,
             used_iat_slots: std::collections::HashSet::new(),
+            codegen_jobs: adeb_core::parallel::default_jobs(),
+            bit_target: default_bit_target(),
+            loop_reports: Vec::new(),
+            target_clones: Vec::new(),
+            clones: Vec::new(),
+            profile: None,
+            function_profile: None,
+            site_ids: FxHashMap::default(),
+            cold_blocks: Vec::new(),
+            split_cold: false,
+            cold_ranges: Vec::new(),
+            segments: Vec::new(),
+            tune: None,
+            schedule_stats: None,
+            function_stats: Vec::new(),
+            process_entry: false,
+            stdout_buffer: None,
+            builtin_heap: false,
+            heap: None,
+            pool: None,
+            par: None,
+            hash: None,
+            tree: None,
+            sync: None,
+            aio: None,
+            vec_math: None,
+            debug_lines: false,
+            debug_info: None,
+            loop_opt: true,
+            scalar_replace: true,
+            return_pass: ArgPass::Value,
+            sret_slot: None,
+        }
+        .with_target_clones(&default_target_clones())
+    }
+
+    /// Número de hilos para compilar funciones en paralelo (1 = serie).
+    pub fn set_codegen_jobs(&mut self, jobs: usize) {
+        self.codegen_jobs = jobs.max(1);
+    }
+
+    /// Ancho SIMD para el vectorizador de bucles (`Bits256` o `BitsAuto` activan AVX2).
+    pub fn set_bit_target(&mut self, target: BitTarget) {
+        self.bit_target = target;
+    }
+
+    /// Conteos de `-fprofile-use`: branch layout y prioridad de registros.
+    pub fn set_profile(&mut self, profile: Profile) {
+        self.profile = Some(profile);
+    }
+
+    /// `-mtune`: el IR se planifica para `tune` justo antes del encode.
+    pub fn set_tune(&mut self, tune: Uarch) {
+        self.tune = Some(tune);
+    }
+
+    /// Target::Linux: el código arranca como proceso (RSP = argc, argv,
+    /// envp, auxv). Las funciones de tiempo usan el vDSO en vez de syscall
+    /// y stdout tiene buffer, vaciado antes de exit_group.
+    pub fn set_process_entry(&mut self, enabled: bool) {
+        self.process_entry = enabled;
+    }
+
+    /// `-fbuiltin-malloc`: malloc/free/calloc/realloc y new/delete usan el
+    /// heap por clases de tamaño de slab_heap.rs en vez del CRT.
+    /// Target::Linux no tiene CRT y lo usa siempre.
+    pub fn set_builtin_heap(&mut self, enabled: bool) {
+        self.builtin_heap = enabled;
+    }
+
+    /// `-g`: marca cada sentencia con su línea de fuente y, tras
+    /// `compile`, deja símbolos y tabla de líneas en `debug_info`.
+    pub fn set_debug_info(&mut self, enabled: bool) {
+        self.debug_lines = enabled;
+    }
+
+    /// Unroll de bucles y variables de inducción a punteros (loop_opt.rs).
+    /// Activo por defecto; las funciones con perfil de `-fprofile-use`
+    /// no se reescriben.
+    pub fn set_loop_opt(&mut self, enabled: bool) {
+        self.loop_opt = enabled;
+    }
+
+    /// Structs locales cuya dirección no escapa → un escalar por campo
+    /// (sroa.rs), candidatos al linear scan. Activo por defecto; como
+    /// loop_opt, no toca las funciones con perfil.
+    pub fn set_scalar_replace(&mut self, enabled: bool) {
+        self.scalar_replace = enabled;
+    }
+
+    /// Símbolos de función y tabla de líneas del último `compile` (-g)
+    pub fn debug_info(&self) -> Option<&DebugInfo> {
+        self.debug_info.as_ref()
+    }
+
+    /// Pasadas del scheduler del último `compile` (solo con `set_tune`)
+    pub fn schedule_stats(&self) -> Option<&OptStats> {
+        self.schedule_stats.as_ref()
+    }
+
+    /// Ops y bytes de cada función del último `compile`, en orden de `.text`
+    pub fn function_stats(&self) -> &[FunctionCodeStats] {
+        &self.function_stats
+    }
+
+    /// Decisiones del vectorizador de bucles (vectorizados y descartados).
+    pub fn loop_reports(&self) -> &[LoopReport] {
+        &self.loop_reports
+    }
+
+    /// Estilo `target_clones`: las funciones con bucles que solo se
+    /// vectorizan en alguno de `targets` se emiten una vez por target más la
+    /// versión base, y el stub de arranque elige por CPUID. Solo cuentan los
+    /// targets que cambian el código (hoy 256-bit: el vectorizador AVX2).
+    pub fn set_target_clones(&mut self, targets: &[BitTarget]) {
+        self.target_clones.clear();
+        for &t in targets {
+            if t.should_soa_optimize() && !self.target_clones.contains(&t) {
+                self.target_clones.push(t);
+            }
         }
     }
 
+    fn with_target_clones(mut self, targets: &[BitTarget]) -> Self {
+        self.set_target_clones(targets);
+        self
+    }
+
+    /// Nombres de las funciones emitidas en varias versiones.
+    pub fn cloned_functions(&self) -> Vec<&str> {
+        self.clones.iter().map(|c| c.name.as_str()).collect()
+    }
+
     /// Create compiler with specific CPU mode (16/32/64-bit scaling)
     pub fn with_cpu_mode(target: Target, mode: CpuMode) -> Self {
         let mut compiler = Self::new(target);
@@ -636,7 +1095,8 @@ impl IsaCompiler {
                     // Local array treated as pointer — use stored elem size
                     Some(*self.array_elem_sizes.get(name.as_str()).unwrap_or(&8))
                 } else {
-                    None
+                    // Global array decays to a pointer to its elements
+                    self.global_array_stride(name)
                 }
             }
             Expr::AddressOf(_) => Some(1), // &x produces a pointer, but stride unknown → 1
@@ -650,6 +1110,34 @@ impl IsaCompiler {
         }
     }
 
+    /// Element size behind an iterator argument (`v`, `v + n`, `&v[0]`...)
+    /// of the parallel algorithms; 8 when it cannot be told.
+    fn iter_width(&self, expr: &Expr) -> u8 {
+        match expr {
+            Expr::BinaryOp { left, .. } => self.iter_width(left),
+            Expr::AddressOf(inner) => match inner.as_ref() {
+                Expr::Index { object, .. } => self.expr_pointer_stride(object).unwrap_or(8),
+                _ => 8,
+            },
+            _ => self.expr_pointer_stride(expr).unwrap_or(8),
+        }
+    }
+
+    /// `s.f` donde `f` es un campo puntero de un struct local: tamaño
+    /// del elemento apuntado
+    fn pointer_field_stride(&self, expr: &Expr) -> Option<u8> {
+        let Expr::FieldAccess { object, field } = expr else { return None };
+        let Expr::Variable(var) = object.as_ref() else { return None };
+        let struct_name = match self.variable_types.get(var)? {
+            Type::Struct(n) | Type::Named(n) | Type::Class(n) => n,
+            _ => return None,
+        };
+        match Self::field_ir_type(&self.field_ir_types, struct_name, field)? {
+            Type::Pointer(inner) => Some(self.inner_type_size(inner)),
+            _ => None,
+        }
+    }
+
     /// Get the byte size for an inner type (used by pointer arithmetic scaling).
     fn inner_type_size(&self, ty: &Type) -> u8 {
         match ty {
@@ -673,11 +1161,20 @@ impl IsaCompiler {
         }
     }
 
+    /// Tipo IR del campo `field` de `class`, sin allocar una clave
+    fn field_ir_type<'a>(
+        field_ir_types: &'a FxHashMap<String, FxHashMap<String, Type>>,
+        class: &str,
+        field: &str,
+    ) -> Option<&'a Type> {
+        field_ir_types.get(class)?.get(field)
+    }
+
     /// Check if an expression produces a float value (for SSE codegen path)
     fn expr_is_float_full(
         expr: &Expr,
-        var_types: &HashMap<String, Type>,
-        field_ir_types: &HashMap<(String, String), Type>,
+        var_types: &FxHashMap<String, Type>,
+        field_ir_types: &FxHashMap<String, FxHashMap<String, Type>>,
         current_class: &Option<String>,
     ) -> bool {
         match expr {
@@ -696,13 +1193,9 @@ impl IsaCompiler {
                     let obj_name = &name[..dot_pos];
                     let field_name = &name[dot_pos + 1..];
                     if let Some(ty) = var_types.get(obj_name) {
-                        let class_name = match ty {
-                            Type::Struct(n) | Type::Named(n) | Type::Class(n) => Some(n.clone()),
-                            _ => None,
-                        };
-                        if let Some(cn) = class_name {
+                        if let Type::Struct(cn) | Type::Named(cn) | Type::Class(cn) = ty {
                             return matches!(
-                                field_ir_types.get(&(cn, field_name.to_string())),
+                                Self::field_ir_type(field_ir_types, cn, field_name),
                                 Some(Type::F32) | Some(Type::F64)
                             );
                         }
@@ -715,7 +1208,7 @@ impl IsaCompiler {
                 if let Expr::This = object.as_ref() {
                     if let Some(cn) = current_class {
                         return matches!(
-                            field_ir_types.get(&(cn.clone(), field.clone())),
+                            Self::field_ir_type(field_ir_types, cn, field),
                             Some(Type::F32) | Some(Type::F64)
                         );
                     }
@@ -724,20 +1217,12 @@ impl IsaCompiler {
                 if let Expr::Variable(obj_name) = object.as_ref() {
                     if let Some(ty) = var_types.get(obj_name) {
                         let class_name = match ty {
-                            Type::Struct(n) | Type::Named(n) | Type::Class(n) => Some(n.clone()),
-                            Type::Pointer(inner) => match inner.as_ref() {
-                                Type::Struct(n) | Type::Named(n) | Type::Class(n) => Some(n.clone()),
-                                _ => None,
-                            },
-                            Type::Reference(inner) => match inner.as_ref() {
-                                Type::Struct(n) | Type::Named(n) | Type::Class(n) => Some(n.clone()),
-                                _ => None,
-                            },
-                            _ => None,
+                            Type::Pointer(inner) | Type::Reference(inner) => inner.as_ref(),
+                            ty => ty,
                         };
-                        if let Some(cn) = class_name {
+                        if let Type::Struct(cn) | Type::Named(cn) | Type::Class(cn) = class_name {
                             return matches!(
-                                field_ir_types.get(&(cn, field.clone())),
+                                Self::field_ir_type(field_ir_types, cn, field),
                                 Some(Type::F32) | Some(Type::F64)
                             );
                         }
@@ -748,6 +1233,15 @@ impl IsaCompiler {
             Expr::Cast { target_type, .. } => {
                 matches!(target_type, Type::F32 | Type::F64)
             }
+            // sin/cos/... devuelven el double en RAX (vec_math.rs)
+            Expr::Call { name, .. } => MathFn::from_name(name).is_some(),
+            Expr::Index { object, .. } => match object.as_ref() {
+                Expr::Variable(name) => matches!(
+                    var_types.get(name),
+                    Some(Type::Array(inner, _) | Type::Pointer(inner)) if **inner == Type::F64
+                ),
+                _ => false,
+            },
             _ => false,
         }
     }
@@ -825,6 +1319,14 @@ impl IsaCompiler {
         }
     }
 
+    /// Stride of `name` if it is a global array not shadowed by a local
+    fn global_array_stride(&self, name: &str) -> Option<u8> {
+        if self.variables.contains_key(name) {
+            return None;
+        }
+        self.global_arrays.get(name).map(|g| g.stride)
+    }
+
     /// Emit index scaling: RAX = RAX * stride.
     /// Uses SHL for power-of-2 strides, no-op for stride 1.
     fn emit_index_scale(&mut self, stride: u8) {
@@ -862,6 +1364,14 @@ impl IsaCompiler {
         self.emit_sized_load(base_reg, 0, stride as i32);
     }
 
+    /// Desplazamiento `k*stride` de un índice constante `p[k]`, si cabe en disp32
+    fn const_index_disp(index: &Expr, stride: u8) -> Option<i32> {
+        match index {
+            Expr::Number(k) => k.checked_mul(stride as i64).and_then(|d| i32::try_from(d).ok()),
+            _ => None,
+        }
+    }
+
     /// Set CPU mode at runtime (for mode transitions)
     pub fn set_cpu_mode(&mut self, mode: CpuMode) {
         self.cpu_mode = mode;
@@ -873,7 +1383,7 @@ impl IsaCompiler {
     }
 
     /// Access class_layouts for external ISA compilers (c_isa, cpp_isa)
-    pub fn class_layouts(&self) -> &HashMap<String, ClassLayout> {
+    pub fn class_layouts(&self) -> &FxHashMap<String, ClassLayout> {
         &self.class_layouts
     }
 
@@ -929,11 +1439,9 @@ impl IsaCompiler {
                 })
                 .collect();
             // Register field IR types for float detection (always, even if layout exists)
+            let ir_types = self.field_ir_types.entry(st.name.clone()).or_default();
             for field in &st.fields {
-                self.field_ir_types.insert(
-                    (st.name.clone(), field.name.clone()),
-                    field.field_type.clone(),
-                );
+                ir_types.insert(field.name.clone(), field.field_type.clone());
             }
             // Only register layout if not already present (c_isa may have registered C99 layouts)
             if self.class_layouts.contains_key(&st.name) {
@@ -957,16 +1465,33 @@ impl IsaCompiler {
         // Fase 1: Recolectar strings (must be before global allocation so
         // string_offsets are available for string-pointer globals)
         self.collect_all_strings(program);
-        self.collect_strings_from_stmts(&program.statements);
 
         // Fase 0.5: Pre-register global variables (top-level VarDecl statements)
         // These are stored in the data section, not on any function's stack
+        self.global_align = program.attributes.global_align.clone().into_iter().collect();
         for stmt in &program.statements {
             if let Stmt::VarDecl { var_type, name, value } = stmt {
+                if let Type::Array(elem, Some(count)) = var_type {
+                    if Self::is_scalar_elem(elem) {
+                        self.alloc_global_array(name, elem, *count, value.as_ref());
+                        continue;
+                    }
+                }
+                if let Some(&align) = self.global_align.get(name) {
+                    self.align_global(align);
+                }
                 match value {
                     Some(Expr::Number(n)) => {
                         self.alloc_global(name, *n);
                     }
+                    // Constante flotante (p.ej. un constexpr ya evaluado): sus bits
+                    Some(Expr::Float(f)) => {
+                        let bits = match var_type {
+                            Type::F32 => (*f as f32).to_bits() as i64,
+                            _ => f.to_bits() as i64,
+                        };
+                        self.alloc_global(name, bits);
+                    }
                     Some(Expr::String(s)) => {
                         // String pointer global: store the address of the string in data section
                         let processed = s
@@ -985,6 +1510,9 @@ impl IsaCompiler {
 
                         if let Some(sn) = struct_name {
                             if let Some(layout) = self.class_layouts.get(&sn).cloned() {
+                                if layout.size as u64 >= CACHE_LINE {
+                                    self.align_global(CACHE_LINE);
+                                }
                                 // Serialize struct fields into global data
                                 let offset = self.global_offset;
                                 self.global_vars.insert(name.clone(), offset);
@@ -1070,22 +1598,57 @@ impl IsaCompiler {
                 self.scan_static_locals(stmt, &func.name);
             }
         }
+        // Linux: slot por función del vDSO (0 = syscall hasta resolverlo)
+        if self.target == Target::Linux && self.cpu_mode == CpuMode::Long64 {
+            for sym in linux_vdso::VDSO_SYMBOLS {
+                self.alloc_global(&linux_vdso::slot_name(sym), 0);
+            }
+        }
+        if self.target == Target::Linux && self.process_entry && program.functions.iter().any(|f| f.name == "main") {
+            self.alloc_global_bytes(linux_stdio::BUF_SLOT, &[0; linux_stdio::BUFSIZ as usize]);
+            self.alloc_global(linux_stdio::LEN_SLOT, 0);
+            self.alloc_global(linux_stdio::MODE_SLOT, linux_stdio::MODE_UNPROBED);
+        }
+        let wants_heap = (self.builtin_heap || self.target == Target::Linux)
+            && self.target != Target::Raw
+            && self.cpu_mode == CpuMode::Long64;
+        if wants_heap && Self::calls_any(program, &HEAP_FUNCTIONS) {
+            self.align_global(slab_heap::STATE_ALIGN);
+            self.alloc_global_bytes(slab_heap::STATE_SLOT, &slab_heap::initial_state());
+        }
+        if self.target != Target::Raw
+            && self.cpu_mode == CpuMode::Long64
+            && (Self::calls_any(program, &POOL_FUNCTIONS) || Self::calls_any(program, &PAR_FUNCTIONS))
+        {
+            self.align_global(task_pool::STATE_ALIGN);
+            self.alloc_global_bytes(task_pool::STATE_SLOT, &[0; task_pool::STATE_SIZE]);
+        }
 
         // Fase 2: Registrar labels de funciones
         eprintln!("[DEBUG compile] program.functions={}, names={:?}",
             program.functions.len(),
             program.functions.iter().map(|f| f.name.as_str()).collect::<Vec<_>>());
+        // Fase 2.1: ICF — instanciaciones de templates (`foldable`) con el
+        // mismo cuerpo, parámetros y tipo de retorno generan el mismo código
+        // (max<int> y max<long>): la duplicada comparte el label de la primera
+        let folded = Self::fold_identical_functions(program);
         for func in &program.functions {
-            let label = self.ir.new_label();
+            let label = match folded.get(&func.name).and_then(|rep| self.functions.get(rep)) {
+                Some(rep) => rep.label,
+                None => self.ir.new_label(),
+            };
             self.functions.insert(
                 func.name.clone(),
                 CompiledFunction {
                     name: func.name.clone(),
                     label,
                     params: func.params.iter().map(|p| p.name.clone()).collect(),
+                    param_types: func.params.iter().map(|p| p.param_type.clone()).collect(),
+                    return_type: func.resolved_return_type.clone(),
                 },
             );
         }
+        self.address_taken = self.collect_address_taken(program);
 
         // Fase 3: Determinar entry point
         // Para binarios flat (bare metal), buscar _start o kernel_main primero
@@ -1105,7 +1668,149 @@ impl IsaCompiler {
         let entry_label = self.functions.get(entry_name).map(|f| f.label);
         let needs_jmp =
             has_entry && (program.functions.len() > 1 || !program.statements.is_empty());
-        if needs_jmp {
+
+        // Fase 3.1: target_clones — un slot por candidata; el stub de arranque
+        // pasa por el resolver CPUID antes de saltar al entry
+        let resolver = if has_entry
+            && !self.target_clones.is_empty()
+            && self.target != Target::Raw
+            && self.cpu_mode == CpuMode::Long64
+        {
+            for func in &program.functions {
+                if Self::has_counted_loop(&func.body) {
+                    self.alloc_global(&clone_slot_name(&func.name), 0);
+                }
+            }
+            Some(self.ir.new_label())
+        } else {
+            None
+        };
+        let vdso_init = if has_entry && self.process_entry && self.target == Target::Linux {
+            Some(self.ir.new_label())
+        } else {
+            None
+        };
+        self.stdout_buffer = match (
+            vdso_init,
+            self.get_global_address(linux_stdio::BUF_SLOT),
+            self.get_global_address(linux_stdio::LEN_SLOT),
+            self.get_global_address(linux_stdio::MODE_SLOT),
+        ) {
+            (Some(_), Some(buf), Some(len), Some(mode)) => Some(StdoutBuffer::new(&mut self.ir, 1, buf, len, mode)),
+            _ => None,
+        };
+        self.heap = self.get_global_address(slab_heap::STATE_SLOT).map(|state| {
+            let source = match self.target {
+                Target::Windows => PageSource::Iat {
+                    alloc_rva: self.iat_rva_for("VirtualAlloc"),
+                    free_rva: self.iat_rva_for("VirtualFree"),
+                },
+                _ => PageSource::Syscall,
+            };
+            SlabHeap::new(&mut self.ir, state, source, self.target == Target::Windows)
+        });
+        self.pool = self.get_global_address(task_pool::STATE_SLOT).map(|state| {
+            let (pages, threads) = match self.target {
+                Target::Windows => (
+                    PageSource::Iat {
+                        alloc_rva: self.iat_rva_for("VirtualAlloc"),
+                        free_rva: self.iat_rva_for("VirtualFree"),
+                    },
+                    ThreadApi::Iat {
+                        create_thread: self.iat_rva_for("CreateThread"),
+                        system_info: self.iat_rva_for("GetSystemInfo"),
+                        create_semaphore: self.iat_rva_for("CreateSemaphoreA"),
+                        release_semaphore: self.iat_rva_for("ReleaseSemaphore"),
+                        wait: self.iat_rva_for("WaitForSingleObject"),
+                    },
+                ),
+                _ => (PageSource::Syscall, ThreadApi::Syscall),
+            };
+            TaskPool::new(&mut self.ir, state, pages, threads)
+        });
+        if Self::calls_any(program, &PAR_FUNCTIONS) {
+            self.par = self.pool.map(|pool| {
+                let pages = match self.target {
+                    Target::Windows => PageSource::Iat {
+                        alloc_rva: self.iat_rva_for("VirtualAlloc"),
+                        free_rva: self.iat_rva_for("VirtualFree"),
+                    },
+                    _ => PageSource::Syscall,
+                };
+                let windows = self.target == Target::Windows;
+                ParAlgorithms::new(&mut self.ir, &pool, pages, windows, self.bit_target.uses_ymm())
+            });
+        }
+        let uses_hash = Self::calls_any(program, &HASH_FUNCTIONS);
+        let uses_tree = Self::calls_any(program, &TREE_FUNCTIONS);
+        if uses_hash || uses_tree {
+            let pages = match self.target {
+                Target::Windows => PageSource::Iat {
+                    alloc_rva: self.iat_rva_for("VirtualAlloc"),
+                    free_rva: self.iat_rva_for("VirtualFree"),
+                },
+                _ => PageSource::Syscall,
+            };
+            let windows = self.target == Target::Windows;
+            if uses_hash {
+                self.hash = Some(FlatHash::new(&mut self.ir, pages, windows, self.bit_target.uses_ymm()));
+            }
+            if uses_tree {
+                self.tree = Some(BTree::new(&mut self.ir, pages, windows));
+            }
+        }
+        if self.target != Target::Raw && self.cpu_mode == CpuMode::Long64 && Self::calls_any(program, &SYNC_FUNCTIONS) {
+            let api = match self.target {
+                Target::Windows => SyncApi::Iat {
+                    acquire: self.iat_rva_for("AcquireSRWLockExclusive"),
+                    release: self.iat_rva_for("ReleaseSRWLockExclusive"),
+                    try_acquire: self.iat_rva_for("TryAcquireSRWLockExclusive"),
+                    sleep: self.iat_rva_for("SleepConditionVariableSRW"),
+                    wake: self.iat_rva_for("WakeConditionVariable"),
+                    wake_all: self.iat_rva_for("WakeAllConditionVariable"),
+                },
+                _ => SyncApi::Futex,
+            };
+            self.sync = Some(SyncRuntime::new(&mut self.ir, api));
+        }
+        if self.target != Target::Raw && self.cpu_mode == CpuMode::Long64 && Self::calls_any(program, &AIO_FUNCTIONS) {
+            let (api, pages) = match self.target {
+                Target::Windows => (
+                    AioApi::Iocp {
+                        create_port: self.iat_rva_for("CreateIoCompletionPort"),
+                        get_queued: self.iat_rva_for("GetQueuedCompletionStatusEx"),
+                        post_queued: self.iat_rva_for("PostQueuedCompletionStatus"),
+                        read_file: self.iat_rva_for("ReadFile"),
+                        write_file: self.iat_rva_for("WriteFile"),
+                        close_handle: self.iat_rva_for("CloseHandle"),
+                        get_last_error: self.iat_rva_for("GetLastError"),
+                    },
+                    PageSource::Iat {
+                        alloc_rva: self.iat_rva_for("VirtualAlloc"),
+                        free_rva: self.iat_rva_for("VirtualFree"),
+                    },
+                ),
+                _ => (AioApi::IoUring, PageSource::Syscall),
+            };
+            self.aio = Some(AsyncIo::new(&mut self.ir, api, pages));
+        }
+        // Con ymm siempre (el vectorizador las llama); sin ymm solo donde no
+        // hay CRT que importe libm, es decir fuera de Windows
+        if self.cpu_mode == CpuMode::Long64
+            && (self.bit_target.uses_ymm() || self.target != Target::Windows)
+            && Self::calls_any(program, &vec_math::MATH_FUNCTIONS)
+        {
+            self.vec_math = Some(VecMathRuntime::new(&mut self.ir));
+        }
+        if has_entry {
+            self.emit_code_pointers();
+        }
+        if let (Some(init), Some(entry)) = (vdso_init, entry_label) {
+            let at_exit = self.stdout_buffer.map(|out| out.flush);
+            linux_vdso::emit_process_start(&mut self.ir, init, resolver.unwrap_or(entry), at_exit);
+        } else if let Some(lbl) = resolver {
+            self.ir.emit(ADeadOp::Jmp { target: lbl });
+        } else if needs_jmp {
             if let Some(lbl) = entry_label {
                 self.ir.emit(ADeadOp::Jmp { target: lbl });
             }
@@ -1116,18 +1821,65 @@ impl IsaCompiler {
         // ISRs, shell commands etc. are not directly reachable from entry but needed.
         // DCE only applies to PE/ELF where unused header inlines waste space.
         let use_dce = self.target != Target::Raw;
-        let reachable = if use_dce {
+        let mut reachable: std::collections::HashSet<String> = if use_dce {
             Self::collect_reachable_functions(program, entry_name)
         } else {
             // Mark ALL functions as reachable for flat binaries
             program.functions.iter().map(|f| f.name.clone()).collect()
         };
+        // Una llamada a la duplicada ejecuta el cuerpo de la representante
+        for (dup, rep) in &folded {
+            if reachable.contains(dup) {
+                reachable.insert(rep.clone());
+            }
+        }
 
         // Fase 4: Compilar funciones auxiliares (solo las alcanzables desde entry)
-        for func in &program.functions {
-            if func.name != entry_name && reachable.contains(&func.name) {
-                self.compile_function(func);
-            }
+        // Fase 6: Compilar entry point (main, _start, o kernel_main)
+        // Con entry no hay top-level (Fase 5), así que 4 y 6 forman un solo
+        // lote que puede compilarse en paralelo.
+        let mut batch: Vec<&Function> = program
+            .functions
+            .iter()
+            .filter(|f| f.name != entry_name && reachable.contains(&f.name) && !folded.contains_key(&f.name))
+            .collect();
+        if has_entry {
+            batch.extend(program.functions.iter().filter(|f| f.name == entry_name));
+        }
+        self.compile_function_batch(&batch);
+
+        if let (Some(resolver), Some(entry)) = (resolver, entry_label) {
+            self.emit_clone_resolver(resolver, entry);
+        }
+        if let Some(init) = vdso_init {
+            self.emit_vdso_init(init);
+        }
+        if let Some(out) = self.stdout_buffer {
+            out.emit_routines(&mut self.ir);
+        }
+        if let Some(heap) = self.heap {
+            heap.emit_routines(&mut self.ir);
+        }
+        if let Some(pool) = self.pool {
+            pool.emit_routines(&mut self.ir);
+        }
+        if let Some(par) = self.par {
+            par.emit_routines(&mut self.ir);
+        }
+        if let Some(hash) = self.hash {
+            hash.emit_routines(&mut self.ir);
+        }
+        if let Some(tree) = self.tree {
+            tree.emit_routines(&mut self.ir);
+        }
+        if let Some(sync) = self.sync {
+            sync.emit_routines(&mut self.ir);
+        }
+        if let Some(aio) = self.aio {
+            aio.emit_routines(&mut self.ir);
+        }
+        if let Some(math) = self.vec_math {
+            math.emit_routines(&mut self.ir);
         }
 
         // Fase 5: Compilar top-level statements (only when no entry — script mode)
@@ -1135,16 +1887,33 @@ impl IsaCompiler {
             self.compile_top_level(&program.statements);
         }
 
-        // Fase 6: Compilar entry point (main, _start, o kernel_main)
-        for func in &program.functions {
-            if func.name == entry_name {
-                self.compile_function(func);
-            }
+        // Fase 6.5: Layout de .text — calientes por afinidad, frío al final.
+        // Solo con el jmp inicial al entry: sin él el entry debe ir primero.
+        if self.target != Target::Raw && (resolver.is_some() || vdso_init.is_some() || needs_jmp) {
+            self.layout_text(program, entry_name);
         }
 
-        // Fase 7: Encode ADeadIR → bytes
-        let mut encoder = Encoder::new();
-        let result = encoder.encode_all(self.ir.ops());
+        // Fase 6.6: Scheduling por microarquitectura (-mtune)
+        self.schedule_stats = self.tune.map(|tune| {
+            let mut scheduler = IsaOptimizer::new(IsaOptLevel::None).with_tune(tune);
+            scheduler.schedule_in_place(self.ir.ops_mut());
+            scheduler.stats().clone()
+        });
+
+        // Fase 7: Encode ADeadIR → bytes, una tanda de funciones por hilo
+        let t = adeb_core::time_report::subphase("encode");
+        let entries: std::collections::HashSet<u32> = self.functions.values().map(|f| f.label.0).collect();
+        let starts: Vec<usize> = self
+            .ir
+            .ops()
+            .iter()
+            .enumerate()
+            .filter(|(_, op)| matches!(op, ADeadOp::Label(l) if entries.contains(&l.0)))
+            .map(|(i, _)| i)
+            .collect();
+        let result = Encoder::encode_functions(self.ir.ops(), &starts, self.codegen_jobs);
+        drop(t);
+        self.function_stats = self.collect_function_stats(&starts, &result);
 
         // Fase 8: Resolver llamadas a funciones por nombre
         let code = result.code;
@@ -1160,6 +1929,19 @@ impl IsaCompiler {
             }
         }
 
+        if self.debug_lines {
+            let functions = self
+                .functions
+                .values()
+                .filter_map(|f| {
+                    let offset = *result.label_offsets.get(&f.label.0)?;
+                    let file = program.attributes.source_files.get(&f.name).cloned().unwrap_or_default();
+                    Some((f.name.clone(), file, offset))
+                })
+                .collect();
+            self.debug_info = Some(DebugInfo::build(functions, &result.source_lines, code.len()));
+        }
+
         // Fase 9: Generar sección de datos
         let data = self.generate_data_section();
 
@@ -1171,10 +1953,203 @@ impl IsaCompiler {
         )
     }
 
+    /// Un tramo por entry de función: desde su label hasta el siguiente
+    /// entry (el mismo corte que usa el encoder por hilos)
+    fn collect_function_stats(&self, starts: &[usize], result: &EncodeResult) -> Vec<FunctionCodeStats> {
+        let names: HashMap<u32, &str> = self.functions.values().map(|f| (f.label.0, f.name.as_str())).collect();
+        let ops = self.ir.ops();
+        let code_len = result.code.len();
+        let offset_of = |i: usize| match &ops[i] {
+            ADeadOp::Label(l) => result.label_offsets.get(&l.0).copied(),
+            _ => None,
+        };
+        starts
+            .iter()
+            .enumerate()
+            .filter_map(|(k, &start)| {
+                let ADeadOp::Label(label) = &ops[start] else {
+                    return None;
+                };
+                let name = names.get(&label.0)?;
+                let end = starts.get(k + 1).copied().unwrap_or(ops.len());
+                let from = offset_of(start)?;
+                let to = starts.get(k + 1).and_then(|&next| offset_of(next)).unwrap_or(code_len);
+                Some(FunctionCodeStats {
+                    name: name.to_string(),
+                    ops: end - start,
+                    bytes: to.saturating_sub(from),
+                })
+            })
+            .collect()
+    }
+
+    // ========================================
+    // Layout de .text (hot/cold + afinidad)
+    // ========================================
+
+    /// Reordena el IR ya emitido según `code_layout`. Los labels siguen
+    /// simbólicos, así que basta con mover los ops de cada segmento.
+    fn layout_text(&mut self, program: &Program, entry_name: &str) {
+        let segments = std::mem::take(&mut self.segments);
+        let index: HashMap<&str, usize> = segments
+            .iter()
+            .enumerate()
+            .map(|(i, seg)| (seg.name.as_str(), i))
+            .collect();
+
+        // (caller, callee, peso, desde un brazo frío)
+        let mut sites: Vec<(usize, usize, u64, bool)> = Vec::new();
+        for func in &program.functions {
+            let Some(&caller) = index.get(func.name.as_str()) else {
+                continue;
+            };
+            let func_profile = self.profile.as_ref().and_then(|p| p.function_for(func));
+            for (callee, weight, cold) in Self::call_sites(&func.body, func_profile) {
+                if let Some(&callee) = index.get(callee.as_str()) {
+                    if callee != caller {
+                        sites.push((caller, callee, weight, cold));
+                    }
+                }
+            }
+        }
+
+        // Fría: el perfil no la vio ejecutarse, o todas sus llamadas salen
+        // de brazos fríos o de otras funciones frías
+        let mut cold: Vec<bool> = segments
+            .iter()
+            .map(|seg| seg.name != entry_name && self.profile.as_ref().is_some_and(|p| p.is_cold(&seg.name)))
+            .collect();
+        loop {
+            let mut changed = false;
+            for (f, seg) in segments.iter().enumerate() {
+                if cold[f] || seg.name == entry_name {
+                    continue;
+                }
+                let mut incoming = sites.iter().filter(|s| s.1 == f).peekable();
+                if incoming.peek().is_some() && incoming.all(|s| s.3 || cold[s.0]) {
+                    cold[f] = true;
+                    changed = true;
+                }
+            }
+            if !changed {
+                break;
+            }
+        }
+
+        let edges: Vec<CallEdge> = sites
+            .iter()
+            .filter(|s| !s.3)
+            .map(|&(caller, callee, weight, _)| CallEdge { caller, callee, weight })
+            .collect();
+        let order = code_layout::affinity_order(segments.len(), &edges, index.get(entry_name).copied(), &cold);
+        code_layout::apply(self.ir.ops_mut(), &segments, &order, &cold);
+    }
+
+    /// Llamadas de `body` con su peso y si salen de un brazo frío. Con
+    /// perfil el peso es la frecuencia del site más interno (como
+    /// `range_weight`); sin él, LOOP_WEIGHT por nivel de loop.
+    fn call_sites(body: &[Stmt], func_profile: Option<&FunctionProfile>) -> Vec<(String, u64, bool)> {
+        let site_ids: HashMap<usize, usize> = match func_profile {
+            Some(_) => profile::site_stmts(body)
+                .into_iter()
+                .enumerate()
+                .map(|(k, stmt)| (stmt as *const Stmt as usize, k))
+                .collect(),
+            None => HashMap::new(),
+        };
+        let mut out = Vec::new();
+        let entry = func_profile.map_or(1, |p| p.entry);
+        Self::walk_call_sites(body, func_profile, &site_ids, entry, false, &mut out);
+        out
+    }
+
+    fn walk_call_sites(
+        stmts: &[Stmt],
+        func_profile: Option<&FunctionProfile>,
+        site_ids: &HashMap<usize, usize>,
+        weight: u64,
+        cold: bool,
+        out: &mut Vec<(String, u64, bool)>,
+    ) {
+        for stmt in stmts {
+            let count = site_ids
+                .get(&(stmt as *const Stmt as usize))
+                .and_then(|&k| func_profile?.site(k).copied());
+            let inner = match (func_profile, count) {
+                (Some(_), Some(c)) => c.frequency(),
+                (None, _) if matches!(stmt, Stmt::While { .. } | Stmt::DoWhile { .. } | Stmt::For { .. } | Stmt::ForEach { .. }) => {
+                    weight.saturating_mul(code_layout::LOOP_WEIGHT)
+                }
+                _ => weight,
+            };
+            let mut calls = Vec::new();
+            let walk = |body: &[Stmt], cold: bool, out: &mut Vec<(String, u64, bool)>| {
+                Self::walk_call_sites(body, func_profile, site_ids, inner, cold, out)
+            };
+            match stmt {
+                Stmt::If { condition, then_body, else_body } => {
+                    Self::collect_calls_from_expr_dce(condition, &mut calls);
+                    let arm = count
+                        .and_then(|c| c.cold_arm())
+                        .or_else(|| code_layout::noreturn_arm(then_body, else_body.as_deref()));
+                    walk(then_body, cold || arm == Some(true), out);
+                    if let Some(else_stmts) = else_body {
+                        walk(else_stmts, cold || arm == Some(false), out);
+                    }
+                }
+                Stmt::While { condition, body } | Stmt::DoWhile { body, condition } => {
+                    Self::collect_calls_from_expr_dce(condition, &mut calls);
+                    walk(body, cold, out);
+                }
+                Stmt::For { start, end, body, .. } => {
+                    Self::collect_calls_from_expr_dce(start, &mut calls);
+                    Self::collect_calls_from_expr_dce(end, &mut calls);
+                    walk(body, cold, out);
+                }
+                Stmt::ForEach { iterable, body, .. } => {
+                    Self::collect_calls_from_expr_dce(iterable, &mut calls);
+                    walk(body, cold, out);
+                }
+                Stmt::Switch { expr, cases, default } => {
+                    Self::collect_calls_from_expr_dce(expr, &mut calls);
+                    for case in cases {
+                        walk(&case.body, cold, out);
+                    }
+                    if let Some(d) = default {
+                        walk(d, cold, out);
+                    }
+                }
+                _ => Self::collect_calls_from_stmt(stmt, &mut calls),
+            }
+            out.extend(calls.into_iter().map(|callee| (callee, inner, cold)));
+        }
+    }
+
     // ========================================
     // Dead Code Elimination — Reachability Analysis
     // ========================================
 
+    /// Identical code folding: duplicada → representante, para las funciones
+    /// `foldable` cuyo (params, retorno, cuerpo) coincide. El nombre no entra
+    /// en la huella; la primera en orden de programa es la representante.
+    fn fold_identical_functions(program: &Program) -> HashMap<String, String> {
+        let mut seen: HashMap<String, &str> = HashMap::new();
+        let mut folded = HashMap::new();
+        for func in program.functions.iter().filter(|f| f.attributes.foldable) {
+            let print = format!("{:?}|{:?}|{:?}", func.params, func.resolved_return_type, func.body);
+            match seen.get(&print) {
+                Some(rep) if *rep != func.name => {
+                    folded.insert(func.name.clone(), rep.to_string());
+                }
+                Some(_) => {}
+                None => {
+                    seen.insert(print, &func.name);
+                }
+            }
+        }
+        folded
+    }
+
     /// Collect all function names transitively reachable from the entry point.
     /// This prevents unused header inline functions from inflating the code section.
     fn collect_reachable_functions(program: &Program, entry_name: &str) -> std::collections::HashSet<String> {
@@ -1186,6 +2161,12 @@ impl IsaCompiler {
             .map(|f| (f.name.as_str(), f))
             .collect();
 
+        // Functions used from top-level statements (e.g. vtable entries) are
+        // roots like the entry, so their own callees are reachable too
+        let mut top_calls = Vec::new();
+        Self::collect_calls_from_stmts(&program.statements, &mut top_calls);
+        worklist.extend(top_calls.into_iter().filter(|c| func_map.contains_key(c.as_str())));
+
         while let Some(name) = worklist.pop() {
             if reachable.contains(&name) {
                 continue;
@@ -1202,15 +2183,6 @@ impl IsaCompiler {
                 }
             }
         }
-        // Also include functions called from top-level statements
-        let mut top_calls = Vec::new();
-        Self::collect_calls_from_stmts(&program.statements, &mut top_calls);
-        for callee in top_calls {
-            if !reachable.contains(&callee) && func_map.contains_key(callee.as_str()) {
-                worklist.push(callee.clone());
-                reachable.insert(callee);
-            }
-        }
         reachable
     }
 
@@ -1269,20 +2241,34 @@ impl IsaCompiler {
                 Self::collect_calls_from_expr_dce(object, calls);
                 Self::collect_calls_from_expr_dce(value, calls);
             }
-            Stmt::Print(e) | Stmt::Println(e) | Stmt::PrintNum(e) | Stmt::Free(e) => {
+            Stmt::Print(e) | Stmt::Println(e) | Stmt::PrintNum(e) => {
+                Self::collect_calls_from_expr_dce(e, calls);
+            }
+            Stmt::Free(e) => {
+                calls.push("free".to_string());
                 Self::collect_calls_from_expr_dce(e, calls);
             }
             _ => {}
         }
     }
 
+    /// Alguna función (o el top-level) llama a una de `names`
+    fn calls_any(program: &Program, names: &[&str]) -> bool {
+        let mut calls = Vec::new();
+        for func in &program.functions {
+            Self::collect_calls_from_stmts(&func.body, &mut calls);
+        }
+        Self::collect_calls_from_stmts(&program.statements, &mut calls);
+        calls.iter().any(|c| names.contains(&c.as_str()))
+    }
+
     fn collect_calls_from_expr_dce(expr: &Expr, calls: &mut Vec<String>) {
         match expr {
             Expr::Call { name, args } => {
                 calls.push(name.clone());
                 for a in args { Self::collect_calls_from_expr_dce(a, calls); }
             }
-            Expr::MethodCall { object, args, .. } => {
+            Expr::MethodCall { object, args, .. } | Expr::VirtualCall { object, args, .. } => {
                 Self::collect_calls_from_expr_dce(object, calls);
                 for a in args { Self::collect_calls_from_expr_dce(a, calls); }
             }
@@ -1295,7 +2281,12 @@ impl IsaCompiler {
             | Expr::Cast { expr, .. } | Expr::IntCast(expr) | Expr::FloatCast(expr)
             | Expr::PreIncrement(expr) | Expr::PreDecrement(expr)
             | Expr::PostIncrement(expr) | Expr::PostDecrement(expr)
-            | Expr::BitwiseNot(expr) | Expr::Malloc(expr) => {
+            | Expr::BitwiseNot(expr) => {
+                Self::collect_calls_from_expr_dce(expr, calls);
+            }
+            // Los builtins del heap cuentan como llamadas (ver `calls_any`)
+            Expr::Malloc(expr) => {
+                calls.push("malloc".to_string());
                 Self::collect_calls_from_expr_dce(expr, calls);
             }
             Expr::Index { object, index } => {
@@ -1313,6 +2304,7 @@ impl IsaCompiler {
                 for e in elems { Self::collect_calls_from_expr_dce(e, calls); }
             }
             Expr::Realloc { ptr, new_size } => {
+                calls.push("realloc".to_string());
                 Self::collect_calls_from_expr_dce(ptr, calls);
                 Self::collect_calls_from_expr_dce(new_size, calls);
             }
@@ -1322,6 +2314,7 @@ impl IsaCompiler {
                 }
             }
             Expr::New { args, .. } => {
+                calls.push("malloc".to_string());
                 for a in args { Self::collect_calls_from_expr_dce(a, calls); }
             }
             Expr::Variable(name) => {
@@ -1338,20 +2331,23 @@ impl IsaCompiler {
     // ========================================
 
     fn collect_all_strings(&mut self, program: &Program) {
-        self.strings.push("%d".to_string());
-        self.strings.push("%s".to_string());
-        self.strings.push("%.2f".to_string());
-        self.strings.push("\n".to_string());
+        self.strings.add("%d".to_string());
+        self.strings.add("%s".to_string());
+        self.strings.add("%.2f".to_string());
+        self.strings.add("\n".to_string());
 
         for func in &program.functions {
             self.collect_strings_from_stmts(&func.body);
         }
-
-        let mut offset = 0u64;
-        for s in &self.strings {
-            self.string_offsets.insert(s.clone(), offset);
-            offset += s.len() as u64 + 1;
+        self.collect_strings_from_stmts(&program.statements);
+        if self.target == Target::Linux && self.process_entry {
+            for sym in linux_vdso::VDSO_SYMBOLS {
+                self.strings.add(sym.vdso_name.to_string());
+            }
         }
+
+        // Todas las direcciones de strings se fijan aquí, con tail merging
+        self.strings.layout();
     }
 
     fn collect_strings_from_expr(&mut self, expr: &Expr) {
@@ -1361,9 +2357,7 @@ impl IsaCompiler {
                     .replace("\\n", "\n")
                     .replace("\\t", "\t")
                     .replace("\\r", "\r");
-                if !self.strings.contains(&processed) {
-                    self.strings.push(processed);
-                }
+                self.strings.add(processed);
             }
             Expr::BinaryOp { left, right, .. } => {
                 self.collect_strings_from_expr(left);
@@ -1390,7 +2384,7 @@ impl IsaCompiler {
                 self.collect_strings_from_expr(then_expr);
                 self.collect_strings_from_expr(else_expr);
             }
-            Expr::MethodCall { object, args, .. } => {
+            Expr::MethodCall { object, args, .. } | Expr::VirtualCall { object, args, .. } => {
                 self.collect_strings_from_expr(object);
                 for arg in args {
                     self.collect_strings_from_expr(arg);
@@ -1450,6 +2444,15 @@ impl IsaCompiler {
                     self.collect_strings_from_stmts(body);
                     self.collect_strings_from_expr(condition);
                 }
+                Stmt::Switch { expr, cases, default } => {
+                    self.collect_strings_from_expr(expr);
+                    for case in cases {
+                        self.collect_strings_from_stmts(&case.body);
+                    }
+                    if let Some(body) = default {
+                        self.collect_strings_from_stmts(body);
+                    }
+                }
                 Stmt::For {
                     start, end, body, ..
                 } => {
@@ -1493,35 +2496,124 @@ impl IsaCompiler {
     }
 
     fn generate_data_section(&self) -> Vec<u8> {
-        let mut data = Vec::new();
-        for s in &self.strings {
-            data.extend_from_slice(s.as_bytes());
-            data.push(0);
-        }
+        let mut data = self.strings.bytes().to_vec();
         // Append global variable data after strings
         if !self.global_data.is_empty() {
-            // Align to 8 bytes
-            while data.len() % 8 != 0 {
-                data.push(0);
-            }
             // The global_vars offsets are relative to this point
+            data.resize(self.globals_offset() as usize, 0);
             data.extend_from_slice(&self.global_data);
         }
         data
     }
 
+    /// Offset (desde data_rva) donde empiezan los globals: tras los strings, alineado a 8
+    fn globals_offset(&self) -> u64 {
+        (self.strings.size() + 7) & !7
+    }
+
+    /// Rellena global_data hasta que el próximo global quede en una
+    /// dirección absoluta múltiplo de `align` (tablas de 64+ bytes en
+    /// su propia línea de caché)
+    fn align_global(&mut self, align: u64) {
+        let next = self.base_address + self.data_rva + self.globals_offset() + self.global_offset as u64;
+        let pad = ((next + align - 1) & !(align - 1)) - next;
+        self.global_data.resize(self.global_data.len() + pad as usize, 0);
+        self.global_offset += pad as u32;
+    }
+
+    /// Elementos que un array global guarda en línea (no structs ni arrays anidados)
+    fn is_scalar_elem(elem: &Type) -> bool {
+        matches!(
+            elem,
+            Type::I8 | Type::I16 | Type::I32 | Type::I64 | Type::U8 | Type::U16 | Type::U32 | Type::U64
+                | Type::F32 | Type::F64 | Type::Bool | Type::Pointer(_)
+        )
+    }
+
+    /// Alineación de un array global: la de alignas si la hay; el ancho
+    /// vectorial resuelto (BitTarget y target_clones) si el array llena
+    /// al menos un vector; línea de caché propia si ocupa 64+ bytes.
+    fn global_array_alignment(&self, name: &str, size: u64) -> u64 {
+        let simd = std::iter::once(self.bit_target)
+            .chain(self.target_clones.iter().copied())
+            .map(|t| t.data_alignment() as u64)
+            .max()
+            .unwrap_or(8);
+        let mut align = 8;
+        if size >= simd {
+            align = simd;
+        }
+        if size >= CACHE_LINE {
+            align = align.max(CACHE_LINE);
+        }
+        self.global_align.get(name).map_or(align, |&a| a.max(align))
+    }
+
+    /// Reserva `count` elementos para un array global y copia el inicializador
+    fn alloc_global_array(&mut self, name: &str, elem: &Type, count: usize, init: Option<&Expr>) {
+        let stride = self.inner_type_size(elem) as usize;
+        let size = stride * count;
+        let align = self.global_array_alignment(name, size as u64);
+        self.align_global(align);
+
+        let offset = self.global_offset;
+        self.global_vars.insert(name.to_string(), offset);
+        let base = self.global_data.len();
+        let alloc = (size + 7) & !7;
+        self.global_data.resize(base + alloc, 0);
+        self.global_offset += alloc as u32;
+
+        match init {
+            Some(Expr::Array(elements)) => {
+                for (i, e) in elements.iter().take(count).enumerate() {
+                    let bits = match (e, elem) {
+                        (Expr::Number(n), Type::F32) => (*n as f32).to_bits() as u64,
+                        (Expr::Number(n), Type::F64) => (*n as f64).to_bits(),
+                        (Expr::Float(f), Type::F32) => (*f as f32).to_bits() as u64,
+                        (Expr::Float(f), Type::F64) => f.to_bits(),
+                        (Expr::Number(n), _) => *n as u64,
+                        (Expr::Variable(func), Type::Pointer(_)) => {
+                            self.code_pointers.push((name.to_string(), (i * stride) as u32, func.clone()));
+                            continue;
+                        }
+                        _ => continue,
+                    };
+                    let at = base + i * stride;
+                    self.global_data[at..at + stride].copy_from_slice(&bits.to_le_bytes()[..stride]);
+                }
+            }
+            Some(Expr::String(text)) if stride == 1 => {
+                let n = text.len().min(count);
+                self.global_data[base..base + n].copy_from_slice(&text.as_bytes()[..n]);
+            }
+            _ => {}
+        }
+        self.global_arrays.insert(
+            name.to_string(),
+            GlobalArray { stride: stride as u8, elem: elem.clone(), align },
+        );
+    }
+
     /// Calculate the absolute address of a global variable
     fn get_global_address(&self, name: &str) -> Option<u64> {
         if let Some(&offset) = self.global_vars.get(name) {
-            // Global data starts after strings (aligned to 8)
-            let strings_size: u64 = self.strings.iter().map(|s| s.len() as u64 + 1).sum();
-            let aligned_strings = (strings_size + 7) & !7;
-            Some(self.base_address + self.data_rva + aligned_strings + offset as u64)
+            Some(self.base_address + self.data_rva + self.globals_offset() + offset as u64)
         } else {
             None
         }
     }
 
+    /// Global holding `init` (padded to 8 bytes)
+    fn alloc_global_bytes(&mut self, name: &str, init: &[u8]) -> u32 {
+        let offset = self.global_offset;
+        self.global_vars.insert(name.to_string(), offset);
+        let alloc = (init.len() + 7) & !7;
+        self.global_data.extend_from_slice(init);
+        self.global_data.resize(self.global_data.len() + alloc - init.len(), 0);
+        self.global_offset += alloc as u32;
+        offset
+    }
+
     /// Allocate a global variable slot and return its offset
     fn alloc_global(&mut self, name: &str, init_value: i64) -> u32 {
         let offset = self.global_offset;
@@ -1583,7 +2675,7 @@ impl IsaCompiler {
     }
 
     fn get_string_address(&self, s: &str) -> u64 {
-        if let Some(&offset) = self.string_offsets.get(s) {
+        if let Some(offset) = self.strings.offset(s) {
             self.base_address + self.data_rva + offset
         } else {
             self.base_address + self.data_rva
@@ -1594,7 +2686,279 @@ impl IsaCompiler {
     // Compilación de funciones
     // ========================================
 
+    // ========================================
+    // Parallel per-function codegen
+    // ========================================
+
+    /// Compila un lote de funciones en orden. Con `codegen_jobs > 1` cada
+    /// función se baja a su propio ADeadIR en un worker y los buffers se
+    /// concatenan en el orden del lote — mismo resultado que en serie.
+    fn compile_function_batch(&mut self, funcs: &[&Function]) {
+        let parallel = self.codegen_jobs > 1
+            && funcs.len() >= PARALLEL_CODEGEN_MIN_FUNCTIONS
+            && self.target != Target::Raw;
+        if !parallel {
+            for func in funcs {
+                self.compile_function(func);
+            }
+            return;
+        }
+
+        let label_base = self.ir.label_count();
+        let this: &IsaCompiler = self;
+        let results = adeb_core::parallel::par_map_with(
+            funcs,
+            self.codegen_jobs,
+            || this.fork_worker(),
+            |worker, _, func| worker.compile_function_isolated(this, func, label_base),
+        );
+
+        if results.iter().any(|r| !r.isolated) {
+            // Alguna función depende del orden serial (p.ej. añadió strings
+            // que desplazan las direcciones de globals) — recompilar en serie.
+            for func in funcs {
+                self.compile_function(func);
+            }
+            return;
+        }
+
+        for code in results {
+            self.merge_function_code(code);
+        }
+    }
+
+    /// Copia del estado de solo-lectura necesario para compilar funciones.
+    /// El estado por función se reinicia en `compile_function`.
+    fn fork_worker(&self) -> IsaCompiler {
+        IsaCompiler {
+            ir: ADeadIR::new(),
+            strings: self.strings.clone(),
+            functions: self.functions.clone(),
+            address_taken: self.address_taken.clone(),
+            class_layouts: self.class_layouts.clone(),
+            current_function: None,
+            variables: FxHashMap::default(),
+            variable_types: FxHashMap::default(),
+            array_vars: FxHashSet::default(),
+            array_elem_sizes: FxHashMap::default(),
+            param_vars: FxHashSet::default(),
+            struct_params: FxHashSet::default(),
+            ref_vars: FxHashSet::default(),
+            stack_offset: 0,
+            target: self.target,
+            base_address: self.base_address,
+            data_rva: self.data_rva,
+            cpu_mode: self.cpu_mode,
+            named_labels: FxHashMap::default(),
+            temp_alloc: TempAllocator::with_regs(&EXPR_REGS),
+            reg_vars: FxHashMap::default(),
+            saved_callee_regs: Vec::new(),
+            frameless_saves: None,
+            tail_loop: None,
+            tail_calls: false,
+            frame_escapes: false,
+            prologue_sub_index: None,
+            loop_stack: Vec::new(),
+            goto_labels: FxHashMap::default(),
+            global_vars: self.global_vars.clone(),
+            global_data: self.global_data.clone(),
+            global_offset: self.global_offset,
+            global_arrays: self.global_arrays.clone(),
+            code_pointers: Vec::new(),
+            global_align: self.global_align.clone(),
+            field_ir_types: self.field_ir_types.clone(),
+            current_class: None,
+            used_iat_slots: std::collections::HashSet::new(),
+            codegen_jobs: 1,
+            bit_target: self.bit_target,
+            loop_reports: Vec::new(),
+            target_clones: self.target_clones.clone(),
+            clones: Vec::new(),
+            profile: self.profile.clone(),
+            function_profile: None,
+            site_ids: FxHashMap::default(),
+            cold_blocks: Vec::new(),
+            split_cold: false,
+            cold_ranges: Vec::new(),
+            segments: Vec::new(),
+            tune: self.tune,
+            schedule_stats: None,
+            function_stats: Vec::new(),
+            process_entry: false,
+            stdout_buffer: self.stdout_buffer,
+            builtin_heap: self.builtin_heap,
+            heap: self.heap,
+            pool: self.pool,
+            par: self.par,
+            hash: self.hash,
+            tree: self.tree,
+            sync: self.sync,
+            aio: self.aio,
+            vec_math: self.vec_math,
+            debug_lines: self.debug_lines,
+            debug_info: None,
+            loop_opt: self.loop_opt,
+            scalar_replace: self.scalar_replace,
+            return_pass: ArgPass::Value,
+            sret_slot: None,
+        }
+    }
+
+    /// Compila `func` en este worker sobre un ADeadIR propio.
+    fn compile_function_isolated(
+        &mut self,
+        main: &IsaCompiler,
+        func: &Function,
+        label_base: u32,
+    ) -> FunctionCode {
+        self.ir = ADeadIR::with_label_base(label_base);
+        self.named_labels = main.named_labels.clone();
+        self.used_iat_slots.clear();
+        self.loop_reports.clear();
+        self.clones.clear();
+        self.segments.clear();
+        self.strings.truncate(main.strings.len());
+        self.base_address = main.base_address;
+        self.cpu_mode = main.cpu_mode;
+
+        self.compile_function(func);
+
+        let isolated = self.strings.len() == main.strings.len()
+            && self.base_address == main.base_address
+            && self.cpu_mode == main.cpu_mode;
+        let mut new_named_labels: Vec<(String, Label)> = self
+            .named_labels
+            .iter()
+            .filter(|(_, l)| l.0 >= label_base)
+            .map(|(n, l)| (n.clone(), *l))
+            .collect();
+        new_named_labels.sort_by_key(|(_, l)| l.0);
+        let mut iat_slots: Vec<usize> = self.used_iat_slots.iter().copied().collect();
+        iat_slots.sort_unstable();
+
+        let ir = std::mem::take(&mut self.ir);
+        FunctionCode {
+            label_end: ir.label_count(),
+            ops: ir.into_ops(),
+            label_base,
+            new_named_labels,
+            iat_slots,
+            loop_reports: std::mem::take(&mut self.loop_reports),
+            clones: std::mem::take(&mut self.clones),
+            segment: self.segments.pop(),
+            isolated,
+        }
+    }
+
+    /// Añade el código de un worker al IR principal, renumerando sus labels
+    /// locales. Los named labels se unifican por nombre igual que en serie.
+    fn merge_function_code(&mut self, code: FunctionCode) {
+        let base = code.label_base;
+        let mut remap: Vec<Option<Label>> = vec![None; (code.label_end - base) as usize];
+        for (name, local) in code.new_named_labels {
+            let global = match self.named_labels.get(&name) {
+                Some(&l) => l,
+                None => {
+                    let l = self.ir.new_label();
+                    self.named_labels.insert(name, l);
+                    l
+                }
+            };
+            remap[(local.0 - base) as usize] = Some(global);
+        }
+        let ir = &mut self.ir;
+        let mut map = |l: Label| -> Label {
+            if l.0 < base {
+                return l;
+            }
+            let slot = &mut remap[(l.0 - base) as usize];
+            *slot.get_or_insert_with(|| ir.new_label())
+        };
+        let mut ops = code.ops;
+        for op in &mut ops {
+            op.map_labels(&mut map);
+        }
+        let mut clones = code.clones;
+        for clone in &mut clones {
+            clone.default = map(clone.default);
+            for (_, label) in &mut clone.variants {
+                *label = map(*label);
+            }
+        }
+        let offset = self.ir.ops().len();
+        self.ir.ops_mut().extend(ops);
+        self.segments.extend(code.segment.map(|seg| seg.shifted(offset)));
+        self.used_iat_slots.extend(code.iat_slots);
+        self.loop_reports.extend(code.loop_reports);
+        self.clones.extend(clones);
+    }
+
+    /// Compila `func` (con sus clones) y anota su segmento para el layout
     fn compile_function(&mut self, func: &Function) {
+        let start = self.ir.ops().len();
+        self.cold_ranges.clear();
+        self.compile_function_versions(func);
+        self.segments.push(FunctionSegment {
+            name: func.name.clone(),
+            ops: start..self.ir.ops().len(),
+            cold: std::mem::take(&mut self.cold_ranges),
+        });
+    }
+
+    fn compile_function_versions(&mut self, func: &Function) {
+        let _span = adeb_core::time_report::span(adeb_core::time_report::FUNCTION, || func.name.clone());
+        let label = self.functions.get(&func.name).map(|f| f.label);
+        let slot = clone_slot_name(&func.name);
+        let attrs = &func.attributes;
+        let clonable = label.is_some()
+            && self.global_vars.contains_key(&slot)
+            && !(attrs.is_interrupt || attrs.is_exception || attrs.is_naked);
+        if !clonable {
+            self.compile_function_at(func, label);
+            return;
+        }
+
+        let first_op = self.ir.ops().len();
+        let first_report = self.loop_reports.len();
+        let named = self.named_labels.len();
+        self.compile_function_at(func, label);
+        // Solo vale la pena si algún bucle se vectoriza en un target más ancho;
+        // con labels nombrados (goto/asm) una segunda copia los duplicaría
+        let hot = self.loop_reports[first_report..]
+            .iter()
+            .any(|r| r.skipped == Some(SoaSkipReason::TargetTooNarrow));
+        if !hot || self.named_labels.len() != named {
+            return;
+        }
+
+        // La versión base pasa a un label propio; el público queda de thunk
+        let default = self.ir.new_label();
+        self.ir.ops_mut()[first_op] = ADeadOp::Label(default);
+        self.ir.emit(ADeadOp::Label(label.unwrap()));
+        self.emit_clone_thunk(&slot);
+
+        let base_target = self.bit_target;
+        let mut variants = Vec::new();
+        for target in self.target_clones.clone() {
+            let variant = self.ir.new_label();
+            let reports = self.loop_reports.len();
+            self.bit_target = target;
+            self.compile_function_at(func, Some(variant));
+            for report in &mut self.loop_reports[reports..] {
+                report.function = format!("{}@{}", func.name, target.register_width());
+            }
+            variants.push((target, variant));
+        }
+        self.bit_target = base_target;
+        self.clones.push(FunctionClone {
+            name: func.name.clone(),
+            default,
+            variants,
+        });
+    }
+
+    /// Emite `func` con `label` como punto de entrada
+    fn compile_function_at(&mut self, func: &Function, label: Option<Label>) {
         self.current_function = Some(func.name.clone());
         self.variables.clear();
         self.variable_types.clear();
@@ -1605,9 +2969,14 @@ impl IsaCompiler {
             None
         };
         self.array_vars.clear();
+        self.array_elem_sizes.clear();
         self.param_vars.clear();
         self.struct_params.clear();
         self.ref_vars.clear();
+        self.reg_vars.clear();
+        self.saved_callee_regs.clear();
+        self.return_pass = ArgPass::Value;
+        self.sret_slot = None;
         // Start at -32 because prologue pushes 4 callee-saved regs after mov rbp,rsp
         // occupying [rbp-8], [rbp-16], [rbp-24], [rbp-32]
         // With decrement-first convention, first var will be at -40
@@ -1618,11 +2987,33 @@ impl IsaCompiler {
         let is_naked = func.attributes.is_naked;
 
         // Label de entrada
-        if let Some(compiled) = self.functions.get(&func.name) {
-            let label = compiled.label;
+        if let Some(label) = label {
             self.ir.emit(ADeadOp::Label(label));
         }
 
+        if !is_interrupt && !is_exception && !is_naked {
+            self.load_function_profile(func);
+        }
+
+        // Con perfil los sites apuntan al cuerpo original: no se reescribe
+        let rewrite = self.function_profile.is_none() && !is_interrupt && !is_exception && !is_naked;
+        let replaced = if self.scalar_replace && rewrite {
+            sroa::scalar_replace(func, |name| self.sra_fields(name))
+        } else {
+            None
+        };
+        let func = replaced.as_ref().unwrap_or(func);
+        let rewritten = if self.loop_opt && rewrite { loop_opt::optimize_function(func) } else { None };
+        let func = rewritten.as_ref().unwrap_or(func);
+
+        // Hoja con todo en registros: sin push rbp / sub rsp
+        if !is_interrupt && !is_exception && !is_naked && self.compile_frameless_leaf(func) {
+            self.function_profile = None;
+            self.split_cold = false;
+            self.current_function = None;
+            return;
+        }
+
         if is_interrupt || is_exception {
             // @interrupt / @exception: push all registers (auto-generated wrapper)
             self.emit_interrupt_prologue();
@@ -1630,8 +3021,37 @@ impl IsaCompiler {
             // Normal function prologue
             self.emit_prologue();
 
-            // Register and save parameters (MSVC x64: RCX, RDX, R8, R9)
-            for (i, param) in func.params.iter().enumerate() {
+            // Register and save parameters (MSVC x64: RCX, RDX, R8, R9;
+            // Target::Linux takes the first four from RDI, RSI, RDX, RCX).
+            // Con structs por valor (struct_abi.rs) cada argumento ocupa
+            // uno o más slots: el puntero sret va en el primero y un
+            // struct Regs se rehace en un local con sus eightbytes
+            let by_value = self.call_abi(&func.name, func.params.len());
+            let passes = match &by_value {
+                Some((passes, ret)) => {
+                    self.return_pass = *ret;
+                    passes.clone()
+                }
+                None => vec![ArgPass::Value; func.params.len()],
+            };
+            let mut slot = 0;
+            if let ArgPass::Copy(_) = self.return_pass {
+                self.stack_offset -= 8;
+                let src = self.arg_register(0);
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Mem { base: Reg::RBP, disp: self.stack_offset },
+                    src: Operand::Reg(src),
+                });
+                self.sret_slot = Some(self.stack_offset);
+                slot = 1;
+            }
+            for (param, &pass) in func.params.iter().zip(&passes) {
+                if let ArgPass::Regs(words) = pass {
+                    self.emit_struct_param(param, words, &mut slot);
+                    continue;
+                }
+                let i = slot;
+                slot += 1;
                 let param_offset = if i <= 3 {
                     self.stack_offset -= 8;
                     let off = self.stack_offset;
@@ -1645,12 +3065,7 @@ impl IsaCompiler {
 
                 // Save register params to stack
                 if i <= 3 {
-                    let src_reg = match i {
-                        0 => Reg::RCX,
-                        1 => Reg::RDX,
-                        2 => Reg::R8,
-                        _ => Reg::R9,
-                    };
+                    let src_reg = self.arg_register(i);
                     self.ir.emit(ADeadOp::Mov {
                         dst: Operand::Mem {
                             base: Reg::RBP,
@@ -1672,6 +3087,23 @@ impl IsaCompiler {
                     self.ref_vars.insert(param.name.clone());
                 }
             }
+
+            // Hot scalar locals → callee-saved registers
+            self.assign_local_registers(&func.body);
+
+            // Recursión de cola: `return f(...)` reescribe los parámetros
+            // y salta aquí, reutilizando el frame
+            self.tail_calls = true;
+            self.frame_escapes = liveness::frame_escapes(&func.body);
+            let plain_params = by_value.is_none()
+                && func.params.iter().all(|p| {
+                    !self.struct_params.contains(&p.name) && !self.ref_vars.contains(&p.name)
+                });
+            if plain_params && !self.frame_escapes {
+                let body_start = self.ir.new_label();
+                self.ir.emit(ADeadOp::Label(body_start));
+                self.tail_loop = Some(body_start);
+            }
         }
         // @naked: no prologue at all
 
@@ -1684,12 +3116,21 @@ impl IsaCompiler {
             // @interrupt / @exception: pop all registers + iretq
             self.emit_interrupt_epilogue();
         } else if !is_naked {
-            // Patch prologue with actual stack frame size
-            self.patch_prologue();
             // Normal function epilogue
             self.emit_epilogue();
+            // Brazos fríos detrás del ret (pueden declarar locales)
+            self.emit_cold_blocks();
+            // Patch prologue with actual stack frame size
+            self.patch_prologue();
         }
         // @naked: no epilogue at all
+        self.tail_calls = false;
+        self.frame_escapes = false;
+        self.tail_loop = None;
+        self.function_profile = None;
+        self.split_cold = false;
+        self.return_pass = ArgPass::Value;
+        self.sret_slot = None;
 
         self.current_function = None;
     }
@@ -1700,6 +3141,8 @@ impl IsaCompiler {
         self.variable_types.clear();
         self.array_vars.clear();
         self.param_vars.clear();
+        self.reg_vars.clear();
+        self.saved_callee_regs.clear();
         // Start at -32 because prologue pushes 4 callee-saved regs after mov rbp,rsp
         // With decrement-first convention, first var will be at -40
         self.stack_offset = -32;
@@ -1756,7 +3199,7 @@ impl IsaCompiler {
             src: Operand::Imm32(0), // placeholder — patched in patch_prologue()
         });
         // Reset temp allocator for this function
-        self.temp_alloc = TempAllocator::new();
+        self.temp_alloc = TempAllocator::with_regs(&EXPR_REGS);
     }
 
     /// Patch the prologue's sub rsp with the actual stack frame size
@@ -1785,6 +3228,26 @@ impl IsaCompiler {
     }
 
     fn emit_epilogue(&mut self) {
+        self.emit_frame_teardown();
+        self.ir.emit(ADeadOp::Ret);
+    }
+
+    /// Deshace el frame sin `ret`: RSP queda como a la entrada
+    fn emit_frame_teardown(&mut self) {
+        if let Some(saves) = self.frameless_saves.clone() {
+            for &reg in saves.iter().rev() {
+                self.ir.emit(ADeadOp::Pop { dst: reg });
+            }
+            return;
+        }
+        // Callee-saved registers of promoted locals live in frame slots
+        for i in 0..self.saved_callee_regs.len() {
+            let (reg, disp) = self.saved_callee_regs[i];
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Reg(reg),
+                src: Operand::Mem { base: Reg::RBP, disp },
+            });
+        }
         // Restore RSP to point before callee-saved pushes
         // We pushed RBP, RBX, R12, RSI, RDI after mov rbp,rsp
         // So lea rsp, [rbp-32] points to where RDI was pushed
@@ -1801,7 +3264,264 @@ impl IsaCompiler {
         self.ir.emit(ADeadOp::Pop { dst: Reg::R12 });
         self.ir.emit(ADeadOp::Pop { dst: Reg::RBX });
         self.ir.emit(ADeadOp::Pop { dst: Reg::RBP });
-        self.ir.emit(ADeadOp::Ret);
+    }
+
+    /// Función hoja (sin llamadas) cuyos parámetros y locales caben en
+    /// LOCAL_REGS: el prólogo solo empuja RBX y los callee-saved que usa,
+    /// sin RBP ni `sub rsp`. No llama a nadie, así que ni la alineación
+    /// de RSP ni el shadow space importan. Si el cuerpo emitido acaba
+    /// tocando RBP/RSP (un temporal en el frame, un call del runtime),
+    /// se deshace lo emitido y devuelve false.
+    fn compile_frameless_leaf(&mut self, func: &Function) -> bool {
+        if self.target == Target::Raw || func.params.len() > 4 {
+            return false;
+        }
+        if self.call_abi(&func.name, func.params.len()).is_some() {
+            return false;
+        }
+        if !func.params.iter().all(|p| liveness::is_register_scalar(&p.param_type)) {
+            return false;
+        }
+        let params: Vec<String> = func.params.iter().map(|p| p.name.clone()).collect();
+        let Some(ranges) = liveness::leaf_ranges(&func.body, &params) else {
+            return false;
+        };
+        let func_name = func.name.clone();
+        let mut alloc = LinearScanAllocator::with_regs(&LOCAL_REGS);
+        for range in &ranges {
+            if self.global_vars.contains_key(&range.name)
+                || self
+                    .global_vars
+                    .contains_key(&format!("{}::{}", func_name, range.name))
+            {
+                return false;
+            }
+            alloc.add_interval(range.name.clone(), range.start, range.end + 1);
+        }
+        alloc.allocate();
+        if alloc.intervals().iter().any(|i| i.assigned_reg.is_none()) {
+            return false;
+        }
+
+        let start = self.ir.len();
+        let reports = self.loop_reports.len();
+        let mut saves = vec![Reg::RBX];
+        saves.extend(alloc.callee_saved_in_use());
+        for &reg in &saves {
+            self.ir.emit(ADeadOp::Push { src: Operand::Reg(reg) });
+        }
+        self.temp_alloc = TempAllocator::with_regs(&EXPR_REGS);
+        for interval in alloc.intervals() {
+            if let Some(reg) = interval.assigned_reg {
+                self.reg_vars.insert(interval.var_name.clone(), reg);
+            }
+        }
+        for (i, param) in func.params.iter().enumerate() {
+            self.variable_types.insert(param.name.clone(), param.param_type.clone());
+            self.param_vars.insert(param.name.clone());
+            if let Some(&reg) = self.reg_vars.get(&param.name) {
+                let src = self.arg_register(i);
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(reg),
+                    src: Operand::Reg(src),
+                });
+            }
+        }
+        self.frameless_saves = Some(saves);
+
+        for stmt in &func.body {
+            self.emit_statement(stmt);
+        }
+        self.emit_epilogue();
+        self.emit_cold_blocks();
+        self.frameless_saves = None;
+
+        if self.ir.ops()[start..].iter().all(|op| !Self::op_uses_frame(op)) {
+            return true;
+        }
+        self.ir.ops_mut().truncate(start);
+        self.loop_reports.truncate(reports);
+        self.cold_ranges.retain(|r| r.start < start);
+        self.reg_vars.clear();
+        self.variables.clear();
+        self.variable_types.clear();
+        self.array_vars.clear();
+        self.array_elem_sizes.clear();
+        self.param_vars.clear();
+        self.stack_offset = -32;
+        false
+    }
+
+    /// La instrucción necesita el frame: accede vía RBP/RSP o llama
+    fn op_uses_frame(op: &ADeadOp) -> bool {
+        let frame_reg = |r: &Reg| matches!(r, Reg::RBP | Reg::RSP);
+        let frame_operand = |o: &Operand| match o {
+            Operand::Reg(r) | Operand::Mem { base: r, .. } => frame_reg(r),
+            Operand::MemSIB { base, index, .. } => frame_reg(base) || frame_reg(index),
+            _ => false,
+        };
+        match op {
+            ADeadOp::Call { .. } | ADeadOp::CallIAT { .. } | ADeadOp::Syscall => true,
+            ADeadOp::Mov { dst, src } | ADeadOp::Add { dst, src } | ADeadOp::Sub { dst, src } => {
+                frame_operand(dst) || frame_operand(src)
+            }
+            ADeadOp::Cmp { left, right } => frame_operand(left) || frame_operand(right),
+            ADeadOp::Lea { dst, src } => frame_reg(dst) || frame_operand(src),
+            ADeadOp::Inc { dst } | ADeadOp::Dec { dst } => frame_operand(dst),
+            ADeadOp::Push { src } => frame_operand(src),
+            ADeadOp::Store8 { base, .. }
+            | ADeadOp::Load8 { base, .. }
+            | ADeadOp::Store16 { base, .. }
+            | ADeadOp::Load16 { base, .. }
+            | ADeadOp::Store32 { base, .. }
+            | ADeadOp::Load32 { base, .. }
+            | ADeadOp::MovsdStore { base, .. }
+            | ADeadOp::MovsdLoad { base, .. } => frame_reg(base),
+            ADeadOp::Rep { op } => Self::op_uses_frame(op),
+            _ => false,
+        }
+    }
+
+    /// Linear scan sobre los rangos de `liveness`: los escalares usados en
+    /// loops pasan a LOCAL_REGS. R12 ya lo guarda el prólogo; R13-R15 se
+    /// guardan en un slot del frame y `emit_epilogue` los restaura.
+    fn assign_local_registers(&mut self, body: &[Stmt]) {
+        let Some(ranges) = liveness::local_ranges(body) else {
+            return;
+        };
+        let func_name = self.current_function.clone().unwrap_or_default();
+        let mut alloc = LinearScanAllocator::with_regs(&LOCAL_REGS);
+        for range in &ranges {
+            let shadows_global = self.global_vars.contains_key(&range.name)
+                || self
+                    .global_vars
+                    .contains_key(&format!("{}::{}", func_name, range.name));
+            if !range.in_loop || shadows_global || self.variables.contains_key(&range.name) {
+                continue;
+            }
+            // Intervalo semiabierto: termina después de su último uso
+            let weight = self.range_weight(range);
+            alloc.add_weighted_interval(range.name.clone(), range.start, range.end + 1, weight);
+        }
+        alloc.allocate();
+
+        for interval in alloc.intervals() {
+            if let Some(reg) = interval.assigned_reg {
+                self.reg_vars.insert(interval.var_name.clone(), reg);
+            }
+        }
+        for reg in alloc.callee_saved_in_use() {
+            if reg == Reg::R12 {
+                continue;
+            }
+            self.stack_offset -= 8;
+            let disp = self.stack_offset;
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Mem { base: Reg::RBP, disp },
+                src: Operand::Reg(reg),
+            });
+            self.saved_callee_regs.push((reg, disp));
+        }
+    }
+
+    /// Ejecuciones estimadas de los usos de `range` según el perfil
+    /// (0 sin perfil: el linear scan decide como siempre)
+    fn range_weight(&self, range: &liveness::LocalRange) -> u64 {
+        let Some(profile) = &self.function_profile else {
+            return 0;
+        };
+        range
+            .sites
+            .iter()
+            .map(|site| match site {
+                Some(k) => profile.site(*k).map_or(0, |c| c.frequency()),
+                None => profile.entry,
+            })
+            .fold(0u64, |acc, n| acc.saturating_add(n))
+    }
+
+    // ========================================
+    // Profile-guided layout (-fprofile-use)
+    // ========================================
+
+    /// Perfil de `func` si cuadra con su cuerpo, y el número de site de
+    /// cada if/loop en el mismo pre-orden que `profile::site_stmts`
+    fn load_function_profile(&mut self, func: &Function) {
+        self.site_ids.clear();
+        self.cold_blocks.clear();
+        self.split_cold = true;
+        self.function_profile = self
+            .profile
+            .as_ref()
+            .and_then(|p| p.function_for(func))
+            .cloned();
+        if self.function_profile.is_some() {
+            for (k, stmt) in profile::site_stmts(&func.body).into_iter().enumerate() {
+                self.site_ids.insert(stmt as *const Stmt as usize, k);
+            }
+        }
+    }
+
+    fn site_count(&self, stmt: &Stmt) -> Option<SiteCount> {
+        let k = self.site_ids.get(&(stmt as *const Stmt as usize))?;
+        self.function_profile.as_ref()?.site(*k).copied()
+    }
+
+    /// Brazo frío del if `stmt`: lo que diga el perfil y, si no dice
+    /// nada, el brazo que acaba en exit/abort/__assert_fail
+    fn cold_arm(&self, stmt: &Stmt, then_body: &[Stmt], else_body: Option<&[Stmt]>) -> Option<bool> {
+        if !self.split_cold {
+            return None;
+        }
+        self.site_count(stmt)
+            .and_then(|c| c.cold_arm())
+            .or_else(|| code_layout::noreturn_arm(then_body, else_body))
+    }
+
+    /// Deja `body` para después del epílogo, con el scope de este punto
+    fn defer_cold_block(&mut self, label: Label, resume: Label, body: &[Stmt]) {
+        self.cold_blocks.push(ColdBlock {
+            label,
+            resume,
+            body: body.to_vec(),
+            variables: self.variables.clone(),
+            variable_types: self.variable_types.clone(),
+            array_vars: self.array_vars.clone(),
+            array_elem_sizes: self.array_elem_sizes.clone(),
+            loop_stack: self.loop_stack.clone(),
+        });
+    }
+
+    fn emit_cold_blocks(&mut self) {
+        let start = self.ir.ops().len();
+        while !self.cold_blocks.is_empty() {
+            for block in std::mem::take(&mut self.cold_blocks) {
+                self.variables = block.variables;
+                self.variable_types = block.variable_types;
+                self.array_vars = block.array_vars;
+                self.array_elem_sizes = block.array_elem_sizes;
+                self.loop_stack = block.loop_stack;
+                self.ir.emit(ADeadOp::Label(block.label));
+                for stmt in &block.body {
+                    self.emit_statement(stmt);
+                }
+                self.ir.emit(ADeadOp::Jmp { target: block.resume });
+            }
+        }
+        self.loop_stack.clear();
+        if self.ir.ops().len() > start {
+            self.cold_ranges.push(start..self.ir.ops().len());
+        }
+    }
+
+    /// Where a local scalar lives: its register if promoted, else its slot
+    fn local_slot(&self, name: &str) -> Option<Operand> {
+        if let Some(&reg) = self.reg_vars.get(name) {
+            return Some(Operand::Reg(reg));
+        }
+        self.variables
+            .get(name)
+            .map(|&disp| Operand::Mem { base: Reg::RBP, disp })
     }
 
     // ========================================
@@ -1893,9 +3613,11 @@ impl IsaCompiler {
                 then_body,
                 else_body,
             } => {
-                self.emit_if(condition, then_body, else_body.as_deref());
+                let cold_arm = self.cold_arm(stmt, then_body, else_body.as_deref());
+                self.emit_if(condition, then_body, else_body.as_deref(), cold_arm);
             }
             Stmt::While { condition, body } => self.emit_while(condition, body),
+            Stmt::Switch { expr, cases, default } => self.emit_switch(expr, cases, default.as_deref()),
             Stmt::For {
                 var,
                 start,
@@ -1903,6 +3625,20 @@ impl IsaCompiler {
                 body,
             } => self.emit_for(var, start, end, body),
             Stmt::Return(expr) => self.emit_return(expr.as_ref()),
+            // `assert(c)` = `c ? (void)0 : __assert_fail(...)`: como if,
+            // para que el fallo salga de la línea
+            Stmt::Expr(Expr::Ternary { condition, then_expr, else_expr })
+                if self.split_cold
+                    && [then_expr, else_expr].iter().any(|e| {
+                        matches!(e.as_ref(), Expr::Call { name, .. } if code_layout::is_noreturn(name))
+                    }) =>
+            {
+                self.emit_statement(&Stmt::If {
+                    condition: condition.as_ref().clone(),
+                    then_body: vec![Stmt::Expr(then_expr.as_ref().clone())],
+                    else_body: Some(vec![Stmt::Expr(else_expr.as_ref().clone())]),
+                });
+            }
             Stmt::Expr(expr) => {
                 self.emit_expression(expr);
             }
@@ -2016,14 +3752,14 @@ impl IsaCompiler {
 
             // ========== FREE: free(ptr) ==========
             Stmt::Free(expr) => {
-                // Evaluate pointer → RCX (first arg, Windows x64 ABI)
+                // Evaluate pointer → first arg register
                 self.emit_expression(expr);
                 self.ir.emit(ADeadOp::Mov {
-                    dst: Operand::Reg(Reg::RCX),
+                    dst: Operand::Reg(self.arg_register(0)),
                     src: Operand::Reg(Reg::RAX),
                 });
-                // Call free via dynamic IAT lookup
-                self.emit_call_iat("free");
+                // Built-in heap, or free via dynamic IAT lookup
+                self.emit_heap_call("free");
             }
 
             // OOP field assignment: self.field = value or obj.field = value (GCC/LLVM ABI)
@@ -2427,46 +4163,14 @@ impl IsaCompiler {
                     let base = self.stack_offset;
                     self.variables.insert(name.clone(), base);
 
-                    // Register each field as "var.field" with correct offset
-                    // Also register nested struct fields (e.g., r.origin.x for struct Rect)
-                    for (field_name, field_off) in &fields {
-                        let flat_name = format!("{}.{}", name, field_name);
-                        self.variables.insert(flat_name.clone(), base + field_off);
-                        // If this field is an array type, mark it in array_vars
-                        // so IndexAssign uses direct RBP-relative access instead of pointer deref
-                        if let Some(vt) = self.variable_types.get(&flat_name) {
-                            if matches!(vt, Type::Array(_, _)) {
-                                self.array_vars.insert(flat_name.clone());
-                            }
-                        }
-                        // Check if this field name matches a known struct type
-                        // by looking up field_types stored in the layout
-                        if let Some(field_type_name) =
-                            self.class_layouts.get(&struct_name).and_then(|layout| {
-                                layout
-                                    .field_types
-                                    .iter()
-                                    .find(|(fn_, _)| fn_ == field_name)
-                                    .map(|(_, ft)| ft.clone())
-                            })
-                        {
-                            if let Some(sub_layout) =
-                                self.class_layouts.get(&field_type_name).cloned()
-                            {
-                                for (sub_field, sub_off) in &sub_layout.fields {
-                                    self.variables.insert(
-                                        format!("{}.{}.{}", name, field_name, sub_field),
-                                        base + field_off + sub_off,
-                                    );
-                                }
-                            }
-                        }
-                    }
+                    self.register_struct_fields(name, &struct_name, base, &fields);
 
                     // Check if initializer is a function call returning a packed struct
                     let is_call_init = matches!(value, Some(Expr::Call { .. }));
 
-                    if is_call_init && fields.len() == 2 {
+                    if self.emit_struct_init(base, struct_size, var_type, value.as_ref()) {
+                        // Copiado de otro struct o de una llamada por valor
+                    } else if is_call_init && fields.len() == 2 {
                         // Struct initialized from function call: emit call, unpack RAX
                         if let Some(val) = value {
                             self.emit_expression(val);
@@ -2524,7 +4228,46 @@ impl IsaCompiler {
                                 src: Operand::Reg(Reg::RAX),
                             });
                         }
+                        // `{a, b, ...}`: un campo por elemento, en orden; el
+                        // resto queda a cero (en una union solo el primero)
+                        if let Some(Expr::Array(elems)) = value {
+                            let is_union = self.class_layouts.get(&struct_name).map_or(false, |l| l.is_union);
+                            let count = if is_union { 1 } else { fields.len() };
+                            for (elem, (field, _)) in elems.iter().zip(&fields).take(count) {
+                                if matches!(elem, Expr::Array(_)) {
+                                    continue;
+                                }
+                                self.emit_statement(&Stmt::FieldAssign {
+                                    object: Expr::Variable(name.clone()),
+                                    field: field.clone(),
+                                    value: elem.clone(),
+                                });
+                            }
+                        }
+                    }
+                    if let Some(vtable) = self.vtable_address(&struct_name) {
+                        self.ir.emit(ADeadOp::Mov {
+                            dst: Operand::Reg(Reg::RAX),
+                            src: Operand::Imm64(vtable),
+                        });
+                        self.ir.emit(ADeadOp::Mov {
+                            dst: Operand::Mem { base: Reg::RBP, disp: base },
+                            src: Operand::Reg(Reg::RAX),
+                        });
+                    }
+                } else if let Some(&reg) = self.reg_vars.get(name.as_str()) {
+                    // SCALAR promoted to a callee-saved register: no slot
+                    match value {
+                        Some(val) => self.emit_expression(val),
+                        None => self.ir.emit(ADeadOp::Xor {
+                            dst: Reg::RAX,
+                            src: Reg::RAX,
+                        }),
                     }
+                    self.ir.emit(ADeadOp::Mov {
+                        dst: Operand::Reg(reg),
+                        src: Operand::Reg(Reg::RAX),
+                    });
                 } else {
                     // SCALAR: single 8-byte slot
                     // If already registered (e.g., struct field like c.size), reuse existing offset
@@ -2736,6 +4479,20 @@ impl IsaCompiler {
                                     src: Operand::Reg(Reg::RCX),
                                 });
                             }
+                        } else if let Some(disp) = Self::const_index_disp(index, self.element_stride(name)) {
+                            // POINTER VARIABLE, índice constante (p[k], p. ej. tras
+                            // loop_opt): store directo a [ptr + k*stride]
+                            let stride = self.element_stride(name);
+                            self.emit_expression(value);
+                            self.ir.emit(ADeadOp::Mov {
+                                dst: Operand::Reg(Reg::RCX),
+                                src: Operand::Reg(Reg::RAX),
+                            });
+                            self.ir.emit(ADeadOp::Mov {
+                                dst: Operand::Reg(Reg::RAX),
+                                src: Operand::Mem { base: Reg::RBP, disp: base_offset },
+                            });
+                            self.emit_sized_store(Reg::RAX, disp, stride as i32, Reg::RCX);
                         } else {
                             // POINTER VARIABLE (e.g. int *arr parameter):
                             // Load pointer, then store at [ptr + i*stride]
@@ -2767,6 +4524,25 @@ impl IsaCompiler {
                             self.ir.emit(ADeadOp::Pop { dst: Reg::RCX });
                             self.emit_sized_store(Reg::RAX, 0, stride as i32, Reg::RCX);
                         }
+                    } else if let Some(stride) = self.global_array_stride(name) {
+                        // GLOBAL ARRAY: store at [addr + i*stride]
+                        let addr = self.get_global_address(name).unwrap_or(0);
+                        self.emit_expression(value);
+                        self.ir.emit(ADeadOp::Push {
+                            src: Operand::Reg(Reg::RAX),
+                        });
+                        self.emit_expression(index);
+                        self.emit_index_scale(stride);
+                        self.ir.emit(ADeadOp::Mov {
+                            dst: Operand::Reg(Reg::RBX),
+                            src: Operand::Imm64(addr),
+                        });
+                        self.ir.emit(ADeadOp::Add {
+                            dst: Operand::Reg(Reg::RAX),
+                            src: Operand::Reg(Reg::RBX),
+                        });
+                        self.ir.emit(ADeadOp::Pop { dst: Reg::RCX });
+                        self.emit_sized_store(Reg::RAX, 0, stride as i32, Reg::RCX);
                     } else {
                         // Unknown variable - skip
                     }
@@ -2805,21 +4581,11 @@ impl IsaCompiler {
                 is_pre: _,
                 is_increment,
             } => {
-                if let Some(&offset) = self.variables.get(name.as_str()) {
+                if let Some(slot) = self.local_slot(name) {
                     if *is_increment {
-                        self.ir.emit(ADeadOp::Inc {
-                            dst: Operand::Mem {
-                                base: Reg::RBP,
-                                disp: offset,
-                            },
-                        });
+                        self.ir.emit(ADeadOp::Inc { dst: slot });
                     } else {
-                        self.ir.emit(ADeadOp::Dec {
-                            dst: Operand::Mem {
-                                base: Reg::RBP,
-                                disp: offset,
-                            },
-                        });
+                        self.ir.emit(ADeadOp::Dec { dst: slot });
                     }
                 }
             }
@@ -2919,6 +4685,11 @@ impl IsaCompiler {
                     });
                 }
             }
+            Stmt::LineMarker(line) => {
+                if self.debug_lines {
+                    self.ir.emit(ADeadOp::SourceLine(*line as u32));
+                }
+            }
             Stmt::Continue => {
                 if let Some(&(_, continue_label)) = self.loop_stack.last() {
                     self.ir.emit(ADeadOp::Jmp {
@@ -3094,7 +4865,7 @@ impl IsaCompiler {
 
     fn emit_compound_assign(&mut self, name: &str, op: &CompoundOp, value: &Expr) {
         // Load current value
-        if let Some(&offset) = self.variables.get(name) {
+        if let Some(slot) = self.local_slot(name) {
             self.emit_expression(value);
             self.ir.emit(ADeadOp::Mov {
                 dst: Operand::Reg(Reg::RBX),
@@ -3102,10 +4873,7 @@ impl IsaCompiler {
             });
             self.ir.emit(ADeadOp::Mov {
                 dst: Operand::Reg(Reg::RAX),
-                src: Operand::Mem {
-                    base: Reg::RBP,
-                    disp: offset,
-                },
+                src: slot.clone(),
             });
             match op {
                 CompoundOp::AddAssign => self.ir.emit(ADeadOp::Add {
@@ -3156,10 +4924,7 @@ impl IsaCompiler {
                 }
             }
             self.ir.emit(ADeadOp::Mov {
-                dst: Operand::Mem {
-                    base: Reg::RBP,
-                    disp: offset,
-                },
+                dst: slot,
                 src: Operand::Reg(Reg::RAX),
             });
         }
@@ -3175,32 +4940,11 @@ impl IsaCompiler {
                 .replace("\\n", "\n")
                 .replace("\\t", "\t")
                 .replace("\\r", "\r");
-            if !self.strings.contains(&processed) {
-                self.strings.push(processed.clone());
-            }
+            self.strings.add(processed.clone());
             let string_addr = self.get_string_address(&processed);
 
             match self.target {
-                Target::Linux => {
-                    // sys_write(1, buf, len)
-                    self.ir.emit(ADeadOp::Mov {
-                        dst: Operand::Reg(Reg::RAX),
-                        src: Operand::Imm32(1),
-                    });
-                    self.ir.emit(ADeadOp::Mov {
-                        dst: Operand::Reg(Reg::RDI),
-                        src: Operand::Imm32(1),
-                    });
-                    self.ir.emit(ADeadOp::Mov {
-                        dst: Operand::Reg(Reg::RSI),
-                        src: Operand::Imm64(string_addr),
-                    });
-                    self.ir.emit(ADeadOp::Mov {
-                        dst: Operand::Reg(Reg::RDX),
-                        src: Operand::Imm32(processed.len() as i32),
-                    });
-                    self.ir.emit(ADeadOp::Syscall);
-                }
+                Target::Linux => self.emit_linux_write(string_addr, &processed),
                 Target::Windows | Target::Raw => {
                     self.ir.emit(ADeadOp::Mov {
                         dst: Operand::Reg(Reg::RCX),
@@ -3311,9 +5055,7 @@ impl IsaCompiler {
         self.emit_print(expr);
         // Print newline
         let newline = "\n".to_string();
-        if !self.strings.contains(&newline) {
-            self.strings.push(newline);
-        }
+        self.strings.add(newline);
         let nl_addr = self.get_string_address("\n");
         match self.target {
             Target::Windows | Target::Raw => {
@@ -3323,8 +5065,34 @@ impl IsaCompiler {
                 });
                 self.emit_call_printf();
             }
-            Target::Linux => {}
+            Target::Linux => self.emit_linux_write(nl_addr, "\n"),
+        }
+    }
+
+    /// Target::Linux: literal a stdout — por el buffer si hay entry de
+    /// proceso (linux_stdio.rs), si no sys_write(1, buf, len) directo
+    fn emit_linux_write(&mut self, addr: u64, text: &str) {
+        if let Some(out) = self.stdout_buffer {
+            out.emit_put(&mut self.ir, addr, text.len(), text.contains('\n'));
+            return;
         }
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RAX),
+            src: Operand::Imm32(1),
+        });
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RDI),
+            src: Operand::Imm32(1),
+        });
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RSI),
+            src: Operand::Imm64(addr),
+        });
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RDX),
+            src: Operand::Imm32(text.len() as i32),
+        });
+        self.ir.emit(ADeadOp::Syscall);
     }
 
     fn emit_print_num(&mut self, expr: &Expr) {
@@ -3347,12 +5115,33 @@ impl IsaCompiler {
 
     /// Emit a call to an IAT-imported function by name.
     /// Looks up the IAT slot RVA from the registry using assumed idata_rva=0x2000.
+    /// RVA asumida del slot IAT de `func_name`, marcándolo como usado
+    fn iat_rva_for(&mut self, func_name: &str) -> u32 {
+        let slot = iat_registry::slot_for_function(func_name)
+            .unwrap_or_else(|| panic!("IAT function not found: {}", func_name));
+        self.used_iat_slots.insert(slot);
+        iat_registry::assumed_iat_rva(slot)
+    }
+
+    /// Argumento ya en el primer registro del ABI: call a la rutina del
+    /// heap propio, si no al CRT por la IAT
+    fn emit_heap_call(&mut self, func_name: &str) {
+        let routine = self.heap.map(|heap| match func_name {
+            "malloc" => heap.malloc,
+            "free" => heap.free,
+            "realloc" => heap.realloc,
+            _ => unreachable!("heap call {}", func_name),
+        });
+        match routine {
+            Some(label) => self.ir.emit(ADeadOp::Call { target: CallTarget::Relative(label) }),
+            None => self.emit_call_iat(func_name),
+        }
+    }
+
     fn emit_call_iat(&mut self, func_name: &str) {
-        let assumed_idata_rva: u32 = 0x2000;
-        let idata_result = iat_registry::build_idata(assumed_idata_rva, &[]);
         let slot = iat_registry::slot_for_function(func_name)
             .unwrap_or_else(|| panic!("IAT function not found: {}", func_name));
-        let iat_rva = idata_result.slot_to_iat_rva[slot];
+        let iat_rva = iat_registry::assumed_iat_rva(slot);
         self.used_iat_slots.insert(slot);
 
         self.ir.emit(ADeadOp::Sub {
@@ -3422,30 +5211,27 @@ impl IsaCompiler {
             return;
         }
 
-        // Optimización: x = x + 1 → inc, x = x - 1 → dec
-        if let Some(&offset) = self.variables.get(name) {
+        // struct = struct: copia del bloque completo, como memcpy
+        if let Some(size) = self.struct_assign_size(name, value) {
+            self.emit_struct_assign(name, value, size);
+            return;
+        }
+
+        // Optimización: x = x + 1 → inc, x = x - 1 → dec (p = p + 1 con
+        // p puntero avanza sizeof(*p): va por el camino general)
+        if let Some(slot) = self.local_slot(name) {
             if let Expr::BinaryOp { op, left, right } = value {
                 if let Expr::Variable(var_name) = left.as_ref() {
-                    if var_name == name {
+                    if var_name == name && self.expr_pointer_stride(left).map_or(true, |s| s == 1) {
                         if let Expr::Number(n) = right.as_ref() {
                             if *n == 1 {
                                 match op {
                                     BinOp::Add => {
-                                        self.ir.emit(ADeadOp::Inc {
-                                            dst: Operand::Mem {
-                                                base: Reg::RBP,
-                                                disp: offset,
-                                            },
-                                        });
+                                        self.ir.emit(ADeadOp::Inc { dst: slot });
                                         return;
                                     }
                                     BinOp::Sub => {
-                                        self.ir.emit(ADeadOp::Dec {
-                                            dst: Operand::Mem {
-                                                base: Reg::RBP,
-                                                disp: offset,
-                                            },
-                                        });
+                                        self.ir.emit(ADeadOp::Dec { dst: slot });
                                         return;
                                     }
                                     _ => {}
@@ -3459,12 +5245,20 @@ impl IsaCompiler {
 
         self.emit_expression(value);
 
+        if let Some(&reg) = self.reg_vars.get(name) {
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Reg(reg),
+                src: Operand::Reg(Reg::RAX),
+            });
+            return;
+        }
+
         // Check global variable first
         if self.variables.get(name).is_none() {
             // Check global or static local
             let global_name = if self.global_vars.contains_key(name) {
                 Some(name.to_string())
-            } else if let Some(func_name) = &self.current_function.clone() {
+            } else if let Some(func_name) = &self.current_function {
                 let mangled = format!("{}::{}", func_name, name);
                 if self.global_vars.contains_key(&mangled) {
                     Some(mangled)
@@ -3530,13 +5324,42 @@ impl IsaCompiler {
     // Control Flow
     // ========================================
 
-    fn emit_if(&mut self, condition: &Expr, then_body: &[Stmt], else_body: Option<&[Stmt]>) {
+    /// `cold_arm` (del perfil): Some(true) = el then casi nunca se toma,
+    /// Some(false) = el else. El brazo frío sale de la línea y el caliente
+    /// queda como fall-through.
+    fn emit_if(
+        &mut self,
+        condition: &Expr,
+        then_body: &[Stmt],
+        else_body: Option<&[Stmt]>,
+        cold_arm: Option<bool>,
+    ) {
         self.emit_condition(condition);
         self.ir.emit(ADeadOp::Test {
             left: Reg::RAX,
             right: Reg::RAX,
         });
 
+        let split = match (cold_arm, else_body) {
+            (Some(true), _) => Some((Condition::NotEqual, else_body.unwrap_or(&[]), then_body)),
+            (Some(false), Some(else_stmts)) => Some((Condition::Equal, then_body, else_stmts)),
+            _ => None,
+        };
+        if let Some((cond, hot, cold)) = split {
+            let cold_label = self.ir.new_label();
+            let resume = self.ir.new_label();
+            self.ir.emit(ADeadOp::Jcc {
+                cond,
+                target: cold_label,
+            });
+            self.defer_cold_block(cold_label, resume, cold);
+            for stmt in hot {
+                self.emit_statement(stmt);
+            }
+            self.ir.emit(ADeadOp::Label(resume));
+            return;
+        }
+
         let else_label = self.ir.new_label();
         self.ir.emit(ADeadOp::Jcc {
             cond: Condition::Equal,
@@ -3561,6 +5384,8 @@ impl IsaCompiler {
     }
 
     fn emit_while(&mut self, condition: &Expr, body: &[Stmt]) {
+        self.try_vectorize_loop(condition, body);
+
         let loop_start = self.ir.new_label();
         let loop_end = self.ir.new_label();
         let continue_label = self.ir.new_label();
@@ -3601,6 +5426,140 @@ impl IsaCompiler {
         self.loop_stack.pop();
     }
 
+    // ========================================
+    // Switch (switch_lowering.rs)
+    // ========================================
+
+    /// Cuerpos de los casos en orden de código, default al final.
+    /// `break` sale del switch; `continue` sigue siendo del bucle de afuera.
+    fn emit_switch(&mut self, expr: &Expr, cases: &[SwitchCase], default: Option<&[Stmt]>) {
+        let end_label = self.ir.new_label();
+        let default_label = if default.is_some() { self.ir.new_label() } else { end_label };
+        let case_labels: Vec<Label> = cases.iter().map(|_| self.ir.new_label()).collect();
+
+        self.emit_expression(expr);
+        let values: Option<Vec<(i64, Label)>> = cases
+            .iter()
+            .zip(&case_labels)
+            .map(|(c, &l)| switch_lowering::case_value(&c.value).map(|v| (v, l)))
+            .collect();
+        match values {
+            Some(values) => {
+                let clusters = switch_lowering::cluster_cases(&values);
+                self.emit_switch_tree(&clusters, default_label);
+            }
+            None => self.emit_switch_chain(cases, &case_labels, default_label),
+        }
+
+        let continue_label = self.loop_stack.last().map_or(end_label, |&(_, c)| c);
+        self.loop_stack.push((end_label, continue_label));
+        for (case, &label) in cases.iter().zip(&case_labels) {
+            self.ir.emit(ADeadOp::Label(label));
+            for stmt in &case.body {
+                self.emit_statement(stmt);
+            }
+        }
+        if let Some(body) = default {
+            self.ir.emit(ADeadOp::Label(default_label));
+            for stmt in body {
+                self.emit_statement(stmt);
+            }
+        }
+        self.loop_stack.pop();
+        self.ir.emit(ADeadOp::Label(end_label));
+    }
+
+    /// Búsqueda binaria sobre los clusters; el valor está en RAX
+    fn emit_switch_tree(&mut self, clusters: &[CaseCluster<Label>], default_label: Label) {
+        let all_single = clusters.iter().all(|c| matches!(c, CaseCluster::Single(..)));
+        if clusters.len() <= switch_lowering::LINEAR_LEAF && (all_single || clusters.len() == 1) {
+            for cluster in clusters {
+                match cluster {
+                    CaseCluster::Single(v, target) => {
+                        self.emit_cmp_rax_imm(*v);
+                        self.ir.emit(ADeadOp::Jcc { cond: Condition::Equal, target: *target });
+                    }
+                    CaseCluster::Table { low, targets } => {
+                        self.emit_jump_table(*low, targets, default_label);
+                        return;
+                    }
+                }
+            }
+            self.ir.emit(ADeadOp::Jmp { target: default_label });
+            return;
+        }
+
+        let mid = clusters.len() / 2;
+        let left = self.ir.new_label();
+        self.emit_cmp_rax_imm(clusters[mid].low());
+        self.ir.emit(ADeadOp::Jcc { cond: Condition::Less, target: left });
+        self.emit_switch_tree(&clusters[mid..], default_label);
+        self.ir.emit(ADeadOp::Label(left));
+        self.emit_switch_tree(&clusters[..mid], default_label);
+    }
+
+    /// Bounds check + salto indirecto por una tabla de offsets en .text
+    fn emit_jump_table(&mut self, low: i64, targets: &[Option<Label>], default_label: Label) {
+        if low != 0 {
+            match i32::try_from(low) {
+                Ok(v) => self.ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RAX), src: Operand::Imm32(v) }),
+                Err(_) => {
+                    self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RCX), src: Operand::Imm64(low as u64) });
+                    self.ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RCX) });
+                }
+            }
+        }
+        self.ir.emit(ADeadOp::Cmp {
+            left: Operand::Reg(Reg::RAX),
+            right: Operand::Imm32(targets.len() as i32 - 1),
+        });
+        self.ir.emit(ADeadOp::Jcc { cond: Condition::Above, target: default_label });
+
+        let table = self.ir.new_label();
+        self.ir.emit(ADeadOp::LeaLabel { dst: Reg::RCX, label: table });
+        // movsxd rax, dword [rcx + rax*4]
+        self.ir.emit(ADeadOp::RawBytes(vec![0x48, 0x63, 0x04, 0x81]));
+        self.ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RCX) });
+        // jmp rax
+        self.ir.emit(ADeadOp::RawBytes(vec![0xFF, 0xE0]));
+        self.ir.emit(ADeadOp::Label(table));
+        self.ir.emit(ADeadOp::JumpTable {
+            table,
+            targets: targets.iter().map(|t| t.unwrap_or(default_label)).collect(),
+        });
+    }
+
+    /// Casos no constantes: el valor va a un slot y se compara caso por caso
+    fn emit_switch_chain(&mut self, cases: &[SwitchCase], case_labels: &[Label], default_label: Label) {
+        self.stack_offset -= 8;
+        let slot = self.stack_offset;
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Mem { base: Reg::RBP, disp: slot },
+            src: Operand::Reg(Reg::RAX),
+        });
+        for (case, &label) in cases.iter().zip(case_labels) {
+            self.emit_expression(&case.value);
+            self.ir.emit(ADeadOp::Cmp {
+                left: Operand::Reg(Reg::RAX),
+                right: Operand::Mem { base: Reg::RBP, disp: slot },
+            });
+            self.ir.emit(ADeadOp::Jcc { cond: Condition::Equal, target: label });
+        }
+        self.ir.emit(ADeadOp::Jmp { target: default_label });
+    }
+
+    /// cmp rax, v (imm32 si cabe; si no, vía RCX)
+    fn emit_cmp_rax_imm(&mut self, v: i64) {
+        let right = match i32::try_from(v) {
+            Ok(v) => Operand::Imm32(v),
+            Err(_) => {
+                self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RCX), src: Operand::Imm64(v as u64) });
+                Operand::Reg(Reg::RCX)
+            }
+        };
+        self.ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right });
+    }
+
     /// Detect how many trailing statements in a while body are "for-loop update" statements.
     /// The C frontend converts `for(init;cond;update) body` into:
     ///   init; while(cond) { body; update; }
@@ -3619,74 +5578,472 @@ impl IsaCompiler {
         }
     }
 
-    fn emit_for(&mut self, var: &str, start: &Expr, end: &Expr, body: &[Stmt]) {
-        // Evaluar start → RCX, end → R8
-        self.emit_expression(start);
+    // ========================================
+    // Loop vectorizer (AVX2) — ver loop_vectorizer.rs
+    // ========================================
+
+    /// Emite un bucle principal AVX2 delante de un `while` contable.
+    /// No toca el bucle escalar que sigue: ese hace el resto (n % LANES)
+    /// o todo el trabajo si el chequeo de aliasing en runtime falla.
+    fn try_vectorize_loop(&mut self, condition: &Expr, body: &[Stmt]) {
+        if self.cpu_mode != CpuMode::Long64 {
+            return;
+        }
+        let var = match loop_vectorizer::induction_var(body) {
+            Some(v) => v.to_string(),
+            None => return,
+        };
+        let result = loop_vectorizer::analyze(condition, body, &*self);
+        let mut report = LoopReport {
+            function: self.current_function.clone().unwrap_or_default(),
+            var,
+            line: loop_vectorizer::body_line(body),
+            elem: None,
+            lanes: 0,
+            alias_check: false,
+            skipped: None,
+        };
+        match result {
+            Err(SoaSkipReason::NotCountable) => return,
+            Err(reason) => report.skipped = Some(reason),
+            Ok(lp) => {
+                report.elem = Some(lp.elem);
+                report.lanes = lp.lanes();
+                report.alias_check = !lp.alias_pairs().is_empty();
+                if self.bit_target.should_soa_optimize() {
+                    self.emit_vector_loop(&lp);
+                } else {
+                    report.skipped = Some(SoaSkipReason::TargetTooNarrow);
+                }
+            }
+        }
+        self.loop_reports.push(report);
+    }
+
+    /// i → RCX, n → RDX, bases → R8..R11; invariantes splat en ymm0..
+    fn emit_vector_loop(&mut self, lp: &VecLoop) {
+        let lanes = lp.lanes() as i32;
+        let size = lp.elem_size() as u8;
+        let vdone = self.ir.new_label();
+        let vloop = self.ir.new_label();
+
+        // Los escalares invariantes solo leen memoria/immediatos: no tocan YMM.
+        // En bucles float los literales van ya con los bits del lane
+        for (k, inv) in lp.invariants.iter().enumerate() {
+            match loop_vectorizer::literal_bits(lp.elem, inv) {
+                Some(bits) => self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Imm64(bits),
+                }),
+                None => self.emit_expression(inv),
+            }
+            let ymm = YmmReg(k as u8);
+            self.emit_avx(&[
+                AvxInst::VmovqFromGp { dst: ymm, src: 0 },
+                AvxInst::Vpbroadcast { lane: size, dst: ymm, src: ymm },
+            ]);
+        }
+        // Bases (array local → LEA, puntero → su valor) y el límite, por la pila
+        for array in &lp.arrays {
+            self.emit_expression(&Expr::Variable(array.name.clone()));
+            self.ir.emit(ADeadOp::Push { src: Operand::Reg(Reg::RAX) });
+        }
+        self.emit_expression(&lp.bound);
+        self.ir.emit(ADeadOp::Push { src: Operand::Reg(Reg::RAX) });
+        self.emit_expression(&Expr::Variable(lp.var.clone()));
         self.ir.emit(ADeadOp::Mov {
             dst: Operand::Reg(Reg::RCX),
             src: Operand::Reg(Reg::RAX),
         });
-        self.emit_expression(end);
-        self.ir.emit(ADeadOp::Mov {
-            dst: Operand::Reg(Reg::R8),
-            src: Operand::Reg(Reg::RAX),
+        self.ir.emit(ADeadOp::Pop { dst: Reg::RDX });
+        if lp.inclusive {
+            self.ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::RDX) });
+        }
+        for k in (0..lp.arrays.len()).rev() {
+            self.ir.emit(ADeadOp::Pop { dst: loop_vectorizer::BASE_GPRS[k] });
+        }
+
+        // Menos de un vector: directo al bucle escalar
+        self.emit_remaining_trip(0);
+        self.ir.emit(ADeadOp::Cmp {
+            left: Operand::Reg(Reg::RAX),
+            right: Operand::Imm32(lanes),
         });
+        self.ir.emit(ADeadOp::Jcc { cond: Condition::Less, target: vdone });
 
-        let var_offset = self.stack_offset;
-        self.variables.insert(var.to_string(), var_offset);
-        self.stack_offset -= 8;
+        // Aliasing: |W - X| >= bytes que tocará el bucle, o W == X con el
+        // mismo índice (cada lane lee lo que la iteración escalar leería)
+        for (w, x) in lp.alias_pairs() {
+            let other = &lp.arrays[x];
+            let span = other.max_offset.max(0) - other.min_offset.min(0);
+            self.emit_remaining_trip(span as i32);
+            if size > 1 {
+                self.ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: size.trailing_zeros() as u8 });
+            }
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Reg(Reg::RBX),
+                src: Operand::Reg(loop_vectorizer::BASE_GPRS[w]),
+            });
+            self.ir.emit(ADeadOp::Sub {
+                dst: Operand::Reg(Reg::RBX),
+                src: Operand::Reg(loop_vectorizer::BASE_GPRS[x]),
+            });
+            let disjoint = self.ir.new_label();
+            if span == 0 {
+                self.ir.emit(ADeadOp::Jcc { cond: Condition::Equal, target: disjoint });
+            }
+            self.ir.emit(ADeadOp::Cmp {
+                left: Operand::Reg(Reg::RBX),
+                right: Operand::Reg(Reg::RAX),
+            });
+            self.ir.emit(ADeadOp::Jcc { cond: Condition::Below, target: vdone });
+            self.ir.emit(ADeadOp::Neg { dst: Reg::RBX });
+            self.ir.emit(ADeadOp::Cmp {
+                left: Operand::Reg(Reg::RBX),
+                right: Operand::Reg(Reg::RAX),
+            });
+            self.ir.emit(ADeadOp::Jcc { cond: Condition::Below, target: vdone });
+            self.ir.emit(ADeadOp::Label(disjoint));
+        }
 
-        let loop_start = self.ir.new_label();
-        let loop_end = self.ir.new_label();
+        // Llamadas a vec_math: zona de spill de los ymm vivos en [rsp]
+        let (vexit, vbody_done) = if lp.has_calls() {
+            self.ir.emit(ADeadOp::Sub {
+                dst: Operand::Reg(Reg::RSP),
+                src: Operand::Imm32(loop_vectorizer::SPILL_BYTES),
+            });
+            let vexit = self.ir.new_label();
+            (Some(vexit), vexit)
+        } else {
+            (None, vdone)
+        };
 
-        self.loop_stack.push((loop_end, loop_start));
+        // Bases alineadas: si i % LANES == 0 al entrar, lo es en cada vuelta
+        // (i avanza de LANES en LANES) y valen los accesos vmovdqa
+        if let Some(aligned_body) = &lp.aligned_body {
+            let valoop = self.ir.new_label();
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Reg(Reg::RAX),
+                src: Operand::Imm32(lanes - 1),
+            });
+            self.ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RCX });
+            self.ir.emit(ADeadOp::Jcc { cond: Condition::NotEqual, target: vloop });
+            self.emit_vector_main_loop(valoop, aligned_body, lanes, vbody_done);
+        }
 
-        self.ir.emit(ADeadOp::Label(loop_start));
+        self.emit_vector_main_loop(vloop, &lp.body, lanes, vbody_done);
+
+        if let Some(vexit) = vexit {
+            self.ir.emit(ADeadOp::Label(vexit));
+            self.ir.emit(ADeadOp::Add {
+                dst: Operand::Reg(Reg::RSP),
+                src: Operand::Imm32(loop_vectorizer::SPILL_BYTES),
+            });
+        }
+        self.ir.emit(ADeadOp::Label(vdone));
+        self.emit_avx(&[AvxInst::Vzeroupper]);
+        if let Some(slot) = self.local_slot(&lp.var) {
+            self.ir.emit(ADeadOp::Mov {
+                dst: slot,
+                src: Operand::Reg(Reg::RCX),
+            });
+        }
+    }
+
+    /// while (i + LANES <= n) { cuerpo vectorial; i += LANES; }
+    fn emit_vector_main_loop(&mut self, head: Label, body: &[VecStep], lanes: i32, done: Label) {
+        self.ir.emit(ADeadOp::Label(head));
+        self.ir.emit(ADeadOp::Lea {
+            dst: Reg::RAX,
+            src: Operand::Mem { base: Reg::RCX, disp: lanes },
+        });
         self.ir.emit(ADeadOp::Cmp {
-            left: Operand::Reg(Reg::RCX),
-            right: Operand::Reg(Reg::R8),
+            left: Operand::Reg(Reg::RAX),
+            right: Operand::Reg(Reg::RDX),
         });
-        self.ir.emit(ADeadOp::Jcc {
-            cond: Condition::GreaterEq,
-            target: loop_end,
+        self.ir.emit(ADeadOp::Jcc { cond: Condition::Greater, target: done });
+        for steps in body.split_inclusive(|step| matches!(step, VecStep::Call { .. })) {
+            let insts: Vec<AvxInst> = steps
+                .iter()
+                .filter_map(|step| match step {
+                    VecStep::Avx(inst) => Some(inst.clone()),
+                    VecStep::Call { .. } => None,
+                })
+                .collect();
+            self.emit_avx(&insts);
+            if let (Some(VecStep::Call { func, double }), Some(math)) = (steps.last(), self.vec_math) {
+                self.ir.emit(ADeadOp::Call { target: CallTarget::Relative(math.entry(*func, *double)) });
+            }
+        }
+        self.ir.emit(ADeadOp::Add {
+            dst: Operand::Reg(Reg::RCX),
+            src: Operand::Imm32(lanes),
         });
+        self.ir.emit(ADeadOp::Jmp { target: head });
+    }
 
-        // Guardar RCX en variable
+    /// RAX = n - i + extra (elementos que quedan, más el margen de offsets)
+    fn emit_remaining_trip(&mut self, extra: i32) {
         self.ir.emit(ADeadOp::Mov {
-            dst: Operand::Mem {
-                base: Reg::RBP,
-                disp: var_offset,
-            },
-            src: Operand::Reg(Reg::RCX),
+            dst: Operand::Reg(Reg::RAX),
+            src: Operand::Reg(Reg::RDX),
         });
-
-        // Preservar RCX y R8
-        self.ir.emit(ADeadOp::Push {
+        self.ir.emit(ADeadOp::Sub {
+            dst: Operand::Reg(Reg::RAX),
             src: Operand::Reg(Reg::RCX),
         });
-        self.ir.emit(ADeadOp::Push {
-            src: Operand::Reg(Reg::R8),
-        });
-
-        for stmt in body {
-            self.emit_statement(stmt);
+        if extra != 0 {
+            self.ir.emit(ADeadOp::Add {
+                dst: Operand::Reg(Reg::RAX),
+                src: Operand::Imm32(extra),
+            });
         }
+    }
 
-        self.ir.emit(ADeadOp::Pop { dst: Reg::R8 });
-        self.ir.emit(ADeadOp::Pop { dst: Reg::RCX });
-        self.ir.emit(ADeadOp::Inc {
-            dst: Operand::Reg(Reg::RCX),
-        });
-        self.ir.emit(ADeadOp::Jmp { target: loop_start });
-        self.ir.emit(ADeadOp::Label(loop_end));
+    fn emit_avx(&mut self, insts: &[AvxInst]) {
+        let mut vex = VexEmitter::new();
+        vex.emit_all(insts);
+        self.ir.emit(ADeadOp::RawBytes(vex.into_bytes()));
+    }
 
-        self.loop_stack.pop();
+    // ========================================
+    // Function multiversioning (target_clones)
+    // ========================================
+
+    /// ¿Algún `while` con forma de `for` contable? Candidata a clonarse.
+    fn has_counted_loop(stmts: &[Stmt]) -> bool {
+        stmts.iter().any(|stmt| match stmt {
+            Stmt::While { body, .. } => {
+                loop_vectorizer::induction_var(body).is_some() || Self::has_counted_loop(body)
+            }
+            Stmt::DoWhile { body, .. } => Self::has_counted_loop(body),
+            Stmt::Switch { cases, default, .. } => {
+                cases.iter().any(|c| Self::has_counted_loop(&c.body))
+                    || default.as_ref().map_or(false, |b| Self::has_counted_loop(b))
+            }
+            Stmt::If { then_body, else_body, .. } => {
+                Self::has_counted_loop(then_body)
+                    || else_body.as_ref().map_or(false, |b| Self::has_counted_loop(b))
+            }
+            _ => false,
+        })
     }
 
-    fn emit_return(&mut self, expr: Option<&Expr>) {
-        if let Some(e) = expr {
-            // Check if returning a struct variable — pack fields into RAX
-            if let Expr::Variable(var_name) = e {
+    /// `mov r11, &slot; jmp [r11]` — R11 no lleva argumentos en ningún ABI
+    fn emit_clone_thunk(&mut self, slot: &str) {
+        let addr = self.get_global_address(slot).unwrap_or(0);
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::R11),
+            src: Operand::Imm64(addr),
+        });
+        self.ir.emit(ADeadOp::RawBytes(vec![0x41, 0xFF, 0x23])); // jmp qword [r11]
+    }
+
+    /// Resolver del stub de arranque: prueba los targets de más ancho a
+    /// menos por CPUID, rellena los slots una sola vez y salta al entry.
+    fn emit_clone_resolver(&mut self, resolver: Label, entry: Label) {
+        self.ir.emit(ADeadOp::Label(resolver));
+        if self.clones.is_empty() {
+            self.ir.emit(ADeadOp::Jmp { target: entry });
+            return;
+        }
+        // CPUID pisa RBX
+        self.ir.emit(ADeadOp::Push { src: Operand::Reg(Reg::RBX) });
+        let done = self.ir.new_label();
+        let mut targets: Vec<BitTarget> = self.target_clones.clone();
+        targets.sort_by_key(|t| std::cmp::Reverse(t.register_width()));
+        for target in targets {
+            let next = self.ir.new_label();
+            self.emit_cpu_supports(target, next);
+            let picks: Vec<(String, Label)> = self
+                .clones
+                .iter()
+                .filter_map(|c| {
+                    let (_, l) = c.variants.iter().find(|(t, _)| *t == target)?;
+                    Some((c.name.clone(), *l))
+                })
+                .collect();
+            self.emit_fill_slots(&picks);
+            self.ir.emit(ADeadOp::Jmp { target: done });
+            self.ir.emit(ADeadOp::Label(next));
+        }
+        let defaults: Vec<(String, Label)> =
+            self.clones.iter().map(|c| (c.name.clone(), c.default)).collect();
+        self.emit_fill_slots(&defaults);
+        self.ir.emit(ADeadOp::Label(done));
+        self.ir.emit(ADeadOp::Pop { dst: Reg::RBX });
+        self.ir.emit(ADeadOp::Jmp { target: entry });
+    }
+
+    /// Resolver del vDSO que llama el stub de proceso (RDI = auxv)
+    fn emit_vdso_init(&mut self, init: Label) {
+        let symbols: Vec<(u64, u64)> = linux_vdso::VDSO_SYMBOLS
+            .iter()
+            .filter_map(|sym| {
+                let slot = self.get_global_address(&linux_vdso::slot_name(sym))?;
+                Some((self.get_string_address(sym.vdso_name), slot))
+            })
+            .collect();
+        linux_vdso::emit_init(&mut self.ir, init, &symbols);
+    }
+
+    /// Rellena los punteros a función de los datos globales (entradas de
+    /// vtable): los labels sólo tienen dirección una vez codificado .text
+    fn emit_code_pointers(&mut self) {
+        let slots = std::mem::take(&mut self.code_pointers);
+        for (global, offset, func) in &slots {
+            let (Some(base), Some(f)) = (self.get_global_address(global), self.functions.get(func)) else {
+                continue;
+            };
+            self.ir.emit(ADeadOp::LeaLabel { dst: Reg::RAX, label: f.label });
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Reg(Reg::R11),
+                src: Operand::Imm64(base + *offset as u64),
+            });
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Mem { base: Reg::R11, disp: 0 },
+                src: Operand::Reg(Reg::RAX),
+            });
+        }
+    }
+
+    /// Dirección de la vtable de `class`, si la tiene
+    fn vtable_address(&self, class: &str) -> Option<u64> {
+        let name = format!("__vtable_{}", class);
+        self.global_arrays.get(&name)?;
+        self.get_global_address(&name)
+    }
+
+    fn emit_fill_slots(&mut self, picks: &[(String, Label)]) {
+        for (name, label) in picks {
+            let addr = self.get_global_address(&clone_slot_name(name)).unwrap_or(0);
+            self.ir.emit(ADeadOp::LeaLabel { dst: Reg::RAX, label: *label });
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Reg(Reg::R11),
+                src: Operand::Imm64(addr),
+            });
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Mem { base: Reg::R11, disp: 0 },
+                src: Operand::Reg(Reg::RAX),
+            });
+        }
+    }
+
+    /// Salta a `unsupported` si la CPU no puede ejecutar código de `target`.
+    /// 256-bit = AVX2: CPUID.1:ECX.{OSXSAVE,AVX}, XCR0.{SSE,AVX} y CPUID.7:EBX.AVX2
+    fn emit_cpu_supports(&mut self, target: BitTarget, unsupported: Label) {
+        if target.register_width() < 256 {
+            return; // SSE2 es la base de x86-64
+        }
+        self.ir.emit(ADeadOp::RawBytes(vec![
+            0xB8, 0x01, 0x00, 0x00, 0x00, // mov eax, 1
+            0x0F, 0xA2, // cpuid
+            0x81, 0xE1, 0x00, 0x00, 0x00, 0x18, // and ecx, OSXSAVE|AVX
+            0x81, 0xF9, 0x00, 0x00, 0x00, 0x18, // cmp ecx, OSXSAVE|AVX
+        ]));
+        self.ir.emit(ADeadOp::Jcc { cond: Condition::NotEqual, target: unsupported });
+        self.ir.emit(ADeadOp::RawBytes(vec![
+            0x31, 0xC9, // xor ecx, ecx
+            0x0F, 0x01, 0xD0, // xgetbv
+            0x83, 0xE0, 0x06, // and eax, 6
+            0x83, 0xF8, 0x06, // cmp eax, 6
+        ]));
+        self.ir.emit(ADeadOp::Jcc { cond: Condition::NotEqual, target: unsupported });
+        self.ir.emit(ADeadOp::RawBytes(vec![
+            0xB8, 0x07, 0x00, 0x00, 0x00, // mov eax, 7
+            0x31, 0xC9, // xor ecx, ecx
+            0x0F, 0xA2, // cpuid
+            0xF7, 0xC3, 0x20, 0x00, 0x00, 0x00, // test ebx, AVX2
+        ]));
+        self.ir.emit(ADeadOp::Jcc { cond: Condition::Equal, target: unsupported });
+    }
+
+    fn emit_for(&mut self, var: &str, start: &Expr, end: &Expr, body: &[Stmt]) {
+        // Evaluar start → RCX, end → R8 (start va por la pila: `end` puede
+        // usar RCX como temporal de expresión)
+        self.emit_expression(start);
+        self.ir.emit(ADeadOp::Push {
+            src: Operand::Reg(Reg::RAX),
+        });
+        self.emit_expression(end);
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::R8),
+            src: Operand::Reg(Reg::RAX),
+        });
+        self.ir.emit(ADeadOp::Pop { dst: Reg::RCX });
+
+        let var_offset = self.stack_offset;
+        self.variables.insert(var.to_string(), var_offset);
+        self.stack_offset -= 8;
+
+        let loop_start = self.ir.new_label();
+        let loop_end = self.ir.new_label();
+
+        self.loop_stack.push((loop_end, loop_start));
+
+        self.ir.emit(ADeadOp::Label(loop_start));
+        self.ir.emit(ADeadOp::Cmp {
+            left: Operand::Reg(Reg::RCX),
+            right: Operand::Reg(Reg::R8),
+        });
+        self.ir.emit(ADeadOp::Jcc {
+            cond: Condition::GreaterEq,
+            target: loop_end,
+        });
+
+        // Guardar RCX en variable
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Mem {
+                base: Reg::RBP,
+                disp: var_offset,
+            },
+            src: Operand::Reg(Reg::RCX),
+        });
+
+        // Preservar RCX y R8
+        self.ir.emit(ADeadOp::Push {
+            src: Operand::Reg(Reg::RCX),
+        });
+        self.ir.emit(ADeadOp::Push {
+            src: Operand::Reg(Reg::R8),
+        });
+
+        for stmt in body {
+            self.emit_statement(stmt);
+        }
+
+        self.ir.emit(ADeadOp::Pop { dst: Reg::R8 });
+        self.ir.emit(ADeadOp::Pop { dst: Reg::RCX });
+        self.ir.emit(ADeadOp::Inc {
+            dst: Operand::Reg(Reg::RCX),
+        });
+        self.ir.emit(ADeadOp::Jmp { target: loop_start });
+        self.ir.emit(ADeadOp::Label(loop_end));
+
+        self.loop_stack.pop();
+    }
+
+    fn emit_return(&mut self, expr: Option<&Expr>) {
+        if let Some(Expr::Call { name, args }) = expr {
+            if self.emit_tail_call(name, args) {
+                return;
+            }
+        }
+        if let (Some(e), true) = (expr, self.return_pass != ArgPass::Value) {
+            // Struct por valor (struct_abi.rs); un retorno Copy devuelve
+            // siempre el puntero sret
+            if !self.emit_struct_return(e) {
+                self.emit_expression(e);
+                if let Some(sret) = self.sret_slot {
+                    self.ir.emit(ADeadOp::Mov {
+                        dst: Operand::Reg(Reg::RAX),
+                        src: Operand::Mem { base: Reg::RBP, disp: sret },
+                    });
+                }
+            }
+        } else if let Some(e) = expr {
+            // Check if returning a struct variable — pack fields into RAX
+            if let Expr::Variable(var_name) = e {
                 if let Some(ty) = self.variable_types.get(var_name).cloned() {
                     let sn = match &ty {
                         Type::Struct(n) | Type::Named(n) | Type::Class(n) => Some(n.clone()),
@@ -3757,112 +6114,676 @@ impl IsaCompiler {
             });
         }
         // Full epilogue inline: must match emit_prologue's callee-saved register saves
-        // Prologue pushes: RBP, then RBX, R12, RSI, RDI (at RBP-8..-32)
-        self.ir.emit(ADeadOp::Lea {
-            dst: Reg::RSP,
-            src: Operand::Mem {
-                base: Reg::RBP,
-                disp: -32,
-            },
-        });
-        self.ir.emit(ADeadOp::Pop { dst: Reg::RDI });
-        self.ir.emit(ADeadOp::Pop { dst: Reg::RSI });
-        self.ir.emit(ADeadOp::Pop { dst: Reg::R12 });
-        self.ir.emit(ADeadOp::Pop { dst: Reg::RBX });
-        self.ir.emit(ADeadOp::Pop { dst: Reg::RBP });
-        self.ir.emit(ADeadOp::Ret);
+        self.emit_epilogue();
     }
 
-    // ========================================
-    // Conditions
-    // ========================================
-
-    fn emit_condition(&mut self, expr: &Expr) {
-        match expr {
-            Expr::Comparison { op, left, right } => {
-                // Use push/pop — safe for nested calls and recursion
-                self.emit_expression(left);
-                self.ir.emit(ADeadOp::Push {
-                    src: Operand::Reg(Reg::RAX),
-                });
-                self.emit_expression(right);
-                self.ir.emit(ADeadOp::Mov {
-                    dst: Operand::Reg(Reg::RBX),
-                    src: Operand::Reg(Reg::RAX),
-                });
-                self.ir.emit(ADeadOp::Pop { dst: Reg::RAX });
+    /// `return f(...)` en posición de cola. Recursión propia → los
+    /// argumentos pasan a los slots de los parámetros y `jmp` al cuerpo.
+    /// Otra función interna con <= 4 argumentos → se deshace el frame y
+    /// `jmp f`: RSP vuelve a ser el de la entrada, así que `f` reutiliza
+    /// el shadow space y la dirección de retorno de nuestro caller.
+    /// Ningún argumento puede apuntar al frame que se reutiliza o se libera,
+    /// y para `jmp f` ninguna dirección del frame puede haber escapado.
+    fn emit_tail_call(&mut self, name: &str, args: &[Expr]) -> bool {
+        if !self.tail_calls {
+            return false;
+        }
+        let Some(callee) = self.functions.get(name) else {
+            return false;
+        };
+        // Structs por valor: slots y sret no cuadran con los parámetros
+        if self.return_pass != ArgPass::Value || self.call_abi(name, args.len()).is_some() {
+            return false;
+        }
+        let (label, params) = (callee.label, callee.params.clone());
+        let is_import = iat_registry::slot_for_function(name).is_some()
+            || matches!(name, "printf" | "std::printf" | "scanf" | "std::scanf" | "malloc" | "free" | "snprintf");
+        let self_loop = self.tail_loop.filter(|_| self.current_function.as_deref() == Some(name));
+        // Los argumentos de pila (5+) no caben en el área del caller
+        if params.len() != args.len() || (self_loop.is_none() && args.len() > 4) {
+            return false;
+        }
+        // `int *q = &x; return g(q);`: q no toma la dirección en el
+        // argumento, pero apunta al frame que el jmp libera
+        if self_loop.is_none() && self.frame_escapes {
+            return false;
+        }
+        if is_import || MemBuiltin::from_name(name).is_some() {
+            return false;
+        }
+        for arg in args {
+            let Some(vars) = liveness::expr_vars(arg) else {
+                return false;
+            };
+            let borrows_frame = vars.iter().any(|v| {
+                self.array_vars.contains(v)
+                    || self
+                        .variable_types
+                        .get(v)
+                        .map_or(false, |ty| self.is_real_struct_type(ty) && !self.struct_params.contains(v))
+            });
+            if borrows_frame {
+                return false;
+            }
+        }
 
-                self.ir.emit(ADeadOp::Cmp {
-                    left: Operand::Reg(Reg::RAX),
-                    right: Operand::Reg(Reg::RBX),
-                });
+        for arg in args {
+            self.emit_expression(arg);
+            self.ir.emit(ADeadOp::Push { src: Operand::Reg(Reg::RAX) });
+        }
 
-                let cond = match op {
-                    CmpOp::Eq => Condition::Equal,
-                    CmpOp::Ne => Condition::NotEqual,
-                    CmpOp::Lt => Condition::Less,
-                    CmpOp::Le => Condition::LessEq,
-                    CmpOp::Gt => Condition::Greater,
-                    CmpOp::Ge => Condition::GreaterEq,
-                };
-                self.ir.emit(ADeadOp::SetCC { cond, dst: Reg::AL });
-                self.ir.emit(ADeadOp::MovZx {
-                    dst: Reg::RAX,
-                    src: Reg::AL,
-                });
+        if let Some(body_start) = self_loop {
+            for param in params.iter().rev() {
+                self.ir.emit(ADeadOp::Pop { dst: Reg::RAX });
+                if let Some(slot) = self.local_slot(param) {
+                    self.ir.emit(ADeadOp::Mov { dst: slot, src: Operand::Reg(Reg::RAX) });
+                }
             }
-            Expr::Bool(b) => {
-                let val = if *b { 1 } else { 0 };
-                self.ir.emit(ADeadOp::Mov {
-                    dst: Operand::Reg(Reg::EAX),
-                    src: Operand::Imm32(val),
-                });
+            self.ir.emit(ADeadOp::Jmp { target: body_start });
+            return true;
+        }
+        // RDI/RSI (Linux) los restaura el epílogo: pasan por R10/R11
+        let staged: Vec<Reg> = (0..args.len())
+            .map(|i| match self.arg_register(i) {
+                Reg::RDI => Reg::R10,
+                Reg::RSI => Reg::R11,
+                reg => reg,
+            })
+            .collect();
+        for &reg in staged.iter().rev() {
+            self.ir.emit(ADeadOp::Pop { dst: reg });
+        }
+        self.emit_frame_teardown();
+        for (i, &reg) in staged.iter().enumerate() {
+            let dst = self.arg_register(i);
+            if dst != reg {
+                self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(dst), src: Operand::Reg(reg) });
             }
-            _ => self.emit_expression(expr),
         }
+        self.ir.emit(ADeadOp::Jmp { target: label });
+        true
     }
 
     // ========================================
-    // Expressions → RAX
+    // Register expression trees
     // ========================================
+    // Integer subtrees without side effects (locals, constants, + - * & | ^)
+    // are evaluated in the EXPR_REGS pool instead of push/pop through the
+    // stack. `reg_tree_need` is the Sethi-Ullman label: registers needed
+    // when the costlier child is evaluated first. None = not register-safe.
 
-    fn emit_expression(&mut self, expr: &Expr) {
+    fn reg_tree_need(&self, expr: &Expr) -> Option<usize> {
         match expr {
-            Expr::Number(n) => {
-                self.ir.emit(ADeadOp::Mov {
-                    dst: Operand::Reg(Reg::RAX),
-                    src: Operand::Imm64(*n as u64),
-                });
+            Expr::Number(_) | Expr::Bool(_) => Some(1),
+            Expr::Variable(name) => {
+                (self.reg_vars.contains_key(name.as_str()) || self.variables.contains_key(name.as_str()))
+                    .then_some(1)
             }
-            Expr::Float(f) => {
-                let bits = f.to_bits();
-                self.ir.emit(ADeadOp::Mov {
-                    dst: Operand::Reg(Reg::RAX),
-                    src: Operand::Imm64(bits),
-                });
+            Expr::IntCast(inner) | Expr::BitwiseNot(inner) => self.reg_tree_need(inner),
+            Expr::UnaryOp { op: UnaryOp::Neg, expr: inner } => self.reg_tree_need(inner),
+            Expr::BinaryOp { op, left, right } => {
+                let op = RegOp::from_bin(op)?;
+                if self.expr_is_float(left) || self.expr_is_float(right) {
+                    return None;
+                }
+                let stride = self.reg_tree_stride(op, left)?;
+                self.reg_pair_need(op, left, right, stride)
+            }
+            Expr::BitwiseOp { op, left, right } => {
+                let op = RegOp::from_bitwise(op)?;
+                self.reg_pair_need(op, left, right, 1)
+            }
+            _ => None,
+        }
+    }
+
+    fn reg_pair_need(&self, op: RegOp, left: &Expr, right: &Expr, stride: u8) -> Option<usize> {
+        let left_need = self.reg_tree_need(left)?;
+        if Self::reg_imm_operand(op, right, stride).is_some() || Self::reg_mul_plan(op, right).is_some() {
+            return Some(left_need);
+        }
+        let right_need = self.reg_tree_need(right)?;
+        Some(if left_need == right_need {
+            left_need + 1
+        } else {
+            left_need.max(right_need)
+        })
+    }
+
+    fn expr_is_float(&self, expr: &Expr) -> bool {
+        Self::expr_is_float_full(expr, &self.variable_types, &self.field_ir_types, &self.current_class)
+    }
+
+    /// Pointer stride applied to the right operand (1 = none). Only strides
+    /// that scale with a shift are register-safe.
+    fn reg_tree_stride(&self, op: RegOp, left: &Expr) -> Option<u8> {
+        if !matches!(op, RegOp::Add | RegOp::Sub) {
+            return Some(1);
+        }
+        match self.expr_pointer_stride(left) {
+            None => Some(1),
+            Some(s @ (1 | 2 | 4 | 8)) => Some(s),
+            Some(_) => None,
+        }
+    }
+
+    /// `x + 4`, `p - 1`: constant right operand folded into an imm32
+    fn reg_imm_operand(op: RegOp, right: &Expr, stride: u8) -> Option<i32> {
+        if !matches!(op, RegOp::Add | RegOp::Sub) {
+            return None;
+        }
+        match right {
+            Expr::Number(n) => n
+                .checked_mul(stride as i64)
+                .and_then(|v| i32::try_from(v).ok()),
+            _ => None,
+        }
+    }
+
+    /// `x * 40` → lea/shl sobre el propio registro (ver strength_reduce.rs)
+    fn reg_mul_plan(op: RegOp, right: &Expr) -> Option<Vec<MulStep>> {
+        match (op, right) {
+            (RegOp::Mul, Expr::Number(c)) => strength_reduce::mul_plan(*c),
+            _ => None,
+        }
+    }
+
+    /// Expressions whose evaluation can be moved before a register-safe
+    /// sibling without changing behavior (they only read memory)
+    fn expr_is_pure(expr: &Expr) -> bool {
+        match expr {
+            Expr::Number(_) | Expr::Float(_) | Expr::Bool(_) | Expr::Null | Expr::Nullptr
+            | Expr::Variable(_) | Expr::SizeOf(_) => true,
+            Expr::BinaryOp { left, right, .. }
+            | Expr::Comparison { left, right, .. }
+            | Expr::BitwiseOp { left, right, .. } => Self::expr_is_pure(left) && Self::expr_is_pure(right),
+            Expr::UnaryOp { expr: inner, .. }
+            | Expr::IntCast(inner)
+            | Expr::FloatCast(inner)
+            | Expr::BoolCast(inner)
+            | Expr::BitwiseNot(inner)
+            | Expr::Deref(inner)
+            | Expr::AddressOf(inner)
+            | Expr::Cast { expr: inner, .. } => Self::expr_is_pure(inner),
+            Expr::Index { object, index } => Self::expr_is_pure(object) && Self::expr_is_pure(index),
+            Expr::FieldAccess { object, .. } => Self::expr_is_pure(object),
+            Expr::ArrowAccess { pointer, .. } => Self::expr_is_pure(pointer),
+            Expr::Ternary { condition, then_expr, else_expr } => {
+                Self::expr_is_pure(condition) && Self::expr_is_pure(then_expr) && Self::expr_is_pure(else_expr)
+            }
+            _ => false,
+        }
+    }
+
+    /// Evaluate a register-safe tree into a register from the pool.
+    /// Never touches RAX or RBX; the caller frees the returned register.
+    fn emit_reg_tree(&mut self, expr: &Expr) -> Reg {
+        match expr {
+            Expr::Number(n) => {
+                let dst = self.alloc_expr_reg();
+                let src = match i32::try_from(*n) {
+                    Ok(v) => Operand::Imm32(v),
+                    Err(_) => Operand::Imm64(*n as u64),
+                };
+                self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(dst), src });
+                dst
             }
             Expr::Bool(b) => {
-                let val = if *b { 1u64 } else { 0u64 };
+                let dst = self.alloc_expr_reg();
                 self.ir.emit(ADeadOp::Mov {
-                    dst: Operand::Reg(Reg::RAX),
-                    src: Operand::Imm64(val),
+                    dst: Operand::Reg(dst),
+                    src: Operand::Imm32(*b as i32),
                 });
+                dst
             }
             Expr::Variable(name) => {
-                if let Some(&offset) = self.variables.get(name) {
-                    if self.array_vars.contains(name) {
-                        // Array variable: load its ADDRESS (LEA), not its value
-                        self.ir.emit(ADeadOp::Lea {
-                            dst: Reg::RAX,
-                            src: Operand::Mem {
-                                base: Reg::RBP,
-                                disp: offset,
-                            },
-                        });
-                    } else if self.ref_vars.contains(name) {
-                        // Reference variable: auto-deref (load pointer, then load value)
+                let dst = self.alloc_expr_reg();
+                if let Some(&reg) = self.reg_vars.get(name.as_str()) {
+                    self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(dst), src: Operand::Reg(reg) });
+                    return dst;
+                }
+                let offset = self.variables[name.as_str()];
+                let slot = Operand::Mem { base: Reg::RBP, disp: offset };
+                if self.array_vars.contains(name.as_str()) {
+                    self.ir.emit(ADeadOp::Lea { dst, src: slot });
+                } else {
+                    self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(dst), src: slot });
+                    if self.ref_vars.contains(name.as_str()) {
                         self.ir.emit(ADeadOp::Mov {
-                            dst: Operand::Reg(Reg::RAX),
+                            dst: Operand::Reg(dst),
+                            src: Operand::Mem { base: dst, disp: 0 },
+                        });
+                    }
+                }
+                dst
+            }
+            Expr::IntCast(inner) => self.emit_reg_tree(inner),
+            Expr::BitwiseNot(inner) => {
+                let dst = self.emit_reg_tree(inner);
+                self.ir.emit(ADeadOp::BitwiseNot { dst });
+                dst
+            }
+            Expr::UnaryOp { op: UnaryOp::Neg, expr: inner } => {
+                let dst = self.emit_reg_tree(inner);
+                self.ir.emit(ADeadOp::Neg { dst });
+                dst
+            }
+            Expr::BinaryOp { op, left, right } => {
+                let op = RegOp::from_bin(op).expect("emit_reg_tree: op is not register-safe");
+                let stride = self.reg_tree_stride(op, left).unwrap_or(1);
+                self.emit_reg_pair(op, left, right, stride)
+            }
+            Expr::BitwiseOp { op, left, right } => {
+                let op = RegOp::from_bitwise(op).expect("emit_reg_tree: op is not register-safe");
+                self.emit_reg_pair(op, left, right, 1)
+            }
+            _ => unreachable!("emit_reg_tree on a non register-safe expression"),
+        }
+    }
+
+    fn emit_reg_pair(&mut self, op: RegOp, left: &Expr, right: &Expr, stride: u8) -> Reg {
+        if let Some(imm) = Self::reg_imm_operand(op, right, stride) {
+            let dst = self.emit_reg_tree(left);
+            self.emit_reg_op(op, dst, Operand::Imm32(imm));
+            return dst;
+        }
+        if let Some(steps) = Self::reg_mul_plan(op, right) {
+            let dst = self.emit_reg_tree(left);
+            self.emit_mul_steps(dst, &steps);
+            return dst;
+        }
+        // Sethi-Ullman: el hijo que más registros necesita va primero
+        let left_need = self.reg_tree_need(left).unwrap_or(1);
+        let right_need = self.reg_tree_need(right).unwrap_or(1);
+        let (dst, src) = if right_need > left_need {
+            let src = self.emit_reg_tree(right);
+            (self.emit_reg_tree(left), src)
+        } else {
+            let dst = self.emit_reg_tree(left);
+            (dst, self.emit_reg_tree(right))
+        };
+        self.emit_stride_scale(src, stride);
+        self.emit_reg_op(op, dst, Operand::Reg(src));
+        self.temp_alloc.free(src);
+        dst
+    }
+
+    fn alloc_expr_reg(&mut self) -> Reg {
+        self.temp_alloc
+            .alloc()
+            .expect("expression register pool exhausted (reg_tree_need too low)")
+    }
+
+    fn emit_reg_op(&mut self, op: RegOp, dst: Reg, src: Operand) {
+        let src_reg = |src: &Operand| match src {
+            Operand::Reg(r) => *r,
+            _ => unreachable!("only add/sub take an immediate operand"),
+        };
+        match op {
+            RegOp::Add => self.ir.emit(ADeadOp::Add { dst: Operand::Reg(dst), src }),
+            RegOp::Sub => self.ir.emit(ADeadOp::Sub { dst: Operand::Reg(dst), src }),
+            RegOp::Mul => self.ir.emit(ADeadOp::Mul { dst, src: src_reg(&src) }),
+            RegOp::And => self.ir.emit(ADeadOp::And { dst, src: src_reg(&src) }),
+            RegOp::Or => self.ir.emit(ADeadOp::Or { dst, src: src_reg(&src) }),
+            RegOp::Xor => self.ir.emit(ADeadOp::Xor { dst, src: src_reg(&src) }),
+        }
+    }
+
+    /// Scale an integer operand by the element stride (pointer arithmetic).
+    /// Non power-of-two strides use RBX as scratch.
+    fn emit_stride_scale(&mut self, reg: Reg, stride: u8) {
+        match stride {
+            0 | 1 => {}
+            2 => self.ir.emit(ADeadOp::Shl { dst: reg, amount: 1 }),
+            4 => self.ir.emit(ADeadOp::Shl { dst: reg, amount: 2 }),
+            8 => self.ir.emit(ADeadOp::Shl { dst: reg, amount: 3 }),
+            _ => {
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RBX),
+                    src: Operand::Imm32(stride as i32),
+                });
+                self.ir.emit(ADeadOp::Mul { dst: reg, src: Reg::RBX });
+            }
+        }
+    }
+
+    /// Evaluate `left` into RAX and return where `right` ended up, already
+    /// scaled by `stride`:
+    ///   - right register-safe → pool register (no stack traffic)
+    ///   - left register-safe and right pure → right first, then RBX
+    ///   - otherwise → push/pop spill, right in RBX
+    /// With `allow_imm` a constant right operand comes back as Imm32.
+    /// The caller emits the op and then calls `release_operand`.
+    fn emit_int_operands(&mut self, left: &Expr, right: &Expr, stride: u8, allow_imm: bool) -> Operand {
+        if allow_imm {
+            if let Some(imm) = Self::reg_imm_operand(RegOp::Add, right, stride) {
+                self.emit_expression(left);
+                return Operand::Imm32(imm);
+            }
+        }
+
+        // Promoted local: its register is the operand (callee-saved, nothing
+        // in `left` can clobber it)
+        if let Expr::Variable(name) = right {
+            if let (Some(&reg), 0 | 1) = (self.reg_vars.get(name.as_str()), stride) {
+                self.emit_expression(left);
+                return Operand::Reg(reg);
+            }
+        }
+
+        let free = self.temp_alloc.available_count();
+        let scalable = matches!(stride, 0 | 1 | 2 | 4 | 8);
+        if scalable && self.reg_tree_need(right).map_or(false, |n| n <= free) {
+            self.emit_expression(left);
+            let src = self.emit_reg_tree(right);
+            self.emit_stride_scale(src, stride);
+            return Operand::Reg(src);
+        }
+
+        if self.reg_tree_need(left).map_or(false, |n| n <= free) && Self::expr_is_pure(right) {
+            self.emit_expression(right);
+            self.emit_stride_scale(Reg::RAX, stride);
+            let tmp = self.emit_reg_tree(left);
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Reg(Reg::RBX),
+                src: Operand::Reg(Reg::RAX),
+            });
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Reg(Reg::RAX),
+                src: Operand::Reg(tmp),
+            });
+            self.temp_alloc.free(tmp);
+            return Operand::Reg(Reg::RBX);
+        }
+
+        // Spill: push/pop — safe for nested calls and recursion
+        self.emit_expression(left);
+        self.ir.emit(ADeadOp::Push {
+            src: Operand::Reg(Reg::RAX),
+        });
+        self.emit_expression(right);
+        self.emit_stride_scale(Reg::RAX, stride);
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RBX),
+            src: Operand::Reg(Reg::RAX),
+        });
+        self.ir.emit(ADeadOp::Pop { dst: Reg::RAX });
+        Operand::Reg(Reg::RBX)
+    }
+
+    /// Return a register from `emit_int_operands` to the pool
+    fn release_operand(&mut self, operand: &Operand) {
+        if let Operand::Reg(reg) = operand {
+            self.temp_alloc.free(*reg);
+        }
+    }
+
+    /// Right operand as a register; IDIV clobbers RDX, so it never divides by it
+    fn operand_reg(&mut self, operand: &Operand, for_div: bool) -> Reg {
+        match operand {
+            Operand::Reg(Reg::RDX) if for_div => {
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RBX),
+                    src: Operand::Reg(Reg::RDX),
+                });
+                Reg::RBX
+            }
+            Operand::Reg(reg) => *reg,
+            _ => unreachable!("immediate operand where a register is required"),
+        }
+    }
+
+    // ========================================
+    // Strength reduction (ver strength_reduce.rs)
+    // ========================================
+
+    /// `x * c`, `x / c`, `x % c` con `c` constante, sin IMUL r,r ni IDIV.
+    /// Devuelve false sin emitir nada cuando la constante no compensa.
+    fn emit_strength_reduced(&mut self, op: &BinOp, left: &Expr, right: &Expr) -> bool {
+        let Some(c) = switch_lowering::case_value(right) else {
+            return false;
+        };
+        match op {
+            BinOp::Mul => {
+                let Some(steps) = strength_reduce::mul_plan(c) else {
+                    return false;
+                };
+                self.emit_expression(left);
+                self.emit_mul_steps(Reg::RAX, &steps);
+            }
+            BinOp::Div | BinOp::Mod => {
+                let Some(plan) = strength_reduce::div_plan(c) else {
+                    return false;
+                };
+                self.emit_expression(left);
+                if matches!(op, BinOp::Div) {
+                    self.emit_const_div(plan);
+                } else {
+                    self.emit_const_rem(plan, c);
+                }
+            }
+            _ => return false,
+        }
+        true
+    }
+
+    fn emit_mul_steps(&mut self, reg: Reg, steps: &[MulStep]) {
+        for step in steps {
+            match *step {
+                MulStep::Lea(scale) => self.ir.emit(ADeadOp::Lea {
+                    dst: reg,
+                    src: Operand::MemSIB { base: reg, index: reg, scale, disp: 0 },
+                }),
+                MulStep::Shl(amount) => self.ir.emit(ADeadOp::Shl { dst: reg, amount }),
+                MulStep::Neg => self.ir.emit(ADeadOp::Neg { dst: reg }),
+            }
+        }
+    }
+
+    /// RAX = RAX / d. Usa RDX; el plan mágico deja el dividendo en RCX.
+    fn emit_const_div(&mut self, plan: DivPlan) {
+        match plan {
+            DivPlan::Unit { negate } => {
+                if negate {
+                    self.ir.emit(ADeadOp::Neg { dst: Reg::RAX });
+                }
+            }
+            DivPlan::Shift { k, negate } => {
+                // Sesgo 2^k - 1 para negativos: el sar redondea hacia cero
+                self.emit_pow2_bias(k);
+                self.ir.emit(ADeadOp::Add {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Reg(Reg::RDX),
+                });
+                self.ir.emit(ADeadOp::Sar { dst: Reg::RAX, amount: k as u8 });
+                if negate {
+                    self.ir.emit(ADeadOp::Neg { dst: Reg::RAX });
+                }
+            }
+            DivPlan::Magic { magic, shift, fixup } => {
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RCX),
+                    src: Operand::Reg(Reg::RAX),
+                });
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RDX),
+                    src: Operand::Imm64(magic as u64),
+                });
+                self.ir.emit(ADeadOp::MulHigh { src: Reg::RDX });
+                match fixup {
+                    MagicFixup::None => {}
+                    MagicFixup::AddDividend => self.ir.emit(ADeadOp::Add {
+                        dst: Operand::Reg(Reg::RDX),
+                        src: Operand::Reg(Reg::RCX),
+                    }),
+                    MagicFixup::SubDividend => self.ir.emit(ADeadOp::Sub {
+                        dst: Operand::Reg(Reg::RDX),
+                        src: Operand::Reg(Reg::RCX),
+                    }),
+                }
+                if shift > 0 {
+                    self.ir.emit(ADeadOp::Sar { dst: Reg::RDX, amount: shift as u8 });
+                }
+                // +1 si el cociente estimado es negativo (truncar hacia cero)
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Reg(Reg::RDX),
+                });
+                self.ir.emit(ADeadOp::Shr { dst: Reg::RAX, amount: 63 });
+                self.ir.emit(ADeadOp::Add {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Reg(Reg::RDX),
+                });
+            }
+        }
+    }
+
+    /// RAX = RAX % d (signo del dividendo, como IDIV)
+    fn emit_const_rem(&mut self, plan: DivPlan, d: i64) {
+        match plan {
+            DivPlan::Unit { .. } => self.ir.emit(ADeadOp::Xor { dst: Reg::EAX, src: Reg::EAX }),
+            DivPlan::Shift { k, .. } => {
+                // ((x + sesgo) & (2^k - 1)) - sesgo
+                self.emit_pow2_bias(k);
+                self.ir.emit(ADeadOp::Add {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Reg(Reg::RDX),
+                });
+                let mask = (1u64 << k) - 1;
+                let src = match i32::try_from(mask) {
+                    Ok(v) => Operand::Imm32(v),
+                    Err(_) => Operand::Imm64(mask),
+                };
+                self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RCX), src });
+                self.ir.emit(ADeadOp::And { dst: Reg::RAX, src: Reg::RCX });
+                self.ir.emit(ADeadOp::Sub {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Reg(Reg::RDX),
+                });
+            }
+            DivPlan::Magic { .. } => {
+                // x - (x / d) * d; el dividendo sigue en RCX
+                self.emit_const_div(plan);
+                match strength_reduce::mul_plan(d) {
+                    Some(steps) => self.emit_mul_steps(Reg::RAX, &steps),
+                    None => {
+                        let src = match i32::try_from(d) {
+                            Ok(v) => Operand::Imm32(v),
+                            Err(_) => Operand::Imm64(d as u64),
+                        };
+                        self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RDX), src });
+                        self.ir.emit(ADeadOp::Mul { dst: Reg::RAX, src: Reg::RDX });
+                    }
+                }
+                self.ir.emit(ADeadOp::Sub {
+                    dst: Operand::Reg(Reg::RCX),
+                    src: Operand::Reg(Reg::RAX),
+                });
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Reg(Reg::RCX),
+                });
+            }
+        }
+    }
+
+    /// RDX = x < 0 ? 2^k - 1 : 0, con x en RAX
+    fn emit_pow2_bias(&mut self, k: u32) {
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RDX),
+            src: Operand::Reg(Reg::RAX),
+        });
+        if k > 1 {
+            self.ir.emit(ADeadOp::Sar { dst: Reg::RDX, amount: 63 });
+        }
+        self.ir.emit(ADeadOp::Shr { dst: Reg::RDX, amount: (64 - k) as u8 });
+    }
+
+    // ========================================
+    // Conditions
+    // ========================================
+
+    fn emit_condition(&mut self, expr: &Expr) {
+        match expr {
+            Expr::Comparison { op, left, right } => {
+                let rhs = self.emit_int_operands(left, right, 1, true);
+                self.ir.emit(ADeadOp::Cmp {
+                    left: Operand::Reg(Reg::RAX),
+                    right: rhs.clone(),
+                });
+                self.release_operand(&rhs);
+
+                let cond = match op {
+                    CmpOp::Eq => Condition::Equal,
+                    CmpOp::Ne => Condition::NotEqual,
+                    CmpOp::Lt => Condition::Less,
+                    CmpOp::Le => Condition::LessEq,
+                    CmpOp::Gt => Condition::Greater,
+                    CmpOp::Ge => Condition::GreaterEq,
+                };
+                self.ir.emit(ADeadOp::SetCC { cond, dst: Reg::AL });
+                self.ir.emit(ADeadOp::MovZx {
+                    dst: Reg::RAX,
+                    src: Reg::AL,
+                });
+            }
+            Expr::Bool(b) => {
+                let val = if *b { 1 } else { 0 };
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::EAX),
+                    src: Operand::Imm32(val),
+                });
+            }
+            _ => self.emit_expression(expr),
+        }
+    }
+
+    // ========================================
+    // Expressions → RAX
+    // ========================================
+
+    fn emit_expression(&mut self, expr: &Expr) {
+        match expr {
+            Expr::Number(n) => {
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Imm64(*n as u64),
+                });
+            }
+            Expr::Float(f) => {
+                let bits = f.to_bits();
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Imm64(bits),
+                });
+            }
+            Expr::Bool(b) => {
+                let val = if *b { 1u64 } else { 0u64 };
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Imm64(val),
+                });
+            }
+            Expr::Variable(name) => {
+                if let Some(&reg) = self.reg_vars.get(name) {
+                    self.ir.emit(ADeadOp::Mov {
+                        dst: Operand::Reg(Reg::RAX),
+                        src: Operand::Reg(reg),
+                    });
+                } else if let Some(&offset) = self.variables.get(name) {
+                    if self.array_vars.contains(name) {
+                        // Array variable: load its ADDRESS (LEA), not its value
+                        self.ir.emit(ADeadOp::Lea {
+                            dst: Reg::RAX,
+                            src: Operand::Mem {
+                                base: Reg::RBP,
+                                disp: offset,
+                            },
+                        });
+                    } else if self.ref_vars.contains(name) {
+                        // Reference variable: auto-deref (load pointer, then load value)
+                        self.ir.emit(ADeadOp::Mov {
+                            dst: Operand::Reg(Reg::RAX),
                             src: Operand::Mem {
                                 base: Reg::RBP,
                                 disp: offset,
@@ -3884,10 +6805,17 @@ impl IsaCompiler {
                             },
                         });
                     }
+                } else if self.global_arrays.contains_key(name) {
+                    // Global array: decays to the address of its storage
+                    let addr = self.get_global_address(name).unwrap_or(0);
+                    self.ir.emit(ADeadOp::Mov {
+                        dst: Operand::Reg(Reg::RAX),
+                        src: Operand::Imm64(addr),
+                    });
                 } else if self.global_vars.contains_key(name) {
                     // Global variable: load from absolute address in data section
                     self.emit_load_global(name);
-                } else if let Some(func_name) = &self.current_function.clone() {
+                } else if let Some(func_name) = &self.current_function {
                     // Check for static local: mangled as func::var
                     let mangled = format!("{}::{}", func_name, name);
                     if self.global_vars.contains_key(&mangled) {
@@ -3958,6 +6886,8 @@ impl IsaCompiler {
                     }
                     // Move result back to RAX
                     self.ir.emit(ADeadOp::MovQ { dst: Reg::RAX, src: Reg::XMM0 });
+                } else if !is_float_op && self.emit_strength_reduced(op, left, right) {
+                    // mul/div/mod por constante: shl/lea/magic ya emitidos
                 } else {
                     // Integer path: use GPR registers
                     // Pointer arithmetic: detect if left is pointer and scale right by element stride
@@ -3967,67 +6897,45 @@ impl IsaCompiler {
                         None
                     };
 
-                    self.emit_expression(left);
-                    self.ir.emit(ADeadOp::Push {
-                        src: Operand::Reg(Reg::RAX),
-                    });
-                    self.emit_expression(right);
+                    // Right operand scaled by the element stride for pointer arithmetic
+                    let allow_imm = matches!(op, BinOp::Add | BinOp::Sub);
+                    let rhs = self.emit_int_operands(left, right, ptr_stride.unwrap_or(1), allow_imm);
 
-                    // Scale the integer operand by element stride for pointer arithmetic
-                    if let Some(stride) = ptr_stride {
-                        if stride > 1 {
-                            match stride {
-                                2 => self.ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: 1 }),
-                                4 => self.ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: 2 }),
-                                8 => self.ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: 3 }),
-                                _ => {
-                                    // Non-power-of-2: multiply
-                                    self.ir.emit(ADeadOp::Mov {
-                                        dst: Operand::Reg(Reg::RBX),
-                                        src: Operand::Imm32(stride as i32),
-                                    });
-                                    self.ir.emit(ADeadOp::Mul { dst: Reg::RAX, src: Reg::RBX });
-                                }
-                            }
+                    match op {
+                        BinOp::Add => self.ir.emit(ADeadOp::Add {
+                            dst: Operand::Reg(Reg::RAX),
+                            src: rhs.clone(),
+                        }),
+                        BinOp::Sub => self.ir.emit(ADeadOp::Sub {
+                            dst: Operand::Reg(Reg::RAX),
+                            src: rhs.clone(),
+                        }),
+                        BinOp::Mul => {
+                            let src = self.operand_reg(&rhs, false);
+                            self.ir.emit(ADeadOp::Mul { dst: Reg::RAX, src });
+                        }
+                        BinOp::Div => {
+                            let src = self.operand_reg(&rhs, true);
+                            self.ir.emit(ADeadOp::Div { src });
                         }
-                    }
-
-                    self.ir.emit(ADeadOp::Mov {
-                        dst: Operand::Reg(Reg::RBX),
-                        src: Operand::Reg(Reg::RAX),
-                    });
-                    self.ir.emit(ADeadOp::Pop { dst: Reg::RAX });
-
-                    match op {
-                        BinOp::Add => self.ir.emit(ADeadOp::Add {
-                            dst: Operand::Reg(Reg::RAX),
-                            src: Operand::Reg(Reg::RBX),
-                        }),
-                        BinOp::Sub => self.ir.emit(ADeadOp::Sub {
-                            dst: Operand::Reg(Reg::RAX),
-                            src: Operand::Reg(Reg::RBX),
-                        }),
-                        BinOp::Mul => self.ir.emit(ADeadOp::Mul {
-                            dst: Reg::RAX,
-                            src: Reg::RBX,
-                        }),
-                        BinOp::Div => self.ir.emit(ADeadOp::Div { src: Reg::RBX }),
                         BinOp::Mod => {
-                            self.ir.emit(ADeadOp::Div { src: Reg::RBX });
+                            let src = self.operand_reg(&rhs, true);
+                            self.ir.emit(ADeadOp::Div { src });
                             self.ir.emit(ADeadOp::Mov {
                                 dst: Operand::Reg(Reg::RAX),
                                 src: Operand::Reg(Reg::RDX),
                             });
                         }
-                        BinOp::And => self.ir.emit(ADeadOp::And {
-                            dst: Reg::RAX,
-                            src: Reg::RBX,
-                        }),
-                        BinOp::Or => self.ir.emit(ADeadOp::Or {
-                            dst: Reg::RAX,
-                            src: Reg::RBX,
-                        }),
+                        BinOp::And => {
+                            let src = self.operand_reg(&rhs, false);
+                            self.ir.emit(ADeadOp::And { dst: Reg::RAX, src });
+                        }
+                        BinOp::Or => {
+                            let src = self.operand_reg(&rhs, false);
+                            self.ir.emit(ADeadOp::Or { dst: Reg::RAX, src });
+                        }
                     }
+                    self.release_operand(&rhs);
                 }
             }
             Expr::UnaryOp { op, expr: inner } => {
@@ -4145,63 +7053,28 @@ impl IsaCompiler {
             }
             // Bitwise operations — using register allocation
             Expr::BitwiseOp { op, left, right } => {
-                self.emit_expression(left);
-
-                if let Some(temp) = self.temp_alloc.alloc() {
-                    self.ir.emit(ADeadOp::Mov {
-                        dst: Operand::Reg(temp),
-                        src: Operand::Reg(Reg::RAX),
-                    });
-                    self.emit_expression(right);
-                    self.ir.emit(ADeadOp::Mov {
-                        dst: Operand::Reg(Reg::RBX),
-                        src: Operand::Reg(Reg::RAX),
-                    });
-                    self.ir.emit(ADeadOp::Mov {
-                        dst: Operand::Reg(Reg::RAX),
-                        src: Operand::Reg(temp),
-                    });
-                    self.temp_alloc.free(temp);
-                } else {
-                    self.ir.emit(ADeadOp::Push {
-                        src: Operand::Reg(Reg::RAX),
-                    });
-                    self.emit_expression(right);
-                    self.ir.emit(ADeadOp::Mov {
-                        dst: Operand::Reg(Reg::RBX),
-                        src: Operand::Reg(Reg::RAX),
-                    });
-                    self.ir.emit(ADeadOp::Pop { dst: Reg::RAX });
-                }
+                let rhs = self.emit_int_operands(left, right, 1, false);
+                let src = self.operand_reg(&rhs, false);
                 match op {
-                    BitwiseOp::And => self.ir.emit(ADeadOp::And {
-                        dst: Reg::RAX,
-                        src: Reg::RBX,
-                    }),
-                    BitwiseOp::Or => self.ir.emit(ADeadOp::Or {
-                        dst: Reg::RAX,
-                        src: Reg::RBX,
-                    }),
-                    BitwiseOp::Xor => self.ir.emit(ADeadOp::Xor {
-                        dst: Reg::RAX,
-                        src: Reg::RBX,
-                    }),
-                    BitwiseOp::LeftShift => {
-                        // RBX has the shift amount from right expression
-                        self.ir.emit(ADeadOp::Mov {
-                            dst: Operand::Reg(Reg::RCX),
-                            src: Operand::Reg(Reg::RBX),
-                        });
-                        self.ir.emit(ADeadOp::ShlCl { dst: Reg::RAX });
-                    }
-                    BitwiseOp::RightShift => {
-                        self.ir.emit(ADeadOp::Mov {
-                            dst: Operand::Reg(Reg::RCX),
-                            src: Operand::Reg(Reg::RBX),
-                        });
-                        self.ir.emit(ADeadOp::ShrCl { dst: Reg::RAX });
+                    BitwiseOp::And => self.ir.emit(ADeadOp::And { dst: Reg::RAX, src }),
+                    BitwiseOp::Or => self.ir.emit(ADeadOp::Or { dst: Reg::RAX, src }),
+                    BitwiseOp::Xor => self.ir.emit(ADeadOp::Xor { dst: Reg::RAX, src }),
+                    BitwiseOp::LeftShift | BitwiseOp::RightShift => {
+                        // Shift amount must be in CL
+                        if src != Reg::RCX {
+                            self.ir.emit(ADeadOp::Mov {
+                                dst: Operand::Reg(Reg::RCX),
+                                src: Operand::Reg(src),
+                            });
+                        }
+                        if matches!(op, BitwiseOp::LeftShift) {
+                            self.ir.emit(ADeadOp::ShlCl { dst: Reg::RAX });
+                        } else {
+                            self.ir.emit(ADeadOp::ShrCl { dst: Reg::RAX });
+                        }
                     }
                 }
+                self.release_operand(&rhs);
             }
             Expr::BitwiseNot(inner) => {
                 self.emit_expression(inner);
@@ -4210,21 +7083,15 @@ impl IsaCompiler {
             Expr::PostIncrement(inner) => {
                 // Post: return old value, then increment in memory
                 if let Expr::Variable(name) = inner.as_ref() {
-                    if let Some(&offset) = self.variables.get(name.as_str()) {
+                    if let Some(slot) = self.local_slot(name) {
                         // Load old value into RAX (this is the return value)
                         self.ir.emit(ADeadOp::Mov {
                             dst: Operand::Reg(Reg::RAX),
-                            src: Operand::Mem {
-                                base: Reg::RBP,
-                                disp: offset,
-                            },
+                            src: slot.clone(),
                         });
                         // Increment the variable in memory
                         self.ir.emit(ADeadOp::Inc {
-                            dst: Operand::Mem {
-                                base: Reg::RBP,
-                                disp: offset,
-                            },
+                            dst: slot.clone(),
                         });
                         // RAX still has old value
                     }
@@ -4238,21 +7105,15 @@ impl IsaCompiler {
             Expr::PreIncrement(inner) => {
                 // Pre: increment in memory, then return new value
                 if let Expr::Variable(name) = inner.as_ref() {
-                    if let Some(&offset) = self.variables.get(name.as_str()) {
+                    if let Some(slot) = self.local_slot(name) {
                         // Increment the variable in memory first
                         self.ir.emit(ADeadOp::Inc {
-                            dst: Operand::Mem {
-                                base: Reg::RBP,
-                                disp: offset,
-                            },
+                            dst: slot.clone(),
                         });
                         // Load new value into RAX
                         self.ir.emit(ADeadOp::Mov {
                             dst: Operand::Reg(Reg::RAX),
-                            src: Operand::Mem {
-                                base: Reg::RBP,
-                                disp: offset,
-                            },
+                            src: slot.clone(),
                         });
                     }
                 } else {
@@ -4264,19 +7125,13 @@ impl IsaCompiler {
             }
             Expr::PostDecrement(inner) => {
                 if let Expr::Variable(name) = inner.as_ref() {
-                    if let Some(&offset) = self.variables.get(name.as_str()) {
+                    if let Some(slot) = self.local_slot(name) {
                         self.ir.emit(ADeadOp::Mov {
                             dst: Operand::Reg(Reg::RAX),
-                            src: Operand::Mem {
-                                base: Reg::RBP,
-                                disp: offset,
-                            },
+                            src: slot.clone(),
                         });
                         self.ir.emit(ADeadOp::Dec {
-                            dst: Operand::Mem {
-                                base: Reg::RBP,
-                                disp: offset,
-                            },
+                            dst: slot.clone(),
                         });
                     }
                 } else {
@@ -4288,19 +7143,13 @@ impl IsaCompiler {
             }
             Expr::PreDecrement(inner) => {
                 if let Expr::Variable(name) = inner.as_ref() {
-                    if let Some(&offset) = self.variables.get(name.as_str()) {
+                    if let Some(slot) = self.local_slot(name) {
                         self.ir.emit(ADeadOp::Dec {
-                            dst: Operand::Mem {
-                                base: Reg::RBP,
-                                disp: offset,
-                            },
+                            dst: slot.clone(),
                         });
                         self.ir.emit(ADeadOp::Mov {
                             dst: Operand::Reg(Reg::RAX),
-                            src: Operand::Mem {
-                                base: Reg::RBP,
-                                disp: offset,
-                            },
+                            src: slot.clone(),
                         });
                     }
                 } else {
@@ -4333,9 +7182,7 @@ impl IsaCompiler {
                     .replace("\\n", "\n")
                     .replace("\\t", "\t")
                     .replace("\\r", "\r");
-                if !self.strings.contains(&processed) {
-                    self.strings.push(processed.clone());
-                }
+                self.strings.add(processed.clone());
                 let addr = self.get_string_address(&processed);
                 self.ir.emit(ADeadOp::Mov {
                     dst: Operand::Reg(Reg::RAX),
@@ -4768,6 +7615,9 @@ impl IsaCompiler {
                     });
                 }
             }
+            Expr::VirtualCall { object, slot, args } => {
+                self.emit_virtual_call(object, *slot, args);
+            }
             // ========== TERNARY: cond ? then : else ==========
             Expr::Ternary {
                 condition,
@@ -4855,6 +7705,18 @@ impl IsaCompiler {
                             disp: 0,
                         },
                     });
+                } else if let Some(stride) = self.pointer_field_stride(object) {
+                    // s.p[i] con `p` puntero: cargar el campo y indexar
+                    self.emit_expression(index);
+                    self.emit_index_scale(stride);
+                    self.ir.emit(ADeadOp::Push { src: Operand::Reg(Reg::RAX) });
+                    self.emit_expression(object);
+                    self.ir.emit(ADeadOp::Pop { dst: Reg::RBX });
+                    self.ir.emit(ADeadOp::Add {
+                        dst: Operand::Reg(Reg::RBX),
+                        src: Operand::Reg(Reg::RAX),
+                    });
+                    self.emit_load_with_stride(Reg::RBX, stride);
                 } else if let Expr::FieldAccess { object: fa_obj, field: fa_field } = object.as_ref() {
                     // Handle struct_field[index] like v.bytes[0]
                     // The field is an array inside a struct — use its stack address
@@ -4880,7 +7742,7 @@ impl IsaCompiler {
                                     if let Some(ty) = self.variable_types.get(obj_name) {
                                         match ty {
                                             Type::Struct(sn) | Type::Named(sn) | Type::Class(sn) => {
-                                                if let Some(fty) = self.field_ir_types.get(&(sn.clone(), fa_field.clone())) {
+                                                if let Some(fty) = Self::field_ir_type(&self.field_ir_types, sn, fa_field) {
                                                     match fty {
                                                         Type::Array(inner, _) => {
                                                             match inner.as_ref() {
@@ -5080,6 +7942,14 @@ impl IsaCompiler {
                                     });
                                 }
                             }
+                        } else if let Some(disp) = Self::const_index_disp(index, self.element_stride(name)) {
+                            // POINTER VARIABLE, índice constante: [ptr + k*stride]
+                            let stride = self.element_stride(name);
+                            self.ir.emit(ADeadOp::Mov {
+                                dst: Operand::Reg(Reg::RBX),
+                                src: Operand::Mem { base: Reg::RBP, disp: base_offset },
+                            });
+                            self.emit_sized_load(Reg::RBX, disp, stride as i32);
                         } else {
                             // POINTER VARIABLE (e.g. function parameter int *arr):
                             // Load pointer value, then index: [ptr + i*stride]
@@ -5110,6 +7980,20 @@ impl IsaCompiler {
                             });
                             self.emit_load_with_stride(Reg::RBX, stride);
                         }
+                    } else if let Some(stride) = self.global_array_stride(name) {
+                        // GLOBAL ARRAY: [addr + i*stride]
+                        let addr = self.get_global_address(name).unwrap_or(0);
+                        self.emit_expression(index);
+                        self.emit_index_scale(stride);
+                        self.ir.emit(ADeadOp::Mov {
+                            dst: Operand::Reg(Reg::RBX),
+                            src: Operand::Imm64(addr),
+                        });
+                        self.ir.emit(ADeadOp::Add {
+                            dst: Operand::Reg(Reg::RBX),
+                            src: Operand::Reg(Reg::RAX),
+                        });
+                        self.emit_load_with_stride(Reg::RBX, stride);
                     } else {
                         // Unknown variable - evaluate as pointer expression
                         self.emit_expression(index);
@@ -5196,7 +8080,12 @@ impl IsaCompiler {
             // ========== ADDRESS-OF: &var ==========
             Expr::AddressOf(inner) => {
                 if let Expr::Variable(name) = inner.as_ref() {
-                    if let Some(&offset) = self.variables.get(name.as_str()) {
+                    if self.variables.contains_key(name.as_str())
+                        && (self.struct_params.contains(name.as_str()) || self.ref_vars.contains(name.as_str()))
+                    {
+                        // Por referencia: la dirección es el puntero del slot
+                        self.emit_struct_address(inner);
+                    } else if let Some(&offset) = self.variables.get(name.as_str()) {
                         self.ir.emit(ADeadOp::Lea {
                             dst: Reg::RAX,
                             src: Operand::Mem {
@@ -5212,7 +8101,7 @@ impl IsaCompiler {
                                 src: Operand::Imm64(abs_addr),
                             });
                         }
-                    } else if let Some(func_name) = &self.current_function.clone() {
+                    } else if let Some(func_name) = &self.current_function {
                         // Try static-local mangled name
                         let mangled = format!("{}::{}", func_name, name);
                         if let Some(abs_addr) = self.get_global_address(&mangled) {
@@ -5437,129 +8326,1031 @@ impl IsaCompiler {
             }
             // ========== MALLOC ==========
             Expr::Malloc(size_expr) => {
-                // Evaluate size argument → RCX (first arg, Windows x64 ABI)
+                // Evaluate size argument → first arg register
                 self.emit_expression(size_expr);
                 self.ir.emit(ADeadOp::Mov {
-                    dst: Operand::Reg(Reg::RCX),
+                    dst: Operand::Reg(self.arg_register(0)),
                     src: Operand::Reg(Reg::RAX),
                 });
-                // Call malloc via dynamic IAT lookup
-                self.emit_call_iat("malloc");
+                // Built-in heap, or malloc via dynamic IAT lookup
+                self.emit_heap_call("malloc");
                 // Result (pointer) is in RAX
             }
-            // ========== REALLOC ==========
-            Expr::Realloc { ptr, new_size } => {
-                // realloc(ptr, new_size) — Windows x64 ABI: RCX=ptr, RDX=new_size
-                self.emit_expression(new_size);
-                self.ir.emit(ADeadOp::Push {
-                    src: Operand::Reg(Reg::RAX),
-                });
-                self.emit_expression(ptr);
+            // ========== REALLOC ==========
+            Expr::Realloc { ptr, new_size } => {
+                // realloc(ptr, new_size) — first two arg registers
+                self.emit_expression(new_size);
+                self.ir.emit(ADeadOp::Push {
+                    src: Operand::Reg(Reg::RAX),
+                });
+                self.emit_expression(ptr);
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(self.arg_register(0)),
+                    src: Operand::Reg(Reg::RAX),
+                });
+                self.ir.emit(ADeadOp::Pop { dst: self.arg_register(1) });
+                self.emit_heap_call("realloc");
+            }
+            // ========== CAST ==========
+            Expr::Cast {
+                target_type,
+                expr: inner,
+            } => {
+                let inner_is_float = Self::expr_is_float_full(
+                    inner,
+                    &self.variable_types,
+                    &self.field_ir_types,
+                    &self.current_class,
+                );
+                let target_is_float = match target_type {
+                    Type::F32 | Type::F64 => true,
+                    Type::Named(n) if n == "float" || n == "double" => true,
+                    _ => false,
+                };
+                let _target_is_int = match target_type {
+                    Type::I8 | Type::U8 | Type::I16 | Type::U16
+                    | Type::I32 | Type::U32 | Type::I64 | Type::U64 => true,
+                    Type::Named(n) if n == "int" || n == "unsigned int" || n == "unsigned"
+                        || n == "long" || n == "long long" || n == "short" || n == "char" => true,
+                    _ => false,
+                };
+
+                self.emit_expression(inner);
+
+                if inner_is_float && !target_is_float {
+                    // float/double → int: CVTTSD2SI (truncate double to integer)
+                    // Value is in RAX as bit-pattern; move to XMM0 first
+                    self.ir.emit(ADeadOp::MovQ {
+                        dst: Reg::XMM0,
+                        src: Reg::RAX,
+                    });
+                    self.ir.emit(ADeadOp::CvtTsd2Si {
+                        dst: Reg::RAX,
+                        src: Reg::XMM0,
+                    });
+                } else if !inner_is_float && target_is_float {
+                    // int → float/double: CVTSI2SD (integer to double)
+                    self.ir.emit(ADeadOp::CvtSi2Sd {
+                        dst: Reg::XMM0,
+                        src: Reg::RAX,
+                    });
+                    self.ir.emit(ADeadOp::MovQ {
+                        dst: Reg::RAX,
+                        src: Reg::XMM0,
+                    });
+                } else {
+                    // Integer truncation based on target type size
+                    let target_size = crate::isa::c_isa::c99_sizeof_for_expr(target_type);
+                    match target_size {
+                        1 => {
+                            self.ir.emit(ADeadOp::MovZx {
+                                dst: Reg::RAX,
+                                src: Reg::AL,
+                            });
+                        }
+                        2 => {
+                            self.ir.emit(ADeadOp::Mov {
+                                dst: Operand::Reg(Reg::RBX),
+                                src: Operand::Imm32(0xFFFF),
+                            });
+                            self.ir.emit(ADeadOp::And {
+                                dst: Reg::RAX,
+                                src: Reg::RBX,
+                            });
+                        }
+                        4 => {
+                            self.ir.emit(ADeadOp::Mov {
+                                dst: Operand::Reg(Reg::EAX),
+                                src: Operand::Reg(Reg::EAX),
+                            });
+                        }
+                        _ => {
+                            // 8 bytes or unknown — no truncation needed
+                        }
+                    }
+                }
+            }
+            // ========== NEW (C++) ==========
+            // Storage for the object from the heap; constructors are not run
+            Expr::New { class_name, .. } if self.target != Target::Raw => {
+                let size = self.class_layouts.get(class_name).map_or(8, |l| l.size.max(1));
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(self.arg_register(0)),
+                    src: Operand::Imm32(size),
+                });
+                self.emit_heap_call("malloc");
+                // Clase polimórfica: vptr en el offset 0
+                if let Some(vtable) = self.vtable_address(class_name) {
+                    self.ir.emit(ADeadOp::Mov {
+                        dst: Operand::Reg(Reg::R11),
+                        src: Operand::Imm64(vtable),
+                    });
+                    self.ir.emit(ADeadOp::Mov {
+                        dst: Operand::Mem { base: Reg::RAX, disp: 0 },
+                        src: Operand::Reg(Reg::R11),
+                    });
+                }
+            }
+            _ => {
+                self.ir.emit(ADeadOp::Xor {
+                    dst: Reg::RAX,
+                    src: Reg::RAX,
+                });
+            }
+        }
+    }
+
+    // ========================================
+    // Builtins de memoria (ver mem_builtins.rs)
+    // ========================================
+
+    fn emit_mem_builtin(&mut self, builtin: MemBuiltin, args: &[Expr]) {
+        match builtin {
+            MemBuiltin::Memcpy => {
+                let size = self.emit_block_args(&[(&args[0], Reg::RDI), (&args[1], Reg::RSI)], &args[2]);
+                self.emit_mem_copy(size);
+            }
+            MemBuiltin::Memset => match switch_lowering::case_value(&args[1]) {
+                Some(fill) => {
+                    let size = self.emit_block_args(&[(&args[0], Reg::RDI)], &args[2]);
+                    let pattern = (fill as u8 as u64).wrapping_mul(0x0101_0101_0101_0101);
+                    self.ir.emit(ADeadOp::Mov {
+                        dst: Operand::Reg(Reg::RAX),
+                        src: Operand::Imm64(pattern),
+                    });
+                    self.emit_mem_fill(size);
+                }
+                None => {
+                    let size = self.emit_block_args(&[(&args[0], Reg::RDI), (&args[1], Reg::RAX)], &args[2]);
+                    // (c & 0xFF) * 0x0101010101010101 → el byte en las 8 posiciones
+                    self.ir.emit(ADeadOp::Mov {
+                        dst: Operand::Reg(Reg::RDX),
+                        src: Operand::Imm32(0xFF),
+                    });
+                    self.ir.emit(ADeadOp::And { dst: Reg::RAX, src: Reg::RDX });
+                    self.ir.emit(ADeadOp::Mov {
+                        dst: Operand::Reg(Reg::RDX),
+                        src: Operand::Imm64(0x0101_0101_0101_0101),
+                    });
+                    self.ir.emit(ADeadOp::Mul { dst: Reg::RAX, src: Reg::RDX });
+                    self.emit_mem_fill(size);
+                }
+            },
+            MemBuiltin::Memcmp => {
+                // a → RSI, b → RDI: cmpsb deja los flags de a - b
+                let size = self.emit_block_args(&[(&args[0], Reg::RSI), (&args[1], Reg::RDI)], &args[2]);
+                self.emit_mem_compare(size);
+            }
+            MemBuiltin::Strlen => {
+                if let Some(len) = Self::literal_strlen(&args[0]) {
+                    self.ir.emit(ADeadOp::Mov {
+                        dst: Operand::Reg(Reg::RAX),
+                        src: Operand::Imm32(len),
+                    });
+                    return;
+                }
+                self.emit_expression(&args[0]);
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RDI),
+                    src: Operand::Reg(Reg::RAX),
+                });
+                self.emit_strlen();
+            }
+        }
+    }
+
+    /// Tamaño del struct local `name` si `value` es otro struct entero
+    /// (variable del mismo tipo, `*p` o una llamada que lo devuelve por valor)
+    fn struct_assign_size(&self, name: &str, value: &Expr) -> Option<u64> {
+        if self.reg_vars.contains_key(name) || !self.variables.contains_key(name) {
+            return None;
+        }
+        let ty = self.variable_types.get(name)?;
+        let size = self.struct_type_size(ty)?;
+        match value {
+            Expr::Variable(src) if self.variables.contains_key(src.as_str()) => {
+                (self.variable_types.get(src.as_str()) == Some(ty)).then_some(size)
+            }
+            Expr::Deref(_) => Some(size),
+            Expr::Call { name: callee, args } => {
+                let (_, ret) = self.call_abi(callee, args.len())?;
+                (ret != ArgPass::Value && self.functions.get(callee)?.return_type == *ty).then_some(size)
+            }
+            _ => None,
+        }
+    }
+
+    fn struct_type_size(&self, ty: &Type) -> Option<u64> {
+        match ty {
+            Type::Struct(n) | Type::Class(n) | Type::Named(n) => {
+                self.class_layouts.get(n).map(|layout| layout.size as u64)
+            }
+            _ => None,
+        }
+    }
+
+    fn emit_struct_assign(&mut self, name: &str, value: &Expr, size: u64) {
+        let emitted = self.emit_struct_address(value);
+        debug_assert!(emitted, "struct_assign_size only accepts addressable structs");
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RSI),
+            src: Operand::Reg(Reg::RAX),
+        });
+        // Destino por referencia (parámetro struct o T&): a través del puntero
+        let slot = Operand::Mem { base: Reg::RBP, disp: self.variables[name] };
+        if self.struct_params.contains(name) || self.ref_vars.contains(name) {
+            self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RDI), src: slot });
+        } else {
+            self.ir.emit(ADeadOp::Lea { dst: Reg::RDI, src: slot });
+        }
+        self.emit_mem_copy(Some(size));
+    }
+
+    /// `strlen("abc")` → 3 (solo literales sin escapes pendientes)
+    fn literal_strlen(expr: &Expr) -> Option<i32> {
+        match expr {
+            Expr::String(s) if !s.contains('\\') => i32::try_from(s.len()).ok(),
+            _ => None,
+        }
+    }
+
+    /// Evalúa los operandos en orden y los deja en sus registros; el tamaño
+    /// va a RCX. Un tamaño constante no se evalúa: se devuelve.
+    fn emit_block_args(&mut self, operands: &[(&Expr, Reg)], size: &Expr) -> Option<u64> {
+        let constant = switch_lowering::case_value(size).and_then(|n| u64::try_from(n).ok());
+        for (expr, _) in operands {
+            self.emit_expression(expr);
+            self.ir.emit(ADeadOp::Push { src: Operand::Reg(Reg::RAX) });
+        }
+        if constant.is_none() {
+            self.emit_expression(size);
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Reg(Reg::RCX),
+                src: Operand::Reg(Reg::RAX),
+            });
+        }
+        for &(_, reg) in operands.iter().rev() {
+            self.ir.emit(ADeadOp::Pop { dst: reg });
+        }
+        constant
+    }
+
+    /// RCX = tamaño constante del bloque (los caminos rep/vector)
+    fn emit_block_count(&mut self, size: Option<u64>) {
+        if let Some(n) = size {
+            let src = match i32::try_from(n) {
+                Ok(v) => Operand::Imm32(v),
+                Err(_) => Operand::Imm64(n),
+            };
+            self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RCX), src });
+        }
+    }
+
+    /// Bucle de bloques de 32 bytes mientras RCX >= 32; `body` procesa un
+    /// bloque, el bucle avanza los punteros. Con `stop_on_mismatch` un
+    /// `vptest` con ZF = 0 sale antes. Termina en vzeroupper.
+    fn emit_vector_blocks(&mut self, body: &[AvxInst], pointers: &[Reg], stop_on_mismatch: bool) {
+        let vloop = self.ir.new_label();
+        let tail = self.ir.new_label();
+        self.ir.emit(ADeadOp::Label(vloop));
+        self.ir.emit(ADeadOp::Cmp {
+            left: Operand::Reg(Reg::RCX),
+            right: Operand::Imm32(mem_builtins::VECTOR_BLOCK),
+        });
+        self.ir.emit(ADeadOp::Jcc { cond: Condition::Below, target: tail });
+        self.emit_avx(body);
+        if stop_on_mismatch {
+            // El bloque difiere: la cola byte a byte localiza el primer byte
+            self.ir.emit(ADeadOp::Jcc { cond: Condition::NotEqual, target: tail });
+        }
+        for &reg in pointers {
+            self.ir.emit(ADeadOp::Add {
+                dst: Operand::Reg(reg),
+                src: Operand::Imm32(mem_builtins::VECTOR_BLOCK),
+            });
+        }
+        self.ir.emit(ADeadOp::Sub {
+            dst: Operand::Reg(Reg::RCX),
+            src: Operand::Imm32(mem_builtins::VECTOR_BLOCK),
+        });
+        self.ir.emit(ADeadOp::Jmp { target: vloop });
+        self.ir.emit(ADeadOp::Label(tail));
+        self.emit_avx(&[AvxInst::Vzeroupper]);
+    }
+
+    /// [RDI..] ← [RSI..]; RAX = destino
+    fn emit_mem_copy(&mut self, size: Option<u64>) {
+        match mem_builtins::block_strategy(size, self.bit_target) {
+            BlockStrategy::Inline(chunks) => {
+                for (disp, width) in chunks {
+                    self.emit_sized_load(Reg::RSI, disp, width as i32);
+                    self.emit_sized_store(Reg::RDI, disp, width as i32, Reg::RAX);
+                }
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Reg(Reg::RDI),
+                });
+            }
+            strategy => {
+                self.emit_block_count(size);
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Reg(Reg::RDI),
+                });
+                if strategy == BlockStrategy::Vector {
+                    let ymm = YmmReg(0);
+                    self.emit_vector_blocks(
+                        &[
+                            AvxInst::VmovdquLoad { dst: ymm, mem: VexMem::base(6, 0) },
+                            AvxInst::VmovdquStore { src: ymm, mem: VexMem::base(7, 0) },
+                        ],
+                        &[Reg::RSI, Reg::RDI],
+                        false,
+                    );
+                }
+                self.ir.emit(ADeadOp::Rep { op: Box::new(ADeadOp::Movsb) });
+            }
+        }
+    }
+
+    /// [RDI..] ← patrón de RAX (el byte repetido 8 veces); RAX = destino
+    fn emit_mem_fill(&mut self, size: Option<u64>) {
+        match mem_builtins::block_strategy(size, self.bit_target) {
+            BlockStrategy::Inline(chunks) => {
+                for (disp, width) in chunks {
+                    self.emit_sized_store(Reg::RDI, disp, width as i32, Reg::RAX);
+                }
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Reg(Reg::RDI),
+                });
+            }
+            strategy => {
+                self.emit_block_count(size);
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RDX),
+                    src: Operand::Reg(Reg::RDI),
+                });
+                if strategy == BlockStrategy::Vector {
+                    let ymm = YmmReg(0);
+                    self.emit_avx(&[
+                        AvxInst::VmovqFromGp { dst: ymm, src: 0 },
+                        AvxInst::Vpbroadcast { lane: 1, dst: ymm, src: ymm },
+                    ]);
+                    self.emit_vector_blocks(
+                        &[AvxInst::VmovdquStore { src: ymm, mem: VexMem::base(7, 0) }],
+                        &[Reg::RDI],
+                        false,
+                    );
+                }
+                self.ir.emit(ADeadOp::Rep { op: Box::new(ADeadOp::Stosb) });
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Reg(Reg::RDX),
+                });
+            }
+        }
+    }
+
+    /// RAX = memcmp(RSI, RDI, n): < 0, 0 o > 0 según el primer byte distinto
+    fn emit_mem_compare(&mut self, size: Option<u64>) {
+        let done = self.ir.new_label();
+        match mem_builtins::block_strategy(size, self.bit_target) {
+            BlockStrategy::Inline(chunks) => {
+                let differ = self.ir.new_label();
+                for (disp, width) in chunks {
+                    self.emit_sized_load(Reg::RDI, disp, width as i32);
+                    self.ir.emit(ADeadOp::Mov {
+                        dst: Operand::Reg(Reg::RDX),
+                        src: Operand::Reg(Reg::RAX),
+                    });
+                    self.emit_sized_load(Reg::RSI, disp, width as i32);
+                    self.ir.emit(ADeadOp::Cmp {
+                        left: Operand::Reg(Reg::RAX),
+                        right: Operand::Reg(Reg::RDX),
+                    });
+                    self.ir.emit(ADeadOp::Jcc { cond: Condition::NotEqual, target: differ });
+                }
+                self.ir.emit(ADeadOp::Xor { dst: Reg::EAX, src: Reg::EAX });
+                self.ir.emit(ADeadOp::Jmp { target: done });
+                // Big-endian: el primer byte distinto decide la comparación sin signo
+                self.ir.emit(ADeadOp::Label(differ));
+                self.ir.emit(ADeadOp::Bswap { dst: Reg::RAX });
+                self.ir.emit(ADeadOp::Bswap { dst: Reg::RDX });
+                self.ir.emit(ADeadOp::Cmp {
+                    left: Operand::Reg(Reg::RAX),
+                    right: Operand::Reg(Reg::RDX),
+                });
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Imm32(-1),
+                });
+                self.ir.emit(ADeadOp::Jcc { cond: Condition::Below, target: done });
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Imm32(1),
+                });
+            }
+            strategy => {
+                self.emit_block_count(size);
+                if strategy == BlockStrategy::Vector {
+                    let (a, b) = (YmmReg(0), YmmReg(1));
+                    self.emit_vector_blocks(
+                        &[
+                            AvxInst::VmovdquLoad { dst: a, mem: VexMem::base(6, 0) },
+                            AvxInst::VmovdquLoad { dst: b, mem: VexMem::base(7, 0) },
+                            AvxInst::Vpxor { dst: a, src1: a, src2: b },
+                            AvxInst::Vptest { src1: a, src2: a },
+                        ],
+                        &[Reg::RSI, Reg::RDI],
+                        true,
+                    );
+                }
+                // repe cmpsb con RCX = 0 no toca los flags: ese caso sale antes
+                self.ir.emit(ADeadOp::Xor { dst: Reg::EAX, src: Reg::EAX });
+                self.ir.emit(ADeadOp::Test { left: Reg::RCX, right: Reg::RCX });
+                self.ir.emit(ADeadOp::Jcc { cond: Condition::Equal, target: done });
+                self.ir.emit(ADeadOp::Rep { op: Box::new(ADeadOp::Cmpsb) });
+                self.ir.emit(ADeadOp::Jcc { cond: Condition::Equal, target: done });
+                self.ir.emit(ADeadOp::Load8 { dst: Reg::RAX, base: Reg::RSI, disp: -1 });
+                self.ir.emit(ADeadOp::Load8 { dst: Reg::RDX, base: Reg::RDI, disp: -1 });
+                self.ir.emit(ADeadOp::Sub {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Reg(Reg::RDX),
+                });
+            }
+        }
+        self.ir.emit(ADeadOp::Label(done));
+    }
+
+    /// RAX = strlen(RDI). Alinea a 8 byte a byte y luego busca el NUL de
+    /// 8 en 8 ((w - 0x01..) & !w & 0x80..): una lectura alineada nunca
+    /// cruza de página.
+    fn emit_strlen(&mut self) {
+        let head = self.ir.new_label();
+        let words = self.ir.new_label();
+        let tail = self.ir.new_label();
+        let done = self.ir.new_label();
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RDX),
+            src: Operand::Reg(Reg::RDI),
+        });
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::R8),
+            src: Operand::Imm32(7),
+        });
+        self.ir.emit(ADeadOp::Label(head));
+        self.ir.emit(ADeadOp::Test { left: Reg::RDI, right: Reg::R8 });
+        self.ir.emit(ADeadOp::Jcc { cond: Condition::Equal, target: words });
+        self.emit_strlen_byte_step(head, done);
+
+        self.ir.emit(ADeadOp::Label(words));
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::R8),
+            src: Operand::Imm64(0x0101_0101_0101_0101),
+        });
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::R9),
+            src: Operand::Imm64(0x8080_8080_8080_8080),
+        });
+        let wloop = self.ir.new_label();
+        self.ir.emit(ADeadOp::Label(wloop));
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RAX),
+            src: Operand::Mem { base: Reg::RDI, disp: 0 },
+        });
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RCX),
+            src: Operand::Reg(Reg::RAX),
+        });
+        self.ir.emit(ADeadOp::Sub {
+            dst: Operand::Reg(Reg::RCX),
+            src: Operand::Reg(Reg::R8),
+        });
+        self.ir.emit(ADeadOp::BitwiseNot { dst: Reg::RAX });
+        self.ir.emit(ADeadOp::And { dst: Reg::RCX, src: Reg::RAX });
+        self.ir.emit(ADeadOp::And { dst: Reg::RCX, src: Reg::R9 });
+        self.ir.emit(ADeadOp::Jcc { cond: Condition::NotEqual, target: tail });
+        self.ir.emit(ADeadOp::Add {
+            dst: Operand::Reg(Reg::RDI),
+            src: Operand::Imm32(8),
+        });
+        self.ir.emit(ADeadOp::Jmp { target: wloop });
+
+        // La palabra contiene el NUL: localizarlo byte a byte
+        self.ir.emit(ADeadOp::Label(tail));
+        self.emit_strlen_byte_step(tail, done);
+
+        self.ir.emit(ADeadOp::Label(done));
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RAX),
+            src: Operand::Reg(Reg::RDI),
+        });
+        self.ir.emit(ADeadOp::Sub {
+            dst: Operand::Reg(Reg::RAX),
+            src: Operand::Reg(Reg::RDX),
+        });
+    }
+
+    /// if (*rdi == 0) goto done; rdi++; goto again
+    fn emit_strlen_byte_step(&mut self, again: Label, done: Label) {
+        self.ir.emit(ADeadOp::Load8 { dst: Reg::RAX, base: Reg::RDI, disp: 0 });
+        self.ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        self.ir.emit(ADeadOp::Jcc { cond: Condition::Equal, target: done });
+        self.ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::RDI) });
+        self.ir.emit(ADeadOp::Jmp { target: again });
+    }
+
+    /// Registra cada campo del struct local `name` como "var.field" con
+    /// su offset, y los campos de structs anidados (r.origin.x en Rect)
+    fn register_struct_fields(&mut self, name: &str, struct_name: &str, base: i32, fields: &[(String, i32)]) {
+        for (field_name, field_off) in fields {
+            let flat_name = format!("{}.{}", name, field_name);
+            self.variables.insert(flat_name.clone(), base + field_off);
+            // If this field is an array type, mark it in array_vars
+            // so IndexAssign uses direct RBP-relative access instead of pointer deref
+            if let Some(vt) = self.variable_types.get(&flat_name) {
+                if matches!(vt, Type::Array(_, _)) {
+                    self.array_vars.insert(flat_name.clone());
+                }
+            }
+            // Check if this field name matches a known struct type
+            // by looking up field_types stored in the layout
+            if let Some(field_type_name) =
+                self.class_layouts.get(struct_name).and_then(|layout| {
+                    layout
+                        .field_types
+                        .iter()
+                        .find(|(fn_, _)| fn_ == field_name)
+                        .map(|(_, ft)| ft.clone())
+                })
+            {
+                if let Some(sub_layout) =
+                    self.class_layouts.get(&field_type_name).cloned()
+                {
+                    for (sub_field, sub_off) in &sub_layout.fields {
+                        self.variables.insert(
+                            format!("{}.{}.{}", name, field_name, sub_field),
+                            base + field_off + sub_off,
+                        );
+                    }
+                }
+            }
+        }
+    }
+
+    /// Check if a Named type has a real struct layout (vs being a typedef like HINSTANCE)
+    fn is_real_struct_type(&self, ty: &Type) -> bool {
+        match ty {
+            Type::Struct(n) | Type::Class(n) => self.class_layouts.contains_key(n),
+            Type::Named(n) => self.class_layouts.contains_key(n),
+            _ => false,
+        }
+    }
+
+    /// Campos (nombre, tipo) del struct `name` si sroa.rs puede partirlo:
+    /// sin union, bitfields ni vtable, y todos enteros de 32/64 bits,
+    /// punteros o double (los que un local escalar guarda igual)
+    fn sra_fields(&self, name: &str) -> Option<Vec<(String, Type)>> {
+        let layout = self.class_layouts.get(name)?;
+        if layout.is_union || !layout.bitfields.is_empty() || self.vtable_address(name).is_some() {
+            return None;
+        }
+        let types = self.field_ir_types.get(name)?;
+        layout
+            .fields
+            .iter()
+            .map(|(field, _)| {
+                let ty = types.get(field)?;
+                matches!(ty, Type::I32 | Type::U32 | Type::I64 | Type::U64 | Type::F64 | Type::Pointer(_))
+                    .then(|| (field.clone(), ty.clone()))
+            })
+            .collect()
+    }
+
+    fn struct_name_of(ty: &Type) -> Option<&str> {
+        match ty {
+            Type::Struct(n) | Type::Named(n) | Type::Class(n) => Some(n),
+            _ => None,
+        }
+    }
+
+    /// Clase de `ty` por valor (struct_abi.rs). Value si no es un struct
+    /// con layout, o si tiene vtable (los objetos van por referencia)
+    fn struct_pass(&self, ty: &Type) -> ArgPass {
+        let Some(name) = Self::struct_name_of(ty) else {
+            return ArgPass::Value;
+        };
+        let Some(layout) = self.class_layouts.get(name) else {
+            return ArgPass::Value;
+        };
+        if self.vtable_address(name).is_some() {
+            return ArgPass::Value;
+        }
+        match struct_abi::classify(layout, self.target != Target::Windows) {
+            StructPass::Regs(words) => ArgPass::Regs(words),
+            StructPass::Memory => ArgPass::Copy(layout.size),
+        }
+    }
+
+    /// Bytes que ocupan los campos de `ty` (ancho del último eightbyte)
+    fn struct_extent(&self, ty: &Type) -> i32 {
+        Self::struct_name_of(ty)
+            .and_then(|name| self.class_layouts.get(name))
+            .map_or(8, struct_abi::extent)
+    }
+
+    /// Funciones propias nombradas como valor (`pf f = usep;`, `&usep`,
+    /// tablas globales): el callee de un `Expr::Call` no cuenta
+    fn collect_address_taken(&self, program: &Program) -> FxHashSet<String> {
+        let mut taken = FxHashSet::default();
+        let mut visit = |e: &Expr| {
+            if let Expr::Variable(name) = e {
+                if self.functions.contains_key(name) {
+                    taken.insert(name.clone());
+                }
+            }
+        };
+        for func in &program.functions {
+            loop_opt::for_each_expr(&func.body, &mut visit);
+        }
+        loop_opt::for_each_expr(&program.statements, &mut visit);
+        taken
+    }
+
+    /// Clases de los parámetros y del retorno de `name` si es una función
+    /// libre propia, llamada con todos sus argumentos, que pasa o devuelve
+    /// algún struct por valor. None = convención de siempre: los structs
+    /// van por referencia (métodos, imports, punteros a función y las
+    /// funciones cuya dirección se toma, que pueden llegar por uno)
+    fn call_abi(&self, name: &str, nargs: usize) -> Option<(Vec<ArgPass>, ArgPass)> {
+        if name.contains("::") || self.address_taken.contains(name) {
+            return None;
+        }
+        let func = self.functions.get(name)?;
+        if func.param_types.len() != nargs {
+            return None;
+        }
+        let passes: Vec<ArgPass> = func.param_types.iter().map(|ty| self.struct_pass(ty)).collect();
+        let ret = self.struct_pass(&func.return_type);
+        (ret != ArgPass::Value || passes.iter().any(|&p| p != ArgPass::Value)).then_some((passes, ret))
+    }
+
+    /// Parámetro struct Regs: un local rehecho con sus eightbytes, que
+    /// llegan en registros de argumento o, desde el 5.º slot, en la pila
+    fn emit_struct_param(&mut self, param: &Param, words: u8, slot: &mut usize) {
+        let struct_name = Self::struct_name_of(&param.param_type).unwrap_or_default().to_string();
+        let (size, fields) = match self.class_layouts.get(&struct_name) {
+            Some(layout) => (layout.size.max(words as i32 * 8), layout.fields.clone()),
+            None => (words as i32 * 8, Vec::new()),
+        };
+        self.stack_offset -= size;
+        let base = self.stack_offset;
+        self.variables.insert(param.name.clone(), base);
+        self.variable_types.insert(param.name.clone(), param.param_type.clone());
+        self.register_struct_fields(&param.name, &struct_name, base, &fields);
+        for k in 0..words as i32 {
+            let src = if *slot <= 3 {
+                self.arg_register(*slot)
+            } else {
+                self.ir.emit(ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Mem { base: Reg::RBP, disp: 48 + (*slot as i32 - 4) * 8 },
+                });
+                Reg::RAX
+            };
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Mem { base: Reg::RBP, disp: base + k * 8 },
+                src: Operand::Reg(src),
+            });
+            *slot += 1;
+        }
+    }
+
+    /// RAX = dirección del struct que vale `expr`: local, parámetro por
+    /// referencia, `*p`, global o resultado de una llamada por valor (un
+    /// retorno Regs se vuelca a un temporal del frame). false, sin emitir
+    /// nada, si `expr` no es un struct direccionable
+    fn emit_struct_address(&mut self, expr: &Expr) -> bool {
+        match expr {
+            Expr::Variable(name) if self.reg_vars.contains_key(name.as_str()) => false,
+            Expr::Variable(name) => {
+                if let Some(&disp) = self.variables.get(name.as_str()) {
+                    let slot = Operand::Mem { base: Reg::RBP, disp };
+                    if self.struct_params.contains(name.as_str()) || self.ref_vars.contains(name.as_str()) {
+                        self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RAX), src: slot });
+                    } else {
+                        self.ir.emit(ADeadOp::Lea { dst: Reg::RAX, src: slot });
+                    }
+                    return true;
+                }
+                let Some(addr) = self.global_vars.get(name.as_str()).and_then(|_| self.get_global_address(name)) else {
+                    return false;
+                };
+                self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RAX), src: Operand::Imm64(addr) });
+                true
+            }
+            Expr::Deref(ptr) => {
+                self.emit_expression(ptr);
+                true
+            }
+            Expr::Call { name, args } => match self.call_abi(name, args.len()) {
+                Some((_, ArgPass::Regs(words))) => {
+                    self.emit_call(name, args);
+                    self.stack_offset -= words as i32 * 8;
+                    let tmp = self.stack_offset;
+                    self.emit_store_eightbytes(tmp, words);
+                    self.ir.emit(ADeadOp::Lea {
+                        dst: Reg::RAX,
+                        src: Operand::Mem { base: Reg::RBP, disp: tmp },
+                    });
+                    true
+                }
+                // RAX = el puntero sret al temporal del caller
+                Some((_, ArgPass::Copy(_))) => {
+                    self.emit_call(name, args);
+                    true
+                }
+                _ => false,
+            },
+            _ => false,
+        }
+    }
+
+    /// [rbp+disp..] ← RAX (y RDX con dos eightbytes)
+    fn emit_store_eightbytes(&mut self, disp: i32, words: u8) {
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Mem { base: Reg::RBP, disp },
+            src: Operand::Reg(Reg::RAX),
+        });
+        if words == 2 {
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Mem { base: Reg::RBP, disp: disp + 8 },
+                src: Operand::Reg(Reg::RDX),
+            });
+        }
+    }
+
+    /// `return e` con retorno struct por valor: Regs → eightbytes en
+    /// RAX(:RDX); Copy → copia al puntero sret, que vuelve en RAX.
+    /// false si `e` no es un struct direccionable
+    fn emit_struct_return(&mut self, e: &Expr) -> bool {
+        if let Expr::Call { name, args } = e {
+            // Misma clase que la nuestra: RAX(:RDX) ya quedan listos
+            let same = self.call_abi(name, args.len()).map(|(_, ret)| ret) == Some(self.return_pass);
+            if same && matches!(self.return_pass, ArgPass::Regs(_)) {
+                self.emit_call(name, args);
+                return true;
+            }
+        }
+        match self.return_pass {
+            ArgPass::Regs(words) => {
+                let extent = self
+                    .current_function
+                    .as_ref()
+                    .and_then(|f| self.functions.get(f))
+                    .map_or(8, |f| self.struct_extent(&f.return_type));
+                if !self.emit_struct_address(e) {
+                    return false;
+                }
+                self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RBX), src: Operand::Reg(Reg::RAX) });
+                if words == 2 {
+                    self.emit_sized_load(Reg::RBX, 8, struct_abi::eightbyte_width(extent, 1));
+                    self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RDX), src: Operand::Reg(Reg::RAX) });
+                }
+                self.emit_sized_load(Reg::RBX, 0, struct_abi::eightbyte_width(extent, 0));
+                true
+            }
+            ArgPass::Copy(size) => {
+                let Some(sret) = self.sret_slot else {
+                    return false;
+                };
+                if !self.emit_struct_address(e) {
+                    return false;
+                }
+                self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RSI), src: Operand::Reg(Reg::RAX) });
                 self.ir.emit(ADeadOp::Mov {
-                    dst: Operand::Reg(Reg::RCX),
-                    src: Operand::Reg(Reg::RAX),
+                    dst: Operand::Reg(Reg::RDI),
+                    src: Operand::Mem { base: Reg::RBP, disp: sret },
                 });
-                self.ir.emit(ADeadOp::Pop { dst: Reg::RDX });
-                self.emit_call_iat("realloc");
+                self.emit_mem_copy(Some(size as u64));
+                true
             }
-            // ========== CAST ==========
-            Expr::Cast {
-                target_type,
-                expr: inner,
-            } => {
-                let inner_is_float = Self::expr_is_float_full(
-                    inner,
-                    &self.variable_types,
-                    &self.field_ir_types,
-                    &self.current_class,
-                );
-                let target_is_float = match target_type {
-                    Type::F32 | Type::F64 => true,
-                    Type::Named(n) if n == "float" || n == "double" => true,
-                    _ => false,
-                };
-                let _target_is_int = match target_type {
-                    Type::I8 | Type::U8 | Type::I16 | Type::U16
-                    | Type::I32 | Type::U32 | Type::I64 | Type::U64 => true,
-                    Type::Named(n) if n == "int" || n == "unsigned int" || n == "unsigned"
-                        || n == "long" || n == "long long" || n == "short" || n == "char" => true,
-                    _ => false,
-                };
+            ArgPass::Value => false,
+        }
+    }
 
-                self.emit_expression(inner);
+    /// `struct S x = val` con `val` otro struct del mismo tipo o una
+    /// llamada por valor: RAX(:RDX) directos o copia desde su dirección
+    fn emit_struct_init(&mut self, base: i32, size: i32, var_type: &Type, value: Option<&Expr>) -> bool {
+        let Some(val) = value else {
+            return false;
+        };
+        match val {
+            Expr::Call { name, args } => match self.call_abi(name, args.len()) {
+                Some((_, ArgPass::Regs(words))) => {
+                    self.emit_call(name, args);
+                    self.emit_store_eightbytes(base, words);
+                    return true;
+                }
+                Some((_, ArgPass::Copy(_))) => {}
+                _ => return false,
+            },
+            Expr::Variable(src) if self.variable_types.get(src.as_str()) == Some(var_type) => {}
+            Expr::Deref(_) => {}
+            _ => return false,
+        }
+        if !self.emit_struct_address(val) {
+            return false;
+        }
+        self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RSI), src: Operand::Reg(Reg::RAX) });
+        self.ir.emit(ADeadOp::Lea {
+            dst: Reg::RDI,
+            src: Operand::Mem { base: Reg::RBP, disp: base },
+        });
+        self.emit_mem_copy(Some(size as u64));
+        true
+    }
 
-                if inner_is_float && !target_is_float {
-                    // float/double → int: CVTTSD2SI (truncate double to integer)
-                    // Value is in RAX as bit-pattern; move to XMM0 first
-                    self.ir.emit(ADeadOp::MovQ {
-                        dst: Reg::XMM0,
-                        src: Reg::RAX,
-                    });
-                    self.ir.emit(ADeadOp::CvtTsd2Si {
-                        dst: Reg::RAX,
-                        src: Reg::XMM0,
-                    });
-                } else if !inner_is_float && target_is_float {
-                    // int → float/double: CVTSI2SD (integer to double)
-                    self.ir.emit(ADeadOp::CvtSi2Sd {
-                        dst: Reg::XMM0,
-                        src: Reg::RAX,
+    /// Llamada a una función libre propia con structs por valor
+    /// (struct_abi.rs). Cada argumento ocupa uno o más slots de 8 bytes,
+    /// el slot s en [RSP + s*8] (los 4 primeros van luego a registros):
+    /// un struct Regs un slot por eightbyte, un struct Copy el puntero a
+    /// una copia en el frame, y un retorno Copy el slot 0 con el puntero
+    /// sret a un temporal, que vuelve en RAX
+    fn emit_call_by_value(&mut self, name: &str, args: &[Expr], passes: &[ArgPass], ret: ArgPass) {
+        let param_types = self.functions[name].param_types.clone();
+        let label = self.functions[name].label;
+        // Copias antes de armar el frame: la copia usa RSI/RDI/RCX
+        let mut copies = vec![None; args.len()];
+        for (i, &pass) in passes.iter().enumerate() {
+            if let ArgPass::Copy(size) = pass {
+                if self.emit_struct_address(&args[i]) {
+                    self.stack_offset -= size;
+                    let tmp = self.stack_offset;
+                    self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RSI), src: Operand::Reg(Reg::RAX) });
+                    self.ir.emit(ADeadOp::Lea {
+                        dst: Reg::RDI,
+                        src: Operand::Mem { base: Reg::RBP, disp: tmp },
                     });
-                    self.ir.emit(ADeadOp::MovQ {
-                        dst: Reg::RAX,
-                        src: Reg::XMM0,
-                    });
-                } else {
-                    // Integer truncation based on target type size
-                    let target_size = crate::isa::c_isa::c99_sizeof_for_expr(target_type);
-                    match target_size {
-                        1 => {
-                            self.ir.emit(ADeadOp::MovZx {
-                                dst: Reg::RAX,
-                                src: Reg::AL,
-                            });
-                        }
-                        2 => {
-                            self.ir.emit(ADeadOp::Mov {
-                                dst: Operand::Reg(Reg::RBX),
-                                src: Operand::Imm32(0xFFFF),
-                            });
-                            self.ir.emit(ADeadOp::And {
-                                dst: Reg::RAX,
-                                src: Reg::RBX,
-                            });
-                        }
-                        4 => {
-                            self.ir.emit(ADeadOp::Mov {
-                                dst: Operand::Reg(Reg::EAX),
-                                src: Operand::Reg(Reg::EAX),
-                            });
-                        }
-                        _ => {
-                            // 8 bytes or unknown — no truncation needed
+                    self.emit_mem_copy(Some(size as u64));
+                    copies[i] = Some(tmp);
+                }
+            }
+        }
+        let sret = match ret {
+            ArgPass::Copy(size) => {
+                self.stack_offset -= size;
+                Some(self.stack_offset)
+            }
+            _ => None,
+        };
+        let slots = usize::from(sret.is_some())
+            + passes
+                .iter()
+                .map(|p| match p {
+                    ArgPass::Regs(words) => *words as usize,
+                    _ => 1,
+                })
+                .sum::<usize>();
+        let frame_size = ((slots.saturating_sub(4) * 8) + 32 + 15) & !15;
+        self.ir.emit(ADeadOp::Sub {
+            dst: Operand::Reg(Reg::RSP),
+            src: Operand::Imm32(frame_size as i32),
+        });
+        let mut slot = 0;
+        if let Some(tmp) = sret {
+            self.ir.emit(ADeadOp::Lea {
+                dst: Reg::RAX,
+                src: Operand::Mem { base: Reg::RBP, disp: tmp },
+            });
+            self.store_arg_slot(&mut slot);
+        }
+        for (i, arg) in args.iter().enumerate() {
+            match passes[i] {
+                ArgPass::Regs(words) => {
+                    if self.emit_struct_address(arg) {
+                        let extent = self.struct_extent(&param_types[i]);
+                        self.ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RBX), src: Operand::Reg(Reg::RAX) });
+                        for k in 0..words {
+                            self.emit_sized_load(Reg::RBX, k as i32 * 8, struct_abi::eightbyte_width(extent, k));
+                            self.store_arg_slot(&mut slot);
                         }
+                    } else {
+                        self.emit_expression(arg);
+                        self.store_arg_slot(&mut slot);
+                        slot += words as usize - 1;
                     }
                 }
+                ArgPass::Copy(_) => {
+                    match copies[i] {
+                        Some(tmp) => self.ir.emit(ADeadOp::Lea {
+                            dst: Reg::RAX,
+                            src: Operand::Mem { base: Reg::RBP, disp: tmp },
+                        }),
+                        None => self.emit_expression(arg),
+                    }
+                    self.store_arg_slot(&mut slot);
+                }
+                ArgPass::Value => {
+                    // Objetos con vtable: por referencia, como siempre
+                    let by_ref = matches!(arg, Expr::Variable(v) if self
+                        .variable_types
+                        .get(v.as_str())
+                        .map_or(false, |ty| self.is_real_struct_type(ty)));
+                    if !(by_ref && self.emit_struct_address(arg)) {
+                        self.emit_expression(arg);
+                    }
+                    self.store_arg_slot(&mut slot);
+                }
             }
-            _ => {
-                self.ir.emit(ADeadOp::Xor {
-                    dst: Reg::RAX,
-                    src: Reg::RAX,
-                });
-            }
         }
+        // Las funciones propias leen sus argumentos de los GPRs
+        for s in (0..slots.min(4)).rev() {
+            let dst = self.arg_register(s);
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Reg(dst),
+                src: Operand::Mem { base: Reg::RSP, disp: (s * 8) as i32 },
+            });
+        }
+        self.ir.emit(ADeadOp::Cld);
+        self.ir.emit(ADeadOp::Call { target: CallTarget::Relative(label) });
+        self.ir.emit(ADeadOp::Add {
+            dst: Operand::Reg(Reg::RSP),
+            src: Operand::Imm32(frame_size as i32),
+        });
     }
 
-    /// Check if a Named type has a real struct layout (vs being a typedef like HINSTANCE)
-    fn is_real_struct_type(&self, ty: &Type) -> bool {
-        match ty {
-            Type::Struct(n) | Type::Class(n) => self.class_layouts.contains_key(n),
-            Type::Named(n) => self.class_layouts.contains_key(n),
-            _ => false,
+    /// [RSP + slot*8] ← RAX y pasa al siguiente slot
+    fn store_arg_slot(&mut self, slot: &mut usize) {
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Mem { base: Reg::RSP, disp: (*slot * 8) as i32 },
+            src: Operand::Reg(Reg::RAX),
+        });
+        *slot += 1;
+    }
+
+    /// Llamada virtual: `this` como primer argumento y un único
+    /// `call [vptr + slot*8]`; el vptr está en el offset 0 del objeto
+    fn emit_virtual_call(&mut self, object: &Expr, slot: u32, args: &[Expr]) {
+        let total_args = args.len() + 1;
+        let reg_args = total_args.min(4);
+        let stack_args = total_args.saturating_sub(4);
+        let frame_size = ((stack_args * 8) + 32 + 15) & !15;
+
+        self.ir.emit(ADeadOp::Sub {
+            dst: Operand::Reg(Reg::RSP),
+            src: Operand::Imm32(frame_size as i32),
+        });
+        let arg = |i: usize| if i == 0 { object } else { &args[i - 1] };
+        for i in 4..total_args {
+            self.emit_expression(arg(i));
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Mem { base: Reg::RSP, disp: 32 + ((i - 4) * 8) as i32 },
+                src: Operand::Reg(Reg::RAX),
+            });
+        }
+        for i in 0..reg_args {
+            self.emit_expression(arg(i));
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Mem { base: Reg::RSP, disp: (i * 8) as i32 },
+                src: Operand::Reg(Reg::RAX),
+            });
+        }
+        for i in (0..reg_args).rev() {
+            let dst = self.arg_register(i);
+            self.ir.emit(ADeadOp::Mov {
+                dst: Operand::Reg(dst),
+                src: Operand::Mem { base: Reg::RSP, disp: (i * 8) as i32 },
+            });
         }
+
+        // RAX = vptr (this está en el primer registro de argumentos)
+        let this_reg = self.arg_register(0);
+        self.ir.emit(ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RAX),
+            src: Operand::Mem { base: this_reg, disp: 0 },
+        });
+        self.ir.emit(ADeadOp::Cld);
+        self.ir.emit(ADeadOp::Call {
+            target: CallTarget::Mem { base: Reg::RAX, disp: slot as i32 * 8 },
+        });
+        self.ir.emit(ADeadOp::Add {
+            dst: Operand::Reg(Reg::RSP),
+            src: Operand::Imm32(frame_size as i32),
+        });
     }
 
     fn emit_call(&mut self, name: &str, args: &[Expr]) {
+        // ========== BUILTINS: memcpy/memset/memcmp/strlen en línea ==========
+        // Ver mem_builtins.rs. Una definición propia del programa gana.
+        if let Some(builtin) = MemBuiltin::from_name(name) {
+            if args.len() == builtin.arg_count() && !self.functions.contains_key(name) {
+                self.emit_mem_builtin(builtin, args);
+                return;
+            }
+        }
+
         // ========== INTRINSIC: __store16(ptr, offset, value) ==========
         // Emits a 16-bit store: mov WORD [ptr + offset], value
         // Used for VGA text mode (each cell = char:8 + attr:8 = 16 bits)
@@ -5919,6 +9710,11 @@ impl IsaCompiler {
             return;
         }
 
+        if let Some((passes, ret)) = self.call_abi(name, args.len()) {
+            self.emit_call_by_value(name, args, &passes, ret);
+            return;
+        }
+
         // Windows x64 ABI: first 4 args in RCX, RDX, R8, R9
         // Args 5+ go on the stack at [rsp+32], [rsp+40], etc. (after shadow space)
         let total_args = args.len();
@@ -6040,6 +9836,93 @@ impl IsaCompiler {
             }
         }
 
+        // Rutinas propias: stdout con buffer (linux_stdio.rs), heap
+        // (slab_heap.rs), pool de tareas (task_pool.rs), algoritmos
+        // paralelos (par_algorithms.rs), contenedores (flat_hash.rs,
+        // btree.rs) y matemáticas (vec_math.rs). Mutex y atomics (sync.rs)
+        // van en el sitio de la llamada
+        if !self.functions.contains_key(name) {
+            let mut inlined = match self.sync {
+                Some(sync) => sync.emit_inline(&mut self.ir, name),
+                None => false,
+            };
+            if let (Some(math), Some((f, double))) = (self.vec_math, MathFn::from_name(name)) {
+                if !inlined && f.arity() == args.len() {
+                    let regs: Vec<Reg> = (0..f.arity()).map(|i| self.arg_register(i)).collect();
+                    math.emit_scalar_call(&mut self.ir, f, double, &regs);
+                    inlined = true;
+                }
+            }
+            if inlined {
+                if frame_size > 0 {
+                    self.ir.emit(ADeadOp::Add {
+                        dst: Operand::Reg(Reg::RSP),
+                        src: Operand::Imm32(frame_size as i32),
+                    });
+                }
+                return;
+            }
+            let routine = match (name, self.stdout_buffer, self.heap) {
+                ("fflush", Some(out), _) => Some(Some(out.flush)),
+                ("setvbuf", Some(out), _) => Some(Some(out.setvbuf)),
+                ("malloc", _, Some(heap)) => Some(Some(heap.malloc)),
+                ("free", _, Some(heap)) => Some(Some(heap.free)),
+                ("calloc", _, Some(heap)) => Some(Some(heap.calloc)),
+                ("realloc", _, Some(heap)) => Some(Some(heap.realloc)),
+                ("adb_heap_stats", _, Some(heap)) => Some(Some(heap.stats)),
+                // Sin heap propio no hay estadísticas: -1
+                ("adb_heap_stats", _, None) => Some(None),
+                _ => self
+                    .pool
+                    .and_then(|pool| pool.routine(name))
+                    .or_else(|| {
+                        let par = self.par?;
+                        let in_width = self.iter_width(args.first()?);
+                        let out_width = args.get(2).map_or(in_width, |out| self.iter_width(out));
+                        par.routine(name, in_width, out_width)
+                    })
+                    .or_else(|| self.hash?.routine(name))
+                    .or_else(|| self.tree?.routine(name))
+                    .or_else(|| self.aio?.routine(name))
+                    .map(Some),
+            };
+            if let Some(routine) = routine {
+                match routine {
+                    Some(label) => self.ir.emit(ADeadOp::Call { target: CallTarget::Relative(label) }),
+                    None => self.ir.emit(ADeadOp::Mov {
+                        dst: Operand::Reg(Reg::RAX),
+                        src: Operand::Imm32(-1),
+                    }),
+                }
+                if name == "fflush" {
+                    self.ir.emit(ADeadOp::Xor { dst: Reg::RAX, src: Reg::RAX });
+                }
+                if frame_size > 0 {
+                    self.ir.emit(ADeadOp::Add {
+                        dst: Operand::Reg(Reg::RSP),
+                        src: Operand::Imm32(frame_size as i32),
+                    });
+                }
+                return;
+            }
+        }
+
+        // Linux: clock_gettime/gettimeofday/time por el vDSO (ver linux_vdso.rs)
+        if self.target == Target::Linux && !self.functions.contains_key(name) {
+            if let Some(sym) = linux_vdso::lookup(name) {
+                if let Some(slot) = self.get_global_address(&linux_vdso::slot_name(sym)) {
+                    linux_vdso::emit_call(&mut self.ir, sym, slot);
+                    if frame_size > 0 {
+                        self.ir.emit(ADeadOp::Add {
+                            dst: Operand::Reg(Reg::RSP),
+                            src: Operand::Imm32(frame_size as i32),
+                        });
+                    }
+                    return;
+                }
+            }
+        }
+
         // Check if this is an IAT-imported function (printf, scanf, malloc, free, Win32, DX12...)
         let iat_name = match name {
             "printf" | "std::printf" => Some("printf"),
@@ -6057,11 +9940,9 @@ impl IsaCompiler {
         };
         if let Some(iat_func) = iat_name {
             // Frame already allocated above. Just emit the call.
-            let assumed_idata_rva: u32 = 0x2000;
-            let idata_result = iat_registry::build_idata(assumed_idata_rva, &[]);
             let slot = iat_registry::slot_for_function(iat_func)
                 .unwrap_or_else(|| panic!("IAT function not found: {}", iat_func));
-            let iat_rva = idata_result.slot_to_iat_rva[slot];
+            let iat_rva = iat_registry::assumed_iat_rva(slot);
             self.used_iat_slots.insert(slot);
             
             // Guarantee DF=0 before Windows DLL calls (x64 ABI strict requirement)
@@ -6182,6 +10063,251 @@ impl IsaCompiler {
     }
 }
 
+impl LoopContext for IsaCompiler {
+    fn array_info(&self, name: &str) -> Option<ArrayInfo> {
+        if self.ref_vars.contains(name) || self.struct_params.contains(name) {
+            return None;
+        }
+        if self.array_vars.contains(name) && self.variables.contains_key(name) {
+            // El stride del array local manda: es el que usa el bucle escalar
+            let stride = *self.array_elem_sizes.get(name).unwrap_or(&8) as usize;
+            let elem = match self.variable_types.get(name) {
+                Some(Type::Array(inner, _)) => loop_vectorizer::elem_of(inner),
+                _ => None,
+            };
+            return Some(ArrayInfo {
+                elem: elem.filter(|e| e.size_bytes() == stride),
+                is_local: true,
+                align: 1,
+            });
+        }
+        if self.local_slot(name).is_none() {
+            // Array global: objeto propio, base colocada por alloc_global_array
+            let global = self.global_arrays.get(name).filter(|_| !self.variables.contains_key(name))?;
+            return Some(ArrayInfo {
+                elem: loop_vectorizer::elem_of(&global.elem),
+                is_local: true,
+                align: global.align,
+            });
+        }
+        match self.variable_types.get(name) {
+            Some(Type::Pointer(inner)) => Some(ArrayInfo {
+                elem: loop_vectorizer::elem_of(inner),
+                is_local: false,
+                align: 1,
+            }),
+            _ => None,
+        }
+    }
+
+    fn is_int_scalar(&self, name: &str) -> bool {
+        self.local_slot(name).is_some()
+            && !self.array_vars.contains(name)
+            && !self.ref_vars.contains(name)
+            && matches!(
+                self.variable_types.get(name),
+                Some(Type::I8 | Type::I16 | Type::I32 | Type::I64 | Type::U8 | Type::U16 | Type::U32 | Type::U64)
+            )
+    }
+
+    fn is_float_scalar(&self, name: &str) -> bool {
+        self.local_slot(name).is_some()
+            && !self.array_vars.contains(name)
+            && !self.ref_vars.contains(name)
+            && self.variable_types.get(name) == Some(&Type::F64)
+    }
+
+    fn has_vector_math(&self, name: &str) -> bool {
+        self.vec_math.is_some() && !self.functions.contains_key(name)
+    }
+}
+
+// Ejecutan el código generado: sólo Linux x86-64 (ver test_jit)
+#[cfg(all(test, target_os = "linux", target_arch = "x86_64"))]
+mod abi_tests {
+    use super::*;
+    use crate::isa::test_jit::JitCode;
+
+    fn var(name: &str) -> Expr {
+        Expr::Variable(name.to_string())
+    }
+
+    fn binary(op: BinOp, left: Expr, right: Expr) -> Expr {
+        Expr::BinaryOp { op, left: Box::new(left), right: Box::new(right) }
+    }
+
+    fn field(object: &str, field: &str) -> Expr {
+        Expr::FieldAccess { object: Box::new(var(object)), field: field.to_string() }
+    }
+
+    fn call(name: &str, args: Vec<Expr>) -> Expr {
+        Expr::Call { name: name.to_string(), args }
+    }
+
+    fn function(name: &str, params: Vec<Param>, body: Vec<Stmt>) -> Function {
+        Function {
+            name: name.to_string(),
+            params,
+            return_type: None,
+            resolved_return_type: Type::I64,
+            body,
+            attributes: FunctionAttributes::default(),
+        }
+    }
+
+    /// struct Pair { int a; int b; };
+    /// long long usep(struct Pair p) { return p.a * 10 + p.b; }
+    /// long long run(void) {
+    ///     struct Pair q = {3, 4};
+    ///     long long (*f)(struct Pair) = usep;
+    ///     return f(q) * 100 + usep(q);
+    /// }
+    fn pair_program() -> Program {
+        let mut program = Program::new();
+        program.structs.push(Struct {
+            name: "Pair".to_string(),
+            fields: ["a", "b"]
+                .iter()
+                .map(|n| StructField { name: n.to_string(), field_type: Type::I32, bit_width: None })
+                .collect(),
+            is_packed: false,
+            is_union: false,
+        });
+        let pair = Type::Struct("Pair".to_string());
+        program.functions.push(function(
+            "usep",
+            vec![Param::typed("p".to_string(), pair.clone())],
+            vec![Stmt::Return(Some(binary(
+                BinOp::Add,
+                binary(BinOp::Mul, field("p", "a"), Expr::Number(10)),
+                field("p", "b"),
+            )))],
+        ));
+        program.functions.push(function(
+            "run",
+            vec![],
+            vec![
+                Stmt::VarDecl {
+                    var_type: pair,
+                    name: "q".to_string(),
+                    value: Some(Expr::Array(vec![Expr::Number(3), Expr::Number(4)])),
+                },
+                Stmt::VarDecl {
+                    var_type: Type::Pointer(Box::new(Type::I64)),
+                    name: "f".to_string(),
+                    value: Some(var("usep")),
+                },
+                Stmt::Return(Some(binary(
+                    BinOp::Add,
+                    binary(BinOp::Mul, call("f", vec![var("q")]), Expr::Number(100)),
+                    call("usep", vec![var("q")]),
+                ))),
+            ],
+        ));
+        program.functions.push(function("main", vec![], vec![Stmt::Return(Some(call("run", vec![])))]));
+        program
+    }
+
+    #[test]
+    fn test_struct_by_value_through_function_pointer() {
+        let program = pair_program();
+        let mut compiler = IsaCompiler::new(Target::Linux);
+        compiler.set_process_entry(false);
+        compiler.compile(&program);
+        // usep se llama por puntero: conserva la convención por referencia
+        // para la llamada directa y para su propio prólogo
+        assert!(compiler.address_taken.contains("usep"));
+        assert!(compiler.call_abi("usep", 1).is_none());
+
+        let code = JitCode::new(compiler.ir().ops());
+        let run: extern "C" fn() -> i64 = unsafe { code.func(compiler.functions["run"].label) };
+        assert_eq!(run(), 3434);
+    }
+
+    #[test]
+    fn test_direct_only_struct_stays_in_registers() {
+        let mut program = pair_program();
+        // Sin el puntero a función: usep pasa el Pair en un registro
+        program.functions[1].body.remove(1);
+        program.functions[1].body[1] =
+            Stmt::Return(Some(binary(BinOp::Add, call("usep", vec![var("q")]), Expr::Number(3400))));
+        let mut compiler = IsaCompiler::new(Target::Linux);
+        compiler.set_process_entry(false);
+        compiler.compile(&program);
+        assert!(compiler.address_taken.is_empty());
+        assert_eq!(compiler.call_abi("usep", 1), Some((vec![ArgPass::Regs(2)], ArgPass::Value)));
+
+        let code = JitCode::new(compiler.ir().ops());
+        let run: extern "C" fn() -> i64 = unsafe { code.func(compiler.functions["run"].label) };
+        assert_eq!(run(), 3434);
+    }
+
+    /// long long get(long long *p) { return *p; }
+    /// long long direct(void) { long long x = 5; return get(&x); }
+    /// long long via_local(void) { long long x = 5; long long *q = &x; return get(q); }
+    /// long long main(void) { return direct() * 10 + via_local(); }
+    #[test]
+    fn test_tail_call_keeps_escaped_frame() {
+        let local = |name: &str, var_type: Type, value: Expr| Stmt::VarDecl {
+            var_type,
+            name: name.to_string(),
+            value: Some(value),
+        };
+        let address = || Expr::AddressOf(Box::new(var("x")));
+        let ptr = Type::Pointer(Box::new(Type::I64));
+        let mut program = Program::new();
+        program.functions.push(function(
+            "get",
+            vec![Param::typed("p".to_string(), ptr.clone())],
+            vec![Stmt::Return(Some(Expr::Deref(Box::new(var("p")))))],
+        ));
+        program.functions.push(function(
+            "direct",
+            vec![],
+            vec![
+                local("x", Type::I64, Expr::Number(5)),
+                Stmt::Return(Some(call("get", vec![address()]))),
+            ],
+        ));
+        program.functions.push(function(
+            "via_local",
+            vec![],
+            vec![
+                local("x", Type::I64, Expr::Number(5)),
+                local("q", ptr, address()),
+                Stmt::Return(Some(call("get", vec![var("q")]))),
+            ],
+        ));
+        let both = binary(
+            BinOp::Add,
+            binary(BinOp::Mul, call("direct", vec![]), Expr::Number(10)),
+            call("via_local", vec![]),
+        );
+        program.functions.push(function("main", vec![], vec![Stmt::Return(Some(both))]));
+        let mut compiler = IsaCompiler::new(Target::Linux);
+        compiler.set_process_entry(false);
+        compiler.compile(&program);
+
+        // Ninguna de las dos puede soltar el frame antes de llamar a get
+        let get = compiler.functions["get"].label;
+        let calls = compiler
+            .ir()
+            .ops()
+            .iter()
+            .filter(|op| matches!(op, ADeadOp::Call { target: CallTarget::Relative(l) } if *l == get))
+            .count();
+        assert_eq!(calls, 2);
+
+        let code = JitCode::new(compiler.ir().ops());
+        for name in ["direct", "via_local"] {
+            let f: extern "C" fn() -> i64 = unsafe { code.func(compiler.functions[name].label) };
+            assert_eq!(f(), 5, "{}", name);
+        }
+        let main: extern "C" fn() -> i64 = unsafe { code.func(compiler.functions["main"].label) };
+        assert_eq!(main(), 55);
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -0,0 +1,323 @@
+// ============================================================
+// ADead-BIB — stdout con buffer (Linux)
+// ============================================================
+// En Target::Linux los printf/puts de literales eran un sys_write
+// por llamada. Con entry de proceso (ver linux_vdso.rs) pasan por un
+// buffer de BUFSIZ bytes en .data, con la semántica de <stdio.h>:
+//
+//   TTY            → _IOLBF: se vacía al escribir un '\n'
+//   fichero / pipe → _IOFBF: se vacía cuando se llena
+//   setvbuf        → cambia el modo (_IONBF escribe directo)
+//   fflush / exit  → el stub de proceso vacía antes de exit_group
+//
+// El modo se decide en la primera escritura: ioctl(fd, TCGETS) == 0
+// significa terminal. Una escritura mayor que el buffer vacía lo
+// pendiente y va directa. Sin entry de proceso (JIT, tests) nadie
+// vaciaría al salir, así que se mantiene el sys_write por llamada.
+//
+// Registros de las rutinas: todos caller-saved (RAX, RCX, RDX, RSI,
+// RDI, R8-R11), igual que una llamada a printf.
+// ============================================================
+
+use super::{ADeadIR, ADeadOp, CallTarget, Condition, Label, Operand, Reg};
+
+/// BUFSIZ de adeb-stdlib (fastos_stdio.rs)
+pub const BUFSIZ: i32 = 8192;
+pub const IOFBF: i32 = 0;
+pub const IOLBF: i32 = 1;
+pub const IONBF: i32 = 2;
+/// Modo inicial: se decide con TCGETS en la primera escritura
+pub const MODE_UNPROBED: i64 = -1;
+
+const SYS_WRITE: i32 = 1;
+const SYS_IOCTL: i32 = 16;
+const TCGETS: i32 = 0x5401;
+
+/// Globals del buffer (no chocan con nombres de C)
+pub const BUF_SLOT: &str = "__stdio.stdout.buf";
+pub const LEN_SLOT: &str = "__stdio.stdout.len";
+pub const MODE_SLOT: &str = "__stdio.stdout.mode";
+
+/// Direcciones del buffer y labels de sus rutinas
+#[derive(Debug, Clone, Copy)]
+pub struct StdoutBuffer {
+    pub fd: i32,
+    pub buf: u64,
+    pub len: u64,
+    pub mode: u64,
+    /// RSI = datos, RDX = longitud
+    pub write: Label,
+    /// Tras escribir un '\n': vacía si el modo es _IOLBF
+    pub line_end: Label,
+    pub flush: Label,
+    /// RDI = stream, RDX = modo → RAX = 0 / -1
+    pub setvbuf: Label,
+    write_all: Label,
+}
+
+fn mov(ir: &mut ADeadIR, dst: Reg, src: Operand) {
+    ir.emit(ADeadOp::Mov { dst: Operand::Reg(dst), src });
+}
+
+fn mem(base: Reg) -> Operand {
+    Operand::Mem { base, disp: 0 }
+}
+
+fn jcc(ir: &mut ADeadIR, cond: Condition, target: Label) {
+    ir.emit(ADeadOp::Jcc { cond, target });
+}
+
+fn call(ir: &mut ADeadIR, target: Label) {
+    ir.emit(ADeadOp::Call { target: CallTarget::Relative(target) });
+}
+
+fn cmp_imm(ir: &mut ADeadIR, reg: Reg, imm: i32) {
+    ir.emit(ADeadOp::Cmp { left: Operand::Reg(reg), right: Operand::Imm32(imm) });
+}
+
+impl StdoutBuffer {
+    pub fn new(ir: &mut ADeadIR, fd: i32, buf: u64, len: u64, mode: u64) -> Self {
+        Self {
+            fd,
+            buf,
+            len,
+            mode,
+            write: ir.new_label(),
+            line_end: ir.new_label(),
+            flush: ir.new_label(),
+            setvbuf: ir.new_label(),
+            write_all: ir.new_label(),
+        }
+    }
+
+    /// Llamada desde un Print: `len` bytes en `data`; `newline` si
+    /// contienen un '\n' (el literal se conoce al compilar)
+    pub fn emit_put(&self, ir: &mut ADeadIR, data: u64, len: usize, newline: bool) {
+        if len == 0 {
+            return;
+        }
+        mov(ir, Reg::RSI, Operand::Imm64(data));
+        mov(ir, Reg::RDX, Operand::Imm32(len as i32));
+        call(ir, self.write);
+        if newline {
+            call(ir, self.line_end);
+        }
+    }
+
+    pub fn emit_routines(&self, ir: &mut ADeadIR) {
+        self.emit_write_all(ir);
+        self.emit_flush(ir);
+        self.emit_write(ir);
+        self.emit_line_end(ir);
+        self.emit_setvbuf(ir);
+    }
+
+    /// write(2) hasta agotar RDX (reintenta escrituras parciales;
+    /// un error descarta el resto)
+    fn emit_write_all(&self, ir: &mut ADeadIR) {
+        let lp = ir.new_label();
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(self.write_all));
+        ir.emit(ADeadOp::Label(lp));
+        ir.emit(ADeadOp::Test { left: Reg::RDX, right: Reg::RDX });
+        jcc(ir, Condition::Equal, done);
+        mov(ir, Reg::RAX, Operand::Imm32(SYS_WRITE));
+        mov(ir, Reg::RDI, Operand::Imm32(self.fd));
+        ir.emit(ADeadOp::Syscall);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::LessEq, done);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSI), src: Operand::Reg(Reg::RAX) });
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RDX), src: Operand::Reg(Reg::RAX) });
+        ir.emit(ADeadOp::Jmp { target: lp });
+        ir.emit(ADeadOp::Label(done));
+        ir.emit(ADeadOp::Ret);
+    }
+
+    fn emit_flush(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.flush));
+        mov(ir, Reg::R8, Operand::Imm64(self.len));
+        mov(ir, Reg::RDX, mem(Reg::R8));
+        ir.emit(ADeadOp::Xor { dst: Reg::RAX, src: Reg::RAX });
+        ir.emit(ADeadOp::Mov { dst: mem(Reg::R8), src: Operand::Reg(Reg::RAX) });
+        mov(ir, Reg::RSI, Operand::Imm64(self.buf));
+        ir.emit(ADeadOp::Jmp { target: self.write_all });
+    }
+
+    fn emit_write(&self, ir: &mut ADeadIR) {
+        let probed = ir.new_label();
+        let tty = ir.new_label();
+        let fits = ir.new_label();
+        ir.emit(ADeadOp::Label(self.write));
+
+        // ---- primera escritura: terminal → _IOLBF, si no _IOFBF ----
+        mov(ir, Reg::R8, Operand::Imm64(self.mode));
+        mov(ir, Reg::RAX, mem(Reg::R8));
+        cmp_imm(ir, Reg::RAX, MODE_UNPROBED as i32);
+        jcc(ir, Condition::NotEqual, probed);
+        ir.emit(ADeadOp::Push { src: Operand::Reg(Reg::RSI) });
+        ir.emit(ADeadOp::Push { src: Operand::Reg(Reg::RDX) });
+        // struct termios (60 bytes) va al buffer, vacío todavía
+        mov(ir, Reg::RAX, Operand::Imm32(SYS_IOCTL));
+        mov(ir, Reg::RDI, Operand::Imm32(self.fd));
+        mov(ir, Reg::RSI, Operand::Imm32(TCGETS));
+        mov(ir, Reg::RDX, Operand::Imm64(self.buf));
+        ir.emit(ADeadOp::Syscall);
+        ir.emit(ADeadOp::Pop { dst: Reg::RDX });
+        ir.emit(ADeadOp::Pop { dst: Reg::RSI });
+        mov(ir, Reg::RCX, Operand::Imm32(IOLBF));
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, tty);
+        mov(ir, Reg::RCX, Operand::Imm32(IOFBF));
+        ir.emit(ADeadOp::Label(tty));
+        mov(ir, Reg::R8, Operand::Imm64(self.mode));
+        ir.emit(ADeadOp::Mov { dst: mem(Reg::R8), src: Operand::Reg(Reg::RCX) });
+        mov(ir, Reg::RAX, Operand::Reg(Reg::RCX));
+
+        ir.emit(ADeadOp::Label(probed));
+        cmp_imm(ir, Reg::RAX, IONBF);
+        jcc(ir, Condition::Equal, self.write_all);
+        mov(ir, Reg::R9, Operand::Imm64(self.len));
+        mov(ir, Reg::RCX, mem(Reg::R9));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RCX), src: Operand::Reg(Reg::RDX) });
+        cmp_imm(ir, Reg::RCX, BUFSIZ);
+        jcc(ir, Condition::BelowEq, fits);
+        // No cabe: vaciar lo pendiente; si ni el buffer entero basta, directo
+        ir.emit(ADeadOp::Push { src: Operand::Reg(Reg::RSI) });
+        ir.emit(ADeadOp::Push { src: Operand::Reg(Reg::RDX) });
+        call(ir, self.flush);
+        ir.emit(ADeadOp::Pop { dst: Reg::RDX });
+        ir.emit(ADeadOp::Pop { dst: Reg::RSI });
+        cmp_imm(ir, Reg::RDX, BUFSIZ);
+        jcc(ir, Condition::Above, self.write_all);
+
+        // ---- copiar a buf + len ----
+        ir.emit(ADeadOp::Label(fits));
+        mov(ir, Reg::R9, Operand::Imm64(self.len));
+        mov(ir, Reg::RDI, mem(Reg::R9));
+        mov(ir, Reg::RAX, Operand::Reg(Reg::RDI));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RDX) });
+        ir.emit(ADeadOp::Mov { dst: mem(Reg::R9), src: Operand::Reg(Reg::RAX) });
+        mov(ir, Reg::RAX, Operand::Imm64(self.buf));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RDI), src: Operand::Reg(Reg::RAX) });
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RDX));
+        ir.emit(ADeadOp::Cld);
+        ir.emit(ADeadOp::Rep { op: Box::new(ADeadOp::Movsb) });
+        ir.emit(ADeadOp::Ret);
+    }
+
+    fn emit_line_end(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.line_end));
+        mov(ir, Reg::R8, Operand::Imm64(self.mode));
+        mov(ir, Reg::RAX, mem(Reg::R8));
+        cmp_imm(ir, Reg::RAX, IOLBF);
+        jcc(ir, Condition::Equal, self.flush);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// Solo stdout tiene buffer; stdin/stderr se aceptan sin cambios.
+    /// El `buf` del usuario se ignora: el buffer es siempre el de .data.
+    fn emit_setvbuf(&self, ir: &mut ADeadIR) {
+        let other = ir.new_label();
+        let bad = ir.new_label();
+        ir.emit(ADeadOp::Label(self.setvbuf));
+        cmp_imm(ir, Reg::RDI, 1);
+        jcc(ir, Condition::NotEqual, other);
+        cmp_imm(ir, Reg::RDX, IONBF);
+        jcc(ir, Condition::Above, bad);
+        ir.emit(ADeadOp::Push { src: Operand::Reg(Reg::RDX) });
+        call(ir, self.flush);
+        ir.emit(ADeadOp::Pop { dst: Reg::RDX });
+        mov(ir, Reg::R8, Operand::Imm64(self.mode));
+        ir.emit(ADeadOp::Mov { dst: mem(Reg::R8), src: Operand::Reg(Reg::RDX) });
+        ir.emit(ADeadOp::Label(other));
+        ir.emit(ADeadOp::Xor { dst: Reg::RAX, src: Reg::RAX });
+        ir.emit(ADeadOp::Ret);
+        ir.emit(ADeadOp::Label(bad));
+        mov(ir, Reg::RAX, Operand::Imm32(-1));
+        ir.emit(ADeadOp::Ret);
+    }
+}
+
+#[cfg(all(test, target_os = "linux", target_arch = "x86_64"))]
+mod tests {
+    use super::*;
+    use crate::isa::test_jit::JitCode;
+
+    extern "C" {
+        fn pipe(fds: *mut i32) -> i32;
+        fn read(fd: i32, buf: *mut u8, len: usize) -> isize;
+        fn close(fd: i32) -> i32;
+    }
+
+    /// Estado del buffer en memoria del test
+    struct Slots {
+        buf: Vec<u8>,
+        len: u64,
+        mode: i64,
+    }
+
+    #[test]
+    fn test_full_buffering_on_pipe_and_setvbuf() {
+        let mut fds = [0i32; 2];
+        assert_eq!(unsafe { pipe(fds.as_mut_ptr()) }, 0);
+        let mut slots = Slots { buf: vec![0; BUFSIZ as usize], len: 0, mode: MODE_UNPROBED };
+        let text = b"hello\nworld\n";
+
+        let mut ir = ADeadIR::new();
+        let out = StdoutBuffer::new(
+            &mut ir,
+            fds[1],
+            slots.buf.as_mut_ptr() as u64,
+            &mut slots.len as *mut u64 as u64,
+            &mut slots.mode as *mut i64 as u64,
+        );
+        let step = |ir: &mut ADeadIR, n: i32| {
+            let next = ir.new_label();
+            ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RDI), right: Operand::Imm32(n) });
+            ir.emit(ADeadOp::Jcc { cond: Condition::NotEqual, target: next });
+            next
+        };
+        // arg 0: put(text) · arg 1: fflush · arg 2: setvbuf(_IONBF) + put(text)
+        let n1 = step(&mut ir, 0);
+        out.emit_put(&mut ir, text.as_ptr() as u64, text.len(), true);
+        ir.emit(ADeadOp::Ret);
+        ir.emit(ADeadOp::Label(n1));
+        let n2 = step(&mut ir, 1);
+        ir.emit(ADeadOp::Call { target: CallTarget::Relative(out.flush) });
+        ir.emit(ADeadOp::Ret);
+        ir.emit(ADeadOp::Label(n2));
+        ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RDI), src: Operand::Imm32(1) });
+        ir.emit(ADeadOp::Mov { dst: Operand::Reg(Reg::RDX), src: Operand::Imm32(IONBF) });
+        ir.emit(ADeadOp::Call { target: CallTarget::Relative(out.setvbuf) });
+        out.emit_put(&mut ir, text.as_ptr() as u64, 5, false);
+        ir.emit(ADeadOp::Ret);
+        out.emit_routines(&mut ir);
+
+        let code = JitCode::new(ir.ops());
+        let call = |arg: u64| code.call(arg);
+        let drain = |want: usize| {
+            let mut got = vec![0u8; want];
+            assert_eq!(unsafe { read(fds[0], got.as_mut_ptr(), want) }, want as isize);
+            got
+        };
+
+        // Un pipe no es terminal: el '\n' no vacía, todo queda en el buffer
+        call(0);
+        assert_eq!(slots.mode, IOFBF as i64);
+        assert_eq!(slots.len, text.len() as u64);
+        call(1);
+        assert_eq!(slots.len, 0);
+        assert_eq!(drain(text.len()), text);
+
+        // _IONBF: escritura directa
+        call(2);
+        assert_eq!(slots.mode, IONBF as i64);
+        assert_eq!(slots.len, 0);
+        assert_eq!(drain(5), b"hello");
+
+        unsafe {
+            close(fds[0]);
+            close(fds[1]);
+        }
+    }
+}
@@ -0,0 +1,262 @@
+// ============================================================
+// ADead-BIB — vDSO para clock_gettime/gettimeofday/time (Linux)
+// ============================================================
+// En Target::Linux las funciones de tiempo de <time.h> (adeb-stdlib
+// fastos_time.rs) no pasan por el kernel en cada llamada:
+//
+//   arranque  → el stub de proceso busca AT_SYSINFO_EHDR en el auxv,
+//               recorre la .dynsym del vDSO y guarda en un slot global
+//               la dirección de __vdso_clock_gettime, etc.
+//   llamada   → slot != 0 ? call slot : syscall (vDSO ausente, o el
+//               código no arrancó como proceso: JIT, tests)
+//
+// El vDSO es un ELF completo mapeado tal cual: las cabeceras de
+// sección están dentro de la imagen y sh_offset es offset en memoria.
+// Desplazamiento de carga = base + sh_offset - sh_addr de la .dynsym.
+//
+// Registros del resolver: todos caller-saved (RAX, RCX, RDX, RSI,
+// RDI, R8-R11); se llama desde el stub de arranque antes de main.
+// ============================================================
+
+use super::{ADeadIR, ADeadOp, CallTarget, Condition, Label, Operand, Reg};
+
+/// Función de tiempo que se resuelve por vDSO
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct VdsoSymbol {
+    /// Nombre en C
+    pub function: &'static str,
+    /// Símbolo exportado por el vDSO de x86-64
+    pub vdso_name: &'static str,
+    /// Número de syscall para el fallback
+    pub syscall: i32,
+}
+
+pub const VDSO_SYMBOLS: &[VdsoSymbol] = &[
+    VdsoSymbol { function: "clock_gettime", vdso_name: "__vdso_clock_gettime", syscall: 228 },
+    VdsoSymbol { function: "gettimeofday", vdso_name: "__vdso_gettimeofday", syscall: 96 },
+    VdsoSymbol { function: "time", vdso_name: "__vdso_time", syscall: 201 },
+];
+
+/// Tipo de entrada del auxv con la base del vDSO
+pub const AT_SYSINFO_EHDR: i32 = 33;
+/// exit_group(2): el stub de proceso termina con el valor de main
+pub const SYS_EXIT_GROUP: i32 = 231;
+
+const SHT_DYNSYM: i32 = 11;
+const ELF64_SHDR_SIZE: i32 = 64;
+const ELF64_SYM_SIZE: i32 = 24;
+
+pub fn lookup(function: &str) -> Option<&'static VdsoSymbol> {
+    VDSO_SYMBOLS.iter().find(|s| s.function == function)
+}
+
+/// Global donde el resolver deja la dirección (no choca con nombres de C)
+pub fn slot_name(sym: &VdsoSymbol) -> String {
+    format!("__vdso.{}", sym.function)
+}
+
+fn mov(ir: &mut ADeadIR, dst: Reg, src: Operand) {
+    ir.emit(ADeadOp::Mov { dst: Operand::Reg(dst), src });
+}
+
+fn mem(base: Reg, disp: i32) -> Operand {
+    Operand::Mem { base, disp }
+}
+
+fn jcc(ir: &mut ADeadIR, cond: Condition, target: Label) {
+    ir.emit(ADeadOp::Jcc { cond, target });
+}
+
+/// Llamada a `sym` con los argumentos ya en RDI/RSI: por el slot si el
+/// resolver lo llenó, si no syscall (mismos registros de argumento).
+pub fn emit_call(ir: &mut ADeadIR, sym: &VdsoSymbol, slot_addr: u64) {
+    let syscall = ir.new_label();
+    let done = ir.new_label();
+    mov(ir, Reg::R10, Operand::Imm64(slot_addr));
+    mov(ir, Reg::R10, mem(Reg::R10, 0));
+    ir.emit(ADeadOp::Test { left: Reg::R10, right: Reg::R10 });
+    jcc(ir, Condition::Equal, syscall);
+    ir.emit(ADeadOp::Call { target: CallTarget::Register(Reg::R10) });
+    ir.emit(ADeadOp::Jmp { target: done });
+    ir.emit(ADeadOp::Label(syscall));
+    mov(ir, Reg::RAX, Operand::Imm32(sym.syscall));
+    ir.emit(ADeadOp::Syscall);
+    ir.emit(ADeadOp::Label(done));
+}
+
+/// Entry de un proceso Linux: RSP apunta a argc, argv[], NULL, envp[],
+/// NULL, auxv. Resuelve el vDSO, llama a `entry` y sale con su valor;
+/// antes de salir llama a `at_exit` (vaciar stdout) si lo hay.
+pub fn emit_process_start(ir: &mut ADeadIR, init: Label, entry: Label, at_exit: Option<Label>) {
+    let env_loop = ir.new_label();
+    // RDI = &envp[0] = RSP + 8 * (argc + 2)
+    mov(ir, Reg::RAX, mem(Reg::RSP, 0));
+    ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: 3 });
+    mov(ir, Reg::RDI, Operand::Reg(Reg::RSP));
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RDI), src: Operand::Reg(Reg::RAX) });
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RDI), src: Operand::Imm8(16) });
+    // Saltar envp hasta su NULL; RDI queda en auxv
+    ir.emit(ADeadOp::Label(env_loop));
+    mov(ir, Reg::RAX, mem(Reg::RDI, 0));
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RDI), src: Operand::Imm8(8) });
+    ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+    jcc(ir, Condition::NotEqual, env_loop);
+    ir.emit(ADeadOp::Call { target: CallTarget::Relative(init) });
+    ir.emit(ADeadOp::Call { target: CallTarget::Relative(entry) });
+    if let Some(at_exit) = at_exit {
+        ir.emit(ADeadOp::Push { src: Operand::Reg(Reg::RAX) });
+        ir.emit(ADeadOp::Call { target: CallTarget::Relative(at_exit) });
+        ir.emit(ADeadOp::Pop { dst: Reg::RAX });
+    }
+    mov(ir, Reg::RDI, Operand::Reg(Reg::RAX));
+    mov(ir, Reg::RAX, Operand::Imm32(SYS_EXIT_GROUP));
+    ir.emit(ADeadOp::Syscall);
+}
+
+/// Resolver: RDI = auxv. `symbols` = (dirección del nombre con NUL,
+/// dirección del slot). Los slots de símbolos que no aparecen quedan a 0.
+pub fn emit_init(ir: &mut ADeadIR, label: Label, symbols: &[(u64, u64)]) {
+    let done = ir.new_label();
+    ir.emit(ADeadOp::Label(label));
+
+    // ---- auxv: pares (tipo, valor) hasta AT_NULL ----
+    let aux_loop = ir.new_label();
+    let aux_found = ir.new_label();
+    ir.emit(ADeadOp::Label(aux_loop));
+    mov(ir, Reg::RAX, mem(Reg::RDI, 0));
+    ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+    jcc(ir, Condition::Equal, done);
+    ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(AT_SYSINFO_EHDR) });
+    jcc(ir, Condition::Equal, aux_found);
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RDI), src: Operand::Imm8(16) });
+    ir.emit(ADeadOp::Jmp { target: aux_loop });
+    ir.emit(ADeadOp::Label(aux_found));
+    mov(ir, Reg::R8, mem(Reg::RDI, 8));
+    ir.emit(ADeadOp::Test { left: Reg::R8, right: Reg::R8 });
+    jcc(ir, Condition::Equal, done);
+
+    // ---- Cabeceras de sección: buscar SHT_DYNSYM ----
+    // R9 = tabla de secciones, R10 = secciones por ver, R11 = actual
+    let sh_loop = ir.new_label();
+    let sh_found = ir.new_label();
+    mov(ir, Reg::R9, mem(Reg::R8, 0x28)); // e_shoff
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::R9), src: Operand::Reg(Reg::R8) });
+    ir.emit(ADeadOp::Load16 { dst: Reg::R10, base: Reg::R8, disp: 0x3C }); // e_shnum
+    mov(ir, Reg::R11, Operand::Reg(Reg::R9));
+    ir.emit(ADeadOp::Label(sh_loop));
+    ir.emit(ADeadOp::Test { left: Reg::R10, right: Reg::R10 });
+    jcc(ir, Condition::Equal, done);
+    ir.emit(ADeadOp::Load32 { dst: Reg::RAX, base: Reg::R11, disp: 4 }); // sh_type
+    ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(SHT_DYNSYM) });
+    jcc(ir, Condition::Equal, sh_found);
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::R11), src: Operand::Imm32(ELF64_SHDR_SIZE) });
+    ir.emit(ADeadOp::Dec { dst: Operand::Reg(Reg::R10) });
+    ir.emit(ADeadOp::Jmp { target: sh_loop });
+
+    // RSI = primer símbolo, RCX = fin, RDX = .dynstr, R8 = desplazamiento
+    ir.emit(ADeadOp::Label(sh_found));
+    mov(ir, Reg::RSI, mem(Reg::R11, 0x18)); // sh_offset
+    mov(ir, Reg::RCX, mem(Reg::R11, 0x20)); // sh_size
+    ir.emit(ADeadOp::Load32 { dst: Reg::RAX, base: Reg::R11, disp: 0x28 }); // sh_link
+    ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: 6 });
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::R9) });
+    mov(ir, Reg::RDX, mem(Reg::RAX, 0x18));
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RDX), src: Operand::Reg(Reg::R8) });
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSI), src: Operand::Reg(Reg::R8) });
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RCX), src: Operand::Reg(Reg::RSI) });
+    mov(ir, Reg::RAX, mem(Reg::R11, 0x18));
+    mov(ir, Reg::R9, mem(Reg::R11, 0x10)); // sh_addr
+    ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::R9) });
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::R8), src: Operand::Reg(Reg::RAX) });
+
+    // ---- Símbolos: comparar el nombre con cada uno de `symbols` ----
+    let sym_loop = ir.new_label();
+    let next = ir.new_label();
+    ir.emit(ADeadOp::Label(sym_loop));
+    ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RSI), right: Operand::Reg(Reg::RCX) });
+    jcc(ir, Condition::AboveEq, done);
+    ir.emit(ADeadOp::Load16 { dst: Reg::RAX, base: Reg::RSI, disp: 6 }); // st_shndx
+    ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+    jcc(ir, Condition::Equal, next); // indefinido
+    for &(name_addr, slot_addr) in symbols {
+        let cmp_loop = ir.new_label();
+        let hit = ir.new_label();
+        let miss = ir.new_label();
+        ir.emit(ADeadOp::Load32 { dst: Reg::R9, base: Reg::RSI, disp: 0 }); // st_name
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::R9), src: Operand::Reg(Reg::RDX) });
+        mov(ir, Reg::R10, Operand::Imm64(name_addr));
+        ir.emit(ADeadOp::Label(cmp_loop));
+        ir.emit(ADeadOp::Load8 { dst: Reg::RAX, base: Reg::R9, disp: 0 });
+        ir.emit(ADeadOp::Load8 { dst: Reg::R11, base: Reg::R10, disp: 0 });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Reg(Reg::R11) });
+        jcc(ir, Condition::NotEqual, miss);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, hit);
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R9) });
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R10) });
+        ir.emit(ADeadOp::Jmp { target: cmp_loop });
+        ir.emit(ADeadOp::Label(hit));
+        mov(ir, Reg::RAX, mem(Reg::RSI, 8)); // st_value
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::R8) });
+        mov(ir, Reg::R11, Operand::Imm64(slot_addr));
+        ir.emit(ADeadOp::Mov { dst: mem(Reg::R11, 0), src: Operand::Reg(Reg::RAX) });
+        ir.emit(ADeadOp::Jmp { target: next });
+        ir.emit(ADeadOp::Label(miss));
+    }
+    ir.emit(ADeadOp::Label(next));
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSI), src: Operand::Imm8(ELF64_SYM_SIZE as i8) });
+    ir.emit(ADeadOp::Jmp { target: sym_loop });
+
+    ir.emit(ADeadOp::Label(done));
+    ir.emit(ADeadOp::Ret);
+}
+
+#[cfg(all(test, target_os = "linux", target_arch = "x86_64"))]
+mod tests {
+    use super::*;
+    use crate::isa::test_jit::run;
+
+    #[test]
+    fn test_resolver_finds_vdso_clock_gettime() {
+        let auxv = std::fs::read("/proc/self/auxv").unwrap();
+        let has_vdso = auxv
+            .chunks_exact(16)
+            .any(|e| u64::from_le_bytes(e[..8].try_into().unwrap()) == AT_SYSINFO_EHDR as u64);
+        if !has_vdso {
+            return;
+        }
+
+        let names: Vec<Vec<u8>> =
+            ["__vdso_clock_gettime", "__vdso_not_there"].iter().map(|n| format!("{}\0", n).into_bytes()).collect();
+        let mut slots = [0u64; 2];
+        let symbols: Vec<(u64, u64)> =
+            names.iter().zip(slots.iter_mut()).map(|(n, s)| (n.as_ptr() as u64, s as *mut u64 as u64)).collect();
+
+        let mut ir = ADeadIR::new();
+        let init = ir.new_label();
+        emit_init(&mut ir, init, &symbols);
+        run(ir.ops(), auxv.as_ptr() as u64);
+        assert_ne!(slots[0], 0);
+        assert_eq!(slots[1], 0);
+
+        // El slot resuelto es clock_gettime de verdad: CLOCK_MONOTONIC avanza
+        let clock: extern "C" fn(i64, *mut [i64; 2]) -> i32 = unsafe { std::mem::transmute(slots[0]) };
+        let (mut a, mut b) = ([0i64; 2], [0i64; 2]);
+        assert_eq!(clock(1, &mut a), 0);
+        assert_eq!(clock(1, &mut b), 0);
+        assert!(b >= a && a != [0, 0]);
+    }
+
+    #[test]
+    fn test_call_falls_back_to_syscall() {
+        // Slot vacío → syscall time(NULL)
+        let slot = 0u64;
+        let sym = lookup("time").unwrap();
+        let mut ir = ADeadIR::new();
+        ir.emit(ADeadOp::Xor { dst: Reg::RDI, src: Reg::RDI });
+        emit_call(&mut ir, sym, &slot as *const u64 as u64);
+        ir.emit(ADeadOp::Ret);
+        let now = std::time::SystemTime::now().duration_since(std::time::UNIX_EPOCH).unwrap().as_secs() as i64;
+        assert!((run(ir.ops(), 0) - now).abs() <= 2);
+    }
+}
@@ -0,0 +1,636 @@
+// ============================================================
+// ADead-BIB Local Liveness — live ranges for LinearScanAllocator
+// ============================================================
+// Numera los statements de una función en pre-orden y registra en
+// qué puntos se usa cada local. Un uso dentro de un loop extiende el
+// rango a todo el loop: el valor tiene que sobrevivir al back-edge.
+//
+// Sólo son candidatos los escalares enteros/puntero declarados con
+// VarDecl cuyos usos son lecturas directas, asignaciones, compound
+// assign e incrementos. Cualquier otra forma (&x, x.campo, x[i], x(),
+// sizeof x, …) los descarta: el codegen de esas formas va a buscar
+// el slot en [rbp+disp] directamente.
+//
+// Un switch se numera en el orden en que se emite (casos, luego
+// default): el dispatch solo salta hacia adelante, así que los
+// rangos lineales siguen siendo válidos.
+//
+// Funciones con labels/goto o construcciones OS-level (registros,
+// asm crudo, directivas) no se analizan.
+//
+// Pipeline: Function.body → local_ranges() → LinearScanAllocator
+//
+// El mismo recorrido decide además si una función es hoja sin frame
+// (leaf_ranges: parámetros y locales caben todos en registros y no hay
+// llamadas) y si su frame se puede reutilizar en un bucle de cola
+// (frame_escapes: nada toma la dirección de un local).
+//
+// Cada uso guarda además el site de PGO más interno que lo contiene
+// (if/while/do/for numerados como `adeb_middle::profile::site_stmts`):
+// con `-fprofile-use` el peso de un rango es la frecuencia de sus usos.
+// ============================================================
+
+use crate::frontend::ast::*;
+use adeb_middle::profile::is_site;
+use std::collections::{HashMap, HashSet};
+
+/// Live range of a local over statement indices `[start, end]`
+#[derive(Debug, Clone, PartialEq)]
+pub struct LocalRange {
+    pub name: String,
+    pub start: usize,
+    pub end: usize,
+    /// Used inside at least one loop (hot: worth a register)
+    pub in_loop: bool,
+    /// Innermost profile site of each use (None = straight-line body)
+    pub sites: Vec<Option<usize>>,
+}
+
+#[derive(Default)]
+struct Scan {
+    point: usize,
+    uses: HashMap<String, Vec<usize>>,
+    use_sites: HashMap<String, Vec<Option<usize>>>,
+    /// Sites abiertos (el último es el más interno) y el próximo número
+    open_sites: Vec<usize>,
+    next_site: usize,
+    declared: HashSet<String>,
+    banned: HashSet<String>,
+    loops: Vec<(usize, usize)>,
+    unsupported: bool,
+    /// Llama a otra función (o a printf vía Print)
+    calls: bool,
+    /// &x, o un array/struct local cuya dirección se usa sin `&`
+    escapes: bool,
+}
+
+/// Rangos de los locales promovibles de `body`, ordenados por inicio.
+/// None si la función usa construcciones que el análisis no modela.
+pub fn local_ranges(body: &[Stmt]) -> Option<Vec<LocalRange>> {
+    let mut scan = Scan::default();
+    scan.stmts(body);
+    if scan.unsupported {
+        return None;
+    }
+    Some(scan.ranges())
+}
+
+/// Rangos de una función hoja: los parámetros cuentan como locales
+/// declarados en el punto 0. None si hay llamadas o si algún local o
+/// parámetro tiene que vivir en memoria (no puede haber frame).
+pub fn leaf_ranges(body: &[Stmt], params: &[String]) -> Option<Vec<LocalRange>> {
+    let mut scan = Scan::default();
+    for param in params {
+        scan.declared.insert(param.clone());
+        scan.use_var(param);
+    }
+    scan.stmts(body);
+    if scan.unsupported || scan.calls || scan.declared.iter().any(|n| scan.banned.contains(n)) {
+        return None;
+    }
+    Some(scan.ranges())
+}
+
+/// true si algún puntero al frame puede sobrevivir a una iteración:
+/// el frame no se puede reutilizar para una llamada recursiva de cola
+pub fn frame_escapes(body: &[Stmt]) -> bool {
+    let mut scan = Scan::default();
+    scan.stmts(body);
+    scan.unsupported || scan.escapes
+}
+
+/// Variables que lee `expr`; None si toma alguna dirección
+pub fn expr_vars(expr: &Expr) -> Option<HashSet<String>> {
+    let mut scan = Scan::default();
+    scan.opaque(expr);
+    (!scan.unsupported && !scan.escapes).then_some(scan.banned)
+}
+
+/// Tipos que caben en un registro de 64 bits sin cambiar el codegen
+pub fn is_register_scalar(ty: &Type) -> bool {
+    matches!(
+        ty,
+        Type::I8
+            | Type::I16
+            | Type::I32
+            | Type::I64
+            | Type::U8
+            | Type::U16
+            | Type::U32
+            | Type::U64
+            | Type::Bool
+            | Type::Pointer(_)
+    )
+}
+
+impl Scan {
+    fn ranges(&self) -> Vec<LocalRange> {
+        let mut ranges = Vec::new();
+        for (name, points) in &self.uses {
+            if !self.declared.contains(name) || self.banned.contains(name) {
+                continue;
+            }
+            let mut start = points.iter().copied().min().unwrap_or(0);
+            let mut end = points.iter().copied().max().unwrap_or(0);
+            let mut in_loop = false;
+            for &(loop_start, loop_end) in &self.loops {
+                if points.iter().any(|&p| p >= loop_start && p <= loop_end) {
+                    in_loop = true;
+                    start = start.min(loop_start);
+                    end = end.max(loop_end);
+                }
+            }
+            ranges.push(LocalRange {
+                name: name.clone(),
+                start,
+                end,
+                in_loop,
+                sites: self.use_sites.get(name).cloned().unwrap_or_default(),
+            });
+        }
+        ranges.sort_by(|a, b| a.start.cmp(&b.start).then_with(|| a.name.cmp(&b.name)));
+        ranges
+    }
+
+    fn use_var(&mut self, name: &str) {
+        self.uses.entry(name.to_string()).or_default().push(self.point);
+        let site = self.open_sites.last().copied();
+        self.use_sites.entry(name.to_string()).or_default().push(site);
+    }
+
+    fn ban(&mut self, name: &str) {
+        self.banned.insert(name.to_string());
+    }
+
+    fn stmts(&mut self, body: &[Stmt]) {
+        for stmt in body {
+            self.stmt(stmt);
+        }
+    }
+
+    fn loop_body(&mut self, start: usize, body: &[Stmt]) {
+        self.stmts(body);
+        self.loops.push((start, self.point));
+    }
+
+    fn stmt(&mut self, stmt: &Stmt) {
+        let site = is_site(stmt);
+        if site {
+            self.open_sites.push(self.next_site);
+            self.next_site += 1;
+        }
+        self.visit(stmt);
+        if site {
+            self.open_sites.pop();
+        }
+    }
+
+    fn visit(&mut self, stmt: &Stmt) {
+        self.point += 1;
+        match stmt {
+            Stmt::Print(e) | Stmt::Println(e) | Stmt::PrintNum(e) => {
+                self.calls = true;
+                self.expr(e);
+            }
+            Stmt::Expr(e) => self.expr(e),
+            Stmt::Return(value) => {
+                if let Some(e) = value {
+                    self.expr(e);
+                }
+            }
+            Stmt::Break | Stmt::Continue | Stmt::Pass | Stmt::LineMarker(_) => {}
+            Stmt::VarDecl {
+                var_type,
+                name,
+                value,
+            } => {
+                if let Some(e) = value {
+                    self.expr(e);
+                }
+                if is_register_scalar(var_type) {
+                    self.declared.insert(name.clone());
+                } else {
+                    self.escapes |= !matches!(var_type, Type::F32 | Type::F64);
+                    self.ban(name);
+                }
+                self.use_var(name);
+            }
+            Stmt::Assign { name, value } | Stmt::CompoundAssign { name, value, .. } => {
+                self.expr(value);
+                self.use_var(name);
+            }
+            Stmt::Increment { name, .. } => self.use_var(name),
+            Stmt::IndexAssign {
+                object,
+                index,
+                value,
+            } => {
+                self.opaque(object);
+                self.expr(index);
+                self.expr(value);
+            }
+            Stmt::FieldAssign { object, value, .. } => {
+                self.opaque(object);
+                self.expr(value);
+            }
+            Stmt::ArrowAssign { pointer, value, .. } => {
+                self.opaque(pointer);
+                self.expr(value);
+            }
+            Stmt::DerefAssign { pointer, value } => {
+                self.expr(pointer);
+                self.expr(value);
+            }
+            Stmt::If {
+                condition,
+                then_body,
+                else_body,
+            } => {
+                self.expr(condition);
+                self.stmts(then_body);
+                if let Some(body) = else_body {
+                    self.stmts(body);
+                }
+            }
+            Stmt::While { condition, body } | Stmt::DoWhile { body, condition } => {
+                let start = self.point;
+                self.expr(condition);
+                self.loop_body(start, body);
+            }
+            Stmt::For {
+                var,
+                start,
+                end,
+                body,
+            } => {
+                // emit_for maneja su variable en el slot
+                self.ban(var);
+                let loop_start = self.point;
+                self.expr(start);
+                self.expr(end);
+                self.loop_body(loop_start, body);
+            }
+            Stmt::ForEach {
+                var,
+                iterable,
+                body,
+            } => {
+                self.ban(var);
+                let loop_start = self.point;
+                self.opaque(iterable);
+                self.loop_body(loop_start, body);
+            }
+            Stmt::Free(e) | Stmt::Delete { expr: e, .. } => self.opaque(e),
+            Stmt::Assert { condition, message } => {
+                self.opaque(condition);
+                if let Some(m) = message {
+                    self.opaque(m);
+                }
+            }
+            Stmt::Switch {
+                expr,
+                cases,
+                default,
+            } => {
+                self.expr(expr);
+                for case in cases {
+                    self.expr(&case.value);
+                }
+                for case in cases {
+                    self.stmts(&case.body);
+                }
+                if let Some(body) = default {
+                    self.stmts(body);
+                }
+            }
+            // goto/labels, OS-level, directivas: sin análisis
+            _ => self.unsupported = true,
+        }
+    }
+
+    fn expr(&mut self, expr: &Expr) {
+        match expr {
+            Expr::Variable(name) => self.use_var(name),
+            Expr::Number(_)
+            | Expr::Float(_)
+            | Expr::String(_)
+            | Expr::Bool(_)
+            | Expr::Null
+            | Expr::Nullptr
+            | Expr::This
+            | Expr::Super
+            | Expr::Input
+            | Expr::CpuidExpr
+            | Expr::LabelAddr { .. } => {}
+            Expr::BinaryOp { left, right, .. }
+            | Expr::Comparison { left, right, .. }
+            | Expr::BitwiseOp { left, right, .. } => {
+                self.expr(left);
+                self.expr(right);
+            }
+            Expr::UnaryOp { expr: inner, .. }
+            | Expr::IntCast(inner)
+            | Expr::FloatCast(inner)
+            | Expr::BoolCast(inner)
+            | Expr::BitwiseNot(inner)
+            | Expr::Deref(inner)
+            | Expr::Cast { expr: inner, .. }
+            | Expr::PreIncrement(inner)
+            | Expr::PreDecrement(inner)
+            | Expr::PostIncrement(inner)
+            | Expr::PostDecrement(inner)
+            | Expr::MemRead { addr: inner }
+            | Expr::PortIn { port: inner } => self.expr(inner),
+            Expr::Ternary {
+                condition,
+                then_expr,
+                else_expr,
+            } => {
+                self.expr(condition);
+                self.expr(then_expr);
+                self.expr(else_expr);
+            }
+            Expr::Call { name, args } => {
+                // Un local con ese nombre es un puntero a función
+                self.calls = true;
+                self.ban(name);
+                for arg in args {
+                    self.expr(arg);
+                }
+            }
+            Expr::Array(elems) => {
+                for e in elems {
+                    self.expr(e);
+                }
+            }
+            Expr::Index { object, index } => {
+                self.opaque(object);
+                self.expr(index);
+            }
+            Expr::RegRead { .. } => self.unsupported = true,
+            _ => self.opaque(expr),
+        }
+    }
+
+    /// Subárbol que el codegen puede leer vía slot: todas sus variables
+    /// se quedan en memoria
+    fn opaque(&mut self, expr: &Expr) {
+        match expr {
+            Expr::Variable(name) => self.ban(name),
+            Expr::BinaryOp { left, right, .. }
+            | Expr::Comparison { left, right, .. }
+            | Expr::BitwiseOp { left, right, .. }
+            | Expr::StringConcat { left, right } => {
+                self.opaque(left);
+                self.opaque(right);
+            }
+            Expr::AddressOf(inner) => {
+                self.escapes = true;
+                self.opaque(inner);
+            }
+            Expr::UnaryOp { expr: inner, .. }
+            | Expr::IntCast(inner)
+            | Expr::FloatCast(inner)
+            | Expr::StrCast(inner)
+            | Expr::BoolCast(inner)
+            | Expr::BitwiseNot(inner)
+            | Expr::Deref(inner)
+            | Expr::Cast { expr: inner, .. }
+            | Expr::PreIncrement(inner)
+            | Expr::PreDecrement(inner)
+            | Expr::PostIncrement(inner)
+            | Expr::PostDecrement(inner)
+            | Expr::Len(inner)
+            | Expr::Pop(inner)
+            | Expr::Malloc(inner)
+            | Expr::MemRead { addr: inner }
+            | Expr::PortIn { port: inner }
+            | Expr::FieldAccess { object: inner, .. }
+            | Expr::ArrowAccess { pointer: inner, .. } => self.opaque(inner),
+            Expr::Lambda { body, .. } => self.opaque(body),
+            Expr::Ternary {
+                condition,
+                then_expr,
+                else_expr,
+            } => {
+                self.opaque(condition);
+                self.opaque(then_expr);
+                self.opaque(else_expr);
+            }
+            Expr::Call { name, args } | Expr::New { class_name: name, args } => {
+                self.calls = true;
+                self.ban(name);
+                for arg in args {
+                    self.opaque(arg);
+                }
+            }
+            Expr::MethodCall { object, args, .. } | Expr::VirtualCall { object, args, .. } => {
+                self.calls = true;
+                self.opaque(object);
+                for arg in args {
+                    self.opaque(arg);
+                }
+            }
+            Expr::Array(elems) => {
+                for e in elems {
+                    self.opaque(e);
+                }
+            }
+            Expr::Index { object, index } => {
+                self.opaque(object);
+                self.opaque(index);
+            }
+            Expr::Slice { object, start, end } => {
+                self.opaque(object);
+                for e in [start, end].into_iter().flatten() {
+                    self.opaque(e);
+                }
+            }
+            Expr::Push { array, value } => {
+                self.opaque(array);
+                self.opaque(value);
+            }
+            Expr::Realloc { ptr, new_size } => {
+                self.opaque(ptr);
+                self.opaque(new_size);
+            }
+            Expr::SizeOf(arg) => {
+                if let SizeOfArg::Expr(e) = arg.as_ref() {
+                    self.opaque(e);
+                }
+            }
+            Expr::RegRead { .. } => self.unsupported = true,
+            Expr::Number(_)
+            | Expr::Float(_)
+            | Expr::String(_)
+            | Expr::Bool(_)
+            | Expr::Null
+            | Expr::Nullptr
+            | Expr::This
+            | Expr::Super
+            | Expr::Input
+            | Expr::CpuidExpr
+            | Expr::LabelAddr { .. } => {}
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn var(name: &str) -> Expr {
+        Expr::Variable(name.to_string())
+    }
+
+    fn decl(name: &str, value: i64) -> Stmt {
+        Stmt::VarDecl {
+            var_type: Type::I64,
+            name: name.to_string(),
+            value: Some(Expr::Number(value)),
+        }
+    }
+
+    #[test]
+    fn test_loop_extends_range() {
+        // long i = 0; long sum = 0; long k = 5;
+        // while (i < 10) { sum += i; i++; }
+        // return sum + k;
+        let body = vec![
+            decl("i", 0),
+            decl("sum", 0),
+            decl("k", 5),
+            Stmt::While {
+                condition: Expr::Comparison {
+                    op: CmpOp::Lt,
+                    left: Box::new(var("i")),
+                    right: Box::new(Expr::Number(10)),
+                },
+                body: vec![
+                    Stmt::CompoundAssign {
+                        name: "sum".to_string(),
+                        op: CompoundOp::AddAssign,
+                        value: var("i"),
+                    },
+                    Stmt::Increment {
+                        name: "i".to_string(),
+                        is_pre: false,
+                        is_increment: true,
+                    },
+                ],
+            },
+            Stmt::Return(Some(Expr::BinaryOp {
+                op: BinOp::Add,
+                left: Box::new(var("sum")),
+                right: Box::new(var("k")),
+            })),
+        ];
+        let ranges = local_ranges(&body).unwrap();
+        let get = |n: &str| ranges.iter().find(|r| r.name == n).unwrap().clone();
+        assert_eq!(
+            get("i"),
+            LocalRange {
+                name: "i".into(),
+                start: 1,
+                end: 6,
+                in_loop: true,
+                sites: vec![None, Some(0), Some(0), Some(0)],
+            }
+        );
+        assert_eq!(get("sum").end, 7);
+        assert!(get("sum").in_loop);
+        assert!(!get("k").in_loop);
+    }
+
+    #[test]
+    fn test_address_taken_is_excluded() {
+        let body = vec![
+            decl("x", 1),
+            Stmt::Expr(Expr::Call {
+                name: "f".to_string(),
+                args: vec![Expr::AddressOf(Box::new(var("x")))],
+            }),
+        ];
+        assert!(local_ranges(&body).unwrap().is_empty());
+    }
+
+    #[test]
+    fn test_goto_disables_analysis() {
+        let body = vec![decl("x", 1), Stmt::LabelDef { name: "again".to_string() }];
+        assert!(local_ranges(&body).is_none());
+    }
+
+    #[test]
+    fn test_leaf_ranges_include_params() {
+        // long acc = a; while (acc < b) acc += acc; return acc;
+        let body = vec![
+            Stmt::VarDecl {
+                var_type: Type::I64,
+                name: "acc".to_string(),
+                value: Some(var("a")),
+            },
+            Stmt::While {
+                condition: Expr::Comparison {
+                    op: CmpOp::Lt,
+                    left: Box::new(var("acc")),
+                    right: Box::new(var("b")),
+                },
+                body: vec![Stmt::CompoundAssign {
+                    name: "acc".to_string(),
+                    op: CompoundOp::AddAssign,
+                    value: var("acc"),
+                }],
+            },
+            Stmt::Return(Some(var("acc"))),
+        ];
+        let params = vec!["a".to_string(), "b".to_string()];
+        let ranges = leaf_ranges(&body, &params).unwrap();
+        let get = |n: &str| ranges.iter().find(|r| r.name == n).unwrap().clone();
+        assert_eq!(get("a").start, 0);
+        assert!(get("b").in_loop);
+        assert_eq!(ranges.len(), 3);
+        assert!(!frame_escapes(&body));
+
+        // Una llamada o un &param obligan a tener frame
+        let mut with_call = body.clone();
+        with_call.push(Stmt::Expr(Expr::Call { name: "g".to_string(), args: vec![] }));
+        assert!(leaf_ranges(&with_call, &params).is_none());
+        let with_addr = vec![Stmt::Return(Some(Expr::AddressOf(Box::new(var("a")))))];
+        assert!(leaf_ranges(&with_addr, &params).is_none());
+        assert!(frame_escapes(&with_addr));
+    }
+
+    #[test]
+    fn test_use_sites_match_profile_numbering() {
+        // if (a) { while (b) { x += 1; } } for (...) { if (x) x = 0; }
+        let inc = Stmt::CompoundAssign {
+            name: "x".to_string(),
+            op: CompoundOp::AddAssign,
+            value: Expr::Number(1),
+        };
+        let body = vec![
+            decl("x", 0),
+            Stmt::If {
+                condition: var("a"),
+                then_body: vec![Stmt::While { condition: var("b"), body: vec![inc] }],
+                else_body: None,
+            },
+            Stmt::For {
+                var: "i".to_string(),
+                start: Expr::Number(0),
+                end: Expr::Number(4),
+                body: vec![Stmt::If {
+                    condition: var("x"),
+                    then_body: vec![Stmt::Assign { name: "x".to_string(), value: Expr::Number(0) }],
+                    else_body: None,
+                }],
+            },
+        ];
+        let sites = adeb_middle::profile::site_stmts(&body);
+        assert_eq!(sites.len(), 4);
+        assert!(matches!(sites[3], Stmt::If { condition: Expr::Variable(v), .. } if v == "x"));
+        let ranges = local_ranges(&body).unwrap();
+        let x = ranges.iter().find(|r| r.name == "x").unwrap();
+        assert_eq!(x.sites, vec![None, Some(1), Some(3), Some(3)]);
+    }
+}
@@ -0,0 +1,964 @@
+// ============================================================
+// ADead-BIB — Loop Optimizer (unroll + variables de inducción)
+// ============================================================
+// Reescribe el cuerpo de cada función antes del codegen. Solo
+// toca bucles internos (sin otro bucle dentro) con forma `for`:
+//
+//   while (i < n) { cuerpo; i++ }      (i <= n | n > i | n >= i)
+//
+// con `i` y `n` enteros locales/parámetros (o `n` constante) que
+// el cuerpo no escribe ni cuya dirección se toma en la función,
+// y un cuerpo sin break/continue/return/goto ni declaraciones.
+//
+// 1. Unroll completo: si justo antes va `i = c` y `n` es
+//    constante, con hasta MAX_FULL_TRIPS vueltas y FULL_BUDGET
+//    nodos en total. Cada copia lleva `i` sustituido por su
+//    constante, así `a[i]` de un array local queda en un
+//    [rbp+disp] fijo. Se cierra con `i = c + vueltas`.
+//
+// 2. Inducción a punteros: un puntero `p` que solo se usa como
+//    `p[i + k]` pasa a un puntero propio `__p_ivN = p + i`,
+//    calculado una vez antes del bucle, con accesos `__p_ivN[k]`
+//    (un load con desplazamiento) y avanzado junto con `i`.
+//
+// 3. Unroll parcial: factor según los nodos del cuerpo
+//    (unroll_factor). Un bucle principal con U copias, una sola
+//    comparación `i + (U-1) < n` y un solo avance de `i` y de los
+//    punteros; detrás queda el bucle de una copia como resto.
+//
+// Los cuerpos de solo `arr[i] = expr` se dejan al vectorizador
+// AVX2 (loop_vectorizer.rs), salvo el unroll completo. Con
+// `-fprofile-use` el isa_compiler no pasa por aquí: los sites
+// del perfil apuntan a los statements originales.
+// ============================================================
+
+use super::loop_vectorizer;
+use crate::frontend::ast::*;
+use std::collections::{HashMap, HashSet};
+
+/// Vueltas máximas de un bucle que se desenrolla entero
+pub const MAX_FULL_TRIPS: i64 = 8;
+/// Nodos del cuerpo desenrollado entero (vueltas × cuerpo)
+pub const FULL_BUDGET: usize = 96;
+
+/// Factor de unroll parcial según los nodos del cuerpo (1 = ninguno)
+pub fn unroll_factor(cost: usize) -> usize {
+    match cost {
+        0..=12 => 4,
+        13..=32 => 2,
+        _ => 1,
+    }
+}
+
+/// `func` con sus bucles internos reescritos; None si no cambia nada
+pub fn optimize_function(func: &Function) -> Option<Function> {
+    let mut pass = LoopOpt::new(func);
+    let body = pass.block(&func.body);
+    if !pass.changed {
+        return None;
+    }
+    let mut out = func.clone();
+    out.body = body;
+    Some(out)
+}
+
+// ============================================================
+// Recorrido del AST
+// ============================================================
+
+pub(super) fn stmt_exprs(stmt: &Stmt) -> Vec<&Expr> {
+    match stmt {
+        Stmt::Print(e)
+        | Stmt::Println(e)
+        | Stmt::PrintNum(e)
+        | Stmt::Expr(e)
+        | Stmt::Free(e)
+        | Stmt::Return(Some(e))
+        | Stmt::VarDecl { value: Some(e), .. }
+        | Stmt::Delete { expr: e, .. } => vec![e],
+        Stmt::Assign { value, .. } | Stmt::CompoundAssign { value, .. } | Stmt::RegAssign { value, .. } => {
+            vec![value]
+        }
+        Stmt::IndexAssign { object, index, value } => vec![object, index, value],
+        Stmt::FieldAssign { object, value, .. } => vec![object, value],
+        Stmt::DerefAssign { pointer, value } | Stmt::ArrowAssign { pointer, value, .. } => vec![pointer, value],
+        Stmt::MemWrite { addr: a, value } | Stmt::PortOut { port: a, value } => vec![a, value],
+        Stmt::If { condition, .. } | Stmt::While { condition, .. } | Stmt::DoWhile { condition, .. } => {
+            vec![condition]
+        }
+        Stmt::For { start, end, .. } => vec![start, end],
+        Stmt::ForEach { iterable, .. } => vec![iterable],
+        Stmt::Assert { condition, message } => std::iter::once(condition).chain(message.as_ref()).collect(),
+        Stmt::Switch { expr, cases, .. } => std::iter::once(expr).chain(cases.iter().map(|c| &c.value)).collect(),
+        _ => Vec::new(),
+    }
+}
+
+/// Igual que `stmt_exprs`, mutable
+pub(super) fn stmt_exprs_mut(stmt: &mut Stmt) -> Vec<&mut Expr> {
+    match stmt {
+        Stmt::Print(e)
+        | Stmt::Println(e)
+        | Stmt::PrintNum(e)
+        | Stmt::Expr(e)
+        | Stmt::Free(e)
+        | Stmt::Return(Some(e))
+        | Stmt::VarDecl { value: Some(e), .. }
+        | Stmt::Delete { expr: e, .. } => vec![e],
+        Stmt::Assign { value, .. } | Stmt::CompoundAssign { value, .. } | Stmt::RegAssign { value, .. } => {
+            vec![value]
+        }
+        Stmt::IndexAssign { object, index, value } => vec![object, index, value],
+        Stmt::FieldAssign { object, value, .. } => vec![object, value],
+        Stmt::DerefAssign { pointer, value } | Stmt::ArrowAssign { pointer, value, .. } => vec![pointer, value],
+        Stmt::MemWrite { addr: a, value } | Stmt::PortOut { port: a, value } => vec![a, value],
+        Stmt::If { condition, .. } | Stmt::While { condition, .. } | Stmt::DoWhile { condition, .. } => {
+            vec![condition]
+        }
+        Stmt::For { start, end, .. } => vec![start, end],
+        Stmt::ForEach { iterable, .. } => vec![iterable],
+        Stmt::Assert { condition, message } => std::iter::once(condition).chain(message.as_mut()).collect(),
+        Stmt::Switch { expr, cases, .. } => {
+            std::iter::once(expr).chain(cases.iter_mut().map(|c| &mut c.value)).collect()
+        }
+        _ => Vec::new(),
+    }
+}
+
+pub(super) fn child_bodies(stmt: &Stmt) -> Vec<&Vec<Stmt>> {
+    match stmt {
+        Stmt::If { then_body, else_body, .. } => std::iter::once(then_body).chain(else_body.as_ref()).collect(),
+        Stmt::While { body, .. } | Stmt::DoWhile { body, .. } | Stmt::For { body, .. } | Stmt::ForEach { body, .. } => {
+            vec![body]
+        }
+        Stmt::Switch { cases, default, .. } => cases.iter().map(|c| &c.body).chain(default.as_ref()).collect(),
+        _ => Vec::new(),
+    }
+}
+
+/// Igual que `child_bodies`, mutable
+pub(super) fn child_bodies_mut(stmt: &mut Stmt) -> Vec<&mut Vec<Stmt>> {
+    match stmt {
+        Stmt::If { then_body, else_body, .. } => std::iter::once(then_body).chain(else_body.as_mut()).collect(),
+        Stmt::While { body, .. } | Stmt::DoWhile { body, .. } | Stmt::For { body, .. } | Stmt::ForEach { body, .. } => {
+            vec![body]
+        }
+        Stmt::Switch { cases, default, .. } => {
+            cases.iter_mut().map(|c| &mut c.body).chain(default.as_mut()).collect()
+        }
+        _ => Vec::new(),
+    }
+}
+
+pub(super) fn expr_children(expr: &Expr) -> Vec<&Expr> {
+    match expr {
+        Expr::BinaryOp { left, right, .. }
+        | Expr::Comparison { left, right, .. }
+        | Expr::BitwiseOp { left, right, .. }
+        | Expr::StringConcat { left, right }
+        | Expr::Index { object: left, index: right }
+        | Expr::Push { array: left, value: right }
+        | Expr::Realloc { ptr: left, new_size: right } => vec![&**left, &**right],
+        Expr::UnaryOp { expr: e, .. }
+        | Expr::Cast { expr: e, .. }
+        | Expr::Len(e)
+        | Expr::Pop(e)
+        | Expr::IntCast(e)
+        | Expr::FloatCast(e)
+        | Expr::StrCast(e)
+        | Expr::BoolCast(e)
+        | Expr::Deref(e)
+        | Expr::AddressOf(e)
+        | Expr::Malloc(e)
+        | Expr::PreIncrement(e)
+        | Expr::PreDecrement(e)
+        | Expr::PostIncrement(e)
+        | Expr::PostDecrement(e)
+        | Expr::BitwiseNot(e)
+        | Expr::FieldAccess { object: e, .. }
+        | Expr::ArrowAccess { pointer: e, .. }
+        | Expr::Lambda { body: e, .. }
+        | Expr::MemRead { addr: e }
+        | Expr::PortIn { port: e } => vec![&**e],
+        Expr::Call { args, .. } | Expr::New { args, .. } | Expr::Array(args) => args.iter().collect(),
+        Expr::MethodCall { object, args, .. } | Expr::VirtualCall { object, args, .. } => {
+            std::iter::once(&**object).chain(args.iter()).collect()
+        }
+        Expr::Slice { object, start, end } => std::iter::once(object)
+            .chain(start.as_ref())
+            .chain(end.as_ref())
+            .map(|e| &**e)
+            .collect(),
+        Expr::Ternary { condition, then_expr, else_expr } => vec![&**condition, &**then_expr, &**else_expr],
+        Expr::SizeOf(arg) => match &**arg {
+            SizeOfArg::Expr(e) => vec![e],
+            SizeOfArg::Type(_) => Vec::new(),
+        },
+        _ => Vec::new(),
+    }
+}
+
+/// Igual que `expr_children`, mutable (para reescribir en sitio)
+pub(super) fn expr_children_mut(expr: &mut Expr) -> Vec<&mut Expr> {
+    match expr {
+        Expr::BinaryOp { left, right, .. }
+        | Expr::Comparison { left, right, .. }
+        | Expr::BitwiseOp { left, right, .. }
+        | Expr::StringConcat { left, right }
+        | Expr::Index { object: left, index: right }
+        | Expr::Push { array: left, value: right }
+        | Expr::Realloc { ptr: left, new_size: right } => vec![&mut **left, &mut **right],
+        Expr::UnaryOp { expr: e, .. }
+        | Expr::Cast { expr: e, .. }
+        | Expr::Len(e)
+        | Expr::Pop(e)
+        | Expr::IntCast(e)
+        | Expr::FloatCast(e)
+        | Expr::StrCast(e)
+        | Expr::BoolCast(e)
+        | Expr::Deref(e)
+        | Expr::AddressOf(e)
+        | Expr::Malloc(e)
+        | Expr::PreIncrement(e)
+        | Expr::PreDecrement(e)
+        | Expr::PostIncrement(e)
+        | Expr::PostDecrement(e)
+        | Expr::BitwiseNot(e)
+        | Expr::FieldAccess { object: e, .. }
+        | Expr::ArrowAccess { pointer: e, .. }
+        | Expr::Lambda { body: e, .. }
+        | Expr::MemRead { addr: e }
+        | Expr::PortIn { port: e } => vec![&mut **e],
+        Expr::Call { args, .. } | Expr::New { args, .. } | Expr::Array(args) => args.iter_mut().collect(),
+        Expr::MethodCall { object, args, .. } | Expr::VirtualCall { object, args, .. } => {
+            std::iter::once(&mut **object).chain(args.iter_mut()).collect()
+        }
+        Expr::Slice { object, start, end } => std::iter::once(object)
+            .chain(start.as_mut())
+            .chain(end.as_mut())
+            .map(|e| &mut **e)
+            .collect(),
+        Expr::Ternary { condition, then_expr, else_expr } => {
+            vec![&mut **condition, &mut **then_expr, &mut **else_expr]
+        }
+        Expr::SizeOf(arg) => match &mut **arg {
+            SizeOfArg::Expr(e) => vec![e],
+            SizeOfArg::Type(_) => Vec::new(),
+        },
+        _ => Vec::new(),
+    }
+}
+
+pub(super) fn for_each_expr(stmts: &[Stmt], f: &mut impl FnMut(&Expr)) {
+    fn walk(expr: &Expr, f: &mut impl FnMut(&Expr)) {
+        f(expr);
+        for child in expr_children(expr) {
+            walk(child, f);
+        }
+    }
+    for stmt in stmts {
+        for expr in stmt_exprs(stmt) {
+            walk(expr, f);
+        }
+        for body in child_bodies(stmt) {
+            for_each_expr(body, f);
+        }
+    }
+}
+
+fn is_loop(stmt: &Stmt) -> bool {
+    matches!(stmt, Stmt::While { .. } | Stmt::DoWhile { .. } | Stmt::For { .. } | Stmt::ForEach { .. })
+}
+
+fn has_loop(stmts: &[Stmt]) -> bool {
+    stmts.iter().any(|s| is_loop(s) || child_bodies(s).into_iter().any(|b| has_loop(b)))
+}
+
+fn is_int(ty: &Type) -> bool {
+    matches!(
+        ty,
+        Type::I8 | Type::I16 | Type::I32 | Type::I64 | Type::U8 | Type::U16 | Type::U32 | Type::U64
+    )
+}
+
+/// Puntero a un escalar (el codegen escala `p + k` por su tamaño)
+fn is_scalar_pointer(ty: &Type) -> bool {
+    match ty {
+        Type::Pointer(inner) => is_int(inner) || matches!(inner.as_ref(), Type::F32 | Type::F64),
+        _ => false,
+    }
+}
+
+fn var(name: &str) -> Expr {
+    Expr::Variable(name.to_string())
+}
+
+fn add(left: Expr, k: i64) -> Expr {
+    Expr::BinaryOp { op: BinOp::Add, left: Box::new(left), right: Box::new(Expr::Number(k)) }
+}
+
+/// k si `index` es `i`, `i + k`, `k + i` o `i - k`
+fn affine_offset(index: &Expr, iv: &str) -> Option<i64> {
+    let is_iv = |e: &Expr| matches!(e, Expr::Variable(v) if v == iv);
+    match index {
+        e if is_iv(e) => Some(0),
+        Expr::BinaryOp { op: BinOp::Add, left, right } => match (left.as_ref(), right.as_ref()) {
+            (l, Expr::Number(k)) if is_iv(l) => Some(*k),
+            (Expr::Number(k), r) if is_iv(r) => Some(*k),
+            _ => None,
+        },
+        Expr::BinaryOp { op: BinOp::Sub, left, right } => match (left.as_ref(), right.as_ref()) {
+            (l, Expr::Number(k)) if is_iv(l) => k.checked_neg(),
+            _ => None,
+        },
+        _ => None,
+    }
+}
+
+/// Pliega `c1 op c2` y `(x ± c1) ± c2` tras una sustitución
+fn fold(expr: &mut Expr) {
+    let Expr::BinaryOp { op, left, right } = expr else {
+        return;
+    };
+    let (op, k) = match (*op, right.as_ref()) {
+        (BinOp::Add, Expr::Number(k)) => (BinOp::Add, *k),
+        (BinOp::Sub, Expr::Number(k)) => (BinOp::Add, k.wrapping_neg()),
+        (BinOp::Mul, Expr::Number(k)) => (BinOp::Mul, *k),
+        _ => return,
+    };
+    match (op, left.as_mut()) {
+        (BinOp::Add, Expr::Number(c)) => *expr = Expr::Number(c.wrapping_add(k)),
+        (BinOp::Mul, Expr::Number(c)) => *expr = Expr::Number(c.wrapping_mul(k)),
+        (BinOp::Add, Expr::BinaryOp { op: BinOp::Add, left: inner, right }) => {
+            if let Expr::Number(c) = right.as_ref() {
+                let sum = c.wrapping_add(k);
+                let inner = std::mem::replace(inner.as_mut(), Expr::Null);
+                *expr = if sum == 0 { inner } else { add(inner, sum) };
+            }
+        }
+        _ => {}
+    }
+}
+
+// ============================================================
+// Análisis del cuerpo
+// ============================================================
+
+/// Lo que el cuerpo de un bucle candidato hace
+#[derive(Default)]
+struct BodyFacts {
+    /// Escalares que escribe (asignación, compound, ++/--)
+    writes: HashSet<String>,
+    /// Nodos de statements y expresiones (tamaño para el unroll)
+    cost: usize,
+}
+
+impl BodyFacts {
+    /// None si el cuerpo tiene control de flujo o construcciones que
+    /// no se pueden duplicar
+    fn scan(stmts: &[Stmt]) -> Option<Self> {
+        let mut facts = BodyFacts::default();
+        facts.stmts(stmts)?;
+        for_each_expr(stmts, &mut |e| {
+            facts.cost += 1;
+            if let Expr::PreIncrement(t) | Expr::PreDecrement(t) | Expr::PostIncrement(t) | Expr::PostDecrement(t) = e {
+                if let Expr::Variable(name) = t.as_ref() {
+                    facts.writes.insert(name.clone());
+                }
+            }
+        });
+        let lambdas = stmts.iter().any(|s| {
+            let mut found = false;
+            for_each_expr(std::slice::from_ref(s), &mut |e| found |= matches!(e, Expr::Lambda { .. }));
+            found
+        });
+        (!lambdas).then_some(facts)
+    }
+
+    fn stmts(&mut self, stmts: &[Stmt]) -> Option<()> {
+        for stmt in stmts {
+            self.cost += 1;
+            match stmt {
+                Stmt::Assign { name, .. } | Stmt::CompoundAssign { name, .. } | Stmt::Increment { name, .. } => {
+                    self.writes.insert(name.clone());
+                }
+                Stmt::If { then_body, else_body, .. } => {
+                    self.stmts(then_body)?;
+                    if let Some(else_body) = else_body {
+                        self.stmts(else_body)?;
+                    }
+                }
+                Stmt::IndexAssign { .. }
+                | Stmt::FieldAssign { .. }
+                | Stmt::DerefAssign { .. }
+                | Stmt::ArrowAssign { .. }
+                | Stmt::Expr(_)
+                | Stmt::Print(_)
+                | Stmt::Println(_)
+                | Stmt::PrintNum(_)
+                | Stmt::LineMarker(_)
+                | Stmt::Pass => {}
+                _ => return None,
+            }
+        }
+        Some(())
+    }
+}
+
+/// true si el cuerpo es de los que el vectorizador AVX2 reconoce:
+/// solo `arr[i] = expr`
+fn vectorizer_shape(stmts: &[Stmt], iv: &str) -> bool {
+    let mut stores = 0;
+    for stmt in stmts {
+        match stmt {
+            Stmt::LineMarker(_) => {}
+            Stmt::IndexAssign { index: Expr::Variable(v), .. } if v == iv => stores += 1,
+            _ => return false,
+        }
+    }
+    stores > 0
+}
+
+// ============================================================
+// Pasada
+// ============================================================
+
+/// Un puntero pasado a variable de inducción propia
+struct PointerIv {
+    pointer: String,
+    name: String,
+    ty: Type,
+}
+
+struct LoopOpt {
+    /// Enteros locales/parámetros (todas sus declaraciones enteras)
+    ints: HashSet<String>,
+    /// Punteros a escalar locales/parámetros con un único tipo
+    pointers: HashMap<String, Type>,
+    /// Variables cuya dirección se toma en la función
+    escaped: HashSet<String>,
+    next_iv: usize,
+    changed: bool,
+}
+
+impl LoopOpt {
+    fn new(func: &Function) -> Self {
+        let mut types: HashMap<String, Option<Type>> = HashMap::new();
+        let mut declare = |name: &str, ty: &Type| {
+            let slot = types.entry(name.to_string()).or_insert_with(|| Some(ty.clone()));
+            if slot.as_ref().map_or(false, |t| t != ty) {
+                *slot = None;
+            }
+        };
+        for param in &func.params {
+            declare(&param.name, &param.param_type);
+        }
+        fn decls(stmts: &[Stmt], declare: &mut impl FnMut(&str, &Type)) {
+            for stmt in stmts {
+                if let Stmt::VarDecl { var_type, name, .. } = stmt {
+                    declare(name, var_type);
+                }
+                for body in child_bodies(stmt) {
+                    decls(body, declare);
+                }
+            }
+        }
+        decls(&func.body, &mut declare);
+
+        let mut escaped = HashSet::new();
+        for_each_expr(&func.body, &mut |e| {
+            if let Expr::AddressOf(inner) = e {
+                if let Expr::Variable(name) = inner.as_ref() {
+                    escaped.insert(name.clone());
+                }
+            }
+        });
+
+        let mut ints = HashSet::new();
+        let mut pointers = HashMap::new();
+        for (name, ty) in types {
+            match ty {
+                Some(ty) if is_int(&ty) => {
+                    ints.insert(name);
+                }
+                Some(ty) if is_scalar_pointer(&ty) => {
+                    pointers.insert(name, ty);
+                }
+                _ => {}
+            }
+        }
+        Self { ints, pointers, escaped, next_iv: 0, changed: false }
+    }
+
+    fn block(&mut self, stmts: &[Stmt]) -> Vec<Stmt> {
+        let mut out: Vec<Stmt> = Vec::with_capacity(stmts.len());
+        for stmt in stmts {
+            if let Stmt::While { condition, body } = stmt {
+                if !has_loop(body) {
+                    if let Some(lowered) = self.rewrite_loop(condition, body, &out) {
+                        self.changed = true;
+                        out.extend(lowered);
+                        continue;
+                    }
+                }
+            }
+            out.push(self.descend(stmt));
+        }
+        out
+    }
+
+    /// `stmt` con los bucles de sus cuerpos reescritos
+    fn descend(&mut self, stmt: &Stmt) -> Stmt {
+        match stmt {
+            Stmt::If { condition, then_body, else_body } => Stmt::If {
+                condition: condition.clone(),
+                then_body: self.block(then_body),
+                else_body: else_body.as_ref().map(|b| self.block(b)),
+            },
+            Stmt::While { condition, body } => Stmt::While { condition: condition.clone(), body: self.block(body) },
+            Stmt::DoWhile { body, condition } => Stmt::DoWhile { body: self.block(body), condition: condition.clone() },
+            Stmt::For { var, start, end, body } => Stmt::For {
+                var: var.clone(),
+                start: start.clone(),
+                end: end.clone(),
+                body: self.block(body),
+            },
+            Stmt::ForEach { var, iterable, body } => Stmt::ForEach {
+                var: var.clone(),
+                iterable: iterable.clone(),
+                body: self.block(body),
+            },
+            Stmt::Switch { expr, cases, default } => Stmt::Switch {
+                expr: expr.clone(),
+                cases: cases
+                    .iter()
+                    .map(|c| SwitchCase { value: c.value.clone(), body: self.block(&c.body), has_break: c.has_break })
+                    .collect(),
+                default: default.as_ref().map(|b| self.block(b)),
+            },
+            _ => stmt.clone(),
+        }
+    }
+
+    /// Statements que reemplazan al `while`; None si se queda como está
+    fn rewrite_loop(&mut self, condition: &Expr, body: &[Stmt], before: &[Stmt]) -> Option<Vec<Stmt>> {
+        let iv = loop_vectorizer::induction_var(body)?.to_string();
+        let (bound, inclusive) = loop_vectorizer::loop_bound(condition, &iv)?;
+        if !self.ints.contains(&iv) || self.escaped.contains(&iv) {
+            return None;
+        }
+        let inner = &body[..body.len() - 1];
+        let facts = BodyFacts::scan(inner)?;
+        if facts.writes.contains(&iv) {
+            return None;
+        }
+        match bound {
+            Expr::Number(_) => {}
+            Expr::Variable(n) if self.ints.contains(n) && !self.escaped.contains(n) && !facts.writes.contains(n) => {}
+            _ => return None,
+        }
+
+        if let (Some(start), Expr::Number(end)) = (initial_value(before, &iv), bound) {
+            let trips = end.saturating_sub(start).saturating_add(inclusive as i64);
+            if trips > 0 && trips <= MAX_FULL_TRIPS && facts.cost * trips as usize <= FULL_BUDGET {
+                let mut out = Vec::with_capacity(inner.len() * trips as usize + 1);
+                for k in 0..trips {
+                    out.extend(inner.iter().map(|s| subst_stmt(s, &iv, Subst::Const(start + k), &[])));
+                }
+                out.push(Stmt::Assign { name: iv, value: Expr::Number(start + trips) });
+                return Some(out);
+            }
+        }
+
+        if vectorizer_shape(inner, &iv) {
+            return None;
+        }
+        let ivs = self.pointer_ivs(inner, &iv, &facts);
+        let factor = unroll_factor(facts.cost);
+        if factor == 1 && ivs.is_empty() {
+            return None;
+        }
+
+        let update = &body[body.len() - 1];
+        let bumps = |step: i64| {
+            ivs.iter()
+                .map(|p| Stmt::Assign { name: p.name.clone(), value: add(var(&p.name), step) })
+                .collect::<Vec<_>>()
+        };
+        let mut out: Vec<Stmt> = ivs
+            .iter()
+            .map(|p| Stmt::VarDecl {
+                var_type: p.ty.clone(),
+                name: p.name.clone(),
+                value: Some(Expr::BinaryOp {
+                    op: BinOp::Add,
+                    left: Box::new(var(&p.pointer)),
+                    right: Box::new(var(&iv)),
+                }),
+            })
+            .collect();
+        if factor > 1 {
+            let mut main = Vec::with_capacity(inner.len() * factor + ivs.len() + 1);
+            for k in 0..factor as i64 {
+                main.extend(inner.iter().map(|s| subst_stmt(s, &iv, Subst::Offset(k), &ivs)));
+            }
+            main.extend(bumps(factor as i64));
+            main.push(Stmt::CompoundAssign {
+                name: iv.clone(),
+                op: CompoundOp::AddAssign,
+                value: Expr::Number(factor as i64),
+            });
+            out.push(Stmt::While {
+                condition: Expr::Comparison {
+                    op: if inclusive { CmpOp::Le } else { CmpOp::Lt },
+                    left: Box::new(add(var(&iv), factor as i64 - 1)),
+                    right: Box::new(bound.clone()),
+                },
+                body: main,
+            });
+        }
+        let mut rest: Vec<Stmt> = inner.iter().map(|s| subst_stmt(s, &iv, Subst::Offset(0), &ivs)).collect();
+        rest.extend(bumps(1));
+        rest.push(update.clone());
+        out.push(Stmt::While { condition: condition.clone(), body: rest });
+        Some(out)
+    }
+
+    /// Punteros del cuerpo que solo se usan como `p[i + k]`
+    fn pointer_ivs(&mut self, inner: &[Stmt], iv: &str, facts: &BodyFacts) -> Vec<PointerIv> {
+        // Por puntero: (accesos `p[..]`, todos afines, apariciones de `p`)
+        let mut seen: HashMap<String, (usize, bool, usize)> = HashMap::new();
+        let pointers = &self.pointers;
+        let mut access = |p: &str, index: &Expr| {
+            if pointers.contains_key(p) {
+                let entry = seen.entry(p.to_string()).or_insert((0, true, 0));
+                entry.0 += 1;
+                entry.1 &= affine_offset(index, iv).is_some();
+            }
+        };
+        // IndexAssign no es una expresión: sus stores se recorren aparte
+        fn stores(stmts: &[Stmt], access: &mut impl FnMut(&str, &Expr)) {
+            for stmt in stmts {
+                if let Stmt::IndexAssign { object: Expr::Variable(p), index, .. } = stmt {
+                    access(p, index);
+                }
+                for body in child_bodies(stmt) {
+                    stores(body, access);
+                }
+            }
+        }
+        stores(inner, &mut access);
+        for_each_expr(inner, &mut |e| {
+            if let Expr::Index { object, index } = e {
+                if let Expr::Variable(p) = object.as_ref() {
+                    access(p, index);
+                }
+            }
+        });
+        // Cada acceso cuenta también como aparición; otra aparición de `p`
+        // (aritmética, argumento, comparación) lo descarta
+        for_each_expr(inner, &mut |e| {
+            if let Expr::Variable(p) = e {
+                if let Some(entry) = seen.get_mut(p) {
+                    entry.2 += 1;
+                }
+            }
+        });
+
+        let mut candidates: Vec<(String, Type)> = seen
+            .into_iter()
+            .filter(|(p, (uses, affine, total))| {
+                *affine && uses == total && !facts.writes.contains(p) && !self.escaped.contains(p)
+            })
+            .map(|(p, _)| {
+                let ty = self.pointers[&p].clone();
+                (p, ty)
+            })
+            .collect();
+        candidates.sort_by(|a, b| a.0.cmp(&b.0));
+        candidates
+            .into_iter()
+            .map(|(pointer, ty)| {
+                let name = format!("__{}_iv{}", pointer, self.next_iv);
+                self.next_iv += 1;
+                PointerIv { pointer, name, ty }
+            })
+            .collect()
+    }
+}
+
+/// Valor constante que el statement anterior (sin LineMarker) da a `iv`
+fn initial_value(before: &[Stmt], iv: &str) -> Option<i64> {
+    match before.iter().rev().find(|s| !matches!(s, Stmt::LineMarker(_)))? {
+        Stmt::VarDecl { name, value: Some(Expr::Number(c)), .. } | Stmt::Assign { name, value: Expr::Number(c) }
+            if name == iv =>
+        {
+            Some(*c)
+        }
+        _ => None,
+    }
+}
+
+// ============================================================
+// Copias del cuerpo
+// ============================================================
+
+#[derive(Clone, Copy)]
+enum Subst {
+    /// `i` → la constante (unroll completo)
+    Const(i64),
+    /// `i` → `i + k` (copia k del unroll parcial)
+    Offset(i64),
+}
+
+impl Subst {
+    fn replace(self, iv: &str) -> Expr {
+        match self {
+            Subst::Const(c) => Expr::Number(c),
+            Subst::Offset(0) => var(iv),
+            Subst::Offset(k) => add(var(iv), k),
+        }
+    }
+
+    fn offset(self) -> i64 {
+        match self {
+            Subst::Const(_) => 0,
+            Subst::Offset(k) => k,
+        }
+    }
+}
+
+fn subst_stmt(stmt: &Stmt, iv: &str, with: Subst, ivs: &[PointerIv]) -> Stmt {
+    let mut stmt = stmt.clone();
+    subst_in_stmt(&mut stmt, iv, with, ivs);
+    stmt
+}
+
+fn subst_in_stmt(stmt: &mut Stmt, iv: &str, with: Subst, ivs: &[PointerIv]) {
+    match stmt {
+        Stmt::IndexAssign { object, index, value } => {
+            if let Some(p) = pointer_iv(object, ivs) {
+                let k = affine_offset(index, iv).expect("loop_opt: pointer IV with non-affine store");
+                *object = var(&p.name);
+                *index = Expr::Number(k + with.offset());
+            } else {
+                subst_in_expr(object, iv, with, ivs);
+                subst_in_expr(index, iv, with, ivs);
+            }
+            subst_in_expr(value, iv, with, ivs);
+        }
+        Stmt::If { condition, then_body, else_body } => {
+            subst_in_expr(condition, iv, with, ivs);
+            for s in then_body.iter_mut().chain(else_body.iter_mut().flatten()) {
+                subst_in_stmt(s, iv, with, ivs);
+            }
+        }
+        Stmt::Assign { value, .. } | Stmt::CompoundAssign { value, .. } => subst_in_expr(value, iv, with, ivs),
+        Stmt::FieldAssign { object, value, .. } => {
+            subst_in_expr(object, iv, with, ivs);
+            subst_in_expr(value, iv, with, ivs);
+        }
+        Stmt::DerefAssign { pointer, value } | Stmt::ArrowAssign { pointer, value, .. } => {
+            subst_in_expr(pointer, iv, with, ivs);
+            subst_in_expr(value, iv, with, ivs);
+        }
+        Stmt::Expr(e) | Stmt::Print(e) | Stmt::Println(e) | Stmt::PrintNum(e) => subst_in_expr(e, iv, with, ivs),
+        _ => {}
+    }
+}
+
+fn pointer_iv<'a>(object: &Expr, ivs: &'a [PointerIv]) -> Option<&'a PointerIv> {
+    match object {
+        Expr::Variable(p) => ivs.iter().find(|iv| &iv.pointer == p),
+        _ => None,
+    }
+}
+
+fn subst_in_expr(expr: &mut Expr, iv: &str, with: Subst, ivs: &[PointerIv]) {
+    if let Expr::Index { object, index } = expr {
+        if let Some(p) = pointer_iv(object, ivs) {
+            let k = affine_offset(index, iv).expect("loop_opt: pointer IV with non-affine load");
+            **object = var(&p.name);
+            **index = Expr::Number(k + with.offset());
+            return;
+        }
+    }
+    if matches!(expr, Expr::Variable(v) if v == iv) {
+        *expr = with.replace(iv);
+        return;
+    }
+    for child in expr_children_mut(expr) {
+        subst_in_expr(child, iv, with, ivs);
+    }
+    fold(expr);
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn int(name: &str) -> Stmt {
+        Stmt::VarDecl { var_type: Type::I64, name: name.to_string(), value: Some(Expr::Number(0)) }
+    }
+
+    fn lt(name: &str, bound: Expr) -> Expr {
+        Expr::Comparison { op: CmpOp::Lt, left: Box::new(var(name)), right: Box::new(bound) }
+    }
+
+    fn inc(name: &str) -> Stmt {
+        Stmt::Increment { name: name.to_string(), is_pre: false, is_increment: true }
+    }
+
+    fn index(object: &str, idx: Expr) -> Expr {
+        Expr::Index { object: Box::new(var(object)), index: Box::new(idx) }
+    }
+
+    fn function(params: Vec<(&str, Type)>, body: Vec<Stmt>) -> Function {
+        Function {
+            name: "f".to_string(),
+            params: params
+                .into_iter()
+                .map(|(name, param_type)| Param { name: name.to_string(), param_type, default_value: None })
+                .collect(),
+            return_type: Some("long".to_string()),
+            resolved_return_type: Type::I64,
+            body,
+            attributes: FunctionAttributes::default(),
+        }
+    }
+
+    /// s = s + a[i]
+    fn accumulate(array: &str) -> Stmt {
+        Stmt::Assign {
+            name: "s".to_string(),
+            value: Expr::BinaryOp {
+                op: BinOp::Add,
+                left: Box::new(var("s")),
+                right: Box::new(index(array, var("i"))),
+            },
+        }
+    }
+
+    fn loops(stmts: &[Stmt]) -> Vec<&Stmt> {
+        stmts.iter().filter(|s| matches!(s, Stmt::While { .. })).collect()
+    }
+
+    #[test]
+    fn test_full_unroll_substitutes_constants() {
+        let func = function(
+            vec![],
+            vec![
+                Stmt::VarDecl { var_type: Type::Array(Box::new(Type::I64), Some(4)), name: "a".to_string(), value: None },
+                int("s"),
+                int("i"),
+                Stmt::While { condition: lt("i", Expr::Number(4)), body: vec![accumulate("a"), inc("i")] },
+            ],
+        );
+        let out = optimize_function(&func).unwrap();
+        assert!(loops(&out.body).is_empty());
+        // 3 decls + 4 copias + i = 4
+        assert_eq!(out.body.len(), 8);
+        match &out.body[4] {
+            Stmt::Assign { value: Expr::BinaryOp { right, .. }, .. } => {
+                assert!(matches!(right.as_ref(), Expr::Index { index, .. } if matches!(index.as_ref(), Expr::Number(1))));
+            }
+            other => panic!("unexpected {:?}", other),
+        }
+        assert!(matches!(&out.body[7], Stmt::Assign { name, value: Expr::Number(4) } if name == "i"));
+    }
+
+    #[test]
+    fn test_pointer_iv_and_partial_unroll() {
+        let ptr = Type::Pointer(Box::new(Type::I64));
+        let func = function(
+            vec![("a", ptr.clone()), ("n", Type::I64)],
+            vec![
+                int("s"),
+                int("i"),
+                Stmt::While { condition: lt("i", var("n")), body: vec![accumulate("a"), inc("i")] },
+                Stmt::Return(Some(var("s"))),
+            ],
+        );
+        let out = optimize_function(&func).unwrap();
+        // __a_iv0 = a + i; bucle x4; resto; return
+        assert!(matches!(&out.body[2], Stmt::VarDecl { name, var_type, .. } if name == "__a_iv0" && *var_type == ptr));
+        let found = loops(&out.body);
+        assert_eq!(found.len(), 2);
+        let Stmt::While { condition, body } = found[0] else { unreachable!() };
+        assert!(matches!(condition, Expr::Comparison { op: CmpOp::Lt, left, .. }
+            if matches!(left.as_ref(), Expr::BinaryOp { right, .. } if matches!(right.as_ref(), Expr::Number(3)))));
+        // 4 copias, bump del puntero, i += 4
+        assert_eq!(body.len(), 6);
+        for (k, stmt) in body[..4].iter().enumerate() {
+            let Stmt::Assign { value: Expr::BinaryOp { right, .. }, .. } = stmt else { panic!("{:?}", stmt) };
+            match right.as_ref() {
+                Expr::Index { object, index } => {
+                    assert!(matches!(object.as_ref(), Expr::Variable(v) if v == "__a_iv0"));
+                    assert!(matches!(index.as_ref(), Expr::Number(n) if *n == k as i64));
+                }
+                other => panic!("unexpected {:?}", other),
+            }
+        }
+        assert!(matches!(&body[4], Stmt::Assign { name, .. } if name == "__a_iv0"));
+        assert!(matches!(&body[5], Stmt::CompoundAssign { value: Expr::Number(4), .. }));
+        // El resto conserva la condición y el update originales
+        let Stmt::While { body: rest, .. } = found[1] else { unreachable!() };
+        assert!(matches!(rest.last(), Some(Stmt::Increment { .. })));
+    }
+
+    #[test]
+    fn test_partial_copies_offset_the_iv() {
+        // s = s + i*i: sin punteros, copias con i + k
+        let square = Stmt::Assign {
+            name: "s".to_string(),
+            value: Expr::BinaryOp {
+                op: BinOp::Add,
+                left: Box::new(var("s")),
+                right: Box::new(Expr::BinaryOp { op: BinOp::Mul, left: Box::new(var("i")), right: Box::new(var("i")) }),
+            },
+        };
+        let func = function(
+            vec![("n", Type::I32)],
+            vec![int("s"), int("i"), Stmt::While { condition: lt("i", var("n")), body: vec![square, inc("i")] }],
+        );
+        let out = optimize_function(&func).unwrap();
+        let Stmt::While { body, .. } = loops(&out.body)[0] else { unreachable!() };
+        let Stmt::Assign { value: Expr::BinaryOp { right, .. }, .. } = &body[2] else { panic!() };
+        let Expr::BinaryOp { left, .. } = right.as_ref() else { panic!() };
+        assert!(matches!(left.as_ref(), Expr::BinaryOp { op: BinOp::Add, right, .. } if matches!(right.as_ref(), Expr::Number(2))));
+    }
+
+    #[test]
+    fn test_loops_left_alone() {
+        let ptr = Type::Pointer(Box::new(Type::I64));
+        let store = |value: Expr| Stmt::IndexAssign { object: var("a"), index: var("i"), value };
+        let cases = vec![
+            // Forma del vectorizador: a[i] = a[i] + 1
+            vec![store(add(index("a", var("i")), 1)), inc("i")],
+            // El cuerpo escribe el bound
+            vec![store(Expr::Number(0)), Stmt::Assign { name: "n".to_string(), value: Expr::Number(1) }, inc("i")],
+            // break
+            vec![store(Expr::Number(0)), Stmt::Break, inc("i")],
+            // Bucle anidado dentro
+            vec![Stmt::While { condition: Expr::Bool(false), body: vec![] }, inc("i")],
+        ];
+        for body in cases {
+            let func = function(
+                vec![("a", ptr.clone()), ("n", Type::I64)],
+                vec![int("i"), Stmt::While { condition: lt("i", var("n")), body }],
+            );
+            assert!(optimize_function(&func).is_none());
+        }
+
+        // &i escapa: no se toca
+        let func = function(
+            vec![("a", ptr.clone()), ("n", Type::I64)],
+            vec![
+                int("i"),
+                Stmt::Expr(Expr::Call { name: "g".to_string(), args: vec![Expr::AddressOf(Box::new(var("i")))] }),
+                Stmt::While { condition: lt("i", var("n")), body: vec![accumulate("a"), inc("i")] },
+            ],
+        );
+        assert!(optimize_function(&func).is_none());
+    }
+}
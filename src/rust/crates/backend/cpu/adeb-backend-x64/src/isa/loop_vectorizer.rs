@@ -0,0 +1,879 @@
+// ============================================================
+// ADead-BIB — Loop Vectorizer (AVX2)
+// ============================================================
+// Reconoce bucles contables sobre arrays y punteros y genera el
+// cuerpo vectorial con VEX (vex_emitter.rs). El SoA optimizer
+// solo cubre arrays de tamaño fijo; esto cubre el caso general:
+//
+//   for (i = 0; i < n; i++) c[i] = a[i] * k + b[i + 1];
+//
+// Forma aceptada:
+//   - condición  i < n | i <= n | n > i | n >= i  (n constante o escalar)
+//   - update     i++ | ++i | i += 1 | i = i + 1
+//   - cuerpo     solo `arr[i] = expr`, expr de + - * & | ^ sobre
+//                `arr[i ± k]`, constantes y escalares enteros
+//   - en float/double además /, y sin cos exp log pow sqrt tanh
+//     (y sus versiones `f`) vía las rutinas de vec_math.rs
+//
+// El isa_compiler emite el bucle principal (LANES elementos por
+// vuelta) y deja detrás el bucle escalar original como resto.
+// Punteros que podrían solaparse se comprueban en runtime.
+//
+// Si alguna base tiene alineación probada de 32 bytes (arrays
+// globales, colocados según el BitTarget) se genera además un
+// cuerpo con vmovdqa para los accesos `arr[i + k]` con k múltiplo
+// de LANES; el isa_compiler lo usa cuando i % LANES == 0 al entrar.
+//
+// Convención fija de registros dentro del bucle vectorial:
+//   i = RCX, n = RDX, bases = R8..R11, ymm0..ymm5 (volátiles en Win64)
+//
+// Una llamada matemática guarda los ymm vivos en [rsp + 32·k]
+// (SPILL_BYTES reservados por el isa_compiler), pasa los argumentos
+// en ymm0/ymm1 y recoge el resultado de ymm0. Las rutinas no tocan
+// RCX/RDX/R8..R11.
+//
+// Cada decisión (vectorizado o no, y por qué) queda en un
+// LoopReport usando SoaSkipReason.
+// ============================================================
+
+use super::bit_resolver::SoaElementType;
+use super::soa_optimizer::SoaSkipReason;
+use super::vec_math::MathFn;
+use super::vex_emitter::{AvxInst, FpOp, VexMem};
+use super::ymm_allocator::YmmReg;
+use super::Reg;
+use crate::frontend::ast::*;
+
+/// GP register encoding holding the induction variable
+pub const REG_I: u8 = 1; // RCX
+/// GP register encoding holding the (exclusive) bound
+pub const REG_N: u8 = 2; // RDX
+/// GP register encodings holding the array bases, in array order
+pub const BASE_REGS: [u8; 4] = [8, 9, 10, 11]; // R8..R11
+/// The same registers as `BASE_REGS`, for the GP-side emission
+pub const BASE_GPRS: [Reg; 4] = [Reg::R8, Reg::R9, Reg::R10, Reg::R11];
+
+/// ymm0..ymm5: the registers Win64 does not require us to preserve
+const MAX_YMM: u8 = 6;
+
+/// Stack area the loop reserves for ymm spills around math calls
+pub const SPILL_BYTES: i32 = 32 * MAX_YMM as i32;
+
+/// Base alignment that makes a ymm access at a multiple of LANES aligned
+pub const YMM_ALIGN: u64 = 32;
+
+// ============================================================
+// Vector IR
+// ============================================================
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum VecBinOp {
+    Add,
+    Sub,
+    Mul,
+    /// Float loops only
+    Div,
+    And,
+    Or,
+    Xor,
+}
+
+#[derive(Debug, Clone, PartialEq)]
+pub enum VecExpr {
+    /// `arrays[array][i + offset]`
+    Load { array: usize, offset: i64 },
+    /// `invariants[k]` broadcast to every lane
+    Splat(usize),
+    Bin(VecBinOp, Box<VecExpr>, Box<VecExpr>),
+    /// Vector math routine at the loop's precision (float loops only)
+    Call(MathFn, Vec<VecExpr>),
+}
+
+/// One step of the lowered body: straight AVX2 code or a call into
+/// the vector math runtime (ymm0[, ymm1] → ymm0)
+#[derive(Debug, Clone)]
+pub enum VecStep {
+    Avx(AvxInst),
+    Call { func: MathFn, double: bool },
+}
+
+impl std::fmt::Display for VecStep {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            VecStep::Avx(inst) => write!(f, "{}", inst),
+            VecStep::Call { func, double } => write!(f, "call {}", func.vector_name(*double)),
+        }
+    }
+}
+
+/// An array or pointer touched by the loop
+#[derive(Debug, Clone)]
+pub struct VecArray {
+    pub name: String,
+    /// Local array (its storage cannot overlap another local array)
+    pub is_local: bool,
+    /// Proven alignment of the base address (1 = unknown)
+    pub align: u64,
+    pub written: bool,
+    pub min_offset: i64,
+    pub max_offset: i64,
+}
+
+/// A loop accepted for vectorization
+#[derive(Debug, Clone)]
+pub struct VecLoop {
+    pub var: String,
+    pub bound: Expr,
+    /// `i <= n`: the exclusive bound is n + 1
+    pub inclusive: bool,
+    pub elem: SoaElementType,
+    pub arrays: Vec<VecArray>,
+    /// Loop-invariant scalars, splat into ymm0.. before the loop
+    pub invariants: Vec<Expr>,
+    /// `arrays[k][i] = expr`, in source order
+    pub stores: Vec<(usize, VecExpr)>,
+    /// Lowered main-loop body (one vector of LANES elements)
+    pub body: Vec<VecStep>,
+    /// The same body with aligned moves where the base alignment proves
+    /// them, valid while i % LANES == 0. None if no access qualifies.
+    pub aligned_body: Option<Vec<VecStep>>,
+}
+
+impl VecLoop {
+    pub fn lanes(&self) -> usize {
+        self.elem.lanes_per_ymm()
+    }
+
+    pub fn elem_size(&self) -> usize {
+        self.elem.size_bytes()
+    }
+
+    /// The body calls the math runtime: the loop needs SPILL_BYTES of stack
+    pub fn has_calls(&self) -> bool {
+        self.body.iter().any(|step| matches!(step, VecStep::Call { .. }))
+    }
+
+    /// (written, other) pairs whose storage may overlap and needs a
+    /// runtime check. Distinct local arrays never overlap.
+    pub fn alias_pairs(&self) -> Vec<(usize, usize)> {
+        let mut pairs = Vec::new();
+        for (w, wa) in self.arrays.iter().enumerate() {
+            if !wa.written {
+                continue;
+            }
+            for (x, xa) in self.arrays.iter().enumerate() {
+                if x == w || (xa.written && x < w) || (wa.is_local && xa.is_local) {
+                    continue;
+                }
+                pairs.push((w, x));
+            }
+        }
+        pairs
+    }
+}
+
+/// What the compiler knows about a name used in the loop
+#[derive(Debug, Clone, Copy)]
+pub struct ArrayInfo {
+    /// None: element type with no lane form (struct, nested array...)
+    pub elem: Option<SoaElementType>,
+    /// Named array object: distinct from every other named array
+    pub is_local: bool,
+    /// Proven alignment of the base address (1 = unknown)
+    pub align: u64,
+}
+
+/// Queries the vectorizer needs from the compiler's symbol state
+pub trait LoopContext {
+    /// Some if `name` is a local array or a pointer local/param
+    fn array_info(&self, name: &str) -> Option<ArrayInfo>;
+    /// true if `name` is an integer scalar local/param
+    fn is_int_scalar(&self, name: &str) -> bool;
+    /// true if `name` is a double scalar local/param
+    fn is_float_scalar(&self, name: &str) -> bool;
+    /// true if a call to `name` can go to the vector math runtime
+    /// (the runtime is emitted and `name` is not a user function)
+    fn has_vector_math(&self, name: &str) -> bool;
+}
+
+/// Lane type of an array/pointer element
+pub fn elem_of(ty: &Type) -> Option<SoaElementType> {
+    match ty {
+        Type::I8 | Type::U8 => Some(SoaElementType::Int8),
+        Type::I16 | Type::U16 => Some(SoaElementType::Int16),
+        Type::I32 | Type::U32 => Some(SoaElementType::Int32),
+        Type::I64 | Type::U64 => Some(SoaElementType::Int64),
+        Type::F32 => Some(SoaElementType::Float32),
+        Type::F64 => Some(SoaElementType::Float64),
+        _ => None,
+    }
+}
+
+fn is_float(elem: SoaElementType) -> bool {
+    matches!(elem, SoaElementType::Float32 | SoaElementType::Float64)
+}
+
+/// Lane bits of a numeric literal invariant in a float loop
+/// (None: not a literal, or an integer loop)
+pub fn literal_bits(elem: SoaElementType, e: &Expr) -> Option<u64> {
+    let v = match e {
+        Expr::Number(n) => *n as f64,
+        Expr::Float(v) => *v,
+        _ => return None,
+    };
+    match elem {
+        SoaElementType::Float32 => Some((v as f32).to_bits() as u64),
+        SoaElementType::Float64 => Some(v.to_bits()),
+        _ => None,
+    }
+}
+
+// ============================================================
+// Diagnostics
+// ============================================================
+
+/// One vectorization decision, kept for `--step` / reports
+#[derive(Debug, Clone)]
+pub struct LoopReport {
+    pub function: String,
+    pub var: String,
+    pub line: usize,
+    pub elem: Option<SoaElementType>,
+    pub lanes: usize,
+    pub alias_check: bool,
+    pub skipped: Option<SoaSkipReason>,
+}
+
+impl std::fmt::Display for LoopReport {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        let var = if self.var.is_empty() { "?" } else { &self.var };
+        write!(f, "{}:{} loop `{}`: ", self.function, self.line, var)?;
+        match (self.skipped, self.elem) {
+            (Some(reason), _) => write!(f, "not vectorized ({})", reason),
+            (None, Some(elem)) => {
+                write!(f, "vectorized {} x {:?}", self.lanes, elem)?;
+                if self.alias_check {
+                    write!(f, ", runtime alias check")?;
+                }
+                Ok(())
+            }
+            (None, None) => write!(f, "vectorized"),
+        }
+    }
+}
+
+/// First line marker in the body, for reports
+pub fn body_line(body: &[Stmt]) -> usize {
+    body.iter()
+        .find_map(|s| match s {
+            Stmt::LineMarker(n) => Some(*n),
+            _ => None,
+        })
+        .unwrap_or(0)
+}
+
+// ============================================================
+// Analysis
+// ============================================================
+
+/// Name of the induction variable if `stmt` is `i++` / `i += 1` / `i = i + 1`
+fn unit_increment(stmt: &Stmt) -> Option<&str> {
+    match stmt {
+        Stmt::Increment { name, is_increment: true, .. } => Some(name),
+        Stmt::CompoundAssign { name, op: CompoundOp::AddAssign, value: Expr::Number(1) } => Some(name),
+        Stmt::Assign { name, value: Expr::BinaryOp { op: BinOp::Add, left, right } } => {
+            match (left.as_ref(), right.as_ref()) {
+                (Expr::Variable(v), Expr::Number(1)) | (Expr::Number(1), Expr::Variable(v)) if v == name => {
+                    Some(name)
+                }
+                _ => None,
+            }
+        }
+        _ => None,
+    }
+}
+
+/// Induction variable of a `for`-shaped while body (its trailing update)
+pub fn induction_var(body: &[Stmt]) -> Option<&str> {
+    body.last().and_then(unit_increment)
+}
+
+/// (bound, inclusive) if `cond` compares `var` against an invariant bound
+pub fn loop_bound<'a>(cond: &'a Expr, var: &str) -> Option<(&'a Expr, bool)> {
+    let is_var = |e: &Expr| matches!(e, Expr::Variable(v) if v == var);
+    match cond {
+        Expr::Comparison { op, left, right } => match op {
+            CmpOp::Lt if is_var(left) => Some((right.as_ref(), false)),
+            CmpOp::Le if is_var(left) => Some((right.as_ref(), true)),
+            CmpOp::Gt if is_var(right) => Some((left.as_ref(), false)),
+            CmpOp::Ge if is_var(right) => Some((left.as_ref(), true)),
+            _ => None,
+        },
+        _ => None,
+    }
+}
+
+struct Analyzer<'a, C: LoopContext> {
+    ctx: &'a C,
+    var: &'a str,
+    elem: Option<SoaElementType>,
+    arrays: Vec<VecArray>,
+    invariants: Vec<Expr>,
+    /// Precision (double?) of each math call, checked against the loop's
+    calls: Vec<bool>,
+}
+
+impl<'a, C: LoopContext> Analyzer<'a, C> {
+    /// Index of `name` in `arrays`, registering it on first use
+    fn array(&mut self, name: &str) -> Result<usize, SoaSkipReason> {
+        if let Some(k) = self.arrays.iter().position(|a| a.name == name) {
+            return Ok(k);
+        }
+        let info = self.ctx.array_info(name).ok_or(SoaSkipReason::UnsupportedType)?;
+        let elem = info.elem.ok_or(SoaSkipReason::UnsupportedType)?;
+        match self.elem {
+            Some(e) if is_float(e) != is_float(elem) => return Err(SoaSkipReason::MixedElementKind),
+            Some(e) if e.size_bytes() != elem.size_bytes() => return Err(SoaSkipReason::MixedElementSize),
+            Some(_) => {}
+            None => self.elem = Some(elem),
+        }
+        if self.arrays.len() == BASE_REGS.len() {
+            return Err(SoaSkipReason::RegistersExhausted);
+        }
+        self.arrays.push(VecArray {
+            name: name.to_string(),
+            is_local: info.is_local,
+            align: info.align,
+            written: false,
+            min_offset: 0,
+            max_offset: 0,
+        });
+        Ok(self.arrays.len() - 1)
+    }
+
+    /// Offset k if `index` is `i`, `i + k`, `k + i` or `i - k`
+    fn offset(&self, index: &Expr) -> Result<i64, SoaSkipReason> {
+        let is_var = |e: &Expr| matches!(e, Expr::Variable(v) if v == self.var);
+        match index {
+            e if is_var(e) => Ok(0),
+            Expr::BinaryOp { op: BinOp::Add, left, right } => match (left.as_ref(), right.as_ref()) {
+                (l, Expr::Number(k)) if is_var(l) => Ok(*k),
+                (Expr::Number(k), r) if is_var(r) => Ok(*k),
+                _ => Err(SoaSkipReason::NonSequential),
+            },
+            Expr::BinaryOp { op: BinOp::Sub, left, right } => match (left.as_ref(), right.as_ref()) {
+                (l, Expr::Number(k)) if is_var(l) => Ok(-*k),
+                _ => Err(SoaSkipReason::NonSequential),
+            },
+            _ => Err(SoaSkipReason::NonSequential),
+        }
+    }
+
+    fn splat(&mut self, e: &Expr) -> VecExpr {
+        let same = |a: &Expr| match (a, e) {
+            (Expr::Number(x), Expr::Number(y)) => x == y,
+            (Expr::Float(x), Expr::Float(y)) => x.to_bits() == y.to_bits(),
+            (Expr::Variable(x), Expr::Variable(y)) => x == y,
+            _ => false,
+        };
+        match self.invariants.iter().position(same) {
+            Some(k) => VecExpr::Splat(k),
+            None => {
+                self.invariants.push(e.clone());
+                VecExpr::Splat(self.invariants.len() - 1)
+            }
+        }
+    }
+
+    fn expr(&mut self, e: &Expr) -> Result<VecExpr, SoaSkipReason> {
+        let (op, left, right) = match e {
+            Expr::Number(_) | Expr::Float(_) => return Ok(self.splat(e)),
+            Expr::Variable(v) if v == self.var => return Err(SoaSkipReason::UnsupportedOp),
+            Expr::Variable(v) if self.ctx.is_int_scalar(v) || self.ctx.is_float_scalar(v) => {
+                return Ok(self.splat(e))
+            }
+            Expr::Call { name, args } => {
+                let (f, double) = MathFn::from_name(name)
+                    .filter(|(f, _)| f.arity() == args.len() && self.ctx.has_vector_math(name))
+                    .ok_or(SoaSkipReason::UnsupportedOp)?;
+                let args = args.iter().map(|a| self.expr(a)).collect::<Result<Vec<_>, _>>()?;
+                self.calls.push(double);
+                return Ok(VecExpr::Call(f, args));
+            }
+            Expr::Index { object, index } => {
+                let name = match object.as_ref() {
+                    Expr::Variable(name) => name,
+                    _ => return Err(SoaSkipReason::UnsupportedType),
+                };
+                let offset = self.offset(index)?;
+                let array = self.array(name)?;
+                let a = &mut self.arrays[array];
+                a.min_offset = a.min_offset.min(offset);
+                a.max_offset = a.max_offset.max(offset);
+                return Ok(VecExpr::Load { array, offset });
+            }
+            Expr::BinaryOp { op, left, right } => {
+                let op = match op {
+                    BinOp::Add => VecBinOp::Add,
+                    BinOp::Sub => VecBinOp::Sub,
+                    BinOp::Mul => VecBinOp::Mul,
+                    BinOp::Div => VecBinOp::Div,
+                    _ => return Err(SoaSkipReason::UnsupportedOp),
+                };
+                (op, left, right)
+            }
+            Expr::BitwiseOp { op, left, right } => {
+                let op = match op {
+                    BitwiseOp::And => VecBinOp::And,
+                    BitwiseOp::Or => VecBinOp::Or,
+                    BitwiseOp::Xor => VecBinOp::Xor,
+                    _ => return Err(SoaSkipReason::UnsupportedOp),
+                };
+                (op, left, right)
+            }
+            _ => return Err(SoaSkipReason::UnsupportedOp),
+        };
+        let l = self.expr(left)?;
+        let r = self.expr(right)?;
+        Ok(VecExpr::Bin(op, Box::new(l), Box::new(r)))
+    }
+
+    /// Invariants and calls must match the lane kind: no int ↔ float
+    /// conversion happens in the vector body
+    fn check_kinds(&self, elem: SoaElementType) -> Result<(), SoaSkipReason> {
+        let double = elem == SoaElementType::Float64;
+        let ok_invariant = |e: &Expr| match e {
+            Expr::Number(_) => true,
+            Expr::Float(_) => is_float(elem),
+            Expr::Variable(v) if self.ctx.is_int_scalar(v) => !is_float(elem),
+            // los escalares float del compilador son doubles
+            _ => double,
+        };
+        if !self.invariants.iter().all(ok_invariant) || self.calls.iter().any(|&d| !is_float(elem) || d != double) {
+            return Err(SoaSkipReason::MixedElementKind);
+        }
+        Ok(())
+    }
+}
+
+/// Decide whether `while (condition) { body }` can be vectorized.
+/// On success the returned loop carries its lowered AVX2 body.
+pub fn analyze<C: LoopContext>(condition: &Expr, body: &[Stmt], ctx: &C) -> Result<VecLoop, SoaSkipReason> {
+    let (update, stmts) = body.split_last().ok_or(SoaSkipReason::NotCountable)?;
+    let var = unit_increment(update).ok_or(SoaSkipReason::NotCountable)?;
+    let (bound, inclusive) = loop_bound(condition, var).ok_or(SoaSkipReason::NotCountable)?;
+    if !ctx.is_int_scalar(var) {
+        return Err(SoaSkipReason::NotCountable);
+    }
+    match bound {
+        Expr::Number(_) => {}
+        Expr::Variable(n) if n != var && ctx.is_int_scalar(n) => {}
+        _ => return Err(SoaSkipReason::NotCountable),
+    }
+
+    let mut an = Analyzer { ctx, var, elem: None, arrays: Vec::new(), invariants: Vec::new(), calls: Vec::new() };
+    let mut stores = Vec::new();
+    for stmt in stmts {
+        match stmt {
+            Stmt::LineMarker(_) => {}
+            Stmt::IndexAssign { object: Expr::Variable(name), index, value } => {
+                if an.offset(index)? != 0 {
+                    return Err(SoaSkipReason::NonSequential);
+                }
+                let value = an.expr(value)?;
+                let array = an.array(name)?;
+                an.arrays[array].written = true;
+                stores.push((array, value));
+            }
+            _ => return Err(SoaSkipReason::UnsupportedStatement),
+        }
+    }
+    if stores.is_empty() {
+        return Err(SoaSkipReason::UnsupportedStatement);
+    }
+    // Leer un array escrito en otro índice cruza iteraciones
+    if an.arrays.iter().any(|a| a.written && (a.min_offset != 0 || a.max_offset != 0)) {
+        return Err(SoaSkipReason::LoopCarriedDependence);
+    }
+    let elem = an.elem.ok_or(SoaSkipReason::UnsupportedType)?;
+    an.check_kinds(elem)?;
+    if let Expr::Number(n) = bound {
+        if (*n + inclusive as i64) < elem.lanes_per_ymm() as i64 {
+            return Err(SoaSkipReason::TripCountTooSmall);
+        }
+    }
+
+    let mut lp = VecLoop {
+        var: var.to_string(),
+        bound: bound.clone(),
+        inclusive,
+        elem,
+        arrays: an.arrays,
+        invariants: an.invariants,
+        stores,
+        body: Vec::new(),
+        aligned_body: None,
+    };
+    lp.body = lower(&lp, false)?;
+    if lp.arrays.iter().any(|a| a.align >= YMM_ALIGN) {
+        let aligned = lower(&lp, true)?;
+        let is_aligned_move =
+            |step: &VecStep| matches!(step, VecStep::Avx(AvxInst::VmovdqaLoad { .. } | AvxInst::VmovdqaStore { .. }));
+        if aligned.iter().any(is_aligned_move) {
+            lp.aligned_body = Some(aligned);
+        }
+    }
+    Ok(lp)
+}
+
+// ============================================================
+// Lowering → VecStep
+// ============================================================
+
+struct Lowering<'a> {
+    lp: &'a VecLoop,
+    /// Assume i % LANES == 0 (aligned variant of the body)
+    aligned: bool,
+    free: Vec<u8>,
+    out: Vec<VecStep>,
+}
+
+impl<'a> Lowering<'a> {
+    fn avx(&mut self, inst: AvxInst) {
+        self.out.push(VecStep::Avx(inst));
+    }
+
+    fn double(&self) -> bool {
+        self.lp.elem == SoaElementType::Float64
+    }
+
+    fn alloc(&mut self) -> Result<YmmReg, SoaSkipReason> {
+        self.free.pop().map(YmmReg).ok_or(SoaSkipReason::RegistersExhausted)
+    }
+
+    fn release(&mut self, reg: YmmReg, owned: bool) {
+        if owned {
+            self.free.push(reg.0);
+        }
+    }
+
+    fn mem(&self, array: usize, offset: i64) -> VexMem {
+        let size = self.lp.elem_size();
+        VexMem::indexed(BASE_REGS[array], REG_I, size as u8, (offset * size as i64) as i32)
+    }
+
+    /// `arrays[array][i + offset]` lands on a 32-byte boundary
+    fn is_aligned(&self, array: usize, offset: i64) -> bool {
+        self.aligned
+            && self.lp.arrays[array].align >= YMM_ALIGN
+            && offset.rem_euclid(self.lp.lanes() as i64) == 0
+    }
+
+    /// Evaluate into a register; `owned` is false for the shared splats
+    fn eval(&mut self, e: &VecExpr) -> Result<(YmmReg, bool), SoaSkipReason> {
+        match e {
+            VecExpr::Splat(k) => Ok((YmmReg(*k as u8), false)),
+            VecExpr::Load { array, offset } => {
+                let dst = self.alloc()?;
+                let mem = self.mem(*array, *offset);
+                self.avx(if self.is_aligned(*array, *offset) {
+                    AvxInst::VmovdqaLoad { dst, mem }
+                } else {
+                    AvxInst::VmovdquLoad { dst, mem }
+                });
+                Ok((dst, true))
+            }
+            VecExpr::Call(MathFn::Sqrt, args) => {
+                let (src, owned) = self.eval(&args[0])?;
+                let dst = if owned { src } else { self.alloc()? };
+                let double = self.double();
+                self.avx(AvxInst::Vsqrt { double, dst, src });
+                Ok((dst, true))
+            }
+            VecExpr::Call(func, args) => self.call(*func, args),
+            VecExpr::Bin(op, l, r) => {
+                let (a, a_owned) = self.eval(l)?;
+                let (b, b_owned) = self.eval(r)?;
+                let (dst, spare) = match (a_owned, b_owned) {
+                    (true, _) => (a, Some((b, b_owned))),
+                    (false, true) => (b, None),
+                    (false, false) => (self.alloc()?, None),
+                };
+                let lane = self.lp.elem_size() as u8;
+                let (src1, src2) = (a, b);
+                let inst = if is_float(self.lp.elem) {
+                    let op = match op {
+                        VecBinOp::Add => FpOp::Add,
+                        VecBinOp::Sub => FpOp::Sub,
+                        VecBinOp::Mul => FpOp::Mul,
+                        VecBinOp::Div => FpOp::Div,
+                        _ => return Err(SoaSkipReason::UnsupportedOp),
+                    };
+                    AvxInst::Vfp { op, double: self.double(), dst, src1, src2 }
+                } else {
+                    match op {
+                        VecBinOp::Add => AvxInst::Vpadd { lane, dst, src1, src2 },
+                        VecBinOp::Sub => AvxInst::Vpsub { lane, dst, src1, src2 },
+                        VecBinOp::Mul if lane == 2 || lane == 4 => AvxInst::Vpmull { lane, dst, src1, src2 },
+                        VecBinOp::Mul | VecBinOp::Div => return Err(SoaSkipReason::UnsupportedOp),
+                        VecBinOp::And => AvxInst::Vpand { dst, src1, src2 },
+                        VecBinOp::Or => AvxInst::Vpor { dst, src1, src2 },
+                        VecBinOp::Xor => AvxInst::Vpxor { dst, src1, src2 },
+                    }
+                };
+                self.avx(inst);
+                if let Some((reg, owned)) = spare {
+                    self.release(reg, owned);
+                }
+                Ok((dst, true))
+            }
+        }
+    }
+
+    /// Routine call: the live ymm (splats and pending temporaries) go to
+    /// the spill area, arguments to ymm0/ymm1, the result comes in ymm0
+    fn call(&mut self, func: MathFn, args: &[VecExpr]) -> Result<(YmmReg, bool), SoaSkipReason> {
+        let mut vals = Vec::new();
+        for arg in args {
+            vals.push(self.eval(arg)?);
+        }
+        let live: Vec<u8> = (0..MAX_YMM)
+            .filter(|r| !self.free.contains(r) && !vals.iter().any(|&(v, owned)| owned && v.0 == *r))
+            .collect();
+        for &r in &live {
+            self.avx(AvxInst::VmovdquStore { src: YmmReg(r), mem: VexMem::base(4, 32 * r as i32) });
+        }
+        let mov = |dst: u8, src: YmmReg| (src.0 != dst).then(|| AvxInst::VmovapsReg { dst: YmmReg(dst), src });
+        let moves = match vals[..] {
+            [(a, _)] => vec![mov(0, a)],
+            // ymm1 ← ymm0 y ymm0 ← ymm1 a la vez: ymm2 de intermedio (la rutina lo pisa igual)
+            [(a, _), (b, _)] if a.0 == 1 && b.0 == 0 => vec![mov(2, a), mov(1, b), mov(0, YmmReg(2))],
+            [(a, _), (b, _)] if b.0 == 0 => vec![mov(1, b), mov(0, a)],
+            [(a, _), (b, _)] => vec![mov(0, a), mov(1, b)],
+            _ => return Err(SoaSkipReason::UnsupportedOp),
+        };
+        for inst in moves.into_iter().flatten() {
+            self.avx(inst);
+        }
+        for (reg, owned) in vals {
+            self.release(reg, owned);
+        }
+        let double = self.double();
+        self.out.push(VecStep::Call { func, double });
+        let dst = self.alloc()?;
+        if dst.0 != 0 {
+            self.avx(AvxInst::VmovapsReg { dst, src: YmmReg(0) });
+        }
+        for &r in &live {
+            self.avx(AvxInst::VmovdquLoad { dst: YmmReg(r), mem: VexMem::base(4, 32 * r as i32) });
+        }
+        Ok((dst, true))
+    }
+}
+
+/// Lower the stores of `lp` to one vector iteration.
+/// Invariant k lives in ymm k; temporaries use the rest of ymm0..5.
+fn lower(lp: &VecLoop, aligned: bool) -> Result<Vec<VecStep>, SoaSkipReason> {
+    let first_free = lp.invariants.len() as u8;
+    if first_free >= MAX_YMM {
+        return Err(SoaSkipReason::RegistersExhausted);
+    }
+    let mut lw = Lowering {
+        lp,
+        aligned,
+        free: (first_free..MAX_YMM).rev().collect(),
+        out: Vec::new(),
+    };
+    for (array, value) in &lp.stores {
+        let (reg, owned) = lw.eval(value)?;
+        let mem = lw.mem(*array, 0);
+        lw.avx(if lw.is_aligned(*array, 0) {
+            AvxInst::VmovdqaStore { src: reg, mem }
+        } else {
+            AvxInst::VmovdquStore { src: reg, mem }
+        });
+        lw.release(reg, owned);
+    }
+    Ok(lw.out)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::collections::HashMap;
+
+    struct Ctx {
+        arrays: HashMap<&'static str, ArrayInfo>,
+        scalars: Vec<&'static str>,
+    }
+
+    impl LoopContext for Ctx {
+        fn array_info(&self, name: &str) -> Option<ArrayInfo> {
+            self.arrays.get(name).copied()
+        }
+        fn is_int_scalar(&self, name: &str) -> bool {
+            self.scalars.contains(&name)
+        }
+        fn is_float_scalar(&self, name: &str) -> bool {
+            name == "s"
+        }
+        fn has_vector_math(&self, name: &str) -> bool {
+            name != "tanhf"
+        }
+    }
+
+    fn ctx() -> Ctx {
+        let ptr = |e| ArrayInfo { elem: Some(e), is_local: false, align: 1 };
+        let mut arrays = HashMap::new();
+        arrays.insert("a", ptr(SoaElementType::Int32));
+        arrays.insert("b", ptr(SoaElementType::Int32));
+        arrays.insert("c", ptr(SoaElementType::Int32));
+        arrays.insert("q", ptr(SoaElementType::Int64));
+        arrays.insert("f", ArrayInfo { elem: None, is_local: false, align: 1 });
+        arrays.insert("x", ArrayInfo { elem: Some(SoaElementType::Int32), is_local: true, align: 1 });
+        arrays.insert("y", ArrayInfo { elem: Some(SoaElementType::Int32), is_local: true, align: 1 });
+        // Arrays globales alineados a 32
+        arrays.insert("g", ArrayInfo { elem: Some(SoaElementType::Int32), is_local: true, align: 32 });
+        arrays.insert("h", ArrayInfo { elem: Some(SoaElementType::Int32), is_local: true, align: 64 });
+        arrays.insert("u", ptr(SoaElementType::Float32));
+        arrays.insert("v", ptr(SoaElementType::Float32));
+        arrays.insert("w", ptr(SoaElementType::Float64));
+        Ctx { arrays, scalars: vec!["i", "n", "k"] }
+    }
+
+    fn var(s: &str) -> Expr {
+        Expr::Variable(s.to_string())
+    }
+    fn idx(a: &str, i: Expr) -> Expr {
+        Expr::Index { object: Box::new(var(a)), index: Box::new(i) }
+    }
+    fn bin(op: BinOp, l: Expr, r: Expr) -> Expr {
+        Expr::BinaryOp { op, left: Box::new(l), right: Box::new(r) }
+    }
+    fn call(name: &str, args: Vec<Expr>) -> Expr {
+        Expr::Call { name: name.to_string(), args }
+    }
+    fn lt_n() -> Expr {
+        Expr::Comparison { op: CmpOp::Lt, left: Box::new(var("i")), right: Box::new(var("n")) }
+    }
+    fn store(a: &str, value: Expr) -> Stmt {
+        Stmt::IndexAssign { object: var(a), index: var("i"), value }
+    }
+    fn inc() -> Stmt {
+        Stmt::Increment { name: "i".to_string(), is_pre: false, is_increment: true }
+    }
+
+    #[test]
+    fn test_vectorizes_pointer_loop() {
+        // c[i] = a[i] * k + b[i + 1]
+        let value = bin(BinOp::Add, bin(BinOp::Mul, idx("a", var("i")), var("k")), idx("b", bin(BinOp::Add, var("i"), Expr::Number(1))));
+        let body = vec![Stmt::LineMarker(7), store("c", value), inc()];
+        let lp = analyze(&lt_n(), &body, &ctx()).unwrap();
+        assert_eq!(lp.lanes(), 8);
+        assert_eq!(lp.invariants.len(), 1);
+        assert_eq!(lp.arrays.len(), 3);
+        assert_eq!(lp.arrays[1].max_offset, 1);
+        // c se compara contra a y b
+        assert_eq!(lp.alias_pairs(), vec![(2, 0), (2, 1)]);
+        let text: Vec<String> = lp.body.iter().map(|i| i.to_string()).collect();
+        assert_eq!(text.len(), 5, "{:?}", text);
+        assert!(text[1].starts_with("vpmulld"));
+        assert!(text[4].starts_with("vmovdqu [gp10+gp1*4+0]"));
+        assert_eq!(body_line(&body), 7);
+    }
+
+    #[test]
+    fn test_local_arrays_need_no_alias_check() {
+        let body = vec![store("x", bin(BinOp::Sub, idx("y", var("i")), Expr::Number(3))), inc()];
+        let lp = analyze(&lt_n(), &body, &ctx()).unwrap();
+        assert!(lp.alias_pairs().is_empty());
+    }
+
+    #[test]
+    fn test_aligned_body_only_for_proven_accesses() {
+        // g[i] = h[i + 8] + h[i + 1] + a[i]
+        let value = bin(
+            BinOp::Add,
+            bin(BinOp::Add, idx("h", bin(BinOp::Add, var("i"), Expr::Number(8))), idx("h", bin(BinOp::Add, var("i"), Expr::Number(1)))),
+            idx("a", var("i")),
+        );
+        let body = vec![store("g", value), inc()];
+        let lp = analyze(&lt_n(), &body, &ctx()).unwrap();
+        assert!(lp.body.iter().all(|i| !i.to_string().starts_with("vmovdqa")));
+        let text: Vec<String> = lp.aligned_body.unwrap().iter().map(|i| i.to_string()).collect();
+        assert!(text[0].starts_with("vmovdqa ymm"), "{:?}", text);
+        assert!(text[1].starts_with("vmovdqu ymm"), "{:?}", text);
+        assert!(text[3].starts_with("vmovdqu ymm"), "{:?}", text);
+        assert!(text.last().unwrap().starts_with("vmovdqa [gp10+"), "{:?}", text);
+
+        // Sin ninguna base alineada no hay variante
+        let body = vec![store("x", idx("y", var("i"))), inc()];
+        assert!(analyze(&lt_n(), &body, &ctx()).unwrap().aligned_body.is_none());
+    }
+
+    #[test]
+    fn test_float_loop_calls_vector_math() {
+        // u[i] = sinf(v[i]) * 2.0 + v[i]
+        let value = bin(BinOp::Add, bin(BinOp::Mul, call("sinf", vec![idx("v", var("i"))]), Expr::Float(2.0)), idx("v", var("i")));
+        let body = vec![store("u", value), inc()];
+        let lp = analyze(&lt_n(), &body, &ctx()).unwrap();
+        assert_eq!((lp.elem, lp.lanes()), (SoaElementType::Float32, 8));
+        assert!(lp.has_calls());
+        assert_eq!(literal_bits(lp.elem, &lp.invariants[0]), Some(2.0f32.to_bits() as u64));
+        let text: Vec<String> = lp.body.iter().map(|i| i.to_string()).collect();
+        // El splat de 2.0 (ymm0) se guarda alrededor de la llamada
+        let call_at = text.iter().position(|t| t == "call _ZGVdN8v_sinf").unwrap();
+        assert!(text[..call_at].iter().any(|t| t.starts_with("vmovdqu [gp4+0], ymm0")), "{:?}", text);
+        assert!(text[call_at + 1..].iter().any(|t| t.starts_with("vmovdqu ymm0, [gp4+0]")), "{:?}", text);
+        assert!(text.iter().any(|t| t.starts_with("vmulps")), "{:?}", text);
+
+        // w[i] = pow(s, w[i]) / sqrt(w[i]): s ya está en ymm0 y w[i] en ymm1
+        let value = bin(BinOp::Div, call("pow", vec![var("s"), idx("w", var("i"))]), call("sqrt", vec![idx("w", var("i"))]));
+        let body = vec![store("w", value), inc()];
+        let lp = analyze(&lt_n(), &body, &ctx()).unwrap();
+        let text: Vec<String> = lp.body.iter().map(|i| i.to_string()).collect();
+        let call_at = text.iter().position(|t| t == "call _ZGVdN4vv_pow").unwrap();
+        assert!(text[..call_at].iter().all(|t| !t.starts_with("vmovaps")), "{:?}", text);
+        assert!(text.iter().any(|t| t.starts_with("vsqrtpd")) && text.iter().any(|t| t.starts_with("vdivpd")), "{:?}", text);
+    }
+
+    #[test]
+    fn test_skip_reasons() {
+        let c = ctx();
+        let cases: Vec<(Vec<Stmt>, SoaSkipReason)> = vec![
+            // a[i] = a[i - 1] + 1
+            (vec![store("a", bin(BinOp::Add, idx("a", bin(BinOp::Sub, var("i"), Expr::Number(1))), Expr::Number(1))), inc()], SoaSkipReason::LoopCarriedDependence),
+            (vec![store("a", idx("q", var("i"))), inc()], SoaSkipReason::MixedElementSize),
+            (vec![store("f", Expr::Number(0)), inc()], SoaSkipReason::UnsupportedType),
+            (vec![store("a", bin(BinOp::Div, idx("b", var("i")), Expr::Number(2))), inc()], SoaSkipReason::UnsupportedOp),
+            (vec![store("a", var("i")), inc()], SoaSkipReason::UnsupportedOp),
+            (vec![store("a", idx("b", Expr::Number(0))), inc()], SoaSkipReason::NonSequential),
+            (vec![Stmt::Break, inc()], SoaSkipReason::UnsupportedStatement),
+            (vec![store("q", bin(BinOp::Mul, idx("q", var("i")), Expr::Number(3))), inc()], SoaSkipReason::UnsupportedOp),
+            (vec![store("a", Expr::Number(0))], SoaSkipReason::NotCountable),
+            (vec![store("u", idx("a", var("i"))), inc()], SoaSkipReason::MixedElementKind),
+            (vec![store("a", call("sinf", vec![idx("b", var("i"))])), inc()], SoaSkipReason::MixedElementKind),
+            (vec![store("u", call("sin", vec![idx("v", var("i"))])), inc()], SoaSkipReason::MixedElementKind),
+            (vec![store("u", bin(BinOp::Mul, idx("v", var("i")), var("k"))), inc()], SoaSkipReason::MixedElementKind),
+            (vec![store("a", bin(BinOp::Add, idx("b", var("i")), Expr::Float(0.5))), inc()], SoaSkipReason::MixedElementKind),
+            (vec![store("u", call("atanf", vec![idx("v", var("i"))])), inc()], SoaSkipReason::UnsupportedOp),
+            (vec![store("u", call("tanhf", vec![idx("v", var("i"))])), inc()], SoaSkipReason::UnsupportedOp),
+        ];
+        for (body, reason) in cases {
+            assert_eq!(analyze(&lt_n(), &body, &c).unwrap_err(), reason, "{:?}", body);
+        }
+        let small = Expr::Comparison { op: CmpOp::Lt, left: Box::new(var("i")), right: Box::new(Expr::Number(4)) };
+        let body = vec![store("a", Expr::Number(0)), inc()];
+        assert_eq!(analyze(&small, &body, &c).unwrap_err(), SoaSkipReason::TripCountTooSmall);
+    }
+
+    #[test]
+    fn test_too_many_invariants_exhaust_ymm() {
+        let mut value = idx("a", var("i"));
+        for k in 1..=6 {
+            value = bin(BinOp::Add, value, Expr::Number(k));
+        }
+        let body = vec![store("b", value), inc()];
+        assert_eq!(analyze(&lt_n(), &body, &ctx()).unwrap_err(), SoaSkipReason::RegistersExhausted);
+    }
+}
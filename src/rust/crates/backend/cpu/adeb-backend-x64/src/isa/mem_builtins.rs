@@ -0,0 +1,126 @@
+// ============================================================
+// ADead-BIB — Builtins de memoria (memcpy/memset/memcmp/strlen)
+// ============================================================
+// Las funciones de <string.h> (adeb-stdlib fastos_string.rs) se
+// expanden en línea en vez de llamar por la IAT:
+//
+//   tamaño constante <= INLINE_MAX_BYTES → movs de 8/4/2/1 bytes
+//   tamaño constante <= REP_MAX_BYTES    → rep movsb / rep stosb
+//   más grande o desconocido             → bucle AVX2 de 32 bytes
+//                                          (BitTarget con YMM) o rep
+//
+// Convención de registros del código expandido:
+//   RDI = destino (o segundo operando de memcmp), RSI = origen,
+//   RCX = tamaño, RAX = valor/resultado, RDX = temporal.
+// RSI/RDI se guardan siempre en el prólogo; RCX/RDX son scratch.
+//
+// La asignación de structs (`a = b;`) usa el mismo camino de copia.
+// ============================================================
+
+use super::bit_resolver::BitTarget;
+
+/// Hasta aquí la copia son movs sueltos (8 pares load/store)
+pub const INLINE_MAX_BYTES: u64 = 64;
+/// Hasta aquí compensa `rep movsb` (ERMSB) frente a un bucle vectorial
+pub const REP_MAX_BYTES: u64 = 4096;
+/// Bytes por iteración del bucle AVX2
+pub const VECTOR_BLOCK: i32 = 32;
+
+/// Función de <string.h> que el backend expande en línea
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum MemBuiltin {
+    Memcpy,
+    Memset,
+    Memcmp,
+    Strlen,
+}
+
+impl MemBuiltin {
+    /// `memcpy` y `__builtin_memcpy` son el mismo builtin
+    pub fn from_name(name: &str) -> Option<Self> {
+        match name.strip_prefix("__builtin_").unwrap_or(name) {
+            "memcpy" => Some(MemBuiltin::Memcpy),
+            "memset" => Some(MemBuiltin::Memset),
+            "memcmp" => Some(MemBuiltin::Memcmp),
+            "strlen" => Some(MemBuiltin::Strlen),
+            _ => None,
+        }
+    }
+
+    pub fn arg_count(&self) -> usize {
+        match self {
+            MemBuiltin::Strlen => 1,
+            _ => 3,
+        }
+    }
+}
+
+/// Cómo se recorre un bloque de `size` bytes
+#[derive(Debug, Clone, PartialEq)]
+pub enum BlockStrategy {
+    /// Tamaño constante pequeño: (offset, anchura) de cada mov
+    Inline(Vec<(i32, u8)>),
+    /// rep movsb / rep stosb / repe cmpsb con RCX = tamaño
+    Rep,
+    /// Bucle de 32 bytes con YMM y cola con rep
+    Vector,
+}
+
+/// `size` = None si el tamaño solo se conoce en runtime
+pub fn block_strategy(size: Option<u64>, target: BitTarget) -> BlockStrategy {
+    match size {
+        Some(n) if n <= INLINE_MAX_BYTES => BlockStrategy::Inline(inline_chunks(n)),
+        Some(n) if n <= REP_MAX_BYTES => BlockStrategy::Rep,
+        _ if target.uses_ymm() => BlockStrategy::Vector,
+        _ => BlockStrategy::Rep,
+    }
+}
+
+/// Parte `size` en movs de 8, 4, 2 y 1 bytes, de menor a mayor offset
+pub fn inline_chunks(size: u64) -> Vec<(i32, u8)> {
+    let mut chunks = Vec::new();
+    let mut offset = 0u64;
+    for width in [8u64, 4, 2, 1] {
+        while size - offset >= width {
+            chunks.push((offset as i32, width as u8));
+            offset += width;
+        }
+    }
+    chunks
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_inline_chunks_cover_the_block_exactly() {
+        for size in 0..=INLINE_MAX_BYTES {
+            let chunks = inline_chunks(size);
+            let mut next = 0;
+            for &(offset, width) in &chunks {
+                assert_eq!(offset, next, "size {}", size);
+                next += width as i32;
+            }
+            assert_eq!(next as u64, size);
+        }
+        assert_eq!(inline_chunks(15), vec![(0, 8), (8, 4), (12, 2), (14, 1)]);
+    }
+
+    #[test]
+    fn test_block_strategy_by_size_and_target() {
+        assert_eq!(block_strategy(Some(24), BitTarget::Bits64), BlockStrategy::Inline(vec![(0, 8), (8, 8), (16, 8)]));
+        assert_eq!(block_strategy(Some(512), BitTarget::Bits256), BlockStrategy::Rep);
+        assert_eq!(block_strategy(Some(1 << 20), BitTarget::Bits256), BlockStrategy::Vector);
+        assert_eq!(block_strategy(None, BitTarget::Bits256), BlockStrategy::Vector);
+        assert_eq!(block_strategy(None, BitTarget::Bits64), BlockStrategy::Rep);
+    }
+
+    #[test]
+    fn test_builtin_names() {
+        assert_eq!(MemBuiltin::from_name("memcpy"), Some(MemBuiltin::Memcpy));
+        assert_eq!(MemBuiltin::from_name("__builtin_memset"), Some(MemBuiltin::Memset));
+        assert_eq!(MemBuiltin::from_name("strlen").map(|b| b.arg_count()), Some(1));
+        assert_eq!(MemBuiltin::from_name("memmove"), None);
+    }
+}
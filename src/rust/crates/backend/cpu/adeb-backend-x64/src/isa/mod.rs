@@ -26,6 +26,7 @@
 // ├── arch/         ← CRITICAL: x86-64 encoding, decoding, types
 // │   ├── encoder.rs       (ADeadOp → bytes, FASM multi-pass)
 // │   ├── decoder.rs       (bytes → disassembly, 80+ patterns)
+// │   ├── decode_table.rs  (opcode maps: longitud/prefijos en una pasada)
 // │   ├── vex_emitter.rs   (AVX/VEX prefix emission)
 // │   └── bit_resolver.rs  (label/jump resolution)
 // │
@@ -35,8 +36,18 @@
 // │   ├── cpp_isa.rs       (C++ vtable, this, inheritance)
 // │   ├── compiler/        (modular split of isa_compiler)
 // │   ├── optimizer.rs     (peephole optimization)
+// │   ├── scheduler.rs     (list scheduling por -mtune, macro-fusión)
 // │   ├── reg_alloc.rs     (GPR register allocation)
+// │   ├── liveness.rs      (live ranges of locals for reg_alloc)
 // │   ├── soa_optimizer.rs (SoA vectorization)
+// │   ├── loop_vectorizer.rs (AVX2 main loops for countable array loops)
+// │   ├── loop_opt.rs      (unroll + inducción a punteros, antes del codegen)
+// │   ├── sroa.rs          (structs locales → escalares, antes del codegen)
+// │   ├── struct_abi.rs    (structs por valor: registros Win64/SysV o memoria)
+// │   ├── switch_lowering.rs (switch → jump tables + binary search)
+// │   ├── strength_reduce.rs (mul/div/mod por constante → shl/lea/magic)
+// │   ├── mem_builtins.rs  (memcpy/memset/memcmp/strlen en línea)
+// │   ├── code_layout.rs   (orden de .text: región fría + afinidad de llamadas)
 // │   └── ymm_allocator.rs (AVX2 256-bit registers)
 // │
 // ├── mod.rs        ← THIS FILE: types (Reg, ADeadOp, etc.)
@@ -55,17 +66,46 @@
 // ════════════════════════════════════════════════════════════
 
 // ── Primary source files (canonical locations) ──
+pub mod async_io;
 pub mod bit_resolver;
+pub mod blas_kernels;
+pub mod btree;
 pub mod c_isa;
+pub mod code_layout;
 pub mod codegen;
 pub mod compiler;
 pub mod cpp_isa;
+pub mod debug_info;
+pub mod decode_table;
 pub mod decoder;
 pub mod encoder;
+pub mod flat_hash;
 pub mod isa_compiler;
+pub mod linux_stdio;
+pub mod linux_vdso;
+pub mod liveness;
+pub mod loop_opt;
+pub mod loop_vectorizer;
+pub mod mem_builtins;
 pub mod optimizer;
+pub mod par_algorithms;
+pub mod post_link;
 pub mod reg_alloc;
+pub mod scheduler;
+pub mod slab_heap;
+pub mod task_pool;
 pub mod soa_optimizer;
+pub mod sroa;
+pub mod strength_reduce;
+pub mod string_pool;
+pub mod struct_abi;
+pub mod switch_lowering;
+pub mod sync;
+// Fixture JIT de los tests; otros crates lo piden con la feature `test-jit`
+#[cfg(all(any(test, feature = "test-jit"), target_os = "linux", target_arch = "x86_64"))]
+#[doc(hidden)]
+pub mod test_jit;
+pub mod vec_math;
 pub mod vex_emitter;
 pub mod ymm_allocator;
 
@@ -614,6 +654,8 @@ pub enum CallTarget {
     Name(String),
     /// Call indirecto via registro (call rax) — function pointers
     Register(Reg),
+    /// Call indirecto via memoria (call [reg+disp]) — slots de vtable
+    Mem { base: Reg, disp: i32 },
 }
 
 impl std::fmt::Display for CallTarget {
@@ -623,6 +665,7 @@ impl std::fmt::Display for CallTarget {
             CallTarget::RipRelative(disp) => write!(f, "[rip+{}]", disp),
             CallTarget::Name(name) => write!(f, "{}", name),
             CallTarget::Register(reg) => write!(f, "*{:?}", reg),
+            CallTarget::Mem { base, disp } => write!(f, "[{:?}+{}]", base, disp),
         }
     }
 }
@@ -695,6 +738,10 @@ pub enum ADeadOp {
     /// Implica CQO antes de la división.
     Div { src: Reg },
 
+    /// IMUL src (un operando) — RDX:RAX = RAX * src con signo.
+    /// RDX es la mitad alta (división por número mágico).
+    MulHigh { src: Reg },
+
     /// AND dst, src — Bitwise AND
     And { dst: Reg, src: Reg },
 
@@ -719,6 +766,9 @@ pub enum ADeadOp {
     /// SHL dst, amount — Shift left
     Shl { dst: Reg, amount: u8 },
 
+    /// SAR dst, amount — Shift right aritmético (conserva el signo)
+    Sar { dst: Reg, amount: u8 },
+
     // ---- Comparison & Flags ----
     /// CMP left, right — Comparación (sets flags)
     Cmp { left: Operand, right: Operand },
@@ -780,6 +830,10 @@ pub enum ADeadOp {
     /// No emite bytes, solo registra el offset para resolución de saltos.
     Label(Label),
 
+    /// Pseudo-instrucción (-g): la línea de fuente empieza aquí.
+    /// No emite bytes; el encoder anota el offset para la tabla de líneas.
+    SourceLine(u32),
+
     /// NOP — No operation
     Nop,
 
@@ -879,6 +933,11 @@ pub enum ADeadOp {
         base_addr: u32,
     },
 
+    /// Tabla de saltos de un switch: un dword `target - table` por entrada.
+    /// Va justo después de `Label(table)`; el dispatch suma la entrada a la
+    /// dirección de la tabla (ver switch_lowering.rs).
+    JumpTable { table: Label, targets: Vec<Label> },
+
     /// CDQ/CQO — Sign-extend EAX/RAX into EDX:RDX (necesario antes de idiv)
     Cdq,
 
@@ -890,6 +949,36 @@ pub enum ADeadOp {
 
     /// STOSB — Store AL at [RDI], incrementa RDI
     Stosb,
+
+    /// CMPSB — Compara [RSI] con [RDI] (flags de [RSI] - [RDI]); con REP = REPE
+    Cmpsb,
+
+    /// BSWAP dst — Invierte el orden de los bytes (64 bits)
+    Bswap { dst: Reg },
+}
+
+impl ADeadOp {
+    /// Reescribe cada `Label` referenciado por la instrucción.
+    /// Usado al fusionar buffers de IR compilados por separado.
+    pub fn map_labels(&mut self, f: &mut impl FnMut(Label) -> Label) {
+        match self {
+            ADeadOp::Label(l)
+            | ADeadOp::Jmp { target: l }
+            | ADeadOp::Jcc { target: l, .. }
+            | ADeadOp::LeaLabel { label: l, .. }
+            | ADeadOp::LabelAddrRef { label: l, .. }
+            | ADeadOp::Call {
+                target: CallTarget::Relative(l),
+            } => *l = f(*l),
+            ADeadOp::JumpTable { table, targets } => {
+                *table = f(*table);
+                for t in targets {
+                    *t = f(*t);
+                }
+            }
+            _ => {}
+        }
+    }
 }
 
 impl std::fmt::Display for ADeadOp {
@@ -908,6 +997,7 @@ impl std::fmt::Display for ADeadOp {
             ADeadOp::Sub { dst, src } => write!(f, "sub {}, {}", dst, src),
             ADeadOp::Mul { dst, src } => write!(f, "imul {}, {}", dst, src),
             ADeadOp::Div { src } => write!(f, "cqo; idiv {}", src),
+            ADeadOp::MulHigh { src } => write!(f, "imul {}", src),
             ADeadOp::And { dst, src } => write!(f, "and {}, {}", dst, src),
             ADeadOp::Or { dst, src } => write!(f, "or {}, {}", dst, src),
             ADeadOp::Xor { dst, src } => write!(f, "xor {}, {}", dst, src),
@@ -916,6 +1006,7 @@ impl std::fmt::Display for ADeadOp {
             ADeadOp::Neg { dst } => write!(f, "neg {}", dst),
             ADeadOp::Not { dst } => write!(f, "not.logical {}", dst),
             ADeadOp::Shl { dst, amount } => write!(f, "shl {}, {}", dst, amount),
+            ADeadOp::Sar { dst, amount } => write!(f, "sar {}, {}", dst, amount),
             ADeadOp::Cmp { left, right } => write!(f, "cmp {}, {}", left, right),
             ADeadOp::Test { left, right } => write!(f, "test {}, {}", left, right),
             ADeadOp::SetCC { cond, dst } => write!(f, "set{} {}", cond, dst),
@@ -936,6 +1027,7 @@ impl std::fmt::Display for ADeadOp {
             ADeadOp::MovsdStore { base, disp, src } => write!(f, "movsd [{}{:+}], {}", base, disp, src),
             ADeadOp::MovsdLoad { dst, base, disp } => write!(f, "movsd {}, [{}{:+}]", dst, base, disp),
             ADeadOp::Label(label) => write!(f, "{}:", label),
+            ADeadOp::SourceLine(line) => write!(f, "; line {}", line),
             ADeadOp::Nop => write!(f, "nop"),
             ADeadOp::Cld => write!(f, "cld"),
             ADeadOp::RawBytes(bytes) => {
@@ -977,6 +1069,13 @@ impl std::fmt::Display for ADeadOp {
             ADeadOp::LeaLabel { dst, label } => {
                 write!(f, "lea {:?}, [rip+{}]", dst, label)
             }
+            ADeadOp::JumpTable { table, targets } => {
+                write!(f, "jump_table {} [", table)?;
+                for (k, t) in targets.iter().enumerate() {
+                    write!(f, "{}{} - {}", if k > 0 { ", " } else { "" }, t, table)?;
+                }
+                write!(f, "]")
+            }
             ADeadOp::LabelAddrRef {
                 label,
                 size,
@@ -992,6 +1091,8 @@ impl std::fmt::Display for ADeadOp {
             ADeadOp::Rep { op } => write!(f, "rep {}", op),
             ADeadOp::Movsb => write!(f, "movsb"),
             ADeadOp::Stosb => write!(f, "stosb"),
+            ADeadOp::Cmpsb => write!(f, "cmpsb"),
+            ADeadOp::Bswap { dst } => write!(f, "bswap {}", dst),
         }
     }
 }
@@ -1050,6 +1151,27 @@ impl ADeadIR {
         Label(id)
     }
 
+    /// Crea un buffer vacío cuyos labels empiezan en `base`.
+    /// Los labels `< base` siguen siendo válidos (p.ej. labels de funciones
+    /// pre-registrados en el buffer principal).
+    pub fn with_label_base(base: u32) -> Self {
+        Self {
+            ops: Vec::new(),
+            label_counter: base,
+            string_table: Vec::new(),
+        }
+    }
+
+    /// Número de labels generados hasta ahora.
+    pub fn label_count(&self) -> u32 {
+        self.label_counter
+    }
+
+    /// Consume el buffer y retorna sus instrucciones.
+    pub fn into_ops(self) -> Vec<ADeadOp> {
+        self.ops
+    }
+
     /// Retorna una referencia a las instrucciones emitidas.
     pub fn ops(&self) -> &[ADeadOp] {
         &self.ops
@@ -8,6 +8,7 @@
 //   - Modular Compiler: split version (compile, expressions, etc.)
 //   - Optimizer: peephole optimization on ADeadOp sequences
 //   - Register Allocator: GPR allocation
+//   - Liveness: live ranges of locals (feeds the allocator)
 //   - SoA Optimizer: struct-of-arrays vectorization
 //   - YMM Allocator: AVX2 256-bit register management
 //
@@ -41,6 +42,7 @@ pub use super::cpp_isa;
 pub use super::compiler;
 pub use super::optimizer;
 pub use super::reg_alloc;
+pub use super::liveness;
 pub use super::soa_optimizer;
 pub use super::ymm_allocator;
 pub use super::codegen;
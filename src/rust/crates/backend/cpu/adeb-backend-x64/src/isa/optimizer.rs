@@ -15,13 +15,17 @@
 //   - Register allocation hints: sugerencias de registros
 //   - Instruction fusion: combinar instrucciones
 //   - Size minimization: encodings más cortos
+//   - Scheduling (-mtune): list scheduler por bloque con latencias del
+//     core, cmp/test pegado al jcc y xorps antes de cvtsi2sd
 //
 // Autor: Eddi Andreé Salazar Matos
 // Email: eddi.salazar.dev@gmail.com
 // ============================================================
 
+use super::scheduler::{self, Uarch};
 use super::{ADeadIR, ADeadOp, Operand, Reg};
 use std::collections::HashSet;
+use std::time::{Duration, Instant};
 
 /// Nivel de optimización
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -36,6 +40,19 @@ pub enum IsaOptLevel {
     Size,
 }
 
+/// Estadísticas de una pasada del optimizador
+#[derive(Debug, Clone, Default)]
+pub struct PassStat {
+    pub name: &'static str,
+    /// Veces que se ejecutó (una por iteración)
+    pub runs: usize,
+    /// Ops eliminados en total (delta de tamaño del buffer)
+    pub ops_removed: usize,
+    /// Iteraciones en las que la pasada cambió algo
+    pub changed_runs: usize,
+    pub time: Duration,
+}
+
 /// Estadísticas de optimización
 #[derive(Debug, Clone, Default)]
 pub struct OptStats {
@@ -45,11 +62,55 @@ pub struct OptStats {
     pub dead_code_removed: usize,
     pub instructions_fused: usize,
     pub nops_eliminated: usize,
+    /// Ops que el scheduler cambió de posición
+    pub instructions_scheduled: usize,
+    /// Pares cmp/test + jcc que se dejaron juntos para macro-fusión
+    pub fused_pairs: usize,
+    /// Dependencias falsas rotas (xorps antes de cvtsi2sd)
+    pub false_deps_broken: usize,
+    /// Iteraciones del pipeline hasta el punto fijo
+    pub iterations: usize,
+    /// Desglose por pasada, en orden de ejecución
+    pub passes: Vec<PassStat>,
+    pub total_time: Duration,
+}
+
+impl OptStats {
+    pub fn pass(&self, name: &str) -> Option<&PassStat> {
+        self.passes.iter().find(|p| p.name == name)
+    }
+}
+
+/// Tope de iteraciones: cada pasada sólo encoge o reescribe hacia formas
+/// canónicas, así que el punto fijo llega en 2-3 vueltas en la práctica.
+const MAX_ITERATIONS: usize = 8;
+
+#[derive(Clone, Copy)]
+enum IsaPass {
+    Nops,
+    Peephole,
+    DeadCode,
+    Fusion,
+    Size,
+}
+
+impl IsaPass {
+    fn name(self) -> &'static str {
+        match self {
+            IsaPass::Nops => "nops",
+            IsaPass::Peephole => "peephole",
+            IsaPass::DeadCode => "dead_code",
+            IsaPass::Fusion => "fusion",
+            IsaPass::Size => "size",
+        }
+    }
 }
 
 /// Binary Layout Optimizer — Optimizador a nivel ISA
 pub struct IsaOptimizer {
     level: IsaOptLevel,
+    /// Core de `-mtune`; None = sin scheduling
+    tune: Option<Uarch>,
     stats: OptStats,
 }
 
@@ -57,10 +118,17 @@ impl IsaOptimizer {
     pub fn new(level: IsaOptLevel) -> Self {
         Self {
             level,
+            tune: None,
             stats: OptStats::default(),
         }
     }
 
+    /// Planifica para `tune` al final del pipeline
+    pub fn with_tune(mut self, tune: Uarch) -> Self {
+        self.tune = Some(tune);
+        self
+    }
+
     /// Convert a 64-bit register to its 32-bit equivalent (for xor-zero optimization)
     fn to_32bit(r: &Reg) -> Option<Reg> {
         match r {
@@ -74,59 +142,126 @@ impl IsaOptimizer {
         }
     }
 
-    /// Optimiza un buffer de instrucciones ADeadIR
-    pub fn optimize(&mut self, ir: &ADeadIR) -> ADeadIR {
-        let mut ops = ir.ops().to_vec();
-        self.stats.original_ops = ops.len();
-
+    /// Pasadas habilitadas por el nivel, en orden
+    fn pipeline(&self) -> Vec<IsaPass> {
+        let mut passes = Vec::new();
         if self.level == IsaOptLevel::None {
-            self.stats.optimized_ops = ops.len();
-            let mut result = ADeadIR::new();
-            for op in ops {
-                result.emit(op);
-            }
-            return result;
+            return passes;
         }
-
-        // Pass 1: Eliminar NOPs
-        ops = self.eliminate_nops(ops);
-
-        // Pass 2: Peephole optimizations
-        ops = self.peephole_optimize(ops);
-
-        // Pass 3: Dead code elimination (solo en Aggressive+)
+        passes.push(IsaPass::Nops);
+        passes.push(IsaPass::Peephole);
         if self.level == IsaOptLevel::Aggressive || self.level == IsaOptLevel::Size {
-            ops = self.eliminate_dead_code(ops);
+            passes.push(IsaPass::DeadCode);
+            passes.push(IsaPass::Fusion);
         }
-
-        // Pass 4: Instruction fusion (solo en Aggressive+)
-        if self.level == IsaOptLevel::Aggressive || self.level == IsaOptLevel::Size {
-            ops = self.fuse_instructions(ops);
+        if self.level == IsaOptLevel::Size {
+            passes.push(IsaPass::Size);
         }
+        passes
+    }
 
-        // Pass 5: Size optimizations (solo en Size)
-        if self.level == IsaOptLevel::Size {
-            ops = self.minimize_size(ops);
+    /// Optimiza el buffer de ops EN SITIO, repitiendo las pasadas hasta que
+    /// ninguna cambie nada (el peephole suele abrir DCE y viceversa).
+    pub fn optimize_in_place(&mut self, ops: &mut Vec<ADeadOp>) {
+        let _span = adeb_core::time_report::subphase("isa-optimize");
+        let start = Instant::now();
+        let pipeline = self.pipeline();
+        self.stats = OptStats {
+            original_ops: ops.len(),
+            passes: pipeline
+                .iter()
+                .map(|p| PassStat {
+                    name: p.name(),
+                    ..PassStat::default()
+                })
+                .collect(),
+            ..OptStats::default()
+        };
+
+        while !pipeline.is_empty() && self.stats.iterations < MAX_ITERATIONS {
+            self.stats.iterations += 1;
+            let mut changed = false;
+            for (k, &pass) in pipeline.iter().enumerate() {
+                let before = ops.len();
+                let t = Instant::now();
+                let did = match pass {
+                    IsaPass::Nops => self.eliminate_nops(ops),
+                    IsaPass::Peephole => self.peephole_optimize(ops),
+                    IsaPass::DeadCode => self.eliminate_dead_code(ops),
+                    IsaPass::Fusion => self.fuse_instructions(ops),
+                    IsaPass::Size => self.minimize_size(ops),
+                };
+                let stat = &mut self.stats.passes[k];
+                stat.runs += 1;
+                stat.time += t.elapsed();
+                stat.ops_removed += before - ops.len();
+                if did {
+                    stat.changed_runs += 1;
+                    changed = true;
+                }
+            }
+            if !changed {
+                break;
+            }
+        }
+        // El scheduling no encoge nada: una vez, sobre el punto fijo
+        if self.level != IsaOptLevel::None {
+            self.run_schedule(ops);
         }
 
         self.stats.optimized_ops = ops.len();
+        self.stats.total_time = start.elapsed();
+    }
 
-        // Reconstruir ADeadIR
-        let mut result = ADeadIR::new();
-        for op in ops {
-            result.emit(op);
-        }
+    /// Solo la pasada de scheduling (la que usa el compilador con `-mtune`:
+    /// el resto del pipeline no corre sobre su salida)
+    pub fn schedule_in_place(&mut self, ops: &mut Vec<ADeadOp>) {
+        let _span = adeb_core::time_report::subphase("isa-schedule");
+        let start = Instant::now();
+        self.stats = OptStats {
+            original_ops: ops.len(),
+            ..OptStats::default()
+        };
+        self.run_schedule(ops);
+        self.stats.optimized_ops = ops.len();
+        self.stats.total_time = start.elapsed();
+    }
+
+    fn run_schedule(&mut self, ops: &mut Vec<ADeadOp>) {
+        let Some(tune) = self.tune else {
+            return;
+        };
+        let t = Instant::now();
+        let result = scheduler::schedule(ops, tune);
+        self.stats.instructions_scheduled += result.moved;
+        self.stats.fused_pairs += result.fused_pairs;
+        self.stats.false_deps_broken += result.false_deps_broken;
+        self.stats.passes.push(PassStat {
+            name: "schedule",
+            runs: 1,
+            ops_removed: 0,
+            changed_runs: (result.moved + result.false_deps_broken > 0) as usize,
+            time: t.elapsed(),
+        });
+    }
+
+    /// Optimiza un ADeadIR en sitio (conserva labels y tabla de strings)
+    pub fn optimize_ir(&mut self, ir: &mut ADeadIR) {
+        self.optimize_in_place(ir.ops_mut());
+    }
+
+    /// Optimiza un buffer de instrucciones ADeadIR
+    pub fn optimize(&mut self, ir: &ADeadIR) -> ADeadIR {
+        let mut result = ir.clone();
+        self.optimize_ir(&mut result);
         result
     }
 
     /// Optimiza un slice de operaciones directamente
     pub fn optimize_ops(&mut self, ops: &[ADeadOp]) -> Vec<ADeadOp> {
-        let mut ir = ADeadIR::new();
-        for op in ops {
-            ir.emit(op.clone());
-        }
-        let optimized = self.optimize(&ir);
-        optimized.ops().to_vec()
+        let mut result = ops.to_vec();
+        self.optimize_in_place(&mut result);
+        result
     }
 
     /// Retorna estadísticas de la última optimización
@@ -138,371 +273,385 @@ impl IsaOptimizer {
     // Pass 1: Eliminar NOPs
     // ========================================
 
-    fn eliminate_nops(&mut self, ops: Vec<ADeadOp>) -> Vec<ADeadOp> {
+    fn eliminate_nops(&mut self, ops: &mut Vec<ADeadOp>) -> bool {
         let original_len = ops.len();
-        let result: Vec<ADeadOp> = ops
-            .into_iter()
-            .filter(|op| !matches!(op, ADeadOp::Nop))
-            .collect();
-        self.stats.nops_eliminated = original_len - result.len();
-        result
+        ops.retain(|op| !matches!(op, ADeadOp::Nop));
+        self.stats.nops_eliminated += original_len - ops.len();
+        ops.len() != original_len
     }
 
     // ========================================
     // Pass 2: Peephole Optimizations
     // ========================================
 
-    fn peephole_optimize(&mut self, ops: Vec<ADeadOp>) -> Vec<ADeadOp> {
-        let mut result = Vec::with_capacity(ops.len());
-        let mut i = 0;
+    fn peephole_optimize(&mut self, ops: &mut Vec<ADeadOp>) -> bool {
+        // Compactación en sitio: `w` nunca adelanta a `r` porque cada
+        // patrón produce a lo sumo tantos ops como consume.
+        let mut changed = false;
+        let (mut r, mut w) = (0, 0);
+        while r < ops.len() {
+            match self.peephole_at(ops, r) {
+                Some((consumed, replacement)) => {
+                    changed = true;
+                    r += consumed;
+                    if let Some(op) = replacement {
+                        ops[w] = op;
+                        w += 1;
+                    }
+                }
+                None => {
+                    ops.swap(w, r);
+                    w += 1;
+                    r += 1;
+                }
+            }
+        }
+        ops.truncate(w);
+        changed
+    }
 
-        while i < ops.len() {
-            // Pattern: mov rax, 0 → xor eax, eax (más corto)
-            if let ADeadOp::Mov {
-                dst: Operand::Reg(Reg::RAX),
-                src: Operand::Imm64(0),
-            } = &ops[i]
-            {
-                result.push(ADeadOp::Xor {
+    /// Patrón peephole en `ops[i..]`: (ops consumidos, reemplazo)
+    fn peephole_at(&mut self, ops: &[ADeadOp], i: usize) -> Option<(usize, Option<ADeadOp>)> {
+        // Pattern: mov rax, 0 → xor eax, eax (más corto)
+        if let ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RAX),
+            src: Operand::Imm64(0),
+        } = &ops[i]
+        {
+            self.stats.peephole_applied += 1;
+            return Some((
+                1,
+                Some(ADeadOp::Xor {
                     dst: Reg::EAX,
                     src: Reg::EAX,
-                });
-                self.stats.peephole_applied += 1;
-                i += 1;
-                continue;
-            }
+                }),
+            ));
+        }
 
-            // Pattern: mov rcx, 0 → xor ecx, ecx
-            if let ADeadOp::Mov {
-                dst: Operand::Reg(Reg::RCX),
-                src: Operand::Imm64(0),
-            } = &ops[i]
-            {
-                result.push(ADeadOp::Xor {
+        // Pattern: mov rcx, 0 → xor ecx, ecx
+        if let ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RCX),
+            src: Operand::Imm64(0),
+        } = &ops[i]
+        {
+            self.stats.peephole_applied += 1;
+            return Some((
+                1,
+                Some(ADeadOp::Xor {
                     dst: Reg::ECX,
                     src: Reg::ECX,
-                });
-                self.stats.peephole_applied += 1;
-                i += 1;
-                continue;
-            }
+                }),
+            ));
+        }
 
-            // Pattern: push rbp; mov rbp, rsp → (mantener, es prologue estándar)
-            // Pattern: mov rsp, rbp; pop rbp → (mantener, es epilogue estándar)
+        // Pattern: push rbp; mov rbp, rsp → (mantener, es prologue estándar)
+        // Pattern: mov rsp, rbp; pop rbp → (mantener, es epilogue estándar)
 
-            // Pattern: add rax, 0 → eliminar (no-op)
-            if let ADeadOp::Add {
-                dst: Operand::Reg(_),
-                src: Operand::Imm32(0),
-            } = &ops[i]
-            {
-                self.stats.peephole_applied += 1;
-                i += 1;
-                continue;
-            }
-            if let ADeadOp::Add {
-                dst: Operand::Reg(_),
-                src: Operand::Imm8(0),
-            } = &ops[i]
-            {
-                self.stats.peephole_applied += 1;
-                i += 1;
-                continue;
-            }
+        // Pattern: add rax, 0 → eliminar (no-op)
+        if let ADeadOp::Add {
+            dst: Operand::Reg(_),
+            src: Operand::Imm32(0),
+        } = &ops[i]
+        {
+            self.stats.peephole_applied += 1;
+            return Some((1, None));
+        }
+        if let ADeadOp::Add {
+            dst: Operand::Reg(_),
+            src: Operand::Imm8(0),
+        } = &ops[i]
+        {
+            self.stats.peephole_applied += 1;
+            return Some((1, None));
+        }
 
-            // Pattern: sub rax, 0 → eliminar (no-op)
-            if let ADeadOp::Sub {
-                dst: Operand::Reg(_),
-                src: Operand::Imm32(0),
-            } = &ops[i]
-            {
-                self.stats.peephole_applied += 1;
-                i += 1;
-                continue;
-            }
-            if let ADeadOp::Sub {
-                dst: Operand::Reg(_),
-                src: Operand::Imm8(0),
-            } = &ops[i]
-            {
+        // Pattern: sub rax, 0 → eliminar (no-op)
+        if let ADeadOp::Sub {
+            dst: Operand::Reg(_),
+            src: Operand::Imm32(0),
+        } = &ops[i]
+        {
+            self.stats.peephole_applied += 1;
+            return Some((1, None));
+        }
+        if let ADeadOp::Sub {
+            dst: Operand::Reg(_),
+            src: Operand::Imm8(0),
+        } = &ops[i]
+        {
+            self.stats.peephole_applied += 1;
+            return Some((1, None));
+        }
+
+        // Pattern: mov reg, reg (mismo registro) → eliminar
+        if let ADeadOp::Mov {
+            dst: Operand::Reg(d),
+            src: Operand::Reg(s),
+        } = &ops[i]
+        {
+            if d == s {
                 self.stats.peephole_applied += 1;
-                i += 1;
-                continue;
+                return Some((1, None));
             }
+        }
 
-            // Pattern: mov reg, reg (mismo registro) → eliminar
-            if let ADeadOp::Mov {
-                dst: Operand::Reg(d),
-                src: Operand::Reg(s),
-            } = &ops[i]
+        // Pattern: push rax; pop rax → eliminar ambos
+        if i + 1 < ops.len() {
+            if let (
+                ADeadOp::Push {
+                    src: Operand::Reg(r1),
+                },
+                ADeadOp::Pop { dst: r2 },
+            ) = (&ops[i], &ops[i + 1])
             {
-                if d == s {
+                if r1 == r2 {
                     self.stats.peephole_applied += 1;
-                    i += 1;
-                    continue;
-                }
-            }
-
-            // Pattern: push rax; pop rax → eliminar ambos
-            if i + 1 < ops.len() {
-                if let (
-                    ADeadOp::Push {
-                        src: Operand::Reg(r1),
-                    },
-                    ADeadOp::Pop { dst: r2 },
-                ) = (&ops[i], &ops[i + 1])
-                {
-                    if r1 == r2 {
-                        self.stats.peephole_applied += 1;
-                        i += 2;
-                        continue;
-                    }
+                    return Some((2, None));
                 }
             }
+        }
 
-            // Pattern: jmp .L0; .L0: → eliminar jmp (salto al siguiente)
-            if i + 1 < ops.len() {
-                if let (ADeadOp::Jmp { target: t1 }, ADeadOp::Label(t2)) = (&ops[i], &ops[i + 1]) {
-                    if t1 == t2 {
-                        self.stats.peephole_applied += 1;
-                        i += 1; // Skip jmp, keep label
-                        continue;
-                    }
+        // Pattern: jmp .L0; .L0: → eliminar jmp (salto al siguiente)
+        if i + 1 < ops.len() {
+            if let (ADeadOp::Jmp { target: t1 }, ADeadOp::Label(t2)) = (&ops[i], &ops[i + 1]) {
+                if t1 == t2 {
+                    self.stats.peephole_applied += 1;
+                    return Some((1, None));
                 }
             }
+        }
 
-            // Pattern: test rax, rax; sete al; movzx rax, al → (mantener, es NOT lógico)
+        // Pattern: test rax, rax; sete al; movzx rax, al → (mantener, es NOT lógico)
 
-            // Pattern: imm32 que cabe en imm8 → usar imm8
-            if let ADeadOp::Sub {
-                dst: Operand::Reg(Reg::RSP),
-                src: Operand::Imm32(v),
-            } = &ops[i]
-            {
-                if *v >= -128 && *v <= 127 {
-                    result.push(ADeadOp::Sub {
+        // Pattern: imm32 que cabe en imm8 → usar imm8
+        if let ADeadOp::Sub {
+            dst: Operand::Reg(Reg::RSP),
+            src: Operand::Imm32(v),
+        } = &ops[i]
+        {
+            if *v >= -128 && *v <= 127 {
+                self.stats.peephole_applied += 1;
+                return Some((
+                    1,
+                    Some(ADeadOp::Sub {
                         dst: Operand::Reg(Reg::RSP),
                         src: Operand::Imm8(*v as i8),
-                    });
-                    self.stats.peephole_applied += 1;
-                    i += 1;
-                    continue;
-                }
+                    }),
+                ));
             }
-            if let ADeadOp::Add {
-                dst: Operand::Reg(Reg::RSP),
-                src: Operand::Imm32(v),
-            } = &ops[i]
-            {
-                if *v >= -128 && *v <= 127 {
-                    result.push(ADeadOp::Add {
+        }
+        if let ADeadOp::Add {
+            dst: Operand::Reg(Reg::RSP),
+            src: Operand::Imm32(v),
+        } = &ops[i]
+        {
+            if *v >= -128 && *v <= 127 {
+                self.stats.peephole_applied += 1;
+                return Some((
+                    1,
+                    Some(ADeadOp::Add {
                         dst: Operand::Reg(Reg::RSP),
                         src: Operand::Imm8(*v as i8),
-                    });
-                    self.stats.peephole_applied += 1;
-                    i += 1;
-                    continue;
-                }
+                    }),
+                ));
             }
+        }
 
-            // Pattern: mov reg, rax; ... use reg → optimize when reg == rax (self-move)
-            // Pattern: mov rax, imm; mov reg, rax; → mov reg, imm (fuse load+move)
-            if i + 1 < ops.len() {
-                if let (
-                    ADeadOp::Mov {
-                        dst: Operand::Reg(Reg::RAX),
-                        src: Operand::Imm64(v),
-                    },
-                    ADeadOp::Mov {
-                        dst: Operand::Reg(dst_reg),
-                        src: Operand::Reg(Reg::RAX),
-                    },
-                ) = (&ops[i], &ops[i + 1])
-                {
-                    // Fuse: mov rax, imm64; mov reg, rax → mov reg, imm64
-                    result.push(ADeadOp::Mov {
+        // Pattern: mov reg, rax; ... use reg → optimize when reg == rax (self-move)
+        // Pattern: mov rax, imm; mov reg, rax; → mov reg, imm (fuse load+move)
+        if i + 1 < ops.len() {
+            if let (
+                ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Imm64(v),
+                },
+                ADeadOp::Mov {
+                    dst: Operand::Reg(dst_reg),
+                    src: Operand::Reg(Reg::RAX),
+                },
+            ) = (&ops[i], &ops[i + 1])
+            {
+                // Fuse: mov rax, imm64; mov reg, rax → mov reg, imm64
+                self.stats.peephole_applied += 1;
+                self.stats.instructions_fused += 1;
+                return Some((
+                    2,
+                    Some(ADeadOp::Mov {
                         dst: Operand::Reg(*dst_reg),
                         src: Operand::Imm64(*v),
-                    });
-                    self.stats.peephole_applied += 1;
-                    self.stats.instructions_fused += 1;
-                    i += 2;
-                    continue;
-                }
+                    }),
+                ));
             }
+        }
 
-            // Pattern: mov temp, rax; mov rax, temp → eliminate (register round-trip)
-            if i + 1 < ops.len() {
-                if let (
-                    ADeadOp::Mov {
-                        dst: Operand::Reg(r1),
-                        src: Operand::Reg(Reg::RAX),
-                    },
-                    ADeadOp::Mov {
-                        dst: Operand::Reg(Reg::RAX),
-                        src: Operand::Reg(r2),
-                    },
-                ) = (&ops[i], &ops[i + 1])
-                {
-                    if r1 == r2 && *r1 != Reg::RAX {
-                        // This is a no-op round-trip, skip both
-                        self.stats.peephole_applied += 1;
-                        i += 2;
-                        continue;
-                    }
+        // Pattern: mov temp, rax; mov rax, temp → eliminate (register round-trip)
+        if i + 1 < ops.len() {
+            if let (
+                ADeadOp::Mov {
+                    dst: Operand::Reg(r1),
+                    src: Operand::Reg(Reg::RAX),
+                },
+                ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Reg(r2),
+                },
+            ) = (&ops[i], &ops[i + 1])
+            {
+                if r1 == r2 && *r1 != Reg::RAX {
+                    // This is a no-op round-trip, skip both
+                    self.stats.peephole_applied += 1;
+                    return Some((2, None));
                 }
             }
+        }
 
-            // FASM-inspired: push rax; pop rbx → mov rbx, rax (saves stack ops)
-            if i + 1 < ops.len() {
-                if let (
-                    ADeadOp::Push {
-                        src: Operand::Reg(r1),
-                    },
-                    ADeadOp::Pop { dst: r2 },
-                ) = (&ops[i], &ops[i + 1])
-                {
-                    if r1 != r2 {
-                        result.push(ADeadOp::Mov {
+        // FASM-inspired: push rax; pop rbx → mov rbx, rax (saves stack ops)
+        if i + 1 < ops.len() {
+            if let (
+                ADeadOp::Push {
+                    src: Operand::Reg(r1),
+                },
+                ADeadOp::Pop { dst: r2 },
+            ) = (&ops[i], &ops[i + 1])
+            {
+                if r1 != r2 {
+                    self.stats.peephole_applied += 1;
+                    self.stats.instructions_fused += 1;
+                    return Some((
+                        2,
+                        Some(ADeadOp::Mov {
                             dst: Operand::Reg(*r2),
                             src: Operand::Reg(*r1),
-                        });
-                        self.stats.peephole_applied += 1;
-                        self.stats.instructions_fused += 1;
-                        i += 2;
-                        continue;
-                    }
+                        }),
+                    ));
                 }
             }
+        }
 
-            // FASM-inspired: mul by power-of-2 → shl (strength reduction)
-            // imul rax, rbx where we know rbx = 2^N → shl rax, N
-            // (Can only apply when preceded by mov rbx, imm)
-            if i + 1 < ops.len() {
-                if let (
-                    ADeadOp::Mov {
-                        dst: Operand::Reg(Reg::RBX),
-                        src: Operand::Imm64(v),
-                    },
-                    ADeadOp::Mul {
-                        dst: Reg::RAX,
-                        src: Reg::RBX,
-                    },
-                ) = (&ops[i], &ops[i + 1])
-                {
-                    if v.is_power_of_two() && *v > 1 {
-                        let shift = v.trailing_zeros() as u8;
-                        result.push(ADeadOp::Shl {
+        // FASM-inspired: mul by power-of-2 → shl (strength reduction)
+        // imul rax, rbx where we know rbx = 2^N → shl rax, N
+        // (Can only apply when preceded by mov rbx, imm)
+        if i + 1 < ops.len() {
+            if let (
+                ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RBX),
+                    src: Operand::Imm64(v),
+                },
+                ADeadOp::Mul {
+                    dst: Reg::RAX,
+                    src: Reg::RBX,
+                },
+            ) = (&ops[i], &ops[i + 1])
+            {
+                if v.is_power_of_two() && *v > 1 {
+                    let shift = v.trailing_zeros() as u8;
+                    self.stats.peephole_applied += 1;
+                    self.stats.instructions_fused += 1;
+                    return Some((
+                        2,
+                        Some(ADeadOp::Shl {
                             dst: Reg::RAX,
                             amount: shift,
-                        });
-                        self.stats.peephole_applied += 1;
-                        self.stats.instructions_fused += 1;
-                        i += 2;
-                        continue;
-                    }
+                        }),
+                    ));
                 }
             }
+        }
 
-            // FASM-inspired: mov rax, imm32(0) → xor eax, eax
-            if let ADeadOp::Mov {
-                dst: Operand::Reg(Reg::RAX),
-                src: Operand::Imm32(0),
-            } = &ops[i]
-            {
-                result.push(ADeadOp::Xor {
+        // FASM-inspired: mov rax, imm32(0) → xor eax, eax
+        if let ADeadOp::Mov {
+            dst: Operand::Reg(Reg::RAX),
+            src: Operand::Imm32(0),
+        } = &ops[i]
+        {
+            self.stats.peephole_applied += 1;
+            return Some((
+                1,
+                Some(ADeadOp::Xor {
                     dst: Reg::EAX,
                     src: Reg::EAX,
-                });
-                self.stats.peephole_applied += 1;
-                i += 1;
-                continue;
-            }
+                }),
+            ));
+        }
 
-            // Pattern: mov reg, 0 → xor reg32, reg32 (ANY general-purpose register)
-            if let ADeadOp::Mov {
-                dst: Operand::Reg(r),
-                src: Operand::Imm64(0),
-            } = &ops[i]
-            {
-                if r.is_64bit() && !matches!(r, Reg::RSP | Reg::RBP) {
-                    let r32 = Self::to_32bit(r);
-                    if let Some(r32) = r32 {
-                        result.push(ADeadOp::Xor { dst: r32, src: r32 });
-                        self.stats.peephole_applied += 1;
-                        i += 1;
-                        continue;
-                    }
+        // Pattern: mov reg, 0 → xor reg32, reg32 (ANY general-purpose register)
+        if let ADeadOp::Mov {
+            dst: Operand::Reg(r),
+            src: Operand::Imm64(0),
+        } = &ops[i]
+        {
+            if r.is_64bit() && !matches!(r, Reg::RSP | Reg::RBP) {
+                let r32 = Self::to_32bit(r);
+                if let Some(r32) = r32 {
+                    self.stats.peephole_applied += 1;
+                    return Some((1, Some(ADeadOp::Xor { dst: r32, src: r32 })));
                 }
             }
+        }
 
-            // Pattern: add reg, reg → shl reg, 1 (x + x = x * 2 = x << 1)
-            if let ADeadOp::Add {
-                dst: Operand::Reg(d),
-                src: Operand::Reg(s),
-            } = &ops[i]
-            {
-                if d == s {
-                    result.push(ADeadOp::Shl { dst: *d, amount: 1 });
-                    self.stats.peephole_applied += 1;
-                    i += 1;
-                    continue;
-                }
+        // Pattern: add reg, reg → shl reg, 1 (x + x = x * 2 = x << 1)
+        if let ADeadOp::Add {
+            dst: Operand::Reg(d),
+            src: Operand::Reg(s),
+        } = &ops[i]
+        {
+            if d == s {
+                self.stats.peephole_applied += 1;
+                return Some((1, Some(ADeadOp::Shl { dst: *d, amount: 1 })));
             }
+        }
 
-            // Pattern: cmp reg, 0 → test reg, reg (shorter encoding)
-            if let ADeadOp::Cmp {
-                left: Operand::Reg(r),
-                right: Operand::Imm32(0),
-            } = &ops[i]
-            {
-                result.push(ADeadOp::Test {
+        // Pattern: cmp reg, 0 → test reg, reg (shorter encoding)
+        if let ADeadOp::Cmp {
+            left: Operand::Reg(r),
+            right: Operand::Imm32(0),
+        } = &ops[i]
+        {
+            self.stats.peephole_applied += 1;
+            return Some((
+                1,
+                Some(ADeadOp::Test {
                     left: *r,
                     right: *r,
-                });
-                self.stats.peephole_applied += 1;
-                i += 1;
-                continue;
-            }
+                }),
+            ));
+        }
 
-            // Pattern: mov rax, imm; push rax → push imm (if imm fits in imm32)
-            if i + 1 < ops.len() {
-                if let (
-                    ADeadOp::Mov {
-                        dst: Operand::Reg(Reg::RAX),
-                        src: Operand::Imm32(v),
-                    },
-                    ADeadOp::Push {
-                        src: Operand::Reg(Reg::RAX),
-                    },
-                ) = (&ops[i], &ops[i + 1])
-                {
-                    result.push(ADeadOp::Push {
+        // Pattern: mov rax, imm; push rax → push imm (if imm fits in imm32)
+        if i + 1 < ops.len() {
+            if let (
+                ADeadOp::Mov {
+                    dst: Operand::Reg(Reg::RAX),
+                    src: Operand::Imm32(v),
+                },
+                ADeadOp::Push {
+                    src: Operand::Reg(Reg::RAX),
+                },
+            ) = (&ops[i], &ops[i + 1])
+            {
+                self.stats.peephole_applied += 1;
+                self.stats.instructions_fused += 1;
+                return Some((
+                    2,
+                    Some(ADeadOp::Push {
                         src: Operand::Imm32(*v),
-                    });
-                    self.stats.peephole_applied += 1;
-                    self.stats.instructions_fused += 1;
-                    i += 2;
-                    continue;
-                }
+                    }),
+                ));
             }
-
-            // No pattern matched, keep instruction
-            result.push(ops[i].clone());
-            i += 1;
         }
 
-        result
+        // No pattern matched, keep instruction
+        None
     }
 
     // ========================================
     // Pass 3: Dead Code Elimination
     // ========================================
 
-    fn eliminate_dead_code(&mut self, ops: Vec<ADeadOp>) -> Vec<ADeadOp> {
+    fn eliminate_dead_code(&mut self, ops: &mut Vec<ADeadOp>) -> bool {
         // Encontrar labels usados
         let mut used_labels: HashSet<u32> = HashSet::new();
-        for op in &ops {
+        for op in ops.iter() {
             match op {
                 ADeadOp::Jmp { target } => {
                     used_labels.insert(target.0);
@@ -515,82 +664,72 @@ impl IsaOptimizer {
                         used_labels.insert(label.0);
                     }
                 }
+                // Direcciones tomadas: function pointers y tablas de saltos
+                ADeadOp::LeaLabel { label, .. } | ADeadOp::LabelAddrRef { label, .. } => {
+                    used_labels.insert(label.0);
+                }
+                ADeadOp::JumpTable { targets, .. } => {
+                    used_labels.extend(targets.iter().map(|t| t.0));
+                }
                 _ => {}
             }
         }
 
         // Eliminar labels no usados y código después de ret/jmp incondicional
-        let mut result = Vec::with_capacity(ops.len());
+        let original_len = ops.len();
         let mut skip_until_label = false;
-
-        for op in ops {
+        ops.retain(|op| {
             // Si encontramos un label, dejamos de saltar
-            if let ADeadOp::Label(label) = &op {
+            if let ADeadOp::Label(label) = op {
                 if used_labels.contains(&label.0) {
                     skip_until_label = false;
-                    result.push(op);
-                } else {
-                    // Label no usado, eliminar
-                    self.stats.dead_code_removed += 1;
+                    return true;
                 }
-                continue;
+                // Label no usado, eliminar
+                return false;
             }
-
             if skip_until_label {
-                self.stats.dead_code_removed += 1;
-                continue;
+                return false;
             }
-
-            result.push(op.clone());
-
             // Después de ret o jmp incondicional, el código es inalcanzable
             if matches!(op, ADeadOp::Ret | ADeadOp::Jmp { .. }) {
                 skip_until_label = true;
             }
-        }
-
-        result
+            true
+        });
+        self.stats.dead_code_removed += original_len - ops.len();
+        ops.len() != original_len
     }
 
     // ========================================
     // Pass 4: Instruction Fusion
     // ========================================
 
-    fn fuse_instructions(&mut self, ops: Vec<ADeadOp>) -> Vec<ADeadOp> {
-        let mut result = Vec::with_capacity(ops.len());
-        let mut i = 0;
-
-        while i < ops.len() {
-            // Pattern: cqo; idiv rbx → Div (ya fusionado en ADeadOp::Div)
-            // Este patrón ya está manejado en el encoder
+    fn fuse_instructions(&mut self, _ops: &mut Vec<ADeadOp>) -> bool {
+        // Pattern: cqo; idiv rbx → Div (ya fusionado en ADeadOp::Div)
+        // Este patrón ya está manejado en el encoder
 
-            // Pattern: test rax, rax; sete al; movzx rax, al → Not (ya fusionado)
-            // Este patrón ya está manejado en el encoder
+        // Pattern: test rax, rax; sete al; movzx rax, al → Not (ya fusionado)
+        // Este patrón ya está manejado en el encoder
 
-            // Pattern: mov rax, [rbp+X]; push rax → push [rbp+X] (si soportado)
-            // x86-64 soporta push mem, pero es más lento. Mantener separado.
+        // Pattern: mov rax, [rbp+X]; push rax → push [rbp+X] (si soportado)
+        // x86-64 soporta push mem, pero es más lento. Mantener separado.
 
-            // Pattern: xor eax, eax; ret → (mantener, es return 0 estándar)
+        // Pattern: xor eax, eax; ret → (mantener, es return 0 estándar)
 
-            // Pattern: sub rsp, N; ... ; add rsp, N → (verificar que N sea igual)
-            // Esto requiere análisis más complejo, skip por ahora
-
-            result.push(ops[i].clone());
-            i += 1;
-        }
-
-        result
+        // Pattern: sub rsp, N; ... ; add rsp, N → (verificar que N sea igual)
+        // Esto requiere análisis más complejo, skip por ahora
+        false
     }
 
     // ========================================
     // Pass 5: Size Minimization
     // ========================================
 
-    fn minimize_size(&mut self, ops: Vec<ADeadOp>) -> Vec<ADeadOp> {
-        let mut result = Vec::with_capacity(ops.len());
-
-        for op in ops {
-            match &op {
+    fn minimize_size(&mut self, ops: &mut Vec<ADeadOp>) -> bool {
+        let mut changed = false;
+        for op in ops.iter_mut() {
+            let shorter = match &*op {
                 // Usar encodings más cortos para inmediatos pequeños
                 ADeadOp::Mov {
                     dst: Operand::Reg(r),
@@ -599,66 +738,49 @@ impl IsaOptimizer {
                     if *v == 0 {
                         // mov rax, 0 → xor eax, eax (2 bytes vs 10 bytes)
                         match r {
-                            Reg::RAX => result.push(ADeadOp::Xor {
+                            Reg::RAX => Some(ADeadOp::Xor {
                                 dst: Reg::EAX,
                                 src: Reg::EAX,
                             }),
-                            Reg::RCX => result.push(ADeadOp::Xor {
+                            Reg::RCX => Some(ADeadOp::Xor {
                                 dst: Reg::ECX,
                                 src: Reg::ECX,
                             }),
-                            _ => result.push(op),
+                            _ => None,
                         }
                     } else if *v <= 0x7FFFFFFF {
                         // Cabe en imm32 sign-extended
-                        result.push(ADeadOp::Mov {
+                        Some(ADeadOp::Mov {
                             dst: Operand::Reg(*r),
                             src: Operand::Imm32(*v as i32),
-                        });
+                        })
                     } else {
-                        result.push(op);
+                        None
                     }
                 }
 
                 // Usar inc/dec en lugar de add/sub 1
                 ADeadOp::Add {
                     dst: Operand::Reg(r),
-                    src: Operand::Imm32(1),
-                } => {
-                    result.push(ADeadOp::Inc {
-                        dst: Operand::Reg(*r),
-                    });
-                }
-                ADeadOp::Add {
-                    dst: Operand::Reg(r),
-                    src: Operand::Imm8(1),
-                } => {
-                    result.push(ADeadOp::Inc {
-                        dst: Operand::Reg(*r),
-                    });
-                }
-                ADeadOp::Sub {
-                    dst: Operand::Reg(r),
-                    src: Operand::Imm32(1),
-                } => {
-                    result.push(ADeadOp::Dec {
-                        dst: Operand::Reg(*r),
-                    });
-                }
+                    src: Operand::Imm32(1) | Operand::Imm8(1),
+                } => Some(ADeadOp::Inc {
+                    dst: Operand::Reg(*r),
+                }),
                 ADeadOp::Sub {
                     dst: Operand::Reg(r),
-                    src: Operand::Imm8(1),
-                } => {
-                    result.push(ADeadOp::Dec {
-                        dst: Operand::Reg(*r),
-                    });
-                }
-
-                _ => result.push(op),
+                    src: Operand::Imm32(1) | Operand::Imm8(1),
+                } => Some(ADeadOp::Dec {
+                    dst: Operand::Reg(*r),
+                }),
+
+                _ => None,
+            };
+            if let Some(shorter) = shorter {
+                *op = shorter;
+                changed = true;
             }
         }
-
-        result
+        changed
     }
 }
 
@@ -692,22 +814,31 @@ impl BinaryRebuilder {
 
         // Decode
         let mut decoder = Decoder::new();
-        let ops = decoder.decode_all(code);
+        let mut ops = decoder.decode_all(code);
 
         // Optimize
-        let mut ir = ADeadIR::new();
-        for op in ops {
-            ir.emit(op);
-        }
-        let optimized_ir = self.optimizer.optimize(&ir);
+        self.optimizer.optimize_in_place(&mut ops);
 
         // Encode
         let mut encoder = Encoder::new();
-        let result = encoder.encode_all(optimized_ir.ops());
+        let result = encoder.encode_all(&ops);
 
         result.code
     }
 
+    /// Post-link: reordena bloques y funciones de `code` (cargado en
+    /// `text_va`) según un perfil de ramas muestreado. A diferencia de
+    /// `reoptimize`, solo re-emite los saltos; ver post_link.rs.
+    pub fn relayout(
+        &self,
+        code: &[u8],
+        text_va: u64,
+        profile: &super::post_link::BranchProfile,
+        entries: &[usize],
+    ) -> Result<super::post_link::Relayout, String> {
+        super::post_link::relayout(code, text_va, profile, entries)
+    }
+
     /// Retorna estadísticas
     pub fn stats(&self) -> &OptStats {
         self.optimizer.stats()
@@ -808,6 +939,78 @@ mod tests {
         assert!(matches!(result[0], ADeadOp::Inc { .. }));
     }
 
+    #[test]
+    fn test_iterates_to_fixed_point() {
+        // push rbx; push rax; pop rax; pop rbx: la primera vuelta deja
+        // push rbx; pop rbx, que sólo cae en la segunda.
+        let mut opt = IsaOptimizer::new(IsaOptLevel::Basic);
+        let ops = vec![
+            ADeadOp::Push {
+                src: Operand::Reg(Reg::RBX),
+            },
+            ADeadOp::Push {
+                src: Operand::Reg(Reg::RAX),
+            },
+            ADeadOp::Nop,
+            ADeadOp::Pop { dst: Reg::RAX },
+            ADeadOp::Pop { dst: Reg::RBX },
+            ADeadOp::Ret,
+        ];
+        let result = opt.optimize_ops(&ops);
+        assert_eq!(result, vec![ADeadOp::Ret]);
+
+        let stats = opt.stats();
+        assert_eq!(stats.iterations, 3);
+        assert_eq!(stats.original_ops - stats.optimized_ops, 5);
+        assert_eq!(stats.pass("nops").unwrap().ops_removed, 1);
+        let peephole = stats.pass("peephole").unwrap();
+        assert_eq!(peephole.ops_removed, 4);
+        assert_eq!(peephole.changed_runs, 2);
+        assert_eq!(peephole.runs, 3);
+        assert!(stats.pass("dead_code").is_none());
+    }
+
+    #[test]
+    fn test_optimize_keeps_label_counter() {
+        let mut ir = ADeadIR::new();
+        let l = ir.new_label();
+        ir.emit(ADeadOp::Nop);
+        ir.emit(ADeadOp::Label(l));
+        let mut opt = IsaOptimizer::new(IsaOptLevel::Basic);
+        let mut out = opt.optimize(&ir);
+        assert_eq!(out.len(), 1);
+        assert_ne!(out.new_label(), l);
+    }
+
+    #[test]
+    fn test_schedule_pass_with_tune() {
+        let ops = vec![
+            ADeadOp::Add {
+                dst: Operand::Reg(Reg::RBX),
+                src: Operand::Reg(Reg::RCX),
+            },
+            ADeadOp::Mov {
+                dst: Operand::Reg(Reg::RAX),
+                src: Operand::Mem { base: Reg::RBP, disp: -8 },
+            },
+            ADeadOp::CvtSi2Sd {
+                dst: Reg::XMM0,
+                src: Reg::RAX,
+            },
+        ];
+        let mut plain = IsaOptimizer::new(IsaOptLevel::Aggressive);
+        assert_eq!(plain.optimize_ops(&ops), ops);
+        assert!(plain.stats().pass("schedule").is_none());
+
+        let mut tuned = IsaOptimizer::new(IsaOptLevel::Aggressive).with_tune(Uarch::Zen3);
+        let result = tuned.optimize_ops(&ops);
+        // La carga sube delante del add; xorps rompe la dependencia de xmm0
+        assert_eq!(result[0], ops[1]);
+        assert_eq!(result[2], ADeadOp::RawBytes(vec![0x0F, 0x57, 0xC0]));
+        assert_eq!(tuned.stats().false_deps_broken, 1);
+        assert_eq!(tuned.stats().pass("schedule").unwrap().changed_runs, 1);
+    }
+
     #[test]
     fn test_roundtrip_reoptimize() {
         use super::super::encoder::Encoder;
@@ -0,0 +1,983 @@
+// ============================================================
+// ADead-BIB — Algoritmos paralelos sobre el pool de tareas
+// ============================================================
+// std::sort / reduce / transform / for_each con std::execution::par
+// o par_unseq (el frontend de C++ baja a adb_par_*), repartidos con
+// `TaskPool::ranges` (task_pool.rs):
+//
+//   - sort: merge sort estable. Cada trozo de CHUNK elementos se
+//     ordena entero en un worker (inserción en tramos de RUN y merges
+//     locales, todo en caché). Después, cada pasada global mezcla
+//     pares de tramos repartiendo la *salida*: cada trozo busca por
+//     bisección (merge path) dónde empieza dentro de cada mitad, así
+//     que hasta la última pasada, un solo par, corre en paralelo.
+//     Buffer auxiliar de n elementos en páginas propias
+//   - reduce: cada trozo suma lo suyo y lo añade al total con un
+//     `lock add`; par_unseq suma con vpaddd/vpaddq (AVX2) si el
+//     BitTarget usa ymm, si no igual que par
+//   - transform / for_each: trozos que llaman a fn por elemento
+//
+// Elementos enteros con signo de 4 u 8 bytes; el ancho sale del tipo
+// del puntero (isa_compiler.rs). sort ordena con <, reduce suma con +:
+// comparadores y operaciones propias no pasan por aquí.
+// ============================================================
+
+use super::slab_heap::{self, PageSource};
+use super::task_pool::TaskPool;
+use super::vex_emitter::{AvxInst, VexEmitter, VexMem};
+use super::ymm_allocator::YmmReg;
+use super::{ADeadIR, ADeadOp, CallTarget, Condition, Label, Operand, Reg};
+
+/// Anchos de elemento soportados, índice de las tablas de labels
+const WIDTHS: [i32; 2] = [4, 8];
+const SHIFTS: [u8; 2] = [2, 3];
+
+/// Tramo ordenado por inserción
+const RUN: i32 = 32;
+const RUN_BITS: u8 = 5;
+/// Trozo que un worker ordena solo: 8192 elementos
+const CHUNK_BITS: u8 = 13;
+const CHUNK: i32 = 1 << CHUNK_BITS;
+// Rondas locales pares: al acabar la fase local los datos siguen en su sitio
+const _: () = assert!((CHUNK_BITS - RUN_BITS) % 2 == 0);
+
+/// Trozo de las pasadas globales: n / 512, al menos MIN_GRAIN
+const GRAIN_SHIFT: u8 = 9;
+const MIN_GRAIN: i32 = 2048;
+
+// ---- Contexto de sort y merge (en la pila de quien llama) ----
+const SRC: i32 = 0;
+const DST: i32 = 8;
+const COUNT: i32 = 16;
+/// Largo de los tramos ya ordenados
+const SORTED: i32 = 24;
+
+// ---- Contexto de reduce ----
+const BASE: i32 = 0;
+const TOTAL: i32 = 8;
+
+// ---- Contexto de transform / for_each ----
+const INPUT: i32 = 0;
+const OUTPUT: i32 = 8;
+const FUNC: i32 = 16;
+
+// ---- Frame de merge ----
+const M_HI: i32 = 0;
+const M_NEXT: i32 = 8;
+const M_LEFT: i32 = 16;
+const M_OUT: i32 = 24;
+const M_FRAME: i32 = 32;
+
+/// Labels de las rutinas, por ancho de elemento (ver WIDTHS)
+#[derive(Debug, Clone, Copy)]
+pub struct ParAlgorithms {
+    ranges: Label,
+    pages: PageSource,
+    args: [Reg; 4],
+    avx2: bool,
+    /// adb_par_sort(first, last)
+    pub sort: [Label; 2],
+    /// adb_par_reduce(first, last, init) → init + Σ
+    pub reduce: [Label; 2],
+    /// adb_par_unseq_reduce(first, last, init): igual, con AVX2
+    pub reduce_unseq: [Label; 2],
+    /// adb_par_transform(first, last, out, fn) → out + n; [entrada][salida]
+    pub transform: [[Label; 2]; 2],
+    /// adb_par_for_each(first, last, fn, by_ref): fn(&x) o fn(x)
+    pub for_each: [Label; 2],
+    sort_chunks: [Label; 2],
+    merge: [Label; 2],
+    insertion: [Label; 2],
+    copy: [Label; 2],
+    sum: [Label; 2],
+    sum_avx: [Label; 2],
+    apply: [[Label; 2]; 2],
+    visit_ref: [Label; 2],
+    visit_val: [Label; 2],
+    map: Label,
+    unmap: Label,
+}
+
+fn mov(ir: &mut ADeadIR, dst: Reg, src: Operand) {
+    ir.emit(ADeadOp::Mov { dst: Operand::Reg(dst), src });
+}
+
+fn mem(base: Reg, disp: i32) -> Operand {
+    Operand::Mem { base, disp }
+}
+
+fn store(ir: &mut ADeadIR, base: Reg, disp: i32, src: Reg) {
+    ir.emit(ADeadOp::Mov { dst: mem(base, disp), src: Operand::Reg(src) });
+}
+
+fn jcc(ir: &mut ADeadIR, cond: Condition, target: Label) {
+    ir.emit(ADeadOp::Jcc { cond, target });
+}
+
+fn call(ir: &mut ADeadIR, target: Label) {
+    ir.emit(ADeadOp::Call { target: CallTarget::Relative(target) });
+}
+
+fn push(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Push { src: Operand::Reg(reg) });
+}
+
+fn pop(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Pop { dst: reg });
+}
+
+fn add_imm(ir: &mut ADeadIR, reg: Reg, imm: i32) {
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(reg), src: Operand::Imm32(imm) });
+}
+
+fn zero(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Xor { dst: reg, src: reg });
+}
+
+/// dst = mínimo(dst, src) con signo
+fn min_into(ir: &mut ADeadIR, dst: Reg, src: Operand) {
+    let ok = ir.new_label();
+    ir.emit(ADeadOp::Cmp { left: Operand::Reg(dst), right: src.clone() });
+    jcc(ir, Condition::LessEq, ok);
+    mov(ir, dst, src);
+    ir.emit(ADeadOp::Label(ok));
+}
+
+/// reg = reg × ancho + base
+fn index_to_ptr(ir: &mut ADeadIR, reg: Reg, shift: u8, base: Operand) {
+    ir.emit(ADeadOp::Shl { dst: reg, amount: shift });
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(reg), src: base });
+}
+
+/// Elemento con signo extendido a 64 bits
+fn load_elem(ir: &mut ADeadIR, dst: Reg, base: Reg, disp: i32, width: i32) {
+    if width == 8 {
+        mov(ir, dst, mem(base, disp));
+    } else {
+        ir.emit(ADeadOp::Load32 { dst, base, disp });
+        ir.emit(ADeadOp::Shl { dst, amount: 32 });
+        ir.emit(ADeadOp::Sar { dst, amount: 32 });
+    }
+}
+
+fn store_elem(ir: &mut ADeadIR, base: Reg, disp: i32, src: Reg, width: i32) {
+    if width == 8 {
+        store(ir, base, disp, src);
+    } else {
+        ir.emit(ADeadOp::Store32 { base, disp, src });
+    }
+}
+
+fn width_index(width: u8) -> Option<usize> {
+    WIDTHS.iter().position(|&w| w == width as i32)
+}
+
+fn emit_avx(ir: &mut ADeadIR, insts: &[AvxInst]) {
+    let mut vex = VexEmitter::new();
+    vex.emit_all(insts);
+    ir.emit(ADeadOp::RawBytes(vex.into_bytes()));
+}
+
+impl ParAlgorithms {
+    /// `windows`: argumentos en RCX/RDX/R8/R9, si no RDI/RSI/RDX/RCX;
+    /// `avx2`: par_unseq puede usar ymm
+    pub fn new(ir: &mut ADeadIR, pool: &TaskPool, pages: PageSource, windows: bool, avx2: bool) -> Self {
+        let mut pair = || [ir.new_label(), ir.new_label()];
+        let sort = pair();
+        let reduce = pair();
+        let reduce_unseq = pair();
+        let transform = [pair(), pair()];
+        let for_each = pair();
+        let sort_chunks = pair();
+        let merge = pair();
+        let insertion = pair();
+        let copy = pair();
+        let sum = pair();
+        let sum_avx = pair();
+        let apply = [pair(), pair()];
+        let visit_ref = pair();
+        let visit_val = pair();
+        let [map, unmap] = pair();
+        Self {
+            ranges: pool.ranges,
+            pages,
+            args: if windows {
+                [Reg::RCX, Reg::RDX, Reg::R8, Reg::R9]
+            } else {
+                [Reg::RDI, Reg::RSI, Reg::RDX, Reg::RCX]
+            },
+            avx2,
+            sort,
+            reduce,
+            reduce_unseq,
+            transform,
+            for_each,
+            sort_chunks,
+            merge,
+            insertion,
+            copy,
+            sum,
+            sum_avx,
+            apply,
+            visit_ref,
+            visit_val,
+            map,
+            unmap,
+        }
+    }
+
+    /// Rutina para una llamada de C/C++ con iteradores de `in_width`
+    /// (y `out_width` para la salida de transform) bytes por elemento
+    pub fn routine(&self, name: &str, in_width: u8, out_width: u8) -> Option<Label> {
+        let k = width_index(in_width)?;
+        match name {
+            "adb_par_sort" => Some(self.sort[k]),
+            "adb_par_reduce" => Some(self.reduce[k]),
+            "adb_par_unseq_reduce" => Some(self.reduce_unseq[k]),
+            "adb_par_transform" => Some(self.transform[k][width_index(out_width)?]),
+            "adb_par_for_each" => Some(self.for_each[k]),
+            _ => None,
+        }
+    }
+
+    pub fn emit_routines(&self, ir: &mut ADeadIR) {
+        slab_heap::emit_page_map(ir, self.map, self.pages);
+        slab_heap::emit_page_unmap(ir, self.unmap, self.pages);
+        for k in 0..WIDTHS.len() {
+            self.emit_sort(ir, k);
+            self.emit_sort_chunks(ir, k);
+            self.emit_merge(ir, k);
+            self.emit_insertion(ir, k);
+            self.emit_copy(ir, k);
+            self.emit_reduce(ir, self.reduce[k], self.sum[k], k);
+            self.emit_sum(ir, k);
+            if self.avx2 {
+                self.emit_reduce(ir, self.reduce_unseq[k], self.sum_avx[k], k);
+                self.emit_sum_avx(ir, k);
+            } else {
+                self.emit_reduce(ir, self.reduce_unseq[k], self.sum[k], k);
+            }
+            for out in 0..WIDTHS.len() {
+                self.emit_transform(ir, k, out);
+                self.emit_apply(ir, k, out);
+            }
+            self.emit_for_each(ir, k);
+            self.emit_visit(ir, self.visit_ref[k], k, true);
+            self.emit_visit(ir, self.visit_val[k], k, false);
+        }
+    }
+
+    // ---- Entradas desde C: la pila puede venir sin alinear ----
+
+    /// Guarda RBX, R12-R15, RSI, RDI y alinea RSP a 16
+    fn enter(ir: &mut ADeadIR) {
+        push(ir, Reg::RBP);
+        mov(ir, Reg::RBP, Operand::Reg(Reg::RSP));
+        for reg in [Reg::RBX, Reg::R12, Reg::R13, Reg::R14, Reg::R15, Reg::RSI, Reg::RDI] {
+            push(ir, reg);
+        }
+        mov(ir, Reg::RAX, Operand::Imm32(-16));
+        ir.emit(ADeadOp::And { dst: Reg::RSP, src: Reg::RAX });
+    }
+
+    fn leave(ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Lea { dst: Reg::RSP, src: mem(Reg::RBP, -56) });
+        for reg in [Reg::RDI, Reg::RSI, Reg::R15, Reg::R14, Reg::R13, Reg::R12, Reg::RBX] {
+            pop(ir, reg);
+        }
+        pop(ir, Reg::RBP);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// RCX = 0, RDX = R13 (n), R8 = grain, R9 = cuerpo, R10 = RSP (ctx)
+    fn fork(&self, ir: &mut ADeadIR, body: Label, grain: Option<()>) {
+        zero(ir, Reg::RCX);
+        mov(ir, Reg::RDX, Operand::Reg(Reg::R13));
+        match grain {
+            // max(n >> GRAIN_SHIFT, MIN_GRAIN): pocas bisecciones por trozo
+            Some(()) => {
+                let ok = ir.new_label();
+                mov(ir, Reg::R8, Operand::Reg(Reg::R13));
+                ir.emit(ADeadOp::Shr { dst: Reg::R8, amount: GRAIN_SHIFT });
+                ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R8), right: Operand::Imm32(MIN_GRAIN) });
+                jcc(ir, Condition::GreaterEq, ok);
+                mov(ir, Reg::R8, Operand::Imm32(MIN_GRAIN));
+                ir.emit(ADeadOp::Label(ok));
+            }
+            None => zero(ir, Reg::R8),
+        }
+        ir.emit(ADeadOp::LeaLabel { dst: Reg::R9, label: body });
+        mov(ir, Reg::R10, Operand::Reg(Reg::RSP));
+        call(ir, self.ranges);
+    }
+
+    /// R13 = (args[1] - args[0]) / ancho
+    fn count(&self, ir: &mut ADeadIR, k: usize) {
+        mov(ir, Reg::R13, Operand::Reg(self.args[1]));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::R13), src: Operand::Reg(self.args[0]) });
+        ir.emit(ADeadOp::Sar { dst: Reg::R13, amount: SHIFTS[k] });
+    }
+
+    // ========================================
+    // sort
+    // ========================================
+
+    fn emit_sort(&self, ir: &mut ADeadIR, k: usize) {
+        let shift = SHIFTS[k];
+        let pass = ir.new_label();
+        let passes_done = ir.new_label();
+        let release = ir.new_label();
+        let fallback = ir.new_label();
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.sort[k]));
+        Self::enter(ir);
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(32) });
+        self.count(ir, k);
+        mov(ir, Reg::R12, Operand::Reg(self.args[0]));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R13), right: Operand::Imm32(2) });
+        jcc(ir, Condition::Less, out);
+        mov(ir, Reg::R14, Operand::Reg(Reg::R13));
+        ir.emit(ADeadOp::Shl { dst: Reg::R14, amount: shift });
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R14));
+        call(ir, self.map);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, fallback);
+        mov(ir, Reg::R15, Operand::Reg(Reg::RAX));
+        store(ir, Reg::RSP, SRC, Reg::R12);
+        store(ir, Reg::RSP, DST, Reg::R15);
+        store(ir, Reg::RSP, COUNT, Reg::R13);
+
+        // Fase local: un trozo de CHUNK por tarea
+        zero(ir, Reg::RCX);
+        mov(ir, Reg::RDX, Operand::Reg(Reg::R13));
+        add_imm(ir, Reg::RDX, CHUNK - 1);
+        ir.emit(ADeadOp::Shr { dst: Reg::RDX, amount: CHUNK_BITS });
+        mov(ir, Reg::R8, Operand::Imm32(1));
+        ir.emit(ADeadOp::LeaLabel { dst: Reg::R9, label: self.sort_chunks[k] });
+        mov(ir, Reg::R10, Operand::Reg(Reg::RSP));
+        call(ir, self.ranges);
+
+        // Pasadas globales: tramos de CHUNK, 2·CHUNK, ... hasta n
+        mov(ir, Reg::RAX, Operand::Imm32(CHUNK));
+        store(ir, Reg::RSP, SORTED, Reg::RAX);
+        ir.emit(ADeadOp::Label(pass));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R13), right: mem(Reg::RSP, SORTED) });
+        jcc(ir, Condition::LessEq, passes_done);
+        self.fork(ir, self.merge[k], Some(()));
+        mov(ir, Reg::RAX, mem(Reg::RSP, SRC));
+        mov(ir, Reg::RCX, mem(Reg::RSP, DST));
+        store(ir, Reg::RSP, SRC, Reg::RCX);
+        store(ir, Reg::RSP, DST, Reg::RAX);
+        mov(ir, Reg::RAX, mem(Reg::RSP, SORTED));
+        ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: 1 });
+        store(ir, Reg::RSP, SORTED, Reg::RAX);
+        ir.emit(ADeadOp::Jmp { target: pass });
+
+        // Si la última pasada dejó el resultado en el buffer, de vuelta
+        ir.emit(ADeadOp::Label(passes_done));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R12), right: mem(Reg::RSP, SRC) });
+        jcc(ir, Condition::Equal, release);
+        self.fork(ir, self.copy[k], Some(()));
+        ir.emit(ADeadOp::Label(release));
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R15));
+        mov(ir, Reg::RDX, Operand::Reg(Reg::R14));
+        call(ir, self.unmap);
+        ir.emit(ADeadOp::Jmp { target: out });
+
+        // Sin páginas para el buffer: inserción sobre todo (lento, correcto)
+        ir.emit(ADeadOp::Label(fallback));
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R12));
+        mov(ir, Reg::RDX, Operand::Reg(Reg::R12));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RDX), src: Operand::Reg(Reg::R14) });
+        mov(ir, Reg::R8, Operand::Reg(Reg::R14));
+        call(ir, self.insertion[k]);
+        ir.emit(ADeadOp::Label(out));
+        zero(ir, Reg::RAX);
+        Self::leave(ir);
+    }
+
+    /// Cuerpo de la fase local: RCX..RDX = trozos, R8 = ctx de sort.
+    /// Cada trozo queda ordenado en su sitio (rondas pares)
+    fn emit_sort_chunks(&self, ir: &mut ADeadIR, k: usize) {
+        let shift = SHIFTS[k];
+        let chunk = ir.new_label();
+        let round = ir.new_label();
+        let next = ir.new_label();
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(self.sort_chunks[k]));
+        for reg in [Reg::RBX, Reg::R12, Reg::R13, Reg::R14, Reg::R15] {
+            push(ir, reg);
+        }
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(32) });
+        mov(ir, Reg::R12, Operand::Reg(Reg::RCX));
+        mov(ir, Reg::R13, Operand::Reg(Reg::RDX));
+        mov(ir, Reg::R14, Operand::Reg(Reg::R8));
+        ir.emit(ADeadOp::Label(chunk));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R12), right: Operand::Reg(Reg::R13) });
+        jcc(ir, Condition::GreaterEq, done);
+        // [R15, RBX) = elementos del trozo
+        mov(ir, Reg::R15, Operand::Reg(Reg::R12));
+        ir.emit(ADeadOp::Shl { dst: Reg::R15, amount: CHUNK_BITS });
+        mov(ir, Reg::RBX, Operand::Reg(Reg::R15));
+        add_imm(ir, Reg::RBX, CHUNK);
+        min_into(ir, Reg::RBX, mem(Reg::R14, COUNT));
+
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R15));
+        index_to_ptr(ir, Reg::RCX, shift, mem(Reg::R14, SRC));
+        mov(ir, Reg::RDX, Operand::Reg(Reg::RBX));
+        index_to_ptr(ir, Reg::RDX, shift, mem(Reg::R14, SRC));
+        mov(ir, Reg::R8, Operand::Imm32(RUN * WIDTHS[k]));
+        call(ir, self.insertion[k]);
+
+        // Merges locales con un ctx propio: RUN, 2·RUN, ... hasta CHUNK
+        for disp in [SRC, DST, COUNT] {
+            mov(ir, Reg::RAX, mem(Reg::R14, disp));
+            store(ir, Reg::RSP, disp, Reg::RAX);
+        }
+        mov(ir, Reg::RAX, Operand::Imm32(RUN));
+        store(ir, Reg::RSP, SORTED, Reg::RAX);
+        ir.emit(ADeadOp::Label(round));
+        ir.emit(ADeadOp::Cmp { left: mem(Reg::RSP, SORTED), right: Operand::Imm32(CHUNK) });
+        jcc(ir, Condition::GreaterEq, next);
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R15));
+        mov(ir, Reg::RDX, Operand::Reg(Reg::RBX));
+        mov(ir, Reg::R8, Operand::Reg(Reg::RSP));
+        call(ir, self.merge[k]);
+        mov(ir, Reg::RAX, mem(Reg::RSP, SRC));
+        mov(ir, Reg::RCX, mem(Reg::RSP, DST));
+        store(ir, Reg::RSP, SRC, Reg::RCX);
+        store(ir, Reg::RSP, DST, Reg::RAX);
+        mov(ir, Reg::RAX, mem(Reg::RSP, SORTED));
+        ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: 1 });
+        store(ir, Reg::RSP, SORTED, Reg::RAX);
+        ir.emit(ADeadOp::Jmp { target: round });
+        ir.emit(ADeadOp::Label(next));
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R12) });
+        ir.emit(ADeadOp::Jmp { target: chunk });
+
+        ir.emit(ADeadOp::Label(done));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(32) });
+        for reg in [Reg::R15, Reg::R14, Reg::R13, Reg::R12, Reg::RBX] {
+            pop(ir, reg);
+        }
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// RCX = lo, RDX = hi (índices de salida), R8 = ctx {SRC, DST,
+    /// COUNT, SORTED}. Escribe DST[lo, hi) mezclando los pares de tramos
+    /// de SORTED elementos de SRC que caen ahí; en empate gana el tramo
+    /// izquierdo (estable). Conserva RBX y R12-R15
+    fn emit_merge(&self, ir: &mut ADeadIR, k: usize) {
+        let width = WIDTHS[k];
+        let shift = SHIFTS[k];
+        let pair = ir.new_label();
+        let search = ir.new_label();
+        let go_left = ir.new_label();
+        let found = ir.new_label();
+        let step = ir.new_label();
+        let take_right = ir.new_label();
+        let advance = ir.new_label();
+        let rest_left = ir.new_label();
+        let rest_right = ir.new_label();
+        let rest = ir.new_label();
+        let lo_ok = ir.new_label();
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.merge[k]));
+        for reg in [Reg::RBX, Reg::R12, Reg::R13, Reg::R14, Reg::R15] {
+            push(ir, reg);
+        }
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(M_FRAME as i8) });
+        store(ir, Reg::RSP, M_HI, Reg::RDX);
+        store(ir, Reg::RSP, M_NEXT, Reg::RCX);
+        mov(ir, Reg::RBX, Operand::Reg(Reg::R8));
+
+        ir.emit(ADeadOp::Label(pair));
+        mov(ir, Reg::RCX, mem(Reg::RSP, M_NEXT));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: mem(Reg::RSP, M_HI) });
+        jcc(ir, Condition::GreaterEq, out);
+        // R15 = s (inicio del par), R14 = k0 (posición de salida dentro del par)
+        mov(ir, Reg::RAX, mem(Reg::RBX, SORTED));
+        ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: 1 });
+        ir.emit(ADeadOp::Dec { dst: Operand::Reg(Reg::RAX) });
+        mov(ir, Reg::R14, Operand::Reg(Reg::RCX));
+        ir.emit(ADeadOp::And { dst: Reg::R14, src: Reg::RAX });
+        mov(ir, Reg::R15, Operand::Reg(Reg::RCX));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::R15), src: Operand::Reg(Reg::R14) });
+        // R12 = largo del tramo izquierdo, R13 = del derecho
+        mov(ir, Reg::R12, mem(Reg::RBX, COUNT));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::R12), src: Operand::Reg(Reg::R15) });
+        min_into(ir, Reg::R12, mem(Reg::RBX, SORTED));
+        mov(ir, Reg::R13, mem(Reg::RBX, COUNT));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::R13), src: Operand::Reg(Reg::R15) });
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::R13), src: Operand::Reg(Reg::R12) });
+        min_into(ir, Reg::R13, mem(Reg::RBX, SORTED));
+        // k1 = min(fin del par, hi - s); el próximo par empieza en s + k1
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R12));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::R13) });
+        mov(ir, Reg::RDX, mem(Reg::RSP, M_HI));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RDX), src: Operand::Reg(Reg::R15) });
+        min_into(ir, Reg::RAX, Operand::Reg(Reg::RDX));
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RAX));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RCX), src: Operand::Reg(Reg::R15) });
+        store(ir, Reg::RSP, M_NEXT, Reg::RCX);
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::R14) });
+        store(ir, Reg::RSP, M_LEFT, Reg::RAX);
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R15));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::R14) });
+        index_to_ptr(ir, Reg::RAX, shift, mem(Reg::RBX, DST));
+        store(ir, Reg::RSP, M_OUT, Reg::RAX);
+        // R10 = tramo izquierdo, R11 = derecho
+        mov(ir, Reg::R10, Operand::Reg(Reg::R15));
+        index_to_ptr(ir, Reg::R10, shift, mem(Reg::RBX, SRC));
+        mov(ir, Reg::R11, Operand::Reg(Reg::R12));
+        index_to_ptr(ir, Reg::R11, shift, Operand::Reg(Reg::R10));
+
+        // Merge path: i0 = menor i en [max(0, k0 - der), min(k0, izq)]
+        // con izq[i] > der[k0 - i - 1]; j0 = k0 - i0
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R14));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::R13) });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(0) });
+        jcc(ir, Condition::GreaterEq, lo_ok);
+        zero(ir, Reg::RAX);
+        ir.emit(ADeadOp::Label(lo_ok));
+        mov(ir, Reg::RDX, Operand::Reg(Reg::R14));
+        min_into(ir, Reg::RDX, Operand::Reg(Reg::R12));
+        ir.emit(ADeadOp::Label(search));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Reg(Reg::RDX) });
+        jcc(ir, Condition::GreaterEq, found);
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RAX));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RCX), src: Operand::Reg(Reg::RDX) });
+        ir.emit(ADeadOp::Shr { dst: Reg::RCX, amount: 1 });
+        mov(ir, Reg::RSI, Operand::Reg(Reg::RCX));
+        index_to_ptr(ir, Reg::RSI, shift, Operand::Reg(Reg::R10));
+        load_elem(ir, Reg::R8, Reg::RSI, 0, width);
+        mov(ir, Reg::RDI, Operand::Reg(Reg::R14));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RDI), src: Operand::Reg(Reg::RCX) });
+        index_to_ptr(ir, Reg::RDI, shift, Operand::Reg(Reg::R11));
+        load_elem(ir, Reg::R9, Reg::RDI, -width, width);
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R8), right: Operand::Reg(Reg::R9) });
+        jcc(ir, Condition::Greater, go_left);
+        ir.emit(ADeadOp::Lea { dst: Reg::RAX, src: mem(Reg::RCX, 1) });
+        ir.emit(ADeadOp::Jmp { target: search });
+        ir.emit(ADeadOp::Label(go_left));
+        mov(ir, Reg::RDX, Operand::Reg(Reg::RCX));
+        ir.emit(ADeadOp::Jmp { target: search });
+
+        // Cursores R10/R11 hasta R12/R13; R15 = salida, R14 = cuántos
+        ir.emit(ADeadOp::Label(found));
+        mov(ir, Reg::R12, Operand::Reg(Reg::R11));
+        index_to_ptr(ir, Reg::R13, shift, Operand::Reg(Reg::R11));
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R14));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RCX), src: Operand::Reg(Reg::RAX) });
+        ir.emit(ADeadOp::Shl { dst: Reg::RCX, amount: shift });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::R11), src: Operand::Reg(Reg::RCX) });
+        index_to_ptr(ir, Reg::RAX, shift, Operand::Reg(Reg::R10));
+        mov(ir, Reg::R10, Operand::Reg(Reg::RAX));
+        mov(ir, Reg::R14, mem(Reg::RSP, M_LEFT));
+        mov(ir, Reg::R15, mem(Reg::RSP, M_OUT));
+        ir.emit(ADeadOp::Test { left: Reg::R14, right: Reg::R14 });
+        jcc(ir, Condition::Equal, pair);
+        ir.emit(ADeadOp::Label(step));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R10), right: Operand::Reg(Reg::R12) });
+        jcc(ir, Condition::AboveEq, rest_right);
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R11), right: Operand::Reg(Reg::R13) });
+        jcc(ir, Condition::AboveEq, rest_left);
+        load_elem(ir, Reg::RAX, Reg::R10, 0, width);
+        load_elem(ir, Reg::RDX, Reg::R11, 0, width);
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Reg(Reg::RDX) });
+        jcc(ir, Condition::Greater, take_right);
+        store_elem(ir, Reg::R15, 0, Reg::RAX, width);
+        add_imm(ir, Reg::R10, width);
+        ir.emit(ADeadOp::Jmp { target: advance });
+        ir.emit(ADeadOp::Label(take_right));
+        store_elem(ir, Reg::R15, 0, Reg::RDX, width);
+        add_imm(ir, Reg::R11, width);
+        ir.emit(ADeadOp::Label(advance));
+        add_imm(ir, Reg::R15, width);
+        ir.emit(ADeadOp::Dec { dst: Operand::Reg(Reg::R14) });
+        jcc(ir, Condition::NotEqual, step);
+        ir.emit(ADeadOp::Jmp { target: pair });
+
+        // Un tramo agotado: lo que queda del otro va seguido
+        ir.emit(ADeadOp::Label(rest_left));
+        mov(ir, Reg::RSI, Operand::Reg(Reg::R10));
+        ir.emit(ADeadOp::Jmp { target: rest });
+        ir.emit(ADeadOp::Label(rest_right));
+        mov(ir, Reg::RSI, Operand::Reg(Reg::R11));
+        ir.emit(ADeadOp::Label(rest));
+        mov(ir, Reg::RDI, Operand::Reg(Reg::R15));
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R14));
+        ir.emit(ADeadOp::Shl { dst: Reg::RCX, amount: shift });
+        ir.emit(ADeadOp::Cld);
+        ir.emit(ADeadOp::Rep { op: Box::new(ADeadOp::Movsb) });
+        ir.emit(ADeadOp::Jmp { target: pair });
+
+        ir.emit(ADeadOp::Label(out));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(M_FRAME as i8) });
+        for reg in [Reg::R15, Reg::R14, Reg::R13, Reg::R12, Reg::RBX] {
+            pop(ir, reg);
+        }
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// RCX = inicio, RDX = fin (punteros), R8 = bytes por tramo: ordena
+    /// cada tramo por inserción. Solo registros volátiles
+    fn emit_insertion(&self, ir: &mut ADeadIR, k: usize) {
+        let width = WIDTHS[k];
+        let run = ir.new_label();
+        let outer = ir.new_label();
+        let inner = ir.new_label();
+        let place = ir.new_label();
+        let run_done = ir.new_label();
+        let full = ir.new_label();
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.insertion[k]));
+        mov(ir, Reg::R10, Operand::Reg(Reg::RCX));
+        mov(ir, Reg::R9, Operand::Reg(Reg::RDX));
+        ir.emit(ADeadOp::Label(run));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R10), right: Operand::Reg(Reg::R9) });
+        jcc(ir, Condition::AboveEq, out);
+        mov(ir, Reg::R11, Operand::Reg(Reg::R10));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::R11), src: Operand::Reg(Reg::R8) });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R11), right: Operand::Reg(Reg::R9) });
+        jcc(ir, Condition::BelowEq, full);
+        mov(ir, Reg::R11, Operand::Reg(Reg::R9));
+        ir.emit(ADeadOp::Label(full));
+        ir.emit(ADeadOp::Lea { dst: Reg::RSI, src: mem(Reg::R10, width) });
+        ir.emit(ADeadOp::Label(outer));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RSI), right: Operand::Reg(Reg::R11) });
+        jcc(ir, Condition::AboveEq, run_done);
+        load_elem(ir, Reg::RAX, Reg::RSI, 0, width);
+        mov(ir, Reg::RDI, Operand::Reg(Reg::RSI));
+        ir.emit(ADeadOp::Label(inner));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RDI), right: Operand::Reg(Reg::R10) });
+        jcc(ir, Condition::BelowEq, place);
+        load_elem(ir, Reg::RDX, Reg::RDI, -width, width);
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RDX), right: Operand::Reg(Reg::RAX) });
+        jcc(ir, Condition::LessEq, place);
+        store_elem(ir, Reg::RDI, 0, Reg::RDX, width);
+        add_imm(ir, Reg::RDI, -width);
+        ir.emit(ADeadOp::Jmp { target: inner });
+        ir.emit(ADeadOp::Label(place));
+        store_elem(ir, Reg::RDI, 0, Reg::RAX, width);
+        add_imm(ir, Reg::RSI, width);
+        ir.emit(ADeadOp::Jmp { target: outer });
+        ir.emit(ADeadOp::Label(run_done));
+        mov(ir, Reg::R10, Operand::Reg(Reg::R11));
+        ir.emit(ADeadOp::Jmp { target: run });
+        ir.emit(ADeadOp::Label(out));
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// Cuerpo: copia SRC[lo, hi) → DST[lo, hi)
+    fn emit_copy(&self, ir: &mut ADeadIR, k: usize) {
+        let shift = SHIFTS[k];
+        ir.emit(ADeadOp::Label(self.copy[k]));
+        mov(ir, Reg::RAX, Operand::Reg(Reg::RDX));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RCX) });
+        ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: shift });
+        ir.emit(ADeadOp::Shl { dst: Reg::RCX, amount: shift });
+        mov(ir, Reg::RSI, mem(Reg::R8, SRC));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSI), src: Operand::Reg(Reg::RCX) });
+        mov(ir, Reg::RDI, mem(Reg::R8, DST));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RDI), src: Operand::Reg(Reg::RCX) });
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RAX));
+        ir.emit(ADeadOp::Cld);
+        ir.emit(ADeadOp::Rep { op: Box::new(ADeadOp::Movsb) });
+        ir.emit(ADeadOp::Ret);
+    }
+
+    // ========================================
+    // reduce
+    // ========================================
+
+    fn emit_reduce(&self, ir: &mut ADeadIR, label: Label, body: Label, k: usize) {
+        ir.emit(ADeadOp::Label(label));
+        Self::enter(ir);
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(32) });
+        mov(ir, Reg::R14, Operand::Reg(self.args[2]));
+        self.count(ir, k);
+        mov(ir, Reg::RAX, Operand::Reg(self.args[0]));
+        store(ir, Reg::RSP, BASE, Reg::RAX);
+        zero(ir, Reg::RAX);
+        store(ir, Reg::RSP, TOTAL, Reg::RAX);
+        self.fork(ir, body, Some(()));
+        mov(ir, Reg::RAX, mem(Reg::RSP, TOTAL));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::R14) });
+        if WIDTHS[k] == 4 {
+            // int: el total da la vuelta en 32 bits, como la suma serial
+            ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: 32 });
+            ir.emit(ADeadOp::Sar { dst: Reg::RAX, amount: 32 });
+        }
+        Self::leave(ir);
+    }
+
+    /// RSI/RDI = [lo, hi) de BASE en R8
+    fn range_pointers(ir: &mut ADeadIR, shift: u8) {
+        mov(ir, Reg::RSI, Operand::Reg(Reg::RCX));
+        index_to_ptr(ir, Reg::RSI, shift, mem(Reg::R8, BASE));
+        mov(ir, Reg::RDI, Operand::Reg(Reg::RDX));
+        index_to_ptr(ir, Reg::RDI, shift, mem(Reg::R8, BASE));
+    }
+
+    /// lock add [r8 + TOTAL], rax
+    fn add_partial(ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::RawBytes(vec![0xF0, 0x49, 0x01, 0x40, TOTAL as u8]));
+    }
+
+    /// Bucle escalar RSI..RDI sumando en RAX
+    fn scalar_sum(ir: &mut ADeadIR, width: i32) {
+        let top = ir.new_label();
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(top));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RSI), right: Operand::Reg(Reg::RDI) });
+        jcc(ir, Condition::AboveEq, done);
+        load_elem(ir, Reg::RDX, Reg::RSI, 0, width);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RDX) });
+        add_imm(ir, Reg::RSI, width);
+        ir.emit(ADeadOp::Jmp { target: top });
+        ir.emit(ADeadOp::Label(done));
+    }
+
+    fn emit_sum(&self, ir: &mut ADeadIR, k: usize) {
+        ir.emit(ADeadOp::Label(self.sum[k]));
+        Self::range_pointers(ir, SHIFTS[k]);
+        zero(ir, Reg::RAX);
+        Self::scalar_sum(ir, WIDTHS[k]);
+        Self::add_partial(ir);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// 32 bytes por vuelta en ymm0 (los carriles dan la vuelta igual
+    /// que la suma escalar), suma horizontal por la pila y el resto escalar
+    fn emit_sum_avx(&self, ir: &mut ADeadIR, k: usize) {
+        let width = WIDTHS[k];
+        let vloop = ir.new_label();
+        let vdone = ir.new_label();
+        let acc = YmmReg(0);
+        let data = YmmReg(1);
+        ir.emit(ADeadOp::Label(self.sum_avx[k]));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+        Self::range_pointers(ir, SHIFTS[k]);
+        emit_avx(ir, &[AvxInst::Vpxor { dst: acc, src1: acc, src2: acc }]);
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RDI));
+        add_imm(ir, Reg::RCX, -32);
+        ir.emit(ADeadOp::Label(vloop));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RSI), right: Operand::Reg(Reg::RCX) });
+        jcc(ir, Condition::Above, vdone);
+        emit_avx(ir, &[
+            AvxInst::VmovdquLoad { dst: data, mem: VexMem::base(6, 0) },
+            AvxInst::Vpadd { lane: width as u8, dst: acc, src1: acc, src2: data },
+        ]);
+        add_imm(ir, Reg::RSI, 32);
+        ir.emit(ADeadOp::Jmp { target: vloop });
+        ir.emit(ADeadOp::Label(vdone));
+        emit_avx(ir, &[AvxInst::VmovdquStore { src: acc, mem: VexMem::base(4, 0) }, AvxInst::Vzeroupper]);
+        zero(ir, Reg::RAX);
+        for lane in 0..32 / width {
+            load_elem(ir, Reg::RDX, Reg::RSP, lane * width, width);
+            ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RDX) });
+        }
+        Self::scalar_sum(ir, width);
+        Self::add_partial(ir);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+        ir.emit(ADeadOp::Ret);
+    }
+
+    // ========================================
+    // transform / for_each
+    // ========================================
+
+    fn emit_transform(&self, ir: &mut ADeadIR, k: usize, out: usize) {
+        ir.emit(ADeadOp::Label(self.transform[k][out]));
+        Self::enter(ir);
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(32) });
+        // En Linux args[3] es RCX: guardar fn y out antes de nada
+        mov(ir, Reg::R15, Operand::Reg(self.args[3]));
+        mov(ir, Reg::R14, Operand::Reg(self.args[2]));
+        self.count(ir, k);
+        mov(ir, Reg::RAX, Operand::Reg(self.args[0]));
+        store(ir, Reg::RSP, INPUT, Reg::RAX);
+        store(ir, Reg::RSP, OUTPUT, Reg::R14);
+        store(ir, Reg::RSP, FUNC, Reg::R15);
+        self.fork(ir, self.apply[k][out], None);
+        // Devuelve el final de la salida
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R13));
+        index_to_ptr(ir, Reg::RAX, SHIFTS[out], Operand::Reg(Reg::R14));
+        Self::leave(ir);
+    }
+
+    /// Cuerpo: OUTPUT[i] = fn(INPUT[i]) para i en [lo, hi)
+    fn emit_apply(&self, ir: &mut ADeadIR, k: usize, out: usize) {
+        let top = ir.new_label();
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(self.apply[k][out]));
+        for reg in [Reg::R12, Reg::R13, Reg::R14, Reg::R15] {
+            push(ir, reg);
+        }
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+        mov(ir, Reg::R14, Operand::Reg(Reg::RCX));
+        index_to_ptr(ir, Reg::R14, SHIFTS[out], mem(Reg::R8, OUTPUT));
+        mov(ir, Reg::R12, Operand::Reg(Reg::RCX));
+        index_to_ptr(ir, Reg::R12, SHIFTS[k], mem(Reg::R8, INPUT));
+        mov(ir, Reg::R13, Operand::Reg(Reg::RDX));
+        index_to_ptr(ir, Reg::R13, SHIFTS[k], mem(Reg::R8, INPUT));
+        mov(ir, Reg::R15, mem(Reg::R8, FUNC));
+        ir.emit(ADeadOp::Label(top));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R12), right: Operand::Reg(Reg::R13) });
+        jcc(ir, Condition::AboveEq, done);
+        load_elem(ir, self.args[0], Reg::R12, 0, WIDTHS[k]);
+        ir.emit(ADeadOp::Call { target: CallTarget::Register(Reg::R15) });
+        store_elem(ir, Reg::R14, 0, Reg::RAX, WIDTHS[out]);
+        add_imm(ir, Reg::R12, WIDTHS[k]);
+        add_imm(ir, Reg::R14, WIDTHS[out]);
+        ir.emit(ADeadOp::Jmp { target: top });
+        ir.emit(ADeadOp::Label(done));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+        for reg in [Reg::R15, Reg::R14, Reg::R13, Reg::R12] {
+            pop(ir, reg);
+        }
+        ir.emit(ADeadOp::Ret);
+    }
+
+    fn emit_for_each(&self, ir: &mut ADeadIR, k: usize) {
+        let by_ref = ir.new_label();
+        ir.emit(ADeadOp::Label(self.for_each[k]));
+        Self::enter(ir);
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(32) });
+        mov(ir, Reg::R15, Operand::Reg(self.args[3]));
+        mov(ir, Reg::R14, Operand::Reg(self.args[2]));
+        self.count(ir, k);
+        mov(ir, Reg::RAX, Operand::Reg(self.args[0]));
+        store(ir, Reg::RSP, INPUT, Reg::RAX);
+        store(ir, Reg::RSP, FUNC, Reg::R14);
+        // fn(T&) recibe la dirección; fn(T), el valor
+        ir.emit(ADeadOp::LeaLabel { dst: Reg::R12, label: self.visit_ref[k] });
+        ir.emit(ADeadOp::Test { left: Reg::R15, right: Reg::R15 });
+        jcc(ir, Condition::NotEqual, by_ref);
+        ir.emit(ADeadOp::LeaLabel { dst: Reg::R12, label: self.visit_val[k] });
+        ir.emit(ADeadOp::Label(by_ref));
+        zero(ir, Reg::RCX);
+        mov(ir, Reg::RDX, Operand::Reg(Reg::R13));
+        zero(ir, Reg::R8);
+        mov(ir, Reg::R9, Operand::Reg(Reg::R12));
+        mov(ir, Reg::R10, Operand::Reg(Reg::RSP));
+        call(ir, self.ranges);
+        zero(ir, Reg::RAX);
+        Self::leave(ir);
+    }
+
+    /// Cuerpo: fn(&INPUT[i]) o fn(INPUT[i]) para i en [lo, hi)
+    fn emit_visit(&self, ir: &mut ADeadIR, label: Label, k: usize, by_ref: bool) {
+        let top = ir.new_label();
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(label));
+        for reg in [Reg::R12, Reg::R13, Reg::R14, Reg::R15] {
+            push(ir, reg);
+        }
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+        mov(ir, Reg::R12, Operand::Reg(Reg::RCX));
+        index_to_ptr(ir, Reg::R12, SHIFTS[k], mem(Reg::R8, INPUT));
+        mov(ir, Reg::R13, Operand::Reg(Reg::RDX));
+        index_to_ptr(ir, Reg::R13, SHIFTS[k], mem(Reg::R8, INPUT));
+        mov(ir, Reg::R15, mem(Reg::R8, FUNC));
+        ir.emit(ADeadOp::Label(top));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R12), right: Operand::Reg(Reg::R13) });
+        jcc(ir, Condition::AboveEq, done);
+        if by_ref {
+            mov(ir, self.args[0], Operand::Reg(Reg::R12));
+        } else {
+            load_elem(ir, self.args[0], Reg::R12, 0, WIDTHS[k]);
+        }
+        ir.emit(ADeadOp::Call { target: CallTarget::Register(Reg::R15) });
+        add_imm(ir, Reg::R12, WIDTHS[k]);
+        ir.emit(ADeadOp::Jmp { target: top });
+        ir.emit(ADeadOp::Label(done));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+        for reg in [Reg::R15, Reg::R14, Reg::R13, Reg::R12] {
+            pop(ir, reg);
+        }
+        ir.emit(ADeadOp::Ret);
+    }
+}
+
+#[cfg(all(test, target_os = "linux", target_arch = "x86_64"))]
+mod tests {
+    use super::*;
+    use crate::isa::task_pool::{ThreadApi, STATE_SIZE};
+    use crate::isa::test_jit::JitCode;
+
+    #[repr(C, align(64))]
+    struct State([u8; STATE_SIZE]);
+
+    extern "C" fn twice(x: i64) -> i64 {
+        x * 2 + 1
+    }
+
+    extern "C" fn bump(p: *mut i32) {
+        unsafe { *p += 1 }
+    }
+
+    #[test]
+    fn test_par_algorithms_inline() {
+        // WORKERS = -1: pool sin hilos, cada rango corre entero en línea
+        let mut state = State([0; STATE_SIZE]);
+        state.0[..8].copy_from_slice(&(-1i64).to_le_bytes());
+        let mut ir = ADeadIR::new();
+        let pool = TaskPool::new(&mut ir, state.0.as_mut_ptr() as u64, PageSource::Syscall, ThreadApi::Syscall);
+        let par = ParAlgorithms::new(&mut ir, &pool, PageSource::Syscall, false, true);
+        pool.emit_routines(&mut ir);
+        par.emit_routines(&mut ir);
+        let code = JitCode::new(ir.ops());
+
+        unsafe {
+            let sort32: extern "C" fn(*mut i32, *mut i32) -> i64 = code.func(par.sort[0]);
+            let sort64: extern "C" fn(*mut i64, *mut i64) -> i64 = code.func(par.sort[1]);
+            let reduce32: extern "C" fn(*const i32, *const i32, i64) -> i64 = code.func(par.reduce[0]);
+            let unseq32: extern "C" fn(*const i32, *const i32, i64) -> i64 = code.func(par.reduce_unseq[0]);
+            let unseq64: extern "C" fn(*const i64, *const i64, i64) -> i64 = code.func(par.reduce_unseq[1]);
+            let transform: extern "C" fn(*const i32, *const i32, *mut i64, extern "C" fn(i64) -> i64) -> *mut i64 =
+                code.func(par.transform[0][1]);
+            let for_each: extern "C" fn(*mut i32, *mut i32, extern "C" fn(*mut i32), i64) -> i64 =
+                code.func(par.for_each[0]);
+
+            // Más de un trozo local y una pasada global, con negativos y repetidos
+            let mut seed = 7u64;
+            let mut v: Vec<i32> = (0..3 * CHUNK as usize + 77)
+                .map(|_| {
+                    seed = seed.wrapping_mul(6364136223846793005).wrapping_add(1442695040888963407);
+                    (seed >> 40) as i32 % 1000 - 500
+                })
+                .collect();
+            let mut want = v.clone();
+            want.sort();
+            let range = v.as_mut_ptr_range();
+            assert_eq!(sort32(range.start, range.end), 0);
+            assert_eq!(v, want);
+
+            let mut w: Vec<i64> = (0..1000).map(|i| (i * 7919 % 1000) as i64 - (1 << 40)).collect();
+            let mut want64 = w.clone();
+            want64.sort();
+            let range = w.as_mut_ptr_range();
+            sort64(range.start, range.end);
+            assert_eq!(w, want64);
+
+            let sum: i64 = v.iter().map(|&x| x as i64).sum();
+            let range = v.as_ptr_range();
+            assert_eq!(reduce32(range.start, range.end, 3), sum + 3);
+            assert_eq!(unseq32(range.start, range.end, 3), sum + 3);
+            let range = w.as_ptr_range();
+            assert_eq!(unseq64(range.start, range.end, 0), w.iter().sum::<i64>());
+
+            let mut out = vec![0i64; v.len()];
+            let range = v.as_ptr_range();
+            let end = transform(range.start, range.end, out.as_mut_ptr(), twice);
+            assert_eq!(end, out.as_mut_ptr().add(v.len()));
+            assert!(out.iter().zip(&v).all(|(&o, &x)| o == x as i64 * 2 + 1));
+
+            let range = v.as_mut_ptr_range();
+            for_each(range.start, range.end, bump, 1);
+            assert!(v.iter().zip(&want).all(|(&x, &y)| x == y + 1));
+        }
+    }
+}
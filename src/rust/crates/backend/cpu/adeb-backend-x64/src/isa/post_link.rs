@@ -0,0 +1,967 @@
+// ============================================================
+// ADead-BIB — Post-link layout (estilo BOLT)
+// ============================================================
+// Re-layout de un .text ya enlazado a partir de un perfil de ramas
+// muestreado (LBR), sin recompilar:
+//
+//   bytes → instrucciones (decoder de longitudes) → bloques básicos
+//         → pesos del perfil → orden de bloques y funciones
+//         → ADeadOp (RawBytes + Jmp/Jcc/Call a labels) → Encoder
+//
+// Las instrucciones que no son saltos se copian tal cual; solo los
+// saltos se vuelven a emitir, así que el Encoder elige rel8/rel32 de
+// nuevo. Los operandos RIP-relative se re-apuntan tras el encode con
+// las posiciones finales de los labels.
+//
+// Orden:
+//   - Bloques de cada función: cadenas Pettis-Hansen por la arista más
+//     pesada (la rama tomada pasa a fall-through), entry delante.
+//   - Funciones: code_layout::affinity_order sobre las llamadas del perfil.
+//   - Región fría al final: bloques nunca vistos de funciones calientes
+//     y después las funciones frías enteras, en su orden original.
+//
+// Conservador: si algún byte no decodifica, o un salto cae dentro de
+// una instrucción, no se toca nada (Err). Las tablas de salto se
+// reconocen con la forma de switch_lowering (lea de la tabla, cmp del
+// límite, jmp reg justo antes de la tabla). Las direcciones absolutas
+// de código (&&label) no son reconocibles y no se soportan.
+//
+// Perfil: registros agregados de perf2bolt (`B from to count mispred`,
+// `F start end count`, hex) o la salida de
+// `perf script -F brstack` (`0xFROM/0xTO/...`, del más reciente al más
+// antiguo). Direcciones virtuales.
+// ============================================================
+
+use super::code_layout::{self, CallEdge};
+use super::encoder::Encoder;
+use super::{ADeadIR, ADeadOp, CallTarget, Condition, Label};
+use std::collections::{BTreeSet, HashMap, HashSet};
+
+// ========================================
+// Perfil de ramas
+// ========================================
+
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct BranchProfile {
+    /// (from, to) → veces tomada
+    taken: HashMap<(u64, u64), u64>,
+    /// Tramos ejecutados en secuencia: (inicio, fin inclusive, veces)
+    ranges: Vec<(u64, u64, u64)>,
+}
+
+fn parse_hex(s: &str) -> Option<u64> {
+    u64::from_str_radix(s.trim_start_matches("0x"), 16).ok()
+}
+
+/// `0xFROM/0xTO/flags...` de `perf script -F brstack`
+fn parse_brstack_entry(field: &str) -> Option<(u64, u64)> {
+    let mut parts = field.split('/');
+    let (from, to) = (parts.next()?, parts.next()?);
+    if !from.starts_with("0x") || !to.starts_with("0x") {
+        return None;
+    }
+    Some((parse_hex(from)?, parse_hex(to)?))
+}
+
+impl BranchProfile {
+    pub fn parse(text: &str) -> Result<Self, String> {
+        let mut profile = BranchProfile::default();
+        for (n, line) in text.lines().enumerate() {
+            let fields: Vec<&str> = line.split_whitespace().collect();
+            let bad = || format!("line {}: malformed record '{}'", n + 1, line.trim());
+            match fields.as_slice() {
+                [] => {}
+                [comment, ..] if comment.starts_with('#') => {}
+                [kind @ ("B" | "F"), a, b, count, ..] => {
+                    let a = parse_hex(a).ok_or_else(bad)?;
+                    let b = parse_hex(b).ok_or_else(bad)?;
+                    let count = count.parse::<u64>().map_err(|_| bad())?;
+                    if *kind == "B" {
+                        profile.add_taken(a, b, count);
+                    } else if a <= b {
+                        profile.ranges.push((a, b, count));
+                    }
+                }
+                _ => {
+                    let lbr: Vec<(u64, u64)> = fields.iter().filter_map(|f| parse_brstack_entry(f)).collect();
+                    for &(from, to) in &lbr {
+                        profile.add_taken(from, to, 1);
+                    }
+                    // Entre el destino de una rama y el origen de la siguiente
+                    // (más reciente) todo se ejecutó en secuencia
+                    for w in lbr.windows(2) {
+                        let (newer, older) = (w[0], w[1]);
+                        if older.1 <= newer.0 {
+                            profile.ranges.push((older.1, newer.0, 1));
+                        }
+                    }
+                }
+            }
+        }
+        if profile.is_empty() {
+            return Err("no branch samples (expected perf2bolt 'B'/'F' records or perf script -F brstack)".to_string());
+        }
+        Ok(profile)
+    }
+
+    pub fn load(path: &str) -> Result<Self, String> {
+        let text = std::fs::read_to_string(path)
+            .map_err(|e| format!("cannot read profile '{}': {}", path, e))?;
+        Self::parse(&text).map_err(|e| format!("{}: {}", path, e))
+    }
+
+    pub fn add_taken(&mut self, from: u64, to: u64, count: u64) {
+        let w = self.taken.entry((from, to)).or_insert(0);
+        *w = w.saturating_add(count);
+    }
+
+    pub fn add_range(&mut self, start: u64, end: u64, count: u64) {
+        self.ranges.push((start, end, count));
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.taken.is_empty() && self.ranges.is_empty()
+    }
+}
+
+// ========================================
+// Decoder de longitudes x86-64
+// ========================================
+
+/// Efecto de una instrucción sobre el flujo. Destinos relativos al
+/// inicio del .text (pueden caer fuera: IAT, datos).
+#[derive(Debug, Clone, PartialEq)]
+enum Flow {
+    Next,
+    Jmp(i64),
+    /// cc = nibble de 7x / 0F 8x
+    Jcc(u8, i64),
+    Call(i64),
+    Ret,
+    /// jmp reg/mem: sale de la función
+    Indirect,
+    /// ud2, int3, hlt
+    Stop,
+    /// Tabla de saltos: un dword `destino - tabla` por entrada
+    Table(Vec<i64>),
+}
+
+#[derive(Debug, Clone, PartialEq)]
+struct Insn {
+    off: usize,
+    len: usize,
+    flow: Flow,
+    /// (posición del disp32 dentro de la instrucción, destino)
+    rip: Option<(usize, i64)>,
+}
+
+impl Insn {
+    fn ends_block(&self) -> bool {
+        !matches!(self.flow, Flow::Next | Flow::Call(_))
+    }
+
+    fn falls_through(&self) -> bool {
+        matches!(self.flow, Flow::Next | Flow::Call(_) | Flow::Jcc(..))
+    }
+}
+
+fn read_rel(code: &[u8], at: usize, size: usize) -> Option<i64> {
+    let b = code.get(at..at + size)?;
+    Some(match size {
+        1 => b[0] as i8 as i64,
+        _ => i32::from_le_bytes(b.try_into().ok()?) as i64,
+    })
+}
+
+/// Longitud y efecto de la instrucción en `off`. None = opcode desconocido.
+fn decode_insn(code: &[u8], off: usize) -> Option<Insn> {
+    let byte = |i: usize| code.get(off + i).copied();
+    let mut i = 0;
+    let mut opsize16 = false;
+    let mut addr32 = false;
+    loop {
+        match byte(i)? {
+            0x66 => opsize16 = true,
+            0x67 => addr32 = true,
+            0xF0 | 0xF2 | 0xF3 | 0x26 | 0x2E | 0x36 | 0x3E | 0x64 | 0x65 => {}
+            _ => break,
+        }
+        i += 1;
+    }
+    let mut rex_w = false;
+    if let b @ 0x40..=0x4F = byte(i)? {
+        rex_w = b & 0x08 != 0;
+        i += 1;
+    }
+    let imm_z = if opsize16 { 2 } else { 4 };
+
+    // (ModRM, bytes de inmediato, rel, flujo sin destino)
+    let op = byte(i)?;
+    i += 1;
+    let (modrm, mut imm, rel, mut flow) = match op {
+        0x0F => {
+            let op2 = byte(i)?;
+            i += 1;
+            match op2 {
+                0x05 | 0x06 | 0x07 | 0x08 | 0x09 | 0x30..=0x35 | 0x77 | 0xA0 | 0xA1 | 0xA2 | 0xA8 | 0xA9
+                | 0xC8..=0xCF => (false, 0, 0, Flow::Next),
+                0x0B => (false, 0, 0, Flow::Stop),
+                0x00 | 0x01 | 0x0D | 0x10..=0x1F | 0x20..=0x23 | 0x28..=0x2F | 0x40..=0x6F | 0x74..=0x76
+                | 0x7C..=0x7F | 0x90..=0x9F | 0xA3 | 0xA5 | 0xAB | 0xAD..=0xAF | 0xB0..=0xB9 | 0xBB..=0xBF
+                | 0xC0 | 0xC1 | 0xC3 | 0xC7 | 0xD0..=0xFF => (true, 0, 0, Flow::Next),
+                0x70..=0x73 | 0xA4 | 0xAC | 0xBA | 0xC2 | 0xC4..=0xC6 => (true, 1, 0, Flow::Next),
+                0x80..=0x8F => (false, 0, 4, Flow::Jcc(op2 & 0x0F, 0)),
+                0x38 => {
+                    i += 1;
+                    (true, 0, 0, Flow::Next)
+                }
+                0x3A => {
+                    i += 1;
+                    (true, 1, 0, Flow::Next)
+                }
+                _ => return None,
+            }
+        }
+        0xC4 | 0xC5 => {
+            // VEX: C5 [R vvvv L pp] op / C4 [RXB mmmmm] [W vvvv L pp] op
+            let map = if op == 0xC5 { 1 } else { byte(i)? & 0x1F };
+            i += if op == 0xC5 { 1 } else { 2 };
+            let vop = byte(i)?;
+            i += 1;
+            match (map, vop) {
+                (1, 0x77) => (false, 0, 0, Flow::Next),
+                (1, 0x70..=0x73 | 0xC2 | 0xC4..=0xC6) => (true, 1, 0, Flow::Next),
+                (1 | 2, _) => (true, 0, 0, Flow::Next),
+                (3, _) => (true, 1, 0, Flow::Next),
+                _ => return None,
+            }
+        }
+        0x00..=0x3F if op & 7 < 4 => (true, 0, 0, Flow::Next),
+        0x00..=0x3F if op & 7 == 4 => (false, 1, 0, Flow::Next),
+        0x00..=0x3F if op & 7 == 5 => (false, imm_z, 0, Flow::Next),
+        0x50..=0x5F | 0x90..=0x99 | 0x9B..=0x9F | 0xA4..=0xA7 | 0xAA..=0xAF | 0xC9 | 0xF5 | 0xF8..=0xFD => {
+            (false, 0, 0, Flow::Next)
+        }
+        0x63 | 0x84..=0x8F | 0xD0..=0xD3 | 0xD8..=0xDF | 0xFE => (true, 0, 0, Flow::Next),
+        0x68 => (false, imm_z, 0, Flow::Next),
+        0x69 => (true, imm_z, 0, Flow::Next),
+        0x6A | 0xA8 | 0xB0..=0xB7 | 0xCD => (false, 1, 0, Flow::Next),
+        0x6B | 0x80 | 0x83 | 0xC0 | 0xC1 | 0xC6 => (true, 1, 0, Flow::Next),
+        0x81 | 0xC7 => (true, imm_z, 0, Flow::Next),
+        0xA9 => (false, imm_z, 0, Flow::Next),
+        0xA0..=0xA3 => (false, if addr32 { 4 } else { 8 }, 0, Flow::Next),
+        0xB8..=0xBF => (false, if rex_w { 8 } else { imm_z }, 0, Flow::Next),
+        0x70..=0x7F => (false, 0, 1, Flow::Jcc(op & 0x0F, 0)),
+        0xC2 => (false, 2, 0, Flow::Ret),
+        0xC3 => (false, 0, 0, Flow::Ret),
+        0xC8 => (false, 3, 0, Flow::Next),
+        0xCC | 0xF4 => (false, 0, 0, Flow::Stop),
+        0xE8 => (false, 0, 4, Flow::Call(0)),
+        0xE9 => (false, 0, 4, Flow::Jmp(0)),
+        0xEB => (false, 0, 1, Flow::Jmp(0)),
+        0xF6 | 0xF7 | 0xFF => (true, 0, 0, Flow::Next),
+        _ => return None,
+    };
+
+    let mut rip_at = None;
+    if modrm {
+        let m = byte(i)?;
+        i += 1;
+        let (md, reg, rm) = (m >> 6, (m >> 3) & 7, m & 7);
+        match op {
+            0xF6 if reg < 2 => imm = 1,
+            0xF7 if reg < 2 => imm = imm_z,
+            0xFF if reg == 4 || reg == 5 => flow = Flow::Indirect,
+            _ => {}
+        }
+        if md != 3 && rm == 4 {
+            let sib = byte(i)?;
+            i += 1;
+            if md == 0 && sib & 7 == 5 {
+                i += 4;
+            }
+        }
+        match md {
+            0 if rm == 5 => {
+                rip_at = Some(i);
+                i += 4;
+            }
+            1 => i += 1,
+            2 => i += 4,
+            _ => {}
+        }
+    }
+    let rel_at = i;
+    let len = i + imm + rel;
+    if off + len > code.len() {
+        return None;
+    }
+    let end = (off + len) as i64;
+    if rel > 0 {
+        let target = end + read_rel(code, off + rel_at, rel)?;
+        flow = match flow {
+            Flow::Jcc(cc, _) => Flow::Jcc(cc, target),
+            Flow::Call(_) => Flow::Call(target),
+            _ => Flow::Jmp(target),
+        };
+    }
+    let rip = match rip_at {
+        Some(at) => Some((at, end + read_rel(code, off + at, 4)?)),
+        None => None,
+    };
+    Some(Insn { off, len, flow, rip })
+}
+
+/// Strip del REX: (opcode, ModRM) de una instrucción sin prefijos legacy
+fn opcode_and_modrm(code: &[u8], insn: &Insn) -> Option<(u8, Option<u8>)> {
+    let bytes = &code[insn.off..insn.off + insn.len];
+    let body = match bytes.first()? {
+        0x40..=0x4F => &bytes[1..],
+        _ => bytes,
+    };
+    Some((*body.first()?, body.get(1).copied()))
+}
+
+/// Límite de `cmp reg, imm` (83 /7 ib, 81 /7 id, 3D id)
+fn cmp_imm(code: &[u8], insn: &Insn) -> Option<i64> {
+    let (op, modrm) = opcode_and_modrm(code, insn)?;
+    let at = insn.off + insn.len;
+    match (op, modrm) {
+        (0x83, Some(m)) if m >> 3 == 0b11_111 => read_rel(code, at - 1, 1),
+        (0x81, Some(m)) if m >> 3 == 0b11_111 => read_rel(code, at - 4, 4),
+        (0x3D, _) => read_rel(code, at - 4, 4),
+        _ => None,
+    }
+}
+
+/// Decodifica `code` entero; las tablas de salto quedan como una
+/// pseudo-instrucción `Flow::Table` justo después de su `jmp reg`.
+fn disassemble(code: &[u8]) -> Result<Vec<Insn>, String> {
+    let mut insns: Vec<Insn> = Vec::new();
+    let mut off = 0;
+    let mut last_cmp: Option<i64> = None;
+    let mut last_lea: Option<i64> = None;
+    while off < code.len() {
+        let insn = decode_insn(code, off).ok_or_else(|| {
+            format!("undecodable instruction at +{:#x}: {:02X?}", off, &code[off..(off + 8).min(code.len())])
+        })?;
+        off += insn.len;
+        if insn.flow == Flow::Indirect && last_lea == Some(off as i64) {
+            let bound = last_cmp.filter(|&n| n >= 0).ok_or_else(|| format!("jump table at +{:#x} without bound check", off))?;
+            let count = bound as usize + 1;
+            if off + count * 4 > code.len() {
+                return Err(format!("jump table at +{:#x} runs past the end of .text", off));
+            }
+            let targets = (0..count).map(|k| off as i64 + read_rel(code, off + k * 4, 4).unwrap_or(0)).collect();
+            insns.push(insn);
+            insns.push(Insn { off, len: count * 4, flow: Flow::Table(targets), rip: None });
+            off += count * 4;
+            continue;
+        }
+        if let Some(v) = cmp_imm(code, &insn) {
+            last_cmp = Some(v);
+        }
+        if let (Some((0x8D, _)), Some((_, target))) = (opcode_and_modrm(code, &insn), insn.rip) {
+            last_lea = Some(target);
+        }
+        insns.push(insn);
+    }
+    Ok(insns)
+}
+
+// ========================================
+// Bloques básicos y pesos
+// ========================================
+
+#[derive(Debug, Clone)]
+struct Block {
+    /// Instrucciones insns[first..end]
+    first: usize,
+    end: usize,
+    func: usize,
+}
+
+/// Resultado de `relayout`
+#[derive(Debug, Clone)]
+pub struct Relayout {
+    pub code: Vec<u8>,
+    /// Offset viejo → nuevo de cada inicio de bloque y destino referenciado
+    moved: HashMap<usize, usize>,
+    pub stats: PostLinkStats,
+}
+
+impl Relayout {
+    /// Nueva posición de `old` (inicios de función/bloque y los `entries`)
+    pub fn new_offset(&self, old: usize) -> Option<usize> {
+        self.moved.get(&old).copied()
+    }
+}
+
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct PostLinkStats {
+    pub functions: usize,
+    pub hot_functions: usize,
+    pub blocks: usize,
+    /// Bloques sin muestras de funciones calientes, movidos a la región fría
+    pub cold_blocks: usize,
+    /// Peso de las aristas del perfil que caen en fall-through
+    pub fallthrough_before: u64,
+    pub fallthrough_after: u64,
+    pub size_before: usize,
+    pub size_after: usize,
+}
+
+impl std::fmt::Display for PostLinkStats {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        write!(
+            f,
+            "{} functions ({} hot), {} blocks ({} moved cold), fall-through weight {} -> {}, {} -> {} bytes",
+            self.functions,
+            self.hot_functions,
+            self.blocks,
+            self.cold_blocks,
+            self.fallthrough_before,
+            self.fallthrough_after,
+            self.size_before,
+            self.size_after
+        )
+    }
+}
+
+fn condition_of(cc: u8) -> Option<Condition> {
+    Some(match cc {
+        0x04 => Condition::Equal,
+        0x05 => Condition::NotEqual,
+        0x0C => Condition::Less,
+        0x0E => Condition::LessEq,
+        0x0F => Condition::Greater,
+        0x0D => Condition::GreaterEq,
+        0x02 => Condition::Below,
+        0x06 => Condition::BelowEq,
+        0x07 => Condition::Above,
+        0x03 => Condition::AboveEq,
+        _ => return None,
+    })
+}
+
+/// Cadenas Pettis-Hansen sobre los bloques calientes de una función:
+/// de la arista más pesada a la más ligera, se une la cola de una
+/// cadena con la cabeza de otra. La cadena del entry va primero.
+fn order_blocks(hot: &[usize], entry: usize, edges: &[((usize, usize), u64)], exec: &[u64]) -> Vec<usize> {
+    let mut chain_of: HashMap<usize, usize> = hot.iter().map(|&b| (b, b)).collect();
+    let mut chains: HashMap<usize, Vec<usize>> = hot.iter().map(|&b| (b, vec![b])).collect();
+    for &((a, b), _) in edges {
+        let (Some(&ca), Some(&cb)) = (chain_of.get(&a), chain_of.get(&b)) else {
+            continue;
+        };
+        if ca == cb || b == entry || chains[&ca].last() != Some(&a) || chains[&cb].first() != Some(&b) {
+            continue;
+        }
+        let tail = chains.remove(&cb).unwrap_or_default();
+        for &blk in &tail {
+            chain_of.insert(blk, ca);
+        }
+        chains.get_mut(&ca).unwrap().extend(tail);
+    }
+    let mut heads: Vec<usize> = chains.keys().copied().collect();
+    let weight = |c: &usize| chains[c].iter().map(|&b| exec[b]).sum::<u64>();
+    heads.sort_by_key(|c| (chains[c].first() != Some(&entry), std::cmp::Reverse(weight(c)), *c));
+    heads.into_iter().flat_map(|c| chains[&c].clone()).collect()
+}
+
+/// Reordena los bloques y funciones de `code` (un .text cargado en
+/// `text_va`) según `profile`. `entries` son offsets a los que se llega
+/// desde fuera del código (entry point, punteros en la IAT): se tratan
+/// como inicios de función y su nueva posición sale de `new_offset`.
+pub fn relayout(code: &[u8], text_va: u64, profile: &BranchProfile, entries: &[usize]) -> Result<Relayout, String> {
+    let insns = disassemble(code)?;
+    let in_text = |t: i64| t >= 0 && (t as usize) < code.len();
+    let index_of: HashMap<usize, usize> = insns.iter().enumerate().map(|(k, insn)| (insn.off, k)).collect();
+    let tables: HashSet<usize> =
+        insns.iter().filter(|insn| matches!(insn.flow, Flow::Table(_))).map(|insn| insn.off).collect();
+
+    // ---- Destinos: deben caer en el inicio de una instrucción ----
+    let mut starts: BTreeSet<usize> = entries.iter().copied().collect();
+    starts.insert(0);
+    let mut leaders: BTreeSet<usize> = BTreeSet::new();
+    let mut referenced: BTreeSet<usize> = BTreeSet::new();
+    let check = |t: i64, from: usize| -> Result<usize, String> {
+        match index_of.contains_key(&(t as usize)) {
+            true => Ok(t as usize),
+            false => Err(format!("reference at +{:#x} into the middle of an instruction (+{:#x})", from, t)),
+        }
+    };
+    for (k, insn) in insns.iter().enumerate() {
+        match &insn.flow {
+            Flow::Jmp(t) | Flow::Jcc(_, t) if in_text(*t) => {
+                leaders.insert(check(*t, insn.off)?);
+            }
+            Flow::Call(t) if in_text(*t) => {
+                starts.insert(check(*t, insn.off)?);
+            }
+            Flow::Table(targets) => {
+                for &t in targets {
+                    leaders.insert(check(t, insn.off)?);
+                }
+            }
+            _ => {}
+        }
+        if let Some((_, t)) = insn.rip.filter(|&(_, t)| in_text(t)) {
+            let t = check(t, insn.off)?;
+            referenced.insert(t);
+            if !tables.contains(&t) {
+                starts.insert(t);
+            }
+        }
+        if insn.ends_block() {
+            if let Some(next) = insns.get(k + 1).filter(|n| !matches!(n.flow, Flow::Table(_))) {
+                leaders.insert(next.off);
+            }
+        }
+    }
+    for &s in &starts {
+        if !index_of.contains_key(&s) {
+            return Err(format!("entry +{:#x} is not an instruction boundary", s));
+        }
+    }
+    leaders.extend(starts.iter().copied());
+
+    // ---- Bloques ----
+    let mut blocks: Vec<Block> = Vec::new();
+    let starts_vec: Vec<usize> = starts.iter().copied().collect();
+    for (k, insn) in insns.iter().enumerate() {
+        if k == 0 || leaders.contains(&insn.off) {
+            let func = starts_vec.partition_point(|&s| s <= insn.off) - 1;
+            blocks.push(Block { first: k, end: k + 1, func });
+        } else {
+            blocks.last_mut().unwrap().end = k + 1;
+        }
+    }
+    let block_starts: Vec<usize> = blocks.iter().map(|b| insns[b.first].off).collect();
+    let block_at = |off: usize| block_starts.binary_search(&off).ok();
+    let block_containing = |off: u64| -> Option<usize> {
+        let off = usize::try_from(off.checked_sub(text_va)?).ok()?;
+        if off >= code.len() {
+            return None;
+        }
+        Some(block_starts.partition_point(|&s| s <= off) - 1)
+    };
+    let nf = starts_vec.len();
+
+    // ---- Pesos del perfil ----
+    let mut exec = vec![0u64; blocks.len()];
+    let mut edges: HashMap<(usize, usize), u64> = HashMap::new();
+    let mut calls: HashMap<(usize, usize), u64> = HashMap::new();
+    let mut taken: Vec<(&(u64, u64), &u64)> = profile.taken.iter().collect();
+    taken.sort();
+    for (&(from, to), &count) in taken {
+        let (Some(bf), Some(bt)) = (block_containing(from), block_containing(to)) else {
+            continue;
+        };
+        let Some(&k) = index_of.get(&((from - text_va) as usize)) else {
+            continue;
+        };
+        if insns[k].flow == Flow::Ret {
+            continue;
+        }
+        exec[bf] = exec[bf].saturating_add(count);
+        exec[bt] = exec[bt].saturating_add(count);
+        if block_starts[bt] != (to - text_va) as usize {
+            continue;
+        }
+        if matches!(insns[k].flow, Flow::Call(_)) {
+            let w = calls.entry((blocks[bf].func, blocks[bt].func)).or_insert(0);
+            *w = w.saturating_add(count);
+        } else {
+            let w = edges.entry((bf, bt)).or_insert(0);
+            *w = w.saturating_add(count);
+        }
+    }
+    for &(start, end, count) in &profile.ranges {
+        let (Some(bs), Some(be)) = (block_containing(start), block_containing(end)) else {
+            continue;
+        };
+        if bs > be || blocks[bs].func != blocks[be].func {
+            continue;
+        }
+        for b in bs..=be {
+            exec[b] = exec[b].saturating_add(count);
+            if b < be {
+                let w = edges.entry((b, b + 1)).or_insert(0);
+                *w = w.saturating_add(count);
+            }
+        }
+    }
+    let mut func_exec = vec![0u64; nf];
+    for (b, blk) in blocks.iter().enumerate() {
+        func_exec[blk.func] = func_exec[blk.func].saturating_add(exec[b]);
+    }
+    // El stub de arranque (offset 0) no se mueve de sitio
+    let cold_func: Vec<bool> = (0..nf).map(|f| f != 0 && func_exec[f] == 0).collect();
+
+    // ---- Orden ----
+    let mut sorted_edges: Vec<((usize, usize), u64)> = edges.iter().map(|(&e, &w)| (e, w)).collect();
+    sorted_edges.sort_by(|a, b| b.1.cmp(&a.1).then(a.0.cmp(&b.0)));
+    let call_edges: Vec<CallEdge> = calls
+        .iter()
+        .map(|(&(caller, callee), &weight)| CallEdge { caller, callee, weight })
+        .collect();
+    let func_order = code_layout::affinity_order(nf, &call_edges, Some(0), &cold_func);
+
+    let mut func_blocks: Vec<Vec<usize>> = vec![Vec::new(); nf];
+    for (b, blk) in blocks.iter().enumerate() {
+        func_blocks[blk.func].push(b);
+    }
+    let mut layout: Vec<usize> = Vec::with_capacity(blocks.len());
+    let mut cold_region: Vec<usize> = Vec::new();
+    for &f in &func_order {
+        let entry = func_blocks[f][0];
+        let (hot, cold): (Vec<usize>, Vec<usize>) =
+            func_blocks[f].iter().partition(|&&b| b == entry || exec[b] > 0 || func_exec[f] == 0);
+        let fedges: Vec<((usize, usize), u64)> =
+            sorted_edges.iter().filter(|((a, _), _)| blocks[*a].func == f).copied().collect();
+        layout.extend(order_blocks(&hot, entry, &fedges, &exec));
+        cold_region.extend(cold);
+    }
+    let cold_blocks = cold_region.len();
+    layout.extend(cold_region);
+    for f in (0..nf).filter(|&f| cold_func[f]) {
+        layout.extend(func_blocks[f].iter().copied());
+    }
+
+    // ---- Emisión ----
+    let mut ir = ADeadIR::new();
+    let block_label: Vec<Label> = (0..blocks.len()).map(|_| ir.new_label()).collect();
+    let extra_label: HashMap<usize, Label> = referenced
+        .iter()
+        .filter(|off| block_at(**off).is_none())
+        .map(|&off| (off, ir.new_label()))
+        .collect();
+    let label_at = |off: usize| block_at(off).map(|b| block_label[b]).or_else(|| extra_label.get(&off).copied());
+
+    enum FixTarget {
+        Label(Label),
+        Offset(i64),
+    }
+    struct Fixup {
+        label: Label,
+        disp_at: usize,
+        len: usize,
+        target: FixTarget,
+    }
+    let mut fixups: Vec<Fixup> = Vec::new();
+    let mut raw: Vec<u8> = Vec::new();
+    let flush = |ir: &mut ADeadIR, raw: &mut Vec<u8>| {
+        if !raw.is_empty() {
+            ir.emit(ADeadOp::RawBytes(std::mem::take(raw)));
+        }
+    };
+    let fix_target = |t: i64| match in_text(t) {
+        true => FixTarget::Label(label_at(t as usize).expect("referenced offsets have labels")),
+        false => FixTarget::Offset(t),
+    };
+    // Instrucción copiada tal cual cuyo disp32 en `disp_at` apunta a `t`
+    let mut emit_fixed = |ir: &mut ADeadIR, raw: &mut Vec<u8>, bytes: Vec<u8>, disp_at: usize, t: i64| {
+        flush(ir, raw);
+        let label = ir.new_label();
+        ir.emit(ADeadOp::Label(label));
+        fixups.push(Fixup { label, disp_at, len: bytes.len(), target: fix_target(t) });
+        ir.emit(ADeadOp::RawBytes(bytes));
+    };
+
+    // Una arista a→b es fall-through si b va justo detrás de a (el jmp
+    // desaparece o el jcc se invierte); no a través de un jmp indirecto
+    let next_in_layout: HashMap<usize, usize> = layout.windows(2).map(|w| (w[0], w[1])).collect();
+    let (mut fallthrough_before, mut fallthrough_after) = (0u64, 0u64);
+    for (&(a, b), &w) in &edges {
+        if matches!(insns[blocks[a].end - 1].flow, Flow::Next | Flow::Call(_) | Flow::Jmp(_) | Flow::Jcc(..)) {
+            if b == a + 1 {
+                fallthrough_before += w;
+            }
+            if next_in_layout.get(&a) == Some(&b) {
+                fallthrough_after += w;
+            }
+        }
+    }
+
+    for (p, &b) in layout.iter().enumerate() {
+        let next = layout.get(p + 1).copied();
+        let blk = &blocks[b];
+        flush(&mut ir, &mut raw);
+        ir.emit(ADeadOp::Label(block_label[b]));
+        let successor = (b + 1 < blocks.len()).then_some(b + 1);
+        let mut needs_fallthrough = insns[blk.end - 1].falls_through();
+        for insn in &insns[blk.first..blk.end] {
+            if let Some(&l) = extra_label.get(&insn.off) {
+                flush(&mut ir, &mut raw);
+                ir.emit(ADeadOp::Label(l));
+            }
+            let bytes = code[insn.off..insn.off + insn.len].to_vec();
+            match &insn.flow {
+                Flow::Jmp(t) if in_text(*t) => {
+                    flush(&mut ir, &mut raw);
+                    let target = block_at(*t as usize).unwrap();
+                    if next != Some(target) {
+                        ir.emit(ADeadOp::Jmp { target: block_label[target] });
+                    }
+                }
+                Flow::Jcc(cc, t) if in_text(*t) => {
+                    let taken = block_at(*t as usize).unwrap();
+                    let inverted = condition_of(cc ^ 1).filter(|_| next == Some(taken) && next != successor);
+                    match (inverted, successor, condition_of(*cc)) {
+                        (Some(cond), Some(ft), _) => {
+                            flush(&mut ir, &mut raw);
+                            ir.emit(ADeadOp::Jcc { cond, target: block_label[ft] });
+                            needs_fallthrough = false;
+                        }
+                        (_, _, Some(cond)) => {
+                            flush(&mut ir, &mut raw);
+                            ir.emit(ADeadOp::Jcc { cond, target: block_label[taken] });
+                        }
+                        (_, _, None) => emit_fixed(&mut ir, &mut raw, vec![0x0F, 0x80 | cc, 0, 0, 0, 0], 2, *t),
+                    }
+                }
+                Flow::Call(t) if in_text(*t) => {
+                    flush(&mut ir, &mut raw);
+                    ir.emit(ADeadOp::Call { target: CallTarget::Relative(block_label[block_at(*t as usize).unwrap()]) });
+                }
+                Flow::Jmp(t) => emit_fixed(&mut ir, &mut raw, vec![0xE9, 0, 0, 0, 0], 1, *t),
+                Flow::Jcc(cc, t) => emit_fixed(&mut ir, &mut raw, vec![0x0F, 0x80 | cc, 0, 0, 0, 0], 2, *t),
+                Flow::Call(t) => emit_fixed(&mut ir, &mut raw, vec![0xE8, 0, 0, 0, 0], 1, *t),
+                Flow::Table(targets) => {
+                    flush(&mut ir, &mut raw);
+                    let table = label_at(insn.off).expect("jump tables are referenced by their lea");
+                    let targets = targets.iter().map(|&t| block_label[block_at(t as usize).unwrap()]).collect();
+                    ir.emit(ADeadOp::JumpTable { table, targets });
+                }
+                _ => match insn.rip {
+                    Some((at, t)) => emit_fixed(&mut ir, &mut raw, bytes, at, t),
+                    None => raw.extend_from_slice(&bytes),
+                },
+            }
+        }
+        if needs_fallthrough {
+            if let Some(ft) = successor.filter(|&ft| next != Some(ft)) {
+                flush(&mut ir, &mut raw);
+                ir.emit(ADeadOp::Jmp { target: block_label[ft] });
+            }
+        }
+    }
+    flush(&mut ir, &mut raw);
+
+    let result = Encoder::new().encode_all(ir.ops());
+    let mut out = result.code;
+    let pos = |l: &Label| result.label_offsets.get(&l.0).copied();
+    for fix in &fixups {
+        let at = pos(&fix.label).ok_or("fixup label was not placed")?;
+        let target = match fix.target {
+            FixTarget::Label(l) => pos(&l).ok_or("fixup target was not placed")? as i64,
+            FixTarget::Offset(t) => t,
+        };
+        let disp = i32::try_from(target - (at + fix.len) as i64)
+            .map_err(|_| format!("RIP-relative target +{:#x} out of range after relayout", target))?;
+        out[at + fix.disp_at..at + fix.disp_at + 4].copy_from_slice(&disp.to_le_bytes());
+    }
+
+    let mut moved = HashMap::new();
+    for (b, l) in block_label.iter().enumerate() {
+        moved.insert(block_starts[b], pos(l).ok_or("block label was not placed")?);
+    }
+    for (&off, l) in &extra_label {
+        moved.insert(off, pos(l).ok_or("label was not placed")?);
+    }
+
+    let stats = PostLinkStats {
+        functions: nf,
+        hot_functions: cold_func.iter().filter(|c| !**c).count(),
+        blocks: blocks.len(),
+        cold_blocks,
+        fallthrough_before,
+        fallthrough_after,
+        size_before: code.len(),
+        size_after: out.len(),
+    };
+    Ok(Relayout { code: out, moved, stats })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::isa::{Operand, Reg};
+
+    fn encode(ops: &[ADeadOp]) -> Vec<u8> {
+        Encoder::new().encode_all(ops).code
+    }
+
+    #[test]
+    fn test_lengths_match_encoder_output() {
+        // Cada op por separado da las fronteras esperadas
+        let ops = vec![
+            ADeadOp::Push { src: Operand::Reg(Reg::RBP) },
+            ADeadOp::Push { src: Operand::Reg(Reg::R12) },
+            ADeadOp::Mov { dst: Operand::Reg(Reg::RBP), src: Operand::Reg(Reg::RSP) },
+            ADeadOp::Mov { dst: Operand::Reg(Reg::RAX), src: Operand::Imm64(0x1234_5678_9ABC) },
+            ADeadOp::Mov { dst: Operand::Mem { base: Reg::RBP, disp: -8 }, src: Operand::Reg(Reg::RAX) },
+            ADeadOp::Mov { dst: Operand::Reg(Reg::R9), src: Operand::Mem { base: Reg::R12, disp: 0x200 } },
+            ADeadOp::Load8 { dst: Reg::RAX, base: Reg::R13, disp: 0 },
+            ADeadOp::Load16 { dst: Reg::R10, base: Reg::RSP, disp: 8 },
+            ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm32(0x100) },
+            ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(7) },
+            ADeadOp::Shl { dst: Reg::RCX, amount: 3 },
+            ADeadOp::Addsd { dst: Reg::XMM1, src: Reg::XMM9 },
+            ADeadOp::CallIAT { iat_rva: 0x2040 },
+            ADeadOp::Cdq,
+            ADeadOp::Syscall,
+            ADeadOp::Pop { dst: Reg::R12 },
+            ADeadOp::Ret,
+        ];
+        let mut expected = Vec::new();
+        let mut at = 0;
+        for op in &ops {
+            expected.push(at);
+            at += encode(std::slice::from_ref(op)).len();
+        }
+        let code = encode(&ops);
+        let insns = disassemble(&code).unwrap();
+        assert_eq!(insns.iter().map(|i| i.off).collect::<Vec<_>>(), expected);
+        // call [rip+disp] → destino = la RVA de la IAT menos la base de .text
+        let iat = &insns[12];
+        assert_eq!(iat.flow, Flow::Next);
+        assert_eq!(iat.rip.map(|(_, t)| t), Some(0x2040 - 0x1000));
+        assert!(disassemble(&[0x06]).is_err());
+    }
+
+    /// f(x): bucle de 0..x con un brazo raro en medio
+    fn loop_with_cold_arm() -> (Vec<ADeadOp>, [Label; 4]) {
+        let mut ir = ADeadIR::new();
+        let [top, rare, join, done] = [ir.new_label(), ir.new_label(), ir.new_label(), ir.new_label()];
+        let ops = vec![
+            ADeadOp::Xor { dst: Reg::RAX, src: Reg::RAX },
+            ADeadOp::Xor { dst: Reg::RCX, src: Reg::RCX },
+            ADeadOp::Label(top),
+            ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: Operand::Reg(Reg::RDI) },
+            ADeadOp::Jcc { cond: Condition::GreaterEq, target: done },
+            ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: Operand::Imm32(1000) },
+            ADeadOp::Jcc { cond: Condition::NotEqual, target: join },
+            ADeadOp::Label(rare),
+            ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Imm32(1_000_000) },
+            ADeadOp::Label(join),
+            ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RCX) },
+            ADeadOp::Inc { dst: Operand::Reg(Reg::RCX) },
+            ADeadOp::Jmp { target: top },
+            ADeadOp::Label(done),
+            ADeadOp::Ret,
+        ];
+        (ops, [top, rare, join, done])
+    }
+
+    #[test]
+    fn test_hot_path_becomes_fallthrough() {
+        let (ops, _) = loop_with_cold_arm();
+        let code = encode(&ops);
+        let insns = disassemble(&code).unwrap();
+        // jne join (tomada casi siempre) y el jmp top del final
+        let jne = insns.iter().find(|i| matches!(i.flow, Flow::Jcc(0x05, _))).unwrap().clone();
+        let Flow::Jcc(_, join) = jne.flow else { unreachable!() };
+        let back = insns.iter().find(|i| matches!(i.flow, Flow::Jmp(_))).unwrap().clone();
+        let Flow::Jmp(top) = back.flow else { unreachable!() };
+        let jge = insns.iter().find(|i| matches!(i.flow, Flow::Jcc(0x0D, _))).unwrap().clone();
+        let Flow::Jcc(_, done) = jge.flow else { unreachable!() };
+        let base = 0x40_1000u64;
+        let mut profile = BranchProfile::default();
+        profile.add_taken(base + jne.off as u64, base + join as u64, 999);
+        profile.add_taken(base + back.off as u64, base + top as u64, 1000);
+        profile.add_taken(base + jge.off as u64, base + done as u64, 1);
+        profile.add_range(base + join as u64, base + back.off as u64, 1000);
+
+        let out = relayout(&code, base, &profile, &[]).unwrap();
+        assert_eq!(out.stats.cold_blocks, 1);
+        assert!(out.stats.fallthrough_after > out.stats.fallthrough_before);
+        // El brazo raro queda detrás del resto de la función
+        let rare_new = out.new_offset(jne.off + jne.len).unwrap();
+        let join_new = out.new_offset(join as usize).unwrap();
+        assert!(rare_new > join_new);
+        let again = disassemble(&out.code).unwrap();
+        assert!(again.iter().any(|i| matches!(i.flow, Flow::Jcc(0x04, _))), "jne became je to the cold arm");
+    }
+
+    #[test]
+    fn test_parse_profile_formats() {
+        let text = "# perf2bolt\nB 401010 401000 12 0\nF 401000 401010 12\n\
+                    0x401020/0x401030/P/-/-/0 0x401008/0x401018/P/-/-/0\n";
+        let p = BranchProfile::parse(text).unwrap();
+        assert_eq!(p.taken[&(0x401010, 0x401000)], 12);
+        assert_eq!(p.taken[&(0x401020, 0x401030)], 1);
+        assert_eq!(p.ranges, vec![(0x401000, 0x401010, 12), (0x401018, 0x401020, 1)]);
+        assert!(BranchProfile::parse("B 40zz 1 2 0\n").is_err());
+        assert!(BranchProfile::parse("nothing here\n").is_err());
+    }
+
+    #[cfg(all(target_os = "linux", target_arch = "x86_64"))]
+    mod exec {
+        use super::*;
+        use crate::isa::test_jit::JitCode;
+
+        fn run(code: &[u8], arg: u64) -> i64 {
+            JitCode::from_code(code).call(arg)
+        }
+
+        #[test]
+        fn test_relayout_preserves_behaviour() {
+            let (ops, _) = loop_with_cold_arm();
+            let code = encode(&ops);
+            let insns = disassemble(&code).unwrap();
+            let mut profile = BranchProfile::default();
+            // Perfil invertido a propósito: fuerza mover todo
+            for insn in &insns {
+                if let Flow::Jcc(_, t) | Flow::Jmp(t) = insn.flow {
+                    profile.add_taken(insn.off as u64, t as u64, 5);
+                }
+            }
+            let out = relayout(&code, 0, &profile, &[]).unwrap();
+            for x in [0u64, 5, 1000, 1001, 5000] {
+                assert_eq!(run(&out.code, x), run(&code, x), "x = {}", x);
+            }
+        }
+
+        #[test]
+        fn test_jump_table_is_rebuilt() {
+            // switch (x) { 0: 10, 1: 20, 2: 30, default: -1 } como switch_lowering
+            let mut ir = ADeadIR::new();
+            let (table, default, end) = (ir.new_label(), ir.new_label(), ir.new_label());
+            let cases = [ir.new_label(), ir.new_label(), ir.new_label()];
+            let mut ops = vec![
+                ADeadOp::Mov { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RDI) },
+                ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(2) },
+                ADeadOp::Jcc { cond: Condition::Above, target: default },
+                ADeadOp::LeaLabel { dst: Reg::RCX, label: table },
+                ADeadOp::RawBytes(vec![0x48, 0x63, 0x04, 0x81]),
+                ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RCX) },
+                ADeadOp::RawBytes(vec![0xFF, 0xE0]),
+                ADeadOp::Label(table),
+                ADeadOp::JumpTable { table, targets: cases.to_vec() },
+            ];
+            for (k, &case) in cases.iter().enumerate() {
+                ops.push(ADeadOp::Label(case));
+                ops.push(ADeadOp::Mov { dst: Operand::Reg(Reg::RAX), src: Operand::Imm32(10 * (k as i32 + 1)) });
+                ops.push(ADeadOp::Jmp { target: end });
+            }
+            ops.push(ADeadOp::Label(default));
+            ops.push(ADeadOp::Mov { dst: Operand::Reg(Reg::RAX), src: Operand::Imm32(-1) });
+            ops.push(ADeadOp::Label(end));
+            ops.push(ADeadOp::Ret);
+            let code = encode(&ops);
+
+            let insns = disassemble(&code).unwrap();
+            assert!(insns.iter().any(|i| matches!(&i.flow, Flow::Table(t) if t.len() == 3)));
+            // Solo el caso 2 está caliente: pasa delante de los otros
+            let case2 = insns.iter().filter(|i| matches!(i.flow, Flow::Jmp(_))).nth(2).unwrap().off;
+            let mut profile = BranchProfile::default();
+            profile.add_range(case2 as u64 - 5, case2 as u64, 100);
+            let out = relayout(&code, 0, &profile, &[]).unwrap();
+            for x in 0..5u64 {
+                assert_eq!(run(&out.code, x), run(&code, x), "x = {}", x);
+            }
+        }
+    }
+}
@@ -33,6 +33,15 @@ const TEMP_REGS: [Reg; 13] = [
     Reg::R15, // Callee-saved
 ];
 
+/// Registers for register-resident expression trees: caller-saved only,
+/// never RAX (result) or RBX (scratch operand of the push/pop fallback).
+/// `alloc` pops from the end, so RCX is handed out first.
+pub const EXPR_REGS: [Reg; 6] = [Reg::R11, Reg::R10, Reg::R9, Reg::R8, Reg::RDX, Reg::RCX];
+
+/// Registers for locals promoted by LinearScanAllocator: callee-saved, so
+/// they survive calls. R12 goes first (the prologue already saves it).
+pub const LOCAL_REGS: [Reg; 4] = [Reg::R15, Reg::R14, Reg::R13, Reg::R12];
+
 /// Callee-saved registers that must be preserved across calls
 const CALLEE_SAVED: [Reg; 5] = [Reg::RBX, Reg::R12, Reg::R13, Reg::R14, Reg::R15];
 
@@ -60,6 +69,16 @@ impl TempAllocator {
         }
     }
 
+    /// Create an allocator over a fixed register pool
+    pub fn with_regs(regs: &[Reg]) -> Self {
+        Self {
+            available: regs.to_vec(),
+            in_use: Vec::new(),
+            spill_count: 0,
+            max_used: 0,
+        }
+    }
+
     /// Allocate a temporary register
     /// Returns None if all registers are in use (caller should spill to stack)
     pub fn alloc(&mut self) -> Option<Reg> {
@@ -228,6 +247,8 @@ pub struct LiveInterval {
     pub end: usize,
     pub assigned_reg: Option<Reg>,
     pub spill_slot: Option<i32>,
+    /// Estimated executions of its uses (profile); 0 = unknown
+    pub weight: u64,
 }
 
 /// Linear-scan register allocator with liveness analysis
@@ -251,14 +272,29 @@ impl LinearScanAllocator {
         }
     }
 
+    /// Create an allocator over a fixed register pool
+    pub fn with_regs(regs: &[Reg]) -> Self {
+        Self {
+            free_regs: regs.to_vec(),
+            ..Self::new()
+        }
+    }
+
     /// Add a liveness interval for a variable
     pub fn add_interval(&mut self, var_name: String, start: usize, end: usize) {
+        self.add_weighted_interval(var_name, start, end, 0);
+    }
+
+    /// Interval with a use count from the profile: when registers run
+    /// out, the lightest interval goes to the stack
+    pub fn add_weighted_interval(&mut self, var_name: String, start: usize, end: usize, weight: u64) {
         self.intervals.push(LiveInterval {
             var_name,
             start,
             end,
             assigned_reg: None,
             spill_slot: None,
+            weight,
         });
     }
 
@@ -299,30 +335,56 @@ impl LinearScanAllocator {
     }
 
     fn spill_at_interval(&mut self, i: usize) {
+        // With profile weights, the least-used interval is spilled
+        let all_equal = self
+            .active
+            .iter()
+            .all(|&idx| self.intervals[idx].weight == self.intervals[i].weight);
+        if !all_equal {
+            let lightest = self
+                .active
+                .iter()
+                .copied()
+                .min_by_key(|&idx| (self.intervals[idx].weight, std::cmp::Reverse(self.intervals[idx].end)));
+            match lightest {
+                Some(victim) if self.intervals[victim].weight < self.intervals[i].weight => {
+                    self.steal_register(victim, i)
+                }
+                _ => self.spill_current(i),
+            }
+            return;
+        }
         if let Some(&last_active) = self.active.last() {
             if self.intervals[last_active].end > self.intervals[i].end {
                 // Spill the active interval that ends latest
-                self.intervals[i].assigned_reg = self.intervals[last_active].assigned_reg;
-                self.spill_offset -= 8;
-                self.intervals[last_active].assigned_reg = None;
-                self.intervals[last_active].spill_slot = Some(self.spill_offset);
-                self.max_spill_slots += 1;
-                self.active.pop();
-                self.active.push(i);
-                self.active.sort_by_key(|&idx| self.intervals[idx].end);
+                self.steal_register(last_active, i);
             } else {
                 // Spill current interval
-                self.spill_offset -= 8;
-                self.intervals[i].spill_slot = Some(self.spill_offset);
-                self.max_spill_slots += 1;
+                self.spill_current(i);
             }
         } else {
-            self.spill_offset -= 8;
-            self.intervals[i].spill_slot = Some(self.spill_offset);
-            self.max_spill_slots += 1;
+            self.spill_current(i);
         }
     }
 
+    /// `victim` (active) goes to the stack and `i` takes its register
+    fn steal_register(&mut self, victim: usize, i: usize) {
+        self.intervals[i].assigned_reg = self.intervals[victim].assigned_reg;
+        self.spill_offset -= 8;
+        self.intervals[victim].assigned_reg = None;
+        self.intervals[victim].spill_slot = Some(self.spill_offset);
+        self.max_spill_slots += 1;
+        self.active.retain(|&idx| idx != victim);
+        self.active.push(i);
+        self.active.sort_by_key(|&idx| self.intervals[idx].end);
+    }
+
+    fn spill_current(&mut self, i: usize) {
+        self.spill_offset -= 8;
+        self.intervals[i].spill_slot = Some(self.spill_offset);
+        self.max_spill_slots += 1;
+    }
+
     /// Get the allocation result for a variable
     pub fn get_allocation(&self, var_name: &str) -> Option<&LiveInterval> {
         self.intervals.iter().find(|i| i.var_name == var_name)
@@ -333,6 +395,16 @@ impl LinearScanAllocator {
         &self.intervals
     }
 
+    /// Callee-saved registers assigned to some interval (in CALLEE_SAVED
+    /// order). These need to be saved/restored in prologue/epilogue
+    pub fn callee_saved_in_use(&self) -> Vec<Reg> {
+        CALLEE_SAVED
+            .iter()
+            .filter(|r| self.intervals.iter().any(|i| i.assigned_reg == Some(**r)))
+            .copied()
+            .collect()
+    }
+
     /// Get number of spill slots used
     pub fn spill_slots_used(&self) -> usize {
         self.max_spill_slots
@@ -432,4 +504,43 @@ mod tests {
         // 13 regs available, 15 intervals → 2 spills
         assert_eq!(alloc.spill_slots_used(), 2);
     }
+
+    #[test]
+    fn test_linear_scan_local_pool() {
+        let mut alloc = LinearScanAllocator::with_regs(&LOCAL_REGS);
+        alloc.add_interval("i".to_string(), 0, 10);
+        alloc.add_interval("sum".to_string(), 0, 10);
+        alloc.add_interval("j".to_string(), 10, 20); // reusa el registro de i
+        alloc.allocate();
+
+        assert_eq!(alloc.get_allocation("i").unwrap().assigned_reg, Some(Reg::R12));
+        assert_eq!(alloc.get_allocation("sum").unwrap().assigned_reg, Some(Reg::R13));
+        assert!(alloc.get_allocation("j").unwrap().assigned_reg.is_some());
+        assert_eq!(alloc.callee_saved_in_use(), vec![Reg::R12, Reg::R13]);
+    }
+
+    #[test]
+    fn test_linear_scan_spills_lightest_interval() {
+        // Cinco rangos solapados para cuatro registros: sin pesos se va
+        // el que termina más tarde; con perfil, el menos usado
+        let build = |weights: [u64; 5]| {
+            let mut alloc = LinearScanAllocator::with_regs(&LOCAL_REGS);
+            for (k, w) in weights.iter().enumerate() {
+                alloc.add_weighted_interval(format!("v{}", k), k, 20 + k, *w);
+            }
+            alloc.allocate();
+            alloc
+        };
+        let spilled = |alloc: &LinearScanAllocator| -> Vec<String> {
+            alloc
+                .intervals()
+                .iter()
+                .filter(|i| i.assigned_reg.is_none())
+                .map(|i| i.var_name.clone())
+                .collect()
+        };
+        assert_eq!(spilled(&build([0; 5])), vec!["v4".to_string()]);
+        assert_eq!(spilled(&build([500, 3, 900, 800, 700])), vec!["v1".to_string()]);
+        assert_eq!(spilled(&build([500, 600, 900, 800, 2])), vec!["v4".to_string()]);
+    }
 }
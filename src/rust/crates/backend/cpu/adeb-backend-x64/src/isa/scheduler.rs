@@ -0,0 +1,806 @@
+// ============================================================
+// ADead-BIB — List scheduler por microarquitectura (-mtune)
+// ============================================================
+// Reordena los ops de cada bloque básico de ADeadIR según las
+// latencias y el ancho de issue del core elegido con `-mtune`:
+//
+//   - Las cargas (latencia 4-5) suben por delante de las ALU
+//     que no dependen de ellas: su latencia se solapa.
+//   - El cmp/test que alimenta al jcc del final del bloque se
+//     queda pegado a él para que el front-end lo fusione (un uop).
+//   - `cvtsi2sd xmm, r64` solo escribe la parte baja de xmm y
+//     arrastra una dependencia falsa con su valor anterior:
+//     se antepone `xorps xmm, xmm` (idiom de zeroing, 0 ciclos).
+//
+// Solo se mueven ops cuyos registros, flags y memoria se modelan
+// con exactitud; cualquier otro (call, push/pop, div, rep, bytes
+// crudos, labels, saltos, escrituras a RSP/RBP) corta la región.
+// Dos accesos a memoria solo se cruzan si ambos son cargas, o si
+// usan la misma base sin índice, no escrita en la región, y sus
+// rangos [disp, disp+tamaño) no se solapan.
+// ============================================================
+
+use super::{ADeadOp, Operand, Reg};
+
+/// Región máxima que se planifica de una vez (el grafo es O(n²))
+pub const MAX_REGION: usize = 256;
+
+/// Core objetivo de `-mtune`
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Uarch {
+    Generic,
+    Skylake,
+    GoldenCove,
+    Zen3,
+    Zen4,
+}
+
+/// Latencias (ciclos) y recursos por ciclo de un core. Valores de las
+/// tablas de Agner Fog / uops.info para las formas r64 y sd escalares.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct UarchTable {
+    pub issue_width: u8,
+    pub load_ports: u8,
+    pub store_ports: u8,
+    pub alu: u8,
+    pub imul: u8,
+    pub load: u8,
+    pub fp_add: u8,
+    pub fp_mul: u8,
+    pub fp_div: u8,
+    pub cvt: u8,
+    pub gpr_xmm: u8,
+}
+
+const GENERIC: UarchTable = UarchTable {
+    issue_width: 4, load_ports: 2, store_ports: 1,
+    alu: 1, imul: 3, load: 5, fp_add: 4, fp_mul: 4, fp_div: 14, cvt: 5, gpr_xmm: 3,
+};
+const SKYLAKE: UarchTable = UarchTable {
+    issue_width: 4, load_ports: 2, store_ports: 1,
+    alu: 1, imul: 3, load: 5, fp_add: 4, fp_mul: 4, fp_div: 14, cvt: 5, gpr_xmm: 2,
+};
+const GOLDEN_COVE: UarchTable = UarchTable {
+    issue_width: 6, load_ports: 3, store_ports: 2,
+    alu: 1, imul: 3, load: 5, fp_add: 2, fp_mul: 4, fp_div: 13, cvt: 5, gpr_xmm: 3,
+};
+const ZEN3: UarchTable = UarchTable {
+    issue_width: 6, load_ports: 3, store_ports: 2,
+    alu: 1, imul: 3, load: 4, fp_add: 3, fp_mul: 3, fp_div: 13, cvt: 4, gpr_xmm: 3,
+};
+const ZEN4: UarchTable = UarchTable {
+    issue_width: 6, load_ports: 3, store_ports: 2,
+    alu: 1, imul: 3, load: 4, fp_add: 3, fp_mul: 3, fp_div: 13, cvt: 4, gpr_xmm: 3,
+};
+
+impl Uarch {
+    /// Nombres de `-mtune` (los de GCC/Clang y alias cortos)
+    pub fn from_name(name: &str) -> Option<Self> {
+        match name {
+            "generic" => Some(Uarch::Generic),
+            "skylake" | "skylake-avx512" | "cascadelake" | "skl" => Some(Uarch::Skylake),
+            "golden-cove" | "goldencove" | "alderlake" | "sapphirerapids" | "glc" => Some(Uarch::GoldenCove),
+            "znver3" | "zen3" => Some(Uarch::Zen3),
+            "znver4" | "zen4" => Some(Uarch::Zen4),
+            _ => None,
+        }
+    }
+
+    pub fn name(self) -> &'static str {
+        match self {
+            Uarch::Generic => "generic",
+            Uarch::Skylake => "skylake",
+            Uarch::GoldenCove => "golden-cove",
+            Uarch::Zen3 => "znver3",
+            Uarch::Zen4 => "znver4",
+        }
+    }
+
+    pub fn table(self) -> &'static UarchTable {
+        match self {
+            Uarch::Generic => &GENERIC,
+            Uarch::Skylake => &SKYLAKE,
+            Uarch::GoldenCove => &GOLDEN_COVE,
+            Uarch::Zen3 => &ZEN3,
+            Uarch::Zen4 => &ZEN4,
+        }
+    }
+}
+
+/// Resultado de una pasada de `schedule`
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct ScheduleStats {
+    /// Ops que cambiaron de posición
+    pub moved: usize,
+    /// cmp/test que se dejaron pegados a su jcc
+    pub fused_pairs: usize,
+    /// `xorps` insertados antes de cvtsi2sd
+    pub false_deps_broken: usize,
+}
+
+#[derive(Debug, Clone, Copy, PartialEq)]
+enum OpClass {
+    Alu,
+    Imul,
+    Load,
+    Store,
+    FpAdd,
+    FpMul,
+    FpDiv,
+    Cvt,
+    GprXmm,
+}
+
+/// Recursos: GPR 0-15, XMM 16-31, FLAGS 32
+const FLAGS: u8 = 32;
+
+#[derive(Debug, Clone, Copy, PartialEq)]
+struct MemAccess {
+    store: bool,
+    base: u8,
+    index: Option<u8>,
+    disp: i32,
+    size: i32,
+}
+
+#[derive(Debug, Clone, Default)]
+struct Effects {
+    reads: Vec<u8>,
+    writes: Vec<u8>,
+    mem: Vec<MemAccess>,
+}
+
+/// (recurso, escritura completa). Las de 8/16 bits mezclan con el valor
+/// anterior, así que cuentan también como lectura.
+fn resource(reg: &Reg) -> Option<(u8, bool)> {
+    use Reg::*;
+    let r = match reg {
+        RAX | EAX => (0, true),
+        RCX | ECX => (1, true),
+        RDX | EDX => (2, true),
+        RBX | EBX => (3, true),
+        RSP | ESP => (4, true),
+        RBP | EBP => (5, true),
+        RSI | ESI => (6, true),
+        RDI | EDI => (7, true),
+        R8 => (8, true),
+        R9 => (9, true),
+        R10 => (10, true),
+        R11 => (11, true),
+        R12 => (12, true),
+        R13 => (13, true),
+        R14 => (14, true),
+        R15 => (15, true),
+        AX | AL | AH => (0, false),
+        CX | CL | CH => (1, false),
+        DX | DL | DH => (2, false),
+        BX | BL | BH => (3, false),
+        SP => (4, false),
+        BP => (5, false),
+        SI => (6, false),
+        DI => (7, false),
+        XMM0 | YMM0 => (16, false),
+        XMM1 | YMM1 => (17, false),
+        XMM2 | YMM2 => (18, false),
+        XMM3 | YMM3 => (19, false),
+        XMM4 | YMM4 => (20, false),
+        XMM5 | YMM5 => (21, false),
+        XMM6 | YMM6 => (22, false),
+        XMM7 | YMM7 => (23, false),
+        XMM8 | YMM8 => (24, false),
+        XMM9 | YMM9 => (25, false),
+        XMM10 | YMM10 => (26, false),
+        XMM11 | YMM11 => (27, false),
+        XMM12 | YMM12 => (28, false),
+        XMM13 | YMM13 => (29, false),
+        XMM14 | YMM14 => (30, false),
+        XMM15 | YMM15 => (31, false),
+        _ => return None,
+    };
+    Some(r)
+}
+
+impl Effects {
+    fn read(&mut self, reg: &Reg) -> Option<()> {
+        self.reads.push(resource(reg)?.0);
+        Some(())
+    }
+
+    fn write(&mut self, reg: &Reg) -> Option<()> {
+        let (id, full) = resource(reg)?;
+        if !full {
+            self.reads.push(id);
+        }
+        self.writes.push(id);
+        Some(())
+    }
+
+    /// Un registro de destino de 64 bits que sí sobrescribe entero
+    fn write_full(&mut self, reg: &Reg) -> Option<()> {
+        self.writes.push(resource(reg)?.0);
+        Some(())
+    }
+
+    fn access(&mut self, store: bool, base: &Reg, index: Option<&Reg>, disp: i32, size: i32) -> Option<()> {
+        let base = resource(base)?.0;
+        let index = match index {
+            Some(r) => Some(resource(r)?.0),
+            None => None,
+        };
+        self.reads.push(base);
+        self.reads.extend(index);
+        self.mem.push(MemAccess { store, base, index, disp, size });
+        Some(())
+    }
+
+    /// Operando fuente: registro, inmediato o memoria (carga de 8 bytes)
+    fn source(&mut self, op: &Operand) -> Option<()> {
+        match op {
+            Operand::Reg(r) => self.read(r),
+            Operand::Imm64(_) | Operand::Imm32(_) | Operand::Imm16(_) | Operand::Imm8(_) => Some(()),
+            Operand::Mem { base, disp } => self.access(false, base, None, *disp, 8),
+            Operand::MemSIB { base, index, disp, .. } => self.access(false, base, Some(index), *disp, 8),
+            Operand::RipRel(_) => None,
+        }
+    }
+
+    /// Operando destino; `also_read` para read-modify-write (add, inc...)
+    fn dest(&mut self, op: &Operand, also_read: bool) -> Option<()> {
+        match op {
+            Operand::Reg(r) => {
+                if also_read {
+                    self.read(r)?;
+                }
+                self.write(r)
+            }
+            Operand::Mem { base, disp } => {
+                if also_read {
+                    self.access(false, base, None, *disp, 8)?;
+                }
+                self.access(true, base, None, *disp, 8)
+            }
+            Operand::MemSIB { base, index, disp, .. } => {
+                if also_read {
+                    self.access(false, base, Some(index), *disp, 8)?;
+                }
+                self.access(true, base, Some(index), *disp, 8)
+            }
+            _ => None,
+        }
+    }
+}
+
+/// Efectos y clase de `op`, o None si no se puede mover
+fn analyze(op: &ADeadOp) -> Option<(Effects, OpClass)> {
+    let mut e = Effects::default();
+    let class = match op {
+        ADeadOp::Mov { dst, src } => {
+            e.source(src)?;
+            e.dest(dst, false)?;
+            mem_class(&e, OpClass::Alu)
+        }
+        ADeadOp::MovZx { dst, src } => {
+            e.read(src)?;
+            e.write_full(dst)?;
+            OpClass::Alu
+        }
+        ADeadOp::Load8 { dst, base, disp } | ADeadOp::Load16 { dst, base, disp } | ADeadOp::Load32 { dst, base, disp } => {
+            let size = match op {
+                ADeadOp::Load8 { .. } => 1,
+                ADeadOp::Load16 { .. } => 2,
+                _ => 4,
+            };
+            e.access(false, base, None, *disp, size)?;
+            e.write_full(dst)?;
+            OpClass::Load
+        }
+        ADeadOp::Store8 { base, disp, src } | ADeadOp::Store16 { base, disp, src } | ADeadOp::Store32 { base, disp, src } => {
+            let size = match op {
+                ADeadOp::Store8 { .. } => 1,
+                ADeadOp::Store16 { .. } => 2,
+                _ => 4,
+            };
+            e.read(src)?;
+            e.access(true, base, None, *disp, size)?;
+            OpClass::Store
+        }
+        ADeadOp::Lea { dst, src } => {
+            match src {
+                Operand::Mem { base, .. } => e.read(base)?,
+                Operand::MemSIB { base, index, .. } => {
+                    e.read(base)?;
+                    e.read(index)?
+                }
+                _ => return None,
+            }
+            e.write(dst)?;
+            OpClass::Alu
+        }
+        ADeadOp::Add { dst, src } | ADeadOp::Sub { dst, src } => {
+            e.source(src)?;
+            e.dest(dst, true)?;
+            e.writes.push(FLAGS);
+            mem_class(&e, OpClass::Alu)
+        }
+        ADeadOp::Inc { dst } | ADeadOp::Dec { dst } => {
+            e.dest(dst, true)?;
+            e.writes.push(FLAGS);
+            mem_class(&e, OpClass::Alu)
+        }
+        ADeadOp::Mul { dst, src } => {
+            e.read(src)?;
+            e.read(dst)?;
+            e.write(dst)?;
+            e.writes.push(FLAGS);
+            OpClass::Imul
+        }
+        ADeadOp::And { dst, src } | ADeadOp::Or { dst, src } | ADeadOp::Xor { dst, src } => {
+            // xor r, r es un zeroing idiom: no lee r
+            let zeroing = matches!(op, ADeadOp::Xor { .. }) && dst == src;
+            if !zeroing {
+                e.read(src)?;
+                e.read(dst)?;
+            }
+            e.write(dst)?;
+            e.writes.push(FLAGS);
+            OpClass::Alu
+        }
+        ADeadOp::Neg { dst } | ADeadOp::Shl { dst, .. } | ADeadOp::Sar { dst, .. } | ADeadOp::Shr { dst, .. } => {
+            e.read(dst)?;
+            e.write(dst)?;
+            e.writes.push(FLAGS);
+            OpClass::Alu
+        }
+        ADeadOp::BitwiseNot { dst } => {
+            e.read(dst)?;
+            e.write(dst)?;
+            OpClass::Alu
+        }
+        // test r, r; sete al; movzx rax, al
+        ADeadOp::Not { dst } => {
+            e.read(dst)?;
+            e.write_full(&Reg::RAX)?;
+            e.writes.push(FLAGS);
+            OpClass::Alu
+        }
+        ADeadOp::Cmp { left, right } => {
+            e.source(left)?;
+            e.source(right)?;
+            e.writes.push(FLAGS);
+            mem_class(&e, OpClass::Alu)
+        }
+        ADeadOp::Test { left, right } => {
+            e.read(left)?;
+            e.read(right)?;
+            e.writes.push(FLAGS);
+            OpClass::Alu
+        }
+        // El encoder siempre emite setcc al
+        ADeadOp::SetCC { .. } => {
+            e.reads.push(FLAGS);
+            e.write(&Reg::AL)?;
+            OpClass::Alu
+        }
+        ADeadOp::CvtSi2Sd { dst, src } => {
+            e.read(src)?;
+            e.write(dst)?;
+            OpClass::Cvt
+        }
+        ADeadOp::CvtTsd2Si { dst, src } => {
+            e.read(src)?;
+            e.write_full(dst)?;
+            OpClass::Cvt
+        }
+        ADeadOp::MovQ { dst, src } => {
+            e.read(src)?;
+            e.write_full(dst)?;
+            OpClass::GprXmm
+        }
+        ADeadOp::Addsd { dst, src } | ADeadOp::Subsd { dst, src } | ADeadOp::Mulsd { dst, src } | ADeadOp::Divsd { dst, src } => {
+            e.read(src)?;
+            e.write(dst)?;
+            match op {
+                ADeadOp::Mulsd { .. } => OpClass::FpMul,
+                ADeadOp::Divsd { .. } => OpClass::FpDiv,
+                _ => OpClass::FpAdd,
+            }
+        }
+        ADeadOp::MovsdLoad { dst, base, disp } => {
+            e.access(false, base, None, *disp, 8)?;
+            e.write_full(dst)?;
+            OpClass::Load
+        }
+        ADeadOp::MovsdStore { base, disp, src } => {
+            e.read(src)?;
+            e.access(true, base, None, *disp, 8)?;
+            OpClass::Store
+        }
+        _ => return None,
+    };
+    // RSP/RBP delimitan el frame: moverlos cambiaría qué memoria es válida
+    if e.writes.iter().any(|&r| r == 4 || r == 5) {
+        return None;
+    }
+    Some((e, class))
+}
+
+fn mem_class(e: &Effects, reg_class: OpClass) -> OpClass {
+    if e.mem.iter().any(|m| m.store) {
+        OpClass::Store
+    } else if !e.mem.is_empty() {
+        OpClass::Load
+    } else {
+        reg_class
+    }
+}
+
+fn latency(class: OpClass, t: &UarchTable) -> u32 {
+    (match class {
+        OpClass::Alu => t.alu,
+        OpClass::Imul => t.imul,
+        OpClass::Load => t.load,
+        OpClass::Store => 1,
+        OpClass::FpAdd => t.fp_add,
+        OpClass::FpMul => t.fp_mul,
+        OpClass::FpDiv => t.fp_div,
+        OpClass::Cvt => t.cvt,
+        OpClass::GprXmm => t.gpr_xmm,
+    }) as u32
+}
+
+/// Los dos accesos pueden tocar los mismos bytes
+fn may_alias(a: &MemAccess, b: &MemAccess, written: &[bool; 33]) -> bool {
+    if !a.store && !b.store {
+        return false;
+    }
+    let same_slot_base = a.base == b.base && a.index.is_none() && b.index.is_none() && !written[a.base as usize];
+    if !same_slot_base {
+        return true;
+    }
+    let (a0, a1) = (a.disp as i64, a.disp as i64 + a.size as i64);
+    let (b0, b1) = (b.disp as i64, b.disp as i64 + b.size as i64);
+    a0 < b1 && b0 < a1
+}
+
+/// Planifica todas las regiones de `ops` para `tune`
+pub fn schedule(ops: &mut Vec<ADeadOp>, tune: Uarch) -> ScheduleStats {
+    let mut stats = ScheduleStats::default();
+    stats.false_deps_broken = break_false_dependencies(ops);
+
+    let table = tune.table();
+    let mut out = Vec::with_capacity(ops.len());
+    let mut region: Vec<(ADeadOp, Effects, OpClass)> = Vec::new();
+    for op in std::mem::take(ops) {
+        match analyze(&op) {
+            Some((effects, class)) if region.len() < MAX_REGION => region.push((op, effects, class)),
+            analyzed => {
+                let fuses = matches!(op, ADeadOp::Jcc { .. });
+                flush_region(&mut region, fuses, table, &mut out, &mut stats);
+                match analyzed {
+                    Some((effects, class)) => region.push((op, effects, class)),
+                    None => out.push(op),
+                }
+            }
+        }
+    }
+    flush_region(&mut region, false, table, &mut out, &mut stats);
+    *ops = out;
+    stats
+}
+
+/// `xorps xmm, xmm` antes de cada `cvtsi2sd xmm, r64`
+fn break_false_dependencies(ops: &mut Vec<ADeadOp>) -> usize {
+    let mut inserted = 0;
+    let mut out = Vec::with_capacity(ops.len());
+    for op in std::mem::take(ops) {
+        if let ADeadOp::CvtSi2Sd { dst, .. } = &op {
+            if let Some(zero) = xorps_zero(dst) {
+                if out.last() != Some(&zero) {
+                    out.push(zero);
+                    inserted += 1;
+                }
+            }
+        }
+        out.push(op);
+    }
+    *ops = out;
+    inserted
+}
+
+/// xorps xmm, xmm (0F 57 /r). Solo XMM0-7: el encoder de cvtsi2sd
+/// no emite REX.R para el destino.
+fn xorps_zero(reg: &Reg) -> Option<ADeadOp> {
+    let idx = resource(reg)?.0.checked_sub(16).filter(|&i| i < 8)?;
+    Some(ADeadOp::RawBytes(vec![0x0F, 0x57, 0xC0 | (idx << 3) | idx]))
+}
+
+/// List scheduling de una región sin barreras. `fuses`: la sigue un
+/// jcc, así que el último escritor de flags debe quedar al final.
+fn flush_region(
+    region: &mut Vec<(ADeadOp, Effects, OpClass)>,
+    fuses: bool,
+    table: &UarchTable,
+    out: &mut Vec<ADeadOp>,
+    stats: &mut ScheduleStats,
+) {
+    let n = region.len();
+    if n < 2 {
+        out.extend(region.drain(..).map(|(op, ..)| op));
+        return;
+    }
+
+    let mut written = [false; 33];
+    for (_, e, _) in region.iter() {
+        for &w in &e.writes {
+            written[w as usize] = true;
+        }
+    }
+    let lat: Vec<u32> = region.iter().map(|(_, _, c)| latency(*c, table)).collect();
+
+    // preds[j] = (i, latencia de la arista). Los flags van aparte: casi
+    // todas las ALU los escriben y casi nadie los lee.
+    let mut preds: Vec<Vec<(usize, u32)>> = vec![Vec::new(); n];
+    for j in 0..n {
+        let ej = &region[j].1;
+        for i in 0..j {
+            let ei = &region[i].1;
+            let hits = |a: &[u8], b: &[u8]| a.iter().any(|r| *r != FLAGS && b.contains(r));
+            let raw = hits(&ei.writes, &ej.reads);
+            let war = hits(&ei.reads, &ej.writes);
+            let waw = hits(&ei.writes, &ej.writes);
+            let mem = ei.mem.iter().any(|a| ej.mem.iter().any(|b| may_alias(a, b, &written)));
+            let store_to_load = mem && ei.mem.iter().any(|a| a.store);
+            if raw || store_to_load {
+                preds[j].push((i, lat[i]));
+            } else if war || waw || mem {
+                preds[j].push((i, 0));
+            }
+        }
+    }
+    add_flag_edges(region, &lat, &mut preds);
+
+    // Macro-fusión: si nada depende del último escritor de flags, va al final
+    if fuses {
+        if let Some(f) = (0..n).rev().find(|&i| region[i].1.writes.contains(&FLAGS)) {
+            let mut reached = vec![false; n];
+            reached[f] = true;
+            for j in f + 1..n {
+                reached[j] = preds[j].iter().any(|&(i, _)| reached[i]);
+            }
+            if !reached[f + 1..].iter().any(|&r| r) {
+                for j in 0..n {
+                    if j != f && !preds[f].iter().any(|&(i, _)| i == j) {
+                        preds[f].push((j, 0));
+                    }
+                }
+                stats.fused_pairs += 1;
+            }
+        }
+    }
+
+    let mut succs: Vec<Vec<(usize, u32)>> = vec![Vec::new(); n];
+    for (j, ps) in preds.iter().enumerate() {
+        for &(i, l) in ps {
+            succs[i].push((j, l));
+        }
+    }
+    // Altura: camino crítico hasta el final de la región. El pin de
+    // fusión añade aristas hacia atrás en índice, así que se itera
+    // sobre un orden topológico en vez de por índice.
+    let topo = topological_order(&preds);
+    let mut height = vec![0u32; n];
+    for &i in topo.iter().rev() {
+        height[i] = succs[i].iter().map(|&(j, l)| l + height[j]).max().unwrap_or(0).max(lat[i]);
+    }
+
+    let mut remaining: Vec<usize> = preds.iter().map(|p| p.len()).collect();
+    let mut earliest = vec![0u32; n];
+    let mut done = vec![false; n];
+    let mut order = Vec::with_capacity(n);
+    let mut cycle = 0u32;
+    while order.len() < n {
+        let (mut issued, mut loads, mut stores) = (0u8, 0u8, 0u8);
+        loop {
+            let pick = (0..n)
+                .filter(|&i| !done[i] && remaining[i] == 0 && earliest[i] <= cycle)
+                .filter(|&i| match region[i].2 {
+                    OpClass::Load => loads < table.load_ports,
+                    OpClass::Store => stores < table.store_ports,
+                    _ => true,
+                })
+                .max_by_key(|&i| (height[i], std::cmp::Reverse(i)));
+            let Some(i) = pick.filter(|_| issued < table.issue_width) else {
+                break;
+            };
+            done[i] = true;
+            order.push(i);
+            issued += 1;
+            match region[i].2 {
+                OpClass::Load => loads += 1,
+                OpClass::Store => stores += 1,
+                _ => {}
+            }
+            for &(j, l) in &succs[i] {
+                remaining[j] -= 1;
+                earliest[j] = earliest[j].max(cycle + l);
+            }
+        }
+        cycle += 1;
+    }
+
+    stats.moved += order.iter().enumerate().filter(|&(k, &i)| k != i).count();
+    let mut slots: Vec<Option<ADeadOp>> = region.drain(..).map(|(op, ..)| Some(op)).collect();
+    out.extend(order.into_iter().filter_map(|i| slots[i].take()));
+}
+
+/// Intervalos vivos de los flags: (escritor, lectores). Un escritor vive
+/// si alguien lee sus flags antes del siguiente; el último de la región
+/// vive siempre (puede leerlos el jcc o lo que venga detrás). Los
+/// escritores muertos se mueven libres entre sí, pero nunca dentro de un
+/// intervalo vivo.
+fn add_flag_edges(region: &[(ADeadOp, Effects, OpClass)], lat: &[u32], preds: &mut [Vec<(usize, u32)>]) {
+    let n = region.len();
+    let writes = |i: usize| region[i].1.writes.contains(&FLAGS);
+    let mut intervals: Vec<(Option<usize>, Vec<usize>)> = vec![(None, Vec::new())];
+    for i in 0..n {
+        if region[i].1.reads.contains(&FLAGS) {
+            intervals.last_mut().unwrap().1.push(i);
+        }
+        if writes(i) {
+            intervals.push((Some(i), Vec::new()));
+        }
+    }
+    let last = intervals.len() - 1;
+    let add = |from: usize, to: usize, l: u32, preds: &mut [Vec<(usize, u32)>]| {
+        if from != to && !preds[to].iter().any(|&(p, _)| p == from) {
+            preds[to].push((from, l));
+        }
+    };
+    for (k, (writer, readers)) in intervals.iter().enumerate() {
+        if readers.is_empty() && (k != last || writer.is_none()) {
+            continue;
+        }
+        if let Some(w) = *writer {
+            for &r in readers {
+                add(w, r, lat[w], preds);
+            }
+        }
+        let start = writer.or(readers.first().copied()).unwrap();
+        let end = readers.last().copied().unwrap_or(start);
+        for x in (0..n).filter(|&x| writes(x) && Some(x) != *writer) {
+            if x < start {
+                add(x, start, 0, preds);
+            } else if x > end {
+                for &r in readers.iter().chain(writer.iter()) {
+                    add(r, x, 0, preds);
+                }
+            }
+        }
+    }
+}
+
+fn topological_order(preds: &[Vec<(usize, u32)>]) -> Vec<usize> {
+    let n = preds.len();
+    let mut remaining: Vec<usize> = preds.iter().map(|p| p.len()).collect();
+    let mut succs: Vec<Vec<usize>> = vec![Vec::new(); n];
+    for (j, ps) in preds.iter().enumerate() {
+        for &(i, _) in ps {
+            succs[i].push(j);
+        }
+    }
+    let mut ready: Vec<usize> = (0..n).filter(|&i| remaining[i] == 0).collect();
+    let mut order = Vec::with_capacity(n);
+    while let Some(i) = ready.pop() {
+        order.push(i);
+        for &j in &succs[i] {
+            remaining[j] -= 1;
+            if remaining[j] == 0 {
+                ready.push(j);
+            }
+        }
+    }
+    order
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::isa::{Condition, Label};
+
+    fn mem(disp: i32) -> Operand {
+        Operand::Mem { base: Reg::RBP, disp }
+    }
+
+    fn mov(dst: Operand, src: Operand) -> ADeadOp {
+        ADeadOp::Mov { dst, src }
+    }
+
+    #[test]
+    fn test_loads_hoist_above_independent_alu() {
+        // add rbx, rcx; add rbx, rdx; mov rax, [rbp-8]; add rax, rsi
+        let ops = vec![
+            ADeadOp::Add { dst: Operand::Reg(Reg::RBX), src: Operand::Reg(Reg::RCX) },
+            ADeadOp::Add { dst: Operand::Reg(Reg::RBX), src: Operand::Reg(Reg::RDX) },
+            mov(Operand::Reg(Reg::RAX), mem(-8)),
+            ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RSI) },
+        ];
+        let mut scheduled = ops.clone();
+        let stats = schedule(&mut scheduled, Uarch::Skylake);
+        assert_eq!(scheduled[0], ops[2]);
+        assert!(stats.moved > 0);
+        // Las dos cadenas conservan su orden interno
+        let at = |op: &ADeadOp| scheduled.iter().position(|o| o == op).unwrap();
+        assert!(at(&ops[0]) < at(&ops[1]));
+        assert!(at(&ops[2]) < at(&ops[3]));
+    }
+
+    #[test]
+    fn test_cmp_stays_next_to_jcc() {
+        // cmp rax, 10; mov rbx, [rbp-16]; jl L
+        let target = Label(0);
+        let mut ops = vec![
+            ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(10) },
+            mov(Operand::Reg(Reg::RBX), mem(-16)),
+            ADeadOp::Jcc { cond: Condition::Less, target },
+        ];
+        let stats = schedule(&mut ops, Uarch::Zen4);
+        assert!(matches!(ops[1], ADeadOp::Cmp { .. }));
+        assert!(matches!(ops[2], ADeadOp::Jcc { .. }));
+        assert_eq!(stats.fused_pairs, 1);
+    }
+
+    #[test]
+    fn test_memory_order_is_preserved() {
+        // Mismo slot: el store no puede cruzar la carga. Otro slot sí.
+        let ops = vec![
+            mov(mem(-8), Operand::Reg(Reg::RCX)),
+            ADeadOp::Add { dst: Operand::Reg(Reg::RBX), src: Operand::Reg(Reg::RDX) },
+            mov(Operand::Reg(Reg::RAX), mem(-8)),
+            mov(mem(-16), Operand::Reg(Reg::RSI)),
+            mov(Operand::Reg(Reg::RDI), Operand::Mem { base: Reg::RCX, disp: 0 }),
+        ];
+        let mut scheduled = ops.clone();
+        schedule(&mut scheduled, Uarch::GoldenCove);
+        let at = |op: &ADeadOp| scheduled.iter().position(|o| o == op).unwrap();
+        assert!(at(&ops[0]) < at(&ops[2]));
+        // [rcx] puede ser cualquier cosa: no adelanta a ningún store
+        assert!(at(&ops[0]) < at(&ops[4]));
+        assert!(at(&ops[3]) < at(&ops[4]));
+    }
+
+    #[test]
+    fn test_barriers_split_regions() {
+        let ops = vec![
+            ADeadOp::Add { dst: Operand::Reg(Reg::RBX), src: Operand::Reg(Reg::RCX) },
+            ADeadOp::Push { src: Operand::Reg(Reg::RAX) },
+            mov(Operand::Reg(Reg::RAX), mem(-8)),
+            ADeadOp::Label(Label(1)),
+            ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm32(32) },
+            mov(Operand::Reg(Reg::RDX), mem(-24)),
+        ];
+        let mut scheduled = ops.clone();
+        let stats = schedule(&mut scheduled, Uarch::Skylake);
+        assert_eq!(scheduled, ops);
+        assert_eq!(stats.moved, 0);
+    }
+
+    #[test]
+    fn test_xorps_breaks_cvtsi2sd_dependency() {
+        let mut ops = vec![ADeadOp::CvtSi2Sd { dst: Reg::XMM1, src: Reg::RAX }];
+        let stats = schedule(&mut ops, Uarch::Generic);
+        assert_eq!(ops[0], ADeadOp::RawBytes(vec![0x0F, 0x57, 0xC9]));
+        assert_eq!(stats.false_deps_broken, 1);
+        // Idempotente: una segunda pasada no añade otro xorps
+        let again = schedule(&mut ops, Uarch::Generic);
+        assert_eq!(again.false_deps_broken, 0);
+        assert_eq!(ops.len(), 2);
+    }
+
+    #[test]
+    fn test_tune_names() {
+        assert_eq!(Uarch::from_name("znver3"), Some(Uarch::Zen3));
+        assert_eq!(Uarch::from_name("alderlake"), Some(Uarch::GoldenCove));
+        assert_eq!(Uarch::from_name("skylake").map(|u| u.table().issue_width), Some(4));
+        assert_eq!(Uarch::from_name("pentium4"), None);
+    }
+}
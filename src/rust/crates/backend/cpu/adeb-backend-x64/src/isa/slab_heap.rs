@@ -0,0 +1,624 @@
+// ============================================================
+// ADead-BIB — Heap propio: slabs por clase de tamaño
+// ============================================================
+// malloc/free/calloc/realloc (y new/delete de C++, que bajan a
+// malloc/free) sin pasar por el heap del sistema:
+//
+//   ≤ 2048 bytes → 8 clases (16, 32 … 2048). Cada clase tiene su
+//                  free list y un slab de 64 KiB del que se corta
+//                  por bump pointer cuando la lista está vacía
+//   > 2048 bytes → páginas propias (mmap / VirtualAlloc), devueltas
+//                  al sistema en free
+//
+// Cada bloque lleva 16 bytes de cabecera: [0] = registro de su
+// clase (0 = bloque grande), [8] = bytes mapeados si es grande.
+// La memoria de usuario queda alineada a 16.
+//
+// Estado en .data, un registro de 64 bytes por clase (una línea de
+// caché, los locks no se comparten): free, cur, end, lock, tamaño.
+// Detrás, las estadísticas que devuelve adb_heap_stats().
+//
+// Hilos: no hay TLS en las imágenes que salen de aquí (sin directorio
+// TLS en el PE, sin FS en el proceso Linux), así que no hay cachés
+// por hilo: cada clase se protege con un spinlock (xchg) que sin
+// contención cuesta lo que una instrucción atómica.
+//
+// Registros: las rutinas siguen el ABI del target (argumentos en
+// RCX/RDX o RDI/RSI, resultado en RAX) y solo tocan caller-saved;
+// RSI/RDI se guardan donde se usan (callee-saved en Windows).
+// ============================================================
+
+use super::{ADeadIR, ADeadOp, CallTarget, Condition, Label, Operand, Reg};
+
+/// Tamaño útil de cada clase
+pub const SIZE_CLASSES: [u32; 8] = [16, 32, 64, 128, 256, 512, 1024, 2048];
+pub const HEADER_SIZE: i32 = 16;
+pub const SLAB_SIZE: i32 = 64 * 1024;
+const PAGE_SIZE: i32 = 4096;
+/// Por encima de 2^46 ni se intenta (el redondeo a página desbordaría)
+const MAX_LARGE: u64 = 1 << 46;
+
+const CLASS_RECORD: u64 = 64;
+const FREE: i32 = 0;
+const CUR: i32 = 8;
+const END: i32 = 16;
+const LOCK: i32 = 24;
+const SIZE: i32 = 32;
+
+/// Offset de las estadísticas dentro del estado
+pub const STATS_OFFSET: u64 = SIZE_CLASSES.len() as u64 * CLASS_RECORD;
+/// Campos de adb_heap_stats_t, en orden
+pub const STATS_FIELDS: [&str; 5] = ["allocs", "frees", "in_use", "mapped", "large_allocs"];
+const ALLOCS: i8 = 0;
+const FREES: i8 = 8;
+const IN_USE: i8 = 16;
+const MAPPED: i8 = 24;
+const LARGE_ALLOCS: i8 = 32;
+
+/// Global del estado (no choca con nombres de C)
+pub const STATE_SLOT: &str = "__heap.state";
+pub const STATE_ALIGN: u64 = 64;
+
+const SYS_MMAP: i32 = 9;
+const SYS_MUNMAP: i32 = 11;
+const PROT_READ_WRITE: i32 = 3;
+const MAP_PRIVATE_ANONYMOUS: i32 = 0x22;
+const MEM_COMMIT_RESERVE: i32 = 0x3000;
+const PAGE_READWRITE: i32 = 4;
+const MEM_RELEASE: i32 = 0x8000;
+
+/// De dónde salen las páginas
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum PageSource {
+    /// Linux: mmap/munmap por syscall
+    Syscall,
+    /// Windows: VirtualAlloc/VirtualFree por la IAT
+    Iat { alloc_rva: u32, free_rva: u32 },
+}
+
+/// Clase de un tamaño pedido; None = bloque grande
+pub fn size_class(size: u64) -> Option<usize> {
+    SIZE_CLASSES.iter().position(|&c| size <= c as u64)
+}
+
+/// Contenido inicial del estado: listas vacías y el tamaño de cada clase
+pub fn initial_state() -> Vec<u8> {
+    let mut state = vec![0u8; STATS_OFFSET as usize + STATS_FIELDS.len() * 8];
+    for (k, &size) in SIZE_CLASSES.iter().enumerate() {
+        let at = k * CLASS_RECORD as usize + SIZE as usize;
+        state[at..at + 8].copy_from_slice(&(size as u64).to_le_bytes());
+    }
+    state
+}
+
+/// Estado en .data y labels de las rutinas
+#[derive(Debug, Clone, Copy)]
+pub struct SlabHeap {
+    pub state: u64,
+    source: PageSource,
+    args: [Reg; 2],
+    pub malloc: Label,
+    pub free: Label,
+    pub calloc: Label,
+    pub realloc: Label,
+    /// adb_heap_stats(out): copia las estadísticas, RAX = 0
+    pub stats: Label,
+    map: Label,
+    unmap: Label,
+}
+
+fn mov(ir: &mut ADeadIR, dst: Reg, src: Operand) {
+    ir.emit(ADeadOp::Mov { dst: Operand::Reg(dst), src });
+}
+
+fn mem(base: Reg, disp: i32) -> Operand {
+    Operand::Mem { base, disp }
+}
+
+fn store(ir: &mut ADeadIR, base: Reg, disp: i32, src: Reg) {
+    ir.emit(ADeadOp::Mov { dst: mem(base, disp), src: Operand::Reg(src) });
+}
+
+fn jcc(ir: &mut ADeadIR, cond: Condition, target: Label) {
+    ir.emit(ADeadOp::Jcc { cond, target });
+}
+
+fn call(ir: &mut ADeadIR, target: Label) {
+    ir.emit(ADeadOp::Call { target: CallTarget::Relative(target) });
+}
+
+fn push(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Push { src: Operand::Reg(reg) });
+}
+
+fn pop(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Pop { dst: reg });
+}
+
+fn add_imm(ir: &mut ADeadIR, reg: Reg, imm: i32) {
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(reg), src: Operand::Imm32(imm) });
+}
+
+/// lock add qword [R11 + disp], src — contador de estadísticas
+fn lock_add_stat(ir: &mut ADeadIR, disp: i8, src: Reg) {
+    let reg = match src {
+        Reg::RAX => 0,
+        Reg::RCX => 1,
+        Reg::RDX => 2,
+        _ => unreachable!("lock add solo desde RAX/RCX/RDX"),
+    };
+    // F0 = lock, REX.W+B (R11), 01 /r = add r/m64, r64, mod=01 rm=011
+    ir.emit(ADeadOp::RawBytes(vec![0xF0, 0x49, 0x01, 0x43 | (reg << 3), disp as u8]));
+}
+
+/// Spinlock de la clase en R8 (RCX de trabajo)
+fn acquire(ir: &mut ADeadIR) {
+    let spin = ir.new_label();
+    let got = ir.new_label();
+    ir.emit(ADeadOp::Label(spin));
+    mov(ir, Reg::RCX, Operand::Imm32(1));
+    // xchg [r8 + LOCK], rcx (lock implícito)
+    ir.emit(ADeadOp::RawBytes(vec![0x49, 0x87, 0x48, LOCK as u8]));
+    ir.emit(ADeadOp::Test { left: Reg::RCX, right: Reg::RCX });
+    jcc(ir, Condition::Equal, got);
+    // pause
+    ir.emit(ADeadOp::RawBytes(vec![0xF3, 0x90]));
+    ir.emit(ADeadOp::Jmp { target: spin });
+    ir.emit(ADeadOp::Label(got));
+}
+
+fn release(ir: &mut ADeadIR) {
+    ir.emit(ADeadOp::Xor { dst: Reg::RCX, src: Reg::RCX });
+    store(ir, Reg::R8, LOCK, Reg::RCX);
+}
+
+/// RCX = bytes → RAX = páginas a cero, o 0 (también la usan task_pool.rs,
+/// par_algorithms.rs, flat_hash.rs y btree.rs)
+pub fn emit_page_map(ir: &mut ADeadIR, label: Label, source: PageSource) {
+    ir.emit(ADeadOp::Label(label));
+    SlabHeap::aligned_frame(ir);
+    match source {
+        PageSource::Syscall => {
+            let ok = ir.new_label();
+            push(ir, Reg::RSI);
+            push(ir, Reg::RDI);
+            mov(ir, Reg::RSI, Operand::Reg(Reg::RCX));
+            ir.emit(ADeadOp::Xor { dst: Reg::RDI, src: Reg::RDI });
+            mov(ir, Reg::RDX, Operand::Imm32(PROT_READ_WRITE));
+            mov(ir, Reg::R10, Operand::Imm32(MAP_PRIVATE_ANONYMOUS));
+            mov(ir, Reg::R8, Operand::Imm32(-1));
+            ir.emit(ADeadOp::Xor { dst: Reg::R9, src: Reg::R9 });
+            mov(ir, Reg::RAX, Operand::Imm32(SYS_MMAP));
+            ir.emit(ADeadOp::Syscall);
+            pop(ir, Reg::RDI);
+            pop(ir, Reg::RSI);
+            // -errno está en [-4095, -1]
+            ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(-PAGE_SIZE) });
+            jcc(ir, Condition::BelowEq, ok);
+            ir.emit(ADeadOp::Xor { dst: Reg::RAX, src: Reg::RAX });
+            ir.emit(ADeadOp::Label(ok));
+        }
+        PageSource::Iat { alloc_rva, .. } => {
+            mov(ir, Reg::RDX, Operand::Reg(Reg::RCX));
+            ir.emit(ADeadOp::Xor { dst: Reg::RCX, src: Reg::RCX });
+            mov(ir, Reg::R8, Operand::Imm32(MEM_COMMIT_RESERVE));
+            mov(ir, Reg::R9, Operand::Imm32(PAGE_READWRITE));
+            ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(32) });
+            ir.emit(ADeadOp::Cld);
+            ir.emit(ADeadOp::CallIAT { iat_rva: alloc_rva });
+        }
+    }
+    SlabHeap::leave(ir);
+}
+
+/// RCX = dirección, RDX = bytes (también la usan par_algorithms.rs,
+/// flat_hash.rs y btree.rs)
+pub fn emit_page_unmap(ir: &mut ADeadIR, label: Label, source: PageSource) {
+    ir.emit(ADeadOp::Label(label));
+    SlabHeap::aligned_frame(ir);
+    match source {
+        PageSource::Syscall => {
+            push(ir, Reg::RSI);
+            push(ir, Reg::RDI);
+            mov(ir, Reg::RDI, Operand::Reg(Reg::RCX));
+            mov(ir, Reg::RSI, Operand::Reg(Reg::RDX));
+            mov(ir, Reg::RAX, Operand::Imm32(SYS_MUNMAP));
+            ir.emit(ADeadOp::Syscall);
+            pop(ir, Reg::RDI);
+            pop(ir, Reg::RSI);
+        }
+        PageSource::Iat { free_rva, .. } => {
+            ir.emit(ADeadOp::Xor { dst: Reg::RDX, src: Reg::RDX });
+            mov(ir, Reg::R8, Operand::Imm32(MEM_RELEASE));
+            ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(32) });
+            ir.emit(ADeadOp::Cld);
+            ir.emit(ADeadOp::CallIAT { iat_rva: free_rva });
+        }
+    }
+    SlabHeap::leave(ir);
+}
+
+impl SlabHeap {
+    /// `windows`: argumentos en RCX/RDX, si no RDI/RSI
+    pub fn new(ir: &mut ADeadIR, state: u64, source: PageSource, windows: bool) -> Self {
+        Self {
+            state,
+            source,
+            args: if windows { [Reg::RCX, Reg::RDX] } else { [Reg::RDI, Reg::RSI] },
+            malloc: ir.new_label(),
+            free: ir.new_label(),
+            calloc: ir.new_label(),
+            realloc: ir.new_label(),
+            stats: ir.new_label(),
+            map: ir.new_label(),
+            unmap: ir.new_label(),
+        }
+    }
+
+    pub fn emit_routines(&self, ir: &mut ADeadIR) {
+        self.emit_map(ir);
+        self.emit_unmap(ir);
+        self.emit_malloc(ir);
+        self.emit_free(ir);
+        self.emit_calloc(ir);
+        self.emit_realloc(ir);
+        self.emit_stats(ir);
+    }
+
+    fn stats_base(&self, ir: &mut ADeadIR) {
+        mov(ir, Reg::R11, Operand::Imm64(self.state + STATS_OFFSET));
+    }
+
+    /// Prólogo/epílogo que alinea RSP a 16 para la llamada al sistema
+    fn aligned_frame(ir: &mut ADeadIR) {
+        push(ir, Reg::RBP);
+        mov(ir, Reg::RBP, Operand::Reg(Reg::RSP));
+        mov(ir, Reg::RAX, Operand::Imm32(-16));
+        ir.emit(ADeadOp::And { dst: Reg::RSP, src: Reg::RAX });
+    }
+
+    fn leave(ir: &mut ADeadIR) {
+        mov(ir, Reg::RSP, Operand::Reg(Reg::RBP));
+        pop(ir, Reg::RBP);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    fn emit_map(&self, ir: &mut ADeadIR) {
+        emit_page_map(ir, self.map, self.source);
+    }
+
+    fn emit_unmap(&self, ir: &mut ADeadIR) {
+        emit_page_unmap(ir, self.unmap, self.source);
+    }
+
+    fn emit_malloc(&self, ir: &mut ADeadIR) {
+        let small = ir.new_label();
+        let large = ir.new_label();
+        let bump = ir.new_label();
+        let carve = ir.new_label();
+        let got = ir.new_label();
+        let oom = ir.new_label();
+        let fail = ir.new_label();
+        let classes: Vec<Label> = SIZE_CLASSES.iter().map(|_| ir.new_label()).collect();
+
+        ir.emit(ADeadOp::Label(self.malloc));
+        mov(ir, Reg::R10, Operand::Reg(self.args[0]));
+        for (&size, &label) in SIZE_CLASSES.iter().zip(&classes) {
+            ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R10), right: Operand::Imm32(size as i32) });
+            jcc(ir, Condition::BelowEq, label);
+        }
+        ir.emit(ADeadOp::Jmp { target: large });
+        for (k, &label) in classes.iter().enumerate() {
+            ir.emit(ADeadOp::Label(label));
+            mov(ir, Reg::R8, Operand::Imm64(self.state + k as u64 * CLASS_RECORD));
+            ir.emit(ADeadOp::Jmp { target: small });
+        }
+
+        // ---- clase en R8: free list, si no bump del slab ----
+        ir.emit(ADeadOp::Label(small));
+        acquire(ir);
+        mov(ir, Reg::RAX, mem(Reg::R8, FREE));
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, bump);
+        mov(ir, Reg::RCX, mem(Reg::RAX, 0));
+        store(ir, Reg::R8, FREE, Reg::RCX);
+        ir.emit(ADeadOp::Jmp { target: got });
+
+        ir.emit(ADeadOp::Label(bump));
+        mov(ir, Reg::R9, mem(Reg::R8, SIZE));
+        add_imm(ir, Reg::R9, HEADER_SIZE);
+        mov(ir, Reg::RAX, mem(Reg::R8, CUR));
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RAX));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RCX), src: Operand::Reg(Reg::R9) });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: mem(Reg::R8, END) });
+        jcc(ir, Condition::BelowEq, carve);
+        // Slab agotado (o el primero): uno nuevo, lo que quede del viejo se pierde
+        push(ir, Reg::R8);
+        push(ir, Reg::R9);
+        mov(ir, Reg::RCX, Operand::Imm32(SLAB_SIZE));
+        call(ir, self.map);
+        pop(ir, Reg::R9);
+        pop(ir, Reg::R8);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, oom);
+        ir.emit(ADeadOp::Lea { dst: Reg::RCX, src: mem(Reg::RAX, SLAB_SIZE) });
+        store(ir, Reg::R8, END, Reg::RCX);
+        self.stats_base(ir);
+        mov(ir, Reg::RCX, Operand::Imm32(SLAB_SIZE));
+        lock_add_stat(ir, MAPPED, Reg::RCX);
+        mov(ir, Reg::RCX, Operand::Reg(Reg::RAX));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RCX), src: Operand::Reg(Reg::R9) });
+
+        ir.emit(ADeadOp::Label(carve));
+        store(ir, Reg::R8, CUR, Reg::RCX);
+        store(ir, Reg::RAX, 0, Reg::R8);
+        add_imm(ir, Reg::RAX, HEADER_SIZE);
+
+        ir.emit(ADeadOp::Label(got));
+        mov(ir, Reg::RDX, mem(Reg::R8, SIZE));
+        release(ir);
+        self.stats_base(ir);
+        lock_add_stat(ir, IN_USE, Reg::RDX);
+        mov(ir, Reg::RDX, Operand::Imm32(1));
+        lock_add_stat(ir, ALLOCS, Reg::RDX);
+        ir.emit(ADeadOp::Ret);
+
+        ir.emit(ADeadOp::Label(oom));
+        release(ir);
+        ir.emit(ADeadOp::Ret);
+
+        // ---- grande: páginas propias, cabecera con lo mapeado ----
+        ir.emit(ADeadOp::Label(large));
+        mov(ir, Reg::R11, Operand::Imm64(MAX_LARGE));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R10), right: Operand::Reg(Reg::R11) });
+        jcc(ir, Condition::Above, fail);
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R10));
+        add_imm(ir, Reg::RCX, HEADER_SIZE + PAGE_SIZE - 1);
+        mov(ir, Reg::RAX, Operand::Imm32(-PAGE_SIZE));
+        ir.emit(ADeadOp::And { dst: Reg::RCX, src: Reg::RAX });
+        push(ir, Reg::RCX);
+        call(ir, self.map);
+        pop(ir, Reg::RCX);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, fail);
+        ir.emit(ADeadOp::Xor { dst: Reg::RDX, src: Reg::RDX });
+        store(ir, Reg::RAX, 0, Reg::RDX);
+        store(ir, Reg::RAX, 8, Reg::RCX);
+        self.stats_base(ir);
+        lock_add_stat(ir, MAPPED, Reg::RCX);
+        lock_add_stat(ir, IN_USE, Reg::RCX);
+        mov(ir, Reg::RDX, Operand::Imm32(1));
+        lock_add_stat(ir, ALLOCS, Reg::RDX);
+        lock_add_stat(ir, LARGE_ALLOCS, Reg::RDX);
+        add_imm(ir, Reg::RAX, HEADER_SIZE);
+        ir.emit(ADeadOp::Ret);
+
+        ir.emit(ADeadOp::Label(fail));
+        ir.emit(ADeadOp::Xor { dst: Reg::RAX, src: Reg::RAX });
+        ir.emit(ADeadOp::Ret);
+    }
+
+    fn emit_free(&self, ir: &mut ADeadIR) {
+        let large = ir.new_label();
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(self.free));
+        mov(ir, Reg::RAX, Operand::Reg(self.args[0]));
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, done);
+        mov(ir, Reg::R8, mem(Reg::RAX, -HEADER_SIZE));
+        ir.emit(ADeadOp::Test { left: Reg::R8, right: Reg::R8 });
+        jcc(ir, Condition::Equal, large);
+
+        // ---- pequeño: a la cabeza de la free list de su clase ----
+        acquire(ir);
+        mov(ir, Reg::RDX, mem(Reg::R8, FREE));
+        store(ir, Reg::RAX, 0, Reg::RDX);
+        store(ir, Reg::R8, FREE, Reg::RAX);
+        mov(ir, Reg::RDX, mem(Reg::R8, SIZE));
+        release(ir);
+        self.stats_base(ir);
+        ir.emit(ADeadOp::Neg { dst: Reg::RDX });
+        lock_add_stat(ir, IN_USE, Reg::RDX);
+        mov(ir, Reg::RDX, Operand::Imm32(1));
+        lock_add_stat(ir, FREES, Reg::RDX);
+        ir.emit(ADeadOp::Ret);
+
+        // ---- grande: las páginas vuelven al sistema ----
+        ir.emit(ADeadOp::Label(large));
+        mov(ir, Reg::RDX, mem(Reg::RAX, 8 - HEADER_SIZE));
+        ir.emit(ADeadOp::Lea { dst: Reg::RCX, src: mem(Reg::RAX, -HEADER_SIZE) });
+        push(ir, Reg::RDX);
+        call(ir, self.unmap);
+        pop(ir, Reg::RDX);
+        self.stats_base(ir);
+        ir.emit(ADeadOp::Neg { dst: Reg::RDX });
+        lock_add_stat(ir, IN_USE, Reg::RDX);
+        lock_add_stat(ir, MAPPED, Reg::RDX);
+        mov(ir, Reg::RDX, Operand::Imm32(1));
+        lock_add_stat(ir, FREES, Reg::RDX);
+        ir.emit(ADeadOp::Label(done));
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// Bytes útiles del bloque de RAX → RCX
+    fn usable_size(ir: &mut ADeadIR) {
+        let small = ir.new_label();
+        let done = ir.new_label();
+        mov(ir, Reg::RCX, mem(Reg::RAX, -HEADER_SIZE));
+        ir.emit(ADeadOp::Test { left: Reg::RCX, right: Reg::RCX });
+        jcc(ir, Condition::NotEqual, small);
+        mov(ir, Reg::RCX, mem(Reg::RAX, 8 - HEADER_SIZE));
+        add_imm(ir, Reg::RCX, -HEADER_SIZE);
+        ir.emit(ADeadOp::Jmp { target: done });
+        ir.emit(ADeadOp::Label(small));
+        mov(ir, Reg::RCX, mem(Reg::RCX, SIZE));
+        ir.emit(ADeadOp::Label(done));
+    }
+
+    fn emit_calloc(&self, ir: &mut ADeadIR) {
+        let done = ir.new_label();
+        let fail = ir.new_label();
+        ir.emit(ADeadOp::Label(self.calloc));
+        mov(ir, Reg::RAX, Operand::Reg(self.args[0]));
+        mov(ir, Reg::RCX, Operand::Reg(self.args[1]));
+        // Operandos de 32 bits: el producto no desborda
+        mov(ir, Reg::RDX, Operand::Reg(Reg::RAX));
+        ir.emit(ADeadOp::Or { dst: Reg::RDX, src: Reg::RCX });
+        ir.emit(ADeadOp::Shr { dst: Reg::RDX, amount: 32 });
+        jcc(ir, Condition::NotEqual, fail);
+        ir.emit(ADeadOp::Mul { dst: Reg::RAX, src: Reg::RCX });
+        push(ir, Reg::RAX);
+        mov(ir, self.args[0], Operand::Reg(Reg::RAX));
+        call(ir, self.malloc);
+        pop(ir, Reg::RCX);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, done);
+        // Bloques reciclados no vienen a cero
+        push(ir, Reg::RDI);
+        mov(ir, Reg::RDI, Operand::Reg(Reg::RAX));
+        mov(ir, Reg::RDX, Operand::Reg(Reg::RAX));
+        ir.emit(ADeadOp::Xor { dst: Reg::RAX, src: Reg::RAX });
+        ir.emit(ADeadOp::Cld);
+        ir.emit(ADeadOp::Rep { op: Box::new(ADeadOp::Stosb) });
+        mov(ir, Reg::RAX, Operand::Reg(Reg::RDX));
+        pop(ir, Reg::RDI);
+        ir.emit(ADeadOp::Label(done));
+        ir.emit(ADeadOp::Ret);
+        ir.emit(ADeadOp::Label(fail));
+        ir.emit(ADeadOp::Xor { dst: Reg::RAX, src: Reg::RAX });
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// Crece solo si no cabe en el bloque actual; nunca encoge
+    fn emit_realloc(&self, ir: &mut ADeadIR) {
+        let fresh = ir.new_label();
+        let keep = ir.new_label();
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(self.realloc));
+        mov(ir, Reg::RAX, Operand::Reg(self.args[0]));
+        mov(ir, Reg::R10, Operand::Reg(self.args[1]));
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, fresh);
+        Self::usable_size(ir);
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R10), right: Operand::Reg(Reg::RCX) });
+        jcc(ir, Condition::BelowEq, keep);
+
+        push(ir, Reg::RAX);
+        push(ir, Reg::RCX);
+        mov(ir, self.args[0], Operand::Reg(Reg::R10));
+        call(ir, self.malloc);
+        pop(ir, Reg::RCX);
+        pop(ir, Reg::RDX);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, done);
+        // memcpy(nuevo, viejo, útil del viejo) y free(viejo)
+        push(ir, Reg::RSI);
+        push(ir, Reg::RDI);
+        mov(ir, Reg::RSI, Operand::Reg(Reg::RDX));
+        mov(ir, Reg::RDI, Operand::Reg(Reg::RAX));
+        ir.emit(ADeadOp::Cld);
+        ir.emit(ADeadOp::Rep { op: Box::new(ADeadOp::Movsb) });
+        pop(ir, Reg::RDI);
+        pop(ir, Reg::RSI);
+        push(ir, Reg::RAX);
+        mov(ir, self.args[0], Operand::Reg(Reg::RDX));
+        call(ir, self.free);
+        pop(ir, Reg::RAX);
+        ir.emit(ADeadOp::Label(done));
+        ir.emit(ADeadOp::Label(keep));
+        ir.emit(ADeadOp::Ret);
+
+        ir.emit(ADeadOp::Label(fresh));
+        mov(ir, self.args[0], Operand::Reg(Reg::R10));
+        ir.emit(ADeadOp::Jmp { target: self.malloc });
+    }
+
+    fn emit_stats(&self, ir: &mut ADeadIR) {
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(self.stats));
+        mov(ir, Reg::R8, Operand::Reg(self.args[0]));
+        ir.emit(ADeadOp::Test { left: Reg::R8, right: Reg::R8 });
+        jcc(ir, Condition::Equal, done);
+        self.stats_base(ir);
+        for i in 0..STATS_FIELDS.len() as i32 {
+            mov(ir, Reg::RAX, mem(Reg::R11, i * 8));
+            store(ir, Reg::R8, i * 8, Reg::RAX);
+        }
+        ir.emit(ADeadOp::Label(done));
+        ir.emit(ADeadOp::Xor { dst: Reg::RAX, src: Reg::RAX });
+        ir.emit(ADeadOp::Ret);
+    }
+}
+
+#[cfg(all(test, target_os = "linux", target_arch = "x86_64"))]
+mod tests {
+    use super::*;
+    use crate::isa::test_jit::JitCode;
+
+    #[test]
+    fn test_size_classes() {
+        assert_eq!(size_class(0), Some(0));
+        assert_eq!(size_class(16), Some(0));
+        assert_eq!(size_class(17), Some(1));
+        assert_eq!(size_class(2048), Some(7));
+        assert_eq!(size_class(2049), None);
+        let state = initial_state();
+        assert_eq!(state.len(), 512 + 40);
+        assert_eq!(state[7 * 64 + 32..7 * 64 + 40], 2048u64.to_le_bytes());
+    }
+
+    #[test]
+    fn test_slab_heap_reuses_blocks_and_counts() {
+        let mut state = initial_state();
+        let mut ir = ADeadIR::new();
+        let heap = SlabHeap::new(&mut ir, state.as_mut_ptr() as u64, PageSource::Syscall, false);
+        heap.emit_routines(&mut ir);
+        let code = JitCode::new(ir.ops());
+
+        unsafe {
+            let malloc: extern "C" fn(u64) -> *mut u8 = code.func(heap.malloc);
+            let free: extern "C" fn(*mut u8) = code.func(heap.free);
+            let calloc: extern "C" fn(u64, u64) -> *mut u8 = code.func(heap.calloc);
+            let realloc: extern "C" fn(*mut u8, u64) -> *mut u8 = code.func(heap.realloc);
+            let stats: extern "C" fn(*mut [u64; 5]) -> i64 = code.func(heap.stats);
+
+            // Misma clase: el bloque liberado es el siguiente en salir
+            let a = malloc(24);
+            let b = malloc(30);
+            assert_eq!(a as usize % 16, 0);
+            assert_eq!(b as usize - a as usize, 32 + HEADER_SIZE as usize);
+            a.write_bytes(0xAB, 24);
+            free(a);
+            assert_eq!(malloc(17), a);
+
+            // calloc limpia bloques reciclados
+            free(a);
+            let z = calloc(3, 8);
+            assert_eq!(z, a);
+            assert!(std::slice::from_raw_parts(z, 24).iter().all(|&x| x == 0));
+            assert!(calloc(1 << 33, 2).is_null());
+
+            // realloc conserva el contenido al pasar a bloque grande
+            for i in 0..24 {
+                *z.add(i) = i as u8;
+            }
+            assert_eq!(realloc(z, 32), z);
+            let big = realloc(z, 10_000);
+            assert_ne!(big, z);
+            assert!((0..24).all(|i| *big.add(i) == i as u8));
+
+            let mut s = [0u64; 5];
+            assert_eq!(stats(&mut s), 0);
+            assert_eq!((s[0], s[1], s[4]), (5, 3, 1));
+            assert_eq!(s[3], SLAB_SIZE as u64 + 12288);
+            assert_eq!(s[2], 32 + 12288);
+            free(big);
+            free(b);
+            free(std::ptr::null_mut());
+            stats(&mut s);
+            assert_eq!((s[0], s[1]), (5, 5));
+            assert_eq!(s[2], 0);
+            assert_eq!(s[3], SLAB_SIZE as u64);
+        }
+    }
+}
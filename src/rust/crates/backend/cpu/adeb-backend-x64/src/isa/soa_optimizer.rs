@@ -82,6 +82,21 @@ pub enum SoaSkipReason {
     NonSequential,
     /// Element type not vectorizable
     UnsupportedType,
+    // ── Loop vectorizer (loop_vectorizer.rs) ──
+    /// Loop is not `for (i = ..; i < n; i++)` with an invariant bound
+    NotCountable,
+    /// Body has something other than `arr[i] = expr` statements
+    UnsupportedStatement,
+    /// Operator or operand with no AVX2 lane equivalent
+    UnsupportedOp,
+    /// An array written in the loop is read at another index
+    LoopCarriedDependence,
+    /// Arrays with different element sizes
+    MixedElementSize,
+    /// Integer and floating-point operands (or float and double) in one loop
+    MixedElementKind,
+    /// Constant trip count smaller than one vector
+    TripCountTooSmall,
 }
 
 impl std::fmt::Display for SoaSkipReason {
@@ -92,6 +107,13 @@ impl std::fmt::Display for SoaSkipReason {
             SoaSkipReason::RegistersExhausted => write!(f, "YMM registers exhausted"),
             SoaSkipReason::NonSequential => write!(f, "non-sequential access"),
             SoaSkipReason::UnsupportedType => write!(f, "unsupported element type"),
+            SoaSkipReason::NotCountable => write!(f, "not a countable loop"),
+            SoaSkipReason::UnsupportedStatement => write!(f, "body is not arr[i] = expr"),
+            SoaSkipReason::UnsupportedOp => write!(f, "operation has no AVX2 form"),
+            SoaSkipReason::LoopCarriedDependence => write!(f, "loop-carried dependence"),
+            SoaSkipReason::MixedElementSize => write!(f, "mixed element sizes"),
+            SoaSkipReason::MixedElementKind => write!(f, "mixed integer/float element kinds"),
+            SoaSkipReason::TripCountTooSmall => write!(f, "trip count below lane width"),
         }
     }
 }
@@ -0,0 +1,381 @@
+// ============================================================
+// ADead-BIB — Scalar Replacement of Aggregates
+// ============================================================
+// Parte los structs locales en un escalar por campo antes del
+// codegen: `struct Pair acc; acc.a = acc.a + i` pasa a
+// `__sra_acc_a = __sra_acc_a + i`. Los escalares son locales
+// normales, así que los que viven en un bucle entran al linear
+// scan (liveness.rs) y el struct deja de ir a memoria.
+//
+// Un struct es candidato si su tipo tiene campos escalares (lo
+// decide el isa_compiler: sin union, bitfields ni vtable), se
+// declara una sola vez en la función, sin inicializar o con
+// `{a, b, ...}`, y solo se usa campo a campo:
+//
+//   s.f   s.f = v   "s.f" (nombre plano del frontend)
+//
+// Cualquier otro uso (el struct entero en una llamada, un
+// return, una asignación, &s, &s.f, sizeof s) hace que su
+// dirección escape y se deja en memoria.
+//
+// Un parámetro struct que cumple lo mismo se copia campo a campo
+// a sus escalares al entrar. Sin inicializador los campos
+// arrancan a cero, igual que el struct en el frame.
+// ============================================================
+
+use super::loop_opt::{child_bodies, child_bodies_mut, expr_children, expr_children_mut, stmt_exprs, stmt_exprs_mut};
+use crate::frontend::ast::*;
+use std::collections::{HashMap, HashSet};
+
+/// Nombre del escalar del campo `field` de `var`
+pub fn scalar_name(var: &str, field: &str) -> String {
+    format!("__sra_{}_{}", var, field)
+}
+
+/// `func` con sus structs locales partidos en escalares; None si no
+/// hay ninguno. `fields(tipo)` da los campos (nombre, tipo) de un
+/// struct que se puede partir
+pub fn scalar_replace(func: &Function, fields: impl Fn(&str) -> Option<Vec<(String, Type)>>) -> Option<Function> {
+    let mut scan = Scan::default();
+    for param in &func.params {
+        scan.declare(&param.name, &param.param_type, true, &fields);
+    }
+    scan.stmts(&func.body, &fields);
+
+    let split: HashMap<String, Vec<(String, Type)>> = scan
+        .candidates
+        .into_iter()
+        .filter(|(name, _)| scan.declared[name] == 1 && !scan.escaped.contains(name))
+        .collect();
+    if split.is_empty() {
+        return None;
+    }
+
+    let mut out = func.clone();
+    let mut entry = Vec::new();
+    for param in &func.params {
+        let Some(fields) = split.get(&param.name) else {
+            continue;
+        };
+        for (field, ty) in fields {
+            entry.push(Stmt::VarDecl {
+                var_type: ty.clone(),
+                name: scalar_name(&param.name, field),
+                value: Some(Expr::FieldAccess {
+                    object: Box::new(Expr::Variable(param.name.clone())),
+                    field: field.clone(),
+                }),
+            });
+        }
+    }
+    entry.extend(rewrite_block(&func.body, &split));
+    out.body = entry;
+    Some(out)
+}
+
+fn struct_name(ty: &Type) -> Option<&str> {
+    match ty {
+        Type::Struct(n) | Type::Named(n) | Type::Class(n) => Some(n),
+        _ => None,
+    }
+}
+
+fn zero(ty: &Type) -> Expr {
+    match ty {
+        Type::F32 | Type::F64 => Expr::Float(0.0),
+        _ => Expr::Number(0),
+    }
+}
+
+#[derive(Default)]
+struct Scan {
+    /// Declaraciones de cada nombre (parámetros, locales, vars de for)
+    declared: HashMap<String, usize>,
+    candidates: HashMap<String, Vec<(String, Type)>>,
+    escaped: HashSet<String>,
+}
+
+impl Scan {
+    fn declare(
+        &mut self,
+        name: &str,
+        ty: &Type,
+        init_ok: bool,
+        fields: &impl Fn(&str) -> Option<Vec<(String, Type)>>,
+    ) {
+        *self.declared.entry(name.to_string()).or_default() += 1;
+        if let Some(list) = struct_name(ty).and_then(|s| fields(s)) {
+            if !list.is_empty() {
+                self.candidates.insert(name.to_string(), list);
+            }
+        }
+        if !init_ok {
+            self.escaped.insert(name.to_string());
+        }
+    }
+
+    /// Uso por nombre: `s` entero escapa, `s.f` vale si `f` es un campo
+    fn name_use(&mut self, name: &str) {
+        let (var, field) = match name.split_once('.') {
+            Some((var, field)) => (var, Some(field)),
+            None => (name, None),
+        };
+        let known = field.map_or(false, |f| {
+            self.candidates.get(var).map_or(false, |list| list.iter().any(|(n, _)| n == f))
+        });
+        if !known {
+            self.escaped.insert(var.to_string());
+        }
+    }
+
+    fn field_use(&mut self, var: &str, field: &str) {
+        self.name_use(&format!("{}.{}", var, field));
+    }
+
+    fn stmts(&mut self, stmts: &[Stmt], fields: &impl Fn(&str) -> Option<Vec<(String, Type)>>) {
+        for stmt in stmts {
+            match stmt {
+                Stmt::VarDecl { var_type, name, value } => {
+                    let init_ok = match value {
+                        None => true,
+                        Some(Expr::Array(elems)) => {
+                            let count = struct_name(var_type).and_then(|s| fields(s)).map_or(0, |l| l.len());
+                            elems.len() <= count && !elems.iter().any(|e| matches!(e, Expr::Array(_)))
+                        }
+                        Some(_) => false,
+                    };
+                    self.declare(name, var_type, init_ok, fields);
+                }
+                Stmt::For { var, .. } | Stmt::ForEach { var, .. } => {
+                    *self.declared.entry(var.clone()).or_default() += 1;
+                    self.name_use(var);
+                }
+                Stmt::Assign { name, .. } | Stmt::CompoundAssign { name, .. } | Stmt::Increment { name, .. } => {
+                    self.name_use(name)
+                }
+                _ => {}
+            }
+            match stmt {
+                Stmt::FieldAssign { object: Expr::Variable(var), field, value } => {
+                    self.field_use(var, field);
+                    self.expr(value);
+                }
+                // Los elementos de `{a, b}` se leen; el Array en sí no es un uso
+                Stmt::VarDecl { value: Some(Expr::Array(elems)), .. } => {
+                    for elem in elems {
+                        self.expr(elem);
+                    }
+                }
+                _ => {
+                    for expr in stmt_exprs(stmt) {
+                        self.expr(expr);
+                    }
+                }
+            }
+            for body in child_bodies(stmt) {
+                self.stmts(body, fields);
+            }
+        }
+    }
+
+    fn expr(&mut self, expr: &Expr) {
+        match expr {
+            Expr::Variable(name) => self.name_use(name),
+            Expr::FieldAccess { object, field } => {
+                if let Expr::Variable(var) = object.as_ref() {
+                    self.field_use(var, field);
+                    return;
+                }
+            }
+            Expr::AddressOf(inner) => {
+                if let Expr::FieldAccess { object, .. } = inner.as_ref() {
+                    if let Expr::Variable(var) = object.as_ref() {
+                        self.escaped.insert(var.clone());
+                    }
+                }
+            }
+            Expr::Call { name, .. } => self.name_use(name),
+            Expr::Lambda { params, .. } => {
+                for p in params {
+                    self.name_use(p);
+                }
+            }
+            _ => {}
+        }
+        for child in expr_children(expr) {
+            self.expr(child);
+        }
+    }
+}
+
+/// Nombre plano "s.f" → su escalar, si `s` se parte
+fn rename(name: &str, split: &HashMap<String, Vec<(String, Type)>>) -> Option<String> {
+    let (var, field) = name.split_once('.')?;
+    split.contains_key(var).then(|| scalar_name(var, field))
+}
+
+fn rewrite_block(stmts: &[Stmt], split: &HashMap<String, Vec<(String, Type)>>) -> Vec<Stmt> {
+    let mut out = Vec::with_capacity(stmts.len());
+    for stmt in stmts {
+        if let Stmt::VarDecl { name, value, .. } = stmt {
+            if let Some(fields) = split.get(name) {
+                let elems = match value {
+                    Some(Expr::Array(elems)) => elems.as_slice(),
+                    _ => &[],
+                };
+                for (k, (field, ty)) in fields.iter().enumerate() {
+                    let mut init = elems.get(k).cloned().unwrap_or_else(|| zero(ty));
+                    rewrite_expr(&mut init, split);
+                    out.push(Stmt::VarDecl { var_type: ty.clone(), name: scalar_name(name, field), value: Some(init) });
+                }
+                continue;
+            }
+        }
+        let mut stmt = stmt.clone();
+        if let Stmt::FieldAssign { object: Expr::Variable(var), field, value } = &stmt {
+            if split.contains_key(var) {
+                stmt = Stmt::Assign { name: scalar_name(var, field), value: value.clone() };
+            }
+        }
+        match &mut stmt {
+            Stmt::Assign { name, .. } | Stmt::CompoundAssign { name, .. } | Stmt::Increment { name, .. } => {
+                if let Some(scalar) = rename(name, split) {
+                    *name = scalar;
+                }
+            }
+            _ => {}
+        }
+        for expr in stmt_exprs_mut(&mut stmt) {
+            rewrite_expr(expr, split);
+        }
+        for body in child_bodies_mut(&mut stmt) {
+            *body = rewrite_block(body, split);
+        }
+        out.push(stmt);
+    }
+    out
+}
+
+fn rewrite_expr(expr: &mut Expr, split: &HashMap<String, Vec<(String, Type)>>) {
+    let scalar = match expr {
+        Expr::FieldAccess { object, field } => match object.as_ref() {
+            Expr::Variable(var) if split.contains_key(var) => Some(scalar_name(var, field)),
+            _ => None,
+        },
+        Expr::Variable(name) => rename(name, split),
+        _ => None,
+    };
+    if let Some(name) = scalar {
+        *expr = Expr::Variable(name);
+        return;
+    }
+    for child in expr_children_mut(expr) {
+        rewrite_expr(child, split);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn var(name: &str) -> Expr {
+        Expr::Variable(name.to_string())
+    }
+
+    fn field(object: &str, field: &str) -> Expr {
+        Expr::FieldAccess { object: Box::new(var(object)), field: field.to_string() }
+    }
+
+    fn set(object: &str, name: &str, value: Expr) -> Stmt {
+        Stmt::FieldAssign { object: var(object), field: name.to_string(), value }
+    }
+
+    fn pair() -> Type {
+        Type::Struct("Pair".to_string())
+    }
+
+    fn fields(name: &str) -> Option<Vec<(String, Type)>> {
+        (name == "Pair").then(|| vec![("a".to_string(), Type::I32), ("b".to_string(), Type::I64)])
+    }
+
+    fn function(params: Vec<(&str, Type)>, body: Vec<Stmt>) -> Function {
+        Function {
+            name: "f".to_string(),
+            params: params
+                .into_iter()
+                .map(|(name, param_type)| Param { name: name.to_string(), param_type, default_value: None })
+                .collect(),
+            return_type: Some("long".to_string()),
+            resolved_return_type: Type::I64,
+            body,
+            attributes: FunctionAttributes::default(),
+        }
+    }
+
+    fn sum(left: Expr, right: Expr) -> Expr {
+        Expr::BinaryOp { op: BinOp::Add, left: Box::new(left), right: Box::new(right) }
+    }
+
+    #[test]
+    fn test_fields_become_scalars() {
+        let func = function(
+            vec![("n", Type::I64)],
+            vec![
+                Stmt::VarDecl { var_type: pair(), name: "acc".to_string(), value: None },
+                Stmt::While {
+                    condition: Expr::Comparison { op: CmpOp::Lt, left: Box::new(field("acc", "b")), right: Box::new(var("n")) },
+                    body: vec![
+                        set("acc", "a", sum(field("acc", "a"), field("acc", "b"))),
+                        Stmt::Increment { name: "acc.b".to_string(), is_pre: false, is_increment: true },
+                    ],
+                },
+                Stmt::Return(Some(field("acc", "a"))),
+            ],
+        );
+        let out = scalar_replace(&func, fields).expect("acc se parte");
+        assert!(matches!(&out.body[0], Stmt::VarDecl { var_type: Type::I32, name, value: Some(Expr::Number(0)) } if name == "__sra_acc_a"));
+        assert!(matches!(&out.body[1], Stmt::VarDecl { var_type: Type::I64, name, .. } if name == "__sra_acc_b"));
+        let Stmt::While { body, .. } = &out.body[2] else { panic!("{:?}", out.body[2]) };
+        assert!(matches!(&body[0], Stmt::Assign { name, .. } if name == "__sra_acc_a"));
+        assert!(matches!(&body[1], Stmt::Increment { name, .. } if name == "__sra_acc_b"));
+        assert!(matches!(&out.body[3], Stmt::Return(Some(Expr::Variable(v))) if v == "__sra_acc_a"));
+    }
+
+    #[test]
+    fn test_initializer_and_params() {
+        let func = function(
+            vec![("p", pair())],
+            vec![
+                Stmt::VarDecl { var_type: pair(), name: "q".to_string(), value: Some(Expr::Array(vec![field("p", "b")])) },
+                Stmt::Return(Some(sum(field("q", "a"), field("q", "b")))),
+            ],
+        );
+        let out = scalar_replace(&func, fields).unwrap();
+        // Entrada: p.a y p.b a sus escalares; q.a = p.b, q.b = 0
+        assert_eq!(out.body.len(), 5);
+        assert!(matches!(&out.body[0], Stmt::VarDecl { name, value: Some(Expr::FieldAccess { .. }), .. } if name == "__sra_p_a"));
+        assert!(matches!(&out.body[2], Stmt::VarDecl { name, value: Some(Expr::Variable(v)), .. } if name == "__sra_q_a" && v == "__sra_p_b"));
+        assert!(matches!(&out.body[3], Stmt::VarDecl { value: Some(Expr::Number(0)), .. }));
+    }
+
+    #[test]
+    fn test_escaping_structs_stay_in_memory() {
+        let decl = |name: &str| Stmt::VarDecl { var_type: pair(), name: name.to_string(), value: None };
+        let whole = function(vec![], vec![decl("s"), Stmt::Expr(Expr::Call { name: "use".to_string(), args: vec![var("s")] })]);
+        assert!(scalar_replace(&whole, fields).is_none());
+        let address = function(vec![], vec![decl("s"), Stmt::Return(Some(Expr::AddressOf(Box::new(field("s", "a")))))]);
+        assert!(scalar_replace(&address, fields).is_none());
+        let unknown = function(vec![], vec![decl("s"), Stmt::Return(Some(field("s", "zz")))]);
+        assert!(scalar_replace(&unknown, fields).is_none());
+        let twice = function(vec![], vec![decl("s"), decl("s"), Stmt::Return(Some(field("s", "a")))]);
+        assert!(scalar_replace(&twice, fields).is_none());
+        let from_call = function(
+            vec![],
+            vec![
+                Stmt::VarDecl { var_type: pair(), name: "s".to_string(), value: Some(Expr::Call { name: "mk".to_string(), args: vec![] }) },
+                Stmt::Return(Some(field("s", "a"))),
+            ],
+        );
+        assert!(scalar_replace(&from_call, fields).is_none());
+    }
+}
@@ -0,0 +1,237 @@
+// ============================================================
+// ADead-BIB — Strength Reduction (mul/div/mod por constante)
+// ============================================================
+// `x * c`, `x / c`, `x % c` con `c` conocido en compile time no
+// necesitan IMUL r,r ni IDIV (20-90 ciclos en x86-64):
+//
+//   x * 8    → shl  rax, 3
+//   x * 40   → lea  rax, [rax + rax*4] ; shl rax, 3
+//   x * -9   → lea  rax, [rax + rax*8] ; neg rax
+//   x / 16   → sesgo (x < 0 ? 15 : 0), luego sar rax, 4
+//   x / 7    → mulhs(x, magic) + corrección de signo (Hacker's Delight)
+//   x % c    → x - (x / c) * c
+//
+// Toda la aritmética entera es de 64 bits con signo y truncamiento
+// hacia cero (la misma semántica que `cqo; idiv`).
+// ============================================================
+
+/// Paso de una multiplicación por constante, aplicado sobre el registro
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum MulStep {
+    /// lea r, [r + r*scale] — multiplica por scale + 1 (3, 5 o 9)
+    Lea(u8),
+    /// shl r, k
+    Shl(u8),
+    /// neg r
+    Neg,
+}
+
+/// Pasos máximos: más allá de dos, IMUL (3 ciclos) ya no pierde
+pub const MAX_MUL_STEPS: usize = 2;
+
+/// Descompone `x * c` en lea/shl/neg. None = mejor un IMUL.
+/// `c == 1` da una lista vacía; `c == 0` se deja al IMUL (el valor
+/// de `x` puede tener efectos y se evalúa igual).
+pub fn mul_plan(c: i64) -> Option<Vec<MulStep>> {
+    if c == 0 {
+        return None;
+    }
+    let magnitude = c.unsigned_abs();
+    let shift = magnitude.trailing_zeros() as u8;
+    let mut steps = match magnitude >> shift {
+        1 => vec![],
+        odd => lea_factors(odd)?,
+    };
+    if shift > 0 {
+        steps.push(MulStep::Shl(shift));
+    }
+    if c < 0 {
+        steps.push(MulStep::Neg);
+    }
+    (steps.len() <= MAX_MUL_STEPS).then_some(steps)
+}
+
+/// Factor impar como producto de a lo sumo dos LEA (3, 5, 9)
+fn lea_factors(odd: u64) -> Option<Vec<MulStep>> {
+    const LEA: [(u64, u8); 3] = [(3, 2), (5, 4), (9, 8)];
+    for &(f, scale) in &LEA {
+        if odd == f {
+            return Some(vec![MulStep::Lea(scale)]);
+        }
+    }
+    for &(f, scale) in &LEA {
+        for &(g, scale2) in &LEA {
+            if f * g == odd {
+                return Some(vec![MulStep::Lea(scale), MulStep::Lea(scale2)]);
+            }
+        }
+    }
+    None
+}
+
+/// Cómo dividir entre una constante `d != 0`
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum DivPlan {
+    /// |d| = 1: el cociente es ±x, el resto 0
+    Unit { negate: bool },
+    /// |d| = 2^k: sesgo para redondear hacia cero y `sar k`
+    Shift { k: u32, negate: bool },
+    /// q = sar(mulhs(x, magic) ± x, shift); q += q >>> 63
+    Magic { magic: i64, shift: u32, fixup: MagicFixup },
+}
+
+/// Corrección tras el multiply-high cuando el mágico y `d` difieren en signo
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum MagicFixup {
+    None,
+    AddDividend,
+    SubDividend,
+}
+
+/// None para `d == 0`: se deja el IDIV y su excepción en runtime
+pub fn div_plan(d: i64) -> Option<DivPlan> {
+    if d == 0 {
+        return None;
+    }
+    let magnitude = d.unsigned_abs();
+    if magnitude == 1 {
+        return Some(DivPlan::Unit { negate: d < 0 });
+    }
+    if magnitude.is_power_of_two() {
+        return Some(DivPlan::Shift { k: magnitude.trailing_zeros(), negate: d < 0 });
+    }
+    let (magic, shift) = signed_magic(d);
+    let fixup = if d > 0 && magic < 0 {
+        MagicFixup::AddDividend
+    } else if d < 0 && magic > 0 {
+        MagicFixup::SubDividend
+    } else {
+        MagicFixup::None
+    };
+    Some(DivPlan::Magic { magic, shift, fixup })
+}
+
+/// Número mágico para la división con signo de 64 bits
+/// (Hacker's Delight, 10-1). Requiere |d| >= 2 y no potencia de dos.
+pub fn signed_magic(d: i64) -> (i64, u32) {
+    const TWO63: u64 = 1 << 63;
+    let ad = d.unsigned_abs();
+    let t = TWO63 + ((d as u64) >> 63);
+    let anc = t - 1 - t % ad;
+    let mut p = 63u32;
+    let (mut q1, mut r1) = (TWO63 / anc, TWO63 % anc);
+    let (mut q2, mut r2) = (TWO63 / ad, TWO63 % ad);
+    loop {
+        p += 1;
+        q1 = q1.wrapping_mul(2);
+        r1 = r1.wrapping_mul(2);
+        if r1 >= anc {
+            q1 = q1.wrapping_add(1);
+            r1 = r1.wrapping_sub(anc);
+        }
+        q2 = q2.wrapping_mul(2);
+        r2 = r2.wrapping_mul(2);
+        if r2 >= ad {
+            q2 = q2.wrapping_add(1);
+            r2 = r2.wrapping_sub(ad);
+        }
+        let delta = ad - r2;
+        if !(q1 < delta || (q1 == delta && r1 == 0)) {
+            break;
+        }
+    }
+    let magic = q2.wrapping_add(1) as i64;
+    (if d < 0 { magic.wrapping_neg() } else { magic }, p - 64)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Ejecuta los pasos tal como los emite el backend
+    fn run_mul(steps: &[MulStep], x: i64) -> i64 {
+        steps.iter().fold(x, |r, step| match step {
+            MulStep::Lea(scale) => r.wrapping_add(r.wrapping_mul(*scale as i64)),
+            MulStep::Shl(k) => r.wrapping_shl(*k as u32),
+            MulStep::Neg => r.wrapping_neg(),
+        })
+    }
+
+    /// Misma secuencia que emite el backend: RDX sesgo/high, RAX cociente
+    fn run_div(plan: DivPlan, x: i64) -> i64 {
+        match plan {
+            DivPlan::Unit { negate } => if negate { x.wrapping_neg() } else { x },
+            DivPlan::Shift { k, negate } => {
+                let bias = ((x >> 63) as u64 >> (64 - k)) as i64;
+                let q = x.wrapping_add(bias) >> k;
+                if negate { q.wrapping_neg() } else { q }
+            }
+            DivPlan::Magic { magic, shift, fixup } => {
+                let mut hi = ((x as i128 * magic as i128) >> 64) as i64;
+                match fixup {
+                    MagicFixup::None => {}
+                    MagicFixup::AddDividend => hi = hi.wrapping_add(x),
+                    MagicFixup::SubDividend => hi = hi.wrapping_sub(x),
+                }
+                hi >>= shift;
+                hi.wrapping_add((hi as u64 >> 63) as i64)
+            }
+        }
+    }
+
+    fn samples() -> Vec<i64> {
+        let mut xs: Vec<i64> = (-300..=300).collect();
+        for k in 0..63 {
+            let p = 1i64 << k;
+            xs.extend([p, p - 1, p + 1, -p, -p + 1, -p - 1]);
+        }
+        xs.extend([i64::MAX, i64::MIN, i64::MIN + 1, 0x1234_5678_9abc_def0, -0x0fed_cba9_8765_4321]);
+        xs
+    }
+
+    fn divisors() -> Vec<i64> {
+        let mut ds: Vec<i64> = (-130..=130).filter(|&d| d != 0).collect();
+        ds.extend([1000, -1000, 641, 1 << 31, (1 << 31) + 1, 1 << 40, 0x7fff_ffff_ffff, i64::MAX, i64::MIN, i64::MIN + 1]);
+        ds
+    }
+
+    #[test]
+    fn test_mul_plan_matches_wrapping_mul() {
+        for c in (-200i64..=200).chain([1 << 40, -(1 << 40), i64::MIN]) {
+            if let Some(steps) = mul_plan(c) {
+                for x in samples() {
+                    assert_eq!(run_mul(&steps, x), x.wrapping_mul(c), "x = {} * {}", x, c);
+                }
+            }
+        }
+        assert_eq!(mul_plan(40), Some(vec![MulStep::Lea(4), MulStep::Shl(3)]));
+        assert_eq!(mul_plan(45), Some(vec![MulStep::Lea(4), MulStep::Lea(8)]));
+        assert_eq!(mul_plan(-8), Some(vec![MulStep::Shl(3), MulStep::Neg]));
+        assert_eq!(mul_plan(7), None);
+        assert_eq!(mul_plan(0), None);
+    }
+
+    #[test]
+    fn test_div_plan_truncates_toward_zero() {
+        for d in divisors() {
+            let plan = div_plan(d).unwrap();
+            for x in samples() {
+                if x == i64::MIN && d == -1 {
+                    continue; // desborda también con IDIV
+                }
+                assert_eq!(run_div(plan, x), x.wrapping_div(d), "{} / {} with {:?}", x, d, plan);
+            }
+        }
+        assert_eq!(div_plan(0), None);
+        assert_eq!(div_plan(-16), Some(DivPlan::Shift { k: 4, negate: true }));
+    }
+
+    #[test]
+    fn test_signed_magic_known_values() {
+        // Valores de Hacker's Delight y de los compiladores de C
+        assert_eq!(signed_magic(3), (0x5555555555555556, 0));
+        assert_eq!(signed_magic(7), (0x4924924924924925u64 as i64, 1));
+        assert_eq!(signed_magic(10), (0x6666666666666667, 2));
+        assert_eq!(div_plan(7), Some(DivPlan::Magic { magic: 0x4924924924924925, shift: 1, fixup: MagicFixup::None }));
+    }
+}
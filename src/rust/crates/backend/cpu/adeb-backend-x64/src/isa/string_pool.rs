@@ -0,0 +1,191 @@
+// ============================================================
+// ADead-BIB — String pool (dedup + tail merging)
+// ============================================================
+// Los literales de un programa se recogen antes de compilar
+// funciones (`add`) y se colocan una sola vez (`layout`):
+//
+//   - Literales idénticos comparten dirección (dedup)
+//   - Un literal que es sufijo de otro vive dentro de él:
+//     "%s\n" apunta al final de "error: %s\n" (tail merging)
+//
+// Sufijos: se ordena por bytes invertidos; la extensión más corta
+// de cada string queda justo antes en orden descendente.
+//
+// Las direcciones ya emitidas no se pueden mover, así que los
+// literales que aparecen después de `layout` (strings tardíos del
+// codegen) se reutilizan si ya existen como cola de otro o se
+// añaden al final.
+// ============================================================
+
+use adeb_core::FxHashMap;
+
+#[derive(Debug, Clone, Default)]
+pub struct StringPool {
+    /// Strings en orden de llegada (cada uno una sola vez)
+    strings: Vec<String>,
+    index: FxHashMap<String, usize>,
+    /// Offset de cada string dentro de `bytes`; vacío hasta `layout`
+    offsets: Vec<u64>,
+    /// Contenido de la sección: strings terminados en NUL
+    bytes: Vec<u8>,
+    /// Tamaño de `bytes` tras añadir cada string (para `truncate`)
+    ends: Vec<usize>,
+    /// Tamaño que dejó `layout`, antes de los strings tardíos
+    base_size: usize,
+    laid_out: bool,
+}
+
+impl StringPool {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Registra `s`. Tras `layout` le asigna dirección al momento.
+    pub fn add(&mut self, s: String) {
+        if self.index.contains_key(&s) {
+            return;
+        }
+        if self.laid_out {
+            let offset = self.find_tail(s.as_bytes()).unwrap_or_else(|| {
+                let at = self.bytes.len();
+                self.bytes.extend_from_slice(s.as_bytes());
+                self.bytes.push(0);
+                at
+            });
+            self.offsets.push(offset as u64);
+            self.ends.push(self.bytes.len());
+        }
+        self.index.insert(s.clone(), self.strings.len());
+        self.strings.push(s);
+    }
+
+    /// Coloca los strings registrados con tail merging. Las raíces
+    /// (strings que no son sufijo de otro) van en orden de llegada.
+    pub fn layout(&mut self) {
+        let n = self.strings.len();
+        let mut order: Vec<usize> = (0..n).collect();
+        order.sort_by(|&a, &b| {
+            let ra = self.strings[a].bytes().rev();
+            let rb = self.strings[b].bytes().rev();
+            rb.cmp(ra)
+        });
+
+        // host[i] = string (raíz) dentro del cual vive i
+        let mut host: Vec<usize> = (0..n).collect();
+        for w in order.windows(2) {
+            let (prev, cur) = (w[0], w[1]);
+            if self.strings[prev].as_bytes().ends_with(self.strings[cur].as_bytes()) {
+                host[cur] = host[prev];
+            }
+        }
+
+        self.bytes.clear();
+        self.offsets = vec![0; n];
+        for i in 0..n {
+            if host[i] == i {
+                self.offsets[i] = self.bytes.len() as u64;
+                self.bytes.extend_from_slice(self.strings[i].as_bytes());
+                self.bytes.push(0);
+            }
+        }
+        for i in 0..n {
+            let root = host[i];
+            let tail = self.strings[root].len() - self.strings[i].len();
+            self.offsets[i] = self.offsets[root] + tail as u64;
+        }
+        self.base_size = self.bytes.len();
+        self.ends = vec![self.base_size; n];
+        self.laid_out = true;
+    }
+
+    /// Offset de `s` dentro de la sección, si ya tiene dirección
+    pub fn offset(&self, s: &str) -> Option<u64> {
+        self.index.get(s).and_then(|&i| self.offsets.get(i).copied())
+    }
+
+    pub fn contains(&self, s: &str) -> bool {
+        self.index.contains_key(s)
+    }
+
+    /// Número de strings distintos registrados
+    pub fn len(&self) -> usize {
+        self.strings.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.strings.is_empty()
+    }
+
+    /// Bytes de la sección (vacío hasta `layout`)
+    pub fn bytes(&self) -> &[u8] {
+        &self.bytes
+    }
+
+    /// Tamaño de la sección en bytes
+    pub fn size(&self) -> u64 {
+        self.bytes.len() as u64
+    }
+
+    /// Olvida los strings registrados después de los primeros `len`
+    pub fn truncate(&mut self, len: usize) {
+        if len >= self.strings.len() {
+            return;
+        }
+        for s in self.strings.drain(len..) {
+            self.index.remove(&s);
+        }
+        if self.laid_out {
+            self.offsets.truncate(len);
+            self.ends.truncate(len);
+            self.bytes.truncate(self.ends.last().copied().unwrap_or(self.base_size));
+        }
+    }
+
+    /// `s` ya está en la sección seguido de NUL (p.ej. como cola de otro)
+    fn find_tail(&self, s: &[u8]) -> Option<usize> {
+        let needle_len = s.len() + 1;
+        self.bytes
+            .windows(needle_len)
+            .position(|w| w[..s.len()] == *s && w[s.len()] == 0)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn pool(strings: &[&str]) -> StringPool {
+        let mut p = StringPool::new();
+        for s in strings {
+            p.add(s.to_string());
+        }
+        p.layout();
+        p
+    }
+
+    #[test]
+    fn test_suffixes_share_storage() {
+        let p = pool(&["%s\n", "error: %s\n", "\n", "%d", "%d"]);
+        assert_eq!(p.len(), 4);
+        assert_eq!(p.bytes(), b"error: %s\n\0%d\0");
+        assert_eq!(p.offset("error: %s\n"), Some(0));
+        assert_eq!(p.offset("%s\n"), Some(7));
+        assert_eq!(p.offset("\n"), Some(9));
+        assert_eq!(p.offset("%d"), Some(11));
+        assert_eq!(p.offset("nope"), None);
+    }
+
+    #[test]
+    fn test_late_strings_keep_earlier_offsets() {
+        let mut p = pool(&["hello world"]);
+        p.add("world".to_string());
+        p.add("bye".to_string());
+        assert_eq!(p.offset("world"), Some(6));
+        assert_eq!(p.offset("bye"), Some(12));
+        assert_eq!(p.size(), 16);
+
+        p.truncate(1);
+        assert!(!p.contains("bye"));
+        assert_eq!(p.bytes(), b"hello world\0");
+    }
+}
@@ -0,0 +1,139 @@
+// ============================================================
+// ADead-BIB — Structs por valor (clasificación de agregados)
+// ============================================================
+// Decide cómo viaja un struct por valor entre funciones propias,
+// como parámetro o como valor de retorno:
+//
+//   Win64: tamaño 1, 2, 4 u 8 → un registro entero; cualquier
+//          otro → por referencia a una copia del caller. Un
+//          retorno que no cabe va por puntero oculto (sret) en el
+//          primer argumento y vuelve en RAX.
+//   SysV:  hasta 16 bytes sin campos desalineados → uno o dos
+//          eightbytes en registros (RAX:RDX a la vuelta); más
+//          grande → memoria.
+//
+// Adaptaciones de este backend:
+// - Los eightbytes de clase SSE (double, float) viajan también en
+//   GPRs, igual que los escalares double del resto del codegen.
+// - La clase MEMORY de SysV no se copia a la pila de argumentos:
+//   se pasa un puntero a una copia del caller, como en Win64.
+//
+// El isa_compiler solo usa estas reglas entre funciones libres
+// propias (no métodos ni llamadas por puntero); el resto sigue
+// recibiendo el struct por referencia.
+// ============================================================
+
+use super::isa_compiler::ClassLayout;
+
+/// Clase de un agregado por valor
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum StructPass {
+    /// En 1 o 2 registros enteros (eightbytes)
+    Regs(u8),
+    /// En memoria: puntero a una copia (o sret al volver)
+    Memory,
+}
+
+pub fn classify(layout: &ClassLayout, sysv: bool) -> StructPass {
+    let size = extent(layout);
+    if size <= 0 {
+        return StructPass::Memory;
+    }
+    if !sysv {
+        return match size {
+            1 | 2 | 4 | 8 => StructPass::Regs(1),
+            _ => StructPass::Memory,
+        };
+    }
+    if size > 16 || layout.size > 16 || misaligned(layout) {
+        return StructPass::Memory;
+    }
+    StructPass::Regs(((size + 7) / 8) as u8)
+}
+
+/// Bytes que ocupan los campos: el layout genérico de C++ da 8 bytes
+/// a cada campo aunque `real_size` sea la suma de sus tamaños
+pub fn extent(layout: &ClassLayout) -> i32 {
+    layout
+        .fields
+        .iter()
+        .map(|(name, offset)| offset + field_size(layout, name))
+        .fold(layout.real_size, i32::max)
+}
+
+fn field_size(layout: &ClassLayout, name: &str) -> i32 {
+    layout.field_sizes.iter().find(|(n, _)| n == name).map_or(8, |&(_, s)| s)
+}
+
+/// Algún campo no cae en su alineación natural (struct packed)
+fn misaligned(layout: &ClassLayout) -> bool {
+    layout.fields.iter().any(|(name, offset)| {
+        let size = field_size(layout, name);
+        let align = size.clamp(1, 8);
+        offset % align != 0 || (size <= 8 && offset / 8 != (offset + size - 1) / 8)
+    })
+}
+
+/// Ancho del load/store del eightbyte `k` de un struct de `real_size`
+/// bytes: el último no lee más allá del struct que lo necesario
+pub fn eightbyte_width(real_size: i32, k: u8) -> i32 {
+    match real_size - k as i32 * 8 {
+        n if n > 4 => 8,
+        n if n > 2 => 4,
+        n if n > 1 => 2,
+        _ => 1,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn layout(fields: &[(&str, i32, i32)], real_size: i32) -> ClassLayout {
+        ClassLayout {
+            name: "S".to_string(),
+            fields: fields.iter().map(|&(n, o, _)| (n.to_string(), o)).collect(),
+            field_types: fields.iter().map(|&(n, _, _)| (n.to_string(), String::new())).collect(),
+            field_sizes: fields.iter().map(|&(n, _, s)| (n.to_string(), s)).collect(),
+            bitfields: vec![],
+            size: (real_size + 7) & !7,
+            real_size,
+            is_union: false,
+        }
+    }
+
+    #[test]
+    fn test_win64_rules() {
+        let pair = layout(&[("a", 0, 4), ("b", 4, 4)], 8);
+        let vec2 = layout(&[("x", 0, 8), ("y", 8, 8)], 16);
+        let rgb = layout(&[("r", 0, 1), ("g", 1, 1), ("b", 2, 1)], 3);
+        assert_eq!(classify(&pair, false), StructPass::Regs(1));
+        assert_eq!(classify(&vec2, false), StructPass::Memory);
+        assert_eq!(classify(&rgb, false), StructPass::Memory);
+        // Layout genérico: `b` en el offset 8 aunque real_size sea 8
+        let slots = ClassLayout { size: 16, ..layout(&[("a", 0, 4), ("b", 8, 4)], 8) };
+        assert_eq!(extent(&slots), 12);
+        assert_eq!(classify(&slots, false), StructPass::Memory);
+        assert_eq!(classify(&slots, true), StructPass::Regs(2));
+    }
+
+    #[test]
+    fn test_sysv_rules() {
+        let vec2 = layout(&[("x", 0, 8), ("y", 8, 8)], 16);
+        let vec3 = layout(&[("x", 0, 8), ("y", 8, 8), ("z", 16, 8)], 24);
+        let triple = layout(&[("a", 0, 4), ("b", 4, 4), ("c", 8, 4)], 12);
+        let packed = layout(&[("c", 0, 1), ("n", 1, 8)], 9);
+        assert_eq!(classify(&vec2, true), StructPass::Regs(2));
+        assert_eq!(classify(&triple, true), StructPass::Regs(2));
+        assert_eq!(classify(&vec3, true), StructPass::Memory);
+        assert_eq!(classify(&packed, true), StructPass::Memory);
+    }
+
+    #[test]
+    fn test_eightbyte_width() {
+        assert_eq!(eightbyte_width(16, 1), 8);
+        assert_eq!(eightbyte_width(12, 1), 4);
+        assert_eq!(eightbyte_width(3, 0), 4);
+        assert_eq!(eightbyte_width(10, 1), 2);
+    }
+}
@@ -0,0 +1,205 @@
+// ============================================================
+// ADead-BIB — Switch Lowering (jump tables + binary search)
+// ============================================================
+// Un `switch` con casos constantes se despacha en O(log n):
+//
+//   1. Los valores se ordenan y se agrupan en clusters:
+//        - rango denso (>= MIN_TABLE_CASES casos, densidad >= 40%,
+//          rango <= MAX_TABLE_RANGE) → tabla de saltos
+//        - el resto → casos sueltos
+//   2. Sobre los clusters se genera un árbol de búsqueda binaria;
+//      las hojas pequeñas comparan en línea.
+//
+// La tabla vive en .text justo detrás del `jmp`, con entradas de
+// 32 bits relativas al inicio de la tabla (como MSVC x64): no
+// necesita relocations y funciona igual en PE y ELF.
+//
+//     sub  rax, low
+//     cmp  rax, high - low
+//     ja   default
+//     lea  rcx, [rip + table]
+//     movsxd rax, dword [rcx + rax*4]
+//     add  rax, rcx
+//     jmp  rax
+//   table:
+//     dd case_0 - table, case_1 - table, ...
+// ============================================================
+
+use crate::frontend::ast::*;
+
+/// Casos mínimos para que una tabla compense el bounds check
+pub const MIN_TABLE_CASES: usize = 4;
+/// Densidad mínima (casos / rango) en décimas
+pub const MIN_TABLE_DENSITY_TENTHS: u64 = 4;
+/// Entradas máximas de una tabla (4 bytes cada una)
+pub const MAX_TABLE_RANGE: u64 = 4096;
+/// Clusters que se comparan en línea en vez de partir el rango
+pub const LINEAR_LEAF: usize = 3;
+
+/// Grupo de casos contiguo en el orden de valores
+#[derive(Debug, Clone, PartialEq)]
+pub enum CaseCluster<T> {
+    /// Un valor → destino
+    Single(i64, T),
+    /// `low..=low + targets.len() - 1`; `None` = hueco → default
+    Table { low: i64, targets: Vec<Option<T>> },
+}
+
+impl<T> CaseCluster<T> {
+    pub fn low(&self) -> i64 {
+        match self {
+            CaseCluster::Single(v, _) => *v,
+            CaseCluster::Table { low, .. } => *low,
+        }
+    }
+
+    pub fn high(&self) -> i64 {
+        match self {
+            CaseCluster::Single(v, _) => *v,
+            CaseCluster::Table { low, targets } => low + targets.len() as i64 - 1,
+        }
+    }
+}
+
+/// Valor de un `case` conocido en compile time
+pub fn case_value(expr: &Expr) -> Option<i64> {
+    match expr {
+        Expr::Number(n) => Some(*n),
+        Expr::Bool(b) => Some(*b as i64),
+        Expr::UnaryOp { op: UnaryOp::Neg, expr } => case_value(expr).map(i64::wrapping_neg),
+        Expr::BitwiseNot(e) => case_value(e).map(|v| !v),
+        Expr::Cast { expr, .. } | Expr::IntCast(expr) => case_value(expr),
+        Expr::BinaryOp { op, left, right } => {
+            let (l, r) = (case_value(left)?, case_value(right)?);
+            match op {
+                BinOp::Add => Some(l.wrapping_add(r)),
+                BinOp::Sub => Some(l.wrapping_sub(r)),
+                BinOp::Mul => Some(l.wrapping_mul(r)),
+                BinOp::Div if r != 0 => Some(l.wrapping_div(r)),
+                BinOp::Mod if r != 0 => Some(l.wrapping_rem(r)),
+                _ => None,
+            }
+        }
+        Expr::BitwiseOp { op, left, right } => {
+            let (l, r) = (case_value(left)?, case_value(right)?);
+            match op {
+                BitwiseOp::And => Some(l & r),
+                BitwiseOp::Or => Some(l | r),
+                BitwiseOp::Xor => Some(l ^ r),
+                BitwiseOp::LeftShift => Some(l.wrapping_shl(r as u32)),
+                BitwiseOp::RightShift => Some(l.wrapping_shr(r as u32)),
+            }
+        }
+        _ => None,
+    }
+}
+
+/// Ordena los casos y los agrupa en tablas densas y casos sueltos.
+/// Un valor repetido conserva su primer destino (como el primer
+/// `case` que lo nombra).
+pub fn cluster_cases<T: Copy>(cases: &[(i64, T)]) -> Vec<CaseCluster<T>> {
+    let mut sorted: Vec<(i64, T)> = Vec::with_capacity(cases.len());
+    for &(v, t) in cases {
+        if !sorted.iter().any(|&(w, _)| w == v) {
+            sorted.push((v, t));
+        }
+    }
+    sorted.sort_by_key(|&(v, _)| v);
+
+    let mut clusters = Vec::new();
+    let mut i = 0;
+    while i < sorted.len() {
+        // El tramo denso más largo que empieza en i
+        let mut best = None;
+        for j in i + MIN_TABLE_CASES - 1..sorted.len() {
+            let range = (sorted[j].0 as i128 - sorted[i].0 as i128 + 1) as u128;
+            if range > MAX_TABLE_RANGE as u128 {
+                break;
+            }
+            let count = (j - i + 1) as u128;
+            if count * 10 >= range * MIN_TABLE_DENSITY_TENTHS as u128 {
+                best = Some(j);
+            }
+        }
+        match best {
+            Some(j) => {
+                let low = sorted[i].0;
+                let mut targets = vec![None; (sorted[j].0 - low + 1) as usize];
+                for &(v, t) in &sorted[i..=j] {
+                    targets[(v - low) as usize] = Some(t);
+                }
+                clusters.push(CaseCluster::Table { low, targets });
+                i = j + 1;
+            }
+            None => {
+                clusters.push(CaseCluster::Single(sorted[i].0, sorted[i].1));
+                i += 1;
+            }
+        }
+    }
+    clusters
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_dense_cases_become_one_table() {
+        let cases: Vec<(i64, usize)> = (0..100).map(|v| (v, v as usize)).collect();
+        let clusters = cluster_cases(&cases);
+        assert_eq!(clusters.len(), 1);
+        match &clusters[0] {
+            CaseCluster::Table { low, targets } => {
+                assert_eq!(*low, 0);
+                assert_eq!(targets.len(), 100);
+                assert!(targets.iter().enumerate().all(|(k, t)| *t == Some(k)));
+            }
+            other => panic!("expected a table, got {:?}", other),
+        }
+    }
+
+    #[test]
+    fn test_mixed_switch_clusters_tables_and_singles() {
+        // 10..=15 con un hueco, 1000 suelto, -7..=-4 denso, 1 << 40 suelto
+        let mut cases: Vec<(i64, char)> = vec![(10, 'a'), (11, 'b'), (13, 'c'), (14, 'd'), (15, 'e')];
+        cases.extend([(1000, 'f'), (-7, 'g'), (-6, 'h'), (-5, 'i'), (-4, 'j'), (1 << 40, 'k'), (11, 'z')]);
+        let clusters = cluster_cases(&cases);
+        assert_eq!(clusters.len(), 4);
+        assert_eq!(
+            clusters[0],
+            CaseCluster::Table { low: -7, targets: vec![Some('g'), Some('h'), Some('i'), Some('j')] }
+        );
+        assert_eq!(
+            clusters[1],
+            CaseCluster::Table {
+                low: 10,
+                targets: vec![Some('a'), Some('b'), None, Some('c'), Some('d'), Some('e')],
+            }
+        );
+        assert_eq!(clusters[2], CaseCluster::Single(1000, 'f'));
+        assert_eq!(clusters[3], CaseCluster::Single(1 << 40, 'k'));
+        assert_eq!(clusters[1].high(), 15);
+    }
+
+    #[test]
+    fn test_sparse_cases_stay_single() {
+        let cases: Vec<(i64, u8)> = (0..8).map(|k| (k * 100, k as u8)).collect();
+        let clusters = cluster_cases(&cases);
+        assert_eq!(clusters.len(), 8);
+        assert!(clusters.iter().all(|c| matches!(c, CaseCluster::Single(..))));
+    }
+
+    #[test]
+    fn test_case_value_folds_constant_expressions() {
+        let neg = Expr::UnaryOp { op: UnaryOp::Neg, expr: Box::new(Expr::Number(3)) };
+        assert_eq!(case_value(&neg), Some(-3));
+        let shl = Expr::BitwiseOp {
+            op: BitwiseOp::LeftShift,
+            left: Box::new(Expr::Number(1)),
+            right: Box::new(Expr::Number(4)),
+        };
+        assert_eq!(case_value(&shl), Some(16));
+        assert_eq!(case_value(&Expr::Variable("x".into())), None);
+    }
+}
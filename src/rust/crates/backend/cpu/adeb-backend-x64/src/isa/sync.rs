@@ -0,0 +1,545 @@
+// ============================================================
+// ADead-BIB — std::mutex, std::condition_variable y std::atomic
+// ============================================================
+// Todo objeto es una palabra de 8 bytes a cero (estado inicial válido),
+// así que no hay constructor ni destructor:
+//
+//   - mutex Linux: palabra de futex de 32 bits (0 libre, 1 tomado,
+//     2 tomado con esperas, como en "Futexes Are Tricky"). lock es un
+//     lock cmpxchg en el sitio de la llamada; si falla, unas vueltas
+//     con pause y luego futex(WAIT). unlock es un lock dec en línea y
+//     solo hace syscall si alguien esperaba
+//   - condition_variable Linux: secuencia en los 4 bytes bajos y
+//     esperas en los altos. notify incrementa la secuencia y solo
+//     despierta por futex si hay esperas; wait duerme contra la
+//     secuencia que vio antes de soltar el mutex
+//   - Windows: SRWLOCK y CONDITION_VARIABLE (ambos de 8 bytes e
+//     inicializados a cero) por la IAT de kernel32; el camino sin
+//     contención ya es un interlocked en modo usuario
+//   - atomic<T> de enteros o punteros: siempre en línea, xchg /
+//     lock xadd / lock cmpxchg sobre la palabra. En x86 todo lock es
+//     barrera completa, así que memory_order se ignora y load es un mov
+// ============================================================
+
+use super::{ADeadIR, ADeadOp, CallTarget, Condition, Label, Operand, Reg};
+
+/// Vueltas con pause antes de dormir en el futex
+const SPINS: i32 = 100;
+
+const SYS_FUTEX: i32 = 202;
+const FUTEX_WAIT_PRIVATE: i32 = 128;
+const FUTEX_WAKE_PRIVATE: i32 = 129;
+const WAKE_ALL: i32 = i32::MAX;
+
+/// Cómo se duerme y se despierta
+#[derive(Debug, Clone, Copy)]
+pub enum SyncApi {
+    /// Linux: futex por syscall
+    Futex,
+    /// Windows: SRW locks y variables de condición de kernel32
+    Iat {
+        acquire: u32,
+        release: u32,
+        try_acquire: u32,
+        sleep: u32,
+        wake: u32,
+        wake_all: u32,
+    },
+}
+
+#[derive(Debug, Clone, Copy)]
+pub struct SyncRuntime {
+    api: SyncApi,
+    args: [Reg; 3],
+    /// Linux: mutex ocupado en RDI; gira y luego duerme
+    lock_slow: Label,
+    /// Linux: toma el mutex de RDI marcándolo con esperas (2)
+    park: Label,
+    /// Linux: el unlock vio esperas; libera RDI y despierta a una
+    unlock_slow: Label,
+    /// Linux: adb_cond_wait(cv = RDI, m = RSI)
+    wait: Label,
+    /// Linux: despierta a RSI esperas de la variable de RDI
+    wake: Label,
+}
+
+fn mov(ir: &mut ADeadIR, dst: Reg, src: Operand) {
+    ir.emit(ADeadOp::Mov { dst: Operand::Reg(dst), src });
+}
+
+fn jcc(ir: &mut ADeadIR, cond: Condition, target: Label) {
+    ir.emit(ADeadOp::Jcc { cond, target });
+}
+
+fn call(ir: &mut ADeadIR, target: Label) {
+    ir.emit(ADeadOp::Call { target: CallTarget::Relative(target) });
+}
+
+fn push(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Push { src: Operand::Reg(reg) });
+}
+
+fn pop(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Pop { dst: reg });
+}
+
+fn zero(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Xor { dst: reg, src: reg });
+}
+
+fn gpr(reg: Reg) -> u8 {
+    match reg {
+        Reg::RAX => 0,
+        Reg::RCX => 1,
+        Reg::RDX => 2,
+        Reg::RBX => 3,
+        Reg::RSI => 6,
+        Reg::RDI => 7,
+        Reg::R8 => 8,
+        Reg::R9 => 9,
+        Reg::R10 => 10,
+        Reg::R11 => 11,
+        _ => unreachable!("sync no direcciona con {:?}", reg),
+    }
+}
+
+/// [lock] op r/m, reg con memoria en [base + disp8]; `wide` = 64 bits.
+/// `reg` es un registro o la extensión /n del opcode
+fn mem_op(ir: &mut ADeadIR, lock: bool, wide: bool, opcode: &[u8], reg: u8, base: Reg, disp: i8, imm: &[u8]) {
+    let b = gpr(base);
+    let mut bytes = Vec::with_capacity(8);
+    if lock {
+        bytes.push(0xF0);
+    }
+    if wide || reg >= 8 || b >= 8 {
+        bytes.push(0x40 | (wide as u8) << 3 | (reg >> 3) << 2 | (b >> 3));
+    }
+    bytes.extend_from_slice(opcode);
+    let mode = if disp != 0 { 0x40 } else { 0 };
+    bytes.push(mode | (reg & 7) << 3 | (b & 7));
+    if disp != 0 {
+        bytes.push(disp as u8);
+    }
+    bytes.extend_from_slice(imm);
+    ir.emit(ADeadOp::RawBytes(bytes));
+}
+
+fn pause(ir: &mut ADeadIR) {
+    ir.emit(ADeadOp::RawBytes(vec![0xF3, 0x90]));
+}
+
+/// futex(RDI, op, val); conserva RSI
+fn futex(ir: &mut ADeadIR, op: i32, val: Operand) {
+    push(ir, Reg::RSI);
+    mov(ir, Reg::RDX, val);
+    mov(ir, Reg::RSI, Operand::Imm32(op));
+    zero(ir, Reg::R10);
+    mov(ir, Reg::RAX, Operand::Imm32(SYS_FUTEX));
+    ir.emit(ADeadOp::Syscall);
+    pop(ir, Reg::RSI);
+}
+
+/// RAX = 0/1 según ZF
+fn zf_to_rax(ir: &mut ADeadIR) {
+    ir.emit(ADeadOp::SetCC { cond: Condition::Equal, dst: Reg::RAX });
+    ir.emit(ADeadOp::MovZx { dst: Reg::RAX, src: Reg::RAX });
+}
+
+impl SyncRuntime {
+    pub fn new(ir: &mut ADeadIR, api: SyncApi) -> Self {
+        Self {
+            api,
+            args: match api {
+                SyncApi::Iat { .. } => [Reg::RCX, Reg::RDX, Reg::R8],
+                SyncApi::Futex => [Reg::RDI, Reg::RSI, Reg::RDX],
+            },
+            lock_slow: ir.new_label(),
+            park: ir.new_label(),
+            unlock_slow: ir.new_label(),
+            wait: ir.new_label(),
+            wake: ir.new_label(),
+        }
+    }
+
+    /// Emite la llamada `name` en el sitio, con sus argumentos ya en
+    /// registros; false si no es de este módulo
+    pub fn emit_inline(&self, ir: &mut ADeadIR, name: &str) -> bool {
+        let [p, v, w] = self.args;
+        match name {
+            "adb_atomic_load" => mem_op(ir, false, true, &[0x8B], 0, p, 0, &[]),
+            // xchg: store seq_cst sin mfence; exchange devuelve lo anterior
+            "adb_atomic_store" | "adb_atomic_exchange" => {
+                mov(ir, Reg::RAX, Operand::Reg(v));
+                mem_op(ir, false, true, &[0x87], 0, p, 0, &[]);
+            }
+            "adb_atomic_fetch_add" | "adb_atomic_fetch_sub" => {
+                mov(ir, Reg::RAX, Operand::Reg(v));
+                if name == "adb_atomic_fetch_sub" {
+                    ir.emit(ADeadOp::Neg { dst: Reg::RAX });
+                }
+                mem_op(ir, true, true, &[0x0F, 0xC1], 0, p, 0, &[]);
+            }
+            // and/or/xor no tienen forma que devuelva el valor anterior
+            "adb_atomic_fetch_and" | "adb_atomic_fetch_or" | "adb_atomic_fetch_xor" => {
+                let retry = ir.new_label();
+                mem_op(ir, false, true, &[0x8B], 0, p, 0, &[]);
+                ir.emit(ADeadOp::Label(retry));
+                mov(ir, Reg::R11, Operand::Reg(Reg::RAX));
+                ir.emit(match name {
+                    "adb_atomic_fetch_and" => ADeadOp::And { dst: Reg::R11, src: v },
+                    "adb_atomic_fetch_or" => ADeadOp::Or { dst: Reg::R11, src: v },
+                    _ => ADeadOp::Xor { dst: Reg::R11, src: v },
+                });
+                mem_op(ir, true, true, &[0x0F, 0xB1], gpr(Reg::R11), p, 0, &[]);
+                jcc(ir, Condition::NotEqual, retry);
+            }
+            // adb_atomic_cas(p, &esperado, nuevo) → 1 si cambió; si no,
+            // deja el valor actual en esperado (compare_exchange_*)
+            "adb_atomic_cas" => {
+                let done = ir.new_label();
+                mem_op(ir, false, true, &[0x8B], 0, v, 0, &[]);
+                mem_op(ir, true, true, &[0x0F, 0xB1], gpr(w), p, 0, &[]);
+                jcc(ir, Condition::Equal, done);
+                ir.emit(ADeadOp::Mov { dst: Operand::Mem { base: v, disp: 0 }, src: Operand::Reg(Reg::RAX) });
+                ir.emit(ADeadOp::Label(done));
+                zf_to_rax(ir);
+            }
+            _ => return self.emit_lock_call(ir, name),
+        }
+        true
+    }
+
+    fn emit_lock_call(&self, ir: &mut ADeadIR, name: &str) -> bool {
+        match self.api {
+            SyncApi::Iat { acquire, release, try_acquire, sleep, wake, wake_all } => {
+                let iat_rva = match name {
+                    "adb_mutex_lock" => acquire,
+                    "adb_mutex_unlock" => release,
+                    "adb_mutex_try_lock" => try_acquire,
+                    "adb_cond_wait" => {
+                        mov(ir, Reg::R8, Operand::Imm32(-1)); // INFINITE
+                        zero(ir, Reg::R9);
+                        sleep
+                    }
+                    "adb_cond_notify_one" => wake,
+                    "adb_cond_notify_all" => wake_all,
+                    _ => return false,
+                };
+                ir.emit(ADeadOp::Cld);
+                ir.emit(ADeadOp::CallIAT { iat_rva });
+                if name == "adb_mutex_try_lock" {
+                    // BOOLEAN en AL
+                    ir.emit(ADeadOp::MovZx { dst: Reg::RAX, src: Reg::RAX });
+                }
+            }
+            SyncApi::Futex => {
+                let m = self.args[0];
+                let done = ir.new_label();
+                match name {
+                    "adb_mutex_lock" | "adb_mutex_try_lock" => {
+                        zero(ir, Reg::RAX);
+                        mov(ir, Reg::RDX, Operand::Imm32(1));
+                        mem_op(ir, true, false, &[0x0F, 0xB1], gpr(Reg::RDX), m, 0, &[]);
+                        if name == "adb_mutex_try_lock" {
+                            zf_to_rax(ir);
+                            return true;
+                        }
+                        jcc(ir, Condition::Equal, done);
+                        call(ir, self.lock_slow);
+                    }
+                    "adb_mutex_unlock" => {
+                        // lock dec: de 1 a 0 sin esperas no hay syscall
+                        mem_op(ir, true, false, &[0xFF], 1, m, 0, &[]);
+                        jcc(ir, Condition::Equal, done);
+                        call(ir, self.unlock_slow);
+                    }
+                    "adb_cond_wait" => call(ir, self.wait),
+                    "adb_cond_notify_one" | "adb_cond_notify_all" => {
+                        mem_op(ir, true, false, &[0xFF], 0, m, 0, &[]);
+                        mem_op(ir, false, false, &[0x83], 7, m, 4, &[0]);
+                        jcc(ir, Condition::Equal, done);
+                        let count = if name == "adb_cond_notify_one" { 1 } else { WAKE_ALL };
+                        mov(ir, Reg::RSI, Operand::Imm32(count));
+                        call(ir, self.wake);
+                    }
+                    _ => return false,
+                }
+                ir.emit(ADeadOp::Label(done));
+            }
+        }
+        true
+    }
+
+    pub fn emit_routines(&self, ir: &mut ADeadIR) {
+        if let SyncApi::Futex = self.api {
+            self.emit_lock_slow(ir);
+            self.emit_unlock_slow(ir);
+            self.emit_wait(ir);
+            self.emit_wake(ir);
+        }
+    }
+
+    // ---- Linux ----
+
+    /// Espera activa acotada mientras el dueño suelta; si no, a dormir
+    fn emit_lock_slow(&self, ir: &mut ADeadIR) {
+        let spin = ir.new_label();
+        let busy = ir.new_label();
+        let done = ir.new_label();
+        let sleep = ir.new_label();
+        ir.emit(ADeadOp::Label(self.lock_slow));
+        mov(ir, Reg::RCX, Operand::Imm32(SPINS));
+        ir.emit(ADeadOp::Label(spin));
+        // Solo se intenta el cmpxchg si se ha visto libre (no ensucia la línea)
+        mem_op(ir, false, false, &[0x8B], 0, Reg::RDI, 0, &[]);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::NotEqual, busy);
+        mov(ir, Reg::RDX, Operand::Imm32(1));
+        mem_op(ir, true, false, &[0x0F, 0xB1], gpr(Reg::RDX), Reg::RDI, 0, &[]);
+        jcc(ir, Condition::Equal, done);
+        ir.emit(ADeadOp::Label(busy));
+        pause(ir);
+        ir.emit(ADeadOp::Dec { dst: Operand::Reg(Reg::RCX) });
+        jcc(ir, Condition::NotEqual, spin);
+
+        // park: xchg a 2; si estaba libre ya es nuestro, si no dormir.
+        // Quien entra por aquí deja 2 aunque no quede nadie esperando:
+        // el siguiente unlock hará una syscall de más, nunca de menos
+        ir.emit(ADeadOp::Label(self.park));
+        mov(ir, Reg::RAX, Operand::Imm32(2));
+        mem_op(ir, false, false, &[0x87], 0, Reg::RDI, 0, &[]);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::NotEqual, sleep);
+        ir.emit(ADeadOp::Label(done));
+        ir.emit(ADeadOp::Ret);
+
+        ir.emit(ADeadOp::Label(sleep));
+        futex(ir, FUTEX_WAIT_PRIVATE, Operand::Imm32(2));
+        ir.emit(ADeadOp::Jmp { target: self.park });
+    }
+
+    fn emit_unlock_slow(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.unlock_slow));
+        zero(ir, Reg::RAX);
+        ir.emit(ADeadOp::Store32 { base: Reg::RDI, disp: 0, src: Reg::RAX });
+        futex(ir, FUTEX_WAKE_PRIVATE, Operand::Imm32(1));
+        ir.emit(ADeadOp::Ret);
+    }
+
+    fn emit_wait(&self, ir: &mut ADeadIR) {
+        let unlocked = ir.new_label();
+        ir.emit(ADeadOp::Label(self.wait));
+        push(ir, Reg::RSI);
+        push(ir, Reg::RDI);
+        // Apuntarse antes de leer la secuencia: un notify posterior a
+        // la lectura ve la espera, y uno anterior cambia la secuencia
+        // y el futex vuelve enseguida
+        mem_op(ir, true, false, &[0xFF], 0, Reg::RDI, 4, &[]);
+        ir.emit(ADeadOp::Load32 { dst: Reg::R9, base: Reg::RDI, disp: 0 });
+        mov(ir, Reg::RDI, Operand::Reg(Reg::RSI));
+        mem_op(ir, true, false, &[0xFF], 1, Reg::RDI, 0, &[]);
+        jcc(ir, Condition::Equal, unlocked);
+        call(ir, self.unlock_slow);
+        ir.emit(ADeadOp::Label(unlocked));
+        mov(ir, Reg::RDI, Operand::Mem { base: Reg::RSP, disp: 0 });
+        futex(ir, FUTEX_WAIT_PRIVATE, Operand::Reg(Reg::R9));
+        mem_op(ir, true, false, &[0xFF], 1, Reg::RDI, 4, &[]);
+        // Puede haber más despertados compitiendo: volver con 2
+        mov(ir, Reg::RDI, Operand::Mem { base: Reg::RSP, disp: 8 });
+        call(ir, self.park);
+        pop(ir, Reg::RDI);
+        pop(ir, Reg::RSI);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    fn emit_wake(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.wake));
+        futex(ir, FUTEX_WAKE_PRIVATE, Operand::Reg(Reg::RSI));
+        ir.emit(ADeadOp::Ret);
+    }
+}
+
+#[cfg(all(test, target_os = "linux", target_arch = "x86_64"))]
+mod tests {
+    use super::*;
+    use crate::isa::test_jit::JitCode;
+    use std::sync::Arc;
+
+    const ENTRIES: [&str; 15] = [
+        "adb_mutex_lock",
+        "adb_mutex_unlock",
+        "adb_mutex_try_lock",
+        "adb_cond_wait",
+        "adb_cond_notify_one",
+        "adb_cond_notify_all",
+        "adb_atomic_load",
+        "adb_atomic_store",
+        "adb_atomic_exchange",
+        "adb_atomic_fetch_add",
+        "adb_atomic_fetch_sub",
+        "adb_atomic_fetch_and",
+        "adb_atomic_fetch_or",
+        "adb_atomic_fetch_xor",
+        "adb_atomic_cas",
+    ];
+
+    struct Code {
+        jit: JitCode,
+        labels: Vec<Label>,
+    }
+
+    impl Code {
+        /// Cada secuencia en línea envuelta en una función con su ret
+        fn build() -> Self {
+            let mut ir = ADeadIR::new();
+            let sync = SyncRuntime::new(&mut ir, SyncApi::Futex);
+            let labels: Vec<Label> = ENTRIES
+                .iter()
+                .map(|name| {
+                    let label = ir.new_label();
+                    ir.emit(ADeadOp::Label(label));
+                    assert!(sync.emit_inline(&mut ir, name), "{}", name);
+                    ir.emit(ADeadOp::Ret);
+                    label
+                })
+                .collect();
+            sync.emit_routines(&mut ir);
+            Code { jit: JitCode::new(ir.ops()), labels }
+        }
+
+        fn label(&self, name: &str) -> Label {
+            self.labels[ENTRIES.iter().position(|n| *n == name).unwrap()]
+        }
+
+        fn f1(&self, name: &str) -> extern "C" fn(*mut i64) -> i64 {
+            unsafe { self.jit.func(self.label(name)) }
+        }
+
+        fn f2(&self, name: &str) -> extern "C" fn(*mut i64, i64) -> i64 {
+            unsafe { self.jit.func(self.label(name)) }
+        }
+    }
+
+    #[test]
+    fn test_atomics() {
+        let code = Code::build();
+        let mut x = 5i64;
+        assert_eq!(code.f1("adb_atomic_load")(&mut x), 5);
+        code.f2("adb_atomic_store")(&mut x, -3);
+        assert_eq!(x, -3);
+        assert_eq!(code.f2("adb_atomic_exchange")(&mut x, 10), -3);
+        assert_eq!(code.f2("adb_atomic_fetch_add")(&mut x, 7), 10);
+        assert_eq!(code.f2("adb_atomic_fetch_sub")(&mut x, 20), 17);
+        assert_eq!(x, -3);
+        x = 0b1100;
+        assert_eq!(code.f2("adb_atomic_fetch_and")(&mut x, 0b0110), 0b1100);
+        assert_eq!(code.f2("adb_atomic_fetch_or")(&mut x, 0b0001), 0b0100);
+        assert_eq!(code.f2("adb_atomic_fetch_xor")(&mut x, 0b0111), 0b0101);
+        assert_eq!(x, 0b0010);
+
+        let cas: extern "C" fn(*mut i64, *mut i64, i64) -> i64 = unsafe { code.jit.func(code.label("adb_atomic_cas")) };
+        let mut expected = 1;
+        assert_eq!(cas(&mut x, &mut expected, 9), 0);
+        assert_eq!((x, expected), (2, 2));
+        assert_eq!(cas(&mut x, &mut expected, 9), 1);
+        assert_eq!(x, 9);
+
+        // Contadores compartidos entre hilos
+        let code = Arc::new(code);
+        let shared = Arc::new(std::sync::atomic::AtomicI64::new(0));
+        let threads: Vec<_> = (0..8)
+            .map(|_| {
+                let (code, shared) = (code.clone(), shared.clone());
+                std::thread::spawn(move || {
+                    let add = code.f2("adb_atomic_fetch_add");
+                    for _ in 0..100_000 {
+                        add(shared.as_ptr(), 1);
+                    }
+                })
+            })
+            .collect();
+        threads.into_iter().for_each(|t| t.join().unwrap());
+        assert_eq!(shared.load(std::sync::atomic::Ordering::SeqCst), 800_000);
+    }
+
+    #[test]
+    fn test_mutex_and_condvar() {
+        struct Shared {
+            mutex: i64,
+            cond: i64,
+            counter: i64,
+            turn: i64,
+        }
+        let code = Arc::new(Code::build());
+        let shared = Arc::new(std::cell::UnsafeCell::new(Shared { mutex: 0, cond: 0, counter: 0, turn: 0 }));
+        struct Ptr(Arc<std::cell::UnsafeCell<Shared>>);
+        unsafe impl Send for Ptr {}
+
+        let try_lock = code.f1("adb_mutex_try_lock");
+        let unlock = code.f1("adb_mutex_unlock");
+        unsafe {
+            let s = &mut *shared.get();
+            assert_eq!(try_lock(&mut s.mutex), 1);
+            assert_eq!(try_lock(&mut s.mutex), 0);
+            unlock(&mut s.mutex);
+            assert_eq!(s.mutex, 0);
+        }
+
+        // Exclusión mutua con contención: se acaba durmiendo en el futex
+        let threads: Vec<_> = (0..6)
+            .map(|_| {
+                let (code, ptr) = (code.clone(), Ptr(shared.clone()));
+                std::thread::spawn(move || {
+                    let ptr = ptr;
+                    let s = ptr.0.get();
+                    let (lock, unlock) = (code.f1("adb_mutex_lock"), code.f1("adb_mutex_unlock"));
+                    for _ in 0..50_000 {
+                        unsafe {
+                            lock(&mut (*s).mutex);
+                            let v = std::ptr::read_volatile(&(*s).counter);
+                            std::ptr::write_volatile(&mut (*s).counter, v + 1);
+                            unlock(&mut (*s).mutex);
+                        }
+                    }
+                })
+            })
+            .collect();
+        threads.into_iter().for_each(|t| t.join().unwrap());
+        unsafe {
+            assert_eq!((*shared.get()).counter, 300_000);
+            assert_eq!((*shared.get()).mutex, 0);
+        }
+
+        // Ping-pong por turnos con wait/notify_all
+        const ROUNDS: i64 = 2_000;
+        let threads: Vec<_> = (0..2i64)
+            .map(|me| {
+                let (code, ptr) = (code.clone(), Ptr(shared.clone()));
+                std::thread::spawn(move || {
+                    let ptr = ptr;
+                    let s = ptr.0.get();
+                    let (lock, unlock) = (code.f1("adb_mutex_lock"), code.f1("adb_mutex_unlock"));
+                    let wait = code.f2("adb_cond_wait");
+                    let notify_all = code.f1("adb_cond_notify_all");
+                    for _ in 0..ROUNDS {
+                        unsafe {
+                            lock(&mut (*s).mutex);
+                            while std::ptr::read_volatile(&(*s).turn) % 2 != me {
+                                wait(&mut (*s).cond, &mut (*s).mutex as *mut i64 as i64);
+                            }
+                            std::ptr::write_volatile(&mut (*s).turn, (*s).turn + 1);
+                            notify_all(&mut (*s).cond);
+                            unlock(&mut (*s).mutex);
+                        }
+                    }
+                })
+            })
+            .collect();
+        threads.into_iter().for_each(|t| t.join().unwrap());
+        unsafe {
+            assert_eq!((*shared.get()).turn, 2 * ROUNDS);
+            // Ninguna espera quedó apuntada
+            assert_eq!((*shared.get()).cond >> 32, 0);
+        }
+    }
+}
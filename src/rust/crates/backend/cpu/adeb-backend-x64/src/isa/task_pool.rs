@@ -0,0 +1,1152 @@
+// ============================================================
+// ADead-BIB — Pool de tareas con work stealing
+// ============================================================
+// adb_parallel_for / adb_async (std::async y adb::parallel_for de
+// C++ bajan aquí) sin un hilo del sistema por tarea:
+//
+//   - Un worker por CPU (sched_getaffinity / GetSystemInfo al
+//     arrancar, no en compilación), hasta MAX_WORKERS. El hilo que
+//     arranca el pool es el worker 0; los demás son hilos propios
+//     (clone en Linux, CreateThread en Windows)
+//   - Cada worker tiene un deque Chase-Lev: el dueño pone y saca por
+//     abajo sin locks, los ladrones roban por arriba con cmpxchg
+//   - parallel_for parte el rango por la mitad hasta `grain`; la
+//     mitad derecha va al deque, la izquierda se sigue partiendo
+//   - Quien espera (parallel_for, future.get) no se bloquea: ejecuta
+//     tareas propias o robadas hasta que lo suyo termina
+//   - Workers sin trabajo giran un rato y luego duermen (futex en
+//     Linux, semáforo en Windows); cada push despierta a uno
+//
+// Sin TLS (no hay directorio TLS en el PE ni FS en el proceso Linux):
+// el worker actual sale de la pila. En Linux las pilas son nuestras,
+// de 1 MiB alineadas, así que es una resta y un shift; en Windows
+// se compara NT_TIB.StackBase (gs:[8]) con la de cada worker. Un hilo
+// que no es del pool ejecuta todo en línea.
+//
+// Estado en .data (STATE_SIZE bytes): cabecera del pool y, en otra
+// línea de caché, el allocator de registros de future. Registros de
+// worker y deques en páginas propias (WORKER_BYTES por worker).
+//
+// El stdout con buffer de linux_stdio.rs no es thread-safe: printf
+// desde tareas en paralelo puede mezclar la salida.
+// ============================================================
+
+use super::slab_heap::{self, PageSource};
+use super::{ADeadIR, ADeadOp, CallTarget, Condition, Label, Operand, Reg};
+
+pub const MAX_WORKERS: u64 = 64;
+/// Entradas por deque (potencia de 2) y bytes por entrada
+pub const DEQUE_CAP: i32 = 1024;
+const DEQUE_BITS: u8 = 10;
+const ENTRY_BITS: u8 = 5;
+/// Pila de cada worker en Linux: 1 << STACK_BITS (1 MiB, como Windows)
+const STACK_BITS: u8 = 20;
+/// Vueltas sin trabajo antes de dormir
+const IDLE_SPINS: i32 = 64;
+
+// ---- Estado global ----
+const WORKERS: i32 = 0; // 0 = sin arrancar, -1 = sin páginas (todo en línea)
+const LOCK: i32 = 8;
+const REGION: i32 = 16;
+const STACKS: i32 = 24;
+const SLEEPERS: i32 = 32;
+const EPOCH: i32 = 40; // palabra del futex
+const SEM: i32 = 48;
+const FUT_LOCK: i32 = 64;
+const FUT_FREE: i32 = 72;
+const FUT_CUR: i32 = 80;
+const FUT_END: i32 = 88;
+pub const STATE_SIZE: usize = 128;
+pub const STATE_SLOT: &str = "__pool.state";
+pub const STATE_ALIGN: u64 = 64;
+
+// ---- Registro de worker: top solo en su línea ----
+const WORKER_RECORD: i32 = 128;
+const WORKER_SHIFT: u8 = 7;
+const TOP: i32 = 0;
+const BOTTOM: i32 = 64;
+const BUF: i32 = 72;
+const IDENT: i32 = 80;
+const SEED: i32 = 88;
+pub const WORKER_BYTES: i32 = WORKER_RECORD + (DEQUE_CAP << ENTRY_BITS);
+
+// ---- Entrada del deque: rutina y tres argumentos ----
+const RUN: i32 = 0;
+const ARG_A: i32 = 8;
+const ARG_B: i32 = 16;
+const ARG_C: i32 = 24;
+
+// ---- Trabajo de parallel_for, en la pila de quien llama ----
+const JOB_FN: i32 = 0;
+const JOB_GRAIN: i32 = 8;
+const JOB_PENDING: i32 = 16;
+/// 0: fn(i) por índice (C); si no, fn(lo, hi, ctx) por trozo (runtime)
+const JOB_CTX: i32 = 24;
+const JOB_BYTES: i32 = 32;
+
+// ---- Registro de future (32 bytes; [0] enlaza la free list) ----
+const FUT_FN: i32 = 0;
+const FUT_ARG: i32 = 8;
+const FUT_RESULT: i32 = 16;
+const FUT_DONE: i32 = 24;
+const FUT_RECORD: i32 = 32;
+const FUT_SLAB: i32 = 64 * 1024;
+
+const SYS_SCHED_GETAFFINITY: i32 = 204; // sched_getaffinity
+const SYS_CLONE: i32 = 56;
+const SYS_FUTEX: i32 = 202;
+const FUTEX_WAIT_PRIVATE: i32 = 128;
+const FUTEX_WAKE_PRIVATE: i32 = 129;
+/// CLONE_VM | FS | FILES | SIGHAND | THREAD | SYSVSEM
+const CLONE_THREAD_FLAGS: i32 = 0x50F00;
+const AFFINITY_BYTES: i32 = 128;
+/// Offset de dwNumberOfProcessors en SYSTEM_INFO
+const SYSINFO_CPUS: i32 = 32;
+
+/// Cómo se crean, cuentan y duermen los hilos
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum ThreadApi {
+    /// Linux: clone/futex/sched_getaffinity por syscall
+    Syscall,
+    /// Windows: kernel32 por la IAT
+    Iat {
+        create_thread: u32,
+        system_info: u32,
+        create_semaphore: u32,
+        release_semaphore: u32,
+        wait: u32,
+    },
+}
+
+/// Estado en .data y labels de las rutinas
+#[derive(Debug, Clone, Copy)]
+pub struct TaskPool {
+    pub state: u64,
+    pages: PageSource,
+    threads: ThreadApi,
+    args: [Reg; 4],
+    /// adb_parallel_for(begin, end, grain, fn): fn(i) para i en [begin, end);
+    /// grain <= 0 elige uno (rango / (8 × workers))
+    pub parallel_for: Label,
+    /// adb_async(fn, arg) → future; fn(arg) corre en el pool
+    pub spawn: Label,
+    /// adb_future_get(future) → resultado; libera el future
+    pub get: Label,
+    /// adb_future_wait(future): espera sin liberar
+    pub wait: Label,
+    /// adb_pool_size() → workers
+    pub size: Label,
+    /// Para otras rutinas del runtime (par_algorithms.rs): RCX = lo,
+    /// RDX = hi, R8 = grain (<= 0 automático), R9 = cuerpo, R10 = ctx;
+    /// vuelve cuando todo [lo, hi) está hecho. El cuerpo recibe trozos
+    /// en RCX = lo, RDX = hi, R8 = ctx y conserva RBX, RBP y R12-R15.
+    /// Entrada con RSP ≡ 8 (mod 16); conserva RBX y R12-R15
+    pub ranges: Label,
+    start: Label,
+    current: Label,
+    run_task: Label,
+    push: Label,
+    pop: Label,
+    steal: Label,
+    wake: Label,
+    range_runner: Label,
+    async_runner: Label,
+    worker_loop: Label,
+    thread_entry: Label,
+    fut_alloc: Label,
+    fut_free: Label,
+    map: Label,
+}
+
+fn mov(ir: &mut ADeadIR, dst: Reg, src: Operand) {
+    ir.emit(ADeadOp::Mov { dst: Operand::Reg(dst), src });
+}
+
+fn mem(base: Reg, disp: i32) -> Operand {
+    Operand::Mem { base, disp }
+}
+
+fn store(ir: &mut ADeadIR, base: Reg, disp: i32, src: Reg) {
+    ir.emit(ADeadOp::Mov { dst: mem(base, disp), src: Operand::Reg(src) });
+}
+
+fn jcc(ir: &mut ADeadIR, cond: Condition, target: Label) {
+    ir.emit(ADeadOp::Jcc { cond, target });
+}
+
+fn call(ir: &mut ADeadIR, target: Label) {
+    ir.emit(ADeadOp::Call { target: CallTarget::Relative(target) });
+}
+
+fn push(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Push { src: Operand::Reg(reg) });
+}
+
+fn pop(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Pop { dst: reg });
+}
+
+fn add_imm(ir: &mut ADeadIR, reg: Reg, imm: i32) {
+    ir.emit(ADeadOp::Add { dst: Operand::Reg(reg), src: Operand::Imm32(imm) });
+}
+
+fn zero(ir: &mut ADeadIR, reg: Reg) {
+    ir.emit(ADeadOp::Xor { dst: reg, src: reg });
+}
+
+fn pause(ir: &mut ADeadIR) {
+    ir.emit(ADeadOp::RawBytes(vec![0xF3, 0x90]));
+}
+
+/// mfence: el push tiene que ser visible antes de leer SLEEPERS
+fn mfence(ir: &mut ADeadIR) {
+    ir.emit(ADeadOp::RawBytes(vec![0x0F, 0xAE, 0xF0]));
+}
+
+/// lock add qword [R11 + disp], src
+fn lock_add(ir: &mut ADeadIR, disp: i32, src: Reg) {
+    let reg = match src {
+        Reg::RAX => 0,
+        Reg::RCX => 1,
+        _ => unreachable!("lock add solo desde RAX/RCX"),
+    };
+    ir.emit(ADeadOp::RawBytes(vec![0xF0, 0x49, 0x01, 0x43 | (reg << 3), disp as u8]));
+}
+
+/// lock cmpxchg [base], R10 (RAX = esperado) — solo TOP, disp 0
+fn cas_top(ir: &mut ADeadIR, base: Reg) {
+    let rm = match base {
+        Reg::RBX => 3,
+        Reg::RDI => 7,
+        _ => unreachable!("cmpxchg solo sobre RBX/RDI"),
+    };
+    ir.emit(ADeadOp::RawBytes(vec![0xF0, 0x4C, 0x0F, 0xB1, 0x10 | rm]));
+}
+
+/// Spinlock en [R11 + disp] (RCX de trabajo)
+fn acquire(ir: &mut ADeadIR, disp: i32) {
+    let spin = ir.new_label();
+    let got = ir.new_label();
+    ir.emit(ADeadOp::Label(spin));
+    mov(ir, Reg::RCX, Operand::Imm32(1));
+    // xchg [r11 + disp], rcx
+    ir.emit(ADeadOp::RawBytes(vec![0x49, 0x87, 0x4B, disp as u8]));
+    ir.emit(ADeadOp::Test { left: Reg::RCX, right: Reg::RCX });
+    jcc(ir, Condition::Equal, got);
+    pause(ir);
+    ir.emit(ADeadOp::Jmp { target: spin });
+    ir.emit(ADeadOp::Label(got));
+}
+
+fn release(ir: &mut ADeadIR, disp: i32) {
+    zero(ir, Reg::RCX);
+    store(ir, Reg::R11, disp, Reg::RCX);
+}
+
+/// RAX = índice (≥ 0) → RAX = índice de su entrada × 32 (módulo DEQUE_CAP)
+fn slot_offset(ir: &mut ADeadIR) {
+    ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: 64 - DEQUE_BITS });
+    ir.emit(ADeadOp::Shr { dst: Reg::RAX, amount: 64 - DEQUE_BITS - ENTRY_BITS });
+}
+
+/// Entrada en RAX → RCX = rutina, RDX/R8/R9 = argumentos
+fn load_entry(ir: &mut ADeadIR) {
+    mov(ir, Reg::RCX, mem(Reg::RAX, RUN));
+    mov(ir, Reg::RDX, mem(Reg::RAX, ARG_A));
+    mov(ir, Reg::R8, mem(Reg::RAX, ARG_B));
+    mov(ir, Reg::R9, mem(Reg::RAX, ARG_C));
+}
+
+impl TaskPool {
+    pub fn new(ir: &mut ADeadIR, state: u64, pages: PageSource, threads: ThreadApi) -> Self {
+        let windows = matches!(threads, ThreadApi::Iat { .. });
+        Self {
+            state,
+            pages,
+            threads,
+            args: if windows {
+                [Reg::RCX, Reg::RDX, Reg::R8, Reg::R9]
+            } else {
+                [Reg::RDI, Reg::RSI, Reg::RDX, Reg::RCX]
+            },
+            parallel_for: ir.new_label(),
+            spawn: ir.new_label(),
+            get: ir.new_label(),
+            wait: ir.new_label(),
+            size: ir.new_label(),
+            ranges: ir.new_label(),
+            start: ir.new_label(),
+            current: ir.new_label(),
+            run_task: ir.new_label(),
+            push: ir.new_label(),
+            pop: ir.new_label(),
+            steal: ir.new_label(),
+            wake: ir.new_label(),
+            range_runner: ir.new_label(),
+            async_runner: ir.new_label(),
+            worker_loop: ir.new_label(),
+            thread_entry: ir.new_label(),
+            fut_alloc: ir.new_label(),
+            fut_free: ir.new_label(),
+            map: ir.new_label(),
+        }
+    }
+
+    /// Rutina para una llamada de C/C++, si es del pool
+    pub fn routine(&self, name: &str) -> Option<Label> {
+        match name {
+            "adb_parallel_for" => Some(self.parallel_for),
+            "adb_async" => Some(self.spawn),
+            "adb_future_get" => Some(self.get),
+            "adb_future_wait" => Some(self.wait),
+            "adb_pool_size" => Some(self.size),
+            _ => None,
+        }
+    }
+
+    pub fn emit_routines(&self, ir: &mut ADeadIR) {
+        slab_heap::emit_page_map(ir, self.map, self.pages);
+        self.emit_start(ir);
+        self.emit_current(ir);
+        self.emit_push(ir);
+        self.emit_pop(ir);
+        self.emit_steal(ir);
+        self.emit_wake(ir);
+        self.emit_run_task(ir);
+        self.emit_range_runner(ir);
+        self.emit_async_runner(ir);
+        self.emit_worker_loop(ir);
+        self.emit_fut_alloc(ir);
+        self.emit_fut_free(ir);
+        self.emit_ranges(ir);
+        self.emit_parallel_for(ir);
+        self.emit_spawn(ir);
+        self.emit_get(ir, self.get, true);
+        self.emit_get(ir, self.wait, false);
+        self.emit_size(ir);
+    }
+
+    fn state_base(&self, ir: &mut ADeadIR) {
+        mov(ir, Reg::R11, Operand::Imm64(self.state));
+    }
+
+    fn call_iat(ir: &mut ADeadIR, iat_rva: u32) {
+        ir.emit(ADeadOp::Cld);
+        ir.emit(ADeadOp::CallIAT { iat_rva });
+    }
+
+    // ---- Entradas desde C: la pila puede venir sin alinear ----
+
+    /// Guarda RBX, R12-R15, RSI, RDI y alinea RSP a 16
+    fn enter(ir: &mut ADeadIR) {
+        push(ir, Reg::RBP);
+        mov(ir, Reg::RBP, Operand::Reg(Reg::RSP));
+        for reg in [Reg::RBX, Reg::R12, Reg::R13, Reg::R14, Reg::R15, Reg::RSI, Reg::RDI] {
+            push(ir, reg);
+        }
+        mov(ir, Reg::RAX, Operand::Imm32(-16));
+        ir.emit(ADeadOp::And { dst: Reg::RSP, src: Reg::RAX });
+    }
+
+    fn leave(ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Lea { dst: Reg::RSP, src: mem(Reg::RBP, -56) });
+        for reg in [Reg::RDI, Reg::RSI, Reg::R15, Reg::R14, Reg::R13, Reg::R12, Reg::RBX] {
+            pop(ir, reg);
+        }
+        pop(ir, Reg::RBP);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// Arranque perezoso: cuenta CPUs, mapea deques (y pilas) y lanza
+    /// los workers. Conserva RBX y R12-R15
+    fn emit_start(&self, ir: &mut ADeadIR) {
+        let slow = ir.new_label();
+        let unlock = ir.new_label();
+        let counted = ir.new_label();
+        let at_least_one = ir.new_label();
+        let capped = ir.new_label();
+        let init = ir.new_label();
+        let spawn_loop = ir.new_label();
+        let spawned = ir.new_label();
+        let published = ir.new_label();
+        let no_pages = ir.new_label();
+        let done = ir.new_label();
+        // SYSTEM_INFO / máscara de afinidad y los args 5-6 de CreateThread
+        let frame = 32 + AFFINITY_BYTES + 8;
+
+        ir.emit(ADeadOp::Label(self.start));
+        self.state_base(ir);
+        ir.emit(ADeadOp::Cmp { left: mem(Reg::R11, WORKERS), right: Operand::Imm32(0) });
+        jcc(ir, Condition::Equal, slow);
+        ir.emit(ADeadOp::Ret);
+
+        ir.emit(ADeadOp::Label(slow));
+        acquire(ir, LOCK);
+        ir.emit(ADeadOp::Cmp { left: mem(Reg::R11, WORKERS), right: Operand::Imm32(0) });
+        jcc(ir, Condition::NotEqual, unlock);
+        for reg in [Reg::RBX, Reg::R12, Reg::R13, Reg::R14] {
+            push(ir, reg);
+        }
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm32(frame) });
+
+        // ---- R12 = CPUs disponibles, entre 1 y MAX_WORKERS ----
+        zero(ir, Reg::R12);
+        match self.threads {
+            ThreadApi::Syscall => {
+                let qword = ir.new_label();
+                let bits = ir.new_label();
+                let next = ir.new_label();
+                zero(ir, Reg::RDI);
+                mov(ir, Reg::RSI, Operand::Imm32(AFFINITY_BYTES));
+                ir.emit(ADeadOp::Lea { dst: Reg::RDX, src: mem(Reg::RSP, 32) });
+                mov(ir, Reg::RAX, Operand::Imm32(SYS_SCHED_GETAFFINITY));
+                ir.emit(ADeadOp::Syscall);
+                // RAX = bytes de máscara escritos (o -errno: ninguno)
+                ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(0) });
+                jcc(ir, Condition::LessEq, counted);
+                ir.emit(ADeadOp::Lea { dst: Reg::RCX, src: mem(Reg::RSP, 32) });
+                ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RCX) });
+                ir.emit(ADeadOp::Label(qword));
+                mov(ir, Reg::R8, mem(Reg::RCX, 0));
+                ir.emit(ADeadOp::Label(bits));
+                ir.emit(ADeadOp::Test { left: Reg::R8, right: Reg::R8 });
+                jcc(ir, Condition::Equal, next);
+                // x &= x - 1
+                ir.emit(ADeadOp::Lea { dst: Reg::R9, src: mem(Reg::R8, -1) });
+                ir.emit(ADeadOp::And { dst: Reg::R8, src: Reg::R9 });
+                ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R12) });
+                ir.emit(ADeadOp::Jmp { target: bits });
+                ir.emit(ADeadOp::Label(next));
+                add_imm(ir, Reg::RCX, 8);
+                ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: Operand::Reg(Reg::RAX) });
+                jcc(ir, Condition::Below, qword);
+            }
+            ThreadApi::Iat { system_info, .. } => {
+                ir.emit(ADeadOp::Lea { dst: Reg::RCX, src: mem(Reg::RSP, 32) });
+                Self::call_iat(ir, system_info);
+                ir.emit(ADeadOp::Load32 { dst: Reg::R12, base: Reg::RSP, disp: 32 + SYSINFO_CPUS });
+            }
+        }
+        ir.emit(ADeadOp::Label(counted));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R12), right: Operand::Imm32(1) });
+        jcc(ir, Condition::GreaterEq, at_least_one);
+        mov(ir, Reg::R12, Operand::Imm32(1));
+        ir.emit(ADeadOp::Label(at_least_one));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R12), right: Operand::Imm32(MAX_WORKERS as i32) });
+        jcc(ir, Condition::LessEq, capped);
+        mov(ir, Reg::R12, Operand::Imm32(MAX_WORKERS as i32));
+        ir.emit(ADeadOp::Label(capped));
+
+        // ---- R13 = registros + deques ----
+        mov(ir, Reg::RCX, Operand::Imm32(WORKER_BYTES));
+        ir.emit(ADeadOp::Mul { dst: Reg::RCX, src: Reg::R12 });
+        call(ir, self.map);
+        self.state_base(ir);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, no_pages);
+        mov(ir, Reg::R13, Operand::Reg(Reg::RAX));
+        store(ir, Reg::R11, REGION, Reg::R13);
+
+        // Deque k tras todos los registros; semilla ≠ 0 para el xorshift
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R12));
+        ir.emit(ADeadOp::Shl { dst: Reg::RCX, amount: WORKER_SHIFT });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RCX), src: Operand::Reg(Reg::R13) });
+        mov(ir, Reg::RBX, Operand::Reg(Reg::R13));
+        zero(ir, Reg::R14);
+        ir.emit(ADeadOp::Label(init));
+        store(ir, Reg::RBX, BUF, Reg::RCX);
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R14) });
+        mov(ir, Reg::RAX, Operand::Imm32(0x9E37_79B9u32 as i32));
+        ir.emit(ADeadOp::Mul { dst: Reg::RAX, src: Reg::R14 });
+        store(ir, Reg::RBX, SEED, Reg::RAX);
+        add_imm(ir, Reg::RCX, DEQUE_CAP << ENTRY_BITS);
+        add_imm(ir, Reg::RBX, WORKER_RECORD);
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R14), right: Operand::Reg(Reg::R12) });
+        jcc(ir, Condition::Below, init);
+
+        // ---- Pilas (Linux) o semáforo e identidad del worker 0 (Windows) ----
+        match self.threads {
+            ThreadApi::Syscall => {
+                let stacks_ok = ir.new_label();
+                mov(ir, Reg::RCX, Operand::Reg(Reg::R12));
+                ir.emit(ADeadOp::Shl { dst: Reg::RCX, amount: STACK_BITS });
+                call(ir, self.map);
+                self.state_base(ir);
+                ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+                jcc(ir, Condition::NotEqual, stacks_ok);
+                // Sin pilas: el pool es solo quien lo arrancó
+                mov(ir, Reg::R12, Operand::Imm32(1));
+                ir.emit(ADeadOp::Label(stacks_ok));
+                store(ir, Reg::R11, STACKS, Reg::RAX);
+            }
+            ThreadApi::Iat { create_semaphore, .. } => {
+                // mov rax, gs:[8] — NT_TIB.StackBase
+                ir.emit(ADeadOp::RawBytes(vec![0x65, 0x48, 0x8B, 0x04, 0x25, 0x08, 0, 0, 0]));
+                store(ir, Reg::R13, IDENT, Reg::RAX);
+                zero(ir, Reg::RCX);
+                zero(ir, Reg::RDX);
+                mov(ir, Reg::R8, Operand::Imm32(i32::MAX));
+                zero(ir, Reg::R9);
+                Self::call_iat(ir, create_semaphore);
+                self.state_base(ir);
+                store(ir, Reg::R11, SEM, Reg::RAX);
+            }
+        }
+        // Publicado antes de lanzar: los workers leen WORKERS al robar
+        store(ir, Reg::R11, WORKERS, Reg::R12);
+
+        // ---- Workers 1..n ----
+        mov(ir, Reg::R14, Operand::Imm32(1));
+        ir.emit(ADeadOp::Label(spawn_loop));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R14), right: Operand::Reg(Reg::R12) });
+        jcc(ir, Condition::AboveEq, published);
+        mov(ir, Reg::RBX, Operand::Reg(Reg::R14));
+        ir.emit(ADeadOp::Shl { dst: Reg::RBX, amount: WORKER_SHIFT });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RBX), src: Operand::Reg(Reg::R13) });
+        match self.threads {
+            ThreadApi::Syscall => {
+                // Pila del worker k: [stacks + k·STACK, stacks + (k+1)·STACK)
+                self.state_base(ir);
+                mov(ir, Reg::RSI, Operand::Reg(Reg::R14));
+                ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::RSI) });
+                ir.emit(ADeadOp::Shl { dst: Reg::RSI, amount: STACK_BITS });
+                ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSI), src: mem(Reg::R11, STACKS) });
+                add_imm(ir, Reg::RSI, -16);
+                store(ir, Reg::RSI, 0, Reg::RBX);
+                mov(ir, Reg::RDI, Operand::Imm32(CLONE_THREAD_FLAGS));
+                zero(ir, Reg::RDX);
+                zero(ir, Reg::R10);
+                zero(ir, Reg::R8);
+                mov(ir, Reg::RAX, Operand::Imm32(SYS_CLONE));
+                ir.emit(ADeadOp::Syscall);
+                ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+                jcc(ir, Condition::NotEqual, spawned);
+                // Hijo: RSP ≡ 8 (mod 16) tras el pop, como recién llamado
+                pop(ir, Reg::RBX);
+                ir.emit(ADeadOp::Jmp { target: self.worker_loop });
+            }
+            ThreadApi::Iat { create_thread, .. } => {
+                zero(ir, Reg::RCX);
+                zero(ir, Reg::RDX);
+                ir.emit(ADeadOp::LeaLabel { dst: Reg::R8, label: self.thread_entry });
+                mov(ir, Reg::R9, Operand::Reg(Reg::RBX));
+                store(ir, Reg::RSP, 32, Reg::RCX);
+                store(ir, Reg::RSP, 40, Reg::RCX);
+                Self::call_iat(ir, create_thread);
+            }
+        }
+        ir.emit(ADeadOp::Label(spawned));
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R14) });
+        ir.emit(ADeadOp::Jmp { target: spawn_loop });
+
+        ir.emit(ADeadOp::Label(no_pages));
+        mov(ir, Reg::RAX, Operand::Imm32(-1));
+        store(ir, Reg::R11, WORKERS, Reg::RAX);
+
+        ir.emit(ADeadOp::Label(published));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSP), src: Operand::Imm32(frame) });
+        for reg in [Reg::R14, Reg::R13, Reg::R12, Reg::RBX] {
+            pop(ir, reg);
+        }
+        self.state_base(ir);
+        ir.emit(ADeadOp::Label(unlock));
+        release(ir, LOCK);
+        ir.emit(ADeadOp::Label(done));
+        ir.emit(ADeadOp::Ret);
+
+        // Windows: RCX = registro del worker
+        if matches!(self.threads, ThreadApi::Iat { .. }) {
+            ir.emit(ADeadOp::Label(self.thread_entry));
+            mov(ir, Reg::RBX, Operand::Reg(Reg::RCX));
+            ir.emit(ADeadOp::RawBytes(vec![0x65, 0x48, 0x8B, 0x04, 0x25, 0x08, 0, 0, 0]));
+            store(ir, Reg::RBX, IDENT, Reg::RAX);
+            ir.emit(ADeadOp::Jmp { target: self.worker_loop });
+        }
+    }
+
+    /// RBX = registro del worker que llama, o 0 si no es del pool
+    fn emit_current(&self, ir: &mut ADeadIR) {
+        let serial = ir.new_label();
+        let found = ir.new_label();
+        ir.emit(ADeadOp::Label(self.current));
+        self.state_base(ir);
+        mov(ir, Reg::RCX, mem(Reg::R11, WORKERS));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: Operand::Imm32(0) });
+        jcc(ir, Condition::LessEq, serial);
+        mov(ir, Reg::RBX, mem(Reg::R11, REGION));
+        match self.threads {
+            ThreadApi::Syscall => {
+                // (RSP - stacks) >> STACK_BITS; fuera de rango = worker 0
+                mov(ir, Reg::RAX, Operand::Reg(Reg::RSP));
+                mov(ir, Reg::RDX, mem(Reg::R11, STACKS));
+                ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::RDX) });
+                ir.emit(ADeadOp::Shr { dst: Reg::RAX, amount: STACK_BITS });
+                ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Reg(Reg::RCX) });
+                jcc(ir, Condition::AboveEq, found);
+                ir.emit(ADeadOp::Shl { dst: Reg::RAX, amount: WORKER_SHIFT });
+                ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RBX), src: Operand::Reg(Reg::RAX) });
+                ir.emit(ADeadOp::Jmp { target: found });
+            }
+            ThreadApi::Iat { .. } => {
+                let scan = ir.new_label();
+                ir.emit(ADeadOp::RawBytes(vec![0x65, 0x48, 0x8B, 0x04, 0x25, 0x08, 0, 0, 0]));
+                ir.emit(ADeadOp::Label(scan));
+                ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: mem(Reg::RBX, IDENT) });
+                jcc(ir, Condition::Equal, found);
+                add_imm(ir, Reg::RBX, WORKER_RECORD);
+                ir.emit(ADeadOp::Dec { dst: Operand::Reg(Reg::RCX) });
+                jcc(ir, Condition::NotEqual, scan);
+            }
+        }
+        ir.emit(ADeadOp::Label(serial));
+        zero(ir, Reg::RBX);
+        ir.emit(ADeadOp::Label(found));
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// Dueño RBX: entrada RAX = rutina, RCX/RDX/R8 = argumentos.
+    /// RAX = 1, o 0 si el deque está lleno
+    fn emit_push(&self, ir: &mut ADeadIR) {
+        let full = ir.new_label();
+        ir.emit(ADeadOp::Label(self.push));
+        mov(ir, Reg::R9, mem(Reg::RBX, BOTTOM));
+        mov(ir, Reg::R11, Operand::Reg(Reg::R9));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::R11), src: mem(Reg::RBX, TOP) });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R11), right: Operand::Imm32(DEQUE_CAP) });
+        jcc(ir, Condition::GreaterEq, full);
+        mov(ir, Reg::R10, Operand::Reg(Reg::RAX));
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R9));
+        slot_offset(ir);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: mem(Reg::RBX, BUF) });
+        store(ir, Reg::RAX, RUN, Reg::R10);
+        store(ir, Reg::RAX, ARG_A, Reg::RCX);
+        store(ir, Reg::RAX, ARG_B, Reg::RDX);
+        store(ir, Reg::RAX, ARG_C, Reg::R8);
+        // TSO: la entrada es visible antes que el nuevo bottom
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R9) });
+        store(ir, Reg::RBX, BOTTOM, Reg::R9);
+        mov(ir, Reg::RAX, Operand::Imm32(1));
+        ir.emit(ADeadOp::Ret);
+        ir.emit(ADeadOp::Label(full));
+        zero(ir, Reg::RAX);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// Dueño RBX saca por abajo. RAX = 1 y entrada en RCX/RDX/R8/R9
+    fn emit_pop(&self, ir: &mut ADeadIR) {
+        let restore = ir.new_label();
+        let empty = ir.new_label();
+        let got = ir.new_label();
+        ir.emit(ADeadOp::Label(self.pop));
+        mov(ir, Reg::R10, mem(Reg::RBX, BOTTOM));
+        ir.emit(ADeadOp::Dec { dst: Operand::Reg(Reg::R10) });
+        // xchg [rbx + BOTTOM], r11: store con barrera antes de leer top
+        mov(ir, Reg::R11, Operand::Reg(Reg::R10));
+        ir.emit(ADeadOp::RawBytes(vec![0x4C, 0x87, 0x5B, BOTTOM as u8]));
+        mov(ir, Reg::R11, mem(Reg::RBX, TOP));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R11), right: Operand::Reg(Reg::R10) });
+        jcc(ir, Condition::Greater, restore);
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R10));
+        slot_offset(ir);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: mem(Reg::RBX, BUF) });
+        load_entry(ir);
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R11), right: Operand::Reg(Reg::R10) });
+        jcc(ir, Condition::NotEqual, got);
+        // Última entrada: se la disputa con los ladrones
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R11));
+        ir.emit(ADeadOp::Lea { dst: Reg::R10, src: mem(Reg::R11, 1) });
+        cas_top(ir, Reg::RBX);
+        store(ir, Reg::RBX, BOTTOM, Reg::R10);
+        jcc(ir, Condition::NotEqual, empty);
+        ir.emit(ADeadOp::Label(got));
+        mov(ir, Reg::RAX, Operand::Imm32(1));
+        ir.emit(ADeadOp::Ret);
+        ir.emit(ADeadOp::Label(restore));
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R10) });
+        store(ir, Reg::RBX, BOTTOM, Reg::R10);
+        ir.emit(ADeadOp::Label(empty));
+        zero(ir, Reg::RAX);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// Roba por arriba del worker RDI. RAX = 1 y entrada en RCX/RDX/R8/R9
+    fn emit_steal(&self, ir: &mut ADeadIR) {
+        let empty = ir.new_label();
+        ir.emit(ADeadOp::Label(self.steal));
+        mov(ir, Reg::R11, mem(Reg::RDI, TOP));
+        mov(ir, Reg::R10, mem(Reg::RDI, BOTTOM));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R11), right: Operand::Reg(Reg::R10) });
+        jcc(ir, Condition::GreaterEq, empty);
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R11));
+        slot_offset(ir);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: mem(Reg::RDI, BUF) });
+        // Si el dueño la reescribió, top ya avanzó y el cmpxchg falla
+        load_entry(ir);
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R11));
+        ir.emit(ADeadOp::Lea { dst: Reg::R10, src: mem(Reg::R11, 1) });
+        cas_top(ir, Reg::RDI);
+        jcc(ir, Condition::NotEqual, empty);
+        mov(ir, Reg::RAX, Operand::Imm32(1));
+        ir.emit(ADeadOp::Ret);
+        ir.emit(ADeadOp::Label(empty));
+        zero(ir, Reg::RAX);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// Tras un push: despierta a un worker si hay alguno dormido
+    fn emit_wake(&self, ir: &mut ADeadIR) {
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(self.wake));
+        mfence(ir);
+        self.state_base(ir);
+        ir.emit(ADeadOp::Cmp { left: mem(Reg::R11, SLEEPERS), right: Operand::Imm32(0) });
+        jcc(ir, Condition::Equal, done);
+        match self.threads {
+            ThreadApi::Syscall => {
+                mov(ir, Reg::RAX, Operand::Imm32(1));
+                lock_add(ir, EPOCH, Reg::RAX);
+                mov(ir, Reg::RDI, Operand::Imm64(self.state + EPOCH as u64));
+                mov(ir, Reg::RSI, Operand::Imm32(FUTEX_WAKE_PRIVATE));
+                mov(ir, Reg::RDX, Operand::Imm32(1));
+                mov(ir, Reg::RAX, Operand::Imm32(SYS_FUTEX));
+                ir.emit(ADeadOp::Syscall);
+            }
+            ThreadApi::Iat { release_semaphore, .. } => {
+                ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+                mov(ir, Reg::RCX, mem(Reg::R11, SEM));
+                mov(ir, Reg::RDX, Operand::Imm32(1));
+                zero(ir, Reg::R8);
+                Self::call_iat(ir, release_semaphore);
+                ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+            }
+        }
+        ir.emit(ADeadOp::Label(done));
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// Worker RBX: una tarea propia o robada. RAX = 1 si ejecutó algo.
+    /// Las rutinas de tarea reciben RBX y sus argumentos en R12-R14
+    fn emit_run_task(&self, ir: &mut ADeadIR) {
+        let steal_loop = ir.new_label();
+        let next = ir.new_label();
+        let no_wrap = ir.new_label();
+        let run = ir.new_label();
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.run_task));
+        for reg in [Reg::R12, Reg::R13, Reg::R14, Reg::R15] {
+            push(ir, reg);
+        }
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+        call(ir, self.pop);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::NotEqual, run);
+
+        // Víctima inicial al azar (xorshift64), luego en orden
+        mov(ir, Reg::RAX, mem(Reg::RBX, SEED));
+        for (shift, left) in [(13, true), (7, false), (17, true)] {
+            mov(ir, Reg::RCX, Operand::Reg(Reg::RAX));
+            if left {
+                ir.emit(ADeadOp::Shl { dst: Reg::RCX, amount: shift });
+            } else {
+                ir.emit(ADeadOp::Shr { dst: Reg::RCX, amount: shift });
+            }
+            ir.emit(ADeadOp::Xor { dst: Reg::RAX, src: Reg::RCX });
+        }
+        store(ir, Reg::RBX, SEED, Reg::RAX);
+        ir.emit(ADeadOp::Shr { dst: Reg::RAX, amount: 1 });
+        self.state_base(ir);
+        mov(ir, Reg::R12, mem(Reg::R11, WORKERS));
+        ir.emit(ADeadOp::Div { src: Reg::R12 });
+        mov(ir, Reg::R14, Operand::Reg(Reg::RDX));
+        mov(ir, Reg::R13, Operand::Reg(Reg::R12));
+        ir.emit(ADeadOp::Label(steal_loop));
+        self.state_base(ir);
+        mov(ir, Reg::RDI, Operand::Reg(Reg::R14));
+        ir.emit(ADeadOp::Shl { dst: Reg::RDI, amount: WORKER_SHIFT });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RDI), src: mem(Reg::R11, REGION) });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RDI), right: Operand::Reg(Reg::RBX) });
+        jcc(ir, Condition::Equal, next);
+        call(ir, self.steal);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::NotEqual, run);
+        ir.emit(ADeadOp::Label(next));
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R14) });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R14), right: Operand::Reg(Reg::R12) });
+        jcc(ir, Condition::Below, no_wrap);
+        zero(ir, Reg::R14);
+        ir.emit(ADeadOp::Label(no_wrap));
+        ir.emit(ADeadOp::Dec { dst: Operand::Reg(Reg::R13) });
+        jcc(ir, Condition::NotEqual, steal_loop);
+        zero(ir, Reg::RAX);
+        ir.emit(ADeadOp::Jmp { target: out });
+
+        ir.emit(ADeadOp::Label(run));
+        mov(ir, Reg::R12, Operand::Reg(Reg::RDX));
+        mov(ir, Reg::R13, Operand::Reg(Reg::R8));
+        mov(ir, Reg::R14, Operand::Reg(Reg::R9));
+        ir.emit(ADeadOp::Call { target: CallTarget::Register(Reg::RCX) });
+        mov(ir, Reg::RAX, Operand::Imm32(1));
+        ir.emit(ADeadOp::Label(out));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+        for reg in [Reg::R15, Reg::R14, Reg::R13, Reg::R12] {
+            pop(ir, reg);
+        }
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// R12 = lo, R13 = hi, R14 = trabajo. Parte mientras el rango pase
+    /// de grain (la mitad derecha al deque), ejecuta el resto y lo
+    /// descuenta de pending. Con ctx el cuerpo recibe el trozo entero
+    fn emit_range_runner(&self, ir: &mut ADeadIR) {
+        let split = ir.new_label();
+        let body = ir.new_label();
+        let iter = ir.new_label();
+        let done = ir.new_label();
+        ir.emit(ADeadOp::Label(self.range_runner));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+        ir.emit(ADeadOp::Label(split));
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R13));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::R12) });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: mem(Reg::R14, JOB_GRAIN) });
+        jcc(ir, Condition::LessEq, body);
+        ir.emit(ADeadOp::Shr { dst: Reg::RAX, amount: 1 });
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::R12) });
+        mov(ir, Reg::R15, Operand::Reg(Reg::RAX));
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R15));
+        mov(ir, Reg::RDX, Operand::Reg(Reg::R13));
+        mov(ir, Reg::R8, Operand::Reg(Reg::R14));
+        ir.emit(ADeadOp::LeaLabel { dst: Reg::RAX, label: self.range_runner });
+        call(ir, self.push);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        // Deque lleno: lo que queda se ejecuta aquí
+        jcc(ir, Condition::Equal, body);
+        mov(ir, Reg::R13, Operand::Reg(Reg::R15));
+        call(ir, self.wake);
+        ir.emit(ADeadOp::Jmp { target: split });
+
+        ir.emit(ADeadOp::Label(body));
+        mov(ir, Reg::R15, Operand::Reg(Reg::R13));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::R15), src: Operand::Reg(Reg::R12) });
+        mov(ir, Reg::R8, mem(Reg::R14, JOB_CTX));
+        ir.emit(ADeadOp::Test { left: Reg::R8, right: Reg::R8 });
+        jcc(ir, Condition::Equal, iter);
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R12));
+        mov(ir, Reg::RDX, Operand::Reg(Reg::R13));
+        mov(ir, Reg::RAX, mem(Reg::R14, JOB_FN));
+        ir.emit(ADeadOp::Call { target: CallTarget::Register(Reg::RAX) });
+        ir.emit(ADeadOp::Jmp { target: done });
+        ir.emit(ADeadOp::Label(iter));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R12), right: Operand::Reg(Reg::R13) });
+        jcc(ir, Condition::GreaterEq, done);
+        mov(ir, self.args[0], Operand::Reg(Reg::R12));
+        mov(ir, Reg::RAX, mem(Reg::R14, JOB_FN));
+        ir.emit(ADeadOp::Call { target: CallTarget::Register(Reg::RAX) });
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R12) });
+        ir.emit(ADeadOp::Jmp { target: iter });
+        ir.emit(ADeadOp::Label(done));
+        ir.emit(ADeadOp::Neg { dst: Reg::R15 });
+        // lock add [r14 + JOB_PENDING], r15
+        ir.emit(ADeadOp::RawBytes(vec![0xF0, 0x4D, 0x01, 0x7E, JOB_PENDING as u8]));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// R12 = future: resultado = fn(arg), luego done
+    fn emit_async_runner(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.async_runner));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+        mov(ir, self.args[0], mem(Reg::R12, FUT_ARG));
+        mov(ir, Reg::RAX, mem(Reg::R12, FUT_FN));
+        ir.emit(ADeadOp::Call { target: CallTarget::Register(Reg::RAX) });
+        store(ir, Reg::R12, FUT_RESULT, Reg::RAX);
+        mov(ir, Reg::RAX, Operand::Imm32(1));
+        store(ir, Reg::R12, FUT_DONE, Reg::RAX);
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// Bucle de los workers 1..n (RBX = su registro); no vuelve
+    fn emit_worker_loop(&self, ir: &mut ADeadIR) {
+        let top = ir.new_label();
+        let idle = ir.new_label();
+        let sleep = ir.new_label();
+        let woke = ir.new_label();
+        ir.emit(ADeadOp::Label(self.worker_loop));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(40) });
+        zero(ir, Reg::R13);
+        ir.emit(ADeadOp::Label(top));
+        call(ir, self.run_task);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, idle);
+        zero(ir, Reg::R13);
+        ir.emit(ADeadOp::Jmp { target: top });
+
+        ir.emit(ADeadOp::Label(idle));
+        ir.emit(ADeadOp::Inc { dst: Operand::Reg(Reg::R13) });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R13), right: Operand::Imm32(IDLE_SPINS) });
+        jcc(ir, Condition::AboveEq, sleep);
+        pause(ir);
+        ir.emit(ADeadOp::Jmp { target: top });
+
+        // SLEEPERS++ antes de mirar por última vez; quien hace push
+        // mira SLEEPERS después de publicar (ver wake)
+        ir.emit(ADeadOp::Label(sleep));
+        zero(ir, Reg::R13);
+        self.state_base(ir);
+        mov(ir, Reg::RAX, Operand::Imm32(1));
+        lock_add(ir, SLEEPERS, Reg::RAX);
+        ir.emit(ADeadOp::Load32 { dst: Reg::R12, base: Reg::R11, disp: EPOCH });
+        call(ir, self.run_task);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::NotEqual, woke);
+        match self.threads {
+            ThreadApi::Syscall => {
+                // futex(&epoch, WAIT, visto): vuelve enseguida si ya cambió
+                mov(ir, Reg::RDI, Operand::Imm64(self.state + EPOCH as u64));
+                mov(ir, Reg::RSI, Operand::Imm32(FUTEX_WAIT_PRIVATE));
+                mov(ir, Reg::RDX, Operand::Reg(Reg::R12));
+                zero(ir, Reg::R10);
+                mov(ir, Reg::RAX, Operand::Imm32(SYS_FUTEX));
+                ir.emit(ADeadOp::Syscall);
+            }
+            ThreadApi::Iat { wait, .. } => {
+                self.state_base(ir);
+                mov(ir, Reg::RCX, mem(Reg::R11, SEM));
+                mov(ir, Reg::RDX, Operand::Imm32(-1));
+                Self::call_iat(ir, wait);
+            }
+        }
+        ir.emit(ADeadOp::Label(woke));
+        self.state_base(ir);
+        mov(ir, Reg::RAX, Operand::Imm32(-1));
+        lock_add(ir, SLEEPERS, Reg::RAX);
+        ir.emit(ADeadOp::Jmp { target: top });
+    }
+
+    /// RAX = registro de future (free list, si no bump de un slab), o 0
+    fn emit_fut_alloc(&self, ir: &mut ADeadIR) {
+        let bump = ir.new_label();
+        let carve = ir.new_label();
+        let got = ir.new_label();
+        let oom = ir.new_label();
+        ir.emit(ADeadOp::Label(self.fut_alloc));
+        self.state_base(ir);
+        acquire(ir, FUT_LOCK);
+        mov(ir, Reg::RAX, mem(Reg::R11, FUT_FREE));
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, bump);
+        mov(ir, Reg::RCX, mem(Reg::RAX, 0));
+        store(ir, Reg::R11, FUT_FREE, Reg::RCX);
+        ir.emit(ADeadOp::Jmp { target: got });
+
+        ir.emit(ADeadOp::Label(bump));
+        mov(ir, Reg::RAX, mem(Reg::R11, FUT_CUR));
+        ir.emit(ADeadOp::Lea { dst: Reg::RCX, src: mem(Reg::RAX, FUT_RECORD) });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: mem(Reg::R11, FUT_END) });
+        jcc(ir, Condition::BelowEq, carve);
+        mov(ir, Reg::RCX, Operand::Imm32(FUT_SLAB));
+        call(ir, self.map);
+        self.state_base(ir);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, oom);
+        ir.emit(ADeadOp::Lea { dst: Reg::RCX, src: mem(Reg::RAX, FUT_SLAB) });
+        store(ir, Reg::R11, FUT_END, Reg::RCX);
+        ir.emit(ADeadOp::Lea { dst: Reg::RCX, src: mem(Reg::RAX, FUT_RECORD) });
+        ir.emit(ADeadOp::Label(carve));
+        store(ir, Reg::R11, FUT_CUR, Reg::RCX);
+        ir.emit(ADeadOp::Label(got));
+        release(ir, FUT_LOCK);
+        ir.emit(ADeadOp::Ret);
+        ir.emit(ADeadOp::Label(oom));
+        release(ir, FUT_LOCK);
+        zero(ir, Reg::RAX);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    /// RDX = registro de future → a la free list
+    fn emit_fut_free(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.fut_free));
+        self.state_base(ir);
+        acquire(ir, FUT_LOCK);
+        mov(ir, Reg::RAX, mem(Reg::R11, FUT_FREE));
+        store(ir, Reg::RDX, 0, Reg::RAX);
+        store(ir, Reg::R11, FUT_FREE, Reg::RDX);
+        release(ir, FUT_LOCK);
+        ir.emit(ADeadOp::Ret);
+    }
+
+    fn emit_ranges(&self, ir: &mut ADeadIR) {
+        let have_grain = ir.new_label();
+        let some_workers = ir.new_label();
+        let grain_ok = ir.new_label();
+        let pooled = ir.new_label();
+        let help = ir.new_label();
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.ranges));
+        for reg in [Reg::RBX, Reg::R12, Reg::R13, Reg::R14, Reg::R15] {
+            push(ir, reg);
+        }
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(JOB_BYTES as i8 + 16) });
+        mov(ir, Reg::R12, Operand::Reg(Reg::RCX));
+        mov(ir, Reg::R13, Operand::Reg(Reg::RDX));
+        mov(ir, Reg::R15, Operand::Reg(Reg::R8));
+        store(ir, Reg::RSP, JOB_FN, Reg::R9);
+        store(ir, Reg::RSP, JOB_CTX, Reg::R10);
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R12), right: Operand::Reg(Reg::R13) });
+        jcc(ir, Condition::GreaterEq, out);
+        call(ir, self.start);
+        call(ir, self.current);
+
+        // grain automático: rango / (8 × workers), al menos 1
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::R15), right: Operand::Imm32(0) });
+        jcc(ir, Condition::Greater, have_grain);
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R13));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::R12) });
+        self.state_base(ir);
+        mov(ir, Reg::RCX, mem(Reg::R11, WORKERS));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: Operand::Imm32(1) });
+        jcc(ir, Condition::GreaterEq, some_workers);
+        mov(ir, Reg::RCX, Operand::Imm32(1));
+        ir.emit(ADeadOp::Label(some_workers));
+        ir.emit(ADeadOp::Shl { dst: Reg::RCX, amount: 3 });
+        ir.emit(ADeadOp::Div { src: Reg::RCX });
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(1) });
+        jcc(ir, Condition::GreaterEq, grain_ok);
+        mov(ir, Reg::RAX, Operand::Imm32(1));
+        ir.emit(ADeadOp::Label(grain_ok));
+        mov(ir, Reg::R15, Operand::Reg(Reg::RAX));
+        ir.emit(ADeadOp::Label(have_grain));
+        // Fuera del pool: un solo trozo, sin partir
+        ir.emit(ADeadOp::Test { left: Reg::RBX, right: Reg::RBX });
+        jcc(ir, Condition::NotEqual, pooled);
+        mov(ir, Reg::R15, Operand::Imm64(i64::MAX as u64));
+        ir.emit(ADeadOp::Label(pooled));
+        store(ir, Reg::RSP, JOB_GRAIN, Reg::R15);
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R13));
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RAX), src: Operand::Reg(Reg::R12) });
+        store(ir, Reg::RSP, JOB_PENDING, Reg::RAX);
+        mov(ir, Reg::R14, Operand::Reg(Reg::RSP));
+        call(ir, self.range_runner);
+        // Mientras otros terminan sus mitades, ayudar
+        ir.emit(ADeadOp::Label(help));
+        ir.emit(ADeadOp::Cmp { left: mem(Reg::RSP, JOB_PENDING), right: Operand::Imm32(0) });
+        jcc(ir, Condition::Equal, out);
+        call(ir, self.run_task);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::NotEqual, help);
+        pause(ir);
+        ir.emit(ADeadOp::Jmp { target: help });
+
+        ir.emit(ADeadOp::Label(out));
+        ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(JOB_BYTES as i8 + 16) });
+        for reg in [Reg::R15, Reg::R14, Reg::R13, Reg::R12, Reg::RBX] {
+            pop(ir, reg);
+        }
+        ir.emit(ADeadOp::Ret);
+    }
+
+    fn emit_parallel_for(&self, ir: &mut ADeadIR) {
+        ir.emit(ADeadOp::Label(self.parallel_for));
+        Self::enter(ir);
+        // En Linux args[3] es RCX: moverlo antes de pisarlo
+        mov(ir, Reg::R9, Operand::Reg(self.args[3]));
+        mov(ir, Reg::R8, Operand::Reg(self.args[2]));
+        mov(ir, Reg::RDX, Operand::Reg(self.args[1]));
+        mov(ir, Reg::RCX, Operand::Reg(self.args[0]));
+        zero(ir, Reg::R10);
+        call(ir, self.ranges);
+        zero(ir, Reg::RAX);
+        Self::leave(ir);
+    }
+
+    fn emit_spawn(&self, ir: &mut ADeadIR) {
+        let inline = ir.new_label();
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(self.spawn));
+        Self::enter(ir);
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(32) });
+        mov(ir, Reg::R12, Operand::Reg(self.args[0]));
+        mov(ir, Reg::R13, Operand::Reg(self.args[1]));
+        call(ir, self.start);
+        call(ir, self.current);
+        call(ir, self.fut_alloc);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, out);
+        mov(ir, Reg::R14, Operand::Reg(Reg::RAX));
+        store(ir, Reg::R14, FUT_FN, Reg::R12);
+        store(ir, Reg::R14, FUT_ARG, Reg::R13);
+        zero(ir, Reg::RAX);
+        store(ir, Reg::R14, FUT_RESULT, Reg::RAX);
+        store(ir, Reg::R14, FUT_DONE, Reg::RAX);
+        ir.emit(ADeadOp::Test { left: Reg::RBX, right: Reg::RBX });
+        jcc(ir, Condition::Equal, inline);
+        ir.emit(ADeadOp::LeaLabel { dst: Reg::RAX, label: self.async_runner });
+        mov(ir, Reg::RCX, Operand::Reg(Reg::R14));
+        call(ir, self.push);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::Equal, inline);
+        call(ir, self.wake);
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R14));
+        ir.emit(ADeadOp::Jmp { target: out });
+        // Fuera del pool o deque lleno: se ejecuta ya
+        ir.emit(ADeadOp::Label(inline));
+        mov(ir, Reg::R12, Operand::Reg(Reg::R14));
+        call(ir, self.async_runner);
+        mov(ir, Reg::RAX, Operand::Reg(Reg::R14));
+        ir.emit(ADeadOp::Label(out));
+        Self::leave(ir);
+    }
+
+    /// Espera a que el future termine ejecutando otras tareas;
+    /// `release`: devuelve el resultado y libera el registro
+    fn emit_get(&self, ir: &mut ADeadIR, label: Label, release: bool) {
+        let wait = ir.new_label();
+        let spin = ir.new_label();
+        let ready = ir.new_label();
+        let out = ir.new_label();
+        ir.emit(ADeadOp::Label(label));
+        Self::enter(ir);
+        ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm8(32) });
+        mov(ir, Reg::R12, Operand::Reg(self.args[0]));
+        zero(ir, Reg::RAX);
+        ir.emit(ADeadOp::Test { left: Reg::R12, right: Reg::R12 });
+        jcc(ir, Condition::Equal, out);
+        call(ir, self.current);
+        ir.emit(ADeadOp::Label(wait));
+        ir.emit(ADeadOp::Cmp { left: mem(Reg::R12, FUT_DONE), right: Operand::Imm32(0) });
+        jcc(ir, Condition::NotEqual, ready);
+        ir.emit(ADeadOp::Test { left: Reg::RBX, right: Reg::RBX });
+        jcc(ir, Condition::Equal, spin);
+        call(ir, self.run_task);
+        ir.emit(ADeadOp::Test { left: Reg::RAX, right: Reg::RAX });
+        jcc(ir, Condition::NotEqual, wait);
+        ir.emit(ADeadOp::Label(spin));
+        pause(ir);
+        ir.emit(ADeadOp::Jmp { target: wait });
+        ir.emit(ADeadOp::Label(ready));
+        if release {
+            mov(ir, Reg::R13, mem(Reg::R12, FUT_RESULT));
+            mov(ir, Reg::RDX, Operand::Reg(Reg::R12));
+            call(ir, self.fut_free);
+            mov(ir, Reg::RAX, Operand::Reg(Reg::R13));
+        } else {
+            zero(ir, Reg::RAX);
+        }
+        ir.emit(ADeadOp::Label(out));
+        Self::leave(ir);
+    }
+
+    fn emit_size(&self, ir: &mut ADeadIR) {
+        let ok = ir.new_label();
+        ir.emit(ADeadOp::Label(self.size));
+        Self::enter(ir);
+        call(ir, self.start);
+        self.state_base(ir);
+        mov(ir, Reg::RAX, mem(Reg::R11, WORKERS));
+        ir.emit(ADeadOp::Cmp { left: Operand::Reg(Reg::RAX), right: Operand::Imm32(1) });
+        jcc(ir, Condition::GreaterEq, ok);
+        mov(ir, Reg::RAX, Operand::Imm32(1));
+        ir.emit(ADeadOp::Label(ok));
+        Self::leave(ir);
+    }
+}
@@ -0,0 +1,105 @@
+// ============================================================
+// ADead-BIB — JIT para tests de runtimes generados
+// ============================================================
+// Los runtimes que el compilador emite como ADeadOp (vDSO, stdio,
+// heap, algoritmos paralelos, mapas, sync, vec_math, io...) se
+// prueban ejecutando el código de verdad: se ensambla con el
+// encoder, se copia a memoria anónima RWX y se llama por puntero.
+//
+// Un solo fixture para todos: el mapeo vive lo que vive `JitCode`
+// y se libera en Drop. Sólo Linux x86-64 (mmap + ABI SysV).
+// ============================================================
+
+use std::collections::HashMap;
+
+use super::encoder::Encoder;
+use super::{ADeadOp, Label};
+
+extern "C" {
+    fn mmap(addr: *mut u8, len: usize, prot: i32, flags: i32, fd: i32, off: i64) -> *mut u8;
+    fn munmap(addr: *mut u8, len: usize) -> i32;
+}
+
+const PAGE: usize = 4096;
+const PROT_RWX: i32 = 7;
+const MAP_PRIVATE_ANON: i32 = 0x22;
+
+/// Código ejecutable mapeado; se desmapea al soltarlo
+pub struct JitCode {
+    mem: *mut u8,
+    size: usize,
+    labels: HashMap<u32, usize>,
+}
+
+// El mapeo es inmutable tras construirlo: se comparte entre hilos
+unsafe impl Send for JitCode {}
+unsafe impl Sync for JitCode {}
+
+impl JitCode {
+    /// Ensambla `ops` y guarda los offsets de sus labels
+    pub fn new(ops: &[ADeadOp]) -> Self {
+        let result = Encoder::new().encode_all(ops);
+        Self::map(&result.code, result.label_offsets)
+    }
+
+    /// Bytes ya codificados, sin labels (kernels con su propio encoder)
+    pub fn from_code(code: &[u8]) -> Self {
+        Self::map(code, HashMap::new())
+    }
+
+    fn map(code: &[u8], labels: HashMap<u32, usize>) -> Self {
+        let size = (code.len().max(1) + PAGE - 1) / PAGE * PAGE;
+        unsafe {
+            let mem = mmap(std::ptr::null_mut(), size, PROT_RWX, MAP_PRIVATE_ANON, -1, 0);
+            assert!(!mem.is_null() && mem as isize != -1, "mmap RWX falló");
+            std::ptr::copy_nonoverlapping(code.as_ptr(), mem, code.len());
+            Self { mem, size, labels }
+        }
+    }
+
+    /// Dirección del label dentro del código mapeado
+    pub fn at(&self, label: Label) -> *const u8 {
+        let offset = self.labels.get(&label.0).unwrap_or_else(|| panic!("label {} sin offset", label));
+        unsafe { self.mem.add(*offset) }
+    }
+
+    /// El label como puntero a función `F`.
+    ///
+    /// # Safety
+    /// `F` debe ser un `extern "C" fn` con la firma que implementa el código.
+    pub unsafe fn func<F: Copy>(&self, label: Label) -> F {
+        cast(self.at(label))
+    }
+
+    /// El inicio del código como puntero a función `F`.
+    ///
+    /// # Safety
+    /// Igual que [`JitCode::func`].
+    pub unsafe fn entry<F: Copy>(&self) -> F {
+        cast(self.mem)
+    }
+
+    /// Llama al inicio del código como fn(arg) -> i64
+    pub fn call(&self, arg: u64) -> i64 {
+        let f: extern "C" fn(u64) -> i64 = unsafe { self.entry() };
+        f(arg)
+    }
+}
+
+impl Drop for JitCode {
+    fn drop(&mut self) {
+        unsafe {
+            munmap(self.mem, self.size);
+        }
+    }
+}
+
+unsafe fn cast<F: Copy>(ptr: *const u8) -> F {
+    assert_eq!(std::mem::size_of::<F>(), std::mem::size_of::<*const u8>());
+    std::mem::transmute_copy(&ptr)
+}
+
+/// Ensambla `ops` en memoria ejecutable y la llama como fn(arg) -> i64
+pub fn run(ops: &[ADeadOp], arg: u64) -> i64 {
+    JitCode::new(ops).call(arg)
+}
@@ -0,0 +1,992 @@
+// ============================================================
+// ADead-BIB — Librería matemática vectorial (sin/cos/exp/log/pow)
+// ============================================================
+// Implementaciones propias, sin CRT, de sin, cos, exp, log, pow,
+// sqrt y tanh en float (8 lanes) y double (4 lanes) sobre AVX2.
+// Cada función es una rutina con la ABI vectorial de tipo `_ZGV`:
+//
+//   ymm0 = argumento y resultado      (ymm1 = segundo argumento de pow)
+//   toca solo ymm0..ymm5 y RAX; el resto de GP se conserva
+//
+// de modo que el vectorizador de bucles la llama entre dos pasos
+// del cuerpo, y la versión escalar (`sin(x)` suelto) es la misma
+// rutina con el valor en el lane 0.
+//
+// Los algoritmos son los de Cephes: reducción de rango de Cody-Waite
+// con la constante partida en trozos exactos y polinomios minimax
+// (Padé en exp/log/tanh double). Cotas que comprueban los tests:
+//
+//   float:  sin/cos/exp/log/tanh ≤ 2 ulp, pow ≤ 1 ulp (núcleo double)
+//   double: sin/cos/exp/log/tanh ≤ 2 ulp,
+//           pow ≤ (2 + |y·ln x|)·2^-52 relativo
+//
+// Solo AVX2 (sin FMA). Las constantes son vectores de 32 bytes en
+// una tabla tras las rutinas, direccionada con RAX.
+// ============================================================
+
+use std::collections::HashMap;
+
+use super::vex_emitter::{AvxInst, FpOp, VexEmitter, VexMem};
+use super::ymm_allocator::YmmReg;
+use super::{ADeadIR, ADeadOp, CallTarget, Label, Operand, Reg};
+
+/// Funciones con versión vectorial
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum MathFn {
+    Sin,
+    Cos,
+    Exp,
+    Log,
+    Pow,
+    Sqrt,
+    Tanh,
+}
+
+/// Nombres de C (double y float) que resuelve esta librería
+pub const MATH_FUNCTIONS: [&str; 14] = [
+    "sin", "sinf", "cos", "cosf", "exp", "expf", "log", "logf", "pow", "powf", "sqrt", "sqrtf", "tanh", "tanhf",
+];
+
+impl MathFn {
+    pub const ALL: [MathFn; 7] =
+        [MathFn::Sin, MathFn::Cos, MathFn::Exp, MathFn::Log, MathFn::Pow, MathFn::Sqrt, MathFn::Tanh];
+
+    /// "sinf" → (Sin, float), "sin" → (Sin, double)
+    pub fn from_name(name: &str) -> Option<(MathFn, bool)> {
+        let (base, double) = match name.strip_suffix('f') {
+            Some(base) => (base, false),
+            None => (name, true),
+        };
+        let f = match base {
+            "sin" => MathFn::Sin,
+            "cos" => MathFn::Cos,
+            "exp" => MathFn::Exp,
+            "log" => MathFn::Log,
+            "pow" => MathFn::Pow,
+            "sqrt" => MathFn::Sqrt,
+            "tanh" => MathFn::Tanh,
+            _ => return None,
+        };
+        Some((f, double))
+    }
+
+    pub fn arity(self) -> usize {
+        if self == MathFn::Pow {
+            2
+        } else {
+            1
+        }
+    }
+
+    fn name(self) -> &'static str {
+        match self {
+            MathFn::Sin => "sin",
+            MathFn::Cos => "cos",
+            MathFn::Exp => "exp",
+            MathFn::Log => "log",
+            MathFn::Pow => "pow",
+            MathFn::Sqrt => "sqrt",
+            MathFn::Tanh => "tanh",
+        }
+    }
+
+    /// Nombre con el mangling vectorial de x86 (`d` = AVX2, N lanes, v por argumento)
+    pub fn vector_name(self, double: bool) -> String {
+        let args = if self.arity() == 2 { "vv" } else { "v" };
+        if double {
+            format!("_ZGVdN4{}_{}", args, self.name())
+        } else {
+            format!("_ZGVdN8{}_{}f", args, self.name())
+        }
+    }
+}
+
+impl std::fmt::Display for MathFn {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.write_str(self.name())
+    }
+}
+
+// ---- Predicados de vcmp ----
+const CMP_EQ: u8 = 0x00;
+const CMP_LT: u8 = 0x01;
+const CMP_NEQ: u8 = 0x04;
+/// !(a >= b): cierto también con NaN
+const CMP_NGE: u8 = 0x09;
+
+// ---- Modos de vround ----
+const ROUND_NEAREST: u8 = 0;
+const ROUND_FLOOR: u8 = 1;
+const ROUND_TRUNC: u8 = 3;
+
+const LOG2_E: f64 = std::f64::consts::LOG2_E;
+const FOUR_OVER_PI: f64 = 1.27323954473516268615;
+const SQRT_HALF: f64 = 0.707106781186547524;
+/// ln 2 = LN2_HI + LN2_LO (LN2_HI con mantisa corta: n·LN2_HI es exacto)
+const LN2_HI: f64 = 0.693359375;
+const LN2_LO: f64 = -2.121944400546905827679e-4;
+
+// ---- Coeficientes (Cephes) ----
+const EXPF_P: [f64; 6] =
+    [1.9875691500E-4, 1.3981999507E-3, 8.3334519073E-3, 4.1665795894E-2, 1.6666665459E-1, 5.0000001201E-1];
+const EXP_P: [f64; 3] = [1.26177193074810590878E-4, 3.02994407707441961300E-2, 9.99999999999999999910E-1];
+const EXP_Q: [f64; 4] =
+    [3.00198505138664455042E-6, 2.52448340349684104192E-3, 2.27265548208155028766E-1, 2.00000000000000000009E0];
+const LOGF_P: [f64; 9] = [
+    7.0376836292E-2,
+    -1.1514610310E-1,
+    1.1676998740E-1,
+    -1.2420140846E-1,
+    1.4249322787E-1,
+    -1.6668057665E-1,
+    2.0000714765E-1,
+    -2.4999993993E-1,
+    3.3333331174E-1,
+];
+const LOG_P: [f64; 6] = [
+    1.01875663804580931796E-4,
+    4.97494994976747001425E-1,
+    4.70579119878881725854E0,
+    1.44989225341610930846E1,
+    1.79368678507819816313E1,
+    7.70838733755885391666E0,
+];
+/// Mónico: el 1 del primer término va implícito
+const LOG_Q: [f64; 5] = [
+    1.12873587189167450590E1,
+    4.52279145837532221105E1,
+    8.29875266912776603211E1,
+    7.11544750618563894466E1,
+    2.31251620126765340583E1,
+];
+const SINF_P: [f64; 3] = [-1.9515295891E-4, 8.3321608736E-3, -1.6666654611E-1];
+const COSF_P: [f64; 5] = [2.443315711809948E-005, -1.388731625493765E-003, 4.166664568298827E-002, -0.5, 1.0];
+const SIN_P: [f64; 6] = [
+    1.58962301576546568060E-10,
+    -2.50507477628578072866E-8,
+    2.75573136213857245213E-6,
+    -1.98412698295895385996E-4,
+    8.33333333332211858878E-3,
+    -1.66666666666666307295E-1,
+];
+const COS_P: [f64; 8] = [
+    -1.13585365213876817300E-11,
+    2.08757008419747316778E-9,
+    -2.75573141792967388112E-7,
+    2.48015872888517045348E-5,
+    -1.38888888888730564116E-3,
+    4.16666666666665929218E-2,
+    -0.5,
+    1.0,
+];
+/// π/4 en tres trozos
+const DPF: [f64; 3] = [0.78515625, 2.4187564849853515625e-4, 3.77489497744594108e-8];
+const DP: [f64; 3] = [7.85398125648498535156E-1, 3.77489470793079817668E-8, 2.69515142907905952645E-15];
+const TANHF_P: [f64; 5] = [-5.70498872745E-3, 2.06390887954E-2, -5.37397155531E-2, 1.33314422036E-1, -3.33332819422E-1];
+const TANH_P: [f64; 3] = [-9.64399179425052238628E-1, -9.92877231001918586564E1, -1.61468768441708447952E3];
+const TANH_Q: [f64; 3] = [1.12811678491632931402E2, 2.23548839060100448583E3, 4.84406305325125486048E3];
+
+const Y: [YmmReg; 6] = [YmmReg(0), YmmReg(1), YmmReg(2), YmmReg(3), YmmReg(4), YmmReg(5)];
+
+// ============================================================
+// Tabla de constantes
+// ============================================================
+
+/// Vectores de 32 bytes con un valor repetido; sin duplicados
+#[derive(Default)]
+struct Pool {
+    bytes: Vec<u8>,
+    offsets: HashMap<(u64, bool), i32>,
+}
+
+impl Pool {
+    fn vector(&mut self, bits: u64, double: bool) -> VexMem {
+        let next = self.bytes.len() as i32;
+        let off = *self.offsets.entry((bits, double)).or_insert(next);
+        if off == next {
+            for _ in 0..if double { 4 } else { 8 } {
+                if double {
+                    self.bytes.extend_from_slice(&bits.to_le_bytes());
+                } else {
+                    self.bytes.extend_from_slice(&(bits as u32).to_le_bytes());
+                }
+            }
+        }
+        VexMem::base(0, off)
+    }
+}
+
+// ============================================================
+// Generador de código PS/PD
+// ============================================================
+
+struct Gen<'a> {
+    double: bool,
+    pool: &'a mut Pool,
+    out: Vec<AvxInst>,
+}
+
+impl<'a> Gen<'a> {
+    fn new(double: bool, pool: &'a mut Pool) -> Self {
+        Self { double, pool, out: Vec::new() }
+    }
+
+    fn width(&self) -> u8 {
+        if self.double {
+            64
+        } else {
+            32
+        }
+    }
+
+    fn mant_bits(&self) -> u8 {
+        if self.double {
+            52
+        } else {
+            23
+        }
+    }
+
+    fn bias(&self) -> f64 {
+        if self.double {
+            1023.0
+        } else {
+            127.0
+        }
+    }
+
+    /// 2^52 / 2^23: sumado a un entero pequeño lo deja en los bits bajos
+    fn magic(&self) -> f64 {
+        (1u64 << self.mant_bits()) as f64
+    }
+
+    fn sign(&self) -> u64 {
+        1 << (self.width() - 1)
+    }
+
+    fn abs_mask(&self) -> u64 {
+        self.sign() - 1
+    }
+
+    fn bits_of(&self, v: f64) -> u64 {
+        if self.double {
+            v.to_bits()
+        } else {
+            (v as f32).to_bits() as u64
+        }
+    }
+
+    fn konst(&mut self, v: f64) -> VexMem {
+        let bits = self.bits_of(v);
+        self.pool.vector(bits, self.double)
+    }
+
+    fn avx(&mut self, inst: AvxInst) {
+        self.out.push(inst);
+    }
+
+    fn op(&mut self, op: FpOp, dst: YmmReg, src1: YmmReg, src2: YmmReg) {
+        let double = self.double;
+        self.avx(AvxInst::Vfp { op, double, dst, src1, src2 });
+    }
+
+    /// dst = src1 op constante
+    fn opk(&mut self, op: FpOp, dst: YmmReg, src1: YmmReg, v: f64) {
+        let mem = self.konst(v);
+        let double = self.double;
+        self.avx(AvxInst::VfpMem { op, double, dst, src1, mem });
+    }
+
+    /// dst = src1 op patrón de bits por lane
+    fn opb(&mut self, op: FpOp, dst: YmmReg, src1: YmmReg, bits: u64) {
+        let mem = self.pool.vector(bits, self.double);
+        let double = self.double;
+        self.avx(AvxInst::VfpMem { op, double, dst, src1, mem });
+    }
+
+    fn load(&mut self, dst: YmmReg, v: f64) {
+        let mem = self.konst(v);
+        self.avx(AvxInst::VmovdquLoad { dst, mem });
+    }
+
+    fn round(&mut self, dst: YmmReg, src: YmmReg, mode: u8) {
+        let double = self.double;
+        self.avx(AvxInst::Vround { double, dst, src, mode });
+    }
+
+    fn cmp(&mut self, dst: YmmReg, src1: YmmReg, src2: YmmReg, pred: u8) {
+        let double = self.double;
+        self.avx(AvxInst::Vcmp { double, pred, dst, src1, src2 });
+    }
+
+    fn cmpk(&mut self, dst: YmmReg, src1: YmmReg, v: f64, pred: u8) {
+        let mem = self.konst(v);
+        let double = self.double;
+        self.avx(AvxInst::VcmpMem { double, pred, dst, src1, mem });
+    }
+
+    /// dst = mask ? src2 : src1
+    fn blend(&mut self, dst: YmmReg, src1: YmmReg, src2: YmmReg, mask: YmmReg) {
+        let double = self.double;
+        self.avx(AvxInst::Vblendv { double, dst, src1, src2, mask });
+    }
+
+    fn shl(&mut self, dst: YmmReg, src: YmmReg, imm: u8) {
+        let lane = self.width() / 8;
+        self.avx(AvxInst::VpshiftImm { lane, left: true, dst, src, imm });
+    }
+
+    fn shr(&mut self, dst: YmmReg, src: YmmReg, imm: u8) {
+        let lane = self.width() / 8;
+        self.avx(AvxInst::VpshiftImm { lane, left: false, dst, src, imm });
+    }
+
+    /// acc = c[0]·x^(n-1) + ... + c[n-1] (Horner)
+    fn poly(&mut self, acc: YmmReg, x: YmmReg, c: &[f64]) {
+        self.load(acc, c[0]);
+        for &k in &c[1..] {
+            self.op(FpOp::Mul, acc, acc, x);
+            self.opk(FpOp::Add, acc, acc, k);
+        }
+    }
+
+    /// acc = x^n + c[0]·x^(n-1) + ... + c[n-1]
+    fn poly1(&mut self, acc: YmmReg, x: YmmReg, c: &[f64]) {
+        self.opk(FpOp::Add, acc, x, c[0]);
+        for &k in &c[1..] {
+            self.op(FpOp::Mul, acc, acc, x);
+            self.opk(FpOp::Add, acc, acc, k);
+        }
+    }
+
+    /// v (entero representado en coma flotante, exponente válido) ← 2^v
+    fn pow2(&mut self, v: YmmReg) {
+        let k = self.magic() + self.bias();
+        self.opk(FpOp::Add, v, v, k);
+        let mant = self.mant_bits();
+        self.shl(v, v, mant);
+    }
+
+    // ---- exp ----
+
+    /// x ← e^x; usa t
+    fn exp(&mut self, x: YmmReg, t: [YmmReg; 3]) {
+        let [n, y, s] = t;
+        let (lo, hi, c1, c2) = if self.double {
+            (-745.2, 710.0, 6.93145751953125E-1, 1.42860682030941723212E-6)
+        } else {
+            (-104.0, 89.0, LN2_HI, LN2_LO)
+        };
+        // min/max con la constante delante: si x es NaN pasa tal cual
+        self.load(n, hi);
+        self.op(FpOp::Min, x, n, x);
+        self.load(n, lo);
+        self.op(FpOp::Max, x, n, x);
+        // n = round(x·log2 e); r = x - n·ln 2
+        self.opk(FpOp::Mul, n, x, LOG2_E);
+        self.round(n, n, ROUND_NEAREST);
+        self.opk(FpOp::Mul, y, n, c1);
+        self.op(FpOp::Sub, x, x, y);
+        self.opk(FpOp::Mul, y, n, c2);
+        self.op(FpOp::Sub, x, x, y);
+        if self.double {
+            // e^r = 1 + 2·r·P(r²) / (Q(r²) - r·P(r²))
+            self.op(FpOp::Mul, s, x, x);
+            self.poly(y, s, &EXP_P);
+            self.op(FpOp::Mul, y, y, x);
+            self.poly(x, s, &EXP_Q);
+            self.op(FpOp::Sub, x, x, y);
+            self.op(FpOp::Div, y, y, x);
+            self.op(FpOp::Add, y, y, y);
+        } else {
+            // e^r = 1 + r + r²·P(r)
+            self.poly(y, x, &EXPF_P);
+            self.op(FpOp::Mul, s, x, x);
+            self.op(FpOp::Mul, y, y, s);
+            self.op(FpOp::Add, y, y, x);
+        }
+        self.opk(FpOp::Add, y, y, 1.0);
+        // ·2^n en dos mitades: los extremos (2^-1075, 2^1024) no caben en un exponente
+        self.opk(FpOp::Mul, x, n, 0.5);
+        self.round(x, x, ROUND_FLOOR);
+        self.op(FpOp::Sub, n, n, x);
+        self.pow2(x);
+        self.op(FpOp::Mul, y, y, x);
+        self.pow2(n);
+        self.op(FpOp::Mul, x, y, n);
+    }
+
+    // ---- log ----
+
+    /// ln x, con x intacto; devuelve el registro del resultado (r[1])
+    fn log(&mut self, x: YmmReg, r: [YmmReg; 5]) -> YmmReg {
+        let [a, m, e, p, q] = r;
+        // Subnormales: se escalan por 2^k y se descuenta k del exponente
+        let (min_normal, k) = if self.double { (f64::MIN_POSITIVE, 54.0) } else { (f32::MIN_POSITIVE as f64, 24.0) };
+        self.cmpk(a, x, min_normal, CMP_LT);
+        self.opk(FpOp::Mul, m, x, (2.0f64).powf(k));
+        self.blend(m, x, m, a);
+        self.opk(FpOp::And, a, a, k);
+        // e = exponente (x = 2^e·m, m en [0.5, 1))
+        let mant = self.mant_bits();
+        self.shr(e, m, mant);
+        let magic = self.bits_of(self.magic());
+        self.opb(FpOp::Or, e, e, magic);
+        let k = self.magic() + self.bias() - 1.0;
+        self.opk(FpOp::Sub, e, e, k);
+        self.op(FpOp::Sub, e, e, a);
+        let half = self.bits_of(0.5);
+        self.opb(FpOp::And, m, m, (1u64 << mant) - 1);
+        self.opb(FpOp::Or, m, m, half);
+        // m < √½: e -= 1 y m = 2m - 1; si no, m = m - 1
+        self.cmpk(a, m, SQRT_HALF, CMP_LT);
+        self.opk(FpOp::And, p, a, 1.0);
+        self.op(FpOp::Sub, e, e, p);
+        self.op(FpOp::And, a, a, m);
+        self.opk(FpOp::Sub, m, m, 1.0);
+        self.op(FpOp::Add, m, m, a);
+        // y = m·z·R(m), z = m²
+        self.op(FpOp::Mul, a, m, m);
+        if self.double {
+            self.poly(p, m, &LOG_P);
+            self.poly1(q, m, &LOG_Q);
+            self.op(FpOp::Mul, p, p, a);
+            self.op(FpOp::Div, p, p, q);
+        } else {
+            self.poly(p, m, &LOGF_P);
+            self.op(FpOp::Mul, p, p, a);
+        }
+        self.op(FpOp::Mul, p, p, m);
+        // ln x = m - z/2 + y + e·ln 2
+        self.opk(FpOp::Mul, q, e, LN2_LO);
+        self.op(FpOp::Add, p, p, q);
+        self.opk(FpOp::Mul, q, a, 0.5);
+        self.op(FpOp::Sub, p, p, q);
+        self.op(FpOp::Add, m, m, p);
+        self.opk(FpOp::Mul, q, e, LN2_HI);
+        self.op(FpOp::Add, m, m, q);
+        // x < 0 o NaN → NaN; ±0 → -inf; +inf → +inf
+        self.cmpk(a, x, 0.0, CMP_NGE);
+        self.op(FpOp::Or, m, m, a);
+        self.cmpk(a, x, 0.0, CMP_EQ);
+        self.load(q, f64::NEG_INFINITY);
+        self.blend(m, m, q, a);
+        self.cmpk(a, x, f64::INFINITY, CMP_EQ);
+        self.load(q, f64::INFINITY);
+        self.blend(m, m, q, a);
+        m
+    }
+
+    // ---- sin / cos ----
+
+    /// sin x o cos x; x se pierde; devuelve el registro del resultado
+    fn sin_cos(&mut self, x: YmmReg, cos: bool, r: [YmmReg; 5]) -> YmmReg {
+        let [s, v, j, q, y] = r;
+        let sign = self.sign();
+        let abs = self.abs_mask();
+        if !cos {
+            self.opb(FpOp::And, s, x, sign);
+        }
+        self.opb(FpOp::And, v, x, abs);
+        // j = octante redondeado al par siguiente
+        self.opk(FpOp::Mul, j, v, FOUR_OVER_PI);
+        self.round(j, j, ROUND_TRUNC);
+        self.opk(FpOp::Add, j, j, 1.0);
+        self.opk(FpOp::Mul, j, j, 0.5);
+        self.round(j, j, ROUND_FLOOR);
+        self.op(FpOp::Add, j, j, j);
+        // v = |x| - j·π/4
+        let dp = if self.double { DP } else { DPF };
+        for c in dp {
+            self.opk(FpOp::Mul, q, j, c);
+            self.op(FpOp::Sub, v, v, q);
+        }
+        // Bits bajos de j (cos: j + 6 ≡ j - 2): bit 2 = signo, bit 1 = polinomio del coseno
+        let magic = self.magic() + if cos { 6.0 } else { 0.0 };
+        self.opk(FpOp::Add, q, j, magic);
+        let w = self.width();
+        self.shl(j, q, w - 3);
+        self.opb(FpOp::And, j, j, sign);
+        let (signs, z) = if cos {
+            self.opb(FpOp::Xor, j, j, sign);
+            (j, s)
+        } else {
+            self.op(FpOp::Xor, s, s, j);
+            (s, j)
+        };
+        self.shl(q, q, w - 2);
+        self.op(FpOp::Mul, z, v, v);
+        if self.double {
+            self.poly(x, z, &COS_P);
+            self.poly(y, z, &SIN_P);
+        } else {
+            self.poly(x, z, &COSF_P);
+            self.poly(y, z, &SINF_P);
+        }
+        self.op(FpOp::Mul, y, y, z);
+        self.op(FpOp::Mul, y, y, v);
+        self.op(FpOp::Add, y, y, v);
+        self.blend(y, y, x, q);
+        self.op(FpOp::Xor, y, y, signs);
+        y
+    }
+
+    // ---- tanh ----
+
+    /// ymm0 ← tanh ymm0
+    fn tanh(&mut self) {
+        let [x, a, b, c, d, f] = Y;
+        let (sign, abs) = (self.sign(), self.abs_mask());
+        // |x| ≥ 0.625: 1 - 2/(e^2|x| + 1), con el signo de x
+        self.opb(FpOp::And, a, x, abs);
+        self.op(FpOp::Add, b, a, a);
+        self.exp(b, [c, d, f]);
+        self.opk(FpOp::Add, b, b, 1.0);
+        self.load(c, 2.0);
+        self.op(FpOp::Div, c, c, b);
+        self.load(d, 1.0);
+        self.op(FpOp::Sub, b, d, c);
+        self.opb(FpOp::And, c, x, sign);
+        self.op(FpOp::Or, b, b, c);
+        // |x| < 0.625: x + x·z·R(z), z = x²
+        self.op(FpOp::Mul, c, x, x);
+        if self.double {
+            self.poly(d, c, &TANH_P);
+            self.poly1(f, c, &TANH_Q);
+            self.op(FpOp::Div, d, d, f);
+        } else {
+            self.poly(d, c, &TANHF_P);
+        }
+        self.op(FpOp::Mul, d, d, c);
+        self.op(FpOp::Mul, d, d, x);
+        self.op(FpOp::Add, d, d, x);
+        self.cmpk(c, a, 0.625, CMP_LT);
+        self.blend(x, b, d, c);
+    }
+
+    // ---- pow ----
+
+    /// ymm0 ← x^y en double, con x en [rsp+xo] e y en [rsp+yo]
+    fn pow_core(&mut self, xo: i32, yo: i32) {
+        let [x, a, b, c, d, f] = Y;
+        let (xm, ym) = (VexMem::base(4, xo), VexMem::base(4, yo));
+        let (sign, abs) = (self.sign(), self.abs_mask());
+        // e^(y·ln|x|)
+        self.avx(AvxInst::VmovdquLoad { dst: x, mem: xm });
+        self.opb(FpOp::And, x, x, abs);
+        let l = self.log(x, [a, b, c, d, f]);
+        let double = self.double;
+        self.avx(AvxInst::VfpMem { op: FpOp::Mul, double, dst: l, src1: l, mem: ym });
+        self.exp(l, [c, d, f]);
+        // x < 0: y entero impar cambia el signo, y no entero da NaN
+        self.avx(AvxInst::VmovdquLoad { dst: x, mem: xm });
+        self.avx(AvxInst::VmovdquLoad { dst: a, mem: ym });
+        self.round(c, a, ROUND_NEAREST);
+        self.cmp(c, c, a, CMP_EQ);
+        self.opk(FpOp::Mul, d, a, 0.5);
+        self.round(f, d, ROUND_FLOOR);
+        self.cmp(d, d, f, CMP_NEQ);
+        self.op(FpOp::And, d, d, c);
+        self.cmpk(f, x, 0.0, CMP_LT);
+        self.op(FpOp::And, d, d, f);
+        self.opb(FpOp::And, d, d, sign);
+        self.op(FpOp::Xor, l, l, d);
+        self.op(FpOp::Andn, c, c, f);
+        self.op(FpOp::Or, l, l, c);
+        // y = 0 o x = 1 → 1 (también con NaN en el otro)
+        self.cmpk(c, a, 0.0, CMP_EQ);
+        self.cmpk(d, x, 1.0, CMP_EQ);
+        self.op(FpOp::Or, c, c, d);
+        self.load(d, 1.0);
+        self.blend(x, l, d, c);
+    }
+
+    /// Cuerpo de la rutina (marco de pila ya reservado)
+    fn routine(&mut self, f: MathFn) {
+        let [x, a, b, c, d, f5] = Y;
+        match f {
+            MathFn::Sqrt => {
+                let double = self.double;
+                self.avx(AvxInst::Vsqrt { double, dst: x, src: x });
+            }
+            MathFn::Exp => self.exp(x, [a, b, c]),
+            MathFn::Log => {
+                let r = self.log(x, [a, b, c, d, f5]);
+                self.avx(AvxInst::VmovapsReg { dst: x, src: r });
+            }
+            MathFn::Sin | MathFn::Cos => {
+                let r = self.sin_cos(x, f == MathFn::Cos, [a, b, c, d, f5]);
+                self.avx(AvxInst::VmovapsReg { dst: x, src: r });
+            }
+            MathFn::Tanh => self.tanh(),
+            MathFn::Pow if self.double => {
+                self.avx(AvxInst::VmovdquStore { src: x, mem: VexMem::base(4, 0) });
+                self.avx(AvxInst::VmovdquStore { src: a, mem: VexMem::base(4, 32) });
+                self.pow_core(0, 32);
+            }
+            MathFn::Pow => {
+                // powf: el núcleo double sobre cada mitad de 4 lanes
+                self.double = true;
+                self.avx(AvxInst::VmovdquStore { src: x, mem: VexMem::base(4, 0) });
+                self.avx(AvxInst::VmovdquStore { src: a, mem: VexMem::base(4, 32) });
+                for half in 0..2 {
+                    for (from, to) in [(0, 64), (32, 96)] {
+                        self.avx(AvxInst::VmovdquLoad { dst: x, mem: VexMem::base(4, from) });
+                        if half == 1 {
+                            self.avx(AvxInst::Vextractf128 { dst: x, src: x });
+                        }
+                        self.avx(AvxInst::Vcvtps2pd { dst: x, src: x });
+                        self.avx(AvxInst::VmovdquStore { src: x, mem: VexMem::base(4, to) });
+                    }
+                    self.pow_core(64, 96);
+                    self.avx(AvxInst::Vcvtpd2ps { dst: x, src: x });
+                    if half == 0 {
+                        self.avx(AvxInst::VmovdquStore { src: x, mem: VexMem::base(4, 128) });
+                    } else {
+                        self.avx(AvxInst::VmovdquLoad { dst: a, mem: VexMem::base(4, 128) });
+                        self.avx(AvxInst::Vinsertf128 { dst: x, src1: a, src2: x });
+                    }
+                }
+                self.double = false;
+            }
+        }
+    }
+}
+
+/// Bytes de pila de la rutina (pow guarda sus argumentos)
+fn frame_bytes(f: MathFn, double: bool) -> i32 {
+    match (f, double) {
+        (MathFn::Pow, true) => 64,
+        (MathFn::Pow, false) => 160,
+        _ => 0,
+    }
+}
+
+// ============================================================
+// Runtime
+// ============================================================
+
+/// Rutinas `_ZGV` emitidas una vez por programa
+#[derive(Debug, Clone, Copy)]
+pub struct VecMathRuntime {
+    /// [función][0 = float, 1 = double]
+    entries: [[Label; 2]; 7],
+    consts: Label,
+}
+
+impl VecMathRuntime {
+    pub fn new(ir: &mut ADeadIR) -> Self {
+        let entries = std::array::from_fn(|_| [ir.new_label(), ir.new_label()]);
+        Self { entries, consts: ir.new_label() }
+    }
+
+    /// Punto de entrada vectorial (ymm0[, ymm1] → ymm0)
+    pub fn entry(&self, f: MathFn, double: bool) -> Label {
+        let i = MathFn::ALL.iter().position(|&g| g == f).unwrap();
+        self.entries[i][double as usize]
+    }
+
+    /// Llamada escalar: los argumentos son bits de double en GP (como todo
+    /// valor float del compilador); el resultado queda igual en RAX
+    pub fn emit_scalar_call(&self, ir: &mut ADeadIR, f: MathFn, double: bool, args: &[Reg]) {
+        for (i, &reg) in args.iter().enumerate() {
+            let xmm = [Reg::XMM0, Reg::XMM1][i];
+            ir.emit(ADeadOp::MovQ { dst: xmm, src: reg });
+            if !double {
+                // cvtsd2ss xmmi, xmmi
+                ir.emit(ADeadOp::RawBytes(vec![0xF2, 0x0F, 0x5A, 0xC0 | (i as u8 * 9)]));
+            }
+        }
+        ir.emit(ADeadOp::Call { target: CallTarget::Relative(self.entry(f, double)) });
+        ir.emit(ADeadOp::RawBytes(vec![0xC5, 0xF8, 0x77]));
+        if !double {
+            // cvtss2sd xmm0, xmm0
+            ir.emit(ADeadOp::RawBytes(vec![0xF3, 0x0F, 0x5A, 0xC0]));
+        }
+        ir.emit(ADeadOp::MovQ { dst: Reg::RAX, src: Reg::XMM0 });
+    }
+
+    pub fn emit_routines(&self, ir: &mut ADeadIR) {
+        let mut pool = Pool::default();
+        for f in MathFn::ALL {
+            for double in [false, true] {
+                ir.emit(ADeadOp::Label(self.entry(f, double)));
+                let frame = frame_bytes(f, double);
+                if frame > 0 {
+                    ir.emit(ADeadOp::Sub { dst: Operand::Reg(Reg::RSP), src: Operand::Imm32(frame) });
+                }
+                if f != MathFn::Sqrt {
+                    ir.emit(ADeadOp::LeaLabel { dst: Reg::RAX, label: self.consts });
+                }
+                let mut gen = Gen::new(double, &mut pool);
+                gen.routine(f);
+                let mut vex = VexEmitter::new();
+                vex.emit_all(&gen.out);
+                ir.emit(ADeadOp::RawBytes(vex.into_bytes()));
+                if frame > 0 {
+                    ir.emit(ADeadOp::Add { dst: Operand::Reg(Reg::RSP), src: Operand::Imm32(frame) });
+                }
+                ir.emit(ADeadOp::Ret);
+            }
+        }
+        ir.emit(ADeadOp::Label(self.consts));
+        ir.emit(ADeadOp::RawBytes(pool.bytes));
+    }
+}
+
+#[cfg(test)]
+mod name_tests {
+    use super::*;
+
+    #[test]
+    fn test_names() {
+        assert_eq!(MathFn::from_name("sinf"), Some((MathFn::Sin, false)));
+        assert_eq!(MathFn::from_name("log"), Some((MathFn::Log, true)));
+        assert_eq!(MathFn::from_name("logf"), Some((MathFn::Log, false)));
+        assert_eq!(MathFn::from_name("sqrt"), Some((MathFn::Sqrt, true)));
+        assert_eq!(MathFn::from_name("atan"), None);
+        assert_eq!(MathFn::Pow.vector_name(false), "_ZGVdN8vv_powf");
+        assert_eq!(MathFn::Sin.vector_name(true), "_ZGVdN4v_sin");
+        for name in MATH_FUNCTIONS {
+            let (f, double) = MathFn::from_name(name).unwrap();
+            assert_eq!(double, !name.ends_with('f'));
+            assert!(f.vector_name(double).ends_with(name));
+        }
+    }
+}
+
+#[cfg(all(test, target_os = "linux", target_arch = "x86_64"))]
+mod tests {
+    use super::*;
+    use crate::isa::test_jit::JitCode;
+
+    type VecFn = extern "C" fn(*const u8, *const u8, *mut u8);
+    type ScalarFn = extern "C" fn(u64) -> u64;
+
+    /// Rutinas + un envoltorio por función: (rdi, rsi) → [rdx] y uno escalar (rdi → rax)
+    struct Lib {
+        vector: HashMap<(MathFn, bool), VecFn>,
+        scalar: HashMap<(MathFn, bool), ScalarFn>,
+        /// Dueño del mapeo al que apuntan los punteros de arriba
+        code: JitCode,
+    }
+
+    fn build() -> Lib {
+        let mut ir = ADeadIR::new();
+        let rt = VecMathRuntime::new(&mut ir);
+        let mut wrappers = Vec::new();
+        for f in MathFn::ALL {
+            for double in [false, true] {
+                let (v, s) = (ir.new_label(), ir.new_label());
+                ir.emit(ADeadOp::Label(v));
+                let mut vex = VexEmitter::new();
+                vex.emit_all(&[
+                    AvxInst::VmovdquLoad { dst: YmmReg(0), mem: VexMem::base(7, 0) },
+                    AvxInst::VmovdquLoad { dst: YmmReg(1), mem: VexMem::base(6, 0) },
+                ]);
+                ir.emit(ADeadOp::RawBytes(vex.into_bytes()));
+                ir.emit(ADeadOp::Call { target: CallTarget::Relative(rt.entry(f, double)) });
+                let mut vex = VexEmitter::new();
+                vex.emit_all(&[AvxInst::VmovdquStore { src: YmmReg(0), mem: VexMem::base(2, 0) }, AvxInst::Vzeroupper]);
+                ir.emit(ADeadOp::RawBytes(vex.into_bytes()));
+                ir.emit(ADeadOp::Ret);
+                ir.emit(ADeadOp::Label(s));
+                rt.emit_scalar_call(&mut ir, f, double, &[Reg::RDI, Reg::RDI][..f.arity()]);
+                ir.emit(ADeadOp::Ret);
+                wrappers.push(((f, double), v, s));
+            }
+        }
+        rt.emit_routines(&mut ir);
+        let code = JitCode::new(ir.ops());
+        let mut lib = Lib { vector: HashMap::new(), scalar: HashMap::new(), code };
+        for (key, v, s) in wrappers {
+            unsafe {
+                lib.vector.insert(key, lib.code.func(v));
+                lib.scalar.insert(key, lib.code.func(s));
+            }
+        }
+        lib
+    }
+
+    fn reference(f: MathFn, x: f64, y: f64) -> f64 {
+        match f {
+            MathFn::Sin => x.sin(),
+            MathFn::Cos => x.cos(),
+            MathFn::Exp => x.exp(),
+            MathFn::Log => x.ln(),
+            MathFn::Pow => x.powf(y),
+            MathFn::Sqrt => x.sqrt(),
+            MathFn::Tanh => x.tanh(),
+        }
+    }
+
+    fn reference_f32(f: MathFn, x: f32, y: f32) -> f32 {
+        match f {
+            MathFn::Sin => x.sin(),
+            MathFn::Cos => x.cos(),
+            MathFn::Exp => x.exp(),
+            MathFn::Log => x.ln(),
+            MathFn::Pow => x.powf(y),
+            MathFn::Sqrt => x.sqrt(),
+            MathFn::Tanh => x.tanh(),
+        }
+    }
+
+    fn run_f64(lib: &Lib, f: MathFn, x: [f64; 4], y: [f64; 4]) -> [f64; 4] {
+        let mut out = [0.0f64; 4];
+        lib.vector[&(f, true)](x.as_ptr() as *const u8, y.as_ptr() as *const u8, out.as_mut_ptr() as *mut u8);
+        out
+    }
+
+    fn run_f32(lib: &Lib, f: MathFn, x: [f32; 8], y: [f32; 8]) -> [f32; 8] {
+        let mut out = [0.0f32; 8];
+        lib.vector[&(f, false)](x.as_ptr() as *const u8, y.as_ptr() as *const u8, out.as_mut_ptr() as *mut u8);
+        out
+    }
+
+    fn ulps_f64(a: f64, b: f64) -> u64 {
+        if a == b || (a.is_nan() && b.is_nan()) {
+            return 0;
+        }
+        let key = |v: f64| {
+            let i = v.to_bits() as i64;
+            if i < 0 {
+                i64::MIN - i
+            } else {
+                i
+            }
+        };
+        (key(a) as i128 - key(b) as i128).unsigned_abs() as u64
+    }
+
+    fn ulps_f32(a: f32, b: f32) -> u64 {
+        if a == b || (a.is_nan() && b.is_nan()) {
+            return 0;
+        }
+        let key = |v: f32| {
+            let i = v.to_bits() as i32;
+            if i < 0 {
+                i32::MIN as i64 - i as i64
+            } else {
+                i as i64
+            }
+        };
+        (key(a) - key(b)).unsigned_abs()
+    }
+
+    /// (función, rango de x, rango de y, ulp máx float, ulp máx double;
+    /// pow double se mide con cota relativa)
+    const CASES: [(MathFn, (f64, f64), (f64, f64), u64, u64); 8] = [
+        (MathFn::Sin, (-100.0, 100.0), (0.0, 0.0), 2, 2),
+        (MathFn::Cos, (-100.0, 100.0), (0.0, 0.0), 2, 2),
+        (MathFn::Exp, (-80.0, 80.0), (0.0, 0.0), 2, 2),
+        (MathFn::Log, (1e-30, 1e30), (0.0, 0.0), 2, 2),
+        (MathFn::Sqrt, (0.0, 1e10), (0.0, 0.0), 0, 0),
+        (MathFn::Tanh, (-10.0, 10.0), (0.0, 0.0), 2, 2),
+        (MathFn::Pow, (0.01, 100.0), (-8.0, 8.0), 1, 0),
+        (MathFn::Pow, (-4.0, 4.0), (-5.0, 5.0), 1, 0),
+    ];
+
+    #[test]
+    fn test_accuracy() {
+        let lib = build();
+        let mut seed = 7u64;
+        let mut rand = |(lo, hi): (f64, f64)| {
+            seed = seed.wrapping_mul(6364136223846793005).wrapping_add(1442695040888963407);
+            let u = (seed >> 11) as f64 / (1u64 << 53) as f64;
+            // log: muestreo logarítmico para cubrir todos los exponentes
+            if lo > 0.0 && hi / lo > 1e6 {
+                lo * (hi / lo).powf(u)
+            } else {
+                lo + (hi - lo) * u
+            }
+        };
+        for (f, xr, yr, max32, max64) in CASES {
+            let (mut worst32, mut worst64) = (0, 0);
+            for _ in 0..4000 {
+                let mut y = [0.0f64; 4];
+                let x: [f64; 4] = std::array::from_fn(|_| rand(xr));
+                for v in y.iter_mut() {
+                    // la mitad de los exponentes de pow, enteros (rama de signo)
+                    *v = if rand((0.0, 1.0)) < 0.5 { rand(yr).round() } else { rand(yr) };
+                }
+                let got = run_f64(&lib, f, x, y);
+                for i in 0..4 {
+                    let want = reference(f, x[i], y[i]);
+                    let ok = if f == MathFn::Pow {
+                        // el error de ln x se amplifica por |y·ln x| al exponenciar
+                        let bound = (2.0 + (y[i] * x[i].abs().ln()).abs()) * f64::EPSILON;
+                        want.is_nan() && got[i].is_nan() || ((got[i] - want) / want).abs() <= bound
+                    } else {
+                        worst64 = worst64.max(ulps_f64(got[i], want));
+                        ulps_f64(got[i], want) <= max64
+                    };
+                    assert!(ok, "{}({}, {}) = {} ≠ {}", f, x[i], y[i], got[i], want);
+                }
+                let xf: [f32; 8] = std::array::from_fn(|i| x[i % 4] as f32 * if i < 4 { 1.0 } else { 0.5 });
+                let yf: [f32; 8] = std::array::from_fn(|i| y[i % 4] as f32);
+                let got = run_f32(&lib, f, xf, yf);
+                for i in 0..8 {
+                    let want = reference_f32(f, xf[i], yf[i]);
+                    worst32 = worst32.max(ulps_f32(got[i], want));
+                    assert!(ulps_f32(got[i], want) <= max32, "{}f({}, {}) = {} ≠ {}", f, xf[i], yf[i], got[i], want);
+                }
+            }
+            assert!(worst32 <= max32 && worst64 <= max64);
+        }
+    }
+
+    #[test]
+    fn test_special_values() {
+        let lib = build();
+        let (inf, nan) = (f64::INFINITY, f64::NAN);
+        let check = |f: MathFn, x: f64, y: f64, want: f64| {
+            // pow = e^(y·ln x) no es exacto ni con enteros: unos pocos ulp en double
+            let tol = if f == MathFn::Pow { 4 } else { 0 };
+            let got = run_f64(&lib, f, [x; 4], [y; 4])[0];
+            assert!(ulps_f64(got, want) <= tol, "{}({}, {}) = {} ≠ {}", f, x, y, got, want);
+            let got = run_f32(&lib, f, [x as f32; 8], [y as f32; 8])[7];
+            assert!(ulps_f32(got, want as f32) == 0, "{}f({}, {}) = {} ≠ {}", f, x, y, got, want);
+        };
+        check(MathFn::Log, 0.0, 0.0, -inf);
+        check(MathFn::Log, -1.0, 0.0, nan);
+        check(MathFn::Log, inf, 0.0, inf);
+        check(MathFn::Log, 1.0, 0.0, 0.0);
+        check(MathFn::Exp, 1000.0, 0.0, inf);
+        check(MathFn::Exp, -1000.0, 0.0, 0.0);
+        check(MathFn::Exp, 0.0, 0.0, 1.0);
+        check(MathFn::Exp, nan, 0.0, nan);
+        check(MathFn::Sin, nan, 0.0, nan);
+        check(MathFn::Sin, 0.0, 0.0, 0.0);
+        check(MathFn::Cos, 0.0, 0.0, 1.0);
+        check(MathFn::Tanh, 20.0, 0.0, 1.0);
+        check(MathFn::Tanh, -20.0, 0.0, -1.0);
+        check(MathFn::Tanh, nan, 0.0, nan);
+        check(MathFn::Pow, -2.0, 3.0, -8.0);
+        check(MathFn::Pow, -2.0, 0.5, nan);
+        check(MathFn::Pow, 0.0, 2.0, 0.0);
+        check(MathFn::Pow, 0.0, -1.0, inf);
+        check(MathFn::Pow, nan, 0.0, 1.0);
+        check(MathFn::Pow, 1.0, nan, 1.0);
+        check(MathFn::Pow, 2.0, 10.0, 1024.0);
+        check(MathFn::Sqrt, -1.0, 0.0, nan);
+        // Subnormales
+        let tiny = f64::from_bits(1 << 20);
+        assert!(ulps_f64(run_f64(&lib, MathFn::Log, [tiny; 4], [0.0; 4])[0], tiny.ln()) <= 2);
+        let tinyf = f32::from_bits(1 << 10);
+        assert!(ulps_f32(run_f32(&lib, MathFn::Log, [tinyf; 8], [0.0; 8])[0], tinyf.ln()) <= 2);
+    }
+
+    #[test]
+    fn test_scalar_entry() {
+        let lib = build();
+        for (f, x, y) in [(MathFn::Sin, 0.5, 0.0), (MathFn::Log, 10.0, 0.0), (MathFn::Pow, 1.5, 1.5)] {
+            // pow(x, x): el envoltorio pasa RDI en los dos argumentos
+            let y = if f == MathFn::Pow { x } else { y };
+            let got = f64::from_bits(lib.scalar[&(f, true)](f64::to_bits(x)));
+            assert!(ulps_f64(got, reference(f, x, y)) <= 2);
+            let got = f64::from_bits(lib.scalar[&(f, false)](f64::to_bits(x)));
+            assert!(ulps_f32(got as f32, reference_f32(f, x as f32, y as f32)) <= 1);
+        }
+    }
+}
@@ -17,6 +17,14 @@
 //   VFMADD231PS ymm, ymm, ymm — FMA (a += b * c)
 //   VPCMPEQD  ymm, ymm, ymm — comparación paralela (BG)
 //   VPTEST    ymm, ymm      — test paralelo (BG)
+//   VMOVDQU   ymm, [b+i*s+d] — carga/almacena sin alinear (loops)
+//   VPADD/VPSUB/VPMULL/VPAND/VPOR/VPXOR — aritmética entera por lane
+//   VPBROADCASTB/W/D/Q        — splat de un escalar (invariantes)
+//   V{ADD,SUB,MUL,DIV,MIN,MAX,AND,ANDN,OR,XOR}{PS,PD}, VSQRT, VROUND,
+//   VCMP, VBLENDV, VPSLL/VPSRL imm, VCVTPS2PD/PD2PS, VEXTRACT/INSERTF128
+//                             — librería matemática vectorial (vec_math.rs)
+//   VBROADCASTSS, VFMADD231PS m256, VMASKMOVPS, VPERMILPS imm
+//                             — kernels densos (blas_kernels.rs)
 //   VZEROUPPER                — limpiar estado YMM superior
 //
 // Autor: Eddi Andreé Salazar Matos — Lima, Perú
@@ -102,6 +110,94 @@ impl VexL {
     }
 }
 
+/// Memory operand `[base + index*scale + disp]` (GP register encodings).
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct VexMem {
+    pub base: u8,
+    /// (index register, scale 1/2/4/8); index must not be RSP
+    pub index: Option<(u8, u8)>,
+    pub disp: i32,
+}
+
+impl VexMem {
+    pub fn base(base: u8, disp: i32) -> Self {
+        Self { base, index: None, disp }
+    }
+
+    pub fn indexed(base: u8, index: u8, scale: u8, disp: i32) -> Self {
+        Self { base, index: Some((index, scale)), disp }
+    }
+}
+
+impl std::fmt::Display for VexMem {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self.index {
+            Some((index, scale)) => write!(f, "[gp{}+gp{}*{}+{}]", self.base, index, scale, self.disp),
+            None => write!(f, "[gp{}+{}]", self.base, self.disp),
+        }
+    }
+}
+
+/// Packed floating-point operation with the `0F xx` encoding shared by
+/// the PS (pp = none) and PD (pp = 66) forms
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum FpOp {
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Min,
+    Max,
+    And,
+    /// dst = !src1 & src2
+    Andn,
+    Or,
+    Xor,
+}
+
+impl FpOp {
+    fn opcode(&self) -> u8 {
+        match self {
+            FpOp::And => 0x54,
+            FpOp::Andn => 0x55,
+            FpOp::Or => 0x56,
+            FpOp::Xor => 0x57,
+            FpOp::Add => 0x58,
+            FpOp::Mul => 0x59,
+            FpOp::Sub => 0x5C,
+            FpOp::Min => 0x5D,
+            FpOp::Div => 0x5E,
+            FpOp::Max => 0x5F,
+        }
+    }
+
+    fn mnemonic(&self) -> &'static str {
+        match self {
+            FpOp::Add => "add",
+            FpOp::Sub => "sub",
+            FpOp::Mul => "mul",
+            FpOp::Div => "div",
+            FpOp::Min => "min",
+            FpOp::Max => "max",
+            FpOp::And => "and",
+            FpOp::Andn => "andn",
+            FpOp::Or => "or",
+            FpOp::Xor => "xor",
+        }
+    }
+}
+
+fn fp_suffix(double: bool) -> &'static str {
+    if double { "pd" } else { "ps" }
+}
+
+fn fp_pp(double: bool) -> VexPP {
+    if double { VexPP::P66 } else { VexPP::None }
+}
+
+/// "Sin registro" en VEX.vvvv (el campo se codifica invertido: 1111)
+const NO_VVVV: u8 = 0;
+
 // ============================================================
 // AVX Instruction Definitions
 // ============================================================
@@ -157,6 +253,14 @@ pub enum AvxInst {
         src1: YmmReg,
         src2: YmmReg,
     },
+    /// VPCMPEQB ymm, ymm, ymm — packed byte compare equal
+    Vpcmpeqb {
+        dst: YmmReg,
+        src1: YmmReg,
+        src2: YmmReg,
+    },
+    /// VPMOVMSKB r32, ymm — gather the 32 byte sign bits into a GP register
+    Vpmovmskb { dst: u8, src: YmmReg },
     /// VPTEST ymm, ymm — packed bitwise test (sets ZF/CF)
     Vptest {
         src1: YmmReg,
@@ -168,6 +272,134 @@ pub enum AvxInst {
         src1: YmmReg,
         src2: YmmReg,
     },
+    /// VMOVDQU ymm, [mem] — unaligned 256-bit load
+    VmovdquLoad { dst: YmmReg, mem: VexMem },
+    /// VMOVDQU [mem], ymm — unaligned 256-bit store
+    VmovdquStore { src: YmmReg, mem: VexMem },
+    /// VMOVDQA ymm, [mem] — aligned 256-bit load (faults unless 32-aligned)
+    VmovdqaLoad { dst: YmmReg, mem: VexMem },
+    /// VMOVDQA [mem], ymm — aligned 256-bit store
+    VmovdqaStore { src: YmmReg, mem: VexMem },
+    /// VPADDB/W/D/Q ymm, ymm, ymm — packed integer add (lane = 1/2/4/8 bytes)
+    Vpadd {
+        lane: u8,
+        dst: YmmReg,
+        src1: YmmReg,
+        src2: YmmReg,
+    },
+    /// VPSUBB/W/D/Q ymm, ymm, ymm — packed integer sub
+    Vpsub {
+        lane: u8,
+        dst: YmmReg,
+        src1: YmmReg,
+        src2: YmmReg,
+    },
+    /// VPMULLW/VPMULLD ymm, ymm, ymm — packed multiply, low half (lane = 2/4)
+    Vpmull {
+        lane: u8,
+        dst: YmmReg,
+        src1: YmmReg,
+        src2: YmmReg,
+    },
+    /// VPAND ymm, ymm, ymm
+    Vpand {
+        dst: YmmReg,
+        src1: YmmReg,
+        src2: YmmReg,
+    },
+    /// VPOR ymm, ymm, ymm
+    Vpor {
+        dst: YmmReg,
+        src1: YmmReg,
+        src2: YmmReg,
+    },
+    /// VPXOR ymm, ymm, ymm
+    Vpxor {
+        dst: YmmReg,
+        src1: YmmReg,
+        src2: YmmReg,
+    },
+    /// VMOVQ xmm, r64 — move a GP register into the low lane
+    VmovqFromGp { dst: YmmReg, src: u8 },
+    /// VPBROADCASTB/W/D/Q ymm, xmm — splat the low lane (lane = 1/2/4/8 bytes)
+    Vpbroadcast { lane: u8, dst: YmmReg, src: YmmReg },
+    /// VMOVAPS ymm, ymm — register copy
+    VmovapsReg { dst: YmmReg, src: YmmReg },
+    /// V{op}PS/PD ymm, ymm, ymm (`double` selects PD)
+    Vfp {
+        op: FpOp,
+        double: bool,
+        dst: YmmReg,
+        src1: YmmReg,
+        src2: YmmReg,
+    },
+    /// V{op}PS/PD ymm, ymm, m256
+    VfpMem {
+        op: FpOp,
+        double: bool,
+        dst: YmmReg,
+        src1: YmmReg,
+        mem: VexMem,
+    },
+    /// VSQRTPS/PD ymm, ymm
+    Vsqrt { double: bool, dst: YmmReg, src: YmmReg },
+    /// VROUNDPS/PD ymm, ymm, imm8 (0 nearest, 1 floor, 2 ceil, 3 trunc)
+    Vround {
+        double: bool,
+        dst: YmmReg,
+        src: YmmReg,
+        mode: u8,
+    },
+    /// VCMPPS/PD ymm, ymm, m256, imm8 — all-ones lanes where `pred` holds
+    VcmpMem {
+        double: bool,
+        pred: u8,
+        dst: YmmReg,
+        src1: YmmReg,
+        mem: VexMem,
+    },
+    /// VCMPPS/PD ymm, ymm, ymm, imm8
+    Vcmp {
+        double: bool,
+        pred: u8,
+        dst: YmmReg,
+        src1: YmmReg,
+        src2: YmmReg,
+    },
+    /// VBLENDVPS/PD ymm, ymm, ymm, ymm — per lane `mask` sign ? src2 : src1
+    Vblendv {
+        double: bool,
+        dst: YmmReg,
+        src1: YmmReg,
+        src2: YmmReg,
+        mask: YmmReg,
+    },
+    /// VPSLLD/Q (left) or VPSRLD/Q ymm, ymm, imm8 (lane = 4/8 bytes)
+    VpshiftImm {
+        lane: u8,
+        left: bool,
+        dst: YmmReg,
+        src: YmmReg,
+        imm: u8,
+    },
+    /// VCVTPS2PD ymm, xmm — 4 floats of the low half to 4 doubles
+    Vcvtps2pd { dst: YmmReg, src: YmmReg },
+    /// VCVTPD2PS xmm, ymm — 4 doubles to 4 floats (upper half zeroed)
+    Vcvtpd2ps { dst: YmmReg, src: YmmReg },
+    /// VEXTRACTF128 xmm, ymm, 1 — upper 128 bits
+    Vextractf128 { dst: YmmReg, src: YmmReg },
+    /// VINSERTF128 ymm, ymm, xmm, 1 — replace the upper 128 bits
+    Vinsertf128 { dst: YmmReg, src1: YmmReg, src2: YmmReg },
+    /// VBROADCASTSS ymm, m32 — splat one float from memory
+    Vbroadcastss { dst: YmmReg, mem: VexMem },
+    /// VFMADD231PS ymm, ymm, m256 — dst += src1 * [mem]
+    Vfmadd231psMem { dst: YmmReg, src1: YmmReg, mem: VexMem },
+    /// VMASKMOVPS ymm, ymm, m256 — load the lanes whose `mask` sign is set, zero the rest
+    VmaskmovpsLoad { dst: YmmReg, mask: YmmReg, mem: VexMem },
+    /// VMASKMOVPS m256, ymm, ymm — store only the lanes whose `mask` sign is set
+    VmaskmovpsStore { src: YmmReg, mask: YmmReg, mem: VexMem },
+    /// VPERMILPS ymm, ymm, imm8 — permute floats inside each 128-bit half
+    Vpermilps { dst: YmmReg, src: YmmReg, imm: u8 },
     /// VZEROUPPER — clear upper 128 bits of all YMM registers
     Vzeroupper,
 }
@@ -199,17 +431,85 @@ impl std::fmt::Display for AvxInst {
             AvxInst::Vpcmpeqd { dst, src1, src2 } => {
                 write!(f, "vpcmpeqd {}, {}, {}", dst, src1, src2)
             }
+            AvxInst::Vpcmpeqb { dst, src1, src2 } => {
+                write!(f, "vpcmpeqb {}, {}, {}", dst, src1, src2)
+            }
+            AvxInst::Vpmovmskb { dst, src } => write!(f, "vpmovmskb gp{}, {}", dst, src),
             AvxInst::Vptest { src1, src2 } => {
                 write!(f, "vptest {}, {}", src1, src2)
             }
             AvxInst::Vxorps { dst, src1, src2 } => {
                 write!(f, "vxorps {}, {}, {}", dst, src1, src2)
             }
+            AvxInst::VmovdquLoad { dst, mem } => write!(f, "vmovdqu {}, {}", dst, mem),
+            AvxInst::VmovdquStore { src, mem } => write!(f, "vmovdqu {}, {}", mem, src),
+            AvxInst::VmovdqaLoad { dst, mem } => write!(f, "vmovdqa {}, {}", dst, mem),
+            AvxInst::VmovdqaStore { src, mem } => write!(f, "vmovdqa {}, {}", mem, src),
+            AvxInst::Vpadd { lane, dst, src1, src2 } => {
+                write!(f, "vpadd{} {}, {}, {}", lane_suffix(*lane), dst, src1, src2)
+            }
+            AvxInst::Vpsub { lane, dst, src1, src2 } => {
+                write!(f, "vpsub{} {}, {}, {}", lane_suffix(*lane), dst, src1, src2)
+            }
+            AvxInst::Vpmull { lane, dst, src1, src2 } => {
+                write!(f, "vpmull{} {}, {}, {}", lane_suffix(*lane), dst, src1, src2)
+            }
+            AvxInst::Vpand { dst, src1, src2 } => write!(f, "vpand {}, {}, {}", dst, src1, src2),
+            AvxInst::Vpor { dst, src1, src2 } => write!(f, "vpor {}, {}, {}", dst, src1, src2),
+            AvxInst::Vpxor { dst, src1, src2 } => write!(f, "vpxor {}, {}, {}", dst, src1, src2),
+            AvxInst::VmovqFromGp { dst, src } => write!(f, "vmovq {}, gp{}", dst.xmm_half(), src),
+            AvxInst::Vpbroadcast { lane, dst, src } => {
+                write!(f, "vpbroadcast{} {}, {}", lane_suffix(*lane), dst, src.xmm_half())
+            }
+            AvxInst::VmovapsReg { dst, src } => write!(f, "vmovaps {}, {}", dst, src),
+            AvxInst::Vfp { op, double, dst, src1, src2 } => {
+                write!(f, "v{}{} {}, {}, {}", op.mnemonic(), fp_suffix(*double), dst, src1, src2)
+            }
+            AvxInst::VfpMem { op, double, dst, src1, mem } => {
+                write!(f, "v{}{} {}, {}, {}", op.mnemonic(), fp_suffix(*double), dst, src1, mem)
+            }
+            AvxInst::Vsqrt { double, dst, src } => write!(f, "vsqrt{} {}, {}", fp_suffix(*double), dst, src),
+            AvxInst::Vround { double, dst, src, mode } => {
+                write!(f, "vround{} {}, {}, {}", fp_suffix(*double), dst, src, mode)
+            }
+            AvxInst::VcmpMem { double, pred, dst, src1, mem } => {
+                write!(f, "vcmp{} {}, {}, {}, {}", fp_suffix(*double), dst, src1, mem, pred)
+            }
+            AvxInst::Vcmp { double, pred, dst, src1, src2 } => {
+                write!(f, "vcmp{} {}, {}, {}, {}", fp_suffix(*double), dst, src1, src2, pred)
+            }
+            AvxInst::Vblendv { double, dst, src1, src2, mask } => {
+                write!(f, "vblendv{} {}, {}, {}, {}", fp_suffix(*double), dst, src1, src2, mask)
+            }
+            AvxInst::VpshiftImm { lane, left, dst, src, imm } => {
+                let dir = if *left { "sll" } else { "srl" };
+                write!(f, "vp{}{} {}, {}, {}", dir, lane_suffix(*lane), dst, src, imm)
+            }
+            AvxInst::Vcvtps2pd { dst, src } => write!(f, "vcvtps2pd {}, {}", dst, src.xmm_half()),
+            AvxInst::Vcvtpd2ps { dst, src } => write!(f, "vcvtpd2ps {}, {}", dst.xmm_half(), src),
+            AvxInst::Vextractf128 { dst, src } => write!(f, "vextractf128 {}, {}, 1", dst.xmm_half(), src),
+            AvxInst::Vinsertf128 { dst, src1, src2 } => {
+                write!(f, "vinsertf128 {}, {}, {}, 1", dst, src1, src2.xmm_half())
+            }
+            AvxInst::Vbroadcastss { dst, mem } => write!(f, "vbroadcastss {}, {}", dst, mem),
+            AvxInst::Vfmadd231psMem { dst, src1, mem } => write!(f, "vfmadd231ps {}, {}, {}", dst, src1, mem),
+            AvxInst::VmaskmovpsLoad { dst, mask, mem } => write!(f, "vmaskmovps {}, {}, {}", dst, mask, mem),
+            AvxInst::VmaskmovpsStore { src, mask, mem } => write!(f, "vmaskmovps {}, {}, {}", mem, mask, src),
+            AvxInst::Vpermilps { dst, src, imm } => write!(f, "vpermilps {}, {}, {}", dst, src, imm),
             AvxInst::Vzeroupper => write!(f, "vzeroupper"),
         }
     }
 }
 
+fn lane_suffix(lane: u8) -> char {
+    match lane {
+        1 => 'b',
+        2 => 'w',
+        4 => 'd',
+        _ => 'q',
+    }
+}
+
 // ============================================================
 // VexEmitter — Byte-level encoder
 // ============================================================
@@ -265,9 +565,10 @@ impl VexEmitter {
         self.bytes.clear();
     }
 
-    /// Emit a 2-byte VEX prefix
+    /// Emit a 2-byte VEX prefix. `r` is the stored (inverted) bit:
+    /// true = register < 8.
     fn emit_vex2(&mut self, r: bool, vvvv: u8, l: VexL, pp: VexPP) {
-        let byte2 = (!r as u8 & 1) << 7
+        let byte2 = (r as u8) << 7
             | ((!vvvv & 0xF) << 3)
             | (l.bit() << 2)
             | pp.bits();
@@ -275,7 +576,8 @@ impl VexEmitter {
         self.bytes.push(byte2);
     }
 
-    /// Emit a 3-byte VEX prefix
+    /// Emit a 3-byte VEX prefix. `r`/`x`/`b` are the stored (inverted)
+    /// bits: true = register < 8.
     fn emit_vex3(
         &mut self,
         r: bool,
@@ -287,10 +589,7 @@ impl VexEmitter {
         l: VexL,
         pp: VexPP,
     ) {
-        let byte2 = (!r as u8 & 1) << 7
-            | (!x as u8 & 1) << 6
-            | (!b as u8 & 1) << 5
-            | map.mmmmm();
+        let byte2 = (r as u8) << 7 | (x as u8) << 6 | (b as u8) << 5 | map.mmmmm();
         let byte3 = (w as u8) << 7
             | ((!vvvv & 0xF) << 3)
             | (l.bit() << 2)
@@ -333,6 +632,64 @@ impl VexEmitter {
         }
     }
 
+    /// ModR/M + SIB + displacement for `[base + index*scale + disp]`
+    fn emit_modrm_vexmem(&mut self, reg: u8, mem: &VexMem) {
+        let (index, scale) = match mem.index {
+            Some(ix) => ix,
+            None => return self.emit_modrm_mem(reg, mem.base, mem.disp),
+        };
+        let scale_bits = match scale {
+            1 => 0,
+            2 => 1,
+            4 => 2,
+            _ => 3,
+        };
+        let sib = (scale_bits << 6) | ((index & 7) << 3) | (mem.base & 7);
+        let reg_field = (reg & 7) << 3;
+        if mem.disp == 0 && (mem.base & 7) != 5 {
+            self.bytes.push(reg_field | 0x04);
+            self.bytes.push(sib);
+        } else if mem.disp >= -128 && mem.disp <= 127 {
+            self.bytes.push(0x40 | reg_field | 0x04);
+            self.bytes.push(sib);
+            self.bytes.push(mem.disp as u8);
+        } else {
+            self.bytes.push(0x80 | reg_field | 0x04);
+            self.bytes.push(sib);
+            self.bytes.extend_from_slice(&mem.disp.to_le_bytes());
+        }
+    }
+
+    /// Emit the shortest VEX prefix for the given extension bits
+    /// (`r`/`x`/`b` = register >= 8).
+    fn emit_vex(&mut self, r: bool, x: bool, b: bool, map: VexMap, w: bool, vvvv: u8, l: VexL, pp: VexPP) {
+        if x || b || w || map != VexMap::Map0F {
+            self.emit_vex3(!r, !x, !b, map, w, vvvv, l, pp);
+        } else {
+            self.emit_vex2(!r, vvvv, l, pp);
+        }
+    }
+
+    /// Emit `OP reg, [mem]` / `OP [mem], reg` (direction set by the opcode)
+    fn emit_avx_mem(&mut self, opcode: u8, reg: u8, mem: &VexMem, map: VexMap, pp: VexPP) {
+        self.emit_avx_mem_nds(opcode, reg, NO_VVVV, mem, map, pp);
+    }
+
+    /// Emit `OP reg, vvvv, [mem]`
+    fn emit_avx_mem_nds(&mut self, opcode: u8, reg: u8, vvvv: u8, mem: &VexMem, map: VexMap, pp: VexPP) {
+        let x = mem.index.map_or(false, |(ix, _)| ix >= 8);
+        self.emit_vex(reg >= 8, x, mem.base >= 8, map, false, vvvv, VexL::L256, pp);
+        self.bytes.push(opcode);
+        self.emit_modrm_vexmem(reg, mem);
+    }
+
+    /// Emit `OP reg, rm` with no vvvv source
+    fn emit_avx_rr(&mut self, opcode: u8, reg: u8, rm: u8, map: VexMap, pp: VexPP, w: bool, l: VexL) {
+        self.emit_vex(reg >= 8, false, rm >= 8, map, w, NO_VVVV, l, pp);
+        self.bytes.push(opcode);
+        self.emit_modrm_rr(reg, rm);
+    }
+
     /// Determine whether we need 2-byte or 3-byte VEX
     fn needs_vex3(dst: &YmmReg, src2: Option<&YmmReg>, map: VexMap) -> bool {
         // Need VEX3 if: map != 0F, or any register >= 8
@@ -390,12 +747,12 @@ impl VexEmitter {
                         *base < 8,
                         VexMap::Map0F,
                         false,
-                        0xF, // no vvvv source
+                        NO_VVVV,
                         VexL::L256,
                         VexPP::None,
                     );
                 } else {
-                    self.emit_vex2(!dst.needs_rex_r(), 0xF, VexL::L256, VexPP::None);
+                    self.emit_vex2(!dst.needs_rex_r(), NO_VVVV, VexL::L256, VexPP::None);
                 }
                 self.bytes.push(0x28);
                 self.emit_modrm_mem(dst.modrm_reg(), *base, *disp);
@@ -410,12 +767,12 @@ impl VexEmitter {
                         *base < 8,
                         VexMap::Map0F,
                         false,
-                        0xF,
+                        NO_VVVV,
                         VexL::L256,
                         VexPP::None,
                     );
                 } else {
-                    self.emit_vex2(!src.needs_rex_r(), 0xF, VexL::L256, VexPP::None);
+                    self.emit_vex2(!src.needs_rex_r(), NO_VVVV, VexL::L256, VexPP::None);
                 }
                 self.bytes.push(0x29);
                 self.emit_modrm_mem(src.modrm_reg(), *base, *disp);
@@ -451,6 +808,16 @@ impl VexEmitter {
                 self.emit_avx_rrr(0x76, dst, src1, src2, VexMap::Map0F, VexPP::P66);
             }
 
+            AvxInst::Vpcmpeqb { dst, src1, src2 } => {
+                // VPCMPEQB: VEX.NDS.256.66.0F.WIG 74 /r
+                self.emit_avx_rrr(0x74, dst, src1, src2, VexMap::Map0F, VexPP::P66);
+            }
+
+            AvxInst::Vpmovmskb { dst, src } => {
+                // VPMOVMSKB r32, ymm: VEX.256.66.0F.WIG D7 /r
+                self.emit_avx_rr(0xD7, *dst, src.index(), VexMap::Map0F, VexPP::P66, false, VexL::L256);
+            }
+
             AvxInst::Vptest { src1, src2 } => {
                 // VPTEST: VEX.256.66.0F38.WIG 17 /r
                 if Self::needs_vex3(src1, Some(src2), VexMap::Map0F38) {
@@ -460,12 +827,12 @@ impl VexEmitter {
                         !src2.needs_rex_r(),
                         VexMap::Map0F38,
                         false,
-                        0xF, // no vvvv for VPTEST
+                        NO_VVVV,
                         VexL::L256,
                         VexPP::P66,
                     );
                 } else {
-                    self.emit_vex2(!src1.needs_rex_r(), 0xF, VexL::L256, VexPP::P66);
+                    self.emit_vex2(!src1.needs_rex_r(), NO_VVVV, VexL::L256, VexPP::P66);
                 }
                 self.bytes.push(0x17);
                 self.emit_modrm_rr(src1.modrm_reg(), src2.modrm_reg());
@@ -476,9 +843,194 @@ impl VexEmitter {
                 self.emit_avx_rrr(0x57, dst, src1, src2, VexMap::Map0F, VexPP::None);
             }
 
+            AvxInst::VmovdquLoad { dst, mem } => {
+                // VMOVDQU ymm, m256: VEX.256.F3.0F.WIG 6F /r
+                self.emit_avx_mem(0x6F, dst.index(), mem, VexMap::Map0F, VexPP::F3);
+            }
+
+            AvxInst::VmovdquStore { src, mem } => {
+                // VMOVDQU m256, ymm: VEX.256.F3.0F.WIG 7F /r
+                self.emit_avx_mem(0x7F, src.index(), mem, VexMap::Map0F, VexPP::F3);
+            }
+
+            AvxInst::VmovdqaLoad { dst, mem } => {
+                // VMOVDQA ymm, m256: VEX.256.66.0F.WIG 6F /r
+                self.emit_avx_mem(0x6F, dst.index(), mem, VexMap::Map0F, VexPP::P66);
+            }
+
+            AvxInst::VmovdqaStore { src, mem } => {
+                // VMOVDQA m256, ymm: VEX.256.66.0F.WIG 7F /r
+                self.emit_avx_mem(0x7F, src.index(), mem, VexMap::Map0F, VexPP::P66);
+            }
+
+            AvxInst::Vpadd { lane, dst, src1, src2 } => {
+                // VPADDB/W/D/Q: VEX.NDS.256.66.0F.WIG FC/FD/FE/D4 /r
+                let opcode = match lane {
+                    1 => 0xFC,
+                    2 => 0xFD,
+                    4 => 0xFE,
+                    _ => 0xD4,
+                };
+                self.emit_avx_rrr(opcode, dst, src1, src2, VexMap::Map0F, VexPP::P66);
+            }
+
+            AvxInst::Vpsub { lane, dst, src1, src2 } => {
+                // VPSUBB/W/D/Q: VEX.NDS.256.66.0F.WIG F8/F9/FA/FB /r
+                let opcode = match lane {
+                    1 => 0xF8,
+                    2 => 0xF9,
+                    4 => 0xFA,
+                    _ => 0xFB,
+                };
+                self.emit_avx_rrr(opcode, dst, src1, src2, VexMap::Map0F, VexPP::P66);
+            }
+
+            AvxInst::Vpmull { lane, dst, src1, src2 } => {
+                if *lane == 2 {
+                    // VPMULLW: VEX.NDS.256.66.0F.WIG D5 /r
+                    self.emit_avx_rrr(0xD5, dst, src1, src2, VexMap::Map0F, VexPP::P66);
+                } else {
+                    // VPMULLD: VEX.NDS.256.66.0F38.WIG 40 /r
+                    self.emit_avx_rrr(0x40, dst, src1, src2, VexMap::Map0F38, VexPP::P66);
+                }
+            }
+
+            AvxInst::Vpand { dst, src1, src2 } => {
+                // VPAND: VEX.NDS.256.66.0F.WIG DB /r
+                self.emit_avx_rrr(0xDB, dst, src1, src2, VexMap::Map0F, VexPP::P66);
+            }
+
+            AvxInst::Vpor { dst, src1, src2 } => {
+                // VPOR: VEX.NDS.256.66.0F.WIG EB /r
+                self.emit_avx_rrr(0xEB, dst, src1, src2, VexMap::Map0F, VexPP::P66);
+            }
+
+            AvxInst::Vpxor { dst, src1, src2 } => {
+                // VPXOR: VEX.NDS.256.66.0F.WIG EF /r
+                self.emit_avx_rrr(0xEF, dst, src1, src2, VexMap::Map0F, VexPP::P66);
+            }
+
+            AvxInst::VmovqFromGp { dst, src } => {
+                // VMOVQ xmm, r64: VEX.128.66.0F.W1 6E /r
+                self.emit_avx_rr(0x6E, dst.index(), *src, VexMap::Map0F, VexPP::P66, true, VexL::L128);
+            }
+
+            AvxInst::Vpbroadcast { lane, dst, src } => {
+                // VPBROADCASTB/W/D/Q ymm, xmm: VEX.256.66.0F38.W0 78/79/58/59 /r
+                let opcode = match lane {
+                    1 => 0x78,
+                    2 => 0x79,
+                    4 => 0x58,
+                    _ => 0x59,
+                };
+                self.emit_avx_rr(opcode, dst.index(), src.index(), VexMap::Map0F38, VexPP::P66, false, VexL::L256);
+            }
+
+            AvxInst::VmovapsReg { dst, src } => {
+                // VMOVAPS ymm, ymm: VEX.256.0F.WIG 28 /r
+                self.emit_avx_rr(0x28, dst.index(), src.index(), VexMap::Map0F, VexPP::None, false, VexL::L256);
+            }
+
+            AvxInst::Vfp { op, double, dst, src1, src2 } => {
+                // VEX.NDS.256.{none,66}.0F.WIG 54..5F /r
+                self.emit_avx_rrr(op.opcode(), dst, src1, src2, VexMap::Map0F, fp_pp(*double));
+            }
+
+            AvxInst::VfpMem { op, double, dst, src1, mem } => {
+                self.emit_avx_mem_nds(op.opcode(), dst.index(), src1.index(), mem, VexMap::Map0F, fp_pp(*double));
+            }
+
+            AvxInst::Vsqrt { double, dst, src } => {
+                // VSQRTPS/PD: VEX.256.{none,66}.0F.WIG 51 /r
+                self.emit_avx_rr(0x51, dst.index(), src.index(), VexMap::Map0F, fp_pp(*double), false, VexL::L256);
+            }
+
+            AvxInst::Vround { double, dst, src, mode } => {
+                // VROUNDPS/PD: VEX.256.66.0F3A.WIG 08/09 /r ib
+                let opcode = if *double { 0x09 } else { 0x08 };
+                self.emit_avx_rr(opcode, dst.index(), src.index(), VexMap::Map0F3A, VexPP::P66, false, VexL::L256);
+                self.bytes.push(*mode);
+            }
+
+            AvxInst::VcmpMem { double, pred, dst, src1, mem } => {
+                // VCMPPS/PD: VEX.NDS.256.{none,66}.0F.WIG C2 /r ib
+                self.emit_avx_mem_nds(0xC2, dst.index(), src1.index(), mem, VexMap::Map0F, fp_pp(*double));
+                self.bytes.push(*pred);
+            }
+
+            AvxInst::Vcmp { double, pred, dst, src1, src2 } => {
+                self.emit_avx_rrr(0xC2, dst, src1, src2, VexMap::Map0F, fp_pp(*double));
+                self.bytes.push(*pred);
+            }
+
+            AvxInst::Vblendv { double, dst, src1, src2, mask } => {
+                // VBLENDVPS/PD: VEX.NDS.256.66.0F3A.W0 4A/4B /r /is4
+                let opcode = if *double { 0x4B } else { 0x4A };
+                self.emit_avx_rrr(opcode, dst, src1, src2, VexMap::Map0F3A, VexPP::P66);
+                self.bytes.push(mask.index() << 4);
+            }
+
+            AvxInst::VpshiftImm { lane, left, dst, src, imm } => {
+                // VPSLLD/VPSRLD: VEX.NDD.256.66.0F 72 /6 (/2) ib; Q forms 73
+                let opcode = if *lane == 8 { 0x73 } else { 0x72 };
+                let digit = if *left { 6 } else { 2 };
+                self.emit_vex(false, false, src.index() >= 8, VexMap::Map0F, false, dst.index(), VexL::L256, VexPP::P66);
+                self.bytes.push(opcode);
+                self.emit_modrm_rr(digit, src.index());
+                self.bytes.push(*imm);
+            }
+
+            AvxInst::Vcvtps2pd { dst, src } => {
+                // VCVTPS2PD ymm, xmm: VEX.256.0F.WIG 5A /r
+                self.emit_avx_rr(0x5A, dst.index(), src.index(), VexMap::Map0F, VexPP::None, false, VexL::L256);
+            }
+
+            AvxInst::Vcvtpd2ps { dst, src } => {
+                // VCVTPD2PS xmm, ymm: VEX.256.66.0F.WIG 5A /r
+                self.emit_avx_rr(0x5A, dst.index(), src.index(), VexMap::Map0F, VexPP::P66, false, VexL::L256);
+            }
+
+            AvxInst::Vextractf128 { dst, src } => {
+                // VEXTRACTF128 xmm, ymm, ib: VEX.256.66.0F3A.W0 19 /r ib (reg = ymm)
+                self.emit_avx_rr(0x19, src.index(), dst.index(), VexMap::Map0F3A, VexPP::P66, false, VexL::L256);
+                self.bytes.push(1);
+            }
+
+            AvxInst::Vinsertf128 { dst, src1, src2 } => {
+                // VINSERTF128 ymm, ymm, xmm, ib: VEX.NDS.256.66.0F3A.W0 18 /r ib
+                self.emit_avx_rrr(0x18, dst, src1, src2, VexMap::Map0F3A, VexPP::P66);
+                self.bytes.push(1);
+            }
+
+            AvxInst::Vbroadcastss { dst, mem } => {
+                // VBROADCASTSS ymm, m32: VEX.256.66.0F38.W0 18 /r
+                self.emit_avx_mem(0x18, dst.index(), mem, VexMap::Map0F38, VexPP::P66);
+            }
+
+            AvxInst::Vfmadd231psMem { dst, src1, mem } => {
+                // VFMADD231PS ymm, ymm, m256: VEX.DDS.256.66.0F38.W0 B8 /r
+                self.emit_avx_mem_nds(0xB8, dst.index(), src1.index(), mem, VexMap::Map0F38, VexPP::P66);
+            }
+
+            AvxInst::VmaskmovpsLoad { dst, mask, mem } => {
+                // VMASKMOVPS ymm, ymm, m256: VEX.NDS.256.66.0F38.W0 2C /r
+                self.emit_avx_mem_nds(0x2C, dst.index(), mask.index(), mem, VexMap::Map0F38, VexPP::P66);
+            }
+
+            AvxInst::VmaskmovpsStore { src, mask, mem } => {
+                // VMASKMOVPS m256, ymm, ymm: VEX.NDS.256.66.0F38.W0 2E /r
+                self.emit_avx_mem_nds(0x2E, src.index(), mask.index(), mem, VexMap::Map0F38, VexPP::P66);
+            }
+
+            AvxInst::Vpermilps { dst, src, imm } => {
+                // VPERMILPS ymm, ymm, ib: VEX.256.66.0F3A.W0 04 /r ib
+                self.emit_avx_rr(0x04, dst.index(), src.index(), VexMap::Map0F3A, VexPP::P66, false, VexL::L256);
+                self.bytes.push(*imm);
+            }
+
             AvxInst::Vzeroupper => {
                 // VZEROUPPER: VEX.128.0F.WIG 77
-                self.emit_vex2(true, 0xF, VexL::L128, VexPP::None);
+                self.emit_vex2(true, NO_VVVV, VexL::L128, VexPP::None);
                 self.bytes.push(0x77);
             }
         }
@@ -603,6 +1155,152 @@ mod tests {
         assert!(emitter.len() > 15); // should be multiple instructions
     }
 
+    #[test]
+    fn test_exact_encodings() {
+        // Bytes checked against GNU as
+        let cases: Vec<(AvxInst, &[u8])> = vec![
+            (AvxInst::Vzeroupper, &[0xC5, 0xF8, 0x77]),
+            (
+                AvxInst::Vaddps { dst: YmmReg(0), src1: YmmReg(0), src2: YmmReg(1) },
+                &[0xC5, 0xFC, 0x58, 0xC1],
+            ),
+            (
+                AvxInst::VmovapsLoad { dst: YmmReg(0), base: 5, disp: -32 },
+                &[0xC5, 0xFC, 0x28, 0x45, 0xE0],
+            ),
+            (
+                AvxInst::Vfmadd231ps { dst: YmmReg(0), src1: YmmReg(1), src2: YmmReg(2) },
+                &[0xC4, 0xE2, 0x75, 0xB8, 0xC2],
+            ),
+            (
+                AvxInst::VmovdquLoad { dst: YmmReg(1), mem: VexMem::indexed(8, 1, 4, 0) },
+                &[0xC4, 0xC1, 0x7E, 0x6F, 0x0C, 0x88],
+            ),
+            (
+                AvxInst::VmovdquStore { src: YmmReg(2), mem: VexMem::indexed(11, 1, 1, 64) },
+                &[0xC4, 0xC1, 0x7E, 0x7F, 0x54, 0x0B, 0x40],
+            ),
+            (
+                AvxInst::VmovdqaLoad { dst: YmmReg(1), mem: VexMem::indexed(8, 1, 4, 0) },
+                &[0xC4, 0xC1, 0x7D, 0x6F, 0x0C, 0x88],
+            ),
+            (
+                AvxInst::VmovdqaStore { src: YmmReg(2), mem: VexMem::indexed(11, 1, 1, 64) },
+                &[0xC4, 0xC1, 0x7D, 0x7F, 0x54, 0x0B, 0x40],
+            ),
+            (
+                AvxInst::Vpadd { lane: 4, dst: YmmReg(3), src1: YmmReg(1), src2: YmmReg(2) },
+                &[0xC5, 0xF5, 0xFE, 0xDA],
+            ),
+            (
+                AvxInst::Vpmull { lane: 4, dst: YmmReg(0), src1: YmmReg(0), src2: YmmReg(5) },
+                &[0xC4, 0xE2, 0x7D, 0x40, 0xC5],
+            ),
+            (AvxInst::VmovqFromGp { dst: YmmReg(4), src: 0 }, &[0xC4, 0xE1, 0xF9, 0x6E, 0xE0]),
+            (
+                AvxInst::Vpbroadcast { lane: 4, dst: YmmReg(4), src: YmmReg(4) },
+                &[0xC4, 0xE2, 0x7D, 0x58, 0xE4],
+            ),
+            (
+                AvxInst::Vpcmpeqb { dst: YmmReg(0), src1: YmmReg(1), src2: YmmReg(2) },
+                &[0xC5, 0xF5, 0x74, 0xC2],
+            ),
+            (AvxInst::Vpmovmskb { dst: 0, src: YmmReg(1) }, &[0xC5, 0xFD, 0xD7, 0xC1]),
+            (AvxInst::Vpmovmskb { dst: 10, src: YmmReg(9) }, &[0xC4, 0x41, 0x7D, 0xD7, 0xD1]),
+            (AvxInst::VmovapsReg { dst: YmmReg(3), src: YmmReg(1) }, &[0xC5, 0xFC, 0x28, 0xD9]),
+            (
+                AvxInst::Vfp { op: FpOp::Mul, double: true, dst: YmmReg(1), src1: YmmReg(2), src2: YmmReg(3) },
+                &[0xC5, 0xED, 0x59, 0xCB],
+            ),
+            (
+                AvxInst::Vfp { op: FpOp::Andn, double: false, dst: YmmReg(0), src1: YmmReg(5), src2: YmmReg(4) },
+                &[0xC5, 0xD4, 0x55, 0xC4],
+            ),
+            (
+                AvxInst::VfpMem { op: FpOp::Max, double: false, dst: YmmReg(2), src1: YmmReg(2), mem: VexMem::base(0, 96) },
+                &[0xC5, 0xEC, 0x5F, 0x50, 0x60],
+            ),
+            (
+                AvxInst::VfpMem { op: FpOp::Sub, double: true, dst: YmmReg(9), src1: YmmReg(1), mem: VexMem::base(0, 0x200) },
+                &[0xC5, 0x75, 0x5C, 0x88, 0x00, 0x02, 0x00, 0x00],
+            ),
+            (AvxInst::Vsqrt { double: true, dst: YmmReg(0), src: YmmReg(1) }, &[0xC5, 0xFD, 0x51, 0xC1]),
+            (
+                AvxInst::Vround { double: false, dst: YmmReg(1), src: YmmReg(0), mode: 1 },
+                &[0xC4, 0xE3, 0x7D, 0x08, 0xC8, 0x01],
+            ),
+            (
+                AvxInst::VcmpMem { double: false, pred: 9, dst: YmmReg(3), src1: YmmReg(0), mem: VexMem::base(0, 32) },
+                &[0xC5, 0xFC, 0xC2, 0x58, 0x20, 0x09],
+            ),
+            (
+                AvxInst::Vcmp { double: true, pred: 0, dst: YmmReg(3), src1: YmmReg(0), src2: YmmReg(4) },
+                &[0xC5, 0xFD, 0xC2, 0xDC, 0x00],
+            ),
+            (
+                AvxInst::Vblendv { double: false, dst: YmmReg(0), src1: YmmReg(1), src2: YmmReg(2), mask: YmmReg(3) },
+                &[0xC4, 0xE3, 0x75, 0x4A, 0xC2, 0x30],
+            ),
+            (
+                AvxInst::Vblendv { double: true, dst: YmmReg(5), src1: YmmReg(4), src2: YmmReg(1), mask: YmmReg(2) },
+                &[0xC4, 0xE3, 0x5D, 0x4B, 0xE9, 0x20],
+            ),
+            (
+                AvxInst::VpshiftImm { lane: 4, left: true, dst: YmmReg(1), src: YmmReg(2), imm: 23 },
+                &[0xC5, 0xF5, 0x72, 0xF2, 0x17],
+            ),
+            (
+                AvxInst::VpshiftImm { lane: 8, left: false, dst: YmmReg(3), src: YmmReg(3), imm: 52 },
+                &[0xC5, 0xE5, 0x73, 0xD3, 0x34],
+            ),
+            (
+                AvxInst::VpshiftImm { lane: 8, left: true, dst: YmmReg(0), src: YmmReg(9), imm: 61 },
+                &[0xC4, 0xC1, 0x7D, 0x73, 0xF1, 0x3D],
+            ),
+            (AvxInst::Vcvtps2pd { dst: YmmReg(1), src: YmmReg(0) }, &[0xC5, 0xFC, 0x5A, 0xC8]),
+            (AvxInst::Vcvtpd2ps { dst: YmmReg(2), src: YmmReg(3) }, &[0xC5, 0xFD, 0x5A, 0xD3]),
+            (AvxInst::Vextractf128 { dst: YmmReg(1), src: YmmReg(0) }, &[0xC4, 0xE3, 0x7D, 0x19, 0xC1, 0x01]),
+            (
+                AvxInst::Vinsertf128 { dst: YmmReg(0), src1: YmmReg(2), src2: YmmReg(1) },
+                &[0xC4, 0xE3, 0x6D, 0x18, 0xC1, 0x01],
+            ),
+        ];
+        for (inst, expected) in cases {
+            let mut emitter = VexEmitter::new();
+            emitter.emit(&inst);
+            assert_eq!(emitter.bytes(), expected, "{}", inst);
+        }
+    }
+
+    #[test]
+    fn test_dense_kernel_encodings() {
+        let cases: Vec<(AvxInst, &[u8])> = vec![
+            (AvxInst::Vbroadcastss { dst: YmmReg(0), mem: VexMem::base(7, 0) }, &[0xC4, 0xE2, 0x7D, 0x18, 0x07]),
+            (
+                AvxInst::Vbroadcastss { dst: YmmReg(14), mem: VexMem::base(8, 20) },
+                &[0xC4, 0x42, 0x7D, 0x18, 0x70, 0x14],
+            ),
+            (
+                AvxInst::Vfmadd231psMem { dst: YmmReg(0), src1: YmmReg(1), mem: VexMem::base(7, 0) },
+                &[0xC4, 0xE2, 0x75, 0xB8, 0x07],
+            ),
+            (
+                AvxInst::VmaskmovpsLoad { dst: YmmReg(0), mask: YmmReg(1), mem: VexMem::base(7, 0) },
+                &[0xC4, 0xE2, 0x75, 0x2C, 0x07],
+            ),
+            (
+                AvxInst::VmaskmovpsStore { src: YmmReg(0), mask: YmmReg(15), mem: VexMem::indexed(2, 0, 1, 32) },
+                &[0xC4, 0xE2, 0x05, 0x2E, 0x44, 0x02, 0x20],
+            ),
+            (AvxInst::Vpermilps { dst: YmmReg(1), src: YmmReg(0), imm: 0x4E }, &[0xC4, 0xE3, 0x7D, 0x04, 0xC8, 0x4E]),
+        ];
+        for (inst, expected) in cases {
+            let mut emitter = VexEmitter::new();
+            emitter.emit(&inst);
+            assert_eq!(emitter.bytes(), expected, "{}", inst);
+        }
+    }
+
     #[test]
     fn test_high_ymm_register() {
         let mut emitter = VexEmitter::new();
@@ -15,6 +15,7 @@
 // ├── validate.rs           ← Validation layer (compiler → PE)
 // ├── flat_binary.rs        ← Raw binary output (boot sectors)
 // ├── elf.rs                ← ELF output (stub)
+// ├── exports.rs            ← Export tables (.edata, .gnu.hash)
 // └── po.rs                 ← .Po output (FastOS format)
 //
 // Pipeline:
@@ -38,10 +39,12 @@ pub mod frontend {
 
 // ── Extracted modules (each in its own file) ──
 pub mod iat_registry;
+pub mod import_hints;
 pub mod pe;
 pub mod validate;
 pub mod flat_binary;
 pub mod elf;
+pub mod exports;
 pub mod po;
 
 // ── Backward-compatible re-export ──
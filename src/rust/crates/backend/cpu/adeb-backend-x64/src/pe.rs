@@ -6,10 +6,16 @@
 //   - Generate valid PE/COFF executables for Windows x64
 //   - Patch IAT call offsets and string addresses
 //   - Build .text + .idata sections
+//   - Re-lay out the .text of an existing image (post-link, see
+//     isa/post_link.rs)
+//   - With -g: DWARF .debug_* sections and a COFF symbol table (see
+//     isa/debug_info.rs)
 //
 // ============================================================
 
-use crate::iat_registry;
+use crate::iat_registry::{self, DelayImport, ImportOptions};
+use crate::isa::debug_info::{CoffStrings, DebugInfo};
+use crate::isa::post_link::{self, BranchProfile, PostLinkStats};
 
 fn align_up_u32(v: u32, a: u32) -> u32 {
     if a == 0 {
@@ -25,16 +31,44 @@ fn align_up_usize(v: usize, a: usize) -> usize {
     (v + (a - 1)) & !(a - 1)
 }
 
-fn push_u16(buf: &mut Vec<u8>, v: u16) {
-    buf.extend_from_slice(&v.to_le_bytes());
+/// Output image allocated once at its final size. Headers and sections
+/// are written in place at their file offsets, so the whole PE never
+/// lives in more than one buffer.
+struct ImageWriter {
+    buf: Vec<u8>,
+    pos: usize,
 }
 
-fn push_u32(buf: &mut Vec<u8>, v: u32) {
-    buf.extend_from_slice(&v.to_le_bytes());
-}
+impl ImageWriter {
+    fn with_len(len: usize) -> Self {
+        Self { buf: vec![0u8; len], pos: 0 }
+    }
 
-fn push_u64(buf: &mut Vec<u8>, v: u64) {
-    buf.extend_from_slice(&v.to_le_bytes());
+    fn seek(&mut self, pos: usize) {
+        self.pos = pos;
+    }
+
+    fn put_bytes(&mut self, bytes: &[u8]) {
+        self.buf[self.pos..self.pos + bytes.len()].copy_from_slice(bytes);
+        self.pos += bytes.len();
+    }
+
+    fn put_u16(&mut self, v: u16) {
+        self.put_bytes(&v.to_le_bytes());
+    }
+
+    fn put_u32(&mut self, v: u32) {
+        self.put_bytes(&v.to_le_bytes());
+    }
+
+    fn put_u64(&mut self, v: u64) {
+        self.put_bytes(&v.to_le_bytes());
+    }
+
+    fn fill(&mut self, len: usize, byte: u8) {
+        self.buf[self.pos..self.pos + len].fill(byte);
+        self.pos += len;
+    }
 }
 
 /// The assumed idata_rva that the ISA compiler uses during code generation.
@@ -59,192 +93,723 @@ pub fn generate_pe_filtered(
     string_imm64_offsets: &[usize],
     used_iat_slots: &std::collections::HashSet<usize>,
 ) -> Result<(), Box<dyn std::error::Error>> {
+    generate_pe_with_imports(
+        code,
+        data,
+        output_path,
+        iat_call_offsets,
+        string_imm64_offsets,
+        used_iat_slots,
+        &ImportOptions::default(),
+        None,
+    )
+}
+
+/// `generate_pe_filtered` with loader hints and delay-loaded DLLs, plus
+/// symbols and line tables when `debug` is given (-g)
+pub fn generate_pe_with_imports(
+    code: &[u8],
+    data: &[u8],
+    output_path: &str,
+    iat_call_offsets: &[usize],
+    string_imm64_offsets: &[usize],
+    used_iat_slots: &std::collections::HashSet<usize>,
+    imports: &ImportOptions,
+    debug: Option<&DebugInfo>,
+) -> Result<(), Box<dyn std::error::Error>> {
+    let image = build_pe_image_with_debug(code, data, iat_call_offsets, string_imm64_offsets, used_iat_slots, imports, debug)?;
+    std::fs::write(output_path, &image)?;
+    Ok(())
+}
+
+/// Size of one delay-load resolver stub (see `delay_stub`)
+pub const DELAY_STUB_SIZE: usize = 98;
+
+/// Resolver for a delay-loaded import, placed after the code in .text.
+/// Saves the argument registers (integer and xmm0-3), calls
+/// LoadLibraryA(dll) + GetProcAddress(h, name), stores the result in the
+/// IAT slot — later calls go straight to the DLL — and tail-jumps to it.
+fn delay_stub(stub_rva: u32, imp: &DelayImport, load_library_rva: u32, get_proc_rva: u32) -> Vec<u8> {
+    let mut s = Vec::with_capacity(DELAY_STUB_SIZE);
+    // disp32 is the last field of every RIP-relative instruction below
+    let rip_rel = |s: &mut Vec<u8>, opcode: &[u8], target: u32| {
+        s.extend_from_slice(opcode);
+        let rip = stub_rva + s.len() as u32 + 4;
+        s.extend_from_slice(&(target.wrapping_sub(rip) as i32).to_le_bytes());
+    };
+    s.extend_from_slice(&[0x51, 0x52, 0x41, 0x50, 0x41, 0x51]); // push rcx, rdx, r8, r9
+    s.extend_from_slice(&[0x48, 0x83, 0xEC, 0x68]); // sub rsp, 0x68 (shadow + 4 xmm, 16-aligned)
+    for modrm in [0x44, 0x4C, 0x54, 0x5C] {
+        let disp = 0x20 + (modrm - 0x44) * 2;
+        s.extend_from_slice(&[0x0F, 0x11, modrm, 0x24, disp]); // movups [rsp+disp], xmmN
+    }
+    rip_rel(&mut s, &[0x48, 0x8D, 0x0D], imp.dll_name_rva); // lea rcx, [dll]
+    rip_rel(&mut s, &[0xFF, 0x15], load_library_rva); // call [LoadLibraryA]
+    s.extend_from_slice(&[0x48, 0x89, 0xC1]); // mov rcx, rax
+    rip_rel(&mut s, &[0x48, 0x8D, 0x15], imp.name_rva); // lea rdx, [name]
+    rip_rel(&mut s, &[0xFF, 0x15], get_proc_rva); // call [GetProcAddress]
+    rip_rel(&mut s, &[0x48, 0x89, 0x05], imp.iat_rva); // mov [slot], rax
+    for modrm in [0x44, 0x4C, 0x54, 0x5C] {
+        let disp = 0x20 + (modrm - 0x44) * 2;
+        s.extend_from_slice(&[0x0F, 0x10, modrm, 0x24, disp]); // movups xmmN, [rsp+disp]
+    }
+    s.extend_from_slice(&[0x48, 0x83, 0xC4, 0x68]); // add rsp, 0x68
+    s.extend_from_slice(&[0x41, 0x59, 0x41, 0x58, 0x5A, 0x59]); // pop r9, r8, rdx, rcx
+    s.extend_from_slice(&[0xFF, 0xE0]); // jmp rax
+    debug_assert_eq!(s.len(), DELAY_STUB_SIZE);
+    s
+}
+
+/// Builds the PE image in memory. The full layout (section RVAs, raw
+/// pointers, final file size) is computed before anything is written;
+/// the image is then allocated once and filled in place.
+pub fn build_pe_image(
+    code: &[u8],
+    data: &[u8],
+    iat_call_offsets: &[usize],
+    string_imm64_offsets: &[usize],
+    used_iat_slots: &std::collections::HashSet<usize>,
+    imports: &ImportOptions,
+) -> Result<Vec<u8>, Box<dyn std::error::Error>> {
+    build_pe_image_with_debug(code, data, iat_call_offsets, string_imm64_offsets, used_iat_slots, imports, None)
+}
+
+/// `build_pe_image` plus, with `debug`, the DWARF sections after .idata
+/// (discardable: mapped but never touched) and a COFF symbol table with
+/// one symbol per function at the end of the file, where profilers and
+/// debuggers look for them
+pub fn build_pe_image_with_debug(
+    code: &[u8],
+    data: &[u8],
+    iat_call_offsets: &[usize],
+    string_imm64_offsets: &[usize],
+    used_iat_slots: &std::collections::HashSet<usize>,
+    imports: &ImportOptions,
+    debug: Option<&DebugInfo>,
+) -> Result<Vec<u8>, Box<dyn std::error::Error>> {
     let file_alignment: u32 = 0x200;
     let section_alignment: u32 = 0x1000;
 
     let image_base: u64 = 0x0000000140000000;
     let text_rva: u32 = 0x1000;
 
+    // Delay-load resolver stubs go after the code, 16-aligned
+    let delayed = iat_registry::delay_load_slots(used_iat_slots, imports).len();
+    let stubs_start = if delayed > 0 { align_up_usize(code.len(), 16) } else { code.len() };
+    let text_len = stubs_start + delayed * DELAY_STUB_SIZE;
+
     // Dynamic idata_rva: place .idata after .text's virtual pages
-    let text_virtual_pages = align_up_u32(code.len() as u32, section_alignment);
+    let text_virtual_pages = align_up_u32(text_len as u32, section_alignment);
     let idata_rva: u32 = text_rva + text_virtual_pages.max(section_alignment);
 
-    let idata_result = iat_registry::build_idata_filtered(idata_rva, used_iat_slots);
-    let mut idata = idata_result.bytes;
-    if idata.len() != idata_result.program_strings_offset as usize {
-        idata.resize(idata_result.program_strings_offset as usize, 0);
-    }
-    idata.extend_from_slice(data);
-
-    // Patch code bytes when idata_rva differs from the assumed value
-    let mut code = code.to_vec();
-    let rva_delta = idata_rva as i64 - ASSUMED_IDATA_RVA as i64;
-    if rva_delta != 0 {
-        // Patch IAT call offsets: each is a RIP-relative disp32 (FF 15 [disp32])
-        // The disp32 encodes (iat_rva - current_rip), so we adjust by the delta
-        for &off in iat_call_offsets {
-            if off + 4 <= code.len() {
-                let old_disp = i32::from_le_bytes([
-                    code[off], code[off + 1], code[off + 2], code[off + 3],
-                ]);
-                let new_disp = old_disp + rva_delta as i32;
-                code[off..off + 4].copy_from_slice(&new_disp.to_le_bytes());
-            }
-        }
-
-        // Patch string imm64 offsets: each is an absolute address (imagebase + idata_rva + string_offset)
-        // Shift by the RVA delta
-        for &off in string_imm64_offsets {
-            if off + 8 <= code.len() {
-                let old_addr = u64::from_le_bytes([
-                    code[off], code[off + 1], code[off + 2], code[off + 3],
-                    code[off + 4], code[off + 5], code[off + 6], code[off + 7],
-                ]);
-                let new_addr = (old_addr as i64 + rva_delta) as u64;
-                code[off..off + 8].copy_from_slice(&new_addr.to_le_bytes());
-            }
+    let idata_result = iat_registry::build_idata_with(idata_rva, used_iat_slots, imports);
+    // .idata = import tables (padded/truncated to program_strings_offset) + program data
+    let strings_offset = idata_result.program_strings_offset as usize;
+    let import_len = idata_result.bytes.len().min(strings_offset);
+
+    // ---- Layout ----
+    let text_virtual_size = text_len as u32;
+    let idata_virtual_size = (strings_offset + data.len()) as u32;
+
+    let text_raw_size = align_up_u32(text_virtual_size, file_alignment);
+    let idata_raw_size = align_up_u32(idata_virtual_size, file_alignment);
+
+    // Long section names live in the COFF string table as "/offset"
+    let mut strings = CoffStrings::new();
+    let debug_sections: Vec<([u8; 8], Vec<u8>)> = match debug {
+        Some(info) => {
+            let dwarf = info.dwarf(image_base + text_rva as u64);
+            vec![
+                (strings.section_name(".debug_abbrev"), dwarf.abbrev),
+                (strings.section_name(".debug_info"), dwarf.info),
+                (strings.section_name(".debug_line"), dwarf.line),
+            ]
         }
-    }
-
-    let text_raw_size = align_up_u32(code.len() as u32, file_alignment);
-    let idata_raw_size = align_up_u32(idata.len() as u32, file_alignment);
+        None => Vec::new(),
+    };
+    let number_of_sections = 2 + debug_sections.len() as u16;
+    let size_of_optional_header: u16 = 0xF0;
 
-    let headers_size = 0x200u32;
+    let e_lfanew: u32 = 0x80;
+    let section_table = e_lfanew + 24 + size_of_optional_header as u32;
+    let headers_size = align_up_u32(section_table + 40 * number_of_sections as u32, file_alignment);
     let text_raw_ptr = headers_size;
     let idata_raw_ptr = text_raw_ptr + text_raw_size;
 
-    let text_virtual_size = code.len() as u32;
-    let idata_virtual_size = idata.len() as u32;
-
-    let size_of_image = align_up_u32(idata_rva + idata_virtual_size, section_alignment);
+    // (RVA, PointerToRawData, SizeOfRawData) of each debug section
+    let mut next_rva = align_up_u32(idata_rva + idata_virtual_size, section_alignment);
+    let mut next_raw = idata_raw_ptr + idata_raw_size;
+    let mut debug_layout = Vec::with_capacity(debug_sections.len());
+    for (_, bytes) in &debug_sections {
+        let raw_size = align_up_u32(bytes.len() as u32, file_alignment);
+        debug_layout.push((next_rva, next_raw, raw_size));
+        next_rva += align_up_u32(bytes.len() as u32, section_alignment);
+        next_raw += raw_size;
+    }
+    let symbols = debug.map(|info| info.coff_symbols(1, &mut strings)).unwrap_or_default();
+    let number_of_symbols = (symbols.len() / 18) as u32;
+    let symbol_table_ptr = if debug.is_some() { next_raw } else { 0 };
+    let strings = strings.finish();
+    let file_end = match debug {
+        Some(_) => next_raw as usize + symbols.len() + strings.len(),
+        None => next_raw as usize,
+    };
+
+    let size_of_image = next_rva;
     let size_of_headers = headers_size;
+    let initialized_data_size = next_raw - idata_raw_ptr;
+    let file_size = align_up_usize(file_end, file_alignment as usize);
 
-    let e_lfanew: u32 = 0x80;
-    let mut dos = vec![0u8; e_lfanew as usize];
-    dos[0..2].copy_from_slice(b"MZ");
-    dos[0x3C..0x40].copy_from_slice(&e_lfanew.to_le_bytes());
+    let mut w = ImageWriter::with_len(file_size);
+
+    // ---- Headers ----
+    w.put_bytes(b"MZ");
+    w.seek(0x3C);
+    w.put_u32(e_lfanew);
+    w.seek(e_lfanew as usize);
 
-    let number_of_sections: u16 = 2;
-    let size_of_optional_header: u16 = 0xF0;
     let characteristics: u16 = 0x0022;
 
-    let mut headers = Vec::new();
-    headers.extend_from_slice(&dos);
-    headers.extend_from_slice(b"PE\0\0");
-
-    push_u16(&mut headers, 0x8664);
-    push_u16(&mut headers, number_of_sections);
-    push_u32(&mut headers, 0);
-    push_u32(&mut headers, 0);
-    push_u32(&mut headers, 0);
-    push_u16(&mut headers, size_of_optional_header);
-    push_u16(&mut headers, characteristics);
-
-    let mut opt = Vec::new();
-    push_u16(&mut opt, 0x20B);
-    opt.push(0);
-    opt.push(0);
-    push_u32(&mut opt, text_raw_size);
-    push_u32(&mut opt, idata_raw_size);
-    push_u32(&mut opt, 0);
-    push_u32(&mut opt, text_rva);
-    push_u32(&mut opt, text_rva);
-    push_u64(&mut opt, image_base);
-    push_u32(&mut opt, section_alignment);
-    push_u32(&mut opt, file_alignment);
-    push_u16(&mut opt, 6);
-    push_u16(&mut opt, 0);
-    push_u16(&mut opt, 0);
-    push_u16(&mut opt, 0);
-    push_u16(&mut opt, 6);
-    push_u16(&mut opt, 0);
-    push_u32(&mut opt, 0);
-    push_u32(&mut opt, size_of_image);
-    push_u32(&mut opt, size_of_headers);
-    push_u32(&mut opt, 0);
-    push_u16(&mut opt, 3);
-    push_u16(&mut opt, 0x8100);
-    push_u64(&mut opt, 0x100000);
-    push_u64(&mut opt, 0x1000);
-    push_u64(&mut opt, 0x100000);
-    push_u64(&mut opt, 0x1000);
-    push_u32(&mut opt, 0);
-    push_u32(&mut opt, 16);
+    w.put_bytes(b"PE\0\0");
+    w.put_u16(0x8664);
+    w.put_u16(number_of_sections);
+    w.put_u32(0);
+    w.put_u32(symbol_table_ptr);
+    w.put_u32(number_of_symbols);
+    w.put_u16(size_of_optional_header);
+    w.put_u16(characteristics);
+
+    let opt_start = w.pos;
+    w.put_u16(0x20B);
+    w.put_bytes(&[0, 0]);
+    w.put_u32(text_raw_size);
+    w.put_u32(initialized_data_size);
+    w.put_u32(0);
+    w.put_u32(text_rva);
+    w.put_u32(text_rva);
+    w.put_u64(image_base);
+    w.put_u32(section_alignment);
+    w.put_u32(file_alignment);
+    w.put_u16(6);
+    w.put_u16(0);
+    w.put_u16(0);
+    w.put_u16(0);
+    w.put_u16(6);
+    w.put_u16(0);
+    w.put_u32(0);
+    w.put_u32(size_of_image);
+    w.put_u32(size_of_headers);
+    w.put_u32(0);
+    w.put_u16(3);
+    w.put_u16(0x8100);
+    w.put_u64(0x100000);
+    w.put_u64(0x1000);
+    w.put_u64(0x100000);
+    w.put_u64(0x1000);
+    w.put_u32(0);
+    w.put_u32(16);
 
     for dir_index in 0..16 {
         if dir_index == 1 {
-            push_u32(&mut opt, idata_result.import_dir_rva);
-            push_u32(&mut opt, idata_result.import_dir_size);
+            w.put_u32(idata_result.import_dir_rva);
+            w.put_u32(idata_result.import_dir_size);
         } else if dir_index == 12 {
-            push_u32(&mut opt, idata_result.iat_rva);
-            push_u32(&mut opt, idata_result.iat_size);
+            w.put_u32(idata_result.iat_rva);
+            w.put_u32(idata_result.iat_size);
         } else {
-            push_u32(&mut opt, 0);
-            push_u32(&mut opt, 0);
+            w.put_u32(0);
+            w.put_u32(0);
         }
     }
 
-    if opt.len() != size_of_optional_header as usize {
+    if w.pos - opt_start != size_of_optional_header as usize {
         return Err(format!(
             "Optional header size mismatch: got {}, expected {}",
-            opt.len(),
+            w.pos - opt_start,
             size_of_optional_header
         )
         .into());
     }
-    headers.extend_from_slice(&opt);
-
-    let mut sh = Vec::new();
 
     let mut name = [0u8; 8];
     name[..5].copy_from_slice(b".text");
-    sh.extend_from_slice(&name);
-    push_u32(&mut sh, text_virtual_size);
-    push_u32(&mut sh, text_rva);
-    push_u32(&mut sh, text_raw_size);
-    push_u32(&mut sh, text_raw_ptr);
-    push_u32(&mut sh, 0);
-    push_u32(&mut sh, 0);
-    push_u16(&mut sh, 0);
-    push_u16(&mut sh, 0);
-    push_u32(&mut sh, 0x60000020);
+    w.put_bytes(&name);
+    w.put_u32(text_virtual_size);
+    w.put_u32(text_rva);
+    w.put_u32(text_raw_size);
+    w.put_u32(text_raw_ptr);
+    w.put_u32(0);
+    w.put_u32(0);
+    w.put_u16(0);
+    w.put_u16(0);
+    w.put_u32(0x60000020);
 
     let mut name2 = [0u8; 8];
     name2[..6].copy_from_slice(b".idata");
-    sh.extend_from_slice(&name2);
-    push_u32(&mut sh, idata_virtual_size);
-    push_u32(&mut sh, idata_rva);
-    push_u32(&mut sh, idata_raw_size);
-    push_u32(&mut sh, idata_raw_ptr);
-    push_u32(&mut sh, 0);
-    push_u32(&mut sh, 0);
-    push_u16(&mut sh, 0);
-    push_u16(&mut sh, 0);
-    push_u32(&mut sh, 0xC0000040);
+    w.put_bytes(&name2);
+    w.put_u32(idata_virtual_size);
+    w.put_u32(idata_rva);
+    w.put_u32(idata_raw_size);
+    w.put_u32(idata_raw_ptr);
+    w.put_u32(0);
+    w.put_u32(0);
+    w.put_u16(0);
+    w.put_u16(0);
+    w.put_u32(0xC0000040);
+
+    for ((name, bytes), &(rva, raw_ptr, raw_size)) in debug_sections.iter().zip(&debug_layout) {
+        w.put_bytes(name);
+        w.put_u32(bytes.len() as u32);
+        w.put_u32(rva);
+        w.put_u32(raw_size);
+        w.put_u32(raw_ptr);
+        w.put_u32(0);
+        w.put_u32(0);
+        w.put_u16(0);
+        w.put_u16(0);
+        w.put_u32(0x42000040); // initialized data, discardable, read
+    }
 
-    headers.extend_from_slice(&sh);
+    if w.pos > headers_size as usize {
+        return Err(format!("PE headers exceed {:#x}", headers_size).into());
+    }
+
+    // ---- .text (NOP padded), patched in place ----
+    w.seek(text_raw_ptr as usize);
+    w.put_bytes(code);
+    w.fill((text_raw_size as usize) - code.len(), 0x90);
 
-    if headers.len() > headers_size as usize {
-        return Err("PE headers exceed 0x200".into());
+    // Patch IAT call offsets: each is a RIP-relative disp32 (FF 15 [disp32])
+    // encoded against the assumed layout, where every function of a DLL
+    // owns a slot. The real IAT only holds the used functions (compacted),
+    // so each call is re-pointed at its slot's actual RVA.
+    let text = &mut w.buf[text_raw_ptr as usize..text_raw_ptr as usize + code.len()];
+    let rva_delta = idata_rva as i64 - ASSUMED_IDATA_RVA as i64;
+    for &off in iat_call_offsets {
+        if let Some(bytes) = text.get_mut(off..off + 4) {
+            let old_disp = i32::from_le_bytes([bytes[0], bytes[1], bytes[2], bytes[3]]);
+            let rip = text_rva as i64 + off as i64 + 4;
+            let assumed_target = (rip + old_disp as i64) as u32;
+            let new_disp = match iat_registry::slot_for_assumed_iat_rva(assumed_target) {
+                Some(slot) => (idata_result.slot_to_iat_rva[slot] as i64 - rip) as i32,
+                // Not a known slot: keep the old relative shift
+                None => old_disp + rva_delta as i32,
+            };
+            bytes.copy_from_slice(&new_disp.to_le_bytes());
+        }
     }
-    headers.resize(headers_size as usize, 0);
 
-    let mut out = Vec::new();
-    out.extend_from_slice(&headers);
+    if rva_delta != 0 {
 
-    let mut text_raw = code;
-    text_raw.resize(text_raw_size as usize, 0x90);
-    out.resize(text_raw_ptr as usize, 0);
-    out.extend_from_slice(&text_raw);
+        // Patch string imm64 offsets: each is an absolute address (imagebase + idata_rva + string_offset)
+        // Shift by the RVA delta
+        for &off in string_imm64_offsets {
+            if let Some(bytes) = text.get_mut(off..off + 8) {
+                let mut old = [0u8; 8];
+                old.copy_from_slice(bytes);
+                let new_addr = (u64::from_le_bytes(old) as i64 + rva_delta) as u64;
+                bytes.copy_from_slice(&new_addr.to_le_bytes());
+            }
+        }
+    }
 
-    let mut idata_raw = idata;
-    idata_raw.resize(idata_raw_size as usize, 0);
-    out.resize(idata_raw_ptr as usize, 0);
-    out.extend_from_slice(&idata_raw);
+    // ---- .idata (zero padded by construction) ----
+    w.seek(idata_raw_ptr as usize);
+    w.put_bytes(&idata_result.bytes[..import_len]);
+    w.seek(idata_raw_ptr as usize + strings_offset);
+    w.put_bytes(data);
 
-    let final_len = align_up_usize(out.len(), file_alignment as usize);
-    out.resize(final_len, 0);
+    // ---- Debug sections, then symbol table + string table ----
+    for ((_, bytes), &(_, raw_ptr, _)) in debug_sections.iter().zip(&debug_layout) {
+        w.seek(raw_ptr as usize);
+        w.put_bytes(bytes);
+    }
+    if debug.is_some() {
+        w.seek(symbol_table_ptr as usize);
+        w.put_bytes(&symbols);
+        w.put_bytes(&strings);
+    }
 
-    std::fs::write(output_path, &out)?;
-    Ok(())
+    // ---- Delay-load stubs; their IAT slots start out pointing at them ----
+    if !idata_result.delay_imports.is_empty() {
+        let loader_rva = |name: &str| {
+            iat_registry::slot_for_function(name).map(|slot| idata_result.slot_to_iat_rva[slot])
+        };
+        let (Some(load_library), Some(get_proc)) = (loader_rva("LoadLibraryA"), loader_rva("GetProcAddress")) else {
+            return Err("delay-load needs LoadLibraryA and GetProcAddress in the registry".into());
+        };
+        for (k, imp) in idata_result.delay_imports.iter().enumerate() {
+            let stub_off = stubs_start + k * DELAY_STUB_SIZE;
+            let stub_rva = text_rva + stub_off as u32;
+            w.seek(text_raw_ptr as usize + stub_off);
+            w.put_bytes(&delay_stub(stub_rva, imp, load_library, get_proc));
+            w.seek(idata_raw_ptr as usize + (imp.iat_rva - idata_rva) as usize);
+            w.put_u64(image_base + stub_rva as u64);
+        }
+    }
+
+    Ok(w.buf)
+}
+
+fn read_u16(b: &[u8], off: usize) -> Option<u16> {
+    Some(u16::from_le_bytes(b.get(off..off + 2)?.try_into().ok()?))
+}
+
+fn read_u32(b: &[u8], off: usize) -> Option<u32> {
+    Some(u32::from_le_bytes(b.get(off..off + 4)?.try_into().ok()?))
+}
+
+fn read_u64(b: &[u8], off: usize) -> Option<u64> {
+    Some(u64::from_le_bytes(b.get(off..off + 8)?.try_into().ok()?))
+}
+
+/// Header fields of a PE32+ image that post-link tools need
+struct PeHeaders {
+    coff: usize,
+    opt: usize,
+    entry_rva: u32,
+    image_base: u64,
+    /// (header offset, VirtualSize, VA, SizeOfRawData, PointerToRawData)
+    sections: Vec<(usize, u32, u32, u32, u32)>,
+}
+
+impl PeHeaders {
+    fn parse(image: &[u8]) -> Result<Self, Box<dyn std::error::Error>> {
+        let malformed = || "malformed PE image";
+        if image.get(0..2) != Some(&b"MZ"[..]) {
+            return Err("not a PE image (missing MZ)".into());
+        }
+        let pe = read_u32(image, 0x3C).ok_or_else(malformed)? as usize;
+        if image.get(pe..pe + 4) != Some(&b"PE\0\0"[..]) {
+            return Err("not a PE image (missing PE signature)".into());
+        }
+        let coff = pe + 4;
+        let num_sections = read_u16(image, coff + 2).ok_or_else(malformed)? as usize;
+        let opt = coff + 20;
+        let opt_size = read_u16(image, coff + 16).ok_or_else(malformed)? as usize;
+        if read_u16(image, opt) != Some(0x20B) {
+            return Err("only PE32+ images are supported".into());
+        }
+        let entry_rva = read_u32(image, opt + 16).ok_or_else(malformed)?;
+        let image_base = read_u64(image, opt + 24).ok_or_else(malformed)?;
+        let sections = (0..num_sections)
+            .map(|i| {
+                let sh = opt + opt_size + i * 40;
+                Some((sh, read_u32(image, sh + 8)?, read_u32(image, sh + 12)?, read_u32(image, sh + 16)?, read_u32(image, sh + 20)?))
+            })
+            .collect::<Option<_>>()
+            .ok_or_else(malformed)?;
+        Ok(Self { coff, opt, entry_rva, image_base, sections })
+    }
+
+    /// Section name, resolving "/N" through the COFF string table
+    fn section_name<'a>(&self, image: &'a [u8], sh: usize) -> Option<&'a [u8]> {
+        let raw = image.get(sh..sh + 8)?;
+        let raw = &raw[..raw.iter().position(|&b| b == 0).unwrap_or(8)];
+        let Some(index) = raw.strip_prefix(b"/") else { return Some(raw) };
+        let index: usize = std::str::from_utf8(index).ok()?.parse().ok()?;
+        let symbols = read_u32(image, self.coff + 8)? as usize;
+        let strings = symbols + read_u32(image, self.coff + 12)? as usize * 18;
+        let name = image.get(strings + index..)?;
+        Some(&name[..name.iter().position(|&b| b == 0)?])
+    }
+
+    /// Raw bytes of the first section called `name`: (VA, bytes)
+    fn section<'a>(&self, image: &'a [u8], name: &str) -> Option<(u32, &'a [u8])> {
+        let &(_, vsize, va, raw_size, raw_ptr) =
+            self.sections.iter().find(|s| self.section_name(image, s.0) == Some(name.as_bytes()))?;
+        let len = if vsize == 0 { raw_size } else { vsize.min(raw_size) };
+        Some((va, image.get(raw_ptr as usize..(raw_ptr + len) as usize)?))
+    }
+}
+
+/// .text of an image plus its -g tables, if it has them
+pub struct ImageText {
+    pub text_va: u64,
+    pub code: Vec<u8>,
+    pub debug: Option<DebugInfo>,
+}
+
+/// Reads .text and the DWARF written by `build_pe_image_with_debug`:
+/// what `adB run --profile` symbolizes samples against
+pub fn read_image_text(image: &[u8]) -> Result<ImageText, Box<dyn std::error::Error>> {
+    let headers = PeHeaders::parse(image)?;
+    let (text_rva, code) = headers.section(image, ".text").ok_or("image has no .text section")?;
+    let text_va = headers.image_base + text_rva as u64;
+    let debug = match (headers.section(image, ".debug_info"), headers.section(image, ".debug_line")) {
+        (Some((_, info)), Some((_, line))) => {
+            let (debug, va) = DebugInfo::from_dwarf(info, line)?;
+            if va != text_va {
+                return Err(format!("DWARF describes code at {:#x}, .text is at {:#x}", va, text_va).into());
+            }
+            Some(debug)
+        }
+        _ => None,
+    };
+    Ok(ImageText { text_va, code: code.to_vec(), debug })
+}
+
+/// Re-lays out .text of a PE32+ image from a sampled branch profile.
+/// The entry point and every IAT slot that points into .text (delay-load
+/// stubs) are entries from outside the code and get re-pointed. Nothing
+/// else moves: the new code must fit in the raw size of .text and before
+/// the next section, and the rest of the image is copied as is.
+pub fn relayout_pe_image(
+    image: &[u8],
+    profile: &BranchProfile,
+) -> Result<(Vec<u8>, PostLinkStats), Box<dyn std::error::Error>> {
+    let malformed = || "malformed PE image";
+    let PeHeaders { opt, entry_rva, image_base, ref sections, .. } = PeHeaders::parse(image)?;
+    let iat_dir = opt + 112 + 12 * 8;
+    let (iat_rva, iat_size) = (
+        read_u32(image, iat_dir).ok_or_else(malformed)?,
+        read_u32(image, iat_dir + 4).ok_or_else(malformed)?,
+    );
+
+    let &(text_sh, text_vsize, text_rva, text_raw_size, text_raw_ptr) = sections
+        .iter()
+        .find(|s| image.get(s.0..s.0 + 8).is_some_and(|n| n.starts_with(b".text\0")))
+        .ok_or("image has no .text section")?;
+    let text_limit = sections.iter().map(|s| s.2).filter(|&va| va > text_rva).min().unwrap_or(u32::MAX);
+    let file_offset = |rva: u32| {
+        sections.iter().find_map(|&(_, vsize, va, raw_size, raw_ptr)| {
+            (va <= rva && rva < va + vsize.max(raw_size)).then(|| (rva - va + raw_ptr) as usize)
+        })
+    };
+    let code = image
+        .get(text_raw_ptr as usize..(text_raw_ptr + text_vsize) as usize)
+        .ok_or_else(malformed)?;
+    let text_va = image_base + text_rva as u64;
+
+    // Entries from outside the code: entry point + IAT slots into .text
+    let entry = (text_rva..text_rva + text_vsize).contains(&entry_rva).then(|| (entry_rva - text_rva) as usize);
+    let mut entries: Vec<usize> = entry.into_iter().collect();
+    let mut stub_slots = Vec::new();
+    for k in 0..iat_size / 8 {
+        let Some(at) = file_offset(iat_rva + k * 8) else { continue };
+        let Some(va) = read_u64(image, at) else { continue };
+        if (text_va..text_va + text_vsize as u64).contains(&va) {
+            entries.push((va - text_va) as usize);
+            stub_slots.push((at, (va - text_va) as usize));
+        }
+    }
+
+    let relaid = post_link::relayout(code, text_va, profile, &entries)?;
+    let new_len = relaid.code.len();
+    if new_len > text_raw_size as usize || text_rva as u64 + new_len as u64 > text_limit as u64 {
+        return Err(format!(
+            "re-laid out .text ({} bytes) does not fit in the section ({} bytes raw)",
+            new_len, text_raw_size
+        )
+        .into());
+    }
+
+    let mut w = ImageWriter { buf: image.to_vec(), pos: text_raw_ptr as usize };
+    w.put_bytes(&relaid.code);
+    w.fill(text_raw_size as usize - new_len, 0x90);
+    w.seek(text_sh + 8);
+    w.put_u32(new_len as u32);
+    if let Some(entry) = entry {
+        w.seek(opt + 16);
+        w.put_u32(text_rva + relaid.new_offset(entry).ok_or("entry point was not placed")? as u32);
+    }
+    for (at, old) in stub_slots {
+        w.seek(at);
+        w.put_u64(text_va + relaid.new_offset(old).ok_or("IAT target was not placed")? as u64);
+    }
+    Ok((w.buf, relaid.stats))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::collections::HashSet;
+
+    fn u32_at(buf: &[u8], off: usize) -> u32 {
+        u32::from_le_bytes([buf[off], buf[off + 1], buf[off + 2], buf[off + 3]])
+    }
+
+    #[test]
+    fn test_pe_image_is_laid_out_in_place() {
+        // 5000 bytes of code push .idata to 0x3000: the IAT disp32 gets patched
+        let code = vec![0xCCu8; 5000];
+        let data = b"hello\0";
+        let image = build_pe_image(&code, data, &[2], &[], &HashSet::new(), &ImportOptions::default()).unwrap();
+
+        assert_eq!(&image[0..2], b"MZ");
+        assert_eq!(&image[0x80..0x84], b"PE\0\0");
+        let sections = 0x80 + 4 + 20 + 0xF0;
+        let (text_raw_size, text_raw_ptr) = (u32_at(&image, sections + 16), u32_at(&image, sections + 20));
+        let idata = sections + 40;
+        let (idata_rva, idata_raw_size, idata_raw_ptr) =
+            (u32_at(&image, idata + 12), u32_at(&image, idata + 16), u32_at(&image, idata + 20));
+
+        assert_eq!((text_raw_ptr, text_raw_size), (0x200, 0x1400));
+        assert_eq!(idata_rva, 0x3000);
+        assert_eq!(idata_raw_ptr, text_raw_ptr + text_raw_size);
+        assert_eq!(image.len(), (idata_raw_ptr + idata_raw_size) as usize);
+
+        let text = &image[text_raw_ptr as usize..(text_raw_ptr + text_raw_size) as usize];
+        assert_eq!(u32_at(text, 2), 0xCCCCCCCCu32.wrapping_add(0x1000));
+        assert!(text[5000..].iter().all(|&b| b == 0x90));
+    }
+
+    /// `call [rip+iat]` at offset 0, encoded against the assumed layout
+    fn call_iat(function: &str) -> (Vec<u8>, usize) {
+        let slot = iat_registry::slot_for_function(function).unwrap();
+        let disp = iat_registry::assumed_iat_rva(slot) as i32 - (0x1000 + 6);
+        let mut code = vec![0xFF, 0x15];
+        code.extend_from_slice(&disp.to_le_bytes());
+        (code, slot)
+    }
+
+    #[test]
+    fn test_iat_calls_follow_compacted_slots() {
+        // malloc is not the first msvcrt function: with only printf and malloc
+        // imported its slot moves to index 1 of the msvcrt IAT
+        let (code, malloc) = call_iat("malloc");
+        let used: HashSet<usize> = [iat_registry::slot_for_function("printf").unwrap(), malloc].into();
+        let image = build_pe_image(&code, &[], &[2], &[], &used, &ImportOptions::default()).unwrap();
+        let idata = iat_registry::build_idata_filtered(0x2000, &used);
+        let target = 0x1006 + i32::from_le_bytes(image[0x202..0x206].try_into().unwrap()) as u32;
+        assert_eq!(target, idata.slot_to_iat_rva[malloc]);
+        assert_eq!(target, idata.slot_to_iat_rva[used.iter().copied().min().unwrap()] + 8);
+    }
+
+    #[test]
+    fn test_delay_loaded_import_starts_at_its_stub() {
+        let (code, d3d_compile) = call_iat("D3DCompile");
+        let used: HashSet<usize> = [d3d_compile].into();
+        let imports = ImportOptions { delay_load: vec!["d3dcompiler_47.dll".into()], ..Default::default() };
+        let image = build_pe_image(&code, &[], &[2], &[], &used, &imports).unwrap();
+
+        let idata = iat_registry::build_idata_with(0x2000, &used, &imports);
+        assert_eq!(idata.delay_imports.len(), 1);
+        // Only kernel32 (LoadLibraryA/GetProcAddress) goes through the loader
+        assert_eq!(idata.import_dir_size, 2 * 20);
+
+        // .text: 6 bytes of code, stub at 16; its VA sits in the IAT slot
+        let stub_rva = 0x1000 + 16;
+        assert_eq!(&image[0x200 + 16..0x200 + 22], &[0x51, 0x52, 0x41, 0x50, 0x41, 0x51]);
+        assert_eq!(&image[0x200 + 16 + DELAY_STUB_SIZE - 2..0x200 + 16 + DELAY_STUB_SIZE], &[0xFF, 0xE0]);
+        let slot_off = 0x400 + (idata.slot_to_iat_rva[d3d_compile] - 0x2000) as usize;
+        let slot_va = u64::from_le_bytes(image[slot_off..slot_off + 8].try_into().unwrap());
+        assert_eq!(slot_va, 0x140000000 + stub_rva as u64);
+
+        // The stub's final store goes to that same slot
+        let store = 0x200 + 16 + 59;
+        assert_eq!(&image[store..store + 3], &[0x48, 0x89, 0x05]);
+        let disp = i32::from_le_bytes(image[store + 3..store + 7].try_into().unwrap());
+        assert_eq!((stub_rva + 59 + 7) as i64 + disp as i64, idata.slot_to_iat_rva[d3d_compile] as i64);
+    }
+
+    #[test]
+    fn test_debug_info_adds_dwarf_sections_and_symbols() {
+        let code = vec![0xC3u8; 0x30];
+        let debug = DebugInfo::build(
+            vec![("main".into(), "app.c".into(), 0x10), ("helper_function".into(), "app.c".into(), 0)],
+            &[(0, 2), (0x10, 7)],
+            code.len(),
+        );
+        let image = build_pe_image_with_debug(&code, &[], &[], &[], &HashSet::new(), &ImportOptions::default(), Some(&debug)).unwrap();
+
+        let coff = 0x84;
+        assert_eq!(u16::from_le_bytes([image[coff + 2], image[coff + 3]]), 5);
+        let sections = coff + 20 + 0xF0;
+        // Five section headers no longer fit in 0x200
+        assert_eq!(u32_at(&image, sections + 20), 0x400);
+        let (symtab, count) = (u32_at(&image, coff + 8) as usize, u32_at(&image, coff + 12) as usize);
+        assert_eq!(count, 2);
+        let strtab = symtab + count * 18;
+
+        // .debug_line: "/N" into the string table, mapped after .idata
+        let line = sections + 4 * 40;
+        let name = std::str::from_utf8(&image[line + 1..line + 8]).unwrap().trim_end_matches('\0');
+        let name_at = strtab + name.parse::<usize>().unwrap();
+        assert!(image[name_at..].starts_with(b".debug_line\0"));
+        assert_eq!(u32_at(&image, line + 36), 0x42000040);
+        let (size, raw_ptr) = (u32_at(&image, line + 8) as usize, u32_at(&image, line + 20) as usize);
+        assert_eq!(&image[raw_ptr..raw_ptr + size], &debug.dwarf(0x140001000).line[..]);
+        let size_of_image = u32_at(&image, 0x98 + 56);
+        assert_eq!(size_of_image, align_up_u32(u32_at(&image, line + 12) + size as u32, 0x1000));
+
+        // Symbols in address order; long names through the string table
+        let first = symtab;
+        assert_eq!(&image[first..first + 4], &[0, 0, 0, 0]);
+        assert!(image[strtab + u32_at(&image, first + 4) as usize..].starts_with(b"helper_function\0"));
+        assert_eq!(&image[first + 18..first + 26], b"main\0\0\0\0");
+        assert_eq!(u32_at(&image, first + 26), 0x10);
+
+        // Without -g the image is unchanged
+        let plain = build_pe_image(&code, &[], &[], &[], &HashSet::new(), &ImportOptions::default()).unwrap();
+        assert_eq!(u32_at(&plain, coff + 8), 0);
+        assert_eq!(u16::from_le_bytes([plain[coff + 2], plain[coff + 3]]), 2);
+    }
+
+    #[test]
+    fn test_read_image_text_recovers_debug_info() {
+        let code = vec![0x90u8; 0x30];
+        let debug = DebugInfo::build(
+            vec![("main".into(), "app.c".into(), 0x10), ("helper_function".into(), "app.c".into(), 0)],
+            &[(0, 2), (0x10, 7)],
+            code.len(),
+        );
+        let image = build_pe_image_with_debug(&code, &[], &[], &[], &HashSet::new(), &ImportOptions::default(), Some(&debug)).unwrap();
+        let text = read_image_text(&image).unwrap();
+        assert_eq!(text.text_va, 0x140001000);
+        assert_eq!(text.code, code);
+        let read = text.debug.unwrap();
+        assert_eq!(read.functions, debug.functions);
+        assert_eq!(read.line_at(0x12), Some(("app.c", 7)));
+
+        let plain = build_pe_image(&code, &[], &[], &[], &HashSet::new(), &ImportOptions::default()).unwrap();
+        assert!(read_image_text(&plain).unwrap().debug.is_none());
+        assert!(read_image_text(b"MZ").is_err());
+    }
+
+    #[test]
+    fn test_relayout_moves_cold_code_and_keeps_imports() {
+        use crate::isa::encoder::Encoder;
+        use crate::isa::{ADeadIR, ADeadOp, Condition, Operand, Reg};
+
+        // if (rcx == 0) return 1; D3DCompile(); — the import call is cold
+        let slot = iat_registry::slot_for_function("D3DCompile").unwrap();
+        let mut ir = ADeadIR::new();
+        let zero = ir.new_label();
+        let ops = vec![
+            ADeadOp::Cmp { left: Operand::Reg(Reg::RCX), right: Operand::Imm32(0) },
+            ADeadOp::Jcc { cond: Condition::Equal, target: zero },
+            ADeadOp::CallIAT { iat_rva: iat_registry::assumed_iat_rva(slot) },
+            ADeadOp::Ret,
+            ADeadOp::Label(zero),
+            ADeadOp::Mov { dst: Operand::Reg(Reg::RAX), src: Operand::Imm32(1) },
+            ADeadOp::Ret,
+        ];
+        let encoded = Encoder::new().encode_all(&ops);
+        let used: HashSet<usize> = [slot].into();
+        let imports = ImportOptions { delay_load: vec!["d3dcompiler_47.dll".into()], ..Default::default() };
+        let image = build_pe_image(&encoded.code, &[], &encoded.iat_call_offsets, &[], &used, &imports).unwrap();
+
+        let text_va = 0x140001000u64;
+        let mut profile = BranchProfile::default();
+        profile.add_taken(text_va + 4, text_va + encoded.label_offsets[&zero.0] as u64, 50);
+        let (out, stats) = relayout_pe_image(&image, &profile).unwrap();
+        assert_eq!(stats.functions, 2);
+        // The import call and the NOP padding before the stub
+        assert_eq!(stats.cold_blocks, 2);
+        assert_eq!(out.len(), image.len());
+        assert_eq!(u32_at(&out, 0x80 + 24 + 16), 0x1000);
+
+        // The call now sits after the hot return and still reaches its slot
+        let idata = iat_registry::build_idata_with(0x2000, &used, &imports);
+        let call = (0x200..0x240).find(|&i| out[i..i + 2] == [0xFF, 0x15]).unwrap();
+        assert!(call > 0x200 + 6);
+        let disp = i32::from_le_bytes(out[call + 2..call + 6].try_into().unwrap());
+        assert_eq!((call - 0x200 + 0x1006) as i64 + disp as i64, idata.slot_to_iat_rva[slot] as i64);
+
+        // The delay-load stub's IAT slot follows the stub
+        let slot_off = 0x400 + (idata.slot_to_iat_rva[slot] - 0x2000) as usize;
+        let stub = u64::from_le_bytes(out[slot_off..slot_off + 8].try_into().unwrap()) - text_va;
+        assert_eq!(&out[0x200 + stub as usize..0x200 + stub as usize + 2], &[0x51, 0x52]);
+    }
 }
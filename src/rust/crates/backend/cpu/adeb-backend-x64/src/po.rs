@@ -2,6 +2,8 @@
 // .Po Output — FastOS format
 // ============================================================
 
+use adeb_platform::po::PoBits;
+
 pub struct PoOutput;
 
 impl PoOutput {
@@ -40,6 +42,19 @@ impl PoOutput {
         std::fs::write(output_path, &bin)?;
         Ok(bin.len())
     }
+
+    /// Po v9: secciones alineadas a página que el loader mapea sin
+    /// copiar; `cold` va comprimida y se descomprime al primer acceso.
+    /// El formato vive en adeb-platform (po.rs).
+    pub fn generate_paged(
+        &self,
+        code: &[u8],
+        data: &[u8],
+        cold: &[u8],
+        output_path: &str,
+    ) -> Result<usize, Box<dyn std::error::Error>> {
+        adeb_platform::po::PoOutput::new().generate_paged(code, data, cold, PoBits::Bits64, 0, 0, output_path)
+    }
 }
 
 impl Default for PoOutput {
@@ -0,0 +1,830 @@
+// ADead-BIB GPU Backend - Autotuning de kernels CUDA generados
+// Kernels MatMul y Reduction parametrizados: cada uno sale de una
+// configuración (tile M/N/K, bloqueo en registros, doble buffer en
+// shared memory, loads float4) y el autotuner mide las variantes
+// válidas para la arquitectura con GpuProfiler.
+//
+// El ganador se guarda por (SM, bucket de forma) en
+// `<ADEB_CACHE_DIR o .adB-cache>/autotune/tuning.db`; una consulta
+// posterior con una forma del mismo bucket lo devuelve sin medir.
+// Es solo biblioteca: ningún camino compilado genera MatMul/Reduction
+// CUDA todavía, así que nadie llama a `matmul_kernel`,
+// `reduction_kernel` ni al `Autotuner` fuera de este módulo.
+// Bucket = log2 redondeado hacia arriba de cada dimensión + si admite
+// loads vectoriales (N y K múltiplos de 4).
+//
+// Autor: Eddi Andreé Salazar Matos
+
+use super::cudead::cuda_driver::{CUcontext, CUdeviceptr, CudaDriverApi, NvrtcApi};
+use super::cudead::cuda_driver::attrib::{
+    CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR,
+};
+use super::cudead::GpuArch;
+use super::metrics::GpuProfiler;
+use adeb_core::cache::objects::ObjectCache;
+use std::collections::BTreeMap;
+use std::ffi::c_void;
+use std::io;
+use std::path::{Path, PathBuf};
+
+/// Versión del formato de tuning.db; otra versión se ignora
+pub const TUNING_VERSION: u32 = 1;
+
+/// Variantes medidas como máximo por forma (el espacio se muestrea)
+pub const DEFAULT_MAX_CANDIDATES: usize = 64;
+
+/// Límite de shared memory estática por bloque (sin opt-in dinámico)
+const STATIC_SHARED_BYTES: u32 = 48 * 1024;
+
+// ============================================================================
+// CONFIGURACIONES
+// ============================================================================
+
+/// Parámetros de un kernel MatMul
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct MatmulConfig {
+    /// Tile del bloque (filas de C, columnas de C, paso de K)
+    pub tile_m: u32,
+    pub tile_n: u32,
+    pub tile_k: u32,
+    /// Bloqueo en registros: cada hilo calcula thread_m × thread_n
+    pub thread_m: u32,
+    pub thread_n: u32,
+    /// 2 = doble buffer (carga el tile t+1 mientras calcula el t)
+    pub stages: u32,
+    /// 4 = loads float4 (necesita N y K múltiplos de 4)
+    pub vector_width: u32,
+}
+
+impl MatmulConfig {
+    /// Punto de partida sin tuning: 64×64×16, 4×4 por hilo, doble buffer
+    pub fn default_for(arch: GpuArch, n: usize, k: usize) -> Self {
+        let cfg = MatmulConfig {
+            tile_m: 64,
+            tile_n: 64,
+            tile_k: 16,
+            thread_m: 4,
+            thread_n: 4,
+            stages: 2,
+            vector_width: if vector_aligned(n, k) { 4 } else { 1 },
+        };
+        debug_assert!(cfg.is_valid(arch));
+        cfg
+    }
+
+    pub fn threads(&self) -> u32 {
+        (self.tile_m / self.thread_m) * (self.tile_n / self.thread_n)
+    }
+
+    pub fn shared_bytes(&self) -> u32 {
+        self.stages * self.tile_k * (self.tile_m + self.tile_n) * 4
+    }
+
+    /// Cabe en la arquitectura (hilos, shared memory)
+    pub fn is_valid(&self, arch: GpuArch) -> bool {
+        let threads = self.threads();
+        self.tile_m % self.thread_m == 0
+            && self.tile_n % self.thread_n == 0
+            && (64..=256).contains(&threads)
+            && threads <= arch.max_threads_per_block()
+            && self.shared_bytes() <= STATIC_SHARED_BYTES.min(arch.max_shared_memory())
+            && matches!(self.stages, 1 | 2)
+            && match self.vector_width {
+                1 => true,
+                4 => self.tile_k % 4 == 0 && self.tile_n % 4 == 0,
+                _ => false,
+            }
+    }
+
+    /// ¿Sirve para esta forma? (float4 necesita filas alineadas)
+    pub fn supports(&self, n: usize, k: usize) -> bool {
+        self.vector_width == 1 || vector_aligned(n, k)
+    }
+
+    /// Espacio de búsqueda para (arch, forma)
+    pub fn space(arch: GpuArch, m: usize, n: usize, k: usize) -> Vec<Self> {
+        let vectors: &[u32] = if vector_aligned(n, k) { &[1, 4] } else { &[1] };
+        let mut space = Vec::new();
+        for tile_m in [32, 64, 128] {
+            for tile_n in [32, 64, 128] {
+                // Un tile mucho más grande que la matriz solo gasta hilos
+                if tile_m as usize > m.next_power_of_two().max(32) || tile_n as usize > n.next_power_of_two().max(32) {
+                    continue;
+                }
+                for tile_k in [8, 16, 32] {
+                    for (thread_m, thread_n) in [(4, 4), (4, 8), (8, 4), (8, 8)] {
+                        for stages in [1, 2] {
+                            for &vector_width in vectors {
+                                let cfg = MatmulConfig { tile_m, tile_n, tile_k, thread_m, thread_n, stages, vector_width };
+                                if cfg.is_valid(arch) {
+                                    space.push(cfg);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        space
+    }
+
+    fn encode(&self) -> String {
+        format!(
+            "{} {} {} {} {} {} {}",
+            self.tile_m, self.tile_n, self.tile_k, self.thread_m, self.thread_n, self.stages, self.vector_width
+        )
+    }
+
+    fn decode(fields: &[&str]) -> Option<Self> {
+        let v: Vec<u32> = fields.iter().map(|f| f.parse().ok()).collect::<Option<_>>()?;
+        match v[..] {
+            [tile_m, tile_n, tile_k, thread_m, thread_n, stages, vector_width] => {
+                Some(MatmulConfig { tile_m, tile_n, tile_k, thread_m, thread_n, stages, vector_width })
+            }
+            _ => None,
+        }
+    }
+}
+
+/// Parámetros de un kernel Reduction (suma)
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct ReductionConfig {
+    /// Hilos por bloque
+    pub block: u32,
+    /// Loads por hilo antes de la reducción por warps
+    pub items_per_thread: u32,
+    /// 4 = loads float4
+    pub vector_width: u32,
+}
+
+impl ReductionConfig {
+    /// Sin tuning: 256 hilos × 4 float4
+    pub fn default_for(_arch: GpuArch) -> Self {
+        ReductionConfig { block: 256, items_per_thread: 4, vector_width: 4 }
+    }
+
+    /// Elementos que consume un bloque
+    pub fn elements_per_block(&self) -> usize {
+        (self.block * self.items_per_thread * self.vector_width) as usize
+    }
+
+    pub fn is_valid(&self, arch: GpuArch) -> bool {
+        self.block % arch.warp_size() == 0
+            && self.block <= arch.max_threads_per_block()
+            && self.items_per_thread >= 1
+            && matches!(self.vector_width, 1 | 4)
+    }
+
+    pub fn space(arch: GpuArch, size: usize) -> Vec<Self> {
+        let mut space = Vec::new();
+        for block in [128, 256, 512, 1024] {
+            for items_per_thread in [1, 2, 4, 8] {
+                for vector_width in [1, 4] {
+                    let cfg = ReductionConfig { block, items_per_thread, vector_width };
+                    // Más de un bloque de sobra ya no reparte trabajo
+                    let wasteful = cfg.elements_per_block() > size.next_power_of_two() && block > 128;
+                    if cfg.is_valid(arch) && !wasteful {
+                        space.push(cfg);
+                    }
+                }
+            }
+        }
+        space
+    }
+
+    fn encode(&self) -> String {
+        format!("{} {} {}", self.block, self.items_per_thread, self.vector_width)
+    }
+
+    fn decode(fields: &[&str]) -> Option<Self> {
+        let v: Vec<u32> = fields.iter().map(|f| f.parse().ok()).collect::<Option<_>>()?;
+        match v[..] {
+            [block, items_per_thread, vector_width] => Some(ReductionConfig { block, items_per_thread, vector_width }),
+            _ => None,
+        }
+    }
+}
+
+fn vector_aligned(n: usize, k: usize) -> bool {
+    n % 4 == 0 && k % 4 == 0
+}
+
+fn log2_ceil(x: usize) -> u32 {
+    x.max(1).next_power_of_two().trailing_zeros()
+}
+
+/// Bucket de forma de un MatMul: "mm<m>x<n>x<k>{a|u}" en log2
+pub fn matmul_bucket(m: usize, n: usize, k: usize) -> String {
+    let align = if vector_aligned(n, k) { 'a' } else { 'u' };
+    format!("mm{}x{}x{}{}", log2_ceil(m), log2_ceil(n), log2_ceil(k), align)
+}
+
+/// Bucket de forma de una Reduction: "sum<n>" en log2
+pub fn reduction_bucket(size: usize) -> String {
+    format!("sum{}", log2_ceil(size))
+}
+
+fn arch_key(arch: GpuArch) -> String {
+    let (major, minor) = arch.sm_version();
+    format!("sm{}{}", major, minor)
+}
+
+// ============================================================================
+// GENERADORES
+// ============================================================================
+
+/// Un kernel listo para compilar con NVRTC y lanzar
+#[derive(Debug, Clone)]
+pub struct GeneratedKernel {
+    pub source: String,
+    pub entry: &'static str,
+    pub grid: (u32, u32, u32),
+    pub block: (u32, u32, u32),
+    pub problem: Problem,
+}
+
+/// Forma del problema (para reservar buffers y contar trabajo)
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Problem {
+    MatMul { m: usize, n: usize, k: usize },
+    Reduction { size: usize },
+}
+
+impl Problem {
+    /// (flops, bytes movidos) para GpuProfiler
+    pub fn work(&self) -> (u64, u64) {
+        match *self {
+            Problem::MatMul { m, n, k } => ((2 * m * n * k) as u64, (4 * (m * k + k * n + m * n)) as u64),
+            Problem::Reduction { size } => (size as u64, 4 * size as u64),
+        }
+    }
+}
+
+const MATMUL_BODY: &str = r#"
+__device__ __forceinline__ void load_tile(float (*as)[BM], float (*bs)[BN], const float *__restrict__ A,
+                                          const float *__restrict__ B, int M, int N, int K,
+                                          int row0, int col0, int k0, int tid) {
+#if VEC == 4
+    for (int i = tid; i < BM * BK / 4; i += THREADS) {
+        int r = i / (BK / 4), c = (i % (BK / 4)) * 4;
+        int gr = row0 + r, gc = k0 + c;
+        float4 v = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+        if (gr < M && gc < K) v = *reinterpret_cast<const float4 *>(A + (size_t)gr * K + gc);
+        as[c][r] = v.x; as[c + 1][r] = v.y; as[c + 2][r] = v.z; as[c + 3][r] = v.w;
+    }
+    for (int i = tid; i < BK * BN / 4; i += THREADS) {
+        int r = i / (BN / 4), c = (i % (BN / 4)) * 4;
+        int gr = k0 + r, gc = col0 + c;
+        float4 v = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+        if (gr < K && gc < N) v = *reinterpret_cast<const float4 *>(B + (size_t)gr * N + gc);
+        *reinterpret_cast<float4 *>(&bs[r][c]) = v;
+    }
+#else
+    for (int i = tid; i < BM * BK; i += THREADS) {
+        int r = i / BK, c = i % BK;
+        int gr = row0 + r, gc = k0 + c;
+        as[c][r] = (gr < M && gc < K) ? A[(size_t)gr * K + gc] : 0.0f;
+    }
+    for (int i = tid; i < BK * BN; i += THREADS) {
+        int r = i / BN, c = i % BN;
+        int gr = k0 + r, gc = col0 + c;
+        bs[r][c] = (gr < K && gc < N) ? B[(size_t)gr * N + gc] : 0.0f;
+    }
+#endif
+}
+
+extern "C" __global__ void __launch_bounds__(THREADS)
+matmul(const float *__restrict__ A, const float *__restrict__ B, float *__restrict__ C, int M, int N, int K) {
+    __shared__ __align__(16) float As[STAGES][BK][BM];
+    __shared__ __align__(16) float Bs[STAGES][BK][BN];
+    const int tid = threadIdx.x;
+    const int tx = tid % (BN / TN), ty = tid / (BN / TN);
+    const int row0 = blockIdx.y * BM, col0 = blockIdx.x * BN;
+    const int tiles = (K + BK - 1) / BK;
+
+    float acc[TM][TN];
+#pragma unroll
+    for (int i = 0; i < TM; i++)
+#pragma unroll
+        for (int j = 0; j < TN; j++) acc[i][j] = 0.0f;
+
+    load_tile(As[0], Bs[0], A, B, M, N, K, row0, col0, 0, tid);
+    __syncthreads();
+    for (int t = 0; t < tiles; t++) {
+        const int cur = t % STAGES;
+#if STAGES == 2
+        if (t + 1 < tiles) load_tile(As[cur ^ 1], Bs[cur ^ 1], A, B, M, N, K, row0, col0, (t + 1) * BK, tid);
+#endif
+#pragma unroll
+        for (int kk = 0; kk < BK; kk++) {
+            float ra[TM], rb[TN];
+#pragma unroll
+            for (int i = 0; i < TM; i++) ra[i] = As[cur][kk][ty * TM + i];
+#pragma unroll
+            for (int j = 0; j < TN; j++) rb[j] = Bs[cur][kk][tx * TN + j];
+#pragma unroll
+            for (int i = 0; i < TM; i++)
+#pragma unroll
+                for (int j = 0; j < TN; j++) acc[i][j] = fmaf(ra[i], rb[j], acc[i][j]);
+        }
+        __syncthreads();
+#if STAGES == 1
+        if (t + 1 < tiles) {
+            load_tile(As[0], Bs[0], A, B, M, N, K, row0, col0, (t + 1) * BK, tid);
+            __syncthreads();
+        }
+#endif
+    }
+
+#pragma unroll
+    for (int i = 0; i < TM; i++) {
+        int r = row0 + ty * TM + i;
+#pragma unroll
+        for (int j = 0; j < TN; j++) {
+            int c = col0 + tx * TN + j;
+            if (r < M && c < N) C[(size_t)r * N + c] = acc[i][j];
+        }
+    }
+}
+"#;
+
+const REDUCTION_BODY: &str = r#"
+extern "C" __global__ void __launch_bounds__(BLOCK)
+reduce(const float *__restrict__ in, float *__restrict__ out, int n) {
+    __shared__ float warp_sums[BLOCK / 32];
+    const int base = blockIdx.x * BLOCK * ITEMS * VEC;
+    float sum = 0.0f;
+#pragma unroll
+    for (int it = 0; it < ITEMS; it++) {
+        int i = base + (it * BLOCK + threadIdx.x) * VEC;
+#if VEC == 4
+        if (i + 3 < n) {
+            float4 v = *reinterpret_cast<const float4 *>(in + i);
+            sum += (v.x + v.y) + (v.z + v.w);
+        } else {
+            for (int j = i; j < n && j < i + 4; j++) sum += in[j];
+        }
+#else
+        if (i < n) sum += in[i];
+#endif
+    }
+    for (int off = 16; off > 0; off >>= 1) sum += __shfl_down_sync(0xffffffff, sum, off);
+    if ((threadIdx.x & 31) == 0) warp_sums[threadIdx.x >> 5] = sum;
+    __syncthreads();
+    if (threadIdx.x < 32) {
+        sum = threadIdx.x < BLOCK / 32 ? warp_sums[threadIdx.x] : 0.0f;
+        for (int off = 16; off > 0; off >>= 1) sum += __shfl_down_sync(0xffffffff, sum, off);
+        if (threadIdx.x == 0) out[blockIdx.x] = sum;
+    }
+}
+"#;
+
+/// C = A·B (row-major) con la configuración `cfg`
+pub fn matmul_kernel(cfg: &MatmulConfig, m: usize, n: usize, k: usize) -> GeneratedKernel {
+    let grid = (
+        n.div_ceil(cfg.tile_n as usize) as u32,
+        m.div_ceil(cfg.tile_m as usize) as u32,
+        1,
+    );
+    let header = format!(
+        "// ADead-BIB CUDA - MatMul (tile {bm}x{bn}x{bk}, {tm}x{tn} por hilo, {stages} etapa(s), float{vec})\n\
+         #define BM {bm}\n#define BN {bn}\n#define BK {bk}\n#define TM {tm}\n#define TN {tn}\n\
+         #define STAGES {stages}\n#define VEC {vec}\n#define THREADS {threads}\n",
+        bm = cfg.tile_m,
+        bn = cfg.tile_n,
+        bk = cfg.tile_k,
+        tm = cfg.thread_m,
+        tn = cfg.thread_n,
+        stages = cfg.stages,
+        vec = cfg.vector_width,
+        threads = cfg.threads(),
+    );
+    let launch = format!(
+        "// Launch: matmul<<<dim3({},{}), {}>>>(A, B, C, {}, {}, {});\n",
+        grid.0,
+        grid.1,
+        cfg.threads(),
+        m,
+        n,
+        k
+    );
+    GeneratedKernel {
+        source: header + MATMUL_BODY + &launch,
+        entry: "matmul",
+        grid,
+        block: (cfg.threads(), 1, 1),
+        problem: Problem::MatMul { m, n, k },
+    }
+}
+
+/// Suma parcial por bloque (out[blockIdx.x]) con la configuración `cfg`
+pub fn reduction_kernel(cfg: &ReductionConfig, size: usize) -> GeneratedKernel {
+    let blocks = size.max(1).div_ceil(cfg.elements_per_block()) as u32;
+    let header = format!(
+        "// ADead-BIB CUDA - Reduction ({block} hilos, {items} loads float{vec} por hilo, warp shuffle)\n\
+         #define BLOCK {block}\n#define ITEMS {items}\n#define VEC {vec}\n",
+        block = cfg.block,
+        items = cfg.items_per_thread,
+        vec = cfg.vector_width,
+    );
+    let launch = format!("// Launch: reduce<<<{}, {}>>>(in, out, {});\n", blocks, cfg.block, size);
+    GeneratedKernel {
+        source: header + REDUCTION_BODY + &launch,
+        entry: "reduce",
+        grid: (blocks, 1, 1),
+        block: (cfg.block, 1, 1),
+        problem: Problem::Reduction { size },
+    }
+}
+
+// ============================================================================
+// MEDICIÓN
+// ============================================================================
+
+/// Mide kernels generados en un dispositivo
+pub trait KernelBench {
+    fn arch(&self) -> GpuArch;
+    /// Mediana en µs de una ejecución; Err si no compila o no corre
+    fn time_kernel(&mut self, kernel: &GeneratedKernel) -> Result<f64, String>;
+}
+
+/// Banco CUDA: NVRTC → PTX → driver, tiempos vía GpuProfiler
+pub struct CudaBench {
+    api: CudaDriverApi,
+    nvrtc: NvrtcApi,
+    ctx: CUcontext,
+    arch: GpuArch,
+    iterations: usize,
+    /// Dispatches de toda la sesión de tuning (para el trace)
+    pub profiler: GpuProfiler,
+}
+
+impl CudaBench {
+    /// Banco en el device 0; falla sin driver, device o NVRTC
+    pub fn new(iterations: usize) -> Result<Self, String> {
+        let api = CudaDriverApi::load()?;
+        let nvrtc = NvrtcApi::load()?;
+        api.init()?;
+        let device = api.get_device(0)?;
+        let major = api.get_attribute(device, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR)? as u32;
+        let minor = api.get_attribute(device, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR)? as u32;
+        let ctx = api.create_context(device)?;
+        Ok(CudaBench {
+            api,
+            nvrtc,
+            ctx,
+            arch: GpuArch::from_sm(major * 10 + minor),
+            iterations: iterations.max(1),
+            profiler: GpuProfiler::new(),
+        })
+    }
+
+    fn buffer(&self, floats: usize, value: f32) -> Result<CUdeviceptr, String> {
+        let host = vec![value; floats.max(1)];
+        let bytes = host.len() * 4;
+        let ptr = self.api.mem_alloc(bytes)?;
+        if let Err(e) = self.api.memcpy_htod(ptr, host.as_ptr() as *const c_void, bytes) {
+            let _ = self.api.mem_free(ptr);
+            return Err(e);
+        }
+        Ok(ptr)
+    }
+
+    fn time_launches(&mut self, kernel: &GeneratedKernel, args: &mut [*mut c_void]) -> Result<f64, String> {
+        let ptx = self.nvrtc.compile_ptx(&kernel.source, "autotune.cu", self.arch)?;
+        let module = self.api.load_module(&ptx)?;
+        let timed = (|| {
+            let function = self.api.get_function(module, kernel.entry)?;
+            let launch = |args: &mut [*mut c_void]| self.api.launch_kernel(function, kernel.grid, kernel.block, 0, args);
+            // Calentamiento: carga del módulo y caches
+            launch(args)?;
+            self.api.synchronize()?;
+
+            let (flops, bytes) = kernel.problem.work();
+            let invocations = (kernel.grid.0 * kernel.grid.1 * kernel.grid.2) as u64
+                * (kernel.block.0 * kernel.block.1 * kernel.block.2) as u64;
+            let mut variant = GpuProfiler::new();
+            for _ in 0..self.iterations {
+                let mut timer = variant.begin_named_dispatch(kernel.entry);
+                launch(args)?;
+                timer.mark_submitted();
+                self.api.synchronize()?;
+                timer.mark_completed();
+                variant.end_dispatch(&timer, invocations, bytes, flops);
+                self.profiler.end_dispatch(&timer, invocations, bytes, flops);
+            }
+            Ok::<_, String>(variant.latency_percentile(50.0) as f64 / 1e3)
+        })();
+        let _ = self.api.unload_module(module);
+        timed
+    }
+}
+
+impl KernelBench for CudaBench {
+    fn arch(&self) -> GpuArch {
+        self.arch
+    }
+
+    fn time_kernel(&mut self, kernel: &GeneratedKernel) -> Result<f64, String> {
+        let (inputs, outputs, mut dims) = match kernel.problem {
+            Problem::MatMul { m, n, k } => (vec![m * k, k * n], m * n, vec![m as i32, n as i32, k as i32]),
+            Problem::Reduction { size } => (vec![size], kernel.grid.0 as usize, vec![size as i32]),
+        };
+        let mut ptrs = Vec::new();
+        let result = (|| {
+            for &floats in &inputs {
+                ptrs.push(self.buffer(floats, 1.0)?);
+            }
+            ptrs.push(self.buffer(outputs, 0.0)?);
+            let mut args: Vec<*mut c_void> = ptrs.iter_mut().map(|p| p as *mut CUdeviceptr as *mut c_void).collect();
+            args.extend(dims.iter_mut().map(|d| d as *mut i32 as *mut c_void));
+            self.time_launches(kernel, &mut args)
+        })();
+        for ptr in ptrs {
+            let _ = self.api.mem_free(ptr);
+        }
+        result
+    }
+}
+
+impl Drop for CudaBench {
+    fn drop(&mut self) {
+        let _ = self.api.destroy_context(self.ctx);
+    }
+}
+
+// ============================================================================
+// PERSISTENCIA + AUTOTUNER
+// ============================================================================
+
+/// Ganador de un bucket y su tiempo medido
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct Tuned<C> {
+    pub config: C,
+    pub micros: f64,
+}
+
+/// Ganadores por (SM, bucket). Una línea por entrada:
+/// `mm <sm> <bucket> <µs> <config…>` / `rd <sm> <bucket> <µs> <config…>`
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct TuningDb {
+    pub matmul: BTreeMap<(String, String), Tuned<MatmulConfig>>,
+    pub reduction: BTreeMap<(String, String), Tuned<ReductionConfig>>,
+}
+
+impl TuningDb {
+    pub fn path(dir: &Path) -> PathBuf {
+        dir.join("autotune").join("tuning.db")
+    }
+
+    /// La base del cache del compilador (vacía si no existe)
+    pub fn from_env() -> Self {
+        Self::load(ObjectCache::from_env().dir())
+    }
+
+    /// Líneas mal formadas o de otra versión se ignoran
+    pub fn load(dir: &Path) -> Self {
+        let mut db = TuningDb::default();
+        let Ok(text) = std::fs::read_to_string(Self::path(dir)) else {
+            return db;
+        };
+        let mut lines = text.lines();
+        if lines.next() != Some(format!("adeb-autotune {}", TUNING_VERSION).as_str()) {
+            return db;
+        }
+        for line in lines {
+            let fields: Vec<&str> = line.split_whitespace().collect();
+            let [kind, sm, bucket, micros, config @ ..] = &fields[..] else {
+                continue;
+            };
+            let (Ok(micros), key) = (micros.parse::<f64>(), (sm.to_string(), bucket.to_string())) else {
+                continue;
+            };
+            match *kind {
+                "mm" => {
+                    if let Some(config) = MatmulConfig::decode(config) {
+                        db.matmul.insert(key, Tuned { config, micros });
+                    }
+                }
+                "rd" => {
+                    if let Some(config) = ReductionConfig::decode(config) {
+                        db.reduction.insert(key, Tuned { config, micros });
+                    }
+                }
+                _ => {}
+            }
+        }
+        db
+    }
+
+    /// tmp + rename, como el cache de objetos
+    pub fn store(&self, dir: &Path) -> io::Result<()> {
+        let mut text = format!("adeb-autotune {}\n", TUNING_VERSION);
+        for ((sm, bucket), t) in &self.matmul {
+            text += &format!("mm {} {} {} {}\n", sm, bucket, t.micros, t.config.encode());
+        }
+        for ((sm, bucket), t) in &self.reduction {
+            text += &format!("rd {} {} {} {}\n", sm, bucket, t.micros, t.config.encode());
+        }
+        let path = Self::path(dir);
+        std::fs::create_dir_all(path.parent().unwrap())?;
+        let tmp = path.with_extension(format!("db.tmp{}", std::process::id()));
+        std::fs::write(&tmp, text)?;
+        std::fs::rename(&tmp, &path)
+    }
+
+    /// Configuración afinada para la forma, si hay y le sirve
+    pub fn matmul(&self, arch: GpuArch, m: usize, n: usize, k: usize) -> Option<MatmulConfig> {
+        let t = self.matmul.get(&(arch_key(arch), matmul_bucket(m, n, k)))?;
+        (t.config.is_valid(arch) && t.config.supports(n, k)).then_some(t.config)
+    }
+
+    pub fn reduction(&self, arch: GpuArch, size: usize) -> Option<ReductionConfig> {
+        let t = self.reduction.get(&(arch_key(arch), reduction_bucket(size)))?;
+        t.config.is_valid(arch).then_some(t.config)
+    }
+}
+
+/// Mide el espacio de variantes y guarda los ganadores
+pub struct Autotuner {
+    pub db: TuningDb,
+    /// Directorio del cache (None = no persiste)
+    dir: Option<PathBuf>,
+    pub max_candidates: usize,
+}
+
+impl Autotuner {
+    /// Sobre la base del cache del compilador
+    pub fn from_env() -> Self {
+        Self::new(Some(ObjectCache::from_env().dir().to_path_buf()))
+    }
+
+    pub fn new(dir: Option<PathBuf>) -> Self {
+        let db = dir.as_deref().map(TuningDb::load).unwrap_or_default();
+        Autotuner { db, dir, max_candidates: DEFAULT_MAX_CANDIDATES }
+    }
+
+    /// Mejor MatMul para la forma (lo mide si el bucket no está afinado)
+    pub fn tune_matmul(&mut self, bench: &mut dyn KernelBench, m: usize, n: usize, k: usize) -> Option<MatmulConfig> {
+        let arch = bench.arch();
+        if let Some(config) = self.db.matmul(arch, m, n, k) {
+            return Some(config);
+        }
+        let default = MatmulConfig::default_for(arch, n, k);
+        let space = sample(MatmulConfig::space(arch, m, n, k), default, self.max_candidates);
+        let best = best_of(bench, &space, |cfg| matmul_kernel(cfg, m, n, k))?;
+        self.db.matmul.insert((arch_key(arch), matmul_bucket(m, n, k)), best);
+        self.persist();
+        Some(best.config)
+    }
+
+    pub fn tune_reduction(&mut self, bench: &mut dyn KernelBench, size: usize) -> Option<ReductionConfig> {
+        let arch = bench.arch();
+        if let Some(config) = self.db.reduction(arch, size) {
+            return Some(config);
+        }
+        let default = ReductionConfig::default_for(arch);
+        let space = sample(ReductionConfig::space(arch, size), default, self.max_candidates);
+        let best = best_of(bench, &space, |cfg| reduction_kernel(cfg, size))?;
+        self.db.reduction.insert((arch_key(arch), reduction_bucket(size)), best);
+        self.persist();
+        Some(best.config)
+    }
+
+    /// Un fallo de escritura solo cuesta volver a medir
+    fn persist(&self) {
+        if let Some(dir) = &self.dir {
+            let _ = self.db.store(dir);
+        }
+    }
+}
+
+/// A lo sumo `max` variantes repartidas por el espacio, con la de
+/// por defecto siempre incluida (el tuning nunca empeora el default)
+fn sample<C: PartialEq + Copy>(space: Vec<C>, default: C, max: usize) -> Vec<C> {
+    let max = max.max(1);
+    let mut picked: Vec<C> = if space.len() <= max {
+        space
+    } else {
+        let step = space.len() as f64 / max as f64;
+        (0..max).map(|i| space[(i as f64 * step) as usize]).collect()
+    };
+    if !picked.contains(&default) {
+        picked.push(default);
+    }
+    picked
+}
+
+fn best_of<C: Copy>(
+    bench: &mut dyn KernelBench,
+    space: &[C],
+    generate: impl Fn(&C) -> GeneratedKernel,
+) -> Option<Tuned<C>> {
+    let mut best: Option<Tuned<C>> = None;
+    for config in space {
+        // Una variante que no compila (registros, NVRTC) se descarta
+        let Ok(micros) = bench.time_kernel(&generate(config)) else {
+            continue;
+        };
+        if best.map_or(true, |b| micros < b.micros) {
+            best = Some(Tuned { config: *config, micros });
+        }
+    }
+    best
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Banco de prueba: costo sintético que premia tiles grandes con
+    /// doble buffer y float4, y cuenta las variantes medidas
+    struct FakeBench {
+        timed: usize,
+    }
+
+    impl KernelBench for FakeBench {
+        fn arch(&self) -> GpuArch {
+            GpuArch::Ampere
+        }
+
+        fn time_kernel(&mut self, kernel: &GeneratedKernel) -> Result<f64, String> {
+            self.timed += 1;
+            let define = |name: &str| -> f64 {
+                let tag = format!("#define {} ", name);
+                let line = kernel.source.lines().find(|l| l.starts_with(&tag)).unwrap();
+                line[tag.len()..].parse().unwrap()
+            };
+            Ok(match kernel.problem {
+                Problem::MatMul { .. } => {
+                    1e4 / (define("BM") * define("BN") * define("STAGES") * define("VEC")) + 1e-3 * define("TM") / define("TN")
+                }
+                Problem::Reduction { .. } => (define("BLOCK") - 256.0).abs() + 10.0 / define("ITEMS"),
+            })
+        }
+    }
+
+    #[test]
+    fn test_search_space_fits_architecture() {
+        let space = MatmulConfig::space(GpuArch::Ampere, 1024, 1024, 1024);
+        assert!(space.len() > 20);
+        assert!(space.contains(&MatmulConfig::default_for(GpuArch::Ampere, 1024, 1024)));
+        for cfg in &space {
+            assert!((64..=256).contains(&cfg.threads()));
+            assert!(cfg.shared_bytes() <= 48 * 1024);
+        }
+        // Sin N/K alineados no hay float4; matrices chicas no usan tiles de 128
+        let small = MatmulConfig::space(GpuArch::Ampere, 40, 30, 30);
+        assert!(small.iter().all(|c| c.vector_width == 1 && c.tile_m <= 64 && c.tile_n <= 32));
+        assert!(ReductionConfig::space(GpuArch::Turing, 1 << 20).iter().all(|c| c.block % 32 == 0));
+    }
+
+    #[test]
+    fn test_kernel_generation() {
+        let cfg = MatmulConfig { tile_m: 128, tile_n: 64, tile_k: 8, thread_m: 8, thread_n: 4, stages: 2, vector_width: 4 };
+        let kernel = matmul_kernel(&cfg, 1000, 512, 256);
+        assert_eq!(kernel.grid, (8, 8, 1));
+        assert_eq!(kernel.block, (256, 1, 1));
+        for define in ["#define BM 128", "#define BN 64", "#define TM 8", "#define STAGES 2", "#define VEC 4", "#define THREADS 256"] {
+            assert!(kernel.source.contains(define), "{}", define);
+        }
+        assert!(kernel.source.contains("extern \"C\" __global__"));
+
+        let reduce = reduction_kernel(&ReductionConfig { block: 256, items_per_thread: 4, vector_width: 4 }, 10_000);
+        assert_eq!(reduce.grid, (3, 1, 1));
+        assert!(reduce.source.contains("__shfl_down_sync"));
+    }
+
+    #[test]
+    fn test_autotune_persists_winner() {
+        let dir = std::env::temp_dir().join(format!("adeb_autotune_{}", std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        let mut bench = FakeBench { timed: 0 };
+        let mut tuner = Autotuner::new(Some(dir.clone()));
+        tuner.max_candidates = 1000;
+
+        let best = tuner.tune_matmul(&mut bench, 1024, 1024, 1024).unwrap();
+        assert_eq!((best.tile_m, best.tile_n, best.stages, best.vector_width), (128, 128, 2, 4));
+        assert!(best.thread_m <= best.thread_n);
+        let reduce = tuner.tune_reduction(&mut bench, 1 << 20).unwrap();
+        assert_eq!((reduce.block, reduce.items_per_thread), (256, 8));
+        let measured = bench.timed;
+
+        // Otro proceso: misma forma del bucket → sin medir
+        let mut again = Autotuner::new(Some(dir.clone()));
+        assert_eq!(again.db, tuner.db);
+        assert_eq!(again.tune_matmul(&mut bench, 1000, 1000, 1000), Some(best));
+        assert_eq!(bench.timed, measured);
+        // Otra arquitectura u otro bucket no reutilizan la entrada
+        assert!(again.db.matmul(GpuArch::Turing, 1024, 1024, 1024).is_none());
+        assert!(again.db.matmul(GpuArch::Ampere, 1023, 1023, 1023).is_none());
+
+        // El muestreo respeta el presupuesto y conserva el default
+        let mut limited = Autotuner::new(None);
+        limited.max_candidates = 8;
+        bench.timed = 0;
+        limited.tune_matmul(&mut bench, 1024, 1024, 1024).unwrap();
+        assert!(bench.timed <= 9);
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
@@ -6,10 +6,32 @@
 //
 // Los drivers NVIDIA ya están instalados en el sistema
 // Solo necesitamos cargar nvcuda.dll y llamar las funciones
+//
+// JIT cache: el cubin que produce el driver (cuLink*) se guarda en
+// `<ADEB_CACHE_DIR o .adB-cache>/cubin/`, keyed por hash de PTX +
+// GpuArch + versión del driver. Un hit carga el cubin sin JIT.
+//
+// CudaProbe: microbenchmarks (latencia de lanzamiento, ancho de banda
+// host↔device) para calibrar el cost model CPU↔GPU del runtime.
+//
+// CudaFrameStream: subidas por frame desde un anillo page-locked en un
+// stream de copia, solapadas con el kernel del frame anterior en el
+// stream de compute (eventos entre ambos).
+//
+// NvrtcApi: CUDA C → PTX en runtime, para que el autotuner compile y
+// mida variantes de kernel sin nvcc.
 // ============================================================
 
+use super::GpuArch;
+use crate::memory::{UploadMetrics, UploadPipeline};
+use adeb_core::cache::hasher::hash_bytes;
+use adeb_core::calibration::GpuProbe;
+use adeb_core::cache::objects::ObjectCache;
+use std::collections::HashMap;
 use std::ffi::{c_void, CString};
+use std::path::PathBuf;
 use std::ptr;
+use std::time::Instant;
 
 /// CUDA Driver API types
 pub type CUdevice = i32;
@@ -18,8 +40,19 @@ pub type CUmodule = *mut c_void;
 pub type CUfunction = *mut c_void;
 pub type CUdeviceptr = u64;
 pub type CUstream = *mut c_void;
+pub type CUevent = *mut c_void;
+pub type CUlinkState = *mut c_void;
 pub type CUresult = i32;
 
+/// CUjitInputType: PTX source
+pub const CU_JIT_INPUT_PTX: i32 = 1;
+
+/// cuStreamCreate: no sincroniza con el stream por defecto
+pub const CU_STREAM_NON_BLOCKING: u32 = 1;
+
+/// cuEventCreate: sin timing, solo orden entre streams
+pub const CU_EVENT_DISABLE_TIMING: u32 = 2;
+
 /// CUDA Driver error codes
 pub const CUDA_SUCCESS: CUresult = 0;
 pub const CUDA_ERROR_INVALID_VALUE: CUresult = 1;
@@ -29,6 +62,7 @@ pub const CUDA_ERROR_NO_DEVICE: CUresult = 100;
 
 /// CUDA Driver API function pointers
 #[derive(Default)]
+#[allow(non_snake_case)]
 pub struct CudaDriverApi {
     // Initialization
     pub cuInit: Option<unsafe extern "system" fn(u32) -> CUresult>,
@@ -49,12 +83,40 @@ pub struct CudaDriverApi {
     pub cuModuleLoadData: Option<unsafe extern "system" fn(*mut CUmodule, *const c_void) -> CUresult>,
     pub cuModuleGetFunction: Option<unsafe extern "system" fn(*mut CUfunction, CUmodule, *const i8) -> CUresult>,
     pub cuModuleUnload: Option<unsafe extern "system" fn(CUmodule) -> CUresult>,
+
+    // JIT linking (PTX → cubin)
+    pub cuDriverGetVersion: Option<unsafe extern "system" fn(*mut i32) -> CUresult>,
+    pub cuLinkCreate: Option<unsafe extern "system" fn(u32, *mut i32, *mut *mut c_void, *mut CUlinkState) -> CUresult>,
+    pub cuLinkAddData: Option<unsafe extern "system" fn(
+        CUlinkState,
+        i32,            // CUjitInputType
+        *mut c_void,    // data
+        usize,          // size
+        *const i8,      // name
+        u32,            // num options
+        *mut i32,       // options
+        *mut *mut c_void // option values
+    ) -> CUresult>,
+    pub cuLinkComplete: Option<unsafe extern "system" fn(CUlinkState, *mut *mut c_void, *mut usize) -> CUresult>,
+    pub cuLinkDestroy: Option<unsafe extern "system" fn(CUlinkState) -> CUresult>,
     
     // Memory management
     pub cuMemAlloc: Option<unsafe extern "system" fn(*mut CUdeviceptr, usize) -> CUresult>,
     pub cuMemFree: Option<unsafe extern "system" fn(CUdeviceptr) -> CUresult>,
     pub cuMemcpyHtoD: Option<unsafe extern "system" fn(CUdeviceptr, *const c_void, usize) -> CUresult>,
     pub cuMemcpyDtoH: Option<unsafe extern "system" fn(*mut c_void, CUdeviceptr, usize) -> CUresult>,
+    pub cuMemAllocHost: Option<unsafe extern "system" fn(*mut *mut c_void, usize) -> CUresult>,
+    pub cuMemFreeHost: Option<unsafe extern "system" fn(*mut c_void) -> CUresult>,
+    pub cuMemcpyHtoDAsync: Option<unsafe extern "system" fn(CUdeviceptr, *const c_void, usize, CUstream) -> CUresult>,
+
+    // Streams y eventos
+    pub cuStreamCreate: Option<unsafe extern "system" fn(*mut CUstream, u32) -> CUresult>,
+    pub cuStreamDestroy: Option<unsafe extern "system" fn(CUstream) -> CUresult>,
+    pub cuStreamWaitEvent: Option<unsafe extern "system" fn(CUstream, CUevent, u32) -> CUresult>,
+    pub cuEventCreate: Option<unsafe extern "system" fn(*mut CUevent, u32) -> CUresult>,
+    pub cuEventDestroy: Option<unsafe extern "system" fn(CUevent) -> CUresult>,
+    pub cuEventRecord: Option<unsafe extern "system" fn(CUevent, CUstream) -> CUresult>,
+    pub cuEventSynchronize: Option<unsafe extern "system" fn(CUevent) -> CUresult>,
     
     // Kernel launch
     pub cuLaunchKernel: Option<unsafe extern "system" fn(
@@ -109,10 +171,25 @@ impl CudaDriverApi {
                 api.cuModuleLoadData = Self::get_proc(handle, "cuModuleLoadData");
                 api.cuModuleGetFunction = Self::get_proc(handle, "cuModuleGetFunction");
                 api.cuModuleUnload = Self::get_proc(handle, "cuModuleUnload");
+                api.cuDriverGetVersion = Self::get_proc(handle, "cuDriverGetVersion");
+                api.cuLinkCreate = Self::get_proc(handle, "cuLinkCreate_v2");
+                api.cuLinkAddData = Self::get_proc(handle, "cuLinkAddData_v2");
+                api.cuLinkComplete = Self::get_proc(handle, "cuLinkComplete");
+                api.cuLinkDestroy = Self::get_proc(handle, "cuLinkDestroy");
                 api.cuMemAlloc = Self::get_proc(handle, "cuMemAlloc_v2");
                 api.cuMemFree = Self::get_proc(handle, "cuMemFree_v2");
                 api.cuMemcpyHtoD = Self::get_proc(handle, "cuMemcpyHtoD_v2");
                 api.cuMemcpyDtoH = Self::get_proc(handle, "cuMemcpyDtoH_v2");
+                api.cuMemAllocHost = Self::get_proc(handle, "cuMemAllocHost_v2");
+                api.cuMemFreeHost = Self::get_proc(handle, "cuMemFreeHost");
+                api.cuMemcpyHtoDAsync = Self::get_proc(handle, "cuMemcpyHtoDAsync_v2");
+                api.cuStreamCreate = Self::get_proc(handle, "cuStreamCreate");
+                api.cuStreamDestroy = Self::get_proc(handle, "cuStreamDestroy_v2");
+                api.cuStreamWaitEvent = Self::get_proc(handle, "cuStreamWaitEvent");
+                api.cuEventCreate = Self::get_proc(handle, "cuEventCreate");
+                api.cuEventDestroy = Self::get_proc(handle, "cuEventDestroy_v2");
+                api.cuEventRecord = Self::get_proc(handle, "cuEventRecord");
+                api.cuEventSynchronize = Self::get_proc(handle, "cuEventSynchronize");
                 api.cuLaunchKernel = Self::get_proc(handle, "cuLaunchKernel");
             }
             
@@ -279,6 +356,115 @@ impl CudaDriverApi {
         Ok(())
     }
     
+    /// Page-locked host memory: the only source an async copy overlaps from
+    pub fn mem_alloc_host(&self, size: usize) -> Result<*mut c_void, String> {
+        let func = self.cuMemAllocHost.ok_or("cuMemAllocHost not loaded")?;
+        let mut ptr: *mut c_void = ptr::null_mut();
+        let result = unsafe { func(&mut ptr, size) };
+        if result != CUDA_SUCCESS {
+            return Err(format!("cuMemAllocHost failed with error {}", result));
+        }
+        Ok(ptr)
+    }
+
+    /// Free page-locked host memory
+    pub fn mem_free_host(&self, ptr: *mut c_void) -> Result<(), String> {
+        let func = self.cuMemFreeHost.ok_or("cuMemFreeHost not loaded")?;
+        let result = unsafe { func(ptr) };
+        if result != CUDA_SUCCESS {
+            return Err(format!("cuMemFreeHost failed with error {}", result));
+        }
+        Ok(())
+    }
+
+    /// Queue a host to device copy on `stream`
+    pub fn memcpy_htod_async(
+        &self,
+        dst: CUdeviceptr,
+        src: *const c_void,
+        size: usize,
+        stream: CUstream,
+    ) -> Result<(), String> {
+        let func = self.cuMemcpyHtoDAsync.ok_or("cuMemcpyHtoDAsync not loaded")?;
+        let result = unsafe { func(dst, src, size, stream) };
+        if result != CUDA_SUCCESS {
+            return Err(format!("cuMemcpyHtoDAsync failed with error {}", result));
+        }
+        Ok(())
+    }
+
+    /// Create a stream that does not serialize with the default stream
+    pub fn stream_create(&self) -> Result<CUstream, String> {
+        let func = self.cuStreamCreate.ok_or("cuStreamCreate not loaded")?;
+        let mut stream: CUstream = ptr::null_mut();
+        let result = unsafe { func(&mut stream, CU_STREAM_NON_BLOCKING) };
+        if result != CUDA_SUCCESS {
+            return Err(format!("cuStreamCreate failed with error {}", result));
+        }
+        Ok(stream)
+    }
+
+    /// Destroy a stream
+    pub fn stream_destroy(&self, stream: CUstream) -> Result<(), String> {
+        let func = self.cuStreamDestroy.ok_or("cuStreamDestroy not loaded")?;
+        let result = unsafe { func(stream) };
+        if result != CUDA_SUCCESS {
+            return Err(format!("cuStreamDestroy failed with error {}", result));
+        }
+        Ok(())
+    }
+
+    /// Work queued on `stream` after this waits for `event`
+    pub fn stream_wait_event(&self, stream: CUstream, event: CUevent) -> Result<(), String> {
+        let func = self.cuStreamWaitEvent.ok_or("cuStreamWaitEvent not loaded")?;
+        let result = unsafe { func(stream, event, 0) };
+        if result != CUDA_SUCCESS {
+            return Err(format!("cuStreamWaitEvent failed with error {}", result));
+        }
+        Ok(())
+    }
+
+    /// Create an event used only for ordering (no timing)
+    pub fn event_create(&self) -> Result<CUevent, String> {
+        let func = self.cuEventCreate.ok_or("cuEventCreate not loaded")?;
+        let mut event: CUevent = ptr::null_mut();
+        let result = unsafe { func(&mut event, CU_EVENT_DISABLE_TIMING) };
+        if result != CUDA_SUCCESS {
+            return Err(format!("cuEventCreate failed with error {}", result));
+        }
+        Ok(event)
+    }
+
+    /// Destroy an event
+    pub fn event_destroy(&self, event: CUevent) -> Result<(), String> {
+        let func = self.cuEventDestroy.ok_or("cuEventDestroy not loaded")?;
+        let result = unsafe { func(event) };
+        if result != CUDA_SUCCESS {
+            return Err(format!("cuEventDestroy failed with error {}", result));
+        }
+        Ok(())
+    }
+
+    /// Mark the point of `stream` that `event` completes at
+    pub fn event_record(&self, event: CUevent, stream: CUstream) -> Result<(), String> {
+        let func = self.cuEventRecord.ok_or("cuEventRecord not loaded")?;
+        let result = unsafe { func(event, stream) };
+        if result != CUDA_SUCCESS {
+            return Err(format!("cuEventRecord failed with error {}", result));
+        }
+        Ok(())
+    }
+
+    /// Block the host until `event` completes
+    pub fn event_synchronize(&self, event: CUevent) -> Result<(), String> {
+        let func = self.cuEventSynchronize.ok_or("cuEventSynchronize not loaded")?;
+        let result = unsafe { func(event) };
+        if result != CUDA_SUCCESS {
+            return Err(format!("cuEventSynchronize failed with error {}", result));
+        }
+        Ok(())
+    }
+
     /// Load PTX module
     pub fn load_module(&self, ptx: &str) -> Result<CUmodule, String> {
         let func = self.cuModuleLoadData.ok_or("cuModuleLoadData not loaded")?;
@@ -291,6 +477,102 @@ impl CudaDriverApi {
         Ok(module)
     }
     
+    /// Load a module from a cubin image (no JIT)
+    pub fn load_cubin(&self, cubin: &[u8]) -> Result<CUmodule, String> {
+        let func = self.cuModuleLoadData.ok_or("cuModuleLoadData not loaded")?;
+        let mut module: CUmodule = ptr::null_mut();
+        let result = unsafe { func(&mut module, cubin.as_ptr() as *const c_void) };
+        if result != CUDA_SUCCESS {
+            return Err(format!("cuModuleLoadData (cubin) failed with error {}", result));
+        }
+        Ok(module)
+    }
+
+    /// Driver version (e.g. 12040 for CUDA 12.4)
+    pub fn driver_version(&self) -> Result<i32, String> {
+        let func = self.cuDriverGetVersion.ok_or("cuDriverGetVersion not loaded")?;
+        let mut version = 0;
+        let result = unsafe { func(&mut version) };
+        if result != CUDA_SUCCESS {
+            return Err(format!("cuDriverGetVersion failed with error {}", result));
+        }
+        Ok(version)
+    }
+
+    /// JIT-compile PTX to a cubin image for the current context's device
+    pub fn jit_cubin(&self, ptx: &str) -> Result<Vec<u8>, String> {
+        let create = self.cuLinkCreate.ok_or("cuLinkCreate not loaded")?;
+        let add = self.cuLinkAddData.ok_or("cuLinkAddData not loaded")?;
+        let complete = self.cuLinkComplete.ok_or("cuLinkComplete not loaded")?;
+        let destroy = self.cuLinkDestroy.ok_or("cuLinkDestroy not loaded")?;
+        let ptx_cstr = CString::new(ptx).map_err(|e| e.to_string())?;
+        let name = CString::new("cudead.ptx").map_err(|e| e.to_string())?;
+
+        let mut state: CUlinkState = ptr::null_mut();
+        let result = unsafe { create(0, ptr::null_mut(), ptr::null_mut(), &mut state) };
+        if result != CUDA_SUCCESS {
+            return Err(format!("cuLinkCreate failed with error {}", result));
+        }
+        // The cubin belongs to the link state: copy it out before destroying
+        let linked = unsafe {
+            let bytes = ptx_cstr.as_bytes_with_nul();
+            let result = add(
+                state,
+                CU_JIT_INPUT_PTX,
+                bytes.as_ptr() as *mut c_void,
+                bytes.len(),
+                name.as_ptr(),
+                0,
+                ptr::null_mut(),
+                ptr::null_mut(),
+            );
+            if result != CUDA_SUCCESS {
+                Err(format!("cuLinkAddData failed with error {}", result))
+            } else {
+                let mut cubin: *mut c_void = ptr::null_mut();
+                let mut size = 0usize;
+                let result = complete(state, &mut cubin, &mut size);
+                if result != CUDA_SUCCESS {
+                    Err(format!("cuLinkComplete failed with error {}", result))
+                } else {
+                    Ok(std::slice::from_raw_parts(cubin as *const u8, size).to_vec())
+                }
+            }
+        };
+        unsafe { destroy(state) };
+        linked
+    }
+
+    /// Load PTX through the cubin cache: a hit skips the driver JIT, a
+    /// miss JITs once and stores the cubin. Without the link API it falls
+    /// back to `load_module`.
+    pub fn load_module_cached(&self, ptx: &str, arch: GpuArch, cache: &CubinCache) -> Result<CUmodule, String> {
+        let (Ok(version), true) = (self.driver_version(), self.cuLinkCreate.is_some()) else {
+            return self.load_module(ptx);
+        };
+        let key = CubinCache::key(ptx, arch, version);
+        if let Some(cubin) = cache.load(key) {
+            // A cubin the driver rejects is stale: drop it and JIT again
+            match self.load_cubin(&cubin) {
+                Ok(module) => return Ok(module),
+                Err(_) => cache.remove(key),
+            }
+        }
+        let cubin = self.jit_cubin(ptx)?;
+        cache.store(key, &cubin);
+        self.load_cubin(&cubin)
+    }
+    
+    /// Unload a module loaded with `load_module`/`load_cubin`
+    pub fn unload_module(&self, module: CUmodule) -> Result<(), String> {
+        let func = self.cuModuleUnload.ok_or("cuModuleUnload not loaded")?;
+        let result = unsafe { func(module) };
+        if result != CUDA_SUCCESS {
+            return Err(format!("cuModuleUnload failed with error {}", result));
+        }
+        Ok(())
+    }
+
     /// Get kernel function from module
     pub fn get_function(&self, module: CUmodule, name: &str) -> Result<CUfunction, String> {
         let func = self.cuModuleGetFunction.ok_or("cuModuleGetFunction not loaded")?;
@@ -311,6 +593,20 @@ impl CudaDriverApi {
         block: (u32, u32, u32),
         shared_mem: u32,
         args: &mut [*mut c_void],
+    ) -> Result<(), String> {
+        // default stream
+        self.launch_kernel_on(ptr::null_mut(), function, grid, block, shared_mem, args)
+    }
+
+    /// Launch kernel on `stream`
+    pub fn launch_kernel_on(
+        &self,
+        stream: CUstream,
+        function: CUfunction,
+        grid: (u32, u32, u32),
+        block: (u32, u32, u32),
+        shared_mem: u32,
+        args: &mut [*mut c_void],
     ) -> Result<(), String> {
         let func = self.cuLaunchKernel.ok_or("cuLaunchKernel not loaded")?;
         let result = unsafe {
@@ -319,7 +615,7 @@ impl CudaDriverApi {
                 grid.0, grid.1, grid.2,
                 block.0, block.1, block.2,
                 shared_mem,
-                ptr::null_mut(), // default stream
+                stream,
                 args.as_mut_ptr(),
                 ptr::null_mut(),
             )
@@ -331,11 +627,467 @@ impl CudaDriverApi {
     }
 }
 
+/// Default size budget of the cubin cache
+pub const DEFAULT_CUBIN_CACHE_BYTES: u64 = 256 * 1024 * 1024;
+
+/// Access order file (`<key> <stamp> <bytes>` per line)
+const CUBIN_INDEX: &str = "lru.idx";
+
+/// On-disk cache of JIT output, evicted least-recently-used first once
+/// the total size passes `max_bytes`
+#[derive(Debug, Clone)]
+pub struct CubinCache {
+    objects: ObjectCache,
+    max_bytes: u64,
+}
+
+impl CubinCache {
+    pub fn new(dir: impl Into<PathBuf>, max_bytes: u64) -> Self {
+        CubinCache { objects: ObjectCache::new(dir), max_bytes }
+    }
+
+    /// `cubin/` inside the compiler object cache, default budget
+    pub fn from_env() -> Self {
+        Self::new(ObjectCache::from_env().dir().join("cubin"), DEFAULT_CUBIN_CACHE_BYTES)
+    }
+
+    /// PTX text + target architecture + driver version
+    pub fn key(ptx: &str, arch: GpuArch, driver_version: i32) -> u64 {
+        let (major, minor) = arch.sm_version();
+        hash_bytes(format!("sm_{}{}\0{}\0{}", major, minor, driver_version, ptx).as_bytes())
+    }
+
+    pub fn load(&self, key: u64) -> Option<Vec<u8>> {
+        let cubin = self.objects.load(key)?;
+        let mut index = self.read_index();
+        let stamp = next_stamp(&index);
+        index.insert(key, (stamp, cubin.len() as u64));
+        self.write_index(&index);
+        Some(cubin)
+    }
+
+    /// Store a cubin and evict until the cache fits its budget. A failed
+    /// write only costs a future miss.
+    pub fn store(&self, key: u64, cubin: &[u8]) {
+        if self.objects.store(key, cubin).is_err() {
+            return;
+        }
+        let mut index = self.read_index();
+        let stamp = next_stamp(&index);
+        index.insert(key, (stamp, cubin.len() as u64));
+        let mut total: u64 = index.values().map(|(_, size)| size).sum();
+        let mut by_age: Vec<(u64, u64, u64)> = index.iter().map(|(&k, &(stamp, size))| (stamp, k, size)).collect();
+        by_age.sort_unstable();
+        for (_, old, size) in by_age {
+            if total <= self.max_bytes || old == key {
+                break;
+            }
+            let _ = std::fs::remove_file(self.objects.path_for(old));
+            index.remove(&old);
+            total -= size;
+        }
+        self.write_index(&index);
+    }
+
+    pub fn remove(&self, key: u64) {
+        let _ = std::fs::remove_file(self.objects.path_for(key));
+        let mut index = self.read_index();
+        if index.remove(&key).is_some() {
+            self.write_index(&index);
+        }
+    }
+
+    fn read_index(&self) -> HashMap<u64, (u64, u64)> {
+        let text = std::fs::read_to_string(self.objects.dir().join(CUBIN_INDEX)).unwrap_or_default();
+        text.lines()
+            .filter_map(|line| {
+                let mut fields = line.split_whitespace();
+                let key = u64::from_str_radix(fields.next()?, 16).ok()?;
+                Some((key, (fields.next()?.parse().ok()?, fields.next()?.parse().ok()?)))
+            })
+            // An entry whose cubin vanished no longer counts
+            .filter(|(key, _)| self.objects.path_for(*key).exists())
+            .collect()
+    }
+
+    fn write_index(&self, index: &HashMap<u64, (u64, u64)>) {
+        let text: String = index
+            .iter()
+            .map(|(key, (stamp, size))| format!("{:016x} {} {}\n", key, stamp, size))
+            .collect();
+        let path = self.objects.dir().join(CUBIN_INDEX);
+        let tmp = path.with_extension(format!("tmp{}", std::process::id()));
+        if std::fs::write(&tmp, text).is_ok() {
+            let _ = std::fs::rename(&tmp, &path);
+        }
+    }
+}
+
+fn next_stamp(index: &HashMap<u64, (u64, u64)>) -> u64 {
+    index.values().map(|(stamp, _)| stamp + 1).max().unwrap_or(0)
+}
+
+/// Empty kernel used to time launch + synchronize
+const NOOP_PTX: &str = ".version 7.0\n.target sm_50\n.address_size 64\n\n.visible .entry noop()\n{\n\tret;\n}\n";
+
+/// Device-side timings for the runtime cost model
+pub struct CudaProbe {
+    api: CudaDriverApi,
+    ctx: CUcontext,
+}
+
+impl CudaProbe {
+    /// Probe on device 0; fails without a driver or a device
+    pub fn new() -> Result<Self, String> {
+        let api = CudaDriverApi::load()?;
+        api.init()?;
+        let ctx = api.create_context(api.get_device(0)?)?;
+        Ok(CudaProbe { api, ctx })
+    }
+
+    /// Best-of-`iterations` µs to launch an empty kernel and wait for it
+    pub fn launch_latency_us(&self, iterations: usize) -> Result<f64, String> {
+        let module = self.api.load_module(NOOP_PTX)?;
+        let noop = self.api.get_function(module, "noop")?;
+        let launch = || {
+            self.api.launch_kernel(noop, (1, 1, 1), (1, 1, 1), 0, &mut [])?;
+            self.api.synchronize()
+        };
+        launch()?; // first launch pays module setup
+        let mut best = f64::MAX;
+        for _ in 0..iterations.max(1) {
+            let t = Instant::now();
+            launch()?;
+            best = best.min(t.elapsed().as_secs_f64() * 1e6);
+        }
+        Ok(best)
+    }
+
+    /// GB/s of a `bytes` host→device copy followed by device→host
+    pub fn copy_gbps(&self, bytes: usize) -> Result<f64, String> {
+        let mut host = vec![0u8; bytes];
+        let device = self.api.mem_alloc(bytes)?;
+        let timed = (|| {
+            // Warm-up: maps the pages and the driver's staging buffers
+            self.api.memcpy_htod(device, host.as_ptr() as *const c_void, bytes)?;
+            let t = Instant::now();
+            self.api.memcpy_htod(device, host.as_ptr() as *const c_void, bytes)?;
+            self.api.memcpy_dtoh(host.as_mut_ptr() as *mut c_void, device, bytes)?;
+            Ok::<_, String>(t.elapsed().as_secs_f64())
+        })();
+        self.api.mem_free(device)?;
+        Ok(2.0 * bytes as f64 / timed?.max(1e-9) / 1e9)
+    }
+}
+
+impl Drop for CudaProbe {
+    fn drop(&mut self) {
+        let _ = self.api.destroy_context(self.ctx);
+    }
+}
+
+/// GPU side of the CPU/GPU calibration (`CostModel::calibrate`)
+impl GpuProbe for CudaProbe {
+    fn launch_latency_us(&mut self) -> Option<f64> {
+        CudaProbe::launch_latency_us(self, 100).ok()
+    }
+
+    fn copy_gbps(&mut self, bytes: usize) -> Option<f64> {
+        CudaProbe::copy_gbps(self, bytes).ok()
+    }
+}
+
+/// Source id of the page-locked ring in `TransferCommand::src_buffer`
+const STAGING_RING: u32 = u32::MAX;
+
+/// Staging offsets of each upload are aligned to this
+const UPLOAD_ALIGNMENT: u64 = 256;
+
+/// Streaming uploads overlapped with compute.
+///
+/// A page-locked staging ring split into `frames_in_flight` slices by
+/// `memory::UploadPipeline`, a copy stream and a compute stream. Frame
+/// N's copies record `uploaded[N]` on the copy stream and its kernel
+/// waits on that event in the compute stream (the batch's
+/// `MemoryBarrier::Transfer`), so the copies of frame N+1 run while
+/// frame N computes. A slice is only rewritten after the `computed`
+/// event of the frame that last used it.
+///
+/// Per frame: `begin_frame` → `upload`* → `dispatch`; `finish` waits
+/// for everything in flight.
+pub struct CudaFrameStream<'a> {
+    api: &'a CudaDriverApi,
+    pipeline: UploadPipeline,
+    host: *mut u8,
+    copy: CUstream,
+    compute: CUstream,
+    /// Per slice: its copies landed / its kernel finished
+    uploaded: Vec<CUevent>,
+    computed: Vec<CUevent>,
+    /// Device buffers uploads can target, by `TransferCommand::dst_buffer`
+    buffers: HashMap<u32, CUdeviceptr>,
+}
+
+impl<'a> CudaFrameStream<'a> {
+    /// `ring_bytes` of page-locked staging, shared by `frames_in_flight` frames
+    pub fn new(api: &'a CudaDriverApi, ring_bytes: usize, frames_in_flight: u32) -> Result<Self, String> {
+        let frames = frames_in_flight.max(1);
+        let mut stream = CudaFrameStream {
+            api,
+            pipeline: UploadPipeline::new(STAGING_RING, ring_bytes as u64, frames),
+            host: ptr::null_mut(),
+            copy: ptr::null_mut(),
+            compute: ptr::null_mut(),
+            uploaded: Vec::new(),
+            computed: Vec::new(),
+            buffers: HashMap::new(),
+        };
+        // On error, Drop releases whatever was created so far
+        stream.host = api.mem_alloc_host(ring_bytes)? as *mut u8;
+        stream.copy = api.stream_create()?;
+        stream.compute = api.stream_create()?;
+        for _ in 0..frames {
+            stream.uploaded.push(api.event_create()?);
+            stream.computed.push(api.event_create()?);
+        }
+        Ok(stream)
+    }
+
+    /// Lets uploads target `ptr` as buffer `id`
+    pub fn bind_buffer(&mut self, id: u32, ptr: CUdeviceptr) {
+        self.buffers.insert(id, ptr);
+    }
+
+    fn slot(&self, frame: u64) -> usize {
+        ((frame - 1) % self.uploaded.len() as u64) as usize
+    }
+
+    /// Starts the next frame, blocking until its staging slice is free
+    pub fn begin_frame(&mut self) -> Result<u64, String> {
+        loop {
+            match self.pipeline.begin_frame() {
+                Ok(frame) => return Ok(frame),
+                Err(busy) => {
+                    self.api.event_synchronize(self.computed[self.slot(busy)])?;
+                    self.pipeline.retire(busy);
+                }
+            }
+        }
+    }
+
+    /// Stages `data` for `dst_buffer[dst_offset..]`. `Ok(false)`: the
+    /// frame's slice is full, dispatch and upload the rest next frame.
+    pub fn upload(&mut self, dst_buffer: u32, dst_offset: u64, data: &[u8]) -> Result<bool, String> {
+        if !self.buffers.contains_key(&dst_buffer) {
+            return Err(format!("upload to unbound buffer {}", dst_buffer));
+        }
+        let Some(offset) = self.pipeline.upload(dst_buffer, dst_offset, data.len() as u64, UPLOAD_ALIGNMENT) else {
+            return Ok(false);
+        };
+        unsafe { ptr::copy_nonoverlapping(data.as_ptr(), self.host.add(offset as usize), data.len()) };
+        Ok(true)
+    }
+
+    /// Closes the frame: queues its copies and the kernel that reads them
+    pub fn dispatch(
+        &mut self,
+        function: CUfunction,
+        grid: (u32, u32, u32),
+        block: (u32, u32, u32),
+        shared_mem: u32,
+        args: &mut [*mut c_void],
+    ) -> Result<u64, String> {
+        let batch = self.pipeline.end_frame();
+        let slot = self.slot(batch.frame);
+        for cmd in &batch.commands {
+            let dst = self.buffers[&cmd.dst_buffer] + cmd.dst_offset;
+            let src = unsafe { self.host.add(cmd.src_offset as usize) } as *const c_void;
+            self.api.memcpy_htod_async(dst, src, cmd.size as usize, self.copy)?;
+        }
+        self.api.event_record(self.uploaded[slot], self.copy)?;
+        self.api.stream_wait_event(self.compute, self.uploaded[slot])?;
+        self.api.launch_kernel_on(self.compute, function, grid, block, shared_mem, args)?;
+        self.api.event_record(self.computed[slot], self.compute)?;
+        Ok(batch.frame)
+    }
+
+    /// Waits for the kernels of every dispatched frame
+    pub fn finish(&mut self) -> Result<(), String> {
+        // An event that was never recorded completes immediately
+        for &event in &self.computed {
+            self.api.event_synchronize(event)?;
+        }
+        self.pipeline.retire(u64::MAX);
+        Ok(())
+    }
+
+    pub fn metrics(&self) -> &UploadMetrics {
+        &self.pipeline.metrics
+    }
+}
+
+impl Drop for CudaFrameStream<'_> {
+    fn drop(&mut self) {
+        let _ = self.finish();
+        for &event in self.uploaded.iter().chain(&self.computed) {
+            let _ = self.api.event_destroy(event);
+        }
+        for stream in [self.copy, self.compute] {
+            if !stream.is_null() {
+                let _ = self.api.stream_destroy(stream);
+            }
+        }
+        if !self.host.is_null() {
+            let _ = self.api.mem_free_host(self.host as *mut c_void);
+        }
+    }
+}
+
+/// NVRTC program handle
+pub type NvrtcProgram = *mut c_void;
+pub type NvrtcResult = i32;
+
+/// NVRTC DLLs, newest toolkit first
+#[cfg(windows)]
+const NVRTC_DLLS: [&str; 4] = ["nvrtc64_120_0.dll", "nvrtc64_112_0.dll", "nvrtc64_111_0.dll", "nvrtc64_110_0.dll"];
+
+/// NVRTC: CUDA C → PTX at runtime. Ships with the toolkit, not the
+/// driver, so only the autotuner depends on it.
+#[derive(Default)]
+#[allow(non_snake_case)]
+pub struct NvrtcApi {
+    pub nvrtcCreateProgram: Option<unsafe extern "system" fn(
+        *mut NvrtcProgram,
+        *const i8, // src
+        *const i8, // name
+        i32,       // numHeaders
+        *const *const i8,
+        *const *const i8,
+    ) -> NvrtcResult>,
+    pub nvrtcCompileProgram: Option<unsafe extern "system" fn(NvrtcProgram, i32, *const *const i8) -> NvrtcResult>,
+    pub nvrtcGetPTXSize: Option<unsafe extern "system" fn(NvrtcProgram, *mut usize) -> NvrtcResult>,
+    pub nvrtcGetPTX: Option<unsafe extern "system" fn(NvrtcProgram, *mut i8) -> NvrtcResult>,
+    pub nvrtcGetProgramLogSize: Option<unsafe extern "system" fn(NvrtcProgram, *mut usize) -> NvrtcResult>,
+    pub nvrtcGetProgramLog: Option<unsafe extern "system" fn(NvrtcProgram, *mut i8) -> NvrtcResult>,
+    pub nvrtcDestroyProgram: Option<unsafe extern "system" fn(*mut NvrtcProgram) -> NvrtcResult>,
+    /// FreeLibrary on drop
+    #[cfg(windows)]
+    lib_handle: Option<*mut c_void>,
+}
+
+#[cfg(windows)]
+impl Drop for NvrtcApi {
+    fn drop(&mut self) {
+        if let Some(handle) = self.lib_handle.take() {
+            unsafe { FreeLibrary(handle) };
+        }
+    }
+}
+
+impl NvrtcApi {
+    /// Load the newest NVRTC found on the DLL search path
+    pub fn load() -> Result<Self, String> {
+        #[cfg(windows)]
+        {
+            use std::os::windows::ffi::OsStrExt;
+
+            let handle = NVRTC_DLLS
+                .iter()
+                .map(|name| {
+                    let wide: Vec<u16> = std::ffi::OsStr::new(name).encode_wide().chain(std::iter::once(0)).collect();
+                    unsafe { LoadLibraryW(wide.as_ptr()) }
+                })
+                .find(|h| !h.is_null())
+                .ok_or("Failed to load nvrtc64_*.dll - CUDA toolkit not installed?")?;
+
+            let mut api = NvrtcApi { lib_handle: Some(handle), ..Default::default() };
+            unsafe {
+                api.nvrtcCreateProgram = CudaDriverApi::get_proc(handle, "nvrtcCreateProgram");
+                api.nvrtcCompileProgram = CudaDriverApi::get_proc(handle, "nvrtcCompileProgram");
+                api.nvrtcGetPTXSize = CudaDriverApi::get_proc(handle, "nvrtcGetPTXSize");
+                api.nvrtcGetPTX = CudaDriverApi::get_proc(handle, "nvrtcGetPTX");
+                api.nvrtcGetProgramLogSize = CudaDriverApi::get_proc(handle, "nvrtcGetProgramLogSize");
+                api.nvrtcGetProgramLog = CudaDriverApi::get_proc(handle, "nvrtcGetProgramLog");
+                api.nvrtcDestroyProgram = CudaDriverApi::get_proc(handle, "nvrtcDestroyProgram");
+            }
+            if api.nvrtcCompileProgram.is_none() {
+                return Err("Failed to load nvrtcCompileProgram".to_string());
+            }
+            Ok(api)
+        }
+
+        #[cfg(not(windows))]
+        {
+            Err("NVRTC loading only implemented for Windows".to_string())
+        }
+    }
+
+    /// Compile CUDA C `source` to PTX for `arch`; the error carries the
+    /// compiler log
+    pub fn compile_ptx(&self, source: &str, name: &str, arch: GpuArch) -> Result<String, String> {
+        let create = self.nvrtcCreateProgram.ok_or("nvrtcCreateProgram not loaded")?;
+        let compile = self.nvrtcCompileProgram.ok_or("nvrtcCompileProgram not loaded")?;
+        let ptx_size = self.nvrtcGetPTXSize.ok_or("nvrtcGetPTXSize not loaded")?;
+        let get_ptx = self.nvrtcGetPTX.ok_or("nvrtcGetPTX not loaded")?;
+        let destroy = self.nvrtcDestroyProgram.ok_or("nvrtcDestroyProgram not loaded")?;
+        let src = CString::new(source).map_err(|e| e.to_string())?;
+        let name = CString::new(name).map_err(|e| e.to_string())?;
+        let (major, minor) = arch.sm_version();
+        let options = [format!("--gpu-architecture=compute_{}{}", major, minor), "--std=c++14".to_string()];
+        let options: Vec<CString> = options.iter().map(|o| CString::new(o.as_str()).unwrap()).collect();
+        let option_ptrs: Vec<*const i8> = options.iter().map(|o| o.as_ptr()).collect();
+
+        let mut prog: NvrtcProgram = ptr::null_mut();
+        let result = unsafe { create(&mut prog, src.as_ptr(), name.as_ptr(), 0, ptr::null(), ptr::null()) };
+        if result != 0 {
+            return Err(format!("nvrtcCreateProgram failed with error {}", result));
+        }
+        let compiled = unsafe {
+            let result = compile(prog, option_ptrs.len() as i32, option_ptrs.as_ptr());
+            if result != 0 {
+                Err(format!("nvrtcCompileProgram failed with error {}: {}", result, self.program_log(prog)))
+            } else {
+                let mut size = 0usize;
+                let mut ptx = Vec::new();
+                let result = ptx_size(prog, &mut size);
+                if result == 0 {
+                    ptx.resize(size, 0);
+                }
+                if result != 0 || get_ptx(prog, ptx.as_mut_ptr() as *mut i8) != 0 {
+                    Err("nvrtcGetPTX failed".to_string())
+                } else {
+                    // Size includes the NUL terminator
+                    ptx.truncate(ptx.iter().position(|&b| b == 0).unwrap_or(ptx.len()));
+                    String::from_utf8(ptx).map_err(|e| e.to_string())
+                }
+            }
+        };
+        unsafe { destroy(&mut prog) };
+        compiled
+    }
+
+    unsafe fn program_log(&self, prog: NvrtcProgram) -> String {
+        let (Some(log_size), Some(get_log)) = (self.nvrtcGetProgramLogSize, self.nvrtcGetProgramLog) else {
+            return String::new();
+        };
+        let mut size = 0usize;
+        if log_size(prog, &mut size) != 0 || size == 0 {
+            return String::new();
+        }
+        let mut log = vec![0u8; size];
+        if get_log(prog, log.as_mut_ptr() as *mut i8) != 0 {
+            return String::new();
+        }
+        String::from_utf8_lossy(&log).trim_end_matches('\0').trim().to_string()
+    }
+}
+
 // Windows FFI
 #[cfg(windows)]
 extern "system" {
     fn LoadLibraryW(lpLibFileName: *const u16) -> *mut c_void;
     fn GetProcAddress(hModule: *mut c_void, lpProcName: *const i8) -> *mut c_void;
+    fn FreeLibrary(hLibModule: *mut c_void) -> i32;
 }
 
 /// Device attributes
@@ -358,6 +1110,63 @@ pub mod attrib {
 mod tests {
     use super::*;
 
+    #[test]
+    fn test_cubin_cache_evicts_least_recently_used() {
+        let dir = std::env::temp_dir().join(format!("adeb_cubin_cache_{}", std::process::id()));
+        let cache = CubinCache::new(&dir, 300);
+        let (a, b, c) = (
+            CubinCache::key("a", GpuArch::Ampere, 12040),
+            CubinCache::key("b", GpuArch::Ampere, 12040),
+            CubinCache::key("c", GpuArch::Ampere, 12040),
+        );
+        assert_ne!(a, CubinCache::key("a", GpuArch::AdaLovelace, 12040));
+        assert_ne!(a, CubinCache::key("a", GpuArch::Ampere, 12050));
+
+        cache.store(a, &[1; 100]);
+        cache.store(b, &[2; 100]);
+        // Touching `a` makes `b` the oldest
+        assert_eq!(cache.load(a).as_deref(), Some(&[1u8; 100][..]));
+        cache.store(c, &[3; 150]);
+        assert!(cache.load(b).is_none());
+        assert!(cache.load(a).is_some());
+        assert!(cache.load(c).is_some());
+
+        cache.remove(a);
+        assert!(cache.load(a).is_none());
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_frame_stream_uploads_every_frame() {
+        // Only runs with an NVIDIA driver and device
+        let Ok(api) = CudaDriverApi::load() else { return };
+        if api.init().is_err() || api.device_count().map_or(true, |n| n == 0) {
+            return;
+        }
+        let ctx = api.create_context(api.get_device(0).unwrap()).unwrap();
+        let module = api.load_module(NOOP_PTX).unwrap();
+        let noop = api.get_function(module, "noop").unwrap();
+        let device = api.mem_alloc(4096).unwrap();
+        {
+            let mut stream = CudaFrameStream::new(&api, 2 * 4096, 2).unwrap();
+            stream.bind_buffer(0, device);
+            for frame in 1..=5u8 {
+                stream.begin_frame().unwrap();
+                assert!(stream.upload(0, 0, &[frame; 4096]).unwrap());
+                stream.dispatch(noop, (1, 1, 1), (1, 1, 1), 0, &mut []).unwrap();
+            }
+            stream.finish().unwrap();
+            assert_eq!(stream.metrics().frames, 5);
+            assert!(stream.metrics().stalls >= 3);
+        }
+        let mut out = vec![0u8; 4096];
+        api.memcpy_dtoh(out.as_mut_ptr() as *mut c_void, device, 4096).unwrap();
+        assert!(out.iter().all(|&b| b == 5));
+        api.mem_free(device).unwrap();
+        api.unload_module(module).unwrap();
+        api.destroy_context(ctx).unwrap();
+    }
+
     #[test]
     fn test_load_driver() {
         // This test will only pass if NVIDIA driver is installed
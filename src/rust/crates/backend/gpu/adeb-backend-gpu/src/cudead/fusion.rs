@@ -0,0 +1,739 @@
+// ============================================================
+// CUDead-BIB — Kernel Fusion
+// ============================================================
+// Fusiona lanzamientos productor → consumidor sobre CudeadIR:
+// - cadenas elementwise (scale → bias → relu) en un solo kernel:
+//   el intermedio queda en un registro, no va y vuelve de VRAM
+// - epílogos de reducción: un consumidor elementwise del resultado
+//   por bloque se inserta en el store de la reducción
+// El consumidor se copia justo después del store del productor, con
+// su índice global reemplazado por el índice de ese store.
+// OccupancyCalculator vigila cada fusión.
+// ============================================================
+
+use super::ir::{CudeadIR, CudeadOp, IrType, KernelIR};
+use super::optimizer::{GpuOptimizer, OccupancyCalculator};
+use super::primitives::{Dim3, KernelType};
+use std::collections::{HashMap, HashSet};
+
+/// La ocupación fusionada puede caer como mucho esta fracción por
+/// debajo de la peor de las dos entradas
+pub const MAX_OCCUPANCY_LOSS: f32 = 0.25;
+
+/// Un lanzamiento dentro de una secuencia del host
+#[derive(Debug, Clone)]
+pub struct KernelLaunch {
+    pub kernel: String,
+    /// Valor del host ligado a cada parámetro (id de buffer o escalar):
+    /// ids iguales = mismo buffer
+    pub args: Vec<u32>,
+    pub grid: Dim3,
+    pub block: Dim3,
+}
+
+/// Resultado de `GpuOptimizer::fuse_kernels`
+#[derive(Debug, Clone)]
+pub struct FusionResult {
+    /// Kernels de entrada más los fusionados
+    pub ir: CudeadIR,
+    pub launches: Vec<KernelLaunch>,
+    /// Pares productor/consumidor fusionados
+    pub fused: usize,
+    /// Accesos a memoria global eliminados (loads reenviados y stores
+    /// de intermedios)
+    pub eliminated_accesses: usize,
+}
+
+/// Qué índice direcciona un acceso
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum Index {
+    /// blockIdx.x * blockDim.x + threadIdx.x
+    Global,
+    /// blockIdx.x (un resultado por bloque)
+    Block,
+}
+
+/// Valor simbólico de un registro (solo lo que describe direcciones)
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum Sym {
+    Tid,
+    Bid,
+    BlockDim,
+    /// blockIdx.x * blockDim.x
+    BlockBase,
+    Gid,
+    Int(i64),
+    /// Parámetro puntero
+    Param(u32),
+    /// índice * bytes (registro raíz del índice)
+    Scaled(Index, u64, u32),
+    /// parámetro + índice * bytes
+    Addr(u32, Index, u64, u32),
+    Value,
+}
+
+impl Sym {
+    /// Registros que solo sirven para calcular el índice global
+    fn is_index_plumbing(self) -> bool {
+        matches!(self, Sym::Tid | Sym::Bid | Sym::BlockDim | Sym::BlockBase | Sym::Gid)
+    }
+}
+
+/// Un load o store con dirección conocida
+#[derive(Debug, Clone, Copy)]
+struct Access {
+    param: u32,
+    index: Index,
+    bytes: u64,
+    /// Registro del índice (Gid o Bid) en el kernel que accede
+    root: u32,
+}
+
+fn dst_of(op: &CudeadOp) -> Option<u32> {
+    match op {
+        CudeadOp::Add { dst, .. }
+        | CudeadOp::Sub { dst, .. }
+        | CudeadOp::Mul { dst, .. }
+        | CudeadOp::Div { dst, .. }
+        | CudeadOp::Fma { dst, .. }
+        | CudeadOp::Neg { dst, .. }
+        | CudeadOp::Load { dst, .. }
+        | CudeadOp::LoadShared { dst, .. }
+        | CudeadOp::ThreadIdxX { dst }
+        | CudeadOp::ThreadIdxY { dst }
+        | CudeadOp::ThreadIdxZ { dst }
+        | CudeadOp::BlockIdxX { dst }
+        | CudeadOp::BlockIdxY { dst }
+        | CudeadOp::BlockIdxZ { dst }
+        | CudeadOp::BlockDimX { dst }
+        | CudeadOp::BlockDimY { dst }
+        | CudeadOp::BlockDimZ { dst }
+        | CudeadOp::GridDimX { dst }
+        | CudeadOp::GridDimY { dst }
+        | CudeadOp::GridDimZ { dst }
+        | CudeadOp::Cmp { dst, .. }
+        | CudeadOp::Convert { dst, .. }
+        | CudeadOp::Const { dst, .. }
+        | CudeadOp::LoadParam { dst, .. }
+        | CudeadOp::Phi { dst, .. } => Some(*dst),
+        _ => None,
+    }
+}
+
+fn srcs_of(op: &CudeadOp) -> Vec<u32> {
+    match op {
+        CudeadOp::Add { src1, src2, .. }
+        | CudeadOp::Sub { src1, src2, .. }
+        | CudeadOp::Mul { src1, src2, .. }
+        | CudeadOp::Div { src1, src2, .. }
+        | CudeadOp::Cmp { src1, src2, .. } => vec![*src1, *src2],
+        CudeadOp::Fma { src1, src2, src3, .. } => vec![*src1, *src2, *src3],
+        CudeadOp::Neg { src, .. } | CudeadOp::Convert { src, .. } => vec![*src],
+        CudeadOp::Load { addr, .. } | CudeadOp::LoadShared { addr, .. } => vec![*addr],
+        CudeadOp::Store { addr, src, .. } | CudeadOp::StoreShared { addr, src, .. } => vec![*addr, *src],
+        CudeadOp::BranchCond { cond, .. } => vec![*cond],
+        CudeadOp::Phi { sources, .. } => sources.iter().map(|(value, _)| *value).collect(),
+        _ => Vec::new(),
+    }
+}
+
+/// Copia de `op` con cada registro pasado por `f`
+fn rename(op: &CudeadOp, mut f: impl FnMut(u32) -> u32) -> CudeadOp {
+    let mut op = op.clone();
+    match &mut op {
+        CudeadOp::Add { dst, src1, src2, .. }
+        | CudeadOp::Sub { dst, src1, src2, .. }
+        | CudeadOp::Mul { dst, src1, src2, .. }
+        | CudeadOp::Div { dst, src1, src2, .. }
+        | CudeadOp::Cmp { dst, src1, src2, .. } => {
+            *src1 = f(*src1);
+            *src2 = f(*src2);
+            *dst = f(*dst);
+        }
+        CudeadOp::Fma { dst, src1, src2, src3, .. } => {
+            *src1 = f(*src1);
+            *src2 = f(*src2);
+            *src3 = f(*src3);
+            *dst = f(*dst);
+        }
+        CudeadOp::Neg { dst, src, .. } | CudeadOp::Convert { dst, src, .. } => {
+            *src = f(*src);
+            *dst = f(*dst);
+        }
+        CudeadOp::Load { dst, addr, .. } | CudeadOp::LoadShared { dst, addr, .. } => {
+            *addr = f(*addr);
+            *dst = f(*dst);
+        }
+        CudeadOp::Store { addr, src, .. } | CudeadOp::StoreShared { addr, src, .. } => {
+            *addr = f(*addr);
+            *src = f(*src);
+        }
+        CudeadOp::BranchCond { cond, .. } => *cond = f(*cond),
+        CudeadOp::Phi { dst, sources, .. } => {
+            for (value, _) in sources.iter_mut() {
+                *value = f(*value);
+            }
+            *dst = f(*dst);
+        }
+        CudeadOp::ThreadIdxX { dst }
+        | CudeadOp::ThreadIdxY { dst }
+        | CudeadOp::ThreadIdxZ { dst }
+        | CudeadOp::BlockIdxX { dst }
+        | CudeadOp::BlockIdxY { dst }
+        | CudeadOp::BlockIdxZ { dst }
+        | CudeadOp::BlockDimX { dst }
+        | CudeadOp::BlockDimY { dst }
+        | CudeadOp::BlockDimZ { dst }
+        | CudeadOp::GridDimX { dst }
+        | CudeadOp::GridDimY { dst }
+        | CudeadOp::GridDimZ { dst }
+        | CudeadOp::Const { dst, .. }
+        | CudeadOp::LoadParam { dst, .. } => *dst = f(*dst),
+        CudeadOp::Branch { .. }
+        | CudeadOp::Label { .. }
+        | CudeadOp::Return
+        | CudeadOp::SyncThreads
+        | CudeadOp::MemoryFence => {}
+    }
+    op
+}
+
+fn is_int(ty: IrType) -> bool {
+    matches!(ty, IrType::I32 | IrType::I64 | IrType::U32 | IrType::U64 | IrType::Ptr)
+}
+
+/// Tipo con que se define un registro (para comparar índices)
+fn def_type(kernel: &KernelIR, reg: u32) -> Option<IrType> {
+    kernel.blocks.iter().flat_map(|b| &b.ops).find(|op| dst_of(op) == Some(reg)).map(|op| match op {
+        CudeadOp::Add { ty, .. } | CudeadOp::Mul { ty, .. } | CudeadOp::LoadParam { ty, .. } => *ty,
+        CudeadOp::Convert { to, .. } => *to,
+        CudeadOp::Const { value, .. } => value.ir_type(),
+        _ => IrType::U32,
+    })
+}
+
+/// Valores simbólicos de todos los registros de un kernel
+struct KernelShape {
+    syms: HashMap<u32, Sym>,
+}
+
+impl KernelShape {
+    fn analyze(kernel: &KernelIR) -> Self {
+        let mut syms = HashMap::new();
+        for op in kernel.blocks.iter().flat_map(|b| &b.ops) {
+            let Some(dst) = dst_of(op) else { continue };
+            let sym_of = |r: &u32| syms.get(r).copied().unwrap_or(Sym::Value);
+            let index = |s: Sym, r: u32| match s {
+                Sym::Gid => Some((Index::Global, r)),
+                Sym::Bid => Some((Index::Block, r)),
+                _ => None,
+            };
+            let sym = match op {
+                CudeadOp::ThreadIdxX { .. } => Sym::Tid,
+                CudeadOp::BlockIdxX { .. } => Sym::Bid,
+                CudeadOp::BlockDimX { .. } => Sym::BlockDim,
+                CudeadOp::Const { value, .. } => match value {
+                    super::ir::IrConst::I32(v) => Sym::Int(*v as i64),
+                    super::ir::IrConst::I64(v) => Sym::Int(*v),
+                    super::ir::IrConst::U32(v) => Sym::Int(*v as i64),
+                    super::ir::IrConst::U64(v) => Sym::Int(*v as i64),
+                    _ => Sym::Value,
+                },
+                CudeadOp::LoadParam { param_idx, ty, .. } => {
+                    let pointer = kernel.params.get(*param_idx as usize).map_or(false, |p| p.2);
+                    if pointer || *ty == IrType::Ptr {
+                        Sym::Param(*param_idx)
+                    } else {
+                        Sym::Value
+                    }
+                }
+                CudeadOp::Convert { src, from, to, .. } if is_int(*from) && is_int(*to) => match sym_of(src) {
+                    s @ (Sym::Gid | Sym::Bid | Sym::Int(_) | Sym::Scaled(..) | Sym::Param(_)) => s,
+                    _ => Sym::Value,
+                },
+                CudeadOp::Mul { src1, src2, ty, .. } if is_int(*ty) => match (sym_of(src1), sym_of(src2)) {
+                    (Sym::Bid, Sym::BlockDim) | (Sym::BlockDim, Sym::Bid) => Sym::BlockBase,
+                    (s, Sym::Int(c)) if c > 0 && index(s, *src1).is_some() => {
+                        let (i, r) = index(s, *src1).unwrap();
+                        Sym::Scaled(i, c as u64, r)
+                    }
+                    (Sym::Int(c), s) if c > 0 && index(s, *src2).is_some() => {
+                        let (i, r) = index(s, *src2).unwrap();
+                        Sym::Scaled(i, c as u64, r)
+                    }
+                    _ => Sym::Value,
+                },
+                CudeadOp::Add { src1, src2, ty, .. } if is_int(*ty) => {
+                    let (a, b) = (sym_of(src1), sym_of(src2));
+                    let addr = |p: Sym, off: Sym, off_reg: u32| match (p, off) {
+                        (Sym::Param(p), Sym::Scaled(i, c, r)) => Some(Sym::Addr(p, i, c, r)),
+                        (Sym::Param(p), s) => index(s, off_reg).map(|(i, r)| Sym::Addr(p, i, 1, r)),
+                        _ => None,
+                    };
+                    match (a, b) {
+                        (Sym::BlockBase, Sym::Tid) | (Sym::Tid, Sym::BlockBase) => Sym::Gid,
+                        _ => addr(a, b, *src2).or_else(|| addr(b, a, *src1)).unwrap_or(Sym::Value),
+                    }
+                }
+                _ => Sym::Value,
+            };
+            // SSA: un registro redefinido ya no es un índice fiable
+            if syms.insert(dst, sym).is_some() {
+                syms.insert(dst, Sym::Value);
+            }
+        }
+        KernelShape { syms }
+    }
+
+    fn sym(&self, reg: u32) -> Sym {
+        self.syms.get(&reg).copied().unwrap_or(Sym::Value)
+    }
+
+    /// Dirección de un load/store, si es `param + índice * tamaño`
+    fn access(&self, op: &CudeadOp) -> Option<Access> {
+        let (addr, ty) = match op {
+            CudeadOp::Load { addr, ty, .. } | CudeadOp::Store { addr, ty, .. } => (*addr, *ty),
+            _ => return None,
+        };
+        match self.sym(addr) {
+            Sym::Addr(param, index, bytes, root) if bytes == ty.size() as u64 => {
+                Some(Access { param, index, bytes, root })
+            }
+            _ => None,
+        }
+    }
+
+    /// Consumidor fusionable: un solo bloque, sin shared ni barreras, todo
+    /// acceso a `param[gid]` y el índice usado solo para direccionar
+    fn is_elementwise(&self, kernel: &KernelIR) -> bool {
+        if kernel.blocks.len() != 1 || kernel.shared_memory > 0 || kernel.kernel_type != KernelType::Kernel {
+            return false;
+        }
+        let ops = &kernel.blocks[0].ops;
+        ops.iter().enumerate().all(|(i, op)| {
+            let allowed = match op {
+                CudeadOp::Return => i + 1 == ops.len(),
+                CudeadOp::Load { .. } | CudeadOp::Store { .. } => {
+                    self.access(op).map_or(false, |a| a.index == Index::Global)
+                }
+                CudeadOp::Add { .. }
+                | CudeadOp::Sub { .. }
+                | CudeadOp::Mul { .. }
+                | CudeadOp::Div { .. }
+                | CudeadOp::Fma { .. }
+                | CudeadOp::Neg { .. }
+                | CudeadOp::Cmp { .. }
+                | CudeadOp::Convert { .. }
+                | CudeadOp::Const { .. }
+                | CudeadOp::LoadParam { .. }
+                | CudeadOp::ThreadIdxX { .. }
+                | CudeadOp::BlockIdxX { .. }
+                | CudeadOp::BlockDimX { .. } => true,
+                _ => false,
+            };
+            // Índices y punteros solo alimentan direcciones
+            let dst_sym = dst_of(op).map_or(Sym::Value, |d| self.sym(d));
+            let addr_only = matches!(op, CudeadOp::Load { .. } | CudeadOp::Store { .. });
+            allowed
+                && srcs_of(op).iter().enumerate().all(|(k, &r)| match self.sym(r) {
+                    Sym::Tid | Sym::Bid | Sym::BlockDim | Sym::BlockBase | Sym::Gid | Sym::Param(_) | Sym::Scaled(..) => {
+                        dst_sym != Sym::Value
+                    }
+                    Sym::Addr(..) => addr_only && k == 0,
+                    _ => true,
+                })
+        })
+    }
+}
+
+/// Estimación de registros por hilo: máximo de registros vivos a la vez
+pub fn estimate_registers(kernel: &KernelIR) -> u32 {
+    let mut max_live = 0;
+    for block in &kernel.blocks {
+        let mut last_use = HashMap::new();
+        for (i, op) in block.ops.iter().enumerate() {
+            for r in srcs_of(op) {
+                last_use.insert(r, i);
+            }
+        }
+        let mut live: HashSet<u32> = HashSet::new();
+        for (i, op) in block.ops.iter().enumerate() {
+            for r in srcs_of(op) {
+                if last_use.get(&r) == Some(&i) {
+                    live.remove(&r);
+                }
+            }
+            if let Some(d) = dst_of(op) {
+                if last_use.contains_key(&d) {
+                    live.insert(d);
+                }
+            }
+            max_live = max_live.max(live.len() as u32);
+        }
+    }
+    max_live.max(1)
+}
+
+impl GpuOptimizer {
+    /// Fusiona pares productor → consumidor consecutivos de `launches`.
+    /// `live_out`: buffers que el host lee al final (esos stores se
+    /// mantienen aunque su lector se haya fusionado).
+    pub fn fuse_kernels(&self, ir: &CudeadIR, launches: &[KernelLaunch], live_out: &[u32]) -> FusionResult {
+        let mut result = FusionResult { ir: ir.clone(), launches: Vec::new(), fused: 0, eliminated_accesses: 0 };
+        let mut kernels: HashMap<String, KernelIR> =
+            ir.kernels.iter().map(|k| (k.name.clone(), k.clone())).collect();
+
+        for (i, launch) in launches.iter().enumerate() {
+            let later = &launches[i + 1..];
+            let fused = result.launches.last().and_then(|producer| {
+                let p = kernels.get(&producer.kernel)?;
+                let c = kernels.get(&launch.kernel)?;
+                let live = |buffer: u32| live_out.contains(&buffer) || later.iter().any(|l| l.args.contains(&buffer));
+                self.fuse_pair(p, producer, c, launch, live)
+            });
+            match fused {
+                Some((kernel, fused_launch, eliminated)) => {
+                    result.fused += 1;
+                    result.eliminated_accesses += eliminated;
+                    *result.launches.last_mut().unwrap() = fused_launch;
+                    kernels.insert(kernel.name.clone(), kernel.clone());
+                    result.ir.add_kernel(kernel);
+                }
+                None => result.launches.push(launch.clone()),
+            }
+        }
+        result
+    }
+
+    fn fuse_pair(
+        &self,
+        p: &KernelIR,
+        pl: &KernelLaunch,
+        c: &KernelIR,
+        cl: &KernelLaunch,
+        live: impl Fn(u32) -> bool,
+    ) -> Option<(KernelIR, KernelLaunch, usize)> {
+        let (ps, cs) = (KernelShape::analyze(p), KernelShape::analyze(c));
+        if p.kernel_type != KernelType::Kernel || !cs.is_elementwise(c) {
+            return None;
+        }
+        let arg = |l: &KernelLaunch, param: u32| l.args.get(param as usize).copied();
+        let pointer_args = |k: &KernelIR, l: &KernelLaunch| -> Vec<u32> {
+            k.params.iter().enumerate().filter(|(_, p)| p.2).filter_map(|(i, _)| arg(l, i as u32)).collect()
+        };
+
+        // Qué escribe / lee cada uno (un store opaco del productor puede
+        // tocar cualquiera de sus punteros)
+        let mut p_writes = HashSet::new();
+        let mut p_opaque_loads = false;
+        let mut p_loads = HashSet::new();
+        for op in p.blocks.iter().flat_map(|b| &b.ops) {
+            match (op, ps.access(op)) {
+                (CudeadOp::Store { .. }, Some(a)) => p_writes.extend(arg(pl, a.param)),
+                (CudeadOp::Store { .. }, None) => p_writes.extend(pointer_args(p, pl)),
+                (CudeadOp::Load { .. }, Some(a)) => p_loads.extend(arg(pl, a.param)),
+                (CudeadOp::Load { .. }, None) => p_opaque_loads = true,
+                _ => {}
+            }
+        }
+        let c_ops = &c.blocks[0].ops;
+        let c_access = |store: bool| {
+            c_ops
+                .iter()
+                .filter(move |op| matches!(op, CudeadOp::Store { .. }) == store && matches!(op, CudeadOp::Load { .. } | CudeadOp::Store { .. }))
+                .filter_map(|op| cs.access(op).and_then(|a| arg(cl, a.param)))
+                .collect::<HashSet<u32>>()
+        };
+        let (c_reads, c_writes) = (c_access(false), c_access(true));
+
+        // El intermedio: lo único que el productor escribe y el consumidor lee
+        let mut shared = p_writes.intersection(&c_reads);
+        let x = *shared.next()?;
+        if shared.next().is_some() {
+            return None;
+        }
+        // El consumidor no pisa nada que el productor lea o escriba
+        let p_pointers: HashSet<u32> = pointer_args(p, pl).into_iter().collect();
+        if c_writes.iter().any(|w| *w != x && (p_pointers.contains(w) || p_writes.contains(w))) {
+            return None;
+        }
+
+        // Un único store de X en el productor
+        let mut sites = p.blocks.iter().enumerate().flat_map(|(b, block)| {
+            block.ops.iter().enumerate().filter_map(move |(i, op)| match op {
+                CudeadOp::Store { src, ty, .. } => Some((b, i, *src, *ty, op)),
+                _ => None,
+            })
+        });
+        let mut site = None;
+        for (b, i, value, ty, op) in &mut sites {
+            match ps.access(op) {
+                Some(a) if arg(pl, a.param) == Some(x) => {
+                    if site.is_some() {
+                        return None;
+                    }
+                    site = Some((b, i, value, ty, a));
+                }
+                None if p_pointers.contains(&x) => return None,
+                _ => {}
+            }
+        }
+        let (site_block, site_op, value, store_ty, store) = site?;
+
+        // Geometría: mismo lanzamiento, o un hilo del consumidor por bloque
+        let one_d = |d: &Dim3| d.y == 1 && d.z == 1;
+        let geometry_ok = match store.index {
+            Index::Global => pl.grid == cl.grid && pl.block == cl.block,
+            Index::Block => {
+                one_d(&pl.grid) && one_d(&cl.grid) && one_d(&cl.block) && cl.grid.total() * cl.block.total() == pl.grid.x as u64
+            }
+        };
+        if !geometry_ok {
+            return None;
+        }
+        // Los loads de X del consumidor leen exactamente lo que se guardó
+        let index_ty = def_type(p, store.root);
+        for op in c_ops {
+            if let (CudeadOp::Load { ty, .. }, Some(a)) = (op, cs.access(op)) {
+                if arg(cl, a.param) == Some(x) && (*ty != store_ty || a.bytes != store.bytes) {
+                    return None;
+                }
+            }
+            let feeds_index = |r: &u32| cs.sym(*r) == Sym::Gid;
+            let skipped = dst_of(op).map_or(false, |d| cs.sym(d).is_index_plumbing());
+            if !skipped && srcs_of(op).iter().filter(|r| feeds_index(r)).any(|r| def_type(c, *r) != index_ty) {
+                return None;
+            }
+        }
+
+        // Parámetros: los del productor + los nuevos del consumidor
+        let mut fused = p.clone();
+        fused.name = format!("{}__{}", p.name, c.name);
+        let mut args = pl.args.clone();
+        let mut param_map = HashMap::new();
+        for (q, param) in c.params.iter().enumerate() {
+            let host = arg(cl, q as u32)?;
+            let index = match args.iter().position(|a| *a == host) {
+                Some(existing) if (fused.params[existing].1, fused.params[existing].2) == (param.1, param.2) => existing,
+                Some(_) => return None,
+                None => {
+                    args.push(host);
+                    fused.params.push(param.clone());
+                    fused.params.len() - 1
+                }
+            };
+            param_map.insert(q as u32, index as u32);
+        }
+
+        // Cuerpo del consumidor tras el store, con gid → índice del store
+        let mut regs: HashMap<u32, u32> = HashMap::new();
+        let mut body = Vec::new();
+        let mut eliminated = 0;
+        for op in c_ops {
+            if matches!(op, CudeadOp::Return) {
+                continue;
+            }
+            if let Some(d) = dst_of(op) {
+                if cs.sym(d) == Sym::Gid {
+                    regs.insert(d, store.root);
+                    continue;
+                }
+                if cs.sym(d).is_index_plumbing() {
+                    continue;
+                }
+            }
+            if let (CudeadOp::Load { dst, .. }, Some(a)) = (op, cs.access(op)) {
+                if arg(cl, a.param) == Some(x) {
+                    regs.insert(*dst, value);
+                    eliminated += 1;
+                    continue;
+                }
+            }
+            let op = match op {
+                CudeadOp::LoadParam { dst, param_idx, ty } => {
+                    CudeadOp::LoadParam { dst: *dst, param_idx: param_map[param_idx], ty: *ty }
+                }
+                other => other.clone(),
+            };
+            // SSA: todo registro que no está en `regs` es un destino nuevo
+            let renamed = rename(&op, |r| {
+                if let Some(&mapped) = regs.get(&r) {
+                    return mapped;
+                }
+                let fresh = fused.alloc_reg();
+                regs.insert(r, fresh);
+                fresh
+            });
+            body.push(renamed);
+        }
+
+        // El store de X sobra si nadie más lo lee o el consumidor lo pisa
+        let drop_store = (!live(x) || c_writes.contains(&x)) && !p_loads.contains(&x) && !p_opaque_loads;
+        let ops = &mut fused.blocks[site_block].ops;
+        let insert_at = if drop_store {
+            ops.remove(site_op);
+            eliminated += 1;
+            site_op
+        } else {
+            site_op + 1
+        };
+        ops.splice(insert_at..insert_at, body);
+
+        // Ocupación: la fusión no debe hundir la de ninguna entrada
+        let calc = OccupancyCalculator::new(self.arch());
+        let occupancy = |k: &KernelIR, l: &KernelLaunch| {
+            calc.calculate(l.block.total() as u32, estimate_registers(k), k.shared_memory).occupancy
+        };
+        let worst = occupancy(p, pl).min(occupancy(c, cl));
+        if occupancy(&fused, pl) < worst * (1.0 - MAX_OCCUPANCY_LOSS) {
+            return None;
+        }
+
+        let launch = KernelLaunch { kernel: fused.name.clone(), args, grid: pl.grid, block: pl.block };
+        Some((fused, launch, eliminated))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use super::super::ir::IrConst;
+    use super::super::primitives::KernelDef;
+
+    /// `out[i] = in[i] <op> k` (k escalar del host), registros SSA
+    fn elementwise(name: &str, mul: bool) -> KernelIR {
+        let mut k = KernelIR::new(&KernelDef::new(name, KernelType::Kernel));
+        k.params = vec![
+            ("in".into(), IrType::F32, true),
+            ("out".into(), IrType::F32, true),
+            ("k".into(), IrType::F32, false),
+        ];
+        let gid = global_index(&mut k);
+        let src = element_addr(&mut k, 0, gid);
+        let x = k.alloc_reg();
+        k.emit(CudeadOp::Load { dst: x, addr: src, ty: IrType::F32 });
+        let s = k.alloc_reg();
+        k.emit(CudeadOp::LoadParam { dst: s, param_idx: 2, ty: IrType::F32 });
+        let y = k.alloc_reg();
+        k.emit(if mul {
+            CudeadOp::Mul { dst: y, src1: x, src2: s, ty: IrType::F32 }
+        } else {
+            CudeadOp::Add { dst: y, src1: x, src2: s, ty: IrType::F32 }
+        });
+        let dst = element_addr(&mut k, 1, gid);
+        k.emit(CudeadOp::Store { addr: dst, src: y, ty: IrType::F32 });
+        k.emit(CudeadOp::Return);
+        k
+    }
+
+    fn global_index(k: &mut KernelIR) -> u32 {
+        let (tid, bid, bdim, base, gid) = (k.alloc_reg(), k.alloc_reg(), k.alloc_reg(), k.alloc_reg(), k.alloc_reg());
+        k.emit(CudeadOp::ThreadIdxX { dst: tid });
+        k.emit(CudeadOp::BlockIdxX { dst: bid });
+        k.emit(CudeadOp::BlockDimX { dst: bdim });
+        k.emit(CudeadOp::Mul { dst: base, src1: bid, src2: bdim, ty: IrType::U32 });
+        k.emit(CudeadOp::Add { dst: gid, src1: base, src2: tid, ty: IrType::U32 });
+        gid
+    }
+
+    fn element_addr(k: &mut KernelIR, param: u32, index: u32) -> u32 {
+        let (ptr, four, off, addr) = (k.alloc_reg(), k.alloc_reg(), k.alloc_reg(), k.alloc_reg());
+        k.emit(CudeadOp::LoadParam { dst: ptr, param_idx: param, ty: IrType::Ptr });
+        k.emit(CudeadOp::Const { dst: four, value: IrConst::U32(4) });
+        k.emit(CudeadOp::Mul { dst: off, src1: index, src2: four, ty: IrType::U32 });
+        k.emit(CudeadOp::Add { dst: addr, src1: ptr, src2: off, ty: IrType::U32 });
+        addr
+    }
+
+    fn launch(kernel: &str, args: [u32; 3], grid: u32) -> KernelLaunch {
+        KernelLaunch { kernel: kernel.into(), args: args.to_vec(), grid: Dim3::linear(grid), block: Dim3::linear(256) }
+    }
+
+    fn count(k: &KernelIR, f: impl Fn(&CudeadOp) -> bool) -> usize {
+        k.blocks.iter().flat_map(|b| &b.ops).filter(|op| f(op)).count()
+    }
+
+    #[test]
+    fn test_elementwise_chain_fuses_into_one_kernel() {
+        let mut ir = CudeadIR::new();
+        ir.add_kernel(elementwise("scale", true));
+        ir.add_kernel(elementwise("bias", false));
+        // x(1) → scale → t(2) → bias → y(3); escalares 10 y 11
+        let launches = [launch("scale", [1, 2, 10], 64), launch("bias", [2, 3, 11], 64)];
+        let result = GpuOptimizer::new(super::super::GpuArch::Ampere).fuse_kernels(&ir, &launches, &[3]);
+
+        assert_eq!(result.fused, 1);
+        assert_eq!(result.launches.len(), 1);
+        assert_eq!(result.launches[0].args, [1, 2, 10, 3, 11]);
+        let fused = result.ir.kernels.iter().find(|k| k.name == "scale__bias").unwrap();
+        // El intermedio t nunca toca memoria: 1 load (x) y 1 store (y)
+        assert_eq!(count(fused, |op| matches!(op, CudeadOp::Load { .. })), 1);
+        assert_eq!(count(fused, |op| matches!(op, CudeadOp::Store { .. })), 1);
+        assert_eq!(count(fused, |op| matches!(op, CudeadOp::ThreadIdxX { .. })), 1);
+        assert!(matches!(fused.blocks[0].ops.last(), Some(CudeadOp::Return)));
+        assert_eq!(result.eliminated_accesses, 2);
+    }
+
+    #[test]
+    fn test_live_intermediate_and_mismatched_geometry() {
+        let mut ir = CudeadIR::new();
+        ir.add_kernel(elementwise("scale", true));
+        ir.add_kernel(elementwise("bias", false));
+        let optimizer = GpuOptimizer::new(super::super::GpuArch::Ampere);
+
+        // El host lee t: el store se queda, el load igual se reenvía
+        let launches = [launch("scale", [1, 2, 10], 64), launch("bias", [2, 3, 11], 64)];
+        let result = optimizer.fuse_kernels(&ir, &launches, &[2, 3]);
+        let fused = result.ir.kernels.iter().find(|k| k.name == "scale__bias").unwrap();
+        assert_eq!(count(fused, |op| matches!(op, CudeadOp::Store { .. })), 2);
+        assert_eq!(count(fused, |op| matches!(op, CudeadOp::Load { .. })), 1);
+
+        // Otra geometría o sin dependencia: no se fusiona
+        let launches = [launch("scale", [1, 2, 10], 64), launch("bias", [2, 3, 11], 32)];
+        assert_eq!(optimizer.fuse_kernels(&ir, &launches, &[3]).fused, 0);
+        let launches = [launch("scale", [1, 2, 10], 64), launch("bias", [4, 3, 11], 64)];
+        assert_eq!(optimizer.fuse_kernels(&ir, &launches, &[3]).fused, 0);
+        // El consumidor escribe la entrada del productor
+        let launches = [launch("scale", [1, 2, 10], 64), launch("bias", [2, 1, 11], 64)];
+        assert_eq!(optimizer.fuse_kernels(&ir, &launches, &[1]).fused, 0);
+    }
+
+    #[test]
+    fn test_reduction_epilogue_is_inlined_at_block_store() {
+        // Reducción por bloque (bucle opaco) que guarda out[blockIdx.x]
+        let mut reduce = KernelIR::new(&KernelDef::new("block_sum", KernelType::Kernel));
+        reduce.params = vec![("in".into(), IrType::F32, true), ("out".into(), IrType::F32, true)];
+        reduce.shared_memory = 1024;
+        let tid = reduce.alloc_reg();
+        reduce.emit(CudeadOp::ThreadIdxX { dst: tid });
+        reduce.emit(CudeadOp::SyncThreads);
+        let sum = reduce.alloc_reg();
+        reduce.emit(CudeadOp::LoadShared { dst: sum, addr: tid, ty: IrType::F32 });
+        let done = reduce.new_block();
+        reduce.emit(CudeadOp::Label { id: done });
+        let bid = reduce.alloc_reg();
+        reduce.emit(CudeadOp::BlockIdxX { dst: bid });
+        let out = element_addr(&mut reduce, 1, bid);
+        reduce.emit(CudeadOp::Store { addr: out, src: sum, ty: IrType::F32 });
+        reduce.emit(CudeadOp::Return);
+
+        let mut ir = CudeadIR::new();
+        ir.add_kernel(reduce);
+        ir.add_kernel(elementwise("scale", true));
+        // 128 bloques → 128 resultados → scale con 1 bloque de 128 hilos
+        let launches = [
+            KernelLaunch { kernel: "block_sum".into(), args: vec![1, 2], grid: Dim3::linear(128), block: Dim3::linear(256) },
+            KernelLaunch { kernel: "scale".into(), args: vec![2, 3, 10], grid: Dim3::linear(1), block: Dim3::linear(128) },
+        ];
+        let result = GpuOptimizer::new(super::super::GpuArch::Ampere).fuse_kernels(&ir, &launches, &[3]);
+        assert_eq!(result.fused, 1);
+        let fused = result.ir.kernels.iter().find(|k| k.name == "block_sum__scale").unwrap();
+        let tail = &fused.blocks[1].ops;
+        assert_eq!(count(fused, |op| matches!(op, CudeadOp::Store { .. })), 1);
+        assert!(tail.iter().any(|op| matches!(op, CudeadOp::Mul { src1, ty: IrType::F32, .. } if *src1 == sum)));
+        // Geometría incompatible: sin fusión
+        let mut bad = launches.clone();
+        bad[1].block = Dim3::linear(64);
+        assert_eq!(GpuOptimizer::default().fuse_kernels(&ir, &bad, &[3]).fused, 0);
+    }
+}
@@ -28,6 +28,7 @@ pub mod ub_detector;
 pub mod parser;
 pub mod ir;
 pub mod optimizer;
+pub mod fusion;
 pub mod cli;
 pub mod cuda_driver;
 pub mod runtime;
@@ -39,6 +40,7 @@ pub use ub_detector::*;
 pub use parser::*;
 pub use ir::*;
 pub use optimizer::*;
+pub use fusion::*;
 
 /// CUDead-BIB version
 pub const CUDEAD_VERSION: &str = "1.0.0";
@@ -173,12 +175,17 @@ impl CudeadCompiler {
             println!("[PHASE 1] PARSER");
         }
         let ast = self.parse(source)?;
+        self.compile_ast(&ast)
+    }
 
+    /// Phases 2-6 over an already parsed source. The CUDA driver parses
+    /// once and runs this on its own thread next to the host pipeline.
+    pub fn compile_ast(&self, ast: &CudeadAst) -> Result<CudeadOutput, CudeadError> {
         // Phase 2: Generate IR
         if self.config.step_mode {
             println!("[PHASE 2] IR GENERATION");
         }
-        let ir = self.generate_ir(&ast)?;
+        let ir = self.generate_ir(ast)?;
 
         // Phase 3: UB Detection
         if self.config.ub_detection {
@@ -221,7 +228,7 @@ impl CudeadCompiler {
         })
     }
 
-    fn parse(&self, source: &str) -> Result<CudeadAst, CudeadError> {
+    pub fn parse(&self, source: &str) -> Result<CudeadAst, CudeadError> {
         let parser = CudeadParser::new();
         parser.parse(source)
     }
@@ -21,6 +21,10 @@ impl GpuOptimizer {
         Self { arch }
     }
 
+    pub fn arch(&self) -> GpuArch {
+        self.arch
+    }
+
     /// Optimize IR
     pub fn optimize(&self, ir: &CudeadIR) -> Result<CudeadIR, super::CudeadError> {
         let mut optimized = ir.clone();
@@ -638,6 +638,108 @@ impl CudeadParser {
     }
 }
 
+// ── Host half ───────────────────────────────────────────────
+
+const DEVICE_QUALIFIERS: [&str; 4] = ["__global__", "__device__", "__cudead_kernel__", "__cudead_device__"];
+
+fn is_ident_byte(b: u8) -> bool {
+    b.is_ascii_alphanumeric() || b == b'_'
+}
+
+/// Longitud de un literal o comentario que empieza en `at` (0 si no lo es)
+fn skip_opaque(src: &[u8], at: usize) -> usize {
+    let rest = &src[at..];
+    if rest.starts_with(b"//") {
+        return rest.iter().position(|&b| b == b'\n').unwrap_or(rest.len());
+    }
+    if rest.starts_with(b"/*") {
+        return rest.windows(2).skip(2).position(|w| w == b"*/").map_or(rest.len(), |p| p + 4);
+    }
+    if rest[0] == b'"' || rest[0] == b'\'' {
+        let mut i = 1;
+        while i < rest.len() && rest[i] != rest[0] {
+            i += if rest[i] == b'\\' { 2 } else { 1 };
+        }
+        return (i + 1).min(rest.len());
+    }
+    0
+}
+
+/// Posición justo después del `}` que cierra el `{` en `open`
+fn matching_brace(src: &[u8], open: usize) -> usize {
+    let mut depth = 0;
+    let mut i = open;
+    while i < src.len() {
+        let n = skip_opaque(src, i);
+        if n > 0 {
+            i += n;
+            continue;
+        }
+        match src[i] {
+            b'{' => depth += 1,
+            b'}' => {
+                depth -= 1;
+                if depth == 0 {
+                    return i + 1;
+                }
+            }
+            _ => {}
+        }
+        i += 1;
+    }
+    src.len()
+}
+
+/// Parte host de un `.cu`: el mismo fuente con cada kernel/función device
+/// reducido a su firma con cuerpo vacío y cada lanzamiento `k<<<g, b>>>(..)`
+/// convertido en la llamada `k(..)`. Lo único que comparte con la mitad
+/// device son esas firmas, así que ambas se compilan por separado.
+pub fn host_source(source: &str) -> String {
+    let src = source.as_bytes();
+    let mut out = String::with_capacity(source.len());
+    let mut copied = 0;
+    let mut i = 0;
+    while i < src.len() {
+        let n = skip_opaque(src, i);
+        if n > 0 {
+            i += n;
+            continue;
+        }
+        if src[i..].starts_with(b"<<<") {
+            let end = source[i..].find(">>>").map_or(src.len(), |p| i + p + 3);
+            out.push_str(&source[copied..i]);
+            copied = end;
+            i = end;
+            continue;
+        }
+        let at_word = i == 0 || !is_ident_byte(src[i - 1]);
+        let qualifier = DEVICE_QUALIFIERS.iter().find(|q| {
+            at_word && src[i..].starts_with(q.as_bytes()) && !src.get(i + q.len()).map_or(false, |&b| is_ident_byte(b))
+        });
+        let Some(qualifier) = qualifier else {
+            i += 1;
+            continue;
+        };
+        out.push_str(&source[copied..i]);
+        let decl = i + qualifier.len();
+        // `__device__ float x;` es una variable: sólo cae el calificador
+        let brace = source[decl..].find(|c| c == '{' || c == ';').map(|p| decl + p);
+        match brace {
+            Some(open) if src[open] == b'{' => {
+                let signature = source[decl..open].trim();
+                let returns_void = signature.starts_with("void");
+                out.push_str(signature);
+                out.push_str(if returns_void { " {}" } else { " { return 0; }" });
+                copied = matching_brace(src, open);
+            }
+            _ => copied = decl,
+        }
+        i = copied;
+    }
+    out.push_str(&source[copied..]);
+    out
+}
+
 impl Default for CudeadParser {
     fn default() -> Self {
         Self::new()
@@ -683,4 +785,31 @@ mod tests {
         assert_eq!(ast.kernels[0].name, "vectorAdd");
         assert_eq!(ast.kernels[0].params.len(), 4);
     }
+
+    #[test]
+    fn test_host_source_strips_device_code() {
+        let source = r#"
+__device__ float scale = 2.0;
+__device__ float twice(float x) { return x * scale; }
+__global__ void fill(float *out, int n) {
+    int i = threadIdx.x;
+    if (i < n) { out[i] = twice(1.0); }
+}
+int main() {
+    // fill<<<1, 1>>> en un comentario no cuenta
+    const char *msg = "__global__ {";
+    fill<<<1, 32>>>(0, 32);
+    return 0;
+}
+"#;
+        let host = host_source(source);
+        assert!(host.contains("float scale = 2.0;"));
+        assert!(host.contains("float twice(float x) { return 0; }"));
+        assert!(host.contains("void fill(float *out, int n) {}"));
+        assert!(host.contains("    fill(0, 32);"));
+        assert!(host.contains("// fill<<<1, 1>>> en un comentario no cuenta"));
+        assert!(host.contains("\"__global__ {\""));
+        assert!(!host.contains("threadIdx"));
+        assert!(host.trim_end().ends_with("return 0;\n}"));
+    }
 }
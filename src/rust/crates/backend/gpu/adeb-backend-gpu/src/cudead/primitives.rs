@@ -22,7 +22,7 @@
 use std::collections::HashMap;
 
 /// Dimensiones de grid/block (x, y, z)
-#[derive(Debug, Clone, Copy, Default)]
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
 pub struct Dim3 {
     pub x: u32,
     pub y: u32,
@@ -421,7 +421,7 @@ impl Default for PtxEmitter {
 #[cfg(test)]
 mod tests {
     use super::*;
-    use crate::backend::gpu::cudead::primitives::KernelDef;
+    use crate::cudead::primitives::KernelDef;
 
     #[test]
     fn test_ptx_header() {
@@ -443,7 +443,7 @@ mod tests {
         };
 
         let emitter = PtxEmitter::new(GpuArch::Ampere);
-        let ptx = emitter.emit_ir(&ir).unwrap();
+        let ptx = emitter.emit(&ir).unwrap();
         assert!(ptx.contains(".entry test"));
     }
 }
@@ -1,20 +1,126 @@
-// ADead-BIB HIP-CPU fallback stub
+// ============================================================
+// ADead-BIB - HIP-CPU: kernels HIP/CUDA ejecutados en CPU
+// ============================================================
+// Motor de ejecución:
+//
+// - Cada bloque del grid es una tarea. Los bloques se reparten en
+//   rangos contiguos, uno por worker; el que vacía su rango le roba la
+//   mitad final al rango de otro (work stealing sin colas).
+// - Sin barreras, los hilos de un bloque van de a LANES (8 f32 = un
+//   YMM): `launch_kernel_lanes` entrega 8 hilos consecutivos en x para
+//   que el kernel escriba bucles de trip count fijo que LLVM vectoriza.
+//   vector_add, saxpy, reduce_sum y matmul usan AVX2/FMA directamente
+//   si el CPU lo tiene.
+// - __syncthreads por region splitting: el kernel se parte en fases en
+//   cada barrera y cada fase corre para todos los hilos del bloque antes
+//   de la siguiente. La memoria __shared__ es un estado por bloque.
+// ============================================================
 
-#[derive(Debug, Clone, Copy, Default)]
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Mutex;
+
+#[cfg(target_arch = "x86_64")]
+use std::arch::x86_64::*;
+
+/// Hilos de un bloque por grupo SIMD (f32 en un YMM)
+pub const LANES: usize = 8;
+
+/// Elementos por tarea en las operaciones vectoriales built-in
+const VECTOR_CHUNK: usize = 16 * 1024;
+/// Filas de C por tarea y profundidad de K por pasada en matmul
+const MATMUL_ROWS: usize = 8;
+const MATMUL_KC: usize = 256;
+
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
 pub struct Dim3 {
     pub x: u32,
     pub y: u32,
     pub z: u32,
 }
 
-#[derive(Debug, Clone, Default)]
-pub struct HipCpuConfig;
+impl Dim3 {
+    pub fn new(x: u32, y: u32, z: u32) -> Self {
+        Dim3 { x, y, z }
+    }
+
+    /// Número total de elementos (x·y·z)
+    pub fn count(&self) -> usize {
+        self.x as usize * self.y as usize * self.z as usize
+    }
 
-#[derive(Debug, Default)]
-pub struct HipCpuRuntime;
+    /// Índice lineal (x más rápido) → coordenadas
+    fn unlinear(&self, index: usize) -> Dim3 {
+        let (x, y) = (self.x.max(1) as usize, self.y.max(1) as usize);
+        Dim3::new((index % x) as u32, (index / x % y) as u32, (index / (x * y)) as u32)
+    }
+}
+
+impl From<u32> for Dim3 {
+    fn from(x: u32) -> Self {
+        Dim3::new(x, 1, 1)
+    }
+}
+
+impl From<(u32, u32)> for Dim3 {
+    fn from((x, y): (u32, u32)) -> Self {
+        Dim3::new(x, y, 1)
+    }
+}
+
+impl From<(u32, u32, u32)> for Dim3 {
+    fn from((x, y, z): (u32, u32, u32)) -> Self {
+        Dim3::new(x, y, z)
+    }
+}
+
+#[derive(Debug, Clone)]
+pub struct HipCpuConfig {
+    /// Workers (0 = ADEB_JOBS / núcleos)
+    pub num_threads: usize,
+    /// Usar AVX2/FMA en las operaciones built-in si el CPU lo tiene
+    pub enable_simd: bool,
+    /// Bloque por defecto de `parallel_for`
+    pub block_size: (u32, u32, u32),
+    pub verbose: bool,
+}
+
+impl Default for HipCpuConfig {
+    fn default() -> Self {
+        Self {
+            num_threads: 0,
+            enable_simd: true,
+            block_size: (256, 1, 1),
+            verbose: false,
+        }
+    }
+}
+
+/// Contadores acumulados del runtime
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct HipCpuStats {
+    pub kernels_launched: u64,
+    pub blocks_executed: u64,
+    /// Bloques que corrió un worker distinto al que los tenía asignados
+    pub blocks_stolen: u64,
+    pub threads_executed: u64,
+}
+
+#[derive(Debug)]
+pub struct HipCpuRuntime {
+    config: HipCpuConfig,
+    workers: usize,
+    simd: bool,
+    kernels: AtomicU64,
+    blocks: AtomicU64,
+    stolen: AtomicU64,
+    threads: AtomicU64,
+}
 
-#[derive(Debug, Clone, Default)]
-pub struct HipCpuStats;
+impl Default for HipCpuRuntime {
+    fn default() -> Self {
+        Self::new(HipCpuConfig::default())
+    }
+}
 
 #[derive(Debug, Clone, Copy)]
 pub struct SendPtr<T>(pub *mut T);
@@ -22,9 +128,521 @@ pub struct SendPtr<T>(pub *mut T);
 unsafe impl<T> Send for SendPtr<T> {}
 unsafe impl<T> Sync for SendPtr<T> {}
 
+impl<T> SendPtr<T> {
+    pub fn new(ptr: *mut T) -> Self {
+        SendPtr(ptr)
+    }
+
+    /// Para buffers de solo lectura
+    pub fn from_const(ptr: *const T) -> Self {
+        SendPtr(ptr as *mut T)
+    }
+
+    /// # Safety
+    /// `index` dentro del buffer original
+    pub unsafe fn read(&self, index: usize) -> T
+    where
+        T: Copy,
+    {
+        *self.0.add(index)
+    }
+
+    /// # Safety
+    /// `index` dentro del buffer original y sin otro hilo escribiéndolo
+    pub unsafe fn write(&self, index: usize, value: T) {
+        *self.0.add(index) = value;
+    }
+
+    /// # Safety
+    /// Tramo dentro del buffer y disjunto de los que usen otros hilos
+    pub unsafe fn slice_mut<'a>(&self, start: usize, len: usize) -> &'a mut [T] {
+        std::slice::from_raw_parts_mut(self.0.add(start), len)
+    }
+}
+
+/// Un hilo del kernel: threadIdx (x, y, z) más las dimensiones del lanzamiento
 #[derive(Debug, Clone, Copy, Default)]
 pub struct ThreadIdx {
     pub x: u32,
     pub y: u32,
     pub z: u32,
+    /// blockIdx
+    pub block: Dim3,
+    /// blockDim
+    pub block_dim: Dim3,
+    /// gridDim
+    pub grid_dim: Dim3,
+}
+
+impl ThreadIdx {
+    /// blockIdx.x * blockDim.x + threadIdx.x
+    pub fn global_x(&self) -> u32 {
+        self.block.x * self.block_dim.x + self.x
+    }
+
+    pub fn global_y(&self) -> u32 {
+        self.block.y * self.block_dim.y + self.y
+    }
+
+    pub fn global_z(&self) -> u32 {
+        self.block.z * self.block_dim.z + self.z
+    }
+
+    /// Índice lineal del hilo dentro del bloque
+    pub fn linear(&self) -> usize {
+        let d = self.block_dim;
+        (self.z as usize * d.y as usize + self.y as usize) * d.x as usize + self.x as usize
+    }
+}
+
+/// Hasta LANES hilos consecutivos en x de un bloque (`first` es el primero)
+#[derive(Debug, Clone, Copy)]
+pub struct ThreadLanes {
+    pub first: ThreadIdx,
+    /// Lanes válidos (< LANES solo al final de una fila del bloque)
+    pub active: u32,
+}
+
+impl ThreadLanes {
+    pub fn thread(&self, lane: u32) -> ThreadIdx {
+        ThreadIdx { x: self.first.x + lane, ..self.first }
+    }
+
+    /// global_x de cada lane
+    pub fn global_x(&self) -> [u32; LANES] {
+        let base = self.first.global_x();
+        std::array::from_fn(|lane| base + lane as u32)
+    }
+}
+
+/// Kernel en fases separadas por __syncthreads; `S` es la memoria
+/// __shared__ del bloque
+pub type KernelPhase<'a, S> = &'a (dyn Fn(ThreadIdx, &mut S) + Sync);
+
+impl HipCpuRuntime {
+    pub fn new(config: HipCpuConfig) -> Self {
+        let workers = if config.num_threads == 0 {
+            adeb_core::parallel::default_jobs()
+        } else {
+            config.num_threads
+        };
+        let simd = config.enable_simd && has_avx2_fma();
+        if config.verbose {
+            println!("[HIP-CPU] {} workers, SIMD {}", workers, if simd { "AVX2/FMA" } else { "off" });
+        }
+        HipCpuRuntime {
+            config,
+            workers,
+            simd,
+            kernels: AtomicU64::new(0),
+            blocks: AtomicU64::new(0),
+            stolen: AtomicU64::new(0),
+            threads: AtomicU64::new(0),
+        }
+    }
+
+    pub fn num_threads(&self) -> usize {
+        self.workers
+    }
+
+    /// ¿Las operaciones built-in usan AVX2/FMA?
+    pub fn simd_enabled(&self) -> bool {
+        self.simd
+    }
+
+    pub fn stats(&self) -> HipCpuStats {
+        HipCpuStats {
+            kernels_launched: self.kernels.load(Ordering::Relaxed),
+            blocks_executed: self.blocks.load(Ordering::Relaxed),
+            blocks_stolen: self.stolen.load(Ordering::Relaxed),
+            threads_executed: self.threads.load(Ordering::Relaxed),
+        }
+    }
+
+    /// Corre `run(bloque)` para cada bloque en `0..total` sobre los workers
+    fn run_blocks(&self, total: usize, run: impl Fn(usize) + Sync) {
+        self.kernels.fetch_add(1, Ordering::Relaxed);
+        self.blocks.fetch_add(total as u64, Ordering::Relaxed);
+        let workers = self.workers.min(total);
+        if workers <= 1 {
+            (0..total).for_each(run);
+            return;
+        }
+
+        // Rango [inicio, fin) pendiente de cada worker
+        let ranges: Vec<Mutex<(usize, usize)>> = (0..workers)
+            .map(|w| Mutex::new((total * w / workers, total * (w + 1) / workers)))
+            .collect();
+        let (ranges, run) = (&ranges, &run);
+        std::thread::scope(|scope| {
+            for w in 0..workers {
+                scope.spawn(move || loop {
+                    let next = {
+                        let mut own = ranges[w].lock().unwrap();
+                        (own.0 < own.1).then(|| {
+                            own.0 += 1;
+                            own.0 - 1
+                        })
+                    };
+                    match next {
+                        Some(block) => run(block),
+                        None => match self.steal(ranges, w) {
+                            Some(stolen) => {
+                                self.stolen.fetch_add((stolen.1 - stolen.0) as u64, Ordering::Relaxed);
+                                *ranges[w].lock().unwrap() = stolen;
+                            }
+                            None => break,
+                        },
+                    }
+                });
+            }
+        });
+    }
+
+    /// Mitad final del primer rango ajeno con trabajo
+    fn steal(&self, ranges: &[Mutex<(usize, usize)>], thief: usize) -> Option<(usize, usize)> {
+        (1..ranges.len()).find_map(|offset| {
+            let mut victim = ranges[(thief + offset) % ranges.len()].lock().unwrap();
+            let left = victim.1 - victim.0;
+            (left > 0).then(|| {
+                let mid = victim.1 - left.div_ceil(2);
+                let stolen = (mid, victim.1);
+                victim.1 = mid;
+                stolen
+            })
+        })
+    }
+
+    /// Hilos de un bloque en orden x → y → z
+    fn for_each_thread(grid: Dim3, block: Dim3, block_idx: Dim3, mut f: impl FnMut(ThreadIdx)) {
+        for z in 0..block.z {
+            for y in 0..block.y {
+                for x in 0..block.x {
+                    f(ThreadIdx { x, y, z, block: block_idx, block_dim: block, grid_dim: grid });
+                }
+            }
+        }
+    }
+
+    /// `kernel(i)` para cada `i` en `0..n`, en bloques de `block_size.x`
+    pub fn parallel_for<F>(&self, n: usize, kernel: F)
+    where
+        F: Fn(usize) + Sync + Send,
+    {
+        let chunk = (self.config.block_size.0 as usize).max(1);
+        self.threads.fetch_add(n as u64, Ordering::Relaxed);
+        self.run_blocks(n.div_ceil(chunk), |block| {
+            (block * chunk..n.min((block + 1) * chunk)).for_each(&kernel);
+        });
+    }
+
+    /// <<<grid, block>>> sin barreras: un hilo por llamada
+    pub fn launch_kernel<F>(&self, grid: Dim3, block: Dim3, kernel: F)
+    where
+        F: Fn(ThreadIdx) + Sync + Send,
+    {
+        self.log_launch("kernel", grid, block);
+        self.threads.fetch_add((grid.count() * block.count()) as u64, Ordering::Relaxed);
+        self.run_blocks(grid.count(), |b| {
+            Self::for_each_thread(grid, block, grid.unlinear(b), &kernel);
+        });
+    }
+
+    /// <<<grid, block>>> sin barreras, de a LANES hilos consecutivos en x
+    pub fn launch_kernel_lanes<F>(&self, grid: Dim3, block: Dim3, kernel: F)
+    where
+        F: Fn(ThreadLanes) + Sync + Send,
+    {
+        self.log_launch("lanes", grid, block);
+        self.threads.fetch_add((grid.count() * block.count()) as u64, Ordering::Relaxed);
+        self.run_blocks(grid.count(), |b| {
+            let block_idx = grid.unlinear(b);
+            for z in 0..block.z {
+                for y in 0..block.y {
+                    for x in (0..block.x).step_by(LANES) {
+                        let first = ThreadIdx { x, y, z, block: block_idx, block_dim: block, grid_dim: grid };
+                        kernel(ThreadLanes { first, active: (block.x - x).min(LANES as u32) });
+                    }
+                }
+            }
+        });
+    }
+
+    /// <<<grid, block>>> con __syncthreads: `phases[i]` corre para todos
+    /// los hilos del bloque antes de `phases[i + 1]`. `shared()` crea la
+    /// memoria __shared__ de cada bloque.
+    pub fn launch_kernel_with_barriers<S, I>(&self, grid: Dim3, block: Dim3, shared: I, phases: &[KernelPhase<S>])
+    where
+        I: Fn() -> S + Sync,
+    {
+        self.log_launch("barriers", grid, block);
+        self.threads.fetch_add((grid.count() * block.count()) as u64, Ordering::Relaxed);
+        self.run_blocks(grid.count(), |b| {
+            let block_idx = grid.unlinear(b);
+            let mut state = shared();
+            for phase in phases {
+                Self::for_each_thread(grid, block, block_idx, |t| phase(t, &mut state));
+            }
+        });
+    }
+
+    fn log_launch(&self, kind: &str, grid: Dim3, block: Dim3) {
+        if self.config.verbose {
+            println!(
+                "[HIP-CPU] {} <<<({},{},{}), ({},{},{})>>> on {} workers",
+                kind, grid.x, grid.y, grid.z, block.x, block.y, block.z, self.workers
+            );
+        }
+    }
+
+    /// Corre `f(inicio, fin)` sobre tramos de VECTOR_CHUNK elementos
+    fn for_chunks(&self, n: usize, f: impl Fn(usize, usize) + Sync) {
+        self.threads.fetch_add(n as u64, Ordering::Relaxed);
+        self.run_blocks(n.div_ceil(VECTOR_CHUNK), |chunk| {
+            let start = chunk * VECTOR_CHUNK;
+            f(start, n.min(start + VECTOR_CHUNK));
+        });
+    }
+
+    /// c = a + b
+    pub fn vector_add(&self, a: &[f32], b: &[f32], c: &mut [f32]) {
+        assert!(a.len() == c.len() && b.len() == c.len());
+        let out = SendPtr::new(c.as_mut_ptr());
+        let simd = self.simd;
+        self.for_chunks(c.len(), |start, end| {
+            // Tramos disjuntos: cada tarea escribe solo el suyo
+            let c = unsafe { out.slice_mut(start, end - start) };
+            add_slices(simd, &a[start..end], &b[start..end], c);
+        });
+    }
+
+    /// y = alpha·x + y
+    pub fn saxpy(&self, alpha: f32, x: &[f32], y: &mut [f32]) {
+        assert_eq!(x.len(), y.len());
+        let out = SendPtr::new(y.as_mut_ptr());
+        let simd = self.simd;
+        self.for_chunks(y.len(), |start, end| {
+            let y = unsafe { out.slice_mut(start, end - start) };
+            axpy_slices(simd, alpha, &x[start..end], y);
+        });
+    }
+
+    /// Suma de `data`; el orden de las sumas parciales no depende de qué
+    /// worker corrió cada tramo
+    pub fn reduce_sum(&self, data: &[f32]) -> f32 {
+        let mut partials = vec![0.0f32; data.len().div_ceil(VECTOR_CHUNK)];
+        let out = SendPtr::new(partials.as_mut_ptr());
+        let simd = self.simd;
+        self.for_chunks(data.len(), |start, end| unsafe {
+            out.write(start / VECTOR_CHUNK, sum_slice(simd, &data[start..end]));
+        });
+        partials.iter().sum()
+    }
+
+    /// C[m×n] = A[m×k]·B[k×n], row-major. Cada tarea hace MATMUL_ROWS
+    /// filas de C en pasadas de MATMUL_KC filas de B (que quedan en L2).
+    pub fn matmul_tiled(&self, a: &[f32], b: &[f32], c: &mut [f32], m: usize, n: usize, k: usize) {
+        assert!(a.len() >= m * k && b.len() >= k * n && c.len() >= m * n);
+        let out = SendPtr::new(c.as_mut_ptr());
+        let simd = self.simd;
+        self.threads.fetch_add((m * n) as u64, Ordering::Relaxed);
+        self.run_blocks(m.div_ceil(MATMUL_ROWS), |tile| {
+            let rows = tile * MATMUL_ROWS..m.min((tile + 1) * MATMUL_ROWS);
+            let c = unsafe { out.slice_mut(rows.start * n, rows.len() * n) };
+            c.fill(0.0);
+            for kk in (0..k).step_by(MATMUL_KC) {
+                for (i, c_row) in rows.clone().zip(c.chunks_exact_mut(n.max(1))) {
+                    for p in kk..k.min(kk + MATMUL_KC) {
+                        axpy_slices(simd, a[i * k + p], &b[p * n..(p + 1) * n], c_row);
+                    }
+                }
+            }
+        });
+    }
+}
+
+// ============================================================
+// Kernels SIMD (8 lanes por YMM) con fallback escalar
+// ============================================================
+
+fn has_avx2_fma() -> bool {
+    #[cfg(target_arch = "x86_64")]
+    {
+        is_x86_feature_detected!("avx2") && is_x86_feature_detected!("fma")
+    }
+    #[cfg(not(target_arch = "x86_64"))]
+    {
+        false
+    }
+}
+
+fn add_slices(simd: bool, a: &[f32], b: &[f32], c: &mut [f32]) {
+    #[cfg(target_arch = "x86_64")]
+    if simd {
+        return unsafe { add_avx2(a, b, c) };
+    }
+    let _ = simd;
+    for ((c, a), b) in c.iter_mut().zip(a).zip(b) {
+        *c = a + b;
+    }
+}
+
+fn axpy_slices(simd: bool, alpha: f32, x: &[f32], y: &mut [f32]) {
+    #[cfg(target_arch = "x86_64")]
+    if simd {
+        return unsafe { axpy_avx2(alpha, x, y) };
+    }
+    let _ = simd;
+    for (y, x) in y.iter_mut().zip(x) {
+        *y += alpha * x;
+    }
+}
+
+fn sum_slice(simd: bool, data: &[f32]) -> f32 {
+    #[cfg(target_arch = "x86_64")]
+    if simd {
+        return unsafe { sum_avx2(data) };
+    }
+    let _ = simd;
+    data.iter().sum()
+}
+
+#[cfg(target_arch = "x86_64")]
+#[target_feature(enable = "avx2,fma")]
+unsafe fn add_avx2(a: &[f32], b: &[f32], c: &mut [f32]) {
+    let n = c.len().min(a.len()).min(b.len());
+    let body = n - n % LANES;
+    for i in (0..body).step_by(LANES) {
+        let v = _mm256_add_ps(_mm256_loadu_ps(a.as_ptr().add(i)), _mm256_loadu_ps(b.as_ptr().add(i)));
+        _mm256_storeu_ps(c.as_mut_ptr().add(i), v);
+    }
+    for i in body..n {
+        c[i] = a[i] + b[i];
+    }
+}
+
+#[cfg(target_arch = "x86_64")]
+#[target_feature(enable = "avx2,fma")]
+unsafe fn axpy_avx2(alpha: f32, x: &[f32], y: &mut [f32]) {
+    let n = y.len().min(x.len());
+    let body = n - n % LANES;
+    let va = _mm256_set1_ps(alpha);
+    for i in (0..body).step_by(LANES) {
+        let py = y.as_mut_ptr().add(i);
+        _mm256_storeu_ps(py, _mm256_fmadd_ps(va, _mm256_loadu_ps(x.as_ptr().add(i)), _mm256_loadu_ps(py)));
+    }
+    for i in body..n {
+        y[i] += alpha * x[i];
+    }
+}
+
+#[cfg(target_arch = "x86_64")]
+#[target_feature(enable = "avx2,fma")]
+unsafe fn sum_avx2(data: &[f32]) -> f32 {
+    // Dos acumuladores para no quedar atados a la latencia de vaddps
+    let body = data.len() - data.len() % (2 * LANES);
+    let (mut s0, mut s1) = (_mm256_setzero_ps(), _mm256_setzero_ps());
+    for i in (0..body).step_by(2 * LANES) {
+        s0 = _mm256_add_ps(s0, _mm256_loadu_ps(data.as_ptr().add(i)));
+        s1 = _mm256_add_ps(s1, _mm256_loadu_ps(data.as_ptr().add(i + LANES)));
+    }
+    let mut lanes = [0.0f32; LANES];
+    _mm256_storeu_ps(lanes.as_mut_ptr(), _mm256_add_ps(s0, s1));
+    lanes.iter().sum::<f32>() + data[body..].iter().sum::<f32>()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn runtime(threads: usize, simd: bool) -> HipCpuRuntime {
+        HipCpuRuntime::new(HipCpuConfig { num_threads: threads, enable_simd: simd, ..Default::default() })
+    }
+
+    #[test]
+    fn test_launch_covers_every_thread_once() {
+        let rt = runtime(4, true);
+        let (grid, block) = (Dim3::new(5, 3, 2), Dim3::new(7, 2, 1));
+        let (w, h) = (35, 6);
+        let mut hits = vec![0u32; w * h * 2];
+        let out = SendPtr::new(hits.as_mut_ptr());
+        rt.launch_kernel(grid, block, |t| unsafe {
+            let i = (t.block.z as usize * h + t.global_y() as usize) * w + t.global_x() as usize;
+            out.write(i, out.read(i) + 1);
+        });
+        assert!(hits.iter().all(|&n| n == 1));
+
+        let mut lanes = vec![0u32; 100];
+        let out = SendPtr::new(lanes.as_mut_ptr());
+        rt.launch_kernel_lanes(Dim3::from(4), Dim3::from(25), |l| {
+            for (lane, g) in l.global_x().into_iter().enumerate().take(l.active as usize) {
+                unsafe { out.write(g as usize, lane as u32 + 1) };
+            }
+        });
+        assert!(lanes.iter().all(|&n| n >= 1));
+        assert_eq!(&lanes[24..26], &[1, 1]); // fin de fila del bloque, nuevo bloque
+        assert_eq!(rt.stats().threads_executed, 420 + 100);
+    }
+
+    #[test]
+    fn test_syncthreads_phases() {
+        // Invierte cada bloque a través de memoria __shared__: la fase 2
+        // lee lo que escribieron otros hilos en la fase 1
+        let rt = runtime(3, true);
+        let input: Vec<u32> = (0..256).collect();
+        let mut output = vec![0u32; 256];
+        let (src, dst) = (SendPtr::from_const(input.as_ptr()), SendPtr::new(output.as_mut_ptr()));
+        let load = |t: ThreadIdx, s: &mut Vec<u32>| s[t.x as usize] = unsafe { src.read(t.global_x() as usize) };
+        let store = |t: ThreadIdx, s: &mut Vec<u32>| unsafe {
+            dst.write(t.global_x() as usize, s[(t.block_dim.x - 1 - t.x) as usize]);
+        };
+        rt.launch_kernel_with_barriers(Dim3::from(4), Dim3::from(64), || vec![0u32; 64], &[&load, &store]);
+        for (i, v) in output.iter().enumerate() {
+            assert_eq!(*v as usize, i / 64 * 64 + 63 - i % 64);
+        }
+    }
+
+    #[test]
+    fn test_idle_workers_steal_blocks() {
+        let rt = runtime(4, true);
+        rt.launch_kernel(Dim3::from(64), Dim3::from(1), |t| {
+            // El rango del worker 0 es lento: los otros le roban
+            if t.block.x < 16 {
+                std::thread::sleep(std::time::Duration::from_millis(2));
+            }
+        });
+        let stats = rt.stats();
+        assert_eq!(stats.blocks_executed, 64);
+        assert!(stats.blocks_stolen > 0, "{:?}", stats);
+    }
+
+    #[test]
+    fn test_builtin_ops_match_scalar() {
+        let n = 3 * VECTOR_CHUNK + 13;
+        let a: Vec<f32> = (0..n).map(|i| (i % 97) as f32 * 0.5).collect();
+        let b: Vec<f32> = (0..n).map(|i| (i % 31) as f32).collect();
+        for simd in [false, true] {
+            let rt = runtime(4, simd);
+            let mut c = vec![0.0f32; n];
+            rt.vector_add(&a, &b, &mut c);
+            assert!(c.iter().enumerate().all(|(i, &v)| v == a[i] + b[i]));
+            let mut y = b.clone();
+            rt.saxpy(2.0, &a, &mut y);
+            assert!(y.iter().enumerate().all(|(i, &v)| v == 2.0 * a[i] + b[i]));
+            let exact: f64 = a.iter().map(|&v| v as f64).sum();
+            assert!((rt.reduce_sum(&a) as f64 - exact).abs() / exact < 1e-5);
+
+            let (m, k, nn) = (19, 300, 21);
+            let ma: Vec<f32> = (0..m * k).map(|i| (i % 7) as f32).collect();
+            let mb: Vec<f32> = (0..k * nn).map(|i| (i % 5) as f32).collect();
+            let mut mc = vec![1.0f32; m * nn];
+            rt.matmul_tiled(&ma, &mb, &mut mc, m, nn, k);
+            for i in 0..m {
+                for j in 0..nn {
+                    let expected: f32 = (0..k).map(|p| ma[i * k + p] * mb[p * nn + j]).sum();
+                    assert_eq!(mc[i * nn + j], expected, "({}, {})", i, j);
+                }
+            }
+        }
+    }
 }
@@ -18,7 +18,9 @@ pub mod cuda_to_hip;
 pub mod hip_cpu;
 pub mod hip_runtime;
 
-pub use hip_cpu::{Dim3, HipCpuConfig, HipCpuRuntime, HipCpuStats, SendPtr, ThreadIdx};
+pub use hip_cpu::{
+    Dim3, HipCpuConfig, HipCpuRuntime, HipCpuStats, KernelPhase, SendPtr, ThreadIdx, ThreadLanes, LANES,
+};
 pub use hip_runtime::{
     detect_hip_backend, get_device_info, print_hip_info, HipBackend, HipCodeGen, HipDeviceInfo,
     HipKernel,
@@ -6,7 +6,14 @@ pub mod cudead;
 pub mod spirv;
 pub mod wgsl;
 pub mod hip;
+pub mod metrics;
+pub mod autotune;
+pub mod scheduler;
+pub mod memory;
 
 // Re-exports
 pub use cudead::{CudeadDriver, PtxEmitter, KernelDef};
 pub use spirv::bytecode::{BytecodeToSpirV, ADeadGpuOp, ADeadGpuInstr};
+pub use metrics::{GpuMetrics, GpuProfiler, PerformanceEstimator};
+pub use scheduler::{CommandBuffer, Dispatch, GpuScheduler};
+pub use memory::{BufferUsage, GpuAllocator, MemoryType};
@@ -4,9 +4,21 @@
 //
 // Filosofía: "¿Dónde viven los datos? ¿Quién sincroniza? ¿Cómo minimizar transferencias?"
 //
+// Cada heap (device / host) es un rango grande que se sub-asigna:
+//   - buffers chicos (≤ 64 KiB): pools por clase de tamaño (potencias
+//     de 2), slots reciclados sin tocar el heap
+//   - el resto: best-fit sobre una free-list ordenada por tamaño, con
+//     fusión de vecinos al liberar
+// La alineación de cada buffer (`with_alignment`) se respeta en ambos.
+// `compact` desliza los buffers vivos hacia abajo en frames ociosos y
+// devuelve las copias a grabar.
+//
+// `UploadPipeline` reparte un RingBuffer de staging en tramos por frame
+// para que la subida del frame N+1 se solape con el compute del N.
+//
 // Autor: Eddi Andreé Salazar Matos
 
-use std::collections::HashMap;
+use std::collections::{BTreeMap, BTreeSet, HashMap};
 
 /// Tipo de memoria GPU
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -91,16 +103,230 @@ impl BufferDescriptor {
     }
 }
 
-/// Allocator de memoria GPU - Simple bump allocator
+/// Buffers hasta este tamaño salen de un pool por clase de tamaño
+pub const MAX_POOLED_SIZE: u64 = 64 * 1024;
+/// Clase de tamaño más chica (y alineación mínima de un slot)
+const MIN_POOL_CLASS: u64 = 256;
+/// Bytes que un pool toma del heap cada vez que se queda sin slots
+/// (como mucho 1/16 del heap, para no acaparar heaps chicos)
+const POOL_CHUNK_SIZE: u64 = 1024 * 1024;
+
+fn align_up(value: u64, alignment: u64) -> u64 {
+    (value + alignment - 1) & !(alignment - 1)
+}
+
+/// Sub-allocator de un rango: bloques libres por offset (para fusionar
+/// vecinos) y por (tamaño, offset) para best-fit en O(log n)
+#[derive(Debug, Clone)]
+pub struct HeapAllocator {
+    pub size: u64,
+    by_offset: BTreeMap<u64, u64>,
+    by_size: BTreeSet<(u64, u64)>,
+    free_bytes: u64,
+}
+
+impl HeapAllocator {
+    pub fn new(size: u64) -> Self {
+        let mut heap = HeapAllocator {
+            size,
+            by_offset: BTreeMap::new(),
+            by_size: BTreeSet::new(),
+            free_bytes: 0,
+        };
+        heap.insert_free(0, size);
+        heap
+    }
+
+    fn insert_free(&mut self, offset: u64, size: u64) {
+        if size > 0 {
+            self.by_offset.insert(offset, size);
+            self.by_size.insert((size, offset));
+            self.free_bytes += size;
+        }
+    }
+
+    fn remove_free(&mut self, offset: u64, size: u64) {
+        self.by_offset.remove(&offset);
+        self.by_size.remove(&(size, offset));
+        self.free_bytes -= size;
+    }
+
+    /// Toma `[start, start + size)` del bloque libre `(offset, block)`
+    fn carve(&mut self, offset: u64, block: u64, start: u64, size: u64) {
+        self.remove_free(offset, block);
+        self.insert_free(offset, start - offset);
+        self.insert_free(start + size, offset + block - (start + size));
+    }
+
+    /// Best-fit: el bloque más chico donde cabe `size` ya alineado
+    pub fn alloc(&mut self, size: u64, alignment: u64) -> Option<u64> {
+        let (block, offset, start) = self.by_size.range((size, 0)..).find_map(|&(block, offset)| {
+            let start = align_up(offset, alignment);
+            (start + size <= offset + block).then_some((block, offset, start))
+        })?;
+        self.carve(offset, block, start, size);
+        Some(start)
+    }
+
+    /// First-fit por dirección: el hueco libre más bajo (compactación)
+    fn alloc_lowest(&mut self, size: u64, alignment: u64) -> Option<u64> {
+        let (offset, block, start) = self.by_offset.iter().find_map(|(&offset, &block)| {
+            let start = align_up(offset, alignment);
+            (start + size <= offset + block).then_some((offset, block, start))
+        })?;
+        self.carve(offset, block, start, size);
+        Some(start)
+    }
+
+    /// Reserva un rango exacto, que debe estar libre
+    fn reserve_at(&mut self, start: u64, size: u64) -> bool {
+        let Some((&offset, &block)) = self.by_offset.range(..=start).next_back() else { return false };
+        if start + size > offset + block {
+            return false;
+        }
+        self.carve(offset, block, start, size);
+        true
+    }
+
+    /// Devuelve un rango, fusionándolo con los bloques libres vecinos
+    pub fn free(&mut self, mut offset: u64, mut size: u64) {
+        if let Some((&prev, &prev_size)) = self.by_offset.range(..offset).next_back() {
+            if prev + prev_size == offset {
+                self.remove_free(prev, prev_size);
+                offset = prev;
+                size += prev_size;
+            }
+        }
+        if let Some(&next_size) = self.by_offset.get(&(offset + size)) {
+            self.remove_free(offset + size, next_size);
+            size += next_size;
+        }
+        self.insert_free(offset, size);
+    }
+
+    pub fn free_bytes(&self) -> u64 {
+        self.free_bytes
+    }
+
+    pub fn largest_free_block(&self) -> u64 {
+        self.by_size.iter().next_back().map_or(0, |&(size, _)| size)
+    }
+
+    pub fn free_blocks(&self) -> usize {
+        self.by_offset.len()
+    }
+
+    /// Fragmentación externa: 1 - mayor bloque libre / bytes libres
+    /// (0 = todo lo libre es contiguo)
+    pub fn fragmentation(&self) -> f64 {
+        if self.free_bytes == 0 {
+            return 0.0;
+        }
+        1.0 - self.largest_free_block() as f64 / self.free_bytes as f64
+    }
+}
+
+/// Slots de una clase de tamaño, tallados de chunks del heap
+#[derive(Debug, Clone)]
+struct SizeClassPool {
+    slot_size: u64,
+    free_slots: Vec<u64>,
+    /// (offset, tamaño) de sus chunks: nunca se mueven al compactar
+    chunks: Vec<(u64, u64)>,
+}
+
+/// Dónde quedó un buffer dentro de su heap
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum Placement {
+    Pool(usize),
+    Heap,
+}
+
+#[derive(Debug, Clone, Copy)]
+struct Reservation {
+    placement: Placement,
+    /// Bytes tomados (slot entero o tamaño alineado)
+    size: u64,
+}
+
+/// Un heap de memoria: sub-allocator + pools de buffers chicos
+#[derive(Debug, Clone)]
+struct MemoryHeap {
+    heap: HeapAllocator,
+    pools: Vec<SizeClassPool>,
+}
+
+impl MemoryHeap {
+    fn new(size: u64) -> Self {
+        let mut pools = Vec::new();
+        let mut slot_size = MIN_POOL_CLASS;
+        while slot_size <= MAX_POOLED_SIZE {
+            pools.push(SizeClassPool { slot_size, free_slots: Vec::new(), chunks: Vec::new() });
+            slot_size *= 2;
+        }
+        MemoryHeap { heap: HeapAllocator::new(size), pools }
+    }
+
+    fn alloc(&mut self, size: u64, alignment: u64) -> Option<(u64, Reservation)> {
+        let class = size.max(alignment).max(MIN_POOL_CLASS).next_power_of_two();
+        if class > MAX_POOLED_SIZE {
+            let size = align_up(size, alignment);
+            let offset = self.heap.alloc(size, alignment)?;
+            return Some((offset, Reservation { placement: Placement::Heap, size }));
+        }
+        // Un slot de clase N está alineado a N, y N ≥ la alineación pedida
+        let index = (class / MIN_POOL_CLASS).trailing_zeros() as usize;
+        let pool = &mut self.pools[index];
+        if pool.free_slots.is_empty() {
+            let slot = pool.slot_size;
+            let chunk_size = (self.heap.size / 16).min(POOL_CHUNK_SIZE) / slot * slot;
+            match self.heap.alloc(chunk_size.max(slot), slot) {
+                Some(chunk) => {
+                    pool.chunks.push((chunk, chunk_size.max(slot)));
+                    pool.free_slots.extend((0..chunk_size.max(slot) / slot).rev().map(|i| chunk + i * slot));
+                }
+                // Sin sitio para otro chunk: el slot va suelto al heap
+                None => {
+                    let offset = self.heap.alloc(slot, slot)?;
+                    return Some((offset, Reservation { placement: Placement::Heap, size: slot }));
+                }
+            }
+        }
+        let offset = pool.free_slots.pop()?;
+        Some((offset, Reservation { placement: Placement::Pool(index), size: class }))
+    }
+
+    fn free(&mut self, offset: u64, reservation: Reservation) {
+        match reservation.placement {
+            Placement::Pool(index) => self.pools[index].free_slots.push(offset),
+            Placement::Heap => self.heap.free(offset, reservation.size),
+        }
+    }
+}
+
+/// Un buffer que `compact` reubicó: copiar `size` bytes de `old_offset`
+/// a `new_offset` dentro del mismo heap, en el orden devuelto. Si ambos
+/// rangos se solapan la copia debe pasar por staging.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct BufferMove {
+    pub buffer_id: u32,
+    pub old_offset: u64,
+    pub new_offset: u64,
+    pub size: u64,
+}
+
+/// Allocator de memoria GPU - sub-asigna heaps grandes
 pub struct GpuAllocator {
     /// Buffers registrados
     buffers: HashMap<u32, BufferDescriptor>,
+    /// Bloque o slot de cada buffer
+    reservations: HashMap<u32, Reservation>,
     /// Siguiente ID de buffer
     next_id: u32,
-    /// Offset actual en el heap de dispositivo
-    device_offset: u64,
-    /// Offset actual en el heap de host
-    host_offset: u64,
+    /// Heap de dispositivo
+    device: MemoryHeap,
+    /// Heap de host
+    host: MemoryHeap,
     /// Tamaño total del heap de dispositivo
     pub device_heap_size: u64,
     /// Tamaño total del heap de host
@@ -126,27 +352,35 @@ pub struct MemoryMetrics {
     pub bytes_uploaded: u64,
     /// Bytes transferidos GPU→CPU
     pub bytes_downloaded: u64,
+    /// Fragmentación externa del heap de dispositivo (0.0 - 1.0)
+    pub device_fragmentation: f64,
+    /// Fragmentación externa del heap de host (0.0 - 1.0)
+    pub host_fragmentation: f64,
+    /// Bloques libres del heap de dispositivo
+    pub device_free_blocks: u32,
+    /// Bloques libres del heap de host
+    pub host_free_blocks: u32,
 }
 
 impl GpuAllocator {
     pub fn new(device_heap_size: u64, host_heap_size: u64) -> Self {
-        GpuAllocator {
+        let mut allocator = GpuAllocator {
             buffers: HashMap::new(),
+            reservations: HashMap::new(),
             next_id: 0,
-            device_offset: 0,
-            host_offset: 0,
+            device: MemoryHeap::new(device_heap_size),
+            host: MemoryHeap::new(host_heap_size),
             device_heap_size,
             host_heap_size,
             metrics: MemoryMetrics::default(),
-        }
+        };
+        allocator.update_fragmentation();
+        allocator
     }
 
     /// Crea un buffer con tamaño y uso específicos
     pub fn create_buffer(&mut self, size: u64, usage: BufferUsage) -> Result<u32, &'static str> {
-        let id = self.next_id;
-        self.next_id += 1;
-
-        let mut desc = BufferDescriptor::new(id, size, usage);
+        let mut desc = BufferDescriptor::new(0, size, usage);
 
         // Determinar tipo de memoria según uso
         desc.memory_type = match usage {
@@ -154,30 +388,34 @@ impl GpuAllocator {
             BufferUsage::Uniform => MemoryType::HostCoherent,
             _ => MemoryType::DeviceLocal,
         };
+        self.create_buffer_from(desc)
+    }
 
-        // Asignar offset
-        let aligned_size = desc.aligned_size();
-        match desc.memory_type {
-            MemoryType::DeviceLocal => {
-                if self.device_offset + aligned_size > self.device_heap_size {
-                    return Err("Device heap exhausted");
-                }
-                desc.offset = self.device_offset;
-                self.device_offset += aligned_size;
-                self.metrics.device_allocated += aligned_size;
-            }
-            _ => {
-                if self.host_offset + aligned_size > self.host_heap_size {
-                    return Err("Host heap exhausted");
-                }
-                desc.offset = self.host_offset;
-                self.host_offset += aligned_size;
-                self.metrics.host_allocated += aligned_size;
-            }
+    /// Crea un buffer desde un descriptor (tipo de memoria, nombre y
+    /// alineación del descriptor; el id y el offset los pone el allocator)
+    pub fn create_buffer_from(&mut self, mut desc: BufferDescriptor) -> Result<u32, &'static str> {
+        if !desc.alignment.is_power_of_two() {
+            return Err("Alignment must be a power of two");
         }
+        let device = desc.memory_type == MemoryType::DeviceLocal;
+        let heap = if device { &mut self.device } else { &mut self.host };
+        let (offset, reservation) = heap
+            .alloc(desc.size.max(1), desc.alignment)
+            .ok_or(if device { "Device heap exhausted" } else { "Host heap exhausted" })?;
 
+        let id = self.next_id;
+        self.next_id += 1;
+        desc.id = id;
+        desc.offset = offset;
+        if device {
+            self.metrics.device_allocated += reservation.size;
+        } else {
+            self.metrics.host_allocated += reservation.size;
+        }
+        self.reservations.insert(id, reservation);
         self.buffers.insert(id, desc);
         self.metrics.buffer_count += 1;
+        self.update_fragmentation();
 
         Ok(id)
     }
@@ -203,20 +441,83 @@ impl GpuAllocator {
 
     /// Libera un buffer
     pub fn free_buffer(&mut self, id: u32) -> bool {
-        if let Some(desc) = self.buffers.remove(&id) {
-            self.metrics.buffer_count -= 1;
-            match desc.memory_type {
-                MemoryType::DeviceLocal => {
-                    self.metrics.device_allocated -= desc.aligned_size();
+        let (Some(desc), Some(reservation)) = (self.buffers.remove(&id), self.reservations.remove(&id)) else {
+            return false;
+        };
+        self.metrics.buffer_count -= 1;
+        match desc.memory_type {
+            MemoryType::DeviceLocal => {
+                self.device.free(desc.offset, reservation);
+                self.metrics.device_allocated -= reservation.size;
+            }
+            _ => {
+                self.host.free(desc.offset, reservation);
+                self.metrics.host_allocated -= reservation.size;
+            }
+        }
+        self.update_fragmentation();
+        true
+    }
+
+    /// Compactación para frames ociosos: desliza hacia direcciones bajas
+    /// los buffers del heap de `memory_type` (los slots de pools no se
+    /// mueven) hasta mover `max_bytes`. Los descriptores quedan con su
+    /// offset nuevo; el caller graba las copias antes de volver a usarlos.
+    pub fn compact(&mut self, memory_type: MemoryType, max_bytes: u64) -> Vec<BufferMove> {
+        let device = memory_type == MemoryType::DeviceLocal;
+        let heap = if device { &mut self.device } else { &mut self.host };
+        let mut movable: Vec<(u64, u32, u64, u64)> = self
+            .buffers
+            .values()
+            .filter(|d| (d.memory_type == MemoryType::DeviceLocal) == device)
+            .filter_map(|d| {
+                let r = self.reservations.get(&d.id)?;
+                (r.placement == Placement::Heap).then_some((d.offset, d.id, r.size, d.alignment))
+            })
+            .collect();
+        movable.sort_unstable();
+
+        // Layout nuevo: chunks de pools fijos, luego cada buffer en el
+        // hueco más bajo (nunca por encima de donde estaba)
+        let mut layout = HeapAllocator::new(heap.heap.size);
+        for pool in &heap.pools {
+            for &(chunk, size) in &pool.chunks {
+                layout.reserve_at(chunk, size);
+            }
+        }
+        let mut moves = Vec::new();
+        let mut budget = max_bytes;
+        for (offset, id, size, alignment) in movable {
+            let target = match layout.alloc_lowest(size, alignment) {
+                Some(target) if target < offset && size <= budget => target,
+                Some(target) => {
+                    layout.free(target, size);
+                    layout.reserve_at(offset, size);
+                    offset
+                }
+                None => {
+                    layout.reserve_at(offset, size);
+                    offset
                 }
-                _ => {
-                    self.metrics.host_allocated -= desc.aligned_size();
+            };
+            if target != offset {
+                budget -= size;
+                moves.push(BufferMove { buffer_id: id, old_offset: offset, new_offset: target, size });
+                if let Some(desc) = self.buffers.get_mut(&id) {
+                    desc.offset = target;
                 }
             }
-            true
-        } else {
-            false
         }
+        heap.heap = layout;
+        self.update_fragmentation();
+        moves
+    }
+
+    fn update_fragmentation(&mut self) {
+        self.metrics.device_fragmentation = self.device.heap.fragmentation();
+        self.metrics.host_fragmentation = self.host.heap.fragmentation();
+        self.metrics.device_free_blocks = self.device.heap.free_blocks() as u32;
+        self.metrics.host_free_blocks = self.host.heap.free_blocks() as u32;
     }
 
     /// Registra una transferencia CPU→GPU
@@ -245,6 +546,13 @@ impl GpuAllocator {
             self.host_heap_size as f64 / 1_048_576.0
         );
         println!("   Buffer count:      {}", self.metrics.buffer_count);
+        println!(
+            "   Fragmentation:     device {:.1}% ({} free blocks), host {:.1}% ({} free blocks)",
+            self.metrics.device_fragmentation * 100.0,
+            self.metrics.device_free_blocks,
+            self.metrics.host_fragmentation * 100.0,
+            self.metrics.host_free_blocks
+        );
         println!(
             "   Uploads:           {} ({:.2} MB)",
             self.metrics.uploads,
@@ -407,6 +715,140 @@ impl ZeroCopyBuffer {
     }
 }
 
+/// Subidas de un frame, listas para la cola de transferencia
+#[derive(Debug, Clone)]
+pub struct TransferBatch {
+    /// Número de frame (desde 1)
+    pub frame: u64,
+    pub commands: Vec<TransferCommand>,
+    /// Barrera entre las copias y el compute que lee los destinos
+    pub barrier: MemoryBarrier,
+    pub bytes: u64,
+}
+
+/// Subidas solapadas con compute.
+///
+/// El anillo de staging (host visible) se parte en `frames_in_flight`
+/// tramos. Mientras el compute del frame N lee sus destinos, la cola de
+/// transferencia ya copia el frame N+1 desde otro tramo; un tramo solo se
+/// reescribe cuando terminó el compute del frame que lo usó.
+///
+/// Por frame: `begin_frame` → `upload`* (el caller escribe en el offset
+/// de staging devuelto) → `end_frame` (copias a enviar) → compute espera
+/// la transferencia del frame → `retire` al completar el compute.
+/// `cudead::cuda_driver::CudaFrameStream` lo ejecuta con un stream de
+/// copia y otro de compute.
+pub struct UploadPipeline {
+    pub ring: RingBuffer,
+    /// Tramo del frame que se está grabando
+    staging: StagingBuffer,
+    frame_base: u64,
+    pending: Vec<TransferCommand>,
+    /// Último frame empezado (0 = ninguno)
+    frame: u64,
+    /// Último frame cuyo compute terminó
+    completed: u64,
+    recording: bool,
+    pub metrics: UploadMetrics,
+}
+
+/// Métricas del pipeline de subidas
+#[derive(Debug, Clone, Default)]
+pub struct UploadMetrics {
+    pub frames: u64,
+    pub transfers: u64,
+    pub bytes_uploaded: u64,
+    /// Veces que `begin_frame` tuvo que esperar un tramo ocupado
+    pub stalls: u64,
+}
+
+impl UploadPipeline {
+    pub fn new(ring_buffer_id: u32, ring_size: u64, frames_in_flight: u32) -> Self {
+        let ring = RingBuffer::new(ring_buffer_id, ring_size, frames_in_flight.max(1));
+        let staging = StagingBuffer::new(ring_buffer_id, ring.frame_size);
+        UploadPipeline {
+            ring,
+            staging,
+            frame_base: 0,
+            pending: Vec::new(),
+            frame: 0,
+            completed: 0,
+            recording: false,
+            metrics: UploadMetrics::default(),
+        }
+    }
+
+    /// Frame de compute a esperar antes de poder empezar otro frame, si
+    /// todos los tramos están en vuelo
+    pub fn wait_for_slot(&self) -> Option<u64> {
+        let reuse = (self.frame + 1).checked_sub(self.ring.frames_in_flight as u64)?;
+        (reuse > self.completed).then_some(reuse)
+    }
+
+    /// Empieza a grabar el siguiente frame. `Err(frame)`: esperar a que
+    /// termine el compute de `frame`, llamar a `retire` y reintentar.
+    pub fn begin_frame(&mut self) -> Result<u64, u64> {
+        assert!(!self.recording, "begin_frame sin end_frame");
+        if let Some(wait) = self.wait_for_slot() {
+            self.metrics.stalls += 1;
+            return Err(wait);
+        }
+        self.frame += 1;
+        self.frame_base = self.ring.next_write_offset();
+        self.staging.reset();
+        self.recording = true;
+        Ok(self.frame)
+    }
+
+    /// Reserva `size` bytes de staging para `dst_buffer[dst_offset..]`.
+    /// Devuelve el offset del anillo donde escribir los datos, o `None`
+    /// si el tramo del frame está lleno.
+    pub fn upload(&mut self, dst_buffer: u32, dst_offset: u64, size: u64, alignment: u64) -> Option<u64> {
+        assert!(self.recording, "upload fuera de begin_frame/end_frame");
+        let src_offset = self.frame_base + self.staging.allocate(size, alignment)?;
+        // Copias contiguas al mismo destino salen como una sola región
+        if let Some(last) = self.pending.last_mut() {
+            if last.dst_buffer == dst_buffer
+                && last.src_offset + last.size == src_offset
+                && last.dst_offset + last.size == dst_offset
+            {
+                last.size += size;
+                return Some(src_offset);
+            }
+        }
+        self.pending.push(
+            TransferCommand::new(self.ring.buffer_id, dst_buffer, size).with_offsets(src_offset, dst_offset),
+        );
+        Some(src_offset)
+    }
+
+    /// Cierra el frame: sus copias van a la cola de transferencia
+    pub fn end_frame(&mut self) -> TransferBatch {
+        assert!(self.recording, "end_frame sin begin_frame");
+        self.recording = false;
+        let commands = std::mem::take(&mut self.pending);
+        let bytes = commands.iter().map(|c| c.size).sum();
+        self.metrics.frames += 1;
+        self.metrics.transfers += commands.len() as u64;
+        self.metrics.bytes_uploaded += bytes;
+        TransferBatch { frame: self.frame, commands, barrier: MemoryBarrier::Transfer, bytes }
+    }
+
+    /// El compute hasta `frame` terminó: sus tramos se pueden reescribir
+    pub fn retire(&mut self, frame: u64) {
+        let frame = frame.min(self.frame);
+        while self.completed < frame {
+            self.completed += 1;
+            self.ring.advance_read();
+        }
+    }
+
+    /// Frames enviados cuyo compute aún no terminó
+    pub fn frames_in_flight(&self) -> u64 {
+        self.frame - self.completed - self.recording as u64
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -435,6 +877,63 @@ mod tests {
         assert_eq!(buf.memory_type, MemoryType::HostVisible);
     }
 
+    #[test]
+    fn test_small_buffers_reuse_pool_slots() {
+        let mut alloc = GpuAllocator::new(16 * 1024 * 1024, 1024 * 1024);
+        let a = alloc.create_buffer(100, BufferUsage::StorageRead).unwrap();
+        let b = alloc.create_buffer(200, BufferUsage::StorageRead).unwrap();
+        let (oa, ob) = (alloc.get_buffer(a).unwrap().offset, alloc.get_buffer(b).unwrap().offset);
+        assert_eq!(ob - oa, 256);
+        assert!(alloc.free_buffer(a));
+        let c = alloc.create_buffer(64, BufferUsage::StorageRead).unwrap();
+        assert_eq!(alloc.get_buffer(c).unwrap().offset, oa);
+        assert!(!alloc.free_buffer(a));
+    }
+
+    #[test]
+    fn test_alignment_is_honored() {
+        let mut alloc = GpuAllocator::new(16 * 1024 * 1024, 1024 * 1024);
+        for (size, alignment) in [(300, 4096), (70_000, 65_536), (100_000, 256)] {
+            let desc = BufferDescriptor::new(0, size, BufferUsage::StorageReadWrite).with_alignment(alignment);
+            let id = alloc.create_buffer_from(desc).unwrap();
+            assert_eq!(alloc.get_buffer(id).unwrap().offset % alignment, 0);
+        }
+        let bad = BufferDescriptor::new(0, 64, BufferUsage::Vertex).with_alignment(48);
+        assert!(alloc.create_buffer_from(bad).is_err());
+    }
+
+    #[test]
+    fn test_free_coalesces_and_compaction_defragments() {
+        let mb = 1024 * 1024;
+        let mut alloc = GpuAllocator::new(8 * mb, mb);
+        let ids: Vec<u32> = (0..8).map(|_| alloc.create_buffer(mb, BufferUsage::StorageRead).unwrap()).collect();
+        assert!(alloc.create_buffer(mb, BufferUsage::StorageRead).is_err());
+        for &id in ids.iter().step_by(2) {
+            alloc.free_buffer(id);
+        }
+        // 4 MB libres en 4 huecos: no entra un buffer de 2 MB
+        assert_eq!(alloc.metrics.device_free_blocks, 4);
+        assert!(alloc.metrics.device_fragmentation > 0.7);
+        assert!(alloc.create_buffer(2 * mb, BufferUsage::StorageRead).is_err());
+
+        // Presupuesto de un solo buffer: compactación incremental
+        assert_eq!(alloc.compact(MemoryType::DeviceLocal, mb).len(), 1);
+        let moves = alloc.compact(MemoryType::DeviceLocal, u64::MAX);
+        assert!(moves.iter().all(|m| m.new_offset < m.old_offset));
+        assert_eq!(alloc.metrics.device_free_blocks, 1);
+        assert_eq!(alloc.metrics.device_fragmentation, 0.0);
+        let big = alloc.create_buffer(4 * mb, BufferUsage::StorageRead).unwrap();
+        assert_eq!(alloc.get_buffer(big).unwrap().offset, 4 * mb);
+
+        // Liberar después de mover devuelve el rango nuevo
+        for &id in ids.iter().skip(1).step_by(2) {
+            assert!(alloc.free_buffer(id));
+        }
+        alloc.free_buffer(big);
+        assert_eq!(alloc.metrics.device_free_blocks, 1);
+        assert_eq!(alloc.metrics.device_allocated, 0);
+    }
+
     #[test]
     fn test_ring_buffer() {
         let mut ring = RingBuffer::new(0, 1024, 3);
@@ -448,6 +947,37 @@ mod tests {
         assert!(off3 > off2);
     }
 
+    #[test]
+    fn test_upload_pipeline_overlaps_frames() {
+        let mut pipeline = UploadPipeline::new(7, 3 * 4096, 3);
+        let mut slots = Vec::new();
+        for frame in 1..=3 {
+            assert_eq!(pipeline.begin_frame(), Ok(frame));
+            let a = pipeline.upload(1, 0, 1024, 256).unwrap();
+            let b = pipeline.upload(1, 1024, 1024, 256).unwrap();
+            assert_eq!(b, a + 1024);
+            assert!(pipeline.upload(2, 0, 4096, 256).is_none());
+            let batch = pipeline.end_frame();
+            // Las dos subidas contiguas se fusionan en una copia
+            assert_eq!(batch.commands.len(), 1);
+            assert_eq!((batch.commands[0].src_buffer, batch.commands[0].size), (7, 2048));
+            slots.push(a);
+        }
+        assert_eq!(slots, [0, 4096, 8192]);
+        assert_eq!(pipeline.frames_in_flight(), 3);
+
+        // Tres frames en vuelo: el cuarto espera al compute del primero
+        assert_eq!(pipeline.begin_frame(), Err(1));
+        pipeline.retire(1);
+        assert_eq!(pipeline.begin_frame(), Ok(4));
+        assert_eq!(pipeline.upload(3, 0, 16, 16), Some(0));
+        pipeline.end_frame();
+        pipeline.retire(4);
+        assert_eq!(pipeline.frames_in_flight(), 0);
+        assert_eq!(pipeline.metrics.stalls, 1);
+        assert_eq!(pipeline.metrics.bytes_uploaded, 3 * 2048 + 16);
+    }
+
     #[test]
     fn test_staging_buffer() {
         let mut staging = StagingBuffer::new(0, 4096);
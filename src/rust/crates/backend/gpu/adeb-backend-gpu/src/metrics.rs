@@ -4,11 +4,155 @@
 //
 // Filosofía: "Sin métricas, no hay argumento técnico fuerte"
 //
+// Memoria fija para dejar el profiler activo en producción: las
+// latencias van a un histograma log-lineal (estilo HDR, error < 1%) y
+// el trace guarda los últimos `trace_capacity` dispatches. El trace se
+// exporta como Chrome trace (Perfetto) con los tiempos medidos en el
+// host (submit → completado). No hay pista de kernel: ningún runtime
+// compilado lee timestamps de la GPU.
+//
 // Autor: Eddi Andreé Salazar Matos
 
+use adeb_core::time_report::{self, Span};
 use std::collections::VecDeque;
 use std::time::{Duration, Instant};
 
+/// Bits de sub-bucket por octava: 128 sub-buckets → error relativo < 1%
+const HIST_SUB_BITS: u32 = 7;
+const HIST_SUB: usize = 1 << HIST_SUB_BITS;
+/// Mayor valor distinguible (2^40 ns ≈ 18 min); lo demás satura
+const HIST_MAX_BITS: u32 = 40;
+const HIST_BUCKETS: usize = 2 * HIST_SUB + (HIST_MAX_BITS - HIST_SUB_BITS - 1) as usize * HIST_SUB;
+
+/// Dispatches que guarda el trace por defecto
+pub const DEFAULT_TRACE_CAPACITY: usize = 4096;
+
+/// Histograma de latencias (ns) de memoria fija: `record` O(1),
+/// percentiles recorriendo los buckets
+#[derive(Debug, Clone)]
+pub struct LatencyHistogram {
+    counts: Vec<u64>,
+    count: u64,
+    sum: u128,
+    min: u64,
+    max: u64,
+}
+
+impl LatencyHistogram {
+    pub fn new() -> Self {
+        LatencyHistogram {
+            counts: vec![0; HIST_BUCKETS],
+            count: 0,
+            sum: 0,
+            min: u64::MAX,
+            max: 0,
+        }
+    }
+
+    /// Valores < 2·HIST_SUB van exactos; después, HIST_SUB buckets por
+    /// octava (los bits altos de la mantisa)
+    fn bucket(value: u64) -> usize {
+        let value = value.min((1u64 << HIST_MAX_BITS) - 1);
+        if value < 2 * HIST_SUB as u64 {
+            return value as usize;
+        }
+        let shift = 63 - value.leading_zeros() - HIST_SUB_BITS;
+        let mantissa = (value >> shift) as usize - HIST_SUB;
+        2 * HIST_SUB + (shift as usize - 1) * HIST_SUB + mantissa
+    }
+
+    /// Punto medio del rango de valores de un bucket
+    fn bucket_value(index: usize) -> u64 {
+        if index < 2 * HIST_SUB {
+            return index as u64;
+        }
+        let shift = ((index - 2 * HIST_SUB) / HIST_SUB + 1) as u32;
+        let mantissa = ((index - 2 * HIST_SUB) % HIST_SUB + HIST_SUB) as u64;
+        (mantissa << shift) + (1u64 << shift) / 2
+    }
+
+    pub fn record(&mut self, value: u64) {
+        self.counts[Self::bucket(value)] += 1;
+        self.count += 1;
+        self.sum += value as u128;
+        self.min = self.min.min(value);
+        self.max = self.max.max(value);
+    }
+
+    pub fn len(&self) -> u64 {
+        self.count
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.count == 0
+    }
+
+    pub fn min(&self) -> u64 {
+        if self.count == 0 {
+            0
+        } else {
+            self.min
+        }
+    }
+
+    pub fn max(&self) -> u64 {
+        self.max
+    }
+
+    pub fn mean(&self) -> f64 {
+        if self.count == 0 {
+            0.0
+        } else {
+            self.sum as f64 / self.count as f64
+        }
+    }
+
+    /// Valor bajo el que cae el `percentile`% de las muestras (0 si vacío)
+    pub fn percentile(&self, percentile: f32) -> u64 {
+        if self.count == 0 {
+            return 0;
+        }
+        let rank = ((percentile.clamp(0.0, 100.0) as f64 / 100.0) * self.count as f64).ceil();
+        let rank = (rank as u64).max(1);
+        if rank >= self.count {
+            return self.max;
+        }
+        let mut seen = 0;
+        for (index, &n) in self.counts.iter().enumerate() {
+            seen += n;
+            if seen >= rank {
+                return Self::bucket_value(index).clamp(self.min, self.max);
+            }
+        }
+        self.max
+    }
+
+    pub fn clear(&mut self) {
+        self.counts.iter_mut().for_each(|n| *n = 0);
+        self.count = 0;
+        self.sum = 0;
+        self.min = u64::MAX;
+        self.max = 0;
+    }
+}
+
+impl Default for LatencyHistogram {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Un dispatch del trace; tiempos en ns desde el inicio de la sesión
+#[derive(Debug, Clone)]
+pub struct DispatchSpan {
+    pub name: String,
+    pub start_ns: u64,
+    pub submitted_ns: u64,
+    pub completed_ns: u64,
+    pub invocations: u64,
+    pub bytes: u64,
+}
+
 /// Métricas de rendimiento GPU
 #[derive(Debug, Clone, Default)]
 pub struct GpuMetrics {
@@ -132,10 +276,12 @@ impl GpuMetrics {
 pub struct GpuProfiler {
     /// Métricas acumuladas
     pub metrics: GpuMetrics,
-    /// Historial de latencias (para percentiles)
-    latency_history: VecDeque<u64>,
-    /// Tamaño máximo del historial
-    history_size: usize,
+    /// Latencias totales de dispatch (para percentiles)
+    latency: LatencyHistogram,
+    /// Últimos dispatches, para el trace
+    spans: VecDeque<DispatchSpan>,
+    /// Dispatches que guarda el trace (0 = sin trace)
+    trace_capacity: usize,
     /// Timestamp de inicio de sesión
     session_start: Instant,
     /// Último timestamp de dispatch
@@ -146,8 +292,9 @@ impl GpuProfiler {
     pub fn new() -> Self {
         GpuProfiler {
             metrics: GpuMetrics::new(),
-            latency_history: VecDeque::with_capacity(1000),
-            history_size: 1000,
+            latency: LatencyHistogram::new(),
+            spans: VecDeque::new(),
+            trace_capacity: DEFAULT_TRACE_CAPACITY,
             session_start: Instant::now(),
             last_dispatch: None,
         }
@@ -155,14 +302,28 @@ impl GpuProfiler {
 
     /// Inicia medición de dispatch
     pub fn begin_dispatch(&mut self) -> DispatchTimer {
+        self.begin_named_dispatch("dispatch")
+    }
+
+    /// Inicia medición de dispatch con nombre para el trace
+    pub fn begin_named_dispatch(&mut self, name: &str) -> DispatchTimer {
         self.last_dispatch = Some(Instant::now());
         DispatchTimer {
+            name: name.to_string(),
             start: Instant::now(),
             submitted: None,
             completed: None,
         }
     }
 
+    /// Cambia cuántos dispatches guarda el trace (0 lo desactiva)
+    pub fn set_trace_capacity(&mut self, capacity: usize) {
+        self.trace_capacity = capacity;
+        while self.spans.len() > capacity {
+            self.spans.pop_front();
+        }
+    }
+
     /// Registra dispatch completado
     pub fn end_dispatch(
         &mut self,
@@ -186,11 +347,24 @@ impl GpuProfiler {
                 + dispatch_time as f64)
                 / (n + 1.0)) as u64;
 
-            // Historial para percentiles
-            if self.latency_history.len() >= self.history_size {
-                self.latency_history.pop_front();
+            // Histograma para percentiles
+            self.latency.record(total_time);
+
+            // Trace (ring de `trace_capacity`)
+            if self.trace_capacity > 0 {
+                if self.spans.len() >= self.trace_capacity {
+                    self.spans.pop_front();
+                }
+                let since = |t: Instant| t.saturating_duration_since(self.session_start).as_nanos() as u64;
+                self.spans.push_back(DispatchSpan {
+                    name: timer.name.clone(),
+                    start_ns: since(timer.start),
+                    submitted_ns: since(submitted),
+                    completed_ns: since(completed),
+                    invocations,
+                    bytes,
+                });
             }
-            self.latency_history.push_back(total_time);
 
             // Throughput
             let seconds = total_time as f64 / 1e9;
@@ -209,15 +383,44 @@ impl GpuProfiler {
 
     /// Calcula percentil de latencia
     pub fn latency_percentile(&self, percentile: f32) -> u64 {
-        if self.latency_history.is_empty() {
-            return 0;
-        }
+        self.latency.percentile(percentile)
+    }
+
+    /// Histograma de latencias de la sesión
+    pub fn latency_histogram(&self) -> &LatencyHistogram {
+        &self.latency
+    }
+
+    /// Dispatches guardados para el trace, del más viejo al más nuevo
+    pub fn dispatch_spans(&self) -> impl Iterator<Item = &DispatchSpan> {
+        self.spans.iter()
+    }
 
-        let mut sorted: Vec<u64> = self.latency_history.iter().copied().collect();
-        sorted.sort();
+    /// Spans en el formato de `time_report`, una pista (inicio →
+    /// completado, reloj del host)
+    pub fn trace_spans(&self) -> Vec<Span> {
+        self.spans
+            .iter()
+            .map(|s| Span {
+                name: s.name.clone(),
+                cat: "gpu-dispatch",
+                start_us: s.start_ns / 1000,
+                dur_us: s.completed_ns.saturating_sub(s.start_ns) / 1000,
+                tid: 1,
+                allocs: 0,
+                alloc_bytes: 0,
+                peak_rss: None,
+            })
+            .collect()
+    }
+
+    /// Chrome trace (Perfetto) de los dispatches guardados
+    pub fn chrome_trace_json(&self) -> String {
+        time_report::chrome_trace_json(&self.trace_spans())
+    }
 
-        let idx = ((percentile / 100.0) * (sorted.len() - 1) as f32) as usize;
-        sorted[idx]
+    pub fn write_chrome_trace(&self, path: &str) -> std::io::Result<()> {
+        time_report::write_chrome_trace(path, &self.trace_spans())
     }
 
     /// P50 (mediana)
@@ -268,7 +471,8 @@ impl GpuProfiler {
     /// Resetea métricas
     pub fn reset(&mut self) {
         self.metrics = GpuMetrics::new();
-        self.latency_history.clear();
+        self.latency.clear();
+        self.spans.clear();
         self.session_start = Instant::now();
     }
 }
@@ -282,6 +486,7 @@ impl Default for GpuProfiler {
 /// Timer para un dispatch individual
 #[derive(Debug, Clone)]
 pub struct DispatchTimer {
+    pub name: String,
     pub start: Instant,
     pub submitted: Option<Instant>,
     pub completed: Option<Instant>,
@@ -461,6 +666,50 @@ mod tests {
         assert_eq!(profiler.metrics.total_invocations, 1000);
     }
 
+    #[test]
+    fn test_latency_histogram_percentiles() {
+        let mut hist = LatencyHistogram::new();
+        assert_eq!(hist.percentile(99.0), 0);
+        // 1..=100_000 ns: el percentil p es p·1000 ns
+        for v in 1..=100_000u64 {
+            hist.record(v);
+        }
+        for p in [50.0f32, 95.0, 99.0] {
+            let exact = (p as f64 * 1000.0) as u64;
+            let got = hist.percentile(p);
+            assert!((got as f64 / exact as f64 - 1.0).abs() < 0.01, "p{} = {}", p, got);
+        }
+        assert_eq!(hist.percentile(100.0), 100_000);
+        assert_eq!(hist.min(), 1);
+        // Los valores pequeños son exactos y los enormes saturan
+        let mut small = LatencyHistogram::new();
+        small.record(7);
+        small.record(u64::MAX);
+        assert_eq!(small.percentile(50.0), 7);
+        assert_eq!(small.percentile(100.0), u64::MAX);
+    }
+
+    #[test]
+    fn test_trace_export() {
+        let mut profiler = GpuProfiler::new();
+        profiler.set_trace_capacity(2);
+        for name in ["a", "b", "c"] {
+            let mut timer = profiler.begin_named_dispatch(name);
+            timer.mark_submitted();
+            timer.mark_completed();
+            profiler.end_dispatch(&timer, 1, 4, 2);
+        }
+        let names: Vec<&str> = profiler.dispatch_spans().map(|s| s.name.as_str()).collect();
+        assert_eq!(names, ["b", "c"]);
+
+        let spans = profiler.trace_spans();
+        assert_eq!(spans.len(), 2);
+        assert!(spans.iter().all(|s| s.tid == 1 && s.cat == "gpu-dispatch"));
+        let json = profiler.chrome_trace_json();
+        assert!(json.contains("\"gpu-dispatch\""), "{}", json);
+        assert!(!json.contains("gpu-kernel"), "{}", json);
+    }
+
     #[test]
     fn test_performance_estimator() {
         let estimator = PerformanceEstimator::for_gpu("NVIDIA", "RTX 3060");
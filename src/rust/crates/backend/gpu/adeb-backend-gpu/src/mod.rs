@@ -48,6 +48,7 @@ pub mod compute; // API unificada: compute::parallel_for, compute::matmul, etc.
 pub mod vulkan_runtime; // TODO: migrar a vulkan/
 
 // === Infraestructura ===
+pub mod autotune;
 pub mod gpu_detect;
 pub mod memory;
 pub mod metrics;
@@ -4,8 +4,21 @@
 //
 // Filosofía: "Quién decide cuándo, cómo y por qué se ejecuta cada shader"
 //
+// Las dependencias forman un DAG: cada dispatch cuenta cuántas le faltan
+// y, al completarse una, sus dependientes bajan el contador. El que
+// llega a 0 entra a la cola de listos (por prioridad): get_ready ya no
+// recorre todos los dispatches en cada tick.
+//
+// Con varias colas (`queue_count`) las cadenas independientes se reparten
+// entre colas y cada una lleva su timeline semaphore: un dispatch señala
+// `signal_value` en la suya y espera (cola, valor) de sus dependencias en
+// otras. Con `gpu_waits` la dependencia se da por resuelta al *enviarla*
+// y la espera la hace la GPU, sin ida y vuelta al host.
+//
 // Autor: Eddi Andreé Salazar Matos
 
+use std::cmp::Reverse;
+use std::collections::{BinaryHeap, HashMap, HashSet};
 use std::time::{Duration, Instant};
 
 /// Dispatch request - Estructura mínima para ejecutar un shader
@@ -80,6 +93,14 @@ pub struct TrackedDispatch {
     pub submitted_at: Option<Instant>,
     /// Timestamp de completado
     pub completed_at: Option<Instant>,
+    /// Dependencias aún sin resolver (in-degree en el DAG)
+    pub unresolved: usize,
+    /// Cola asignada al entregarlo (None mientras espera)
+    pub queue: Option<u32>,
+    /// Valor que señala en el timeline semaphore de su cola
+    pub signal_value: u64,
+    /// (cola, valor) que debe esperar antes de ejecutar, uno por cola
+    pub waits: Vec<(u32, u64)>,
 }
 
 impl TrackedDispatch {
@@ -91,6 +112,10 @@ impl TrackedDispatch {
             created_at: Instant::now(),
             submitted_at: None,
             completed_at: None,
+            unresolved: 0,
+            queue: None,
+            signal_value: 0,
+            waits: Vec::new(),
         }
     }
 
@@ -108,14 +133,24 @@ impl TrackedDispatch {
     }
 }
 
-/// Scheduler determinista - Sin colas dinámicas, sin locks
+/// Scheduler determinista - Sin locks
 pub struct GpuScheduler {
-    /// Dispatches pendientes (array fijo, no Vec dinámico en hot path)
+    /// Dispatches vivos, en orden de submit
     dispatches: Vec<TrackedDispatch>,
+    /// ID → posición en `dispatches`
+    slots: HashMap<u32, usize>,
     /// Siguiente ID de dispatch
     next_id: u32,
     /// Dispatches completados (para tracking de dependencias)
-    completed_ids: Vec<u32>,
+    completed_ids: HashSet<u32>,
+    /// Aristas del DAG: dependencia → dispatches que la esperan
+    dependents: HashMap<u32, Vec<u32>>,
+    /// Listos para entregar: (prioridad, id), el menor primero
+    ready: BinaryHeap<Reverse<(u8, u32)>>,
+    /// Último valor señalado en el timeline de cada cola
+    timelines: Vec<u64>,
+    /// Dispatches entregados y no completados, por cola
+    queue_load: Vec<usize>,
     /// Métricas acumuladas
     pub metrics: SchedulerMetrics,
     /// Configuración
@@ -133,6 +168,11 @@ pub struct SchedulerConfig {
     pub timeout_ms: u64,
     /// Ordenar por prioridad
     pub priority_scheduling: bool,
+    /// Colas de compute entre las que se reparten las cadenas
+    pub queue_count: usize,
+    /// Resolver una dependencia al enviarla (espera en GPU vía timeline
+    /// semaphore) en vez de al completarse
+    pub gpu_waits: bool,
 }
 
 impl Default for SchedulerConfig {
@@ -142,6 +182,8 @@ impl Default for SchedulerConfig {
             max_batch_size: 16,
             timeout_ms: 1000,
             priority_scheduling: true,
+            queue_count: 1,
+            gpu_waits: false,
         }
     }
 }
@@ -171,8 +213,13 @@ impl GpuScheduler {
     pub fn new() -> Self {
         GpuScheduler {
             dispatches: Vec::with_capacity(64),
+            slots: HashMap::with_capacity(64),
             next_id: 0,
-            completed_ids: Vec::with_capacity(256),
+            completed_ids: HashSet::with_capacity(256),
+            dependents: HashMap::new(),
+            ready: BinaryHeap::new(),
+            timelines: Vec::new(),
+            queue_load: Vec::new(),
             metrics: SchedulerMetrics::default(),
             config: SchedulerConfig::default(),
         }
@@ -189,85 +236,134 @@ impl GpuScheduler {
         let id = self.next_id;
         self.next_id += 1;
 
-        let tracked = TrackedDispatch::new(id, dispatch);
+        let mut tracked = TrackedDispatch::new(id, dispatch);
+        let mut deps = tracked.dispatch.dependencies.clone();
+        deps.sort_unstable();
+        deps.dedup();
+        for dep in deps {
+            if !self.is_resolved(dep) {
+                tracked.unresolved += 1;
+                self.dependents.entry(dep).or_default().push(id);
+            }
+        }
+        self.slots.insert(id, self.dispatches.len());
         self.dispatches.push(tracked);
+        if self.dispatches.last().map_or(false, |d| d.unresolved == 0) {
+            self.make_ready(id);
+        }
 
         id
     }
 
-    /// Obtiene dispatches listos para ejecutar (dependencias satisfechas)
-    pub fn get_ready_dispatches(&mut self) -> Vec<u32> {
-        let mut ready = Vec::new();
-
-        for dispatch in &mut self.dispatches {
-            if dispatch.state != DispatchState::Pending {
-                continue;
-            }
+    /// Una dependencia ya no retiene a quien la espera
+    fn is_resolved(&self, dep: u32) -> bool {
+        self.completed_ids.contains(&dep)
+            || (self.config.gpu_waits
+                && self.get_dispatch(dep).map_or(false, |d| d.state == DispatchState::Submitted))
+    }
 
-            // Verificar dependencias
-            let deps_satisfied = dispatch
-                .dispatch
-                .dependencies
-                .iter()
-                .all(|dep_id| self.completed_ids.contains(dep_id));
+    fn make_ready(&mut self, id: u32) {
+        let Some(&slot) = self.slots.get(&id) else { return };
+        let dispatch = &mut self.dispatches[slot];
+        dispatch.state = DispatchState::Ready;
+        let priority = if self.config.priority_scheduling { dispatch.dispatch.priority } else { 0 };
+        self.ready.push(Reverse((priority, id)));
+    }
 
-            if deps_satisfied {
-                dispatch.state = DispatchState::Ready;
-                ready.push(dispatch.id);
+    /// `id` se resolvió: sus dependientes bajan el contador (una sola vez)
+    fn release_dependents(&mut self, id: u32) {
+        for dependent in self.dependents.remove(&id).unwrap_or_default() {
+            let Some(&slot) = self.slots.get(&dependent) else { continue };
+            let dispatch = &mut self.dispatches[slot];
+            dispatch.unresolved -= 1;
+            if dispatch.unresolved == 0 && dispatch.state == DispatchState::Pending {
+                self.make_ready(dependent);
             }
         }
+    }
 
-        // Ordenar por prioridad si está habilitado
-        if self.config.priority_scheduling {
-            ready.sort_by(|a, b| {
-                let pa = self
-                    .dispatches
-                    .iter()
-                    .find(|d| d.id == *a)
-                    .map(|d| d.dispatch.priority)
-                    .unwrap_or(255);
-                let pb = self
-                    .dispatches
-                    .iter()
-                    .find(|d| d.id == *b)
-                    .map(|d| d.dispatch.priority)
-                    .unwrap_or(255);
-                pa.cmp(&pb)
-            });
+    /// Obtiene dispatches listos para ejecutar (dependencias satisfechas),
+    /// hasta `max_batch_size`, cada uno con su cola ya asignada
+    pub fn get_ready_dispatches(&mut self) -> Vec<u32> {
+        let mut ready = Vec::new();
+        while ready.len() < self.config.max_batch_size {
+            let Some(Reverse((_, id))) = self.ready.pop() else { break };
+            self.assign_queue(id);
+            ready.push(id);
+        }
+        ready
+    }
+
+    /// Cada cadena sigue en la cola de su dependencia; lo independiente va
+    /// a la cola menos cargada. Las dependencias no completadas en otra
+    /// cola se esperan en su timeline.
+    fn assign_queue(&mut self, id: u32) {
+        let queues = self.config.queue_count.max(1);
+        if self.timelines.len() < queues {
+            self.timelines.resize(queues, 0);
+            self.queue_load.resize(queues, 0);
         }
+        let Some(&slot) = self.slots.get(&id) else { return };
 
-        // Limitar a max_batch_size
-        ready.truncate(self.config.max_batch_size);
+        let mut waits: Vec<(u32, u64)> = Vec::new();
+        let mut inherited = None;
+        for dep in &self.dispatches[slot].dispatch.dependencies {
+            if self.completed_ids.contains(dep) {
+                continue;
+            }
+            let Some(d) = self.get_dispatch(*dep) else { continue };
+            let Some(queue) = d.queue else { continue };
+            inherited.get_or_insert(queue);
+            match waits.iter_mut().find(|(q, _)| *q == queue) {
+                Some(wait) => wait.1 = wait.1.max(d.signal_value),
+                None => waits.push((queue, d.signal_value)),
+            }
+        }
+        let queue = inherited.filter(|&q| (q as usize) < queues).unwrap_or_else(|| {
+            (0..queues).min_by_key(|&q| (self.queue_load[q], q)).unwrap_or(0) as u32
+        });
+        waits.sort_unstable();
+        self.timelines[queue as usize] += 1;
+        self.queue_load[queue as usize] += 1;
 
-        ready
+        let dispatch = &mut self.dispatches[slot];
+        dispatch.queue = Some(queue);
+        dispatch.signal_value = self.timelines[queue as usize];
+        dispatch.waits = waits;
     }
 
     /// Marca un dispatch como enviado a GPU
     pub fn mark_submitted(&mut self, id: u32) {
-        if let Some(dispatch) = self.dispatches.iter_mut().find(|d| d.id == id) {
-            dispatch.state = DispatchState::Submitted;
-            dispatch.submitted_at = Some(Instant::now());
+        let Some(&slot) = self.slots.get(&id) else { return };
+        let dispatch = &mut self.dispatches[slot];
+        dispatch.state = DispatchState::Submitted;
+        dispatch.submitted_at = Some(Instant::now());
+        if self.config.gpu_waits {
+            self.release_dependents(id);
         }
     }
 
     /// Marca un dispatch como completado
     pub fn mark_completed(&mut self, id: u32) {
         // Extraer datos necesarios primero para evitar borrow múltiple
-        let dispatch_data = self
-            .dispatches
-            .iter_mut()
-            .find(|d| d.id == id)
+        let slot = self.slots.get(&id).copied();
+        let dispatch_data = slot
+            .map(|slot| &mut self.dispatches[slot])
             .map(|dispatch| {
                 dispatch.state = DispatchState::Completed;
                 dispatch.completed_at = Some(Instant::now());
                 (
+                    dispatch.queue,
                     dispatch.dispatch.total_invocations(),
                     dispatch.total_latency(),
                     dispatch.gpu_time(),
                 )
             });
 
-        if let Some((invocations, latency, gpu_time)) = dispatch_data {
+        if let Some((queue, invocations, latency, gpu_time)) = dispatch_data {
+            if let Some(load) = queue.and_then(|q| self.queue_load.get_mut(q as usize)) {
+                *load = load.saturating_sub(1);
+            }
             // Actualizar métricas
             self.metrics.total_dispatches += 1;
             self.metrics.successful_dispatches += 1;
@@ -283,13 +379,18 @@ impl GpuScheduler {
             }
 
             // Agregar a completados para dependencias
-            self.completed_ids.push(id);
+            self.completed_ids.insert(id);
+            self.release_dependents(id);
         }
     }
 
     /// Marca un dispatch como fallido
     pub fn mark_failed(&mut self, id: u32) {
-        if let Some(dispatch) = self.dispatches.iter_mut().find(|d| d.id == id) {
+        if let Some(&slot) = self.slots.get(&id) {
+            let dispatch = &mut self.dispatches[slot];
+            if let Some(load) = dispatch.queue.and_then(|q| self.queue_load.get_mut(q as usize)) {
+                *load = load.saturating_sub(1);
+            }
             dispatch.state = DispatchState::Failed;
             self.metrics.total_dispatches += 1;
             self.metrics.failed_dispatches += 1;
@@ -311,13 +412,14 @@ impl GpuScheduler {
 
     /// Obtiene un dispatch por ID
     pub fn get_dispatch(&self, id: u32) -> Option<&TrackedDispatch> {
-        self.dispatches.iter().find(|d| d.id == id)
+        self.slots.get(&id).map(|&slot| &self.dispatches[slot])
     }
 
     /// Limpia dispatches completados (libera memoria)
     pub fn cleanup_completed(&mut self) {
         self.dispatches
             .retain(|d| d.state != DispatchState::Completed && d.state != DispatchState::Failed);
+        self.slots = self.dispatches.iter().enumerate().map(|(slot, d)| (d.id, slot)).collect();
     }
 
     /// Número de dispatches pendientes
@@ -567,6 +669,77 @@ mod tests {
         assert_eq!(ready[0], id2);
     }
 
+    #[test]
+    fn test_ready_queue_priority_and_batches() {
+        let mut scheduler = GpuScheduler::with_config(SchedulerConfig { max_batch_size: 2, ..Default::default() });
+        let mut low = Dispatch::new(0, (1, 1, 1));
+        low.priority = 5;
+        let low = scheduler.submit(low);
+        let high = scheduler.submit(Dispatch::new(1, (1, 1, 1)));
+        let other = scheduler.submit(Dispatch::new(2, (1, 1, 1)));
+
+        assert_eq!(scheduler.get_ready_dispatches(), vec![high, other]);
+        // Lo que no entró en el batch sigue en la cola
+        assert_eq!(scheduler.get_ready_dispatches(), vec![low]);
+        assert!(scheduler.get_ready_dispatches().is_empty());
+    }
+
+    #[test]
+    fn test_diamond_dag() {
+        let mut scheduler = GpuScheduler::new();
+        let a = scheduler.submit(Dispatch::new(0, (1, 1, 1)));
+        let b = scheduler.submit(Dispatch::new(1, (1, 1, 1)).with_dependency(a));
+        let c = scheduler.submit(Dispatch::new(2, (1, 1, 1)).with_dependency(a));
+        let d = scheduler.submit(Dispatch::new(3, (1, 1, 1)).with_dependency(b).with_dependency(c));
+
+        assert_eq!(scheduler.get_ready_dispatches(), vec![a]);
+        scheduler.mark_submitted(a);
+        scheduler.mark_completed(a);
+        assert_eq!(scheduler.get_ready_dispatches(), vec![b, c]);
+        scheduler.mark_completed(b);
+        assert!(scheduler.get_ready_dispatches().is_empty());
+        scheduler.mark_completed(c);
+        assert_eq!(scheduler.get_ready_dispatches(), vec![d]);
+
+        // Una dependencia ya completada (y limpiada) no retiene
+        scheduler.cleanup_completed();
+        let e = scheduler.submit(Dispatch::new(4, (1, 1, 1)).with_dependency(a));
+        assert_eq!(scheduler.get_ready_dispatches(), vec![e]);
+    }
+
+    #[test]
+    fn test_chains_spread_across_queues() {
+        let mut scheduler = GpuScheduler::with_config(SchedulerConfig {
+            queue_count: 2,
+            gpu_waits: true,
+            ..Default::default()
+        });
+        let a = scheduler.submit(Dispatch::new(0, (1, 1, 1)));
+        let x = scheduler.submit(Dispatch::new(1, (1, 1, 1)));
+        let b = scheduler.submit(Dispatch::new(2, (1, 1, 1)).with_dependency(a));
+        let join = scheduler.submit(Dispatch::new(3, (1, 1, 1)).with_dependency(b).with_dependency(x));
+
+        assert_eq!(scheduler.get_ready_dispatches(), vec![a, x]);
+        let queue = |s: &GpuScheduler, id| s.get_dispatch(id).unwrap().queue.unwrap();
+        assert_ne!(queue(&scheduler, a), queue(&scheduler, x));
+
+        // gpu_waits: enviar `a` ya libera a `b`, que sigue en la cola de `a`
+        scheduler.mark_submitted(a);
+        scheduler.mark_submitted(x);
+        assert_eq!(scheduler.get_ready_dispatches(), vec![b]);
+        assert_eq!(queue(&scheduler, b), queue(&scheduler, a));
+        let tb = scheduler.get_dispatch(b).unwrap();
+        assert_eq!(tb.waits, vec![(queue(&scheduler, a), 1)]);
+        assert_eq!(tb.signal_value, 2);
+
+        scheduler.mark_submitted(b);
+        assert_eq!(scheduler.get_ready_dispatches(), vec![join]);
+        let tj = scheduler.get_dispatch(join).unwrap();
+        let mut expected = vec![(queue(&scheduler, b), 2), (queue(&scheduler, x), 1)];
+        expected.sort_unstable();
+        assert_eq!(tj.waits, expected);
+    }
+
     #[test]
     fn test_command_buffer() {
         let mut cmd = CommandBuffer::new();
@@ -7,6 +7,8 @@
 //
 // Autor: Eddi Andreé Salazar Matos
 
+use super::optimize::{self, Inst, SpirvModule};
+
 /// SPIR-V execution models
 #[repr(u32)]
 #[derive(Debug, Clone, Copy)]
@@ -47,10 +49,24 @@ pub enum SpirVOp {
     OpStore = 62,
     OpAccessChain = 65,
     OpDecorate = 71,
+    OpMemberDecorate = 72,
+    OpCompositeExtract = 81,
     OpLabel = 248,
     OpReturn = 253,
     OpIAdd = 128,
+    OpFAdd = 129,
+    OpISub = 130,
+    OpFSub = 131,
+    OpFMul = 133,
+    OpFDiv = 136,
+    OpSelect = 169,
+    OpUGreaterThanEqual = 174,
+    OpFOrdLessThan = 184,
+    OpFOrdGreaterThan = 186,
     OpControlBarrier = 224,
+    OpGroupNonUniformFAdd = 350,
+    OpGroupNonUniformFMin = 355,
+    OpGroupNonUniformFMax = 358,
 }
 
 /// Vulkan capabilities
@@ -64,6 +80,8 @@ pub enum VulkanCapability {
     Float64 = 10,
     Int64 = 11,
     Int16 = 22,
+    GroupNonUniform = 61,
+    GroupNonUniformArithmetic = 63,
 }
 
 /// Opcodes ADead para GPU (4 bits = 16 instrucciones)
@@ -94,9 +112,16 @@ pub enum ADeadGpuOp {
     Sync = 0xC, // barrier
     Nop = 0xD,
 
-    // Reservados
-    Reserved1 = 0xE,
-    Reserved2 = 0xF,
+    // Colectivas sobre el workgroup (operand: 0 suma, 1 mín, 2 máx)
+    Reduce = 0xE, // acc = op(acc de todos los hilos)
+    Scan = 0xF,   // acc = op(acc de los hilos 0..=lid), inclusivo
+}
+
+impl ADeadGpuOp {
+    /// Reduce/Scan: cooperan todos los hilos del workgroup
+    pub fn is_group_op(self) -> bool {
+        matches!(self, ADeadGpuOp::Reduce | ADeadGpuOp::Scan)
+    }
 }
 
 impl From<u8> for ADeadGpuOp {
@@ -115,6 +140,8 @@ impl From<u8> for ADeadGpuOp {
             0xA => ADeadGpuOp::Dot,
             0xB => ADeadGpuOp::MatMul,
             0xC => ADeadGpuOp::Sync,
+            0xE => ADeadGpuOp::Reduce,
+            0xF => ADeadGpuOp::Scan,
             _ => ADeadGpuOp::Nop,
         }
     }
@@ -146,330 +173,425 @@ impl ADeadGpuInstr {
     }
 }
 
+/// Generator: ADead-BIB Bytecode Compiler
+const GENERATOR: u32 = 0x0008_0001;
+
+/// Workgroup cuando no se conoce el dispositivo
+pub const DEFAULT_WORKGROUP_SIZE: (u32, u32, u32) = (256, 1, 1);
+
+/// Subgroups por workgroup en kernels sin Reduce/Scan
+const SUBGROUPS_PER_WORKGROUP: u32 = 4;
+
+/// Largo del array de cada buffer (struct { float data[1024]; })
+const BUFFER_LEN: u32 = 1024;
+
+/// Lo que el generador necesita saber del dispositivo
+/// (VkPhysicalDeviceSubgroupProperties + maxComputeWorkGroupInvocations)
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct SpirvTarget {
+    pub subgroup_size: u32,
+    /// subgroupSupportedOperations tiene ARITHMETIC para compute
+    pub subgroup_arithmetic: bool,
+    pub max_invocations: u32,
+}
+
+/// Operador de Reduce/Scan, según el operand
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum GroupOp {
+    Sum,
+    Min,
+    Max,
+}
+
+impl GroupOp {
+    fn from_operand(operand: u8) -> Self {
+        match operand {
+            1 => GroupOp::Min,
+            2 => GroupOp::Max,
+            _ => GroupOp::Sum,
+        }
+    }
+}
+
+/// IDs de tipos, constantes y variables del módulo en construcción
+#[derive(Debug, Clone, Copy, Default)]
+struct Ids {
+    void: u32,
+    bool_: u32,
+    float: u32,
+    uint: u32,
+    ptr_float: u32,
+    func: u32,
+    input: u32,
+    output: u32,
+    global_id: u32,
+    uvec3: u32,
+    /// Solo con Reduce/Scan sobre memoria compartida
+    local_index: u32,
+    shared: u32,
+    ptr_shared_float: u32,
+}
+
 /// Compilador ADead Bytecode → SPIR-V
 pub struct BytecodeToSpirV {
-    /// Instrucciones SPIR-V generadas
-    instructions: Vec<u32>,
-    /// Siguiente ID
-    next_id: u32,
-    /// IDs de tipos
-    type_void: u32,
-    type_float: u32,
-    type_uint: u32,
-    type_vec4: u32,
-    type_ptr_storage: u32,
-    type_ptr_float: u32,
-    type_func: u32,
-    /// IDs de variables
-    var_acc: u32, // Acumulador escalar
-    var_vec_acc: u32, // Acumulador vectorial
-    var_input: u32,   // Buffer de entrada
-    var_output: u32,  // Buffer de salida
-    var_global_id: u32,
-    /// Workgroup size
-    workgroup_size: (u32, u32, u32),
+    /// Módulo en construcción
+    module: SpirvModule,
+    ids: Ids,
+    /// Valores SSA vivos durante la compilación
+    acc: u32,
+    gid: u32,
+    lid: u32,
+    /// Workgroup fijado con `set_workgroup_size`
+    workgroup_override: Option<(u32, u32, u32)>,
+    /// Dispositivo destino, si se conoce
+    target: Option<SpirvTarget>,
+    /// Pasadas de `optimize` (desactivables para depurar)
+    optimize: bool,
 }
 
 impl BytecodeToSpirV {
     pub fn new() -> Self {
         BytecodeToSpirV {
-            instructions: Vec::new(),
-            next_id: 1,
-            type_void: 0,
-            type_float: 0,
-            type_uint: 0,
-            type_vec4: 0,
-            type_ptr_storage: 0,
-            type_ptr_float: 0,
-            type_func: 0,
-            var_acc: 0,
-            var_vec_acc: 0,
-            var_input: 0,
-            var_output: 0,
-            var_global_id: 0,
-            workgroup_size: (256, 1, 1),
+            module: SpirvModule::new(),
+            ids: Ids::default(),
+            acc: 0,
+            gid: 0,
+            lid: 0,
+            workgroup_override: None,
+            target: None,
+            optimize: true,
         }
     }
 
+    /// Fija el workgroup; gana sobre la elección por subgroup
     pub fn set_workgroup_size(&mut self, x: u32, y: u32, z: u32) {
-        self.workgroup_size = (x, y, z);
+        self.workgroup_override = Some((x, y, z));
     }
 
-    fn alloc_id(&mut self) -> u32 {
-        let id = self.next_id;
-        self.next_id += 1;
-        id
+    /// Workgroup para kernels sin Reduce/Scan
+    pub fn workgroup_size(&self) -> (u32, u32, u32) {
+        self.workgroup_size_for(&[])
     }
 
-    fn emit(&mut self, op: SpirVOp, operands: &[u32]) {
-        let word_count = (1 + operands.len()) as u32;
-        self.instructions.push((word_count << 16) | (op as u32));
-        self.instructions.extend_from_slice(operands);
+    /// Genera código para `target`: workgroup múltiplo del subgroup y
+    /// Reduce/Scan con OpGroupNonUniform* si el dispositivo los tiene
+    pub fn set_target(&mut self, target: SpirvTarget) {
+        self.target = Some(target);
     }
 
-    fn emit_result(&mut self, op: SpirVOp, result_type: u32, operands: &[u32]) -> u32 {
-        let result_id = self.alloc_id();
-        let word_count = (3 + operands.len()) as u32;
-        self.instructions.push((word_count << 16) | (op as u32));
-        self.instructions.push(result_type);
-        self.instructions.push(result_id);
-        self.instructions.extend_from_slice(operands);
-        result_id
+    pub fn target(&self) -> Option<SpirvTarget> {
+        self.target
     }
 
-    /// Genera header SPIR-V
-    fn generate_header(&self) -> Vec<u32> {
-        vec![
-            0x07230203, // Magic
-            0x00010500, // Version 1.5
-            0x00080001, // Generator: ADead-BIB Bytecode Compiler
-            self.next_id,
-            0,
-        ]
+    pub fn set_optimize(&mut self, enabled: bool) {
+        self.optimize = enabled;
     }
 
-    /// Emite preámbulo (capabilities, types, variables)
-    fn emit_preamble(&mut self) {
-        // Capabilities
-        self.emit(SpirVOp::OpCapability, &[VulkanCapability::Shader as u32]);
-
-        // Memory model
-        self.emit(SpirVOp::OpMemoryModel, &[0, 1]); // Logical GLSL450
+    /// Workgroup con el que se compila `bytecode` (el dispatch lo necesita)
+    ///
+    /// Con Reduce/Scan y aritmética de subgroup el workgroup es un solo
+    /// subgroup: la colectiva queda en una instrucción, sin barreras.
+    pub fn workgroup_size_for(&self, bytecode: &[u8]) -> (u32, u32, u32) {
+        if let Some(size) = self.workgroup_override {
+            return size;
+        }
+        let Some(t) = self.target else {
+            return DEFAULT_WORKGROUP_SIZE;
+        };
+        let subgroup = t.subgroup_size.clamp(1, t.max_invocations.max(1));
+        if t.subgroup_arithmetic && uses_group_ops(bytecode) {
+            return (subgroup, 1, 1);
+        }
+        let subgroups = (t.max_invocations / subgroup).clamp(1, SUBGROUPS_PER_WORKGROUP);
+        (subgroup * subgroups, 1, 1)
+    }
 
-        // Types
-        self.type_void = self.alloc_id();
-        self.emit(SpirVOp::OpTypeVoid, &[self.type_void]);
+    /// ¿Reduce/Scan se bajan a OpGroupNonUniform* con este workgroup?
+    pub fn lowers_to_subgroup(&self, workgroup: (u32, u32, u32)) -> bool {
+        self.target.map_or(false, |t| {
+            t.subgroup_arithmetic && workgroup.0 * workgroup.1 * workgroup.2 == t.subgroup_size
+        })
+    }
 
-        self.type_float = self.alloc_id();
-        self.emit(SpirVOp::OpTypeFloat, &[self.type_float, 32]);
+    /// Lo que cambia el módulo además del bytecode y el workgroup
+    pub(super) fn cache_flags(&self, workgroup: (u32, u32, u32)) -> u32 {
+        self.lowers_to_subgroup(workgroup) as u32 | (!self.optimize as u32) << 1
+    }
 
-        self.type_uint = self.alloc_id();
-        self.emit(SpirVOp::OpTypeInt, &[self.type_uint, 32, 0]);
+    fn push(&mut self, op: SpirVOp, operands: &[u32]) {
+        self.module.body.push(Inst::new(op, operands));
+    }
 
-        self.type_vec4 = self.alloc_id();
-        self.emit(SpirVOp::OpTypeVector, &[self.type_vec4, self.type_float, 4]);
+    fn push_result(&mut self, op: SpirVOp, ty: u32, operands: &[u32]) -> u32 {
+        let id = self.module.alloc_id();
+        self.module.body.push(Inst::with_result(op, ty, id, operands));
+        id
+    }
 
-        // Array type para buffers
-        let array_size_id = self.alloc_id();
-        self.emit(SpirVOp::OpConstant, &[self.type_uint, array_size_id, 1024]);
+    fn global(&mut self, op: SpirVOp, rest: &[u32]) -> u32 {
+        let id = self.module.alloc_id();
+        let mut operands = vec![id];
+        operands.extend_from_slice(rest);
+        self.module.globals.push(Inst::new(op, &operands));
+        id
+    }
 
-        let array_type = self.alloc_id();
-        self.emit(
-            SpirVOp::OpTypeArray,
-            &[array_type, self.type_float, array_size_id],
-        );
+    fn variable(&mut self, ptr_type: u32, storage_class: u32) -> u32 {
+        let id = self.module.alloc_id();
+        self.module.globals.push(Inst::new(SpirVOp::OpVariable, &[ptr_type, id, storage_class]));
+        id
+    }
 
-        // Struct para buffer
-        let struct_type = self.alloc_id();
-        self.emit(SpirVOp::OpTypeStruct, &[struct_type, array_type]);
+    fn decorate(&mut self, target: u32, decoration: &[u32]) {
+        let mut operands = vec![target];
+        operands.extend_from_slice(decoration);
+        self.module.annotations.push(Inst::new(SpirVOp::OpDecorate, &operands));
+    }
 
-        // Pointer types
-        self.type_ptr_storage = self.alloc_id();
-        self.emit(
-            SpirVOp::OpTypePointer,
-            &[self.type_ptr_storage, 12, struct_type],
-        );
+    fn uint(&mut self, value: u32) -> u32 {
+        let ty = self.ids.uint;
+        self.module.constant(ty, value)
+    }
 
-        self.type_ptr_float = self.alloc_id();
-        self.emit(
-            SpirVOp::OpTypePointer,
-            &[self.type_ptr_float, 12, self.type_float],
-        );
+    fn float(&mut self, value: f32) -> u32 {
+        let ty = self.ids.float;
+        self.module.constant(ty, value.to_bits())
+    }
 
-        let ptr_func_float = self.alloc_id();
-        self.emit(
-            SpirVOp::OpTypePointer,
-            &[ptr_func_float, 7, self.type_float],
-        ); // Function
-
-        // Function type
-        self.type_func = self.alloc_id();
-        self.emit(SpirVOp::OpTypeFunction, &[self.type_func, self.type_void]);
-
-        // Variables globales
-        self.var_input = self.alloc_id();
-        self.emit(
-            SpirVOp::OpVariable,
-            &[self.type_ptr_storage, self.var_input, 12],
-        );
+    /// Tipos, buffers y builtins
+    fn emit_globals(&mut self, workgroup_invocations: u32, shared: bool) {
+        self.ids.void = self.global(SpirVOp::OpTypeVoid, &[]);
+        self.ids.bool_ = self.global(SpirVOp::OpTypeBool, &[]);
+        self.ids.float = self.global(SpirVOp::OpTypeFloat, &[32]);
+        self.ids.uint = self.global(SpirVOp::OpTypeInt, &[32, 0]);
+        self.ids.uvec3 = self.global(SpirVOp::OpTypeVector, &[self.ids.uint, 3]);
+
+        // Buffers: struct { float data[1024]; } con layout explícito
+        let len = self.uint(BUFFER_LEN);
+        let array = self.global(SpirVOp::OpTypeArray, &[self.ids.float, len]);
+        let block = self.global(SpirVOp::OpTypeStruct, &[array]);
+        self.decorate(array, &[6, 4]); // ArrayStride 4
+        self.decorate(block, &[2]); // Block
+        self.module.annotations.push(Inst::new(SpirVOp::OpMemberDecorate, &[block, 0, 35, 0])); // Offset 0
+
+        let ptr_block = self.global(SpirVOp::OpTypePointer, &[12, block]); // StorageBuffer
+        self.ids.ptr_float = self.global(SpirVOp::OpTypePointer, &[12, self.ids.float]);
+        let ptr_uvec3 = self.global(SpirVOp::OpTypePointer, &[1, self.ids.uvec3]); // Input
+        self.ids.func = self.global(SpirVOp::OpTypeFunction, &[self.ids.void]);
+
+        self.ids.input = self.variable(ptr_block, 12);
+        self.ids.output = self.variable(ptr_block, 12);
+        self.ids.global_id = self.variable(ptr_uvec3, 1);
+        self.decorate(self.ids.input, &[34, 0]); // DescriptorSet 0
+        self.decorate(self.ids.input, &[33, 0]); // Binding 0
+        self.decorate(self.ids.output, &[34, 0]);
+        self.decorate(self.ids.output, &[33, 1]);
+        self.decorate(self.ids.global_id, &[11, 28]); // BuiltIn GlobalInvocationId
+
+        if shared {
+            // float scratch[workgroup] en memoria Workgroup (sin layout)
+            let ptr_uint = self.global(SpirVOp::OpTypePointer, &[1, self.ids.uint]);
+            self.ids.local_index = self.variable(ptr_uint, 1);
+            self.decorate(self.ids.local_index, &[11, 29]); // BuiltIn LocalInvocationIndex
+            let len = self.uint(workgroup_invocations);
+            let scratch = self.global(SpirVOp::OpTypeArray, &[self.ids.float, len]);
+            let ptr_scratch = self.global(SpirVOp::OpTypePointer, &[4, scratch]);
+            self.ids.ptr_shared_float = self.global(SpirVOp::OpTypePointer, &[4, self.ids.float]);
+            self.ids.shared = self.variable(ptr_scratch, 4);
+        }
+    }
 
-        self.var_output = self.alloc_id();
-        self.emit(
-            SpirVOp::OpVariable,
-            &[self.type_ptr_storage, self.var_output, 12],
+    /// Capabilities, entry point y execution mode: van al final porque
+    /// dependen de lo que sobrevivió a las pasadas
+    fn emit_preamble(&mut self, main: u32, workgroup: (u32, u32, u32)) {
+        let mut preamble = vec![Inst::new(SpirVOp::OpCapability, &[VulkanCapability::Shader as u32])];
+        let group_ops = (SpirVOp::OpGroupNonUniformFAdd as u32)..=(SpirVOp::OpGroupNonUniformFMax as u32);
+        if self.module.body.iter().any(|i| group_ops.contains(&i.op)) {
+            for cap in [VulkanCapability::GroupNonUniform, VulkanCapability::GroupNonUniformArithmetic] {
+                preamble.push(Inst::new(SpirVOp::OpCapability, &[cap as u32]));
+            }
+        }
+        preamble.push(Inst::new(SpirVOp::OpMemoryModel, &[0, 1])); // Logical GLSL450
+
+        // Desde SPIR-V 1.4 la interfaz lista todas las variables globales
+        let mut entry = vec![ExecutionModel::GLCompute as u32, main, 0x6E69616D, 0x00000000]; // "main"
+        entry.extend(
+            self.module
+                .globals
+                .iter()
+                .filter(|g| g.op == SpirVOp::OpVariable as u32)
+                .map(|g| g.operands[1]),
         );
-
-        // GlobalInvocationId
-        let uvec3_type = self.alloc_id();
-        self.emit(SpirVOp::OpTypeVector, &[uvec3_type, self.type_uint, 3]);
-
-        let ptr_uvec3 = self.alloc_id();
-        self.emit(SpirVOp::OpTypePointer, &[ptr_uvec3, 1, uvec3_type]);
-
-        self.var_global_id = self.alloc_id();
-        self.emit(SpirVOp::OpVariable, &[ptr_uvec3, self.var_global_id, 1]);
-
-        // Decorations
-        self.emit(SpirVOp::OpDecorate, &[self.var_input, 34, 0]); // DescriptorSet 0
-        self.emit(SpirVOp::OpDecorate, &[self.var_input, 33, 0]); // Binding 0
-        self.emit(SpirVOp::OpDecorate, &[self.var_output, 34, 0]);
-        self.emit(SpirVOp::OpDecorate, &[self.var_output, 33, 1]);
-        self.emit(SpirVOp::OpDecorate, &[self.var_global_id, 11, 28]); // BuiltIn GlobalInvocationId
+        preamble.push(Inst::new(SpirVOp::OpEntryPoint, &entry));
+        preamble.push(Inst::new(
+            SpirVOp::OpExecutionMode,
+            &[main, 17, workgroup.0, workgroup.1, workgroup.2], // LocalSize
+        ));
+        self.module.preamble = preamble;
     }
 
     /// Compila bytecode ADead a SPIR-V
     pub fn compile(&mut self, bytecode: &[u8]) -> Vec<u8> {
-        self.instructions.clear();
-        self.next_id = 1;
-
-        // Emitir preámbulo
-        self.emit_preamble();
-
-        // Entry point
-        let main_func = self.alloc_id();
-        self.emit(
-            SpirVOp::OpEntryPoint,
-            &[
-                ExecutionModel::GLCompute as u32,
-                main_func,
-                0x6E69616D,
-                0x00000000, // "main"
-                self.var_global_id,
-                self.var_input,
-                self.var_output,
-            ],
-        );
-
-        // Execution mode
-        self.emit(
-            SpirVOp::OpExecutionMode,
-            &[
-                main_func,
-                17,
-                self.workgroup_size.0,
-                self.workgroup_size.1,
-                self.workgroup_size.2,
-            ],
-        );
+        let workgroup = self.workgroup_size_for(bytecode);
+        let invocations = workgroup.0 * workgroup.1 * workgroup.2;
+        let subgroup = self.lowers_to_subgroup(workgroup);
+        let shared = uses_group_ops(bytecode) && !subgroup;
+
+        self.module = SpirvModule::new();
+        self.ids = Ids::default();
+        self.emit_globals(invocations, shared);
+
+        // Main function: un solo bloque, el acumulador es un valor SSA
+        let main = self.module.alloc_id();
+        self.module.body.push(Inst::with_result(SpirVOp::OpFunction, self.ids.void, main, &[0, self.ids.func]));
+        let label = self.module.alloc_id();
+        self.push(SpirVOp::OpLabel, &[label]);
+
+        let gid3 = self.push_result(SpirVOp::OpLoad, self.ids.uvec3, &[self.ids.global_id]);
+        self.gid = self.push_result(SpirVOp::OpCompositeExtract, self.ids.uint, &[gid3, 0]);
+        if shared {
+            self.lid = self.push_result(SpirVOp::OpLoad, self.ids.uint, &[self.ids.local_index]);
+        }
+        self.acc = self.float(0.0);
 
-        // Main function
-        self.emit(
-            SpirVOp::OpFunction,
-            &[self.type_void, main_func, 0, self.type_func],
-        );
+        for &byte in bytecode {
+            let instr = ADeadGpuInstr::from_byte(byte);
+            self.compile_instruction(&instr, subgroup, invocations);
+        }
 
-        let label = self.alloc_id();
-        self.emit(SpirVOp::OpLabel, &[label]);
+        self.push(SpirVOp::OpReturn, &[]);
+        self.push(SpirVOp::OpFunctionEnd, &[]);
 
-        // Cargar global ID
-        let uvec3_type = self.type_uint; // Simplificado
-        let gid = self.emit_result(SpirVOp::OpLoad, uvec3_type, &[self.var_global_id]);
+        if self.optimize {
+            optimize::optimize(&mut self.module);
+        }
+        self.emit_preamble(main, workgroup);
+        self.module.to_bytes(GENERATOR)
+    }
 
-        // Constantes
-        let const_0 = self.alloc_id();
-        self.emit(SpirVOp::OpConstant, &[self.type_uint, const_0, 0]);
+    /// Puntero a buffer[gid + operand]
+    fn element_ptr(&mut self, buffer: u32, operand: u8) -> u32 {
+        let (zero, offset) = (self.uint(0), self.uint(operand as u32));
+        let idx = self.push_result(SpirVOp::OpIAdd, self.ids.uint, &[self.gid, offset]);
+        self.push_result(SpirVOp::OpAccessChain, self.ids.ptr_float, &[buffer, zero, idx])
+    }
 
-        // Variable local para acumulador
-        let acc = self.alloc_id();
-        let const_zero_f = self.alloc_id();
-        self.emit(SpirVOp::OpConstant, &[self.type_float, const_zero_f, 0]);
+    fn shared_ptr(&mut self, idx: u32) -> u32 {
+        self.push_result(SpirVOp::OpAccessChain, self.ids.ptr_shared_float, &[self.ids.shared, idx])
+    }
 
-        // Compilar cada instrucción del bytecode
-        for &byte in bytecode {
-            let instr = ADeadGpuInstr::from_byte(byte);
-            self.compile_instruction(&instr, gid, const_0, acc);
-        }
+    fn barrier(&mut self) {
+        let workgroup = self.uint(2); // Scope Workgroup
+        let semantics = self.uint(0x108); // AcquireRelease | WorkgroupMemory
+        self.push(SpirVOp::OpControlBarrier, &[workgroup, workgroup, semantics]);
+    }
 
-        // Return
-        self.emit(SpirVOp::OpReturn, &[]);
-        self.emit(SpirVOp::OpFunctionEnd, &[]);
+    /// op(a, b) para el fallback en memoria compartida
+    fn combine(&mut self, op: GroupOp, a: u32, b: u32) -> u32 {
+        let float = self.ids.float;
+        let pick = match op {
+            GroupOp::Sum => return self.push_result(SpirVOp::OpFAdd, float, &[a, b]),
+            GroupOp::Min => SpirVOp::OpFOrdLessThan,
+            GroupOp::Max => SpirVOp::OpFOrdGreaterThan,
+        };
+        let cond = self.push_result(pick, self.ids.bool_, &[b, a]);
+        self.push_result(SpirVOp::OpSelect, float, &[cond, b, a])
+    }
 
-        // Build final SPIR-V
-        let mut spirv = self.generate_header();
-        spirv.extend_from_slice(&self.instructions);
+    /// Reduce/Scan de todo el workgroup
+    fn compile_group_op(&mut self, op: GroupOp, scan: bool, subgroup: bool, invocations: u32) {
+        if subgroup {
+            // El workgroup es un subgroup: una sola instrucción
+            let opcode = match op {
+                GroupOp::Sum => SpirVOp::OpGroupNonUniformFAdd,
+                GroupOp::Min => SpirVOp::OpGroupNonUniformFMin,
+                GroupOp::Max => SpirVOp::OpGroupNonUniformFMax,
+            };
+            let scope = self.uint(3); // Scope Subgroup
+            let operation = scan as u32; // Reduce = 0, InclusiveScan = 1
+            self.acc = self.push_result(opcode, self.ids.float, &[scope, operation, self.acc]);
+            return;
+        }
 
-        spirv.iter().flat_map(|w| w.to_le_bytes()).collect()
+        // Hillis-Steele sobre scratch[]: log2(workgroup) pasos
+        // desenrollados, sin saltos (OpSelect en vez de if)
+        self.barrier();
+        let own = self.shared_ptr(self.lid);
+        self.push(SpirVOp::OpStore, &[own, self.acc]);
+        let mut stride = 1;
+        while stride < invocations {
+            let s = self.uint(stride);
+            let active = self.push_result(SpirVOp::OpUGreaterThanEqual, self.ids.bool_, &[self.lid, s]);
+            let back = self.push_result(SpirVOp::OpISub, self.ids.uint, &[self.lid, s]);
+            let idx = self.push_result(SpirVOp::OpSelect, self.ids.uint, &[active, back, self.lid]);
+            self.barrier();
+            let ptr = self.shared_ptr(idx);
+            let other = self.push_result(SpirVOp::OpLoad, self.ids.float, &[ptr]);
+            self.barrier();
+            let combined = self.combine(op, self.acc, other);
+            self.acc = self.push_result(SpirVOp::OpSelect, self.ids.float, &[active, combined, self.acc]);
+            let own = self.shared_ptr(self.lid);
+            self.push(SpirVOp::OpStore, &[own, self.acc]);
+            stride *= 2;
+        }
+        if !scan {
+            // El último prefijo es el total
+            self.barrier();
+            let last = self.uint(invocations - 1);
+            let ptr = self.shared_ptr(last);
+            self.acc = self.push_result(SpirVOp::OpLoad, self.ids.float, &[ptr]);
+        }
     }
 
     /// Compila una instrucción individual
-    fn compile_instruction(&mut self, instr: &ADeadGpuInstr, gid: u32, const_0: u32, _acc: u32) {
+    fn compile_instruction(&mut self, instr: &ADeadGpuInstr, subgroup: bool, invocations: u32) {
         match instr.opcode {
             ADeadGpuOp::Exit => {
                 // No-op en GPU (el shader termina naturalmente)
             }
             ADeadGpuOp::Load => {
                 // acc = input[gid + operand]
-                let offset = self.alloc_id();
-                self.emit(
-                    SpirVOp::OpConstant,
-                    &[self.type_uint, offset, instr.operand as u32],
-                );
-
-                let idx = self.emit_result(SpirVOp::OpIAdd, self.type_uint, &[gid, offset]);
-                let ptr = self.emit_result(
-                    SpirVOp::OpAccessChain,
-                    self.type_ptr_float,
-                    &[self.var_input, const_0, idx],
-                );
-                let _val = self.emit_result(SpirVOp::OpLoad, self.type_float, &[ptr]);
+                let ptr = self.element_ptr(self.ids.input, instr.operand);
+                self.acc = self.push_result(SpirVOp::OpLoad, self.ids.float, &[ptr]);
             }
             ADeadGpuOp::Store => {
                 // output[gid + operand] = acc
-                let offset = self.alloc_id();
-                self.emit(
-                    SpirVOp::OpConstant,
-                    &[self.type_uint, offset, instr.operand as u32],
-                );
-
-                let idx = self.emit_result(SpirVOp::OpIAdd, self.type_uint, &[gid, offset]);
-                let ptr = self.emit_result(
-                    SpirVOp::OpAccessChain,
-                    self.type_ptr_float,
-                    &[self.var_output, const_0, idx],
-                );
-
-                // Store zero (placeholder - necesita valor real)
-                let zero = self.alloc_id();
-                self.emit(SpirVOp::OpConstant, &[self.type_float, zero, 0]);
-                self.emit(SpirVOp::OpStore, &[ptr, zero]);
+                let ptr = self.element_ptr(self.ids.output, instr.operand);
+                self.push(SpirVOp::OpStore, &[ptr, self.acc]);
             }
             ADeadGpuOp::LoadImm => {
                 // acc = operand (como float)
-                let _val = self.alloc_id();
-                self.emit(
-                    SpirVOp::OpConstant,
-                    &[self.type_float, _val, instr.operand as u32],
-                );
+                self.acc = self.float(instr.operand as f32);
             }
             ADeadGpuOp::Add | ADeadGpuOp::Sub | ADeadGpuOp::Mul | ADeadGpuOp::Div => {
-                // Operaciones aritméticas
-                let offset = self.alloc_id();
-                self.emit(
-                    SpirVOp::OpConstant,
-                    &[self.type_uint, offset, instr.operand as u32],
-                );
-
-                let idx = self.emit_result(SpirVOp::OpIAdd, self.type_uint, &[gid, offset]);
-                let ptr = self.emit_result(
-                    SpirVOp::OpAccessChain,
-                    self.type_ptr_float,
-                    &[self.var_input, const_0, idx],
-                );
-                let _val = self.emit_result(SpirVOp::OpLoad, self.type_float, &[ptr]);
-
-                // La operación real se haría aquí con el acumulador
+                // acc = acc op input[gid + operand]
+                let ptr = self.element_ptr(self.ids.input, instr.operand);
+                let val = self.push_result(SpirVOp::OpLoad, self.ids.float, &[ptr]);
+                let op = match instr.opcode {
+                    ADeadGpuOp::Add => SpirVOp::OpFAdd,
+                    ADeadGpuOp::Sub => SpirVOp::OpFSub,
+                    ADeadGpuOp::Mul => SpirVOp::OpFMul,
+                    _ => SpirVOp::OpFDiv,
+                };
+                self.acc = self.push_result(op, self.ids.float, &[self.acc, val]);
             }
-            ADeadGpuOp::Sync => {
-                // Barrier (simplificado)
-                // OpControlBarrier requiere más setup
+            ADeadGpuOp::Sync => self.barrier(),
+            ADeadGpuOp::Reduce | ADeadGpuOp::Scan => {
+                let scan = instr.opcode == ADeadGpuOp::Scan;
+                self.compile_group_op(GroupOp::from_operand(instr.operand), scan, subgroup, invocations);
             }
             _ => {
-                // Nop y otros
+                // Nop y vectoriales (aún sin acumulador vectorial)
             }
         }
     }
 }
 
+/// ¿El bytecode tiene Reduce/Scan?
+fn uses_group_ops(bytecode: &[u8]) -> bool {
+    bytecode.iter().any(|&b| ADeadGpuInstr::from_byte(b).opcode.is_group_op())
+}
+
 impl Default for BytecodeToSpirV {
     fn default() -> Self {
         Self::new()
@@ -548,4 +670,137 @@ mod tests {
         assert_eq!(&spirv[0..4], &[0x03, 0x02, 0x23, 0x07]);
         assert!(spirv.len() > 100); // Debe tener contenido
     }
+
+    /// (opcode, operandos) de cada instrucción; comprueba que los word
+    /// counts cierran y que cada id se define una vez y cabe en el bound
+    fn decode(spirv: &[u8]) -> Vec<(u32, Vec<u32>)> {
+        let words: Vec<u32> = spirv.chunks(4).map(|c| u32::from_le_bytes([c[0], c[1], c[2], c[3]])).collect();
+        let bound = words[3];
+        let (mut out, mut defined, mut i) = (Vec::new(), std::collections::HashSet::new(), 5);
+        while i < words.len() {
+            let (count, op) = ((words[i] >> 16) as usize, words[i] & 0xFFFF);
+            assert!(count >= 1 && i + count <= words.len());
+            let operands = words[i + 1..i + count].to_vec();
+            let result = match op {
+                19..=33 | 248 => operands.first().copied(),
+                43 | 54 | 59 | 61 | 65 | 81 | 128..=186 | 350..=358 => operands.get(1).copied(),
+                _ => None,
+            };
+            if let Some(id) = result {
+                assert!(id < bound && defined.insert(id), "id {} redefinido o fuera del bound", id);
+            }
+            out.push((op, operands));
+            i += count;
+        }
+        out
+    }
+
+    fn count(module: &[(u32, Vec<u32>)], op: SpirVOp) -> usize {
+        module.iter().filter(|(o, _)| *o == op as u32).count()
+    }
+
+    #[test]
+    fn test_vector_add_module() {
+        let spirv = BytecodeToSpirV::new().compile(&example_vector_add());
+        let module = decode(&spirv);
+
+        // gid + A[gid] + B[gid+1]; gid + 0 se plegó
+        assert_eq!(count(&module, SpirVOp::OpLoad), 3);
+        assert_eq!(count(&module, SpirVOp::OpIAdd), 1);
+        assert_eq!(count(&module, SpirVOp::OpFAdd), 1);
+        assert_eq!(count(&module, SpirVOp::OpStore), 1);
+        assert_eq!(count(&module, SpirVOp::OpCapability), 1);
+        // El store escribe el resultado de la suma, no una constante
+        let sum = module.iter().find(|(o, _)| *o == SpirVOp::OpFAdd as u32).unwrap().1[1];
+        let store = module.iter().find(|(o, _)| *o == SpirVOp::OpStore as u32).unwrap();
+        assert_eq!(store.1[1], sum);
+    }
+
+    #[test]
+    fn test_redundant_memory_ops_removed() {
+        let bytecode = generate_adead_gpu_bytecode(&[
+            (ADeadGpuOp::Load, 0),
+            (ADeadGpuOp::Add, 0), // misma dirección: reutiliza el load
+            (ADeadGpuOp::Store, 0),
+            (ADeadGpuOp::LoadImm, 2),
+            (ADeadGpuOp::Store, 0), // tapa al store anterior
+        ]);
+        let mut compiler = BytecodeToSpirV::new();
+        compiler.set_optimize(false);
+        let raw = decode(&compiler.compile(&bytecode));
+        assert_eq!(count(&raw, SpirVOp::OpLoad), 3);
+        assert_eq!(count(&raw, SpirVOp::OpStore), 2);
+
+        compiler.set_optimize(true);
+        let module = decode(&compiler.compile(&bytecode));
+        assert_eq!(count(&module, SpirVOp::OpLoad), 1);
+        assert_eq!(count(&module, SpirVOp::OpStore), 1);
+        // El load y la suma quedaron muertos
+        assert_eq!(count(&module, SpirVOp::OpFAdd), 0);
+    }
+
+    #[test]
+    fn test_workgroup_from_subgroup() {
+        let mut compiler = BytecodeToSpirV::new();
+        assert_eq!(compiler.workgroup_size(), DEFAULT_WORKGROUP_SIZE);
+
+        compiler.set_target(SpirvTarget { subgroup_size: 16, subgroup_arithmetic: true, max_invocations: 1024 });
+        assert_eq!(compiler.workgroup_size(), (64, 1, 1));
+        let reduce = generate_adead_gpu_bytecode(&[(ADeadGpuOp::Load, 0), (ADeadGpuOp::Reduce, 0)]);
+        assert_eq!(compiler.workgroup_size_for(&reduce), (16, 1, 1));
+
+        compiler.set_target(SpirvTarget { subgroup_size: 64, subgroup_arithmetic: false, max_invocations: 128 });
+        assert_eq!(compiler.workgroup_size_for(&reduce), (128, 1, 1));
+
+        compiler.set_workgroup_size(8, 8, 1);
+        assert_eq!(compiler.workgroup_size_for(&reduce), (8, 8, 1));
+    }
+
+    #[test]
+    fn test_subgroup_reduce() {
+        let bytecode = generate_adead_gpu_bytecode(&[
+            (ADeadGpuOp::Load, 0),
+            (ADeadGpuOp::Reduce, 0),
+            (ADeadGpuOp::Scan, 2),
+            (ADeadGpuOp::Store, 0),
+        ]);
+        let mut compiler = BytecodeToSpirV::new();
+        compiler.set_target(SpirvTarget { subgroup_size: 32, subgroup_arithmetic: true, max_invocations: 1024 });
+        let module = decode(&compiler.compile(&bytecode));
+
+        assert_eq!(count(&module, SpirVOp::OpGroupNonUniformFAdd), 1);
+        assert_eq!(count(&module, SpirVOp::OpGroupNonUniformFMax), 1);
+        assert_eq!(count(&module, SpirVOp::OpControlBarrier), 0);
+        let caps: Vec<u32> = module.iter().filter(|(o, _)| *o == SpirVOp::OpCapability as u32).map(|(_, w)| w[0]).collect();
+        assert_eq!(caps, vec![1, 61, 63]);
+        let mode = module.iter().find(|(o, _)| *o == SpirVOp::OpExecutionMode as u32).unwrap();
+        assert_eq!(&mode.1[1..], &[17, 32, 1, 1]);
+    }
+
+    #[test]
+    fn test_shared_memory_fallback() {
+        let bytecode = generate_adead_gpu_bytecode(&[
+            (ADeadGpuOp::Load, 0),
+            (ADeadGpuOp::Reduce, 1),
+            (ADeadGpuOp::Store, 0),
+        ]);
+        let mut compiler = BytecodeToSpirV::new();
+        compiler.set_workgroup_size(64, 1, 1);
+        let module = decode(&compiler.compile(&bytecode));
+
+        // Entrada + 2 por cada uno de los log2(64) pasos + lectura del total
+        assert_eq!(count(&module, SpirVOp::OpControlBarrier), 1 + 2 * 6 + 1);
+        assert_eq!(count(&module, SpirVOp::OpGroupNonUniformFMin), 0);
+        assert_eq!(count(&module, SpirVOp::OpFOrdLessThan), 6);
+        // Sin saltos: el módulo es un solo bloque
+        assert_eq!(count(&module, SpirVOp::OpLabel), 1);
+        // La variable Workgroup está en la interfaz del entry point
+        let shared = module
+            .iter()
+            .find(|(o, w)| *o == SpirVOp::OpVariable as u32 && w[2] == 4)
+            .unwrap()
+            .1[1];
+        let entry = module.iter().find(|(o, _)| *o == SpirVOp::OpEntryPoint as u32).unwrap();
+        assert!(entry.1[4..].contains(&shared));
+    }
 }
@@ -0,0 +1,104 @@
+// ADead-BIB GPU Backend - Cache de módulos SPIR-V
+// Clave = hash del bytecode ADead + workgroup size + flags de
+// generación + versión del generador: un warm start no vuelve a
+// emitir SPIR-V.
+// Los blobs viven en `<ADEB_CACHE_DIR o .adB-cache>/spirv/`.
+//
+// Autor: Eddi Andreé Salazar Matos
+
+use super::bytecode::BytecodeToSpirV;
+use adeb_core::cache::hasher::hash_bytes;
+use adeb_core::cache::objects::ObjectCache;
+use std::path::PathBuf;
+
+/// Sube al cambiar lo que emite `BytecodeToSpirV`: invalida los módulos
+pub const SPIRV_GENERATOR_VERSION: u32 = 2;
+
+/// Magic de SPIR-V (little-endian): un blob sin él no es un módulo
+const SPIRV_MAGIC: [u8; 4] = 0x0723_0203u32.to_le_bytes();
+
+/// Cache persistente de módulos SPIR-V, por contenido
+#[derive(Debug, Clone)]
+pub struct SpirvCache {
+    objects: ObjectCache,
+}
+
+impl SpirvCache {
+    pub fn new(dir: impl Into<PathBuf>) -> Self {
+        SpirvCache { objects: ObjectCache::new(dir) }
+    }
+
+    /// `spirv/` dentro del cache de objetos del compilador
+    pub fn from_env() -> Self {
+        Self::new(ObjectCache::from_env().dir().join("spirv"))
+    }
+
+    /// Clave de un kernel: bytecode + workgroup size + versión
+    pub fn key(bytecode: &[u8], workgroup_size: (u32, u32, u32)) -> u64 {
+        Self::key_with_flags(bytecode, workgroup_size, 0)
+    }
+
+    /// Como `key`, con los flags de generación (subgroups, sin optimizar)
+    pub fn key_with_flags(bytecode: &[u8], workgroup_size: (u32, u32, u32), flags: u32) -> u64 {
+        let mut data = Vec::with_capacity(bytecode.len() + 20);
+        for word in [SPIRV_GENERATOR_VERSION, workgroup_size.0, workgroup_size.1, workgroup_size.2, flags] {
+            data.extend_from_slice(&word.to_le_bytes());
+        }
+        data.extend_from_slice(bytecode);
+        hash_bytes(&data)
+    }
+
+    /// Módulo cacheado, `None` si falta o no parece SPIR-V
+    pub fn load(&self, key: u64) -> Option<Vec<u8>> {
+        self.objects.load(key).filter(|spirv| spirv.len() % 4 == 0 && spirv.starts_with(&SPIRV_MAGIC))
+    }
+
+    /// Guarda un módulo; un fallo de escritura solo cuesta un cache miss
+    pub fn store(&self, key: u64, spirv: &[u8]) {
+        let _ = self.objects.store(key, spirv);
+    }
+}
+
+impl BytecodeToSpirV {
+    /// Como `compile`, pero reutiliza el módulo de `cache` si ya se
+    /// generó este bytecode con el mismo workgroup size y flags
+    pub fn compile_cached(&mut self, bytecode: &[u8], cache: &SpirvCache) -> Vec<u8> {
+        let workgroup = self.workgroup_size_for(bytecode);
+        let key = SpirvCache::key_with_flags(bytecode, workgroup, self.cache_flags(workgroup));
+        if let Some(spirv) = cache.load(key) {
+            return spirv;
+        }
+        let spirv = self.compile(bytecode);
+        cache.store(key, &spirv);
+        spirv
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::spirv::bytecode::example_vector_add;
+
+    #[test]
+    fn test_module_cache_round_trip() {
+        let dir = std::env::temp_dir().join(format!("adeb_spirv_cache_{}", std::process::id()));
+        let cache = SpirvCache::new(&dir);
+        let bytecode = example_vector_add();
+
+        let mut compiler = BytecodeToSpirV::new();
+        let cold = compiler.compile_cached(&bytecode, &cache);
+        assert_eq!(cold, BytecodeToSpirV::new().compile(&bytecode));
+        let key = SpirvCache::key(&bytecode, (256, 1, 1));
+        assert_eq!(cache.load(key).as_deref(), Some(cold.as_slice()));
+        assert_eq!(compiler.compile_cached(&bytecode, &cache), cold);
+
+        // Otro workgroup size es otro módulo
+        assert_ne!(SpirvCache::key(&bytecode, (64, 1, 1)), key);
+        // Aritmética de subgroup es otro módulo
+        assert_ne!(SpirvCache::key_with_flags(&bytecode, (256, 1, 1), 1), key);
+        // Un blob corrupto es un miss, no un módulo
+        cache.store(key, b"garbage!");
+        assert!(cache.load(key).is_none());
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
@@ -3,5 +3,8 @@
 // Soporta: NVIDIA, AMD, Intel, y cualquier GPU Vulkan
 
 pub mod bytecode;
+pub mod cache;
+pub mod optimize;
 
 pub use bytecode::*;
+pub use cache::SpirvCache;
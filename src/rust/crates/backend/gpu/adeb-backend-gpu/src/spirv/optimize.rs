@@ -0,0 +1,336 @@
+// ADead-BIB GPU Backend - Optimizador de módulos SPIR-V
+// Pasadas sobre el módulo que genera BytecodeToSpirV, antes de
+// serializarlo:
+//
+//   1. fold:    constantes (IAdd/ISub/F*), identidades (x + 0u, x * 1.0)
+//               y CSE de OpAccessChain
+//   2. forward: load→load y store→load del mismo puntero sin store ni
+//               barrera en medio; un store tapado por otro al mismo
+//               puntero (sin lecturas en medio) se elimina
+//   3. dce:     instrucciones puras sin uso y constantes huérfanas
+//
+// El cuerpo es un solo bloque (el bytecode no tiene saltos), así que
+// todo es una pasada lineal. Cualquier store invalida todas las cargas
+// conocidas: dos bindings pueden apuntar al mismo buffer.
+//
+// Autor: Eddi Andreé Salazar Matos
+
+use super::bytecode::SpirVOp;
+use std::collections::{HashMap, HashSet};
+
+/// Una instrucción SPIR-V: `ty`/`id` solo si el opcode los tiene
+#[derive(Debug, Clone, PartialEq)]
+pub struct Inst {
+    pub op: u32,
+    pub ty: Option<u32>,
+    pub id: Option<u32>,
+    pub operands: Vec<u32>,
+}
+
+impl Inst {
+    pub fn new(op: SpirVOp, operands: &[u32]) -> Self {
+        Inst { op: op as u32, ty: None, id: None, operands: operands.to_vec() }
+    }
+
+    pub fn with_result(op: SpirVOp, ty: u32, id: u32, operands: &[u32]) -> Self {
+        Inst { op: op as u32, ty: Some(ty), id: Some(id), operands: operands.to_vec() }
+    }
+
+    fn is(&self, op: SpirVOp) -> bool {
+        self.op == op as u32
+    }
+
+    fn encode(&self, out: &mut Vec<u32>) {
+        let words = 1 + self.ty.is_some() as usize + self.id.is_some() as usize + self.operands.len();
+        out.push(((words as u32) << 16) | self.op);
+        out.extend(self.ty);
+        out.extend(self.id);
+        out.extend_from_slice(&self.operands);
+    }
+
+    /// Posiciones de `operands` que son ids (el resto son literales)
+    fn id_operand(&self, index: usize) -> bool {
+        const COMPOSITE_EXTRACT: u32 = SpirVOp::OpCompositeExtract as u32;
+        const FUNCTION: u32 = SpirVOp::OpFunction as u32;
+        match self.op {
+            COMPOSITE_EXTRACT => index == 0,
+            FUNCTION => index == 1,
+            op if is_group_op(op) => index != 1,
+            _ => true,
+        }
+    }
+
+    /// ¿Se puede borrar si nadie usa su resultado?
+    fn is_pure(&self) -> bool {
+        self.id.is_some() && !self.is(SpirVOp::OpFunction) && !self.is(SpirVOp::OpLabel)
+    }
+}
+
+fn is_group_op(op: u32) -> bool {
+    (SpirVOp::OpGroupNonUniformFAdd as u32..=SpirVOp::OpGroupNonUniformFMax as u32).contains(&op)
+}
+
+/// Módulo en secciones (orden lógico de SPIR-V)
+#[derive(Debug, Clone, Default)]
+pub struct SpirvModule {
+    /// Capabilities, memory model, entry point y execution modes
+    pub preamble: Vec<Inst>,
+    /// Decoraciones
+    pub annotations: Vec<Inst>,
+    /// Tipos, constantes y variables globales
+    pub globals: Vec<Inst>,
+    /// La función main
+    pub body: Vec<Inst>,
+    /// Siguiente id libre
+    pub bound: u32,
+    constants: HashMap<(u32, u32), u32>,
+}
+
+impl SpirvModule {
+    pub fn new() -> Self {
+        SpirvModule { bound: 1, ..Default::default() }
+    }
+
+    pub fn alloc_id(&mut self) -> u32 {
+        let id = self.bound;
+        self.bound += 1;
+        id
+    }
+
+    /// OpConstant de 32 bits, una sola vez por (tipo, valor)
+    pub fn constant(&mut self, ty: u32, bits: u32) -> u32 {
+        if let Some(&id) = self.constants.get(&(ty, bits)) {
+            return id;
+        }
+        let id = self.alloc_id();
+        self.globals.push(Inst::new(SpirVOp::OpConstant, &[ty, id, bits]));
+        self.constants.insert((ty, bits), id);
+        id
+    }
+
+    /// (tipo, bits) de una constante
+    fn constant_value(&self, id: u32) -> Option<(u32, u32)> {
+        self.globals
+            .iter()
+            .find(|g| g.is(SpirVOp::OpConstant) && g.operands[1] == id)
+            .map(|g| (g.operands[0], g.operands[2]))
+    }
+
+    pub fn to_words(&self, generator: u32) -> Vec<u32> {
+        let mut words = vec![0x0723_0203, 0x0001_0500, generator, self.bound, 0];
+        for inst in self.preamble.iter().chain(&self.annotations).chain(&self.globals).chain(&self.body) {
+            inst.encode(&mut words);
+        }
+        words
+    }
+
+    pub fn to_bytes(&self, generator: u32) -> Vec<u8> {
+        self.to_words(generator).iter().flat_map(|w| w.to_le_bytes()).collect()
+    }
+}
+
+/// Corre todas las pasadas
+pub fn optimize(module: &mut SpirvModule) {
+    fold_and_forward(module);
+    dce(module);
+}
+
+/// Pasadas 1 y 2 en un solo recorrido del bloque
+pub fn fold_and_forward(module: &mut SpirvModule) {
+    let body = std::mem::take(&mut module.body);
+    let mut out: Vec<Option<Inst>> = Vec::with_capacity(body.len());
+    let mut subst: HashMap<u32, u32> = HashMap::new();
+    let mut chains: HashMap<Vec<u32>, u32> = HashMap::new();
+    let mut loaded: HashMap<u32, u32> = HashMap::new();
+    // Puntero → índice en `out` de su último store aún no leído
+    let mut pending: HashMap<u32, usize> = HashMap::new();
+
+    for mut inst in body {
+        for i in 0..inst.operands.len() {
+            if inst.id_operand(i) {
+                if let Some(&to) = subst.get(&inst.operands[i]) {
+                    inst.operands[i] = to;
+                }
+            }
+        }
+        let ops = inst.operands.clone();
+        let result = inst.id;
+
+        match inst.op {
+            op if op == SpirVOp::OpIAdd as u32 || op == SpirVOp::OpISub as u32 => {
+                let add = op == SpirVOp::OpIAdd as u32;
+                let (a, b) = (module.constant_value(ops[0]), module.constant_value(ops[1]));
+                let folded = match (a, b) {
+                    (Some((ty, x)), Some((_, y))) => {
+                        Some(module.constant(ty, if add { x.wrapping_add(y) } else { x.wrapping_sub(y) }))
+                    }
+                    (_, Some((_, 0))) => Some(ops[0]),
+                    (Some((_, 0)), _) if add => Some(ops[1]),
+                    _ => None,
+                };
+                if let Some(to) = folded {
+                    subst.insert(result.unwrap(), to);
+                    continue;
+                }
+            }
+            op if is_float_arith(op) => {
+                let (a, b) = (module.constant_value(ops[0]), module.constant_value(ops[1]));
+                let folded = match (a, b) {
+                    (Some((ty, x)), Some((_, y))) => {
+                        let (x, y) = (f32::from_bits(x), f32::from_bits(y));
+                        let v = match op {
+                            o if o == SpirVOp::OpFAdd as u32 => x + y,
+                            o if o == SpirVOp::OpFSub as u32 => x - y,
+                            o if o == SpirVOp::OpFMul as u32 => x * y,
+                            _ => x / y,
+                        };
+                        Some(module.constant(ty, v.to_bits()))
+                    }
+                    // x·1.0 y x/1.0 son exactos; x + 0.0 no (-0.0)
+                    (_, Some((_, one))) if one == 1.0f32.to_bits() && op != SpirVOp::OpFAdd as u32 && op != SpirVOp::OpFSub as u32 => Some(ops[0]),
+                    (Some((_, one)), _) if one == 1.0f32.to_bits() && op == SpirVOp::OpFMul as u32 => Some(ops[1]),
+                    _ => None,
+                };
+                if let Some(to) = folded {
+                    subst.insert(result.unwrap(), to);
+                    continue;
+                }
+            }
+            op if op == SpirVOp::OpAccessChain as u32 => {
+                let mut key = vec![inst.ty.unwrap()];
+                key.extend_from_slice(&ops);
+                if let Some(&same) = chains.get(&key) {
+                    subst.insert(result.unwrap(), same);
+                    continue;
+                }
+                chains.insert(key, result.unwrap());
+            }
+            op if op == SpirVOp::OpLoad as u32 => {
+                if let Some(&value) = loaded.get(&ops[0]) {
+                    subst.insert(result.unwrap(), value);
+                    continue;
+                }
+                // Lee memoria: los stores pendientes ya no son muertos
+                pending.clear();
+                loaded.insert(ops[0], result.unwrap());
+            }
+            op if op == SpirVOp::OpStore as u32 => {
+                let (ptr, value) = (ops[0], ops[1]);
+                if let Some(prev) = pending.insert(ptr, out.len()) {
+                    out[prev] = None;
+                }
+                loaded.clear();
+                loaded.insert(ptr, value);
+            }
+            op if op == SpirVOp::OpControlBarrier as u32 => {
+                // Otros hilos escriben y leen a través de la barrera
+                loaded.clear();
+                pending.clear();
+            }
+            _ => {}
+        }
+        out.push(Some(inst));
+    }
+    module.body = out.into_iter().flatten().collect();
+}
+
+fn is_float_arith(op: u32) -> bool {
+    [SpirVOp::OpFAdd, SpirVOp::OpFSub, SpirVOp::OpFMul, SpirVOp::OpFDiv]
+        .iter()
+        .any(|&o| o as u32 == op)
+}
+
+/// Pasada 3: el bloque es SSA en línea recta, basta un recorrido hacia atrás
+pub fn dce(module: &mut SpirvModule) {
+    let mut used: HashSet<u32> = HashSet::new();
+    let mut live = vec![false; module.body.len()];
+    for (i, inst) in module.body.iter().enumerate().rev() {
+        if inst.is_pure() && !used.contains(&inst.id.unwrap()) {
+            continue;
+        }
+        live[i] = true;
+        used.extend(inst.ty);
+        for (k, &op) in inst.operands.iter().enumerate() {
+            if inst.id_operand(k) {
+                used.insert(op);
+            }
+        }
+    }
+    let mut live = live.into_iter();
+    module.body.retain(|_| live.next().unwrap());
+
+    // Constantes: vivas si las usa el cuerpo u otro global (p.ej. el
+    // largo de un OpTypeArray)
+    for g in &module.globals {
+        if !g.is(SpirVOp::OpConstant) {
+            used.extend(g.operands.iter().skip(1).copied());
+        }
+    }
+    module.globals.retain(|g| !g.is(SpirVOp::OpConstant) || used.contains(&g.operands[1]));
+    let kept: HashSet<u32> = module.globals.iter().filter(|g| g.is(SpirVOp::OpConstant)).map(|g| g.operands[1]).collect();
+    module.constants.retain(|_, id| kept.contains(id));
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// float, uint, un buffer y una función vacía
+    fn module() -> (SpirvModule, u32, u32, u32) {
+        let mut m = SpirvModule::new();
+        let (float, uint, ptr) = (m.alloc_id(), m.alloc_id(), m.alloc_id());
+        m.globals.push(Inst::new(SpirVOp::OpTypeFloat, &[float, 32]));
+        m.globals.push(Inst::new(SpirVOp::OpTypeInt, &[uint, 32, 0]));
+        m.globals.push(Inst::new(SpirVOp::OpTypePointer, &[ptr, 12, float]));
+        (m, float, uint, ptr)
+    }
+
+    #[test]
+    fn test_constant_folding() {
+        let (mut m, float, uint, _) = module();
+        let (two, three) = (m.constant(float, 2.0f32.to_bits()), m.constant(float, 3.0f32.to_bits()));
+        let (one_u, zero_u) = (m.constant(uint, 1), m.constant(uint, 0));
+        let (sum, idx) = (m.alloc_id(), m.alloc_id());
+        m.body.push(Inst::with_result(SpirVOp::OpFAdd, float, sum, &[two, three]));
+        m.body.push(Inst::with_result(SpirVOp::OpIAdd, uint, idx, &[one_u, zero_u]));
+        m.body.push(Inst::new(SpirVOp::OpStore, &[idx, sum]));
+        optimize(&mut m);
+
+        assert_eq!(m.body.len(), 1);
+        let five = m.constant(float, 5.0f32.to_bits());
+        assert_eq!(m.body[0].operands, vec![one_u, five]);
+        // 2.0, 3.0 y 0u quedaron sin uso
+        assert!(m.constant_value(two).is_none() && m.constant_value(zero_u).is_none());
+    }
+
+    #[test]
+    fn test_load_store_forwarding() {
+        let (mut m, float, uint, ptr) = module();
+        let (buf, zero) = (m.alloc_id(), m.constant(uint, 0));
+        let ids: Vec<u32> = (0..7).map(|_| m.alloc_id()).collect();
+        let (p, q, a, b, sum, c, d) = (ids[0], ids[1], ids[2], ids[3], ids[4], ids[5], ids[6]);
+        m.body = vec![
+            Inst::with_result(SpirVOp::OpAccessChain, ptr, p, &[buf, zero]),
+            Inst::with_result(SpirVOp::OpAccessChain, ptr, q, &[buf, zero]), // = p
+            Inst::with_result(SpirVOp::OpLoad, float, a, &[p]),
+            Inst::with_result(SpirVOp::OpLoad, float, b, &[q]), // = a
+            Inst::with_result(SpirVOp::OpFAdd, float, sum, &[a, b]),
+            Inst::new(SpirVOp::OpStore, &[p, a]), // tapado por el siguiente
+            Inst::new(SpirVOp::OpStore, &[p, sum]),
+            Inst::with_result(SpirVOp::OpLoad, float, c, &[p]), // = sum
+            Inst::with_result(SpirVOp::OpFMul, float, d, &[c, c]),
+            Inst::new(SpirVOp::OpStore, &[q, d]), // tapa también a `p = sum`
+        ];
+        optimize(&mut m);
+
+        let ops: Vec<u32> = m.body.iter().map(|i| i.op).collect();
+        use SpirVOp::*;
+        assert_eq!(
+            ops,
+            [OpAccessChain, OpLoad, OpFAdd, OpFMul, OpStore].map(|o| o as u32)
+        );
+        assert_eq!(m.body[2].operands, vec![a, a]);
+        assert_eq!(m.body[3].operands, vec![sum, sum]);
+        assert_eq!(m.body[4].operands, vec![p, d]);
+    }
+}
@@ -4,6 +4,7 @@
 //
 // Autor: Eddi Andreé Salazar Matos
 
+use crate::spirv::SpirvTarget;
 use ash::vk;
 use std::ffi::CStr;
 use std::time::Instant;
@@ -33,6 +34,10 @@ pub struct DeviceProperties {
     pub max_compute_workgroup_size: [u32; 3],
     pub max_compute_workgroup_invocations: u32,
     pub max_compute_shared_memory: u32,
+    /// VkPhysicalDeviceSubgroupProperties::subgroupSize
+    pub subgroup_size: u32,
+    /// OpGroupNonUniform{Reduce,Scan} disponibles en compute
+    pub subgroup_arithmetic: bool,
 }
 
 /// Métricas de runtime
@@ -117,6 +122,14 @@ impl VulkanRuntime {
         // Obtener límites de compute
         let limits = props.limits;
 
+        // Subgroups (core 1.1): deciden el workgroup y si las reducciones
+        // usan OpGroupNonUniform*
+        let mut subgroup = vk::PhysicalDeviceSubgroupProperties::default();
+        let mut props2 = vk::PhysicalDeviceProperties2::builder().push_next(&mut subgroup).build();
+        instance.get_physical_device_properties2(physical_device, &mut props2);
+        let subgroup_arithmetic = subgroup.supported_stages.contains(vk::ShaderStageFlags::COMPUTE)
+            && subgroup.supported_operations.contains(vk::SubgroupFeatureFlags::ARITHMETIC);
+
         let device_props = DeviceProperties {
             name: device_name,
             vendor_id: props.vendor_id,
@@ -125,6 +138,8 @@ impl VulkanRuntime {
             max_compute_workgroup_size: limits.max_compute_work_group_size,
             max_compute_workgroup_invocations: limits.max_compute_work_group_invocations,
             max_compute_shared_memory: limits.max_compute_shared_memory_size,
+            subgroup_size: subgroup.subgroup_size.max(1),
+            subgroup_arithmetic,
         };
 
         Ok(VulkanRuntime {
@@ -383,6 +398,15 @@ impl VulkanRuntime {
             .map_err(|e| format!("Failed to create shader module: {:?}", e))
     }
 
+    /// Destino de generación SPIR-V para este dispositivo
+    pub fn spirv_target(&self) -> SpirvTarget {
+        SpirvTarget {
+            subgroup_size: self.device_props.subgroup_size,
+            subgroup_arithmetic: self.device_props.subgroup_arithmetic,
+            max_invocations: self.device_props.max_compute_workgroup_invocations,
+        }
+    }
+
     /// Crea compute pipeline
     pub unsafe fn create_compute_pipeline(
         &self,
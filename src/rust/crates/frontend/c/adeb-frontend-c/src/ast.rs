@@ -1,8 +1,11 @@
 // C99 AST for ADead-BIB C Frontend
 // Represents C programs before lowering to ADead-BIB IR
 
+use serde::{Deserialize, Serialize};
+use std::collections::BTreeSet;
+
 /// C type representation
-#[derive(Debug, Clone, PartialEq)]
+#[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
 pub enum CType {
     Void,
     Char,
@@ -33,7 +36,7 @@ pub enum CType {
 }
 
 /// C expression
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub enum CExpr {
     IntLiteral(i64),
     FloatLiteral(f64),
@@ -120,7 +123,7 @@ pub enum CExpr {
 }
 
 /// C99/C11 Initializer — first-class representation for aggregate initialization
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub enum CInitializer {
     /// Simple expression initializer: = expr
     Expr(CExpr),
@@ -129,7 +132,7 @@ pub enum CInitializer {
 }
 
 /// One entry in an initializer list, optionally with designators
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct CInitEntry {
     /// Designator chain: .field, [idx], or nested .a.b[3]
     pub designators: Vec<CDesignator>,
@@ -138,7 +141,7 @@ pub struct CInitEntry {
 }
 
 /// C99/C11 Designator for designated initializers
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub enum CDesignator {
     /// .field_name
     Field(String),
@@ -148,7 +151,7 @@ pub enum CDesignator {
     Range(CExpr, CExpr),
 }
 
-#[derive(Debug, Clone, Copy, PartialEq)]
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
 pub enum CBinOp {
     Add,
     Sub,
@@ -170,7 +173,7 @@ pub enum CBinOp {
     Ge,
 }
 
-#[derive(Debug, Clone, Copy, PartialEq)]
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
 pub enum CUnaryOp {
     Neg,     // -x
     LogNot,  // !x
@@ -181,7 +184,7 @@ pub enum CUnaryOp {
     PostDec, // x--
 }
 
-#[derive(Debug, Clone, Copy, PartialEq)]
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
 pub enum CAssignOp {
     Assign,    // =
     AddAssign, // +=
@@ -197,7 +200,7 @@ pub enum CAssignOp {
 }
 
 /// C statement
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub enum CStmt {
     // Expression statement: expr;
     Expr(CExpr),
@@ -268,30 +271,31 @@ pub enum CStmt {
 }
 
 /// Switch case
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct CSwitchCase {
     pub value: Option<CExpr>, // None = default
     pub body: Vec<CStmt>,
 }
 
 /// Variable declarator (handles: int x = 5, *y, z[10])
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct CDeclarator {
     pub name: String,
     pub derived_type: Option<CDerivedType>, // pointer/array modifications
     pub initializer: Option<CInitializer>,
     pub full_type: Option<CType>,          // resolved full type
+    pub align: Option<usize>,              // _Alignas / __declspec(align) / aligned(N)
 }
 
 /// Type modifications on declarators
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub enum CDerivedType {
     Pointer(Option<Box<CDerivedType>>),              // *
     Array(Option<usize>, Option<Box<CDerivedType>>), // [N]
 }
 
 /// Top-level C declarations
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub enum CTopLevel {
     // Function definition
     FunctionDef {
@@ -340,14 +344,14 @@ pub enum CTopLevel {
 }
 
 /// Function parameter
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct CParam {
     pub param_type: CType,
     pub name: Option<String>, // can be unnamed in prototypes
 }
 
 /// Struct field
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct CStructField {
     pub field_type: CType,
     pub name: String,
@@ -355,7 +359,7 @@ pub struct CStructField {
 }
 
 /// Storage class and specifiers for declarations
-#[derive(Debug, Clone, Default)]
+#[derive(Debug, Clone, Default, Serialize, Deserialize)]
 pub struct CDeclSpecifiers {
     pub is_static: bool,
     pub is_extern: bool,
@@ -367,15 +371,19 @@ pub struct CDeclSpecifiers {
 }
 
 /// Complete C translation unit (a .c file)
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct CTranslationUnit {
     pub declarations: Vec<CTopLevel>,
+    /// Top-level functions and globals declared `static`
+    #[serde(default)]
+    pub internal: BTreeSet<String>,
 }
 
 impl CTranslationUnit {
     pub fn new() -> Self {
         Self {
             declarations: Vec::new(),
+            internal: BTreeSet::new(),
         }
     }
 }
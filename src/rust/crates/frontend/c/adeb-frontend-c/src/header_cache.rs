@@ -0,0 +1,505 @@
+// ============================================================
+// ADead-BIB C Header Cache — fastos.bib for built-in headers
+// ============================================================
+// Los headers built-in (stdlib.rs) se lexean y parsean UNA vez por
+// combinación de includes y se guardan en fastos.bib:
+//   ast_data → declaraciones CTopLevel (JSON)
+//   types    → typedef/struct/enum names (se siembran en el parser)
+//   symbols  → prototipos y definiciones de funciones
+// El source del usuario se preprocesa sin pegar el texto de los headers
+// y se parsea con la tabla de typedefs ya cargada.
+//
+// Materialización perezosa: cada declaración queda indexada por los
+// nombres que define. Al TU solo se le anteponen las que alcanza desde
+// sus identificadores (cierre transitivo sobre tipos, llamadas dentro
+// de los `static inline` y constantes) — incluir windows.h para usar
+// dos funciones cuesta dos funciones, no el header entero.
+//
+// Cache hit = leer archivo + deserializar. Cache miss = parse + escribir.
+// ============================================================
+
+use crate::ast::{
+    CDeclarator, CDesignator, CExpr, CInitializer, CParam, CStmt, CTopLevel, CType,
+};
+use crate::parse::lexer::CLexer;
+use crate::parse::parser::CParser;
+use crate::stdlib;
+use adeb_core::cache::{
+    build_id, deserializer, hasher, serializer, validator, ADeadCache, CachedSymbol,
+    CachedSymbolKind, CachedType, CachedTypeKind,
+};
+use std::collections::{HashMap, HashSet};
+use std::path::PathBuf;
+use std::sync::{Arc, Mutex, OnceLock};
+
+/// Built-in headers already parsed: declarations + typedef names, indexed
+/// by the names each declaration defines
+#[derive(Debug, Clone)]
+pub struct ParsedHeaders {
+    pub declarations: Vec<CTopLevel>,
+    pub typedef_names: Vec<String>,
+    /// name → declarations defining it (prototype and definition, tag and
+    /// typedef, enum and its constants)
+    index: HashMap<String, Vec<usize>>,
+    /// Names each declaration needs, by position
+    references: Vec<Vec<String>>,
+}
+
+impl ParsedHeaders {
+    pub fn new(declarations: Vec<CTopLevel>, typedef_names: Vec<String>) -> Self {
+        let mut index: HashMap<String, Vec<usize>> = HashMap::new();
+        let mut references = Vec::with_capacity(declarations.len());
+        for (i, decl) in declarations.iter().enumerate() {
+            for name in defined_names(decl) {
+                index.entry(name.to_string()).or_default().push(i);
+            }
+            let mut refs = Vec::new();
+            referenced_names(decl, &mut refs);
+            refs.sort();
+            refs.dedup();
+            references.push(refs);
+        }
+        Self { declarations, typedef_names, index, references }
+    }
+
+    /// Whether some declaration of these headers defines `name`
+    pub fn defines(&self, name: &str) -> bool {
+        self.index.contains_key(name)
+    }
+
+    /// Declarations reachable from `roots` (the identifiers the TU uses),
+    /// in header order
+    pub fn materialize<'a>(&self, roots: impl IntoIterator<Item = &'a str>) -> Vec<CTopLevel> {
+        let mut wanted = vec![false; self.declarations.len()];
+        let mut seen: HashSet<&str> = HashSet::new();
+        let mut pending: Vec<&str> = roots.into_iter().collect();
+        while let Some(name) = pending.pop() {
+            if !seen.insert(name) {
+                continue;
+            }
+            for &i in self.index.get(name).into_iter().flatten() {
+                if !wanted[i] {
+                    wanted[i] = true;
+                    pending.extend(self.references[i].iter().map(String::as_str));
+                }
+            }
+        }
+        self.declarations
+            .iter()
+            .zip(wanted)
+            .filter_map(|(decl, wanted)| wanted.then(|| decl.clone()))
+            .collect()
+    }
+}
+
+/// Names a top-level declaration introduces
+fn defined_names(decl: &CTopLevel) -> Vec<&str> {
+    match decl {
+        CTopLevel::FunctionDef { name, .. }
+        | CTopLevel::FunctionDecl { name, .. }
+        | CTopLevel::StructDef { name, .. }
+        | CTopLevel::UnionDef { name, .. } => vec![name],
+        CTopLevel::GlobalVar { declarators, .. } => declarators.iter().map(|d| d.name.as_str()).collect(),
+        CTopLevel::EnumDef { name, values } => {
+            std::iter::once(name.as_str()).chain(values.iter().map(|(v, _)| v.as_str())).collect()
+        }
+        CTopLevel::TypedefDecl { new_name, .. } => vec![new_name],
+    }
+}
+
+/// Every type, function, variable or constant name `decl` refers to
+/// (field names are not top-level names and are left out)
+pub fn referenced_names(decl: &CTopLevel, out: &mut Vec<String>) {
+    match decl {
+        CTopLevel::FunctionDef { return_type, params, body, .. } => {
+            type_names(return_type, out);
+            params.iter().for_each(|p| type_names(&p.param_type, out));
+            body.iter().for_each(|s| stmt_names(s, out));
+        }
+        CTopLevel::FunctionDecl { return_type, params, .. } => {
+            type_names(return_type, out);
+            params.iter().for_each(|p| type_names(&p.param_type, out));
+        }
+        CTopLevel::GlobalVar { type_spec, declarators } => {
+            type_names(type_spec, out);
+            declarators.iter().for_each(|d| declarator_names(d, out));
+        }
+        CTopLevel::StructDef { fields, .. } | CTopLevel::UnionDef { fields, .. } => {
+            fields.iter().for_each(|f| type_names(&f.field_type, out));
+        }
+        CTopLevel::EnumDef { .. } => {}
+        CTopLevel::TypedefDecl { original, .. } => type_names(original, out),
+    }
+}
+
+fn type_names(ty: &CType, out: &mut Vec<String>) {
+    match ty {
+        CType::Struct(name) | CType::Union(name) | CType::Enum(name) | CType::Typedef(name) => {
+            out.push(name.clone())
+        }
+        CType::Unsigned(inner)
+        | CType::Signed(inner)
+        | CType::Pointer(inner)
+        | CType::Array(inner, _)
+        | CType::Const(inner)
+        | CType::Volatile(inner)
+        | CType::Complex(inner) => type_names(inner, out),
+        CType::Function { return_type, params } => {
+            type_names(return_type, out);
+            params.iter().for_each(|p| type_names(p, out));
+        }
+        _ => {}
+    }
+}
+
+fn declarator_names(d: &CDeclarator, out: &mut Vec<String>) {
+    if let Some(ty) = &d.full_type {
+        type_names(ty, out);
+    }
+    if let Some(init) = &d.initializer {
+        initializer_names(init, out);
+    }
+}
+
+fn initializer_names(init: &CInitializer, out: &mut Vec<String>) {
+    match init {
+        CInitializer::Expr(e) => expr_names(e, out),
+        CInitializer::List(entries) => {
+            for entry in entries {
+                for designator in &entry.designators {
+                    match designator {
+                        CDesignator::Field(_) => {}
+                        CDesignator::Index(e) => expr_names(e, out),
+                        CDesignator::Range(lo, hi) => {
+                            expr_names(lo, out);
+                            expr_names(hi, out);
+                        }
+                    }
+                }
+                initializer_names(&entry.value, out);
+            }
+        }
+    }
+}
+
+fn stmt_names(stmt: &CStmt, out: &mut Vec<String>) {
+    match stmt {
+        CStmt::Expr(e) | CStmt::Return(Some(e)) => expr_names(e, out),
+        CStmt::VarDecl { type_spec, declarators, .. } => {
+            type_names(type_spec, out);
+            declarators.iter().for_each(|d| declarator_names(d, out));
+        }
+        CStmt::Block(stmts) => stmts.iter().for_each(|s| stmt_names(s, out)),
+        CStmt::If { condition, then_body, else_body } => {
+            expr_names(condition, out);
+            stmt_names(then_body, out);
+            if let Some(other) = else_body {
+                stmt_names(other, out);
+            }
+        }
+        CStmt::While { condition, body } | CStmt::DoWhile { body, condition } => {
+            expr_names(condition, out);
+            stmt_names(body, out);
+        }
+        CStmt::For { init, condition, update, body } => {
+            if let Some(init) = init {
+                stmt_names(init, out);
+            }
+            condition.iter().chain(update).for_each(|e| expr_names(e, out));
+            stmt_names(body, out);
+        }
+        CStmt::Switch { expr, cases } => {
+            expr_names(expr, out);
+            for case in cases {
+                if let Some(value) = &case.value {
+                    expr_names(value, out);
+                }
+                case.body.iter().for_each(|s| stmt_names(s, out));
+            }
+        }
+        CStmt::Label(_, body) => stmt_names(body, out),
+        CStmt::Return(None)
+        | CStmt::Break
+        | CStmt::Continue
+        | CStmt::Goto(_)
+        | CStmt::Empty
+        | CStmt::LineMarker(_) => {}
+    }
+}
+
+fn expr_names(expr: &CExpr, out: &mut Vec<String>) {
+    match expr {
+        CExpr::Identifier(name) => out.push(name.clone()),
+        CExpr::BinaryOp { left, right, .. } => {
+            expr_names(left, out);
+            expr_names(right, out);
+        }
+        CExpr::UnaryOp { expr, .. }
+        | CExpr::SizeofExpr(expr)
+        | CExpr::AddressOf(expr)
+        | CExpr::Deref(expr)
+        | CExpr::Member { object: expr, .. }
+        | CExpr::ArrowMember { pointer: expr, .. } => expr_names(expr, out),
+        CExpr::Call { func, args } => {
+            expr_names(func, out);
+            args.iter().for_each(|a| expr_names(a, out));
+        }
+        CExpr::Index { array, index } => {
+            expr_names(array, out);
+            expr_names(index, out);
+        }
+        CExpr::Cast { target_type, expr } => {
+            type_names(target_type, out);
+            expr_names(expr, out);
+        }
+        CExpr::SizeofType(ty) => type_names(ty, out),
+        CExpr::Ternary { condition, then_expr, else_expr } => {
+            expr_names(condition, out);
+            expr_names(then_expr, out);
+            expr_names(else_expr, out);
+        }
+        CExpr::Assign { target, value, .. } => {
+            expr_names(target, out);
+            expr_names(value, out);
+        }
+        CExpr::Comma(items) | CExpr::InitList(items) => items.iter().for_each(|e| expr_names(e, out)),
+        CExpr::IntLiteral(_)
+        | CExpr::FloatLiteral(_)
+        | CExpr::StringLiteral(_)
+        | CExpr::CharLiteral(_)
+        | CExpr::Null => {}
+    }
+}
+
+/// Text the preprocessor would paste for `headers` (prologue first, then
+/// each header in inclusion order)
+pub fn header_source(headers: &[String]) -> String {
+    let mut out = String::new();
+    if headers.is_empty() {
+        return out;
+    }
+    out.push_str("# 1 \"<common_prologue>\"\n");
+    out.push_str(stdlib::COMMON_PROLOGUE);
+    out.push('\n');
+    for name in headers {
+        if let Some(text) = stdlib::get_header(name) {
+            out.push_str(&format!("# 1 \"{}\"\n", name));
+            out.push_str(text);
+            out.push('\n');
+        }
+    }
+    out
+}
+
+/// Cache key: content of every header + compiler build id
+pub fn header_key(headers: &[String]) -> u64 {
+    let salt = format!("{}\0{}\0", build_id(), headers.join("\0"));
+    hasher::hash_bytes(salt.as_bytes()) ^ hasher::hash_bytes(header_source(headers).as_bytes())
+}
+
+/// Lex + parse the built-in headers (cache miss path)
+pub fn parse_headers(headers: &[String]) -> Result<ParsedHeaders, String> {
+    let source = header_source(headers);
+    let (tokens, lines) = CLexer::new(&source).tokenize();
+    let mut parser = CParser::new(tokens, lines);
+    let unit = parser.parse_translation_unit()?;
+    let mut typedef_names: Vec<String> = parser.typedef_names().iter().cloned().collect();
+    typedef_names.sort();
+    Ok(ParsedHeaders::new(unit.declarations, typedef_names))
+}
+
+fn render_params(params: &[CParam]) -> Vec<String> {
+    params.iter().map(|p| format!("{:?}", p.param_type)).collect()
+}
+
+/// Build the fastos.bib image for parsed headers
+pub fn to_cache(headers: &[String], parsed: &ParsedHeaders) -> Result<ADeadCache, String> {
+    let mut cache = ADeadCache::new(header_key(headers));
+    cache.ast_data = serde_json::to_vec(&parsed.declarations).map_err(|e| e.to_string())?;
+    index_declarations(&mut cache, &parsed.declarations, &parsed.typedef_names, &headers.join(","));
+    Ok(cache)
+}
+
+/// Index typedef/struct names into `cache.types` and functions into
+/// `cache.symbols` (shared with the precompiled user headers)
+pub(crate) fn index_declarations(
+    cache: &mut ADeadCache,
+    declarations: &[CTopLevel],
+    typedef_names: &[String],
+    source_file: &str,
+) {
+    for name in typedef_names {
+        cache.types.insert(
+            name.clone(),
+            CachedType {
+                name: name.clone(),
+                size: 0,
+                alignment: 0,
+                kind: CachedTypeKind::Primitive,
+            },
+        );
+    }
+    for decl in declarations {
+        match decl {
+            CTopLevel::StructDef { name, fields } | CTopLevel::UnionDef { name, fields } => {
+                cache.types.insert(
+                    name.clone(),
+                    CachedType {
+                        name: name.clone(),
+                        size: 0,
+                        alignment: 0,
+                        kind: CachedTypeKind::Struct {
+                            fields: fields
+                                .iter()
+                                .map(|f| (f.name.clone(), format!("{:?}", f.field_type)))
+                                .collect(),
+                        },
+                    },
+                );
+            }
+            CTopLevel::FunctionDecl { return_type, name, params }
+            | CTopLevel::FunctionDef { return_type, name, params, .. } => {
+                cache.symbols.insert(
+                    name.clone(),
+                    CachedSymbol {
+                        name: name.clone(),
+                        kind: CachedSymbolKind::Function {
+                            params: render_params(params),
+                            ret: format!("{:?}", return_type),
+                        },
+                        source_file: source_file.to_string(),
+                    },
+                );
+            }
+            _ => {}
+        }
+    }
+}
+
+/// Restore parsed headers from a fastos.bib image
+pub fn from_cache(cache: &ADeadCache) -> Result<ParsedHeaders, String> {
+    let declarations: Vec<CTopLevel> =
+        serde_json::from_slice(&cache.ast_data).map_err(|e| e.to_string())?;
+    let mut typedef_names: Vec<String> = cache
+        .types
+        .entries
+        .keys()
+        .cloned()
+        .collect();
+    typedef_names.sort();
+    Ok(ParsedHeaders::new(declarations, typedef_names))
+}
+
+/// Directory for fastos.bib files: `ADEB_CACHE_DIR` or `<tmp>/adB-cache`.
+/// `ADEB_HEADER_CACHE=0` disables the on-disk cache.
+fn cache_dir() -> Option<PathBuf> {
+    if std::env::var("ADEB_HEADER_CACHE").map(|v| v == "0").unwrap_or(false) {
+        return None;
+    }
+    match std::env::var("ADEB_CACHE_DIR") {
+        Ok(dir) if !dir.is_empty() => Some(PathBuf::from(dir)),
+        _ => Some(std::env::temp_dir().join("adB-cache")),
+    }
+}
+
+fn memo() -> &'static Mutex<HashMap<u64, Arc<ParsedHeaders>>> {
+    static MEMO: OnceLock<Mutex<HashMap<u64, Arc<ParsedHeaders>>>> = OnceLock::new();
+    MEMO.get_or_init(|| Mutex::new(HashMap::new()))
+}
+
+/// Parsed built-in headers for this include list: in-process memo, then
+/// fastos.bib on disk, then a fresh parse (which refreshes fastos.bib).
+pub fn load_headers(headers: &[String]) -> Result<Arc<ParsedHeaders>, String> {
+    let key = header_key(headers);
+    if let Some(hit) = memo().lock().unwrap().get(&key) {
+        return Ok(hit.clone());
+    }
+
+    let path = cache_dir().map(|d| d.join(format!("fastos-{:016x}.bib", key)));
+    let mut parsed = None;
+    if let Some(path) = &path {
+        if let Ok(cache) = deserializer::read_from_file(&path.to_string_lossy()) {
+            if validator::validate(&cache, key) == validator::CacheStatus::Hit {
+                parsed = from_cache(&cache).ok();
+            }
+        }
+    }
+
+    let parsed = match parsed {
+        Some(p) => p,
+        None => {
+            let p = parse_headers(headers)?;
+            if let Some(path) = &path {
+                if let Ok(cache) = to_cache(headers, &p) {
+                    // Best effort: a missing cache only costs a reparse
+                    let _ = write_cache_file(path, &cache);
+                }
+            }
+            p
+        }
+    };
+
+    let parsed = Arc::new(parsed);
+    memo().lock().unwrap().insert(key, parsed.clone());
+    Ok(parsed)
+}
+
+fn write_cache_file(path: &PathBuf, cache: &ADeadCache) -> std::io::Result<()> {
+    if let Some(dir) = path.parent() {
+        std::fs::create_dir_all(dir)?;
+    }
+    let tmp = path.with_extension(format!("bib.tmp{}", std::process::id()));
+    serializer::write_to_file(cache, &tmp.to_string_lossy())?;
+    std::fs::rename(&tmp, path)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_cache_roundtrip() {
+        let headers = vec!["stdio.h".to_string(), "stdlib.h".to_string()];
+        let parsed = parse_headers(&headers).unwrap();
+        assert!(!parsed.declarations.is_empty());
+        assert!(parsed.typedef_names.iter().any(|n| n == "size_t"));
+
+        let bytes = serializer::serialize(&to_cache(&headers, &parsed).unwrap());
+        let restored = from_cache(&deserializer::deserialize(&bytes).unwrap()).unwrap();
+        assert_eq!(restored.declarations.len(), parsed.declarations.len());
+        for name in &parsed.typedef_names {
+            assert!(restored.typedef_names.contains(name), "lost typedef {}", name);
+        }
+    }
+
+    #[test]
+    fn test_materialize_only_what_is_reachable() {
+        let headers = vec!["stdio.h".to_string(), "ctype.h".to_string()];
+        let parsed = parse_headers(&headers).unwrap();
+        assert!(parsed.defines("printf") && parsed.defines("isalpha"));
+        assert!(!parsed.defines("no_such_function"));
+
+        let used = parsed.materialize(["isalpha"]);
+        assert!(used.len() < parsed.declarations.len() / 4, "{} of {}", used.len(), parsed.declarations.len());
+        let names: Vec<&str> = used.iter().flat_map(defined_names).collect();
+        assert!(names.contains(&"isalpha"));
+        assert!(!names.contains(&"printf"));
+        // `static inline isalpha` calls its siblings: they come along
+        let mut refs = Vec::new();
+        for decl in &used {
+            referenced_names(decl, &mut refs);
+        }
+        for name in refs.iter().filter(|n| parsed.defines(n)) {
+            assert!(names.contains(&name.as_str()), "missing dependency {}", name);
+        }
+        assert!(parsed.materialize(std::iter::empty()).is_empty());
+    }
+
+    #[test]
+    fn test_header_key_depends_on_order() {
+        let a = vec!["stdio.h".to_string(), "math.h".to_string()];
+        let b = vec!["math.h".to_string(), "stdio.h".to_string()];
+        assert_ne!(header_key(&a), header_key(&b));
+        assert_eq!(header_key(&a), header_key(&a.clone()));
+    }
+}
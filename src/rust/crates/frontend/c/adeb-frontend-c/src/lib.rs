@@ -4,6 +4,8 @@
 
 pub mod ast;
 pub mod compiler_extensions;
+pub mod header_cache;
+pub mod pch;
 pub mod preprocessor;
 pub mod stdlib;
 
@@ -15,7 +15,7 @@
 use crate::c_ast::*;
 use crate::frontend::ast::{
     self, BinOp, BitwiseOp, CmpOp, Expr, Function, FunctionAttributes, Param, Program,
-    ProgramAttributes, Stmt, Struct, StructField, UnaryOp,
+    ProgramAttributes, Stmt, Struct, StructField, SwitchCase, UnaryOp,
 };
 use crate::frontend::types::Type;
 
@@ -46,8 +46,30 @@ impl CToIR {
 
     /// Main entry: Convert entire C translation unit → ADead-BIB Program
     pub fn convert(&mut self, unit: &CTranslationUnit) -> Result<Program, String> {
+        let mut program = self.begin(unit);
+        for decl in &unit.declarations {
+            self.lower_decl(decl, &mut program)?;
+        }
+        Ok(program)
+    }
+
+    /// `convert` that consumes the unit: each function body is freed as
+    /// soon as it is lowered, so the AST and the IR of the whole file are
+    /// never alive at the same time
+    pub fn convert_owned(&mut self, unit: CTranslationUnit) -> Result<Program, String> {
+        let mut program = self.begin(&unit);
+        for decl in unit.declarations {
+            self.lower_decl(&decl, &mut program)?;
+        }
+        Ok(program)
+    }
+
+    /// Passes that need the whole unit: structs, enums, typedefs and the
+    /// static locals hoisted to globals
+    fn begin(&mut self, unit: &CTranslationUnit) -> Program {
         let mut program = Program::new();
         program.attributes = ProgramAttributes::default();
+        program.attributes.internal_symbols = unit.internal.clone();
 
         // First pass: collect structs, enums, typedefs
         for decl in &unit.declarations {
@@ -77,50 +99,67 @@ impl CToIR {
                 self.collect_static_locals(body, &mut program.statements);
             }
         }
+        // Static locals have no linkage either
+        for stmt in &program.statements {
+            if let Stmt::VarDecl { name, .. } = stmt {
+                program.attributes.internal_symbols.insert(name.clone());
+            }
+        }
+        program
+    }
 
-        for decl in &unit.declarations {
-            match decl {
-                CTopLevel::FunctionDef {
-                    return_type,
-                    name,
-                    params,
-                    body,
-                } => {
-                    let func = self.convert_function(return_type, name, params, body)?;
-                    program.functions.push(func);
-                }
-                CTopLevel::FunctionDecl { .. } => {
-                    // Prototypes — skip (resolved at link time)
+    /// Lower one function or global into `program`
+    fn lower_decl(&mut self, decl: &CTopLevel, program: &mut Program) -> Result<(), String> {
+        match decl {
+            CTopLevel::FunctionDef {
+                return_type,
+                name,
+                params,
+                body,
+            } => {
+                let func = self.convert_function(return_type, name, params, body)?;
+                if !program.attributes.internal_symbols.contains(name) {
+                    program.attributes.external_definitions.insert(name.clone());
                 }
-                CTopLevel::GlobalVar {
-                    type_spec,
-                    declarators,
-                } => {
-                    for decl_item in declarators {
-                        let var_type =
-                            self.resolve_declarator_type(type_spec, &decl_item.derived_type);
-                        let init_val = if let Some(ref init) = decl_item.initializer {
-                            match init {
-                                CInitializer::Expr(expr) => Some(self.convert_expr(expr)?),
-                                CInitializer::List(entries) => {
-                                    Some(self.convert_init_list(entries)?)
-                                }
+                program.functions.push(func);
+            }
+            CTopLevel::FunctionDecl { .. } => {
+                // Prototypes — skip (resolved at link time)
+            }
+            CTopLevel::GlobalVar {
+                type_spec,
+                declarators,
+            } => {
+                for decl_item in declarators {
+                    let var_type =
+                        self.resolve_declarator_type(type_spec, &decl_item.derived_type);
+                    let init_val = if let Some(ref init) = decl_item.initializer {
+                        match init {
+                            CInitializer::Expr(expr) => Some(self.convert_expr(expr)?),
+                            CInitializer::List(entries) => {
+                                Some(self.convert_init_list(entries)?)
                             }
-                        } else {
-                            None
-                        };
-                        program.statements.push(Stmt::VarDecl {
-                            var_type,
-                            name: decl_item.name.clone(),
-                            value: init_val,
-                        });
+                        }
+                    } else {
+                        None
+                    };
+                    if let Some(align) = decl_item.align {
+                        program.attributes.global_align.insert(decl_item.name.clone(), align as u64);
+                    }
+                    // `int x;` is tentative: it merges with another TU's definition
+                    if init_val.is_some() && !program.attributes.internal_symbols.contains(&decl_item.name) {
+                        program.attributes.external_definitions.insert(decl_item.name.clone());
                     }
+                    program.statements.push(Stmt::VarDecl {
+                        var_type,
+                        name: decl_item.name.clone(),
+                        value: init_val,
+                    });
                 }
-                _ => {}
             }
+            _ => {}
         }
-
-        Ok(program)
+        Ok(())
     }
 
     // ========== Type conversion ==========
@@ -480,49 +519,51 @@ impl CToIR {
             }
 
             CStmt::Switch { expr, cases } => {
-                let switch_val = self.convert_expr(expr)?;
-                let switch_var = fresh_temp("sw");
-                let mut result = vec![Stmt::Assign {
-                    name: switch_var.clone(),
-                    value: switch_val,
-                }];
-
-                let mut last_else: Option<Vec<Stmt>> = None;
-
-                for case in cases.iter().rev() {
-                    let mut case_body: Vec<Stmt> = Vec::new();
+                // El backend elige el dispatch (tabla, búsqueda binaria o
+                // cadena); aquí solo se conserva el orden del código para
+                // el fall-through, y `break` queda dentro de cada cuerpo.
+                let mut ir_cases: Vec<SwitchCase> = Vec::new();
+                let mut default: Option<Vec<Stmt>> = None;
+                for case in cases {
+                    let mut body = Vec::new();
                     for s in &case.body {
-                        let stmts = self.convert_stmt(s)?;
-                        for st in stmts {
-                            if matches!(st, Stmt::Break) {
-                                break;
-                            }
-                            case_body.push(st);
-                        }
+                        body.extend(self.convert_stmt(s)?);
                     }
-
-                    if let Some(ref val) = case.value {
-                        let cond = Expr::Comparison {
-                            op: CmpOp::Eq,
-                            left: Box::new(Expr::Variable(switch_var.clone())),
-                            right: Box::new(self.convert_expr(val)?),
-                        };
-                        let if_stmt = Stmt::If {
-                            condition: cond,
-                            then_body: case_body,
-                            else_body: last_else.take(),
-                        };
-                        last_else = Some(vec![if_stmt]);
-                    } else {
-                        last_else = Some(case_body);
+                    match &case.value {
+                        Some(val) => ir_cases.push(SwitchCase {
+                            value: self.convert_expr(val)?,
+                            has_break: body.iter().any(|s| matches!(s, Stmt::Break)),
+                            body,
+                        }),
+                        None => default = Some(body),
                     }
                 }
 
-                if let Some(stmts) = last_else {
-                    result.extend(stmts);
+                // default en medio: el backend lo pone al final, así que se
+                // enlaza con el caso anterior y el siguiente con labels, y el
+                // último caso ya no cae en él
+                let pos = cases.iter().position(|c| c.value.is_none());
+                if let (Some(pos), Some(body)) = (pos, default.as_mut()) {
+                    if pos < ir_cases.len() {
+                        if let Some(last) = ir_cases.last_mut() {
+                            last.body.push(Stmt::Break);
+                        }
+                        let next = fresh_temp("swnext");
+                        body.push(Stmt::JumpTo { label: next.clone() });
+                        ir_cases[pos].body.insert(0, Stmt::LabelDef { name: next });
+                        if pos > 0 {
+                            let entry = fresh_temp("swdefault");
+                            body.insert(0, Stmt::LabelDef { name: entry.clone() });
+                            ir_cases[pos - 1].body.push(Stmt::JumpTo { label: entry });
+                        }
+                    }
                 }
 
-                Ok(result)
+                Ok(vec![Stmt::Switch {
+                    expr: self.convert_expr(expr)?,
+                    cases: ir_cases,
+                    default,
+                }])
             }
 
             CStmt::Break => Ok(vec![Stmt::Break]),
@@ -1583,6 +1624,29 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_global_alignment_specifiers() {
+        let program = compile_c_to_program(
+            r#"
+            _Alignas(32) float a[8], b[8];
+            __declspec(align(64)) int table[16];
+            double v[4] __attribute__((aligned(32)));
+            _Alignas(double) char tag[8];
+            int plain[4];
+            int main() { return 0; }
+        "#,
+        )
+        .unwrap();
+
+        let align = &program.attributes.global_align;
+        assert_eq!(align.get("a"), Some(&32));
+        assert_eq!(align.get("b"), Some(&32));
+        assert_eq!(align.get("table"), Some(&64));
+        assert_eq!(align.get("v"), Some(&32));
+        assert_eq!(align.get("tag"), Some(&8));
+        assert_eq!(align.get("plain"), None);
+    }
+
     #[test]
     fn test_compound_assign_array() {
         let program = compile_c_to_program(
@@ -1719,9 +1783,15 @@ mod tests {
         )
         .unwrap();
         let body = &prog.functions[0].body;
-        // switch converts to chained if-else
-        let has_if = body.iter().any(|s| matches!(s, Stmt::If { .. }));
-        assert!(has_if, "switch should convert to If chain: {:?}", body);
+        // switch se conserva; el backend elige tabla o comparaciones
+        let switch = body.iter().find_map(|s| match s {
+            Stmt::Switch { cases, default, .. } => Some((cases, default)),
+            _ => None,
+        });
+        let (cases, default) = switch.unwrap_or_else(|| panic!("switch should stay a Switch: {:?}", body));
+        assert_eq!(cases.len(), 2);
+        assert!(matches!(cases[1].value, Expr::Number(2)));
+        assert!(default.is_some());
     }
 
     #[test]
@@ -2049,11 +2119,16 @@ mod tests {
             static int counter = 0;
             extern int printf(const char *fmt, ...);
             static inline int double_it(int x) { return x * 2; }
+            int total = 1, scratch;
             int main() { return double_it(21); }
         "#,
         )
         .unwrap();
         assert!(prog.functions.len() >= 2);
+        let internal: Vec<&str> = prog.attributes.internal_symbols.iter().map(String::as_str).collect();
+        assert_eq!(internal, vec!["counter", "double_it"]);
+        let external: Vec<&str> = prog.attributes.external_definitions.iter().map(String::as_str).collect();
+        assert_eq!(external, vec!["main", "total"]);
     }
 
     #[test]
@@ -5,6 +5,8 @@
 // Pure Rust — no external dependencies
 // ============================================================
 
+use adeb_core::interner::{Ident, IdentCache};
+
 #[derive(Debug, Clone, PartialEq)]
 pub enum CToken {
     // C Keywords
@@ -54,7 +56,7 @@ pub enum CToken {
     ThreadLocal,   // _Thread_local
 
     // Identifiers and literals
-    Identifier(String),
+    Identifier(Ident),
     IntLiteral(i64),
     FloatLiteral(f64),
     StringLiteral(String),
@@ -114,49 +116,89 @@ pub enum CToken {
     Eof,
 }
 
-pub struct CLexer {
-    input: Vec<char>,
+/// Lexer sobre los bytes del source (sin `Vec<char>`): los identificadores
+/// y keywords se cortan como slices y sólo los identificadores se internan
+/// ([`Ident`]); los string literals sin escapes se copian de una vez.
+pub struct CLexer<'a> {
+    src: &'a str,
+    bytes: &'a [u8],
     position: usize,
-    current_char: Option<char>,
     pub line: usize,
     pub column: usize,
     pub token_start_line: usize,
+    idents: IdentCache<'a>,
+}
+
+/// Longitud de un carácter UTF-8 a partir de su primer byte
+fn utf8_len(lead: u8) -> usize {
+    match lead {
+        0x00..=0x7F => 1,
+        0xC0..=0xDF => 2,
+        0xE0..=0xEF => 3,
+        _ => 4,
+    }
 }
 
-impl CLexer {
-    pub fn new(input: &str) -> Self {
-        let chars: Vec<char> = input.chars().collect();
-        let current = chars.first().copied();
+impl<'a> CLexer<'a> {
+    pub fn new(input: &'a str) -> Self {
         Self {
-            input: chars,
+            src: input,
+            bytes: input.as_bytes(),
             position: 0,
-            current_char: current,
             line: 1,
             column: 1,
             token_start_line: 1,
+            idents: IdentCache::new(),
         }
     }
 
+    #[inline]
+    fn current(&self) -> Option<u8> {
+        self.bytes.get(self.position).copied()
+    }
+
+    #[inline]
+    fn peek(&self) -> Option<u8> {
+        self.bytes.get(self.position + 1).copied()
+    }
+
+    /// Carácter completo en la posición actual (para bytes no-ASCII)
+    fn current_char(&self) -> Option<char> {
+        self.src[self.position..].chars().next()
+    }
+
+    #[inline]
     fn advance(&mut self) {
-        if let Some(ch) = self.current_char {
-            if ch == '\n' {
+        match self.current() {
+            None => {}
+            Some(b'\n') => {
                 self.line += 1;
                 self.column = 1;
-            } else {
+                self.position += 1;
+            }
+            Some(b) => {
                 self.column += 1;
+                self.position += utf8_len(b);
             }
         }
-        self.position += 1;
-        self.current_char = self.input.get(self.position).copied();
     }
 
-    fn peek(&self) -> Option<char> {
-        self.input.get(self.position + 1).copied()
+    /// Avanza hasta `end` actualizando línea/columna de una pasada
+    fn advance_to(&mut self, end: usize) {
+        for &b in &self.bytes[self.position..end] {
+            if b == b'\n' {
+                self.line += 1;
+                self.column = 1;
+            } else if b & 0xC0 != 0x80 {
+                self.column += 1;
+            }
+        }
+        self.position = end;
     }
 
     fn skip_whitespace(&mut self) {
-        while let Some(ch) = self.current_char {
-            if ch.is_ascii_whitespace() {
+        while let Some(b) = self.current() {
+            if b.is_ascii_whitespace() {
                 self.advance();
             } else {
                 break;
@@ -165,139 +207,150 @@ impl CLexer {
     }
 
     fn skip_line_comment(&mut self) {
-        while let Some(ch) = self.current_char {
-            if ch == '\n' {
-                self.advance();
-                break;
-            }
-            self.advance();
-        }
+        let end = match self.bytes[self.position..].iter().position(|&b| b == b'\n') {
+            Some(off) => self.position + off + 1,
+            None => self.bytes.len(),
+        };
+        self.advance_to(end);
     }
 
     fn skip_block_comment(&mut self) {
         self.advance(); // skip *
-        loop {
-            match self.current_char {
-                None => break,
-                Some('*') => {
-                    self.advance();
-                    if self.current_char == Some('/') {
-                        self.advance();
-                        break;
-                    }
-                }
-                _ => self.advance(),
-            }
-        }
+        let rest = &self.bytes[self.position..];
+        let end = match rest.windows(2).position(|w| w == b"*/") {
+            Some(off) => self.position + off + 2,
+            None => self.bytes.len(),
+        };
+        self.advance_to(end);
     }
 
     fn skip_preprocessor_line(&mut self) {
-        let mut line_str = String::new();
+        let start = self.position;
+        let mut has_backslash = false;
         // Skip # and entire line
-        while let Some(ch) = self.current_char {
-            if ch == '\n' {
-                // Check if this was a line marker from gcc (e.g. `# 12 "file.c"`)
-                let parts: Vec<&str> = line_str.split_whitespace().collect();
-                if parts.len() >= 2 {
-                    if let Ok(num) = parts[1].parse::<usize>() {
-                        // The preprocessor tells us the NEXT line is `num`
-                        // Since `self.advance()` right below will consume the `\n` and increment `self.line` by 1
-                        // we set `self.line` to `num - 1` so it becomes exactly `num`.
-                        self.line = num.saturating_sub(1);
-                    }
+        while let Some(b) = self.current() {
+            if b == b'\n' {
+                let text = &self.src[start..self.position];
+                if has_backslash {
+                    let spliced = Self::splice_directive(text);
+                    self.apply_line_marker(&spliced);
+                } else {
+                    self.apply_line_marker(text);
                 }
-                
                 self.advance();
-                break;
+                return;
             }
             // Handle line continuation with backslash
-            if ch == '\\' {
+            if b == b'\\' {
+                has_backslash = true;
                 self.advance();
-                if self.current_char == Some('\n') {
+                if self.current() == Some(b'\n') {
                     self.advance();
                     continue;
                 }
             }
-            line_str.push(ch);
             self.advance();
         }
     }
 
-    fn read_identifier(&mut self) -> String {
-        let mut ident = String::new();
-        while let Some(ch) = self.current_char {
-            if ch.is_alphanumeric() || ch == '_' {
-                ident.push(ch);
+    /// Texto de una directiva con `\` tal como lo veía el lexer de chars:
+    /// `\`+newline desaparece, `\`+otro char deja sólo la barra.
+    fn splice_directive(text: &str) -> String {
+        let mut out = String::with_capacity(text.len());
+        let mut chars = text.chars();
+        while let Some(ch) = chars.next() {
+            if ch == '\\' {
+                if chars.next() == Some('\n') {
+                    continue;
+                }
+            }
+            out.push(ch);
+        }
+        out
+    }
+
+    /// Line marker del preprocesador (e.g. `# 12 "file.c"`)
+    fn apply_line_marker(&mut self, text: &str) {
+        let mut parts = text.split_whitespace();
+        if let (Some(_), Some(num)) = (parts.next(), parts.next()) {
+            if let Ok(num) = num.parse::<usize>() {
+                // The preprocessor tells us the NEXT line is `num`
+                // Since `self.advance()` right after will consume the `\n` and increment `self.line` by 1
+                // we set `self.line` to `num - 1` so it becomes exactly `num`.
+                self.line = num.saturating_sub(1);
+            }
+        }
+    }
+
+    fn is_ident_start(&self, b: u8) -> bool {
+        if b < 0x80 {
+            b.is_ascii_alphabetic() || b == b'_'
+        } else {
+            self.current_char().map_or(false, |ch| ch.is_alphabetic())
+        }
+    }
+
+    fn read_identifier(&mut self) -> &'a str {
+        let start = self.position;
+        while let Some(b) = self.current() {
+            if b.is_ascii_alphanumeric() || b == b'_' {
+                self.position += 1;
+                self.column += 1;
+            } else if b >= 0x80 && self.current_char().map_or(false, |ch| ch.is_alphanumeric()) {
                 self.advance();
             } else {
                 break;
             }
         }
-        ident
+        &self.src[start..self.position]
     }
 
     fn read_number(&mut self) -> CToken {
-        let mut num_str = String::new();
         let mut is_float = false;
         // Check for hex: 0x or 0X
-        if self.current_char == Some('0') {
-            if let Some(next) = self.peek() {
-                if next == 'x' || next == 'X' {
-                    self.advance(); // skip 0
-                    self.advance(); // skip x
-                    while let Some(ch) = self.current_char {
-                        if ch.is_ascii_hexdigit() {
-                            num_str.push(ch);
-                            self.advance();
-                        } else {
-                            break;
-                        }
-                    }
-                    // Skip suffixes: U, L, UL, ULL, etc.
-                    self.skip_int_suffix();
-                    let val = i64::from_str_radix(&num_str, 16).unwrap_or(0);
-                    return CToken::IntLiteral(val);
-                }
+        if self.current() == Some(b'0') && matches!(self.peek(), Some(b'x') | Some(b'X')) {
+            self.advance(); // skip 0
+            self.advance(); // skip x
+            let start = self.position;
+            while matches!(self.current(), Some(b) if b.is_ascii_hexdigit()) {
+                self.advance();
             }
+            let digits = &self.src[start..self.position];
+            // Skip suffixes: U, L, UL, ULL, etc.
+            self.skip_int_suffix();
+            let val = i64::from_str_radix(digits, 16).unwrap_or(0);
+            return CToken::IntLiteral(val);
         }
 
         // Decimal or octal
-        while let Some(ch) = self.current_char {
-            if ch.is_ascii_digit() {
-                num_str.push(ch);
+        let start = self.position;
+        while let Some(b) = self.current() {
+            if b.is_ascii_digit() {
                 self.advance();
-            } else if ch == '.' && !is_float {
+            } else if b == b'.' && !is_float {
                 // Check it's not .. or method call
-                if let Some(next) = self.peek() {
-                    if next.is_ascii_digit() {
-                        is_float = true;
-                        num_str.push(ch);
-                        self.advance();
-                    } else {
-                        break;
-                    }
+                if matches!(self.peek(), Some(next) if next.is_ascii_digit()) {
+                    is_float = true;
+                    self.advance();
                 } else {
                     break;
                 }
-            } else if ch == 'e' || ch == 'E' {
+            } else if b == b'e' || b == b'E' {
                 is_float = true;
-                num_str.push(ch);
                 self.advance();
-                if self.current_char == Some('+') || self.current_char == Some('-') {
-                    num_str.push(self.current_char.unwrap());
+                if self.current() == Some(b'+') || self.current() == Some(b'-') {
                     self.advance();
                 }
             } else {
                 break;
             }
         }
+        let num_str = &self.src[start..self.position];
 
         if is_float {
             // Skip float suffix: f, F, l, L
-            if let Some(ch) = self.current_char {
-                if ch == 'f' || ch == 'F' || ch == 'l' || ch == 'L' {
-                    self.advance();
-                }
+            if matches!(self.current(), Some(b'f') | Some(b'F') | Some(b'l') | Some(b'L')) {
+                self.advance();
             }
             let val: f64 = num_str.parse().unwrap_or(0.0);
             CToken::FloatLiteral(val)
@@ -310,97 +363,63 @@ impl CLexer {
 
     fn skip_int_suffix(&mut self) {
         // Skip U, L, UL, LL, ULL suffixes
-        while let Some(ch) = self.current_char {
-            if ch == 'u' || ch == 'U' || ch == 'l' || ch == 'L' {
-                self.advance();
-            } else {
-                break;
-            }
+        while matches!(self.current(), Some(b'u') | Some(b'U') | Some(b'l') | Some(b'L')) {
+            self.advance();
         }
     }
 
     fn read_escape(&mut self) -> char {
         self.advance(); // skip backslash
-        match self.current_char {
-            Some('n') => {
-                self.advance();
-                '\n'
-            }
-            Some('t') => {
-                self.advance();
-                '\t'
-            }
-            Some('r') => {
-                self.advance();
-                '\r'
-            }
-            Some('0') => {
-                self.advance();
-                '\0'
-            }
-            Some('\\') => {
-                self.advance();
-                '\\'
-            }
-            Some('\'') => {
-                self.advance();
-                '\''
-            }
-            Some('"') => {
-                self.advance();
-                '"'
-            }
-            Some('a') => {
-                self.advance();
-                '\x07'
-            }
-            Some('b') => {
-                self.advance();
-                '\x08'
-            }
-            Some('f') => {
-                self.advance();
-                '\x0C'
-            }
-            Some('x') => {
+        let escaped = match self.current() {
+            Some(b'n') => '\n',
+            Some(b't') => '\t',
+            Some(b'r') => '\r',
+            Some(b'0') => '\0',
+            Some(b'\\') => '\\',
+            Some(b'\'') => '\'',
+            Some(b'"') => '"',
+            Some(b'a') => '\x07',
+            Some(b'b') => '\x08',
+            Some(b'f') => '\x0C',
+            Some(b'x') => {
                 // Hex escape: \xFF
                 self.advance();
-                let mut hex = String::new();
+                let start = self.position;
                 for _ in 0..2 {
-                    if let Some(ch) = self.current_char {
-                        if ch.is_ascii_hexdigit() {
-                            hex.push(ch);
-                            self.advance();
-                        }
+                    if matches!(self.current(), Some(b) if b.is_ascii_hexdigit()) {
+                        self.advance();
                     }
                 }
-                let val = u8::from_str_radix(&hex, 16).unwrap_or(0);
-                val as char
-            }
-            Some(ch) => {
-                self.advance();
-                ch
+                let val = u8::from_str_radix(&self.src[start..self.position], 16).unwrap_or(0);
+                return val as char;
             }
-            None => '\0',
-        }
+            Some(_) => self.current_char().unwrap_or('\0'),
+            None => return '\0',
+        };
+        self.advance();
+        escaped
     }
 
     fn read_string(&mut self) -> String {
         self.advance(); // skip opening "
         let mut s = String::new();
         loop {
-            match self.current_char {
-                None | Some('"') => {
+            // Tramo sin escapes: copiar el slice entero
+            let start = self.position;
+            let run = self.bytes[start..]
+                .iter()
+                .position(|&b| b == b'"' || b == b'\\')
+                .unwrap_or(self.bytes.len() - start);
+            if run > 0 {
+                s.push_str(&self.src[start..start + run]);
+                self.advance_to(start + run);
+            }
+            match self.current() {
+                None | Some(b'"') => {
                     self.advance(); // skip closing "
                     break;
                 }
-                Some('\\') => {
-                    s.push(self.read_escape());
-                }
-                Some(ch) => {
-                    s.push(ch);
-                    self.advance();
-                }
+                _ => s.push(self.read_escape()),
             }
         }
         s
@@ -408,14 +427,14 @@ impl CLexer {
 
     fn read_char_literal(&mut self) -> char {
         self.advance(); // skip opening '
-        let ch = if self.current_char == Some('\\') {
+        let ch = if self.current() == Some(b'\\') {
             self.read_escape()
         } else {
-            let c = self.current_char.unwrap_or('\0');
+            let c = self.current_char().unwrap_or('\0');
             self.advance();
             c
         };
-        if self.current_char == Some('\'') {
+        if self.current() == Some(b'\'') {
             self.advance(); // skip closing '
         }
         ch
@@ -425,48 +444,48 @@ impl CLexer {
         self.skip_whitespace();
         self.token_start_line = self.line;
 
-        match self.current_char {
+        match self.current() {
             None => CToken::Eof,
 
             // Preprocessor directives — skip line
-            Some('#') => {
+            Some(b'#') => {
                 self.skip_preprocessor_line();
                 self.next_token()
             }
 
             // String literal
-            Some('"') => {
+            Some(b'"') => {
                 let s = self.read_string();
                 CToken::StringLiteral(s)
             }
 
             // Char literal
-            Some('\'') => {
+            Some(b'\'') => {
                 let ch = self.read_char_literal();
                 CToken::CharLiteral(ch)
             }
 
             // Numbers
-            Some(ch) if ch.is_ascii_digit() => self.read_number(),
+            Some(b) if b.is_ascii_digit() => self.read_number(),
 
             // Identifiers and keywords
-            Some(ch) if ch.is_alphabetic() || ch == '_' => {
+            Some(b) if self.is_ident_start(b) => {
                 let ident = self.read_identifier();
                 // Wide/Unicode string literal prefixes: L"", u"", U"", u8""
                 if (ident == "L" || ident == "u" || ident == "U" || ident == "u8")
-                    && self.current_char == Some('"')
+                    && self.current() == Some(b'"')
                 {
                     let s = self.read_string();
                     return CToken::StringLiteral(s);
                 }
                 // Wide/Unicode char literal prefixes: L'x', u'x', U'x'
                 if (ident == "L" || ident == "u" || ident == "U")
-                    && self.current_char == Some('\'')
+                    && self.current() == Some(b'\'')
                 {
                     let ch = self.read_char_literal();
                     return CToken::CharLiteral(ch);
                 }
-                match ident.as_str() {
+                match ident {
                     "auto" => CToken::Auto,
                     "break" => CToken::Break,
                     "case" => CToken::Case,
@@ -509,187 +528,187 @@ impl CLexer {
                     "_Generic" => CToken::Generic,
                     "_Noreturn" | "noreturn" => CToken::Noreturn,
                     "_Thread_local" | "thread_local" => CToken::ThreadLocal,
-                    "NULL" | "nullptr" => CToken::Identifier("NULL".to_string()),
-                    _ => CToken::Identifier(ident),
+                    "NULL" | "nullptr" => CToken::Identifier(self.idents.intern("NULL")),
+                    _ => CToken::Identifier(self.idents.intern(ident)),
                 }
             }
 
             // Operators and punctuation
-            Some('+') => {
+            Some(b'+') => {
                 self.advance();
-                match self.current_char {
-                    Some('+') => {
+                match self.current() {
+                    Some(b'+') => {
                         self.advance();
                         CToken::PlusPlus
                     }
-                    Some('=') => {
+                    Some(b'=') => {
                         self.advance();
                         CToken::PlusAssign
                     }
                     _ => CToken::Plus,
                 }
             }
-            Some('-') => {
+            Some(b'-') => {
                 self.advance();
-                match self.current_char {
-                    Some('-') => {
+                match self.current() {
+                    Some(b'-') => {
                         self.advance();
                         CToken::MinusMinus
                     }
-                    Some('=') => {
+                    Some(b'=') => {
                         self.advance();
                         CToken::MinusAssign
                     }
-                    Some('>') => {
+                    Some(b'>') => {
                         self.advance();
                         CToken::Arrow
                     }
                     _ => CToken::Minus,
                 }
             }
-            Some('*') => {
+            Some(b'*') => {
                 self.advance();
-                if self.current_char == Some('=') {
+                if self.current() == Some(b'=') {
                     self.advance();
                     CToken::StarAssign
                 } else {
                     CToken::Star
                 }
             }
-            Some('/') => {
+            Some(b'/') => {
                 self.advance();
-                match self.current_char {
-                    Some('/') => {
+                match self.current() {
+                    Some(b'/') => {
                         self.advance();
                         self.skip_line_comment();
                         self.next_token()
                     }
-                    Some('*') => {
+                    Some(b'*') => {
                         self.skip_block_comment();
                         self.next_token()
                     }
-                    Some('=') => {
+                    Some(b'=') => {
                         self.advance();
                         CToken::SlashAssign
                     }
                     _ => CToken::Slash,
                 }
             }
-            Some('%') => {
+            Some(b'%') => {
                 self.advance();
-                if self.current_char == Some('=') {
+                if self.current() == Some(b'=') {
                     self.advance();
                     CToken::PercentAssign
                 } else {
                     CToken::Percent
                 }
             }
-            Some('=') => {
+            Some(b'=') => {
                 self.advance();
-                if self.current_char == Some('=') {
+                if self.current() == Some(b'=') {
                     self.advance();
                     CToken::EqEq
                 } else {
                     CToken::Assign
                 }
             }
-            Some('!') => {
+            Some(b'!') => {
                 self.advance();
-                if self.current_char == Some('=') {
+                if self.current() == Some(b'=') {
                     self.advance();
                     CToken::NotEq
                 } else {
                     CToken::Bang
                 }
             }
-            Some('<') => {
+            Some(b'<') => {
                 self.advance();
-                match self.current_char {
-                    Some('<') => {
+                match self.current() {
+                    Some(b'<') => {
                         self.advance();
-                        if self.current_char == Some('=') {
+                        if self.current() == Some(b'=') {
                             self.advance();
                             CToken::LShiftAssign
                         } else {
                             CToken::LShift
                         }
                     }
-                    Some('=') => {
+                    Some(b'=') => {
                         self.advance();
                         CToken::LessEq
                     }
                     _ => CToken::Less,
                 }
             }
-            Some('>') => {
+            Some(b'>') => {
                 self.advance();
-                match self.current_char {
-                    Some('>') => {
+                match self.current() {
+                    Some(b'>') => {
                         self.advance();
-                        if self.current_char == Some('=') {
+                        if self.current() == Some(b'=') {
                             self.advance();
                             CToken::RShiftAssign
                         } else {
                             CToken::RShift
                         }
                     }
-                    Some('=') => {
+                    Some(b'=') => {
                         self.advance();
                         CToken::GreaterEq
                     }
                     _ => CToken::Greater,
                 }
             }
-            Some('&') => {
+            Some(b'&') => {
                 self.advance();
-                match self.current_char {
-                    Some('&') => {
+                match self.current() {
+                    Some(b'&') => {
                         self.advance();
                         CToken::AndAnd
                     }
-                    Some('=') => {
+                    Some(b'=') => {
                         self.advance();
                         CToken::AmpAssign
                     }
                     _ => CToken::Ampersand,
                 }
             }
-            Some('|') => {
+            Some(b'|') => {
                 self.advance();
-                match self.current_char {
-                    Some('|') => {
+                match self.current() {
+                    Some(b'|') => {
                         self.advance();
                         CToken::OrOr
                     }
-                    Some('=') => {
+                    Some(b'=') => {
                         self.advance();
                         CToken::PipeAssign
                     }
                     _ => CToken::Pipe,
                 }
             }
-            Some('^') => {
+            Some(b'^') => {
                 self.advance();
-                if self.current_char == Some('=') {
+                if self.current() == Some(b'=') {
                     self.advance();
                     CToken::CaretAssign
                 } else {
                     CToken::Caret
                 }
             }
-            Some('~') => {
+            Some(b'~') => {
                 self.advance();
                 CToken::Tilde
             }
-            Some('?') => {
+            Some(b'?') => {
                 self.advance();
                 CToken::Question
             }
-            Some('.') => {
+            Some(b'.') => {
                 self.advance();
-                if self.current_char == Some('.') {
+                if self.current() == Some(b'.') {
                     self.advance();
-                    if self.current_char == Some('.') {
+                    if self.current() == Some(b'.') {
                         self.advance();
                         CToken::Ellipsis
                     } else {
@@ -701,44 +720,45 @@ impl CLexer {
             }
 
             // Punctuation
-            Some('(') => {
+            Some(b'(') => {
                 self.advance();
                 CToken::LParen
             }
-            Some(')') => {
+            Some(b')') => {
                 self.advance();
                 CToken::RParen
             }
-            Some('{') => {
+            Some(b'{') => {
                 self.advance();
                 CToken::LBrace
             }
-            Some('}') => {
+            Some(b'}') => {
                 self.advance();
                 CToken::RBrace
             }
-            Some('[') => {
+            Some(b'[') => {
                 self.advance();
                 CToken::LBracket
             }
-            Some(']') => {
+            Some(b']') => {
                 self.advance();
                 CToken::RBracket
             }
-            Some(';') => {
+            Some(b';') => {
                 self.advance();
                 CToken::Semicolon
             }
-            Some(',') => {
+            Some(b',') => {
                 self.advance();
                 CToken::Comma
             }
-            Some(':') => {
+            Some(b':') => {
                 self.advance();
                 CToken::Colon
             }
 
-            Some(ch) => {
+            Some(_) => {
+                let ch = self.current_char().unwrap_or('\0');
                 eprintln!(
                     "C Lexer: unexpected character '{}' at line {}:{}",
                     ch, self.line, self.column
@@ -774,7 +794,7 @@ mod tests {
     fn test_basic_c() {
         let mut lexer = CLexer::new("int main() { return 0; }");
         assert_eq!(lexer.next_token(), CToken::Int);
-        assert_eq!(lexer.next_token(), CToken::Identifier("main".to_string()));
+        assert_eq!(lexer.next_token(), CToken::Identifier(Ident::new("main")));
         assert_eq!(lexer.next_token(), CToken::LParen);
         assert_eq!(lexer.next_token(), CToken::RParen);
         assert_eq!(lexer.next_token(), CToken::LBrace);
@@ -828,7 +848,7 @@ mod tests {
     fn test_preprocessor_skip() {
         let mut lexer = CLexer::new("#include <stdio.h>\nint x;");
         assert_eq!(lexer.next_token(), CToken::Int);
-        assert_eq!(lexer.next_token(), CToken::Identifier("x".to_string()));
+        assert_eq!(lexer.next_token(), CToken::Identifier(Ident::new("x")));
         assert_eq!(lexer.next_token(), CToken::Semicolon);
     }
 }
@@ -8,6 +8,7 @@
 
 use crate::c_ast::*;
 use crate::c_lexer::CToken;
+use adeb_core::toolchain::{GccAttribute, MsvcDeclspec};
 
 pub struct CParser {
     tokens: Vec<CToken>,
@@ -16,6 +17,12 @@ pub struct CParser {
     /// Known typedef names so we can recognize them as type starters
     typedef_names: std::collections::HashSet<String>,
     anonymous_struct_fields: Vec<CStructField>,
+    /// Alignment requested by the specifiers of the declaration being parsed
+    pending_align: Option<usize>,
+    /// `static` seen in the specifiers of the declaration being parsed
+    pending_static: bool,
+    /// Top-level names declared `static` (internal linkage)
+    internal: std::collections::BTreeSet<String>,
 }
 
 impl CParser {
@@ -26,9 +33,23 @@ impl CParser {
             pos: 0,
             typedef_names: std::collections::HashSet::new(),
             anonymous_struct_fields: Vec::new(),
+            pending_align: None,
+            pending_static: false,
+            internal: std::collections::BTreeSet::new(),
         }
     }
 
+    /// Pre-register typedef names (e.g. from pre-parsed built-in headers)
+    /// so they are recognized as type starters in this token stream.
+    pub fn seed_typedef_names<I: IntoIterator<Item = String>>(&mut self, names: I) {
+        self.typedef_names.extend(names);
+    }
+
+    /// Typedef names known so far (after parsing: every typedef/struct/enum)
+    pub fn typedef_names(&self) -> &std::collections::HashSet<String> {
+        &self.typedef_names
+    }
+
     // ========== Token helpers ==========
 
     fn current_line(&self) -> usize {
@@ -81,7 +102,7 @@ impl CParser {
         match self.current().clone() {
             CToken::Identifier(name) => {
                 self.advance();
-                Ok(name)
+                Ok(name.to_string())
             }
             other => Err(format!("Expected identifier, got {:?}", other)),
         }
@@ -115,7 +136,7 @@ impl CParser {
             | CToken::Alignas
             | CToken::Noreturn
             | CToken::ThreadLocal => true,
-            CToken::Identifier(name) => self.typedef_names.contains(name),
+            CToken::Identifier(name) => self.typedef_names.contains(name.as_str()),
             _ => false,
         }
     }
@@ -143,8 +164,11 @@ impl CParser {
         // Skip storage class and qualifiers
         loop {
             match self.current() {
-                CToken::Static
-                | CToken::Extern
+                CToken::Static => {
+                    self.pending_static = true;
+                    self.advance();
+                }
+                CToken::Extern
                 | CToken::Register
                 | CToken::Inline
                 | CToken::Volatile => {
@@ -153,14 +177,18 @@ impl CParser {
                 CToken::Const => {
                     self.advance();
                 }
-                CToken::Noreturn | CToken::ThreadLocal | CToken::Alignas => {
+                CToken::Alignas => {
                     self.advance();
-                    // Skip _Alignas(expr) or _Alignas(type)
-                    if matches!(self.current(), CToken::LParen) {
-                        self.advance();
-                        self.skip_balanced_parens();
+                    if let Some(n) = self.parse_alignas() {
+                        self.request_align(n);
                     }
                 }
+                CToken::Noreturn | CToken::ThreadLocal => {
+                    self.advance();
+                }
+                CToken::Identifier(ref name) if Self::is_attribute_keyword(name.as_str()) => {
+                    self.parse_extended_attribute();
+                }
                 _ => break,
             }
         }
@@ -246,7 +274,7 @@ impl CParser {
             CToken::Identifier(ref name) => {
                 let name = name.clone();
                 self.advance();
-                CType::Typedef(name)
+                CType::Typedef(name.to_string())
             }
             other => return Err(format!("Expected type, got {:?}", other)),
         };
@@ -277,6 +305,91 @@ impl CParser {
         Ok(base)
     }
 
+    /// `_Alignas(N)` or `_Alignas(type)`, after the keyword. None if the
+    /// operand is not a literal or a scalar type (skipped).
+    fn parse_alignas(&mut self) -> Option<usize> {
+        if !self.eat(&CToken::LParen) {
+            return None;
+        }
+        let align = match self.current().clone() {
+            CToken::IntLiteral(n) if *self.peek() == CToken::RParen => {
+                self.advance();
+                Some(n as usize)
+            }
+            _ if self.is_type_start() => {
+                let saved = self.pending_align;
+                let align = self.parse_type().ok().and_then(|ty| Self::scalar_align(&ty));
+                self.pending_align = saved;
+                align
+            }
+            _ => None,
+        };
+        if !self.eat(&CToken::RParen) {
+            self.skip_balanced_parens();
+        }
+        align
+    }
+
+    /// Natural alignment of scalar types, for `_Alignas(type)`
+    fn scalar_align(ty: &CType) -> Option<usize> {
+        Some(match ty {
+            CType::Char | CType::Bool => 1,
+            CType::Short => 2,
+            CType::Int | CType::Long | CType::Float | CType::Enum(_) => 4,
+            CType::LongLong | CType::Double | CType::LongDouble | CType::Pointer(_) => 8,
+            CType::Signed(inner) | CType::Unsigned(inner) | CType::Const(inner) | CType::Volatile(inner) => {
+                return Self::scalar_align(inner)
+            }
+            _ => return None,
+        })
+    }
+
+    fn is_attribute_keyword(name: &str) -> bool {
+        matches!(name, "__declspec" | "__attribute__" | "__attribute")
+    }
+
+    /// `__declspec(...)` or `__attribute__((...))`. Only the alignment is
+    /// kept (`align(N)` / `aligned(N)`); every other specifier is skipped.
+    fn parse_extended_attribute(&mut self) {
+        let msvc = matches!(self.current(), CToken::Identifier(n) if n.as_str() == "__declspec");
+        self.advance();
+        if !self.eat(&CToken::LParen) {
+            return;
+        }
+        let start = self.pos;
+        self.skip_balanced_parens();
+        let end = self.pos.saturating_sub(1);
+
+        let mut i = start;
+        while i < end {
+            if let CToken::Identifier(name) = &self.tokens[i] {
+                let arg = match (self.tokens.get(i + 1), self.tokens.get(i + 2), self.tokens.get(i + 3)) {
+                    (Some(CToken::LParen), Some(CToken::IntLiteral(n)), Some(CToken::RParen)) => Some(n.to_string()),
+                    _ => None,
+                };
+                let align = if msvc {
+                    match MsvcDeclspec::parse(name.as_str(), arg.as_deref()) {
+                        MsvcDeclspec::Align(n) if arg.is_some() => Some(n),
+                        _ => None,
+                    }
+                } else {
+                    GccAttribute::parse(name.as_str().trim_matches('_'), arg.as_deref()).alignment()
+                };
+                if let Some(n) = align {
+                    self.request_align(n as usize);
+                }
+            }
+            i += 1;
+        }
+    }
+
+    /// Several specifiers may ask for alignment: the strictest wins
+    fn request_align(&mut self, n: usize) {
+        if n.is_power_of_two() {
+            self.pending_align = Some(self.pending_align.map_or(n, |a| a.max(n)));
+        }
+    }
+
     // ========== Top-level parsing ==========
 
     pub fn parse_translation_unit(&mut self) -> Result<CTranslationUnit, String> {
@@ -313,6 +426,7 @@ impl CParser {
                 }
             }
         }
+        unit.internal = std::mem::take(&mut self.internal);
         Ok(unit)
     }
 
@@ -372,7 +486,7 @@ impl CParser {
                 // The name is the identifier just before the semicolon
                 if j > 0 && j < self.tokens.len() {
                     if let CToken::Identifier(name) = &self.tokens[j - 1] {
-                        self.typedef_names.insert(name.clone());
+                        self.typedef_names.insert(name.to_string());
                     }
                 }
                 i = j + 1;
@@ -429,8 +543,15 @@ impl CParser {
         }
 
         // Function or global variable: type name ...
+        self.pending_align = None;
+        self.pending_static = false;
         let ret_type = self.parse_type()?;
+        let spec_align = self.pending_align.take();
+        let is_static = std::mem::take(&mut self.pending_static);
         let name = self.expect_identifier()?;
+        if is_static {
+            self.internal.insert(name.clone());
+        }
 
         if *self.current() == CToken::LParen {
             // Function definition or declaration
@@ -459,7 +580,7 @@ impl CParser {
         } else {
             // Global variable declaration
             let mut declarators = Vec::new();
-            let first = self.parse_declarator_rest(name)?;
+            let first = self.parse_declarator_rest(name, spec_align)?;
             declarators.push(first);
 
             while self.eat(&CToken::Comma) {
@@ -470,7 +591,10 @@ impl CParser {
                     var_type = CType::Pointer(Box::new(var_type));
                 }
                 let n = self.expect_identifier()?;
-                let d = self.parse_declarator_rest(n)?;
+                if is_static {
+                    self.internal.insert(n.clone());
+                }
+                let d = self.parse_declarator_rest(n, spec_align)?;
                 declarators.push(d);
             }
             self.expect(&CToken::Semicolon)?;
@@ -482,7 +606,7 @@ impl CParser {
         }
     }
 
-    fn parse_declarator_rest(&mut self, name: String) -> Result<CDeclarator, String> {
+    fn parse_declarator_rest(&mut self, name: String, spec_align: Option<usize>) -> Result<CDeclarator, String> {
         // Check for array: name[N] or multi-dimensional name[N][M]...
         let derived = {
             let mut d: Option<CDerivedType> = None;
@@ -513,6 +637,13 @@ impl CParser {
             d
         };
 
+        // Trailing `__attribute__((aligned(N)))` applies to this declarator only
+        self.pending_align = spec_align;
+        while matches!(self.current(), CToken::Identifier(n) if Self::is_attribute_keyword(n.as_str())) {
+            self.parse_extended_attribute();
+        }
+        let align = self.pending_align.take();
+
         let init = if self.eat(&CToken::Assign) {
             if *self.current() == CToken::LBrace {
                 // Brace-enclosed initializer list: = { expr, expr, ... }
@@ -530,6 +661,7 @@ impl CParser {
             derived_type: derived,
             initializer: init,
             full_type: None,
+            align,
         })
     }
 
@@ -791,7 +923,7 @@ impl CParser {
                         CType::Array(Box::new(ft), size)
                     } else { ft };
                     self.expect(&CToken::Semicolon)?;
-                    return Ok(Some(CStructField { field_type: final_type, name: fname, bit_width: None }));
+                    return Ok(Some(CStructField { field_type: final_type, name: fname.to_string(), bit_width: None }));
                 }
             }
             self.pos = save;
@@ -1181,7 +1313,7 @@ impl CParser {
         match self.current().clone() {
             CToken::Identifier(name) => {
                 self.advance();
-                Ok(name)
+                Ok(name.to_string())
             }
             CToken::Bool => {
                 self.advance();
@@ -1297,7 +1429,7 @@ impl CParser {
                             self.advance(); // skip identifier
                             self.advance(); // skip :
                             let stmt = self.parse_statement()?;
-                            return Ok(CStmt::Label(label, Box::new(stmt)));
+                            return Ok(CStmt::Label(label.to_string(), Box::new(stmt)));
                         }
                     }
 
@@ -1319,11 +1451,13 @@ impl CParser {
         // Check for static keyword before the type
         let is_static = *self.current() == CToken::Static;
         // parse_type will skip the static token internally
+        self.pending_align = None;
         let type_spec = self.parse_type()?;
+        let spec_align = self.pending_align.take();
         let mut declarators = Vec::new();
 
         let name = self.expect_identifier()?;
-        let first = self.parse_declarator_rest(name)?;
+        let first = self.parse_declarator_rest(name, spec_align)?;
         declarators.push(first);
 
         while self.eat(&CToken::Comma) {
@@ -1333,7 +1467,7 @@ impl CParser {
                 _inner_type = CType::Pointer(Box::new(_inner_type));
             }
             let n = self.expect_identifier()?;
-            let d = self.parse_declarator_rest(n)?;
+            let d = self.parse_declarator_rest(n, spec_align)?;
             declarators.push(d);
         }
         self.expect(&CToken::Semicolon)?;
@@ -1817,7 +1951,7 @@ impl CParser {
             | CToken::Volatile
             | CToken::Bool
             | CToken::Complex => true,
-            CToken::Identifier(name) => self.typedef_names.contains(name),
+            CToken::Identifier(name) => self.typedef_names.contains(name.as_str()),
             _ => false,
         }
     }
@@ -1846,7 +1980,7 @@ impl CParser {
             CToken::Identifier(name) => {
                 // Only treat as cast if name is a known typedef AND
                 // the token after closing ) looks like a unary expr, not binary op
-                self.typedef_names.contains(name)
+                self.typedef_names.contains(name.as_str())
             }
             _ => false,
         }
@@ -1992,7 +2126,7 @@ impl CParser {
             }
             CToken::Identifier(name) => {
                 self.advance();
-                Ok(CExpr::Identifier(name))
+                Ok(CExpr::Identifier(name.to_string()))
             }
             CToken::LParen => {
                 // Check for compound literal: (Type){...}
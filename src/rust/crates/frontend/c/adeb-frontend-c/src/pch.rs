@@ -0,0 +1,195 @@
+// ============================================================
+// ADead-BIB C Precompiled Headers — fastos.bib for user headers
+// ============================================================
+// `adB cc --pch common.h` parsea un header del proyecto UNA vez y deja
+// su imagen al lado, common.h.bib (formato fastos.bib):
+//   ast_data     → declaraciones, typedefs y estado de includes (JSON)
+//   types        → typedef/struct names
+//   symbols      → prototipos, definiciones y macros (#define)
+//   ub_reports   → UB encontrado en las funciones del header
+//   dependencies → el header y todo header de usuario que pega
+// El hash cubre todas las dependencias: editar cualquiera invalida.
+//
+// Un TU que hace `#include "common.h"` antes de cualquier #define carga
+// la imagen en vez del texto: el preprocesador repone macros e include
+// guards, y el driver antepone las declaraciones como con los built-in.
+// ============================================================
+
+use crate::ast::CTopLevel;
+use crate::header_cache;
+use adeb_core::cache::{
+    build_id, deserializer, hasher, serializer, validator, ADeadCache, CachedSymbol,
+    CachedSymbolKind, CachedUBReport,
+};
+use serde::{Deserialize, Serialize};
+use std::collections::HashMap;
+use std::path::{Path, PathBuf};
+use std::sync::{Arc, Mutex, OnceLock};
+
+/// A user header as the preprocessor and parser left it
+#[derive(Debug, Clone)]
+pub struct PrecompiledHeader {
+    /// Its top-level declarations (built-in headers excluded)
+    pub declarations: Vec<CTopLevel>,
+    pub typedef_names: Vec<String>,
+    /// Macro table after the header, as `#define` bodies
+    pub macros: Vec<(String, String)>,
+    /// Built-in headers it includes, in order
+    pub builtin_headers: Vec<String>,
+    /// Every include name it saw (they become include guards of the TU)
+    pub included: Vec<String>,
+    /// Include closure: the header first, then the user headers it pastes
+    pub files: Vec<String>,
+    pub ub_reports: Vec<CachedUBReport>,
+}
+
+/// What only the loader reads back from `ast_data`
+#[derive(Serialize, Deserialize)]
+struct PchAst {
+    declarations: Vec<CTopLevel>,
+    typedef_names: Vec<String>,
+    builtin_headers: Vec<String>,
+    included: Vec<String>,
+}
+
+/// Image of `header`: `common.h` → `common.h.bib`
+pub fn image_path(header: &Path) -> PathBuf {
+    let mut name = header.as_os_str().to_owned();
+    name.push(".bib");
+    PathBuf::from(name)
+}
+
+fn salt() -> String {
+    format!("adB-pch-{}", build_id())
+}
+
+/// Build the fastos.bib image of a precompiled header
+pub fn to_cache(pch: &PrecompiledHeader) -> Result<ADeadCache, String> {
+    let files: Vec<&str> = pch.files.iter().map(String::as_str).collect();
+    let hash = hasher::hash_closure(&files, &salt()).map_err(|e| e.to_string())?;
+    let mut cache = ADeadCache::new(hash);
+    cache.dependencies = pch.files.clone();
+    cache.ast_data = serde_json::to_vec(&PchAst {
+        declarations: pch.declarations.clone(),
+        typedef_names: pch.typedef_names.clone(),
+        builtin_headers: pch.builtin_headers.clone(),
+        included: pch.included.clone(),
+    })
+    .map_err(|e| e.to_string())?;
+
+    let source = pch.files.first().map(String::as_str).unwrap_or_default();
+    header_cache::index_declarations(&mut cache, &pch.declarations, &pch.typedef_names, source);
+    // `#NAME`: a macro may share its name with a function
+    for (name, definition) in &pch.macros {
+        cache.symbols.insert(
+            format!("#{}", name),
+            CachedSymbol {
+                name: name.clone(),
+                kind: CachedSymbolKind::Macro { value: definition.clone() },
+                source_file: source.to_string(),
+            },
+        );
+    }
+    cache.ub_reports = pch.ub_reports.clone();
+    Ok(cache)
+}
+
+/// Restore a precompiled header from its fastos.bib image
+pub fn from_cache(cache: &ADeadCache) -> Result<PrecompiledHeader, String> {
+    let ast: PchAst = serde_json::from_slice(&cache.ast_data).map_err(|e| e.to_string())?;
+    let mut macros: Vec<(String, String)> = cache
+        .symbols
+        .entries
+        .values()
+        .filter_map(|sym| match &sym.kind {
+            CachedSymbolKind::Macro { value } => Some((sym.name.clone(), value.clone())),
+            _ => None,
+        })
+        .collect();
+    macros.sort();
+    Ok(PrecompiledHeader {
+        declarations: ast.declarations,
+        typedef_names: ast.typedef_names,
+        macros,
+        builtin_headers: ast.builtin_headers,
+        included: ast.included,
+        files: cache.dependencies.clone(),
+        ub_reports: cache.ub_reports.clone(),
+    })
+}
+
+/// Write the image (tmp + rename, as the other caches); returns its size
+pub fn write_image(pch: &PrecompiledHeader, path: &Path) -> Result<usize, String> {
+    let cache = to_cache(pch)?;
+    let tmp = path.with_extension(format!("bib.tmp{}", std::process::id()));
+    let size = serializer::write_to_file(&cache, &tmp.to_string_lossy())
+        .and_then(|size| std::fs::rename(&tmp, path).map(|_| size))
+        .map_err(|e| format!("Cannot write '{}': {}", path.display(), e))?;
+    Ok(size)
+}
+
+/// Images already decoded in this process, by content hash: every TU of
+/// a multi-file build includes the same header
+fn memo() -> &'static Mutex<HashMap<u64, Arc<PrecompiledHeader>>> {
+    static MEMO: OnceLock<Mutex<HashMap<u64, Arc<PrecompiledHeader>>>> = OnceLock::new();
+    MEMO.get_or_init(|| Mutex::new(HashMap::new()))
+}
+
+/// Precompiled `header`, if its image exists and no file of its include
+/// closure changed since it was built
+pub fn load(header: &Path) -> Option<Arc<PrecompiledHeader>> {
+    let cache = deserializer::read_from_file(&image_path(header).to_string_lossy()).ok()?;
+    if validator::validate_dependencies(&cache, &salt()) != validator::CacheStatus::Hit {
+        return None;
+    }
+    if let Some(hit) = memo().lock().unwrap().get(&cache.hash) {
+        return Some(hit.clone());
+    }
+    let pch = Arc::new(from_cache(&cache).ok()?);
+    memo().lock().unwrap().insert(cache.hash, pch.clone());
+    Some(pch)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::preprocessor::CPreprocessor;
+
+    #[test]
+    fn test_image_roundtrip_and_invalidation() {
+        let dir = std::env::temp_dir().join(format!("adeb_pch_{}", std::process::id()));
+        std::fs::create_dir_all(&dir).unwrap();
+        let header = dir.join("common.h");
+        std::fs::write(&header, "#define SCALE 3\nint scale(int x);\n").unwrap();
+        let file = header.to_string_lossy().into_owned();
+
+        let pch = PrecompiledHeader {
+            declarations: Vec::new(),
+            typedef_names: vec!["u32".to_string()],
+            macros: vec![("SCALE".to_string(), "SCALE 3".to_string())],
+            builtin_headers: vec!["stdio.h".to_string()],
+            included: vec!["stdio.h".to_string()],
+            files: vec![file.clone()],
+            ub_reports: Vec::new(),
+        };
+        write_image(&pch, &image_path(&header)).unwrap();
+        let loaded = load(&header).expect("fresh image loads");
+        assert_eq!(loaded.macros, pch.macros);
+        assert_eq!(loaded.typedef_names, pch.typedef_names);
+        assert_eq!(loaded.files, vec![file]);
+
+        // Driver mode: the TU gets the macros and built-in headers back
+        let mut pp = CPreprocessor::new();
+        pp.set_inject_headers(false);
+        pp.set_source_dir(&dir);
+        let out = pp.process("#include \"common.h\"\nint main() { return scale(SCALE); }\n");
+        assert!(out.contains("scale(3)"), "{}", out);
+        assert_eq!(pp.precompiled().len(), 1);
+        assert_eq!(pp.include_order(), ["stdio.h".to_string()]);
+        assert!(pp.user_headers().is_empty());
+
+        std::fs::write(&header, "#define SCALE 4\nint scale(int x);\n").unwrap();
+        assert!(load(&header).is_none(), "edited header must invalidate the image");
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
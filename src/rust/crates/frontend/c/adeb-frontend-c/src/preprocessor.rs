@@ -3,49 +3,105 @@
 // ============================================================
 // Resolves #include directives by injecting built-in headers
 // Handles: #include <header.h>, #include "header.h"
+// A quoted include of a file next to the TU pastes its text, or loads
+// its precompiled image (`<header>.bib`, see pch.rs) when one is valid.
 // Skips: #define, #ifdef, #ifndef, #endif, #else, #if, #pragma
 //
+// Macros: code lines are split into preprocessing tokens once and
+// expanded by a token expander (hashed macro table, hide sets for
+// recursion, rescanning) — no per-macro rewrite of the line.
+//
 // No GCC. No Clang. ADead-BIB owns the headers. 💀🦈
 // ============================================================
 
 use super::c_stdlib;
-use std::collections::{HashMap, HashSet};
+use crate::pch::{self, PrecompiledHeader};
+use std::borrow::Cow;
+use std::collections::{HashMap, HashSet, VecDeque};
+use std::path::{Path, PathBuf};
+use std::rc::Rc;
+use std::sync::Arc;
 
-/// A #define macro: either object-like or function-like
+/// A #define macro: either object-like or function-like.
+/// Bodies are stored pre-tokenized for the expander.
 #[derive(Debug, Clone)]
 enum Macro {
     /// #define NAME value
-    Object(String),
+    Object(Vec<BodyToken>),
     /// #define NAME(a,b) body
-    Function { params: Vec<String>, body: String, variadic: bool },
+    Function { params: Vec<String>, body: Vec<BodyToken>, variadic: bool },
 }
 
 pub struct CPreprocessor {
     /// Track included headers to prevent double inclusion
     included: HashSet<String>,
+    /// Known headers in first-inclusion order (key for the fastos.bib cache)
+    include_order: Vec<String>,
+    /// Paste header text into the output (false when the driver loads the
+    /// pre-parsed headers from fastos.bib instead)
+    inject_headers: bool,
     /// Whether the common prologue has been injected
     prologue_injected: bool,
     /// Defined macros
     macros: HashMap<String, Macro>,
+    /// Directory `#include "..."` resolves against (that of the file
+    /// being processed)
+    source_dir: PathBuf,
+    /// User headers pasted as text, in inclusion order
+    user_headers: Vec<String>,
+    /// User headers taken from their precompiled image instead
+    precompiled: Vec<Arc<PrecompiledHeader>>,
+    /// Load `<header>.bib` images (off while building one)
+    use_precompiled: bool,
+    /// A #define/#undef already ran: an image captured the macro table
+    /// of a fresh TU, so from here on headers are pasted
+    macros_touched: bool,
 }
 
 impl CPreprocessor {
     pub fn new() -> Self {
         let mut macros = HashMap::new();
         // Standard predefined macros
-        macros.insert("__STDC__".to_string(), Macro::Object("1".to_string()));
-        macros.insert("__STDC_VERSION__".to_string(), Macro::Object("201112L".to_string()));
-        macros.insert("__ADEAD_BIB__".to_string(), Macro::Object("1".to_string()));
-        macros.insert("__x86_64__".to_string(), Macro::Object("1".to_string()));
-        macros.insert("__LP64__".to_string(), Macro::Object("1".to_string()));
+        for (name, value) in [
+            ("__STDC__", "1"),
+            ("__STDC_VERSION__", "201112L"),
+            ("__ADEAD_BIB__", "1"),
+            ("__x86_64__", "1"),
+            ("__LP64__", "1"),
+        ] {
+            macros.insert(name.to_string(), Macro::Object(lex_macro_body(value)));
+        }
 
         Self {
             included: HashSet::new(),
+            include_order: Vec::new(),
+            inject_headers: true,
             prologue_injected: false,
             macros,
+            source_dir: PathBuf::from("."),
+            user_headers: Vec::new(),
+            precompiled: Vec::new(),
+            use_precompiled: true,
+            macros_touched: false,
         }
     }
 
+    /// Directory of the TU: quoted includes are looked up there
+    pub fn set_source_dir(&mut self, dir: impl Into<PathBuf>) {
+        self.source_dir = dir.into();
+    }
+
+    /// Paste user headers even when a precompiled image exists
+    pub fn set_use_precompiled(&mut self, enabled: bool) {
+        self.use_precompiled = enabled;
+    }
+
+    /// Skip pasting built-in header text; only record which headers were
+    /// included (see `include_order`). Line numbers stay those of the source.
+    pub fn set_inject_headers(&mut self, inject: bool) {
+        self.inject_headers = inject;
+    }
+
     /// Process C source code, resolving #include directives
     /// Returns preprocessed source with declarations injected
     pub fn process(&mut self, source: &str) -> String {
@@ -146,6 +202,23 @@ impl CPreprocessor {
                     }
                     self.included.insert(header_name.clone());
 
+                    if c_stdlib::get_header(&header_name).is_none() {
+                        if let Some(path) = self.resolve_user_header(trimmed, &header_name) {
+                            self.include_user_header(&header_name, &path, source_line, &mut output);
+                            continue;
+                        }
+                    }
+
+                    if !self.inject_headers {
+                        if c_stdlib::get_header(&header_name).is_some() {
+                            self.include_order.push(header_name);
+                        } else {
+                            eprintln!("ADead-BIB: unknown header <{}> — skipped", header_name);
+                        }
+                        output.push('\n');
+                        continue;
+                    }
+
                     // Wait, track if we injected lines
                     let mut lines_injected = false;
 
@@ -160,6 +233,7 @@ impl CPreprocessor {
 
                     // Look up header declarations
                     if let Some(declarations) = c_stdlib::get_header(&header_name) {
+                        self.include_order.push(header_name.clone());
                         output.push_str(&format!("# 1 \"{}\"\n", header_name));
                         output.push_str(declarations);
                         output.push('\n');
@@ -179,10 +253,12 @@ impl CPreprocessor {
                 }
             } else if trimmed.starts_with("#define ") || trimmed.starts_with("#define\t") {
                 self.parse_define(trimmed);
+                self.macros_touched = true;
                 output.push('\n');
             } else if trimmed.starts_with("#undef ") {
                 let name = trimmed[7..].trim().to_string();
                 self.macros.remove(&name);
+                self.macros_touched = true;
                 output.push('\n');
             } else if trimmed.starts_with("#ifdef ") {
                 let name = trimmed[7..].trim();
@@ -225,8 +301,7 @@ impl CPreprocessor {
                 output.push('\n');
             } else {
                 // Expand macros in regular code lines
-                let expanded = self.expand_macros_preserving_literals(line, &mut in_block_comment);
-                output.push_str(&expanded);
+                self.expand_line_into(line, &mut in_block_comment, &mut output);
                 output.push('\n');
             }
         }
@@ -253,6 +328,59 @@ impl CPreprocessor {
         }
     }
 
+    /// `#include "name"` of an existing file relative to the current one
+    fn resolve_user_header(&self, line: &str, name: &str) -> Option<PathBuf> {
+        let quoted = line["#include".len()..].trim_start().starts_with('"');
+        let path = self.source_dir.join(name);
+        (quoted && path.is_file()).then_some(path)
+    }
+
+    /// Paste a user header, or in driver mode (headers not injected) take
+    /// it from its precompiled image while that still matches the sources
+    fn include_user_header(&mut self, name: &str, path: &Path, source_line: usize, output: &mut String) {
+        if !self.inject_headers && self.use_precompiled && !self.macros_touched {
+            if let Some(image) = pch::load(path) {
+                self.apply_precompiled(image);
+                output.push('\n');
+                return;
+            }
+        }
+        let text = match std::fs::read_to_string(path) {
+            Ok(text) => text,
+            Err(e) => {
+                eprintln!("ADead-BIB: cannot read header \"{}\": {} — skipped", name, e);
+                output.push('\n');
+                return;
+            }
+        };
+        self.user_headers.push(path.to_string_lossy().into_owned());
+        let dir = path.parent().map(Path::to_path_buf).unwrap_or_default();
+        let outer = std::mem::replace(&mut self.source_dir, dir);
+        let body = self.process(&text);
+        self.source_dir = outer;
+        output.push_str(&format!("# 1 \"{}\"\n", name));
+        output.push_str(&body);
+        output.push_str(&format!("# {} \"main\"\n", source_line + 1));
+    }
+
+    /// State after a precompiled header: its macro table (which started
+    /// from the predefined one, like this TU), its include guards and the
+    /// built-in headers it pulls in
+    fn apply_precompiled(&mut self, image: Arc<PrecompiledHeader>) {
+        self.macros.clear();
+        for (_, definition) in &image.macros {
+            self.parse_define(&format!("#define {}", definition));
+        }
+        self.included.extend(image.included.iter().cloned());
+        for name in &image.builtin_headers {
+            if !self.include_order.contains(name) {
+                self.include_order.push(name.clone());
+            }
+        }
+        self.macros_touched = true;
+        self.precompiled.push(image);
+    }
+
     /// Parse a #define directive and store the macro
     fn parse_define(&mut self, line: &str) {
         let rest = line.strip_prefix("#define").unwrap().trim();
@@ -277,7 +405,7 @@ impl CPreprocessor {
                     if variadic {
                         params.pop();
                     }
-                    let body = after_name[close + 1..].trim().to_string();
+                    let body = lex_macro_body(&after_name[close + 1..]);
                     self.macros
                         .insert(name.to_string(), Macro::Function { params, body, variadic });
                     return;
@@ -299,265 +427,597 @@ impl CPreprocessor {
             value
         };
         self.macros
-            .insert(name.to_string(), Macro::Object(value.to_string()));
+            .insert(name.to_string(), Macro::Object(lex_macro_body(value)));
     }
 
-    /// Expand macros in a line of code
-    fn expand_macros(&self, line: &str) -> String {
-        if self.macros.is_empty() {
-            return line.to_string();
+    /// Expand macros in one source line and append it to `out`.
+    /// String/char literals and comments are copied verbatim; the code in
+    /// between goes through the token expander.
+    fn expand_line_into(&self, line: &str, in_block_comment: &mut bool, out: &mut String) {
+        let tokens = lex_pp_line(line, in_block_comment);
+        let needs_expansion = tokens
+            .iter()
+            .any(|t| t.kind == PpKind::Ident && self.macros.contains_key(&*t.text));
+        if !needs_expansion {
+            out.push_str(line);
+            return;
         }
-
-        let mut result = line.to_string();
-        // Multiple passes to handle nested macros (limit to prevent infinite loops)
-        for _ in 0..8 {
-            let prev = result.clone();
-            for (name, mac) in &self.macros {
-                match mac {
-                    Macro::Object(value) => {
-                        // Replace whole-word occurrences only
-                        result = self.replace_whole_word(&result, name, value);
-                    }
-                    Macro::Function { params, body, variadic } => {
-                        result = self.expand_function_macro(&result, name, params, body, *variadic);
-                    }
-                }
-            }
-            if result == prev {
-                break;
-            }
+        for tok in self.expand_tokens(tokens) {
+            out.push_str(&tok.text);
         }
-        result
     }
 
-    fn expand_macros_preserving_literals(
-        &self,
-        line: &str,
-        in_block_comment: &mut bool,
-    ) -> String {
-        if self.macros.is_empty() {
-            return line.to_string();
-        }
-
-        let chars: Vec<char> = line.chars().collect();
-        let mut result = String::with_capacity(line.len());
-        let mut code_chunk = String::new();
-        let mut i = 0;
+    /// Fully macro-expand a token list. Replacements are pushed back onto
+    /// the input and rescanned; each token's hide set stops a macro from
+    /// expanding inside its own replacement (C99 §6.10.3.4).
+    fn expand_tokens<'a>(&'a self, tokens: Vec<PpToken<'a>>) -> Vec<PpToken<'a>> {
+        let mut input: VecDeque<PpToken<'a>> = tokens.into();
+        let mut out = Vec::with_capacity(input.len());
 
-        while i < chars.len() {
-            if *in_block_comment {
-                if chars[i] == '*' && i + 1 < chars.len() && chars[i + 1] == '/' {
-                    result.push(chars[i]);
-                    result.push(chars[i + 1]);
-                    *in_block_comment = false;
-                    i += 2;
-                } else {
-                    result.push(chars[i]);
-                    i += 1;
+        while let Some(tok) = input.pop_front() {
+            if tok.kind != PpKind::Ident {
+                out.push(tok);
+                continue;
+            }
+            let (name, mac) = match self.macros.get_key_value(&*tok.text) {
+                Some(entry) => entry,
+                None => {
+                    out.push(tok);
+                    continue;
                 }
+            };
+            if hide_contains(&tok.hide, name) {
+                out.push(tok);
                 continue;
             }
 
-            if chars[i] == '/' && i + 1 < chars.len() && chars[i + 1] == '/' {
-                if !code_chunk.is_empty() {
-                    result.push_str(&self.expand_macros(&code_chunk));
-                    code_chunk.clear();
+            let replacement = match mac {
+                Macro::Object(body) => {
+                    let hide = hide_with(&tok.hide, name);
+                    self.substitute(body, &[], None, false, &hide)
+                }
+                Macro::Function { params, body, variadic } => {
+                    let (args, rparen_hide) = match collect_macro_args(&mut input) {
+                        Some(found) => found,
+                        None => {
+                            // NAME not followed by (...) on this line: plain identifier
+                            out.push(tok);
+                            continue;
+                        }
+                    };
+                    let hide = hide_with(&hide_intersect(&tok.hide, &rparen_hide), name);
+                    let substituted = self.substitute(body, params, Some(&args), *variadic, &hide);
+                    if is_statement_body(body) {
+                        substituted
+                    } else {
+                        // Wrap expression bodies in parentheses for safety
+                        let mut expanded = Vec::with_capacity(substituted.len() + 2);
+                        expanded.push(PpToken::punct("(", hide.clone()));
+                        expanded.extend(substituted);
+                        expanded.push(PpToken::punct(")", hide.clone()));
+                        expanded
+                    }
                 }
-                result.extend(chars[i..].iter());
-                break;
+            };
+
+            for t in replacement.into_iter().rev() {
+                input.push_front(t);
             }
+        }
+        out
+    }
 
-            if chars[i] == '/' && i + 1 < chars.len() && chars[i + 1] == '*' {
-                if !code_chunk.is_empty() {
-                    result.push_str(&self.expand_macros(&code_chunk));
-                    code_chunk.clear();
+    /// Build a macro's replacement list: parameters get their (expanded)
+    /// arguments, `#param` is stringified and `##` pastes its neighbours.
+    /// Every resulting token inherits `hide`.
+    fn substitute<'a>(
+        &'a self,
+        body: &'a [BodyToken],
+        params: &[String],
+        args: Option<&[Vec<PpToken<'a>>]>,
+        variadic: bool,
+        hide: &HideSet<'a>,
+    ) -> Vec<PpToken<'a>> {
+        let param_index = |text: &str| -> Option<usize> {
+            args?;
+            if variadic && text == "__VA_ARGS__" {
+                return Some(params.len());
+            }
+            params.iter().position(|p| p == text)
+        };
+        let arg_tokens = |index: usize| -> Option<Vec<PpToken<'a>>> {
+            let args = args?;
+            if index < params.len() {
+                return args.get(index).cloned();
+            }
+            // __VA_ARGS__: every argument after the named ones, joined by ", "
+            let mut va = Vec::new();
+            for (i, arg) in args.iter().enumerate().skip(params.len()) {
+                if i > params.len() {
+                    va.push(PpToken::punct(",", None));
+                    va.push(PpToken::space(" "));
                 }
-                result.push(chars[i]);
-                result.push(chars[i + 1]);
-                *in_block_comment = true;
-                i += 2;
-                continue;
+                va.extend(arg.iter().cloned());
             }
+            Some(va)
+        };
+        let next_solid = |from: usize| (from..body.len()).find(|&j| !body[j].kind.is_blank());
+        let prev_solid = |before: usize| (0..before).rev().find(|&j| !body[j].kind.is_blank());
 
-            if chars[i] == '"' || chars[i] == '\'' {
-                if !code_chunk.is_empty() {
-                    result.push_str(&self.expand_macros(&code_chunk));
-                    code_chunk.clear();
+        let mut result: Vec<PpToken<'a>> = Vec::with_capacity(body.len());
+        let mut i = 0;
+        while i < body.len() {
+            let bt = &body[i];
+
+            // #param → "arg"
+            if bt.kind == PpKind::Punct && bt.text == "#" && args.is_some() {
+                if let Some(j) = next_solid(i + 1) {
+                    if let Some(p) = param_index(&body[j].text).filter(|_| body[j].kind == PpKind::Ident) {
+                        let spelled = arg_tokens(p).map(|t| stringify(&t)).unwrap_or_default();
+                        result.push(PpToken {
+                            kind: PpKind::Literal,
+                            text: Cow::Owned(spelled),
+                            hide: None,
+                        });
+                        i = j + 1;
+                        continue;
+                    }
                 }
+            }
 
-                let quote = chars[i];
-                result.push(quote);
-                i += 1;
-                while i < chars.len() {
-                    let ch = chars[i];
-                    result.push(ch);
-                    i += 1;
-                    if ch == '\\' && i < chars.len() {
-                        result.push(chars[i]);
+            if bt.kind == PpKind::Ident {
+                if let Some(p) = param_index(&bt.text) {
+                    if let Some(arg) = arg_tokens(p) {
+                        let pastes_before = prev_solid(i).map_or(false, |j| body[j].kind == PpKind::Paste);
+                        let pastes_after = next_solid(i + 1).map_or(false, |j| body[j].kind == PpKind::Paste);
+                        if p == params.len() && pastes_before && is_comma_paste(&result) {
+                            // GNU `, ## __VA_ARGS__`: no paste; drops the comma if empty
+                            drop_paste(&mut result);
+                            if arg.is_empty() {
+                                result.pop();
+                            } else {
+                                result.push(PpToken::space(" "));
+                                result.extend(arg);
+                            }
+                        } else if pastes_before || pastes_after {
+                            result.extend(arg);
+                        } else {
+                            result.extend(self.expand_tokens(arg));
+                        }
                         i += 1;
                         continue;
                     }
-                    if ch == quote {
-                        break;
-                    }
                 }
-                continue;
             }
 
-            code_chunk.push(chars[i]);
+            result.push(PpToken {
+                kind: bt.kind,
+                text: Cow::Borrowed(bt.text.as_str()),
+                hide: None,
+            });
             i += 1;
         }
 
-        if !code_chunk.is_empty() {
-            result.push_str(&self.expand_macros(&code_chunk));
+        let mut result = paste_tokens(result);
+        for tok in &mut result {
+            tok.hide = hide_union(&tok.hide, hide);
         }
-
         result
     }
 
-    /// Replace whole-word occurrences of `name` with `value`
-    fn replace_whole_word(&self, text: &str, name: &str, value: &str) -> String {
-        let mut result = String::with_capacity(text.len());
-        let chars: Vec<char> = text.chars().collect();
-        let name_chars: Vec<char> = name.chars().collect();
-        let mut i = 0;
-        while i < chars.len() {
-            if i + name_chars.len() <= chars.len()
-                && &chars[i..i + name_chars.len()] == name_chars.as_slice()
-            {
-                // Check word boundary before
-                let before_ok = i == 0 || !chars[i - 1].is_alphanumeric() && chars[i - 1] != '_';
-                // Check word boundary after
-                let after_idx = i + name_chars.len();
-                let after_ok = after_idx >= chars.len()
-                    || !chars[after_idx].is_alphanumeric() && chars[after_idx] != '_';
-                if before_ok && after_ok {
-                    result.push_str(value);
-                    i += name_chars.len();
-                    continue;
+    /// Get list of all included headers (for debugging/analysis)
+    pub fn included_headers(&self) -> &HashSet<String> {
+        &self.included
+    }
+
+    /// Known built-in headers in the order they were first included
+    pub fn include_order(&self) -> &[String] {
+        &self.include_order
+    }
+
+    /// User headers pasted as text (paths as resolved, inclusion order)
+    pub fn user_headers(&self) -> &[String] {
+        &self.user_headers
+    }
+
+    /// Precompiled headers loaded in place of their text
+    pub fn precompiled(&self) -> &[Arc<PrecompiledHeader>] {
+        &self.precompiled
+    }
+
+    /// Macro table as `#define` bodies (`N value`, `F(a, b) body`), by name
+    pub fn macro_definitions(&self) -> Vec<(String, String)> {
+        let mut defs: Vec<(String, String)> = self
+            .macros
+            .iter()
+            .map(|(name, m)| (name.clone(), m.definition(name)))
+            .collect();
+        defs.sort();
+        defs
+    }
+}
+
+impl Macro {
+    /// Text after `#define` that parses back to this macro
+    fn definition(&self, name: &str) -> String {
+        let text = |body: &[BodyToken]| body.iter().map(|t| t.text.as_str()).collect::<String>();
+        match self {
+            Macro::Object(body) if body.is_empty() => name.to_string(),
+            Macro::Object(body) => format!("{} {}", name, text(body)),
+            Macro::Function { params, body, variadic } => {
+                let mut params = params.clone();
+                if *variadic {
+                    params.push("...".to_string());
                 }
+                format!("{}({}) {}", name, params.join(", "), text(body))
             }
-            result.push(chars[i]);
-            i += 1;
         }
-        result
     }
+}
 
-    /// Expand function-like macro invocations: NAME(arg1, arg2)
-    fn expand_function_macro(
-        &self,
-        text: &str,
-        name: &str,
-        params: &[String],
-        body: &str,
-        variadic: bool,
-    ) -> String {
-        let mut result = String::new();
-        let chars: Vec<char> = text.chars().collect();
-        let name_chars: Vec<char> = name.chars().collect();
-        let mut i = 0;
+// ── Preprocessing tokens ──
 
-        while i < chars.len() {
-            // Look for macro name followed by '('
-            if i + name_chars.len() < chars.len()
-                && &chars[i..i + name_chars.len()] == name_chars.as_slice()
-            {
-                let before_ok = i == 0 || !chars[i - 1].is_alphanumeric() && chars[i - 1] != '_';
-                let mut after_idx = i + name_chars.len();
-                while after_idx < chars.len() && chars[after_idx].is_ascii_whitespace() {
-                    after_idx += 1;
-                }
-                if before_ok && after_idx < chars.len() && chars[after_idx] == '(' {
-                    // Extract arguments
-                    if let Some((args, end_pos)) = self.extract_macro_args(&chars, after_idx) {
-                        // Substitute parameters in body
-                        let mut expanded = body.to_string();
-
-                        // Handle # stringification: #param → "arg"
-                        for (pi, param) in params.iter().enumerate() {
-                            if pi < args.len() {
-                                let pattern = format!("#{}", param);
-                                let replacement = format!("\"{}\"", args[pi].replace('\\', "\\\\").replace('"', "\\\""));
-                                expanded = expanded.replace(&pattern, &replacement);
-                            }
-                        }
+/// Kind of preprocessing token (only what macro expansion needs)
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum PpKind {
+    Ident,
+    Number,
+    /// String or char literal, prefix included
+    Literal,
+    Punct,
+    /// `##` inside a macro body
+    Paste,
+    Space,
+    Comment,
+}
 
-                        for (pi, param) in params.iter().enumerate() {
-                            if pi < args.len() {
-                                expanded = self.replace_whole_word(&expanded, param, &args[pi]);
-                            }
-                        }
+impl PpKind {
+    fn is_blank(self) -> bool {
+        matches!(self, PpKind::Space | PpKind::Comment)
+    }
+}
 
-                        // Handle __VA_ARGS__ for variadic macros
-                        if variadic {
-                            let va_args = if args.len() > params.len() {
-                                args[params.len()..].join(", ")
-                            } else {
-                                String::new()
-                            };
-                            expanded = expanded.replace("__VA_ARGS__", &va_args);
-                        }
+/// Names of the macros a token must not be expanded by (hide set)
+type HideSet<'a> = Option<Rc<Vec<&'a str>>>;
 
-                        // Handle ## token pasting
-                        expanded = expanded.replace(" ## ", "");
-                        expanded = expanded.replace("## ", "");
-                        expanded = expanded.replace(" ##", "");
+#[derive(Debug, Clone)]
+struct PpToken<'a> {
+    kind: PpKind,
+    text: Cow<'a, str>,
+    hide: HideSet<'a>,
+}
 
-                        // Wrap in parentheses for safety
-                        result.push('(');
-                        result.push_str(&expanded);
-                        result.push(')');
-                        i = end_pos;
-                        continue;
-                    }
+impl<'a> PpToken<'a> {
+    fn punct(text: &'static str, hide: HideSet<'a>) -> Self {
+        PpToken { kind: PpKind::Punct, text: Cow::Borrowed(text), hide }
+    }
+
+    fn space(text: &'static str) -> Self {
+        PpToken { kind: PpKind::Space, text: Cow::Borrowed(text), hide: None }
+    }
+}
+
+/// Token of a stored macro body (owned by the macro table)
+#[derive(Debug, Clone)]
+struct BodyToken {
+    kind: PpKind,
+    text: String,
+}
+
+/// Tokenize a macro body: comments become a single space, `##` is a paste
+/// operator, leading/trailing whitespace is dropped.
+fn lex_macro_body(body: &str) -> Vec<BodyToken> {
+    let mut in_comment = false;
+    let mut tokens: Vec<BodyToken> = lex_pp_line(body, &mut in_comment)
+        .into_iter()
+        .map(|t| match t.kind {
+            PpKind::Comment => BodyToken { kind: PpKind::Space, text: " ".to_string() },
+            PpKind::Punct if t.text == "##" => BodyToken { kind: PpKind::Paste, text: "##".to_string() },
+            kind => BodyToken { kind, text: t.text.into_owned() },
+        })
+        .collect();
+    while tokens.last().map_or(false, |t| t.kind.is_blank()) {
+        tokens.pop();
+    }
+    let lead = tokens.iter().take_while(|t| t.kind.is_blank()).count();
+    tokens.drain(..lead);
+    tokens
+}
+
+/// Statement-like bodies (`do { ... } while (0)`, `{ ... }`, anything with
+/// a `;`) must not be wrapped in parentheses
+fn is_statement_body(body: &[BodyToken]) -> bool {
+    let starts_statement = body.first().map_or(true, |t| {
+        t.text == "{"
+            || (t.kind == PpKind::Ident
+                && matches!(
+                    t.text.as_str(),
+                    "do" | "if" | "for" | "while" | "switch" | "return" | "break" | "continue" | "goto"
+                ))
+    });
+    starts_statement || body.iter().any(|t| t.kind == PpKind::Punct && t.text == ";")
+}
+
+fn is_ident_char(ch: char) -> bool {
+    ch.is_alphanumeric() || ch == '_'
+}
+
+/// Split one line into preprocessing tokens. `in_block_comment` carries an
+/// open `/* ... */` across lines. Concatenating the token texts gives back
+/// the line unchanged.
+fn lex_pp_line<'a>(line: &'a str, in_block_comment: &mut bool) -> Vec<PpToken<'a>> {
+    let bytes = line.as_bytes();
+    let mut tokens = Vec::new();
+    let mut i = 0;
+    let push = |kind: PpKind, start: usize, end: usize, tokens: &mut Vec<PpToken<'a>>| {
+        tokens.push(PpToken { kind, text: Cow::Borrowed(&line[start..end]), hide: None });
+    };
+
+    while i < bytes.len() {
+        let start = i;
+        if *in_block_comment {
+            i = match line[i..].find("*/") {
+                Some(off) => {
+                    *in_block_comment = false;
+                    i + off + 2
                 }
+                None => bytes.len(),
+            };
+            push(PpKind::Comment, start, i, &mut tokens);
+            continue;
+        }
+
+        let b = bytes[i];
+        let next = bytes.get(i + 1).copied().unwrap_or(0);
+        if b.is_ascii_whitespace() {
+            while i < bytes.len() && bytes[i].is_ascii_whitespace() {
+                i += 1;
             }
-            result.push(chars[i]);
+            push(PpKind::Space, start, i, &mut tokens);
+        } else if b == b'/' && next == b'/' {
+            push(PpKind::Comment, start, bytes.len(), &mut tokens);
+            break;
+        } else if b == b'/' && next == b'*' {
+            *in_block_comment = true;
+            i += 2;
+            push(PpKind::Comment, start, i, &mut tokens);
+        } else if b == b'"' || b == b'\'' {
+            i = skip_literal(bytes, i);
+            push(PpKind::Literal, start, i, &mut tokens);
+        } else if b.is_ascii_digit() || (b == b'.' && next.is_ascii_digit()) {
+            // pp-number: digits, letters, '.', and signs after e/E/p/P
             i += 1;
+            while i < bytes.len() {
+                let c = bytes[i];
+                if c.is_ascii_alphanumeric() || c == b'_' || c == b'.' {
+                    i += 1;
+                } else if (c == b'+' || c == b'-') && matches!(bytes[i - 1], b'e' | b'E' | b'p' | b'P') {
+                    i += 1;
+                } else {
+                    break;
+                }
+            }
+            push(PpKind::Number, start, i, &mut tokens);
+        } else if line[i..].chars().next().map_or(false, |c| c.is_alphabetic() || c == '_') {
+            for ch in line[i..].chars() {
+                if !is_ident_char(ch) {
+                    break;
+                }
+                i += ch.len_utf8();
+            }
+            // L"..." / u8'x' and friends are one literal
+            let word = &line[start..i];
+            if matches!(word, "L" | "u" | "U" | "u8") && matches!(bytes.get(i), Some(b'"') | Some(b'\'')) {
+                i = skip_literal(bytes, i);
+                push(PpKind::Literal, start, i, &mut tokens);
+            } else {
+                push(PpKind::Ident, start, i, &mut tokens);
+            }
+        } else if b == b'#' && next == b'#' {
+            i += 2;
+            push(PpKind::Punct, start, i, &mut tokens);
+        } else {
+            i += line[i..].chars().next().map_or(1, |c| c.len_utf8());
+            push(PpKind::Punct, start, i, &mut tokens);
         }
-        result
     }
+    tokens
+}
 
-    /// Extract comma-separated arguments from a function-like macro call
-    /// Returns (args, position after closing paren)
-    fn extract_macro_args(
-        &self,
-        chars: &[char],
-        open_paren: usize,
-    ) -> Option<(Vec<String>, usize)> {
-        let mut depth = 0;
-        let mut args = Vec::new();
-        let mut current = String::new();
-        let mut i = open_paren;
-
-        while i < chars.len() {
-            let c = chars[i];
-            if c == '(' {
-                depth += 1;
-                if depth > 1 {
-                    current.push(c);
-                }
-            } else if c == ')' {
+/// End of the string/char literal opening at `start` (or end of line)
+fn skip_literal(bytes: &[u8], start: usize) -> usize {
+    let quote = bytes[start];
+    let mut i = start + 1;
+    while i < bytes.len() {
+        if bytes[i] == b'\\' {
+            i += 2;
+            continue;
+        }
+        i += 1;
+        if bytes[i - 1] == quote {
+            break;
+        }
+    }
+    i.min(bytes.len())
+}
+
+/// Take `( arg, arg, ... )` off the front of `input` if the next solid
+/// token is `(`. Arguments come back trimmed, plus the hide set of `)`.
+fn collect_macro_args<'a>(
+    input: &mut VecDeque<PpToken<'a>>,
+) -> Option<(Vec<Vec<PpToken<'a>>>, HideSet<'a>)> {
+    let open = input.iter().position(|t| !t.kind.is_blank())?;
+    if input[open].kind != PpKind::Punct || input[open].text != "(" {
+        return None;
+    }
+
+    let mut depth = 0usize;
+    let mut close = None;
+    for (j, t) in input.iter().enumerate().skip(open) {
+        if t.kind != PpKind::Punct {
+            continue;
+        }
+        match &*t.text {
+            "(" => depth += 1,
+            ")" => {
                 depth -= 1;
                 if depth == 0 {
-                    args.push(current.trim().to_string());
-                    return Some((args, i + 1));
+                    close = Some(j);
+                    break;
                 }
-                current.push(c);
-            } else if c == ',' && depth == 1 {
-                args.push(current.trim().to_string());
-                current = String::new();
-            } else {
-                current.push(c);
             }
-            i += 1;
+            _ => {}
         }
-        None
     }
+    let close = close?;
 
-    /// Get list of all included headers (for debugging/analysis)
-    pub fn included_headers(&self) -> &HashSet<String> {
-        &self.included
+    let mut taken: Vec<PpToken<'a>> = input.drain(..=close).skip(open + 1).collect();
+    let rparen = taken.pop().expect("closing paren");
+
+    let mut args = Vec::new();
+    let mut current = Vec::new();
+    let mut depth = 0usize;
+    for t in taken {
+        if t.kind == PpKind::Punct {
+            match &*t.text {
+                "(" => depth += 1,
+                ")" => depth -= 1,
+                "," if depth == 0 => {
+                    args.push(trim_blank(std::mem::take(&mut current)));
+                    continue;
+                }
+                _ => {}
+            }
+        }
+        current.push(t);
+    }
+    args.push(trim_blank(current));
+    Some((args, rparen.hide))
+}
+
+fn trim_blank(mut tokens: Vec<PpToken<'_>>) -> Vec<PpToken<'_>> {
+    while tokens.last().map_or(false, |t| t.kind.is_blank()) {
+        tokens.pop();
+    }
+    let lead = tokens.iter().take_while(|t| t.kind.is_blank()).count();
+    tokens.drain(..lead);
+    tokens
+}
+
+/// `#arg`: spelling of the argument as a string literal
+fn stringify(tokens: &[PpToken<'_>]) -> String {
+    let mut s = String::from("\"");
+    let mut pending_space = false;
+    for t in tokens {
+        if t.kind.is_blank() {
+            pending_space = true;
+            continue;
+        }
+        if pending_space && s.len() > 1 {
+            s.push(' ');
+        }
+        pending_space = false;
+        for ch in t.text.chars() {
+            if ch == '\\' || ch == '"' {
+                s.push('\\');
+            }
+            s.push(ch);
+        }
+    }
+    s.push('"');
+    s
+}
+
+/// Partial replacement ends in `,` `##`
+fn is_comma_paste(result: &[PpToken<'_>]) -> bool {
+    let mut solid = result.iter().rev().filter(|t| !t.kind.is_blank());
+    matches!(solid.next(), Some(t) if t.kind == PpKind::Paste)
+        && matches!(solid.next(), Some(t) if t.kind == PpKind::Punct && t.text == ",")
+}
+
+/// Remove the trailing `##` (and blanks around it), leaving the `,` last
+fn drop_paste(result: &mut Vec<PpToken<'_>>) {
+    while result.last().map_or(false, |t| t.kind.is_blank() || t.kind == PpKind::Paste) {
+        result.pop();
+    }
+}
+
+/// Apply `##`: glue the solid tokens on each side into one token
+fn paste_tokens(tokens: Vec<PpToken<'_>>) -> Vec<PpToken<'_>> {
+    if !tokens.iter().any(|t| t.kind == PpKind::Paste) {
+        return tokens;
+    }
+    let mut out: Vec<PpToken<'_>> = Vec::with_capacity(tokens.len());
+    let mut iter = tokens.into_iter().peekable();
+    while let Some(tok) = iter.next() {
+        if tok.kind != PpKind::Paste {
+            out.push(tok);
+            continue;
+        }
+        while out.last().map_or(false, |t| t.kind.is_blank()) {
+            out.pop();
+        }
+        while iter.peek().map_or(false, |t| t.kind.is_blank()) {
+            iter.next();
+        }
+        let right = match iter.next() {
+            Some(r) if r.kind != PpKind::Paste => r,
+            _ => continue,
+        };
+        match out.pop() {
+            Some(left) => {
+                let glued = format!("{}{}", left.text, right.text);
+                let kind = {
+                    let mut in_comment = false;
+                    let lexed = lex_pp_line(&glued, &mut in_comment);
+                    if lexed.len() == 1 { lexed[0].kind } else { PpKind::Punct }
+                };
+                out.push(PpToken { kind, text: Cow::Owned(glued), hide: left.hide });
+            }
+            None => out.push(right),
+        }
+    }
+    out
+}
+
+fn hide_contains(hide: &HideSet<'_>, name: &str) -> bool {
+    hide.as_ref().map_or(false, |h| h.iter().any(|n| *n == name))
+}
+
+fn hide_with<'a>(hide: &HideSet<'a>, name: &'a str) -> HideSet<'a> {
+    let mut names = hide.as_ref().map(|h| h.as_ref().clone()).unwrap_or_default();
+    if !names.contains(&name) {
+        names.push(name);
+    }
+    Some(Rc::new(names))
+}
+
+fn hide_intersect<'a>(a: &HideSet<'a>, b: &HideSet<'a>) -> HideSet<'a> {
+    match (a, b) {
+        (Some(a), Some(b)) => {
+            let names: Vec<&'a str> = a.iter().copied().filter(|n| b.contains(n)).collect();
+            if names.is_empty() { None } else { Some(Rc::new(names)) }
+        }
+        _ => None,
+    }
+}
+
+fn hide_union<'a>(a: &HideSet<'a>, b: &HideSet<'a>) -> HideSet<'a> {
+    match (a, b) {
+        (None, _) => b.clone(),
+        (_, None) => a.clone(),
+        (Some(x), Some(y)) => {
+            if Rc::ptr_eq(x, y) {
+                return a.clone();
+            }
+            let mut names = x.as_ref().clone();
+            for n in y.iter() {
+                if !names.contains(n) {
+                    names.push(n);
+                }
+            }
+            Some(Rc::new(names))
+        }
     }
 }
 
@@ -591,6 +1051,37 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_quote_include_pastes_user_header() {
+        let dir = std::env::temp_dir().join(format!("adeb_pp_user_{}", std::process::id()));
+        std::fs::create_dir_all(dir.join("inc")).unwrap();
+        std::fs::write(dir.join("common.h"), "#include \"inc/limits.h\"\nint twice(int x);\n").unwrap();
+        std::fs::write(dir.join("inc/limits.h"), "#define LIMIT 40\n").unwrap();
+
+        let mut pp = CPreprocessor::new();
+        pp.set_source_dir(&dir);
+        let result = pp.process("#include \"common.h\"\nint main() { return LIMIT; }\n");
+        assert!(result.contains("int twice(int x);"));
+        assert!(result.contains("return 40;"));
+        assert_eq!(pp.user_headers().len(), 2);
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_macro_definitions_roundtrip() {
+        let mut pp = CPreprocessor::new();
+        pp.process("#define N 4\n#define SQ(x) ((x) * (x))\n#define LOG(fmt, ...) printf(fmt, __VA_ARGS__)\n");
+        let mut replay = CPreprocessor::new();
+        replay.macros.clear();
+        for (_, def) in pp.macro_definitions() {
+            replay.parse_define(&format!("#define {}", def));
+        }
+        assert_eq!(replay.macro_definitions(), pp.macro_definitions());
+        let out = replay.process("int a = SQ(N); LOG(\"%d\", a);\n");
+        assert!(out.contains("((4) * (4))"), "{}", out);
+        assert!(out.contains("printf(\"%d\", a)"), "{}", out);
+    }
+
     #[test]
     fn test_no_double_include() {
         let mut pp = CPreprocessor::new();
@@ -702,4 +1193,44 @@ int x = 3;
         assert!(result.contains("my_log"));
         assert!(result.contains("1, 2, 3"));
     }
+
+    #[test]
+    fn test_self_referential_macros_stop() {
+        let mut pp = CPreprocessor::new();
+        let source = "#define foo foo + 1\n#define A B\n#define B A\nint x = foo; int y = A;\n";
+        let result = pp.process(source);
+        assert!(result.contains("int x = foo + 1;"));
+        assert!(result.contains("int y = A;"));
+    }
+
+    #[test]
+    fn test_paste_stringify_and_string_args() {
+        let mut pp = CPreprocessor::new();
+        let source = r#"
+#define CONCAT(a, b) a##b
+#define STR(x) #x
+#define XSTR(x) STR(x)
+#define N 42
+#define LOG(msg) printf("[LOG] %s\n", msg)
+#define ASSERT(c, ...) do { if (!(c)) return 1; } while (0)
+int CONCAT(my, _var) = 1;
+const char *s = XSTR(N);
+LOG("started");
+ASSERT(x > 0, "positive");
+"#;
+        let result = pp.process(source);
+        assert!(result.contains("int (my_var) = 1;"));
+        assert!(result.contains(r#"const char *s = (("42"));"#));
+        assert!(result.contains(r#"(printf("[LOG] %s\n", "started"));"#));
+        assert!(result.contains("do { if (!(x > 0)) return 1; } while (0);"));
+    }
+
+    #[test]
+    fn test_gnu_comma_paste_with_empty_va_args() {
+        let mut pp = CPreprocessor::new();
+        let source = "#define P(fmt, ...) printf(fmt, ## __VA_ARGS__)\nP(\"a\");\nP(\"%d\", 1);\n";
+        let result = pp.process(source);
+        assert!(result.contains(r#"(printf("a"));"#));
+        assert!(result.contains(r#"(printf("%d", 1));"#));
+    }
 }
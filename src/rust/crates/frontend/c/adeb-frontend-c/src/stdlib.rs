@@ -248,6 +248,8 @@ pub fn get_header(name: &str) -> Option<&'static str> {
         "fastos_limits.h" => Some(HEADER_LIMITS),
         "fastos_types.h" => Some(HEADER_STDINT),
         "fastos_ctype.h" => Some(HEADER_CTYPE),
+        // Anillo de E/S asíncrona (io_uring / IOCP), no es un alias
+        "fastos_aio.h" => Some(HEADER_FASTOS_AIO),
 
         // ==========================================
         // DirectX / DXGI / HLSL (Fase 3)
@@ -262,11 +264,25 @@ pub fn get_header(name: &str) -> Option<&'static str> {
     }
 }
 
-/// Check if a symbol name is a known C stdlib function/type/macro.
-/// Uses the stdlib/c/ registries for authoritative lookup.
+/// Headers whose names `is_known_c_symbol` answers for
+const STANDARD_C_HEADERS: &[&str] = &[
+    "stddef.h", "stdint.h", "stdbool.h", "limits.h", "errno.h", "assert.h",
+    "stdio.h", "stdlib.h", "string.h", "math.h", "time.h", "ctype.h",
+];
+
+/// Check if a symbol name is a known C stdlib function/type/constant.
+/// Looks it up in the symbol index of the parsed standard headers
+/// (built once per process, from fastos.bib when it is there).
 pub fn is_known_c_symbol(name: &str) -> bool {
-    let _ = name;
-    false
+    use std::sync::{Arc, OnceLock};
+    static INDEX: OnceLock<Option<Arc<crate::header_cache::ParsedHeaders>>> = OnceLock::new();
+    INDEX
+        .get_or_init(|| {
+            let headers: Vec<String> = STANDARD_C_HEADERS.iter().map(|h| h.to_string()).collect();
+            crate::header_cache::load_headers(&headers).ok()
+        })
+        .as_ref()
+        .map_or(false, |index| index.defines(name))
 }
 
 /// Resolve a fastos header name to its origin module.
@@ -400,6 +416,14 @@ char *realpath(const char *path, char *resolved_path);
 typedef struct { int quot; int rem; } div_t;
 typedef struct { long quot; long rem; } ldiv_t;
 typedef struct { long long quot; long long rem; } lldiv_t;
+typedef struct {
+    unsigned long long allocs;
+    unsigned long long frees;
+    unsigned long long in_use;
+    unsigned long long mapped;
+    unsigned long long large_allocs;
+} adb_heap_stats_t;
+int adb_heap_stats(adb_heap_stats_t *out);
 "#;
 
 const HEADER_STRING: &str = r#"
@@ -508,6 +532,7 @@ float fminf(float x, float y);
 float logf(float x);
 float log2f(float x);
 float expf(float x);
+float tanhf(float x);
 float atan2f(float y, float x);
 "#;
 
@@ -1392,6 +1417,51 @@ void gpu_sync(void);
 #define GPU_RGB(r, g, b) (((r) << 16) | ((g) << 8) | (b))
 "#;
 
+const HEADER_FASTOS_AIO: &str = r#"
+/* fastos_aio.h — asynchronous file/socket I/O ring */
+/* Linux: io_uring (raw syscalls). Windows: I/O completion port; handles */
+/* must be opened with FILE_FLAG_OVERLAPPED. */
+/* op is one of ADB_IO_*; offset is ignored by RECV/SEND; buf_index */
+/* names a registered buffer (*_FIXED only). result is the byte count, */
+/* or a negative error. */
+typedef struct adb_ring adb_ring;
+
+typedef struct {
+    long long op;
+    long long fd;
+    void *buf;
+    unsigned long long len;
+    long long offset;
+    unsigned long long user_data;
+    long long buf_index;
+} adb_io_req;
+
+typedef struct {
+    unsigned long long user_data;
+    long long result;
+} adb_cqe;
+
+typedef struct {
+    void *base;
+    unsigned long long len;
+} adb_iovec;
+
+#define ADB_IO_READ_FIXED   4
+#define ADB_IO_WRITE_FIXED  5
+#define ADB_IO_READ         22
+#define ADB_IO_WRITE        23
+#define ADB_IO_SEND         26
+#define ADB_IO_RECV         27
+
+adb_ring *adb_ring_create(unsigned entries);
+int adb_ring_register_buffers(adb_ring *ring, const adb_iovec *iov, unsigned count);
+int adb_ring_queue(adb_ring *ring, const adb_io_req *req);
+int adb_ring_queue_batch(adb_ring *ring, const adb_io_req *reqs, unsigned count);
+int adb_ring_submit(adb_ring *ring);
+int adb_ring_wait(adb_ring *ring, adb_cqe *out, unsigned max, unsigned min);
+void adb_ring_destroy(adb_ring *ring);
+"#;
+
 const HEADER_ADEAD_CORE: &str = r#"
 /* adead.h — ADead-BIB Master Header (Arquitectura_2) */
 /* One include to rule them all */
@@ -3483,6 +3553,7 @@ mod tests {
         assert!(get_header("curl/curl.h").is_some());
         assert!(get_header("zlib.h").is_some());
         assert!(get_header("png.h").is_some());
+        assert!(get_header("fastos_aio.h").is_some());
     }
 
     #[test]
@@ -3491,6 +3562,14 @@ mod tests {
         assert!(get_header("not_a_real_header.h").is_none());
     }
 
+    #[test]
+    fn test_known_c_symbols() {
+        assert!(is_known_c_symbol("printf"));
+        assert!(is_known_c_symbol("size_t"));
+        assert!(is_known_c_symbol("isdigit"));
+        assert!(!is_known_c_symbol("my_own_helper"));
+    }
+
     #[test]
     fn test_stdio_has_printf() {
         let stdio = get_header("stdio.h").unwrap();
@@ -104,6 +104,63 @@ pub enum CppType {
     SizeT,
 }
 
+impl CppType {
+    /// Canonical C++ spelling: `signed int` → `int`, `vector<int>` →
+    /// `std::vector<int>`. Two types spell the same iff they are the same
+    /// type (aliases aside), so the spelling keys template instantiations.
+    pub fn spelling(&self) -> String {
+        let list = |args: &[CppType]| args.iter().map(|a| a.spelling()).collect::<Vec<_>>().join(", ");
+        let std1 = |name: &str, t: &CppType| format!("std::{}<{}>", name, t.spelling());
+        match self {
+            CppType::Void => "void".into(),
+            CppType::Bool => "bool".into(),
+            CppType::Char => "char".into(),
+            CppType::WChar => "wchar_t".into(),
+            CppType::Char8 => "char8_t".into(),
+            CppType::Char16 => "char16_t".into(),
+            CppType::Char32 => "char32_t".into(),
+            CppType::Short => "short".into(),
+            CppType::Int => "int".into(),
+            CppType::Long => "long".into(),
+            CppType::LongLong => "long long".into(),
+            CppType::Float => "float".into(),
+            CppType::Double => "double".into(),
+            CppType::LongDouble => "long double".into(),
+            CppType::Auto => "auto".into(),
+            CppType::SizeT => "size_t".into(),
+            CppType::Nullptr => "std::nullptr_t".into(),
+            CppType::Unsigned(t) => format!("unsigned {}", t.spelling()),
+            // Only `signed char` is a distinct type
+            CppType::Signed(t) if **t == CppType::Char => "signed char".into(),
+            CppType::Signed(t) => t.spelling(),
+            CppType::Const(t) => format!("const {}", t.spelling()),
+            CppType::Volatile(t) => format!("volatile {}", t.spelling()),
+            CppType::Mutable(t) | CppType::Constexpr(t) => t.spelling(),
+            CppType::Pointer(t) => format!("{}*", t.spelling()),
+            CppType::Reference(t) => format!("{}&", t.spelling()),
+            CppType::RValueRef(t) => format!("{}&&", t.spelling()),
+            CppType::Array(t, Some(n)) => format!("{}[{}]", t.spelling(), n),
+            CppType::Array(t, None) => format!("{}[]", t.spelling()),
+            CppType::Named(n) | CppType::Struct(n) | CppType::Class(n)
+            | CppType::Enum(n) | CppType::Union(n) | CppType::Typedef(n) => n.clone(),
+            CppType::TemplateType { name, args } => format!("{}<{}>", name, list(args)),
+            CppType::StdString => "std::string".into(),
+            CppType::StdStringView => "std::string_view".into(),
+            CppType::StdVector(t) => std1("vector", t),
+            CppType::StdMap(k, v) => format!("std::map<{}, {}>", k.spelling(), v.spelling()),
+            CppType::StdUnorderedMap(k, v) => format!("std::unordered_map<{}, {}>", k.spelling(), v.spelling()),
+            CppType::StdSet(t) => std1("set", t),
+            CppType::StdUnorderedSet(t) => std1("unordered_set", t),
+            CppType::UniquePtr(t) => std1("unique_ptr", t),
+            CppType::SharedPtr(t) => std1("shared_ptr", t),
+            CppType::StdAtomic(t) => std1("atomic", t),
+            CppType::StdTuple(args) => format!("std::tuple<{}>", list(args)),
+            // The rest have no template-relevant identity beyond their shape
+            other => format!("{:?}", other),
+        }
+    }
+}
+
 // ========== Expressions ==========
 
 #[derive(Debug, Clone, PartialEq)]
@@ -123,6 +180,11 @@ pub enum CppExpr {
         scope: Vec<String>, // std::cout → ["std"]
         name: String,       // "cout"
     },
+    // Template-id: max<int>, Box<T> (callee of an explicit instantiation)
+    TemplateId {
+        name: String,
+        args: Vec<CppType>,
+    },
     This,
 
     // Binary operations
@@ -372,6 +434,93 @@ pub enum CppStmt {
     CoReturn(Option<CppExpr>),
 }
 
+impl CppExpr {
+    /// Direct subexpressions (lambda bodies are statements: see `visit_exprs`)
+    pub fn children(&self) -> Vec<&CppExpr> {
+        match self {
+            CppExpr::BinaryOp { left, right, .. }
+            | CppExpr::Assign { target: left, value: right }
+            | CppExpr::CompoundAssign { target: left, value: right, .. }
+            | CppExpr::Index { object: left, index: right }
+            | CppExpr::RangeExpr { start: left, end: right } => vec![left, right],
+            CppExpr::UnaryOp { expr: e, .. }
+            | CppExpr::MemberAccess { object: e, .. }
+            | CppExpr::ArrowAccess { pointer: e, .. }
+            | CppExpr::Deref(e)
+            | CppExpr::AddressOf(e)
+            | CppExpr::Cast { expr: e, .. }
+            | CppExpr::TypeId(e)
+            | CppExpr::Delete { expr: e, .. }
+            | CppExpr::PackExpansion(e)
+            | CppExpr::CoAwait(e)
+            | CppExpr::CoYield(e)
+            | CppExpr::SizeOf(CppSizeOfArg::Expr(e)) => vec![e],
+            CppExpr::Call { callee, args } => std::iter::once(callee.as_ref()).chain(args).collect(),
+            CppExpr::Ternary { condition, then_expr, else_expr } => vec![condition, then_expr, else_expr],
+            CppExpr::InitList(items) => items.iter().collect(),
+            CppExpr::New { args, array_size, .. } => args.iter().chain(array_size.as_deref()).collect(),
+            CppExpr::FoldExpr { pack, init, .. } => std::iter::once(pack.as_ref()).chain(init.as_deref()).collect(),
+            CppExpr::Throw(e) => e.as_deref().into_iter().collect(),
+            _ => Vec::new(),
+        }
+    }
+}
+
+impl CppStmt {
+    /// Expressions and nested statements directly inside this statement
+    pub fn parts(&self) -> (Vec<&CppExpr>, Vec<&CppStmt>) {
+        match self {
+            CppStmt::Expr(e) | CppStmt::Throw(Some(e)) | CppStmt::Return(Some(e)) | CppStmt::CoReturn(Some(e)) => {
+                (vec![e], Vec::new())
+            }
+            CppStmt::VarDecl { declarators, .. } => {
+                (declarators.iter().filter_map(|d| d.initializer.as_ref()).collect(), Vec::new())
+            }
+            CppStmt::Block(body) => (Vec::new(), body.iter().collect()),
+            CppStmt::If { init, condition, then_body, else_body, .. } => (
+                vec![condition],
+                init.as_deref().into_iter().chain(Some(then_body.as_ref())).chain(else_body.as_deref()).collect(),
+            ),
+            CppStmt::While { condition, body } | CppStmt::DoWhile { body, condition } => (vec![condition], vec![body]),
+            CppStmt::For { init, condition, increment, body } => (
+                condition.iter().chain(increment).collect(),
+                init.as_deref().into_iter().chain(Some(body.as_ref())).collect(),
+            ),
+            CppStmt::RangeFor { iterable, body, .. } => (vec![iterable], vec![body]),
+            CppStmt::Switch { expr, cases, default } => (
+                std::iter::once(expr).chain(cases.iter().map(|c| &c.value)).collect(),
+                cases.iter().flat_map(|c| &c.body).chain(default.iter().flatten()).collect(),
+            ),
+            CppStmt::Label(_, body) => (Vec::new(), vec![body]),
+            CppStmt::Try { body, catches } => {
+                (Vec::new(), body.iter().chain(catches.iter().flat_map(|c| &c.body)).collect())
+            }
+            _ => (Vec::new(), Vec::new()),
+        }
+    }
+}
+
+/// Calls `f` on every expression in `stmts`, outer before inner, lambda
+/// bodies included
+pub fn visit_exprs<'a>(stmts: impl IntoIterator<Item = &'a CppStmt>, f: &mut impl FnMut(&'a CppExpr)) {
+    fn expr<'a>(e: &'a CppExpr, f: &mut impl FnMut(&'a CppExpr)) {
+        f(e);
+        if let CppExpr::Lambda { body, .. } = e {
+            visit_exprs(body, f);
+        }
+        for child in e.children() {
+            expr(child, f);
+        }
+    }
+    for stmt in stmts {
+        let (exprs, nested) = stmt.parts();
+        for e in exprs {
+            expr(e, f);
+        }
+        visit_exprs(nested, f);
+    }
+}
+
 #[derive(Debug, Clone, PartialEq)]
 pub struct CppDeclarator {
     pub name: String,
@@ -438,6 +587,7 @@ pub enum CppTopLevel {
         bases: Vec<CppBaseClass>,
         members: Vec<CppClassMember>,
         is_struct: bool,
+        is_final: bool,
     },
 
     // Enums
@@ -14,7 +14,11 @@ pub mod parse {
 }
 
 pub mod lower {
+    pub mod constexpr;
     pub mod cpp_to_ir;
+    pub mod elision;
+    pub mod hierarchy;
+    pub mod templates;
 }
 
 // Compatibility aliases matching cpp_mod.rs convention
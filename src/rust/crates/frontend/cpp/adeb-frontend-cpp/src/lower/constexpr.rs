@@ -0,0 +1,900 @@
+// ============================================================
+// Constexpr Evaluator
+// ============================================================
+// A small interpreter over the C++ AST that runs `constexpr`
+// functions at compile time: locals, loops, switch, recursion,
+// std::array / C arrays, with C++ integer semantics (width,
+// signedness, usual arithmetic conversions and wraparound).
+//
+// The lowering uses it for constexpr and const variables, whose
+// values it materializes as initialized data (a CRC table becomes
+// 256 words in the image instead of a loop run at startup), for
+// `static_assert`, `if constexpr` and non-type template arguments.
+//
+// Anything it cannot prove constant — a call to a non-constexpr
+// function, a pointer, a mutable reference — is an `Err`, and the
+// caller falls back to lowering the expression for runtime.
+// ============================================================
+
+use crate::ast::*;
+use std::collections::HashMap;
+
+/// Statements and calls one evaluation may execute, like clang's
+/// -fconstexpr-steps
+pub const STEP_LIMIT: u64 = 1 << 24;
+/// Nested constexpr calls, like -fconstexpr-depth
+pub const DEPTH_LIMIT: usize = 512;
+
+/// An integer with its C++ type: `v` holds the bit pattern, already
+/// wrapped to `bits` (sign-extended when signed)
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct Int {
+    pub v: i64,
+    pub bits: u32,
+    pub unsigned: bool,
+}
+
+impl Int {
+    pub fn new(v: i64, bits: u32, unsigned: bool) -> Self {
+        let v = match bits {
+            64 => v,
+            _ if unsigned => v & ((1i64 << bits) - 1),
+            _ => (v << (64 - bits)) >> (64 - bits),
+        };
+        Self { v, bits, unsigned }
+    }
+
+    pub fn int(v: i64) -> Self {
+        Self::new(v, 32, false)
+    }
+
+    fn promoted(self) -> Self {
+        if self.bits < 32 { Self::int(self.v) } else { self }
+    }
+
+    /// Type both operands convert to (usual arithmetic conversions)
+    fn common(a: Self, b: Self) -> (u32, bool) {
+        let (a, b) = (a.promoted(), b.promoted());
+        let bits = a.bits.max(b.bits);
+        let unsigned = if a.bits == b.bits {
+            a.unsigned || b.unsigned
+        } else if a.bits > b.bits {
+            a.unsigned
+        } else {
+            b.unsigned
+        };
+        (bits, unsigned)
+    }
+}
+
+#[derive(Debug, Clone, PartialEq)]
+pub enum Value {
+    Int(Int),
+    Float(f64),
+    Array(Vec<Value>),
+}
+
+impl Value {
+    pub fn int(v: i64) -> Self {
+        Value::Int(Int::int(v))
+    }
+
+    fn bool(b: bool) -> Self {
+        Value::int(b as i64)
+    }
+
+    pub fn as_int(&self) -> Option<i64> {
+        match self {
+            Value::Int(i) => Some(i.v),
+            _ => None,
+        }
+    }
+
+    pub fn truthy(&self) -> Option<bool> {
+        match self {
+            Value::Int(i) => Some(i.v != 0),
+            Value::Float(f) => Some(*f != 0.0),
+            Value::Array(_) => None,
+        }
+    }
+
+    fn as_float(&self) -> Option<f64> {
+        match self {
+            Value::Int(i) if i.unsigned => Some(i.v as u64 as f64),
+            Value::Int(i) => Some(i.v as f64),
+            Value::Float(f) => Some(*f),
+            Value::Array(_) => None,
+        }
+    }
+}
+
+/// Shape of a scalar type
+#[derive(Debug, Clone, Copy, PartialEq)]
+enum Scalar {
+    Bool,
+    Int(u32, bool),
+    Float,
+    Double,
+}
+
+#[derive(Debug, Clone)]
+struct ConstFn {
+    return_type: CppType,
+    params: Vec<CppParam>,
+    body: Vec<CppStmt>,
+    /// Enclosing namespaces, to resolve unqualified calls from the body
+    ns: Vec<String>,
+}
+
+/// Whether a declaration carries `constexpr` (under any cv-qualifiers)
+pub fn is_constexpr(ty: &CppType) -> bool {
+    match ty {
+        CppType::Constexpr(_) => true,
+        CppType::Const(t) | CppType::Volatile(t) => is_constexpr(t),
+        _ => false,
+    }
+}
+
+/// Declared type of one declarator: `int t[4]` is `int[4]`, and an
+/// unsized `int t[] = {1, 2}` takes its size from the initializer
+pub fn declarator_type(type_spec: &CppType, d: &CppDeclarator) -> CppType {
+    d.derived_type.iter().rev().fold(type_spec.clone(), |t, derived| match derived {
+        CppDerivedType::Array(n) => {
+            let len = n.or(match &d.initializer {
+                Some(CppExpr::InitList(items)) => Some(items.len()),
+                _ => None,
+            });
+            CppType::Array(Box::new(t), len)
+        }
+        CppDerivedType::Pointer => CppType::Pointer(Box::new(t)),
+        CppDerivedType::Reference => CppType::Reference(Box::new(t)),
+        CppDerivedType::RValueRef => CppType::RValueRef(Box::new(t)),
+    })
+}
+
+/// Constexpr functions and constant values of one TU
+#[derive(Debug, Clone, Default)]
+pub struct ConstEval {
+    functions: HashMap<String, ConstFn>,
+    values: HashMap<String, Value>,
+    aliases: HashMap<String, CppType>,
+}
+
+impl ConstEval {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn define_function(&mut self, name: &str, ns: &[String], return_type: &CppType, params: &[CppParam], body: &[CppStmt]) {
+        self.functions.insert(name.to_string(), ConstFn {
+            return_type: return_type.clone(),
+            params: params.to_vec(),
+            body: body.to_vec(),
+            ns: ns.to_vec(),
+        });
+    }
+
+    pub fn has_function(&self, name: &str) -> bool {
+        self.functions.contains_key(name)
+    }
+
+    pub fn define_alias(&mut self, name: &str, ty: &CppType) {
+        self.aliases.insert(name.to_string(), ty.clone());
+    }
+
+    /// Records a variable's value so later constant expressions see it
+    pub fn define(&mut self, name: &str, value: Value) {
+        self.values.insert(name.to_string(), value);
+    }
+
+    pub fn value(&self, name: &str) -> Option<&Value> {
+        self.values.get(name)
+    }
+
+    /// Evaluates `expr`; names that are neither locals, constexpr
+    /// variables nor functions are asked to `outer` (template
+    /// arguments, enumerators)
+    pub fn eval(&self, expr: &CppExpr, outer: &dyn Fn(&str) -> Option<Value>) -> Result<Value, String> {
+        Machine { eval: self, outer, frames: vec![Frame::default()], steps: 0 }.expr(expr)
+    }
+
+    /// Evaluates the initializer of a variable of type `ty`
+    pub fn eval_init(&self, ty: &CppType, init: &CppExpr, outer: &dyn Fn(&str) -> Option<Value>) -> Result<Value, String> {
+        let mut m = Machine { eval: self, outer, frames: vec![Frame::default()], steps: 0 };
+        m.init(ty, Some(init))
+    }
+
+    fn scalar(&self, ty: &CppType) -> Option<Scalar> {
+        Some(match ty {
+            CppType::Bool => Scalar::Bool,
+            CppType::Char | CppType::Char8 => Scalar::Int(8, false),
+            CppType::Short | CppType::Char16 => Scalar::Int(16, false),
+            CppType::Int | CppType::Long | CppType::WChar | CppType::Char32 | CppType::Enum(_) => Scalar::Int(32, false),
+            CppType::LongLong => Scalar::Int(64, false),
+            CppType::SizeT => Scalar::Int(64, true),
+            CppType::Float => Scalar::Float,
+            CppType::Double | CppType::LongDouble => Scalar::Double,
+            CppType::Unsigned(t) => match self.scalar(t)? {
+                Scalar::Int(bits, _) => Scalar::Int(bits, true),
+                _ => return None,
+            },
+            CppType::Signed(t) => match self.scalar(t)? {
+                Scalar::Int(bits, _) => Scalar::Int(bits, false),
+                _ => return None,
+            },
+            CppType::Const(t) | CppType::Volatile(t) | CppType::Constexpr(t) | CppType::Mutable(t) => self.scalar(t)?,
+            CppType::Named(n) | CppType::Typedef(n) => match n.trim_start_matches("std::") {
+                "int8_t" => Scalar::Int(8, false),
+                "int16_t" => Scalar::Int(16, false),
+                "int32_t" => Scalar::Int(32, false),
+                "int64_t" | "intptr_t" | "ptrdiff_t" | "intmax_t" => Scalar::Int(64, false),
+                "uint8_t" => Scalar::Int(8, true),
+                "uint16_t" => Scalar::Int(16, true),
+                "uint32_t" => Scalar::Int(32, true),
+                "uint64_t" | "uintptr_t" | "uintmax_t" | "size_t" => Scalar::Int(64, true),
+                _ => self.scalar(self.aliases.get(n)?)?,
+            },
+            _ => return None,
+        })
+    }
+
+    /// `v` converted to `ty`; types without a scalar shape keep it as is
+    fn convert(&self, v: Value, ty: &CppType) -> Result<Value, String> {
+        let Some(shape) = self.scalar(ty) else {
+            return Ok(v);
+        };
+        let bad = || format!("constexpr: cannot convert {:?} to {}", v, ty.spelling());
+        Ok(match (shape, &v) {
+            (Scalar::Bool, _) => Value::bool(v.truthy().ok_or_else(bad)?),
+            (Scalar::Int(bits, unsigned), Value::Int(i)) => Value::Int(Int::new(i.v, bits, unsigned)),
+            (Scalar::Int(bits, unsigned), Value::Float(f)) => Value::Int(Int::new(*f as i64, bits, unsigned)),
+            (Scalar::Float, _) => Value::Float(v.as_float().ok_or_else(bad)? as f32 as f64),
+            (Scalar::Double, _) => Value::Float(v.as_float().ok_or_else(bad)?),
+            _ => return Err(bad()),
+        })
+    }
+
+    /// Value-initialized object of `ty`: zeros, element by element
+    fn zero(&self, ty: &CppType) -> Result<Value, String> {
+        match ty {
+            CppType::StdArray(elem, n) | CppType::Array(elem, Some(n)) => {
+                let z = self.zero(elem)?;
+                Ok(Value::Array(vec![z; *n]))
+            }
+            CppType::Const(t) | CppType::Volatile(t) | CppType::Constexpr(t) => self.zero(t),
+            CppType::Named(n) | CppType::Typedef(n) if self.scalar(ty).is_none() => match self.aliases.get(n) {
+                Some(t) => self.zero(t),
+                None => Err(format!("constexpr: unsupported type {}", n)),
+            },
+            _ => self.convert(Value::int(0), ty).and_then(|v| match v {
+                Value::Int(_) | Value::Float(_) if self.scalar(ty).is_some() => Ok(v),
+                _ => Err(format!("constexpr: unsupported type {}", ty.spelling())),
+            }),
+        }
+    }
+}
+
+/// Locals of one call, innermost scope last
+#[derive(Debug, Default)]
+struct Frame {
+    locals: Vec<(String, Value, CppType)>,
+    scopes: Vec<usize>,
+    /// Namespaces of the function this call runs
+    ns: Vec<String>,
+}
+
+enum Flow {
+    Normal,
+    Break,
+    Continue,
+    Return(Value),
+}
+
+struct Machine<'a> {
+    eval: &'a ConstEval,
+    outer: &'a dyn Fn(&str) -> Option<Value>,
+    frames: Vec<Frame>,
+    steps: u64,
+}
+
+fn not_constant(what: &str) -> String {
+    format!("constexpr: {} is not a constant expression", what)
+}
+
+impl<'a> Machine<'a> {
+    fn step(&mut self) -> Result<(), String> {
+        self.steps += 1;
+        if self.steps > STEP_LIMIT {
+            return Err(format!("constexpr: evaluation exceeded {} steps", STEP_LIMIT));
+        }
+        Ok(())
+    }
+
+    fn frame(&mut self) -> &mut Frame {
+        self.frames.last_mut().unwrap()
+    }
+
+    fn local(&self, name: &str) -> Option<&(String, Value, CppType)> {
+        self.frames.last()?.locals.iter().rev().find(|(n, _, _)| n == name)
+    }
+
+    fn local_mut(&mut self, name: &str) -> Option<&mut (String, Value, CppType)> {
+        self.frames.last_mut()?.locals.iter_mut().rev().find(|(n, _, _)| n == name)
+    }
+
+    fn declare(&mut self, name: &str, v: Value, ty: CppType) {
+        self.frame().locals.push((name.to_string(), v, ty));
+    }
+
+    fn scoped<T>(&mut self, f: impl FnOnce(&mut Self) -> Result<T, String>) -> Result<T, String> {
+        let mark = self.frame().locals.len();
+        self.frame().scopes.push(mark);
+        let result = f(self);
+        let frame = self.frame();
+        frame.scopes.pop();
+        frame.locals.truncate(mark);
+        result
+    }
+
+    fn lookup(&self, name: &str) -> Result<Value, String> {
+        if let Some((_, v, _)) = self.local(name) {
+            return Ok(v.clone());
+        }
+        if let Some(v) = self.eval.values.get(name) {
+            return Ok(v.clone());
+        }
+        (self.outer)(name).ok_or_else(|| not_constant(name))
+    }
+
+    /// Initial value of a variable of type `ty`
+    fn init(&mut self, ty: &CppType, init: Option<&CppExpr>) -> Result<Value, String> {
+        match init {
+            None => self.eval.zero(ty),
+            Some(CppExpr::InitList(items)) if matches!(ty, CppType::StdArray(..) | CppType::Array(..)) => {
+                let (CppType::StdArray(elem, _) | CppType::Array(elem, _)) = ty else { unreachable!() };
+                let mut out = match self.eval.zero(ty)? {
+                    Value::Array(zeros) => zeros,
+                    _ => unreachable!(),
+                };
+                if items.len() > out.len() {
+                    return Err("constexpr: too many initializers".into());
+                }
+                for (slot, item) in out.iter_mut().zip(items) {
+                    *slot = self.init(elem, Some(item))?;
+                }
+                Ok(Value::Array(out))
+            }
+            // `T x{}` / `T x = {v}` on a scalar
+            Some(CppExpr::InitList(items)) => match items.as_slice() {
+                [] => self.eval.zero(ty),
+                [one] => self.init(ty, Some(one)),
+                _ => Err(not_constant("initializer list")),
+            },
+            Some(e) => {
+                let v = self.expr(e)?;
+                self.eval.convert(v, ty)
+            }
+        }
+    }
+
+    // ── Statements ──────────────────────────────────────────
+
+    fn block(&mut self, stmts: &[CppStmt]) -> Result<Flow, String> {
+        self.scoped(|m| {
+            for s in stmts {
+                match m.stmt(s)? {
+                    Flow::Normal => {}
+                    flow => return Ok(flow),
+                }
+            }
+            Ok(Flow::Normal)
+        })
+    }
+
+    fn stmt(&mut self, stmt: &CppStmt) -> Result<Flow, String> {
+        self.step()?;
+        match stmt {
+            CppStmt::LineMarker(_) | CppStmt::Empty => Ok(Flow::Normal),
+            CppStmt::Expr(e) => self.expr(e).map(|_| Flow::Normal),
+            CppStmt::VarDecl { type_spec, declarators } => {
+                for d in declarators {
+                    let ty = declarator_type(type_spec, d);
+                    if matches!(ty, CppType::Pointer(_) | CppType::Reference(_) | CppType::RValueRef(_)) {
+                        return Err(not_constant(&format!("reference or pointer `{}`", d.name)));
+                    }
+                    let v = self.init(&ty, d.initializer.as_ref())?;
+                    self.declare(&d.name, v, ty);
+                }
+                Ok(Flow::Normal)
+            }
+            CppStmt::Block(body) => self.block(body),
+            CppStmt::Return(Some(e)) => Ok(Flow::Return(self.expr(e)?)),
+            CppStmt::Return(None) => Ok(Flow::Return(Value::int(0))),
+            CppStmt::If { init, condition, then_body, else_body, .. } => self.scoped(|m| {
+                if let Some(init) = init {
+                    m.stmt(init)?;
+                }
+                if m.condition(condition)? {
+                    m.stmt(then_body)
+                } else if let Some(eb) = else_body {
+                    m.stmt(eb)
+                } else {
+                    Ok(Flow::Normal)
+                }
+            }),
+            CppStmt::While { condition, body } => {
+                while self.condition(condition)? {
+                    match self.stmt(body)? {
+                        Flow::Break => break,
+                        Flow::Return(v) => return Ok(Flow::Return(v)),
+                        Flow::Normal | Flow::Continue => {}
+                    }
+                }
+                Ok(Flow::Normal)
+            }
+            CppStmt::DoWhile { body, condition } => {
+                loop {
+                    match self.stmt(body)? {
+                        Flow::Break => break,
+                        Flow::Return(v) => return Ok(Flow::Return(v)),
+                        Flow::Normal | Flow::Continue => {}
+                    }
+                    if !self.condition(condition)? {
+                        break;
+                    }
+                }
+                Ok(Flow::Normal)
+            }
+            CppStmt::For { init, condition, increment, body } => self.scoped(|m| {
+                if let Some(init) = init {
+                    m.stmt(init)?;
+                }
+                while match condition {
+                    Some(c) => m.condition(c)?,
+                    None => true,
+                } {
+                    match m.stmt(body)? {
+                        Flow::Break => break,
+                        Flow::Return(v) => return Ok(Flow::Return(v)),
+                        Flow::Normal | Flow::Continue => {}
+                    }
+                    if let Some(inc) = increment {
+                        m.expr(inc)?;
+                    }
+                }
+                Ok(Flow::Normal)
+            }),
+            CppStmt::RangeFor { type_spec, name, iterable, body } => {
+                let Value::Array(items) = self.expr(iterable)? else {
+                    return Err(not_constant("range-for over a non-array"));
+                };
+                for item in items {
+                    let flow = self.scoped(|m| {
+                        let v = m.eval.convert(item, type_spec)?;
+                        m.declare(name, v, type_spec.clone());
+                        m.stmt(body)
+                    })?;
+                    match flow {
+                        Flow::Break => break,
+                        Flow::Return(v) => return Ok(Flow::Return(v)),
+                        Flow::Normal | Flow::Continue => {}
+                    }
+                }
+                Ok(Flow::Normal)
+            }
+            CppStmt::Switch { expr, cases, default } => {
+                let v = self.expr(expr)?;
+                let mut start = None;
+                for (i, case) in cases.iter().enumerate() {
+                    if self.expr(&case.value)? == v {
+                        start = Some(i);
+                        break;
+                    }
+                }
+                // A matching case falls through the ones after it, then `default`
+                let bodies = start.map_or(&cases[cases.len()..], |i| &cases[i..]);
+                let stmts = bodies.iter().flat_map(|c| &c.body).chain(default.iter().flatten());
+                let body: Vec<CppStmt> = stmts.cloned().collect();
+                match self.block(&body)? {
+                    Flow::Break | Flow::Normal => Ok(Flow::Normal),
+                    flow => Ok(flow),
+                }
+            }
+            CppStmt::Break => Ok(Flow::Break),
+            CppStmt::Continue => Ok(Flow::Continue),
+            _ => Err(not_constant("statement")),
+        }
+    }
+
+    fn condition(&mut self, e: &CppExpr) -> Result<bool, String> {
+        self.expr(e)?.truthy().ok_or_else(|| not_constant("condition"))
+    }
+
+    // ── Expressions ─────────────────────────────────────────
+
+    fn expr(&mut self, e: &CppExpr) -> Result<Value, String> {
+        match e {
+            CppExpr::IntLiteral(n) => Ok(Value::Int(match i32::try_from(*n) {
+                Ok(_) => Int::int(*n),
+                Err(_) => Int::new(*n, 64, false),
+            })),
+            CppExpr::UIntLiteral(n) => Ok(Value::Int(Int::new(*n as i64, if *n > u32::MAX as u64 { 64 } else { 32 }, true))),
+            CppExpr::FloatLiteral(f) => Ok(Value::Float(*f)),
+            CppExpr::CharLiteral(c) => Ok(Value::Int(Int::new(*c as i64, 8, false))),
+            CppExpr::BoolLiteral(b) => Ok(Value::bool(*b)),
+            CppExpr::Identifier(name) => self.lookup(name),
+            CppExpr::ScopedIdentifier { scope, name } => {
+                let full = format!("{}::{}", scope.join("::"), name);
+                self.lookup(&full).or_else(|_| self.lookup(name))
+            }
+            CppExpr::BinaryOp { op: CppBinOp::And, left, right } => {
+                Ok(Value::bool(self.condition(left)? && self.condition(right)?))
+            }
+            CppExpr::BinaryOp { op: CppBinOp::Or, left, right } => {
+                Ok(Value::bool(self.condition(left)? || self.condition(right)?))
+            }
+            CppExpr::BinaryOp { op, left, right } => {
+                let (a, b) = (self.expr(left)?, self.expr(right)?);
+                binary(*op, &a, &b)
+            }
+            CppExpr::UnaryOp { op, expr, .. } => match op {
+                CppUnaryOp::Neg => match self.expr(expr)? {
+                    Value::Int(i) => {
+                        let p = i.promoted();
+                        Ok(Value::Int(Int::new(p.v.wrapping_neg(), p.bits, p.unsigned)))
+                    }
+                    Value::Float(f) => Ok(Value::Float(-f)),
+                    Value::Array(_) => Err(not_constant("-array")),
+                },
+                CppUnaryOp::Not => Ok(Value::bool(!self.condition(expr)?)),
+                CppUnaryOp::BitNot => match self.expr(expr)? {
+                    Value::Int(i) => {
+                        let p = i.promoted();
+                        Ok(Value::Int(Int::new(!p.v, p.bits, p.unsigned)))
+                    }
+                    _ => Err(not_constant("~ on a non-integer")),
+                },
+                CppUnaryOp::PreInc | CppUnaryOp::PreDec | CppUnaryOp::PostInc | CppUnaryOp::PostDec => {
+                    let old = self.expr(expr)?;
+                    let bin = if matches!(op, CppUnaryOp::PreInc | CppUnaryOp::PostInc) { CppBinOp::Add } else { CppBinOp::Sub };
+                    let new = self.store(expr, binary(bin, &old, &Value::int(1))?)?;
+                    Ok(if matches!(op, CppUnaryOp::PostInc | CppUnaryOp::PostDec) { old } else { new })
+                }
+            },
+            CppExpr::Assign { target, value } => {
+                let v = self.expr(value)?;
+                self.store(target, v)
+            }
+            CppExpr::CompoundAssign { op, target, value } => {
+                let (old, v) = (self.expr(target)?, self.expr(value)?);
+                self.store(target, binary(*op, &old, &v)?)
+            }
+            CppExpr::Ternary { condition, then_expr, else_expr } => {
+                if self.condition(condition)? { self.expr(then_expr) } else { self.expr(else_expr) }
+            }
+            CppExpr::Cast { cast_type: CppCastKind::CStyle | CppCastKind::StaticCast, target_type, expr } => {
+                let v = self.expr(expr)?;
+                self.eval.convert(v, target_type)
+            }
+            CppExpr::Index { .. } => {
+                let (name, path) = self.place(e)?;
+                let mut v = match self.local(&name) {
+                    Some((_, v, _)) => v,
+                    None => self.eval.values.get(&name).ok_or_else(|| not_constant(&name))?,
+                };
+                for i in path {
+                    v = match v {
+                        Value::Array(items) => items.get(i).ok_or_else(|| format!("constexpr: index {} out of bounds", i))?,
+                        _ => return Err(not_constant("subscript of a non-array")),
+                    };
+                }
+                Ok(v.clone())
+            }
+            CppExpr::SizeOf(CppSizeOfArg::Type(t)) => self.size_of(t),
+            CppExpr::Call { callee, args } => self.call(callee, args),
+            CppExpr::InitList(items) => {
+                let items = items.iter().map(|i| self.expr(i)).collect::<Result<_, _>>()?;
+                Ok(Value::Array(items))
+            }
+            _ => Err(not_constant(&format!("{:?}", e).chars().take(40).collect::<String>())),
+        }
+    }
+
+    fn size_of(&self, t: &CppType) -> Result<Value, String> {
+        let size = match self.eval.scalar(t) {
+            Some(Scalar::Bool) => 1,
+            Some(Scalar::Int(bits, _)) => bits as i64 / 8,
+            Some(Scalar::Float) => 4,
+            Some(Scalar::Double) => 8,
+            None => match t {
+                CppType::Pointer(_) | CppType::Reference(_) => 8,
+                CppType::StdArray(elem, n) | CppType::Array(elem, Some(n)) => {
+                    self.size_of(elem)?.as_int().unwrap() * *n as i64
+                }
+                _ => return Err(not_constant("sizeof")),
+            },
+        };
+        Ok(Value::Int(Int::new(size, 64, true)))
+    }
+
+    /// Variable and indices an lvalue names: `t[i][j]` → ("t", [i, j])
+    fn place(&mut self, e: &CppExpr) -> Result<(String, Vec<usize>), String> {
+        match e {
+            CppExpr::Identifier(name) => Ok((name.clone(), Vec::new())),
+            CppExpr::Index { object, index } => {
+                let i = self.expr(index)?.as_int().ok_or_else(|| not_constant("index"))?;
+                let (name, mut path) = self.place(object)?;
+                path.push(usize::try_from(i).map_err(|_| format!("constexpr: negative index {}", i))?);
+                Ok((name, path))
+            }
+            _ => Err(not_constant("assignment target")),
+        }
+    }
+
+    /// Assigns `v` (converted to the element type) and returns the stored value
+    fn store(&mut self, target: &CppExpr, v: Value) -> Result<Value, String> {
+        let (name, path) = self.place(target)?;
+        let ty = match self.local(&name) {
+            Some((_, _, ty)) => element_type(ty, path.len()),
+            None => return Err(not_constant(&format!("modification of `{}`", name))),
+        };
+        let v = self.eval.convert(v, &ty)?;
+        let (_, slot, _) = self.local_mut(&name).unwrap();
+        let mut slot = slot;
+        for i in path {
+            slot = match slot {
+                Value::Array(items) => items.get_mut(i).ok_or_else(|| format!("constexpr: index {} out of bounds", i))?,
+                _ => return Err(not_constant("subscript of a non-array")),
+            };
+        }
+        *slot = v.clone();
+        Ok(v)
+    }
+
+    fn call(&mut self, callee: &CppExpr, args: &[CppExpr]) -> Result<Value, String> {
+        if let CppExpr::MemberAccess { object, member } = callee {
+            return match (self.expr(object)?, member.as_str()) {
+                (Value::Array(items), "size") if args.is_empty() => Ok(Value::Int(Int::new(items.len() as i64, 64, true))),
+                _ => Err(not_constant(&format!(".{}()", member))),
+            };
+        }
+        let (scope, name) = match callee {
+            CppExpr::Identifier(n) => (Vec::new(), n.as_str()),
+            CppExpr::ScopedIdentifier { scope, name } => (scope.clone(), name.as_str()),
+            _ => return Err(not_constant("indirect call")),
+        };
+        let values = args.iter().map(|a| self.expr(a)).collect::<Result<Vec<_>, _>>()?;
+        let Some(f) = self.function(&scope, name) else {
+            return builtin(&scope, name, &values).ok_or_else(|| not_constant(&format!("call to `{}`", name)));
+        };
+        self.step()?;
+        if self.frames.len() > DEPTH_LIMIT {
+            return Err(format!("constexpr: call depth exceeds {}", DEPTH_LIMIT));
+        }
+        let mut frame = Frame { ns: f.ns.clone(), ..Frame::default() };
+        for (i, p) in f.params.iter().enumerate() {
+            let v = match (values.get(i), &p.default_value) {
+                (Some(v), _) => v.clone(),
+                (None, Some(d)) => self.expr(d)?,
+                (None, None) => return Err(format!("constexpr: too few arguments to `{}`", name)),
+            };
+            let ty = match &p.param_type {
+                CppType::Reference(t) if matches!(t.as_ref(), CppType::Const(_)) => t.as_ref().clone(),
+                CppType::Reference(_) | CppType::Pointer(_) | CppType::RValueRef(_) => {
+                    return Err(not_constant(&format!("reference or pointer parameter of `{}`", name)));
+                }
+                t => t.clone(),
+            };
+            let v = self.eval.convert(v, &ty)?;
+            if let Some(n) = &p.name {
+                frame.locals.push((n.clone(), v, ty));
+            }
+        }
+        self.frames.push(frame);
+        let flow = self.block(&f.body);
+        self.frames.pop();
+        match flow? {
+            Flow::Return(v) => self.eval.convert(v, &f.return_type),
+            _ => Err(format!("constexpr: `{}` ended without returning a value", name)),
+        }
+    }
+
+    /// The constexpr function a call names: qualified as written, then
+    /// relative to the namespaces of the function making the call
+    fn function(&self, scope: &[String], name: &str) -> Option<&'a ConstFn> {
+        let written: Vec<&str> = scope.iter().map(String::as_str).chain(Some(name)).collect();
+        let written = written.join("::");
+        let fns = &self.eval.functions;
+        let ns = &self.frames.last()?.ns;
+        (0..=ns.len()).rev().find_map(|k| match k {
+            0 => fns.get(&written),
+            _ => fns.get(&format!("{}::{}", ns[..k].join("::"), written)),
+        })
+    }
+}
+
+/// Element type `depth` subscripts into `ty`
+fn element_type(ty: &CppType, depth: usize) -> CppType {
+    match (ty, depth) {
+        (_, 0) => ty.clone(),
+        (CppType::StdArray(elem, _) | CppType::Array(elem, _), _) => element_type(elem, depth - 1),
+        (CppType::Const(t) | CppType::Constexpr(t) | CppType::Volatile(t), _) => element_type(t, depth),
+        _ => ty.clone(),
+    }
+}
+
+fn binary(op: CppBinOp, a: &Value, b: &Value) -> Result<Value, String> {
+    match (a, b) {
+        (Value::Int(x), Value::Int(y)) => int_binary(op, *x, *y),
+        (Value::Array(_), _) | (_, Value::Array(_)) => Err(not_constant("array operand")),
+        _ => {
+            let (x, y) = (a.as_float().unwrap(), b.as_float().unwrap());
+            Ok(match op {
+                CppBinOp::Add => Value::Float(x + y),
+                CppBinOp::Sub => Value::Float(x - y),
+                CppBinOp::Mul => Value::Float(x * y),
+                CppBinOp::Div => Value::Float(x / y),
+                CppBinOp::Eq => Value::bool(x == y),
+                CppBinOp::Ne => Value::bool(x != y),
+                CppBinOp::Lt => Value::bool(x < y),
+                CppBinOp::Le => Value::bool(x <= y),
+                CppBinOp::Gt => Value::bool(x > y),
+                CppBinOp::Ge => Value::bool(x >= y),
+                _ => return Err(not_constant("integer operator on a float")),
+            })
+        }
+    }
+}
+
+fn int_binary(op: CppBinOp, a: Int, b: Int) -> Result<Value, String> {
+    // Shifts take the type of the promoted left operand
+    if let CppBinOp::Shl | CppBinOp::Shr = op {
+        let a = a.promoted();
+        let n = u32::try_from(b.v).ok().filter(|n| *n < a.bits).ok_or_else(|| not_constant("shift by the operand width or more"))?;
+        let v = match (op, a.unsigned) {
+            (CppBinOp::Shl, _) => a.v.wrapping_shl(n),
+            (_, true) => ((a.v as u64) >> n) as i64,
+            (_, false) => a.v >> n,
+        };
+        return Ok(Value::Int(Int::new(v, a.bits, a.unsigned)));
+    }
+    let (bits, unsigned) = Int::common(a, b);
+    let (x, y) = (Int::new(a.v, bits, unsigned).v, Int::new(b.v, bits, unsigned).v);
+    let cmp = if unsigned { (x as u64).cmp(&(y as u64)) } else { x.cmp(&y) };
+    let wrap = |v: i64| Ok(Value::Int(Int::new(v, bits, unsigned)));
+    match op {
+        CppBinOp::Add => wrap(x.wrapping_add(y)),
+        CppBinOp::Sub => wrap(x.wrapping_sub(y)),
+        CppBinOp::Mul => wrap(x.wrapping_mul(y)),
+        CppBinOp::Div | CppBinOp::Mod if y == 0 => Err("constexpr: division by zero".into()),
+        CppBinOp::Div if unsigned => wrap(((x as u64) / (y as u64)) as i64),
+        CppBinOp::Mod if unsigned => wrap(((x as u64) % (y as u64)) as i64),
+        CppBinOp::Div => wrap(x.wrapping_div(y)),
+        CppBinOp::Mod => wrap(x.wrapping_rem(y)),
+        CppBinOp::BitAnd => wrap(x & y),
+        CppBinOp::BitOr => wrap(x | y),
+        CppBinOp::BitXor => wrap(x ^ y),
+        CppBinOp::Eq => Ok(Value::bool(cmp.is_eq())),
+        CppBinOp::Ne => Ok(Value::bool(cmp.is_ne())),
+        CppBinOp::Lt => Ok(Value::bool(cmp.is_lt())),
+        CppBinOp::Le => Ok(Value::bool(cmp.is_le())),
+        CppBinOp::Gt => Ok(Value::bool(cmp.is_gt())),
+        CppBinOp::Ge => Ok(Value::bool(cmp.is_ge())),
+        CppBinOp::Spaceship => Ok(Value::int(cmp as i64)),
+        CppBinOp::And | CppBinOp::Or | CppBinOp::Shl | CppBinOp::Shr => unreachable!(),
+    }
+}
+
+/// <cmath> and <algorithm> functions usable in constant expressions
+fn builtin(scope: &[String], name: &str, args: &[Value]) -> Option<Value> {
+    if !(scope.is_empty() || scope == ["std"]) {
+        return None;
+    }
+    let f = |i: usize| args.get(i).and_then(Value::as_float);
+    let unary: Option<fn(f64) -> f64> = match name {
+        "sin" => Some(f64::sin),
+        "cos" => Some(f64::cos),
+        "tan" => Some(f64::tan),
+        "asin" => Some(f64::asin),
+        "acos" => Some(f64::acos),
+        "atan" => Some(f64::atan),
+        "sinh" => Some(f64::sinh),
+        "cosh" => Some(f64::cosh),
+        "tanh" => Some(f64::tanh),
+        "exp" => Some(f64::exp),
+        "log" => Some(f64::ln),
+        "log2" => Some(f64::log2),
+        "log10" => Some(f64::log10),
+        "sqrt" => Some(f64::sqrt),
+        "fabs" => Some(f64::abs),
+        "floor" => Some(f64::floor),
+        "ceil" => Some(f64::ceil),
+        "round" => Some(f64::round),
+        _ => None,
+    };
+    if let (Some(op), [_]) = (unary, args) {
+        return Some(Value::Float(op(f(0)?)));
+    }
+    match (name, args) {
+        ("pow", [_, _]) => Some(Value::Float(f(0)?.powf(f(1)?))),
+        ("atan2", [_, _]) => Some(Value::Float(f(0)?.atan2(f(1)?))),
+        ("fmod", [_, _]) => Some(Value::Float(f(0)? % f(1)?)),
+        ("abs", [Value::Int(i)]) => Some(Value::Int(Int::new(i.v.wrapping_abs(), i.bits, i.unsigned))),
+        ("abs", [Value::Float(x)]) => Some(Value::Float(x.abs())),
+        ("min" | "max", [a, b]) => {
+            let less = binary(CppBinOp::Lt, b, a).ok()?.truthy()?;
+            Some(if less == (name == "min") { b.clone() } else { a.clone() })
+        }
+        _ => None,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::parse::lexer::CppLexer;
+    use crate::parse::parser::CppParser;
+    use crate::preprocessor::CppPreprocessor;
+
+    /// Constexpr functions of `src` and the value of `expr` under them
+    fn eval(src: &str, expr: CppExpr) -> Result<Value, String> {
+        let mut pp = CppPreprocessor::new();
+        let (tokens, lines) = CppLexer::new(&pp.process(src)).tokenize();
+        let unit = CppParser::new(tokens, lines).parse_translation_unit().unwrap();
+        let mut ce = ConstEval::new();
+        for d in &unit.declarations {
+            if let CppTopLevel::FunctionDef { name, return_type, params, body, .. } = d {
+                if is_constexpr(return_type) {
+                    ce.define_function(name, &[], return_type, params, body);
+                }
+            }
+        }
+        ce.eval(&expr, &|_| None)
+    }
+
+    fn call(name: &str, args: Vec<CppExpr>) -> CppExpr {
+        CppExpr::Call { callee: Box::new(CppExpr::Identifier(name.into())), args }
+    }
+
+    #[test]
+    fn test_unsigned_wraparound_and_loops() {
+        let src = r#"
+            constexpr unsigned int crc(unsigned int c) {
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                return c;
+            }
+            constexpr unsigned int fnv(int n) {
+                unsigned int h = 2166136261u;
+                while (n-- > 0) { h = (h ^ 97) * 16777619u; }
+                return ~h;
+            }
+        "#;
+        let crc1 = eval(src, call("crc", vec![CppExpr::IntLiteral(1)])).unwrap();
+        assert_eq!(crc1.as_int(), Some(0x77073096));
+        let h = eval(src, call("fnv", vec![CppExpr::IntLiteral(2)])).unwrap();
+        let expected = (0..2).fold(2166136261u32, |h, _| (h ^ 97).wrapping_mul(16777619));
+        assert_eq!(h.as_int(), Some(!expected as i64));
+    }
+
+    #[test]
+    fn test_arrays_recursion_and_limits() {
+        let src = r#"
+            constexpr int fact(int n) { return n <= 1 ? 1 : n * fact(n - 1); }
+            constexpr std::array<int, 4> squares() {
+                std::array<int, 4> t{};
+                for (int i = 0; i < t.size(); ++i) t[i] = i * i;
+                return t;
+            }
+            constexpr int forever() { while (true) {} return 0; }
+            int runtime() { return 1; }
+            constexpr int uses_runtime() { return runtime(); }
+        "#;
+        assert_eq!(eval(src, call("fact", vec![CppExpr::IntLiteral(5)])).unwrap().as_int(), Some(120));
+        let table = eval(src, call("squares", vec![])).unwrap();
+        assert_eq!(table, Value::Array([0, 1, 4, 9].map(Value::int).to_vec()));
+        assert!(eval(src, call("forever", vec![])).unwrap_err().contains("steps"));
+        assert!(eval(src, call("uses_runtime", vec![])).is_err());
+    }
+}
@@ -13,7 +13,14 @@ use crate::frontend::ast::{
     StructField, UnaryOp, SwitchCase,
 };
 use crate::frontend::types::Type;
-
+use crate::lower::constexpr::{declarator_type, is_constexpr, ConstEval, Value};
+use crate::lower::elision::{constructors, ctor_kind, moved_operand, named_return, Ctor, CtorKind};
+use crate::lower::hierarchy::{class_info, unstable_locals, ClassHierarchy, Dispatch};
+use crate::lower::templates::{instance_symbol, InstanceKind, Instance, InstantiationTable, LoweredInstance, SharedInstances};
+use adeb_core::cache::hasher::hash_bytes;
+
+use std::cell::RefCell;
+use std::collections::{HashMap, HashSet};
 use std::sync::atomic::{AtomicU64, Ordering};
 
 static TEMP_COUNTER: AtomicU64 = AtomicU64::new(0);
@@ -27,28 +34,112 @@ pub struct CppToIR {
     ns: Vec<String>,
     current_class: Option<String>,
     enum_constants: Vec<(String, i64)>,
-    /// Track virtual methods per class for vtable generation
-    vtables: Vec<VTableInfo>,
+    /// Polymorphic classes lowered so far: each gets a vtable in pass 3
+    vtables: Vec<String>,
+    /// Bases, finality and methods of every class, for devirtualization
+    hierarchy: ClassHierarchy,
+    /// Pointer locals whose dynamic class is known (initialized with
+    /// `new D` or `&d` and never changed); the newest entry per name wins
+    exact_types: Vec<(String, Option<String>)>,
+    /// Locals of the current function that may change after their
+    /// declaration, see `unstable_locals`
+    unstable: HashSet<String>,
     /// Track template function definitions for monomorphization
     template_defs: Vec<TemplateFuncDef>,
-    /// Track template instantiations requested
-    template_uses: Vec<(String, Vec<CppType>)>,
+    /// Class templates, instantiated per argument list like functions
+    class_templates: Vec<ClassTemplateDef>,
+    /// Explicit specializations by canonical symbol (`max<int>`)
+    func_specializations: Vec<(String, TemplateFuncDef)>,
+    class_specializations: Vec<(String, ClassTemplateDef)>,
+    /// Non-template functions: a call to one of these is never deduced
+    plain_functions: Vec<String>,
+    /// (template, args) → symbol, each lowered once. Expressions lower
+    /// through &self, hence the RefCell.
+    instances: RefCell<InstantiationTable>,
+    /// Instantiations shared with the other TUs of a multi-file build
+    shared: Option<SharedInstances>,
+    /// Template parameters bound while lowering an instantiation
+    type_bindings: Vec<(String, CppType)>,
+    /// Declared types of the current function's parameters and locals,
+    /// for template argument deduction
+    var_types: Vec<(String, CppType)>,
     /// Type aliases: using/typedef name → resolved type
     type_aliases: Vec<(String, CppType)>,
+    /// Variables holding a std::future (handles into the backend task pool)
+    futures: Vec<String>,
+    /// Functions taking their first parameter by value: for_each hands
+    /// them the element instead of its address
+    by_value_callbacks: Vec<String>,
+    /// Integer-keyed std containers and the backend runtime behind them:
+    /// "adb_hash" (unordered_map/set) or "adb_tree" (map/set)
+    containers: Vec<(String, &'static str)>,
+    /// Variables holding a container find() result (a value pointer)
+    value_iters: Vec<String>,
+    /// std::mutex / condition_variable / atomic objects (one zeroed word
+    /// each, see the backend's sync.rs) and lock guards (a mutex address)
+    sync_objects: Vec<(String, SyncKind)>,
+    /// Lock guards alive per enclosing scope, released on every way out
+    lock_scopes: Vec<LockScope>,
+    /// Return type of the function being lowered
+    return_type: Type,
+    /// Constexpr functions and the values of constant globals
+    consteval: ConstEval,
+    /// Constexpr locals of the current function and their values
+    const_locals: Vec<(String, Value)>,
+    /// Constructors with a body, per class
+    ctors: HashMap<String, Vec<Ctor>>,
+    /// Fields of every class lowered so far, as emitted in its struct
+    class_fields: HashMap<String, Vec<StructField>>,
+    /// Functions returning a class by value → (position of the hidden
+    /// `__sret` argument, class); see elision.rs
+    sret: HashMap<String, (usize, String)>,
+    /// Class the current function builds in `*__sret`
+    sret_class: Option<String>,
+    /// Its NRVO local, which lives in `*__sret`
+    nrvo: Option<String>,
+    /// Temporaries holding by-value results used as expressions, declared
+    /// at the top of the current function
+    temps: RefCell<Vec<(String, String)>>,
 }
 
-/// Vtable entry: one virtual method slot
-#[derive(Debug, Clone)]
-struct VTableSlot {
-    method_name: String,
-    mangled_name: String,
+/// How an object is initialized, see `classify_init`
+#[derive(Debug, Clone, Copy)]
+enum Init<'a> {
+    Default,
+    /// Constructor arguments
+    Args(&'a [CppExpr]),
+    /// From an lvalue of the same class
+    Copy(&'a CppExpr),
+    /// From an xvalue: `std::move(x)`, or a local being returned
+    Move(&'a CppExpr),
+    /// Any other value: a by-value result is built in place, the rest stored
+    Value(&'a CppExpr),
+}
+
+#[derive(Debug, Clone, Copy, PartialEq)]
+enum SyncKind {
+    Mutex,
+    CondVar,
+    Atomic,
+    /// lock_guard / scoped_lock: locked for the whole scope
+    Guard,
+    /// unique_lock: may be unlocked early, tracked by an owns flag
+    UniqueLock,
+}
+
+#[derive(Debug, Clone, Copy, PartialEq)]
+enum ScopeKind {
+    Block,
+    /// Loop body: the target of break and continue
+    Loop,
+    /// Switch: the target of break
+    Switch,
 }
 
-/// Per-class vtable info
 #[derive(Debug, Clone)]
-struct VTableInfo {
-    class_name: String,
-    slots: Vec<VTableSlot>,
+struct LockScope {
+    kind: ScopeKind,
+    guards: Vec<(String, SyncKind)>,
 }
 
 /// Stored template function definition for monomorphization
@@ -59,6 +150,23 @@ struct TemplateFuncDef {
     return_type: CppType,
     params: Vec<CppParam>,
     body: Vec<CppStmt>,
+    /// Hash of the whole definition: part of every instance key
+    fingerprint: u64,
+}
+
+/// Stored class template (or explicit class specialization)
+#[derive(Debug, Clone)]
+struct ClassTemplateDef {
+    name: String,
+    template_params: Vec<CppTemplateParam>,
+    bases: Vec<CppBaseClass>,
+    members: Vec<CppClassMember>,
+    is_struct: bool,
+    fingerprint: u64,
+}
+
+fn fingerprint(decl: &CppTopLevel) -> u64 {
+    hash_bytes(format!("{:?}", decl).as_bytes())
 }
 
 impl CppToIR {
@@ -68,12 +176,56 @@ impl CppToIR {
             current_class: None,
             enum_constants: Vec::new(),
             vtables: Vec::new(),
+            hierarchy: ClassHierarchy::new(true),
+            exact_types: Vec::new(),
+            unstable: HashSet::new(),
             template_defs: Vec::new(),
-            template_uses: Vec::new(),
+            class_templates: Vec::new(),
+            func_specializations: Vec::new(),
+            class_specializations: Vec::new(),
+            plain_functions: Vec::new(),
+            instances: RefCell::new(InstantiationTable::new()),
+            shared: None,
+            type_bindings: Vec::new(),
+            var_types: Vec::new(),
             type_aliases: Vec::new(),
+            futures: Vec::new(),
+            by_value_callbacks: Vec::new(),
+            containers: Vec::new(),
+            value_iters: Vec::new(),
+            sync_objects: Vec::new(),
+            lock_scopes: Vec::new(),
+            return_type: Type::Void,
+            consteval: ConstEval::new(),
+            const_locals: Vec::new(),
+            ctors: HashMap::new(),
+            class_fields: HashMap::new(),
+            sret: HashMap::new(),
+            sret_class: None,
+            nrvo: None,
+            temps: RefCell::new(Vec::new()),
         }
     }
 
+    /// Share lowered template instantiations with the other TUs of a build
+    pub fn with_shared_instances(mut self, shared: SharedInstances) -> Self {
+        self.shared = Some(shared);
+        self
+    }
+
+    /// Whether this TU sees every subclass of its classes. A TU of a
+    /// multi-file build does not: a call with one implementation here may
+    /// reach an override another TU defines.
+    pub fn with_closed_hierarchy(mut self, closed: bool) -> Self {
+        self.hierarchy.set_closed(closed);
+        self
+    }
+
+    /// Distinct template instantiations this TU requested
+    pub fn instance_count(&self) -> usize {
+        self.instances.borrow().len()
+    }
+
     fn mangled(&self, name: &str) -> String {
         if self.ns.is_empty() { name.to_string() }
         else { format!("{}::{}", self.ns.join("::"), name) }
@@ -83,19 +235,23 @@ impl CppToIR {
         let mut prog = Program::new();
         prog.attributes = ProgramAttributes::default();
 
-        // Pass 1: collect enums, typedefs, type aliases, template definitions
+        // Pass 1: collect enums, typedefs, type aliases, template definitions,
+        // constexpr functions and the class hierarchy
+        self.collect_classes(&unit.declarations);
+        self.collect_constexpr(&unit.declarations);
         for d in &unit.declarations {
             match d {
                 CppTopLevel::EnumDef { values, .. } => {
                     let mut val = 0i64;
                     for (name, expr) in values {
-                        if let Some(CppExpr::IntLiteral(v)) = expr { val = *v; }
+                        if let Some(v) = expr.as_ref().and_then(|e| self.try_eval_int(e)) { val = v; }
                         self.enum_constants.push((name.clone(), val));
                         val += 1;
                     }
                 }
                 CppTopLevel::TypeAlias { new_name, original, .. } => {
                     self.type_aliases.push((new_name.clone(), original.clone()));
+                    self.consteval.define_alias(new_name, original);
                 }
                 CppTopLevel::FunctionDef { name, template_params, return_type, params, body, .. }
                     if !template_params.is_empty() =>
@@ -106,55 +262,196 @@ impl CppToIR {
                         return_type: return_type.clone(),
                         params: params.clone(),
                         body: body.clone(),
+                        fingerprint: fingerprint(d),
+                    });
+                }
+                CppTopLevel::ClassDef { name, template_params, bases, members, is_struct, .. }
+                    if !template_params.is_empty() =>
+                {
+                    self.class_templates.push(ClassTemplateDef {
+                        name: name.clone(),
+                        template_params: template_params.clone(),
+                        bases: bases.clone(),
+                        members: members.clone(),
+                        is_struct: *is_struct,
+                        fingerprint: fingerprint(d),
                     });
                 }
+                CppTopLevel::TemplateFuncSpecialization { name, specialized_args, return_type, params, body, .. } => {
+                    let symbol = instance_symbol(name, specialized_args);
+                    self.func_specializations.push((symbol, TemplateFuncDef {
+                        name: name.clone(),
+                        template_params: Vec::new(),
+                        return_type: return_type.clone(),
+                        params: params.clone(),
+                        body: body.clone(),
+                        fingerprint: fingerprint(d),
+                    }));
+                }
+                // Full specializations only; partial ones fall back to the primary
+                CppTopLevel::TemplateSpecialization { name, specialized_args, template_params, members, is_struct }
+                    if template_params.is_empty() =>
+                {
+                    let symbol = instance_symbol(name, specialized_args);
+                    self.class_specializations.push((symbol, ClassTemplateDef {
+                        name: name.clone(),
+                        template_params: Vec::new(),
+                        bases: Vec::new(),
+                        members: members.clone(),
+                        is_struct: *is_struct,
+                        fingerprint: fingerprint(d),
+                    }));
+                }
+                CppTopLevel::FunctionDef { name, params, .. } => {
+                    self.plain_functions.push(name.clone());
+                    if params.first().map_or(false, |p| {
+                        !matches!(p.param_type, CppType::Reference(_) | CppType::RValueRef(_) | CppType::Pointer(_))
+                    }) {
+                        self.by_value_callbacks.push(name.clone());
+                    }
+                }
                 _ => {}
             }
         }
+        self.collect_sret(&unit.declarations);
 
         // Pass 2: everything else
         for d in &unit.declarations {
             self.convert_top_level(d, &mut prog)?;
         }
 
-        // Pass 3: emit vtable structs for classes with virtual methods
-        for vt in &self.vtables {
-            let mut vtable_fields = Vec::new();
-            for slot in &vt.slots {
-                vtable_fields.push(StructField {
-                    name: slot.method_name.clone(),
-                    field_type: Type::Pointer(Box::new(Type::Void)),
-                    bit_width: None,
-                });
-            }
+        // Pass 2b: the template instantiations pass 2 asked for
+        self.lower_instances(&mut prog)?;
+
+        // Pass 3: one vtable per polymorphic class — its layout as a struct
+        // and the table itself as a global array of code pointers (0 for
+        // pure virtuals), where the backend points every object's vptr
+        for class in &self.vtables {
+            let slot_type = Type::Pointer(Box::new(Type::Void));
+            let name = format!("__vtable_{}", class);
+            let vtable_fields = self.hierarchy.slots(class).into_iter().map(|m| StructField {
+                name: m,
+                field_type: slot_type.clone(),
+                bit_width: None,
+            });
             prog.structs.push(Struct {
-                name: format!("__vtable_{}", vt.class_name),
-                fields: vtable_fields,
+                name: name.clone(),
+                fields: vtable_fields.collect(),
                 is_packed: false,
                 is_union: false,
             });
+            let entries: Vec<Expr> = self.hierarchy.vtable(class).into_iter()
+                .map(|m| m.map_or(Expr::Number(0), Expr::Variable))
+                .collect();
+            prog.statements.push(Stmt::VarDecl {
+                var_type: Type::Array(Box::new(slot_type), Some(entries.len())),
+                name,
+                value: Some(Expr::Array(entries)),
+            });
         }
 
         Ok(prog)
     }
 
+    /// Non-template constexpr functions, for the compile-time evaluator
+    fn collect_constexpr(&mut self, decls: &[CppTopLevel]) {
+        for d in decls {
+            match d {
+                CppTopLevel::FunctionDef { name, template_params, return_type, params, qualifiers, body }
+                    if template_params.is_empty() && (qualifiers.is_constexpr || is_constexpr(return_type)) =>
+                {
+                    let symbol = self.mangled(name);
+                    self.consteval.define_function(&symbol, &self.ns, return_type, params, body);
+                }
+                CppTopLevel::Namespace { name, declarations } => {
+                    self.ns.push(name.clone());
+                    self.collect_constexpr(declarations);
+                    self.ns.pop();
+                }
+                CppTopLevel::ExternC { declarations } => self.collect_constexpr(declarations),
+                _ => {}
+            }
+        }
+    }
+
+    /// Every non-template class, nested ones and those in namespaces too
+    fn collect_classes(&mut self, decls: &[CppTopLevel]) {
+        for d in decls {
+            match d {
+                CppTopLevel::ClassDef { name, template_params, bases, members, is_final, .. }
+                    if template_params.is_empty() =>
+                {
+                    self.hierarchy.add(class_info(name, bases, members, *is_final, Self::mangle_operator));
+                    self.ctors.insert(name.clone(), constructors(name, members));
+                    for m in members {
+                        if let CppClassMember::NestedClass(inner) = m {
+                            self.collect_classes(std::slice::from_ref(inner.as_ref()));
+                        }
+                    }
+                }
+                CppTopLevel::Namespace { declarations, .. } | CppTopLevel::ExternC { declarations } => {
+                    self.collect_classes(declarations);
+                }
+                _ => {}
+            }
+        }
+    }
+
+    /// Non-template functions and non-virtual methods returning a class by
+    /// value: they get the caller's slot as a hidden argument
+    fn collect_sret(&mut self, decls: &[CppTopLevel]) {
+        for d in decls {
+            match d {
+                CppTopLevel::FunctionDef { name, template_params, return_type, .. } if template_params.is_empty() => {
+                    if let Some(class) = self.by_value_class(return_type) {
+                        self.sret.insert(self.mangled(name), (0, class));
+                    }
+                }
+                CppTopLevel::FunctionDecl { name, return_type, .. } => {
+                    if let Some(class) = self.by_value_class(return_type) {
+                        self.sret.insert(self.mangled(name), (0, class));
+                    }
+                }
+                CppTopLevel::ClassDef { name, template_params, members, .. } if template_params.is_empty() => {
+                    for m in members {
+                        match m {
+                            CppClassMember::Method { return_type, name: mname, qualifiers, .. } => {
+                                let method = Self::mangle_operator(mname);
+                                if self.hierarchy.is_virtual(name, &method) {
+                                    continue;
+                                }
+                                if let Some(class) = self.by_value_class(return_type) {
+                                    let at = if qualifiers.is_static { 0 } else { 1 };
+                                    self.sret.insert(format!("{}::{}", name, method), (at, class));
+                                }
+                            }
+                            CppClassMember::NestedClass(inner) => self.collect_sret(std::slice::from_ref(inner.as_ref())),
+                            _ => {}
+                        }
+                    }
+                }
+                CppTopLevel::Namespace { name, declarations } => {
+                    self.ns.push(name.clone());
+                    self.collect_sret(declarations);
+                    self.ns.pop();
+                }
+                CppTopLevel::ExternC { declarations } => self.collect_sret(declarations),
+                _ => {}
+            }
+        }
+    }
+
     fn convert_top_level(&mut self, decl: &CppTopLevel, prog: &mut Program) -> Result<(), String> {
         match decl {
             // Skip template functions — they're stored for monomorphization
             CppTopLevel::FunctionDef { template_params, .. } if !template_params.is_empty() => {}
             CppTopLevel::FunctionDef { return_type, name, params, body, .. } => {
                 let fname = self.mangled(name);
-                let ir_params: Vec<Param> = params.iter().map(|p| self.convert_param(p)).collect();
-                let ir_body = self.convert_stmts(body)?;
-                prog.functions.push(Function {
-                    name: fname,
-                    params: ir_params,
-                    return_type: Some(self.type_name(return_type)),
-                    resolved_return_type: self.convert_type(return_type),
-                    body: ir_body,
-                    attributes: FunctionAttributes::default(),
-                });
+                let func = self.lower_function(fname, return_type, params, body)?;
+                prog.functions.push(func);
             }
+            // Class templates are lowered per instantiation
+            CppTopLevel::ClassDef { template_params, .. } if !template_params.is_empty() => {}
             CppTopLevel::ClassDef { name, bases, members, is_struct, .. } => {
                 self.convert_class(name, bases, members, *is_struct, prog)?;
             }
@@ -165,6 +462,14 @@ impl CppToIR {
             }
             CppTopLevel::GlobalVar { type_spec, declarators } => {
                 for d in declarators {
+                    if let Some(kind) = Self::sync_kind(type_spec).filter(|k| Self::is_sync_object(*k)) {
+                        prog.statements.push(self.declare_sync_object(&d.name, kind, d.initializer.as_ref()));
+                        continue;
+                    }
+                    if let Some(decl) = self.materialize(type_spec, d) {
+                        prog.statements.push(decl);
+                        continue;
+                    }
                     let val = d.initializer.as_ref().map(|e| self.convert_expr(e));
                     prog.statements.push(Stmt::VarDecl {
                         var_type: self.convert_type(type_spec),
@@ -179,20 +484,37 @@ impl CppToIR {
             CppTopLevel::FunctionDecl { name, params, return_type, .. } => {
                 // Forward declaration: emit function with empty body
                 let fname = self.mangled(name);
-                let ir_params: Vec<Param> = params.iter().map(|p| self.convert_param(p)).collect();
+                let sret = self.sret.get(&fname).map(|(_, class)| class.clone());
+                let mut ir_params: Vec<Param> = sret.iter().map(|c| Self::sret_param(c)).collect();
+                ir_params.extend(params.iter().map(|p| self.convert_param(p)));
+                let (type_name, resolved) = match &sret {
+                    Some(class) => (format!("{}*", class), Self::sret_type(class)),
+                    None => (self.type_name(return_type), self.convert_type(return_type)),
+                };
                 prog.functions.push(Function {
                     name: fname,
                     params: ir_params,
-                    return_type: Some(self.type_name(return_type)),
-                    resolved_return_type: self.convert_type(return_type),
+                    return_type: Some(type_name),
+                    resolved_return_type: resolved,
                     body: Vec::new(),
                     attributes: FunctionAttributes::default(),
                 });
             }
             CppTopLevel::EnumDef { .. } | CppTopLevel::TypeAlias { .. } => { /* handled in pass 1 */ }
+            // template class Box<int>; → queue the instantiation
+            CppTopLevel::TemplateInstantiation { type_name } => {
+                self.convert_type(type_name);
+            }
+            // Conditions the evaluator cannot decide are let through
+            CppTopLevel::StaticAssert { condition, message } => {
+                if self.try_eval_constexpr(condition) == Some(false) {
+                    return Err(match message {
+                        Some(m) => format!("static_assert failed: {}", m),
+                        None => "static_assert failed".to_string(),
+                    });
+                }
+            }
             CppTopLevel::UsingDecl { .. } | CppTopLevel::UsingNamespace(_)
-            | CppTopLevel::StaticAssert { .. }
-            | CppTopLevel::TemplateInstantiation { .. }
             | CppTopLevel::TemplateSpecialization { .. }
             | CppTopLevel::TemplateFuncSpecialization { .. } => {}
         }
@@ -204,15 +526,14 @@ impl CppToIR {
         members: &[CppClassMember], _is_struct: bool, prog: &mut Program
     ) -> Result<(), String> {
         let mut fields = Vec::new();
-        let mut vtable_slots: Vec<VTableSlot> = Vec::new();
-        let has_virtual = members.iter().any(|m| match m {
-            CppClassMember::Method { qualifiers, .. } => qualifiers.is_virtual || qualifiers.is_pure_virtual,
-            CppClassMember::Destructor { is_virtual, .. } => *is_virtual,
-            _ => false,
-        });
+        // Template instances are only known once instantiated
+        if !self.hierarchy.contains(name) {
+            self.hierarchy.add(class_info(name, bases, members, false, Self::mangle_operator));
+        }
+        self.ctors.entry(name.to_string()).or_insert_with(|| constructors(name, members));
 
-        // If class has virtual methods, add __vptr field
-        if has_virtual {
+        // Polymorphic: one __vptr at offset 0, shared with the primary base
+        if self.hierarchy.owns_vptr(name) {
             fields.push(StructField {
                 name: "__vptr".into(),
                 field_type: Type::Pointer(Box::new(Type::Void)),
@@ -229,54 +550,37 @@ impl CppToIR {
             });
         }
 
+        for m in members {
+            if let CppClassMember::Field { type_spec, name: fname, .. } = m {
+                fields.push(StructField {
+                    name: fname.clone(),
+                    field_type: self.convert_type(type_spec),
+                    bit_width: None,
+                });
+            }
+        }
+        // Known before the methods: their copies need the object size
+        self.class_fields.insert(name.to_string(), fields.clone());
+
         let old_class = self.current_class.take();
         self.current_class = Some(name.to_string());
 
         for m in members {
             match m {
-                CppClassMember::Field { type_spec, name: fname, .. } => {
-                    fields.push(StructField {
-                        name: fname.clone(),
-                        field_type: self.convert_type(type_spec),
-                        bit_width: None,
-                    });
-                }
-                CppClassMember::Method { return_type, name: mname, params, qualifiers, body, .. } => {
+                CppClassMember::Method { return_type, name: mname, params, qualifiers, body: Some(body), .. } => {
                     // Phase 3: operator overload → mangled name
                     let method_name = Self::mangle_operator(mname);
                     let fname = format!("{}::{}", name, method_name);
 
-                    // Phase 3: track virtual methods for vtable
-                    if qualifiers.is_virtual || qualifiers.is_override || qualifiers.is_pure_virtual {
-                        vtable_slots.push(VTableSlot {
-                            method_name: method_name.clone(),
-                            mangled_name: fname.clone(),
-                        });
-                    }
-
                     // Static methods don't get `this` parameter
-                    let mut ir_params = if qualifiers.is_static {
-                        Vec::new()
-                    } else {
-                        vec![Param::typed("this".into(),
-                            Type::Pointer(Box::new(Type::Struct(name.to_string()))))]
-                    };
-                    ir_params.extend(params.iter().map(|p| self.convert_param(p)));
-
-                    if let Some(body) = body {
-                        let ir_body = self.convert_stmts(body)?;
-                        prog.functions.push(Function {
-                            name: fname,
-                            params: ir_params,
-                            return_type: Some(self.type_name(return_type)),
-                            resolved_return_type: self.convert_type(return_type),
-                            body: ir_body,
-                            attributes: FunctionAttributes::default(),
-                        });
-                    }
+                    let this = (!qualifiers.is_static).then(|| Param::typed("this".into(),
+                        Type::Pointer(Box::new(Type::Struct(name.to_string())))));
+                    let func = self.lower_callable(fname, this, return_type, params, body)?;
+                    prog.functions.push(func);
                 }
                 CppClassMember::Constructor { params, body: Some(body), initializer_list, .. } => {
-                    let fname = format!("{}::__init", name);
+                    // S(const S&) → S::__copy, S(S&&) → S::__move, the rest S::__init
+                    let fname = ctor_kind(name, params).symbol(name);
                     let mut ir_params = vec![Param::typed("this".into(),
                         Type::Pointer(Box::new(Type::Struct(name.to_string()))))];
                     ir_params.extend(params.iter().map(|p| self.convert_param(p)));
@@ -298,12 +602,13 @@ impl CppToIR {
                         params: ir_params,
                         return_type: None,
                         resolved_return_type: Type::Void,
-                        body: init_stmts,
+                        body: self.with_temps(init_stmts),
                         attributes: FunctionAttributes::default(),
                     });
                 }
                 CppClassMember::Destructor { body: Some(body), .. } => {
                     let fname = format!("{}::__destroy", name);
+                    let body = self.convert_stmts(body)?;
                     let ir_params = vec![Param::typed("this".into(),
                         Type::Pointer(Box::new(Type::Struct(name.to_string()))))];
                     prog.functions.push(Function {
@@ -311,7 +616,7 @@ impl CppToIR {
                         params: ir_params,
                         return_type: None,
                         resolved_return_type: Type::Void,
-                        body: self.convert_stmts(body)?,
+                        body: self.with_temps(body),
                         attributes: FunctionAttributes::default(),
                     });
                 }
@@ -336,12 +641,8 @@ impl CppToIR {
         // Emit class struct
         prog.structs.push(Struct { name: name.to_string(), fields, is_packed: false, is_union: false });
 
-        // Phase 3: store vtable info if this class has virtual methods
-        if !vtable_slots.is_empty() {
-            self.vtables.push(VTableInfo {
-                class_name: name.to_string(),
-                slots: vtable_slots,
-            });
+        if self.hierarchy.is_polymorphic(name) {
+            self.vtables.push(name.to_string());
         }
 
         self.current_class = old_class;
@@ -384,16 +685,503 @@ impl CppToIR {
         }
     }
 
+    fn lower_function(&mut self, name: String, return_type: &CppType, params: &[CppParam], body: &[CppStmt]) -> Result<Function, String> {
+        self.lower_callable(name, None, return_type, params, body)
+    }
+
+    /// A function, or a method with its `this`. One returning a class by
+    /// value takes the caller's slot after `this` and returns it.
+    fn lower_callable(&mut self, name: String, this: Option<Param>, return_type: &CppType,
+        params: &[CppParam], body: &[CppStmt],
+    ) -> Result<Function, String> {
+        let sret = self.sret.get(&name).map(|(_, class)| class.clone());
+        let mut ir_params: Vec<Param> = this.into_iter().collect();
+        ir_params.extend(sret.iter().map(|c| Self::sret_param(c)));
+        ir_params.extend(params.iter().map(|p| self.convert_param(p)));
+        self.enter_function(params, body);
+        let type_name = match &sret {
+            Some(class) => {
+                self.return_type = Self::sret_type(class);
+                self.var_types.push(("__sret".into(), CppType::Pointer(Box::new(CppType::Named(class.clone())))));
+                self.nrvo = named_return(params, body)
+                    .filter(|(_, t)| self.by_value_class(t).as_ref() == Some(class))
+                    .map(|(n, _)| n.to_string());
+                format!("{}*", class)
+            }
+            None => {
+                self.return_type = self.convert_type(return_type);
+                self.type_name(return_type)
+            }
+        };
+        self.sret_class = sret;
+        let lowered = self.convert_stmts(body);
+        self.sret_class = None;
+        self.nrvo = None;
+        Ok(Function {
+            name,
+            params: ir_params,
+            return_type: Some(type_name),
+            resolved_return_type: self.return_type.clone(),
+            body: self.with_temps(lowered?),
+            attributes: FunctionAttributes::default(),
+        })
+    }
+
+    fn sret_param(class: &str) -> Param {
+        Param::typed("__sret".into(), Self::sret_type(class))
+    }
+
+    fn sret_type(class: &str) -> Type {
+        Type::Pointer(Box::new(Type::Struct(class.to_string())))
+    }
+
+    /// `body` after the declarations of the result temporaries it uses
+    fn with_temps(&self, body: Vec<Stmt>) -> Vec<Stmt> {
+        let temps = std::mem::take(&mut *self.temps.borrow_mut());
+        temps
+            .into_iter()
+            .map(|(name, class)| Stmt::VarDecl { var_type: Type::Struct(class), name, value: None })
+            .chain(body)
+            .collect()
+    }
+
+    /// Parameter types become the first deducible locals
+    fn enter_function(&mut self, params: &[CppParam], body: &[CppStmt]) {
+        self.var_types = params
+            .iter()
+            .filter_map(|p| Some((p.name.clone()?, self.resolve_type(&p.param_type))))
+            .collect();
+        self.exact_types.clear();
+        self.const_locals.clear();
+        self.temps.borrow_mut().clear();
+        self.unstable = unstable_locals(params, body);
+    }
+
+    // ── Templates ───────────────────────────────────────────
+
+    /// Bound template parameter, while lowering an instantiation
+    fn binding(&self, name: &str) -> Option<&CppType> {
+        self.type_bindings
+            .iter()
+            .rev()
+            .find(|(n, t)| n == name && !matches!(t, CppType::Named(b) if b == name))
+            .map(|(_, t)| t)
+    }
+
+    /// Substitutes bound parameters and expands type aliases, so that
+    /// `T` under T=int and `typedef int I; I` both spell `int`
+    fn resolve_type(&self, ty: &CppType) -> CppType {
+        let boxed = |t: &CppType| Box::new(self.resolve_type(t));
+        match ty {
+            CppType::Named(n) | CppType::Typedef(n) => {
+                if let Some(bound) = self.binding(n) {
+                    return self.resolve_type(bound);
+                }
+                match self.type_aliases.iter().rev().find(|(a, _)| a == n) {
+                    Some((_, original)) if !matches!(original, CppType::Named(o) if o == n) => self.resolve_type(original),
+                    _ => ty.clone(),
+                }
+            }
+            CppType::Const(t) => CppType::Const(boxed(t)),
+            CppType::Volatile(t) => CppType::Volatile(boxed(t)),
+            CppType::Unsigned(t) => CppType::Unsigned(boxed(t)),
+            CppType::Signed(t) => CppType::Signed(boxed(t)),
+            CppType::Pointer(t) => CppType::Pointer(boxed(t)),
+            CppType::Reference(t) => CppType::Reference(boxed(t)),
+            CppType::RValueRef(t) => CppType::RValueRef(boxed(t)),
+            CppType::Array(t, n) => CppType::Array(boxed(t), *n),
+            CppType::TemplateType { name, args } => CppType::TemplateType {
+                name: name.clone(),
+                args: args.iter().map(|a| self.resolve_type(a)).collect(),
+            },
+            _ => ty.clone(),
+        }
+    }
+
+    /// Fills defaulted parameters; variadic and template-template
+    /// parameters are not instantiated
+    fn complete_args(&self, params: &[CppTemplateParam], explicit: &[CppType]) -> Option<Vec<CppType>> {
+        let mut args: Vec<CppType> = explicit.iter().map(|a| self.resolve_type(a)).collect();
+        if args.len() > params.len() {
+            return None;
+        }
+        for param in &params[args.len()..] {
+            args.push(match param {
+                CppTemplateParam::TypeParam { default_type: Some(t), .. } => self.resolve_type(t),
+                CppTemplateParam::NonTypeParam { default_value: Some(v), .. } => {
+                    CppType::Named(self.try_eval_int(v)?.to_string())
+                }
+                _ => return None,
+            });
+        }
+        Some(args)
+    }
+
+    /// Symbol of a function template instantiation, queued for lowering.
+    /// Explicit arguments first; the rest are deduced from the call.
+    fn template_call(&self, name: &str, explicit: &[CppType], call_args: &[CppExpr]) -> Option<String> {
+        let explicit: Vec<CppType> = explicit.iter().map(|a| self.resolve_type(a)).collect();
+        let symbol = instance_symbol(name, &explicit);
+        if let Some((_, def)) = self.func_specializations.iter().find(|(s, _)| *s == symbol) {
+            return Some(self.instances.borrow_mut().request(InstanceKind::Function, name, &explicit, def.fingerprint));
+        }
+        let def = self.template_defs.iter().find(|d| d.name == name)?;
+        let args = self.deduce_args(def, &explicit, call_args)?;
+        Some(self.instances.borrow_mut().request(InstanceKind::Function, name, &args, def.fingerprint))
+    }
+
+    /// `Box<int>` → symbol of the class instantiation, queued for lowering
+    fn template_class(&self, name: &str, args: &[CppType]) -> Option<String> {
+        let args: Vec<CppType> = args.iter().map(|a| self.resolve_type(a)).collect();
+        let symbol = instance_symbol(name, &args);
+        if let Some((_, def)) = self.class_specializations.iter().find(|(s, _)| *s == symbol) {
+            return Some(self.instances.borrow_mut().request(InstanceKind::Class, name, &args, def.fingerprint));
+        }
+        let def = self.class_templates.iter().find(|d| d.name == name)?;
+        let args = self.complete_args(&def.template_params, &args)?;
+        Some(self.instances.borrow_mut().request(InstanceKind::Class, name, &args, def.fingerprint))
+    }
+
+    /// Template argument deduction from the call's argument types
+    fn deduce_args(&self, def: &TemplateFuncDef, explicit: &[CppType], call_args: &[CppExpr]) -> Option<Vec<CppType>> {
+        let mut bound: Vec<(String, CppType)> = def
+            .template_params
+            .iter()
+            .zip(explicit)
+            .filter_map(|(p, a)| match p {
+                CppTemplateParam::TypeParam { name, .. } | CppTemplateParam::NonTypeParam { name, .. } => {
+                    Some((name.clone(), self.resolve_type(a)))
+                }
+                _ => None,
+            })
+            .collect();
+        for (param, arg) in def.params.iter().zip(call_args) {
+            if let Some(actual) = self.expr_type(arg) {
+                Self::deduce(&def.template_params, &param.param_type, &actual, &mut bound)?;
+            }
+        }
+        def.template_params
+            .iter()
+            .map(|p| match p {
+                CppTemplateParam::TypeParam { name, default_type } => bound
+                    .iter()
+                    .find(|(n, _)| n == name)
+                    .map(|(_, t)| t.clone())
+                    .or_else(|| default_type.as_ref().map(|t| self.resolve_type(t))),
+                CppTemplateParam::NonTypeParam { name, default_value, .. } => bound
+                    .iter()
+                    .find(|(n, _)| n == name)
+                    .map(|(_, t)| t.clone())
+                    .or_else(|| Some(CppType::Named(self.try_eval_int(default_value.as_ref()?)?.to_string()))),
+                _ => None,
+            })
+            .collect()
+    }
+
+    /// Matches one parameter type against an argument type, binding the
+    /// template parameters it mentions. `None` on conflicting bindings.
+    fn deduce(params: &[CppTemplateParam], param: &CppType, arg: &CppType, bound: &mut Vec<(String, CppType)>) -> Option<()> {
+        // By value and const T& drop the argument's top-level const and
+        // reference; T& keeps the const (T = const int)
+        let (param, arg) = match param {
+            CppType::Reference(inner) if !matches!(inner.as_ref(), CppType::Const(_)) => (inner.as_ref(), Self::strip_ref(arg)),
+            CppType::Reference(inner) | CppType::RValueRef(inner) => (inner.as_ref(), Self::decay(arg)),
+            _ => (param, Self::decay(arg)),
+        };
+        Self::deduce_inner(params, param, arg, bound)
+    }
+
+    fn deduce_inner(params: &[CppTemplateParam], param: &CppType, arg: &CppType, bound: &mut Vec<(String, CppType)>) -> Option<()> {
+        let is_param = |n: &str| params.iter().any(|p| matches!(p, CppTemplateParam::TypeParam { name, .. } if name == n));
+        match (param, arg) {
+            (CppType::Named(n), _) if is_param(n) => match bound.iter().find(|(b, _)| b == n) {
+                Some((_, t)) if t.spelling() != arg.spelling() => None,
+                Some(_) => Some(()),
+                None => {
+                    bound.push((n.clone(), arg.clone()));
+                    Some(())
+                }
+            },
+            (CppType::Const(p), CppType::Const(a)) | (CppType::Pointer(p), CppType::Pointer(a)) => {
+                Self::deduce_inner(params, p, a, bound)
+            }
+            (CppType::Const(p), a) => Self::deduce_inner(params, p, a, bound),
+            (CppType::TemplateType { name: pn, args: pa }, CppType::TemplateType { name: an, args: aa })
+                if pn == an && pa.len() == aa.len() =>
+            {
+                pa.iter().zip(aa).try_for_each(|(p, a)| Self::deduce_inner(params, p, a, bound))
+            }
+            // Non-dependent parameter: nothing to deduce
+            _ => Some(()),
+        }
+    }
+
+    fn strip_ref(t: &CppType) -> &CppType {
+        match t {
+            CppType::Reference(inner) | CppType::RValueRef(inner) => inner,
+            _ => t,
+        }
+    }
+
+    /// Top-level reference and cv dropped, as a by-value parameter sees it
+    fn decay(t: &CppType) -> &CppType {
+        match Self::strip_ref(t) {
+            CppType::Const(inner) | CppType::Volatile(inner) => Self::decay(inner),
+            other => other,
+        }
+    }
+
+    /// Static type of an expression, as far as deduction needs it
+    fn expr_type(&self, e: &CppExpr) -> Option<CppType> {
+        match e {
+            CppExpr::IntLiteral(_) => Some(CppType::Int),
+            CppExpr::UIntLiteral(_) => Some(CppType::Unsigned(Box::new(CppType::Int))),
+            CppExpr::FloatLiteral(_) => Some(CppType::Double),
+            CppExpr::CharLiteral(_) => Some(CppType::Char),
+            CppExpr::BoolLiteral(_) => Some(CppType::Bool),
+            CppExpr::StringLiteral(_) => Some(CppType::Pointer(Box::new(CppType::Const(Box::new(CppType::Char))))),
+            CppExpr::Identifier(n) => self.var_types.iter().rev().find(|(v, _)| v == n).map(|(_, t)| t.clone()),
+            CppExpr::Cast { target_type, .. } => Some(self.resolve_type(target_type)),
+            CppExpr::This => Some(CppType::Pointer(Box::new(CppType::Named(self.current_class.clone()?)))),
+            CppExpr::New { type_name, is_array: false, .. } => Some(CppType::Pointer(Box::new(self.resolve_type(type_name)))),
+            CppExpr::AddressOf(inner) => Some(CppType::Pointer(Box::new(Self::strip_ref(&self.expr_type(inner)?).clone()))),
+            CppExpr::Deref(inner) => match Self::decay(&self.expr_type(inner)?) {
+                CppType::Pointer(t) => Some(t.as_ref().clone()),
+                _ => None,
+            },
+            CppExpr::UnaryOp { op: CppUnaryOp::Not, .. } => Some(CppType::Bool),
+            CppExpr::UnaryOp { expr, .. } => self.expr_type(expr),
+            CppExpr::BinaryOp { op, left, right } => match op {
+                CppBinOp::Eq | CppBinOp::Ne | CppBinOp::Lt | CppBinOp::Le | CppBinOp::Gt | CppBinOp::Ge
+                | CppBinOp::And | CppBinOp::Or => Some(CppType::Bool),
+                _ => {
+                    let (l, r) = (self.expr_type(left)?, self.expr_type(right)?);
+                    (Self::decay(&l).spelling() == Self::decay(&r).spelling()).then(|| Self::decay(&l).clone())
+                }
+            },
+            CppExpr::Ternary { then_expr, else_expr, .. } => {
+                let (t, f) = (self.expr_type(then_expr)?, self.expr_type(else_expr)?);
+                (t.spelling() == f.spelling()).then_some(t)
+            }
+            _ => None,
+        }
+    }
+
+    // ── Devirtualization ────────────────────────────────────
+
+    /// Class named by a (possibly cv-qualified) type
+    fn class_of(&self, t: &CppType) -> Option<String> {
+        let name = match Self::decay(t) {
+            CppType::Named(n) | CppType::Struct(n) | CppType::Class(n) => n.clone(),
+            CppType::TemplateType { name, args } => self.template_class(name, args)?,
+            _ => return None,
+        };
+        self.hierarchy.contains(&name).then_some(name)
+    }
+
+    /// Class of an object held by value: not through a pointer or reference
+    fn by_value_class(&self, t: &CppType) -> Option<String> {
+        let t = self.resolve_type(t);
+        if matches!(Self::strip_cv(&t), CppType::Reference(_) | CppType::RValueRef(_)) {
+            return None;
+        }
+        self.class_of(&t)
+    }
+
+    /// Exact class of the object a pointer initializer points to:
+    /// `new D(...)` or `&d` with `d` a `D` object
+    fn pointee_class(&self, init: &CppExpr) -> Option<String> {
+        match init {
+            CppExpr::New { type_name, is_array: false, .. } => self.class_of(&self.resolve_type(type_name)),
+            CppExpr::AddressOf(inner) => self.object_class(inner),
+            _ => None,
+        }
+    }
+
+    /// Class of a local declared as an object (not a reference)
+    fn object_class(&self, e: &CppExpr) -> Option<String> {
+        match self.expr_type(e)? {
+            CppType::Reference(_) | CppType::RValueRef(_) => None,
+            t if matches!(e, CppExpr::Identifier(_)) => self.class_of(&t),
+            _ => None,
+        }
+    }
+
+    /// `object.member(args)` / `object->member(args)` on a known class:
+    /// a direct call when the hierarchy pins the implementation, a vtable
+    /// call otherwise. `None` leaves it to the backend's generic path.
+    fn member_call(&self, object: &CppExpr, via_pointer: bool, member: &str, ir_args: &[Expr]) -> Option<Expr> {
+        let method = Self::mangle_operator(member);
+        let static_type = self.expr_type(object)?;
+        let (class, exact, this) = if via_pointer {
+            let CppType::Pointer(pointee) = Self::decay(&static_type) else { return None };
+            let known = match object {
+                CppExpr::Identifier(v) => self.exact_types.iter().rev().find(|(n, _)| n == v).and_then(|(_, c)| c.clone()),
+                _ => None,
+            };
+            match known {
+                Some(class) => (class, true, self.convert_expr(object)),
+                None => (self.class_of(pointee)?, false, self.convert_expr(object)),
+            }
+        } else {
+            match &static_type {
+                CppType::Reference(inner) | CppType::RValueRef(inner) => {
+                    (self.class_of(inner)?, false, self.convert_expr(object))
+                }
+                t => {
+                    let class = self.class_of(t)?;
+                    let this = match object {
+                        CppExpr::Deref(ptr) => self.convert_expr(ptr),
+                        _ => self.object_address(object).unwrap_or_else(|| Self::address_of(self.convert_expr(object))),
+                    };
+                    (class, self.object_class(object).is_some(), this)
+                }
+            }
+        };
+        match self.hierarchy.dispatch(&class, &method, exact)? {
+            Dispatch::Direct(name) if self.hierarchy.is_static(&class, &method) => {
+                Some(Expr::Call { name, args: ir_args.to_vec() })
+            }
+            Dispatch::Direct(name) => {
+                let args = std::iter::once(this).chain(ir_args.iter().cloned()).collect();
+                Some(Expr::Call { name, args })
+            }
+            Dispatch::Slot(slot) => Some(Expr::VirtualCall { object: Box::new(this), slot, args: ir_args.to_vec() }),
+        }
+    }
+
+    /// Enums and aliases an instantiation's body was lowered under: only
+    /// TUs that agree on them may share its IR
+    fn context_hash(&self) -> u64 {
+        hash_bytes(format!("{:?}{:?}", self.enum_constants, self.type_aliases).as_bytes())
+    }
+
+    /// Lowers every queued instantiation. Lowering one body may queue more;
+    /// with a shared store, instantiations another TU lowered are reused.
+    fn lower_instances(&mut self, prog: &mut Program) -> Result<(), String> {
+        let context = self.context_hash();
+        loop {
+            let next = self.instances.borrow_mut().next_pending();
+            let inst = match next {
+                Some(inst) => inst,
+                None => break,
+            };
+            if let Some(reused) = self.shared.as_ref().and_then(|s| s.closure(inst.key ^ context)) {
+                let mut table = self.instances.borrow_mut();
+                for entry in reused {
+                    // Dependencies already requested here are lowered (or
+                    // reused) on their own turn
+                    if entry.key != inst.key && table.contains(entry.key) {
+                        continue;
+                    }
+                    table.mark_lowered(entry.key, &entry.symbol);
+                    prog.functions.extend(entry.functions);
+                    prog.structs.extend(entry.structs);
+                }
+                continue;
+            }
+            self.instances.borrow_mut().begin_recording();
+            let lowered = self.lower_instance(&inst);
+            let requires = self.instances.borrow_mut().end_recording();
+            let mut scratch = lowered?;
+            for func in &mut scratch.functions {
+                func.attributes.foldable = true;
+            }
+            if let Some(shared) = &self.shared {
+                shared.insert(inst.key ^ context, LoweredInstance {
+                    key: inst.key,
+                    kind: inst.kind,
+                    symbol: inst.symbol.clone(),
+                    functions: scratch.functions.clone(),
+                    structs: scratch.structs.clone(),
+                    requires: requires.iter().map(|k| k ^ context).collect(),
+                });
+            }
+            prog.functions.append(&mut scratch.functions);
+            prog.structs.append(&mut scratch.structs);
+        }
+        Ok(())
+    }
+
+    /// One instantiation, lowered with its parameters bound
+    fn lower_instance(&mut self, inst: &Instance) -> Result<Program, String> {
+        let missing = || format!("no definition for template `{}`", inst.symbol);
+        let mut scratch = Program::new();
+        let saved_bindings = std::mem::take(&mut self.type_bindings);
+        let saved_vars = std::mem::take(&mut self.var_types);
+        let result = match inst.kind {
+            InstanceKind::Function => {
+                let def = self
+                    .func_specializations
+                    .iter()
+                    .find(|(s, _)| *s == inst.symbol)
+                    .map(|(_, d)| d)
+                    .or_else(|| self.template_defs.iter().find(|d| d.name == inst.template))
+                    .cloned();
+                match def {
+                    Some(def) => {
+                        self.bind(&def.template_params, &inst.args);
+                        self.lower_function(inst.symbol.clone(), &def.return_type, &def.params, &def.body)
+                            .map(|f| scratch.functions.push(f))
+                    }
+                    None => Err(missing()),
+                }
+            }
+            InstanceKind::Class => {
+                let def = self
+                    .class_specializations
+                    .iter()
+                    .find(|(s, _)| *s == inst.symbol)
+                    .map(|(_, d)| d)
+                    .or_else(|| self.class_templates.iter().find(|d| d.name == inst.template))
+                    .cloned();
+                match def {
+                    Some(def) => {
+                        self.bind(&def.template_params, &inst.args);
+                        // The injected class name: `Box` inside Box<T> is Box<T>
+                        self.type_bindings.push((def.name.clone(), CppType::Named(inst.symbol.clone())));
+                        self.convert_class(&inst.symbol, &def.bases, &def.members, def.is_struct, &mut scratch)
+                    }
+                    None => Err(missing()),
+                }
+            }
+        };
+        self.type_bindings = saved_bindings;
+        self.var_types = saved_vars;
+        result.map(|_| scratch)
+    }
+
+    fn bind(&mut self, params: &[CppTemplateParam], args: &[CppType]) {
+        for (param, arg) in params.iter().zip(args) {
+            if let CppTemplateParam::TypeParam { name, .. } | CppTemplateParam::NonTypeParam { name, .. } = param {
+                self.type_bindings.push((name.clone(), arg.clone()));
+            }
+        }
+    }
+
     // ── Statements ──────────────────────────────────────────
     fn convert_stmts(&mut self, stmts: &[CppStmt]) -> Result<Vec<Stmt>, String> {
+        self.convert_scoped(ScopeKind::Block, stmts)
+    }
+
+    /// Statements of one scope; lock guards declared in it are released
+    /// at its end unless control already left through a jump
+    fn convert_scoped(&mut self, kind: ScopeKind, stmts: &[CppStmt]) -> Result<Vec<Stmt>, String> {
+        self.lock_scopes.push(LockScope { kind, guards: Vec::new() });
         let mut out = Vec::new();
-        for s in stmts { self.convert_stmt(s, &mut out)?; }
+        let result = stmts.iter().try_for_each(|s| self.convert_stmt(s, &mut out));
+        let scope = self.lock_scopes.pop().unwrap();
+        result?;
+        if !matches!(out.last(), Some(Stmt::Return(_) | Stmt::Break | Stmt::Continue)) {
+            Self::release_guards(std::slice::from_ref(&scope), &mut out);
+        }
         Ok(out)
     }
 
     fn convert_stmt(&mut self, stmt: &CppStmt, out: &mut Vec<Stmt>) -> Result<(), String> {
         match stmt {
             CppStmt::Expr(e) => {
+                if self.lower_sync_stmt(e, out) { return Ok(()); }
                 // Phase 2+3: handle special expression forms at statement level
                 match e {
                     CppExpr::Assign { target, value } => {
@@ -414,14 +1202,118 @@ impl CppToIR {
                     CppExpr::BinaryOp { op: CppBinOp::Shr, left, right } if self.is_cin(left) => {
                         self.lower_cin_chain(e, out);
                     }
+                    // ++m[k] / m[k]-- on a runtime container → m[k] += 1
+                    CppExpr::UnaryOp { op, expr: inner, .. }
+                        if matches!(op, CppUnaryOp::PreInc | CppUnaryOp::PostInc | CppUnaryOp::PreDec | CppUnaryOp::PostDec)
+                            && matches!(inner.as_ref(), CppExpr::Index { object, .. } if self.container_of(object).is_some()) =>
+                    {
+                        let bin = if matches!(op, CppUnaryOp::PreInc | CppUnaryOp::PostInc) { CppBinOp::Add } else { CppBinOp::Sub };
+                        self.lower_compound_assign(&bin, inner, &CppExpr::IntLiteral(1), out);
+                    }
                     _ => { out.push(Stmt::Expr(self.convert_expr(e))); }
                 }
             }
+            // By-value class result: built in the caller's slot (already
+            // there under NRVO), which is returned
+            CppStmt::Return(Some(e)) if self.sret_class.is_some() => {
+                let class = self.sret_class.clone().unwrap_or_default();
+                let slot = Expr::Variable("__sret".into());
+                if self.nrvo.is_none() {
+                    let init = self.classify_init(&class, Some(e), true);
+                    if let Some(value) = self.construct(&class, slot.clone(), init, out) {
+                        out.push(Stmt::DerefAssign { pointer: slot.clone(), value });
+                    }
+                }
+                Self::release_guards(&self.lock_scopes, out);
+                out.push(Stmt::Return(Some(slot)));
+            }
+            // Guarded return: evaluate the value, release, then return it
+            CppStmt::Return(Some(e)) if self.lock_scopes.iter().any(|s| !s.guards.is_empty()) => {
+                let value = fresh_temp("ret");
+                out.push(Stmt::VarDecl {
+                    var_type: self.return_type.clone(),
+                    name: value.clone(),
+                    value: Some(self.convert_expr(e)),
+                });
+                Self::release_guards(&self.lock_scopes, out);
+                out.push(Stmt::Return(Some(Expr::Variable(value))));
+            }
             CppStmt::Return(Some(e)) => { out.push(Stmt::Return(Some(self.convert_expr(e)))); }
-            CppStmt::Return(None) => { out.push(Stmt::Return(None)); }
+            CppStmt::Return(None) => {
+                Self::release_guards(&self.lock_scopes, out);
+                out.push(Stmt::Return(None));
+            }
             CppStmt::VarDecl { type_spec, declarators } => {
                 for d in declarators {
-                    let val = d.initializer.as_ref().map(|e| self.convert_expr(e));
+                    let declared = match (type_spec, &d.initializer) {
+                        (CppType::Auto, Some(init)) => self.expr_type(init),
+                        _ => Some(self.resolve_type(type_spec)),
+                    };
+                    if let Some(t) = declared {
+                        self.var_types.push((d.name.clone(), t));
+                    }
+                    let exact = d.initializer.as_ref()
+                        .filter(|_| !self.unstable.contains(&d.name))
+                        .and_then(|init| self.pointee_class(init));
+                    self.exact_types.push((d.name.clone(), exact));
+                    if let Some(kind) = Self::sync_kind(type_spec) {
+                        if self.declare_sync(&d.name, kind, d.initializer.as_ref(), out) {
+                            continue;
+                        }
+                    }
+                    if Self::is_future_type(type_spec) || d.initializer.as_ref().map_or(false, Self::is_async_call) {
+                        self.futures.push(d.name.clone());
+                    }
+                    if d.initializer.as_ref().map_or(false, |e| self.is_container_find(e)) {
+                        self.value_iters.push(d.name.clone());
+                    }
+                    if let Some(runtime) = Self::container_runtime(type_spec) {
+                        self.containers.push((d.name.clone(), runtime));
+                        out.push(Stmt::VarDecl {
+                            var_type: Type::I64,
+                            name: d.name.clone(),
+                            value: Some(Expr::Call { name: format!("{}_new", runtime), args: Vec::new() }),
+                        });
+                        // = {{k, v}, ...} / = {k, ...} → one insert per element
+                        if let Some(CppExpr::InitList(items)) = &d.initializer {
+                            let handle = CppExpr::Identifier(d.name.clone());
+                            for item in items {
+                                let insert = self.container_method(&handle, "insert", std::slice::from_ref(item));
+                                out.extend(insert.map(Stmt::Expr));
+                            }
+                        }
+                        continue;
+                    }
+                    // Class objects are constructed in place; the NRVO local
+                    // in the caller's slot
+                    if let Some(class) = self.by_value_class(type_spec).filter(|_| d.derived_type.is_empty()) {
+                        let init = self.classify_init(&class, d.initializer.as_ref(), false);
+                        if self.nrvo.as_ref() == Some(&d.name) {
+                            let slot = Expr::Variable("__sret".into());
+                            if let Some(value) = self.construct(&class, slot.clone(), init, out) {
+                                out.push(Stmt::DerefAssign { pointer: slot, value });
+                            }
+                            continue;
+                        }
+                        let mut built = Vec::new();
+                        let dest = Expr::AddressOf(Box::new(Expr::Variable(d.name.clone())));
+                        let value = self.construct(&class, dest, init, &mut built);
+                        out.push(Stmt::VarDecl { var_type: self.convert_type(type_spec), name: d.name.clone(), value });
+                        out.extend(built);
+                        continue;
+                    }
+                    // constexpr scalars are lowered as their value
+                    let constant = d.initializer.as_ref()
+                        .filter(|_| is_constexpr(type_spec))
+                        .and_then(|init| self.const_init(&declarator_type(type_spec, d), init))
+                        .filter(|v| !matches!(v, Value::Array(_)));
+                    let val = match constant {
+                        Some(v) => {
+                            self.const_locals.push((d.name.clone(), v.clone()));
+                            Some(Self::const_expr(&v))
+                        }
+                        None => d.initializer.as_ref().map(|e| self.convert_expr(e)),
+                    };
                     out.push(Stmt::VarDecl {
                         var_type: self.convert_type(type_spec),
                         name: d.name.clone(),
@@ -430,7 +1322,8 @@ impl CppToIR {
                 }
             }
             CppStmt::Block(stmts) => {
-                for s in stmts { self.convert_stmt(s, out)?; }
+                let block = self.convert_scoped(ScopeKind::Block, stmts)?;
+                out.extend(block);
             }
             CppStmt::If { condition, then_body, else_body, is_constexpr, .. } => {
                 // Phase 2: if constexpr — evaluate at compile time, eliminate dead branch
@@ -455,12 +1348,12 @@ impl CppToIR {
             CppStmt::While { condition, body } => {
                 out.push(Stmt::While {
                     condition: self.convert_expr(condition),
-                    body: self.convert_stmt_to_vec(body)?,
+                    body: self.convert_scoped(ScopeKind::Loop, std::slice::from_ref(body.as_ref()))?,
                 });
             }
             CppStmt::DoWhile { body, condition } => {
                 out.push(Stmt::DoWhile {
-                    body: self.convert_stmt_to_vec(body)?,
+                    body: self.convert_scoped(ScopeKind::Loop, std::slice::from_ref(body.as_ref()))?,
                     condition: self.convert_expr(condition),
                 });
             }
@@ -469,7 +1362,7 @@ impl CppToIR {
                 if let Some(init_s) = init { self.convert_stmt(init_s, out)?; }
                 let cond = condition.as_ref().map(|c| self.convert_expr(c))
                     .unwrap_or(Expr::Bool(true));
-                let mut loop_body = self.convert_stmt_to_vec(body)?;
+                let mut loop_body = self.convert_scoped(ScopeKind::Loop, std::slice::from_ref(body.as_ref()))?;
                 if let Some(inc) = increment {
                     loop_body.push(Stmt::Expr(self.convert_expr(inc)));
                 }
@@ -480,10 +1373,11 @@ impl CppToIR {
                 out.push(Stmt::ForEach {
                     var: name.clone(),
                     iterable: self.convert_expr(iterable),
-                    body: self.convert_stmt_to_vec(body)?,
+                    body: self.convert_scoped(ScopeKind::Loop, std::slice::from_ref(body.as_ref()))?,
                 });
             }
             CppStmt::Switch { expr, cases, default } => {
+                self.lock_scopes.push(LockScope { kind: ScopeKind::Switch, guards: Vec::new() });
                 let ir_cases: Vec<SwitchCase> = cases.iter().map(|c| {
                     SwitchCase {
                         value: self.convert_expr(&c.value),
@@ -500,14 +1394,21 @@ impl CppToIR {
                     for s in d { let _ = self.convert_stmt(s, &mut v); }
                     v
                 });
+                self.lock_scopes.pop();
                 out.push(Stmt::Switch {
                     expr: self.convert_expr(expr),
                     cases: ir_cases,
                     default: ir_default,
                 });
             }
-            CppStmt::Break => { out.push(Stmt::Break); }
-            CppStmt::Continue => { out.push(Stmt::Continue); }
+            CppStmt::Break => {
+                Self::release_guards(self.jump_scopes(&[ScopeKind::Loop, ScopeKind::Switch]), out);
+                out.push(Stmt::Break);
+            }
+            CppStmt::Continue => {
+                Self::release_guards(self.jump_scopes(&[ScopeKind::Loop]), out);
+                out.push(Stmt::Continue);
+            }
             CppStmt::Goto(label) => { out.push(Stmt::JumpTo { label: label.clone() }); }
             CppStmt::Label(name, inner) => {
                 out.push(Stmt::LabelDef { name: name.clone() });
@@ -534,19 +1435,68 @@ impl CppToIR {
 
     // ── Expressions ─────────────────────────────────────────
     fn convert_expr(&self, expr: &CppExpr) -> Expr {
-        match expr {
-            CppExpr::IntLiteral(n) => Expr::Number(*n),
-            CppExpr::UIntLiteral(n) => Expr::Number(*n as i64),
+        if let Some(v) = self.folded_call(expr) {
+            return Self::const_expr(&v);
+        }
+        let lowered = self.lower_expr(expr);
+        self.in_temporary(expr, lowered)
+    }
+
+    /// A by-value class result used as an expression: built in a fresh
+    /// temporary, whose value it is
+    fn in_temporary(&self, expr: &CppExpr, lowered: Expr) -> Expr {
+        match self.temporary(expr, &lowered) {
+            Some(pointer) => Expr::Deref(Box::new(pointer)),
+            None => lowered,
+        }
+    }
+
+    /// The call of `expr` building its by-value result in a fresh
+    /// temporary, evaluating to the temporary's address
+    fn temporary(&self, expr: &CppExpr, lowered: &Expr) -> Option<Expr> {
+        let (at, class) = self.sret_slot(expr, lowered)?;
+        let temp = fresh_temp("rvo");
+        self.temps.borrow_mut().push((temp.clone(), class));
+        let slot = Expr::AddressOf(Box::new(Expr::Variable(temp)));
+        Some(Self::with_slot(lowered.clone(), at, slot))
+    }
+
+    /// A call argument. Class objects are passed by address, a by-value
+    /// result as the address of its temporary.
+    fn convert_arg(&self, arg: &CppExpr) -> Expr {
+        if self.folded_call(arg).is_some() {
+            return self.convert_expr(arg);
+        }
+        let lowered = self.lower_expr(arg);
+        self.temporary(arg, &lowered).unwrap_or(lowered)
+    }
+
+    fn lower_expr(&self, expr: &CppExpr) -> Expr {
+        match expr {
+            CppExpr::IntLiteral(n) => Expr::Number(*n),
+            CppExpr::UIntLiteral(n) => Expr::Number(*n as i64),
             CppExpr::FloatLiteral(f) => Expr::Float(*f),
             CppExpr::StringLiteral(s) => Expr::String(s.clone()),
             CppExpr::CharLiteral(c) => Expr::Number(*c as i64),
             CppExpr::BoolLiteral(b) => Expr::Bool(*b),
             CppExpr::NullptrLiteral => Expr::Nullptr,
+            CppExpr::Identifier(name) if self.nrvo.as_ref() == Some(name) => {
+                Expr::Deref(Box::new(Expr::Variable("__sret".into())))
+            }
             CppExpr::Identifier(name) => {
+                // Non-type template parameter of the instantiation
+                if let Some(CppType::Named(v)) = self.binding(name) {
+                    if let Ok(n) = v.parse::<i64>() { return Expr::Number(n); }
+                    if v == "true" || v == "false" { return Expr::Bool(v == "true"); }
+                }
                 // Check enum constants
                 for (en, ev) in &self.enum_constants {
                     if en == name { return Expr::Number(*ev); }
                 }
+                // Reading an atomic: a fresh load every time (a plain mov)
+                if self.sync_of(expr) == Some(SyncKind::Atomic) {
+                    return Self::sync_call("adb_atomic_load", vec![self.sync_addr(expr)]);
+                }
                 Expr::Variable(name.clone())
             }
             CppExpr::ScopedIdentifier { scope, name } => {
@@ -557,6 +1507,12 @@ impl CppToIR {
                 if full == "std::endl" { return Expr::String("\n".into()); }
                 Expr::Variable(full)
             }
+            // &max<int>, or a template-id passed as a callback
+            CppExpr::TemplateId { name, args } => {
+                let symbol = self.template_call(name, args, &[])
+                    .unwrap_or_else(|| instance_symbol(name, args));
+                Expr::Variable(symbol)
+            }
             CppExpr::This => Expr::Variable("this".into()),
             CppExpr::BinaryOp { op, left, right } => {
                 let l = Box::new(self.convert_expr(left));
@@ -594,6 +1550,22 @@ impl CppToIR {
                     }
                 }
             }
+            CppExpr::UnaryOp { op, expr: inner, .. }
+                if matches!(op, CppUnaryOp::PreInc | CppUnaryOp::PostInc | CppUnaryOp::PreDec | CppUnaryOp::PostDec)
+                    && self.sync_of(inner) == Some(SyncKind::Atomic) =>
+            {
+                // ++a / a-- on an atomic: lock xadd, adjusted for the prefix forms
+                let (name, bias) = match op {
+                    CppUnaryOp::PostInc => ("adb_atomic_fetch_add", 0),
+                    CppUnaryOp::PreInc => ("adb_atomic_fetch_add", 1),
+                    CppUnaryOp::PostDec => ("adb_atomic_fetch_sub", 0),
+                    _ => ("adb_atomic_fetch_sub", -1),
+                };
+                let old = Self::sync_call(name, vec![self.sync_addr(inner), Expr::Number(1)]);
+                if bias == 0 { old } else {
+                    Expr::BinaryOp { op: BinOp::Add, left: Box::new(old), right: Box::new(Expr::Number(bias)) }
+                }
+            }
             CppExpr::UnaryOp { op, expr: inner, .. } => {
                 let e = Box::new(self.convert_expr(inner));
                 match op {
@@ -614,36 +1586,88 @@ impl CppToIR {
                 // Compound assignment as expression evaluates to the result
                 self.convert_expr(value)
             }
+            // std::move / std::forward only change overload resolution:
+            // the constructors they select are picked in `classify_init`
+            CppExpr::Call { args, .. } if moved_operand(expr).is_some() => self.convert_expr(&args[0]),
             CppExpr::Call { callee, args } => {
-                let ir_args: Vec<Expr> = args.iter().map(|a| self.convert_expr(a)).collect();
+                let ir_args: Vec<Expr> = args.iter().map(|a| self.convert_arg(a)).collect();
                 match callee.as_ref() {
-                    CppExpr::Identifier(name) => Expr::Call { name: name.clone(), args: ir_args },
+                    CppExpr::Identifier(name) => self
+                        .parallel_algorithm(name, args, &ir_args)
+                        .or_else(|| {
+                            // max(a, b) on a function template: deduce, instantiate
+                            (!self.plain_functions.contains(name))
+                                .then(|| self.template_call(name, &[], args))
+                                .flatten()
+                                .map(|symbol| Expr::Call { name: symbol, args: ir_args.clone() })
+                        })
+                        .unwrap_or_else(|| Expr::Call { name: name.clone(), args: ir_args }),
+                    CppExpr::TemplateId { name, args: targs } => {
+                        let symbol = self.template_call(name, targs, args)
+                            .unwrap_or_else(|| instance_symbol(name, targs));
+                        Expr::Call { name: symbol, args: ir_args }
+                    }
                     CppExpr::ScopedIdentifier { scope, name } => {
                         let full = format!("{}::{}", scope.join("::"), name);
-                        Expr::Call { name: full, args: ir_args }
+                        match full.as_str() {
+                            // Every launch policy runs on the pool: drop it
+                            "std::async" => {
+                                let skip = matches!(args.first(),
+                                    Some(CppExpr::ScopedIdentifier { scope, .. }) if scope.last().map_or(false, |s| s == "launch"));
+                                Expr::Call { name: "adb_async".into(), args: ir_args[skip as usize..].to_vec() }
+                            }
+                            "adb::parallel_for" => Expr::Call { name: "adb_parallel_for".into(), args: ir_args },
+                            "adb::pool_size" => Expr::Call { name: "adb_pool_size".into(), args: ir_args },
+                            _ => (scope == &["std"])
+                                .then(|| self.parallel_algorithm(name, args, &ir_args))
+                                .flatten()
+                                .unwrap_or_else(|| Expr::Call { name: full, args: ir_args }),
+                        }
+                    }
+                    // fut.get() / fut.wait() → task pool runtime
+                    CppExpr::MemberAccess { object, member }
+                        if (member == "get" || member == "wait")
+                            && matches!(object.as_ref(), CppExpr::Identifier(v) if self.futures.contains(v)) =>
+                    {
+                        let name = if member == "get" { "adb_future_get" } else { "adb_future_wait" };
+                        Expr::Call { name: name.into(), args: vec![self.convert_expr(object)] }
                     }
                     CppExpr::MemberAccess { object, member } => {
-                        let obj = self.convert_expr(object);
-                        Expr::MethodCall { object: Box::new(obj), method: member.clone(), args: ir_args }
+                        self.sync_method(object, member, args)
+                            .or_else(|| self.container_method(object, member, args))
+                            .or_else(|| self.member_call(object, false, member, &ir_args))
+                            .unwrap_or_else(|| {
+                            let obj = self.convert_expr(object);
+                            Expr::MethodCall { object: Box::new(obj), method: member.clone(), args: ir_args }
+                        })
                     }
                     CppExpr::ArrowAccess { pointer, member } => {
-                        let ptr = self.convert_expr(pointer);
-                        Expr::MethodCall { object: Box::new(ptr), method: member.clone(), args: ir_args }
+                        self.member_call(pointer, true, member, &ir_args).unwrap_or_else(|| {
+                            let ptr = self.convert_expr(pointer);
+                            Expr::MethodCall { object: Box::new(ptr), method: member.clone(), args: ir_args }
+                        })
                     }
                     _ => Expr::Call { name: "__unknown_call".into(), args: ir_args },
                 }
             }
-            CppExpr::MemberAccess { object, member } => {
-                Expr::FieldAccess { object: Box::new(self.convert_expr(object)), field: member.clone() }
+            // (*p).f, the NRVO local or a result temporary: p->f
+            CppExpr::MemberAccess { object, member } => match self.convert_expr(object) {
+                Expr::Deref(pointer) => Expr::ArrowAccess { pointer, field: member.clone() },
+                object => Expr::FieldAccess { object: Box::new(object), field: member.clone() },
+            },
+            // it->second on a container find() result: the value itself
+            CppExpr::ArrowAccess { pointer, member } if member == "second" && self.is_value_iter(pointer) => {
+                Expr::Deref(Box::new(self.convert_expr(pointer)))
             }
             CppExpr::ArrowAccess { pointer, member } => {
                 Expr::ArrowAccess { pointer: Box::new(self.convert_expr(pointer)), field: member.clone() }
             }
-            CppExpr::Index { object, index } => {
-                Expr::Index { object: Box::new(self.convert_expr(object)), index: Box::new(self.convert_expr(index)) }
-            }
+            CppExpr::Index { object, index } => match self.container_slot(object, index) {
+                Some(slot) => Expr::Deref(Box::new(slot)),
+                None => Expr::Index { object: Box::new(self.convert_expr(object)), index: Box::new(self.convert_expr(index)) },
+            },
             CppExpr::Deref(inner) => Expr::Deref(Box::new(self.convert_expr(inner))),
-            CppExpr::AddressOf(inner) => Expr::AddressOf(Box::new(self.convert_expr(inner))),
+            CppExpr::AddressOf(inner) => Self::address_of(self.convert_expr(inner)),
             CppExpr::Cast { target_type, expr: inner, .. } => {
                 Expr::Cast { target_type: self.convert_type(target_type), expr: Box::new(self.convert_expr(inner)) }
             }
@@ -701,8 +1725,151 @@ impl CppToIR {
         }
     }
 
+    // ── Copy elision ────────────────────────────────────────
+
+    /// `S::__init` taking `args` arguments; several overloads would share
+    /// the name, so only a class with one such constructor qualifies
+    fn init_ctor(&self, class: &str, args: usize) -> bool {
+        let mut inits = self.ctors.get(class).into_iter().flatten().filter(|c| c.kind == CtorKind::Init);
+        matches!((inits.next(), inits.next()), (Some(c), None) if c.accepts(args))
+    }
+
+    fn has_ctor(&self, class: &str, kind: CtorKind) -> bool {
+        self.ctors.get(class).map_or(false, |cs| cs.iter().any(|c| c.kind == kind))
+    }
+
+    /// Initialization of a `class` object from `init` (`None`: default
+    /// construction). `returned` moves from a local, as `return x;` does.
+    fn classify_init<'a>(&self, class: &str, init: Option<&'a CppExpr>, returned: bool) -> Init<'a> {
+        let Some(init) = init else { return Init::Default };
+        let class_of = |e: &CppExpr| self.expr_type(e).and_then(|t| self.class_of(&t));
+        if let Some(src) = moved_operand(init) {
+            if class_of(src).as_deref() == Some(class) {
+                return Init::Move(src);
+            }
+        }
+        match init {
+            // S x(a, b) / S x{a, b} / S(a, b)
+            CppExpr::InitList(args) if self.init_ctor(class, args.len()) => return Init::Args(args),
+            CppExpr::Call { callee, args } if matches!(callee.as_ref(), CppExpr::Identifier(n) if n == class)
+                && self.init_ctor(class, args.len()) => return Init::Args(args),
+            _ => {}
+        }
+        match self.expr_type(init) {
+            Some(t) if self.class_of(&t).as_deref() == Some(class) => {
+                let local = matches!(init, CppExpr::Identifier(_)) && !matches!(t, CppType::Reference(_) | CppType::RValueRef(_));
+                if returned && local { Init::Move(init) } else { Init::Copy(init) }
+            }
+            // S x(n) / S x = n through a converting constructor
+            Some(t) if self.class_of(&t).is_none() && self.init_ctor(class, 1) => Init::Args(std::slice::from_ref(init)),
+            _ => Init::Value(init),
+        }
+    }
+
+    /// Builds a `class` object at address `dest`. A value that is neither
+    /// constructed nor a by-value result is handed back to be stored.
+    fn construct(&self, class: &str, dest: Expr, init: Init, out: &mut Vec<Stmt>) -> Option<Expr> {
+        let call = match init {
+            Init::Default if self.init_ctor(class, 0) => {
+                Expr::Call { name: CtorKind::Init.symbol(class), args: vec![dest] }
+            }
+            Init::Default => return None,
+            Init::Args(args) => {
+                let args = std::iter::once(dest).chain(args.iter().map(|a| self.convert_expr(a))).collect();
+                Expr::Call { name: CtorKind::Init.symbol(class), args }
+            }
+            Init::Copy(src) | Init::Move(src) => {
+                let Some(from) = self.object_address(src) else { return Some(self.convert_expr(src)) };
+                let kind = match init {
+                    Init::Move(_) if self.has_ctor(class, CtorKind::Move) => CtorKind::Move,
+                    _ => CtorKind::Copy,
+                };
+                if self.has_ctor(class, kind) {
+                    Expr::Call { name: kind.symbol(class), args: vec![dest, from] }
+                } else {
+                    let size = match self.object_size(class) {
+                        Some(bytes) => Expr::Number(bytes),
+                        None => Expr::SizeOf(Box::new(crate::frontend::ast::SizeOfArg::Type(Type::Struct(class.to_string())))),
+                    };
+                    Expr::Call { name: "memcpy".into(), args: vec![dest, from, size] }
+                }
+            }
+            Init::Value(e) => {
+                let lowered = self.lower_expr(e);
+                match self.sret_slot(e, &lowered) {
+                    Some((at, _)) => Self::with_slot(lowered, at, dest),
+                    None => return Some(lowered),
+                }
+            }
+        };
+        out.push(Stmt::Expr(call));
+        None
+    }
+
+    /// Bytes a `class` object occupies in the backend, which gives every
+    /// field an 8-byte slot (arrays one per element, embedded structs
+    /// their own size). Not `sizeof`: that is the C layout.
+    fn object_size(&self, class: &str) -> Option<i64> {
+        let fields = self.class_fields.get(class)?;
+        let size = fields
+            .iter()
+            .map(|f| match &f.field_type {
+                Type::Struct(n) | Type::Class(n) | Type::Named(n) => self.object_size(n).unwrap_or(8),
+                Type::Array(_, Some(count)) => *count as i64 * 8,
+                _ => 8,
+            })
+            .sum();
+        Some(size)
+    }
+
+    /// Address of an object denoted by `e`, if it has one
+    fn object_address(&self, e: &CppExpr) -> Option<Expr> {
+        match e {
+            CppExpr::Deref(pointer) => Some(self.convert_expr(pointer)),
+            CppExpr::Identifier(_) | CppExpr::MemberAccess { .. } | CppExpr::ArrowAccess { .. } | CppExpr::Index { .. } => {
+                // References already are pointers
+                match self.expr_type(e) {
+                    Some(CppType::Reference(_) | CppType::RValueRef(_)) => Some(self.convert_expr(e)),
+                    _ => Some(Self::address_of(self.convert_expr(e))),
+                }
+            }
+            _ => None,
+        }
+    }
+
+    /// `&e`, folding `&*p` to `p`
+    fn address_of(e: Expr) -> Expr {
+        match e {
+            Expr::Deref(pointer) => *pointer,
+            e => Expr::AddressOf(Box::new(e)),
+        }
+    }
+
+    /// Where the slot goes in the lowered call of `expr` and the class it
+    /// holds, when `expr` calls a function returning a class by value
+    fn sret_slot(&self, expr: &CppExpr, lowered: &Expr) -> Option<(usize, String)> {
+        let (CppExpr::Call { .. }, Expr::Call { name, args }) = (expr, lowered) else { return None };
+        let (at, class) = self.sret.get(name).or_else(|| self.sret.get(&self.mangled(name)))?;
+        (*at <= args.len()).then(|| (*at, class.clone()))
+    }
+
+    fn with_slot(call: Expr, at: usize, slot: Expr) -> Expr {
+        match call {
+            Expr::Call { name, mut args } => {
+                args.insert(at, slot);
+                Expr::Call { name, args }
+            }
+            other => other,
+        }
+    }
+
     // ── Type conversion ─────────────────────────────────────
     fn convert_type(&self, ty: &CppType) -> Type {
+        if let CppType::Named(n) | CppType::Typedef(n) = ty {
+            if let Some(bound) = self.binding(n) {
+                return self.convert_type(bound);
+            }
+        }
         match ty {
             CppType::Void => Type::Void,
             CppType::Bool => Type::Bool,
@@ -732,11 +1899,20 @@ impl CppToIR {
             CppType::Typedef(n) => Type::Struct(n.clone()),
             CppType::StdString | CppType::StdStringView => Type::Pointer(Box::new(Type::I8)),
             CppType::SizeT | CppType::Nullptr => Type::I64,
+            CppType::TemplateType { name, args } => match self.template_class(name, args) {
+                Some(symbol) => Type::Struct(symbol),
+                None => Type::I64,
+            },
             _ => Type::I64,
         }
     }
 
     fn type_name(&self, ty: &CppType) -> String {
+        if let CppType::Named(n) = ty {
+            if let Some(bound) = self.binding(n) {
+                return self.type_name(bound);
+            }
+        }
         match ty {
             CppType::Void => "void".into(),
             CppType::Bool => "bool".into(),
@@ -750,6 +1926,7 @@ impl CppToIR {
             CppType::Pointer(inner) => format!("{}*", self.type_name(inner)),
             CppType::Reference(inner) => format!("{}&", self.type_name(inner)),
             CppType::Named(n) | CppType::Struct(n) | CppType::Class(n) => n.clone(),
+            CppType::TemplateType { name, args } => self.template_class(name, args).unwrap_or_else(|| "int".into()),
             _ => "int".into(),
         }
     }
@@ -762,17 +1939,33 @@ impl CppToIR {
     // ── Phase 2: Assignment lowering ────────────────────────
 
     fn lower_assign(&self, target: &CppExpr, value: &CppExpr, out: &mut Vec<Stmt>) {
-        let v = self.convert_expr(value);
+        let v = match self.folded_call(value) {
+            Some(c) => Self::const_expr(&c),
+            None => {
+                let lowered = self.lower_expr(value);
+                // x = f() with f returning x's class by value: f builds
+                // straight into x, unless the class defines its own assignment
+                if let (CppExpr::Identifier(_), Some((at, _))) = (target, self.sret_slot(value, &lowered)) {
+                    let plain = self.object_class(target)
+                        .filter(|c| self.hierarchy.implementation(c, "operator_assign").is_none());
+                    if let Some(dest) = plain.and_then(|_| self.object_address(target)) {
+                        out.push(Stmt::Expr(Self::with_slot(lowered, at, dest)));
+                        return;
+                    }
+                }
+                self.in_temporary(value, lowered)
+            }
+        };
         match target {
             CppExpr::Identifier(name) => {
                 out.push(Stmt::Assign { name: name.clone(), value: v });
             }
-            CppExpr::MemberAccess { object, member } => {
-                out.push(Stmt::FieldAssign {
-                    object: self.convert_expr(object),
-                    field: member.clone(),
-                    value: v,
-                });
+            CppExpr::MemberAccess { object, member } => match self.convert_expr(object) {
+                Expr::Deref(pointer) => out.push(Stmt::ArrowAssign { pointer: *pointer, field: member.clone(), value: v }),
+                object => out.push(Stmt::FieldAssign { object, field: member.clone(), value: v }),
+            },
+            CppExpr::ArrowAccess { pointer, member } if member == "second" && self.is_value_iter(pointer) => {
+                out.push(Stmt::DerefAssign { pointer: self.convert_expr(pointer), value: v });
             }
             CppExpr::ArrowAccess { pointer, member } => {
                 out.push(Stmt::ArrowAssign {
@@ -787,6 +1980,10 @@ impl CppToIR {
                     value: v,
                 });
             }
+            CppExpr::Index { object, index } if self.container_of(object).is_some() => {
+                let pointer = self.container_slot(object, index).unwrap();
+                out.push(Stmt::DerefAssign { pointer, value: v });
+            }
             CppExpr::Index { object, index } => {
                 out.push(Stmt::IndexAssign {
                     object: self.convert_expr(object),
@@ -822,6 +2019,30 @@ impl CppToIR {
                     value: self.convert_expr(value),
                 });
             }
+            // m[k] op= v: one lookup into a temp, then *slot = *slot op v
+            CppExpr::Index { object, index } if self.container_of(object).is_some() => {
+                let slot = fresh_temp("slot");
+                out.push(Stmt::VarDecl {
+                    var_type: Type::Pointer(Box::new(Type::I64)),
+                    name: slot.clone(),
+                    value: self.container_slot(object, index),
+                });
+                let l = Box::new(Expr::Deref(Box::new(Expr::Variable(slot.clone()))));
+                let r = Box::new(self.convert_expr(value));
+                let updated = match op {
+                    CppBinOp::Sub => Expr::BinaryOp { op: BinOp::Sub, left: l, right: r },
+                    CppBinOp::Mul => Expr::BinaryOp { op: BinOp::Mul, left: l, right: r },
+                    CppBinOp::Div => Expr::BinaryOp { op: BinOp::Div, left: l, right: r },
+                    CppBinOp::Mod => Expr::BinaryOp { op: BinOp::Mod, left: l, right: r },
+                    CppBinOp::BitAnd => Expr::BitwiseOp { op: BitwiseOp::And, left: l, right: r },
+                    CppBinOp::BitOr => Expr::BitwiseOp { op: BitwiseOp::Or, left: l, right: r },
+                    CppBinOp::BitXor => Expr::BitwiseOp { op: BitwiseOp::Xor, left: l, right: r },
+                    CppBinOp::Shl => Expr::BitwiseOp { op: BitwiseOp::LeftShift, left: l, right: r },
+                    CppBinOp::Shr => Expr::BitwiseOp { op: BitwiseOp::RightShift, left: l, right: r },
+                    _ => Expr::BinaryOp { op: BinOp::Add, left: l, right: r },
+                };
+                out.push(Stmt::DerefAssign { pointer: Expr::Variable(slot), value: updated });
+            }
             _ => {
                 // Fallback: expand to full assign
                 let t = self.convert_expr(target);
@@ -866,6 +2087,354 @@ impl CppToIR {
 
     // ── Phase 3: cout/cin detection ──────────────────────
 
+    fn is_future_type(t: &CppType) -> bool {
+        matches!(t, CppType::TemplateType { name, .. }
+            if matches!(name.trim_start_matches("std::"), "future" | "shared_future"))
+    }
+
+    fn is_execution_policy(e: &CppExpr) -> Option<&str> {
+        match e {
+            CppExpr::ScopedIdentifier { scope, name }
+                if scope.last().map_or(false, |s| s == "execution") && (name == "par" || name == "par_unseq") =>
+            {
+                Some(name)
+            }
+            _ => None,
+        }
+    }
+
+    /// sort/reduce/transform/for_each with std::execution::par or
+    /// par_unseq as first argument → backend parallel algorithms.
+    /// `seq` and shapes with a comparator or custom op stay plain calls.
+    fn parallel_algorithm(&self, name: &str, args: &[CppExpr], ir_args: &[Expr]) -> Option<Expr> {
+        let policy = Self::is_execution_policy(args.first()?)?;
+        let rest = &ir_args[1..];
+        let (callee, call_args) = match (name, rest.len()) {
+            ("sort", 2) => ("adb_par_sort", rest.to_vec()),
+            ("reduce", 2 | 3) => {
+                let init = rest.get(2).cloned().unwrap_or(Expr::Number(0));
+                let callee = if policy == "par_unseq" { "adb_par_unseq_reduce" } else { "adb_par_reduce" };
+                (callee, vec![rest[0].clone(), rest[1].clone(), init])
+            }
+            ("transform", 4) => ("adb_par_transform", rest.to_vec()),
+            ("for_each", 3) => {
+                let by_value = matches!(args.last(), Some(CppExpr::Identifier(f)) if self.by_value_callbacks.contains(f));
+                let mut call_args = rest.to_vec();
+                call_args.push(Expr::Number(!by_value as i64));
+                ("adb_par_for_each", call_args)
+            }
+            _ => return None,
+        };
+        Some(Expr::Call { name: callee.into(), args: call_args })
+    }
+
+    /// Word-sized key/value types the container runtimes store inline
+    fn is_word_type(t: &CppType) -> bool {
+        match t {
+            CppType::Bool | CppType::Char | CppType::Short | CppType::Int | CppType::Long
+            | CppType::LongLong | CppType::SizeT | CppType::Enum(_) | CppType::Pointer(_) => true,
+            CppType::Unsigned(inner) | CppType::Signed(inner) | CppType::Const(inner) => Self::is_word_type(inner),
+            _ => false,
+        }
+    }
+
+    /// unordered_map/unordered_set → flat hash table, map/set → B-tree,
+    /// as long as keys and values are integers or pointers
+    fn container_runtime(t: &CppType) -> Option<&'static str> {
+        match t {
+            CppType::StdUnorderedMap(k, v) if Self::is_word_type(k) && Self::is_word_type(v) => Some("adb_hash"),
+            CppType::StdUnorderedSet(k) if Self::is_word_type(k) => Some("adb_hash"),
+            CppType::StdMap(k, v) if Self::is_word_type(k) && Self::is_word_type(v) => Some("adb_tree"),
+            CppType::StdSet(k) if Self::is_word_type(k) => Some("adb_tree"),
+            _ => None,
+        }
+    }
+
+    fn container_of(&self, e: &CppExpr) -> Option<&'static str> {
+        match e {
+            CppExpr::Identifier(v) => self.containers.iter().rev().find(|(n, _)| n == v).map(|&(_, r)| r),
+            _ => None,
+        }
+    }
+
+    fn is_container_find(&self, e: &CppExpr) -> bool {
+        matches!(e, CppExpr::Call { callee, .. }
+            if matches!(callee.as_ref(), CppExpr::MemberAccess { object, member } if member == "find" && self.container_of(object).is_some()))
+    }
+
+    fn is_value_iter(&self, e: &CppExpr) -> bool {
+        match e {
+            CppExpr::Identifier(v) => self.value_iters.contains(v),
+            _ => self.is_container_find(e),
+        }
+    }
+
+    /// m[k] → adb_*_slot(m, k): address of the value, inserted as 0 if new
+    fn container_slot(&self, object: &CppExpr, key: &CppExpr) -> Option<Expr> {
+        let runtime = self.container_of(object)?;
+        Some(Expr::Call {
+            name: format!("{}_slot", runtime),
+            args: vec![self.convert_expr(object), self.convert_expr(key)],
+        })
+    }
+
+    /// Member calls on a runtime container. Iterators are value pointers:
+    /// find() yields the value's address or 0 and end() is 0, so
+    /// `find(k) != end()` and `find(k)->second` keep working.
+    fn container_method(&self, object: &CppExpr, member: &str, args: &[CppExpr]) -> Option<Expr> {
+        let runtime = self.container_of(object)?;
+        let call = |op: &str, rest: Vec<Expr>| {
+            let mut call_args = vec![self.convert_expr(object)];
+            call_args.extend(rest);
+            Expr::Call { name: format!("{}_{}", runtime, op), args: call_args }
+        };
+        let key = || args.first().map(|k| self.convert_expr(k));
+        Some(match (member, args) {
+            // insert({k, v}) / insert(std::make_pair(k, v)) / insert(k) on a set
+            ("insert", [CppExpr::InitList(kv)]) if kv.len() == 2 => {
+                call("insert", kv.iter().map(|e| self.convert_expr(e)).collect())
+            }
+            ("insert", [CppExpr::Call { callee, args: kv }])
+                if kv.len() == 2
+                    && matches!(callee.as_ref(), CppExpr::Identifier(n) | CppExpr::ScopedIdentifier { name: n, .. } if n == "make_pair") =>
+            {
+                call("insert", kv.iter().map(|e| self.convert_expr(e)).collect())
+            }
+            ("insert" | "emplace" | "try_emplace", [k]) => call("insert", vec![self.convert_expr(k), Expr::Number(0)]),
+            ("emplace" | "try_emplace", [k, v]) => call("insert", vec![self.convert_expr(k), self.convert_expr(v)]),
+            ("find", [_]) => call("find", key().into_iter().collect()),
+            ("count" | "contains", [_]) => Expr::Comparison {
+                op: CmpOp::Ne,
+                left: Box::new(call("find", key().into_iter().collect())),
+                right: Box::new(Expr::Number(0)),
+            },
+            ("at", [_]) => Expr::Deref(Box::new(call("slot", key().into_iter().collect()))),
+            ("erase", [_]) => call("erase", key().into_iter().collect()),
+            ("size", []) => call("size", Vec::new()),
+            ("empty", []) => Expr::Comparison {
+                op: CmpOp::Eq,
+                left: Box::new(call("size", Vec::new())),
+                right: Box::new(Expr::Number(0)),
+            },
+            ("clear", []) => call("clear", Vec::new()),
+            ("end", []) => Expr::Number(0),
+            ("reserve" | "rehash", [_]) => Expr::Number(0),
+            _ => return None,
+        })
+    }
+
+    fn guard_kind(name: &str) -> Option<SyncKind> {
+        match name {
+            "lock_guard" | "scoped_lock" => Some(SyncKind::Guard),
+            "unique_lock" => Some(SyncKind::UniqueLock),
+            _ => None,
+        }
+    }
+
+    /// std::mutex, std::condition_variable, std::atomic<T> of integers
+    /// or pointers, std::atomic_flag and the lock guards
+    fn sync_kind(t: &CppType) -> Option<SyncKind> {
+        match t {
+            CppType::StdMutex => Some(SyncKind::Mutex),
+            CppType::StdAtomic(inner) if Self::is_word_type(inner) => Some(SyncKind::Atomic),
+            CppType::TemplateType { name, .. } => Self::guard_kind(name),
+            CppType::Named(n) => match n.rsplit("::").next().unwrap_or(n) {
+                "condition_variable" | "condition_variable_any" => Some(SyncKind::CondVar),
+                "atomic_flag" => Some(SyncKind::Atomic),
+                other => Self::guard_kind(other),
+            },
+            _ => None,
+        }
+    }
+
+    fn is_sync_object(kind: SyncKind) -> bool {
+        matches!(kind, SyncKind::Mutex | SyncKind::CondVar | SyncKind::Atomic)
+    }
+
+    fn sync_of(&self, e: &CppExpr) -> Option<SyncKind> {
+        match e {
+            CppExpr::Identifier(v) => self.sync_objects.iter().rev().find(|(n, _)| n == v).map(|&(_, k)| k),
+            _ => None,
+        }
+    }
+
+    /// Address of the object's word; a guard already holds its mutex's
+    fn sync_addr(&self, e: &CppExpr) -> Expr {
+        let CppExpr::Identifier(name) = e else { unreachable!("sync objects are named variables") };
+        match self.sync_of(e) {
+            Some(SyncKind::Guard | SyncKind::UniqueLock) => Expr::Variable(name.clone()),
+            _ => Expr::AddressOf(Box::new(Expr::Variable(name.clone()))),
+        }
+    }
+
+    fn sync_call(name: &str, args: Vec<Expr>) -> Expr {
+        Expr::Call { name: name.into(), args }
+    }
+
+    fn owns_flag(guard: &str) -> String {
+        format!("__owns_{}", guard)
+    }
+
+    /// Mutexes, condition variables and atomics are one zeroed word, so
+    /// declaring one is just that (the initial value for atomics)
+    fn declare_sync_object(&mut self, name: &str, kind: SyncKind, init: Option<&CppExpr>) -> Stmt {
+        let value = match init {
+            Some(CppExpr::Identifier(n)) if n == "ATOMIC_FLAG_INIT" => Expr::Number(0),
+            Some(e) if kind == SyncKind::Atomic => self.convert_expr(e),
+            _ => Expr::Number(0),
+        };
+        self.sync_objects.push((name.to_string(), kind));
+        Stmt::VarDecl { var_type: Type::I64, name: name.to_string(), value: Some(value) }
+    }
+
+    /// Local sync declaration. A guard over a known mutex locks it here
+    /// and joins the innermost scope, which releases it on the way out.
+    /// false = not lowered (e.g. unique_lock with defer_lock)
+    fn declare_sync(&mut self, name: &str, kind: SyncKind, init: Option<&CppExpr>, out: &mut Vec<Stmt>) -> bool {
+        if Self::is_sync_object(kind) {
+            let decl = self.declare_sync_object(name, kind, init);
+            out.push(decl);
+            return true;
+        }
+        let Some(mutex) = init.filter(|m| self.sync_of(m) == Some(SyncKind::Mutex)) else { return false };
+        out.push(Stmt::VarDecl {
+            var_type: Type::Pointer(Box::new(Type::I64)),
+            name: name.to_string(),
+            value: Some(self.sync_addr(mutex)),
+        });
+        out.push(Stmt::Expr(Self::sync_call("adb_mutex_lock", vec![Expr::Variable(name.to_string())])));
+        if kind == SyncKind::UniqueLock {
+            out.push(Stmt::VarDecl { var_type: Type::I64, name: Self::owns_flag(name), value: Some(Expr::Number(1)) });
+        }
+        self.sync_objects.push((name.to_string(), kind));
+        if let Some(scope) = self.lock_scopes.last_mut() {
+            scope.guards.push((name.to_string(), kind));
+        }
+        true
+    }
+
+    /// Unlocks for the guards of `scopes`, innermost first
+    fn release_guards(scopes: &[LockScope], out: &mut Vec<Stmt>) {
+        for (guard, kind) in scopes.iter().rev().flat_map(|s| s.guards.iter().rev()) {
+            let unlock = Stmt::Expr(Self::sync_call("adb_mutex_unlock", vec![Expr::Variable(guard.clone())]));
+            if *kind == SyncKind::UniqueLock {
+                out.push(Stmt::If {
+                    condition: Expr::Variable(Self::owns_flag(guard)),
+                    then_body: vec![unlock],
+                    else_body: None,
+                });
+            } else {
+                out.push(unlock);
+            }
+        }
+    }
+
+    /// Scopes a break/continue leaves: up to the innermost of `targets`
+    fn jump_scopes(&self, targets: &[ScopeKind]) -> &[LockScope] {
+        match self.lock_scopes.iter().rposition(|s| targets.contains(&s.kind)) {
+            Some(i) => &self.lock_scopes[i..],
+            None => &[],
+        }
+    }
+
+    /// Statement forms on sync objects that need more than one IR
+    /// statement or a different shape than the expression lowering
+    fn lower_sync_stmt(&self, e: &CppExpr, out: &mut Vec<Stmt>) -> bool {
+        match e {
+            // cv.wait(lk, pred) → while (!pred) cv.wait(lk)
+            CppExpr::Call { callee, args } if args.len() == 2 => {
+                let CppExpr::MemberAccess { object, member } = callee.as_ref() else { return false };
+                if member != "wait" || self.sync_of(object) != Some(SyncKind::CondVar) {
+                    return false;
+                }
+                let pred = match &args[1] {
+                    CppExpr::Lambda { body, .. } => match body.last() {
+                        Some(CppStmt::Return(Some(r))) => self.convert_expr(r),
+                        _ => return false,
+                    },
+                    other => self.convert_expr(&CppExpr::Call { callee: Box::new(other.clone()), args: Vec::new() }),
+                };
+                let wait = Self::sync_call("adb_cond_wait", vec![self.sync_addr(object), self.sync_addr(&args[0])]);
+                out.push(Stmt::While {
+                    condition: Expr::UnaryOp { op: UnaryOp::Not, expr: Box::new(pred) },
+                    body: vec![Stmt::Expr(wait)],
+                });
+            }
+            // lk.lock() / lk.unlock() on a unique_lock also track ownership
+            CppExpr::Call { callee, args } if args.is_empty() => {
+                let CppExpr::MemberAccess { object, member } = callee.as_ref() else { return false };
+                if self.sync_of(object) != Some(SyncKind::UniqueLock) || !matches!(member.as_str(), "lock" | "unlock") {
+                    return false;
+                }
+                let CppExpr::Identifier(guard) = object.as_ref() else { return false };
+                let name = if member == "lock" { "adb_mutex_lock" } else { "adb_mutex_unlock" };
+                out.push(Stmt::Expr(Self::sync_call(name, vec![self.sync_addr(object)])));
+                out.push(Stmt::Assign { name: Self::owns_flag(guard), value: Expr::Number((member == "lock") as i64) });
+            }
+            CppExpr::Assign { target, value } if self.sync_of(target) == Some(SyncKind::Atomic) => {
+                let store = Self::sync_call("adb_atomic_store", vec![self.sync_addr(target), self.convert_expr(value)]);
+                out.push(Stmt::Expr(store));
+            }
+            CppExpr::CompoundAssign { op, target, value } if self.sync_of(target) == Some(SyncKind::Atomic) => {
+                let name = match op {
+                    CppBinOp::Add => "adb_atomic_fetch_add",
+                    CppBinOp::Sub => "adb_atomic_fetch_sub",
+                    CppBinOp::BitAnd => "adb_atomic_fetch_and",
+                    CppBinOp::BitOr => "adb_atomic_fetch_or",
+                    CppBinOp::BitXor => "adb_atomic_fetch_xor",
+                    _ => return false,
+                };
+                out.push(Stmt::Expr(Self::sync_call(name, vec![self.sync_addr(target), self.convert_expr(value)])));
+            }
+            _ => return false,
+        }
+        true
+    }
+
+    /// Member calls on mutexes, condition variables, atomics and guards.
+    /// memory_order arguments are dropped: every lowering is seq_cst on x86.
+    fn sync_method(&self, object: &CppExpr, member: &str, args: &[CppExpr]) -> Option<Expr> {
+        let kind = self.sync_of(object)?;
+        let call = |name: &str, rest: Vec<Expr>| {
+            let mut call_args = vec![self.sync_addr(object)];
+            call_args.extend(rest);
+            Self::sync_call(name, call_args)
+        };
+        let arg = |i: usize| args.get(i).map(|a| self.convert_expr(a));
+        use SyncKind::*;
+        Some(match (kind, member) {
+            (Mutex | Guard | UniqueLock, "lock") => call("adb_mutex_lock", Vec::new()),
+            (Mutex | Guard | UniqueLock, "unlock") => call("adb_mutex_unlock", Vec::new()),
+            (Mutex, "try_lock") => call("adb_mutex_try_lock", Vec::new()),
+            (UniqueLock, "owns_lock") => match object {
+                CppExpr::Identifier(guard) => Expr::Variable(Self::owns_flag(guard)),
+                _ => return None,
+            },
+            (CondVar, "wait") => call("adb_cond_wait", vec![self.sync_addr(args.first()?)]),
+            (CondVar, "notify_one") => call("adb_cond_notify_one", Vec::new()),
+            (CondVar, "notify_all") => call("adb_cond_notify_all", Vec::new()),
+            (Atomic, "load") => call("adb_atomic_load", Vec::new()),
+            (Atomic, "store") => call("adb_atomic_store", vec![arg(0)?]),
+            (Atomic, "exchange") => call("adb_atomic_exchange", vec![arg(0)?]),
+            (Atomic, "fetch_add" | "fetch_sub" | "fetch_and" | "fetch_or" | "fetch_xor") => {
+                call(&format!("adb_atomic_{}", member), vec![arg(0)?])
+            }
+            (Atomic, "compare_exchange_strong" | "compare_exchange_weak") => {
+                let expected = Expr::AddressOf(Box::new(arg(0)?));
+                call("adb_atomic_cas", vec![expected, arg(1)?])
+            }
+            (Atomic, "test_and_set") => call("adb_atomic_exchange", vec![Expr::Number(1)]),
+            (Atomic, "clear") => call("adb_atomic_store", vec![Expr::Number(0)]),
+            (Atomic, "is_lock_free") => Expr::Number(1),
+            _ => return None,
+        })
+    }
+
+    fn is_async_call(e: &CppExpr) -> bool {
+        matches!(e, CppExpr::Call { callee, .. }
+            if matches!(callee.as_ref(), CppExpr::ScopedIdentifier { scope, name } if scope == &["std"] && name == "async"))
+    }
+
     fn is_cout(&self, expr: &CppExpr) -> bool {
         match expr {
             CppExpr::Identifier(n) => n == "cout",
@@ -970,82 +2539,130 @@ impl CppToIR {
 
     // ── Phase 2: Compile-time evaluation for if constexpr ───
 
-    fn try_eval_constexpr(&self, expr: &CppExpr) -> Option<bool> {
-        match expr {
-            CppExpr::BoolLiteral(b) => Some(*b),
-            CppExpr::IntLiteral(n) => Some(*n != 0),
-            CppExpr::BinaryOp { op: CppBinOp::Eq, left, right } => {
-                match (self.try_eval_int(left), self.try_eval_int(right)) {
-                    (Some(a), Some(b)) => Some(a == b),
-                    _ => None,
-                }
-            }
-            CppExpr::BinaryOp { op: CppBinOp::Ne, left, right } => {
-                match (self.try_eval_int(left), self.try_eval_int(right)) {
-                    (Some(a), Some(b)) => Some(a != b),
-                    _ => None,
-                }
-            }
-            CppExpr::BinaryOp { op: CppBinOp::Lt, left, right } => {
-                match (self.try_eval_int(left), self.try_eval_int(right)) {
-                    (Some(a), Some(b)) => Some(a < b),
-                    _ => None,
-                }
-            }
-            CppExpr::BinaryOp { op: CppBinOp::Gt, left, right } => {
-                match (self.try_eval_int(left), self.try_eval_int(right)) {
-                    (Some(a), Some(b)) => Some(a > b),
-                    _ => None,
-                }
-            }
-            CppExpr::BinaryOp { op: CppBinOp::And, left, right } => {
-                match (self.try_eval_constexpr(left), self.try_eval_constexpr(right)) {
-                    (Some(a), Some(b)) => Some(a && b),
-                    _ => None,
-                }
-            }
-            CppExpr::BinaryOp { op: CppBinOp::Or, left, right } => {
-                match (self.try_eval_constexpr(left), self.try_eval_constexpr(right)) {
-                    (Some(a), Some(b)) => Some(a || b),
-                    _ => None,
-                }
-            }
-            CppExpr::UnaryOp { op: CppUnaryOp::Not, expr, .. } => {
-                self.try_eval_constexpr(expr).map(|v| !v)
-            }
-            _ => None,
+    // ── Compile-time evaluation ─────────────────────────────
+
+    /// Names the evaluator cannot see itself: bound non-type template
+    /// parameters, constexpr locals and enumerators
+    fn const_name(&self, name: &str) -> Option<Value> {
+        if let Some(CppType::Named(v)) = self.binding(name) {
+            return match v.as_str() {
+                "true" | "false" => Some(Value::int((v == "true") as i64)),
+                _ => v.parse().ok().map(Value::int),
+            };
         }
+        if let Some((_, v)) = self.const_locals.iter().rev().find(|(n, _)| n == name) {
+            return Some(v.clone());
+        }
+        self.enum_constants.iter().find(|(n, _)| n == name).map(|(_, v)| Value::int(*v))
     }
 
-    fn try_eval_int(&self, expr: &CppExpr) -> Option<i64> {
-        match expr {
-            CppExpr::IntLiteral(n) => Some(*n),
-            CppExpr::BoolLiteral(b) => Some(if *b { 1 } else { 0 }),
-            CppExpr::UnaryOp { op: CppUnaryOp::Neg, expr, .. } => {
-                self.try_eval_int(expr).map(|v| -v)
+    /// Whether `e` reads a runtime local or parameter, which may shadow
+    /// a constant of the same name
+    fn reads_runtime_local(&self, e: &CppExpr) -> bool {
+        match e {
+            CppExpr::Identifier(n) => {
+                self.var_types.iter().any(|(v, _)| v == n) && !self.const_locals.iter().any(|(c, _)| c == n)
             }
-            CppExpr::BinaryOp { op, left, right } => {
-                let a = self.try_eval_int(left)?;
-                let b = self.try_eval_int(right)?;
-                match op {
-                    CppBinOp::Add => a.checked_add(b),
-                    CppBinOp::Sub => a.checked_sub(b),
-                    CppBinOp::Mul => a.checked_mul(b),
-                    CppBinOp::Div if b != 0 => a.checked_div(b),
-                    CppBinOp::Mod if b != 0 => a.checked_rem(b),
-                    _ => None,
-                }
-            }
-            CppExpr::Identifier(name) => {
-                // Check enum constants
-                for (en, ev) in &self.enum_constants {
-                    if en == name { return Some(*ev); }
+            _ => e.children().into_iter().any(|c| self.reads_runtime_local(c)),
+        }
+    }
+
+    fn const_value(&self, expr: &CppExpr) -> Option<Value> {
+        if self.reads_runtime_local(expr) {
+            return None;
+        }
+        self.consteval.eval(expr, &|n| self.const_name(n)).ok()
+    }
+
+    /// Value of a variable of type `ty` initialized with `init`
+    fn const_init(&self, ty: &CppType, init: &CppExpr) -> Option<Value> {
+        if self.reads_runtime_local(init) {
+            return None;
+        }
+        let ty = self.resolve_type(ty);
+        self.consteval.eval_init(&ty, init, &|n| self.const_name(n)).ok()
+    }
+
+    /// A call to a constexpr function (or `.size()` of a constant array)
+    /// whose result is a constant scalar
+    fn folded_call(&self, expr: &CppExpr) -> Option<Value> {
+        let CppExpr::Call { callee, .. } = expr else { return None };
+        let foldable = match callee.as_ref() {
+            CppExpr::Identifier(name) => self.consteval.has_function(&self.mangled(name)) || self.consteval.has_function(name),
+            CppExpr::ScopedIdentifier { scope, name } => self.consteval.has_function(&format!("{}::{}", scope.join("::"), name)),
+            CppExpr::MemberAccess { object, member } => member == "size"
+                && matches!(object.as_ref(), CppExpr::Identifier(n) if matches!(self.consteval.value(n), Some(Value::Array(_)))),
+            _ => false,
+        };
+        if !foldable {
+            return None;
+        }
+        self.const_value(expr).filter(|v| !matches!(v, Value::Array(_)))
+    }
+
+    fn const_expr(v: &Value) -> Expr {
+        match v {
+            Value::Int(i) => Expr::Number(i.v),
+            Value::Float(f) => Expr::Float(*f),
+            Value::Array(items) => Expr::Array(items.iter().map(Self::const_expr).collect()),
+        }
+    }
+
+    /// A constexpr (or const) global the evaluator computes, lowered as
+    /// initialized data: scalars and one-dimensional arrays of scalars
+    fn materialize(&mut self, type_spec: &CppType, d: &CppDeclarator) -> Option<Stmt> {
+        if !is_constexpr(type_spec) && !matches!(type_spec, CppType::Const(_)) {
+            return None;
+        }
+        let ty = declarator_type(type_spec, d);
+        let value = self.const_init(&ty, d.initializer.as_ref()?)?;
+        // `auto` takes the type of the value: elements of a table returned
+        // by a constexpr function carry their declared width
+        let var_type = match (&value, Self::strip_cv(&ty)) {
+            (Value::Array(items), declared) => {
+                if items.iter().any(|v| matches!(v, Value::Array(_))) {
+                    return None;
                 }
-                None
+                let elem = match declared {
+                    CppType::StdArray(elem, _) | CppType::Array(elem, _) => self.convert_type(&self.resolve_type(elem)),
+                    _ => items.first().map_or(Type::I32, Self::value_type),
+                };
+                Type::Array(Box::new(elem), Some(items.len()))
             }
-            _ => None,
+            (_, CppType::Auto) => Self::value_type(&value),
+            (_, declared) => self.convert_type(&self.resolve_type(declared)),
+        };
+        self.consteval.define(&d.name, value.clone());
+        Some(Stmt::VarDecl { var_type, name: d.name.clone(), value: Some(Self::const_expr(&value)) })
+    }
+
+    fn value_type(v: &Value) -> Type {
+        match v {
+            Value::Int(i) => match i.bits {
+                8 => Type::I8,
+                16 => Type::I16,
+                32 => Type::I32,
+                _ => Type::I64,
+            },
+            Value::Float(_) => Type::F64,
+            Value::Array(items) => Type::Array(Box::new(items.first().map_or(Type::I32, Self::value_type)), Some(items.len())),
+        }
+    }
+
+    fn strip_cv(t: &CppType) -> &CppType {
+        match t {
+            CppType::Const(t) | CppType::Volatile(t) | CppType::Constexpr(t) => Self::strip_cv(t),
+            t => t,
         }
     }
+
+    fn try_eval_constexpr(&self, expr: &CppExpr) -> Option<bool> {
+        self.const_value(expr)?.truthy()
+    }
+
+    fn try_eval_int(&self, expr: &CppExpr) -> Option<i64> {
+        self.const_value(expr)?.as_int()
+    }
 }
 
 /// Convenience function: compile C++ source → Program IR
@@ -1112,6 +2729,356 @@ mod tests {
         assert!(prog.functions.iter().any(|f| f.name == "math::square"));
     }
 
+    #[test]
+    fn test_async_future_lowering() {
+        let prog = compile_cpp_to_program(r#"
+            int work(int n) { return n * 2; }
+            void body(int i) { }
+            int main() {
+                std::future<int> f = std::async(std::launch::async, work, 21);
+                auto g = std::async(work, 1);
+                adb::parallel_for(0, 100, 0, body);
+                g.wait();
+                return f.get();
+            }
+        "#).unwrap();
+        let main = prog.functions.iter().find(|f| f.name == "main").unwrap();
+        let text = format!("{:?}", main.body);
+        assert!(text.contains("\"adb_async\""));
+        assert!(!text.contains("launch"));
+        assert!(text.contains("\"adb_parallel_for\""));
+        assert!(text.contains("\"adb_future_wait\""));
+        assert!(text.contains("\"adb_future_get\""));
+    }
+
+    #[test]
+    fn test_parallel_algorithm_lowering() {
+        let prog = compile_cpp_to_program(r#"
+            int twice(int x) { return x * 2; }
+            void bump(int& x) { x = x + 1; }
+            void show(int x) { }
+            int main() {
+                int* v = 0;
+                int* w = 0;
+                std::sort(std::execution::par, v, v + 8);
+                std::transform(std::execution::par, v, v + 8, w, twice);
+                std::for_each(std::execution::par, v, v + 8, bump);
+                std::for_each(std::execution::par_unseq, v, v + 8, show);
+                std::sort(std::execution::seq, v, v + 8);
+                return std::reduce(std::execution::par_unseq, v, v + 8) + std::reduce(std::execution::par, v, v + 8, 5);
+            }
+        "#).unwrap();
+        let main = prog.functions.iter().find(|f| f.name == "main").unwrap();
+        let text = format!("{:?}", main.body);
+        assert!(text.contains("\"adb_par_sort\""));
+        assert!(text.contains("\"adb_par_transform\""));
+        assert!(text.contains("\"adb_par_unseq_reduce\""));
+        assert!(text.contains("\"adb_par_reduce\""));
+        assert_eq!(text.matches("\"adb_par_for_each\"").count(), 2);
+        // seq keeps the library call
+        assert!(text.contains("\"std::sort\""));
+    }
+
+    #[test]
+    fn test_container_lowering() {
+        let prog = compile_cpp_to_program(r#"
+            int main() {
+                std::unordered_map<int, long long> counts;
+                std::map<int, int> order = {{3, 30}, {1, 10}};
+                std::set<int> seen;
+                counts[7] = 1;
+                counts[7] += 2;
+                ++counts[8];
+                order.insert({5, 50});
+                order.emplace(6, 60);
+                seen.insert(4);
+                auto it = order.find(5);
+                if (it != order.end()) it->second = 55;
+                if (seen.count(4) && !counts.empty()) order.erase(1);
+                return counts[7] + order.size();
+            }
+        "#).unwrap();
+        let main = prog.functions.iter().find(|f| f.name == "main").unwrap();
+        let text = format!("{:?}", main.body);
+        assert_eq!(text.matches("\"adb_hash_new\"").count(), 1);
+        assert_eq!(text.matches("\"adb_tree_new\"").count(), 2);
+        // Two initializer pairs plus insert({..}), emplace and the set insert
+        assert_eq!(text.matches("\"adb_tree_insert\"").count(), 5);
+        assert_eq!(text.matches("\"adb_hash_slot\"").count(), 4);
+        assert!(text.contains("\"adb_tree_find\""));
+        assert!(text.contains("\"adb_tree_erase\""));
+        assert!(text.contains("\"adb_hash_size\""));
+        assert!(text.contains("\"adb_tree_size\""));
+        assert!(!text.contains("MethodCall"));
+    }
+
+    #[test]
+    fn test_sync_lowering() {
+        let prog = compile_cpp_to_program(r#"
+            std::mutex m;
+            std::condition_variable cv;
+            std::atomic<int> hits{0};
+            int take(int n) {
+                std::lock_guard<std::mutex> g(m);
+                if (n > 2) return n;
+                hits += n;
+                return 0;
+            }
+            int main() {
+                for (int i = 0; i < 4; i++) {
+                    std::unique_lock<std::mutex> lk(m);
+                    if (i == 1) continue;
+                    ++hits;
+                    cv.notify_all();
+                }
+                std::unique_lock<std::mutex> lk(m);
+                cv.wait(lk, [&]{ return hits > 3; });
+                int expected = 5;
+                hits.compare_exchange_strong(expected, 6);
+                return hits.load(std::memory_order_acquire);
+            }
+        "#).unwrap();
+        let take = prog.functions.iter().find(|f| f.name == "take").unwrap();
+        let text = format!("{:?}", take.body);
+        assert_eq!(text.matches("\"adb_mutex_lock\"").count(), 1);
+        // Both returns unlock the guard before leaving
+        assert_eq!(text.matches("\"adb_mutex_unlock\"").count(), 2);
+        assert!(text.contains("\"adb_atomic_fetch_add\""));
+        let main = prog.functions.iter().find(|f| f.name == "main").unwrap();
+        let text = format!("{:?}", main.body);
+        // Loop body end, the continue and main's return
+        assert_eq!(text.matches("\"adb_mutex_unlock\"").count(), 3);
+        assert!(text.contains("While { condition: UnaryOp { op: Not"));
+        assert!(text.contains("\"adb_cond_wait\""));
+        assert!(text.contains("\"adb_cond_notify_all\""));
+        assert!(text.contains("\"adb_atomic_cas\""));
+        assert!(text.contains("\"adb_atomic_load\""));
+        assert!(!text.contains("MethodCall"));
+    }
+
+    #[test]
+    fn test_template_instantiated_once() {
+        let prog = compile_cpp_to_program(r#"
+            template<typename T> T maxv(T a, T b) { return a > b ? a : b; }
+            int main() {
+                int x = maxv<int>(1, 2);
+                int y = maxv(3, 4);
+                double z = maxv(1.5, 2.5);
+                return x + y;
+            }
+        "#).unwrap();
+        let names: Vec<&str> = prog.functions.iter().map(|f| f.name.as_str()).collect();
+        assert_eq!(names.iter().filter(|n| **n == "maxv<int>").count(), 1);
+        assert_eq!(names.iter().filter(|n| **n == "maxv<double>").count(), 1);
+        let inst = prog.functions.iter().find(|f| f.name == "maxv<int>").unwrap();
+        assert!(inst.attributes.foldable);
+        let main = prog.functions.iter().find(|f| f.name == "main").unwrap();
+        assert_eq!(format!("{:?}", main.body).matches("\"maxv<int>\"").count(), 2);
+    }
+
+    #[test]
+    fn test_template_deduction_conflict_not_instantiated() {
+        let prog = compile_cpp_to_program(r#"
+            template<typename T> T add(T a, T b) { return a + b; }
+            template<typename T, int N> T scale(T v) { return v * N; }
+            int main() {
+                char c = 'a';
+                int r = scale<int, 3>(2);
+                return add(1, c);
+            }
+        "#).unwrap();
+        assert!(prog.functions.iter().all(|f| !f.name.starts_with("add<")));
+        let scale = prog.functions.iter().find(|f| f.name == "scale<int, 3>").unwrap();
+        assert!(format!("{:?}", scale.body).contains("Number(3)"));
+    }
+
+    #[test]
+    fn test_class_template_and_specialization() {
+        let prog = compile_cpp_to_program(r#"
+            template<typename T> struct Box { T value; T get() { return value; } };
+            template<> struct Box<char> { int packed; };
+            template<typename T> T ident(T v) { return v; }
+            template<> int ident<int>(int v) { return v + 1; }
+            int main() {
+                Box<int> a;
+                Box<char> b;
+                return ident<int>(a.value);
+            }
+        "#).unwrap();
+        assert_eq!(prog.structs.iter().filter(|s| s.name == "Box<int>").count(), 1);
+        let special = prog.structs.iter().find(|s| s.name == "Box<char>").unwrap();
+        assert!(format!("{:?}", special).contains("packed"));
+        let ident = prog.functions.iter().find(|f| f.name == "ident<int>").unwrap();
+        assert!(format!("{:?}", ident.body).contains("Number(1)"));
+    }
+
+    #[test]
+    fn test_shared_instances_reused_across_units() {
+        use crate::parse::lexer::CppLexer;
+        use crate::parse::parser::CppParser;
+        let source = r#"
+            template<typename T> T twice(T v) { return v + v; }
+            int main() { return twice(2); }
+        "#;
+        let lower = |shared: &SharedInstances| {
+            let (tokens, lines) = CppLexer::new(source).tokenize();
+            let unit = CppParser::new(tokens, lines).parse_translation_unit().unwrap();
+            CppToIR::new().with_shared_instances(shared.clone()).convert(&unit).unwrap()
+        };
+        let shared = SharedInstances::new();
+        let first = lower(&shared);
+        assert_eq!(shared.len(), 1);
+        let second = lower(&shared);
+        assert_eq!(shared.len(), 1);
+        assert_eq!(format!("{:?}", first.functions), format!("{:?}", second.functions));
+    }
+
+    fn body_of(prog: &Program, name: &str) -> String {
+        format!("{:?}", prog.functions.iter().find(|f| f.name == name).unwrap().body)
+    }
+
+    #[test]
+    fn test_devirtualized_calls() {
+        let prog = compile_cpp_to_program(r#"
+            class Shape { public: virtual int area() { return 0; } int id() { return 7; } };
+            class Square final : public Shape { public: int s; int area() override { return s * s; } };
+            class Circle : public Shape { public: int r; int area() override { return 3 * r * r; } };
+            int sealed(Square* q) { return q->area(); }
+            int plain(Shape* p) { return p->id(); }
+            int local() { Shape* p = new Circle(); return p->area(); }
+            int value() { Shape s; return s.area(); }
+            int main() { return 0; }
+        "#).unwrap();
+        assert!(body_of(&prog, "sealed").contains("name: \"Square::area\""));
+        assert!(body_of(&prog, "plain").contains("name: \"Shape::id\""));
+        assert!(body_of(&prog, "local").contains("name: \"Circle::area\""));
+        assert!(body_of(&prog, "value").contains("name: \"Shape::area\""));
+        for f in ["sealed", "plain", "local", "value"] {
+            assert!(!body_of(&prog, f).contains("VirtualCall") && !body_of(&prog, f).contains("MethodCall"));
+        }
+    }
+
+    #[test]
+    fn test_copy_elision() {
+        let prog = compile_cpp_to_program(r#"
+            struct V {
+                int x; int y;
+                V(int a, int b) : x(a), y(b) {}
+                V(const V& o) : x(o.x), y(o.y) {}
+                V(V&& o) : x(o.x), y(o.y) { o.x = 0; }
+            };
+            V make(int n) { V r(n, n); r.y = 7; return r; }
+            V pick(bool c, V a, V b) { if (c) return a; return b; }
+            int main() {
+                V v = make(3);
+                V w(v);
+                V u = std::move(w);
+                v = make(4);
+                return make(5).y + u.x;
+            }
+        "#).unwrap();
+        let make = prog.functions.iter().find(|f| f.name == "make").unwrap();
+        assert_eq!(make.params[0].name, "__sret");
+        // NRVO: r is the caller's slot
+        let body = body_of(&prog, "make");
+        assert!(body.contains("Call { name: \"V::__init\", args: [Variable(\"__sret\")"));
+        assert!(!body.contains("name: \"r\""));
+        // Two named results: each moved into the slot
+        assert_eq!(body_of(&prog, "pick").matches("V::__move").count(), 2);
+        let main = body_of(&prog, "main");
+        assert!(main.contains("Call { name: \"make\", args: [AddressOf(Variable(\"v\")), Number(3)] }"));
+        assert!(main.contains("Call { name: \"make\", args: [AddressOf(Variable(\"v\")), Number(4)] }"));
+        assert!(main.contains("Call { name: \"V::__copy\", args: [AddressOf(Variable(\"w\")), AddressOf(Variable(\"v\"))] }"));
+        assert!(main.contains("Call { name: \"V::__move\", args: [AddressOf(Variable(\"u\")), AddressOf(Variable(\"w\"))] }"));
+        assert!(main.contains("ArrowAccess { pointer: Call { name: \"make\", args: [AddressOf(Variable(\"__rvo"));
+        assert!(!main.contains("std::move"));
+    }
+
+    #[test]
+    fn test_plain_copy_uses_slot_size() {
+        let prog = compile_cpp_to_program(r#"
+            struct P { int x; char c; };
+            struct W { P p; int v[3]; short s; };
+            int main() { P a; P b = a; W w; W u = w; return b.x + u.s; }
+        "#).unwrap();
+        // One 8-byte slot per field, not sizeof
+        let main = body_of(&prog, "main");
+        assert!(main.contains("args: [AddressOf(Variable(\"b\")), AddressOf(Variable(\"a\")), Number(16)]"));
+        assert!(main.contains("args: [AddressOf(Variable(\"u\")), AddressOf(Variable(\"w\")), Number(48)]"));
+    }
+
+    #[test]
+    fn test_virtual_call_through_compact_vtable() {
+        let source = r#"
+            class Plugin { public: virtual int run(int x) = 0; virtual int stop() { return 0; } };
+            class Echo : public Plugin { public: int run(int x) override { return x; } };
+            class Gain : public Plugin { public: int g; int run(int x) override { return x * g; } };
+            int drive(Plugin* p, int x) { return p->run(x) + p->stop(); }
+            int main() { return 0; }
+        "#;
+        let prog = compile_cpp_to_program(source).unwrap();
+        let drive = body_of(&prog, "drive");
+        // Two overriders of run: slot 0; stop has one implementation
+        assert!(drive.contains("VirtualCall { object: Variable(\"p\"), slot: 0"));
+        assert!(drive.contains("name: \"Plugin::stop\""));
+        // One vptr, owned by the root; the table lists Gain's overrider
+        let gain = prog.structs.iter().find(|s| s.name == "Gain").unwrap();
+        assert!(!gain.fields.iter().any(|f| f.name == "__vptr"));
+        let table = prog.statements.iter().find_map(|s| match s {
+            Stmt::VarDecl { name, value, .. } if name == "__vtable_Gain" => Some(format!("{:?}", value)),
+            _ => None,
+        }).unwrap();
+        assert_eq!(table, "Some(Array([Variable(\"Gain::run\"), Variable(\"Plugin::stop\")]))");
+
+        // Another TU may add overriders of stop: no CHA
+        use crate::parse::lexer::CppLexer;
+        use crate::parse::parser::CppParser;
+        let (tokens, lines) = CppLexer::new(source).tokenize();
+        let unit = CppParser::new(tokens, lines).parse_translation_unit().unwrap();
+        let open = CppToIR::new().with_closed_hierarchy(false).convert(&unit).unwrap();
+        assert!(body_of(&open, "drive").contains("slot: 1"));
+    }
+
+    #[test]
+    fn test_constexpr_tables_materialized() {
+        let source = r#"
+            typedef unsigned int uint32_t;
+            constexpr std::array<uint32_t, 256> make_crc_table() {
+                std::array<uint32_t, 256> t{};
+                for (uint32_t n = 0; n < 256; n++) {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+                    t[n] = c;
+                }
+                return t;
+            }
+            constexpr auto crc_table = make_crc_table();
+            constexpr int kSize = crc_table.size() / 4;
+            static_assert(kSize == 64, "table size");
+            constexpr int square(int x) { return x * x; }
+            int main() {
+                constexpr int nine = square(3);
+                if constexpr (square(2) == 4) { return crc_table[1] + nine; }
+                return 0;
+            }
+        "#;
+        let prog = compile_cpp_to_program(source).unwrap();
+        let table = prog.statements.iter().find_map(|s| match s {
+            Stmt::VarDecl { name, var_type, value: Some(Expr::Array(items)), .. } if name == "crc_table" => Some((var_type, items)),
+            _ => None,
+        }).unwrap();
+        assert_eq!(*table.0, Type::Array(Box::new(Type::I32), Some(256)));
+        assert!(matches!(table.1[1], Expr::Number(0x77073096)));
+        assert!(prog.statements.iter().any(|s| matches!(s,
+            Stmt::VarDecl { name, value: Some(Expr::Number(64)), .. } if name == "kSize")));
+        let main = body_of(&prog, "main");
+        assert!(main.contains("name: \"nine\", value: Some(Number(9))"));
+        assert!(!main.contains("If"));
+
+        let err = compile_cpp_to_program("constexpr int f() { return 1; } static_assert(f() == 2, \"f\");").unwrap_err();
+        assert_eq!(err, "static_assert failed: f");
+    }
+
     #[test]
     fn test_enum() {
         let prog = compile_cpp_to_program(r#"
@@ -0,0 +1,207 @@
+// ============================================================
+// Copy Elision and Move Semantics
+// ============================================================
+// A function returning a class by value takes a hidden `__sret`
+// pointer to the slot its caller reserved and builds the result right
+// there: `V v = make();` passes `&v`, a temporary only exists when the
+// result is used as an expression. It returns `__sret` back.
+//
+// When every return names the same local (NRVO), that local *is* the
+// caller's slot: its declaration constructs into `*__sret` and no copy
+// is ever made. Otherwise a returned local is moved into the slot.
+//
+// Constructors are told apart by what they take: `S(const S&)` is
+// `S::__copy`, `S(S&&)` is `S::__move`, the rest are `S::__init`.
+// Without a user copy/move constructor an object is copied bytewise.
+// ============================================================
+
+use crate::ast::*;
+
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum CtorKind {
+    Init,
+    Copy,
+    Move,
+}
+
+impl CtorKind {
+    /// Lowered function name of a `class` constructor of this kind
+    pub fn symbol(self, class: &str) -> String {
+        let suffix = match self {
+            CtorKind::Init => "__init",
+            CtorKind::Copy => "__copy",
+            CtorKind::Move => "__move",
+        };
+        format!("{}::{}", class, suffix)
+    }
+}
+
+/// A constructor with a body (declared-only and `= default` ones are
+/// left to the bytewise copy)
+#[derive(Debug, Clone)]
+pub struct Ctor {
+    pub kind: CtorKind,
+    pub arity: usize,
+    /// Parameters without a default argument
+    pub required: usize,
+}
+
+impl Ctor {
+    pub fn accepts(&self, args: usize) -> bool {
+        self.kind == CtorKind::Init && (self.required..=self.arity).contains(&args)
+    }
+}
+
+/// `S(const S&)` / `S(S&&)` of class `class` (a template instance
+/// spells itself by its bare name: `Box(const Box&)` in `Box<int>`)
+pub fn ctor_kind(class: &str, params: &[CppParam]) -> CtorKind {
+    let [param] = params else { return CtorKind::Init };
+    let names_class = |t: &CppType| {
+        let mut t = t;
+        while let CppType::Const(inner) | CppType::Volatile(inner) = t {
+            t = inner;
+        }
+        matches!(t, CppType::Named(n) | CppType::Struct(n) | CppType::Class(n)
+            if n == class || class.strip_prefix(n.as_str()).map_or(false, |rest| rest.starts_with('<')))
+    };
+    match &param.param_type {
+        CppType::RValueRef(inner) if names_class(inner) => CtorKind::Move,
+        CppType::Reference(inner) if names_class(inner) => CtorKind::Copy,
+        _ => CtorKind::Init,
+    }
+}
+
+/// Constructors of a class body that are lowered to functions
+pub fn constructors(class: &str, members: &[CppClassMember]) -> Vec<Ctor> {
+    members
+        .iter()
+        .filter_map(|m| match m {
+            CppClassMember::Constructor { params, body: Some(_), .. } => Some(Ctor {
+                kind: ctor_kind(class, params),
+                arity: params.len(),
+                required: params.iter().filter(|p| p.default_value.is_none()).count(),
+            }),
+            _ => None,
+        })
+        .collect()
+}
+
+/// `x` of `std::move(x)`, `std::forward<T>(x)` or `static_cast<T&&>(x)`
+pub fn moved_operand(e: &CppExpr) -> Option<&CppExpr> {
+    match e {
+        CppExpr::Call { callee, args } if args.len() == 1 => {
+            let name = match callee.as_ref() {
+                CppExpr::ScopedIdentifier { scope, name } if scope == &["std"] => name.as_str(),
+                CppExpr::Identifier(name) => name.as_str(),
+                CppExpr::TemplateId { name, .. } => name.strip_prefix("std::").unwrap_or(name),
+                _ => return None,
+            };
+            matches!(name, "move" | "forward").then(|| &args[0])
+        }
+        CppExpr::Cast { target_type: CppType::RValueRef(_), expr, .. } => Some(expr),
+        _ => None,
+    }
+}
+
+/// The local every `return` of `body` names, with its declared type: the
+/// NRVO candidate. It must be declared once, as a plain object (no
+/// pointer, reference or array declarator), and never be assigned as a
+/// whole, so that living in the caller's slot is unobservable.
+pub fn named_return<'a>(params: &[CppParam], body: &'a [CppStmt]) -> Option<(&'a str, &'a CppType)> {
+    /// Whether every return in `stmts` names `name` (the first one found)
+    fn returned<'a>(stmts: impl IntoIterator<Item = &'a CppStmt>, name: &mut Option<&'a str>) -> bool {
+        stmts.into_iter().all(|stmt| match stmt {
+            CppStmt::Return(Some(CppExpr::Identifier(n))) => *name.get_or_insert(n) == n,
+            CppStmt::Return(_) | CppStmt::CoReturn(_) => false,
+            _ => returned(stmt.parts().1, name),
+        })
+    }
+    /// Every declaration of `name`; a range-for variable has no declarator
+    fn declarations<'a>(stmts: impl IntoIterator<Item = &'a CppStmt>, name: &str,
+        out: &mut Vec<Option<(&'a CppType, &'a CppDeclarator)>>,
+    ) {
+        for stmt in stmts {
+            match stmt {
+                CppStmt::VarDecl { type_spec, declarators } => {
+                    out.extend(declarators.iter().filter(|d| d.name == name).map(|d| Some((type_spec, d))));
+                }
+                CppStmt::RangeFor { name: n, .. } if n == name => out.push(None),
+                _ => {}
+            }
+            declarations(stmt.parts().1, name, out);
+        }
+    }
+
+    let mut name = None;
+    if !returned(body, &mut name) {
+        return None;
+    }
+    let name = name?;
+    if params.iter().any(|p| p.name.as_deref() == Some(name)) {
+        return None;
+    }
+    let mut decls = Vec::new();
+    declarations(body, name, &mut decls);
+    let [Some((type_spec, d))] = decls[..] else { return None };
+    if !d.derived_type.is_empty() {
+        return None;
+    }
+    let mut assigned = false;
+    visit_exprs(body, &mut |e| {
+        if let CppExpr::Assign { target, .. } = e {
+            assigned |= matches!(target.as_ref(), CppExpr::Identifier(n) if n == name);
+        }
+    });
+    (!assigned).then_some((name, type_spec))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn param(ty: CppType, name: &str) -> CppParam {
+        CppParam { param_type: ty, name: Some(name.into()), default_value: None, is_variadic: false }
+    }
+
+    fn decl(name: &str) -> CppStmt {
+        CppStmt::VarDecl {
+            type_spec: CppType::Named("V".into()),
+            declarators: vec![CppDeclarator { name: name.into(), derived_type: Vec::new(), initializer: None }],
+        }
+    }
+
+    #[test]
+    fn test_ctor_kinds() {
+        let v = || Box::new(CppType::Named("V".into()));
+        assert_eq!(ctor_kind("V", &[param(CppType::Reference(Box::new(CppType::Const(v()))), "o")]), CtorKind::Copy);
+        assert_eq!(ctor_kind("V", &[param(CppType::RValueRef(v()), "o")]), CtorKind::Move);
+        assert_eq!(ctor_kind("V<int>", &[param(CppType::RValueRef(v()), "o")]), CtorKind::Move);
+        assert_eq!(ctor_kind("V", &[param(CppType::Int, "n")]), CtorKind::Init);
+        assert_eq!(CtorKind::Move.symbol("V"), "V::__move");
+    }
+
+    #[test]
+    fn test_named_return() {
+        let ret = |n: &str| CppStmt::Return(Some(CppExpr::Identifier(n.into())));
+        let branch = |then: CppStmt, other: CppStmt| CppStmt::If {
+            init: None,
+            condition: CppExpr::BoolLiteral(true),
+            then_body: Box::new(then),
+            else_body: Some(Box::new(other)),
+            is_constexpr: false,
+        };
+        let body = vec![decl("r"), branch(ret("r"), ret("r"))];
+        assert_eq!(named_return(&[], &body).map(|(n, _)| n), Some("r"));
+        // Two named results: neither can live in the caller's slot
+        let body = vec![decl("r"), decl("s"), branch(ret("r"), ret("s"))];
+        assert_eq!(named_return(&[], &body), None);
+        // Shadowed in a nested block
+        let body = vec![decl("r"), CppStmt::Block(vec![decl("r")]), ret("r")];
+        assert_eq!(named_return(&[], &body), None);
+        let assign = CppStmt::Expr(CppExpr::Assign {
+            target: Box::new(CppExpr::Identifier("r".into())),
+            value: Box::new(CppExpr::Identifier("x".into())),
+        });
+        assert_eq!(named_return(&[], &[decl("r"), assign, ret("r")]), None);
+    }
+}
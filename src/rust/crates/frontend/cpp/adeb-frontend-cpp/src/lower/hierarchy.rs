@@ -0,0 +1,347 @@
+// ============================================================
+// Class Hierarchy Analysis
+// ============================================================
+// What the lowering knows about every class of the TU: its bases,
+// whether it is `final`, and which methods it declares (virtual or
+// not). With that, a member call resolves to one direct call when:
+//
+//   - the method is not virtual,
+//   - the object's dynamic type is known (a value, `new D`, `&d`),
+//   - the class or the implementation it reaches is `final`,
+//   - every class at or below the static type shares one
+//     implementation (only with a closed hierarchy: a TU of a
+//     multi-file build cannot see the subclasses other TUs add).
+//
+// What is left goes through a compact vtable: one array of code
+// pointers per polymorphic class, a single vptr at offset 0 shared
+// with the primary (first) base, and a fixed slot per method.
+// ============================================================
+
+use crate::ast::*;
+use std::collections::{HashMap, HashSet};
+
+/// One method declared in a class body
+#[derive(Debug, Clone)]
+pub struct MethodInfo {
+    /// Operator names already mangled (`operator_add`)
+    pub name: String,
+    pub is_virtual: bool,
+    pub is_final: bool,
+    pub is_pure: bool,
+    pub is_static: bool,
+}
+
+#[derive(Debug, Clone)]
+pub struct ClassInfo {
+    pub name: String,
+    pub bases: Vec<String>,
+    pub is_final: bool,
+    pub methods: Vec<MethodInfo>,
+}
+
+/// How a member call is dispatched
+#[derive(Debug, Clone, PartialEq)]
+pub enum Dispatch {
+    /// `Class::method`, called directly
+    Direct(String),
+    /// Through vtable slot `n`
+    Slot(u32),
+}
+
+#[derive(Debug, Default)]
+pub struct ClassHierarchy {
+    classes: HashMap<String, ClassInfo>,
+    /// Every subclass of the TU is known (single-file build)
+    closed: bool,
+}
+
+impl ClassHierarchy {
+    pub fn new(closed: bool) -> Self {
+        Self { classes: HashMap::new(), closed }
+    }
+
+    pub fn set_closed(&mut self, closed: bool) {
+        self.closed = closed;
+    }
+
+    /// Records a class; a later definition of the same name replaces it
+    pub fn add(&mut self, info: ClassInfo) {
+        self.classes.insert(info.name.clone(), info);
+    }
+
+    pub fn contains(&self, class: &str) -> bool {
+        self.classes.contains_key(class)
+    }
+
+    fn method(&self, class: &str, method: &str) -> Option<&MethodInfo> {
+        self.classes.get(class)?.methods.iter().find(|m| m.name == method)
+    }
+
+    fn primary_base(&self, class: &str) -> Option<&str> {
+        self.classes.get(class)?.bases.first().map(|b| b.as_str())
+    }
+
+    /// `class` and its primary bases, most derived first. Only these share
+    /// the object's address, so only their methods take `this` unadjusted.
+    fn primary_chain<'a>(&'a self, class: &'a str) -> Vec<&'a str> {
+        let mut chain = vec![class];
+        while let Some(base) = self.primary_base(chain[chain.len() - 1]) {
+            if chain.contains(&base) {
+                break;
+            }
+            chain.push(base);
+        }
+        chain
+    }
+
+    /// Declared virtual here or in any base (overriders are virtual too)
+    pub fn is_virtual(&self, class: &str, method: &str) -> bool {
+        let mut seen = HashSet::new();
+        let mut work = vec![class];
+        while let Some(c) = work.pop() {
+            if !seen.insert(c) {
+                continue;
+            }
+            if self.method(c, method).map_or(false, |m| m.is_virtual) {
+                return true;
+            }
+            if let Some(info) = self.classes.get(c) {
+                work.extend(info.bases.iter().map(|b| b.as_str()));
+            }
+        }
+        false
+    }
+
+    /// Declaration a call on a `class` object resolves to statically:
+    /// the nearest one on the primary chain
+    fn nearest<'a>(&'a self, class: &'a str, method: &str) -> Option<(&'a str, &'a MethodInfo)> {
+        self.primary_chain(class)
+            .into_iter()
+            .find_map(|c| Some((c, self.method(c, method)?)))
+    }
+
+    /// `Decl::method` a `class` object runs, `None` if pure or unknown
+    pub fn implementation(&self, class: &str, method: &str) -> Option<String> {
+        let (decl, info) = self.nearest(class, method)?;
+        (!info.is_pure).then(|| format!("{}::{}", decl, method))
+    }
+
+    pub fn is_static(&self, class: &str, method: &str) -> bool {
+        self.nearest(class, method).map_or(false, |(_, m)| m.is_static)
+    }
+
+    /// Vtable slots: the primary base's, then the virtuals `class` adds,
+    /// in declaration order
+    pub fn slots(&self, class: &str) -> Vec<String> {
+        let mut slots = Vec::new();
+        for c in self.primary_chain(class).into_iter().rev() {
+            for m in &self.classes[c].methods {
+                if self.is_virtual(c, &m.name) && !m.is_static && !slots.contains(&m.name) {
+                    slots.push(m.name.clone());
+                }
+            }
+        }
+        slots
+    }
+
+    /// Vtable contents: one implementation per slot (`None` = pure)
+    pub fn vtable(&self, class: &str) -> Vec<Option<String>> {
+        self.slots(class).iter().map(|m| self.implementation(class, m)).collect()
+    }
+
+    pub fn is_polymorphic(&self, class: &str) -> bool {
+        self.contains(class) && !self.slots(class).is_empty()
+    }
+
+    /// Adds the vptr field: polymorphic, and no primary base brings one
+    pub fn owns_vptr(&self, class: &str) -> bool {
+        self.is_polymorphic(class) && !self.primary_base(class).map_or(false, |b| self.is_polymorphic(b))
+    }
+
+    /// Every class deriving from `class`, directly or not
+    pub fn subclasses(&self, class: &str) -> Vec<&str> {
+        let mut out: Vec<&str> = Vec::new();
+        let mut work = vec![class];
+        while let Some(c) = work.pop() {
+            for info in self.classes.values() {
+                if info.bases.iter().any(|b| b == c) && !out.contains(&info.name.as_str()) {
+                    out.push(&info.name);
+                    work.push(&info.name);
+                }
+            }
+        }
+        out
+    }
+
+    /// How `object.method()` dispatches when the object's static type is
+    /// `class`; `exact` when its dynamic type is known to be `class`.
+    /// `None`: not resolvable here (unknown class, or a virtual reached only
+    /// through a secondary base).
+    pub fn dispatch(&self, class: &str, method: &str, exact: bool) -> Option<Dispatch> {
+        let (decl, info) = self.nearest(class, method)?;
+        let direct = || Some(Dispatch::Direct(format!("{}::{}", decl, method)));
+        if !self.is_virtual(class, method) || info.is_static {
+            return direct();
+        }
+        let sealed = exact || info.is_final || self.classes[class].is_final;
+        if sealed && !info.is_pure {
+            return direct();
+        }
+        if self.closed {
+            let mut impls: Vec<Option<String>> = std::iter::once(class)
+                .chain(self.subclasses(class))
+                .filter(|c| !self.is_abstract(c))
+                .map(|c| self.implementation(c, method))
+                .collect();
+            impls.sort();
+            impls.dedup();
+            if let [Some(only)] = impls.as_slice() {
+                return Some(Dispatch::Direct(only.clone()));
+            }
+        }
+        let slot = self.slots(class).iter().position(|m| m == method)?;
+        Some(Dispatch::Slot(slot as u32))
+    }
+
+    /// Some slot has no implementation: never instantiated
+    fn is_abstract(&self, class: &str) -> bool {
+        self.vtable(class).iter().any(|m| m.is_none())
+    }
+}
+
+/// Class info from a class body
+pub fn class_info(name: &str, bases: &[CppBaseClass], members: &[CppClassMember], is_final: bool,
+    mangle: impl Fn(&str) -> String,
+) -> ClassInfo {
+    let methods = members
+        .iter()
+        .filter_map(|m| match m {
+            CppClassMember::Method { name, qualifiers: q, .. } => Some(MethodInfo {
+                name: mangle(name),
+                is_virtual: q.is_virtual || q.is_override || q.is_final || q.is_pure_virtual,
+                is_final: q.is_final,
+                is_pure: q.is_pure_virtual,
+                is_static: q.is_static,
+            }),
+            _ => None,
+        })
+        .collect();
+    ClassInfo {
+        name: name.to_string(),
+        bases: bases.iter().map(|b| b.name.clone()).collect(),
+        is_final,
+        methods,
+    }
+}
+
+/// Locals whose value may change after their declaration: assigned,
+/// incremented, address-taken or handed to a call (which may take them
+/// by reference), plus names declared more than once (a shadowing
+/// declaration would be mistaken for the outer one). Only the others keep
+/// the dynamic type they were initialized with.
+pub fn unstable_locals(params: &[CppParam], body: &[CppStmt]) -> HashSet<String> {
+    fn name(e: &CppExpr) -> Option<String> {
+        match e {
+            CppExpr::Identifier(n) => Some(n.clone()),
+            _ => None,
+        }
+    }
+    /// Names declared by `stmts`, not counting lambda bodies
+    fn declarations<'a>(stmts: impl IntoIterator<Item = &'a CppStmt>, out: &mut Vec<&'a str>) {
+        for stmt in stmts {
+            match stmt {
+                CppStmt::VarDecl { declarators, .. } => out.extend(declarators.iter().map(|d| d.name.as_str())),
+                CppStmt::RangeFor { name, .. } => out.push(name),
+                _ => {}
+            }
+            declarations(stmt.parts().1, out);
+        }
+    }
+
+    let mut out = HashSet::new();
+    let mut declared: Vec<&str> = params.iter().filter_map(|p| p.name.as_deref()).collect();
+    declarations(body, &mut declared);
+    visit_exprs(body, &mut |e| match e {
+        CppExpr::Assign { target, .. } | CppExpr::CompoundAssign { target, .. } | CppExpr::AddressOf(target) => {
+            out.extend(name(target))
+        }
+        CppExpr::UnaryOp { op: CppUnaryOp::PreInc | CppUnaryOp::PreDec | CppUnaryOp::PostInc | CppUnaryOp::PostDec, expr, .. } => {
+            out.extend(name(expr))
+        }
+        CppExpr::Call { args, .. } | CppExpr::New { args, .. } => out.extend(args.iter().filter_map(name)),
+        CppExpr::Lambda { captures, params, body, .. } => {
+            out.extend(captures.iter().filter_map(|c| match c {
+                CppCapture::ByRef(n) => Some(n.clone()),
+                _ => None,
+            }));
+            declared.extend(params.iter().filter_map(|p| p.name.as_deref()));
+            declarations(body, &mut declared);
+        }
+        _ => {}
+    });
+    declared.sort_unstable();
+    out.extend(declared.windows(2).filter(|w| w[0] == w[1]).map(|w| w[0].to_string()));
+    out
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn method(name: &str, is_virtual: bool) -> MethodInfo {
+        MethodInfo { name: name.into(), is_virtual, is_final: false, is_pure: false, is_static: false }
+    }
+
+    fn class(name: &str, bases: &[&str], methods: Vec<MethodInfo>) -> ClassInfo {
+        ClassInfo { name: name.into(), bases: bases.iter().map(|b| b.to_string()).collect(), is_final: false, methods }
+    }
+
+    #[test]
+    fn test_slots_extend_the_primary_base() {
+        let mut h = ClassHierarchy::new(false);
+        h.add(class("Shape", &[], vec![method("area", true), method("name", true), method("id", false)]));
+        h.add(class("Circle", &["Shape"], vec![method("name", false), method("radius", true)]));
+        assert_eq!(h.slots("Circle"), vec!["area", "name", "radius"]);
+        assert_eq!(h.vtable("Circle")[1].as_deref(), Some("Circle::name"));
+        assert_eq!(h.vtable("Circle")[0].as_deref(), Some("Shape::area"));
+        assert!(h.owns_vptr("Shape") && !h.owns_vptr("Circle"));
+        // Open hierarchy: only the slot is known
+        assert_eq!(h.dispatch("Shape", "name", false), Some(Dispatch::Slot(1)));
+        assert_eq!(h.dispatch("Shape", "id", false), Some(Dispatch::Direct("Shape::id".into())));
+        assert_eq!(h.dispatch("Shape", "name", true), Some(Dispatch::Direct("Shape::name".into())));
+    }
+
+    #[test]
+    fn test_closed_hierarchy_single_implementation() {
+        let mut pure = method("run", true);
+        pure.is_pure = true;
+        let mut h = ClassHierarchy::new(true);
+        h.add(class("Plugin", &[], vec![pure, method("stop", true)]));
+        h.add(class("Echo", &["Plugin"], vec![method("run", true)]));
+        assert_eq!(h.dispatch("Plugin", "run", false), Some(Dispatch::Direct("Echo::run".into())));
+        h.add(class("Gain", &["Plugin"], vec![method("run", true), method("stop", true)]));
+        assert_eq!(h.dispatch("Plugin", "run", false), Some(Dispatch::Slot(0)));
+        assert_eq!(h.dispatch("Echo", "stop", false), Some(Dispatch::Direct("Plugin::stop".into())));
+    }
+
+    #[test]
+    fn test_unstable_locals() {
+        let ident = |n: &str| CppExpr::Identifier(n.into());
+        let decl = |n: &str| CppStmt::VarDecl {
+            type_spec: CppType::Pointer(Box::new(CppType::Named("Plugin".into()))),
+            declarators: vec![CppDeclarator { name: n.into(), derived_type: Vec::new(), initializer: None }],
+        };
+        let body = vec![
+            decl("a"),
+            decl("b"),
+            decl("c"),
+            CppStmt::Expr(CppExpr::Assign { target: Box::new(ident("a")), value: Box::new(ident("b")) }),
+            CppStmt::Block(vec![decl("c")]),
+            CppStmt::Expr(CppExpr::Call { callee: Box::new(ident("f")), args: vec![ident("b")] }),
+        ];
+        let mut unstable: Vec<String> = unstable_locals(&[], &body).into_iter().collect();
+        unstable.sort();
+        assert_eq!(unstable, vec!["a", "b", "c"]);
+        assert!(unstable_locals(&[], &body[..2]).is_empty());
+    }
+}
@@ -0,0 +1,224 @@
+// ============================================================
+// Template Instantiation Table
+// ============================================================
+// Every (template, args) pair the lowering meets is keyed by a hash
+// of its canonical spelling (`max<int>`, `Box<const char*>`) and the
+// template definition it comes from. A pair is lowered the first
+// time it is requested and never again: later requests just get the
+// symbol back.
+//
+// Multi-file builds share lowered instantiations through
+// `SharedInstances`: a TU that needs `max<int>` reuses the IR another
+// TU (or an earlier build, via the object cache) already produced.
+// ============================================================
+
+use crate::ast::CppType;
+use crate::frontend::ast::{Function, Struct};
+use adeb_core::cache::hasher::hash_bytes;
+use serde::{Deserialize, Serialize};
+use std::collections::{HashMap, HashSet, VecDeque};
+use std::sync::{Arc, Mutex};
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
+pub enum InstanceKind {
+    Function,
+    Class,
+}
+
+/// One requested instantiation
+#[derive(Debug, Clone)]
+pub struct Instance {
+    /// Hash of the symbol and of the template definition
+    pub key: u64,
+    pub kind: InstanceKind,
+    pub template: String,
+    pub args: Vec<CppType>,
+    /// Canonical spelling, also the IR name: `max<int>`
+    pub symbol: String,
+}
+
+/// `name<arg, ...>` with canonical argument spellings
+pub fn instance_symbol(template: &str, args: &[CppType]) -> String {
+    let spelled: Vec<String> = args.iter().map(|a| a.spelling()).collect();
+    format!("{}<{}>", template, spelled.join(", "))
+}
+
+/// Key of an instantiation: its symbol combined with the definition's
+/// fingerprint, so two TUs with different bodies for `max` never share
+pub fn instance_key(symbol: &str, definition: u64) -> u64 {
+    hash_bytes(symbol.as_bytes()) ^ definition.rotate_left(1)
+}
+
+/// Instantiations of one TU: every key seen so far and the worklist of
+/// the ones still to lower, in request order
+#[derive(Debug, Default)]
+pub struct InstantiationTable {
+    index: HashMap<u64, String>,
+    pending: VecDeque<Instance>,
+    /// Keys requested while the current instance is being lowered
+    recording: Option<Vec<u64>>,
+}
+
+impl InstantiationTable {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Symbol for (template, args); queues it for lowering on first sight
+    pub fn request(&mut self, kind: InstanceKind, template: &str, args: &[CppType], definition: u64) -> String {
+        let symbol = instance_symbol(template, args);
+        let key = instance_key(&symbol, definition);
+        if let Some(deps) = &mut self.recording {
+            deps.push(key);
+        }
+        if !self.index.contains_key(&key) {
+            self.index.insert(key, symbol.clone());
+            self.pending.push_back(Instance {
+                key,
+                kind,
+                template: template.to_string(),
+                args: args.to_vec(),
+                symbol: symbol.clone(),
+            });
+        }
+        symbol
+    }
+
+    /// Next instantiation to lower, taken off the worklist
+    pub fn next_pending(&mut self) -> Option<Instance> {
+        self.pending.pop_front()
+    }
+
+    /// Whether `key` was requested (lowered or pending)
+    pub fn contains(&self, key: u64) -> bool {
+        self.index.contains_key(&key)
+    }
+
+    /// Records an instantiation reused from elsewhere as already lowered
+    pub fn mark_lowered(&mut self, key: u64, symbol: &str) {
+        self.index.entry(key).or_insert_with(|| symbol.to_string());
+    }
+
+    /// Starts collecting the keys requested by one instance's body
+    pub fn begin_recording(&mut self) {
+        self.recording = Some(Vec::new());
+    }
+
+    pub fn end_recording(&mut self) -> Vec<u64> {
+        self.recording.take().unwrap_or_default()
+    }
+
+    /// Distinct instantiations requested so far
+    pub fn len(&self) -> usize {
+        self.index.len()
+    }
+}
+
+/// The IR one instantiation lowered to, plus the instantiations its body
+/// needs (by key) so a reuse can bring them along
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct LoweredInstance {
+    pub key: u64,
+    pub kind: InstanceKind,
+    pub symbol: String,
+    pub functions: Vec<Function>,
+    pub structs: Vec<Struct>,
+    pub requires: Vec<u64>,
+}
+
+/// Lowered instantiations shared by every TU of a build. Entries are keyed
+/// by instance key mixed with the TU context (enums, aliases) the body
+/// was lowered under; see `CppToIR::context_hash`.
+#[derive(Debug, Clone, Default)]
+pub struct SharedInstances {
+    entries: Arc<Mutex<HashMap<u64, LoweredInstance>>>,
+    used: Arc<Mutex<HashSet<u64>>>,
+}
+
+impl SharedInstances {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Store seeded with entries from an earlier build
+    pub fn from_entries(entries: Vec<(u64, LoweredInstance)>) -> Self {
+        let shared = Self::new();
+        shared.entries.lock().unwrap().extend(entries);
+        shared
+    }
+
+    /// The entry and everything it transitively requires, or `None` if any
+    /// of them is missing
+    pub fn closure(&self, key: u64) -> Option<Vec<LoweredInstance>> {
+        let entries = self.entries.lock().unwrap();
+        let mut out = Vec::new();
+        let mut seen = HashSet::new();
+        let mut work = vec![key];
+        while let Some(k) = work.pop() {
+            if !seen.insert(k) {
+                continue;
+            }
+            let entry = entries.get(&k)?;
+            work.extend(entry.requires.iter().copied());
+            out.push(entry.clone());
+        }
+        self.used.lock().unwrap().extend(seen);
+        Some(out)
+    }
+
+    /// First writer wins: two TUs racing on one instance lowered the same IR
+    pub fn insert(&self, key: u64, lowered: LoweredInstance) {
+        self.used.lock().unwrap().insert(key);
+        self.entries.lock().unwrap().entry(key).or_insert(lowered);
+    }
+
+    pub fn len(&self) -> usize {
+        self.entries.lock().unwrap().len()
+    }
+
+    /// Entries this build inserted or reused, for persisting
+    pub fn used_entries(&self) -> Vec<(u64, LoweredInstance)> {
+        let used = self.used.lock().unwrap();
+        let entries = self.entries.lock().unwrap();
+        let mut out: Vec<_> = used.iter().filter_map(|k| Some((*k, entries.get(k)?.clone()))).collect();
+        out.sort_by_key(|(k, _)| *k);
+        out
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_request_dedups_by_canonical_spelling() {
+        let mut table = InstantiationTable::new();
+        let a = table.request(InstanceKind::Function, "max", &[CppType::Int], 7);
+        let b = table.request(InstanceKind::Function, "max", &[CppType::Signed(Box::new(CppType::Int))], 7);
+        assert_eq!(a, "max<int>");
+        assert_eq!(a, b);
+        assert!(table.next_pending().is_some());
+        assert!(table.next_pending().is_none());
+        // A different definition of `max` is a different instantiation
+        table.request(InstanceKind::Function, "max", &[CppType::Int], 8);
+        assert!(table.next_pending().is_some());
+    }
+
+    #[test]
+    fn test_shared_closure_needs_every_dependency() {
+        let entry = |key, requires| LoweredInstance {
+            key,
+            kind: InstanceKind::Function,
+            symbol: format!("f{}", key),
+            functions: Vec::new(),
+            structs: Vec::new(),
+            requires,
+        };
+        let shared = SharedInstances::new();
+        shared.insert(1, entry(1, vec![2]));
+        assert!(shared.closure(1).is_none());
+        shared.insert(2, entry(2, vec![1]));
+        assert_eq!(shared.closure(1).unwrap().len(), 2);
+        assert_eq!(shared.used_entries().len(), 2);
+    }
+}
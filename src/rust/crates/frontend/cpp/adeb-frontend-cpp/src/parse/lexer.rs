@@ -7,6 +7,8 @@
 // Sin GCC. Sin LLVM. Sin Clang. Solo ADead-BIB. 💀🦈
 // ============================================================
 
+use adeb_core::interner::{Ident, IdentCache};
+
 #[derive(Debug, Clone, PartialEq)]
 #[allow(non_camel_case_types)]
 pub enum CppToken {
@@ -18,7 +20,7 @@ pub enum CppToken {
     CharLiteral(char),
 
     // Identifier
-    Identifier(String),
+    Identifier(Ident),
 
     // C keywords (shared with C)
     Auto,
@@ -170,20 +172,26 @@ pub enum CppToken {
     Eof,
 }
 
-pub struct CppLexer {
-    chars: Vec<char>,
+/// Lexer sobre los bytes del source (sin `Vec<char>`): identificadores y
+/// keywords se cortan como slices y sólo los identificadores se internan.
+pub struct CppLexer<'a> {
+    src: &'a str,
+    bytes: &'a [u8],
     pos: usize,
     pub line: usize,
     pub column: usize,
+    idents: IdentCache<'a>,
 }
 
-impl CppLexer {
-    pub fn new(source: &str) -> Self {
+impl<'a> CppLexer<'a> {
+    pub fn new(source: &'a str) -> Self {
         Self {
-            chars: source.chars().collect(),
+            src: source,
+            bytes: source.as_bytes(),
             pos: 0,
             line: 1,
             column: 1,
+            idents: IdentCache::new(),
         }
     }
 
@@ -204,34 +212,43 @@ impl CppLexer {
         (tokens, lines)
     }
 
-    fn peek(&self) -> char {
-        self.chars.get(self.pos).copied().unwrap_or('\0')
+    #[inline]
+    fn peek(&self) -> u8 {
+        self.bytes.get(self.pos).copied().unwrap_or(0)
     }
 
-    fn peek_at(&self, offset: usize) -> char {
-        self.chars.get(self.pos + offset).copied().unwrap_or('\0')
+    #[inline]
+    fn peek_at(&self, offset: usize) -> u8 {
+        self.bytes.get(self.pos + offset).copied().unwrap_or(0)
     }
 
+    /// Avanza un carácter completo (UTF-8) y lo devuelve
     fn advance(&mut self) -> char {
-        let ch = self.peek();
-        self.pos += 1;
-        if ch == '\n' {
-            self.line += 1;
-            self.column = 1;
-        } else {
-            self.column += 1;
+        let b = self.peek();
+        if b < 0x80 {
+            self.pos += 1;
+            if b == b'\n' {
+                self.line += 1;
+                self.column = 1;
+            } else {
+                self.column += 1;
+            }
+            return b as char;
         }
+        let ch = self.src[self.pos..].chars().next().unwrap_or('\0');
+        self.pos += ch.len_utf8();
+        self.column += 1;
         ch
     }
 
     fn skip_whitespace(&mut self) {
-        while self.pos < self.chars.len() && self.peek().is_ascii_whitespace() {
+        while self.pos < self.bytes.len() && self.peek().is_ascii_whitespace() {
             self.advance();
         }
     }
 
     fn skip_line_comment(&mut self) {
-        while self.pos < self.chars.len() && self.peek() != '\n' {
+        while self.pos < self.bytes.len() && self.peek() != b'\n' {
             self.advance();
         }
     }
@@ -239,8 +256,8 @@ impl CppLexer {
     fn skip_block_comment(&mut self) {
         self.advance(); // skip /
         self.advance(); // skip *
-        while self.pos + 1 < self.chars.len() {
-            if self.peek() == '*' && self.peek_at(1) == '/' {
+        while self.pos + 1 < self.bytes.len() {
+            if self.peek() == b'*' && self.peek_at(1) == b'/' {
                 self.advance();
                 self.advance();
                 return;
@@ -250,14 +267,21 @@ impl CppLexer {
     }
 
     fn skip_preprocessor_line(&mut self) {
-        let mut line_str = String::new();
-        while self.pos < self.chars.len() {
+        let start = self.pos;
+        let mut spliced = false;
+        while self.pos < self.bytes.len() {
             let ch = self.peek();
-            if ch == '\n' {
+            if ch == b'\n' {
                 // Check if this was a line marker from gcc (e.g. `# 12 "file.c"`)
-                let parts: Vec<&str> = line_str.split_whitespace().collect();
-                if parts.len() >= 2 {
-                    if let Ok(num) = parts[1].parse::<usize>() {
+                let text = &self.src[start..self.pos];
+                let line_str = if spliced {
+                    std::borrow::Cow::Owned(text.replace("\\\n", ""))
+                } else {
+                    std::borrow::Cow::Borrowed(text)
+                };
+                let mut parts = line_str.split_whitespace();
+                if let (Some(_), Some(num)) = (parts.next(), parts.next()) {
+                    if let Ok(num) = num.parse::<usize>() {
                         // The advance() below will consume \n and add 1
                         self.line = num.saturating_sub(1);
                     }
@@ -265,24 +289,25 @@ impl CppLexer {
                 self.advance();
                 break;
             }
-            if ch == '\\' && self.peek_at(1) == '\n' {
+            if ch == b'\\' && self.peek_at(1) == b'\n' {
+                spliced = true;
                 self.advance(); // consume \
                 self.advance(); // consume \n
                 continue;
             }
-            line_str.push(ch);
             self.advance();
         }
     }
 
-    fn read_identifier(&mut self) -> String {
+    fn read_identifier(&mut self) -> &'a str {
         let start = self.pos;
-        while self.pos < self.chars.len()
-            && (self.peek().is_ascii_alphanumeric() || self.peek() == '_')
+        while self.pos < self.bytes.len()
+            && (self.peek().is_ascii_alphanumeric() || self.peek() == b'_')
         {
-            self.advance();
+            self.pos += 1;
+            self.column += 1;
         }
-        self.chars[start..self.pos].iter().collect()
+        &self.src[start..self.pos]
     }
 
     fn read_number(&mut self) -> CppToken {
@@ -291,50 +316,51 @@ impl CppLexer {
         let mut is_hex = false;
 
         // Hex
-        if self.peek() == '0' && (self.peek_at(1) == 'x' || self.peek_at(1) == 'X') {
+        if self.peek() == b'0' && (self.peek_at(1) == b'x' || self.peek_at(1) == b'X') {
             self.advance(); // 0
             self.advance(); // x
             is_hex = true;
-            while self.pos < self.chars.len() && self.peek().is_ascii_hexdigit() {
+            while self.pos < self.bytes.len() && self.peek().is_ascii_hexdigit() {
                 self.advance();
             }
-        } else if self.peek() == '0' && (self.peek_at(1) == 'b' || self.peek_at(1) == 'B') {
+        } else if self.peek() == b'0' && (self.peek_at(1) == b'b' || self.peek_at(1) == b'B') {
             // C++14 binary literals: 0b10101010
             self.advance(); // 0
             self.advance(); // b
             let bin_start = self.pos;
-            while self.pos < self.chars.len() && matches!(self.peek(), '0' | '1' | '\'') {
+            while self.pos < self.bytes.len() && matches!(self.peek(), b'0' | b'1' | b'\'') {
                 self.advance();
             }
-            let bin_str: String = self.chars[bin_start..self.pos].iter()
-                .filter(|c| **c != '\'')
+            let bin_str: String = self.src[bin_start..self.pos]
+                .chars()
+                .filter(|c| *c != '\'')
                 .collect();
             // Skip suffixes
-            while self.pos < self.chars.len() && matches!(self.peek(), 'u' | 'U' | 'l' | 'L') {
+            while self.pos < self.bytes.len() && matches!(self.peek(), b'u' | b'U' | b'l' | b'L') {
                 self.advance();
             }
             let val = i64::from_str_radix(&bin_str, 2).unwrap_or(0);
             return CppToken::IntLiteral(val);
         } else {
             // Decimal / float
-            while self.pos < self.chars.len() && self.peek().is_ascii_digit() {
+            while self.pos < self.bytes.len() && self.peek().is_ascii_digit() {
                 self.advance();
             }
-            if self.peek() == '.' && self.peek_at(1).is_ascii_digit() {
+            if self.peek() == b'.' && self.peek_at(1).is_ascii_digit() {
                 is_float = true;
                 self.advance(); // .
-                while self.pos < self.chars.len() && self.peek().is_ascii_digit() {
+                while self.pos < self.bytes.len() && self.peek().is_ascii_digit() {
                     self.advance();
                 }
             }
             // Scientific notation
-            if self.peek() == 'e' || self.peek() == 'E' {
+            if self.peek() == b'e' || self.peek() == b'E' {
                 is_float = true;
                 self.advance();
-                if self.peek() == '+' || self.peek() == '-' {
+                if self.peek() == b'+' || self.peek() == b'-' {
                     self.advance();
                 }
-                while self.pos < self.chars.len() && self.peek().is_ascii_digit() {
+                while self.pos < self.bytes.len() && self.peek().is_ascii_digit() {
                     self.advance();
                 }
             }
@@ -344,14 +370,14 @@ impl CppLexer {
         let mut is_unsigned = false;
         loop {
             match self.peek() {
-                'u' | 'U' => {
+                b'u' | b'U' => {
                     is_unsigned = true;
                     self.advance();
                 }
-                'l' | 'L' => {
+                b'l' | b'L' => {
                     self.advance();
                 }
-                'f' | 'F' => {
+                b'f' | b'F' => {
                     is_float = true;
                     self.advance();
                 }
@@ -359,7 +385,7 @@ impl CppLexer {
             }
         }
 
-        let text: String = self.chars[start..self.pos].iter().collect();
+        let text = &self.src[start..self.pos];
         let clean: String = text
             .chars()
             .filter(|c| !matches!(c, 'u' | 'U' | 'l' | 'L' | 'f' | 'F'))
@@ -384,39 +410,39 @@ impl CppLexer {
     fn read_string(&mut self) -> String {
         self.advance(); // skip opening "
         let mut s = String::new();
-        while self.pos < self.chars.len() && self.peek() != '"' {
-            if self.peek() == '\\' {
+        while self.pos < self.bytes.len() && self.peek() != b'"' {
+            if self.peek() == b'\\' {
                 self.advance();
                 match self.peek() {
-                    'n' => {
+                    b'n' => {
                         s.push('\n');
                         self.advance();
                     }
-                    't' => {
+                    b't' => {
                         s.push('\t');
                         self.advance();
                     }
-                    'r' => {
+                    b'r' => {
                         s.push('\r');
                         self.advance();
                     }
-                    '\\' => {
+                    b'\\' => {
                         s.push('\\');
                         self.advance();
                     }
-                    '"' => {
+                    b'"' => {
                         s.push('"');
                         self.advance();
                     }
-                    '\'' => {
+                    b'\'' => {
                         s.push('\'');
                         self.advance();
                     }
-                    '0' => {
+                    b'0' => {
                         s.push('\0');
                         self.advance();
                     }
-                    'x' => {
+                    b'x' => {
                         self.advance();
                         let mut hex = String::new();
                         for _ in 0..2 {
@@ -428,16 +454,15 @@ impl CppLexer {
                             s.push(n as char);
                         }
                     }
-                    other => {
-                        s.push(other);
-                        self.advance();
+                    _ => {
+                        s.push(self.advance());
                     }
                 }
             } else {
                 s.push(self.advance());
             }
         }
-        if self.peek() == '"' {
+        if self.peek() == b'"' {
             self.advance();
         }
         s
@@ -445,7 +470,7 @@ impl CppLexer {
 
     fn read_char_literal(&mut self) -> char {
         self.advance(); // skip '
-        let ch = if self.peek() == '\\' {
+        let ch = if self.peek() == b'\\' {
             self.advance();
             match self.advance() {
                 'n' => '\n',
@@ -459,13 +484,13 @@ impl CppLexer {
         } else {
             self.advance()
         };
-        if self.peek() == '\'' {
+        if self.peek() == b'\'' {
             self.advance();
         }
         ch
     }
 
-    fn keyword_or_ident(&mut self, word: &str) -> CppToken {
+    fn keyword_or_ident(&mut self, word: &'a str) -> CppToken {
         match word {
             // C keywords
             "auto" => CppToken::Auto,
@@ -558,13 +583,13 @@ impl CppLexer {
 
             // __declspec(...) — skip entirely (MSVC extension)
             "__declspec" => {
-                if self.pos < self.chars.len() && self.chars[self.pos] == '(' {
+                if self.pos < self.bytes.len() && self.bytes[self.pos] == b'(' {
                     self.advance(); // (
                     let mut depth = 1i32;
-                    while self.pos < self.chars.len() && depth > 0 {
-                        match self.chars[self.pos] {
-                            '(' => { depth += 1; self.pos += 1; }
-                            ')' => { depth -= 1; self.pos += 1; }
+                    while self.pos < self.bytes.len() && depth > 0 {
+                        match self.bytes[self.pos] {
+                            b'(' => { depth += 1; self.pos += 1; }
+                            b')' => { depth -= 1; self.pos += 1; }
                             _ => { self.pos += 1; }
                         }
                     }
@@ -574,13 +599,13 @@ impl CppLexer {
 
             // __attribute__((...)) — skip entirely (GCC extension)
             "__attribute__" => {
-                if self.pos < self.chars.len() && self.chars[self.pos] == '(' {
+                if self.pos < self.bytes.len() && self.bytes[self.pos] == b'(' {
                     self.advance(); // (
                     let mut depth = 1i32;
-                    while self.pos < self.chars.len() && depth > 0 {
-                        match self.chars[self.pos] {
-                            '(' => { depth += 1; self.pos += 1; }
-                            ')' => { depth -= 1; self.pos += 1; }
+                    while self.pos < self.bytes.len() && depth > 0 {
+                        match self.bytes[self.pos] {
+                            b'(' => { depth += 1; self.pos += 1; }
+                            b')' => { depth -= 1; self.pos += 1; }
                             _ => { self.pos += 1; }
                         }
                     }
@@ -599,13 +624,13 @@ impl CppLexer {
             | "_COM_Outptr_" | "_Field_size_" | "_Field_size_bytes_"
             | "__in" | "__out" | "__inout" | "__in_opt" | "__out_opt" => {
                 // If followed by ( ), skip the parenthesized args too
-                if self.pos < self.chars.len() && self.chars[self.pos] == '(' {
+                if self.pos < self.bytes.len() && self.bytes[self.pos] == b'(' {
                     self.advance();
                     let mut depth = 1i32;
-                    while self.pos < self.chars.len() && depth > 0 {
-                        match self.chars[self.pos] {
-                            '(' => { depth += 1; self.pos += 1; }
-                            ')' => { depth -= 1; self.pos += 1; }
+                    while self.pos < self.bytes.len() && depth > 0 {
+                        match self.bytes[self.pos] {
+                            b'(' => { depth += 1; self.pos += 1; }
+                            b')' => { depth -= 1; self.pos += 1; }
                             _ => { self.pos += 1; }
                         }
                     }
@@ -623,29 +648,29 @@ impl CppLexer {
             }
 
             // Identifier
-            _ => CppToken::Identifier(word.to_string()),
+            _ => CppToken::Identifier(self.idents.intern(word)),
         }
     }
 
     pub fn next_token(&mut self) -> CppToken {
         loop {
             self.skip_whitespace();
-            if self.pos >= self.chars.len() {
+            if self.pos >= self.bytes.len() {
                 return CppToken::Eof;
             }
 
             // Comments
-            if self.peek() == '/' && self.peek_at(1) == '/' {
+            if self.peek() == b'/' && self.peek_at(1) == b'/' {
                 self.skip_line_comment();
                 continue;
             }
-            if self.peek() == '/' && self.peek_at(1) == '*' {
+            if self.peek() == b'/' && self.peek_at(1) == b'*' {
                 self.skip_block_comment();
                 continue;
             }
 
             // Preprocessor — skip entire line
-            if self.peek() == '#' {
+            if self.peek() == b'#' {
                 self.skip_preprocessor_line();
                 continue;
             }
@@ -653,34 +678,34 @@ impl CppLexer {
             break;
         }
 
-        if self.pos >= self.chars.len() {
+        if self.pos >= self.bytes.len() {
             return CppToken::Eof;
         }
 
         let ch = self.peek();
 
         // Wide/Unicode string literal prefixes: L"", u"", U"", u8""
-        if (ch == 'L' || ch == 'U') && self.peek_at(1) == '"' {
+        if (ch == b'L' || ch == b'U') && self.peek_at(1) == b'"' {
             self.advance(); // skip prefix
             return CppToken::StringLiteral(self.read_string());
         }
-        if ch == 'u' && self.peek_at(1) == '"' {
+        if ch == b'u' && self.peek_at(1) == b'"' {
             self.advance(); // skip u
             return CppToken::StringLiteral(self.read_string());
         }
-        if ch == 'u' && self.peek_at(1) == '8' && self.peek_at(2) == '"' {
+        if ch == b'u' && self.peek_at(1) == b'8' && self.peek_at(2) == b'"' {
             self.advance(); // skip u
             self.advance(); // skip 8
             return CppToken::StringLiteral(self.read_string());
         }
         // Wide/Unicode char literal prefixes: L'x', u'x', U'x'
-        if (ch == 'L' || ch == 'U' || ch == 'u') && self.peek_at(1) == '\'' {
+        if (ch == b'L' || ch == b'U' || ch == b'u') && self.peek_at(1) == b'\'' {
             self.advance(); // skip prefix
             return CppToken::CharLiteral(self.read_char_literal());
         }
 
         // Identifiers and keywords
-        if ch.is_ascii_alphabetic() || ch == '_' {
+        if ch.is_ascii_alphabetic() || ch == b'_' {
             let word = self.read_identifier();
             return self.keyword_or_ident(&word);
         }
@@ -690,51 +715,52 @@ impl CppLexer {
             return self.read_number();
         }
         // Float starting with dot: .5
-        if ch == '.' && self.peek_at(1).is_ascii_digit() {
+        if ch == b'.' && self.peek_at(1).is_ascii_digit() {
             return self.read_number();
         }
 
         // String literals (including raw string R"(...)")
-        if ch == '"' {
+        if ch == b'"' {
             return CppToken::StringLiteral(self.read_string());
         }
         // Raw string prefix
-        if ch == 'R' && self.peek_at(1) == '"' {
+        if ch == b'R' && self.peek_at(1) == b'"' {
             self.advance(); // skip R
             return CppToken::StringLiteral(self.read_string());
         }
 
         // Character literal
-        if ch == '\'' {
+        if ch == b'\'' {
             return CppToken::CharLiteral(self.read_char_literal());
         }
 
         // Multi-character operators
+        let start = self.pos;
         self.advance();
         match ch {
-            '+' => {
-                if self.peek() == '+' {
+            b'+' => {
+                if self.peek() == b'+' {
                     self.advance();
                     return CppToken::Increment;
                 }
-                if self.peek() == '=' {
+                if self.peek() == b'=' {
                     self.advance();
                     return CppToken::PlusAssign;
                 }
                 CppToken::Plus
             }
-            '-' => {
-                if self.peek() == '-' {
+            b'-' => {
+                if self.peek() == b'-' {
                     self.advance();
                     return CppToken::Decrement;
                 }
-                if self.peek() == '=' {
+                if self.peek() == b'=' {
                     self.advance();
                     return CppToken::MinusAssign;
                 }
-                if self.peek() == '>' {
+                if self.peek() == b'>' {
                     self.advance();
-                    if self.peek() == '*' {
+                    if self.peek() == b'*' {
                         self.advance();
                         return CppToken::ArrowStar;
                     }
@@ -742,53 +768,53 @@ impl CppLexer {
                 }
                 CppToken::Minus
             }
-            '*' => {
-                if self.peek() == '=' {
+            b'*' => {
+                if self.peek() == b'=' {
                     self.advance();
                     return CppToken::StarAssign;
                 }
                 CppToken::Star
             }
-            '/' => {
-                if self.peek() == '=' {
+            b'/' => {
+                if self.peek() == b'=' {
                     self.advance();
                     return CppToken::SlashAssign;
                 }
                 CppToken::Slash
             }
-            '%' => {
-                if self.peek() == '=' {
+            b'%' => {
+                if self.peek() == b'=' {
                     self.advance();
                     return CppToken::PercentAssign;
                 }
                 CppToken::Percent
             }
-            '=' => {
-                if self.peek() == '=' {
+            b'=' => {
+                if self.peek() == b'=' {
                     self.advance();
                     return CppToken::Eq;
                 }
                 CppToken::Assign
             }
-            '!' => {
-                if self.peek() == '=' {
+            b'!' => {
+                if self.peek() == b'=' {
                     self.advance();
                     return CppToken::Ne;
                 }
                 CppToken::Not
             }
-            '<' => {
-                if self.peek() == '=' {
+            b'<' => {
+                if self.peek() == b'=' {
                     self.advance();
-                    if self.peek() == '>' {
+                    if self.peek() == b'>' {
                         self.advance();
                         return CppToken::Spaceship;
                     }
                     return CppToken::Le;
                 }
-                if self.peek() == '<' {
+                if self.peek() == b'<' {
                     self.advance();
-                    if self.peek() == '=' {
+                    if self.peek() == b'=' {
                         self.advance();
                         return CppToken::ShlAssign;
                     }
@@ -796,14 +822,14 @@ impl CppLexer {
                 }
                 CppToken::Lt
             }
-            '>' => {
-                if self.peek() == '=' {
+            b'>' => {
+                if self.peek() == b'=' {
                     self.advance();
                     return CppToken::Ge;
                 }
-                if self.peek() == '>' {
+                if self.peek() == b'>' {
                     self.advance();
-                    if self.peek() == '=' {
+                    if self.peek() == b'=' {
                         self.advance();
                         return CppToken::ShrAssign;
                     }
@@ -811,68 +837,68 @@ impl CppLexer {
                 }
                 CppToken::Gt
             }
-            '&' => {
-                if self.peek() == '&' {
+            b'&' => {
+                if self.peek() == b'&' {
                     self.advance();
                     return CppToken::And;
                 }
-                if self.peek() == '=' {
+                if self.peek() == b'=' {
                     self.advance();
                     return CppToken::AmpAssign;
                 }
                 CppToken::Amp
             }
-            '|' => {
-                if self.peek() == '|' {
+            b'|' => {
+                if self.peek() == b'|' {
                     self.advance();
                     return CppToken::Or;
                 }
-                if self.peek() == '=' {
+                if self.peek() == b'=' {
                     self.advance();
                     return CppToken::PipeAssign;
                 }
                 CppToken::Pipe
             }
-            '^' => {
-                if self.peek() == '=' {
+            b'^' => {
+                if self.peek() == b'=' {
                     self.advance();
                     return CppToken::CaretAssign;
                 }
                 CppToken::Caret
             }
-            '~' => CppToken::Tilde,
-            '?' => CppToken::Question,
-            ':' => {
-                if self.peek() == ':' {
+            b'~' => CppToken::Tilde,
+            b'?' => CppToken::Question,
+            b':' => {
+                if self.peek() == b':' {
                     self.advance();
                     return CppToken::Scope;
                 }
                 CppToken::Colon
             }
-            '.' => {
-                if self.peek() == '.' && self.peek_at(1) == '.' {
+            b'.' => {
+                if self.peek() == b'.' && self.peek_at(1) == b'.' {
                     self.advance();
                     self.advance();
                     return CppToken::Ellipsis;
                 }
-                if self.peek() == '*' {
+                if self.peek() == b'*' {
                     self.advance();
                     return CppToken::DotStar;
                 }
                 CppToken::Dot
             }
-            '(' => CppToken::LParen,
-            ')' => CppToken::RParen,
-            '[' => CppToken::LBracket,
-            ']' => CppToken::RBracket,
-            '{' => CppToken::LBrace,
-            '}' => CppToken::RBrace,
-            ';' => CppToken::Semicolon,
-            ',' => CppToken::Comma,
-            '#' => CppToken::Hash,
+            b'(' => CppToken::LParen,
+            b')' => CppToken::RParen,
+            b'[' => CppToken::LBracket,
+            b']' => CppToken::RBracket,
+            b'{' => CppToken::LBrace,
+            b'}' => CppToken::RBrace,
+            b';' => CppToken::Semicolon,
+            b',' => CppToken::Comma,
+            b'#' => CppToken::Hash,
             _ => {
                 // Skip unknown character
-                CppToken::Identifier(ch.to_string())
+                CppToken::Identifier(self.idents.intern(&self.src[start..self.pos]))
             }
         }
     }
@@ -886,7 +912,7 @@ mod tests {
     fn test_basic_cpp() {
         let tokens = CppLexer::new("int main() { return 0; }").tokenize().0;
         assert_eq!(tokens[0], CppToken::Int);
-        assert_eq!(tokens[1], CppToken::Identifier("main".to_string()));
+        assert_eq!(tokens[1], CppToken::Identifier(Ident::new("main")));
         assert_eq!(tokens[2], CppToken::LParen);
         assert_eq!(tokens[3], CppToken::RParen);
         assert_eq!(tokens[4], CppToken::LBrace);
@@ -902,10 +928,10 @@ mod tests {
             .tokenize()
             .0;
         assert_eq!(tokens[0], CppToken::Class);
-        assert_eq!(tokens[1], CppToken::Identifier("Foo".to_string()));
+        assert_eq!(tokens[1], CppToken::Identifier(Ident::new("Foo")));
         assert_eq!(tokens[2], CppToken::Colon);
         assert_eq!(tokens[3], CppToken::Public);
-        assert_eq!(tokens[4], CppToken::Identifier("Base".to_string()));
+        assert_eq!(tokens[4], CppToken::Identifier(Ident::new("Base")));
         assert_eq!(tokens[5], CppToken::LBrace);
         assert_eq!(tokens[6], CppToken::Virtual);
     }
@@ -913,9 +939,9 @@ mod tests {
     #[test]
     fn test_scope_operator() {
         let tokens = CppLexer::new("std::cout << x;").tokenize().0;
-        assert_eq!(tokens[0], CppToken::Identifier("std".to_string()));
+        assert_eq!(tokens[0], CppToken::Identifier(Ident::new("std")));
         assert_eq!(tokens[1], CppToken::Scope);
-        assert_eq!(tokens[2], CppToken::Identifier("cout".to_string()));
+        assert_eq!(tokens[2], CppToken::Identifier(Ident::new("cout")));
         assert_eq!(tokens[3], CppToken::Shl);
     }
 
@@ -935,7 +961,7 @@ mod tests {
         assert_eq!(tokens[0], CppToken::Template);
         assert_eq!(tokens[1], CppToken::Lt);
         assert_eq!(tokens[2], CppToken::Typename);
-        assert_eq!(tokens[3], CppToken::Identifier("T".to_string()));
+        assert_eq!(tokens[3], CppToken::Identifier(Ident::new("T")));
         assert_eq!(tokens[4], CppToken::Gt);
     }
 
@@ -943,7 +969,7 @@ mod tests {
     fn test_nullptr_and_auto() {
         let tokens = CppLexer::new("auto x = nullptr;").tokenize().0;
         assert_eq!(tokens[0], CppToken::Auto);
-        assert_eq!(tokens[1], CppToken::Identifier("x".to_string()));
+        assert_eq!(tokens[1], CppToken::Identifier(Ident::new("x")));
         assert_eq!(tokens[2], CppToken::Assign);
         assert_eq!(tokens[3], CppToken::Nullptr);
     }
@@ -951,12 +977,12 @@ mod tests {
     #[test]
     fn test_arrow_and_scope() {
         let tokens = CppLexer::new("ptr->member; Foo::bar").tokenize().0;
-        assert_eq!(tokens[0], CppToken::Identifier("ptr".to_string()));
+        assert_eq!(tokens[0], CppToken::Identifier(Ident::new("ptr")));
         assert_eq!(tokens[1], CppToken::Arrow);
-        assert_eq!(tokens[2], CppToken::Identifier("member".to_string()));
-        assert_eq!(tokens[4], CppToken::Identifier("Foo".to_string()));
+        assert_eq!(tokens[2], CppToken::Identifier(Ident::new("member")));
+        assert_eq!(tokens[4], CppToken::Identifier(Ident::new("Foo")));
         assert_eq!(tokens[5], CppToken::Scope);
-        assert_eq!(tokens[6], CppToken::Identifier("bar".to_string()));
+        assert_eq!(tokens[6], CppToken::Identifier(Ident::new("bar")));
     }
 
     #[test]
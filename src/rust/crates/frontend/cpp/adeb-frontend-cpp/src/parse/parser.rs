@@ -78,7 +78,7 @@ impl CppParser {
         match self.current().clone() {
             CppToken::Identifier(name) => {
                 self.advance();
-                Ok(name)
+                Ok(name.to_string())
             }
             other => Err(format!(
                 "Expected identifier, got {:?} at pos {}",
@@ -122,7 +122,7 @@ impl CppParser {
             | CppToken::Register
             | CppToken::Thread_local => true,
             CppToken::Identifier(name) => {
-                if self.type_names.contains(name) {
+                if self.type_names.contains(name.as_str()) {
                     // If followed by ::, check if the inner name is also a type
                     // to avoid treating namespace::function() as a type declaration
                     if *self.peek() == CppToken::Scope {
@@ -130,7 +130,7 @@ impl CppParser {
                             // If inner is a known type → type declaration (e.g., std::vector)
                             // If inner is NOT a type → likely function call (e.g., fs::exists)
                             // Also accept if inner is followed by < (template type)
-                            return self.type_names.contains(inner)
+                            return self.type_names.contains(inner.as_str())
                                 || *self.peek_at(3) == CppToken::Lt;
                         }
                     }
@@ -139,7 +139,7 @@ impl CppParser {
                 // Recognize namespace::type patterns (e.g. std::vector, std::string)
                 if *self.peek() == CppToken::Scope {
                     if let CppToken::Identifier(inner) = self.peek_at(2) {
-                        return self.type_names.contains(inner);
+                        return self.type_names.contains(inner.as_str());
                     }
                 }
                 false
@@ -302,7 +302,7 @@ impl CppParser {
                     if let Ok(args) = self.try_parse_template_args() {
                         Self::classify_template_type(&name, args)
                     } else {
-                        CppType::Named(name)
+                        CppType::Named(name.to_string())
                     }
                 } else {
                     // Check for scope: std::string, std::chrono::milliseconds, etc.
@@ -647,7 +647,7 @@ impl CppParser {
             match &self.tokens[i] {
                 CppToken::Class | CppToken::Struct => {
                     if let Some(CppToken::Identifier(name)) = self.tokens.get(i + 1) {
-                        self.type_names.insert(name.clone());
+                        self.type_names.insert(name.to_string());
                     }
                     i += 1;
                 }
@@ -670,7 +670,7 @@ impl CppParser {
                     }
                     if j > 0 && j < self.tokens.len() {
                         if let CppToken::Identifier(name) = &self.tokens[j - 1] {
-                            self.type_names.insert(name.clone());
+                            self.type_names.insert(name.to_string());
                         }
                     }
                     i = j + 1;
@@ -678,7 +678,7 @@ impl CppParser {
                 CppToken::Using => {
                     if let Some(CppToken::Identifier(name)) = self.tokens.get(i + 1) {
                         if self.tokens.get(i + 2) == Some(&CppToken::Assign) {
-                            self.type_names.insert(name.clone());
+                            self.type_names.insert(name.to_string());
                         }
                     }
                     i += 1;
@@ -690,7 +690,7 @@ impl CppParser {
                         j += 1;
                     }
                     if let Some(CppToken::Identifier(name)) = self.tokens.get(j) {
-                        self.type_names.insert(name.clone());
+                        self.type_names.insert(name.to_string());
                     }
                     i += 1;
                 }
@@ -1252,8 +1252,7 @@ impl CppParser {
         let name = self.expect_identifier()?;
         self.type_names.insert(name.clone());
 
-        // final
-        self.eat(&CppToken::Final);
+        let is_final = self.eat(&CppToken::Final);
 
         // Base classes
         let mut bases = Vec::new();
@@ -1322,6 +1321,7 @@ impl CppParser {
             bases,
             members,
             is_struct,
+            is_final,
         })
     }
 
@@ -1389,7 +1389,7 @@ impl CppParser {
                         break;
                     }
                     if let CppToken::Identifier(ref n) = self.current().clone() {
-                        friend_name = n.clone();
+                        friend_name = n.to_string();
                     }
                     self.advance();
                 }
@@ -1515,7 +1515,7 @@ impl CppParser {
             // Constructor check: ClassName(...)
             // A constructor has no return type — the identifier IS the class name and next is (
             if let CppToken::Identifier(ref ident) = self.current().clone() {
-                if *self.peek() == CppToken::LParen && self.type_names.contains(ident) {
+                if *self.peek() == CppToken::LParen && self.type_names.contains(ident.as_str()) {
                     // This could be a constructor or a method with return type = ClassName
                     // Heuristic: if the name matches a class name and it's followed by (
                     // and there's no type before it, it's likely a constructor
@@ -2239,7 +2239,7 @@ impl CppParser {
             CppToken::Identifier(ref name) => {
                 let n = name.clone();
                 self.advance();
-                return Ok(n);
+                return Ok(n.to_string());
             }
             _ => return Err(format!("Unknown operator {:?}", self.current())),
         };
@@ -2404,7 +2404,7 @@ impl CppParser {
                             self.advance();
                             self.advance();
                             let stmt = self.parse_statement()?;
-                            return Ok(CppStmt::Label(label, Box::new(stmt)));
+                            return Ok(CppStmt::Label(label.to_string(), Box::new(stmt)));
                         }
                     }
                     let expr = self.parse_expression()?;
@@ -3234,9 +3234,7 @@ impl CppParser {
                                 }
                                 _ => unreachable!(),
                             };
-                            let mangled = format!("{}<{}>", callee_name,
-                                targs.iter().map(|t| format!("{:?}", t)).collect::<Vec<_>>().join(", "));
-                            expr = CppExpr::Identifier(mangled);
+                            expr = CppExpr::TemplateId { name: callee_name, args: targs };
                             // Continue to let LParen/Scope/etc. handle what follows
                             continue;
                         }
@@ -3314,6 +3312,14 @@ impl CppParser {
                                 name: member,
                             };
                         }
+                        // Box<int>::make → scope "Box<int>"
+                        CppExpr::TemplateId { ref name, ref args } => {
+                            let spelled = args.iter().map(|a| a.spelling()).collect::<Vec<_>>().join(", ");
+                            expr = CppExpr::ScopedIdentifier {
+                                scope: vec![format!("{}<{}>", name, spelled)],
+                                name: member,
+                            };
+                        }
                         CppExpr::ScopedIdentifier { ref scope, ref name } => {
                             let mut new_scope = scope.clone();
                             new_scope.push(name.clone());
@@ -3382,7 +3388,7 @@ impl CppParser {
             }
             CppToken::Identifier(name) => {
                 self.advance();
-                Ok(CppExpr::Identifier(name))
+                Ok(CppExpr::Identifier(name.to_string()))
             }
             CppToken::LBrace => {
                 // Initializer list (C++11/C++20 designated initializers)
@@ -3451,7 +3457,7 @@ impl CppParser {
                         self.advance();
                         if let CppToken::Identifier(name) = self.current().clone() {
                             self.advance();
-                            captures.push(CppCapture::ByRef(name));
+                            captures.push(CppCapture::ByRef(name.to_string()));
                         } else {
                             captures.push(CppCapture::DefaultByRef);
                         }
@@ -3463,7 +3469,7 @@ impl CppParser {
                     CppToken::Identifier(ref name) => {
                         let n = name.clone();
                         self.advance();
-                        captures.push(CppCapture::ByValue(n));
+                        captures.push(CppCapture::ByValue(n.to_string()));
                     }
                     _ => break,
                 }
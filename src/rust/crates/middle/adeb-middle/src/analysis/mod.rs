@@ -1 +1,2 @@
 pub mod strict_type_checker;
+pub mod strict_program;
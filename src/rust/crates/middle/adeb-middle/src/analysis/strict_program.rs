@@ -0,0 +1,733 @@
+// ============================================================
+// Strict Type Checker — programa completo
+// ============================================================
+// Aplica las reglas de `strict_type_checker` a un Program entero
+// en dos fases:
+//
+//   1. Firmas (serie): tipos de parámetros/retorno de cada función
+//      y tipo de cada global. Es lo único que un cuerpo ve de fuera.
+//   2. Cuerpos (paralelo): cada función se revisa sola contra esas
+//      firmas; los diagnósticos vuelven en el orden del Program.
+//
+// Cada resultado se guarda con el hash del cuerpo y el hash de cada
+// firma que el cuerpo consultó (también las ausentes). Si nada de eso
+// cambió, el cuerpo no se vuelve a revisar: en `adB serve` y en batch
+// el cache vive lo que el proceso y solo se revisa lo editado.
+// ============================================================
+
+use super::strict_type_checker::{
+    check_assignment_compatible, check_types_compatible, CType, TypeCompatResult,
+};
+use adeb_core::ast::{BinOp, BitwiseOp, CmpOp, CompoundOp, Expr, Function, Program, Stmt};
+use adeb_core::cache::hasher::hash_bytes;
+use adeb_core::types::Type;
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex, OnceLock};
+
+/// Versión de las reglas: cambiarla invalida todo lo cacheado
+pub const STRICT_CHECKER_VERSION: u32 = 1;
+
+/// Hash de una firma que no existe: un global o función nuevos con ese
+/// nombre invalidan a quien la buscó
+const ABSENT_SIGNATURE: u64 = 0;
+
+/// Map the unified AST type onto the strict checker's type
+pub fn ctype_of(ty: &Type) -> CType {
+    match ty {
+        Type::I8 => CType::Int8,
+        Type::I16 => CType::Int16,
+        Type::I32 => CType::Int32,
+        Type::I64 => CType::Int64,
+        Type::U8 => CType::UInt8,
+        Type::U16 => CType::UInt16,
+        Type::U32 => CType::UInt32,
+        Type::U64 => CType::UInt64,
+        Type::F32 => CType::Float32,
+        Type::F64 => CType::Float64,
+        Type::Bool => CType::Bool,
+        Type::Void => CType::Void,
+        Type::Str => CType::Pointer(Box::new(CType::Char)),
+        Type::Pointer(inner) | Type::Reference(inner) | Type::Array(inner, None) => {
+            CType::Pointer(Box::new(ctype_of(inner)))
+        }
+        Type::Array(inner, Some(n)) => CType::Array(Box::new(ctype_of(inner)), *n),
+        Type::Struct(name) | Type::Class(name) => CType::Struct(name.clone()),
+        _ => CType::Unknown,
+    }
+}
+
+// ── Fase 1: firmas ──────────────────────────────────────────
+
+#[derive(Debug, Clone)]
+struct FnSignature {
+    params: Vec<CType>,
+    ret: CType,
+    hash: u64,
+}
+
+#[derive(Debug, Clone)]
+struct GlobalSignature {
+    ty: CType,
+    hash: u64,
+}
+
+/// Everything a function body can see of the rest of the program
+#[derive(Debug, Default)]
+pub struct Signatures {
+    functions: HashMap<String, FnSignature>,
+    globals: HashMap<String, GlobalSignature>,
+}
+
+impl Signatures {
+    pub fn collect(program: &Program) -> Self {
+        let mut sigs = Signatures::default();
+        for f in &program.functions {
+            let params: Vec<CType> = f.params.iter().map(|p| ctype_of(&p.param_type)).collect();
+            let ret = ctype_of(&f.resolved_return_type);
+            let hash = signature_hash("fn", &f.name, &format!("{:?} -> {:?}", params, ret));
+            sigs.functions.insert(f.name.clone(), FnSignature { params, ret, hash });
+        }
+        for stmt in &program.statements {
+            if let Stmt::VarDecl { var_type, name, .. } = stmt {
+                let ty = ctype_of(var_type);
+                let hash = signature_hash("global", name, &format!("{:?}", ty));
+                sigs.globals.insert(name.clone(), GlobalSignature { ty, hash });
+            }
+        }
+        sigs
+    }
+
+    fn function_hash(&self, name: &str) -> u64 {
+        self.functions.get(name).map_or(ABSENT_SIGNATURE, |s| s.hash)
+    }
+
+    fn global_hash(&self, name: &str) -> u64 {
+        self.globals.get(name).map_or(ABSENT_SIGNATURE, |s| s.hash)
+    }
+}
+
+fn signature_hash(kind: &str, name: &str, detail: &str) -> u64 {
+    hash_bytes(format!("{}:{}:{}", kind, name, detail).as_bytes()) | 1
+}
+
+/// Hash of everything inside a function that the checker reads
+fn body_hash(f: &Function) -> u64 {
+    hash_bytes(
+        format!(
+            "v{}:{}:{:?}:{:?}:{:?}",
+            STRICT_CHECKER_VERSION, f.name, f.params, f.resolved_return_type, f.body
+        )
+        .as_bytes(),
+    )
+}
+
+// ── Diagnósticos ────────────────────────────────────────────
+
+/// One strict-mode type error inside a function
+#[derive(Debug, Clone)]
+pub struct StrictDiagnostic {
+    pub function: String,
+    /// Última línea fuente vista (LineMarker), 0 si no hay
+    pub line: usize,
+    pub result: TypeCompatResult,
+}
+
+/// Result of checking a whole program
+#[derive(Debug, Default)]
+pub struct StrictReport {
+    /// En el orden de `program.functions`
+    pub diagnostics: Vec<StrictDiagnostic>,
+    /// Cuerpos revisados en esta pasada
+    pub checked: usize,
+    /// Cuerpos tomados del cache
+    pub reused: usize,
+}
+
+impl StrictReport {
+    pub fn has_errors(&self) -> bool {
+        !self.diagnostics.is_empty()
+    }
+}
+
+// ── Cache por función ───────────────────────────────────────
+
+/// Firma consultada por un cuerpo y su hash en el momento del check
+type Dependency = (DepKind, String, u64);
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum DepKind {
+    Function,
+    Global,
+}
+
+#[derive(Debug)]
+struct CachedBody {
+    deps: Vec<Dependency>,
+    diagnostics: Arc<[StrictDiagnostic]>,
+}
+
+/// Per-function results keyed by body hash, valid while every
+/// signature the body looked up still hashes the same
+#[derive(Debug, Default)]
+pub struct StrictCheckCache {
+    entries: Mutex<HashMap<u64, CachedBody>>,
+    hits: AtomicUsize,
+    misses: AtomicUsize,
+}
+
+impl StrictCheckCache {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Cache del proceso: lo comparten todos los builds de `adB serve`
+    /// y todas las entradas de un batch
+    pub fn global() -> &'static StrictCheckCache {
+        static CACHE: OnceLock<StrictCheckCache> = OnceLock::new();
+        CACHE.get_or_init(StrictCheckCache::new)
+    }
+
+    pub fn hits(&self) -> usize {
+        self.hits.load(Ordering::Relaxed)
+    }
+
+    pub fn misses(&self) -> usize {
+        self.misses.load(Ordering::Relaxed)
+    }
+
+    pub fn len(&self) -> usize {
+        self.entries.lock().unwrap().len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    fn lookup(&self, key: u64, sigs: &Signatures) -> Option<Arc<[StrictDiagnostic]>> {
+        let entries = self.entries.lock().unwrap();
+        let entry = entries.get(&key)?;
+        let fresh = entry.deps.iter().all(|(kind, name, hash)| {
+            let current = match kind {
+                DepKind::Function => sigs.function_hash(name),
+                DepKind::Global => sigs.global_hash(name),
+            };
+            current == *hash
+        });
+        fresh.then(|| entry.diagnostics.clone())
+    }
+
+    fn insert(&self, key: u64, deps: Vec<Dependency>, diagnostics: Arc<[StrictDiagnostic]>) {
+        self.entries.lock().unwrap().insert(key, CachedBody { deps, diagnostics });
+    }
+}
+
+// ── Fase 2: cuerpos ─────────────────────────────────────────
+
+/// Two-phase strict type checker over a whole program
+pub struct StrictTypeChecker<'c> {
+    cache: Option<&'c StrictCheckCache>,
+    jobs: usize,
+}
+
+impl Default for StrictTypeChecker<'_> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<'c> StrictTypeChecker<'c> {
+    pub fn new() -> Self {
+        Self { cache: None, jobs: adeb_core::parallel::default_jobs() }
+    }
+
+    /// Reutiliza los cuerpos sin cambios guardados en `cache`
+    pub fn with_cache(mut self, cache: &'c StrictCheckCache) -> Self {
+        self.cache = Some(cache);
+        self
+    }
+
+    pub fn with_jobs(mut self, jobs: usize) -> Self {
+        self.jobs = jobs.max(1);
+        self
+    }
+
+    pub fn check_program(&self, program: &Program) -> StrictReport {
+        let sigs = Signatures::collect(program);
+        let results = adeb_core::parallel::par_map(&program.functions, self.jobs, |f| {
+            self.check_cached(f, &sigs)
+        });
+
+        let mut report = StrictReport::default();
+        for (diagnostics, reused) in results {
+            if reused {
+                report.reused += 1;
+            } else {
+                report.checked += 1;
+            }
+            report.diagnostics.extend(diagnostics.iter().cloned());
+        }
+        report
+    }
+
+    fn check_cached(&self, f: &Function, sigs: &Signatures) -> (Arc<[StrictDiagnostic]>, bool) {
+        let Some(cache) = self.cache else {
+            return (check_function(f, sigs).0.into(), false);
+        };
+        let key = body_hash(f);
+        if let Some(hit) = cache.lookup(key, sigs) {
+            cache.hits.fetch_add(1, Ordering::Relaxed);
+            return (hit, true);
+        }
+        cache.misses.fetch_add(1, Ordering::Relaxed);
+        let (diagnostics, deps) = check_function(f, sigs);
+        let diagnostics: Arc<[StrictDiagnostic]> = diagnostics.into();
+        cache.insert(key, deps, diagnostics.clone());
+        (diagnostics, false)
+    }
+}
+
+/// Revisa un cuerpo; devuelve sus diagnósticos y las firmas que leyó
+fn check_function(f: &Function, sigs: &Signatures) -> (Vec<StrictDiagnostic>, Vec<Dependency>) {
+    let mut cx = BodyChecker {
+        sigs,
+        function: &f.name,
+        ret: ctype_of(&f.resolved_return_type),
+        locals: f.params.iter().map(|p| (p.name.clone(), ctype_of(&p.param_type))).collect(),
+        line: 0,
+        diagnostics: Vec::new(),
+        deps: Vec::new(),
+    };
+    cx.stmts(&f.body);
+    cx.deps.sort_by(|a, b| (a.0 as u8, &a.1).cmp(&(b.0 as u8, &b.1)));
+    cx.deps.dedup();
+    (cx.diagnostics, cx.deps)
+}
+
+struct BodyChecker<'a> {
+    sigs: &'a Signatures,
+    function: &'a str,
+    ret: CType,
+    locals: HashMap<String, CType>,
+    line: usize,
+    diagnostics: Vec<StrictDiagnostic>,
+    deps: Vec<Dependency>,
+}
+
+impl BodyChecker<'_> {
+    fn report(&mut self, result: TypeCompatResult) {
+        // Una sola vez por línea: los nodos de una línea (o de un switch
+        // sin LineMarker propio) repiten el mismo hallazgo
+        let line = self.line;
+        let seen = self.diagnostics.iter().any(|d| d.line == line && d.result == result);
+        if result.is_error() && !seen {
+            self.diagnostics.push(StrictDiagnostic {
+                function: self.function.to_string(),
+                line: self.line,
+                result,
+            });
+        }
+    }
+
+    fn variable(&mut self, name: &str) -> CType {
+        if let Some(ty) = self.locals.get(name) {
+            return ty.clone();
+        }
+        let global = self.sigs.globals.get(name);
+        self.deps.push((DepKind::Global, name.to_string(), global.map_or(ABSENT_SIGNATURE, |g| g.hash)));
+        global.map_or(CType::Unknown, |g| g.ty.clone())
+    }
+
+    fn callee(&mut self, name: &str) -> Option<&FnSignature> {
+        let sig = self.sigs.functions.get(name);
+        self.deps.push((DepKind::Function, name.to_string(), sig.map_or(ABSENT_SIGNATURE, |s| s.hash)));
+        sig
+    }
+
+    fn assign(&mut self, target: &CType, value: &Expr) {
+        let source = self.expr(value);
+        self.report(check_assignment_compatible(target, &source));
+    }
+
+    fn stmts(&mut self, stmts: &[Stmt]) {
+        for stmt in stmts {
+            self.stmt(stmt);
+        }
+    }
+
+    fn stmt(&mut self, stmt: &Stmt) {
+        match stmt {
+            Stmt::LineMarker(line) => self.line = *line,
+            Stmt::VarDecl { var_type, name, value } => {
+                let ty = ctype_of(var_type);
+                if let Some(v) = value {
+                    self.assign(&ty, v);
+                }
+                self.locals.insert(name.clone(), ty);
+            }
+            Stmt::Assign { name, value } => {
+                let target = self.variable(name);
+                self.assign(&target, value);
+            }
+            Stmt::CompoundAssign { name, op, value } => {
+                let target = self.variable(name);
+                let source = self.expr(value);
+                self.report(check_types_compatible(&target, &source, compound_op(*op)));
+            }
+            Stmt::DerefAssign { pointer, value } => {
+                let target = pointee(&self.expr(pointer));
+                self.assign(&target, value);
+            }
+            Stmt::IndexAssign { object, index, value } => {
+                let target = pointee(&self.expr(object));
+                self.expr(index);
+                self.assign(&target, value);
+            }
+            Stmt::FieldAssign { object, value, .. } => {
+                self.expr(object);
+                self.expr(value);
+            }
+            Stmt::ArrowAssign { pointer, value, .. } => {
+                self.expr(pointer);
+                self.expr(value);
+            }
+            Stmt::Return(Some(value)) => {
+                let ret = self.ret.clone();
+                self.assign(&ret, value);
+            }
+            Stmt::If { condition, then_body, else_body } => {
+                self.expr(condition);
+                self.stmts(then_body);
+                if let Some(eb) = else_body {
+                    self.stmts(eb);
+                }
+            }
+            Stmt::While { condition, body } | Stmt::DoWhile { body, condition } => {
+                self.expr(condition);
+                self.stmts(body);
+            }
+            Stmt::For { var, start, end, body } => {
+                self.expr(start);
+                self.expr(end);
+                self.locals.insert(var.clone(), CType::Unknown);
+                self.stmts(body);
+            }
+            Stmt::ForEach { var, iterable, body } => {
+                self.expr(iterable);
+                self.locals.insert(var.clone(), CType::Unknown);
+                self.stmts(body);
+            }
+            Stmt::Switch { expr, cases, default } => {
+                self.expr(expr);
+                for case in cases {
+                    self.stmts(&case.body);
+                }
+                if let Some(d) = default {
+                    self.stmts(d);
+                }
+            }
+            Stmt::Assert { condition, message } => {
+                self.expr(condition);
+                if let Some(m) = message {
+                    self.expr(m);
+                }
+            }
+            Stmt::Print(e)
+            | Stmt::Println(e)
+            | Stmt::PrintNum(e)
+            | Stmt::Expr(e)
+            | Stmt::Free(e)
+            | Stmt::Delete { expr: e, .. }
+            | Stmt::RegAssign { value: e, .. } => {
+                self.expr(e);
+            }
+            Stmt::MemWrite { addr, value } | Stmt::PortOut { port: addr, value } => {
+                self.expr(addr);
+                self.expr(value);
+            }
+            _ => {}
+        }
+    }
+
+    /// Tipo de `e` (Unknown si no se puede inferir); reporta lo que
+    /// encuentre por el camino. Los literales se adaptan al destino.
+    fn expr(&mut self, e: &Expr) -> CType {
+        match e {
+            Expr::Variable(name) => self.variable(name),
+            Expr::BinaryOp { op, left, right } => {
+                let l = self.expr(left);
+                let r = self.expr(right);
+                match op {
+                    BinOp::And | BinOp::Or => CType::Unknown,
+                    _ => self.binary(&l, &r, bin_op(*op)),
+                }
+            }
+            Expr::BitwiseOp { op, left, right } => {
+                let l = self.expr(left);
+                let r = self.expr(right);
+                match op {
+                    // El tipo del shift es el del operando izquierdo
+                    BitwiseOp::LeftShift | BitwiseOp::RightShift => l,
+                    _ => self.binary(&l, &r, bitwise_op(*op)),
+                }
+            }
+            Expr::Comparison { op, left, right } => {
+                let l = self.expr(left);
+                let r = self.expr(right);
+                self.report(check_types_compatible(&l, &r, cmp_op(*op)));
+                CType::Unknown
+            }
+            Expr::Call { name, args } => {
+                let arg_types: Vec<CType> = args.iter().map(|a| self.expr(a)).collect();
+                let Some(sig) = self.callee(name) else { return CType::Unknown };
+                let (params, ret) = (sig.params.clone(), sig.ret.clone());
+                for (param, arg) in params.iter().zip(&arg_types) {
+                    self.report(check_assignment_compatible(param, arg));
+                }
+                ret
+            }
+            Expr::Cast { target_type, expr } => {
+                self.expr(expr);
+                ctype_of(target_type)
+            }
+            Expr::Deref(inner) => pointee(&self.expr(inner)),
+            Expr::AddressOf(inner) => match self.expr(inner) {
+                CType::Unknown => CType::Unknown,
+                ty => CType::Pointer(Box::new(ty)),
+            },
+            Expr::Index { object, index } => {
+                self.expr(index);
+                pointee(&self.expr(object))
+            }
+            Expr::Ternary { condition, then_expr, else_expr } => {
+                self.expr(condition);
+                let t = self.expr(then_expr);
+                self.expr(else_expr);
+                t
+            }
+            Expr::UnaryOp { expr, .. }
+            | Expr::PreIncrement(expr)
+            | Expr::PreDecrement(expr)
+            | Expr::PostIncrement(expr)
+            | Expr::PostDecrement(expr)
+            | Expr::BitwiseNot(expr) => self.expr(expr),
+            Expr::String(_) => CType::Pointer(Box::new(CType::Char)),
+            _ => {
+                self.children(e);
+                CType::Unknown
+            }
+        }
+    }
+
+    /// Recorre los hijos de expresiones cuyo tipo no se infiere
+    fn children(&mut self, e: &Expr) {
+        match e {
+            Expr::Array(items) | Expr::New { args: items, .. } => {
+                for i in items {
+                    self.expr(i);
+                }
+            }
+            Expr::MethodCall { object, args, .. } | Expr::VirtualCall { object, args, .. } => {
+                self.expr(object);
+                for a in args {
+                    self.expr(a);
+                }
+            }
+            Expr::Slice { object, start, end } => {
+                self.expr(object);
+                for bound in [start, end].into_iter().flatten() {
+                    self.expr(bound);
+                }
+            }
+            Expr::StringConcat { left, right } | Expr::Push { array: left, value: right } => {
+                self.expr(left);
+                self.expr(right);
+            }
+            Expr::Realloc { ptr, new_size } => {
+                self.expr(ptr);
+                self.expr(new_size);
+            }
+            Expr::FieldAccess { object: inner, .. }
+            | Expr::ArrowAccess { pointer: inner, .. }
+            | Expr::Lambda { body: inner, .. }
+            | Expr::Len(inner)
+            | Expr::Pop(inner)
+            | Expr::IntCast(inner)
+            | Expr::FloatCast(inner)
+            | Expr::StrCast(inner)
+            | Expr::BoolCast(inner)
+            | Expr::Malloc(inner)
+            | Expr::MemRead { addr: inner }
+            | Expr::PortIn { port: inner } => {
+                self.expr(inner);
+            }
+            _ => {}
+        }
+    }
+
+    fn binary(&mut self, l: &CType, r: &CType, op: &str) -> CType {
+        let (l, r) = (&l.decayed(), &r.decayed());
+        // Aritmética de punteros: p + n / p - n conserva el puntero,
+        // p - q es un ptrdiff_t
+        if l.is_pointer() && r.is_integer() && matches!(op, "+" | "-") {
+            return l.clone();
+        }
+        if l.is_pointer() && op == "-" && l.same_as(r) {
+            return CType::Int64;
+        }
+        match check_types_compatible(l, r, op) {
+            TypeCompatResult::Ok(ty) => ty,
+            err => {
+                self.report(err);
+                CType::Unknown
+            }
+        }
+    }
+}
+
+fn pointee(ty: &CType) -> CType {
+    match ty {
+        CType::Pointer(inner) | CType::Array(inner, _) => (**inner).clone(),
+        _ => CType::Unknown,
+    }
+}
+
+fn bin_op(op: BinOp) -> &'static str {
+    match op {
+        BinOp::Add => "+",
+        BinOp::Sub => "-",
+        BinOp::Mul => "*",
+        BinOp::Div => "/",
+        BinOp::Mod => "%",
+        BinOp::And => "&&",
+        BinOp::Or => "||",
+    }
+}
+
+fn bitwise_op(op: BitwiseOp) -> &'static str {
+    match op {
+        BitwiseOp::And => "&",
+        BitwiseOp::Or => "|",
+        BitwiseOp::Xor => "^",
+        BitwiseOp::LeftShift => "<<",
+        BitwiseOp::RightShift => ">>",
+    }
+}
+
+fn cmp_op(op: CmpOp) -> &'static str {
+    match op {
+        CmpOp::Eq => "==",
+        CmpOp::Ne => "!=",
+        CmpOp::Lt => "<",
+        CmpOp::Le => "<=",
+        CmpOp::Gt => ">",
+        CmpOp::Ge => ">=",
+    }
+}
+
+fn compound_op(op: CompoundOp) -> &'static str {
+    match op {
+        CompoundOp::AddAssign => "+=",
+        CompoundOp::SubAssign => "-=",
+        CompoundOp::MulAssign => "*=",
+        CompoundOp::DivAssign => "/=",
+        CompoundOp::ModAssign => "%=",
+        CompoundOp::AndAssign => "&=",
+        CompoundOp::OrAssign => "|=",
+        CompoundOp::XorAssign => "^=",
+        CompoundOp::ShlAssign => "<<=",
+        CompoundOp::ShrAssign => ">>=",
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use adeb_core::ast::{FunctionAttributes, Param};
+
+    fn func(name: &str, params: Vec<Param>, ret: Type, body: Vec<Stmt>) -> Function {
+        Function {
+            name: name.to_string(),
+            params,
+            return_type: None,
+            resolved_return_type: ret,
+            body,
+            attributes: FunctionAttributes::default(),
+        }
+    }
+
+    fn program() -> Program {
+        let mut p = Program::new();
+        p.statements.push(Stmt::VarDecl { var_type: Type::F64, name: "scale".into(), value: None });
+        p.functions.push(func(
+            "half",
+            vec![Param::typed("x".into(), Type::F64)],
+            Type::F64,
+            vec![Stmt::Return(Some(Expr::Variable("x".into())))],
+        ));
+        p.functions.push(func("idle", vec![], Type::Void, vec![Stmt::Return(None)]));
+        // int n = half(scale); → double a int sin cast
+        p.functions.push(func(
+            "main",
+            vec![],
+            Type::I32,
+            vec![
+                Stmt::LineMarker(7),
+                Stmt::VarDecl {
+                    var_type: Type::I32,
+                    name: "n".into(),
+                    value: Some(Expr::Call { name: "half".into(), args: vec![Expr::Variable("scale".into())] }),
+                },
+                Stmt::Return(Some(Expr::Variable("n".into()))),
+            ],
+        ));
+        p
+    }
+
+    #[test]
+    fn test_reports_in_function_order() {
+        let report = StrictTypeChecker::new().with_jobs(4).check_program(&program());
+        assert_eq!(report.checked, 3);
+        assert_eq!(report.diagnostics.len(), 1);
+        let d = &report.diagnostics[0];
+        assert_eq!((d.function.as_str(), d.line), ("main", 7));
+        assert!(matches!(d.result, TypeCompatResult::NarrowingConversion { .. }));
+    }
+
+    #[test]
+    fn test_one_diagnostic_per_line() {
+        let mut p = program();
+        // Dos veces `n = half(scale);` sin LineMarker entre medias
+        let again = Stmt::Assign {
+            name: "n".into(),
+            value: Expr::Call { name: "half".into(), args: vec![Expr::Variable("scale".into())] },
+        };
+        p.functions[2].body.insert(2, again.clone());
+        p.functions[2].body.insert(2, again);
+        let report = StrictTypeChecker::new().check_program(&p);
+        assert_eq!(report.diagnostics.len(), 1);
+    }
+
+    #[test]
+    fn test_unchanged_bodies_reused() {
+        let cache = StrictCheckCache::new();
+        let checker = StrictTypeChecker::new().with_cache(&cache);
+        let mut p = program();
+        assert_eq!(checker.check_program(&p).checked, 3);
+
+        let again = checker.check_program(&p);
+        assert_eq!((again.checked, again.reused), (0, 3));
+        assert_eq!(again.diagnostics.len(), 1);
+
+        // Cambiar la firma de half revisa half y a quien la llama
+        p.functions[0].resolved_return_type = Type::I32;
+        p.functions[0].body = vec![Stmt::Return(Some(Expr::Number(0)))];
+        let edited = checker.check_program(&p);
+        assert_eq!((edited.checked, edited.reused), (2, 1));
+        assert!(edited.diagnostics.is_empty());
+
+        p.statements[0] = Stmt::VarDecl { var_type: Type::I32, name: "scale".into(), value: None };
+        let global = checker.check_program(&p);
+        assert_eq!((global.checked, global.reused), (1, 2), "solo main lee el global");
+    }
+}
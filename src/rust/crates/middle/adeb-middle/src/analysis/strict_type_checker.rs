@@ -121,6 +121,24 @@ impl CType {
         matches!(self, CType::Pointer(_))
     }
 
+    /// Type of the value: an array decays to a pointer to its element
+    pub fn decayed(&self) -> CType {
+        match self {
+            CType::Array(inner, _) => CType::Pointer(inner.clone()),
+            other => other.clone(),
+        }
+    }
+
+    /// Same type, with `char` and `int8` as one (the frontend emits both)
+    pub fn same_as(&self, other: &CType) -> bool {
+        match (self, other) {
+            (CType::Char, CType::Int8) | (CType::Int8, CType::Char) => true,
+            (CType::Pointer(a), CType::Pointer(b)) => a.same_as(b),
+            (CType::Array(a, n), CType::Array(b, m)) => n == m && a.same_as(b),
+            (a, b) => a == b,
+        }
+    }
+
     // Convert from frontend Type to CType
     // NOTE: Requires adeb-frontend-c integration — disabled until frontend is linked
     // pub fn from_frontend_type(t: &crate::frontend::types::Type) -> Self { ... }
@@ -151,7 +169,7 @@ impl fmt::Display for CType {
 }
 
 /// Result of type compatibility check
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, PartialEq)]
 pub enum TypeCompatResult {
     /// Types are compatible, result type is provided
     Ok(CType),
@@ -202,6 +220,9 @@ pub fn check_types_compatible(left: &CType, right: &CType, op: &str) -> TypeComp
         return TypeCompatResult::Ok(CType::Unknown);
     }
 
+    // Arrays in an expression are pointers to their first element
+    let (left, right) = (&left.decayed(), &right.decayed());
+
     // Special case: char + char = int32 (C standard, integer promotion)
     if *left == CType::Char && *right == CType::Char {
         return TypeCompatResult::Ok(CType::Int32);
@@ -233,10 +254,17 @@ pub fn check_types_compatible(left: &CType, right: &CType, op: &str) -> TypeComp
     }
 
     // Same type is always compatible
-    if left == right {
+    if left.same_as(right) {
         return TypeCompatResult::Ok(left.clone());
     }
 
+    // ALLOWED: any pointer against void* (NULL, malloc results)
+    if let (CType::Pointer(l), CType::Pointer(r)) = (left, right) {
+        if **l == CType::Void || **r == CType::Void {
+            return TypeCompatResult::Ok(left.clone());
+        }
+    }
+
     // BLOCKED: signed vs unsigned mixing
     if (left.is_signed() && right.is_unsigned()) || (left.is_unsigned() && right.is_signed()) {
         let (signed, unsigned) = if left.is_signed() {
@@ -326,11 +354,31 @@ pub fn check_assignment_compatible(target: &CType, source: &CType) -> TypeCompat
         return TypeCompatResult::Ok(target.clone());
     }
 
+    // An array is initialized from a string literal or another array
+    // of the same element, not assigned a pointer
+    if let CType::Array(elem, _) = target {
+        if let CType::Pointer(inner) = source.decayed() {
+            if inner.same_as(elem) {
+                return TypeCompatResult::Ok(target.clone());
+            }
+        }
+    }
+
+    // Array → pointer decay: `int* p = arr;`
+    let source = &source.decayed();
+
     // Same type is always compatible
-    if target == source {
+    if target.same_as(source) {
         return TypeCompatResult::Ok(target.clone());
     }
 
+    // ALLOWED: any object pointer converts to void*
+    if let (CType::Pointer(inner_target), CType::Pointer(_)) = (target, source) {
+        if **inner_target == CType::Void {
+            return TypeCompatResult::Ok(target.clone());
+        }
+    }
+
     // BLOCKED: narrowing from float to int
     if target.is_integer() && source.is_float() {
         return TypeCompatResult::NarrowingConversion {
@@ -647,6 +695,24 @@ mod tests {
         assert!(matches!(result, TypeCompatResult::ImplicitCast { .. }));
     }
 
+    #[test]
+    fn test_legal_pointer_assignments() {
+        let ptr = |t: CType| CType::Pointer(Box::new(t));
+        let array = |t: CType, n| CType::Array(Box::new(t), n);
+        let ok = |target: &CType, source: &CType| matches!(check_assignment_compatible(target, source), TypeCompatResult::Ok(_));
+        // int* p = arr;  char** v = argv_like;
+        assert!(ok(&ptr(CType::Int32), &array(CType::Int32, 5)));
+        assert!(ok(&ptr(ptr(CType::Int8)), &array(ptr(CType::Char), 4)));
+        // const char* s = "hi";  char buf[32] = "hi";
+        assert!(ok(&ptr(CType::Int8), &ptr(CType::Char)));
+        assert!(ok(&array(CType::Int8, 32), &ptr(CType::Char)));
+        // void* v = p;
+        assert!(ok(&ptr(CType::Void), &ptr(CType::Struct("Ctx".into()))));
+        // Still blocked: unrelated pointers and arrays of another element
+        assert!(!ok(&ptr(CType::Int32), &ptr(CType::Float32)));
+        assert!(!ok(&ptr(CType::Int64), &array(CType::Int32, 5)));
+    }
+
     #[test]
     fn test_overflow_detection() {
         let result = check_overflow(&CType::Int32, "+", i32::MAX as i64, 1);
@@ -0,0 +1,167 @@
+// ============================================================
+// Recorrido del AST de adeb_core
+// ============================================================
+// Visitor mutable sobre `Stmt`/`Expr` compartido por los pases que
+// trabajan sobre el Program real (LTO, inlining): stmts en pre-orden,
+// expresiones en post-orden.
+// ============================================================
+
+use adeb_core::ast::{Expr, Function, SizeOfArg, Stmt};
+use adeb_core::types::Type;
+use std::collections::HashMap;
+
+pub(crate) trait Visitor {
+    fn stmt(&mut self, _stmt: &mut Stmt) {}
+    /// false = no bajar a los hijos de `expr`
+    fn enter(&mut self, _expr: &Expr) -> bool {
+        true
+    }
+    /// Post-orden: los hijos ya se visitaron
+    fn expr(&mut self, _expr: &mut Expr) {}
+}
+
+pub(crate) fn walk_stmts(stmts: &mut [Stmt], v: &mut impl Visitor) {
+    for stmt in stmts {
+        v.stmt(stmt);
+        for expr in stmt_exprs(stmt) {
+            walk_expr(expr, v);
+        }
+        for body in child_bodies(stmt) {
+            walk_stmts(body, v);
+        }
+    }
+}
+
+pub(crate) fn walk_expr(expr: &mut Expr, v: &mut impl Visitor) {
+    if v.enter(expr) {
+        for child in expr_children(expr) {
+            walk_expr(child, v);
+        }
+    }
+    v.expr(expr);
+}
+
+pub(crate) fn stmt_exprs(stmt: &mut Stmt) -> Vec<&mut Expr> {
+    match stmt {
+        Stmt::Print(e)
+        | Stmt::Println(e)
+        | Stmt::PrintNum(e)
+        | Stmt::Expr(e)
+        | Stmt::Free(e)
+        | Stmt::Return(Some(e))
+        | Stmt::VarDecl { value: Some(e), .. }
+        | Stmt::Delete { expr: e, .. } => vec![e],
+        Stmt::Assign { value, .. } | Stmt::CompoundAssign { value, .. } | Stmt::RegAssign { value, .. } => {
+            vec![value]
+        }
+        Stmt::IndexAssign { object, index, value } => vec![object, index, value],
+        Stmt::FieldAssign { object, value, .. } => vec![object, value],
+        Stmt::DerefAssign { pointer, value } | Stmt::ArrowAssign { pointer, value, .. } => vec![pointer, value],
+        Stmt::MemWrite { addr: a, value } | Stmt::PortOut { port: a, value } => vec![a, value],
+        Stmt::If { condition, .. } | Stmt::While { condition, .. } | Stmt::DoWhile { condition, .. } => {
+            vec![condition]
+        }
+        Stmt::For { start, end, .. } => vec![start, end],
+        Stmt::ForEach { iterable, .. } => vec![iterable],
+        Stmt::Assert { condition, message } => std::iter::once(condition).chain(message.as_mut()).collect(),
+        Stmt::Switch { expr, cases, .. } => std::iter::once(expr).chain(cases.iter_mut().map(|c| &mut c.value)).collect(),
+        _ => Vec::new(),
+    }
+}
+
+pub(crate) fn child_bodies(stmt: &mut Stmt) -> Vec<&mut Vec<Stmt>> {
+    match stmt {
+        Stmt::If { then_body, else_body, .. } => std::iter::once(then_body).chain(else_body.as_mut()).collect(),
+        Stmt::While { body, .. } | Stmt::DoWhile { body, .. } | Stmt::For { body, .. } | Stmt::ForEach { body, .. } => {
+            vec![body]
+        }
+        Stmt::Switch { cases, default, .. } => {
+            cases.iter_mut().map(|c| &mut c.body).chain(default.as_mut()).collect()
+        }
+        _ => Vec::new(),
+    }
+}
+
+pub(crate) fn expr_children(expr: &mut Expr) -> Vec<&mut Expr> {
+    match expr {
+        Expr::BinaryOp { left, right, .. }
+        | Expr::Comparison { left, right, .. }
+        | Expr::BitwiseOp { left, right, .. }
+        | Expr::StringConcat { left, right }
+        | Expr::Index { object: left, index: right }
+        | Expr::Push { array: left, value: right }
+        | Expr::Realloc { ptr: left, new_size: right } => vec![&mut **left, &mut **right],
+        Expr::UnaryOp { expr: e, .. }
+        | Expr::Cast { expr: e, .. }
+        | Expr::Len(e)
+        | Expr::Pop(e)
+        | Expr::IntCast(e)
+        | Expr::FloatCast(e)
+        | Expr::StrCast(e)
+        | Expr::BoolCast(e)
+        | Expr::Deref(e)
+        | Expr::AddressOf(e)
+        | Expr::Malloc(e)
+        | Expr::PreIncrement(e)
+        | Expr::PreDecrement(e)
+        | Expr::PostIncrement(e)
+        | Expr::PostDecrement(e)
+        | Expr::BitwiseNot(e)
+        | Expr::FieldAccess { object: e, .. }
+        | Expr::ArrowAccess { pointer: e, .. }
+        | Expr::Lambda { body: e, .. }
+        | Expr::MemRead { addr: e }
+        | Expr::PortIn { port: e } => vec![&mut **e],
+        Expr::Call { args, .. } | Expr::New { args, .. } | Expr::Array(args) => args.iter_mut().collect(),
+        Expr::MethodCall { object, args, .. } | Expr::VirtualCall { object, args, .. } => {
+            std::iter::once(&mut **object).chain(args.iter_mut()).collect()
+        }
+        Expr::Slice { object, start, end } => std::iter::once(object)
+            .chain(start.as_mut())
+            .chain(end.as_mut())
+            .map(|e| &mut **e)
+            .collect(),
+        Expr::Ternary { condition, then_expr, else_expr } => {
+            vec![&mut **condition, &mut **then_expr, &mut **else_expr]
+        }
+        Expr::SizeOf(arg) => match &mut **arg {
+            SizeOfArg::Expr(e) => vec![e],
+            SizeOfArg::Type(_) => Vec::new(),
+        },
+        _ => Vec::new(),
+    }
+}
+
+/// Parámetros y locales declarados en cualquier scope de `func`
+pub(crate) fn declared_names(func: &mut Function) -> HashMap<String, Type> {
+    struct Decls(HashMap<String, Type>);
+    impl Visitor for Decls {
+        fn stmt(&mut self, stmt: &mut Stmt) {
+            match stmt {
+                Stmt::VarDecl { var_type, name, .. } => {
+                    if self.0.get(name).is_some_and(|t| t != var_type) {
+                        self.0.insert(name.clone(), Type::Unknown);
+                    } else {
+                        self.0.insert(name.clone(), var_type.clone());
+                    }
+                }
+                Stmt::For { var, .. } | Stmt::ForEach { var, .. } => {
+                    self.0.entry(var.clone()).or_insert(Type::Unknown);
+                }
+                _ => {}
+            }
+        }
+    }
+    let mut decls = Decls(func.params.iter().map(|p| (p.name.clone(), p.param_type.clone())).collect());
+    walk_stmts(&mut func.body, &mut decls);
+    decls.0
+}
+
+pub(crate) fn is_integer(ty: &Type) -> bool {
+    ty.is_signed() || ty.is_unsigned() || *ty == Type::Bool
+}
+
+/// Entradas que no llegan por un call de C: ISRs, excepciones, exports
+pub(crate) fn is_root(func: &Function) -> bool {
+    func.attributes.is_interrupt || func.attributes.is_exception || func.attributes.export_name.is_some()
+}
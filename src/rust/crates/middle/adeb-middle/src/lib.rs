@@ -7,10 +7,15 @@ pub mod passes;
 pub mod analysis;
 pub mod ub_detector;
 pub mod optimizer;
+pub mod profile;
+pub mod lto;
+mod ast_walk;
 
 // Re-exports — SSA IR types
 pub use ir::{Module, Function, BasicBlock, Type, Value, ValueId, Constant};
 pub use ir::{Instruction, Opcode, BinaryOp, CastOp, CompareOp};
 pub use ir::{IRBuilder, GlobalVariable};
 pub use analysis::strict_type_checker;
+pub use analysis::strict_program::{StrictCheckCache, StrictReport, StrictTypeChecker};
 pub use ub_detector::{UBDetector, UBReport};
+pub use profile::{FunctionProfile, Profile, SiteCount, SiteKind};
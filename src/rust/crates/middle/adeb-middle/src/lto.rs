@@ -0,0 +1,502 @@
+// ============================================================
+// ADead-BIB — Link-Time Optimization (-flto)
+// ============================================================
+// Los builds multi-fichero guardan el Program de cada TU (CObject)
+// hasta el link. Con -flto el Program ya enlazado pasa por aquí antes
+// del backend, viendo el programa entero:
+//
+//   1. Globales constantes: un global escalar con inicializador
+//      literal que nadie escribe ni toma su dirección se sustituye
+//      por su valor en todas las funciones
+//   2. Inlining entre TUs: `InlineExpander::run_typed` (call graph,
+//      SCCs y cost model de inline_exp) sobre el programa enlazado, ya
+//      con los globales constantes sustituidos
+//   3. Stripping desde el entry: funciones y globales a los que no se
+//      llega desde main, ISRs, exports ni objetos externos desaparecen
+//
+// `rename_symbols` no es parte de -flto: el link multi-TU lo usa en
+// cada TU para dar nombre único a sus símbolos `static`.
+//
+// Los objetos ASM-BIB (adeb-bridge) son hojas externas: sus exports
+// se pueden llamar pero no vuelven a C, así que no frenan ningún
+// análisis; los símbolos C que importan son raíces que no se tocan.
+// ============================================================
+
+use crate::ast_walk::{declared_names, is_root, walk_stmts, Visitor};
+use crate::optimizer::inline_exp::InlineExpander;
+use adeb_core::ast::{Expr, OutputMode, Program, Stmt};
+use adeb_core::types::Type;
+use std::collections::{HashMap, HashSet};
+
+/// Frontera del programa visible
+#[derive(Debug, Clone)]
+pub struct LtoOptions {
+    pub entry: String,
+    /// Definidos fuera del Program (exports de ASM-BIB): hojas sin cuerpo
+    pub external_leaves: HashSet<String>,
+    /// Símbolos C referenciados desde fuera (imports de ASM-BIB)
+    pub external_refs: HashSet<String>,
+}
+
+impl Default for LtoOptions {
+    fn default() -> Self {
+        Self { entry: "main".to_string(), external_leaves: HashSet::new(), external_refs: HashSet::new() }
+    }
+}
+
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct LtoStats {
+    pub globals_propagated: usize,
+    pub calls_inlined: usize,
+    pub functions_stripped: usize,
+    pub globals_stripped: usize,
+}
+
+pub fn optimize(program: &mut Program, options: &LtoOptions) -> LtoStats {
+    let globals_propagated = propagate_globals(program, options);
+    let (calls_inlined, functions_inlined) = inline_calls(program, options);
+    let (functions_stripped, globals_stripped) = strip_unreachable(program, options);
+    LtoStats {
+        globals_propagated,
+        calls_inlined,
+        functions_stripped: functions_inlined + functions_stripped,
+        globals_stripped,
+    }
+}
+
+// ============================================================
+// Recorrido del AST
+// ============================================================
+
+fn for_each_function(program: &mut Program, v: &mut impl Visitor) {
+    for func in &mut program.functions {
+        walk_stmts(&mut func.body, v);
+    }
+}
+
+// ============================================================
+// 1. Globales constantes
+// ============================================================
+
+/// `n` cabe en `ty` sin truncar
+fn fits(ty: &Type, n: i64) -> bool {
+    match ty {
+        Type::Bool => n == 0 || n == 1,
+        Type::I8 => i8::try_from(n).is_ok(),
+        Type::I16 => i16::try_from(n).is_ok(),
+        Type::I32 => i32::try_from(n).is_ok(),
+        Type::U8 => u8::try_from(n).is_ok(),
+        Type::U16 => u16::try_from(n).is_ok(),
+        Type::U32 => u32::try_from(n).is_ok(),
+        Type::I64 | Type::U64 => true,
+        _ => false,
+    }
+}
+
+/// Nombres que se escriben o cuya dirección escapa
+struct Writes(HashSet<String>);
+
+impl Visitor for Writes {
+    fn stmt(&mut self, stmt: &mut Stmt) {
+        match stmt {
+            Stmt::Assign { name, .. } | Stmt::CompoundAssign { name, .. } | Stmt::Increment { name, .. } => {
+                self.0.insert(name.clone());
+            }
+            Stmt::IndexAssign { object: Expr::Variable(name), .. }
+            | Stmt::FieldAssign { object: Expr::Variable(name), .. } => {
+                self.0.insert(name.clone());
+            }
+            _ => {}
+        }
+    }
+
+    fn enter(&mut self, expr: &Expr) -> bool {
+        let mut target = match expr {
+            Expr::AddressOf(e)
+            | Expr::PreIncrement(e)
+            | Expr::PreDecrement(e)
+            | Expr::PostIncrement(e)
+            | Expr::PostDecrement(e) => &**e,
+            _ => return true,
+        };
+        while let Expr::Index { object: e, .. } | Expr::FieldAccess { object: e, .. } = target {
+            target = &**e;
+        }
+        if let Expr::Variable(name) = target {
+            self.0.insert(name.clone());
+        }
+        true
+    }
+}
+
+fn propagate_globals(program: &mut Program, options: &LtoOptions) -> usize {
+    let mut constants: HashMap<String, i64> = HashMap::new();
+    let mut seen: HashSet<String> = HashSet::new();
+    for stmt in &program.statements {
+        if let Stmt::VarDecl { var_type, name, value } = stmt {
+            match value {
+                Some(Expr::Number(n)) if seen.insert(name.clone()) && fits(var_type, *n) => {
+                    constants.insert(name.clone(), *n);
+                }
+                // Declarado dos veces: no se sabe cuál gana
+                _ => {
+                    seen.insert(name.clone());
+                    constants.remove(name);
+                }
+            }
+        }
+    }
+    let mut writes = Writes(options.external_refs.clone());
+    for_each_function(program, &mut writes);
+    walk_stmts(&mut program.statements, &mut writes);
+    constants.retain(|name, _| !writes.0.contains(name));
+    if constants.is_empty() {
+        return 0;
+    }
+
+    struct Substitute<'a> {
+        values: &'a HashMap<String, i64>,
+        shadowed: HashMap<String, Type>,
+        count: usize,
+    }
+    impl Visitor for Substitute<'_> {
+        // sizeof(g) es el tamaño del global, no el del literal
+        fn enter(&mut self, expr: &Expr) -> bool {
+            !matches!(expr, Expr::SizeOf(_))
+        }
+        fn expr(&mut self, expr: &mut Expr) {
+            if let Expr::Variable(name) = expr {
+                if let Some(&n) = self.values.get(name.as_str()) {
+                    if !self.shadowed.contains_key(name.as_str()) {
+                        *expr = Expr::Number(n);
+                        self.count += 1;
+                    }
+                }
+            }
+        }
+    }
+    let mut count = 0;
+    for func in &mut program.functions {
+        let mut subst = Substitute { values: &constants, shadowed: declared_names(func), count: 0 };
+        walk_stmts(&mut func.body, &mut subst);
+        count += subst.count;
+    }
+    count
+}
+
+// ============================================================
+// 2. Inlining entre TUs
+// ============================================================
+
+/// El inliner de `optimizer::inline_exp` sobre el programa enlazado:
+/// las funciones de otra TU ya tienen cuerpo y son hojas como cualquiera.
+/// El entry y lo que se llama desde fuera no se inlinean ni se quitan.
+fn inline_calls(program: &mut Program, options: &LtoOptions) -> (usize, usize) {
+    let mut keep: HashSet<String> = options.external_leaves.union(&options.external_refs).cloned().collect();
+    keep.insert(options.entry.clone());
+    let stats = InlineExpander::new().run_typed(program, &keep);
+    (stats.inlined_calls, stats.removed_functions.len())
+}
+
+// ============================================================
+// 3. Stripping desde el entry
+// ============================================================
+
+/// Nombres de funciones y globales que menciona el código
+struct Refs(Vec<String>);
+
+impl Visitor for Refs {
+    fn stmt(&mut self, stmt: &mut Stmt) {
+        if let Stmt::Assign { name, .. } | Stmt::CompoundAssign { name, .. } | Stmt::Increment { name, .. } = stmt {
+            self.0.push(name.clone());
+        }
+    }
+    fn expr(&mut self, expr: &mut Expr) {
+        if let Expr::Call { name, .. } | Expr::Variable(name) = expr {
+            self.0.push(name.clone());
+        }
+    }
+}
+
+/// (funciones, globales) eliminados. Los binarios flat/raw compilan
+/// todas las funciones (ISRs, callbacks) y no se tocan.
+fn strip_unreachable(program: &mut Program, options: &LtoOptions) -> (usize, usize) {
+    if matches!(program.attributes.mode, OutputMode::Raw | OutputMode::Flat)
+        || !program.functions.iter().any(|f| f.name == options.entry)
+    {
+        return (0, 0);
+    }
+    let functions: HashMap<String, usize> =
+        program.functions.iter().enumerate().map(|(i, f)| (f.name.clone(), i)).collect();
+    let mut globals: HashMap<String, Vec<usize>> = HashMap::new();
+    for (i, stmt) in program.statements.iter().enumerate() {
+        if let Stmt::VarDecl { name, .. } = stmt {
+            globals.entry(name.clone()).or_default().push(i);
+        }
+    }
+
+    let mut worklist: Vec<String> = vec![options.entry.clone()];
+    worklist.extend(program.functions.iter().filter(|f| is_root(f)).map(|f| f.name.clone()));
+    worklist.extend(options.external_refs.iter().cloned());
+    // Lo que no es una declaración de global se ejecuta siempre
+    let mut top = Refs(Vec::new());
+    for stmt in &mut program.statements {
+        if !matches!(stmt, Stmt::VarDecl { .. }) {
+            walk_stmts(std::slice::from_mut(stmt), &mut top);
+        }
+    }
+    worklist.extend(top.0);
+
+    let mut reached: HashSet<String> = HashSet::new();
+    while let Some(name) = worklist.pop() {
+        if options.external_leaves.contains(&name) || !reached.insert(name.clone()) {
+            continue;
+        }
+        let mut refs = Refs(Vec::new());
+        if let Some(&f) = functions.get(&name) {
+            walk_stmts(&mut program.functions[f].body, &mut refs);
+        }
+        for &g in globals.get(&name).into_iter().flatten() {
+            walk_stmts(std::slice::from_mut(&mut program.statements[g]), &mut refs);
+        }
+        worklist.extend(refs.0.into_iter().filter(|r| !reached.contains(r)));
+    }
+
+    let before = (program.functions.len(), program.statements.len());
+    program.functions.retain(|f| reached.contains(&f.name));
+    program.statements.retain(|s| match s {
+        Stmt::VarDecl { name, .. } => reached.contains(name),
+        _ => true,
+    });
+    (before.0 - program.functions.len(), before.1 - program.statements.len())
+}
+
+// ============================================================
+// Renombrado de símbolos
+// ============================================================
+
+/// Renombra funciones y globales: la definición, las llamadas y cada
+/// uso que no tape un parámetro o local del mismo nombre
+pub fn rename_symbols(program: &mut Program, renames: &HashMap<String, String>) {
+    if renames.is_empty() {
+        return;
+    }
+    struct Rename<'a> {
+        renames: &'a HashMap<String, String>,
+        shadowed: HashMap<String, Type>,
+    }
+    impl Rename<'_> {
+        fn apply(&self, name: &mut String) {
+            if self.shadowed.contains_key(name.as_str()) {
+                return;
+            }
+            if let Some(new) = self.renames.get(name.as_str()) {
+                *name = new.clone();
+            }
+        }
+    }
+    impl Visitor for Rename<'_> {
+        fn stmt(&mut self, stmt: &mut Stmt) {
+            if let Stmt::VarDecl { name, .. }
+            | Stmt::Assign { name, .. }
+            | Stmt::CompoundAssign { name, .. }
+            | Stmt::Increment { name, .. } = stmt
+            {
+                self.apply(name);
+            }
+        }
+        fn expr(&mut self, expr: &mut Expr) {
+            if let Expr::Call { name, .. } | Expr::Variable(name) = expr {
+                self.apply(name);
+            }
+        }
+    }
+
+    let mut globals = Rename { renames, shadowed: HashMap::new() };
+    walk_stmts(&mut program.statements, &mut globals);
+    for func in &mut program.functions {
+        let mut rename = Rename { renames, shadowed: declared_names(func) };
+        walk_stmts(&mut func.body, &mut rename);
+        rename.shadowed.clear();
+        rename.apply(&mut func.name);
+    }
+    let attrs = &mut program.attributes;
+    let rekey = |name: String| renames.get(&name).cloned().unwrap_or(name);
+    attrs.global_align = std::mem::take(&mut attrs.global_align).into_iter().map(|(k, v)| (rekey(k), v)).collect();
+    attrs.source_files = std::mem::take(&mut attrs.source_files).into_iter().map(|(k, v)| (rekey(k), v)).collect();
+    attrs.internal_symbols = std::mem::take(&mut attrs.internal_symbols).into_iter().map(rekey).collect();
+    attrs.external_definitions = std::mem::take(&mut attrs.external_definitions).into_iter().map(rekey).collect();
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use adeb_core::ast::{BinOp, Function, Param};
+
+    fn var(name: &str) -> Expr {
+        Expr::Variable(name.to_string())
+    }
+
+    fn call(name: &str, args: Vec<Expr>) -> Expr {
+        Expr::Call { name: name.to_string(), args }
+    }
+
+    fn add(a: Expr, b: Expr) -> Expr {
+        Expr::BinaryOp { op: BinOp::Add, left: Box::new(a), right: Box::new(b) }
+    }
+
+    fn func(name: &str, params: &[(&str, Type)], body: Vec<Stmt>) -> Function {
+        Function {
+            name: name.to_string(),
+            params: params
+                .iter()
+                .map(|(p, ty)| Param { name: p.to_string(), param_type: ty.clone(), default_value: None })
+                .collect(),
+            return_type: None,
+            resolved_return_type: Type::I32,
+            body,
+            attributes: Default::default(),
+        }
+    }
+
+    fn global(name: &str, var_type: Type, value: Option<Expr>) -> Stmt {
+        Stmt::VarDecl { var_type, name: name.to_string(), value }
+    }
+
+    #[test]
+    fn test_global_constants_propagate_unless_written() {
+        let mut program = Program::new();
+        program.statements = vec![
+            global("limit", Type::I32, Some(Expr::Number(10))),
+            global("counter", Type::I32, Some(Expr::Number(0))),
+            global("wide", Type::I8, Some(Expr::Number(300))),
+        ];
+        program.functions.push(func(
+            "main",
+            &[],
+            vec![
+                Stmt::Assign { name: "counter".into(), value: add(var("counter"), var("limit")) },
+                Stmt::Return(Some(add(var("wide"), var("limit")))),
+            ],
+        ));
+        // `limit` local en otra función: esa no se reescribe
+        program.functions.push(func("shadow", &[("limit", Type::I32)], vec![Stmt::Return(Some(var("limit")))]));
+
+        assert_eq!(propagate_globals(&mut program, &LtoOptions::default()), 2);
+        let Stmt::Return(Some(ret)) = &program.functions[0].body[1] else { panic!() };
+        assert!(matches!(ret, Expr::BinaryOp { left, right, .. }
+            if matches!(**left, Expr::Variable(_)) && matches!(**right, Expr::Number(10))));
+        assert!(matches!(&program.functions[1].body[0], Stmt::Return(Some(Expr::Variable(_)))));
+
+        // Un import de ASM-BIB puede escribirlo
+        let mut options = LtoOptions::default();
+        options.external_refs.insert("limit".into());
+        let mut program2 = Program::new();
+        program2.statements = vec![global("limit", Type::I32, Some(Expr::Number(10)))];
+        program2.functions.push(func("main", &[], vec![Stmt::Return(Some(var("limit")))]));
+        assert_eq!(propagate_globals(&mut program2, &options), 0);
+    }
+
+    #[test]
+    fn test_leaf_inlining_and_stripping_from_entry() {
+        let mut program = Program::new();
+        program.statements = vec![global("unused_table", Type::I64, Some(Expr::Number(7)))];
+        // square(x) = x * x se usa dos veces: solo con argumentos triviales
+        let square = Expr::BinaryOp { op: BinOp::Mul, left: Box::new(var("x")), right: Box::new(var("x")) };
+        program.functions.push(func("square", &[("x", Type::I32)], vec![Stmt::Return(Some(square))]));
+        program.functions.push(func(
+            "inc",
+            &[("x", Type::I32)],
+            vec![Stmt::Return(Some(add(var("x"), Expr::Number(1))))],
+        ));
+        program.functions.push(func("helper_from_other_tu", &[], vec![Stmt::Return(Some(Expr::Number(1)))]));
+        program.functions.push(func("asm_leaf_user", &[], vec![Stmt::Expr(call("asm_memcpy", vec![]))]));
+        program.functions.push(func(
+            "main",
+            &[("n", Type::I32)],
+            vec![
+                Stmt::VarDecl { var_type: Type::I32, name: "a".into(), value: Some(call("square", vec![var("n")])) },
+                Stmt::VarDecl {
+                    var_type: Type::I32,
+                    name: "b".into(),
+                    value: Some(call("square", vec![add(var("a"), Expr::Number(1))])),
+                },
+                Stmt::Expr(call("asm_memcpy", vec![])),
+                Stmt::Return(Some(call("inc", vec![add(var("a"), var("b"))]))),
+            ],
+        ));
+        let mut options = LtoOptions::default();
+        options.external_leaves.insert("asm_memcpy".into());
+
+        let stats = optimize(&mut program, &options);
+        assert_eq!(stats.calls_inlined, 2, "square(n) e inc(a + b); square(a + 1) repetiría a + 1");
+        assert_eq!(stats.globals_stripped, 1);
+        let names: Vec<&str> = program.functions.iter().map(|f| f.name.as_str()).collect();
+        assert_eq!(names, vec!["square", "main"]);
+        let main = &program.functions[1];
+        assert!(matches!(&main.body[0], Stmt::VarDecl { value: Some(Expr::BinaryOp { op: BinOp::Mul, .. }), .. }));
+        assert!(matches!(&main.body[3], Stmt::Return(Some(Expr::BinaryOp { op: BinOp::Add, .. }))));
+    }
+
+    #[test]
+    fn test_inlining_goes_bottom_up_across_tus() {
+        // outer solo es hoja cuando inner ya se expandió; fact es recursiva
+        let mut program = Program::new();
+        let double = Expr::BinaryOp { op: BinOp::Mul, left: Box::new(var("x")), right: Box::new(Expr::Number(2)) };
+        program.functions.push(func(
+            "outer",
+            &[("x", Type::I32)],
+            vec![Stmt::Return(Some(add(call("inner", vec![var("x")]), Expr::Number(1))))],
+        ));
+        program.functions.push(func("inner", &[("x", Type::I32)], vec![Stmt::Return(Some(double))]));
+        program.functions.push(func(
+            "fact",
+            &[("n", Type::I32)],
+            vec![Stmt::Return(Some(call("fact", vec![var("n")])))],
+        ));
+        program.functions.push(func(
+            "main",
+            &[("n", Type::I32)],
+            vec![Stmt::Return(Some(add(call("outer", vec![var("n")]), call("fact", vec![var("n")]))))],
+        ));
+
+        let stats = optimize(&mut program, &LtoOptions::default());
+        assert_eq!(stats.calls_inlined, 2);
+        assert_eq!(stats.functions_stripped, 2);
+        let names: Vec<&str> = program.functions.iter().map(|f| f.name.as_str()).collect();
+        assert_eq!(names, vec!["fact", "main"]);
+        let Stmt::Return(Some(Expr::BinaryOp { left, .. })) = &program.functions[1].body[0] else { panic!() };
+        assert!(matches!(left.as_ref(), Expr::BinaryOp { op: BinOp::Add, .. }));
+    }
+
+    #[test]
+    fn test_raw_binaries_keep_every_function() {
+        let mut program = Program::new();
+        program.attributes.mode = OutputMode::Raw;
+        program.functions.push(func("main", &[], vec![Stmt::Return(Some(Expr::Number(0)))]));
+        program.functions.push(func("isr_timer", &[], vec![Stmt::Return(None)]));
+        assert_eq!(strip_unreachable(&mut program, &LtoOptions::default()), (0, 0));
+    }
+
+    #[test]
+    fn test_rename_symbols_skips_shadowing_locals() {
+        let mut program = Program::new();
+        program.statements.push(global("count", Type::I32, Some(Expr::Number(0))));
+        program.functions.push(func("helper", &[], vec![Stmt::Return(Some(var("count")))]));
+        program.functions.push(func("shadow", &[("count", Type::I32)], vec![Stmt::Return(Some(var("count")))]));
+        program.functions.push(func("main", &[], vec![Stmt::Return(Some(call("helper", vec![])))]));
+        program.attributes.internal_symbols = ["count".to_string(), "helper".to_string()].into();
+        let renames: HashMap<String, String> =
+            [("count", "__tu1_count"), ("helper", "__tu1_helper")].iter().map(|&(a, b)| (a.into(), b.into())).collect();
+
+        rename_symbols(&mut program, &renames);
+        assert!(matches!(&program.statements[0], Stmt::VarDecl { name, .. } if name == "__tu1_count"));
+        assert_eq!(program.functions[0].name, "__tu1_helper");
+        assert!(matches!(&program.functions[0].body[0], Stmt::Return(Some(Expr::Variable(v))) if v == "__tu1_count"));
+        assert!(matches!(&program.functions[1].body[0], Stmt::Return(Some(Expr::Variable(v))) if v == "count"));
+        assert!(
+            matches!(&program.functions[2].body[0], Stmt::Return(Some(Expr::Call { name, .. })) if name == "__tu1_helper")
+        );
+        assert!(program.attributes.internal_symbols.contains("__tu1_helper"));
+    }
+}
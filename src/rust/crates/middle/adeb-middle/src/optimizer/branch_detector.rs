@@ -1,4 +1,5 @@
 use crate::optimizer::ast_types::*;
+use crate::profile::FunctionProfile;
 
 #[derive(Debug, Clone)]
 pub enum BranchPattern {
@@ -24,17 +25,34 @@ pub enum BranchPattern {
     },
 }
 
-pub struct BranchDetector;
+pub struct BranchDetector {
+    profile: Option<FunctionProfile>,
+}
 
 impl BranchDetector {
     pub fn new() -> Self {
-        Self
+        Self { profile: None }
+    }
+
+    /// Con el perfil de la función: un if que casi siempre va al mismo
+    /// lado se deja como salto (el predictor acierta y el cmov obligaría
+    /// a evaluar los dos brazos). `analyze` recibe entonces el cuerpo
+    /// entero, para que los sites se numeren como en `profile::site_stmts`.
+    pub fn with_profile(profile: FunctionProfile) -> Self {
+        Self { profile: Some(profile) }
     }
 
     pub fn analyze(&self, stmts: &[Stmt]) -> Vec<BranchPattern> {
         let mut patterns = Vec::new();
+        let mut next_site = 0;
 
         for stmt in stmts {
+            let site = next_site;
+            next_site += site_count(stmt);
+            if self.is_predictable(site) {
+                continue;
+            }
+
             // Detectar ReLU: if x > 0 { result = x } else { result = 0 }
             if let Some(pattern) = self.detect_relu(stmt) {
                 patterns.push(pattern);
@@ -51,6 +69,13 @@ impl BranchDetector {
         patterns
     }
 
+    fn is_predictable(&self, site: usize) -> bool {
+        self.profile
+            .as_ref()
+            .and_then(|p| p.site(site))
+            .map_or(false, |s| s.is_predictable())
+    }
+
     fn detect_relu(&self, stmt: &Stmt) -> Option<BranchPattern> {
         if let Stmt::If {
             condition,
@@ -138,3 +163,54 @@ impl BranchDetector {
         None
     }
 }
+
+/// Sites (if/while/do/for) de `stmt` y sus cuerpos, en pre-orden
+fn site_count(stmt: &Stmt) -> usize {
+    let nested = |body: &[Stmt]| body.iter().map(site_count).sum::<usize>();
+    match stmt {
+        Stmt::If { then_body, else_body, .. } => {
+            1 + nested(then_body) + else_body.as_deref().map_or(0, nested)
+        }
+        Stmt::While { body, .. } | Stmt::DoWhile { body, .. } | Stmt::For { body, .. } => 1 + nested(body),
+        _ => 0,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::profile::{SiteCount, SiteKind};
+
+    fn select(target: &str) -> Stmt {
+        Stmt::If {
+            condition: Expr::Variable("c".to_string()),
+            then_body: vec![Stmt::Assign { name: target.to_string(), value: Expr::Number(1) }],
+            else_body: Some(vec![Stmt::Assign { name: target.to_string(), value: Expr::Number(2) }]),
+        }
+    }
+
+    #[test]
+    fn test_profile_keeps_predictable_branches() {
+        // site 0: while, site 1: select dentro del while, site 2 y 3: selects
+        let body = vec![
+            Stmt::While { condition: Expr::Variable("n".to_string()), body: vec![select("a")] },
+            select("b"),
+            select("c"),
+        ];
+        assert_eq!(BranchDetector::new().analyze(&body).len(), 2);
+
+        let site = |reached, taken| SiteCount { kind: SiteKind::If, reached, taken };
+        let profile = FunctionProfile {
+            entry: 1,
+            sites: vec![
+                SiteCount { kind: SiteKind::Loop, reached: 1, taken: 100 },
+                site(100, 50),
+                site(1000, 999),
+                site(1000, 480),
+            ],
+        };
+        let patterns = BranchDetector::with_profile(profile).analyze(&body);
+        assert_eq!(patterns.len(), 1);
+        assert!(matches!(&patterns[0], BranchPattern::Select { target, .. } if target == "c"));
+    }
+}
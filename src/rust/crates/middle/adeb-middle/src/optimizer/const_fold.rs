@@ -38,7 +38,7 @@ impl ConstFolder {
 
     fn fold_stmt(&self, stmt: &mut Stmt) {
         match stmt {
-            Stmt::Assign { value, .. } => {
+            Stmt::VarDecl { value: Some(value), .. } | Stmt::Assign { value, .. } => {
                 *value = self.fold_expr(value.clone());
             }
             Stmt::Print(expr) | Stmt::Println(expr) | Stmt::PrintNum(expr) => {
@@ -39,6 +39,19 @@ impl ConstPropagator {
                 constants.insert(name.clone(), *n);
                 stmt.clone()
             }
+            Stmt::VarDecl {
+                var_type,
+                name,
+                value: Some(value),
+            } => {
+                let value = self.propagate_expr(value, constants);
+                constants.remove(name);
+                Stmt::VarDecl {
+                    name: name.clone(),
+                    var_type: var_type.clone(),
+                    value: Some(value),
+                }
+            }
             // x = 5; → track x=5 (if simple assignment)
             Stmt::Assign { name, value } => {
                 if let Expr::Number(n) = value {
@@ -55,17 +68,31 @@ impl ConstPropagator {
                 condition,
                 then_body,
                 else_body,
-            } => Stmt::If {
-                condition: self.propagate_expr(condition, constants),
-                then_body: self.propagate_stmts(then_body, &mut constants.clone()),
-                else_body: else_body
-                    .as_ref()
-                    .map(|eb| self.propagate_stmts(eb, &mut constants.clone())),
-            },
-            Stmt::While { condition, body } => Stmt::While {
-                condition: self.propagate_expr(condition, constants),
-                body: self.propagate_stmts(body, &mut constants.clone()),
-            },
+            } => {
+                let propagated = Stmt::If {
+                    condition: self.propagate_expr(condition, constants),
+                    then_body: self.propagate_stmts(then_body, &mut constants.clone()),
+                    else_body: else_body
+                        .as_ref()
+                        .map(|eb| self.propagate_stmts(eb, &mut constants.clone())),
+                };
+                // Lo asignado en cualquier rama ya no es constante despues del if
+                Self::forget_assigned(std::slice::from_ref(stmt), constants);
+                propagated
+            }
+            // Lo asignado en el cuerpo cambia entre iteraciones: ni la
+            // condicion ni el cuerpo pueden usar el valor de antes del bucle
+            Stmt::While { condition, body } => {
+                Self::forget_assigned(body, constants);
+                Stmt::While {
+                    condition: self.propagate_expr(condition, constants),
+                    body: self.propagate_stmts(body, &mut constants.clone()),
+                }
+            }
+            Stmt::DoWhile { .. } | Stmt::For { .. } => {
+                Self::forget_assigned(std::slice::from_ref(stmt), constants);
+                stmt.clone()
+            }
             Stmt::Print(expr) => Stmt::Print(self.propagate_expr(expr, constants)),
             Stmt::Println(expr) => Stmt::Println(self.propagate_expr(expr, constants)),
             Stmt::PrintNum(expr) => Stmt::PrintNum(self.propagate_expr(expr, constants)),
@@ -75,6 +102,35 @@ impl ConstPropagator {
         }
     }
 
+    /// Quita de `constants` toda variable escrita en `stmts`
+    fn forget_assigned(stmts: &[Stmt], constants: &mut HashMap<String, i64>) {
+        for stmt in stmts {
+            match stmt {
+                Stmt::VarDecl { name, .. } | Stmt::Assign { name, .. } => {
+                    constants.remove(name);
+                }
+                Stmt::If {
+                    then_body,
+                    else_body,
+                    ..
+                } => {
+                    Self::forget_assigned(then_body, constants);
+                    if let Some(eb) = else_body {
+                        Self::forget_assigned(eb, constants);
+                    }
+                }
+                Stmt::While { body, .. } | Stmt::DoWhile { body, .. } => {
+                    Self::forget_assigned(body, constants);
+                }
+                Stmt::For { var, body, .. } => {
+                    constants.remove(var);
+                    Self::forget_assigned(body, constants);
+                }
+                _ => {}
+            }
+        }
+    }
+
     fn propagate_expr(&self, expr: &Expr, constants: &HashMap<String, i64>) -> Expr {
         match expr {
             Expr::Variable(name) => {
@@ -23,6 +23,19 @@ impl DeadCodeEliminator {
     fn eliminate_stmts(&self, stmts: &[Stmt]) -> Vec<Stmt> {
         let mut result = Vec::new();
         for stmt in stmts {
+            // if constante: la rama que queda se integra entera
+            if let Stmt::If { condition, then_body, else_body } = stmt {
+                if Self::is_always_true(condition) {
+                    result.extend(self.eliminate_stmts(then_body));
+                    continue;
+                }
+                if Self::is_always_false(condition) {
+                    if let Some(eb) = else_body {
+                        result.extend(self.eliminate_stmts(eb));
+                    }
+                    continue;
+                }
+            }
             result.push(self.eliminate_stmt(stmt));
             // Statements after return are unreachable
             if matches!(stmt, Stmt::Return(_)) {
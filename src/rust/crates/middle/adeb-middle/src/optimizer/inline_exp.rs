@@ -3,39 +3,351 @@
 // ============================================================
 // Si una funcion es suficientemente pequena, se expande inline.
 // Sin overhead de call/ret.
+//
+//   1. Call graph + SCCs (Tarjan): una funcion en un ciclo
+//      (o que se llama a si misma) nunca se inlinea
+//   2. SCCs en orden bottom-up: los callees ya vienen inlineados
+//      cuando se expanden en sus callers
+//   3. Cost model: tamano del cuerpo (nodos del AST) contra el
+//      overhead del call, con bonus por argumento constante y por
+//      callee con un solo call site (la copia out-of-line muere).
+//      Con perfil (`with_profile`): un callee que nunca se ejecutó no
+//      se inlinea y uno caliente recibe un bonus
+//   4. Rewriting:
+//        - `return e;`  → la llamada se reemplaza por `e` con los
+//          parametros sustituidos por los argumentos
+//        - cuerpo general en `x = f(..)`, `int x = f(..)`, `f(..);`
+//          y `return f(..)` → parametros como locales renombrados
+//          (`__inl{n}_p`) y el return final como asignacion
+//   5. Const fold/prop + DCE otra vez sobre el programa, y se
+//      eliminan las funciones que quedaron sin llamadas
+//
+// `run` trabaja sobre `ast_types`; `run_typed` aplica el mismo call
+// graph y cost model al Program de adeb_core que compila el driver C
+// (y -flto sobre el programa enlazado).
 // ============================================================
 
-use crate::optimizer::ast_types::{Function, Program};
+use crate::ast_walk::{declared_names as typed_locals, is_integer, is_root, walk_expr, walk_stmts, Visitor};
+use crate::optimizer::ast_types::{Expr, Function, Program, Stmt};
+use crate::optimizer::const_fold::ConstFolder;
+use crate::optimizer::const_prop::ConstPropagator;
+use crate::optimizer::dead_code::DeadCodeEliminator;
+use crate::profile::Profile;
+use adeb_core::ast as typed;
+use adeb_core::types::Type;
+use std::collections::{HashMap, HashSet};
 
 /// Threshold: funciones con menos de este numero de statements se inlinean
 const INLINE_THRESHOLD: usize = 5;
 
+/// call + prologue/epilogue + movs de argumentos, en nodos del AST
+const CALL_OVERHEAD: i64 = 4;
+
+/// Un argumento constante suele plegar parte del cuerpo
+const CONST_ARG_BONUS: i64 = 3;
+
+/// Crecimiento maximo de codigo (en nodos) por call site inlineado
+const INLINE_GROWTH: i64 = 8;
+
+/// Callee caliente segun el perfil: el call evitado se paga muchas veces
+const HOT_CALLEE_BONUS: i64 = 4;
+
+// ============================================================
+// Call graph
+// ============================================================
+
+pub struct CallGraph {
+    names: Vec<String>,
+    index: HashMap<String, usize>,
+    /// callees[f] = funciones del programa llamadas desde f (sin repetir)
+    callees: Vec<Vec<usize>>,
+    /// Numero de call sites de cada funcion, en todo el programa
+    sites: Vec<usize>,
+    /// scc_of[f] = indice en `sccs`
+    scc_of: Vec<usize>,
+    /// SCCs en orden bottom-up (callees antes que callers)
+    sccs: Vec<Vec<usize>>,
+}
+
+impl CallGraph {
+    pub fn build(program: &Program) -> Self {
+        let calls = program
+            .functions
+            .iter()
+            .map(|func| {
+                let mut calls = Vec::new();
+                collect_calls(&func.body, &mut calls);
+                (func.name.clone(), calls)
+            })
+            .collect();
+        let mut top = Vec::new();
+        collect_calls(&program.statements, &mut top);
+        Self::from_calls(calls, top)
+    }
+
+    /// Mismo grafo sobre el Program con tipos que produce el frontend C
+    pub fn build_typed(program: &mut typed::Program) -> Self {
+        let calls = program
+            .functions
+            .iter_mut()
+            .map(|func| (func.name.clone(), typed_calls(&mut func.body)))
+            .collect();
+        let top = typed_calls(&mut program.statements);
+        Self::from_calls(calls, top)
+    }
+
+    /// (funcion, llamadas en su cuerpo) + llamadas fuera de funciones
+    fn from_calls(calls: Vec<(String, Vec<String>)>, top: Vec<String>) -> Self {
+        let names: Vec<String> = calls.iter().map(|(name, _)| name.clone()).collect();
+        let index: HashMap<String, usize> = names.iter().enumerate().map(|(i, n)| (n.clone(), i)).collect();
+        let mut callees = vec![Vec::new(); names.len()];
+        let mut sites = vec![0; names.len()];
+
+        for (f, (_, calls)) in calls.into_iter().enumerate() {
+            for name in calls {
+                if let Some(&g) = index.get(&name) {
+                    sites[g] += 1;
+                    if !callees[f].contains(&g) {
+                        callees[f].push(g);
+                    }
+                }
+            }
+        }
+        for name in top {
+            if let Some(&g) = index.get(&name) {
+                sites[g] += 1;
+            }
+        }
+
+        let mut graph = Self {
+            names,
+            index,
+            callees,
+            sites,
+            scc_of: Vec::new(),
+            sccs: Vec::new(),
+        };
+        graph.compute_sccs();
+        graph
+    }
+
+    /// Tarjan: las SCCs salen en orden topologico inverso (bottom-up)
+    fn compute_sccs(&mut self) {
+        struct Tarjan<'g> {
+            callees: &'g [Vec<usize>],
+            next: usize,
+            order: Vec<Option<usize>>,
+            low: Vec<usize>,
+            stack: Vec<usize>,
+            on_stack: Vec<bool>,
+            sccs: Vec<Vec<usize>>,
+        }
+
+        impl Tarjan<'_> {
+            fn visit(&mut self, v: usize) {
+                self.order[v] = Some(self.next);
+                self.low[v] = self.next;
+                self.next += 1;
+                self.stack.push(v);
+                self.on_stack[v] = true;
+
+                for k in 0..self.callees[v].len() {
+                    let w = self.callees[v][k];
+                    match self.order[w] {
+                        None => {
+                            self.visit(w);
+                            self.low[v] = self.low[v].min(self.low[w]);
+                        }
+                        Some(ow) if self.on_stack[w] => self.low[v] = self.low[v].min(ow),
+                        Some(_) => {}
+                    }
+                }
+
+                if Some(self.low[v]) == self.order[v] {
+                    let mut scc = Vec::new();
+                    while let Some(w) = self.stack.pop() {
+                        self.on_stack[w] = false;
+                        scc.push(w);
+                        if w == v {
+                            break;
+                        }
+                    }
+                    self.sccs.push(scc);
+                }
+            }
+        }
+
+        let n = self.names.len();
+        let mut t = Tarjan {
+            callees: &self.callees,
+            next: 0,
+            order: vec![None; n],
+            low: vec![0; n],
+            stack: Vec::new(),
+            on_stack: vec![false; n],
+            sccs: Vec::new(),
+        };
+        for v in 0..n {
+            if t.order[v].is_none() {
+                t.visit(v);
+            }
+        }
+        let sccs = t.sccs;
+
+        self.scc_of = vec![0; n];
+        for (s, scc) in sccs.iter().enumerate() {
+            for &f in scc {
+                self.scc_of[f] = s;
+            }
+        }
+        self.sccs = sccs;
+    }
+
+    /// Funciones del programa llamadas desde `name`
+    pub fn callees(&self, name: &str) -> Vec<&str> {
+        self.index.get(name).map_or_else(Vec::new, |&f| {
+            self.callees[f].iter().map(|&g| self.names[g].as_str()).collect()
+        })
+    }
+
+    /// Call sites de `name` en todo el programa
+    pub fn call_sites(&self, name: &str) -> usize {
+        self.index.get(name).map_or(0, |&f| self.sites[f])
+    }
+
+    /// true si `name` se alcanza a si misma (directa o mutuamente)
+    pub fn is_recursive(&self, name: &str) -> bool {
+        self.index.get(name).map_or(false, |&f| {
+            self.sccs[self.scc_of[f]].len() > 1 || self.callees[f].contains(&f)
+        })
+    }
+
+    /// SCCs en orden bottom-up, por nombre
+    pub fn sccs(&self) -> Vec<Vec<&str>> {
+        self.sccs
+            .iter()
+            .map(|scc| scc.iter().map(|&f| self.names[f].as_str()).collect())
+            .collect()
+    }
+}
+
+// ============================================================
+// Inliner
+// ============================================================
+
+/// Resultado de `InlineExpander::run`
+#[derive(Debug, Clone, Default)]
+pub struct InlineStats {
+    /// Call sites reemplazados por el cuerpo del callee
+    pub inlined_calls: usize,
+    /// Funciones eliminadas porque ya nadie las llama
+    pub removed_functions: Vec<String>,
+}
+
 pub struct InlineExpander {
     threshold: usize,
+    profile: Option<Profile>,
 }
 
 impl InlineExpander {
     pub fn new() -> Self {
         Self {
             threshold: INLINE_THRESHOLD,
+            profile: None,
         }
     }
 
     pub fn with_threshold(threshold: usize) -> Self {
-        Self { threshold }
+        Self {
+            threshold,
+            profile: None,
+        }
+    }
+
+    /// Decide con los conteos de entrada de `-fprofile-use`
+    pub fn with_profile(mut self, profile: Profile) -> Self {
+        self.profile = Some(profile);
+        self
     }
 
     /// Identifica funciones candidatas a inline (pequenas, no recursivas)
     pub fn find_inline_candidates<'a>(&self, program: &'a Program) -> Vec<&'a Function> {
+        let graph = CallGraph::build(program);
         program
             .functions
             .iter()
-            .filter(|f| self.is_inlineable(f))
+            .filter(|f| self.is_inlineable(f, &graph))
             .collect()
     }
 
+    /// Inlinea el programa bottom-up y limpia con const prop + DCE
+    pub fn run(&self, program: &mut Program) -> InlineStats {
+        let graph = CallGraph::build(program);
+        let mut stats = InlineStats::default();
+        let mut ready: HashMap<String, Function> = HashMap::new();
+        let mut counter = 0;
+
+        for scc in graph.sccs() {
+            for name in scc {
+                let f = program.functions.iter().position(|f| f.name == name).unwrap();
+                let func = &program.functions[f];
+                let mut site = Inliner {
+                    expander: self,
+                    graph: &graph,
+                    ready: &ready,
+                    scope: declared_names(&func.params, &func.body),
+                    counter: &mut counter,
+                    inlined: 0,
+                };
+                let body = site.inline_stmts(&func.body);
+                stats.inlined_calls += site.inlined;
+                program.functions[f].body = body;
+
+                let func = &program.functions[f];
+                if self.is_inlineable(func, &graph) {
+                    ready.insert(func.name.clone(), func.clone());
+                }
+            }
+        }
+        let mut site = Inliner {
+            expander: self,
+            graph: &graph,
+            ready: &ready,
+            scope: declared_names(&[], &program.statements),
+            counter: &mut counter,
+            inlined: 0,
+        };
+        program.statements = site.inline_stmts(&program.statements);
+        stats.inlined_calls += site.inlined;
+
+        if stats.inlined_calls == 0 {
+            return stats;
+        }
+
+        // Los argumentos constantes ya son locales: plegarlos
+        let folder = ConstFolder::new();
+        folder.fold_program(program);
+        ConstPropagator::new().propagate(program);
+        folder.fold_program(program);
+        DeadCodeEliminator::new().eliminate(program);
+
+        // Funciones inlineadas en todos sus call sites
+        let after = CallGraph::build(program);
+        program.functions.retain(|f| {
+            let dead = f.name != "main"
+                && ready.contains_key(&f.name)
+                && graph.call_sites(&f.name) > 0
+                && after.call_sites(&f.name) == 0;
+            if dead {
+                stats.removed_functions.push(f.name.clone());
+            }
+            !dead
+        });
+        stats
+    }
+
     /// Retorna true si la funcion es candidata a inline
-    fn is_inlineable(&self, func: &Function) -> bool {
+    fn is_inlineable(&self, func: &Function, graph: &CallGraph) -> bool {
         // Muy grande → no inlinear
         if func.body.len() > self.threshold {
             return false;
@@ -45,17 +357,43 @@ impl InlineExpander {
             return false;
         }
         // Funciones recursivas no se inlinean
-        if self.is_recursive(func) {
+        if self.is_recursive(func, graph) {
             return false;
         }
-        true
+        // Nunca se ejecutó en el perfil: inlinearla solo agranda el caller
+        if self.profile.as_ref().map_or(false, |p| p.is_cold(&func.name)) {
+            return false;
+        }
+        // Solo se sabe reescribir un return al final del cuerpo
+        let (last, init) = match func.body.split_last() {
+            Some(split) => split,
+            None => return true,
+        };
+        !init.iter().any(contains_return) && (matches!(last, Stmt::Return(_)) || !contains_return(last))
+    }
+
+    /// Detecta si una funcion se llama a si misma (directa o por un ciclo)
+    fn is_recursive(&self, func: &Function, graph: &CallGraph) -> bool {
+        graph.is_recursive(&func.name)
     }
 
-    /// Detecta si una funcion se llama a si misma
-    fn is_recursive(&self, _func: &Function) -> bool {
-        // Simplificado: busca llamadas con el mismo nombre
-        // Un analisis completo recorreria el AST
-        false // Conservador por ahora
+    /// Costo neto de inlinear `callee` en un call site; <= INLINE_GROWTH se inlinea
+    pub fn inline_cost(&self, callee: &Function, args: &[Expr], call_sites: usize) -> i64 {
+        let size = callee.body.iter().map(stmt_size).sum::<usize>() as i64;
+        let consts = args.iter().filter(|a| is_constant(a)).count() as i64;
+        self.net_cost(&callee.name, size, consts, call_sites)
+    }
+
+    /// Cuerpo de `size` nodos con `consts` argumentos constantes
+    fn net_cost(&self, name: &str, size: i64, consts: i64, call_sites: usize) -> i64 {
+        let mut cost = size - CALL_OVERHEAD - CONST_ARG_BONUS * consts;
+        if call_sites == 1 {
+            cost -= size;
+        }
+        if self.profile.as_ref().map_or(false, |p| p.is_hot(name)) {
+            cost -= HOT_CALLEE_BONUS;
+        }
+        cost
     }
 
     /// Retorna el threshold actual
@@ -70,9 +408,733 @@ impl Default for InlineExpander {
     }
 }
 
+/// Destino del valor de retorno en un inline a nivel de statement
+#[derive(Clone)]
+enum Sink {
+    Discard,
+    Assign(String),
+    Declare(String, Option<String>),
+    Return,
+}
+
+/// Estado de inlining dentro de un caller
+struct Inliner<'a> {
+    expander: &'a InlineExpander,
+    graph: &'a CallGraph,
+    /// Callees ya procesados e inlineables
+    ready: &'a HashMap<String, Function>,
+    /// Nombres declarados en el caller (para evitar captura)
+    scope: HashSet<String>,
+    counter: &'a mut usize,
+    inlined: usize,
+}
+
+impl<'a> Inliner<'a> {
+    fn inline_stmts(&mut self, stmts: &[Stmt]) -> Vec<Stmt> {
+        let mut out = Vec::with_capacity(stmts.len());
+        for stmt in stmts {
+            self.inline_stmt(stmt, &mut out);
+        }
+        out
+    }
+
+    fn inline_stmt(&mut self, stmt: &Stmt, out: &mut Vec<Stmt>) {
+        // Llamada en posicion de statement: se puede expandir el cuerpo entero
+        let (call, sink) = match stmt {
+            Stmt::Expr(e @ Expr::Call { .. }) => (e, Sink::Discard),
+            Stmt::Assign { name, value: e @ Expr::Call { .. } } => (e, Sink::Assign(name.clone())),
+            Stmt::VarDecl { name, var_type, value: Some(e @ Expr::Call { .. }) } => {
+                (e, Sink::Declare(name.clone(), var_type.clone()))
+            }
+            Stmt::Return(Some(e @ Expr::Call { .. })) => (e, Sink::Return),
+            _ => {
+                out.push(self.rewrite_stmt(stmt));
+                return;
+            }
+        };
+        let (name, args) = match call {
+            Expr::Call { name, args } => (name, args.iter().map(|a| self.inline_expr(a)).collect::<Vec<_>>()),
+            _ => unreachable!(),
+        };
+        let value = match self.expand_expr(name, &args) {
+            Some(e) => e,
+            None => match self.expand_stmts(name, &args, &sink) {
+                Some(body) => {
+                    out.extend(body);
+                    return;
+                }
+                None => Expr::Call { name: name.clone(), args },
+            },
+        };
+        out.push(sink_stmt(sink, value));
+    }
+
+    fn rewrite_stmt(&mut self, stmt: &Stmt) -> Stmt {
+        match stmt {
+            Stmt::VarDecl { name, var_type, value } => Stmt::VarDecl {
+                name: name.clone(),
+                var_type: var_type.clone(),
+                value: value.as_ref().map(|v| self.inline_expr(v)),
+            },
+            Stmt::Assign { name, value } => Stmt::Assign {
+                name: name.clone(),
+                value: self.inline_expr(value),
+            },
+            Stmt::If { condition, then_body, else_body } => Stmt::If {
+                condition: self.inline_expr(condition),
+                then_body: self.inline_stmts(then_body),
+                else_body: else_body.as_ref().map(|eb| self.inline_stmts(eb)),
+            },
+            Stmt::While { condition, body } => Stmt::While {
+                condition: self.inline_expr(condition),
+                body: self.inline_stmts(body),
+            },
+            Stmt::DoWhile { body, condition } => Stmt::DoWhile {
+                body: self.inline_stmts(body),
+                condition: self.inline_expr(condition),
+            },
+            Stmt::For { var, start, end, body } => Stmt::For {
+                var: var.clone(),
+                start: self.inline_expr(start),
+                end: self.inline_expr(end),
+                body: self.inline_stmts(body),
+            },
+            Stmt::Print(e) => Stmt::Print(self.inline_expr(e)),
+            Stmt::Println(e) => Stmt::Println(self.inline_expr(e)),
+            Stmt::PrintNum(e) => Stmt::PrintNum(self.inline_expr(e)),
+            Stmt::Expr(e) => Stmt::Expr(self.inline_expr(e)),
+            Stmt::Return(Some(e)) => Stmt::Return(Some(self.inline_expr(e))),
+            Stmt::Return(None) | Stmt::Pass => stmt.clone(),
+        }
+    }
+
+    /// Post-order: los argumentos se inlinean antes que la llamada
+    fn inline_expr(&mut self, expr: &Expr) -> Expr {
+        let mut f = |e: Expr| match e {
+            Expr::Call { name, args } => match self.expand_expr(&name, &args) {
+                Some(inlined) => inlined,
+                None => Expr::Call { name, args },
+            },
+            other => other,
+        };
+        map_expr(expr, &mut f)
+    }
+
+    /// Callee listo y rentable para este call site
+    fn callee(&self, name: &str, args: &[Expr]) -> Option<&'a Function> {
+        let ready: &'a HashMap<String, Function> = self.ready;
+        let callee = ready.get(name)?;
+        if callee.params.len() != args.len() {
+            return None;
+        }
+        let cost = self.expander.inline_cost(callee, args, self.graph.call_sites(name));
+        (cost <= INLINE_GROWTH).then_some(callee)
+    }
+
+    /// `int f(a, b) { return e; }` → e[a := arg0, b := arg1]
+    fn expand_expr(&mut self, name: &str, args: &[Expr]) -> Option<Expr> {
+        let callee = self.callee(name, args)?;
+        let body = match callee.body.as_slice() {
+            [Stmt::Return(Some(e))] => e,
+            _ => return None,
+        };
+        // Solo parametros: nada que capturar del scope del caller
+        let mut names = Vec::new();
+        expr_names(body, &mut names);
+        if names.iter().any(|n| !callee.params.contains(n)) {
+            return None;
+        }
+        // Un argumento con efectos o caro debe evaluarse exactamente una vez
+        for (param, arg) in callee.params.iter().zip(args) {
+            let uses = names.iter().filter(|n| *n == param).count();
+            if !is_trivial(arg) && (uses != 1 || has_call(arg)) {
+                return None;
+            }
+        }
+
+        let subst: HashMap<&str, &Expr> = callee.params.iter().map(|p| p.as_str()).zip(args).collect();
+        let mut f = |e: Expr| match &e {
+            Expr::Variable(n) | Expr::Identifier(n) => subst.get(n.as_str()).map_or(e.clone(), |a| (*a).clone()),
+            _ => e,
+        };
+        let inlined = map_expr(body, &mut f);
+        self.inlined += 1;
+        Some(inlined)
+    }
+
+    /// Cuerpo general: parametros como locales renombrados, return final → sink
+    fn expand_stmts(&mut self, name: &str, args: &[Expr], sink: &Sink) -> Option<Vec<Stmt>> {
+        let callee = self.callee(name, args)?;
+        let (body, ret) = match callee.body.split_last() {
+            Some((Stmt::Return(value), init)) => (init, value.as_ref()),
+            _ => (callee.body.as_slice(), None),
+        };
+        if ret.is_none() && !matches!(sink, Sink::Discard) {
+            return None;
+        }
+
+        let locals = declared_names(&callee.params, &callee.body);
+        let mut free = Vec::new();
+        for stmt in &callee.body {
+            stmt_names(stmt, &mut free);
+        }
+        if free.iter().any(|n| !locals.contains(n) && self.scope.contains(n)) {
+            return None;
+        }
+
+        let n = *self.counter;
+        *self.counter += 1;
+        let rename: HashMap<String, String> = locals
+            .iter()
+            .map(|l| (l.clone(), format!("__inl{}_{}", n, l)))
+            .collect();
+
+        let mut out: Vec<Stmt> = callee
+            .params
+            .iter()
+            .zip(args)
+            .map(|(p, a)| Stmt::VarDecl {
+                name: rename[p].clone(),
+                var_type: None,
+                value: Some(a.clone()),
+            })
+            .collect();
+        out.extend(body.iter().map(|s| rename_stmt(s, &rename)));
+        if let Some(value) = ret {
+            let value = rename_expr(value, &rename);
+            if !matches!(sink, Sink::Discard) || has_call(&value) {
+                out.push(sink_stmt(sink.clone(), value));
+            }
+        }
+        self.scope.extend(rename.into_values());
+        self.inlined += 1;
+        Some(out)
+    }
+}
+
+fn sink_stmt(sink: Sink, value: Expr) -> Stmt {
+    match sink {
+        Sink::Discard => Stmt::Expr(value),
+        Sink::Assign(name) => Stmt::Assign { name, value },
+        Sink::Declare(name, var_type) => Stmt::VarDecl { name, var_type, value: Some(value) },
+        Sink::Return => Stmt::Return(Some(value)),
+    }
+}
+
+// ============================================================
+// AST helpers
+// ============================================================
+
+/// Reconstruye `expr` aplicando `f` a cada nodo, de las hojas a la raiz
+fn map_expr(expr: &Expr, f: &mut dyn FnMut(Expr) -> Expr) -> Expr {
+    let b = |e: &Expr, f: &mut dyn FnMut(Expr) -> Expr| Box::new(map_expr(e, f));
+    let rebuilt = match expr {
+        Expr::BinaryOp { op, left, right } => Expr::BinaryOp { op: *op, left: b(left, f), right: b(right, f) },
+        Expr::UnaryOp { op, expr } => Expr::UnaryOp { op: *op, expr: b(expr, f) },
+        Expr::Comparison { op, left, right } => Expr::Comparison { op: *op, left: b(left, f), right: b(right, f) },
+        Expr::Ternary { condition, then_expr, else_expr } => Expr::Ternary {
+            condition: b(condition, f),
+            then_expr: b(then_expr, f),
+            else_expr: b(else_expr, f),
+        },
+        Expr::BitwiseOp { op, left, right } => Expr::BitwiseOp { op: *op, left: b(left, f), right: b(right, f) },
+        Expr::BitwiseNot(e) => Expr::BitwiseNot(b(e, f)),
+        Expr::Call { name, args } => Expr::Call {
+            name: name.clone(),
+            args: args.iter().map(|a| map_expr(a, f)).collect(),
+        },
+        Expr::Index { object, index } => Expr::Index { object: b(object, f), index: b(index, f) },
+        Expr::Array(items) => Expr::Array(items.iter().map(|a| map_expr(a, f)).collect()),
+        Expr::Cast { target_type, expr } => Expr::Cast { target_type: target_type.clone(), expr: b(expr, f) },
+        leaf => leaf.clone(),
+    };
+    f(rebuilt)
+}
+
+/// Hijos directos de un nodo
+fn expr_children(expr: &Expr) -> Vec<&Expr> {
+    match expr {
+        Expr::BinaryOp { left, right, .. }
+        | Expr::Comparison { left, right, .. }
+        | Expr::BitwiseOp { left, right, .. } => vec![left, right],
+        Expr::UnaryOp { expr, .. } | Expr::BitwiseNot(expr) | Expr::Cast { expr, .. } => vec![expr],
+        Expr::Ternary { condition, then_expr, else_expr } => vec![condition, then_expr, else_expr],
+        Expr::Call { args, .. } | Expr::Array(args) => args.iter().collect(),
+        Expr::Index { object, index } => vec![object, index],
+        _ => Vec::new(),
+    }
+}
+
+/// Expresiones y cuerpos anidados de un statement
+fn stmt_parts(stmt: &Stmt) -> (Vec<&Expr>, Vec<&[Stmt]>) {
+    match stmt {
+        Stmt::VarDecl { value, .. } => (value.iter().collect(), Vec::new()),
+        Stmt::Assign { value, .. } => (vec![value], Vec::new()),
+        Stmt::If { condition, then_body, else_body } => {
+            let mut bodies = vec![then_body.as_slice()];
+            bodies.extend(else_body.as_deref());
+            (vec![condition], bodies)
+        }
+        Stmt::While { condition, body } | Stmt::DoWhile { body, condition } => (vec![condition], vec![body]),
+        Stmt::For { start, end, body, .. } => (vec![start, end], vec![body]),
+        Stmt::Print(e) | Stmt::Println(e) | Stmt::PrintNum(e) | Stmt::Expr(e) => (vec![e], Vec::new()),
+        Stmt::Return(value) => (value.iter().collect(), Vec::new()),
+        Stmt::Pass => (Vec::new(), Vec::new()),
+    }
+}
+
+fn expr_size(expr: &Expr) -> usize {
+    1 + expr_children(expr).into_iter().map(expr_size).sum::<usize>()
+}
+
+fn stmt_size(stmt: &Stmt) -> usize {
+    let (exprs, bodies) = stmt_parts(stmt);
+    1 + exprs.into_iter().map(expr_size).sum::<usize>()
+        + bodies.into_iter().flatten().map(stmt_size).sum::<usize>()
+}
+
+fn collect_expr_calls(expr: &Expr, out: &mut Vec<String>) {
+    if let Expr::Call { name, .. } = expr {
+        out.push(name.clone());
+    }
+    for child in expr_children(expr) {
+        collect_expr_calls(child, out);
+    }
+}
+
+fn collect_calls(stmts: &[Stmt], out: &mut Vec<String>) {
+    for stmt in stmts {
+        let (exprs, bodies) = stmt_parts(stmt);
+        for e in exprs {
+            collect_expr_calls(e, out);
+        }
+        for body in bodies {
+            collect_calls(body, out);
+        }
+    }
+}
+
+fn contains_return(stmt: &Stmt) -> bool {
+    matches!(stmt, Stmt::Return(_)) || stmt_parts(stmt).1.into_iter().flatten().any(contains_return)
+}
+
+fn has_call(expr: &Expr) -> bool {
+    matches!(expr, Expr::Call { .. }) || expr_children(expr).into_iter().any(has_call)
+}
+
+fn is_constant(expr: &Expr) -> bool {
+    matches!(expr, Expr::Number(_) | Expr::Float(_) | Expr::Bool(_) | Expr::String(_))
+}
+
+/// Se puede duplicar o descartar sin cambiar la semantica ni el costo
+fn is_trivial(expr: &Expr) -> bool {
+    is_constant(expr) || matches!(expr, Expr::Variable(_) | Expr::Identifier(_))
+}
+
+/// Variables leidas en una expresion (con repeticiones)
+fn expr_names(expr: &Expr, out: &mut Vec<String>) {
+    if let Expr::Variable(n) | Expr::Identifier(n) = expr {
+        out.push(n.clone());
+    }
+    for child in expr_children(expr) {
+        expr_names(child, out);
+    }
+}
+
+/// Variables leidas o escritas en un statement
+fn stmt_names(stmt: &Stmt, out: &mut Vec<String>) {
+    match stmt {
+        Stmt::VarDecl { name, .. } | Stmt::Assign { name, .. } | Stmt::For { var: name, .. } => out.push(name.clone()),
+        _ => {}
+    }
+    let (exprs, bodies) = stmt_parts(stmt);
+    for e in exprs {
+        expr_names(e, out);
+    }
+    for s in bodies.into_iter().flatten() {
+        stmt_names(s, out);
+    }
+}
+
+/// Parametros + variables declaradas en el cuerpo
+fn declared_names(params: &[String], body: &[Stmt]) -> HashSet<String> {
+    fn walk(stmts: &[Stmt], out: &mut HashSet<String>) {
+        for stmt in stmts {
+            if let Stmt::VarDecl { name, .. } | Stmt::For { var: name, .. } = stmt {
+                out.insert(name.clone());
+            }
+            for body in stmt_parts(stmt).1 {
+                walk(body, out);
+            }
+        }
+    }
+    let mut out: HashSet<String> = params.iter().cloned().collect();
+    walk(body, &mut out);
+    out
+}
+
+fn rename_expr(expr: &Expr, rename: &HashMap<String, String>) -> Expr {
+    let mut f = |e: Expr| match e {
+        Expr::Variable(n) => Expr::Variable(rename.get(&n).cloned().unwrap_or(n)),
+        Expr::Identifier(n) => Expr::Identifier(rename.get(&n).cloned().unwrap_or(n)),
+        other => other,
+    };
+    map_expr(expr, &mut f)
+}
+
+fn rename_stmt(stmt: &Stmt, rename: &HashMap<String, String>) -> Stmt {
+    let name = |n: &String| rename.get(n).cloned().unwrap_or_else(|| n.clone());
+    let expr = |e: &Expr| rename_expr(e, rename);
+    let body = |b: &[Stmt]| b.iter().map(|s| rename_stmt(s, rename)).collect::<Vec<_>>();
+    match stmt {
+        Stmt::VarDecl { name: n, var_type, value } => Stmt::VarDecl {
+            name: name(n),
+            var_type: var_type.clone(),
+            value: value.as_ref().map(expr),
+        },
+        Stmt::Assign { name: n, value } => Stmt::Assign { name: name(n), value: expr(value) },
+        Stmt::If { condition, then_body, else_body } => Stmt::If {
+            condition: expr(condition),
+            then_body: body(then_body),
+            else_body: else_body.as_deref().map(body),
+        },
+        Stmt::While { condition, body: b } => Stmt::While { condition: expr(condition), body: body(b) },
+        Stmt::DoWhile { body: b, condition } => Stmt::DoWhile { body: body(b), condition: expr(condition) },
+        Stmt::For { var, start, end, body: b } => Stmt::For {
+            var: name(var),
+            start: expr(start),
+            end: expr(end),
+            body: body(b),
+        },
+        Stmt::Print(e) => Stmt::Print(expr(e)),
+        Stmt::Println(e) => Stmt::Println(expr(e)),
+        Stmt::PrintNum(e) => Stmt::PrintNum(expr(e)),
+        Stmt::Expr(e) => Stmt::Expr(expr(e)),
+        Stmt::Return(value) => Stmt::Return(value.as_ref().map(expr)),
+        Stmt::Pass => Stmt::Pass,
+    }
+}
+
+// ============================================================
+// Inlining sobre el Program con tipos (adeb_core::ast)
+// ============================================================
+// Lo que compila el driver C. Mismo call graph, mismo orden bottom-up
+// y mismo cost model que `run`; el rewriting es el de `return e;`:
+// solo hojas puras con parametros y retorno enteros/punteros, y solo
+// en call sites cuyos argumentos ya tienen el tipo del parametro, asi
+// la sustitucion no cambia ninguna conversion del call. Lo que los
+// argumentos constantes dejan en el cuerpo se pliega al sustituir.
+
+/// Cuerpo `return e;` listo para sustituir
+struct TypedLeaf {
+    params: Vec<(String, Type)>,
+    body: typed::Expr,
+    size: i64,
+}
+
+impl InlineExpander {
+    /// Inlinea el Program del frontend bottom-up. Las funciones de
+    /// `keep` (entry, simbolos que se llaman desde fuera) ni se
+    /// inlinean ni se eliminan.
+    pub fn run_typed(&self, program: &mut typed::Program, keep: &HashSet<String>) -> InlineStats {
+        let graph = CallGraph::build_typed(program);
+        let mut stats = InlineStats::default();
+        let mut ready: HashMap<String, TypedLeaf> = HashMap::new();
+        let globals: HashMap<String, Type> = program
+            .statements
+            .iter()
+            .filter_map(|s| match s {
+                typed::Stmt::VarDecl { var_type, name, .. } => Some((name.clone(), var_type.clone())),
+                _ => None,
+            })
+            .collect();
+
+        for scc in graph.sccs() {
+            for name in scc {
+                let f = program.functions.iter().position(|f| f.name == name).unwrap();
+                let func = &mut program.functions[f];
+                if !ready.is_empty() {
+                    let mut env = globals.clone();
+                    for (local, ty) in typed_locals(func) {
+                        let conflict = env.get(&local).is_some_and(|t| *t != ty);
+                        env.insert(local, if conflict { Type::Unknown } else { ty });
+                    }
+                    let mut site = TypedInliner { expander: self, graph: &graph, ready: &ready, env, inlined: 0 };
+                    walk_stmts(&mut func.body, &mut site);
+                    stats.inlined_calls += site.inlined;
+                }
+                if !keep.contains(&func.name) && self.is_typed_inlineable(func, &graph) {
+                    if let Some(leaf) = typed_leaf(func) {
+                        ready.insert(func.name.clone(), leaf);
+                    }
+                }
+            }
+        }
+
+        // Flat/raw compilan todas las funciones: ahi no se elimina nada
+        if stats.inlined_calls == 0
+            || matches!(program.attributes.mode, typed::OutputMode::Raw | typed::OutputMode::Flat)
+        {
+            return stats;
+        }
+        // Inlineadas en todos sus call sites y sin la direccion tomada
+        let mut refs = Refs(HashSet::new());
+        for func in &mut program.functions {
+            walk_stmts(&mut func.body, &mut refs);
+        }
+        walk_stmts(&mut program.statements, &mut refs);
+        program.functions.retain(|f| {
+            let dead = ready.contains_key(&f.name) && graph.call_sites(&f.name) > 0 && !refs.0.contains(&f.name);
+            if dead {
+                stats.removed_functions.push(f.name.clone());
+            }
+            !dead
+        });
+        stats
+    }
+
+    fn is_typed_inlineable(&self, func: &typed::Function, graph: &CallGraph) -> bool {
+        func.name != "main"
+            && !is_root(func)
+            && !func.attributes.is_naked
+            && !graph.is_recursive(&func.name)
+            && !self.profile.as_ref().map_or(false, |p| p.is_cold(&func.name))
+    }
+}
+
+/// `return e;` con `e` puro y que solo lee sus parametros
+fn typed_leaf(func: &typed::Function) -> Option<TypedLeaf> {
+    let mut stmts = func.body.iter().filter(|s| !matches!(s, typed::Stmt::LineMarker(_)));
+    let (Some(typed::Stmt::Return(Some(body))), None) = (stmts.next(), stmts.next()) else {
+        return None;
+    };
+    let scalar = |ty: &Type| is_integer(ty) || ty.is_pointer();
+    if !scalar(&func.resolved_return_type) || !func.params.iter().all(|p| scalar(&p.param_type)) {
+        return None;
+    }
+    if !is_pure(body) || typed_has_address_of(body) {
+        return None;
+    }
+    if !typed_names(body).iter().all(|v| func.params.iter().any(|p| &p.name == v)) {
+        return None;
+    }
+    Some(TypedLeaf {
+        params: func.params.iter().map(|p| (p.name.clone(), p.param_type.clone())).collect(),
+        size: 1 + typed_size(body),
+        body: body.clone(),
+    })
+}
+
+/// Estado de inlining dentro de un caller
+struct TypedInliner<'a> {
+    expander: &'a InlineExpander,
+    graph: &'a CallGraph,
+    ready: &'a HashMap<String, TypedLeaf>,
+    /// Tipos de globales, parametros y locales del caller
+    env: HashMap<String, Type>,
+    inlined: usize,
+}
+
+impl Visitor for TypedInliner<'_> {
+    // Post-orden: los argumentos ya vienen inlineados
+    fn expr(&mut self, expr: &mut typed::Expr) {
+        let typed::Expr::Call { name, args } = expr else { return };
+        let Some(leaf) = self.ready.get(name.as_str()) else { return };
+        if args.len() != leaf.params.len() {
+            return;
+        }
+        // Un argumento no trivial debe evaluarse exactamente una vez
+        let trivial = |a: &typed::Expr| matches!(a, typed::Expr::Number(_) | typed::Expr::Variable(_));
+        let uses = typed_names(&leaf.body);
+        let ok = leaf.params.iter().zip(args.iter()).all(|((p, ty), a)| {
+            arg_fits(a, ty, &self.env) && (trivial(a) || uses.iter().filter(|v| *v == p).count() <= 1)
+        });
+        if !ok {
+            return;
+        }
+        let consts = args.iter().filter(|a| matches!(a, typed::Expr::Number(_))).count() as i64;
+        if self.expander.net_cost(name, leaf.size, consts, self.graph.call_sites(name)) > INLINE_GROWTH {
+            return;
+        }
+
+        struct Bind<'b>(HashMap<&'b str, typed::Expr>);
+        impl Visitor for Bind<'_> {
+            fn expr(&mut self, expr: &mut typed::Expr) {
+                if let typed::Expr::Variable(v) = expr {
+                    if let Some(arg) = self.0.get(v.as_str()) {
+                        *expr = arg.clone();
+                    }
+                }
+            }
+        }
+        let mut bind = Bind(leaf.params.iter().map(|(p, _)| p.as_str()).zip(std::mem::take(args)).collect());
+        let mut body = leaf.body.clone();
+        walk_expr(&mut body, &mut bind);
+        walk_expr(&mut body, &mut FoldConstants);
+        *expr = body;
+        self.inlined += 1;
+    }
+}
+
+/// Pliega `c1 op c2` que deja un argumento constante, solo cuando
+/// operandos y resultado caben en int (sin depender del ancho del tipo)
+struct FoldConstants;
+
+impl Visitor for FoldConstants {
+    fn expr(&mut self, expr: &mut typed::Expr) {
+        use typed::{BinOp, Expr as E};
+        let E::BinaryOp { op, left, right } = expr else { return };
+        let (&E::Number(l), &E::Number(r)) = (left.as_ref(), right.as_ref()) else { return };
+        let (Ok(l), Ok(r)) = (i32::try_from(l), i32::try_from(r)) else { return };
+        let value = match op {
+            BinOp::Add => l.checked_add(r),
+            BinOp::Sub => l.checked_sub(r),
+            BinOp::Mul => l.checked_mul(r),
+            _ => None,
+        };
+        if let Some(n) = value {
+            *expr = E::Number(n as i64);
+        }
+    }
+}
+
+/// Expresion sin efectos ni llamadas; los literales float y los casts
+/// a float quedan fuera porque sin tipos no se sabe que convierte el call
+fn is_pure(expr: &typed::Expr) -> bool {
+    use typed::Expr as E;
+    match expr {
+        E::Number(_) | E::Bool(_) | E::Null | E::Nullptr | E::Variable(_) => true,
+        E::BinaryOp { left, right, .. }
+        | E::Comparison { left, right, .. }
+        | E::BitwiseOp { left, right, .. }
+        | E::Index { object: left, index: right } => is_pure(left) && is_pure(right),
+        E::UnaryOp { expr: e, .. }
+        | E::BitwiseNot(e)
+        | E::Deref(e)
+        | E::FieldAccess { object: e, .. }
+        | E::ArrowAccess { pointer: e, .. } => is_pure(e),
+        E::Cast { target_type, expr: e } => (is_integer(target_type) || target_type.is_pointer()) && is_pure(e),
+        E::Ternary { condition, then_expr, else_expr } => {
+            is_pure(condition) && is_pure(then_expr) && is_pure(else_expr)
+        }
+        _ => false,
+    }
+}
+
+/// El argumento se puede sustituir por el parametro `ty` sin cambiar
+/// ni la conversion del call ni la signedness de las operaciones
+fn arg_fits(arg: &typed::Expr, ty: &Type, env: &HashMap<String, Type>) -> bool {
+    use typed::Expr as E;
+    if ty.is_pointer() {
+        return matches!(arg, E::Variable(v) if env.get(v) == Some(ty));
+    }
+    fn int_expr(e: &typed::Expr, unsigned: bool, env: &HashMap<String, Type>) -> bool {
+        match e {
+            E::Number(n) => *n >= 0 || !unsigned,
+            E::Bool(_) => true,
+            E::Variable(v) => env.get(v).is_some_and(|t| is_integer(t) && t.is_unsigned() == unsigned),
+            E::Cast { target_type, expr } => {
+                is_integer(target_type) && target_type.is_unsigned() == unsigned && is_pure(expr)
+            }
+            E::BinaryOp { left, right, .. } | E::BitwiseOp { left, right, .. } => {
+                int_expr(left, unsigned, env) && int_expr(right, unsigned, env)
+            }
+            E::UnaryOp { expr, .. } | E::BitwiseNot(expr) => int_expr(expr, unsigned, env),
+            _ => false,
+        }
+    }
+    int_expr(arg, ty.is_unsigned(), env)
+}
+
+fn typed_calls(stmts: &mut [typed::Stmt]) -> Vec<String> {
+    struct Calls(Vec<String>);
+    impl Visitor for Calls {
+        fn expr(&mut self, expr: &mut typed::Expr) {
+            if let typed::Expr::Call { name, .. } = expr {
+                self.0.push(name.clone());
+            }
+        }
+    }
+    let mut calls = Calls(Vec::new());
+    walk_stmts(stmts, &mut calls);
+    calls.0
+}
+
+/// Nombres que el codigo llama o lee (un puntero a funcion tambien)
+struct Refs(HashSet<String>);
+
+impl Visitor for Refs {
+    fn expr(&mut self, expr: &mut typed::Expr) {
+        if let typed::Expr::Call { name, .. } | typed::Expr::Variable(name) = expr {
+            self.0.insert(name.clone());
+        }
+    }
+}
+
+/// Variables leidas en una expresion (con repeticiones)
+fn typed_names(expr: &typed::Expr) -> Vec<String> {
+    struct Vars(Vec<String>);
+    impl Visitor for Vars {
+        fn expr(&mut self, expr: &mut typed::Expr) {
+            if let typed::Expr::Variable(name) = expr {
+                self.0.push(name.clone());
+            }
+        }
+    }
+    let mut vars = Vars(Vec::new());
+    walk_expr(&mut expr.clone(), &mut vars);
+    vars.0
+}
+
+fn typed_has_address_of(expr: &typed::Expr) -> bool {
+    struct Found(bool);
+    impl Visitor for Found {
+        fn enter(&mut self, expr: &typed::Expr) -> bool {
+            self.0 |= matches!(expr, typed::Expr::AddressOf(_));
+            !self.0
+        }
+    }
+    let mut found = Found(false);
+    walk_expr(&mut expr.clone(), &mut found);
+    found.0
+}
+
+fn typed_size(expr: &typed::Expr) -> i64 {
+    struct Nodes(i64);
+    impl Visitor for Nodes {
+        fn expr(&mut self, _expr: &mut typed::Expr) {
+            self.0 += 1;
+        }
+    }
+    let mut nodes = Nodes(0);
+    walk_expr(&mut expr.clone(), &mut nodes);
+    nodes.0
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::optimizer::ast_types::{BinaryOp, CmpOp};
+
+    fn var(n: &str) -> Expr {
+        Expr::Variable(n.to_string())
+    }
+
+    fn call(n: &str, args: Vec<Expr>) -> Expr {
+        Expr::Call { name: n.to_string(), args }
+    }
+
+    fn bin(op: BinaryOp, l: Expr, r: Expr) -> Expr {
+        Expr::BinaryOp { op, left: Box::new(l), right: Box::new(r) }
+    }
+
+    fn func(name: &str, params: &[&str], body: Vec<Stmt>) -> Function {
+        Function {
+            name: name.to_string(),
+            params: params.iter().map(|p| p.to_string()).collect(),
+            body,
+        }
+    }
 
     #[test]
     fn test_inline_threshold() {
@@ -85,4 +1147,216 @@ mod tests {
         let expander = InlineExpander::with_threshold(10);
         assert_eq!(expander.threshold(), 10);
     }
+
+    #[test]
+    fn test_call_graph_detects_mutual_recursion() {
+        // even ↔ odd forman un ciclo; fact se llama a si misma; leaf no
+        let program = Program {
+            functions: vec![
+                func("even", &["n"], vec![Stmt::Return(Some(call("odd", vec![var("n")])))]),
+                func("odd", &["n"], vec![Stmt::Return(Some(call("even", vec![var("n")])))]),
+                func("fact", &["n"], vec![Stmt::Return(Some(call("fact", vec![var("n")])))]),
+                func("leaf", &["n"], vec![Stmt::Return(Some(var("n")))]),
+                func("main", &[], vec![Stmt::Expr(call("even", vec![Expr::Number(4)]))]),
+            ],
+            statements: Vec::new(),
+        };
+        let graph = CallGraph::build(&program);
+        assert!(graph.is_recursive("even") && graph.is_recursive("odd"));
+        assert!(graph.is_recursive("fact"));
+        assert!(!graph.is_recursive("leaf") && !graph.is_recursive("main"));
+        assert_eq!(graph.call_sites("even"), 2);
+
+        // Bottom-up: el ciclo sale antes que main
+        let sccs = graph.sccs();
+        let pos = |n: &str| sccs.iter().position(|s| s.contains(&n)).unwrap();
+        assert_eq!(pos("even"), pos("odd"));
+        assert!(pos("even") < pos("main"));
+
+        let names: Vec<String> = InlineExpander::new()
+            .find_inline_candidates(&program)
+            .iter()
+            .map(|f| f.name.clone())
+            .collect();
+        assert_eq!(names, vec!["leaf".to_string()]);
+    }
+
+    #[test]
+    fn test_expression_inlining_folds_constant_args() {
+        // int sq(x) { return x * x; }
+        // int add3(a) { return sq(a) + 3; }
+        // main() { int r = add3(4); print(r); }
+        let mut program = Program {
+            functions: vec![
+                func("sq", &["x"], vec![Stmt::Return(Some(bin(BinaryOp::Mul, var("x"), var("x"))))]),
+                func(
+                    "add3",
+                    &["a"],
+                    vec![Stmt::Return(Some(bin(BinaryOp::Add, call("sq", vec![var("a")]), Expr::Number(3))))],
+                ),
+                func(
+                    "main",
+                    &[],
+                    vec![
+                        Stmt::VarDecl { name: "r".into(), var_type: None, value: Some(call("add3", vec![Expr::Number(4)])) },
+                        Stmt::PrintNum(var("r")),
+                    ],
+                ),
+            ],
+            statements: Vec::new(),
+        };
+        let stats = InlineExpander::new().run(&mut program);
+        assert_eq!(stats.inlined_calls, 2);
+        assert_eq!(stats.removed_functions, vec!["sq".to_string(), "add3".to_string()]);
+        assert_eq!(program.functions.len(), 1);
+        let main = &program.functions[0];
+        assert!(matches!(&main.body[0], Stmt::VarDecl { value: Some(Expr::Number(19)), .. }));
+        assert!(matches!(&main.body[1], Stmt::PrintNum(Expr::Number(19))));
+    }
+
+    #[test]
+    fn test_statement_inlining_renames_locals() {
+        // int clamp(v) { int lo = 0; if (v < lo) { v = lo; } return v; }
+        // main(v) { int lo = 7; y = clamp(v); print(lo); print(y); }
+        let clamp = func(
+            "clamp",
+            &["v"],
+            vec![
+                Stmt::VarDecl { name: "lo".into(), var_type: None, value: Some(Expr::Number(0)) },
+                Stmt::If {
+                    condition: Expr::Comparison { op: CmpOp::Lt, left: Box::new(var("v")), right: Box::new(var("lo")) },
+                    then_body: vec![Stmt::Assign { name: "v".into(), value: var("lo") }],
+                    else_body: None,
+                },
+                Stmt::Return(Some(var("v"))),
+            ],
+        );
+        let main = func(
+            "main",
+            &["v"],
+            vec![
+                Stmt::VarDecl { name: "lo".into(), var_type: None, value: Some(Expr::Number(7)) },
+                Stmt::Assign { name: "y".into(), value: call("clamp", vec![var("v")]) },
+                Stmt::PrintNum(var("lo")),
+                Stmt::PrintNum(var("y")),
+            ],
+        );
+        let mut program = Program { functions: vec![clamp, main], statements: Vec::new() };
+        let stats = InlineExpander::new().run(&mut program);
+        assert_eq!(stats.inlined_calls, 1);
+        assert_eq!(program.functions.len(), 1);
+
+        let body = &program.functions[0].body;
+        let mut calls = Vec::new();
+        collect_calls(body, &mut calls);
+        assert!(calls.is_empty());
+        // El `lo` del callee no pisa el del caller
+        assert!(matches!(&body[1], Stmt::VarDecl { name, value: Some(Expr::Variable(v)), .. } if name == "__inl0_v" && v == "v"));
+        assert!(body.iter().any(|s| matches!(s, Stmt::Assign { name, value: Expr::Variable(v) } if name == "y" && v == "__inl0_v")));
+        assert!(matches!(&body[body.len() - 2], Stmt::PrintNum(Expr::Number(7))));
+    }
+
+    #[test]
+    fn test_recursive_and_costly_calls_stay() {
+        let big_body: Vec<Stmt> = (0..4)
+            .map(|k| Stmt::PrintNum(bin(BinaryOp::Mul, bin(BinaryOp::Add, var("x"), Expr::Number(k)), var("x"))))
+            .collect();
+        let mut program = Program {
+            functions: vec![
+                func("fact", &["n"], vec![Stmt::Return(Some(call("fact", vec![var("n")])))]),
+                func("big", &["x"], big_body),
+                func(
+                    "main",
+                    &["y"],
+                    vec![
+                        Stmt::Expr(call("fact", vec![Expr::Number(5)])),
+                        Stmt::Expr(call("big", vec![var("y")])),
+                        Stmt::Expr(call("big", vec![var("y")])),
+                    ],
+                ),
+            ],
+            statements: Vec::new(),
+        };
+        let stats = InlineExpander::new().run(&mut program);
+        assert_eq!(stats.inlined_calls, 0);
+        assert_eq!(program.functions.len(), 3);
+    }
+
+    #[test]
+    fn test_profile_gates_cold_and_hot_callees() {
+        // mid(x) pasa el presupuesto por 2 nodos; sq nunca se ejecutó
+        let mid = func(
+            "mid",
+            &["x"],
+            vec![Stmt::Return(Some(bin(
+                BinaryOp::Mul,
+                bin(BinaryOp::Mul, bin(BinaryOp::Add, var("x"), Expr::Number(1)), bin(BinaryOp::Add, var("x"), Expr::Number(2))),
+                bin(BinaryOp::Mul, bin(BinaryOp::Sub, var("x"), Expr::Number(3)), var("x")),
+            )))],
+        );
+        let sq = func("sq", &["x"], vec![Stmt::Return(Some(bin(BinaryOp::Mul, var("x"), var("x"))))]);
+        let main = func(
+            "main",
+            &["y"],
+            vec![
+                Stmt::PrintNum(call("mid", vec![var("y")])),
+                Stmt::PrintNum(call("mid", vec![var("y")])),
+                Stmt::PrintNum(call("sq", vec![var("y")])),
+            ],
+        );
+        let program = Program { functions: vec![mid, sq, main], statements: Vec::new() };
+
+        let mut plain = program.clone();
+        assert_eq!(InlineExpander::new().run(&mut plain).inlined_calls, 1);
+
+        let profile = Profile::parse("# adeb-profile 1\nfn main 1\nfn mid 1000\nfn sq 0\n").unwrap();
+        let mut guided = program;
+        let stats = InlineExpander::new().with_profile(profile).run(&mut guided);
+        assert_eq!(stats.inlined_calls, 2);
+        let mut calls = Vec::new();
+        collect_calls(&guided.functions.last().unwrap().body, &mut calls);
+        assert_eq!(calls, vec!["sq".to_string()]);
+    }
+
+    fn typed_func(name: &str, params: &[&str], body: Vec<typed::Stmt>) -> typed::Function {
+        typed::Function {
+            name: name.to_string(),
+            params: params
+                .iter()
+                .map(|p| typed::Param { name: p.to_string(), param_type: Type::I32, default_value: None })
+                .collect(),
+            return_type: None,
+            resolved_return_type: Type::I32,
+            body,
+            attributes: Default::default(),
+        }
+    }
+
+    #[test]
+    fn test_run_typed_inlines_bottom_up() {
+        use typed::{BinOp, Expr as E, Stmt as S};
+        let v = |n: &str| E::Variable(n.to_string());
+        let c = |n: &str, args| E::Call { name: n.to_string(), args };
+        let add = |l, r| E::BinaryOp { op: BinOp::Add, left: Box::new(l), right: Box::new(r) };
+        // twice(x) = inc(inc(x)) solo es hoja cuando inc ya se expandio;
+        // fact es recursiva y se queda como call
+        let mut program = typed::Program::new();
+        program.functions = vec![
+            typed_func("twice", &["x"], vec![S::Return(Some(c("inc", vec![c("inc", vec![v("x")])])))]),
+            typed_func("inc", &["x"], vec![S::Return(Some(add(v("x"), E::Number(1))))]),
+            typed_func("fact", &["n"], vec![S::Return(Some(c("fact", vec![v("n")])))]),
+            typed_func(
+                "main",
+                &["n"],
+                vec![S::Return(Some(add(c("twice", vec![v("n")]), c("fact", vec![v("n")]))))],
+            ),
+        ];
+
+        let stats = InlineExpander::new().run_typed(&mut program, &HashSet::new());
+        assert_eq!(stats.inlined_calls, 3, "inc x2 en twice y twice en main");
+        assert_eq!(stats.removed_functions, vec!["twice".to_string(), "inc".to_string()]);
+        let main = program.functions.last().unwrap();
+        assert_eq!(typed_calls(&mut main.body.clone()), vec!["fact".to_string()]);
+        assert!(program.functions.iter().any(|f| f.name == "fact"));
+    }
 }
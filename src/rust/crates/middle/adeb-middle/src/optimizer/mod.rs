@@ -14,5 +14,5 @@ pub use binary_optimizer::{BinaryOptimizer, OptLevel, OptimizationStats, PESizeO
 pub use const_fold::ConstFolder;
 pub use const_prop::ConstPropagator;
 pub use dead_code::DeadCodeEliminator;
-pub use inline_exp::InlineExpander;
+pub use inline_exp::{CallGraph, InlineExpander, InlineStats};
 pub use redundant::RedundantEliminator;
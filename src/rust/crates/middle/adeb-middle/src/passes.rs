@@ -1,6 +0,0 @@
-//! ADead-BIB Transform Passes
-//! DCE, GVN, LICM, inline, constant propagation
-
-pub fn transform(_module: &mut crate::ir::Module) {
-    // Transform passes - placeholder
-}
@@ -0,0 +1,333 @@
+// ============================================================
+// CFG Utilities — edges, RPO, dominators
+// ============================================================
+// Blocks are addressed by their index in `Function::blocks`.
+// Edges are read from the terminators (BasicBlock operands), not
+// from BasicBlock::predecessors/successors: the builder does not
+// keep those up to date. `refresh_edges` rewrites them after the
+// pipeline so printers and later consumers see the final CFG.
+//
+// Dominators: Cooper, Harvey, Kennedy — "A Simple, Fast Dominance
+// Algorithm" (iterative over reverse post-order).
+// ============================================================
+
+use crate::ir::{Function, Instruction, Opcode, Value, ValueId};
+use std::collections::HashMap;
+
+/// Block ids a terminator can jump to (deduplicated, in operand order)
+pub fn terminator_targets(inst: &Instruction) -> Vec<u32> {
+    let mut targets = Vec::new();
+    if inst.is_terminator() {
+        for op in &inst.operands {
+            if let Value::BasicBlock(id) = op {
+                if !targets.contains(id) {
+                    targets.push(*id);
+                }
+            }
+        }
+    }
+    targets
+}
+
+/// Control-flow graph snapshot of a function
+pub struct Cfg {
+    pub succs: Vec<Vec<usize>>,
+    pub preds: Vec<Vec<usize>>,
+    /// Reachable blocks in reverse post-order (entry first)
+    pub rpo: Vec<usize>,
+    rpo_pos: Vec<Option<usize>>,
+}
+
+impl Cfg {
+    pub fn build(func: &Function) -> Self {
+        let n = func.blocks.len();
+        let index: HashMap<u32, usize> = func
+            .blocks
+            .iter()
+            .enumerate()
+            .map(|(i, b)| (b.id.0, i))
+            .collect();
+
+        let mut succs = vec![Vec::new(); n];
+        let mut preds = vec![Vec::new(); n];
+        for (i, block) in func.blocks.iter().enumerate() {
+            if let Some(term) = block.terminator() {
+                for target in terminator_targets(term) {
+                    if let Some(&t) = index.get(&target) {
+                        succs[i].push(t);
+                        preds[t].push(i);
+                    }
+                }
+            }
+        }
+
+        // Iterative DFS post-order from the entry block
+        let mut post = Vec::with_capacity(n);
+        if n > 0 {
+            let mut visited = vec![false; n];
+            let mut stack = vec![(0usize, 0usize)];
+            visited[0] = true;
+            while let Some((b, next)) = stack.pop() {
+                if next < succs[b].len() {
+                    stack.push((b, next + 1));
+                    let s = succs[b][next];
+                    if !visited[s] {
+                        visited[s] = true;
+                        stack.push((s, 0));
+                    }
+                } else {
+                    post.push(b);
+                }
+            }
+        }
+        post.reverse();
+
+        let mut rpo_pos = vec![None; n];
+        for (pos, &b) in post.iter().enumerate() {
+            rpo_pos[b] = Some(pos);
+        }
+        Cfg {
+            succs,
+            preds,
+            rpo: post,
+            rpo_pos,
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        self.succs.len()
+    }
+
+    pub fn is_reachable(&self, block: usize) -> bool {
+        self.rpo_pos[block].is_some()
+    }
+}
+
+/// Dominator tree over the reachable blocks of a `Cfg`
+pub struct DomTree {
+    idom: Vec<Option<usize>>,
+    children: Vec<Vec<usize>>,
+}
+
+impl DomTree {
+    pub fn build(cfg: &Cfg) -> Self {
+        let n = cfg.len();
+        let mut idom: Vec<Option<usize>> = vec![None; n];
+        if let Some(&entry) = cfg.rpo.first() {
+            idom[entry] = Some(entry);
+            let pos = |b: usize| cfg.rpo_pos[b].unwrap_or(usize::MAX);
+            let mut changed = true;
+            while changed {
+                changed = false;
+                for &b in cfg.rpo.iter().skip(1) {
+                    let mut new_idom: Option<usize> = None;
+                    for &p in &cfg.preds[b] {
+                        if idom[p].is_none() {
+                            continue;
+                        }
+                        new_idom = Some(match new_idom {
+                            None => p,
+                            Some(mut a) => {
+                                // intersect(a, p)
+                                let mut c = p;
+                                while a != c {
+                                    while pos(a) > pos(c) {
+                                        a = idom[a].unwrap();
+                                    }
+                                    while pos(c) > pos(a) {
+                                        c = idom[c].unwrap();
+                                    }
+                                }
+                                a
+                            }
+                        });
+                    }
+                    if new_idom.is_some() && idom[b] != new_idom {
+                        idom[b] = new_idom;
+                        changed = true;
+                    }
+                }
+            }
+            idom[entry] = None;
+        }
+
+        let mut children = vec![Vec::new(); n];
+        for &b in &cfg.rpo {
+            if let Some(parent) = idom[b] {
+                children[parent].push(b);
+            }
+        }
+        DomTree { idom, children }
+    }
+
+    /// Immediate dominator (None for the entry and unreachable blocks)
+    pub fn idom(&self, block: usize) -> Option<usize> {
+        self.idom[block]
+    }
+
+    pub fn children(&self, block: usize) -> &[usize] {
+        &self.children[block]
+    }
+
+    /// Does `a` dominate `b`? (reflexive)
+    pub fn dominates(&self, a: usize, b: usize) -> bool {
+        let mut cur = Some(b);
+        while let Some(c) = cur {
+            if c == a {
+                return true;
+            }
+            cur = self.idom[c];
+        }
+        false
+    }
+
+    /// Dominance frontier of every block
+    pub fn frontiers(&self, cfg: &Cfg) -> Vec<Vec<usize>> {
+        let mut df = vec![Vec::new(); cfg.len()];
+        for &b in &cfg.rpo {
+            let preds: Vec<usize> = cfg.preds[b]
+                .iter()
+                .copied()
+                .filter(|&p| cfg.is_reachable(p))
+                .collect();
+            if preds.len() < 2 {
+                continue;
+            }
+            for p in preds {
+                let mut runner = p;
+                while Some(runner) != self.idom[b] {
+                    if !df[runner].contains(&b) {
+                        df[runner].push(b);
+                    }
+                    match self.idom[runner] {
+                        Some(up) => runner = up,
+                        None => break,
+                    }
+                }
+            }
+        }
+        df
+    }
+
+}
+
+/// Rewrite BasicBlock::predecessors/successors from the terminators
+pub fn refresh_edges(func: &mut Function) {
+    let cfg = Cfg::build(func);
+    let ids: Vec<_> = func.blocks.iter().map(|b| b.id).collect();
+    for (i, block) in func.blocks.iter_mut().enumerate() {
+        block.successors = cfg.succs[i].iter().map(|&s| ids[s]).collect();
+        block.predecessors = cfg.preds[i].iter().map(|&p| ids[p]).collect();
+        block.predecessors.dedup();
+    }
+}
+
+/// Follow a replacement chain (`%a → %b → const`) to its end
+pub fn resolve(map: &HashMap<ValueId, Value>, value: &Value) -> Value {
+    let mut cur = value.clone();
+    let mut steps = 0;
+    while let Value::Instruction(id) = &cur {
+        match map.get(id) {
+            Some(next) if steps < map.len() => {
+                cur = next.clone();
+                steps += 1;
+            }
+            _ => break,
+        }
+    }
+    cur
+}
+
+/// Replace every use of the mapped values (operands and GEP indices)
+pub fn replace_uses(func: &mut Function, map: &HashMap<ValueId, Value>) {
+    if map.is_empty() {
+        return;
+    }
+    for block in &mut func.blocks {
+        for inst in &mut block.instructions {
+            for op in inst.operands.iter_mut().chain(inst.indices.iter_mut()) {
+                if let Value::Instruction(id) = op {
+                    if map.contains_key(id) {
+                        *op = resolve(map, op);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// Drop phi incomings from blocks that are no longer predecessors
+pub fn prune_phis(func: &mut Function) {
+    let cfg = Cfg::build(func);
+    let ids: Vec<u32> = func.blocks.iter().map(|b| b.id.0).collect();
+    for (i, block) in func.blocks.iter_mut().enumerate() {
+        let preds: Vec<u32> = cfg.preds[i].iter().map(|&p| ids[p]).collect();
+        for inst in &mut block.instructions {
+            if inst.opcode != Opcode::Phi {
+                continue;
+            }
+            let mut k = 0;
+            while k < inst.phi_blocks.len() {
+                if preds.contains(&inst.phi_blocks[k]) {
+                    k += 1;
+                } else {
+                    inst.phi_blocks.remove(k);
+                    inst.operands.remove(k);
+                }
+            }
+        }
+    }
+}
+
+/// Remove blocks not reachable from the entry. Returns true if any
+pub fn remove_unreachable(func: &mut Function) -> bool {
+    let cfg = Cfg::build(func);
+    if cfg.rpo.len() == func.blocks.len() {
+        return false;
+    }
+    let mut i = 0;
+    func.blocks.retain(|_| {
+        let keep = cfg.is_reachable(i);
+        i += 1;
+        keep
+    });
+    prune_phis(func);
+    true
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::ir::{Constant, Type};
+
+    /// entry → {a, b} → merge → (loop back to entry's successor a)
+    fn diamond() -> Function {
+        let mut func = Function::new("f", Type::Void);
+        let entry = func.create_block(Some("entry"));
+        let a = func.create_block(Some("a"));
+        let b = func.create_block(Some("b"));
+        let merge = func.create_block(Some("merge"));
+        let cond = Value::Constant(Constant::bool(true));
+        func.get_block_mut(entry).unwrap().push(Instruction::cond_br(cond.clone(), a.0, b.0));
+        func.get_block_mut(a).unwrap().push(Instruction::br(merge.0));
+        func.get_block_mut(b).unwrap().push(Instruction::br(merge.0));
+        func.get_block_mut(merge).unwrap().push(Instruction::cond_br(cond, a.0, merge.0));
+        func
+    }
+
+    #[test]
+    fn test_dominators_and_frontiers() {
+        let func = diamond();
+        let cfg = Cfg::build(&func);
+        let dom = DomTree::build(&cfg);
+        assert_eq!(cfg.rpo[0], 0);
+        assert_eq!(dom.idom(1), Some(0));
+        assert_eq!(dom.idom(3), Some(0));
+        assert!(dom.dominates(0, 3));
+        assert!(!dom.dominates(1, 3));
+        let df = dom.frontiers(&cfg);
+        assert_eq!(df[2], vec![3]);
+        assert!(df[1].contains(&3));
+        assert!(df[3].contains(&1) && df[3].contains(&3));
+    }
+}
@@ -0,0 +1,88 @@
+// ============================================================
+// DCE — mark & sweep dead instruction elimination
+// ============================================================
+// Roots are instructions with side effects (stores, calls,
+// terminators, intrinsics). Everything reachable from a root
+// through operands is live; the rest is deleted, including
+// phi cycles that only feed each other.
+// ============================================================
+
+use super::Pass;
+use crate::ir::{Function, Opcode, Value, ValueId};
+use std::collections::{HashMap, HashSet};
+
+pub struct Dce;
+
+impl Pass for Dce {
+    fn name(&self) -> &'static str {
+        "dce"
+    }
+
+    fn run_on_function(&mut self, func: &mut Function) -> bool {
+        let mut defs: HashMap<ValueId, (usize, usize)> = HashMap::new();
+        let mut work: Vec<(usize, usize)> = Vec::new();
+        for (b, block) in func.blocks.iter().enumerate() {
+            for (i, inst) in block.instructions.iter().enumerate() {
+                if let Some(id) = inst.result {
+                    defs.insert(id, (b, i));
+                }
+                if inst.has_side_effects() || inst.opcode == Opcode::Intrinsic || inst.result.is_none() {
+                    work.push((b, i));
+                }
+            }
+        }
+
+        let mut live: HashSet<(usize, usize)> = work.iter().copied().collect();
+        while let Some((b, i)) = work.pop() {
+            let inst = &func.blocks[b].instructions[i];
+            for op in inst.operands.iter().chain(inst.indices.iter()) {
+                if let Value::Instruction(id) = op {
+                    if let Some(&def) = defs.get(id) {
+                        if live.insert(def) {
+                            work.push(def);
+                        }
+                    }
+                }
+            }
+        }
+
+        let total: usize = func.blocks.iter().map(|b| b.instructions.len()).sum();
+        if live.len() == total {
+            return false;
+        }
+        for (b, block) in func.blocks.iter_mut().enumerate() {
+            let mut i = 0;
+            block.instructions.retain(|_| {
+                let keep = live.contains(&(b, i));
+                i += 1;
+                keep
+            });
+        }
+        true
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::ir::{IRBuilder, Module, Type};
+
+    #[test]
+    fn test_unused_chain_is_removed() {
+        let mut module = Module::new("m");
+        let mut bld = IRBuilder::new(&mut module);
+        bld.create_function("f", Type::I32);
+        let entry = bld.create_block(Some("entry"));
+        bld.set_block(entry);
+        let x = Value::Argument { index: 0, ty: Type::I32 };
+        let dead = bld.build_mul(x.clone(), x.clone(), Type::I32);
+        bld.build_add(dead, bld.const_i32(1), Type::I32);
+        bld.build_call(Type::Void, "keep", vec![]);
+        bld.build_ret(Some(x));
+
+        let func = module.get_function_mut("f").unwrap();
+        assert!(Dce.run_on_function(func));
+        assert_eq!(func.blocks[0].instructions.len(), 2);
+        assert!(!Dce.run_on_function(func));
+    }
+}
@@ -0,0 +1,240 @@
+// ============================================================
+// mem2reg — promote scalar allocas to SSA values
+// ============================================================
+// Classic Cytron et al. construction:
+//   1. An entry-block alloca of a scalar type whose address is only
+//      used as the pointer of loads/stores is promotable.
+//   2. Phis go on the iterated dominance frontier of its stores.
+//   3. A dominator-tree walk renames loads to the reaching value
+//      (Undef when no store reaches) and fills phi incomings.
+// ============================================================
+
+use super::cfg::{self, Cfg, DomTree};
+use super::Pass;
+use crate::ir::{Constant, Function, Instruction, Opcode, Type, Value, ValueId};
+use std::collections::{HashMap, HashSet};
+
+pub struct Mem2Reg;
+
+/// Allocas of scalar type whose address never escapes
+fn promotable_allocas(func: &Function) -> HashMap<ValueId, Type> {
+    let mut candidates: HashMap<ValueId, Type> = HashMap::new();
+    if let Some(entry) = func.blocks.first() {
+        for inst in &entry.instructions {
+            if inst.opcode != Opcode::Alloca {
+                continue;
+            }
+            if let (Some(id), Some(ty)) = (inst.result, inst.ty.pointee()) {
+                if ty.is_integer() || ty.is_float() || ty.is_pointer() {
+                    candidates.insert(id, ty.clone());
+                }
+            }
+        }
+    }
+
+    for block in &func.blocks {
+        for inst in &block.instructions {
+            for (pos, op) in inst.operands.iter().chain(inst.indices.iter()).enumerate() {
+                let id = match op {
+                    Value::Instruction(id) if candidates.contains_key(id) => *id,
+                    _ => continue,
+                };
+                let ok = match inst.opcode {
+                    Opcode::Load => pos == 0 && Some(&inst.ty) == candidates.get(&id),
+                    Opcode::Store => pos == 1 && inst.operands.len() == 2,
+                    _ => false,
+                };
+                if !ok {
+                    candidates.remove(&id);
+                }
+            }
+        }
+    }
+    candidates
+}
+
+impl Pass for Mem2Reg {
+    fn name(&self) -> &'static str {
+        "mem2reg"
+    }
+
+    fn run_on_function(&mut self, func: &mut Function) -> bool {
+        // Loads in unreachable blocks would have no reaching definition
+        let pruned = cfg::remove_unreachable(func);
+
+        let allocas = promotable_allocas(func);
+        if allocas.is_empty() {
+            return pruned;
+        }
+        let mut order: Vec<ValueId> = allocas.keys().copied().collect();
+        order.sort_by_key(|id| id.0);
+
+        let cfg = Cfg::build(func);
+        let dom = DomTree::build(&cfg);
+        let frontiers = dom.frontiers(&cfg);
+
+        // 2. Phi placement: placed[block] = [(alloca, phi id, incomings)]
+        let mut placed: Vec<Vec<(ValueId, ValueId, Vec<(Value, u32)>)>> =
+            vec![Vec::new(); func.blocks.len()];
+        for &alloca in &order {
+            let mut work: Vec<usize> = Vec::new();
+            for (b, block) in func.blocks.iter().enumerate() {
+                let stores = block.instructions.iter().any(|i| {
+                    i.opcode == Opcode::Store && i.operands.get(1) == Some(&Value::Instruction(alloca))
+                });
+                if stores {
+                    work.push(b);
+                }
+            }
+            let mut has_phi: HashSet<usize> = HashSet::new();
+            let mut queued: HashSet<usize> = work.iter().copied().collect();
+            while let Some(b) = work.pop() {
+                for &f in &frontiers[b] {
+                    if has_phi.insert(f) {
+                        let phi_id = func.new_value_id();
+                        placed[f].push((alloca, phi_id, Vec::new()));
+                        if queued.insert(f) {
+                            work.push(f);
+                        }
+                    }
+                }
+            }
+        }
+
+        // 3. Renaming over the dominator tree
+        enum Step {
+            Enter(usize),
+            Exit(Vec<ValueId>),
+        }
+        let ids: Vec<u32> = func.blocks.iter().map(|b| b.id.0).collect();
+        let mut stacks: HashMap<ValueId, Vec<Value>> = HashMap::new();
+        let mut replace: HashMap<ValueId, Value> = HashMap::new();
+        let current = |stacks: &HashMap<ValueId, Vec<Value>>, a: &ValueId| -> Value {
+            stacks
+                .get(a)
+                .and_then(|s| s.last().cloned())
+                .unwrap_or_else(|| Value::Constant(Constant::Undef(allocas[a].clone())))
+        };
+
+        let mut steps = vec![Step::Enter(0)];
+        while let Some(step) = steps.pop() {
+            let b = match step {
+                Step::Enter(b) => b,
+                Step::Exit(pushed) => {
+                    for a in pushed {
+                        stacks.get_mut(&a).unwrap().pop();
+                    }
+                    continue;
+                }
+            };
+            let mut pushed = Vec::new();
+            for (a, phi_id, _) in &placed[b] {
+                stacks.entry(*a).or_default().push(Value::Instruction(*phi_id));
+                pushed.push(*a);
+            }
+            for inst in &func.blocks[b].instructions {
+                match inst.opcode {
+                    Opcode::Load => {
+                        if let Some(Value::Instruction(a)) = inst.operands.first() {
+                            if allocas.contains_key(a) {
+                                replace.insert(inst.result.unwrap(), current(&stacks, a));
+                            }
+                        }
+                    }
+                    Opcode::Store => {
+                        if let Some(Value::Instruction(a)) = inst.operands.get(1) {
+                            if allocas.contains_key(a) {
+                                stacks.entry(*a).or_default().push(inst.operands[0].clone());
+                                pushed.push(*a);
+                            }
+                        }
+                    }
+                    _ => {}
+                }
+            }
+            for &s in &cfg.succs[b] {
+                for k in 0..placed[s].len() {
+                    let value = current(&stacks, &placed[s][k].0);
+                    placed[s][k].2.push((value, ids[b]));
+                }
+            }
+            steps.push(Step::Exit(pushed));
+            for &child in dom.children(b).iter().rev() {
+                steps.push(Step::Enter(child));
+            }
+        }
+
+        // 4. Rewrite: drop allocas/loads/stores, insert the phis
+        for (b, block) in func.blocks.iter_mut().enumerate() {
+            block.instructions.retain(|inst| match inst.opcode {
+                Opcode::Alloca => !inst.result.map_or(false, |id| allocas.contains_key(&id)),
+                Opcode::Load => !inst.result.map_or(false, |id| replace.contains_key(&id)),
+                Opcode::Store => !matches!(
+                    inst.operands.get(1),
+                    Some(Value::Instruction(a)) if allocas.contains_key(a)
+                ),
+                _ => true,
+            });
+            let phis: Vec<Instruction> = placed[b]
+                .drain(..)
+                .map(|(a, id, incoming)| Instruction::phi(allocas[&a].clone(), incoming, id))
+                .collect();
+            block.instructions.splice(0..0, phis);
+        }
+        cfg::replace_uses(func, &replace);
+        true
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::ir::{CompareOp, IRBuilder, Module};
+
+    #[test]
+    fn test_diamond_gets_phi() {
+        // x = 1; if (a < 0) x = 2; return x;
+        let mut module = Module::new("m");
+        let mut b = IRBuilder::new(&mut module);
+        b.create_function("f", Type::I32);
+        b.add_param("a", Type::I32);
+        let entry = b.create_block(Some("entry"));
+        let then = b.create_block(Some("then"));
+        let exit = b.create_block(Some("exit"));
+        b.set_block(entry);
+        let x = b.build_alloca(Type::I32, Some("x"));
+        b.build_store(b.const_i32(1), x.clone());
+        let arg = Value::Argument { index: 0, ty: Type::I32 };
+        let c = b.build_icmp(CompareOp::Slt, arg, b.const_i32(0));
+        b.build_cond_br(c, then, exit);
+        b.set_block(then);
+        b.build_store(b.const_i32(2), x.clone());
+        b.build_br(exit);
+        b.set_block(exit);
+        let v = b.build_load(Type::I32, x);
+        b.build_ret(Some(v));
+
+        let func = module.get_function_mut("f").unwrap();
+        assert!(Mem2Reg.run_on_function(func));
+        assert!(func.blocks.iter().flat_map(|b| &b.instructions).all(|i| !i.is_memory_op()));
+        let phi = &func.blocks[2].instructions[0];
+        assert_eq!(phi.opcode, Opcode::Phi);
+        assert_eq!(phi.operands.len(), 2);
+        let ret = func.blocks[2].terminator().unwrap();
+        assert_eq!(ret.operands[0], Value::Instruction(phi.result.unwrap()));
+    }
+
+    #[test]
+    fn test_escaping_alloca_is_kept() {
+        let mut module = Module::new("m");
+        let mut b = IRBuilder::new(&mut module);
+        b.create_function("f", Type::Void);
+        let entry = b.create_block(Some("entry"));
+        b.set_block(entry);
+        let x = b.build_alloca(Type::I32, Some("x"));
+        b.build_call(Type::Void, "consume", vec![x]);
+        b.build_ret_void();
+        let func = module.get_function_mut("f").unwrap();
+        assert!(!Mem2Reg.run_on_function(func));
+    }
+}
@@ -0,0 +1,296 @@
+//! ADead-BIB Transform Passes
+//! SSA construction over the middle IR: mem2reg and DCE, driven by a
+//! pass manager that iterates the whole sequence until no pass reports
+//! a change. Nothing lowers the AST into this IR yet; SCCP, GVN, LICM
+//! and CFG simplification come once something does.
+
+pub mod cfg;
+pub mod dce;
+pub mod mem2reg;
+
+use crate::ir::{Function, Module};
+
+pub use dce::Dce;
+pub use mem2reg::Mem2Reg;
+
+/// A function-level transform. Returns true if the function changed
+pub trait Pass {
+    fn name(&self) -> &'static str;
+    fn run_on_function(&mut self, func: &mut Function) -> bool;
+}
+
+/// Per-run statistics of the pass manager
+#[derive(Debug, Clone, Default)]
+pub struct PassStats {
+    /// Pipeline iterations (summed over functions)
+    pub iterations: usize,
+    /// (pass, number of runs that changed something)
+    pub changes: Vec<(&'static str, usize)>,
+}
+
+impl PassStats {
+    pub fn changes_for(&self, pass: &str) -> usize {
+        self.changes
+            .iter()
+            .find(|(name, _)| *name == pass)
+            .map_or(0, |(_, n)| *n)
+    }
+}
+
+/// Runs its passes in order, repeating until a fixed point
+pub struct PassManager {
+    passes: Vec<Box<dyn Pass>>,
+    max_iterations: usize,
+}
+
+impl PassManager {
+    pub fn new() -> Self {
+        PassManager {
+            passes: Vec::new(),
+            max_iterations: 16,
+        }
+    }
+
+    /// mem2reg → dce
+    pub fn default_pipeline() -> Self {
+        let mut pm = Self::new();
+        pm.add(Mem2Reg);
+        pm.add(Dce);
+        pm
+    }
+
+    pub fn add<P: Pass + 'static>(&mut self, pass: P) -> &mut Self {
+        self.passes.push(Box::new(pass));
+        self
+    }
+
+    /// Upper bound on pipeline repetitions per function
+    pub fn with_max_iterations(mut self, n: usize) -> Self {
+        self.max_iterations = n.max(1);
+        self
+    }
+
+    pub fn run_on_function(&mut self, func: &mut Function, stats: &mut PassStats) {
+        if func.is_declaration || func.blocks.is_empty() {
+            return;
+        }
+        for _ in 0..self.max_iterations {
+            stats.iterations += 1;
+            let mut changed = false;
+            for (k, pass) in self.passes.iter_mut().enumerate() {
+                if pass.run_on_function(func) {
+                    changed = true;
+                    stats.changes[k].1 += 1;
+                }
+            }
+            if !changed {
+                break;
+            }
+        }
+        cfg::refresh_edges(func);
+    }
+
+    pub fn run(&mut self, module: &mut Module) -> PassStats {
+        let mut stats = PassStats {
+            iterations: 0,
+            changes: self.passes.iter().map(|p| (p.name(), 0)).collect(),
+        };
+        for func in &mut module.functions {
+            self.run_on_function(func, &mut stats);
+        }
+        stats
+    }
+}
+
+impl Default for PassManager {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Run the default SSA pipeline over every function of the module
+pub fn transform(module: &mut Module) -> PassStats {
+    PassManager::default_pipeline().run(module)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::ir::{BasicBlock, BinaryOp, CompareOp, Constant, IRBuilder, Instruction, Opcode, Type, Value, ValueId};
+    use std::collections::HashMap;
+
+    /// Tiny reference interpreter (scalars, allocas, phis, branches)
+    fn interpret(func: &Function, args: &[i64]) -> i64 {
+        let block_of = |id: u32| -> &BasicBlock { func.blocks.iter().find(|b| b.id.0 == id).unwrap() };
+        let mut values: HashMap<ValueId, Value> = HashMap::new();
+        let mut memory: HashMap<ValueId, Value> = HashMap::new();
+        let eval = |v: &Value, values: &HashMap<ValueId, Value>| -> Value {
+            match v {
+                Value::Instruction(id) => values[id].clone(),
+                Value::Argument { index, .. } => Value::Constant(Constant::i32(args[*index] as i32)),
+                other => other.clone(),
+            }
+        };
+        let as_int = |v: &Value| -> i64 {
+            match v {
+                Value::Constant(Constant::Int { value, .. }) => *value,
+                Value::Constant(Constant::Bool(b)) => *b as i64,
+                other => panic!("not an int: {:?}", other),
+            }
+        };
+
+        let (mut prev, mut cur) = (u32::MAX, func.blocks[0].id.0);
+        for _ in 0..100_000 {
+            let block = block_of(cur);
+            // Los phis se evalúan juntos con los valores del bloque anterior
+            let phis: Vec<(ValueId, Value)> = block
+                .instructions
+                .iter()
+                .filter(|i| i.opcode == Opcode::Phi)
+                .map(|i| {
+                    let k = i.phi_blocks.iter().position(|&p| p == prev).unwrap();
+                    (i.result.unwrap(), eval(&i.operands[k], &values))
+                })
+                .collect();
+            values.extend(phis);
+            for inst in block.instructions.iter().filter(|i| i.opcode != Opcode::Phi) {
+                let ops: Vec<Value> = inst.operands.iter().map(|v| eval(v, &values)).collect();
+                match inst.opcode {
+                    Opcode::Alloca => {
+                        values.insert(inst.result.unwrap(), Value::Instruction(inst.result.unwrap()));
+                    }
+                    Opcode::Store => {
+                        memory.insert(ops[1].as_instruction().unwrap(), ops[0].clone());
+                    }
+                    Opcode::Load => {
+                        let v = memory[&ops[0].as_instruction().unwrap()].clone();
+                        values.insert(inst.result.unwrap(), v);
+                    }
+                    Opcode::Br => {
+                        prev = cur;
+                        cur = match ops[0] {
+                            Value::BasicBlock(t) => t,
+                            _ => unreachable!(),
+                        };
+                    }
+                    Opcode::CondBr => {
+                        prev = cur;
+                        let taken = if as_int(&ops[0]) != 0 { 1 } else { 2 };
+                        cur = match ops[taken] {
+                            Value::BasicBlock(t) => t,
+                            _ => unreachable!(),
+                        };
+                    }
+                    Opcode::Ret => return as_int(&ops[0]),
+                    _ => {
+                        let (a, b) = (as_int(&ops[0]), as_int(&ops[1]));
+                        let c = match inst.opcode {
+                            Opcode::Binary(BinaryOp::Add) => Constant::i32(a.wrapping_add(b) as i32),
+                            Opcode::Binary(BinaryOp::Mul) => Constant::i32(a.wrapping_mul(b) as i32),
+                            Opcode::ICmp(CompareOp::Slt) => Constant::bool(a < b),
+                            Opcode::ICmp(CompareOp::Sgt) => Constant::bool(a > b),
+                            other => panic!("not interpreted: {:?}", other),
+                        };
+                        values.insert(inst.result.unwrap(), Value::Constant(c));
+                    }
+                }
+            }
+        }
+        panic!("interpreter step limit");
+    }
+
+    /// int f(int n) {
+    ///     int s = 0, i = 0, k = 3 * 4;
+    ///     while (i < n) { s = s + i * k + (n + 7); i = i + 1; }
+    ///     if (k > 100) s = 0;
+    ///     return s;
+    /// }
+    fn build_sum(module: &mut Module) {
+        let mut b = IRBuilder::new(module);
+        b.create_function("sum", Type::I32);
+        b.add_param("n", Type::I32);
+        let entry = b.create_block(Some("entry"));
+        let header = b.create_block(Some("while.cond"));
+        let body = b.create_block(Some("while.body"));
+        let exit = b.create_block(Some("while.end"));
+        let zero = b.create_block(Some("if.then"));
+        let done = b.create_block(Some("if.end"));
+        let n = Value::Argument { index: 0, ty: Type::I32 };
+
+        b.set_block(entry);
+        let s = b.build_alloca(Type::I32, Some("s"));
+        let i = b.build_alloca(Type::I32, Some("i"));
+        let k = b.build_alloca(Type::I32, Some("k"));
+        b.build_store(b.const_i32(0), s.clone());
+        b.build_store(b.const_i32(0), i.clone());
+        let twelve = b.build_mul(b.const_i32(3), b.const_i32(4), Type::I32);
+        b.build_store(twelve, k.clone());
+        b.build_br(header);
+
+        b.set_block(header);
+        let iv = b.build_load(Type::I32, i.clone());
+        let c = b.build_icmp(CompareOp::Slt, iv, n.clone());
+        b.build_cond_br(c, body, exit);
+
+        b.set_block(body);
+        let sv = b.build_load(Type::I32, s.clone());
+        let iv = b.build_load(Type::I32, i.clone());
+        let kv = b.build_load(Type::I32, k.clone());
+        let m = b.build_mul(iv, kv, Type::I32);
+        let t = b.build_add(sv, m, Type::I32);
+        let inv = b.build_add(n.clone(), b.const_i32(7), Type::I32);
+        let t = b.build_add(t, inv, Type::I32);
+        b.build_store(t, s.clone());
+        let iv = b.build_load(Type::I32, i.clone());
+        let next = b.build_add(iv, b.const_i32(1), Type::I32);
+        b.build_store(next, i);
+        b.build_br(header);
+
+        b.set_block(exit);
+        let kv = b.build_load(Type::I32, k);
+        let big = b.build_icmp(CompareOp::Sgt, kv, b.const_i32(100));
+        b.build_cond_br(big, zero, done);
+
+        b.set_block(zero);
+        b.build_store(b.const_i32(0), s.clone());
+        b.build_br(done);
+
+        b.set_block(done);
+        let r = b.build_load(Type::I32, s);
+        b.build_ret(Some(r));
+    }
+
+    #[test]
+    fn test_pipeline_preserves_semantics() {
+        let mut module = Module::new("t");
+        build_sum(&mut module);
+        let before = module.get_function("sum").unwrap().clone();
+
+        let stats = transform(&mut module);
+        module.verify().unwrap();
+        let after = module.get_function("sum").unwrap();
+        for n in -2..8 {
+            assert_eq!(interpret(&before, &[n]), interpret(after, &[n]), "n = {}", n);
+        }
+        assert!(stats.changes_for("mem2reg") > 0);
+        assert!(stats.iterations >= 2);
+
+        let insts: Vec<&Instruction> = after.blocks.iter().flat_map(|b| &b.instructions).collect();
+        assert!(insts.iter().all(|i| !i.is_memory_op()), "allocas left behind");
+        // s e i viven en phis de la cabecera del bucle
+        let header = after.blocks.iter().find(|b| b.name.as_deref() == Some("while.cond")).unwrap();
+        assert_eq!(header.instructions.iter().filter(|i| i.opcode == Opcode::Phi).count(), 2);
+    }
+
+    #[test]
+    fn test_pipeline_reaches_fixed_point() {
+        let mut module = Module::new("t");
+        build_sum(&mut module);
+        transform(&mut module);
+        let snapshot = format!("{:?}", module.get_function("sum").unwrap().blocks);
+        let stats = transform(&mut module);
+        assert_eq!(stats.iterations, 1);
+        assert!(stats.changes.iter().all(|(_, n)| *n == 0));
+        assert_eq!(snapshot, format!("{:?}", module.get_function("sum").unwrap().blocks));
+    }
+}
@@ -0,0 +1,662 @@
+// ============================================================
+// ADead-BIB — Profile-Guided Optimization (PGO)
+// ============================================================
+// `-fprofile-generate` instrumenta el programa con contadores y
+// `-fprofile-use=app.prof` devuelve esos conteos al compilador:
+//
+//   instrument(program, "app.prof")
+//     → un contador global por entrada de función y dos por site
+//       (veces que se alcanza / veces que se toma), incrementados
+//       con `c = c + 1`; main vuelca el .prof antes de salir
+//   Profile::load("app.prof")
+//     → branch layout, prioridad de registros (backend) e
+//       inliner / BranchDetector (optimizer)
+//
+// Un "site" es cada If/While/DoWhile/For/ForEach de una función,
+// numerado en pre-orden (los cuerpos de un switch en orden: casos,
+// luego default). La numeración solo depende de la forma del cuerpo,
+// así que el build instrumentado y el de profile-use coinciden
+// mientras el fuente no cambie; una función cuyo número de sites no
+// cuadra se ignora.
+//
+// Formato del .prof (texto, una línea por registro):
+//
+//   # adeb-profile 1
+//   fn <nombre> <entradas>
+//   site <k> <if|loop> <alcanzado> <tomado>
+//
+// Para un if, "tomado" = veces que entra al then; para un loop, las
+// iteraciones del cuerpo.
+// ============================================================
+
+use adeb_core::ast::{BinOp, Expr, Function, Program, Stmt};
+use adeb_core::types::Type;
+use std::collections::HashMap;
+
+/// Cabecera de la primera línea del .prof
+pub const PROFILE_HEADER: &str = "# adeb-profile 1";
+/// Un brazo que se toma en menos de 1/COLD_FRACTION de las visitas es frío
+pub const COLD_FRACTION: u64 = 16;
+/// Sesgo a partir del cual el predictor acierta casi siempre
+pub const PREDICTABLE_BIAS: f64 = 0.9;
+/// Función generada que escribe el .prof
+pub const DUMP_FUNCTION: &str = "__adeb_prof_dump";
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum SiteKind {
+    If,
+    Loop,
+}
+
+impl SiteKind {
+    fn as_str(&self) -> &'static str {
+        match self {
+            SiteKind::If => "if",
+            SiteKind::Loop => "loop",
+        }
+    }
+}
+
+/// Conteos de un site
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct SiteCount {
+    pub kind: SiteKind,
+    pub reached: u64,
+    pub taken: u64,
+}
+
+impl SiteCount {
+    /// Probabilidad de saltar al then (if) o de repetir el cuerpo (loop)
+    pub fn taken_probability(&self) -> Option<f64> {
+        let total = match self.kind {
+            SiteKind::If => self.reached,
+            SiteKind::Loop => self.reached + self.taken,
+        };
+        (total > 0).then(|| self.taken as f64 / total as f64)
+    }
+
+    /// Veces que se ejecuta el código controlado por el site
+    pub fn frequency(&self) -> u64 {
+        match self.kind {
+            SiteKind::If => self.reached,
+            SiteKind::Loop => self.reached + self.taken,
+        }
+    }
+
+    /// Brazo frío de un if: Some(true) = then, Some(false) = else
+    pub fn cold_arm(&self) -> Option<bool> {
+        if self.kind != SiteKind::If || self.reached < COLD_FRACTION {
+            return None;
+        }
+        if self.taken * COLD_FRACTION <= self.reached {
+            Some(true)
+        } else if (self.reached - self.taken) * COLD_FRACTION <= self.reached {
+            Some(false)
+        } else {
+            None
+        }
+    }
+
+    /// El salto va casi siempre al mismo lado: un cmov no gana nada
+    pub fn is_predictable(&self) -> bool {
+        match self.taken_probability() {
+            Some(p) => p >= PREDICTABLE_BIAS || p <= 1.0 - PREDICTABLE_BIAS,
+            None => false,
+        }
+    }
+}
+
+/// Conteos de una función
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct FunctionProfile {
+    pub entry: u64,
+    pub sites: Vec<SiteCount>,
+}
+
+impl FunctionProfile {
+    pub fn site(&self, index: usize) -> Option<&SiteCount> {
+        self.sites.get(index)
+    }
+}
+
+/// Contenido de un .prof
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct Profile {
+    pub functions: HashMap<String, FunctionProfile>,
+}
+
+impl Profile {
+    pub fn parse(text: &str) -> Result<Self, String> {
+        let mut lines = text.lines().enumerate();
+        match lines.next() {
+            Some((_, first)) if first.trim() == PROFILE_HEADER => {}
+            _ => return Err(format!("missing '{}' header", PROFILE_HEADER)),
+        }
+        let mut profile = Profile::default();
+        let mut current: Option<String> = None;
+        for (n, line) in lines {
+            let fields: Vec<&str> = line.split_whitespace().collect();
+            let bad = || format!("line {}: malformed record '{}'", n + 1, line.trim());
+            let count = |s: &str| s.parse::<u64>().map_err(|_| bad());
+            match fields.as_slice() {
+                [] => {}
+                [comment, ..] if comment.starts_with('#') => {}
+                ["fn", name, entry] => {
+                    let entry = count(entry)?;
+                    profile.functions.insert(
+                        name.to_string(),
+                        FunctionProfile { entry, sites: Vec::new() },
+                    );
+                    current = Some(name.to_string());
+                }
+                ["site", index, kind, reached, taken] => {
+                    let func = current
+                        .as_ref()
+                        .and_then(|name| profile.functions.get_mut(name))
+                        .ok_or_else(bad)?;
+                    if count(index)? as usize != func.sites.len() {
+                        return Err(bad());
+                    }
+                    let kind = match *kind {
+                        "if" => SiteKind::If,
+                        "loop" => SiteKind::Loop,
+                        _ => return Err(bad()),
+                    };
+                    func.sites.push(SiteCount {
+                        kind,
+                        reached: count(reached)?,
+                        taken: count(taken)?,
+                    });
+                }
+                _ => return Err(bad()),
+            }
+        }
+        Ok(profile)
+    }
+
+    pub fn load(path: &str) -> Result<Self, String> {
+        let text = std::fs::read_to_string(path)
+            .map_err(|e| format!("cannot read profile '{}': {}", path, e))?;
+        Self::parse(&text).map_err(|e| format!("{}: {}", path, e))
+    }
+
+    /// Mismo formato que escribe el programa instrumentado, ordenado por nombre
+    pub fn to_text(&self) -> String {
+        let mut names: Vec<&String> = self.functions.keys().collect();
+        names.sort();
+        let mut out = format!("{}\n", PROFILE_HEADER);
+        for name in names {
+            let func = &self.functions[name];
+            out.push_str(&format!("fn {} {}\n", name, func.entry));
+            for (k, site) in func.sites.iter().enumerate() {
+                out.push_str(&format!(
+                    "site {} {} {} {}\n",
+                    k,
+                    site.kind.as_str(),
+                    site.reached,
+                    site.taken
+                ));
+            }
+        }
+        out
+    }
+
+    pub fn function(&self, name: &str) -> Option<&FunctionProfile> {
+        self.functions.get(name)
+    }
+
+    /// Perfil de `func` si sus sites cuadran con el cuerpo actual
+    pub fn function_for(&self, func: &Function) -> Option<&FunctionProfile> {
+        self.function(&func.name)
+            .filter(|p| p.sites.len() == site_stmts(&func.body).len())
+    }
+
+    pub fn max_entry(&self) -> u64 {
+        self.functions.values().map(|f| f.entry).max().unwrap_or(0)
+    }
+
+    /// Entre las funciones más llamadas (>= 1/COLD_FRACTION del máximo)
+    pub fn is_hot(&self, name: &str) -> bool {
+        let max = self.max_entry();
+        match self.function(name) {
+            Some(f) => max > 0 && f.entry * COLD_FRACTION >= max,
+            None => false,
+        }
+    }
+
+    /// Medida y nunca ejecutada. Sin datos no es fría.
+    pub fn is_cold(&self, name: &str) -> bool {
+        self.function(name).map_or(false, |f| f.entry == 0)
+    }
+}
+
+// ============================================================
+// Sites
+// ============================================================
+
+pub fn is_site(stmt: &Stmt) -> bool {
+    matches!(
+        stmt,
+        Stmt::If { .. }
+            | Stmt::While { .. }
+            | Stmt::DoWhile { .. }
+            | Stmt::For { .. }
+            | Stmt::ForEach { .. }
+    )
+}
+
+/// Sites de `body` en pre-orden; el índice en el vector es su número
+pub fn site_stmts(body: &[Stmt]) -> Vec<&Stmt> {
+    fn walk<'a>(stmts: &'a [Stmt], out: &mut Vec<&'a Stmt>) {
+        for stmt in stmts {
+            if is_site(stmt) {
+                out.push(stmt);
+            }
+            for child in child_bodies(stmt) {
+                walk(child, out);
+            }
+        }
+    }
+    let mut out = Vec::new();
+    walk(body, &mut out);
+    out
+}
+
+fn child_bodies(stmt: &Stmt) -> Vec<&[Stmt]> {
+    match stmt {
+        Stmt::If { then_body, else_body, .. } => {
+            let mut bodies = vec![then_body.as_slice()];
+            if let Some(body) = else_body {
+                bodies.push(body);
+            }
+            bodies
+        }
+        Stmt::While { body, .. }
+        | Stmt::DoWhile { body, .. }
+        | Stmt::For { body, .. }
+        | Stmt::ForEach { body, .. } => vec![body.as_slice()],
+        Stmt::Switch { cases, default, .. } => {
+            let mut bodies: Vec<&[Stmt]> = cases.iter().map(|c| c.body.as_slice()).collect();
+            if let Some(body) = default {
+                bodies.push(body);
+            }
+            bodies
+        }
+        _ => Vec::new(),
+    }
+}
+
+fn site_kind(stmt: &Stmt) -> SiteKind {
+    match stmt {
+        Stmt::If { .. } => SiteKind::If,
+        _ => SiteKind::Loop,
+    }
+}
+
+// ============================================================
+// Instrumentación (-fprofile-generate)
+// ============================================================
+
+/// Añade los contadores y el volcado a `out_path`. Los contadores son
+/// globales escalares (`__prof_<f>_e`, `__prof_<f>_<k>_r/_t`): cada
+/// incremento es un load/add/store absoluto, sin llamadas. Sin main no hay
+/// punto de salida donde volcar y el programa queda igual.
+pub fn instrument(program: &mut Program, out_path: &str) {
+    if !program.functions.iter().any(|f| f.name == "main") {
+        return;
+    }
+    let mut layout: Vec<(String, Vec<SiteKind>)> = Vec::new();
+    for (fi, func) in program.functions.iter_mut().enumerate() {
+        let kinds: Vec<SiteKind> = site_stmts(&func.body).into_iter().map(site_kind).collect();
+        let mut next = 0;
+        let mut body = instrument_body(&func.body, fi, &mut next);
+        body.insert(0, bump(&entry_counter(fi)));
+        if func.name == "main" {
+            dump_on_main_exit(&mut body);
+        }
+        func.body = body;
+        layout.push((func.name.clone(), kinds));
+    }
+
+    for (fi, (_, kinds)) in layout.iter().enumerate() {
+        let mut names = vec![entry_counter(fi)];
+        for k in 0..kinds.len() {
+            names.push(site_counter(fi, k, 'r'));
+            names.push(site_counter(fi, k, 't'));
+        }
+        for name in names {
+            program.statements.push(Stmt::VarDecl {
+                var_type: Type::I64,
+                name,
+                value: Some(Expr::Number(0)),
+            });
+        }
+    }
+    program.functions.push(dump_function(&layout, out_path));
+}
+
+fn entry_counter(fi: usize) -> String {
+    format!("__prof_{}_e", fi)
+}
+
+fn site_counter(fi: usize, k: usize, which: char) -> String {
+    format!("__prof_{}_{}_{}", fi, k, which)
+}
+
+/// `c = c + 1` (el backend solo resuelve `+=` sobre locales)
+fn bump(name: &str) -> Stmt {
+    Stmt::Assign {
+        name: name.to_string(),
+        value: Expr::BinaryOp {
+            op: BinOp::Add,
+            left: Box::new(Expr::Variable(name.to_string())),
+            right: Box::new(Expr::Number(1)),
+        },
+    }
+}
+
+fn dump_call() -> Stmt {
+    Stmt::Expr(Expr::Call {
+        name: DUMP_FUNCTION.to_string(),
+        args: Vec::new(),
+    })
+}
+
+/// Copia de `stmts` con los contadores de sus sites. `next` sigue el
+/// mismo pre-orden que `site_stmts`.
+fn instrument_body(stmts: &[Stmt], fi: usize, next: &mut usize) -> Vec<Stmt> {
+    let mut out = Vec::with_capacity(stmts.len());
+    for stmt in stmts {
+        let site = is_site(stmt).then(|| {
+            let k = *next;
+            *next += 1;
+            k
+        });
+        // Entrar al then / al cuerpo del loop cuenta como "tomado"
+        let arm = |body: &[Stmt], next: &mut usize| {
+            let mut inner = instrument_body(body, fi, next);
+            if let Some(k) = site {
+                inner.insert(0, bump(&site_counter(fi, k, 't')));
+            }
+            inner
+        };
+        let copy = match stmt {
+            Stmt::If { condition, then_body, else_body } => {
+                let then_body = arm(then_body, next);
+                Stmt::If {
+                    condition: condition.clone(),
+                    then_body,
+                    else_body: else_body.as_ref().map(|b| instrument_body(b, fi, next)),
+                }
+            }
+            Stmt::While { condition, body } => Stmt::While {
+                condition: condition.clone(),
+                body: arm(body, next),
+            },
+            Stmt::DoWhile { body, condition } => Stmt::DoWhile {
+                body: arm(body, next),
+                condition: condition.clone(),
+            },
+            Stmt::For { var, start, end, body } => Stmt::For {
+                var: var.clone(),
+                start: start.clone(),
+                end: end.clone(),
+                body: arm(body, next),
+            },
+            Stmt::ForEach { var, iterable, body } => Stmt::ForEach {
+                var: var.clone(),
+                iterable: iterable.clone(),
+                body: arm(body, next),
+            },
+            Stmt::Switch { expr, cases, default } => {
+                let mut cases = cases.clone();
+                for case in &mut cases {
+                    case.body = instrument_body(&case.body, fi, next);
+                }
+                Stmt::Switch {
+                    expr: expr.clone(),
+                    cases,
+                    default: default.as_ref().map(|b| instrument_body(b, fi, next)),
+                }
+            }
+            // exit() no vuelve a main: volcar antes
+            Stmt::Expr(Expr::Call { name, .. }) if name == "exit" => {
+                out.push(dump_call());
+                stmt.clone()
+            }
+            _ => stmt.clone(),
+        };
+        if let Some(k) = site {
+            out.push(bump(&site_counter(fi, k, 'r')));
+        }
+        out.push(copy);
+    }
+    out
+}
+
+/// `return e;` → `__prof_ret = e; dump(); return __prof_ret;` en todo
+/// main, y un dump al final si main termina sin return
+fn dump_on_main_exit(body: &mut Vec<Stmt>) {
+    fn rewrite(stmts: &mut Vec<Stmt>) {
+        let mut i = 0;
+        while i < stmts.len() {
+            match &mut stmts[i] {
+                Stmt::Return(value) => {
+                    let replacement = match value.take() {
+                        Some(e) => vec![
+                            Stmt::VarDecl {
+                                var_type: Type::I64,
+                                name: "__prof_ret".to_string(),
+                                value: Some(e),
+                            },
+                            dump_call(),
+                            Stmt::Return(Some(Expr::Variable("__prof_ret".to_string()))),
+                        ],
+                        None => vec![dump_call(), Stmt::Return(None)],
+                    };
+                    let n = replacement.len();
+                    stmts.splice(i..=i, replacement);
+                    i += n;
+                    continue;
+                }
+                Stmt::If { then_body, else_body, .. } => {
+                    rewrite(then_body);
+                    if let Some(body) = else_body {
+                        rewrite(body);
+                    }
+                }
+                Stmt::While { body, .. }
+                | Stmt::DoWhile { body, .. }
+                | Stmt::For { body, .. }
+                | Stmt::ForEach { body, .. } => rewrite(body),
+                Stmt::Switch { cases, default, .. } => {
+                    for case in cases.iter_mut() {
+                        rewrite(&mut case.body);
+                    }
+                    if let Some(body) = default {
+                        rewrite(body);
+                    }
+                }
+                _ => {}
+            }
+            i += 1;
+        }
+    }
+    rewrite(body);
+    let falls_off = !matches!(
+        body.iter().rev().find(|s| !matches!(s, Stmt::LineMarker(_))),
+        Some(Stmt::Return(_))
+    );
+    if falls_off {
+        body.push(dump_call());
+    }
+}
+
+/// `void __adeb_prof_dump()`: fopen + un fprintf por registro + fclose.
+/// Sobrescribe el .prof en cada ejecución.
+fn dump_function(layout: &[(String, Vec<SiteKind>)], out_path: &str) -> Function {
+    let file = || Expr::Variable("__prof_f".to_string());
+    let var = |name: String| Expr::Variable(name);
+    let fprintf = |format: String, mut values: Vec<Expr>| {
+        let mut args = vec![file(), Expr::String(format)];
+        args.append(&mut values);
+        Stmt::Expr(Expr::Call { name: "fprintf".to_string(), args })
+    };
+
+    let mut writes = vec![fprintf(format!("{}\n", PROFILE_HEADER), Vec::new())];
+    for (fi, (name, kinds)) in layout.iter().enumerate() {
+        writes.push(fprintf(format!("fn {} %lld\n", name), vec![var(entry_counter(fi))]));
+        for (k, kind) in kinds.iter().enumerate() {
+            writes.push(fprintf(
+                format!("site {} {} %lld %lld\n", k, kind.as_str()),
+                vec![var(site_counter(fi, k, 'r')), var(site_counter(fi, k, 't'))],
+            ));
+        }
+    }
+    writes.push(Stmt::Expr(Expr::Call {
+        name: "fclose".to_string(),
+        args: vec![file()],
+    }));
+
+    Function {
+        name: DUMP_FUNCTION.to_string(),
+        params: Vec::new(),
+        return_type: None,
+        resolved_return_type: Type::Void,
+        body: vec![
+            Stmt::VarDecl {
+                var_type: Type::Pointer(Box::new(Type::Void)),
+                name: "__prof_f".to_string(),
+                value: Some(Expr::Call {
+                    name: "fopen".to_string(),
+                    args: vec![Expr::String(out_path.to_string()), Expr::String("w".to_string())],
+                }),
+            },
+            Stmt::If {
+                condition: file(),
+                then_body: writes,
+                else_body: None,
+            },
+            Stmt::Return(None),
+        ],
+        attributes: Default::default(),
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use adeb_core::ast::CmpOp;
+
+    fn func(name: &str, body: Vec<Stmt>) -> Function {
+        Function {
+            name: name.to_string(),
+            params: Vec::new(),
+            return_type: None,
+            resolved_return_type: Type::I32,
+            body,
+            attributes: Default::default(),
+        }
+    }
+
+    fn lt(a: &str, n: i64) -> Expr {
+        Expr::Comparison {
+            op: CmpOp::Lt,
+            left: Box::new(Expr::Variable(a.to_string())),
+            right: Box::new(Expr::Number(n)),
+        }
+    }
+
+    fn sample() -> Program {
+        let mut program = Program::new();
+        program.functions.push(func(
+            "main",
+            vec![
+                Stmt::While {
+                    condition: lt("i", 10),
+                    body: vec![Stmt::If {
+                        condition: lt("i", 1),
+                        then_body: vec![Stmt::Pass],
+                        else_body: Some(vec![Stmt::For {
+                            var: "j".to_string(),
+                            start: Expr::Number(0),
+                            end: Expr::Number(3),
+                            body: vec![],
+                        }]),
+                    }],
+                },
+                Stmt::Return(Some(Expr::Number(0))),
+            ],
+        ));
+        program
+    }
+
+    #[test]
+    fn test_parse_round_trip() {
+        let text = "# adeb-profile 1\nfn main 1\nsite 0 loop 1 10\nsite 1 if 10 1\nfn leaf 0\n";
+        let profile = Profile::parse(text).unwrap();
+        assert_eq!(profile.function("main").unwrap().sites.len(), 2);
+        assert_eq!(Profile::parse(&profile.to_text()).unwrap(), profile);
+        assert!(profile.is_cold("leaf"));
+        assert!(!profile.is_cold("missing"));
+        assert!(profile.is_hot("main"));
+
+        assert!(Profile::parse("fn main 1\n").is_err());
+        assert!(Profile::parse("# adeb-profile 1\nsite 0 if 1 1\n").is_err());
+        assert!(Profile::parse("# adeb-profile 1\nfn main 1\nsite 1 if 1 1\n").is_err());
+    }
+
+    #[test]
+    fn test_site_count_decisions() {
+        let site = |kind, reached, taken| SiteCount { kind, reached, taken };
+        assert_eq!(site(SiteKind::If, 1000, 10).cold_arm(), Some(true));
+        assert_eq!(site(SiteKind::If, 1000, 995).cold_arm(), Some(false));
+        assert_eq!(site(SiteKind::If, 1000, 500).cold_arm(), None);
+        assert_eq!(site(SiteKind::If, 4, 0).cold_arm(), None);
+        assert!(site(SiteKind::If, 1000, 990).is_predictable());
+        assert!(!site(SiteKind::If, 1000, 500).is_predictable());
+        // Un loop de 99 iteraciones por entrada repite el 99% de las veces
+        assert!(site(SiteKind::Loop, 10, 990).is_predictable());
+        assert_eq!(site(SiteKind::Loop, 10, 990).frequency(), 1000);
+    }
+
+    #[test]
+    fn test_instrument_numbers_sites_in_preorder() {
+        let mut program = sample();
+        let kinds: Vec<SiteKind> = site_stmts(&program.functions[0].body)
+            .into_iter()
+            .map(site_kind)
+            .collect();
+        assert_eq!(kinds, vec![SiteKind::Loop, SiteKind::If, SiteKind::Loop]);
+
+        instrument(&mut program, "app.prof");
+        // e + 3 sites × (r, t)
+        assert_eq!(program.statements.len(), 7);
+        let main = &program.functions[0];
+        assert!(matches!(&main.body[0], Stmt::Assign { name, .. } if name == "__prof_0_e"));
+        assert!(matches!(&main.body[1], Stmt::Assign { name, .. } if name == "__prof_0_0_r"));
+        let Stmt::While { body, .. } = &main.body[2] else { panic!("{:?}", main.body[2]) };
+        assert!(matches!(&body[0], Stmt::Assign { name, .. } if name == "__prof_0_0_t"));
+        assert!(matches!(&body[1], Stmt::Assign { name, .. } if name == "__prof_0_1_r"));
+        // Los contadores no son sites: la numeración sigue igual
+        assert_eq!(site_stmts(&main.body).len(), 3);
+        // return 0 → __prof_ret = 0; dump(); return __prof_ret
+        assert!(matches!(&main.body[4], Stmt::Expr(Expr::Call { name, .. }) if name == DUMP_FUNCTION));
+        assert!(matches!(&main.body[5], Stmt::Return(Some(Expr::Variable(v))) if v == "__prof_ret"));
+
+        let dump = program.functions.last().unwrap();
+        assert_eq!(dump.name, DUMP_FUNCTION);
+        let Stmt::If { then_body, .. } = &dump.body[1] else { panic!() };
+        // cabecera + fn + 3 sites + fclose
+        assert_eq!(then_body.len(), 6);
+    }
+
+    #[test]
+    fn test_instrument_without_main_is_a_no_op() {
+        let mut program = Program::new();
+        program.functions.push(func("lib", vec![Stmt::Return(None)]));
+        instrument(&mut program, "x.prof");
+        assert_eq!(program.functions.len(), 1);
+        assert!(program.statements.is_empty());
+    }
+}
@@ -0,0 +1,448 @@
+// ============================================================
+// BG — Binary Guardian: Analysis Cache
+// ============================================================
+// Cache incremental por función para el pipeline de compilación.
+//
+// Cada función aporta un trozo de ArchitectureMap (instrucciones,
+// syscalls, IO, control de flujo, capacidades) que depende solo de
+// sus ops. Ese aporte se guarda keyed por el hash de las ops
+// codificadas (bytes del encoder, límites entre ops y nombres de
+// las llamadas sin resolver) y POLICY_VERSION, junto al object
+// cache (`ADEB_CACHE_DIR` / `.adB-cache`). En un build incremental
+// solo se re-analizan las funciones que cambiaron; el resto se
+// fusiona desde el cache.
+//
+// Los labels se renumeran por orden de aparición antes de codificar:
+// el compilador los renumera en cada build y el mapa no depende de
+// ellos. Cambiar solo el número de una línea de fuente no invalida.
+//
+// Autor: Eddi Andreé Salazar Matos
+// ============================================================
+
+use super::arch_map::*;
+use super::capability::CapabilityMapper;
+use super::policy::POLICY_VERSION;
+use adeb_backend_x64::isa::encoder::Encoder;
+use adeb_backend_x64::isa::{ADeadOp, Label};
+use adeb_core::cache::hasher::hash_bytes;
+use adeb_core::cache::objects::ObjectCache;
+use std::collections::HashMap;
+
+/// Magic del blob de un aporte: "ADBG"
+const ENTRY_MAGIC: [u8; 4] = *b"ADBG";
+
+/// Salt para que las claves de BG no colisionen con objetos de TU
+const KEY_SALT: u64 = 0x6267_5f66_756e_6373; // "bg_funcs"
+
+/// Clave de una función: hash de sus ops codificadas (labels
+/// normalizados) + POLICY_VERSION.
+///
+/// El mapa guarda índices de op, así que la clave fija también dónde
+/// empieza cada op: cada una va precedida de un `SourceLine` con su
+/// índice y el encoder devuelve su offset. Las `SourceLine` originales
+/// no generan bytes ni el mapa lee su línea: entran solo por posición.
+pub fn function_key(ops: &[ADeadOp]) -> u64 {
+    let mut labels: HashMap<u32, Label> = HashMap::new();
+    let mut marked = Vec::with_capacity(ops.len() * 2);
+    let mut bytes = POLICY_VERSION.to_le_bytes().to_vec();
+    for (i, op) in ops.iter().enumerate() {
+        marked.push(ADeadOp::SourceLine(i as u32));
+        match op {
+            ADeadOp::SourceLine(_) => bytes.push(b'l'),
+            ADeadOp::Label(_) => bytes.push(b':'),
+            _ => bytes.push(b'.'),
+        }
+        if !matches!(op, ADeadOp::SourceLine(_)) {
+            let mut op = op.clone();
+            op.map_labels(&mut |l| {
+                let next = Label(labels.len() as u32);
+                *labels.entry(l.0).or_insert(next)
+            });
+            marked.push(op);
+        }
+    }
+    let encoded = Encoder::new().encode_all(&marked);
+
+    bytes.extend_from_slice(&encoded.code);
+    for &(offset, _) in &encoded.source_lines {
+        bytes.extend_from_slice(&(offset as u32).to_le_bytes());
+    }
+    // El encoder deja a 0 el rel32 de una llamada por nombre
+    for (offset, name) in &encoded.unresolved_calls {
+        bytes.extend_from_slice(&(*offset as u32).to_le_bytes());
+        bytes.extend_from_slice(name.as_bytes());
+        bytes.push(0);
+    }
+    hash_bytes(&bytes) ^ KEY_SALT
+}
+
+/// Cache de aportes por función.
+pub struct AnalysisCache {
+    /// Persistencia en disco (None = solo memoria)
+    objects: Option<ObjectCache>,
+    /// Aportes ya vistos en este proceso
+    memory: HashMap<u64, ArchitectureMap>,
+    /// Funciones tomadas del cache
+    pub hits: usize,
+    /// Funciones re-analizadas
+    pub misses: usize,
+}
+
+impl AnalysisCache {
+    /// Cache persistido en el directorio del object cache.
+    pub fn new(objects: ObjectCache) -> Self {
+        Self {
+            objects: Some(objects),
+            memory: HashMap::new(),
+            hits: 0,
+            misses: 0,
+        }
+    }
+
+    /// Mismo directorio que el object cache del driver (`ObjectCache::from_env`).
+    pub fn from_env() -> Self {
+        Self::new(ObjectCache::from_env())
+    }
+
+    /// Solo en memoria — nada se escribe a disco.
+    pub fn in_memory() -> Self {
+        Self {
+            objects: None,
+            memory: HashMap::new(),
+            hits: 0,
+            misses: 0,
+        }
+    }
+
+    /// Aporte de una función al ArchitectureMap, índices locales desde 0.
+    /// Del cache si existe; si no, se analiza y se guarda.
+    pub fn contribution(&mut self, ops: &[ADeadOp]) -> ArchitectureMap {
+        let key = function_key(ops);
+        if let Some(map) = self.memory.get(&key) {
+            self.hits += 1;
+            return map.clone();
+        }
+        if let Some(map) = self
+            .objects
+            .as_ref()
+            .and_then(|o| o.load(key))
+            .and_then(|bytes| decode_contribution(&bytes))
+        {
+            self.hits += 1;
+            self.memory.insert(key, map.clone());
+            return map;
+        }
+
+        self.misses += 1;
+        let map = CapabilityMapper::analyze(ops);
+        if let Some(ref objects) = self.objects {
+            // Un fallo de escritura solo cuesta el cache
+            let _ = objects.store(key, &encode_contribution(&map));
+        }
+        self.memory.insert(key, map.clone());
+        map
+    }
+}
+
+// ============================================================
+// Formato del blob
+// ============================================================
+//   "ADBG" u32 POLICY_VERSION
+//   InstructionMap, SyscallMap, IOMap, ControlFlowMap, Capabilities
+// Enteros u32 little-endian; listas con longitud u32 al frente.
+
+fn put(out: &mut Vec<u8>, v: usize) {
+    out.extend_from_slice(&(v as u32).to_le_bytes());
+}
+
+fn put_list(out: &mut Vec<u8>, items: &[usize]) {
+    put(out, items.len());
+    for &i in items {
+        put(out, i);
+    }
+}
+
+fn class_tag(class: InstructionClass) -> u8 {
+    match class {
+        InstructionClass::Safe => 0,
+        InstructionClass::Restricted => 1,
+        InstructionClass::Privileged => 2,
+    }
+}
+
+fn capability_bits(c: &Capabilities) -> u16 {
+    [
+        c.privileged_instructions,
+        c.io_port_access,
+        c.syscalls,
+        c.interrupts,
+        c.indirect_control_flow,
+        c.self_modifying_code,
+        c.control_register_access,
+        c.interrupt_control,
+        c.msr_access,
+        c.descriptor_table_access,
+        c.far_jumps,
+    ]
+    .iter()
+    .enumerate()
+    .fold(0, |bits, (i, &f)| bits | ((f as u16) << i))
+}
+
+/// Serializa la parte de un ArchitectureMap que produce CapabilityMapper.
+pub fn encode_contribution(map: &ArchitectureMap) -> Vec<u8> {
+    let mut out = Vec::new();
+    out.extend_from_slice(&ENTRY_MAGIC);
+    out.extend_from_slice(&POLICY_VERSION.to_le_bytes());
+
+    let im = &map.instruction_map;
+    put(&mut out, im.total);
+    put(&mut out, im.safe_count);
+    put(&mut out, im.restricted_count);
+    put(&mut out, im.privileged_count);
+    put(&mut out, im.flagged.len());
+    for &(idx, class) in &im.flagged {
+        put(&mut out, idx);
+        out.push(class_tag(class));
+    }
+
+    let sm = &map.syscall_map;
+    put(&mut out, sm.syscall_count);
+    put(&mut out, sm.interrupt_vectors.len());
+    out.extend_from_slice(&sm.interrupt_vectors);
+    out.push(sm.uses_syscall_instruction as u8);
+    put_list(&mut out, &sm.call_sites);
+
+    put(&mut out, map.io_map.accesses.len());
+    for a in &map.io_map.accesses {
+        match a.port {
+            Some(port) => {
+                out.push(1);
+                out.extend_from_slice(&port.to_le_bytes());
+            }
+            None => out.extend_from_slice(&[0, 0, 0]),
+        }
+        out.push((a.direction == IODirection::Out) as u8);
+        put(&mut out, a.instruction_index);
+    }
+
+    let cf = &map.control_flow_map;
+    for v in [
+        cf.direct_jumps,
+        cf.indirect_jumps,
+        cf.direct_calls,
+        cf.indirect_calls,
+        cf.conditional_branches,
+        cf.far_jumps,
+    ] {
+        put(&mut out, v);
+    }
+    put_list(&mut out, &cf.indirect_sites);
+
+    out.extend_from_slice(&capability_bits(&map.capabilities).to_le_bytes());
+    out
+}
+
+/// Lector secuencial; cualquier truncamiento devuelve None.
+struct Reader<'a> {
+    bytes: &'a [u8],
+    pos: usize,
+}
+
+impl<'a> Reader<'a> {
+    fn take(&mut self, n: usize) -> Option<&'a [u8]> {
+        let s = self.bytes.get(self.pos..self.pos.checked_add(n)?)?;
+        self.pos += n;
+        Some(s)
+    }
+
+    fn byte(&mut self) -> Option<u8> {
+        Some(self.take(1)?[0])
+    }
+
+    fn u16(&mut self) -> Option<u16> {
+        let b = self.take(2)?;
+        Some(u16::from_le_bytes([b[0], b[1]]))
+    }
+
+    fn num(&mut self) -> Option<usize> {
+        let b = self.take(4)?;
+        Some(u32::from_le_bytes([b[0], b[1], b[2], b[3]]) as usize)
+    }
+
+    fn list(&mut self) -> Option<Vec<usize>> {
+        let n = self.num()?;
+        (0..n).map(|_| self.num()).collect()
+    }
+}
+
+/// Inverso de `encode_contribution`. None si el blob no es válido o es
+/// de otra POLICY_VERSION.
+pub fn decode_contribution(bytes: &[u8]) -> Option<ArchitectureMap> {
+    let mut r = Reader { bytes, pos: 0 };
+    if r.take(4)? != ENTRY_MAGIC || r.num()? != POLICY_VERSION as usize {
+        return None;
+    }
+    let mut map = ArchitectureMap::new();
+
+    let im = &mut map.instruction_map;
+    im.total = r.num()?;
+    im.safe_count = r.num()?;
+    im.restricted_count = r.num()?;
+    im.privileged_count = r.num()?;
+    for _ in 0..r.num()? {
+        let idx = r.num()?;
+        let class = match r.byte()? {
+            0 => InstructionClass::Safe,
+            1 => InstructionClass::Restricted,
+            2 => InstructionClass::Privileged,
+            _ => return None,
+        };
+        im.flagged.push((idx, class));
+    }
+
+    let sm = &mut map.syscall_map;
+    sm.syscall_count = r.num()?;
+    let n = r.num()?;
+    sm.interrupt_vectors = r.take(n)?.to_vec();
+    sm.uses_syscall_instruction = r.byte()? != 0;
+    sm.call_sites = r.list()?;
+
+    for _ in 0..r.num()? {
+        let has_port = r.byte()? != 0;
+        let port = r.u16()?;
+        let direction = if r.byte()? != 0 { IODirection::Out } else { IODirection::In };
+        map.io_map.accesses.push(IOAccess {
+            port: if has_port { Some(port) } else { None },
+            direction,
+            instruction_index: r.num()?,
+        });
+    }
+
+    let cf = &mut map.control_flow_map;
+    cf.direct_jumps = r.num()?;
+    cf.indirect_jumps = r.num()?;
+    cf.direct_calls = r.num()?;
+    cf.indirect_calls = r.num()?;
+    cf.conditional_branches = r.num()?;
+    cf.far_jumps = r.num()?;
+    cf.indirect_sites = r.list()?;
+
+    let bits = r.u16()?;
+    let flag = |i: u32| bits & (1 << i) != 0;
+    map.capabilities = Capabilities {
+        privileged_instructions: flag(0),
+        io_port_access: flag(1),
+        syscalls: flag(2),
+        interrupts: flag(3),
+        indirect_control_flow: flag(4),
+        self_modifying_code: flag(5),
+        control_register_access: flag(6),
+        interrupt_control: flag(7),
+        msr_access: flag(8),
+        descriptor_table_access: flag(9),
+        far_jumps: flag(10),
+    };
+
+    if r.pos != bytes.len() {
+        return None;
+    }
+    Some(map)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use adeb_backend_x64::isa::*;
+
+    fn sample_ops() -> Vec<ADeadOp> {
+        vec![
+            ADeadOp::Label(Label(7)),
+            ADeadOp::Push {
+                src: Operand::Reg(Reg::RBP),
+            },
+            ADeadOp::Syscall,
+            ADeadOp::Int { vector: 0x80 },
+            ADeadOp::InByte {
+                port: Operand::Imm8(0x60),
+            },
+            ADeadOp::Call {
+                target: CallTarget::RipRelative(0x40),
+            },
+            ADeadOp::Jmp { target: Label(9) },
+            ADeadOp::Cli,
+            ADeadOp::Ret,
+        ]
+    }
+
+    #[test]
+    fn test_contribution_roundtrip() {
+        let map = CapabilityMapper::analyze(&sample_ops());
+        let decoded = decode_contribution(&encode_contribution(&map)).unwrap();
+        assert_eq!(decoded.instruction_map.total, map.instruction_map.total);
+        assert_eq!(decoded.instruction_map.flagged, map.instruction_map.flagged);
+        assert_eq!(decoded.syscall_map.interrupt_vectors, vec![0x80]);
+        assert_eq!(decoded.syscall_map.call_sites, map.syscall_map.call_sites);
+        assert_eq!(decoded.io_map.unique_ports(), vec![0x60]);
+        assert_eq!(decoded.control_flow_map.indirect_sites, map.control_flow_map.indirect_sites);
+        assert_eq!(decoded.capabilities.active_count(), map.capabilities.active_count());
+
+        let bytes = encode_contribution(&map);
+        assert!(decode_contribution(&bytes[..bytes.len() - 1]).is_none());
+    }
+
+    #[test]
+    fn test_key_ignores_label_numbering() {
+        let a = sample_ops();
+        let mut b = sample_ops();
+        for op in &mut b {
+            op.map_labels(&mut |l| Label(l.0 + 100));
+        }
+        assert_eq!(function_key(&a), function_key(&b));
+
+        let mut c = sample_ops();
+        c.push(ADeadOp::Nop);
+        assert_ne!(function_key(&a), function_key(&c));
+
+        // La línea no entra; su posición sí (desplaza los índices del mapa)
+        let mut d = sample_ops();
+        d.insert(1, ADeadOp::SourceLine(42));
+        let mut e = sample_ops();
+        e.insert(1, ADeadOp::SourceLine(43));
+        assert_eq!(function_key(&d), function_key(&e));
+        assert_ne!(function_key(&a), function_key(&d));
+    }
+
+    #[test]
+    fn test_key_keeps_call_names() {
+        let call = |name: &str| {
+            vec![
+                ADeadOp::Call {
+                    target: CallTarget::Name(name.to_string()),
+                },
+                ADeadOp::Ret,
+            ]
+        };
+        let alloc = function_key(&call("VirtualAlloc"));
+        assert_eq!(alloc, function_key(&call("VirtualAlloc")));
+        assert_ne!(alloc, function_key(&call("malloc")));
+    }
+
+    #[test]
+    fn test_cache_persists_with_object_cache() {
+        let dir = std::env::temp_dir().join(format!("adeb_bgcache_{}", std::process::id()));
+        let ops = sample_ops();
+
+        let mut cache = AnalysisCache::new(ObjectCache::new(&dir));
+        cache.contribution(&ops);
+        cache.contribution(&ops);
+        assert_eq!((cache.hits, cache.misses), (1, 1));
+
+        // Otro proceso (cache nuevo) lo lee del disco
+        let mut fresh = AnalysisCache::new(ObjectCache::new(&dir));
+        let map = fresh.contribution(&ops);
+        assert_eq!((fresh.hits, fresh.misses), (1, 0));
+        assert!(map.capabilities.privileged_instructions);
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
@@ -10,17 +10,28 @@
 // O(n) para generar el mapa. O(1) para evaluar.
 // Determinista: mismo input + misma policy = mismo output.
 //
+// Archivos: el loader mapea el binario y divide las secciones
+// ejecutables en chunks. Cada chunk se decodifica en paralelo a un
+// mapa parcial; al fusionar (en orden) cada chunk se alinea a la
+// frontera de instrucción real que dejó el anterior, así el resultado
+// es idéntico al de un escaneo secuencial sección por sección.
+//
 // Autor: Eddi Andreé Salazar Matos
 // ============================================================
 
+use super::analysis_cache::AnalysisCache;
 use super::arch_map::ArchitectureMap;
-use super::binary_loader::{BinaryInfo, BinaryLoader};
+use super::binary_loader::{
+    BinaryInfo, BinaryLoader, CodeChunk, CHUNK_SYNC_WINDOW, DEFAULT_CHUNK_SIZE,
+};
 use super::capability::CapabilityMapper;
 use super::policy::{PolicyEngine, SecurityLevel, SecurityPolicy, Verdict};
-use crate::isa::decoder::Decoder;
-use crate::isa::ADeadOp;
+use adeb_backend_x64::isa::decoder::Decoder;
+use adeb_backend_x64::isa::{ADeadOp, Label};
 use std::fmt;
 use std::path::Path;
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use std::sync::Mutex;
 
 // ============================================================
 // Analysis Result
@@ -41,6 +52,8 @@ pub struct AnalysisResult {
     pub instruction_count: usize,
     /// Nombre de la policy usada
     pub policy_name: String,
+    /// False si el escaneo se cortó en la primera violación dura
+    pub complete: bool,
 }
 
 impl fmt::Display for AnalysisResult {
@@ -57,6 +70,9 @@ impl fmt::Display for AnalysisResult {
         writeln!(f, "  Policy:     {}", self.policy_name)?;
         writeln!(f, "  Min level:  {}", self.minimum_level)?;
         writeln!(f, "  Opcodes:    {}", self.instruction_count)?;
+        if !self.complete {
+            writeln!(f, "  Scan:       partial (stopped at first violation)")?;
+        }
         writeln!(f)?;
         writeln!(f, "{}", self.map)?;
         writeln!(f, "  ┌─ Verdict ──────────────────────────────┐")?;
@@ -82,6 +98,40 @@ impl fmt::Display for AnalysisResult {
     }
 }
 
+// ============================================================
+// Scan Options
+// ============================================================
+
+/// Parámetros del escaneo paralelo de archivos.
+#[derive(Debug, Clone)]
+pub struct ScanOptions {
+    /// Tamaño nominal de cada chunk en bytes
+    pub chunk_size: usize,
+    /// Hilos de escaneo (0 = `available_parallelism`)
+    pub threads: usize,
+}
+
+impl Default for ScanOptions {
+    fn default() -> Self {
+        Self {
+            chunk_size: DEFAULT_CHUNK_SIZE,
+            threads: 0,
+        }
+    }
+}
+
+/// Resultado de decodificar un chunk.
+struct ChunkScan {
+    /// Ops que empiezan dentro de la ventana de sincronización, con su
+    /// offset: cuáles son válidas depende de dónde terminó el chunk previo.
+    prefix: Vec<(usize, ADeadOp)>,
+    /// Mapa de las ops posteriores a la ventana (índices locales desde 0)
+    body: ArchitectureMap,
+    body_count: usize,
+    /// Offset tras la última op que empieza antes del fin del chunk
+    next: usize,
+}
+
 // ============================================================
 // BinaryGuardian — API principal
 // ============================================================
@@ -93,17 +143,167 @@ impl BinaryGuardian {
     /// Analiza un archivo binario completo (PE/ELF/Raw).
     /// Pipeline: Load → Decode → Map → Validate → Evaluate.
     pub fn analyze_file(path: &Path, policy: &SecurityPolicy) -> Result<AnalysisResult, String> {
-        let info = BinaryLoader::load_file(path)?;
-        let result = Self::analyze_loaded(&info, policy);
-        Ok(result)
+        Self::analyze_file_with(path, policy, &ScanOptions::default())
     }
 
-    /// Analiza un binario ya cargado en memoria.
+    /// Como `analyze_file`, con control sobre chunks e hilos.
+    pub fn analyze_file_with(
+        path: &Path,
+        policy: &SecurityPolicy,
+        options: &ScanOptions,
+    ) -> Result<AnalysisResult, String> {
+        let (data, info) = BinaryLoader::map_file(path)?;
+        Ok(Self::analyze_mapped(&data, &info, policy, options))
+    }
+
+    /// Analiza un binario cuyos bytes completos están en `data` (mapeo o
+    /// buffer), escaneando `info.code_ranges` en paralelo.
+    /// Los índices de instrucción cuentan instrucciones decodificadas
+    /// (sin los pseudo-ops Label que inserta `decode_all`).
+    pub fn analyze_mapped(
+        data: &[u8],
+        info: &BinaryInfo,
+        policy: &SecurityPolicy,
+        options: &ScanOptions,
+    ) -> AnalysisResult {
+        let chunks = BinaryLoader::plan_chunks(info, options.chunk_size);
+        let (map, count, complete) = Self::scan_chunks(data, &chunks, policy, options.threads);
+        Self::finish(map, info, policy, count, complete)
+    }
+
+    /// Analiza un binario ya cargado en memoria (requiere `code_bytes`,
+    /// es decir `load_file`/`load_bytes`; para `map_file` usar `analyze_mapped`).
     pub fn analyze_loaded(info: &BinaryInfo, policy: &SecurityPolicy) -> AnalysisResult {
         let mut decoder = Decoder::new();
         let ops = decoder.decode_all(&info.code_bytes);
-        let mut map = CapabilityMapper::analyze(&ops);
+        let map = CapabilityMapper::analyze(&ops);
+        Self::finish(map, info, policy, ops.len(), true)
+    }
+
+    /// Decodifica los chunks en paralelo y fusiona los mapas parciales en
+    /// orden. Retorna (mapa, instrucciones, escaneo completo).
+    fn scan_chunks(
+        data: &[u8],
+        chunks: &[CodeChunk],
+        policy: &SecurityPolicy,
+        threads: usize,
+    ) -> (ArchitectureMap, usize, bool) {
+        let stop = AtomicBool::new(false);
+        let next_chunk = AtomicUsize::new(0);
+        let slots: Vec<Mutex<Option<ChunkScan>>> = chunks.iter().map(|_| Mutex::new(None)).collect();
+
+        let worker = || loop {
+            let i = next_chunk.fetch_add(1, Ordering::Relaxed);
+            if i >= chunks.len() || stop.load(Ordering::Relaxed) {
+                break;
+            }
+            let c = &chunks[i];
+            // El primer chunk de cada rango empieza en una frontera real
+            let window = if c.start == 0 { 0 } else { CHUNK_SYNC_WINDOW };
+            let scan = Self::scan_chunk(c.range_bytes(data), c.start, c.end, window, policy, &stop);
+            *slots[i].lock().unwrap() = Some(scan);
+        };
+
+        let threads = match threads {
+            0 => std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1),
+            n => n,
+        }
+        .min(chunks.len());
+        if threads <= 1 {
+            worker();
+        } else {
+            std::thread::scope(|s| {
+                for _ in 0..threads {
+                    s.spawn(&worker);
+                }
+            });
+        }
+
+        // ==== Merge en orden, alineando cada chunk a la frontera real ====
+        let stopped = stop.load(Ordering::Relaxed);
+        let mut map = ArchitectureMap::new();
+        let mut count = 0;
+        let mut cursor = 0;
+        for (c, slot) in chunks.iter().zip(slots) {
+            let Some(mut scan) = slot.into_inner().unwrap() else {
+                continue;
+            };
+            if c.start > 0 {
+                // Decodificación especulativa desde c.start: válida si pasa
+                // por `cursor`. Si no, re-escanear desde la frontera real.
+                let synced = scan.prefix.iter().any(|(off, _)| *off == cursor);
+                if !synced {
+                    if stopped {
+                        continue;
+                    }
+                    scan = Self::scan_chunk(c.range_bytes(data), cursor, c.end, 0, policy, &stop);
+                }
+                for (off, op) in &scan.prefix {
+                    if *off >= cursor {
+                        CapabilityMapper::record(&mut map, count, op);
+                        count += 1;
+                    }
+                }
+            }
+            map.merge_scan(scan.body, count);
+            count += scan.body_count;
+            cursor = scan.next;
+        }
+
+        (map, count, !stopped)
+    }
+
+    /// Decodifica `code[start..end)` (ops que empiezan antes de `end`) en
+    /// streaming. Las ops de los primeros `window` bytes quedan aparte.
+    fn scan_chunk(
+        code: &[u8],
+        start: usize,
+        end: usize,
+        window: usize,
+        policy: &SecurityPolicy,
+        stop: &AtomicBool,
+    ) -> ChunkScan {
+        let fail_fast = policy.stop_on_first_violation;
+        let mut decoder = Decoder::new();
+        let mut scan = ChunkScan {
+            prefix: Vec::new(),
+            body: ArchitectureMap::new(),
+            body_count: 0,
+            next: start,
+        };
+        let mut offset = start;
+
+        while offset < end {
+            let (op, consumed) = decoder.decode_next(code, offset);
+            if offset < start + window {
+                scan.prefix.push((offset, op));
+            } else {
+                CapabilityMapper::record(&mut scan.body, scan.body_count, &op);
+                scan.body_count += 1;
+                if fail_fast && PolicyEngine::has_hard_violation(&scan.body, policy) {
+                    stop.store(true, Ordering::Relaxed);
+                }
+            }
+            offset += consumed;
+
+            // Otro hilo (o este) ya encontró un DENY: el resto sobra
+            if fail_fast && stop.load(Ordering::Relaxed) {
+                break;
+            }
+        }
+
+        scan.next = offset;
+        scan
+    }
 
+    /// Completa el mapa con la estructura del binario y evalúa la policy.
+    fn finish(
+        mut map: ArchitectureMap,
+        info: &BinaryInfo,
+        policy: &SecurityPolicy,
+        instruction_count: usize,
+        complete: bool,
+    ) -> AnalysisResult {
         // Poblar metadata del binario
         map.binary_name = Some(info.path.clone());
         map.binary_size = info.total_size;
@@ -189,8 +389,9 @@ impl BinaryGuardian {
             map,
             verdict,
             minimum_level,
-            instruction_count: ops.len(),
+            instruction_count,
             policy_name: policy.name.clone(),
+            complete,
         }
     }
 
@@ -214,9 +415,58 @@ impl BinaryGuardian {
             minimum_level,
             instruction_count: ops.len(),
             policy_name: policy.name.clone(),
+            complete: true,
+        }
+    }
+
+    /// Como `analyze_ops`, pero función por función con cache: solo se
+    /// re-analizan las funciones cuyas ops cambiaron. El resultado es el
+    /// mismo que `analyze_ops` sobre la concatenación.
+    pub fn analyze_functions(
+        functions: &[&[ADeadOp]],
+        policy: &SecurityPolicy,
+        cache: &mut AnalysisCache,
+    ) -> AnalysisResult {
+        let mut map = ArchitectureMap::new();
+        let mut count = 0;
+        for ops in functions {
+            map.merge_scan(cache.contribution(ops), count);
+            count += ops.len();
+        }
+        let minimum_level = PolicyEngine::infer_minimum_level(&map);
+        let verdict = PolicyEngine::evaluate(&map, policy);
+
+        AnalysisResult {
+            binary_info: None,
+            map,
+            verdict,
+            minimum_level,
+            instruction_count: count,
+            policy_name: policy.name.clone(),
+            complete: true,
         }
     }
 
+    /// Divide el stream de ops del compilador en funciones: un corte antes
+    /// de cada `Label` de entrada (los labels con nombre de función).
+    pub fn split_functions<'a>(ops: &'a [ADeadOp], entries: &[Label]) -> Vec<&'a [ADeadOp]> {
+        let entries: std::collections::HashSet<Label> = entries.iter().copied().collect();
+        let mut functions = Vec::new();
+        let mut start = 0;
+        for (i, op) in ops.iter().enumerate() {
+            if let ADeadOp::Label(l) = op {
+                if i > start && entries.contains(l) {
+                    functions.push(&ops[start..i]);
+                    start = i;
+                }
+            }
+        }
+        if start < ops.len() {
+            functions.push(&ops[start..]);
+        }
+        functions
+    }
+
     /// Quick check: ¿aprobaría este binario bajo la policy dada?
     pub fn quick_check(ops: &[ADeadOp], policy: &SecurityPolicy) -> bool {
         let map = CapabilityMapper::analyze(ops);
@@ -232,7 +482,7 @@ impl BinaryGuardian {
 #[cfg(test)]
 mod tests {
     use super::*;
-    use crate::isa::*;
+    use adeb_backend_x64::isa::*;
 
     #[test]
     fn test_analyze_safe_ops() {
@@ -290,6 +540,89 @@ mod tests {
         assert!(map.capabilities.io_port_access);
     }
 
+    /// Código sintético con instrucciones de 1 a 10 bytes, para que los
+    /// cortes de chunk caigan a mitad de instrucción.
+    fn synthetic_code(blocks: usize) -> Vec<u8> {
+        let mut code = Vec::new();
+        for i in 0..blocks {
+            code.extend_from_slice(&[0x55, 0x48, 0x89, 0xE5]); // push rbp; mov rbp, rsp
+            code.extend_from_slice(&[0x48, 0xB8]); // mov rax, imm64
+            code.extend_from_slice(&(i as u64).to_le_bytes());
+            code.extend_from_slice(&[0x0F, 0x05]); // syscall
+            if i % 3 == 0 {
+                code.extend_from_slice(&[0xE8, 0x00, 0x00, 0x00, 0x00]); // call rel32
+            }
+            code.extend_from_slice(&[0x5D, 0xC3]); // pop rbp; ret
+        }
+        code
+    }
+
+    #[test]
+    fn test_parallel_scan_matches_sequential() {
+        let code = synthetic_code(2000);
+        let info = BinaryLoader::load_bytes(&code, "synthetic.bin").unwrap();
+        let policy = SecurityPolicy::kernel();
+        let whole = ScanOptions { chunk_size: code.len(), threads: 1 };
+
+        let a = BinaryGuardian::analyze_mapped(&code, &info, &policy, &whole);
+        for chunk_size in [33, 97, 1000] {
+            let split = ScanOptions { chunk_size, threads: 4 };
+            let b = BinaryGuardian::analyze_mapped(&code, &info, &policy, &split);
+            assert!(b.complete);
+            assert_eq!(a.instruction_count, b.instruction_count);
+            assert_eq!(a.map.instruction_map.flagged, b.map.instruction_map.flagged);
+            assert_eq!(a.map.syscall_map.call_sites, b.map.syscall_map.call_sites);
+            assert_eq!(
+                a.map.control_flow_map.direct_calls,
+                b.map.control_flow_map.direct_calls
+            );
+        }
+        assert_eq!(a.map.syscall_map.syscall_count, 2000);
+    }
+
+    #[test]
+    fn test_fail_fast_clean_binary_scans_everything() {
+        let code = synthetic_code(500);
+        let info = BinaryLoader::load_bytes(&code, "synthetic.bin").unwrap();
+        let options = ScanOptions { chunk_size: 64, threads: 2 };
+        let policy = SecurityPolicy::service().fail_fast();
+        let result = BinaryGuardian::analyze_mapped(&code, &info, &policy, &options);
+        assert!(result.complete);
+        assert_eq!(result.map.syscall_map.syscall_count, 500);
+    }
+
+    #[test]
+    fn test_analyze_functions_matches_analyze_ops() {
+        let ops = vec![
+            ADeadOp::Label(Label(0)),
+            ADeadOp::Push {
+                src: Operand::Reg(Reg::RBP),
+            },
+            ADeadOp::Syscall,
+            ADeadOp::Ret,
+            ADeadOp::Label(Label(1)),
+            ADeadOp::Cli,
+            ADeadOp::Int { vector: 0x80 },
+            ADeadOp::Ret,
+        ];
+        let functions = BinaryGuardian::split_functions(&ops, &[Label(0), Label(1)]);
+        assert_eq!(functions.len(), 2);
+
+        let policy = SecurityPolicy::user();
+        let whole = BinaryGuardian::analyze_ops(&ops, &policy);
+        let mut cache = AnalysisCache::in_memory();
+        let first = BinaryGuardian::analyze_functions(&functions, &policy, &mut cache);
+        let second = BinaryGuardian::analyze_functions(&functions, &policy, &mut cache);
+
+        for r in [&first, &second] {
+            assert_eq!(r.instruction_count, whole.instruction_count);
+            assert_eq!(r.map.instruction_map.flagged, whole.map.instruction_map.flagged);
+            assert_eq!(r.map.syscall_map.call_sites, whole.map.syscall_map.call_sites);
+            assert_eq!(r.verdict.violation_count(), whole.verdict.violation_count());
+        }
+        assert_eq!((cache.misses, cache.hits), (2, 2));
+    }
+
     #[test]
     fn test_display() {
         let ops = vec![ADeadOp::Nop, ADeadOp::Ret];
@@ -81,6 +81,16 @@ impl InstructionMap {
         }
         self.safe_count as f64 / self.total as f64
     }
+
+    /// Fusiona un mapa parcial cuyos índices empiezan en `base`.
+    pub fn merge(&mut self, other: InstructionMap, base: usize) {
+        self.total += other.total;
+        self.safe_count += other.safe_count;
+        self.restricted_count += other.restricted_count;
+        self.privileged_count += other.privileged_count;
+        self.flagged
+            .extend(other.flagged.into_iter().map(|(i, class)| (i + base, class)));
+    }
 }
 
 // ============================================================
@@ -174,6 +184,19 @@ impl SyscallMap {
     pub fn has_syscalls(&self) -> bool {
         self.syscall_count > 0 || !self.interrupt_vectors.is_empty()
     }
+
+    /// Fusiona un mapa parcial cuyos índices empiezan en `base`.
+    pub fn merge(&mut self, other: SyscallMap, base: usize) {
+        self.syscall_count += other.syscall_count;
+        self.uses_syscall_instruction |= other.uses_syscall_instruction;
+        for v in other.interrupt_vectors {
+            if !self.interrupt_vectors.contains(&v) {
+                self.interrupt_vectors.push(v);
+            }
+        }
+        self.call_sites
+            .extend(other.call_sites.into_iter().map(|i| i + base));
+    }
 }
 
 // ============================================================
@@ -224,6 +247,14 @@ impl IOMap {
         ports.dedup();
         ports
     }
+
+    /// Fusiona un mapa parcial cuyos índices empiezan en `base`.
+    pub fn merge(&mut self, other: IOMap, base: usize) {
+        self.accesses.extend(other.accesses.into_iter().map(|mut a| {
+            a.instruction_index += base;
+            a
+        }));
+    }
 }
 
 // ============================================================
@@ -263,6 +294,18 @@ impl ControlFlowMap {
     pub fn has_indirect_control(&self) -> bool {
         self.indirect_jumps > 0 || self.indirect_calls > 0
     }
+
+    /// Fusiona un mapa parcial cuyos índices empiezan en `base`.
+    pub fn merge(&mut self, other: ControlFlowMap, base: usize) {
+        self.direct_jumps += other.direct_jumps;
+        self.indirect_jumps += other.indirect_jumps;
+        self.direct_calls += other.direct_calls;
+        self.indirect_calls += other.indirect_calls;
+        self.conditional_branches += other.conditional_branches;
+        self.far_jumps += other.far_jumps;
+        self.indirect_sites
+            .extend(other.indirect_sites.into_iter().map(|i| i + base));
+    }
 }
 
 // ============================================================
@@ -549,6 +592,21 @@ impl Capabilities {
         ];
         flags.iter().filter(|&&f| f).count()
     }
+
+    /// Unión de capacidades (OR de cada flag).
+    pub fn merge(&mut self, other: &Capabilities) {
+        self.privileged_instructions |= other.privileged_instructions;
+        self.io_port_access |= other.io_port_access;
+        self.syscalls |= other.syscalls;
+        self.interrupts |= other.interrupts;
+        self.indirect_control_flow |= other.indirect_control_flow;
+        self.self_modifying_code |= other.self_modifying_code;
+        self.control_register_access |= other.control_register_access;
+        self.interrupt_control |= other.interrupt_control;
+        self.msr_access |= other.msr_access;
+        self.descriptor_table_access |= other.descriptor_table_access;
+        self.far_jumps |= other.far_jumps;
+    }
 }
 
 // ============================================================
@@ -592,6 +650,18 @@ impl ArchitectureMap {
             binary_size: 0,
         }
     }
+
+    /// Fusiona el resultado de escanear otro trozo de código: mapas de
+    /// instrucciones, syscalls, IO, control de flujo y capacidades. Los
+    /// índices de `other` se desplazan en `base` (instrucciones previas).
+    /// Memoria, integridad e imports vienen del loader y no se fusionan.
+    pub fn merge_scan(&mut self, other: ArchitectureMap, base: usize) {
+        self.instruction_map.merge(other.instruction_map, base);
+        self.syscall_map.merge(other.syscall_map, base);
+        self.io_map.merge(other.io_map, base);
+        self.control_flow_map.merge(other.control_flow_map, base);
+        self.capabilities.merge(&other.capabilities);
+    }
 }
 
 impl fmt::Display for ArchitectureMap {
@@ -7,10 +7,16 @@
 // Usa goblin para parsing de PE/ELF.
 // Para raw binaries (boot sectors, firmware), trata todo como código.
 //
+// Los archivos se mapean en memoria (mmap / MapViewOfFile): un DLL de
+// cientos de MB no se copia entero al heap, y el analyzer escanea las
+// secciones ejecutables directamente desde el mapeo, en chunks paralelos.
+//
 // Autor: Eddi Andreé Salazar Matos
 // ============================================================
 
 use std::fmt;
+use std::fs::File;
+use std::ops::Deref;
 use std::path::Path;
 
 /// Tipo de formato binario detectado.
@@ -89,7 +95,10 @@ pub struct BinaryInfo {
     pub path: String,
     pub format: BinaryFormat,
     pub sections: Vec<SectionInfo>,
+    /// Bytes de código concatenados (vacío si se cargó con `map_file`)
     pub code_bytes: Vec<u8>,
+    /// Rangos (offset, size) en el archivo con contenido ejecutable
+    pub code_ranges: Vec<(usize, usize)>,
     pub total_size: usize,
     pub entry_point: usize,
     pub rwx_count: usize,
@@ -101,6 +110,13 @@ pub struct BinaryInfo {
     pub header_size: usize,
 }
 
+impl BinaryInfo {
+    /// Total de bytes ejecutables, esté o no copiado `code_bytes`.
+    pub fn code_size(&self) -> usize {
+        self.code_ranges.iter().map(|&(_, size)| size).sum()
+    }
+}
+
 /// Una entrada de import: biblioteca + nombre de función.
 #[derive(Debug, Clone)]
 pub struct ImportEntry {
@@ -118,7 +134,7 @@ impl fmt::Display for BinaryInfo {
         writeln!(f, "  Size:          {} bytes", self.total_size)?;
         writeln!(f, "  Entry point:   0x{:08X}", self.entry_point)?;
         writeln!(f, "  Sections:      {}", self.sections.len())?;
-        writeln!(f, "  Code bytes:    {}", self.code_bytes.len())?;
+        writeln!(f, "  Code bytes:    {}", self.code_size())?;
         writeln!(f, "  RWX sections:  {}", self.rwx_count)?;
         if !self.imports.is_empty() {
             writeln!(f, "  Imports:       {}", self.imports.len())?;
@@ -140,25 +156,69 @@ pub struct BinaryLoader;
 impl BinaryLoader {
     /// Carga un binario desde un archivo y extrae su información.
     pub fn load_file(path: &Path) -> Result<BinaryInfo, String> {
-        let data =
-            std::fs::read(path).map_err(|e| format!("Cannot read '{}': {}", path.display(), e))?;
+        let data = MappedFile::open(path)?;
         let name = path.to_string_lossy().to_string();
         Self::load_bytes(&data, &name)
     }
 
+    /// Mapea un archivo y parsea su estructura sin copiar el código:
+    /// `code_bytes` queda vacío y `code_ranges` apunta dentro del mapeo.
+    pub fn map_file(path: &Path) -> Result<(MappedFile, BinaryInfo), String> {
+        let data = MappedFile::open(path)?;
+        let name = path.to_string_lossy().to_string();
+        let info = Self::parse(&data, &name, false);
+        Ok((data, info))
+    }
+
     /// Carga un binario desde bytes en memoria.
     pub fn load_bytes(data: &[u8], name: &str) -> Result<BinaryInfo, String> {
-        match goblin::Object::parse(data) {
-            Ok(goblin::Object::PE(pe)) => Ok(Self::load_pe(&pe, data, name)),
-            Ok(goblin::Object::Elf(elf)) => Ok(Self::load_elf(&elf, data, name)),
-            _ => Ok(Self::load_raw(data, name)),
+        Ok(Self::parse(data, name, true))
+    }
+
+    fn parse(data: &[u8], name: &str, copy_code: bool) -> BinaryInfo {
+        let mut info = match goblin::Object::parse(data) {
+            Ok(goblin::Object::PE(pe)) => Self::load_pe(&pe, data, name),
+            Ok(goblin::Object::Elf(elf)) => Self::load_elf(&elf, data, name),
+            _ => Self::load_raw(data, name),
+        };
+        if copy_code {
+            info.code_bytes.reserve_exact(info.code_size());
+            for &(offset, size) in &info.code_ranges {
+                info.code_bytes.extend_from_slice(&data[offset..offset + size]);
+            }
+        }
+        info
+    }
+
+    /// Divide los rangos ejecutables en chunks de ~`chunk_size` bytes para
+    /// escaneo paralelo. Los cortes son nominales: el analyzer los alinea
+    /// a fronteras de instrucción al fusionar (ver `BinaryGuardian`).
+    pub fn plan_chunks(info: &BinaryInfo, chunk_size: usize) -> Vec<CodeChunk> {
+        let chunk_size = chunk_size.max(CHUNK_SYNC_WINDOW * 2);
+        let mut chunks = Vec::new();
+        for (range, &(offset, size)) in info.code_ranges.iter().enumerate() {
+            let mut start = 0;
+            while start < size {
+                let end = (start + chunk_size).min(size);
+                // Evitar un chunk final más corto que la ventana de sincronización
+                let end = if size - end < CHUNK_SYNC_WINDOW { size } else { end };
+                chunks.push(CodeChunk {
+                    range,
+                    range_offset: offset,
+                    range_size: size,
+                    start,
+                    end,
+                });
+                start = end;
+            }
         }
+        chunks
     }
 
     /// Parsea un PE (Windows executable).
     fn load_pe(pe: &goblin::pe::PE, data: &[u8], name: &str) -> BinaryInfo {
         let mut sections = Vec::new();
-        let mut code_bytes = Vec::new();
+        let mut code_ranges = Vec::new();
         let mut rwx_count = 0;
         let header_size = pe
             .header
@@ -194,8 +254,8 @@ impl BinaryLoader {
             let size = section.size_of_raw_data as usize;
             let virtual_address = section.virtual_address as usize;
 
-            if executable && offset + size <= data.len() {
-                code_bytes.extend_from_slice(&data[offset..offset + size]);
+            if executable && size > 0 && offset + size <= data.len() {
+                code_ranges.push((offset, size));
             }
 
             sections.push(SectionInfo {
@@ -232,7 +292,8 @@ impl BinaryLoader {
             path: name.to_string(),
             format: BinaryFormat::PE,
             sections,
-            code_bytes,
+            code_bytes: Vec::new(),
+            code_ranges,
             total_size: data.len(),
             entry_point,
             rwx_count,
@@ -245,7 +306,7 @@ impl BinaryLoader {
     /// Parsea un ELF (Linux executable).
     fn load_elf(elf: &goblin::elf::Elf, data: &[u8], name: &str) -> BinaryInfo {
         let mut sections = Vec::new();
-        let mut code_bytes = Vec::new();
+        let mut code_ranges = Vec::new();
         let mut rwx_count = 0;
 
         // Estimate header size from first section offset
@@ -280,8 +341,8 @@ impl BinaryLoader {
             let virtual_address = sh.sh_addr as usize;
 
             if executable && sh.sh_type == goblin::elf::section_header::SHT_PROGBITS {
-                if offset + size <= data.len() {
-                    code_bytes.extend_from_slice(&data[offset..offset + size]);
+                if size > 0 && offset + size <= data.len() {
+                    code_ranges.push((offset, size));
                 }
             }
 
@@ -334,7 +395,8 @@ impl BinaryLoader {
             path: name.to_string(),
             format: BinaryFormat::ELF,
             sections,
-            code_bytes,
+            code_bytes: Vec::new(),
+            code_ranges,
             total_size: data.len(),
             entry_point,
             rwx_count,
@@ -359,7 +421,8 @@ impl BinaryLoader {
                 writable: false,
                 readable: true,
             }],
-            code_bytes: data.to_vec(),
+            code_bytes: Vec::new(),
+            code_ranges: if data.is_empty() { Vec::new() } else { vec![(0, data.len())] },
             total_size: data.len(),
             entry_point: 0,
             rwx_count: 0,
@@ -406,6 +469,192 @@ impl BinaryLoader {
     }
 }
 
+// ============================================================
+// Code chunks — unidades de escaneo paralelo
+// ============================================================
+
+/// Bytes que un chunk puede necesitar para resincronizar con la
+/// decodificación del chunk anterior (> instrucción x86 más larga, 15 B).
+pub const CHUNK_SYNC_WINDOW: usize = 16;
+
+/// Tamaño de chunk por defecto para el escaneo paralelo.
+pub const DEFAULT_CHUNK_SIZE: usize = 4 * 1024 * 1024;
+
+/// Un trozo contiguo de un rango ejecutable. `start..end` es relativo al
+/// rango; los saltos se resuelven dentro del rango completo.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct CodeChunk {
+    /// Índice en `BinaryInfo::code_ranges`
+    pub range: usize,
+    pub range_offset: usize,
+    pub range_size: usize,
+    pub start: usize,
+    pub end: usize,
+}
+
+impl CodeChunk {
+    /// Bytes del rango completo al que pertenece el chunk.
+    pub fn range_bytes<'a>(&self, data: &'a [u8]) -> &'a [u8] {
+        &data[self.range_offset..self.range_offset + self.range_size]
+    }
+}
+
+// ============================================================
+// MappedFile — archivo de solo lectura mapeado en memoria
+// ============================================================
+
+/// Archivo mapeado en memoria de solo lectura. Si el mapeo no es posible
+/// (archivo vacío, plataforma sin soporte) cae a una lectura normal.
+pub struct MappedFile {
+    ptr: *const u8,
+    len: usize,
+    owned: Vec<u8>,
+    #[cfg(windows)]
+    mapping: *mut std::ffi::c_void,
+}
+
+// El mapeo es de solo lectura y vive hasta Drop.
+unsafe impl Send for MappedFile {}
+unsafe impl Sync for MappedFile {}
+
+#[cfg(unix)]
+mod sys {
+    use std::ffi::c_void;
+    pub const PROT_READ: i32 = 1;
+    pub const MAP_PRIVATE: i32 = 2;
+    extern "C" {
+        pub fn mmap(addr: *mut c_void, len: usize, prot: i32, flags: i32, fd: i32, off: i64)
+            -> *mut c_void;
+        pub fn munmap(addr: *mut c_void, len: usize) -> i32;
+    }
+}
+
+#[cfg(windows)]
+mod sys {
+    use std::ffi::c_void;
+    pub const PAGE_READONLY: u32 = 0x02;
+    pub const FILE_MAP_READ: u32 = 0x04;
+    extern "system" {
+        pub fn CreateFileMappingW(
+            file: *mut c_void,
+            attrs: *mut c_void,
+            protect: u32,
+            size_high: u32,
+            size_low: u32,
+            name: *const u16,
+        ) -> *mut c_void;
+        pub fn MapViewOfFile(
+            mapping: *mut c_void,
+            access: u32,
+            offset_high: u32,
+            offset_low: u32,
+            bytes: usize,
+        ) -> *mut c_void;
+        pub fn UnmapViewOfFile(base: *const c_void) -> i32;
+        pub fn CloseHandle(handle: *mut c_void) -> i32;
+    }
+}
+
+impl MappedFile {
+    pub fn open(path: &Path) -> Result<Self, String> {
+        let err = |e: std::io::Error| format!("Cannot read '{}': {}", path.display(), e);
+        let file = File::open(path).map_err(err)?;
+        let len = file.metadata().map_err(err)?.len() as usize;
+        if len > 0 {
+            if let Some(mapped) = Self::map(&file, len) {
+                return Ok(mapped);
+            }
+        }
+        let owned = std::fs::read(path).map_err(err)?;
+        Ok(Self::from_vec(owned))
+    }
+
+    fn from_vec(owned: Vec<u8>) -> Self {
+        Self {
+            ptr: std::ptr::null(),
+            len: 0,
+            owned,
+            #[cfg(windows)]
+            mapping: std::ptr::null_mut(),
+        }
+    }
+
+    /// True si los bytes vienen de un mapeo (no de una copia en heap).
+    pub fn is_mapped(&self) -> bool {
+        !self.ptr.is_null()
+    }
+
+    #[cfg(unix)]
+    fn map(file: &File, len: usize) -> Option<Self> {
+        use std::os::unix::io::AsRawFd;
+        let ptr = unsafe {
+            sys::mmap(std::ptr::null_mut(), len, sys::PROT_READ, sys::MAP_PRIVATE, file.as_raw_fd(), 0)
+        };
+        if ptr as isize == -1 || ptr.is_null() {
+            return None;
+        }
+        Some(Self { ptr: ptr as *const u8, len, owned: Vec::new() })
+    }
+
+    #[cfg(windows)]
+    fn map(file: &File, len: usize) -> Option<Self> {
+        use std::os::windows::io::AsRawHandle;
+        unsafe {
+            let mapping = sys::CreateFileMappingW(
+                file.as_raw_handle() as *mut _,
+                std::ptr::null_mut(),
+                sys::PAGE_READONLY,
+                0,
+                0,
+                std::ptr::null(),
+            );
+            if mapping.is_null() {
+                return None;
+            }
+            let ptr = sys::MapViewOfFile(mapping, sys::FILE_MAP_READ, 0, 0, 0);
+            if ptr.is_null() {
+                sys::CloseHandle(mapping);
+                return None;
+            }
+            Some(Self { ptr: ptr as *const u8, len, owned: Vec::new(), mapping })
+        }
+    }
+
+    #[cfg(not(any(unix, windows)))]
+    fn map(_file: &File, _len: usize) -> Option<Self> {
+        None
+    }
+}
+
+impl Deref for MappedFile {
+    type Target = [u8];
+
+    fn deref(&self) -> &[u8] {
+        if self.ptr.is_null() {
+            &self.owned
+        } else {
+            unsafe { std::slice::from_raw_parts(self.ptr, self.len) }
+        }
+    }
+}
+
+impl Drop for MappedFile {
+    fn drop(&mut self) {
+        if self.ptr.is_null() {
+            return;
+        }
+        #[cfg(unix)]
+        unsafe {
+            sys::munmap(self.ptr as *mut _, self.len);
+        }
+        #[cfg(windows)]
+        unsafe {
+            sys::UnmapViewOfFile(self.ptr as *const _);
+            sys::CloseHandle(self.mapping);
+        }
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -437,6 +686,35 @@ mod tests {
         assert!(s.contains("test.bin"));
     }
 
+    #[test]
+    fn test_mapped_file_matches_read() {
+        let path = std::env::temp_dir().join(format!("bg_map_{}.bin", std::process::id()));
+        let data: Vec<u8> = (0..10_000u32).map(|i| (i * 7) as u8).collect();
+        std::fs::write(&path, &data).unwrap();
+        let mapped = MappedFile::open(&path).unwrap();
+        assert_eq!(&mapped[..], &data[..]);
+
+        let (_, info) = BinaryLoader::map_file(&path).unwrap();
+        assert!(info.code_bytes.is_empty());
+        assert_eq!(info.code_ranges, vec![(0, data.len())]);
+        assert_eq!(info.code_size(), data.len());
+        let _ = std::fs::remove_file(&path);
+    }
+
+    #[test]
+    fn test_plan_chunks_cover_ranges() {
+        let data = vec![0x90u8; 1000];
+        let info = BinaryLoader::load_bytes(&data, "nops.bin").unwrap();
+        let chunks = BinaryLoader::plan_chunks(&info, 256);
+        assert_eq!(chunks.first().unwrap().start, 0);
+        assert_eq!(chunks.last().unwrap().end, 1000);
+        for pair in chunks.windows(2) {
+            assert_eq!(pair[0].end, pair[1].start);
+        }
+        // 1000 = 256 * 3 + 232: el resto es mayor que la ventana, queda aparte
+        assert_eq!(chunks.len(), 4);
+    }
+
     #[test]
     fn test_validate_raw() {
         let data = vec![0x55, 0x48, 0x89, 0xE5, 0xC3];
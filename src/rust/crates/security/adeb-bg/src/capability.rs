@@ -13,7 +13,7 @@
 // ============================================================
 
 use super::arch_map::*;
-use crate::isa::{ADeadOp, CallTarget, Operand};
+use adeb_backend_x64::isa::{ADeadOp, CallTarget, Operand};
 
 /// Capability Mapper — Analiza ABIB IR y construye un Architecture Map.
 pub struct CapabilityMapper;
@@ -23,147 +23,151 @@ impl CapabilityMapper {
     /// ArchitectureMap completo. Single-pass, O(n).
     pub fn analyze(ops: &[ADeadOp]) -> ArchitectureMap {
         let mut map = ArchitectureMap::new();
-
         for (i, op) in ops.iter().enumerate() {
-            let class = Self::classify(op);
+            Self::record(&mut map, i, op);
+        }
+        map
+    }
 
-            // Instruction Map
-            map.instruction_map.total += 1;
-            match class {
-                InstructionClass::Safe => map.instruction_map.safe_count += 1,
-                InstructionClass::Restricted => {
-                    map.instruction_map.restricted_count += 1;
-                    map.instruction_map.flagged.push((i, class));
-                }
-                InstructionClass::Privileged => {
-                    map.instruction_map.privileged_count += 1;
-                    map.instruction_map.flagged.push((i, class));
-                }
+    /// Registra una instrucción (índice `i`) en el mapa. Permite construir
+    /// el mapa en streaming, sin materializar todo el vector de ops.
+    pub fn record(map: &mut ArchitectureMap, i: usize, op: &ADeadOp) {
+        let class = Self::classify(op);
+
+        // Instruction Map
+        map.instruction_map.total += 1;
+        match class {
+            InstructionClass::Safe => map.instruction_map.safe_count += 1,
+            InstructionClass::Restricted => {
+                map.instruction_map.restricted_count += 1;
+                map.instruction_map.flagged.push((i, class));
+            }
+            InstructionClass::Privileged => {
+                map.instruction_map.privileged_count += 1;
+                map.instruction_map.flagged.push((i, class));
             }
+        }
 
-            // Syscall Map
-            match op {
-                ADeadOp::Syscall => {
-                    map.syscall_map.syscall_count += 1;
-                    map.syscall_map.uses_syscall_instruction = true;
-                    map.syscall_map.call_sites.push(i);
-                }
-                ADeadOp::Int { vector } => {
-                    map.syscall_map.syscall_count += 1;
-                    if !map.syscall_map.interrupt_vectors.contains(vector) {
-                        map.syscall_map.interrupt_vectors.push(*vector);
-                    }
-                    map.syscall_map.call_sites.push(i);
+        // Syscall Map
+        match op {
+            ADeadOp::Syscall => {
+                map.syscall_map.syscall_count += 1;
+                map.syscall_map.uses_syscall_instruction = true;
+                map.syscall_map.call_sites.push(i);
+            }
+            ADeadOp::Int { vector } => {
+                map.syscall_map.syscall_count += 1;
+                if !map.syscall_map.interrupt_vectors.contains(vector) {
+                    map.syscall_map.interrupt_vectors.push(*vector);
                 }
-                _ => {}
+                map.syscall_map.call_sites.push(i);
             }
+            _ => {}
+        }
 
-            // IO Map
-            match op {
-                ADeadOp::InByte { port } => {
-                    map.io_map.accesses.push(IOAccess {
-                        port: Self::extract_static_port(port),
-                        direction: IODirection::In,
-                        instruction_index: i,
-                    });
-                }
-                ADeadOp::OutByte { port, .. } => {
-                    map.io_map.accesses.push(IOAccess {
-                        port: Self::extract_static_port(port),
-                        direction: IODirection::Out,
-                        instruction_index: i,
-                    });
-                }
-                _ => {}
+        // IO Map
+        match op {
+            ADeadOp::InByte { port } => {
+                map.io_map.accesses.push(IOAccess {
+                    port: Self::extract_static_port(port),
+                    direction: IODirection::In,
+                    instruction_index: i,
+                });
+            }
+            ADeadOp::OutByte { port, .. } => {
+                map.io_map.accesses.push(IOAccess {
+                    port: Self::extract_static_port(port),
+                    direction: IODirection::Out,
+                    instruction_index: i,
+                });
             }
+            _ => {}
+        }
 
-            // Control Flow Map
-            match op {
-                ADeadOp::Jmp { target: _ } => {
-                    map.control_flow_map.direct_jumps += 1;
-                }
-                ADeadOp::Jcc { cond: _, target: _ } => {
-                    map.control_flow_map.conditional_branches += 1;
+        // Control Flow Map
+        match op {
+            ADeadOp::Jmp { target: _ } => {
+                map.control_flow_map.direct_jumps += 1;
+            }
+            ADeadOp::Jcc { cond: _, target: _ } => {
+                map.control_flow_map.conditional_branches += 1;
+            }
+            ADeadOp::Call { target } => match target {
+                CallTarget::Relative(_) => {
+                    map.control_flow_map.direct_calls += 1;
                 }
-                ADeadOp::Call { target } => match target {
-                    CallTarget::Relative(_) => {
-                        map.control_flow_map.direct_calls += 1;
-                    }
-                    CallTarget::RipRelative(_) => {
-                        map.control_flow_map.indirect_calls += 1;
-                        map.control_flow_map.indirect_sites.push(i);
-                    }
-                    CallTarget::Name(_) => {
-                        map.control_flow_map.direct_calls += 1;
-                    }
-                    CallTarget::Register(_) => {
-                        map.control_flow_map.indirect_calls += 1;
-                        map.control_flow_map.indirect_sites.push(i);
-                    }
-                },
-                ADeadOp::CallIAT { .. } => {
+                CallTarget::RipRelative(_) => {
                     map.control_flow_map.indirect_calls += 1;
                     map.control_flow_map.indirect_sites.push(i);
                 }
-                ADeadOp::FarJmp { .. } => {
-                    map.control_flow_map.far_jumps += 1;
-                }
-                _ => {}
-            }
-
-            // Capability detection
-            match op {
-                ADeadOp::Cli | ADeadOp::Sti => {
-                    map.capabilities.interrupt_control = true;
-                    map.capabilities.privileged_instructions = true;
-                }
-                ADeadOp::Hlt => {
-                    map.capabilities.privileged_instructions = true;
-                }
-                ADeadOp::Lgdt { .. } | ADeadOp::Lidt { .. } => {
-                    map.capabilities.descriptor_table_access = true;
-                    map.capabilities.privileged_instructions = true;
-                }
-                ADeadOp::MovToCr { .. } | ADeadOp::MovFromCr { .. } => {
-                    map.capabilities.control_register_access = true;
-                    map.capabilities.privileged_instructions = true;
+                CallTarget::Name(_) => {
+                    map.control_flow_map.direct_calls += 1;
                 }
-                ADeadOp::Rdmsr | ADeadOp::Wrmsr => {
-                    map.capabilities.msr_access = true;
-                    map.capabilities.privileged_instructions = true;
-                }
-                ADeadOp::Invlpg { .. } => {
-                    map.capabilities.privileged_instructions = true;
-                }
-                ADeadOp::InByte { .. } | ADeadOp::OutByte { .. } => {
-                    map.capabilities.io_port_access = true;
-                    map.capabilities.privileged_instructions = true;
-                }
-                ADeadOp::Syscall => {
-                    map.capabilities.syscalls = true;
-                }
-                ADeadOp::Int { .. } => {
-                    map.capabilities.interrupts = true;
-                }
-                ADeadOp::Iret => {
-                    map.capabilities.privileged_instructions = true;
-                }
-                ADeadOp::FarJmp { .. } => {
-                    map.capabilities.far_jumps = true;
-                }
-                ADeadOp::CallIAT { .. } => {
-                    map.capabilities.indirect_control_flow = true;
-                }
-                ADeadOp::Call {
-                    target: CallTarget::RipRelative(_),
-                } => {
-                    map.capabilities.indirect_control_flow = true;
+                CallTarget::Register(_) | CallTarget::Mem { .. } => {
+                    map.control_flow_map.indirect_calls += 1;
+                    map.control_flow_map.indirect_sites.push(i);
                 }
-                _ => {}
+            },
+            ADeadOp::CallIAT { .. } => {
+                map.control_flow_map.indirect_calls += 1;
+                map.control_flow_map.indirect_sites.push(i);
+            }
+            ADeadOp::FarJmp { .. } => {
+                map.control_flow_map.far_jumps += 1;
             }
+            _ => {}
         }
 
-        map
+        // Capability detection
+        match op {
+            ADeadOp::Cli | ADeadOp::Sti => {
+                map.capabilities.interrupt_control = true;
+                map.capabilities.privileged_instructions = true;
+            }
+            ADeadOp::Hlt => {
+                map.capabilities.privileged_instructions = true;
+            }
+            ADeadOp::Lgdt { .. } | ADeadOp::Lidt { .. } => {
+                map.capabilities.descriptor_table_access = true;
+                map.capabilities.privileged_instructions = true;
+            }
+            ADeadOp::MovToCr { .. } | ADeadOp::MovFromCr { .. } => {
+                map.capabilities.control_register_access = true;
+                map.capabilities.privileged_instructions = true;
+            }
+            ADeadOp::Rdmsr | ADeadOp::Wrmsr => {
+                map.capabilities.msr_access = true;
+                map.capabilities.privileged_instructions = true;
+            }
+            ADeadOp::Invlpg { .. } => {
+                map.capabilities.privileged_instructions = true;
+            }
+            ADeadOp::InByte { .. } | ADeadOp::OutByte { .. } => {
+                map.capabilities.io_port_access = true;
+                map.capabilities.privileged_instructions = true;
+            }
+            ADeadOp::Syscall => {
+                map.capabilities.syscalls = true;
+            }
+            ADeadOp::Int { .. } => {
+                map.capabilities.interrupts = true;
+            }
+            ADeadOp::Iret => {
+                map.capabilities.privileged_instructions = true;
+            }
+            ADeadOp::FarJmp { .. } => {
+                map.capabilities.far_jumps = true;
+            }
+            ADeadOp::CallIAT { .. } => {
+                map.capabilities.indirect_control_flow = true;
+            }
+            ADeadOp::Call {
+                target: CallTarget::RipRelative(_),
+            } => {
+                map.capabilities.indirect_control_flow = true;
+            }
+            _ => {}
+        }
     }
 
     /// Clasifica una instrucción individual. Determinista, O(1).
@@ -208,7 +212,7 @@ impl CapabilityMapper {
 #[cfg(test)]
 mod tests {
     use super::*;
-    use crate::isa::*;
+    use adeb_backend_x64::isa::*;
 
     #[test]
     fn test_safe_program() {
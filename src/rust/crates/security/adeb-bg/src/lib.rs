@@ -1,13 +1,46 @@
-//! ADead-BIB Background Runtime
-//!
-//! Runtime para tareas en background: I/O asíncrono, timers, event loop.
+//! ADead-BIB Binary Guardian — análisis estático y seguridad a nivel ISA.
 
+// ============================================================
+// BG — Binary Guardian
+// ============================================================
+// Deterministic ISA-Level Capability Guardian
+//
+// No antivirus. No sandbox clásico. No heurísticas.
+// Arquitectura de control estructural.
+//
+//   Binary → ISA Decoder → ABIB IR → Capability Mapper
+//       → Architecture Map → Policy Engine → APPROVE / DENY
+//
+// ● Pre-execution: analiza una vez, genera mapa compacto.
+// ● Deterministic: mismo binario + misma policy = mismo resultado.
+// ● O(n) build, O(1) query.
+// ● Directo al ISA: no depende de lenguaje, formato, ni alto nivel.
+//
+// Diseñado para FastOS loader integration.
+//
+// Autor: Eddi Andreé Salazar Matos
+// Email: eddi.salazar.dev@gmail.com
+// ============================================================
+
+pub mod analysis_cache;
+pub mod analyzer;
+pub mod arch_map;
+pub mod binary_loader;
+pub mod capability;
+pub mod policy;
+
+// Re-exports — API ergonómica
+pub use analysis_cache::AnalysisCache;
+pub use analyzer::{AnalysisResult, BinaryGuardian, ScanOptions};
+pub use arch_map::{ArchitectureMap, Capabilities, InstructionClass};
+pub use binary_loader::{BinaryInfo, BinaryLoader, CodeChunk, MappedFile, SectionInfo, SectionKind};
+pub use capability::CapabilityMapper;
+pub use policy::{
+    PolicyEngine, SecurityLevel, SecurityPolicy, Verdict, Violation, ViolationType, POLICY_VERSION,
+};
+
+// Background runtime (stubs): I/O asíncrono, timers, event loop
+pub mod io;
 pub mod runtime;
 pub mod task;
 pub mod timer;
-pub mod io;
-
-pub use runtime::*;
-pub use task::*;
-pub use timer::*;
-pub use io::*;
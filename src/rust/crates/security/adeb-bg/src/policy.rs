@@ -19,6 +19,11 @@
 use super::arch_map::*;
 use std::fmt;
 
+/// Versión de las reglas de clasificación y de policy. Subirla cuando
+/// cambie qué se marca o cómo: invalida los análisis cacheados
+/// (ver `analysis_cache`).
+pub const POLICY_VERSION: u32 = 1;
+
 // ============================================================
 // Security Level (mapea a CPU rings)
 // ============================================================
@@ -72,6 +77,9 @@ pub struct SecurityPolicy {
     pub require_structural_integrity: bool,
     /// Permitir APIs de inyección de proceso
     pub allow_process_injection: bool,
+    /// Cortar el análisis en la primera violación dura (veredicto con una
+    /// sola violación y mapa parcial). Útil en el loader: DENY lo antes posible.
+    pub stop_on_first_violation: bool,
 }
 
 impl SecurityPolicy {
@@ -88,6 +96,7 @@ impl SecurityPolicy {
             allow_far_jumps: true,
             require_structural_integrity: false,
             allow_process_injection: true,
+            stop_on_first_violation: false,
         }
     }
 
@@ -104,6 +113,7 @@ impl SecurityPolicy {
             allow_far_jumps: false,
             require_structural_integrity: true,
             allow_process_injection: false,
+            stop_on_first_violation: false,
         }
     }
 
@@ -120,6 +130,7 @@ impl SecurityPolicy {
             allow_far_jumps: false,
             require_structural_integrity: true,
             allow_process_injection: false,
+            stop_on_first_violation: false,
         }
     }
 
@@ -136,6 +147,7 @@ impl SecurityPolicy {
             allow_far_jumps: false,
             require_structural_integrity: true,
             allow_process_injection: false,
+            stop_on_first_violation: false,
         }
     }
 
@@ -152,6 +164,7 @@ impl SecurityPolicy {
             allow_far_jumps: false,
             require_structural_integrity: true,
             allow_process_injection: false,
+            stop_on_first_violation: false,
         }
     }
 
@@ -168,8 +181,15 @@ impl SecurityPolicy {
             allow_far_jumps: false,
             require_structural_integrity: true,
             allow_process_injection: false,
+            stop_on_first_violation: false,
         }
     }
+
+    /// Misma policy, pero deteniéndose en la primera violación dura.
+    pub fn fail_fast(mut self) -> Self {
+        self.stop_on_first_violation = true;
+        self
+    }
 }
 
 impl fmt::Display for SecurityPolicy {
@@ -306,8 +326,10 @@ pub struct PolicyEngine;
 impl PolicyEngine {
     /// Evalúa el architecture map de un binario contra una policy.
     /// Retorna APPROVED o DENIED con lista de violaciones específicas.
+    /// Con `stop_on_first_violation` se detiene en la primera violación.
     pub fn evaluate(map: &ArchitectureMap, policy: &SecurityPolicy) -> Verdict {
         let mut violations = Vec::new();
+        let stop = policy.stop_on_first_violation;
 
         match policy.level {
             SecurityLevel::Kernel => {
@@ -325,20 +347,23 @@ impl PolicyEngine {
         }
 
         // Checks universales (aplican a todos los niveles excepto Kernel)
-        if policy.level != SecurityLevel::Kernel {
+        if policy.level != SecurityLevel::Kernel && !(stop && !violations.is_empty()) {
             Self::check_universal(map, policy, &mut violations);
         }
 
         // Checks de integridad estructural — NUEVO
-        if policy.require_structural_integrity {
+        if policy.require_structural_integrity && !(stop && !violations.is_empty()) {
             Self::check_structural_integrity(map, &mut violations);
         }
 
         // Checks de imports — NUEVO
-        if !policy.allow_process_injection {
+        if !policy.allow_process_injection && !(stop && !violations.is_empty()) {
             Self::check_import_violations(map, &mut violations);
         }
 
+        if stop {
+            violations.truncate(1);
+        }
         if violations.is_empty() {
             Verdict::Approved
         } else {
@@ -346,6 +371,21 @@ impl PolicyEngine {
         }
     }
 
+    /// True si el mapa (aunque sea parcial) ya contiene una violación
+    /// dura: una que ninguna instrucción posterior puede revertir. El
+    /// escáner la consulta para abandonar el resto del binario.
+    pub fn has_hard_violation(map: &ArchitectureMap, policy: &SecurityPolicy) -> bool {
+        let caps = &map.capabilities;
+        let level = match policy.level {
+            SecurityLevel::Kernel => false,
+            SecurityLevel::Driver => {
+                caps.control_register_access || caps.msr_access || caps.descriptor_table_access
+            }
+            SecurityLevel::Service | SecurityLevel::User => caps.privileged_instructions,
+        };
+        level || (policy.level != SecurityLevel::Kernel && !policy.allow_far_jumps && caps.far_jumps)
+    }
+
     /// Infiere el nivel de seguridad mínimo requerido para ejecutar un binario.
     pub fn infer_minimum_level(map: &ArchitectureMap) -> SecurityLevel {
         if map.capabilities.requires_kernel() {
@@ -561,8 +601,8 @@ impl PolicyEngine {
 #[cfg(test)]
 mod tests {
     use super::*;
-    use crate::bg::capability::CapabilityMapper;
-    use crate::isa::*;
+    use crate::capability::CapabilityMapper;
+    use adeb_backend_x64::isa::*;
 
     #[test]
     fn test_safe_approved() {
@@ -665,6 +705,22 @@ mod tests {
             .any(|v| v.kind == ViolationType::ProcessInjectionImports));
     }
 
+    #[test]
+    fn test_fail_fast_single_violation() {
+        let ops = vec![ADeadOp::Cli, ADeadOp::Rdmsr, ADeadOp::Hlt];
+        let map = CapabilityMapper::analyze(&ops);
+        let full = PolicyEngine::evaluate(&map, &SecurityPolicy::user());
+        assert!(full.violation_count() > 1);
+
+        let fast = SecurityPolicy::user().fail_fast();
+        assert!(PolicyEngine::has_hard_violation(&map, &fast));
+        let verdict = PolicyEngine::evaluate(&map, &fast);
+        assert_eq!(verdict.violation_count(), 1);
+        assert_eq!(verdict.violations()[0].kind, ViolationType::PrivilegedInstruction);
+
+        assert!(!PolicyEngine::has_hard_violation(&map, &SecurityPolicy::kernel()));
+    }
+
     #[test]
     fn test_kernel_allows_everything() {
         let ops = vec![ADeadOp::Ret];
@@ -4,8 +4,10 @@
 // Use unified type system
 pub use super::types::RegSize;
 pub use super::types::Type;
+use serde::{Deserialize, Serialize};
+use std::collections::{BTreeMap, BTreeSet};
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub enum Expr {
     Number(i64),
     Float(f64),
@@ -52,6 +54,14 @@ pub enum Expr {
         method: String,
         args: Vec<Expr>,
     },
+    /// Llamada virtual que no se pudo devirtualizar: `object` evalúa al
+    /// puntero `this` (vptr en el offset 0) y se llama a la entrada
+    /// `slot` de su vtable
+    VirtualCall {
+        object: Box<Expr>,
+        slot: u32,
+        args: Vec<Expr>,
+    },
     FieldAccess {
         object: Box<Expr>,
         field: String,
@@ -173,14 +183,14 @@ pub enum Expr {
 }
 
 /// Argumento de sizeof
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub enum SizeOfArg {
     Type(Type),
     Expr(Expr),
 }
 
 /// Operadores bitwise
-#[derive(Debug, Clone, Copy, PartialEq)]
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
 pub enum BitwiseOp {
     And,        // &
     Or,         // |
@@ -189,7 +199,7 @@ pub enum BitwiseOp {
     RightShift, // >>
 }
 
-#[derive(Debug, Clone, Copy, PartialEq)]
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
 pub enum BinOp {
     Add,
     Sub,
@@ -200,13 +210,13 @@ pub enum BinOp {
     Or,
 }
 
-#[derive(Debug, Clone, Copy, PartialEq)]
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
 pub enum UnaryOp {
     Neg,
     Not,
 }
 
-#[derive(Debug, Clone, Copy, PartialEq)]
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
 pub enum CmpOp {
     Eq, // ==
     Ne, // !=
@@ -216,7 +226,7 @@ pub enum CmpOp {
     Ge, // >=
 }
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub enum Stmt {
     Print(Expr),
     Println(Expr), // println con \n automático
@@ -440,7 +450,7 @@ pub enum Stmt {
 }
 
 /// Case de switch
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct SwitchCase {
     pub value: Expr,
     pub body: Vec<Stmt>,
@@ -448,7 +458,7 @@ pub struct SwitchCase {
 }
 
 /// Operadores de asignación compuesta
-#[derive(Debug, Clone, Copy, PartialEq)]
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
 pub enum CompoundOp {
     AddAssign, // +=
     SubAssign, // -=
@@ -462,7 +472,7 @@ pub enum CompoundOp {
     ShrAssign, // >>=
 }
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Param {
     pub name: String,
     pub param_type: Type,            // Unified type (always present)
@@ -496,7 +506,7 @@ impl Param {
 }
 
 /// Atributos de función para OS-level (v3.1-OS)
-#[derive(Debug, Clone, Default)]
+#[derive(Debug, Clone, Default, Serialize, Deserialize)]
 pub struct FunctionAttributes {
     /// @interrupt — auto push/pop registers + iretq
     pub is_interrupt: bool,
@@ -506,9 +516,13 @@ pub struct FunctionAttributes {
     pub is_naked: bool,
     /// @export("C") — C-compatible symbol name
     pub export_name: Option<String>,
+    /// Instancia de template: el backend puede plegarla con otra de
+    /// cuerpo idéntico (identical-code folding)
+    #[serde(default)]
+    pub foldable: bool,
 }
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Function {
     pub name: String,
     pub params: Vec<Param>,
@@ -519,13 +533,13 @@ pub struct Function {
 }
 
 // OOP: Interface/Trait
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Interface {
     pub name: String,
     pub methods: Vec<MethodSignature>,
 }
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct MethodSignature {
     pub name: String,
     pub params: Vec<Param>,
@@ -534,7 +548,7 @@ pub struct MethodSignature {
 }
 
 // OOP: Clase con herencia y polimorfismo
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Class {
     pub name: String,
     pub parent: Option<String>,  // Herencia
@@ -545,7 +559,7 @@ pub struct Class {
     pub destructor: Option<Method>,  // __del__
 }
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Field {
     pub name: String,
     pub type_name: Option<String>,
@@ -553,7 +567,7 @@ pub struct Field {
     pub default_value: Option<Expr>,
 }
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Method {
     pub name: String,
     pub params: Vec<Param>,
@@ -566,7 +580,7 @@ pub struct Method {
 }
 
 // Rust-style struct
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Struct {
     pub name: String,
     pub fields: Vec<StructField>,
@@ -576,7 +590,7 @@ pub struct Struct {
     pub is_union: bool,
 }
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct StructField {
     pub name: String,
     pub field_type: Type,
@@ -584,7 +598,7 @@ pub struct StructField {
 }
 
 // Rust-style impl block
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Impl {
     pub struct_name: String,
     pub trait_name: Option<String>, // Some("TraitName") for `impl Trait for Struct`
@@ -592,13 +606,13 @@ pub struct Impl {
 }
 
 // Trait definition (v1.6.0)
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Trait {
     pub name: String,
     pub methods: Vec<TraitMethod>,
 }
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct TraitMethod {
     pub name: String,
     pub params: Vec<Param>,
@@ -608,7 +622,7 @@ pub struct TraitMethod {
 }
 
 // Sistema de imports
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Import {
     pub module: String,
     pub items: Vec<String>,    // from module import item1, item2
@@ -616,15 +630,28 @@ pub struct Import {
 }
 
 /// Atributos de programa (#![...])
-#[derive(Debug, Clone, Default)]
+#[derive(Debug, Clone, Default, Serialize, Deserialize)]
 pub struct ProgramAttributes {
     pub mode: OutputMode,          // #![mode(raw|pe|elf)]
     pub base_address: Option<u64>, // #![base(0x1000)]
     pub clean_level: CleanLevel,   // #![clean(normal|aggressive|none)]
     pub cpu_mode: CpuModeAttr,     // #![cpu(real16|protected32|long64)]
+    /// alignas(N) / __declspec(align(N)) de globals: nombre → bytes
+    #[serde(default)]
+    pub global_align: BTreeMap<String, u64>,
+    /// -g: fichero fuente de cada función (nombre → ruta)
+    #[serde(default)]
+    pub source_files: BTreeMap<String, String>,
+    /// Funciones y globals `static` de la TU: el link multi-TU los
+    /// renombra para que no choquen con los de otra TU
+    pub internal_symbols: BTreeSet<String>,
+    /// Definiciones externas de la TU (funciones con cuerpo, globals
+    /// con inicializador): otra TU con el mismo nombre es un error de
+    /// link. Vacío = todo se puede repetir (inline y templates de C++)
+    pub external_definitions: BTreeSet<String>,
 }
 
-#[derive(Debug, Clone, Default, PartialEq)]
+#[derive(Debug, Clone, Default, PartialEq, Serialize, Deserialize)]
 pub enum OutputMode {
     #[default]
     PE, // Windows PE (default)
@@ -634,7 +661,7 @@ pub enum OutputMode {
 }
 
 /// CPU mode attribute for OS-level code generation
-#[derive(Debug, Clone, Default, PartialEq)]
+#[derive(Debug, Clone, Default, PartialEq, Serialize, Deserialize)]
 pub enum CpuModeAttr {
     Real16,      // 16-bit real mode (boot sector)
     Protected32, // 32-bit protected mode
@@ -642,7 +669,7 @@ pub enum CpuModeAttr {
     Long64, // 64-bit long mode (default)
 }
 
-#[derive(Debug, Clone, Default, PartialEq)]
+#[derive(Debug, Clone, Default, PartialEq, Serialize, Deserialize)]
 pub enum CleanLevel {
     #[default]
     Normal,
@@ -650,7 +677,7 @@ pub enum CleanLevel {
     None,
 }
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Program {
     pub attributes: ProgramAttributes, // Atributos del programa
     pub imports: Vec<Import>,
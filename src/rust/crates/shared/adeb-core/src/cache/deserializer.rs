@@ -123,6 +123,13 @@ pub fn deserialize(bytes: &[u8]) -> Result<ADeadCache, DeserializeError> {
     // Hash
     let hash = read_u64(bytes, &mut pos)?;
 
+    // Dependencies
+    let deps_count = read_u32(bytes, &mut pos)? as usize;
+    let mut dependencies = Vec::with_capacity(deps_count.min(bytes.len() / 4));
+    for _ in 0..deps_count {
+        dependencies.push(read_string(bytes, &mut pos)?);
+    }
+
     // AST data
     let ast_len = read_u32(bytes, &mut pos)? as usize;
     if pos + ast_len > bytes.len() {
@@ -245,6 +252,7 @@ pub fn deserialize(bytes: &[u8]) -> Result<ADeadCache, DeserializeError> {
         version,
         timestamp,
         hash,
+        dependencies,
         ast_data,
         types,
         symbols,
@@ -266,12 +274,14 @@ mod tests {
 
     #[test]
     fn test_roundtrip() {
-        let cache = ADeadCache::new(0xCAFEBABE);
+        let mut cache = ADeadCache::new(0xCAFEBABE);
+        cache.dependencies = vec!["common.h".to_string(), "inc/types.h".to_string()];
         let bytes = serializer::serialize(&cache);
         let result = deserialize(&bytes);
         assert!(result.is_ok());
         let loaded = result.unwrap();
         assert_eq!(loaded.hash, 0xCAFEBABE);
+        assert_eq!(loaded.dependencies, cache.dependencies);
         assert!(loaded.is_valid());
     }
 
@@ -36,6 +36,12 @@ pub fn hash_files(paths: &[&str]) -> Result<u64, std::io::Error> {
     Ok(combined)
 }
 
+/// Hash de un conjunto de archivos mezclado con un salt (versión del
+/// compilador, flags): cambiar cualquiera de los dos invalida
+pub fn hash_closure(paths: &[&str], salt: &str) -> Result<u64, std::io::Error> {
+    Ok(hash_files(paths)? ^ hash_bytes(salt.as_bytes()).rotate_left(1))
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
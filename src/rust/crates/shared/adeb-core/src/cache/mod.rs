@@ -3,21 +3,51 @@
 // ============================================================
 // Precompiled cache that eliminates repeated header parsing.
 // fastos.bib stores: AST, TypeTable, SymbolTable, UB reports.
+// Un header precompilado (adB cc --pch) guarda además la lista de
+// archivos que incluye: el hash cubre todos, no solo el header.
 // Cache hit = nanosegundos. Cache miss = compile + generate cache.
 // ============================================================
 
 pub mod deserializer;
 pub mod hasher;
+pub mod objects;
 pub mod serializer;
 pub mod validator;
 
 use std::collections::HashMap;
+use std::sync::OnceLock;
 
 /// Magic bytes for fastos.bib: "ADEAD.BI"
 pub const CACHE_MAGIC: [u8; 8] = *b"ADEAD.BI";
 
 /// Version del formato de cache
-pub const CACHE_VERSION: u32 = 2;
+pub const CACHE_VERSION: u32 = 3;
+
+/// Version de la forma serializada de lo que guardan los caches de
+/// objetos y de headers (`Program`, AST de C). Subirla cuando cambien sus
+/// campos: una entrada vieja deja de coincidir en vez de leerse a medias.
+pub const FORMAT_VERSION: u32 = 1;
+
+/// Identidad del compilador para las claves de cache: version del
+/// paquete, `FORMAT_VERSION` y el ejecutable (tamaño + mtime), para que
+/// un build distinto del compilador no reutilice objetos de otro
+pub fn build_id() -> &'static str {
+    static ID: OnceLock<String> = OnceLock::new();
+    ID.get_or_init(|| {
+        let exe = std::env::current_exe()
+            .and_then(std::fs::metadata)
+            .map(|meta| {
+                let mtime = meta
+                    .modified()
+                    .ok()
+                    .and_then(|t| t.duration_since(std::time::UNIX_EPOCH).ok())
+                    .map_or(0, |d| d.as_nanos());
+                format!("{:x}.{:x}", meta.len(), mtime)
+            })
+            .unwrap_or_default();
+        format!("{}-f{}-{}", env!("CARGO_PKG_VERSION"), FORMAT_VERSION, exe)
+    })
+}
 
 /// Estructura principal del cache — fastos.bib
 #[derive(Debug, Clone)]
@@ -30,6 +60,9 @@ pub struct ADeadCache {
     pub timestamp: u64,
     /// Hash del header source — si cambia, cache invalido
     pub hash: u64,
+    /// Archivos cubiertos por `hash` (closure de includes de un header de
+    /// usuario); vacío para los headers built-in
+    pub dependencies: Vec<String>,
     /// AST serializado (tipos resueltos)
     pub ast_data: Vec<u8>,
     /// Tabla de tipos resueltos
@@ -52,6 +85,7 @@ impl ADeadCache {
                 .unwrap_or_default()
                 .as_secs(),
             hash,
+            dependencies: Vec::new(),
             ast_data: Vec::new(),
             types: TypeTable::new(),
             symbols: SymbolTable::new(),
@@ -207,6 +241,13 @@ mod tests {
         assert_eq!(cache.magic, CACHE_MAGIC);
     }
 
+    #[test]
+    fn test_build_id_carries_format_version() {
+        let id = build_id();
+        assert!(id.starts_with(&format!("{}-f{}-", env!("CARGO_PKG_VERSION"), FORMAT_VERSION)), "{}", id);
+        assert!(std::ptr::eq(id, build_id()));
+    }
+
     #[test]
     fn test_type_table() {
         let mut table = TypeTable::new();
@@ -0,0 +1,184 @@
+// ============================================================
+// Object Cache — per-TU intermediate objects on disk
+// ============================================================
+// Cada translation unit compilada se guarda como un blob keyed
+// por el hash de su contenido. Si el hash no cambia, el driver
+// reutiliza el objeto y se salta preprocessor/lexer/parser/UB.
+// El formato del blob lo define quien lo escribe (el driver).
+//
+// Un proceso largo (`adB serve`) puede dejar los objetos residentes:
+// cada uno se lee del disco una vez y los siguientes builds lo toman de
+// memoria. La clave ya es el hash del contenido, así que nunca caduca.
+// ============================================================
+
+use std::cell::RefCell;
+use std::collections::HashMap;
+use std::fs;
+use std::io;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, OnceLock};
+
+/// Directorio por defecto del cache de objetos (relativo al cwd)
+pub const DEFAULT_OBJECT_CACHE_DIR: &str = ".adB-cache";
+
+/// Extension de los objetos cacheados
+pub const OBJECT_EXTENSION: &str = "tuo";
+
+static RESIDENT: AtomicBool = AtomicBool::new(false);
+
+/// Sufijo de cada temporal de `store`: dos hilos del mismo proceso que
+/// escriben la misma clave no comparten el archivo a medias
+static TMP_SEQ: AtomicU64 = AtomicU64::new(0);
+
+thread_local! {
+    /// Directorio fijado por [`with_dir`] para el hilo actual
+    static SCOPED_DIR: RefCell<Option<PathBuf>> = const { RefCell::new(None) };
+}
+
+fn resident() -> &'static Mutex<HashMap<PathBuf, Arc<[u8]>>> {
+    static OBJECTS: OnceLock<Mutex<HashMap<PathBuf, Arc<[u8]>>>> = OnceLock::new();
+    OBJECTS.get_or_init(|| Mutex::new(HashMap::new()))
+}
+
+/// Mantiene en memoria los objetos leídos y escritos desde ahora
+pub fn keep_resident() {
+    RESIDENT.store(true, Ordering::Relaxed);
+}
+
+/// Corre `f` con `from_env` apuntando a `dir` en este hilo: un servidor
+/// atiende a clientes con distinto cwd / `ADEB_CACHE_DIR`
+pub fn with_dir<R>(dir: impl Into<PathBuf>, f: impl FnOnce() -> R) -> R {
+    struct Restore(Option<PathBuf>);
+    impl Drop for Restore {
+        fn drop(&mut self) {
+            SCOPED_DIR.with(|d| *d.borrow_mut() = self.0.take());
+        }
+    }
+    let _restore = Restore(SCOPED_DIR.with(|d| d.borrow_mut().replace(dir.into())));
+    f()
+}
+
+/// Cache de objetos por translation unit
+#[derive(Debug, Clone)]
+pub struct ObjectCache {
+    dir: PathBuf,
+}
+
+impl ObjectCache {
+    pub fn new(dir: impl Into<PathBuf>) -> Self {
+        Self { dir: dir.into() }
+    }
+
+    /// Cache en `ADEB_CACHE_DIR` si está definido, si no `.adB-cache/`
+    /// (dentro de [`with_dir`], el directorio fijado)
+    pub fn from_env() -> Self {
+        if let Some(dir) = SCOPED_DIR.with(|d| d.borrow().clone()) {
+            return Self::new(dir);
+        }
+        match std::env::var("ADEB_CACHE_DIR") {
+            Ok(dir) if !dir.is_empty() => Self::new(dir),
+            _ => Self::new(DEFAULT_OBJECT_CACHE_DIR),
+        }
+    }
+
+    pub fn dir(&self) -> &Path {
+        &self.dir
+    }
+
+    /// Ruta del objeto para una clave
+    pub fn path_for(&self, key: u64) -> PathBuf {
+        self.dir.join(format!("{:016x}.{}", key, OBJECT_EXTENSION))
+    }
+
+    /// Lee el objeto cacheado, `None` si no existe o no se puede leer
+    pub fn load(&self, key: u64) -> Option<Vec<u8>> {
+        let path = self.path_for(key);
+        if !RESIDENT.load(Ordering::Relaxed) {
+            return fs::read(path).ok();
+        }
+        if let Some(bytes) = resident().lock().unwrap().get(&path) {
+            return Some(bytes.to_vec());
+        }
+        let bytes = fs::read(&path).ok()?;
+        resident().lock().unwrap().insert(path, bytes.as_slice().into());
+        Some(bytes)
+    }
+
+    /// Escribe el objeto (tmp + rename: un build interrumpido nunca deja
+    /// un objeto a medias que parezca válido)
+    pub fn store(&self, key: u64, bytes: &[u8]) -> io::Result<()> {
+        fs::create_dir_all(&self.dir)?;
+        let path = self.path_for(key);
+        let seq = TMP_SEQ.fetch_add(1, Ordering::Relaxed);
+        let tmp = path.with_extension(format!("{}.tmp{}-{}", OBJECT_EXTENSION, std::process::id(), seq));
+        fs::write(&tmp, bytes)?;
+        fs::rename(&tmp, &path)?;
+        if RESIDENT.load(Ordering::Relaxed) {
+            resident().lock().unwrap().insert(path, bytes.into());
+        }
+        Ok(())
+    }
+}
+
+/// Clave de un objeto: hash del contenido del TU combinado con un salt
+/// (versión del compilador, flags) para que cambiar de flags invalide.
+pub fn object_key(path: &str, salt: &str) -> io::Result<u64> {
+    super::hasher::hash_closure(&[path], salt)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_store_and_load() {
+        let dir = std::env::temp_dir().join(format!("adeb_objcache_{}", std::process::id()));
+        let cache = ObjectCache::new(&dir);
+        assert!(cache.load(42).is_none());
+        cache.store(42, b"object").unwrap();
+        assert_eq!(cache.load(42).as_deref(), Some(&b"object"[..]));
+        let _ = fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_concurrent_stores_of_one_key() {
+        let dir = std::env::temp_dir().join(format!("adeb_objcache_race_{}", std::process::id()));
+        let cache = ObjectCache::new(&dir);
+        std::thread::scope(|s| {
+            for t in 0..8u8 {
+                let cache = &cache;
+                s.spawn(move || {
+                    for _ in 0..50 {
+                        cache.store(7, &[t; 4096]).unwrap();
+                    }
+                });
+            }
+        });
+        // Gana el último rename, siempre un objeto entero
+        let bytes = cache.load(7).unwrap();
+        assert_eq!(bytes.len(), 4096);
+        assert!(bytes.iter().all(|&b| b == bytes[0]));
+        let leftovers = fs::read_dir(&dir).unwrap().count();
+        assert_eq!(leftovers, 1);
+        let _ = fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_scoped_dir() {
+        let dir = std::env::temp_dir().join("adeb_objcache_scoped");
+        let inside = with_dir(&dir, || ObjectCache::from_env().dir().to_path_buf());
+        assert_eq!(inside, dir);
+        assert_ne!(ObjectCache::from_env().dir(), dir.as_path());
+    }
+
+    #[test]
+    fn test_object_key_depends_on_salt() {
+        let path = std::env::temp_dir().join(format!("adeb_objkey_{}.c", std::process::id()));
+        fs::write(&path, "int main() { return 0; }").unwrap();
+        let p = path.to_str().unwrap();
+        assert_eq!(object_key(p, "a").unwrap(), object_key(p, "a").unwrap());
+        assert_ne!(object_key(p, "a").unwrap(), object_key(p, "b").unwrap());
+        let _ = fs::remove_file(&path);
+    }
+}
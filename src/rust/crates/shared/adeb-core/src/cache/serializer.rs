@@ -27,6 +27,12 @@ pub fn serialize(cache: &ADeadCache) -> Vec<u8> {
     // Hash (8 bytes)
     bytes.extend_from_slice(&cache.hash.to_le_bytes());
 
+    // Dependencies: count + paths
+    bytes.extend_from_slice(&(cache.dependencies.len() as u32).to_le_bytes());
+    for path in &cache.dependencies {
+        write_string(&mut bytes, path);
+    }
+
     // AST data length + data
     let ast_len = cache.ast_data.len() as u32;
     bytes.extend_from_slice(&ast_len.to_le_bytes());
@@ -126,8 +132,8 @@ mod tests {
     fn test_serialize_header() {
         let cache = ADeadCache::new(0xDEADBEEF);
         let bytes = serialize(&cache);
-        // Minimum: 8 (magic) + 4 (version) + 8 (timestamp) + 8 (hash) + 4 (ast_len) + 4+4+4 (counts)
-        assert!(bytes.len() >= 44);
+        // Minimum: 8 (magic) + 4 (version) + 8 (timestamp) + 8 (hash) + 4 (deps) + 4 (ast_len) + 4+4+4 (counts)
+        assert!(bytes.len() >= 48);
         assert_eq!(&bytes[0..8], b"ADEAD.BI");
     }
 }
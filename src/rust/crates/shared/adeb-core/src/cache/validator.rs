@@ -5,6 +5,8 @@
 //   fastos.bib existe?
 //     SI: hash(header) == cache.hash? -> CACHE HIT (nanosegundos)
 //     NO: CACHE MISS -> recompila -> genera cache
+// Con dependencias (header precompilado) el hash se recalcula sobre
+// todos los archivos de `cache.dependencies`.
 // ============================================================
 
 use super::hasher;
@@ -60,6 +62,16 @@ pub fn validate_file(cache_path: &str, header_path: &str) -> CacheStatus {
     validate(&cache, current_hash)
 }
 
+/// Valida un cache cuyo hash cubre `cache.dependencies` mezclado con
+/// `salt` (ver `hasher::hash_closure`). Si falta un archivo, es Stale.
+pub fn validate_dependencies(cache: &ADeadCache, salt: &str) -> CacheStatus {
+    let paths: Vec<&str> = cache.dependencies.iter().map(String::as_str).collect();
+    match hasher::hash_closure(&paths, salt) {
+        Ok(h) => validate(cache, h),
+        Err(_) => CacheStatus::Stale,
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -76,6 +88,23 @@ mod tests {
         assert_eq!(validate(&cache, 0xDEADBEEF), CacheStatus::Stale);
     }
 
+    #[test]
+    fn test_dependencies_stale_on_edit() {
+        let dir = std::env::temp_dir().join(format!("adeb_deps_{}", std::process::id()));
+        std::fs::create_dir_all(&dir).unwrap();
+        let header = dir.join("common.h");
+        std::fs::write(&header, "int f(void);").unwrap();
+        let path = header.to_str().unwrap();
+
+        let mut cache = ADeadCache::new(hasher::hash_closure(&[path], "salt").unwrap());
+        cache.dependencies = vec![path.to_string()];
+        assert_eq!(validate_dependencies(&cache, "salt"), CacheStatus::Hit);
+        assert_eq!(validate_dependencies(&cache, "other"), CacheStatus::Stale);
+        std::fs::write(&header, "int f(int);").unwrap();
+        assert_eq!(validate_dependencies(&cache, "salt"), CacheStatus::Stale);
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
     #[test]
     fn test_cache_corrupt() {
         let mut cache = ADeadCache::new(0x12345678);
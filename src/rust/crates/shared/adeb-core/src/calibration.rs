@@ -0,0 +1,340 @@
+// ADead-BIB - Calibración del cost model CPU↔GPU
+// Microbenchmarks en el primer arranque, persistidos por máquina
+//
+// Los umbrales fijos (1M elementos, GFLOPS teóricos) eligen la GPU en
+// tamaños donde la latencia de lanzamiento y el PCIe pierden. Aquí se
+// mide lo que de verdad cuesta cada lado:
+//
+//   CPU: GFLOP/s por operación (vector_add, saxpy, reduction, matmul)
+//   GPU: latencia de lanzar + sincronizar un kernel vacío, y ancho de
+//        banda host↔device (lo mide un GpuProbe del backend)
+//
+// y el crossover es directo: GPU si launch + bytes/bw + flops/gflops
+// es menor que flops/cpu_gflops. El resultado va a
+// `<ADEB_CACHE_DIR o .adB-cache>/calibration/<huella>.json`; la huella
+// incluye CPU y GPU, así que cambiar de hardware recalibra.
+// ADEB_RECALIBRATE=1 fuerza una calibración nueva.
+//
+// Solo mide y persiste: ningún camino compilado elige CPU o GPU con
+// `prefers_gpu` todavía (AutoDispatcher y UnifiedPipeline viven en
+// módulos que no se compilan). Vive fuera de runtime/ para compilar
+// sin la detección de hardware: quien la llama pasa la huella ya
+// armada con `machine_id`.
+
+use crate::cache::hasher::hash_bytes;
+use crate::cache::objects::ObjectCache;
+use serde::{Deserialize, Serialize};
+use std::collections::BTreeMap;
+use std::hint::black_box;
+use std::io;
+use std::path::{Path, PathBuf};
+use std::time::{Duration, Instant};
+
+/// Versión del formato; un archivo de otra versión se ignora
+pub const CALIBRATION_VERSION: u32 = 1;
+
+/// Operaciones que mide la calibración
+pub const CALIBRATED_OPS: [&str; 4] = ["vector_add", "saxpy", "reduction", "matmul"];
+
+/// GFLOP/s de kernel GPU cuando el probe no los mide (igual que
+/// `OperationCost::estimate_kernel_us`)
+pub const DEFAULT_GPU_GFLOPS: f64 = 300.0;
+
+/// Elementos por array en los benchmarks de streaming (4 MiB, fuera de L2)
+const STREAM_ELEMENTS: usize = 1 << 20;
+/// Lado del benchmark de matmul
+const MATMUL_SIDE: usize = 192;
+/// Tiempo mínimo medido por benchmark
+const BENCH_TIME: Duration = Duration::from_millis(20);
+/// Bytes de la copia que mide el PCIe
+const COPY_BYTES: usize = 64 << 20;
+
+/// Microbenchmarks de GPU que aporta el backend (CUDA, Vulkan...)
+pub trait GpuProbe {
+    /// µs de lanzar un kernel vacío y esperarlo
+    fn launch_latency_us(&mut self) -> Option<f64>;
+    /// GB/s de copiar `bytes` host→device→host
+    fn copy_gbps(&mut self, bytes: usize) -> Option<f64>;
+    /// GFLOP/s sostenidos de un kernel (None = `DEFAULT_GPU_GFLOPS`)
+    fn kernel_gflops(&mut self) -> Option<f64> {
+        None
+    }
+}
+
+/// Modelo de coste medido en esta máquina
+#[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
+pub struct CostModel {
+    pub version: u32,
+    /// Huella de la máquina (ver `machine_id`)
+    pub machine: String,
+    /// GFLOP/s de CPU por operación
+    pub cpu_gflops: BTreeMap<String, f64>,
+    /// µs por lanzamiento de kernel; None = sin GPU medida
+    pub gpu_launch_us: Option<f64>,
+    /// GB/s host↔device
+    pub pcie_gbps: Option<f64>,
+    /// GFLOP/s de kernel GPU
+    pub gpu_gflops: Option<f64>,
+}
+
+/// Huella de la máquina: CPU, hilos y GPU (nombre, MB de VRAM)
+pub fn machine_id(cpu_brand: &str, threads: usize, gpu: Option<(&str, u64)>) -> String {
+    let gpu = match gpu {
+        Some((name, vram_mb)) => format!("{} {}MB", name.trim(), vram_mb),
+        None => "no-gpu".to_string(),
+    };
+    format!("{} / {} threads / {}", cpu_brand.trim(), threads, gpu)
+}
+
+/// (FLOPs, bytes host↔device) de `op` sobre `size` elementos. En
+/// matmul `size` son los elementos de C (matriz cuadrada).
+pub fn op_work(op: &str, size: usize) -> (f64, usize) {
+    let n = size as f64;
+    match op {
+        "saxpy" => (2.0 * n, 12 * size),
+        "reduction" | "sum" => (n, 4 * size + 4),
+        "matmul" => {
+            let side = n.sqrt().round() as usize;
+            matmul_work(side, side, side)
+        }
+        // vector_add y cualquier elementwise: a + b → c
+        _ => (n, 12 * size),
+    }
+}
+
+/// (FLOPs, bytes host↔device) de C[m×n] = A[m×k]·B[k×n]
+pub fn matmul_work(m: usize, n: usize, k: usize) -> (f64, usize) {
+    (2.0 * (m * n) as f64 * k as f64, 4 * (m * k + k * n + m * n))
+}
+
+impl CostModel {
+    /// Modelo sin medidas (todo None): `prefers_gpu` no decide
+    pub fn empty(machine: &str) -> Self {
+        Self {
+            version: CALIBRATION_VERSION,
+            machine: machine.to_string(),
+            cpu_gflops: BTreeMap::new(),
+            gpu_launch_us: None,
+            pcie_gbps: None,
+            gpu_gflops: None,
+        }
+    }
+
+    /// Corre los microbenchmarks (CPU siempre, GPU si hay probe)
+    pub fn calibrate(machine: &str, probe: Option<&mut dyn GpuProbe>) -> Self {
+        let mut model = Self::empty(machine);
+        for op in CALIBRATED_OPS {
+            model.cpu_gflops.insert(op.to_string(), bench_cpu(op));
+        }
+        if let Some(probe) = probe {
+            model.gpu_launch_us = probe.launch_latency_us();
+            model.pcie_gbps = probe.copy_gbps(COPY_BYTES);
+            model.gpu_gflops = probe.kernel_gflops();
+        }
+        model
+    }
+
+    /// Modelo persistido para `machine`, o calibra y lo guarda
+    pub fn load_or_calibrate(machine: &str, probe: Option<&mut dyn GpuProbe>) -> Self {
+        let dir = ObjectCache::from_env().dir().to_path_buf();
+        let recalibrate = std::env::var("ADEB_RECALIBRATE").map_or(false, |v| v == "1");
+        if !recalibrate {
+            if let Some(model) = Self::load(&dir, machine) {
+                return model;
+            }
+        }
+        let model = Self::calibrate(machine, probe);
+        // Sin cache escribible se recalibra en el próximo arranque
+        let _ = model.store(&dir);
+        model
+    }
+
+    /// Modelo persistido, sin medir nada si no existe
+    pub fn load_cached(machine: &str) -> Option<Self> {
+        Self::load(ObjectCache::from_env().dir(), machine)
+    }
+
+    pub fn path(dir: &Path, machine: &str) -> PathBuf {
+        dir.join("calibration").join(format!("{:016x}.json", hash_bytes(machine.as_bytes())))
+    }
+
+    pub fn load(dir: &Path, machine: &str) -> Option<Self> {
+        let text = std::fs::read_to_string(Self::path(dir, machine)).ok()?;
+        let model: Self = serde_json::from_str(&text).ok()?;
+        (model.version == CALIBRATION_VERSION && model.machine == machine).then_some(model)
+    }
+
+    /// tmp + rename, como el cache de objetos
+    pub fn store(&self, dir: &Path) -> io::Result<()> {
+        let path = Self::path(dir, &self.machine);
+        std::fs::create_dir_all(path.parent().unwrap())?;
+        let json = serde_json::to_string_pretty(self).map_err(|e| io::Error::new(io::ErrorKind::Other, e))?;
+        let tmp = path.with_extension(format!("json.tmp{}", std::process::id()));
+        std::fs::write(&tmp, json)?;
+        std::fs::rename(&tmp, &path)
+    }
+
+    /// µs estimados en CPU; operaciones sin medida usan la de vector_add
+    pub fn cpu_us(&self, op: &str, flops: f64) -> Option<f64> {
+        let gflops = self.cpu_gflops.get(op).or_else(|| self.cpu_gflops.get("vector_add"))?;
+        Some(flops / (gflops * 1e3))
+    }
+
+    /// µs estimados en GPU: lanzamiento + transferencias + kernel
+    pub fn gpu_us(&self, flops: f64, bytes: usize) -> Option<f64> {
+        let (launch, gbps) = (self.gpu_launch_us?, self.pcie_gbps?);
+        let kernel = flops / (self.gpu_gflops.unwrap_or(DEFAULT_GPU_GFLOPS) * 1e3);
+        Some(launch + bytes as f64 / (gbps * 1e3) + kernel)
+    }
+
+    /// ¿Gana la GPU? None si falta alguna medida
+    pub fn prefers_gpu(&self, op: &str, flops: f64, bytes: usize) -> Option<bool> {
+        Some(self.gpu_us(flops, bytes)? < self.cpu_us(op, flops)?)
+    }
+}
+
+/// Mejor tiempo (s) de `f` en al menos 3 vueltas y `BENCH_TIME`
+fn best_time(mut f: impl FnMut()) -> f64 {
+    f();
+    let (start, mut best, mut runs) = (Instant::now(), f64::MAX, 0);
+    while runs < 3 || start.elapsed() < BENCH_TIME {
+        let t = Instant::now();
+        f();
+        best = best.min(t.elapsed().as_secs_f64());
+        runs += 1;
+    }
+    best
+}
+
+/// GFLOP/s de una operación en este CPU (un hilo)
+fn bench_cpu(op: &str) -> f64 {
+    let n = STREAM_ELEMENTS;
+    let (a, b) = (vec![1.5f32; n], vec![0.5f32; n]);
+    let mut c = vec![0.0f32; n];
+    let (flops, secs) = match op {
+        "saxpy" => {
+            let secs = best_time(|| {
+                let alpha = black_box(1.0001f32);
+                for (y, x) in c.iter_mut().zip(black_box(&a)) {
+                    *y += alpha * x;
+                }
+                black_box(&c);
+            });
+            (2.0 * n as f64, secs)
+        }
+        "reduction" => {
+            let secs = best_time(|| {
+                // 8 sumas parciales: el compilador vectoriza la suma
+                let mut acc = [0.0f32; 8];
+                for chunk in black_box(&a).chunks_exact(8) {
+                    for (s, v) in acc.iter_mut().zip(chunk) {
+                        *s += v;
+                    }
+                }
+                black_box(acc);
+            });
+            (n as f64, secs)
+        }
+        "matmul" => {
+            let s = MATMUL_SIDE;
+            let (a, b) = (&a[..s * s], &b[..s * s]);
+            let c = &mut c[..s * s];
+            let secs = best_time(|| {
+                c.fill(0.0);
+                for i in 0..s {
+                    let row = &mut c[i * s..(i + 1) * s];
+                    for p in 0..s {
+                        let av = a[i * s + p];
+                        for (cv, bv) in row.iter_mut().zip(&b[p * s..(p + 1) * s]) {
+                            *cv += av * bv;
+                        }
+                    }
+                }
+                black_box(&*c);
+            });
+            (2.0 * (s * s * s) as f64, secs)
+        }
+        _ => {
+            let secs = best_time(|| {
+                for ((c, a), b) in c.iter_mut().zip(black_box(&a)).zip(black_box(&b)) {
+                    *c = a + b;
+                }
+                black_box(&c);
+            });
+            (n as f64, secs)
+        }
+    };
+    flops / secs.max(1e-9) / 1e9
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    struct FakeGpu {
+        launch_us: f64,
+        gbps: f64,
+    }
+
+    impl GpuProbe for FakeGpu {
+        fn launch_latency_us(&mut self) -> Option<f64> {
+            Some(self.launch_us)
+        }
+        fn copy_gbps(&mut self, _bytes: usize) -> Option<f64> {
+            Some(self.gbps)
+        }
+        fn kernel_gflops(&mut self) -> Option<f64> {
+            Some(10_000.0)
+        }
+    }
+
+    fn model() -> CostModel {
+        let mut model = CostModel::empty("test");
+        model.cpu_gflops.insert("vector_add".into(), 2.0);
+        model.cpu_gflops.insert("matmul".into(), 50.0);
+        model.gpu_launch_us = Some(20.0);
+        model.pcie_gbps = Some(10.0);
+        model.gpu_gflops = Some(10_000.0);
+        model
+    }
+
+    #[test]
+    fn test_crossover() {
+        let m = model();
+        // VectorAdd: 12 bytes por FLOP, el PCIe nunca compensa
+        let (flops, bytes) = op_work("vector_add", 1 << 24);
+        assert_eq!(m.prefers_gpu("vector_add", flops, bytes), Some(false));
+        // MatMul pequeño: gana la latencia de lanzamiento; grande: la GPU
+        let (flops, bytes) = matmul_work(16, 16, 16);
+        assert_eq!(m.prefers_gpu("matmul", flops, bytes), Some(false));
+        let (flops, bytes) = matmul_work(2048, 2048, 2048);
+        assert_eq!(m.prefers_gpu("matmul", flops, bytes), Some(true));
+        // Sin medidas de GPU no hay decisión
+        assert_eq!(CostModel::empty("x").prefers_gpu("matmul", flops, bytes), None);
+    }
+
+    #[test]
+    fn test_calibrate_and_persist() {
+        let dir = std::env::temp_dir().join(format!("adeb_calibration_{}", std::process::id()));
+        let mut gpu = FakeGpu { launch_us: 8.0, gbps: 12.0 };
+        let model = CostModel::calibrate("box", Some(&mut gpu));
+        for op in CALIBRATED_OPS {
+            assert!(model.cpu_gflops[op] > 0.0, "{}", op);
+        }
+        assert_eq!(model.gpu_launch_us, Some(8.0));
+        model.store(&dir).unwrap();
+        let loaded = CostModel::load(&dir, "box").unwrap();
+        assert_eq!(loaded.gpu_launch_us, Some(8.0));
+        for op in CALIBRATED_OPS {
+            // serde_json puede perder el último ulp del f64
+            assert!((loaded.cpu_gflops[op] / model.cpu_gflops[op] - 1.0).abs() < 1e-12);
+        }
+        // Otra máquina u otra versión del formato no reutilizan el archivo
+        assert_eq!(CostModel::load(&dir, "other"), None);
+        let mut old = model;
+        old.version = 0;
+        old.store(&dir).unwrap();
+        assert_eq!(CostModel::load(&dir, "box"), None);
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
@@ -0,0 +1,328 @@
+//! ADead-BIB Identifier Interner
+//!
+//! Tablas de identificadores: cada nombre distinto se guarda UNA vez por
+//! tabla y recibe un id entero. Los tokens llevan un [`Ident`] (id + texto
+//! compartido) en vez de un `String` propio, así que clonar un token o
+//! compararlo con otro identificador no toca el heap.
+//!
+//! Cada lexer interna en su propio [`IdentCache`]: una sesión con tabla
+//! propia que muere con el lexer. Ni los hilos del compilador se pelean
+//! por un lock, ni `adB serve` acumula los nombres de cada petición: el
+//! texto vive lo que vivan los tokens que lo usan. Los ids sólo valen
+//! dentro de su sesión; dos `Ident` de sesiones distintas se comparan por
+//! texto. [`Ident::new`] fuera de un lexer usa una tabla global pequeña.
+
+use std::borrow::Borrow;
+use std::collections::HashMap;
+use std::fmt;
+use std::hash::{BuildHasherDefault, Hash, Hasher};
+use std::marker::PhantomData;
+use std::ops::Deref;
+use std::sync::atomic::{AtomicU32, Ordering};
+use std::sync::{Arc, Mutex, OnceLock};
+
+/// Hash multiplicativo estilo FxHash: los identificadores son cortos y el
+/// SipHash por defecto domina el costo de internar. Las tablas de símbolos
+/// del backend (variables, funciones, layouts) lo usan por la misma razón
+/// a través de [`FxHashMap`] / [`FxHashSet`]; no resiste entradas hostiles,
+/// sólo nombres del propio programa.
+#[derive(Default, Clone, Copy)]
+pub struct FxHasher {
+    hash: u64,
+}
+
+const FX_SEED: u64 = 0x51_7c_c1_b7_27_22_0a_95;
+
+impl Hasher for FxHasher {
+    #[inline]
+    fn write(&mut self, bytes: &[u8]) {
+        let mut chunks = bytes.chunks_exact(8);
+        for chunk in &mut chunks {
+            let word = u64::from_le_bytes(chunk.try_into().unwrap());
+            self.hash = (self.hash.rotate_left(5) ^ word).wrapping_mul(FX_SEED);
+        }
+        for &b in chunks.remainder() {
+            self.hash = (self.hash.rotate_left(5) ^ b as u64).wrapping_mul(FX_SEED);
+        }
+    }
+
+    #[inline]
+    fn write_u8(&mut self, i: u8) {
+        self.write_u64(i as u64);
+    }
+
+    #[inline]
+    fn write_u32(&mut self, i: u32) {
+        self.write_u64(i as u64);
+    }
+
+    #[inline]
+    fn write_u64(&mut self, i: u64) {
+        self.hash = (self.hash.rotate_left(5) ^ i).wrapping_mul(FX_SEED);
+    }
+
+    #[inline]
+    fn write_usize(&mut self, i: usize) {
+        self.write_u64(i as u64);
+    }
+
+    #[inline]
+    fn finish(&self) -> u64 {
+        self.hash
+    }
+}
+
+pub type FxBuildHasher = BuildHasherDefault<FxHasher>;
+pub type FxHashMap<K, V> = HashMap<K, V, FxBuildHasher>;
+pub type FxHashSet<K> = std::collections::HashSet<K, FxBuildHasher>;
+
+/// Identificador internado. Dentro de una sesión dos `Ident` son iguales
+/// si y sólo si tienen el mismo id.
+#[derive(Clone)]
+pub struct Ident {
+    id: u32,
+    session: u32,
+    text: Arc<str>,
+}
+
+/// Sesión 0: la tabla global de [`Ident::new`]
+const GLOBAL_SESSION: u32 = 0;
+static NEXT_SESSION: AtomicU32 = AtomicU32::new(GLOBAL_SESSION + 1);
+
+struct Interner {
+    session: u32,
+    ids: HashMap<Arc<str>, u32, FxBuildHasher>,
+    names: Vec<Arc<str>>,
+}
+
+impl Interner {
+    fn new(session: u32) -> Self {
+        Self {
+            session,
+            ids: HashMap::default(),
+            names: Vec::new(),
+        }
+    }
+
+    fn intern(&mut self, name: &str) -> Ident {
+        if let Some((text, &id)) = self.ids.get_key_value(name) {
+            return Ident { id, session: self.session, text: text.clone() };
+        }
+        let id = self.names.len() as u32;
+        let text: Arc<str> = Arc::from(name);
+        self.names.push(text.clone());
+        self.ids.insert(text.clone(), id);
+        Ident { id, session: self.session, text }
+    }
+}
+
+fn table() -> &'static Mutex<Interner> {
+    static TABLE: OnceLock<Mutex<Interner>> = OnceLock::new();
+    TABLE.get_or_init(|| Mutex::new(Interner::new(GLOBAL_SESSION)))
+}
+
+impl Ident {
+    /// Interna `name` en la tabla global
+    pub fn new(name: &str) -> Self {
+        table().lock().unwrap().intern(name)
+    }
+
+    /// Id entero del identificador (estable dentro de su sesión)
+    pub fn id(&self) -> u32 {
+        self.id
+    }
+
+    pub fn as_str(&self) -> &str {
+        &self.text
+    }
+
+    /// Identificador de la tabla global con ese id, si existe
+    pub fn from_id(id: u32) -> Option<Self> {
+        let table = table().lock().unwrap();
+        table
+            .names
+            .get(id as usize)
+            .map(|text| Ident { id, session: GLOBAL_SESSION, text: text.clone() })
+    }
+}
+
+/// Número de identificadores distintos de la tabla global
+pub fn interned_count() -> usize {
+    table().lock().unwrap().names.len()
+}
+
+impl Deref for Ident {
+    type Target = str;
+    fn deref(&self) -> &str {
+        &self.text
+    }
+}
+
+impl AsRef<str> for Ident {
+    fn as_ref(&self) -> &str {
+        &self.text
+    }
+}
+
+impl Borrow<str> for Ident {
+    fn borrow(&self) -> &str {
+        &self.text
+    }
+}
+
+impl PartialEq for Ident {
+    fn eq(&self, other: &Self) -> bool {
+        if self.session == other.session {
+            self.id == other.id
+        } else {
+            self.text == other.text
+        }
+    }
+}
+
+impl Eq for Ident {}
+
+// Hash por texto para que sea coherente con `Borrow<str>`
+impl Hash for Ident {
+    fn hash<H: Hasher>(&self, state: &mut H) {
+        self.text.hash(state)
+    }
+}
+
+impl PartialOrd for Ident {
+    fn partial_cmp(&self, other: &Self) -> Option<std::cmp::Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+impl Ord for Ident {
+    fn cmp(&self, other: &Self) -> std::cmp::Ordering {
+        self.text.cmp(&other.text)
+    }
+}
+
+impl PartialEq<str> for Ident {
+    fn eq(&self, other: &str) -> bool {
+        &*self.text == other
+    }
+}
+
+impl PartialEq<&str> for Ident {
+    fn eq(&self, other: &&str) -> bool {
+        &*self.text == *other
+    }
+}
+
+impl PartialEq<String> for Ident {
+    fn eq(&self, other: &String) -> bool {
+        &*self.text == other.as_str()
+    }
+}
+
+impl From<&str> for Ident {
+    fn from(name: &str) -> Self {
+        Ident::new(name)
+    }
+}
+
+impl From<String> for Ident {
+    fn from(name: String) -> Self {
+        Ident::new(&name)
+    }
+}
+
+impl From<&Ident> for String {
+    fn from(ident: &Ident) -> Self {
+        ident.text.to_string()
+    }
+}
+
+impl From<Ident> for String {
+    fn from(ident: Ident) -> Self {
+        ident.text.to_string()
+    }
+}
+
+// Debug como un string: `Identifier("main")` sigue viéndose igual
+impl fmt::Debug for Ident {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        fmt::Debug::fmt(&*self.text, f)
+    }
+}
+
+impl fmt::Display for Ident {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.write_str(&self.text)
+    }
+}
+
+/// Sesión de internado de un lexer: tabla propia sin lock, que se
+/// libera con el lexer (los `Ident` ya emitidos guardan su texto)
+pub struct IdentCache<'src> {
+    table: Interner,
+    _source: PhantomData<&'src str>,
+}
+
+impl<'src> IdentCache<'src> {
+    pub fn new() -> Self {
+        Self {
+            table: Interner::new(NEXT_SESSION.fetch_add(1, Ordering::Relaxed)),
+            _source: PhantomData,
+        }
+    }
+
+    pub fn intern(&mut self, name: &'src str) -> Ident {
+        self.table.intern(name)
+    }
+}
+
+impl Default for IdentCache<'_> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_same_name_same_id() {
+        let a = Ident::new("interner_test_name");
+        let b = Ident::from("interner_test_name".to_string());
+        let c = Ident::new("interner_test_other");
+        assert_eq!(a, b);
+        assert_eq!(a.id(), b.id());
+        assert_ne!(a, c);
+        assert_eq!(a, "interner_test_name");
+        assert_eq!(Ident::from_id(a.id()).unwrap(), a);
+    }
+
+    #[test]
+    fn test_cache_is_its_own_session() {
+        let source = String::from("foo bar foo");
+        let mut cache = IdentCache::new();
+        let words: Vec<Ident> = source.split(' ').map(|w| cache.intern(w)).collect();
+        assert_eq!(words[0], words[2]);
+        assert_eq!(words[0].id(), words[2].id());
+        assert_ne!(words[0], words[1]);
+        // Otra sesión (o la tabla global): mismo texto, mismo nombre
+        assert_eq!(words[0], Ident::new("foo"));
+        let mut other = IdentCache::new();
+        let bar = other.intern("bar");
+        assert_eq!(bar.id(), 0);
+        assert_eq!(words[1], bar);
+        assert_ne!(words[0], bar);
+        assert_eq!(format!("{:?}", words[1]), "\"bar\"");
+    }
+
+    #[test]
+    fn test_session_table_freed_with_lexer() {
+        let ident = {
+            let mut cache = IdentCache::new();
+            cache.intern("interner_session_only_name")
+        };
+        // Sólo el token sigue apuntando al texto
+        assert_eq!(Arc::strong_count(&ident.text), 1);
+    }
+}
@@ -8,8 +8,15 @@ pub mod source;
 pub mod symbols;
 pub mod types;
 pub mod ast;
+pub mod cache;
+pub mod calibration;
+pub mod parallel;
+pub mod interner;
+pub mod time_report;
+pub mod toolchain;
 
 // Re-exports comunes
 pub use diagnostics::{Diagnostic, DiagnosticLevel, DiagnosticManager};
 pub use source::{SourceFile, SourceLocation, SourceMap};
 pub use symbols::{Symbol, SymbolTable, SymbolKind};
+pub use interner::{FxHashMap, FxHashSet, Ident};
@@ -0,0 +1,106 @@
+//! ADead-BIB Parallel Helpers
+//!
+//! Paralelismo mínimo sobre `std::thread::scope` — sin dependencias externas.
+//! Usado por las fases del compilador que procesan unidades independientes
+//! (funciones, archivos, chunks) y necesitan resultados en orden determinista.
+
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Mutex;
+
+/// Número de hilos por defecto: `ADEB_JOBS` si está definido, si no los
+/// núcleos disponibles.
+pub fn default_jobs() -> usize {
+    if let Ok(v) = std::env::var("ADEB_JOBS") {
+        if let Ok(n) = v.trim().parse::<usize>() {
+            return n.max(1);
+        }
+    }
+    std::thread::available_parallelism()
+        .map(|n| n.get())
+        .unwrap_or(1)
+}
+
+/// Aplica `f` a cada elemento usando hasta `jobs` hilos.
+///
+/// Los resultados se devuelven en el mismo orden que `items`, sin importar
+/// qué hilo procesó cada elemento. `init` crea el estado privado de cada
+/// hilo (p.ej. un compilador clonado) y se reutiliza entre sus elementos.
+/// Con `jobs <= 1` o un solo elemento todo corre en el hilo actual.
+pub fn par_map_with<T, S, R, I, F>(items: &[T], jobs: usize, init: I, f: F) -> Vec<R>
+where
+    T: Sync,
+    R: Send,
+    I: Fn() -> S + Sync,
+    F: Fn(&mut S, usize, &T) -> R + Sync,
+{
+    let jobs = jobs.max(1).min(items.len());
+    if jobs <= 1 {
+        let mut state = init();
+        return items
+            .iter()
+            .enumerate()
+            .map(|(i, item)| f(&mut state, i, item))
+            .collect();
+    }
+
+    let next = AtomicUsize::new(0);
+    let slots: Mutex<Vec<Option<R>>> = Mutex::new((0..items.len()).map(|_| None).collect());
+
+    std::thread::scope(|scope| {
+        for _ in 0..jobs {
+            scope.spawn(|| {
+                let mut state = init();
+                loop {
+                    let i = next.fetch_add(1, Ordering::Relaxed);
+                    if i >= items.len() {
+                        break;
+                    }
+                    let r = f(&mut state, i, &items[i]);
+                    slots.lock().unwrap()[i] = Some(r);
+                }
+            });
+        }
+    });
+
+    slots
+        .into_inner()
+        .unwrap()
+        .into_iter()
+        .map(|r| r.expect("par_map: worker did not produce a result"))
+        .collect()
+}
+
+/// Variante sin estado por hilo de [`par_map_with`].
+pub fn par_map<T, R, F>(items: &[T], jobs: usize, f: F) -> Vec<R>
+where
+    T: Sync,
+    R: Send,
+    F: Fn(&T) -> R + Sync,
+{
+    par_map_with(items, jobs, || (), |_, _, item| f(item))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_par_map_preserves_order() {
+        let items: Vec<u32> = (0..1000).collect();
+        let out = par_map(&items, 8, |x| x * 2);
+        assert_eq!(out, items.iter().map(|x| x * 2).collect::<Vec<_>>());
+    }
+
+    #[test]
+    fn test_par_map_with_serial_fallback() {
+        let items = vec!["a", "bb", "ccc"];
+        let out = par_map_with(&items, 1, || 10usize, |base, i, s| *base + i + s.len());
+        assert_eq!(out, vec![11, 13, 15]);
+    }
+
+    #[test]
+    fn test_par_map_empty() {
+        let items: Vec<u8> = Vec::new();
+        assert!(par_map(&items, 4, |x| *x).is_empty());
+    }
+}
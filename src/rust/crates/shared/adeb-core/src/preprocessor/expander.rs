@@ -48,6 +48,8 @@ impl MacroExpander {
     }
 
     /// Expande if constexpr C++17 — evalua en compilacion, solo incluye branch correcto
+    /// (la condicion ya viene evaluada; el frontend C++ evalua `if constexpr`
+    /// por su cuenta con el interprete de lower/constexpr.rs)
     pub fn expand_if_constexpr(
         &self,
         condition_is_true: bool,
@@ -129,6 +131,8 @@ impl MacroExpander {
     }
 
     /// Expande `constexpr int f() { return 42; }` → evaluacion en tiempo de compilacion
+    /// (solo reescribe un valor ya conocido; el frontend C++ ejecuta las funciones
+    /// constexpr con el interprete de lower/constexpr.rs)
     pub fn expand_constexpr_func(
         &self,
         return_type: &str,
@@ -142,7 +146,8 @@ impl MacroExpander {
     }
 
     /// Expande move semantics: `std::move(x)` → transferencia de ownership
-    /// En C++98 canon: simplemente copia (sin RVO/move, el optimizer maneja)
+    /// En C++98 canon: simplemente copia (el frontend C++ elige el
+    /// constructor de movimiento y aplica RVO/NRVO en lower/elision.rs)
     pub fn expand_move(&self, expr: &str) -> String {
         format!("/* std::move */ {}", expr)
     }
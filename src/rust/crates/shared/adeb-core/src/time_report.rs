@@ -0,0 +1,416 @@
+//! ADead-BIB Compile-Time Report
+//!
+//! Mide cada fase del compilador (`-ftime-report`) y opcionalmente vuelca
+//! los spans como un Chrome trace (`--trace-json`, abrir en
+//! `chrome://tracing` o Perfetto).
+//!
+//! Desactivado por defecto: [`phase`] y [`span`] devuelven un guard vacío
+//! tras leer un `AtomicBool`, así que la instrumentación puede quedarse en
+//! las rutas calientes (una span por función compilada).
+//!
+//! Las asignaciones se cuentan con [`CountingAlloc`], que el binario
+//! instala como `#[global_allocator]`. Sin él los contadores quedan en 0.
+
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::cell::Cell;
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::{Mutex, OnceLock};
+use std::time::Instant;
+
+/// Categoría de las fases del pipeline (entran en la tabla del reporte)
+pub const PHASE: &str = "phase";
+/// Sub-fase anidada dentro de una fase (p.ej. encode dentro de codegen):
+/// aparece indentada en la tabla y no suma al total
+pub const SUBPHASE: &str = "subphase";
+/// Categoría de las spans por función (sólo en el trace y el top del reporte)
+pub const FUNCTION: &str = "function";
+
+static ENABLED: AtomicBool = AtomicBool::new(false);
+static SPANS: Mutex<Vec<Span>> = Mutex::new(Vec::new());
+static NEXT_TID: AtomicU64 = AtomicU64::new(1);
+
+thread_local! {
+    static ALLOC_COUNT: Cell<u64> = const { Cell::new(0) };
+    static ALLOC_BYTES: Cell<u64> = const { Cell::new(0) };
+    static TID: Cell<u64> = const { Cell::new(0) };
+}
+
+fn epoch() -> Instant {
+    static EPOCH: OnceLock<Instant> = OnceLock::new();
+    *EPOCH.get_or_init(Instant::now)
+}
+
+/// Id pequeño y estable del hilo actual (para el campo `tid` del trace)
+fn thread_id() -> u64 {
+    TID.with(|t| {
+        if t.get() == 0 {
+            t.set(NEXT_TID.fetch_add(1, Ordering::Relaxed));
+        }
+        t.get()
+    })
+}
+
+fn alloc_counters() -> (u64, u64) {
+    let count = ALLOC_COUNT.try_with(Cell::get).unwrap_or(0);
+    let bytes = ALLOC_BYTES.try_with(Cell::get).unwrap_or(0);
+    (count, bytes)
+}
+
+/// Allocator del sistema con contadores por hilo (número y bytes pedidos)
+pub struct CountingAlloc;
+
+unsafe impl GlobalAlloc for CountingAlloc {
+    #[inline]
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        record_alloc(layout.size());
+        System.alloc(layout)
+    }
+
+    #[inline]
+    unsafe fn alloc_zeroed(&self, layout: Layout) -> *mut u8 {
+        record_alloc(layout.size());
+        System.alloc_zeroed(layout)
+    }
+
+    #[inline]
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        record_alloc(new_size);
+        System.realloc(ptr, layout, new_size)
+    }
+
+    #[inline]
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        System.dealloc(ptr, layout)
+    }
+}
+
+#[inline]
+fn record_alloc(size: usize) {
+    // try_with: el TLS puede estar destruido mientras el hilo termina
+    let _ = ALLOC_COUNT.try_with(|c| c.set(c.get() + 1));
+    let _ = ALLOC_BYTES.try_with(|c| c.set(c.get() + size as u64));
+}
+
+/// Pico de memoria residente del proceso (VmHWM), si el SO lo expone
+pub fn peak_rss_bytes() -> Option<u64> {
+    #[cfg(target_os = "linux")]
+    {
+        let status = std::fs::read_to_string("/proc/self/status").ok()?;
+        let line = status.lines().find(|l| l.starts_with("VmHWM:"))?;
+        let kb: u64 = line.split_whitespace().nth(1)?.parse().ok()?;
+        Some(kb * 1024)
+    }
+    #[cfg(not(target_os = "linux"))]
+    {
+        None
+    }
+}
+
+/// Una span cerrada
+#[derive(Debug, Clone)]
+pub struct Span {
+    pub name: String,
+    pub cat: &'static str,
+    pub start_us: u64,
+    pub dur_us: u64,
+    pub tid: u64,
+    /// Asignaciones hechas por este hilo dentro de la span
+    pub allocs: u64,
+    pub alloc_bytes: u64,
+    /// Pico RSS del proceso al cerrar la fase (sólo fases)
+    pub peak_rss: Option<u64>,
+}
+
+/// Empieza a registrar spans
+pub fn enable() {
+    epoch();
+    ENABLED.store(true, Ordering::Relaxed);
+}
+
+#[inline]
+pub fn is_enabled() -> bool {
+    ENABLED.load(Ordering::Relaxed)
+}
+
+/// Saca todas las spans registradas hasta ahora
+pub fn take() -> Vec<Span> {
+    std::mem::take(&mut *SPANS.lock().unwrap())
+}
+
+/// Copia de las spans registradas hasta ahora, sin sacarlas (`adB step`
+/// las muestra fase a fase y `-ftime-report` las sigue viendo al final)
+pub fn snapshot() -> Vec<Span> {
+    SPANS.lock().unwrap().clone()
+}
+
+/// Cierra la span al salir de scope
+#[must_use = "la span se cierra cuando el guard sale de scope"]
+pub struct SpanGuard(Option<OpenSpan>);
+
+struct OpenSpan {
+    name: String,
+    cat: &'static str,
+    start: Instant,
+    allocs: u64,
+    alloc_bytes: u64,
+}
+
+/// Span de una fase del pipeline
+#[inline]
+pub fn phase(name: &str) -> SpanGuard {
+    span(PHASE, || name.to_string())
+}
+
+/// Span de una sub-fase (anidada en una fase)
+#[inline]
+pub fn subphase(name: &str) -> SpanGuard {
+    span(SUBPHASE, || name.to_string())
+}
+
+/// Span de categoría `cat`; el nombre sólo se construye si está activo
+#[inline]
+pub fn span(cat: &'static str, name: impl FnOnce() -> String) -> SpanGuard {
+    if !is_enabled() {
+        return SpanGuard(None);
+    }
+    let (allocs, alloc_bytes) = alloc_counters();
+    SpanGuard(Some(OpenSpan {
+        name: name(),
+        cat,
+        start: Instant::now(),
+        allocs,
+        alloc_bytes,
+    }))
+}
+
+impl Drop for SpanGuard {
+    fn drop(&mut self) {
+        let open = match self.0.take() {
+            Some(open) => open,
+            None => return,
+        };
+        let end = Instant::now();
+        let (allocs, alloc_bytes) = alloc_counters();
+        let span = Span {
+            name: open.name,
+            cat: open.cat,
+            start_us: open.start.saturating_duration_since(epoch()).as_micros() as u64,
+            dur_us: end.saturating_duration_since(open.start).as_micros() as u64,
+            tid: thread_id(),
+            allocs: allocs.wrapping_sub(open.allocs),
+            alloc_bytes: alloc_bytes.wrapping_sub(open.alloc_bytes),
+            peak_rss: if open.cat == PHASE {
+                peak_rss_bytes()
+            } else {
+                None
+            },
+        };
+        SPANS.lock().unwrap().push(span);
+    }
+}
+
+// ============================================================
+// Salida
+// ============================================================
+
+pub fn fmt_bytes(n: u64) -> String {
+    if n >= 1 << 20 {
+        format!("{:.1} MiB", n as f64 / (1u64 << 20) as f64)
+    } else if n >= 1 << 10 {
+        format!("{:.1} KiB", n as f64 / 1024.0)
+    } else {
+        format!("{} B", n)
+    }
+}
+
+/// Tabla de `-ftime-report`: una fila por fase (sumando repeticiones,
+/// p.ej. una por TU), en orden de primer inicio, más las funciones más
+/// lentas de codegen.  El % es sobre la suma de fases de nivel superior.
+pub fn render_report(spans: &[Span]) -> String {
+    struct Row<'a> {
+        name: &'a str,
+        sub: bool,
+        first_us: u64,
+        runs: usize,
+        dur_us: u64,
+        allocs: u64,
+        bytes: u64,
+        peak_rss: Option<u64>,
+    }
+    let mut rows: Vec<Row> = Vec::new();
+    for s in spans.iter().filter(|s| s.cat == PHASE || s.cat == SUBPHASE) {
+        let sub = s.cat == SUBPHASE;
+        let k = match rows.iter().position(|r| r.name == s.name && r.sub == sub) {
+            Some(k) => k,
+            None => {
+                rows.push(Row {
+                    name: &s.name,
+                    sub,
+                    first_us: s.start_us,
+                    runs: 0,
+                    dur_us: 0,
+                    allocs: 0,
+                    bytes: 0,
+                    peak_rss: None,
+                });
+                rows.len() - 1
+            }
+        };
+        let row = &mut rows[k];
+        row.first_us = row.first_us.min(s.start_us);
+        row.runs += 1;
+        row.dur_us += s.dur_us;
+        row.allocs += s.allocs;
+        row.bytes += s.alloc_bytes;
+        row.peak_rss = row.peak_rss.max(s.peak_rss);
+    }
+    rows.sort_by_key(|r| (r.first_us, r.sub));
+    let total_us: u64 = rows
+        .iter()
+        .filter(|r| !r.sub)
+        .map(|r| r.dur_us)
+        .sum::<u64>()
+        .max(1);
+
+    let mut out = String::new();
+    out.push_str("   ===-- Time report --===\n");
+    out.push_str(&format!(
+        "   {:<20} {:>10} {:>6} {:>10} {:>11} {:>11}\n",
+        "phase", "wall ms", "%", "allocs", "alloc'd", "peak RSS"
+    ));
+    for r in &rows {
+        let mut name = if r.runs > 1 {
+            format!("{} (x{})", r.name, r.runs)
+        } else {
+            r.name.to_string()
+        };
+        if r.sub {
+            name.insert_str(0, "  ");
+        }
+        out.push_str(&format!(
+            "   {:<20} {:>10.3} {:>5.1}% {:>10} {:>11} {:>11}\n",
+            name,
+            r.dur_us as f64 / 1000.0,
+            r.dur_us as f64 * 100.0 / total_us as f64,
+            r.allocs,
+            fmt_bytes(r.bytes),
+            r.peak_rss.map_or_else(|| "-".to_string(), fmt_bytes),
+        ));
+    }
+    out.push_str(&format!(
+        "   {:<20} {:>10.3}\n",
+        "total",
+        total_us as f64 / 1000.0
+    ));
+
+    let mut funcs: Vec<&Span> = spans.iter().filter(|s| s.cat == FUNCTION).collect();
+    if !funcs.is_empty() {
+        funcs.sort_by(|a, b| b.dur_us.cmp(&a.dur_us));
+        out.push_str(&format!(
+            "   slowest functions ({} compiled):\n",
+            funcs.len()
+        ));
+        for s in funcs.iter().take(5) {
+            out.push_str(&format!(
+                "     {:<30} {:>10.3} ms {:>8} allocs\n",
+                s.name,
+                s.dur_us as f64 / 1000.0,
+                s.allocs
+            ));
+        }
+    }
+    out
+}
+
+/// Chrome trace (formato "Trace Event"): un evento completo (`ph: X`) por span
+pub fn chrome_trace_json(spans: &[Span]) -> String {
+    let events: Vec<serde_json::Value> = spans
+        .iter()
+        .map(|s| {
+            let mut args = serde_json::json!({
+                "allocs": s.allocs,
+                "alloc_bytes": s.alloc_bytes,
+            });
+            if let Some(rss) = s.peak_rss {
+                args["peak_rss"] = rss.into();
+            }
+            serde_json::json!({
+                "name": s.name,
+                "cat": s.cat,
+                "ph": "X",
+                "ts": s.start_us,
+                "dur": s.dur_us,
+                "pid": 1,
+                "tid": s.tid,
+                "args": args,
+            })
+        })
+        .collect();
+    serde_json::json!({ "traceEvents": events, "displayTimeUnit": "ms" }).to_string()
+}
+
+pub fn write_chrome_trace(path: &str, spans: &[Span]) -> std::io::Result<()> {
+    std::fs::write(path, chrome_trace_json(spans))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn span_named(name: &str, cat: &'static str, dur_us: u64) -> Span {
+        Span {
+            name: name.to_string(),
+            cat,
+            start_us: 0,
+            dur_us,
+            tid: 1,
+            allocs: 3,
+            alloc_bytes: 2048,
+            peak_rss: None,
+        }
+    }
+
+    #[test]
+    fn test_guards_record_only_when_enabled() {
+        // El colector es global: este es el único test que lo activa
+        drop(phase("before-enable"));
+        assert!(take().is_empty());
+
+        enable();
+        {
+            let _outer = phase("parse");
+            let _inner = span(FUNCTION, || "main".to_string());
+        }
+        let spans = take();
+        assert_eq!(spans.len(), 2);
+        assert_eq!((spans[0].name.as_str(), spans[0].cat), ("main", FUNCTION));
+        assert_eq!((spans[1].name.as_str(), spans[1].cat), ("parse", PHASE));
+        assert!(spans[1].start_us <= spans[0].start_us);
+        assert!(spans[1].dur_us >= spans[0].dur_us);
+    }
+
+    #[test]
+    fn test_report_and_trace_shape() {
+        let spans = vec![
+            span_named("lex", PHASE, 1000),
+            span_named("lex", PHASE, 1000),
+            span_named("codegen", PHASE, 2000),
+            span_named("encode", SUBPHASE, 500),
+            span_named("main", FUNCTION, 1500),
+        ];
+        let report = render_report(&spans);
+        assert!(report.contains("lex (x2)"));
+        assert!(report.contains("  encode"));
+        assert!(report.contains("50.0%"));
+        assert!(report.contains("4.0 KiB"));
+        assert!(report.contains("slowest functions (1 compiled)"));
+
+        let trace: serde_json::Value = serde_json::from_str(&chrome_trace_json(&spans)).unwrap();
+        let events = trace["traceEvents"].as_array().unwrap();
+        assert_eq!(events.len(), 5);
+        assert_eq!(events[4]["name"], "main");
+        assert_eq!(events[4]["ph"], "X");
+        assert_eq!(events[4]["dur"], 1500);
+        assert_eq!(events[2]["args"]["allocs"], 3);
+    }
+}
@@ -1,10 +1,12 @@
+use serde::{Deserialize, Serialize};
+
 /// Unified Type System for ADead-BIB
 /// C-style sized types that flow from parser to codegen
 ///
 /// Philosophy: Types determine machine code size.
 /// `char x = 65` → `mov al, 65` (2 bytes) not `mov rax, 65` (10 bytes)
 
-#[derive(Debug, Clone, PartialEq)]
+#[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
 pub enum Type {
     // Signed integers with explicit size (C-style)
     I8,  // char / int8_t       (1 byte)
@@ -51,7 +53,7 @@ pub enum Type {
 }
 
 /// Register size classification for codegen
-#[derive(Debug, Clone, Copy, PartialEq)]
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
 pub enum RegSize {
     Byte,  // 8-bit: AL, BL, CL, DL
     Word,  // 16-bit: AX, BX, CX, DX
@@ -4,6 +4,8 @@
 
 pub mod os;
 pub mod arch;
+pub mod lz4;
+pub mod po;
 
 pub use os::*;
 pub use arch::*;
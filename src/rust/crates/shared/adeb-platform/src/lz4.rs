@@ -0,0 +1,187 @@
+// ============================================================
+// LZ4 block format — compresor y descompresor propios
+// ============================================================
+// Formato de bloque estándar (sin frame): secuencias
+//   token | lit_len extra | literales | offset u16 | match_len extra
+// con match mínimo de 4 bytes. Restricciones del formato que el
+// compresor respeta: los últimos 5 bytes son literales y el último
+// match empieza al menos 12 bytes antes del final.
+//
+// Lo usan las secciones frías de .Po v9: se comprimen al escribir
+// y se descomprimen la primera vez que el loader las toca. Greedy
+// con una tabla hash de 4 KiB entradas: no es el mejor ratio, pero
+// descomprimir es una copia de memoria con saltos.
+// ============================================================
+
+const MIN_MATCH: usize = 4;
+const LAST_LITERALS: usize = 5;
+const MF_LIMIT: usize = 12;
+const MAX_OFFSET: usize = u16::MAX as usize;
+const HASH_LOG: u32 = 12;
+
+fn read_u32(b: &[u8], at: usize) -> u32 {
+    u32::from_le_bytes([b[at], b[at + 1], b[at + 2], b[at + 3]])
+}
+
+fn push_length(out: &mut Vec<u8>, mut rest: usize) {
+    while rest >= 255 {
+        out.push(255);
+        rest -= 255;
+    }
+    out.push(rest as u8);
+}
+
+fn push_sequence(out: &mut Vec<u8>, literals: &[u8], m: Option<(u16, usize)>) {
+    let lit = literals.len();
+    let match_code = m.map_or(0, |(_, len)| (len - MIN_MATCH).min(15));
+    out.push(((lit.min(15) as u8) << 4) | match_code as u8);
+    if lit >= 15 {
+        push_length(out, lit - 15);
+    }
+    out.extend_from_slice(literals);
+    if let Some((offset, len)) = m {
+        out.extend_from_slice(&offset.to_le_bytes());
+        if len - MIN_MATCH >= 15 {
+            push_length(out, len - MIN_MATCH - 15);
+        }
+    }
+}
+
+/// Comprime `input` a un bloque LZ4
+pub fn compress(input: &[u8]) -> Vec<u8> {
+    let n = input.len();
+    let mut out = Vec::with_capacity(n / 2 + 16);
+    let mut anchor = 0;
+    if n > MF_LIMIT {
+        // Posición + 1 del último sitio con ese hash (0 = vacío)
+        let mut table = vec![0u32; 1 << HASH_LOG];
+        let mut i = 0;
+        while i + MF_LIMIT <= n {
+            let seq = read_u32(input, i);
+            let h = (seq.wrapping_mul(2_654_435_761) >> (32 - HASH_LOG)) as usize;
+            let candidate = table[h] as usize;
+            table[h] = i as u32 + 1;
+            if candidate > 0 {
+                let c = candidate - 1;
+                if i - c <= MAX_OFFSET && read_u32(input, c) == seq {
+                    let mut len = MIN_MATCH;
+                    while i + len < n - LAST_LITERALS && input[c + len] == input[i + len] {
+                        len += 1;
+                    }
+                    push_sequence(&mut out, &input[anchor..i], Some(((i - c) as u16, len)));
+                    i += len;
+                    anchor = i;
+                    continue;
+                }
+            }
+            i += 1;
+        }
+    }
+    push_sequence(&mut out, &input[anchor..], None);
+    out
+}
+
+/// Descomprime un bloque que debe dar exactamente `size` bytes
+pub fn decompress(input: &[u8], size: usize) -> Result<Vec<u8>, String> {
+    let truncated = || "truncated LZ4 block".to_string();
+    let mut out = Vec::with_capacity(size);
+    let mut at = 0;
+    let read_length = |at: &mut usize, mut len: usize| -> Result<usize, String> {
+        loop {
+            let byte = *input.get(*at).ok_or_else(truncated)?;
+            *at += 1;
+            len += byte as usize;
+            if byte != 255 {
+                return Ok(len);
+            }
+        }
+    };
+    loop {
+        let token = *input.get(at).ok_or_else(truncated)?;
+        at += 1;
+        let mut lit = (token >> 4) as usize;
+        if lit == 15 {
+            lit = read_length(&mut at, lit)?;
+        }
+        let literals = input.get(at..at + lit).ok_or_else(truncated)?;
+        if out.len() + lit > size {
+            return Err("LZ4 block is larger than its section".to_string());
+        }
+        out.extend_from_slice(literals);
+        at += lit;
+        if at == input.len() {
+            break;
+        }
+
+        let offset = u16::from_le_bytes([*input.get(at).ok_or_else(truncated)?, *input.get(at + 1).ok_or_else(truncated)?]) as usize;
+        at += 2;
+        let mut len = (token & 0x0F) as usize;
+        if len == 15 {
+            len = read_length(&mut at, len)?;
+        }
+        len += MIN_MATCH;
+        if offset == 0 || offset > out.len() {
+            return Err(format!("LZ4 match offset {} out of range", offset));
+        }
+        if out.len() + len > size {
+            return Err("LZ4 block is larger than its section".to_string());
+        }
+        // Solapado a propósito: offset < len repite el patrón
+        let start = out.len() - offset;
+        for k in 0..len {
+            out.push(out[start + k]);
+        }
+    }
+    if out.len() != size {
+        return Err(format!("LZ4 block gave {} bytes, expected {}", out.len(), size));
+    }
+    Ok(out)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn round_trip(input: &[u8]) -> Vec<u8> {
+        let packed = compress(input);
+        assert_eq!(decompress(&packed, input.len()).unwrap(), input);
+        packed
+    }
+
+    #[test]
+    fn test_round_trip_sizes() {
+        round_trip(b"");
+        round_trip(b"a");
+        round_trip(b"abcdefghijkl");
+        round_trip(b"abcdefghijklm");
+        let code: Vec<u8> = (0..20_000u32).map(|i| (i.wrapping_mul(2_654_435_761) >> 24) as u8).collect();
+        round_trip(&code);
+    }
+
+    #[test]
+    fn test_repetitive_input_shrinks() {
+        let mut cold = Vec::new();
+        for i in 0..2000u32 {
+            // Secuencias tipo prólogo/epílogo repetidas
+            cold.extend_from_slice(&[0x55, 0x48, 0x89, 0xE5, 0x48, 0x83, 0xEC, 0x20]);
+            cold.extend_from_slice(&i.to_le_bytes());
+            cold.extend_from_slice(&[0x48, 0x89, 0xEC, 0x5D, 0xC3]);
+        }
+        cold.extend(std::iter::repeat(0xCC).take(70_000));
+        let packed = round_trip(&cold);
+        assert!(packed.len() * 3 < cold.len(), "{} -> {}", cold.len(), packed.len());
+        // Formato: los últimos 5 bytes del original salen como literales
+        assert_eq!(&packed[packed.len() - 5..], &cold[cold.len() - 5..]);
+    }
+
+    #[test]
+    fn test_decompress_rejects_bad_blocks() {
+        let packed = compress(&[7u8; 1000]);
+        assert!(decompress(&packed, 999).is_err());
+        assert!(decompress(&packed, 1001).is_err());
+        assert!(decompress(&packed[..packed.len() - 1], 1000).is_err());
+        // Offset 0 y offset más allá del principio
+        assert!(decompress(&[0x10, b'x', 0, 0], 5).is_err());
+        assert!(decompress(&[0x10, b'x', 9, 0], 5).is_err());
+    }
+}
@@ -5,6 +5,7 @@
 //
 // v1.0: 24-byte header — 64-bit standard
 // v8.0: 32-byte header — 16/64/128/256-bit support
+// v9.0: header + tabla de secciones, secciones alineadas a página
 //
 // Po header v8.0 (32 bytes):
 //   magic:     0x506F4F53 ('PoOS')       4 bytes
@@ -18,9 +19,30 @@
 //   soa_map:   offset to SoA table       4 bytes
 //   bg_stamp:  BG verification hash      4 bytes
 //
+// Po v9.0 (paginado): el loader mapea el fichero en vez de copiarlo.
+//   header (32 bytes):
+//     magic, version 0x90, bits, ymm_used     8 bytes (como v8)
+//     page_shift (12 = 4 KiB)                 1 byte
+//     section_count                           1 byte
+//     reserved                                2 bytes
+//     entry:     vaddr del punto de entrada   4 bytes
+//     image_size: vaddr final, alineado       4 bytes
+//     section_table: offset en fichero (32)   4 bytes
+//     soa_map, bg_stamp                       8 bytes
+//   sección (32 bytes):
+//     name[8], flags u32, vaddr, vsize, offset, stored, size
+// vaddr y offset son múltiplos de página: .text y lo read-only se
+// mapean tal cual y se comparten entre procesos, .data se mapea
+// privada (copy-on-write) y lo que pasa de `size` hasta `vsize` son
+// ceros (bss). Una sección PO_SEC_LZ4 guarda `stored` bytes LZ4 que
+// dan `size` bytes: el loader reserva sus páginas y la descomprime
+// la primera vez que se toca.
+//
 // NSA abre binario → Google '0x506F4F53' → 0 resultados → "._."
 // ============================================================
 
+use crate::lz4;
+
 /// Po magic: 0x506F4F53 = 'PoOS' (4 bytes, little-endian)
 pub const PO_MAGIC: u32 = 0x506F4F53;
 
@@ -31,6 +53,21 @@ pub const PO_MAGIC_V1: [u8; 6] = *b"FASTOS";
 pub const PO_VERSION_V1: u8 = 0x10;
 pub const PO_VERSION_V2: u8 = 0x20;
 pub const PO_VERSION_V8: u8 = 0x80;
+pub const PO_VERSION_V9: u8 = 0x90;
+
+/// Páginas de 4 KiB (x86-64 y FastOS)
+pub const PO_PAGE_SHIFT: u8 = 12;
+pub const PO_PAGE_SIZE: u32 = 1 << PO_PAGE_SHIFT;
+
+/// Flags de sección (v9)
+pub const PO_SEC_READ: u32 = 0x01;
+pub const PO_SEC_WRITE: u32 = 0x02;
+pub const PO_SEC_EXEC: u32 = 0x04;
+/// Contenido comprimido con LZ4, se descomprime al primer acceso
+pub const PO_SEC_LZ4: u32 = 0x10;
+
+const PO_V9_HEADER_SIZE: u32 = 32;
+const PO_V9_SECTION_SIZE: u32 = 32;
 
 /// Bit width identifiers for Po header
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -139,6 +176,276 @@ impl PoHeader {
     }
 }
 
+fn page_align(v: u32) -> u32 {
+    (v + PO_PAGE_SIZE - 1) & !(PO_PAGE_SIZE - 1)
+}
+
+fn le32(b: &[u8], at: usize) -> u32 {
+    u32::from_le_bytes([b[at], b[at + 1], b[at + 2], b[at + 3]])
+}
+
+/// Entrada de la tabla de secciones v9 (32 bytes)
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct PoSection {
+    pub name: [u8; 8],
+    pub flags: u32,
+    /// Offset desde la base de carga, múltiplo de página
+    pub vaddr: u32,
+    /// Bytes en memoria; de `size` a `vsize` son ceros
+    pub vsize: u32,
+    /// Offset en fichero, múltiplo de página (0 si no hay contenido)
+    pub offset: u32,
+    /// Bytes en fichero (comprimidos con PO_SEC_LZ4)
+    pub stored: u32,
+    /// Bytes de contenido sin comprimir
+    pub size: u32,
+}
+
+impl PoSection {
+    pub fn name(&self) -> &str {
+        let len = self.name.iter().position(|&c| c == 0).unwrap_or(8);
+        std::str::from_utf8(&self.name[..len]).unwrap_or("")
+    }
+
+    pub fn to_bytes(&self) -> [u8; 32] {
+        let mut buf = [0u8; 32];
+        buf[0..8].copy_from_slice(&self.name);
+        buf[8..12].copy_from_slice(&self.flags.to_le_bytes());
+        buf[12..16].copy_from_slice(&self.vaddr.to_le_bytes());
+        buf[16..20].copy_from_slice(&self.vsize.to_le_bytes());
+        buf[20..24].copy_from_slice(&self.offset.to_le_bytes());
+        buf[24..28].copy_from_slice(&self.stored.to_le_bytes());
+        buf[28..32].copy_from_slice(&self.size.to_le_bytes());
+        buf
+    }
+
+    pub fn from_bytes(buf: &[u8]) -> Option<Self> {
+        let buf = buf.get(..32)?;
+        Some(Self {
+            name: buf[0..8].try_into().ok()?,
+            flags: le32(buf, 8),
+            vaddr: le32(buf, 12),
+            vsize: le32(buf, 16),
+            offset: le32(buf, 20),
+            stored: le32(buf, 24),
+            size: le32(buf, 28),
+        })
+    }
+}
+
+/// Layout de un .Po v9: secciones en orden de dirección, cada una
+/// empezando en página nueva tanto en memoria como en fichero
+#[derive(Debug, Clone)]
+pub struct PoLayout {
+    pub bits: PoBits,
+    pub ymm_used: u16,
+    pub bg_stamp: u32,
+    pub soa_map: u32,
+    pub entry: u32,
+    sections: Vec<(PoSection, Vec<u8>)>,
+    next_vaddr: u32,
+}
+
+impl PoLayout {
+    pub fn new(bits: PoBits) -> Self {
+        Self {
+            bits,
+            ymm_used: 0,
+            bg_stamp: 0,
+            soa_map: 0,
+            entry: 0,
+            sections: Vec::new(),
+            // La página 0 queda para header y tabla: un puntero nulo
+            // relativo a la base nunca cae en código
+            next_vaddr: PO_PAGE_SIZE,
+        }
+    }
+
+    /// Añade una sección con `bytes` de contenido y `vsize` en memoria
+    /// (al menos `bytes.len()`). Con PO_SEC_LZ4 se comprime, salvo que
+    /// no gane nada. Devuelve su vaddr, para enlazar contra ella.
+    pub fn push(&mut self, name: &str, flags: u32, bytes: &[u8], vsize: u32) -> u32 {
+        let size = bytes.len() as u32;
+        let vsize = vsize.max(size);
+        let mut flags = flags;
+        let stored = if flags & PO_SEC_LZ4 != 0 {
+            let packed = lz4::compress(bytes);
+            if packed.len() < bytes.len() {
+                packed
+            } else {
+                flags &= !PO_SEC_LZ4;
+                bytes.to_vec()
+            }
+        } else {
+            bytes.to_vec()
+        };
+        let mut field = [0u8; 8];
+        let n = name.len().min(8);
+        field[..n].copy_from_slice(&name.as_bytes()[..n]);
+        let vaddr = self.next_vaddr;
+        self.next_vaddr = vaddr + page_align(vsize.max(1));
+        let section = PoSection { name: field, flags, vaddr, vsize, offset: 0, stored: stored.len() as u32, size };
+        self.sections.push((section, stored));
+        vaddr
+    }
+
+    /// Header + tabla en la primera página, cada sección en su página
+    pub fn to_bytes(&self) -> Vec<u8> {
+        let table_end = PO_V9_HEADER_SIZE + PO_V9_SECTION_SIZE * self.sections.len() as u32;
+        let mut offset = page_align(table_end);
+        let mut table = Vec::with_capacity(self.sections.len());
+        for (section, stored) in &self.sections {
+            let mut section = section.clone();
+            if !stored.is_empty() {
+                section.offset = offset;
+                offset = page_align(offset + stored.len() as u32);
+            }
+            table.push(section);
+        }
+        // El último contenido no necesita la cola de relleno
+        let file_len = table
+            .iter()
+            .filter(|s| s.stored > 0)
+            .map(|s| s.offset + s.stored)
+            .max()
+            .unwrap_or(table_end);
+
+        let mut out = vec![0u8; file_len as usize];
+        out[0..4].copy_from_slice(&PO_MAGIC.to_le_bytes());
+        out[4] = PO_VERSION_V9;
+        out[5] = self.bits as u8;
+        out[6..8].copy_from_slice(&self.ymm_used.to_le_bytes());
+        out[8] = PO_PAGE_SHIFT;
+        out[9] = self.sections.len() as u8;
+        out[12..16].copy_from_slice(&self.entry.to_le_bytes());
+        out[16..20].copy_from_slice(&self.next_vaddr.to_le_bytes());
+        out[20..24].copy_from_slice(&PO_V9_HEADER_SIZE.to_le_bytes());
+        out[24..28].copy_from_slice(&self.soa_map.to_le_bytes());
+        out[28..32].copy_from_slice(&self.bg_stamp.to_le_bytes());
+        for (i, (section, (_, stored))) in table.iter().zip(&self.sections).enumerate() {
+            let at = (PO_V9_HEADER_SIZE + PO_V9_SECTION_SIZE * i as u32) as usize;
+            out[at..at + 32].copy_from_slice(&section.to_bytes());
+            let start = section.offset as usize;
+            out[start..start + stored.len()].copy_from_slice(stored);
+        }
+        out
+    }
+}
+
+/// Qué hace el loader con cada sección al cargar
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum PoMapping {
+    /// mmap del fichero: compartida si no es escribible, si no privada
+    /// (copy-on-write). Páginas de `file_len` a `len` van a cero.
+    File { offset: u32, file_len: u32, shared: bool },
+    /// Sólo páginas a cero (bss)
+    Zero,
+    /// Páginas reservadas sin acceso; el primer fallo descomprime
+    Deferred,
+}
+
+/// Un .Po v9 ya en memoria (el fichero mapeado): parsea header y tabla
+/// sin copiar nada y descomprime las secciones LZ4 al primer acceso
+#[derive(Debug)]
+pub struct PoImage<'a> {
+    file: &'a [u8],
+    pub bits: u8,
+    pub ymm_used: u16,
+    pub entry: u32,
+    pub image_size: u32,
+    pub soa_map: u32,
+    pub bg_stamp: u32,
+    pub sections: Vec<PoSection>,
+    unpacked: Vec<std::cell::OnceCell<Vec<u8>>>,
+}
+
+impl<'a> PoImage<'a> {
+    pub fn parse(file: &'a [u8]) -> Result<Self, String> {
+        let header = file.get(..PO_V9_HEADER_SIZE as usize).ok_or("truncated Po header")?;
+        if le32(header, 0) != PO_MAGIC {
+            return Err("not a Po image (bad magic)".to_string());
+        }
+        if header[4] != PO_VERSION_V9 {
+            return Err(format!("Po version {:#04x} is not paged (v9)", header[4]));
+        }
+        if header[8] != PO_PAGE_SHIFT {
+            return Err(format!("unsupported Po page size 2^{}", header[8]));
+        }
+        let count = header[9] as usize;
+        let table = le32(header, 20) as usize;
+        let image_size = le32(header, 16);
+        let mut sections = Vec::with_capacity(count);
+        for i in 0..count {
+            let at = table + i * PO_V9_SECTION_SIZE as usize;
+            let section = file.get(at..).and_then(PoSection::from_bytes).ok_or("truncated Po section table")?;
+            let aligned = section.vaddr % PO_PAGE_SIZE == 0 && (section.stored == 0 || section.offset % PO_PAGE_SIZE == 0);
+            let in_file = (section.offset as usize).checked_add(section.stored as usize).is_some_and(|end| end <= file.len());
+            let in_image = section.vaddr.checked_add(section.vsize).is_some_and(|end| end <= image_size);
+            if !aligned || !in_file || !in_image || section.size > section.vsize {
+                return Err(format!("malformed Po section '{}'", section.name()));
+            }
+            if section.flags & PO_SEC_LZ4 == 0 && section.stored != section.size {
+                return Err(format!("Po section '{}' stores {} of {} bytes", section.name(), section.stored, section.size));
+            }
+            sections.push(section);
+        }
+        Ok(Self {
+            file,
+            bits: header[5],
+            ymm_used: u16::from_le_bytes([header[6], header[7]]),
+            entry: le32(header, 12),
+            image_size,
+            soa_map: le32(header, 24),
+            bg_stamp: le32(header, 28),
+            unpacked: (0..count).map(|_| std::cell::OnceCell::new()).collect(),
+            sections,
+        })
+    }
+
+    /// Plan de carga: nada se lee ni se descomprime todavía
+    pub fn mappings(&self) -> Vec<(&PoSection, PoMapping)> {
+        self.sections
+            .iter()
+            .map(|s| {
+                let mapping = if s.flags & PO_SEC_LZ4 != 0 {
+                    PoMapping::Deferred
+                } else if s.stored == 0 {
+                    PoMapping::Zero
+                } else {
+                    PoMapping::File { offset: s.offset, file_len: s.stored, shared: s.flags & PO_SEC_WRITE == 0 }
+                };
+                (s, mapping)
+            })
+            .collect()
+    }
+
+    pub fn find(&self, name: &str) -> Option<usize> {
+        self.sections.iter().position(|s| s.name() == name)
+    }
+
+    /// Contenido de la sección `index` (sin la cola de ceros): un slice
+    /// del fichero o, con LZ4, lo descomprimido en el primer acceso
+    pub fn section_bytes(&self, index: usize) -> Result<&[u8], String> {
+        let section = self.sections.get(index).ok_or("no such Po section")?;
+        let stored = &self.file[section.offset as usize..(section.offset + section.stored) as usize];
+        if section.flags & PO_SEC_LZ4 == 0 {
+            return Ok(stored);
+        }
+        let cell = &self.unpacked[index];
+        if let Some(bytes) = cell.get() {
+            return Ok(bytes);
+        }
+        let bytes = lz4::decompress(stored, section.size as usize)
+            .map_err(|e| format!("Po section '{}': {}", section.name(), e))?;
+        Ok(cell.get_or_init(|| bytes))
+    }
+
+    /// Secciones comprimidas que ya se descomprimieron
+    pub fn unpacked_count(&self) -> usize {
+        self.unpacked.iter().filter(|c| c.get().is_some()).count()
+    }
+}
+
 pub struct PoOutput;
 
 impl PoOutput {
@@ -195,6 +502,34 @@ impl PoOutput {
         Ok(total)
     }
 
+    /// Genera un .Po v9 paginado: .text (R+X, compartible), .data
+    /// (R+W, privada) y, si hay, .cold comprimida con LZ4. El entry
+    /// point es el inicio de .text.
+    pub fn generate_paged(
+        &self,
+        code: &[u8],
+        data: &[u8],
+        cold: &[u8],
+        bits: PoBits,
+        ymm_used: u16,
+        bg_stamp: u32,
+        output_path: &str,
+    ) -> Result<usize, Box<dyn std::error::Error>> {
+        let mut layout = PoLayout::new(bits);
+        layout.ymm_used = ymm_used;
+        layout.bg_stamp = bg_stamp;
+        layout.entry = layout.push(".text", PO_SEC_READ | PO_SEC_EXEC, code, 0);
+        if !data.is_empty() {
+            layout.push(".data", PO_SEC_READ | PO_SEC_WRITE, data, 0);
+        }
+        if !cold.is_empty() {
+            layout.push(".cold", PO_SEC_READ | PO_SEC_EXEC | PO_SEC_LZ4, cold, 0);
+        }
+        let binary = layout.to_bytes();
+        std::fs::write(output_path, &binary)?;
+        Ok(binary.len())
+    }
+
     /// Generate legacy v1 format (24-byte header) for backward compat
     pub fn generate_v1(
         &self,
@@ -280,6 +615,85 @@ mod tests {
         assert_eq!(PoBits::from_width(16).to_actual_bits(), 16);
     }
 
+    fn paged_sample() -> (Vec<u8>, Vec<u8>, Vec<u8>) {
+        let code: Vec<u8> = (0..5000u32).map(|i| i as u8).collect();
+        let data = b"hello, FastOS\0".to_vec();
+        let mut cold = Vec::new();
+        for _ in 0..3000 {
+            cold.extend_from_slice(&[0x55, 0x48, 0x89, 0xE5, 0x5D, 0xC3]);
+        }
+        (code, data, cold)
+    }
+
+    #[test]
+    fn test_paged_layout_is_page_aligned() {
+        let (code, data, cold) = paged_sample();
+        let mut layout = PoLayout::new(PoBits::Bits64);
+        let text = layout.push(".text", PO_SEC_READ | PO_SEC_EXEC, &code, 0);
+        let bss = layout.push(".data", PO_SEC_READ | PO_SEC_WRITE, &data, 0x3000);
+        let cold_at = layout.push(".cold", PO_SEC_READ | PO_SEC_EXEC | PO_SEC_LZ4, &cold, 0);
+        layout.entry = text;
+        assert_eq!((text, bss, cold_at), (0x1000, 0x3000, 0x6000));
+        let file = layout.to_bytes();
+
+        let image = PoImage::parse(&file).unwrap();
+        assert_eq!((image.entry, image.image_size), (0x1000, 0xB000));
+        for s in &image.sections {
+            assert_eq!(s.vaddr % PO_PAGE_SIZE, 0);
+            assert_eq!(s.offset % PO_PAGE_SIZE, 0);
+        }
+        let mappings = image.mappings();
+        assert_eq!(mappings[0].1, PoMapping::File { offset: 0x1000, file_len: 5000, shared: true });
+        assert_eq!(mappings[1].1, PoMapping::File { offset: 0x3000, file_len: data.len() as u32, shared: false });
+        assert_eq!(mappings[1].0.vsize, 0x3000);
+        assert_eq!(mappings[2].1, PoMapping::Deferred);
+        assert!(mappings[2].0.stored < mappings[2].0.size / 4);
+    }
+
+    #[test]
+    fn test_paged_loader_unpacks_on_first_touch() {
+        let (code, data, cold) = paged_sample();
+        let dir = std::env::temp_dir().join(format!("adeb_po_v9_{}.po", std::process::id()));
+        let path = dir.to_str().unwrap();
+        let size = PoOutput::new().generate_paged(&code, &data, &cold, PoBits::Bits256, 0x3, 7, path).unwrap();
+        let file = std::fs::read(path).unwrap();
+        let _ = std::fs::remove_file(path);
+        assert_eq!(size, file.len());
+
+        let image = PoImage::parse(&file).unwrap();
+        assert_eq!((image.bits, image.ymm_used, image.bg_stamp), (PoBits::Bits256 as u8, 0x3, 7));
+        let text = image.find(".text").unwrap();
+        assert_eq!(image.section_bytes(text).unwrap(), &code[..]);
+        // El slice de .text apunta al propio fichero: cero copias
+        assert_eq!(image.section_bytes(text).unwrap().as_ptr(), file[0x1000..].as_ptr());
+        assert_eq!(image.unpacked_count(), 0);
+        let cold_index = image.find(".cold").unwrap();
+        assert_eq!(image.section_bytes(cold_index).unwrap(), &cold[..]);
+        assert_eq!(image.section_bytes(cold_index).unwrap(), &cold[..]);
+        assert_eq!(image.unpacked_count(), 1);
+        assert_eq!(image.section_bytes(image.find(".data").unwrap()).unwrap(), &data[..]);
+    }
+
+    #[test]
+    fn test_paged_parse_rejects_bad_images() {
+        let (code, _, _) = paged_sample();
+        let mut layout = PoLayout::new(PoBits::Bits64);
+        layout.push(".text", PO_SEC_READ | PO_SEC_EXEC, &code, 0);
+        // Datos incompresibles: LZ4 se descarta y la sección va tal cual
+        let noise: Vec<u8> = (0..64u32).map(|i| (i.wrapping_mul(2_654_435_761) >> 24) as u8).collect();
+        layout.push(".cold", PO_SEC_READ | PO_SEC_LZ4, &noise, 0);
+        let file = layout.to_bytes();
+        let image = PoImage::parse(&file).unwrap();
+        assert_eq!(image.sections[1].flags & PO_SEC_LZ4, 0);
+
+        assert!(PoImage::parse(&file[..0x1000]).is_err());
+        let mut unaligned = file.clone();
+        unaligned[32 + 12] = 0x10; // vaddr de .text = 0x1010
+        assert!(PoImage::parse(&unaligned).is_err());
+        let v8 = PoHeader::new_v8(PoBits::Bits64).to_bytes();
+        assert!(PoImage::parse(&v8).is_err());
+    }
+
     #[test]
     fn test_po_bad_magic() {
         let buf = [0u8; 32]; // all zeros — bad magic
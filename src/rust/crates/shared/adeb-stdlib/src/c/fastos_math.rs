@@ -4,6 +4,11 @@
 // sin, cos, tan, sqrt, pow, log, PI, E, TAU
 // Implementado con instrucciones x87 FPU y SSE2
 // SIN libc — SIN linker externo
+//
+// sin/cos/exp/log/pow/sqrt/tanh (y las versiones `f`) tienen además
+// implementación propia en AVX2 (backend isa/vec_math.rs): rutinas
+// vectoriales `_ZGVdN8v_sinf`, `_ZGVdN4v_sin`... que usa el loop
+// vectorizer y, fuera de Windows, también la llamada escalar.
 // ============================================================
 
 pub const MATH_FUNCTIONS: &[&str] = &[
@@ -35,7 +40,7 @@ pub const MATH_FUNCTIONS: &[&str] = &[
     "nan", "nanf",
     "scalbn", "scalbln",
     // Float variants
-    "sinf", "cosf", "tanf", "sqrtf", "powf", "logf",
+    "sinf", "cosf", "tanf", "sqrtf", "powf", "logf", "expf", "tanhf",
     "floorf", "ceilf", "roundf", "truncf",
     // Extended rounding
     "lround", "llround", "lroundf", "llroundf",
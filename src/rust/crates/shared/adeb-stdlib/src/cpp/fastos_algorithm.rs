@@ -2,6 +2,9 @@
 // fastos_algorithm.rs — <algorithm> implementation
 // ============================================================
 // std::sort, find, copy, transform, reverse, etc.
+// sort/reduce/transform/for_each with std::execution::par or
+// par_unseq lower to the backend's parallel algorithms on the
+// work-stealing pool (adeb-backend-x64 isa/par_algorithms.rs)
 // ============================================================
 
 pub const ALGORITHM_FUNCTIONS: &[&str] = &[
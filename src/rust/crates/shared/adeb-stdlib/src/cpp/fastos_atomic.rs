@@ -2,6 +2,9 @@
 // fastos_atomic.rs — <atomic> implementation
 // ============================================================
 // std::atomic<T>, std::atomic_flag, memory_order
+//
+// Word-sized atomics lower inline to mov/xchg/lock xadd/lock cmpxchg
+// (backend isa/sync.rs); every order is seq_cst on x86.
 // ============================================================
 
 pub const ATOMIC_TYPES: &[&str] = &["atomic", "atomic_flag", "memory_order"];
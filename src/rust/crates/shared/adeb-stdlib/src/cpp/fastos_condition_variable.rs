@@ -2,6 +2,10 @@
 // fastos_condition_variable.rs — <condition_variable> implementation
 // ============================================================
 // std::condition_variable, std::condition_variable_any
+//
+// A sequence word + waiter count on a futex (Linux) or a Win32
+// CONDITION_VARIABLE over the SRWLOCK (backend isa/sync.rs).
+// wait(lk, pred) lowers to while (!pred) wait(lk).
 // ============================================================
 
 pub const CV_TYPES: &[&str] = &["condition_variable", "condition_variable_any", "cv_status"];
@@ -3,11 +3,14 @@
 // ============================================================
 // std::future / std::promise — Asynchronous result passing
 // Task-based parallelism with std::async
+// std::async (any launch policy), future::get/wait and
+// adb::parallel_for lower to the backend's work-stealing pool
+// (adeb-backend-x64 isa/task_pool.rs), not one thread per task
 // ============================================================
 
 pub const FUTURE_TYPES: &[&str] = &["future", "shared_future", "promise", "packaged_task", "launch", "future_status"];
 
-pub const FUTURE_FUNCTIONS: &[&str] = &["async"];
+pub const FUTURE_FUNCTIONS: &[&str] = &["async", "parallel_for", "pool_size"];
 
 pub const FUTURE_METHODS: &[&str] = &[
     "get", "wait", "wait_for", "wait_until", "valid", "share",
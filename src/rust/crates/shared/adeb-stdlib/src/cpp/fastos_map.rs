@@ -2,6 +2,9 @@
 // fastos_map.rs — <map> implementation
 // ============================================================
 // std::map<K,V> — Red-Black Tree ordered map
+// With integer/pointer keys and values, std::map lowers to the backend's
+// B-tree (adeb-backend-x64 isa/btree.rs) and std::unordered_map to its
+// flat open-addressing table (isa/flat_hash.rs)
 // ============================================================
 
 pub const MAP_METHODS: &[&str] = &[
@@ -2,6 +2,10 @@
 // fastos_mutex.rs — <mutex> implementation
 // ============================================================
 // std::mutex, std::lock_guard, std::unique_lock, std::scoped_lock
+//
+// std::mutex is one word: a lock cmpxchg fast path inline, a bounded
+// spin, then futex (Linux) or SRWLOCK (Windows) — backend isa/sync.rs.
+// Guards lock at declaration and unlock on every scope exit.
 // ============================================================
 
 pub const MUTEX_TYPES: &[&str] = &[
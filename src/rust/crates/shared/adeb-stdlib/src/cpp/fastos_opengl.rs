@@ -1,6 +1,7 @@
 pub fn generate_opengl_hpp() -> String {
 r#"// ad_opengl.hpp — ADead-BIB OpenGL Header
 // OpenGL 1.0–1.1 + WGL — Sin dependencias externas
+// Shaders GL 2.0+ y caché de program binary (GL 4.1) vía wglGetProcAddress
 // Autor: Eddi Andreé Salazar Matos — Marzo 2026
 
 #ifndef ADEAD_OPENGL_H
@@ -123,6 +124,314 @@ extern "C" {
 #define PFD_DOUBLEBUFFER    0x00000001
 #define PFD_TYPE_RGBA       0
 
+// ── GL 2.0+ shaders y GL 4.1 program binary — cargados con wglGetProcAddress ──
+typedef char GLchar;
+
+#define GL_GEOMETRY_SHADER                 0x8DD9
+#define GL_COMPUTE_SHADER                  0x91B9
+#define GL_INFO_LOG_LENGTH                 0x8B84
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+#define GL_SHADER_BINARY_FORMAT_SPIR_V     0x9551
+
+typedef GLuint (*PFN_glCreateShader)(GLenum type);
+typedef void   (*PFN_glShaderSource)(GLuint shader, GLsizei count, const GLchar** strings, const GLint* lengths);
+typedef void   (*PFN_glCompileShader)(GLuint shader);
+typedef void   (*PFN_glGetShaderiv)(GLuint shader, GLenum pname, GLint* params);
+typedef void   (*PFN_glDeleteShader)(GLuint shader);
+typedef GLuint (*PFN_glCreateProgram)();
+typedef void   (*PFN_glDeleteProgram)(GLuint program);
+typedef void   (*PFN_glAttachShader)(GLuint program, GLuint shader);
+typedef void   (*PFN_glLinkProgram)(GLuint program);
+typedef void   (*PFN_glUseProgram)(GLuint program);
+typedef void   (*PFN_glGetProgramiv)(GLuint program, GLenum pname, GLint* params);
+typedef void   (*PFN_glProgramParameteri)(GLuint program, GLenum pname, GLint value);
+typedef void   (*PFN_glGetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void   (*PFN_glProgramBinary)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void   (*PFN_glShaderBinary)(GLsizei count, const GLuint* shaders, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void   (*PFN_glSpecializeShader)(GLuint shader, const GLchar* entry, GLuint numSpec, const GLuint* indices, const GLuint* values);
+
+extern "C" {
+    void* wglGetProcAddress(const char* name);
+    void* fopen(const char* path, const char* mode);
+    int   fclose(void* f);
+    unsigned long long fread(void* buf, unsigned long long size, unsigned long long n, void* f);
+    unsigned long long fwrite(const void* buf, unsigned long long size, unsigned long long n, void* f);
+    int   remove(const char* path);
+    int   rename(const char* from, const char* to);
+    int   CreateDirectoryA(const char* path, void* security);
+    void* malloc(unsigned long long size);
+    void  free(void* p);
+}
+
+PFN_glCreateShader glCreateShader = 0;
+PFN_glShaderSource glShaderSource = 0;
+PFN_glCompileShader glCompileShader = 0;
+PFN_glGetShaderiv glGetShaderiv = 0;
+PFN_glDeleteShader glDeleteShader = 0;
+PFN_glCreateProgram glCreateProgram = 0;
+PFN_glDeleteProgram glDeleteProgram = 0;
+PFN_glAttachShader glAttachShader = 0;
+PFN_glLinkProgram glLinkProgram = 0;
+PFN_glUseProgram glUseProgram = 0;
+PFN_glGetProgramiv glGetProgramiv = 0;
+PFN_glProgramParameteri glProgramParameteri = 0;
+PFN_glGetProgramBinary glGetProgramBinary = 0;
+PFN_glProgramBinary glProgramBinary = 0;
+PFN_glShaderBinary glShaderBinary = 0;
+PFN_glSpecializeShader glSpecializeShader = 0;
+
+// Requiere un contexto GL actual (wglMakeCurrent). Devuelve 1 si hay
+// shaders GL 2.0; program binary (4.1) y SPIR-V (4.6) son opcionales.
+extern "C" int adLoadShaderFunctions() {
+    glCreateShader = (PFN_glCreateShader)wglGetProcAddress("glCreateShader");
+    glShaderSource = (PFN_glShaderSource)wglGetProcAddress("glShaderSource");
+    glCompileShader = (PFN_glCompileShader)wglGetProcAddress("glCompileShader");
+    glGetShaderiv = (PFN_glGetShaderiv)wglGetProcAddress("glGetShaderiv");
+    glDeleteShader = (PFN_glDeleteShader)wglGetProcAddress("glDeleteShader");
+    glCreateProgram = (PFN_glCreateProgram)wglGetProcAddress("glCreateProgram");
+    glDeleteProgram = (PFN_glDeleteProgram)wglGetProcAddress("glDeleteProgram");
+    glAttachShader = (PFN_glAttachShader)wglGetProcAddress("glAttachShader");
+    glLinkProgram = (PFN_glLinkProgram)wglGetProcAddress("glLinkProgram");
+    glUseProgram = (PFN_glUseProgram)wglGetProcAddress("glUseProgram");
+    glGetProgramiv = (PFN_glGetProgramiv)wglGetProcAddress("glGetProgramiv");
+    glProgramParameteri = (PFN_glProgramParameteri)wglGetProcAddress("glProgramParameteri");
+    glGetProgramBinary = (PFN_glGetProgramBinary)wglGetProcAddress("glGetProgramBinary");
+    glProgramBinary = (PFN_glProgramBinary)wglGetProcAddress("glProgramBinary");
+    glShaderBinary = (PFN_glShaderBinary)wglGetProcAddress("glShaderBinary");
+    glSpecializeShader = (PFN_glSpecializeShader)wglGetProcAddress("glSpecializeShader");
+    if (glCreateShader == nullptr || glCreateProgram == nullptr || glLinkProgram == nullptr) return 0;
+    return 1;
+}
+
+// ── Program binary cache ──
+// Clave FNV-1a 64 sobre cada etapa (enum, longitud, fuente), las spec
+// constants y GL_VENDOR/GL_RENDERER/GL_VERSION. Archivo <dir>/<clave>.glbin:
+//   u32 'ADGB', u32 versión, u32 binaryFormat, u32 longitud, bytes
+// Mismo formato que ProgramBinaryCache en shader_bridge.rs. Un binario que
+// el driver rechaza (GL_LINK_STATUS falso) se borra y se recompila.
+static const char* __adb_gl_cache_dir = ".adB-cache";
+static int __adb_gl_cache_hits = 0;
+static int __adb_gl_cache_misses = 0;
+static int __adb_gl_cache_rejected = 0;
+
+static unsigned long long __adb_fnv(unsigned long long h, const void* data, unsigned int len) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (unsigned int i = 0; i < len; i++) {
+        h = h ^ p[i];
+        h = h * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static unsigned long long __adb_fnv_u32(unsigned long long h, unsigned int v) {
+    return __adb_fnv(h, &v, 4);
+}
+
+static unsigned int __adb_strlen(const char* s) {
+    unsigned int n = 0;
+    if (s == nullptr) return 0;
+    while (s[n] != 0) n++;
+    return n;
+}
+
+static unsigned long long __adb_fnv_driver(unsigned long long h) {
+    GLenum names[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (int i = 0; i < 3; i++) {
+        const char* s = (const char*)glGetString(names[i]);
+        h = __adb_fnv(h, s, __adb_strlen(s));
+        h = __adb_fnv(h, "", 1);
+    }
+    return h;
+}
+
+static void __adb_gl_cache_path(char* out, unsigned long long key, const char* suffix) {
+    const char* hex = "0123456789abcdef";
+    unsigned int n = 0;
+    const char* d = __adb_gl_cache_dir;
+    while (d[n] != 0 && n < 200) { out[n] = d[n]; n++; }
+    out[n++] = '/';
+    for (int i = 15; i >= 0; i--) out[n++] = hex[(key >> (i * 4)) & 0xF];
+    for (unsigned int i = 0; suffix[i] != 0; i++) out[n++] = suffix[i];
+    out[n] = 0;
+}
+
+// 1 = cargado, 0 = rechazado (archivo borrado), -1 = sin entrada
+static int __adb_gl_try_binary(GLuint program, unsigned long long key) {
+    char path[256];
+    __adb_gl_cache_path(path, key, ".glbin");
+    void* f = fopen(path, "rb");
+    if (f == nullptr) return -1;
+    unsigned int head[4] = { 0, 0, 0, 0 };
+    int ok = 0;
+    if (fread(head, 4, 4, f) == 4 && head[0] == 0x42474441 && head[1] == 1 && head[3] > 0) {
+        void* data = malloc(head[3]);
+        if (data != nullptr && fread(data, 1, head[3], f) == head[3]) {
+            glProgramBinary(program, head[2], data, (GLsizei)head[3]);
+            GLint status = 0;
+            glGetProgramiv(program, GL_LINK_STATUS, &status);
+            ok = status != 0;
+        }
+        free(data);
+    }
+    fclose(f);
+    if (!ok) remove(path);
+    return ok;
+}
+
+static void __adb_gl_store_binary(GLuint program, unsigned long long key) {
+    GLint len = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &len);
+    if (len <= 0) return;
+    void* data = malloc(len);
+    if (data == nullptr) return;
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, len, &written, &format, data);
+    if (written > 0) {
+        char path[256];
+        char tmp[256];
+        __adb_gl_cache_path(path, key, ".glbin");
+        __adb_gl_cache_path(tmp, key, ".glbin.tmp");
+        CreateDirectoryA(__adb_gl_cache_dir, nullptr);
+        void* f = fopen(tmp, "wb");
+        if (f != nullptr) {
+            unsigned int head[4] = { 0x42474441, 1, format, (unsigned int)written };
+            int ok = fwrite(head, 4, 4, f) == 4 && fwrite(data, 1, written, f) == (unsigned long long)written;
+            fclose(f);
+            remove(path);
+            if (!ok || rename(tmp, path) != 0) remove(tmp);
+        }
+    }
+    free(data);
+}
+
+// Carga desde caché o compila+enlaza con `attach` (compila y adjunta etapas)
+static GLuint __adb_gl_program_cached(unsigned long long key, int (*attach)(GLuint, const void*), const void* ctx) {
+    int cacheable = __adb_gl_cache_dir != nullptr && glProgramBinary != nullptr
+                 && glGetProgramBinary != nullptr && glProgramParameteri != nullptr;
+    GLuint program = glCreateProgram();
+    if (program == 0) return 0;
+    if (cacheable) {
+        int r = __adb_gl_try_binary(program, key);
+        if (r == 1) {
+            __adb_gl_cache_hits++;
+            return program;
+        }
+        if (r == 0) {
+            // glProgramBinary fallido deja el programa inválido: empezar de cero
+            __adb_gl_cache_rejected++;
+            glDeleteProgram(program);
+            program = glCreateProgram();
+        } else {
+            __adb_gl_cache_misses++;
+        }
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    if (!attach(program, ctx)) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    glLinkProgram(program);
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == 0) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    if (cacheable) __adb_gl_store_binary(program, key);
+    return program;
+}
+
+struct __adb_gl_stages {
+    const GLenum* stages;
+    const void* const* sources;
+    const int* sizes;
+    int count;
+    const GLuint* spec_ids;
+    const GLuint* spec_values;
+    int spec_count;
+};
+
+static int __adb_gl_attach_shader(GLuint program, GLuint shader) {
+    GLint ok = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (ok != 0) glAttachShader(program, shader);
+    // El programa conserva la referencia; el shader se libera al enlazar
+    glDeleteShader(shader);
+    return ok != 0;
+}
+
+static int __adb_gl_attach_glsl(GLuint program, const void* ctx) {
+    const __adb_gl_stages* s = (const __adb_gl_stages*)ctx;
+    for (int i = 0; i < s->count; i++) {
+        GLuint sh = glCreateShader(s->stages[i]);
+        const GLchar* src = (const GLchar*)s->sources[i];
+        glShaderSource(sh, 1, &src, nullptr);
+        glCompileShader(sh);
+        if (!__adb_gl_attach_shader(program, sh)) return 0;
+    }
+    return 1;
+}
+
+static int __adb_gl_attach_spirv(GLuint program, const void* ctx) {
+    const __adb_gl_stages* s = (const __adb_gl_stages*)ctx;
+    if (glShaderBinary == nullptr || glSpecializeShader == nullptr) return 0;
+    for (int i = 0; i < s->count; i++) {
+        GLuint sh = glCreateShader(s->stages[i]);
+        glShaderBinary(1, &sh, GL_SHADER_BINARY_FORMAT_SPIR_V, s->sources[i], s->sizes[i]);
+        glSpecializeShader(sh, "main", s->spec_count, s->spec_ids, s->spec_values);
+        if (!__adb_gl_attach_shader(program, sh)) return 0;
+    }
+    return 1;
+}
+
+// Directorio de la caché (por defecto ".adB-cache"); nullptr la desactiva
+extern "C" void adSetProgramCacheDir(const char* dir) {
+    __adb_gl_cache_dir = dir;
+}
+
+extern "C" void adProgramCacheStats(int* hits, int* misses, int* rejected) {
+    if (hits != nullptr) *hits = __adb_gl_cache_hits;
+    if (misses != nullptr) *misses = __adb_gl_cache_misses;
+    if (rejected != nullptr) *rejected = __adb_gl_cache_rejected;
+}
+
+// Programa GLSL (count etapas) — desde caché si el driver acepta el binario
+extern "C" GLuint adCreateProgramCached(const GLenum* stages, const char* const* sources, int count) {
+    unsigned long long key = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < count; i++) {
+        unsigned int len = __adb_strlen(sources[i]);
+        key = __adb_fnv_u32(key, stages[i]);
+        key = __adb_fnv_u32(key, len);
+        key = __adb_fnv(key, sources[i], len);
+    }
+    key = __adb_fnv_driver(key);
+    __adb_gl_stages s = { stages, (const void* const*)sources, nullptr, count, nullptr, nullptr, 0 };
+    return __adb_gl_program_cached(key, __adb_gl_attach_glsl, &s);
+}
+
+// Programa SPIR-V (GL 4.6) con spec constants aplicadas a todas las etapas
+extern "C" GLuint adCreateProgramCachedSpirv(const GLenum* stages, const void* const* binaries, const int* sizes, int count,
+                                             const GLuint* spec_ids, const GLuint* spec_values, int spec_count) {
+    unsigned long long key = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < count; i++) {
+        key = __adb_fnv_u32(key, stages[i]);
+        key = __adb_fnv_u32(key, (unsigned int)sizes[i]);
+        key = __adb_fnv(key, binaries[i], (unsigned int)sizes[i]);
+        key = __adb_fnv(key, "main", 5);
+        key = __adb_fnv_u32(key, (unsigned int)spec_count);
+        for (int j = 0; j < spec_count; j++) {
+            key = __adb_fnv_u32(key, spec_ids[j]);
+            key = __adb_fnv_u32(key, spec_values[j]);
+        }
+    }
+    key = __adb_fnv_driver(key);
+    __adb_gl_stages s = { stages, binaries, sizes, count, spec_ids, spec_values, spec_count };
+    return __adb_gl_program_cached(key, __adb_gl_attach_spirv, &s);
+}
+
 #endif
 "#.
     to_string()
@@ -3,6 +3,9 @@
 // ============================================================
 // std::set / std::unordered_set — Associative containers
 // Ordered and unordered unique/multi key collections
+// With integer/pointer keys, std::set lowers to the backend's B-tree
+// (adeb-backend-x64 isa/btree.rs) and std::unordered_set to its flat
+// open-addressing table (isa/flat_hash.rs)
 // ============================================================
 
 pub const SET_TYPES: &[&str] = &["set", "multiset", "unordered_set", "unordered_multiset"];
@@ -2,7 +2,7 @@
 // fastos_string_cpp.rs — <string> implementation
 // ============================================================
 // std::string — Dynamic string with SSO (Small String Optimization)
-// Strings <= 15 chars stored inline, longer strings on heap.
+// 24-byte object: strings <= 23 chars stored inline, longer on heap.
 // ============================================================
 
 pub const STRING_METHODS: &[&str] = &[
@@ -18,7 +18,7 @@ pub const STRING_METHODS: &[&str] = &[
     "begin", "end", "rbegin", "rend",
     "front", "back",
     "push_back", "pop_back",
-    "resize", "reserve", "capacity",
+    "resize", "reserve", "capacity", "shrink_to_fit",
     "swap",
 ];
 
@@ -32,117 +32,179 @@ pub fn is_string_cpp_symbol(name: &str) -> bool {
         || STRING_CONSTANTS.iter().any(|(n, _)| *n == name)
 }
 
-/// C inline implementation of std::string with SSO
-/// Injected into the translation unit when <string> is included
+/// C reference implementation of std::string with SSO. Nothing injects
+/// it: the C++ frontend maps <string> to an empty header and lowers
+/// std::string itself; the C driver tests compile this source
 pub const STRING_IMPL: &str = r#"
+/* 24 bytes, no self-pointer (safe to return by value).
+   Short: chars in _buf, _buf[23] = 23 - size (doubles as the NUL at 23).
+   Long:  heap {ptr, size, cap | LONG_BIT}; high bit of _buf[23] set. */
 typedef struct {
-    char* _ptr;
-    size_t _size;
-    size_t _cap;
     char _buf[24];
 } __adb_string;
 
-static __adb_string __str_new(const char* src) {
+typedef struct {
+    char* ptr;
+    size_t size;
+    size_t cap;
+} __adb_string_heap;
+
+#define __STR_SSO_CAP 23
+#define __STR_LONG_BIT ((size_t)1 << 63)
+#define __STR_HEAP(s) ((__adb_string_heap*)(s)->_buf)
+
+static int __str_is_long(const __adb_string* s) {
+    return ((unsigned char)s->_buf[23] & 0x80) != 0;
+}
+
+static char* __str_ptr(const __adb_string* s) {
+    return __str_is_long(s) ? __STR_HEAP(s)->ptr : (char*)s->_buf;
+}
+
+/* Switches s to (or keeps it in) inline mode holding n chars */
+static void __str_set_short(__adb_string* s, size_t n) {
+    s->_buf[n] = 0;
+    s->_buf[23] = (char)(__STR_SSO_CAP - n);
+}
+
+static void __str_set_size(__adb_string* s, size_t n) {
+    if (__str_is_long(s)) {
+        __STR_HEAP(s)->size = n;
+        __STR_HEAP(s)->ptr[n] = 0;
+    } else {
+        __str_set_short(s, n);
+    }
+}
+
+static __adb_string __str_new_n(const char* src, size_t len) {
     __adb_string s;
-    size_t len = strlen(src);
-    if (len <= 22) {
-        memcpy(s._buf, src, len + 1);
-        s._ptr = s._buf;
-        s._size = len;
-        s._cap = 23;
+    if (len <= __STR_SSO_CAP) {
+        memcpy(s._buf, src, len);
+        __str_set_short(&s, len);
     } else {
-        s._ptr = (char*)malloc(len + 1);
-        memcpy(s._ptr, src, len + 1);
-        s._size = len;
-        s._cap = len + 1;
+        __STR_HEAP(&s)->ptr = (char*)malloc(len + 1);
+        memcpy(__STR_HEAP(&s)->ptr, src, len);
+        __STR_HEAP(&s)->cap = len | __STR_LONG_BIT;
+        __str_set_size(&s, len);
     }
     return s;
 }
 
+static __adb_string __str_new(const char* src) {
+    return __str_new_n(src, strlen(src));
+}
+
 static __adb_string __str_new_empty() {
     __adb_string s;
-    s._buf[0] = 0;
-    s._ptr = s._buf;
-    s._size = 0;
-    s._cap = 23;
+    __str_set_short(&s, 0);
     return s;
 }
 
 static const char* __str_cstr(const __adb_string* s) {
-    return s->_ptr;
+    return __str_ptr(s);
 }
 
 static size_t __str_size(const __adb_string* s) {
-    return s->_size;
+    if (__str_is_long(s)) return __STR_HEAP(s)->size;
+    return __STR_SSO_CAP - (size_t)s->_buf[23];
 }
 
 static size_t __str_length(const __adb_string* s) {
-    return s->_size;
+    return __str_size(s);
 }
 
 static int __str_empty(const __adb_string* s) {
-    return s->_size == 0;
+    return __str_size(s) == 0;
 }
 
+/* Characters storable without reallocating (terminator excluded) */
 static size_t __str_capacity(const __adb_string* s) {
-    return s->_cap;
+    if (__str_is_long(s)) return __STR_HEAP(s)->cap & ~__STR_LONG_BIT;
+    return __STR_SSO_CAP;
 }
 
 static char __str_at(const __adb_string* s, size_t i) {
-    return s->_ptr[i];
+    return __str_ptr(s)[i];
 }
 
 static char __str_front(const __adb_string* s) {
-    return s->_ptr[0];
+    return __str_ptr(s)[0];
 }
 
 static char __str_back(const __adb_string* s) {
-    return s->_ptr[s->_size - 1];
+    return __str_ptr(s)[__str_size(s) - 1];
+}
+
+/* Moves the contents into a heap block of exactly new_cap chars */
+static void __str_realloc(__adb_string* s, size_t new_cap) {
+    size_t n = __str_size(s);
+    if (__str_is_long(s)) {
+        __STR_HEAP(s)->ptr = (char*)realloc(__STR_HEAP(s)->ptr, new_cap + 1);
+    } else {
+        char* np = (char*)malloc(new_cap + 1);
+        memcpy(np, s->_buf, n + 1);
+        __STR_HEAP(s)->ptr = np;
+        __STR_HEAP(s)->size = n;
+    }
+    __STR_HEAP(s)->cap = new_cap | __STR_LONG_BIT;
 }
 
 static void __str_reserve(__adb_string* s, size_t new_cap) {
-    if (new_cap <= s->_cap) return;
-    char* np = (char*)malloc(new_cap);
-    memcpy(np, s->_ptr, s->_size + 1);
-    if (s->_ptr != s->_buf) free(s->_ptr);
-    s->_ptr = np;
-    s->_cap = new_cap;
+    if (new_cap <= __str_capacity(s)) return;
+    __str_realloc(s, new_cap);
+}
+
+/* Back to the inline buffer when it fits, else trims the heap block */
+static void __str_shrink_to_fit(__adb_string* s) {
+    if (!__str_is_long(s)) return;
+    size_t n = __STR_HEAP(s)->size;
+    if (n <= __STR_SSO_CAP) {
+        char* old = __STR_HEAP(s)->ptr;
+        memcpy(s->_buf, old, n);
+        __str_set_short(s, n);
+        free(old);
+    } else if (n < __str_capacity(s)) {
+        __str_realloc(s, n);
+    }
 }
 
-static void __str_append(__adb_string* s, const char* src) {
-    size_t slen = strlen(src);
-    size_t need = s->_size + slen + 1;
-    if (need > s->_cap) {
-        size_t nc = s->_cap * 2;
+static void __str_append_n(__adb_string* s, const char* src, size_t slen) {
+    size_t n = __str_size(s);
+    size_t need = n + slen;
+    size_t cap = __str_capacity(s);
+    if (need > cap) {
+        size_t nc = cap * 2;
         if (nc < need) nc = need;
-        __str_reserve(s, nc);
+        __str_realloc(s, nc);
     }
-    memcpy(s->_ptr + s->_size, src, slen + 1);
-    s->_size += slen;
+    memcpy(__str_ptr(s) + n, src, slen);
+    __str_set_size(s, need);
+}
+
+static void __str_append(__adb_string* s, const char* src) {
+    __str_append_n(s, src, strlen(src));
 }
 
 static void __str_push_back(__adb_string* s, char c) {
-    char tmp[2];
-    tmp[0] = c;
-    tmp[1] = 0;
-    __str_append(s, tmp);
+    __str_append_n(s, &c, 1);
 }
 
 static __adb_string __str_concat(const __adb_string* a, const __adb_string* b) {
-    __adb_string r = __str_new(a->_ptr);
-    __str_append(&r, b->_ptr);
+    __adb_string r = __str_new_n(__str_ptr(a), __str_size(a));
+    __str_append_n(&r, __str_ptr(b), __str_size(b));
     return r;
 }
 
 static __adb_string __str_concat_cstr(const __adb_string* a, const char* b) {
-    __adb_string r = __str_new(a->_ptr);
+    __adb_string r = __str_new_n(__str_ptr(a), __str_size(a));
     __str_append(&r, b);
     return r;
 }
 
 static int __str_eq(const __adb_string* a, const __adb_string* b) {
-    if (a->_size != b->_size) return 0;
-    return strcmp(a->_ptr, b->_ptr) == 0;
+    size_t n = __str_size(a);
+    if (n != __str_size(b)) return 0;
+    return memcmp(__str_ptr(a), __str_ptr(b), n) == 0;
 }
 
 static int __str_ne(const __adb_string* a, const __adb_string* b) {
@@ -150,37 +212,41 @@ static int __str_ne(const __adb_string* a, const __adb_string* b) {
 }
 
 static int __str_lt(const __adb_string* a, const __adb_string* b) {
-    return strcmp(a->_ptr, b->_ptr) < 0;
+    return strcmp(__str_ptr(a), __str_ptr(b)) < 0;
 }
 
 static int __str_compare(const __adb_string* a, const __adb_string* b) {
-    return strcmp(a->_ptr, b->_ptr);
+    return strcmp(__str_ptr(a), __str_ptr(b));
 }
 
 static __adb_string __str_substr(const __adb_string* s, size_t pos, size_t len) {
-    __adb_string r = __str_new_empty();
-    if (pos >= s->_size) return r;
-    size_t avail = s->_size - pos;
+    size_t n = __str_size(s);
+    if (pos >= n) return __str_new_empty();
+    size_t avail = n - pos;
     if (len > avail) len = avail;
-    __str_reserve(&r, len + 1);
-    memcpy(r._ptr, s->_ptr + pos, len);
-    r._ptr[len] = 0;
-    r._size = len;
-    return r;
+    return __str_new_n(__str_ptr(s) + pos, len);
 }
 
 static size_t __str_find(const __adb_string* s, const char* needle) {
-    const char* p = strstr(s->_ptr, needle);
-    if (p) return (size_t)(p - s->_ptr);
+    const char* base = __str_ptr(s);
+    const char* p = strstr(base, needle);
+    if (p) return (size_t)(p - base);
     return (size_t)-1;
 }
 
 static void __str_clear(__adb_string* s) {
-    s->_size = 0;
-    s->_ptr[0] = 0;
+    __str_set_size(s, 0);
+}
+
+/* Steals src's buffer; src is left empty */
+static __adb_string __str_move(__adb_string* src) {
+    __adb_string r = *src;
+    __str_set_short(src, 0);
+    return r;
 }
 
 static void __str_free(__adb_string* s) {
-    if (s->_ptr != s->_buf) free(s->_ptr);
+    if (__str_is_long(s)) free(__STR_HEAP(s)->ptr);
+    __str_set_short(s, 0);
 }
 "#;
@@ -3,7 +3,8 @@
 // ============================================================
 // std::vector<T> — Dynamic array with amortized O(1) push_back
 // Rule of Three completo (copy ctor/assign/dtor)
-// Move semantics supported.
+// Move semantics supported: growth relocates elements with realloc
+// (2x while small, then 1.5x), reserve/shrink_to_fit set exact capacity.
 // ============================================================
 
 pub const VECTOR_METHODS: &[&str] = &[
@@ -22,8 +23,9 @@ pub fn is_vector_symbol(name: &str) -> bool {
     name == "vector" || VECTOR_METHODS.contains(&name)
 }
 
-/// C inline implementation of std::vector (generic via int elements, 8-byte stride)
-/// Injected into the translation unit when <vector> is included
+/// C reference implementation of std::vector (generic via int elements, 8-byte stride).
+/// Nothing injects it: the C++ frontend maps <vector> to an empty header
+/// and lowers std::vector itself; the C driver tests compile this source
 pub const VECTOR_IMPL: &str = r#"
 typedef struct {
     void* _data;
@@ -39,24 +41,46 @@ static void __vec_init(__adb_vector* v, size_t elem_size) {
     v->_elem_size = elem_size;
 }
 
+/* Growth target for at least `need` elements: doubles while the buffer
+   is small, then grows by 1.5x so freed blocks can be reused */
+static size_t __vec_grow_cap(__adb_vector* v, size_t need) {
+    size_t nc = v->_cap < 64 ? v->_cap * 2 : v->_cap + v->_cap / 2;
+    if (nc < 4) nc = 4;
+    if (nc < need) nc = need;
+    return nc;
+}
+
+/* Elements are trivially relocatable: realloc moves them bytewise
+   (or grows the block in place) instead of copying through a new one */
+static void __vec_realloc(__adb_vector* v, size_t new_cap) {
+    v->_data = realloc(v->_data, new_cap * v->_elem_size);
+    v->_cap = new_cap;
+}
+
 static void __vec_reserve(__adb_vector* v, size_t new_cap) {
     if (new_cap <= v->_cap) return;
-    void* np = malloc(new_cap * v->_elem_size);
-    if (v->_data) {
-        memcpy(np, v->_data, v->_size * v->_elem_size);
+    __vec_realloc(v, new_cap);
+}
+
+static void __vec_shrink_to_fit(__adb_vector* v) {
+    if (v->_cap == v->_size) return;
+    if (v->_size == 0) {
         free(v->_data);
+        v->_data = 0;
+        v->_cap = 0;
+        return;
     }
-    v->_data = np;
-    v->_cap = new_cap;
+    __vec_realloc(v, v->_size);
+}
+
+/* Slot for a new last element, constructed in place by the caller */
+static void* __vec_emplace_back(__adb_vector* v) {
+    if (v->_size == v->_cap) __vec_realloc(v, __vec_grow_cap(v, v->_size + 1));
+    return (char*)v->_data + v->_size++ * v->_elem_size;
 }
 
 static void __vec_push_back(__adb_vector* v, const void* elem) {
-    if (v->_size >= v->_cap) {
-        size_t nc = v->_cap == 0 ? 4 : v->_cap * 2;
-        __vec_reserve(v, nc);
-    }
-    memcpy((char*)v->_data + v->_size * v->_elem_size, elem, v->_elem_size);
-    v->_size++;
+    memcpy(__vec_emplace_back(v), elem, v->_elem_size);
 }
 
 static void __vec_push_back_int(__adb_vector* v, int val) {
@@ -121,7 +145,7 @@ static void __vec_clear(__adb_vector* v) {
 }
 
 static void __vec_resize(__adb_vector* v, size_t n) {
-    if (n > v->_cap) __vec_reserve(v, n);
+    if (n > v->_cap) __vec_realloc(v, __vec_grow_cap(v, n));
     if (n > v->_size) {
         memset((char*)v->_data + v->_size * v->_elem_size, 0, (n - v->_size) * v->_elem_size);
     }
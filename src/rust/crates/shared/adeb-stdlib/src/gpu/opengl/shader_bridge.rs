@@ -1291,6 +1291,278 @@ fn dxbc_to_spirv_stub(dxbc_data: &[u8]) -> Vec<u8> {
     spirv
 }
 
+// =========================================================================
+// Program binary cache (GL 4.1 / GL_ARB_get_program_binary)
+// =========================================================================
+//
+// Guarda el binario de programa enlazado por el driver para saltar la
+// compilación GLSL/SPIR-V en los siguientes arranques. El formato del
+// archivo y la clave son los mismos que usa `adCreateProgramCached` en
+// ad_opengl.hpp, así que Rust y C/C++ comparten la caché.
+
+/// Cache file magic: "ADGB"
+pub const PROGRAM_CACHE_MAGIC: u32 = 0x4247_4441;
+/// Cache file layout version
+pub const PROGRAM_CACHE_VERSION: u32 = 1;
+/// Default cache directory (relative to the working directory)
+pub const PROGRAM_CACHE_DEFAULT_DIR: &str = ".adB-cache";
+
+const FNV64_OFFSET: u64 = 0xcbf2_9ce4_8422_2325;
+const FNV64_PRIME: u64 = 0x0000_0100_0000_01b3;
+
+/// Driver identity — program binaries are only valid for the exact
+/// vendor/renderer/version that produced them.
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct GlDriverInfo {
+    pub vendor: String,
+    pub renderer: String,
+    pub version: String,
+}
+
+/// Incremental FNV-1a 64 key over stage sources, spec constants and driver
+#[derive(Debug, Clone, Copy)]
+pub struct ProgramCacheKey {
+    hash: u64,
+}
+
+impl ProgramCacheKey {
+    pub fn new() -> Self {
+        Self { hash: FNV64_OFFSET }
+    }
+
+    fn feed(&mut self, bytes: &[u8]) {
+        for &b in bytes {
+            self.hash ^= b as u64;
+            self.hash = self.hash.wrapping_mul(FNV64_PRIME);
+        }
+    }
+
+    fn feed_u32(&mut self, v: u32) {
+        self.feed(&v.to_le_bytes());
+    }
+
+    /// Add one stage: GL stage enum, source length, source bytes
+    /// (GLSL text or SPIR-V bytecode).
+    pub fn stage(mut self, stage: ShaderStage, source: &[u8]) -> Self {
+        self.feed_u32(stage.to_gl_enum());
+        self.feed_u32(source.len() as u32);
+        self.feed(source);
+        self
+    }
+
+    /// Add a SPIR-V stage including its entry point and spec constants
+    pub fn spirv(self, shader: &SpirVShader) -> Self {
+        let mut key = self.stage(shader.stage, &shader.bytecode);
+        key.feed(shader.entry_point.as_bytes());
+        key.feed(&[0]);
+        key.spec_constants(&shader.spec_constants)
+    }
+
+    pub fn spec_constants(mut self, constants: &[SpecConstant]) -> Self {
+        self.feed_u32(constants.len() as u32);
+        for c in constants {
+            self.feed_u32(c.index);
+            self.feed_u32(c.value);
+        }
+        self
+    }
+
+    pub fn driver(mut self, info: &GlDriverInfo) -> Self {
+        for s in [&info.vendor, &info.renderer, &info.version] {
+            self.feed(s.as_bytes());
+            self.feed(&[0]);
+        }
+        self
+    }
+
+    pub fn finish(&self) -> u64 {
+        self.hash
+    }
+}
+
+impl Default for ProgramCacheKey {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Driver-specific program binary as returned by glGetProgramBinary
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct ProgramBinary {
+    pub format: GLenum,
+    pub data: Vec<u8>,
+}
+
+impl ProgramBinary {
+    pub fn to_bytes(&self) -> Vec<u8> {
+        let mut out = Vec::with_capacity(16 + self.data.len());
+        out.extend_from_slice(&PROGRAM_CACHE_MAGIC.to_le_bytes());
+        out.extend_from_slice(&PROGRAM_CACHE_VERSION.to_le_bytes());
+        out.extend_from_slice(&self.format.to_le_bytes());
+        out.extend_from_slice(&(self.data.len() as u32).to_le_bytes());
+        out.extend_from_slice(&self.data);
+        out
+    }
+
+    pub fn from_bytes(bytes: &[u8]) -> Option<Self> {
+        let word = |i: usize| -> Option<u32> {
+            bytes.get(i * 4..i * 4 + 4).map(|b| u32::from_le_bytes([b[0], b[1], b[2], b[3]]))
+        };
+        if word(0)? != PROGRAM_CACHE_MAGIC || word(1)? != PROGRAM_CACHE_VERSION {
+            return None;
+        }
+        let format = word(2)?;
+        let len = word(3)? as usize;
+        let data = bytes.get(16..16 + len)?.to_vec();
+        if data.is_empty() || bytes.len() != 16 + len {
+            return None;
+        }
+        Some(Self { format, data })
+    }
+}
+
+/// Minimal GL surface the cache needs — implemented over the GL 2.0/4.1
+/// function tables by `GlProgramBinaryFns`, and by fakes in tests.
+pub trait ProgramBinaryBackend {
+    fn create_program(&mut self) -> GLuint;
+    fn delete_program(&mut self, program: GLuint);
+    /// glProgramBinary + GL_LINK_STATUS; false when the driver rejects it
+    fn load_binary(&mut self, program: GLuint, binary: &ProgramBinary) -> bool;
+    /// glGetProgramBinary (program must have been linked with
+    /// GL_PROGRAM_BINARY_RETRIEVABLE_HINT)
+    fn get_binary(&mut self, program: GLuint) -> Option<ProgramBinary>;
+}
+
+/// `ProgramBinaryBackend` over loaded GL 2.0 + GL 4.1 tables
+pub struct GlProgramBinaryFns<'a> {
+    pub gl20: &'a super::gl20::GL20,
+    pub gl41: &'a super::gl41::GL41,
+}
+
+impl<'a> ProgramBinaryBackend for GlProgramBinaryFns<'a> {
+    fn create_program(&mut self) -> GLuint {
+        match self.gl20.glCreateProgram {
+            Some(f) => unsafe { f() },
+            None => 0,
+        }
+    }
+
+    fn delete_program(&mut self, program: GLuint) {
+        if let Some(f) = self.gl20.glDeleteProgram {
+            unsafe { f(program) }
+        }
+    }
+
+    fn load_binary(&mut self, program: GLuint, binary: &ProgramBinary) -> bool {
+        let (Some(bin), Some(getiv)) = (self.gl41.glProgramBinary, self.gl20.glGetProgramiv) else {
+            return false;
+        };
+        let mut status: GLint = 0;
+        unsafe {
+            bin(program, binary.format, binary.data.as_ptr() as *const GLvoid, binary.data.len() as GLsizei);
+            getiv(program, super::constants_gl2x::GL_LINK_STATUS, &mut status);
+        }
+        status != 0
+    }
+
+    fn get_binary(&mut self, program: GLuint) -> Option<ProgramBinary> {
+        let get = self.gl41.glGetProgramBinary?;
+        let getiv = self.gl20.glGetProgramiv?;
+        let mut len: GLint = 0;
+        unsafe { getiv(program, super::constants_gl4x::GL_PROGRAM_BINARY_LENGTH, &mut len) };
+        if len <= 0 {
+            return None;
+        }
+        let mut data = vec![0u8; len as usize];
+        let mut written: GLsizei = 0;
+        let mut format: GLenum = 0;
+        unsafe { get(program, len, &mut written, &mut format, data.as_mut_ptr() as *mut GLvoid) };
+        data.truncate(written.max(0) as usize);
+        if data.is_empty() {
+            return None;
+        }
+        Some(ProgramBinary { format, data })
+    }
+}
+
+/// On-disk program binary cache: one `<key>.glbin` file per program
+#[derive(Debug, Clone)]
+pub struct ProgramBinaryCache {
+    dir: std::path::PathBuf,
+    /// Programs restored from a cached binary
+    pub hits: u32,
+    /// Programs compiled from source (no entry)
+    pub misses: u32,
+    /// Cached binaries the driver refused (driver update, different GPU)
+    pub rejected: u32,
+}
+
+impl ProgramBinaryCache {
+    pub fn new(dir: impl Into<std::path::PathBuf>) -> Self {
+        Self { dir: dir.into(), hits: 0, misses: 0, rejected: 0 }
+    }
+
+    pub fn path_for(&self, key: u64) -> std::path::PathBuf {
+        self.dir.join(format!("{:016x}.glbin", key))
+    }
+
+    pub fn load(&self, key: u64) -> Option<ProgramBinary> {
+        let bytes = std::fs::read(self.path_for(key)).ok()?;
+        ProgramBinary::from_bytes(&bytes)
+    }
+
+    pub fn store(&self, key: u64, binary: &ProgramBinary) -> std::io::Result<()> {
+        std::fs::create_dir_all(&self.dir)?;
+        // Escribir a un temporal y renombrar: otro proceso nunca ve un
+        // binario a medias.
+        let path = self.path_for(key);
+        let tmp = path.with_extension("glbin.tmp");
+        std::fs::write(&tmp, binary.to_bytes())?;
+        std::fs::rename(&tmp, &path)
+    }
+
+    pub fn evict(&self, key: u64) {
+        let _ = std::fs::remove_file(self.path_for(key));
+    }
+
+    /// Return a linked program: from the cached binary when the driver
+    /// accepts it, otherwise via `build` (full compile + link, which must
+    /// set GL_PROGRAM_BINARY_RETRIEVABLE_HINT before linking). A fresh
+    /// build is written back to the cache; I/O errors only cost the cache.
+    pub fn get_or_build<B, F>(&mut self, key: u64, gl: &mut B, build: F) -> Result<GLuint, String>
+    where
+        B: ProgramBinaryBackend,
+        F: FnOnce(&mut B) -> Result<GLuint, String>,
+    {
+        if let Some(binary) = self.load(key) {
+            let program = gl.create_program();
+            if program != 0 && gl.load_binary(program, &binary) {
+                self.hits += 1;
+                return Ok(program);
+            }
+            if program != 0 {
+                gl.delete_program(program);
+            }
+            self.rejected += 1;
+            self.evict(key);
+        } else {
+            self.misses += 1;
+        }
+
+        let program = build(gl)?;
+        if let Some(binary) = gl.get_binary(program) {
+            let _ = self.store(key, &binary);
+        }
+        Ok(program)
+    }
+}
+
+impl Default for ProgramBinaryCache {
+    fn default() -> Self {
+        Self::new(PROGRAM_CACHE_DEFAULT_DIR)
+    }
+}
+
 // =========================================================================
 // Public Expeller API — funciones exportadas para el OpenGL Expeller
 // =========================================================================
@@ -1430,4 +1702,96 @@ mod tests {
         assert!(dispatch.is_some());
         assert_eq!(dispatch.unwrap().glsl_equivalent, "gl_GlobalInvocationID");
     }
+
+    fn driver(version: &str) -> GlDriverInfo {
+        GlDriverInfo {
+            vendor: "ADead".to_string(),
+            renderer: "Test GPU".to_string(),
+            version: version.to_string(),
+        }
+    }
+
+    #[test]
+    fn test_program_cache_key_inputs() {
+        let base = ProgramCacheKey::new()
+            .stage(ShaderStage::Vertex, b"void main(){}")
+            .stage(ShaderStage::Fragment, b"void main(){}");
+        let a = base.driver(&driver("4.6")).finish();
+        assert_eq!(a, base.driver(&driver("4.6")).finish());
+        assert_ne!(a, base.driver(&driver("4.5")).finish());
+
+        let spec = base.spec_constants(&[SpecConstant { index: 0, value: 1 }]);
+        assert_ne!(a, spec.driver(&driver("4.6")).finish());
+
+        // Cambiar la etapa con la misma fuente también cambia la clave
+        let swapped = ProgramCacheKey::new()
+            .stage(ShaderStage::Fragment, b"void main(){}")
+            .stage(ShaderStage::Geometry, b"void main(){}")
+            .driver(&driver("4.6"))
+            .finish();
+        assert_ne!(a, swapped);
+    }
+
+    #[test]
+    fn test_program_binary_roundtrip() {
+        let bin = ProgramBinary { format: 0x1234, data: vec![1, 2, 3, 4, 5] };
+        let bytes = bin.to_bytes();
+        assert_eq!(ProgramBinary::from_bytes(&bytes), Some(bin));
+        assert_eq!(ProgramBinary::from_bytes(&bytes[..bytes.len() - 1]), None);
+        assert_eq!(ProgramBinary::from_bytes(b"not a cache file"), None);
+    }
+
+    /// Driver falso: acepta solo binarios con su formato actual
+    struct FakeGl {
+        format: GLenum,
+        next: GLuint,
+        builds: u32,
+        deleted: Vec<GLuint>,
+    }
+
+    impl ProgramBinaryBackend for FakeGl {
+        fn create_program(&mut self) -> GLuint {
+            self.next += 1;
+            self.next
+        }
+        fn delete_program(&mut self, program: GLuint) {
+            self.deleted.push(program);
+        }
+        fn load_binary(&mut self, _program: GLuint, binary: &ProgramBinary) -> bool {
+            binary.format == self.format
+        }
+        fn get_binary(&mut self, _program: GLuint) -> Option<ProgramBinary> {
+            Some(ProgramBinary { format: self.format, data: vec![0xAB; 8] })
+        }
+    }
+
+    #[test]
+    fn test_program_cache_hit_miss_reject() {
+        let dir = std::env::temp_dir().join(format!("adeb_glcache_{}", std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        let mut cache = ProgramBinaryCache::new(&dir);
+        let mut gl = FakeGl { format: 1, next: 0, builds: 0, deleted: Vec::new() };
+        let key = ProgramCacheKey::new().stage(ShaderStage::Compute, b"src").finish();
+        let build = |gl: &mut FakeGl| -> Result<GLuint, String> {
+            gl.builds += 1;
+            Ok(gl.create_program())
+        };
+
+        cache.get_or_build(key, &mut gl, build).unwrap();
+        assert_eq!((cache.misses, gl.builds), (1, 1));
+        assert!(cache.path_for(key).exists());
+
+        cache.get_or_build(key, &mut gl, build).unwrap();
+        assert_eq!((cache.hits, gl.builds), (1, 1));
+
+        // Driver actualizado: el binario guardado se rechaza y se recompila
+        gl.format = 2;
+        let program = cache.get_or_build(key, &mut gl, build).unwrap();
+        assert_eq!((cache.rejected, gl.builds), (1, 2));
+        assert_eq!(gl.deleted.len(), 1);
+        assert_ne!(gl.deleted[0], program);
+        assert_eq!(cache.load(key).map(|b| b.format), Some(2));
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
 }
@@ -0,0 +1,112 @@
+// ============================================================
+// Bench 01: Sort / Search — basado en 30_algorithms.c
+// ============================================================
+// Mide: quicksort, insertion sort y binary search sobre
+// arrays de int generados con LCG
+// ============================================================
+
+#include <stdlib.h>
+#include "bench.h"
+
+#define N      20000
+#define SMALL  512
+#define REPS   8
+
+void insertion_sort(int *arr, int n) {
+    int i, j;
+    for (i = 1; i < n; i++) {
+        int key = arr[i];
+        j = i - 1;
+        while (j >= 0 && arr[j] > key) {
+            arr[j + 1] = arr[j];
+            j--;
+        }
+        arr[j + 1] = key;
+    }
+}
+
+int partition(int *arr, int lo, int hi) {
+    int pivot = arr[hi];
+    int i = lo - 1;
+    int j;
+    for (j = lo; j < hi; j++) {
+        if (arr[j] <= pivot) {
+            i++;
+            int tmp = arr[i];
+            arr[i] = arr[j];
+            arr[j] = tmp;
+        }
+    }
+    int tmp = arr[i + 1];
+    arr[i + 1] = arr[hi];
+    arr[hi] = tmp;
+    return i + 1;
+}
+
+void quick_sort(int *arr, int lo, int hi) {
+    if (lo < hi) {
+        int p = partition(arr, lo, hi);
+        quick_sort(arr, lo, p - 1);
+        quick_sort(arr, p + 1, hi);
+    }
+}
+
+int binary_search(int *arr, int n, int target) {
+    int lo = 0, hi = n - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (arr[mid] == target) return mid;
+        if (arr[mid] < target) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+void fill(int *arr, int n) {
+    int i;
+    for (i = 0; i < n; i++) arr[i] = bench_rand();
+}
+
+int main() {
+    int *arr = (int *)malloc(N * sizeof(int));
+    long long sum = 0;
+    long long t0, t1;
+    int r, i;
+
+    // --- quicksort ---
+    t0 = bench_now();
+    for (r = 0; r < REPS; r++) {
+        fill(arr, N);
+        quick_sort(arr, 0, N - 1);
+        sum += arr[0] + arr[N / 2] + arr[N - 1];
+    }
+    t1 = bench_now();
+    bench_report("quicksort", t1 - t0, sum);
+
+    // --- insertion sort (arrays pequeños) ---
+    sum = 0;
+    t0 = bench_now();
+    for (r = 0; r < REPS * 8; r++) {
+        fill(arr, SMALL);
+        insertion_sort(arr, SMALL);
+        sum += arr[SMALL / 2];
+    }
+    t1 = bench_now();
+    bench_report("insertion_sort", t1 - t0, sum);
+
+    // --- binary search sobre el array ordenado ---
+    fill(arr, N);
+    quick_sort(arr, 0, N - 1);
+    sum = 0;
+    t0 = bench_now();
+    for (r = 0; r < REPS * 4; r++) {
+        for (i = 0; i < N; i++) {
+            sum += binary_search(arr, N, arr[i]) >= 0;
+        }
+    }
+    t1 = bench_now();
+    bench_report("binary_search", t1 - t0, sum);
+
+    free(arr);
+    return 0;
+}
@@ -0,0 +1,113 @@
+// ============================================================
+// Bench 02: Hashing — basado en la hash table de 30_algorithms.c
+// ============================================================
+// Mide: djb2 sobre strings, FNV-1a sobre bloques de bytes e
+// insert/lookup en una tabla de direccionamiento abierto
+// ============================================================
+
+#include <stdlib.h>
+#include "bench.h"
+
+#define TABLE_SIZE 8192
+#define KEYS       6000
+#define BYTES      65536
+#define REPS       16
+
+unsigned int hash_djb2(const char *str) {
+    unsigned int hash = 5381;
+    int c;
+    while ((c = *str++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash;
+}
+
+unsigned int hash_fnv1a(unsigned char *data, int len) {
+    unsigned int hash = 2166136261u;
+    int i;
+    for (i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+struct Slot {
+    int key;
+    int value;
+    int used;
+};
+
+void table_clear(struct Slot *table) {
+    int i;
+    for (i = 0; i < TABLE_SIZE; i++) table[i].used = 0;
+}
+
+void table_put(struct Slot *table, int key, int value) {
+    unsigned int h = ((unsigned int)key * 2654435761u) & (TABLE_SIZE - 1);
+    while (table[h].used && table[h].key != key) {
+        h = (h + 1) & (TABLE_SIZE - 1);
+    }
+    table[h].key = key;
+    table[h].value = value;
+    table[h].used = 1;
+}
+
+int table_get(struct Slot *table, int key) {
+    unsigned int h = ((unsigned int)key * 2654435761u) & (TABLE_SIZE - 1);
+    while (table[h].used) {
+        if (table[h].key == key) return table[h].value;
+        h = (h + 1) & (TABLE_SIZE - 1);
+    }
+    return -1;
+}
+
+int main() {
+    char words[64][16];
+    unsigned char *bytes = (unsigned char *)malloc(BYTES);
+    struct Slot *table = (struct Slot *)malloc(TABLE_SIZE * sizeof(struct Slot));
+    int *keys = (int *)malloc(KEYS * sizeof(int));
+    long long sum = 0;
+    long long t0, t1;
+    int r, i, j;
+
+    for (i = 0; i < 64; i++) {
+        for (j = 0; j < 15; j++) words[i][j] = 'a' + (bench_rand() % 26);
+        words[i][15] = '\0';
+    }
+    for (i = 0; i < BYTES; i++) bytes[i] = (unsigned char)bench_rand();
+    for (i = 0; i < KEYS; i++) keys[i] = bench_rand() * 32768 + bench_rand();
+
+    // --- djb2 ---
+    t0 = bench_now();
+    for (r = 0; r < REPS * 256; r++) {
+        for (i = 0; i < 64; i++) sum += hash_djb2(words[i]) & 0xFF;
+    }
+    t1 = bench_now();
+    bench_report("djb2", t1 - t0, sum);
+
+    // --- FNV-1a ---
+    sum = 0;
+    t0 = bench_now();
+    for (r = 0; r < REPS; r++) {
+        sum += hash_fnv1a(bytes, BYTES) & 0xFFFF;
+    }
+    t1 = bench_now();
+    bench_report("fnv1a", t1 - t0, sum);
+
+    // --- open addressing put/get ---
+    sum = 0;
+    t0 = bench_now();
+    for (r = 0; r < REPS; r++) {
+        table_clear(table);
+        for (i = 0; i < KEYS; i++) table_put(table, keys[i], i);
+        for (i = 0; i < KEYS; i++) sum += table_get(table, keys[i]);
+    }
+    t1 = bench_now();
+    bench_report("hash_table", t1 - t0, sum);
+
+    free(keys);
+    free(table);
+    free(bytes);
+    return 0;
+}
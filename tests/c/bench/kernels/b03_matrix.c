@@ -0,0 +1,111 @@
+// ============================================================
+// Bench 03: Matrix ops — multiplicación, transpuesta, suma
+// ============================================================
+// Mide: matmul ingenuo i-j-k, matmul i-k-j (cache friendly)
+// y transpuesta sobre matrices int N x N en heap
+// ============================================================
+
+#include <stdlib.h>
+#include "bench.h"
+
+#define N    96
+#define REPS 8
+
+void mat_fill(int *m, int n) {
+    int i;
+    for (i = 0; i < n * n; i++) m[i] = bench_rand() % 100;
+}
+
+void mat_zero(int *m, int n) {
+    int i;
+    for (i = 0; i < n * n; i++) m[i] = 0;
+}
+
+void matmul_ijk(int *a, int *b, int *c, int n) {
+    int i, j, k;
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < n; j++) {
+            int acc = 0;
+            for (k = 0; k < n; k++) {
+                acc += a[i * n + k] * b[k * n + j];
+            }
+            c[i * n + j] = acc;
+        }
+    }
+}
+
+void matmul_ikj(int *a, int *b, int *c, int n) {
+    int i, j, k;
+    mat_zero(c, n);
+    for (i = 0; i < n; i++) {
+        for (k = 0; k < n; k++) {
+            int aik = a[i * n + k];
+            for (j = 0; j < n; j++) {
+                c[i * n + j] += aik * b[k * n + j];
+            }
+        }
+    }
+}
+
+void transpose(int *src, int *dst, int n) {
+    int i, j;
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < n; j++) {
+            dst[j * n + i] = src[i * n + j];
+        }
+    }
+}
+
+long long mat_trace(int *m, int n) {
+    long long t = 0;
+    int i;
+    for (i = 0; i < n; i++) t += m[i * n + i];
+    return t;
+}
+
+int main() {
+    int *a = (int *)malloc(N * N * sizeof(int));
+    int *b = (int *)malloc(N * N * sizeof(int));
+    int *c = (int *)malloc(N * N * sizeof(int));
+    long long sum = 0;
+    long long t0, t1;
+    int r;
+
+    mat_fill(a, N);
+    mat_fill(b, N);
+
+    // --- matmul i-j-k ---
+    t0 = bench_now();
+    for (r = 0; r < REPS; r++) {
+        matmul_ijk(a, b, c, N);
+        sum += mat_trace(c, N);
+    }
+    t1 = bench_now();
+    bench_report("matmul_ijk", t1 - t0, sum);
+
+    // --- matmul i-k-j ---
+    sum = 0;
+    t0 = bench_now();
+    for (r = 0; r < REPS; r++) {
+        matmul_ikj(a, b, c, N);
+        sum += mat_trace(c, N);
+    }
+    t1 = bench_now();
+    bench_report("matmul_ikj", t1 - t0, sum);
+
+    // --- transpose ---
+    sum = 0;
+    t0 = bench_now();
+    for (r = 0; r < REPS * 32; r++) {
+        transpose(a, c, N);
+        transpose(c, b, N);
+        sum += b[r % (N * N)];
+    }
+    t1 = bench_now();
+    bench_report("transpose", t1 - t0, sum);
+
+    free(c);
+    free(b);
+    free(a);
+    return 0;
+}
@@ -0,0 +1,145 @@
+// ============================================================
+// Bench 04: Linked list — basado en 31_linked_list_full.c
+// ============================================================
+// Mide: push/traverse, reverse y merge sort sobre listas
+// enlazadas en heap (pointer chasing + malloc/free)
+// ============================================================
+
+#include <stdlib.h>
+#include "bench.h"
+
+#define NODES 20000
+#define REPS  8
+
+struct Node {
+    int data;
+    struct Node *next;
+};
+
+struct Node *node_new(int data) {
+    struct Node *n = (struct Node *)malloc(sizeof(struct Node));
+    n->data = data;
+    n->next = NULL;
+    return n;
+}
+
+void list_push_front(struct Node **head, int data) {
+    struct Node *n = node_new(data);
+    n->next = *head;
+    *head = n;
+}
+
+long long list_sum(struct Node *head) {
+    long long s = 0;
+    while (head) {
+        s += head->data;
+        head = head->next;
+    }
+    return s;
+}
+
+void list_reverse(struct Node **head) {
+    struct Node *prev = NULL;
+    struct Node *curr = *head;
+    while (curr) {
+        struct Node *next = curr->next;
+        curr->next = prev;
+        prev = curr;
+        curr = next;
+    }
+    *head = prev;
+}
+
+void list_free(struct Node *head) {
+    while (head) {
+        struct Node *next = head->next;
+        free(head);
+        head = next;
+    }
+}
+
+struct Node *list_merge(struct Node *a, struct Node *b) {
+    struct Node dummy;
+    struct Node *tail = &dummy;
+    dummy.next = NULL;
+    while (a && b) {
+        if (a->data <= b->data) {
+            tail->next = a;
+            a = a->next;
+        } else {
+            tail->next = b;
+            b = b->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = a ? a : b;
+    return dummy.next;
+}
+
+void list_split(struct Node *head, struct Node **front, struct Node **back) {
+    struct Node *slow = head;
+    struct Node *fast = head->next;
+    while (fast && fast->next) {
+        slow = slow->next;
+        fast = fast->next->next;
+    }
+    *front = head;
+    *back = slow->next;
+    slow->next = NULL;
+}
+
+void list_sort(struct Node **head) {
+    struct Node *a;
+    struct Node *b;
+    if (!*head || !(*head)->next) return;
+    list_split(*head, &a, &b);
+    list_sort(&a);
+    list_sort(&b);
+    *head = list_merge(a, b);
+}
+
+int main() {
+    struct Node *head = NULL;
+    long long sum = 0;
+    long long t0, t1;
+    int r, i;
+
+    // --- build + traverse + free ---
+    t0 = bench_now();
+    for (r = 0; r < REPS; r++) {
+        head = NULL;
+        for (i = 0; i < NODES; i++) list_push_front(&head, i);
+        sum += list_sum(head);
+        list_free(head);
+    }
+    t1 = bench_now();
+    bench_report("list_build", t1 - t0, sum);
+
+    // --- reverse ---
+    head = NULL;
+    for (i = 0; i < NODES; i++) list_push_front(&head, i);
+    sum = 0;
+    t0 = bench_now();
+    for (r = 0; r < REPS * 4; r++) {
+        list_reverse(&head);
+        sum += head->data;
+    }
+    t1 = bench_now();
+    bench_report("list_reverse", t1 - t0, sum);
+    list_free(head);
+
+    // --- merge sort ---
+    sum = 0;
+    t0 = bench_now();
+    for (r = 0; r < REPS; r++) {
+        head = NULL;
+        for (i = 0; i < NODES; i++) list_push_front(&head, bench_rand());
+        list_sort(&head);
+        sum += head->data + list_sum(head);
+        list_free(head);
+    }
+    t1 = bench_now();
+    bench_report("list_sort", t1 - t0, sum);
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+// ============================================================
+// Bench 05: State machine — basado en 33_state_machine.c
+// ============================================================
+// Mide: FSM por switch y FSM por tabla de function pointers
+// procesando un flujo pseudo-aleatorio de eventos
+// ============================================================
+
+#include <stdlib.h>
+#include "bench.h"
+
+#define EVENTS 200000
+#define REPS   8
+
+enum State {
+    STATE_IDLE,
+    STATE_RUNNING,
+    STATE_PAUSED,
+    STATE_ERROR,
+    STATE_DONE,
+    STATE_COUNT
+};
+
+enum Event {
+    EVENT_START,
+    EVENT_PAUSE,
+    EVENT_RESUME,
+    EVENT_STOP,
+    EVENT_ERROR,
+    EVENT_RESET,
+    EVENT_COUNT
+};
+
+struct MachineContext {
+    int ticks;
+    int error_count;
+    int transitions;
+};
+
+// --- FSM por switch ---
+enum State fsm_switch(enum State current, enum Event event,
+                      struct MachineContext *ctx) {
+    switch (current) {
+        case STATE_IDLE:
+            if (event == EVENT_START) { ctx->transitions++; return STATE_RUNNING; }
+            break;
+        case STATE_RUNNING:
+            if (event == EVENT_PAUSE) { ctx->transitions++; return STATE_PAUSED; }
+            if (event == EVENT_STOP) { ctx->transitions++; return STATE_DONE; }
+            if (event == EVENT_ERROR) { ctx->error_count++; return STATE_ERROR; }
+            ctx->ticks++;
+            break;
+        case STATE_PAUSED:
+            if (event == EVENT_RESUME) { ctx->transitions++; return STATE_RUNNING; }
+            if (event == EVENT_STOP) { ctx->transitions++; return STATE_DONE; }
+            break;
+        case STATE_ERROR:
+        case STATE_DONE:
+            if (event == EVENT_RESET) { ctx->transitions++; return STATE_IDLE; }
+            break;
+        default:
+            break;
+    }
+    return current;
+}
+
+// --- FSM por tabla de function pointers ---
+typedef enum State (*Handler)(enum Event event, struct MachineContext *ctx);
+
+enum State on_idle(enum Event event, struct MachineContext *ctx) {
+    if (event == EVENT_START) { ctx->transitions++; return STATE_RUNNING; }
+    return STATE_IDLE;
+}
+
+enum State on_running(enum Event event, struct MachineContext *ctx) {
+    if (event == EVENT_PAUSE) { ctx->transitions++; return STATE_PAUSED; }
+    if (event == EVENT_STOP) { ctx->transitions++; return STATE_DONE; }
+    if (event == EVENT_ERROR) { ctx->error_count++; return STATE_ERROR; }
+    ctx->ticks++;
+    return STATE_RUNNING;
+}
+
+enum State on_paused(enum Event event, struct MachineContext *ctx) {
+    if (event == EVENT_RESUME) { ctx->transitions++; return STATE_RUNNING; }
+    if (event == EVENT_STOP) { ctx->transitions++; return STATE_DONE; }
+    return STATE_PAUSED;
+}
+
+enum State on_error(enum Event event, struct MachineContext *ctx) {
+    if (event == EVENT_RESET) { ctx->transitions++; return STATE_IDLE; }
+    return STATE_ERROR;
+}
+
+enum State on_done(enum Event event, struct MachineContext *ctx) {
+    if (event == EVENT_RESET) { ctx->transitions++; return STATE_IDLE; }
+    return STATE_DONE;
+}
+
+Handler handlers[STATE_COUNT] = {on_idle, on_running, on_paused, on_error, on_done};
+
+long long fsm_checksum(struct MachineContext *ctx, enum State s) {
+    return (long long)ctx->ticks * 7 + ctx->error_count * 13 + ctx->transitions * 3 + s;
+}
+
+int main() {
+    unsigned char *events = (unsigned char *)malloc(EVENTS);
+    struct MachineContext ctx;
+    enum State s;
+    long long sum = 0;
+    long long t0, t1;
+    int r, i;
+
+    for (i = 0; i < EVENTS; i++) events[i] = (unsigned char)(bench_rand() % EVENT_COUNT);
+
+    // --- switch ---
+    t0 = bench_now();
+    for (r = 0; r < REPS; r++) {
+        ctx.ticks = 0; ctx.error_count = 0; ctx.transitions = 0;
+        s = STATE_IDLE;
+        for (i = 0; i < EVENTS; i++) s = fsm_switch(s, (enum Event)events[i], &ctx);
+        sum += fsm_checksum(&ctx, s);
+    }
+    t1 = bench_now();
+    bench_report("fsm_switch", t1 - t0, sum);
+
+    // --- tabla de handlers ---
+    sum = 0;
+    t0 = bench_now();
+    for (r = 0; r < REPS; r++) {
+        ctx.ticks = 0; ctx.error_count = 0; ctx.transitions = 0;
+        s = STATE_IDLE;
+        for (i = 0; i < EVENTS; i++) s = handlers[s]((enum Event)events[i], &ctx);
+        sum += fsm_checksum(&ctx, s);
+    }
+    t1 = bench_now();
+    bench_report("fsm_table", t1 - t0, sum);
+
+    free(events);
+    return 0;
+}
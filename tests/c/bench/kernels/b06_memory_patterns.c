@@ -0,0 +1,158 @@
+// ============================================================
+// Bench 06: Memory patterns — basado en 34_memory_patterns.c
+// ============================================================
+// Mide: arena bump allocator, ring buffer push/pop, pool
+// allocator con free list y memcpy/memset sobre bloques
+// ============================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+#define ARENA_SIZE  (256 * 1024)
+#define RING_CAP    1024
+#define OPS         200000
+#define COPY_BYTES  65536
+#define REPS        8
+
+// --- Arena allocator ---
+struct Arena {
+    char *buffer;
+    int capacity;
+    int used;
+};
+
+void *arena_alloc(struct Arena *a, int size) {
+    int aligned = (size + 7) & ~7;
+    if (a->used + aligned > a->capacity) return (void *)0;
+    void *ptr = a->buffer + a->used;
+    a->used += aligned;
+    return ptr;
+}
+
+// --- Ring buffer ---
+struct RingBuffer {
+    int data[RING_CAP];
+    int head;
+    int tail;
+    int count;
+};
+
+int ring_push(struct RingBuffer *rb, int value) {
+    if (rb->count >= RING_CAP) return 0;
+    rb->data[rb->tail] = value;
+    rb->tail = (rb->tail + 1) % RING_CAP;
+    rb->count++;
+    return 1;
+}
+
+int ring_pop(struct RingBuffer *rb, int *value) {
+    if (rb->count == 0) return 0;
+    *value = rb->data[rb->head];
+    rb->head = (rb->head + 1) % RING_CAP;
+    rb->count--;
+    return 1;
+}
+
+// --- Pool allocator ---
+#define POOL_BLOCK_SIZE 32
+#define POOL_BLOCKS     256
+
+struct Pool {
+    char memory[POOL_BLOCK_SIZE * POOL_BLOCKS];
+    int free_list[POOL_BLOCKS];
+    int free_count;
+};
+
+void pool_init(struct Pool *p) {
+    int i;
+    for (i = 0; i < POOL_BLOCKS; i++) p->free_list[i] = i;
+    p->free_count = POOL_BLOCKS;
+}
+
+void *pool_alloc(struct Pool *p) {
+    if (p->free_count == 0) return (void *)0;
+    p->free_count--;
+    return p->memory + p->free_list[p->free_count] * POOL_BLOCK_SIZE;
+}
+
+void pool_free(struct Pool *p, void *ptr) {
+    int idx = (int)((char *)ptr - p->memory) / POOL_BLOCK_SIZE;
+    p->free_list[p->free_count] = idx;
+    p->free_count++;
+}
+
+int main() {
+    struct Arena arena;
+    struct RingBuffer *ring = (struct RingBuffer *)malloc(sizeof(struct RingBuffer));
+    struct Pool *pool = (struct Pool *)malloc(sizeof(struct Pool));
+    char *src = (char *)malloc(COPY_BYTES);
+    char *dst = (char *)malloc(COPY_BYTES);
+    void *live[64];
+    long long sum = 0;
+    long long t0, t1;
+    int r, i, v;
+
+    arena.buffer = (char *)malloc(ARENA_SIZE);
+    arena.capacity = ARENA_SIZE;
+
+    // --- arena ---
+    t0 = bench_now();
+    for (r = 0; r < REPS * 4; r++) {
+        arena.used = 0;
+        for (i = 0; i < 8192; i++) {
+            int *p = (int *)arena_alloc(&arena, 4 + (i & 15));
+            if (p) { *p = i; sum += *p; }
+        }
+    }
+    t1 = bench_now();
+    bench_report("arena", t1 - t0, sum);
+
+    // --- ring buffer ---
+    sum = 0;
+    t0 = bench_now();
+    for (r = 0; r < REPS; r++) {
+        ring->head = 0; ring->tail = 0; ring->count = 0;
+        for (i = 0; i < OPS; i++) {
+            if ((i & 3) != 3) ring_push(ring, i);
+            else if (ring_pop(ring, &v)) sum += v;
+        }
+    }
+    t1 = bench_now();
+    bench_report("ring_buffer", t1 - t0, sum);
+
+    // --- pool ---
+    sum = 0;
+    t0 = bench_now();
+    for (r = 0; r < REPS; r++) {
+        pool_init(pool);
+        for (i = 0; i < OPS / 64; i++) {
+            int k;
+            for (k = 0; k < 64; k++) live[k] = pool_alloc(pool);
+            for (k = 0; k < 64; k++) {
+                sum += (char *)live[k] - pool->memory;
+                pool_free(pool, live[k]);
+            }
+        }
+    }
+    t1 = bench_now();
+    bench_report("pool", t1 - t0, sum);
+
+    // --- memset/memcpy ---
+    sum = 0;
+    t0 = bench_now();
+    for (r = 0; r < REPS * 16; r++) {
+        memset(src, r & 0xFF, COPY_BYTES);
+        memcpy(dst, src, COPY_BYTES);
+        sum += dst[r % COPY_BYTES];
+    }
+    t1 = bench_now();
+    bench_report("memcpy", t1 - t0, sum);
+
+    free(arena.buffer);
+    free(dst);
+    free(src);
+    free(pool);
+    free(ring);
+    return 0;
+}
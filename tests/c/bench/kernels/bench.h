@@ -0,0 +1,32 @@
+// ============================================================
+// bench.h — Temporizador común para los kernels de rendimiento
+// ============================================================
+// Cada kernel imprime una línea por medición:
+//   BENCH <nombre> <ticks> <frecuencia> <checksum>
+// run_bench.ps1 toma el mínimo de varias ejecuciones y convierte
+// ticks/frecuencia a nanosegundos. El checksum debe coincidir
+// entre ADead-BIB y el compilador de referencia.
+// ============================================================
+
+#include <stdio.h>
+#include <windows.h>
+
+long long bench_now(void) {
+    long long t = 0;
+    QueryPerformanceCounter(&t);
+    return t;
+}
+
+void bench_report(const char *name, long long ticks, long long checksum) {
+    long long freq = 0;
+    QueryPerformanceFrequency(&freq);
+    printf("BENCH %s %lld %lld %lld\n", name, ticks, freq, checksum);
+}
+
+// Generador determinista (LCG) — mismas entradas en cada compilador
+unsigned int bench_seed = 12345;
+
+int bench_rand(void) {
+    bench_seed = bench_seed * 1103515245 + 12345;
+    return (int)((bench_seed >> 16) & 0x7FFF);
+}
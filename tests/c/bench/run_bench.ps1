@@ -0,0 +1,198 @@
+# ============================================================
+# run_bench.ps1 — Benchmark de rendimiento del código generado
+# ============================================================
+# Compila cada kernel de bench\kernels con adB (y con un compilador
+# de referencia a -O2 si hay uno en PATH), ejecuta cada binario
+# varias veces, se queda con el mínimo de ticks por medición y
+# escribe un reporte JSON con tiempos, tamaño de binario y checksums.
+#
+# Con -Baseline compara contra un reporte anterior y marca como
+# regresión cualquier medición (tiempo o tamaño) que empeore más
+# de -Threshold. Sale con código 1 si hay regresiones o checksums
+# distintos al compilador de referencia.
+#
+# Uso:
+#   .\run_bench.ps1
+#   .\run_bench.ps1 -Runs 9 -Save baseline.json
+#   .\run_bench.ps1 -Baseline baseline.json -Threshold 0.05
+# ============================================================
+
+param(
+    [string]$Compiler  = (Join-Path $PSScriptRoot "..\..\..\src\rust\target\release\adB.exe"),
+    [string]$Reference = "",
+    [switch]$NoReference,
+    [int]$Runs         = 5,
+    [string]$Save      = (Join-Path $PSScriptRoot "..\output\bench_results.json"),
+    [string]$Baseline  = "",
+    [double]$Threshold = 0.10
+)
+
+$ResultsVersion = 1
+$kernels = Join-Path $PSScriptRoot "kernels"
+$outdir  = Join-Path $PSScriptRoot "..\output\bench"
+
+if (-not (Test-Path $outdir)) { New-Item -ItemType Directory -Path $outdir -Force | Out-Null }
+if (-not (Test-Path $Compiler)) {
+    Write-Host "adB no encontrado: $Compiler (cargo build --release primero)"
+    exit 2
+}
+
+# --- Compilador de referencia: clang > gcc > cl ---
+function Find-Reference {
+    foreach ($cand in @("clang", "gcc", "cl")) {
+        if (Get-Command $cand -ErrorAction SilentlyContinue) { return $cand }
+    }
+    return ""
+}
+
+if ($NoReference) { $Reference = "" }
+elseif ($Reference -eq "") { $Reference = Find-Reference }
+
+function Invoke-RefCompile($src, $exe) {
+    if ($Reference -eq "cl") {
+        & cl /nologo /O2 $src "/Fe:$exe" "/Fo:$outdir\" 2>&1 | Out-Null
+    } else {
+        & $Reference -O2 -w $src -o $exe 2>&1 | Out-Null
+    }
+    return (Test-Path $exe)
+}
+
+# --- Ejecuta un binario N veces y devuelve el mínimo por medición ---
+function Measure-Binary($exe) {
+    $best = @{}
+    for ($i = 0; $i -lt $Runs; $i++) {
+        $out = & $exe 2>&1 | Out-String
+        if ($LASTEXITCODE -ne 0) { return $null }
+        foreach ($line in ($out -split "`r?`n")) {
+            $f = $line.Trim() -split '\s+'
+            if ($f.Count -ne 5 -or $f[0] -ne "BENCH") { continue }
+            $ns = [double]$f[2] * 1e9 / [double]$f[3]
+            $name = $f[1]
+            if (-not $best.ContainsKey($name) -or $ns -lt $best[$name].ns) {
+                $best[$name] = [PSCustomObject]@{ ns = $ns; checksum = $f[4] }
+            }
+        }
+    }
+    return $best
+}
+
+$report = [ordered]@{
+    version   = $ResultsVersion
+    compiler  = $Compiler
+    reference = $Reference
+    runs      = $Runs
+    kernels   = @()
+}
+$problems = @()
+
+foreach ($f in (Get-ChildItem "$kernels\*.c" | Sort-Object Name)) {
+    $name   = $f.BaseName
+    $exe    = Join-Path $outdir "$name.exe"
+    $refExe = Join-Path $outdir "$name.ref.exe"
+    Remove-Item $exe, $refExe -ErrorAction SilentlyContinue
+
+    & $Compiler cc $f.FullName -o $exe 2>&1 | Out-Null
+    if (-not (Test-Path $exe)) {
+        $problems += "${name}: compile failed"
+        $report.kernels += [ordered]@{ kernel = $name; status = "COMPILE_FAIL" }
+        continue
+    }
+    $adb = Measure-Binary $exe
+    if ($null -eq $adb) {
+        $problems += "${name}: crashed"
+        $report.kernels += [ordered]@{ kernel = $name; status = "CRASH" }
+        continue
+    }
+
+    $ref = $null
+    $refSize = $null
+    if ($Reference -ne "" -and (Invoke-RefCompile $f.FullName $refExe)) {
+        $refSize = (Get-Item $refExe).Length
+        $ref = Measure-Binary $refExe
+    }
+
+    $measurements = @()
+    foreach ($m in ($adb.Keys | Sort-Object)) {
+        $entry = [ordered]@{
+            name     = $m
+            ns       = [math]::Round($adb[$m].ns)
+            checksum = $adb[$m].checksum
+        }
+        if ($null -ne $ref -and $ref.ContainsKey($m)) {
+            $entry.ref_ns = [math]::Round($ref[$m].ns)
+            $entry.ratio  = [math]::Round($adb[$m].ns / [math]::Max($ref[$m].ns, 1), 3)
+            $entry.checksum_ok = ($ref[$m].checksum -eq $adb[$m].checksum)
+            if (-not $entry.checksum_ok) { $problems += "${name}/${m}: checksum differs from $Reference" }
+        }
+        $measurements += $entry
+    }
+
+    $report.kernels += [ordered]@{
+        kernel         = $name
+        status         = "OK"
+        size_bytes     = (Get-Item $exe).Length
+        ref_size_bytes = $refSize
+        measurements   = $measurements
+    }
+}
+
+# --- Comparación contra baseline ---
+$regressions = @()
+if ($Baseline -ne "") {
+    $base = Get-Content $Baseline -Raw | ConvertFrom-Json
+    if ($base.version -ne $ResultsVersion) {
+        Write-Host "baseline version $($base.version) != $ResultsVersion, comparación omitida"
+    } else {
+        foreach ($k in $report.kernels) {
+            $old = $base.kernels | Where-Object { $_.kernel -eq $k.kernel } | Select-Object -First 1
+            if ($null -eq $old -or $k.status -ne "OK" -or $old.status -ne "OK") { continue }
+            if ($k.size_bytes -gt $old.size_bytes * (1 + $Threshold)) {
+                $regressions += [ordered]@{
+                    kernel = $k.kernel; metric = "size_bytes"
+                    baseline = $old.size_bytes; current = $k.size_bytes
+                }
+            }
+            foreach ($m in $k.measurements) {
+                $om = $old.measurements | Where-Object { $_.name -eq $m.name } | Select-Object -First 1
+                if ($null -eq $om) { continue }
+                if ($m.ns -gt $om.ns * (1 + $Threshold)) {
+                    $regressions += [ordered]@{
+                        kernel = $k.kernel; metric = $m.name
+                        baseline = $om.ns; current = $m.ns
+                    }
+                }
+            }
+        }
+    }
+}
+$report.regressions = $regressions
+$report.problems    = $problems
+
+$report | ConvertTo-Json -Depth 6 | Set-Content -Path $Save -Encoding UTF8
+
+# --- Resumen ---
+Write-Host "`n=========================================="
+Write-Host " ADead-BIB — Generated Code Benchmarks"
+Write-Host "==========================================`n"
+$refLabel = if ($Reference -ne "") { "$Reference -O2" } else { "(sin referencia)" }
+Write-Host ("reference: " + $refLabel + "   runs: " + $Runs)
+foreach ($k in $report.kernels) {
+    if ($k.status -ne "OK") { Write-Host ("[!!] " + $k.kernel + " " + $k.status); continue }
+    $size = "" + $k.size_bytes + " B"
+    if ($null -ne $k.ref_size_bytes) { $size += " (ref " + $k.ref_size_bytes + " B)" }
+    Write-Host ("{0,-22} {1}" -f $k.kernel, $size)
+    foreach ($m in $k.measurements) {
+        $line = "    {0,-16} {1,12:N0} ns" -f $m.name, $m.ns
+        if ($m.Contains("ref_ns")) { $line += ("   ref {0,12:N0} ns   x{1}" -f $m.ref_ns, $m.ratio) }
+        Write-Host $line
+    }
+}
+foreach ($r in $regressions) {
+    Write-Host ("[REGRESSION] " + $r.kernel + "/" + $r.metric + ": " + $r.baseline + " -> " + $r.current)
+}
+foreach ($p in $problems) { Write-Host ("[FAIL] " + $p) }
+Write-Host ''
+Write-Host ('report: ' + $Save)
+
+if ($regressions.Count -gt 0 -or $problems.Count -gt 0) { exit 1 }
+exit 0